@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+#include <components/esm/loadnpc.hpp>
+
+namespace
+{
+    /// Create an ESM file in memory containing the given number of NPC records, each with some inventory and spells.
+    boost::shared_ptr<std::vector<char> > getNpcFile(int count)
+    {
+        std::ostringstream stream;
+
+        ESM::ESMWriter writer;
+        writer.setFormat(0);
+        writer.save(stream);
+
+        for (int i=0; i<count; ++i)
+        {
+            std::ostringstream id;
+            id << "benchmark_npc_" << i;
+
+            ESM::NPC record;
+            record.blank();
+            record.mId = id.str();
+            record.mName = "Benchmark NPC";
+            record.mModel = "meshes\\base_anim.nif";
+            record.mRace = "Dark Elf";
+            record.mClass = "Warrior";
+            record.mHead = "b_n_dark elf_m_head_01";
+            record.mHair = "b_n_dark elf_m_hair_01";
+
+            for (int item=0; item<8; ++item)
+            {
+                ESM::ContItem contItem;
+                contItem.mCount = item+1;
+                contItem.mItem.assign("iron_longsword");
+                record.mInventory.mList.push_back(contItem);
+            }
+            record.mSpells.mList.push_back("fireball");
+            record.mSpells.mList.push_back("frostbite");
+
+            writer.startRecord(ESM::NPC::sRecordId);
+            record.save(writer);
+            writer.endRecord(ESM::NPC::sRecordId);
+        }
+        writer.close();
+
+        const std::string data = stream.str();
+        return boost::shared_ptr<std::vector<char> >(new std::vector<char>(data.begin(), data.end()));
+    }
+}
+
+/// Parse all records of a file that is already in memory, as ESMStore::load does.
+static void BM_ESMReader_loadNpcRecords(benchmark::State& state)
+{
+    boost::shared_ptr<std::vector<char> > data = getNpcFile(static_cast<int>(state.range(0)));
+
+    while (state.KeepRunning())
+    {
+        ESM::ESMReader reader;
+        reader.setEncoder(NULL);
+        reader.openInMemory(data, "benchmark.esp");
+
+        while (reader.hasMoreRecs())
+        {
+            reader.getRecName();
+            reader.getRecHeader();
+
+            ESM::NPC record;
+            bool isDeleted = false;
+            record.load(reader, isDeleted);
+            benchmark::DoNotOptimize(record.mId);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(data->size()));
+}
+BENCHMARK(BM_ESMReader_loadNpcRecords)->Arg(1000);
@@ -0,0 +1,167 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <components/compiler/context.hpp>
+#include <components/compiler/fileparser.hpp>
+#include <components/compiler/locals.hpp>
+#include <components/compiler/scanner.hpp>
+#include <components/compiler/streamerrorhandler.hpp>
+
+#include <components/interpreter/context.hpp>
+#include <components/interpreter/installopcodes.hpp>
+#include <components/interpreter/interpreter.hpp>
+
+namespace
+{
+    /// A script like the ones attached to objects: locals, arithmetic and branches in a loop
+    const char* const sScript =
+        "begin benchmark\n"
+        "short counter\n"
+        "short total\n"
+        "float value\n"
+        "set counter to 0\n"
+        "set total to 0\n"
+        "while ( counter < 100 )\n"
+        "    set value to value * 0.5 + counter\n"
+        "    if ( counter > 50 )\n"
+        "        set total to total + 2\n"
+        "    elseif ( counter == 25 )\n"
+        "        set total to total - 1\n"
+        "    else\n"
+        "        set total to total + 1\n"
+        "    endif\n"
+        "    set counter to counter + 1\n"
+        "endwhile\n"
+        "end\n";
+
+    /// Compiler context without any globals or IDs
+    class CompilerContext : public Compiler::Context
+    {
+    public:
+        virtual bool canDeclareLocals() const { return true; }
+        virtual char getGlobalType (const std::string& name) const { return ' '; }
+        virtual std::pair<char, bool> getMemberType (const std::string& name, const std::string& id) const
+        {
+            return std::make_pair (' ', false);
+        }
+        virtual bool isId (const std::string& name) const { return false; }
+        virtual bool isJournalId (const std::string& name) const { return false; }
+    };
+
+    /// Interpreter context that only has the local variables of the script
+    class InterpreterContext : public Interpreter::Context
+    {
+    public:
+        InterpreterContext (const Compiler::Locals& locals)
+        : mShorts (locals.get ('s').size()), mLongs (locals.get ('l').size()), mFloats (locals.get ('f').size())
+        {}
+
+        virtual int getLocalShort (int index) const { return mShorts[index]; }
+        virtual int getLocalLong (int index) const { return mLongs[index]; }
+        virtual float getLocalFloat (int index) const { return mFloats[index]; }
+        virtual void setLocalShort (int index, int value) { mShorts[index] = value; }
+        virtual void setLocalLong (int index, int value) { mLongs[index] = value; }
+        virtual void setLocalFloat (int index, float value) { mFloats[index] = value; }
+
+        virtual void messageBox (const std::string& message, const std::vector<std::string>& buttons) {}
+        virtual void report (const std::string& message) {}
+        virtual bool menuMode() { return false; }
+
+        virtual int getGlobalShort (const std::string& name) const { return 0; }
+        virtual int getGlobalLong (const std::string& name) const { return 0; }
+        virtual float getGlobalFloat (const std::string& name) const { return 0; }
+        virtual void setGlobalShort (const std::string& name, int value) {}
+        virtual void setGlobalLong (const std::string& name, int value) {}
+        virtual void setGlobalFloat (const std::string& name, float value) {}
+        virtual std::vector<std::string> getGlobals () const { return std::vector<std::string>(); }
+        virtual char getGlobalType (const std::string& name) const { return ' '; }
+
+        virtual std::string getActionBinding (const std::string& action) const { return ""; }
+        virtual std::string getNPCName() const { return ""; }
+        virtual std::string getNPCRace() const { return ""; }
+        virtual std::string getNPCClass() const { return ""; }
+        virtual std::string getNPCFaction() const { return ""; }
+        virtual std::string getNPCRank() const { return ""; }
+        virtual std::string getPCName() const { return ""; }
+        virtual std::string getPCRace() const { return ""; }
+        virtual std::string getPCClass() const { return ""; }
+        virtual std::string getPCRank() const { return ""; }
+        virtual std::string getPCNextRank() const { return ""; }
+        virtual int getPCBounty() const { return 0; }
+        virtual std::string getCurrentCellName() const { return ""; }
+
+        virtual bool isScriptRunning (const std::string& name) const { return false; }
+        virtual void startScript (const std::string& name, const std::string& targetId) {}
+        virtual void stopScript (const std::string& name) {}
+        virtual float getDistance (const std::string& name, const std::string& id) const { return 0; }
+        virtual float getSecondsPassed() const { return 0; }
+        virtual bool isDisabled (const std::string& id) const { return false; }
+        virtual void enable (const std::string& id) {}
+        virtual void disable (const std::string& id) {}
+
+        virtual int getMemberShort (const std::string& id, const std::string& name, bool global) const { return 0; }
+        virtual int getMemberLong (const std::string& id, const std::string& name, bool global) const { return 0; }
+        virtual float getMemberFloat (const std::string& id, const std::string& name, bool global) const { return 0; }
+        virtual void setMemberShort (const std::string& id, const std::string& name, int value, bool global) {}
+        virtual void setMemberLong (const std::string& id, const std::string& name, int value, bool global) {}
+        virtual void setMemberFloat (const std::string& id, const std::string& name, float value, bool global) {}
+
+        virtual std::string getTargetId() const { return ""; }
+
+    private:
+        std::vector<int> mShorts;
+        std::vector<int> mLongs;
+        std::vector<float> mFloats;
+    };
+}
+
+static void BM_Compiler_compile(benchmark::State& state)
+{
+    CompilerContext compilerContext;
+    Compiler::StreamErrorHandler errorHandler (std::cerr);
+
+    while (state.KeepRunning())
+    {
+        Compiler::FileParser parser (errorHandler, compilerContext);
+        std::istringstream input (sScript);
+        Compiler::Scanner scanner (errorHandler, input);
+        scanner.scan (parser);
+    }
+
+    state.SetBytesProcessed (state.iterations() * std::strlen (sScript));
+}
+BENCHMARK(BM_Compiler_compile);
+
+static void BM_Interpreter_run(benchmark::State& state)
+{
+    CompilerContext compilerContext;
+    Compiler::StreamErrorHandler errorHandler (std::cerr);
+    Compiler::FileParser parser (errorHandler, compilerContext);
+
+    std::istringstream input (sScript);
+    Compiler::Scanner scanner (errorHandler, input);
+    scanner.scan (parser);
+    if (!errorHandler.isGood())
+        throw std::runtime_error ("failed to compile the benchmark script");
+
+    std::vector<Interpreter::Type_Code> code;
+    parser.getCode (code);
+    Interpreter::Program program (code);
+
+    Interpreter::Interpreter interpreter;
+    Interpreter::installOpcodes (interpreter);
+
+    InterpreterContext context (parser.getLocals());
+
+    const unsigned long executedBefore = interpreter.getExecutedInstructions();
+    while (state.KeepRunning())
+        interpreter.run (program, context);
+
+    // Instructions per second
+    state.SetItemsProcessed (interpreter.getExecutedInstructions() - executedBefore);
+}
+BENCHMARK(BM_Interpreter_run);
@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+
+#include "apps/openmw/mwdialogue/keywordsearch.hpp"
+
+namespace
+{
+    typedef MWDialogue::KeywordSearch<std::string, int> Search;
+
+    const char* const sWords[] = {
+        "ald", "balmora", "vivec", "dwemer", "ruins", "latest", "rumors", "little", "secret", "services",
+        "someone", "in", "particular", "specific", "place", "my", "trade", "background", "duties", "orders",
+        "ashlanders", "great", "house", "temple", "tribunal", "guild", "fighters", "mages", "thieves", "legion"
+    };
+    const int sNumWords = sizeof(sWords) / sizeof(sWords[0]);
+
+    /// All words and all pairs of different words as topics, about as many as the game with its expansions has,
+    /// and a response text of the given number of words.
+    void setUp(Search& search, std::string& text, int textWords)
+    {
+        for (int i=0; i<sNumWords; ++i)
+        {
+            search.seed(sWords[i], i);
+            for (int j=0; j<sNumWords; ++j)
+                if (j != i)
+                    search.seed(std::string(sWords[i]) + ' ' + sWords[j], i * sNumWords + j);
+        }
+
+        for (int i=0; i<textWords; ++i)
+        {
+            if (i)
+                text += (i % 11 == 0) ? ". " : " ";
+            text += (i % 5 == 0) ? "Aldmeri" : sWords[(i * 17) % sNumWords];
+        }
+    }
+}
+
+static void BM_KeywordSearch_highlightKeywords(benchmark::State& state)
+{
+    Search search;
+    std::string text;
+    setUp(search, text, static_cast<int>(state.range(0)));
+
+    std::vector<Search::Match> matches;
+    while (state.KeepRunning())
+    {
+        matches.clear();
+        search.highlightKeywords(text.begin(), text.end(), matches);
+        benchmark::DoNotOptimize(matches.size());
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_KeywordSearch_highlightKeywords)->Arg(100)->Arg(1000);
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+#include <components/loadinglistener/loadinglistener.hpp>
+
+#include "apps/openmw/mwworld/esmstore.hpp"
+
+namespace
+{
+    Loading::Listener dummyListener;
+
+    std::string getId(int index)
+    {
+        std::ostringstream id;
+        id << "Benchmark_Apparatus_" << index;
+        return id.str();
+    }
+
+    /// ESMStore loaded from an in-memory file with the given number of apparatus records.
+    struct StoreFixture : public benchmark::Fixture
+    {
+        StoreFixture()
+        {
+            const int count = 10000;
+
+            std::stringstream* stream = new std::stringstream;
+            ESM::ESMWriter writer;
+            writer.setFormat(0);
+            writer.save(*stream);
+            for (int i=0; i<count; ++i)
+            {
+                ESM::Apparatus record;
+                record.blank();
+                record.mId = getId(i);
+                writer.startRecord(ESM::Apparatus::sRecordId);
+                record.save(writer);
+                writer.endRecord(ESM::Apparatus::sRecordId);
+            }
+            writer.close();
+
+            ESM::ESMReader reader;
+            std::vector<ESM::ESMReader> readerList;
+            readerList.push_back(reader);
+            reader.setGlobalReaderList(&readerList);
+            reader.open(Files::IStreamPtr(stream), "benchmark.esp");
+            mEsmStore.load(reader, &dummyListener);
+            mEsmStore.setUp();
+
+            // Scripts and dialogue refer to the IDs in any case
+            for (int i=0; i<count; i+=37)
+            {
+                mIds.push_back(getId(i));
+                mMissingIds.push_back(getId(i+count));
+            }
+        }
+
+        MWWorld::ESMStore mEsmStore;
+        std::vector<std::string> mIds;
+        std::vector<std::string> mMissingIds;
+    };
+}
+
+BENCHMARK_F(StoreFixture, BM_Store_search)(benchmark::State& state)
+{
+    const MWWorld::Store<ESM::Apparatus>& store = mEsmStore.get<ESM::Apparatus>();
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+        benchmark::DoNotOptimize(store.search(mIds[index]));
+        index = (index+1) % mIds.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(StoreFixture, BM_Store_searchMissing)(benchmark::State& state)
+{
+    const MWWorld::Store<ESM::Apparatus>& store = mEsmStore.get<ESM::Apparatus>();
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+        benchmark::DoNotOptimize(store.search(mMissingIds[index]));
+        index = (index+1) % mMissingIds.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <sstream>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <osg/Node>
+
+#include <components/nif/niffile.hpp>
+#include <components/nifosg/nifloader.hpp>
+#include <components/resource/texturemanager.hpp>
+#include <components/vfs/manager.hpp>
+
+namespace
+{
+    /// Read the NIF file named by the OPENMW_BENCHMARK_NIF environment variable into memory, so that the
+    /// benchmarks do not measure the disk. The game data may not be distributed, so there is no default file.
+    bool readNifFile(benchmark::State& state, std::string& name, std::string& data)
+    {
+        const char* path = std::getenv("OPENMW_BENCHMARK_NIF");
+        if (!path || !*path)
+        {
+            state.SkipWithError("set OPENMW_BENCHMARK_NIF to the path of a NIF file");
+            return false;
+        }
+
+        boost::filesystem::ifstream stream(path, std::ios::binary);
+        if (!stream.is_open())
+        {
+            state.SkipWithError("failed to open the file in OPENMW_BENCHMARK_NIF");
+            return false;
+        }
+
+        std::ostringstream contents;
+        contents << stream.rdbuf();
+        name = path;
+        data = contents.str();
+        return true;
+    }
+}
+
+static void BM_NIFFile_parse(benchmark::State& state)
+{
+    std::string name;
+    std::string data;
+    if (!readNifFile(state, name, data))
+        return;
+
+    while (state.KeepRunning())
+    {
+        Nif::NIFFile file(Files::IStreamPtr(new std::istringstream(data)), name);
+        benchmark::DoNotOptimize(file.numRoots());
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+}
+BENCHMARK(BM_NIFFile_parse);
+
+static void BM_Loader_load(benchmark::State& state)
+{
+    std::string name;
+    std::string data;
+    if (!readNifFile(state, name, data))
+        return;
+
+    Nif::NIFFilePtr file(new Nif::NIFFile(Files::IStreamPtr(new std::istringstream(data)), name));
+
+    // Without archives, all textures are replaced by the warning texture
+    VFS::Manager vfs(false);
+    vfs.buildIndex();
+    Resource::TextureManager textureManager(&vfs);
+
+    while (state.KeepRunning())
+    {
+        osg::ref_ptr<osg::Node> node = NifOsg::Loader::load(file, &textureManager);
+        benchmark::DoNotOptimize(node.get());
+    }
+}
+BENCHMARK(BM_Loader_load);
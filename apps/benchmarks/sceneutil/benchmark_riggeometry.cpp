@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+
+#include <osg/MatrixTransform>
+#include <osg/NodeVisitor>
+
+#include <components/sceneutil/riggeometry.hpp>
+#include <components/sceneutil/skeleton.hpp>
+
+namespace
+{
+    const int sNumBones = 32;
+    const int sBonesPerVertex = 2;
+
+    std::string getBoneName(int index)
+    {
+        std::ostringstream name;
+        name << "Bip01 Bone " << index;
+        return name.str();
+    }
+
+    /// A chain of bones with a skinned mesh below, about as large as the body of an NPC.
+    struct RigGeometryFixture : public benchmark::Fixture
+    {
+        RigGeometryFixture()
+        {
+            const int numVertices = 2000;
+
+            mSkeleton = new SceneUtil::Skeleton;
+
+            osg::Group* parent = mSkeleton;
+            for (int i=0; i<sNumBones; ++i)
+            {
+                osg::ref_ptr<osg::MatrixTransform> bone (new osg::MatrixTransform(
+                    osg::Matrix::rotate(0.05f, osg::Vec3f(0, 0, 1)) * osg::Matrix::translate(osg::Vec3f(0, 0, 5))));
+                bone->setName(getBoneName(i));
+                parent->addChild(bone);
+                parent = bone;
+            }
+
+            osg::ref_ptr<osg::Geometry> source (new osg::Geometry);
+            osg::ref_ptr<osg::Vec3Array> vertices (new osg::Vec3Array);
+            osg::ref_ptr<osg::Vec3Array> normals (new osg::Vec3Array);
+            for (int i=0; i<numVertices; ++i)
+            {
+                vertices->push_back(osg::Vec3f(static_cast<float>(i % 7), static_cast<float>(i % 11), i * 0.08f));
+                normals->push_back(osg::Vec3f(0, 0, 1));
+            }
+            source->setVertexArray(vertices);
+            source->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+            source->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, numVertices));
+
+            osg::ref_ptr<SceneUtil::RigGeometry::InfluenceMap> influences (new SceneUtil::RigGeometry::InfluenceMap);
+            for (int i=0; i<numVertices; ++i)
+            {
+                const int firstBone = i * sNumBones / numVertices;
+                for (int j=0; j<sBonesPerVertex; ++j)
+                {
+                    SceneUtil::RigGeometry::BoneInfluence& influence = influences->mMap[getBoneName((firstBone + j) % sNumBones)];
+                    influence.mWeights[static_cast<unsigned short>(i)] = 1.f / sBonesPerVertex;
+                    influence.mBoundSphere = osg::BoundingSpheref(osg::Vec3f(0, 0, 0), 10.f);
+                }
+            }
+
+            mGeometry = new SceneUtil::RigGeometry;
+            mGeometry->setSourceGeometry(source);
+            mGeometry->setInfluenceMap(influences);
+            mSkeleton->addChild(mGeometry);
+
+            mVisitor.pushOntoNodePath(mSkeleton);
+            mVisitor.pushOntoNodePath(mGeometry);
+
+            // Finds the skeleton and groups the vertices by their bones
+            mVisitor.setTraversalNumber(1);
+            mGeometry->updateBounds(&mVisitor);
+        }
+
+        osg::ref_ptr<SceneUtil::Skeleton> mSkeleton;
+        osg::ref_ptr<SceneUtil::RigGeometry> mGeometry;
+        osg::NodeVisitor mVisitor;
+    };
+}
+
+/// Skinning on the CPU, as for geometry with more bones than the skinning shader supports.
+BENCHMARK_F(RigGeometryFixture, BM_RigGeometry_update)(benchmark::State& state)
+{
+    unsigned int frameNumber = 1;
+    while (state.KeepRunning())
+    {
+        // A new frame each time, so that the bone matrices and the vertices are updated
+        mVisitor.setTraversalNumber(++frameNumber);
+        mGeometry->update(&mVisitor);
+    }
+    state.SetItemsProcessed(state.iterations() * mGeometry->getVertexArray()->getNumElements());
+}
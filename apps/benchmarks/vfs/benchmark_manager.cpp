@@ -0,0 +1,103 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include <components/vfs/manager.hpp>
+#include <components/vfs/archive.hpp>
+
+namespace
+{
+    const int sNumFiles = 20000;
+
+    std::string getFileName(int index)
+    {
+        std::ostringstream name;
+        name << "Meshes\\x\\Benchmark_" << index << ".NIF";
+        return name.str();
+    }
+
+    class MemoryFile : public VFS::File
+    {
+    public:
+        virtual Files::IStreamPtr open()
+        {
+            return Files::IStreamPtr(new std::istringstream("benchmark"));
+        }
+    };
+
+    /// Archive with the given number of small files, named like the meshes of the game.
+    class MemoryArchive : public VFS::Archive
+    {
+    public:
+        MemoryArchive(int count)
+        {
+            for (int i=0; i<count; ++i)
+                mFiles[getFileName(i)] = MemoryFile();
+        }
+
+        virtual void listResources(std::map<std::string, VFS::File*>& out, char (*normalize_function) (char))
+        {
+            for (std::map<std::string, MemoryFile>::iterator it = mFiles.begin(); it != mFiles.end(); ++it)
+            {
+                std::string name = it->first;
+                std::transform(name.begin(), name.end(), name.begin(), normalize_function);
+                out[name] = &it->second;
+            }
+        }
+
+    private:
+        std::map<std::string, MemoryFile> mFiles;
+    };
+
+    struct ManagerFixture : public benchmark::Fixture
+    {
+        ManagerFixture() : mManager(false)
+        {
+            mManager.addArchive(new MemoryArchive(sNumFiles));
+            mManager.buildIndex();
+
+            for (int i=0; i<sNumFiles; i+=97)
+                mNames.push_back(getFileName(i));
+        }
+
+        VFS::Manager mManager;
+        std::vector<std::string> mNames;
+    };
+}
+
+BENCHMARK_F(ManagerFixture, BM_Manager_get)(benchmark::State& state)
+{
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+        benchmark::DoNotOptimize(mManager.get(mNames[index]));
+        index = (index+1) % mNames.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(ManagerFixture, BM_Manager_exists)(benchmark::State& state)
+{
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+        benchmark::DoNotOptimize(mManager.exists(mNames[index]));
+        index = (index+1) % mNames.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(ManagerFixture, BM_Manager_normalizeFilename)(benchmark::State& state)
+{
+    size_t index = 0;
+    while (state.KeepRunning())
+    {
+        std::string name = mNames[index];
+        mManager.normalizeFilename(name);
+        benchmark::DoNotOptimize(name);
+        index = (index+1) % mNames.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
@@ -1,15 +1,23 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <set>
+#include <algorithm>
 #include <exception>
+#include <stdexcept>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
 
 #include <components/bsa/bsa_file.hpp>
+#include <components/bsa/packfile.hpp>
+#include <components/files/lz4.hpp>
 
-#define BSATOOL_VERSION 1.1
+#define BSATOOL_VERSION 1.2
 
 // Create local aliases for brevity
 namespace bpo = boost::program_options;
@@ -24,6 +32,7 @@ struct Arguments
 
     bool longformat;
     bool fullpath;
+    unsigned int threads;
 };
 
 void replaceAll(std::string& str, const std::string& needle, const std::string& substitute)
@@ -38,7 +47,7 @@ void replaceAll(std::string& str, const std::string& needle, const std::string&
 
 bool parseOptions (int argc, char** argv, Arguments &info)
 {
-    bpo::options_description desc("Inspect and extract files from Bethesda BSA archives\n\n"
+    bpo::options_description desc("Inspect, extract and create Bethesda BSA archives\n\n"
             "Usages:\n"
             "  bsatool list [-l] archivefile\n"
             "      List the files presents in the input archive.\n\n"
@@ -46,6 +55,11 @@ bool parseOptions (int argc, char** argv, Arguments &info)
             "      Extract a file from the input archive.\n\n"
             "  bsatool extractall archivefile [output_directory]\n"
             "      Extract all files from the input archive.\n\n"
+            "  bsatool create archivefile [input_directory]\n"
+            "      Create an archive from the files in the input directory.\n\n"
+            "  bsatool pack archivefile [input_directory]\n"
+            "      Create a pack archive, with each file compressed on its own,\n"
+            "      from the files in the input directory.\n\n"
             "Allowed options");
 
     desc.add_options()
@@ -54,6 +68,9 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         ("long,l", "Include extra information in archive listing.")
         ("full-path,f", "Create directory hierarchy on file extraction "
          "(always true for extractall).")
+        ("threads,t", bpo::value<unsigned int>()->default_value(0),
+         "Number of files to extract at the same time with extractall "
+         "(0 for one per processor core).")
         ;
 
     // input-file is hidden and used as a positional argument
@@ -105,7 +122,8 @@ bool parseOptions (int argc, char** argv, Arguments &info)
     }
 
     info.mode = variables["mode"].as<std::string>();
-    if (!(info.mode == "list" || info.mode == "extract" || info.mode == "extractall"))
+    if (!(info.mode == "list" || info.mode == "extract" || info.mode == "extractall"
+        || info.mode == "create" || info.mode == "pack"))
     {
         std::cout << std::endl << "ERROR: invalid mode \"" << info.mode << "\"\n\n"
             << desc << std::endl;
@@ -142,12 +160,18 @@ bool parseOptions (int argc, char** argv, Arguments &info)
     info.longformat = variables.count("long") != 0;
     info.fullpath = variables.count("full-path") != 0;
 
+    info.threads = variables["threads"].as<unsigned int>();
+    if (info.threads == 0)
+        info.threads = std::max(1u, boost::thread::hardware_concurrency());
+
     return true;
 }
 
 int list(Bsa::BSAFile& bsa, Arguments& info);
 int extract(Bsa::BSAFile& bsa, Arguments& info);
 int extractAll(Bsa::BSAFile& bsa, Arguments& info);
+int create(Arguments& info);
+int pack(Arguments& info);
 
 int main(int argc, char** argv)
 {
@@ -157,6 +181,11 @@ int main(int argc, char** argv)
         if(!parseOptions (argc, argv, info))
             return 1;
 
+        if (info.mode == "create")
+            return create(info);
+        if (info.mode == "pack")
+            return pack(info);
+
         // Open file
         Bsa::BSAFile bsa;
         bsa.open(info.filename);
@@ -251,21 +280,101 @@ int extract(Bsa::BSAFile& bsa, Arguments& info)
     return 0;
 }
 
+/// Files of an archive that are extracted by several threads at once
+struct ExtractQueue
+{
+    Bsa::BSAFile& mBsa;
+    std::vector<const Bsa::BSAFile::FileStruct*> mFiles;
+    std::vector<bfs::path> mTargets;
+
+    boost::mutex mMutex;
+    std::size_t mNext;
+    bool mFailed;
+
+    ExtractQueue(Bsa::BSAFile& bsa) : mBsa(bsa), mNext(0), mFailed(false) {}
+};
+
+bool isBefore(const Bsa::BSAFile::FileStruct* left, const Bsa::BSAFile::FileStruct* right)
+{
+    return left->offset < right->offset;
+}
+
+void extractFiles(ExtractQueue* queue)
+{
+    while (true)
+    {
+        std::size_t index;
+        {
+            boost::mutex::scoped_lock lock(queue->mMutex);
+            if (queue->mFailed || queue->mNext >= queue->mFiles.size())
+                return;
+            index = queue->mNext++;
+        }
+
+        const Bsa::BSAFile::FileStruct* file = queue->mFiles[index];
+        const bfs::path& target = queue->mTargets[index];
+
+        try
+        {
+            bfs::ofstream out(target, std::ios::binary);
+
+            // Write straight from the mapping, if there is one
+            if (const char* data = queue->mBsa.getFileData(file))
+                out.write(data, file->fileSize);
+            else if (file->fileSize > 0)
+                out << queue->mBsa.getFile(file)->rdbuf();
+
+            out.close();
+            if (out.fail())
+                throw std::runtime_error("failed to write " + target.string());
+
+            boost::mutex::scoped_lock lock(queue->mMutex);
+            std::cout << "Extracting " << target << std::endl;
+        }
+        catch (std::exception& e)
+        {
+            boost::mutex::scoped_lock lock(queue->mMutex);
+            std::cerr << "ERROR extracting " << file->name << ": " << e.what() << std::endl;
+            queue->mFailed = true;
+        }
+    }
+}
+
 int extractAll(Bsa::BSAFile& bsa, Arguments& info)
 {
-    // Get the list of files present in the archive
-    Bsa::BSAFile::FileList list = bsa.getList();
+    // Reading from a mapping needs no file handle per file, and does not seek in a shared stream
+    try
+    {
+        bsa.mapIntoMemory();
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Failed to map the archive into memory, reading it as a file instead: "
+            << e.what() << std::endl;
+    }
+
+    ExtractQueue queue(bsa);
 
-    // Iter on the list
-    for(Bsa::BSAFile::FileList::iterator it = list.begin(); it != list.end(); ++it) {
-        const char* archivePath = it->name;
+    // Extract in the order of the data in the archive, so that it is read from start to end
+    const Bsa::BSAFile::FileList& list = bsa.getList();
+    for (Bsa::BSAFile::FileList::const_iterator it = list.begin(); it != list.end(); ++it)
+        queue.mFiles.push_back(&*it);
+    std::sort(queue.mFiles.begin(), queue.mFiles.end(), isBefore);
 
-        std::string extractPath (archivePath);
+    // The directories are created up front, by this thread only
+    std::set<bfs::path> directories;
+    for (std::size_t i=0; i<queue.mFiles.size(); ++i)
+    {
+        std::string extractPath (queue.mFiles[i]->name);
         replaceAll(extractPath, "\\", "/");
 
         // Get the target path (the path the file will be extracted to)
         bfs::path target (info.outdir);
         target /= extractPath;
+        queue.mTargets.push_back(target);
+
+        if (!directories.insert(target.parent_path()).second)
+            continue;
 
         // Create the directory hierarchy
         bfs::create_directories(target.parent_path());
@@ -276,17 +385,313 @@ int extractAll(Bsa::BSAFile& bsa, Arguments& info)
             std::cout << "ERROR: " << target.parent_path() << " is not a directory." << std::endl;
             return 3;
         }
+    }
+
+    boost::thread_group threads;
+    for (unsigned int i=0; i<std::min<std::size_t>(info.threads, queue.mFiles.size()); ++i)
+        threads.create_thread(boost::bind(extractFiles, &queue));
+    threads.join_all();
+
+    return queue.mFailed ? 3 : 0;
+}
+
+/// A file that is added to a new archive
+struct PackedFile
+{
+    std::string mName; // lower case, with backslashes
+    bfs::path mSource;
+    uint32_t mSize;
+    uint32_t mOffset; // into the data buffer
+    uint32_t mHash[2];
+};
+
+/// The hash that Morrowind looks up the files of an archive by
+void getHash(const std::string& name, uint32_t hash[2])
+{
+    std::size_t half = name.size() / 2;
+
+    uint32_t sum = 0;
+    unsigned int shift = 0;
+    std::size_t i = 0;
+    for (; i<half; ++i)
+    {
+        sum ^= uint32_t(static_cast<unsigned char>(name[i])) << (shift & 0x1f);
+        shift += 8;
+    }
+    hash[0] = sum;
+
+    sum = 0;
+    shift = 0;
+    for (; i<name.size(); ++i)
+    {
+        uint32_t temp = uint32_t(static_cast<unsigned char>(name[i])) << (shift & 0x1f);
+        sum ^= temp;
+        unsigned int rotate = temp & 0x1f;
+        if (rotate)
+            sum = (sum << (32 - rotate)) | (sum >> rotate);
+        shift += 8;
+    }
+    hash[1] = sum;
+}
+
+/// Order of the file data: grouped by directory, then by name
+bool isBeforeInDirectory(const PackedFile* left, const PackedFile* right)
+{
+    std::size_t leftSplit = left->mName.rfind('\\');
+    std::size_t rightSplit = right->mName.rfind('\\');
+    std::string leftDir = leftSplit == std::string::npos ? std::string() : left->mName.substr(0, leftSplit);
+    std::string rightDir = rightSplit == std::string::npos ? std::string() : right->mName.substr(0, rightSplit);
+
+    if (leftDir != rightDir)
+        return leftDir < rightDir;
+    return left->mName < right->mName;
+}
+
+/// Order of the directory: by hash, like the archives of the game, then by name
+bool isBeforeInHash(const PackedFile* left, const PackedFile* right)
+{
+    if (left->mHash[0] != right->mHash[0])
+        return left->mHash[0] < right->mHash[0];
+    if (left->mHash[1] != right->mHash[1])
+        return left->mHash[1] < right->mHash[1];
+    return left->mName < right->mName;
+}
+
+void addFiles(const bfs::path& directory, const std::string& prefix, std::vector<PackedFile>& files)
+{
+    for (bfs::directory_iterator it (directory); it != bfs::directory_iterator(); ++it)
+    {
+        std::string name = prefix + boost::algorithm::to_lower_copy(it->path().filename().string());
+
+        if (bfs::is_directory(it->status()))
+            addFiles(it->path(), name + "\\", files);
+        else if (bfs::is_regular_file(it->status()))
+        {
+            boost::uintmax_t size = bfs::file_size(it->path());
+            if (size > 0xffffffff)
+                throw std::runtime_error("File too large for a BSA archive: " + it->path().string());
+
+            PackedFile file;
+            file.mName = name;
+            file.mSource = it->path();
+            file.mSize = static_cast<uint32_t>(size);
+            file.mOffset = 0;
+            getHash(name, file.mHash);
+            files.push_back(file);
+        }
+    }
+}
+
+template<typename T>
+void write(std::ostream& stream, const T& value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+int create(Arguments& info)
+{
+    bfs::path indir (info.outdir);
+    if (!bfs::is_directory(indir))
+    {
+        std::cout << "ERROR: " << indir << " is not a directory." << std::endl;
+        return 3;
+    }
+
+    std::vector<PackedFile> files;
+    addFiles(indir, "", files);
+
+    // Lay out the data by directory, so that reading the files of one directory stays local
+    std::vector<PackedFile*> dataOrder;
+    for (std::vector<PackedFile>::iterator it = files.begin(); it != files.end(); ++it)
+        dataOrder.push_back(&*it);
+    std::sort(dataOrder.begin(), dataOrder.end(), isBeforeInDirectory);
+
+    boost::uintmax_t offset = 0;
+    for (std::vector<PackedFile*>::iterator it = dataOrder.begin(); it != dataOrder.end(); ++it)
+    {
+        (*it)->mOffset = static_cast<uint32_t>(offset);
+        offset += (*it)->mSize;
+        if (offset > 0xffffffff)
+            throw std::runtime_error("Files too large for a BSA archive");
+    }
+
+    std::vector<PackedFile*> directory (dataOrder);
+    std::sort(directory.begin(), directory.end(), isBeforeInHash);
+
+    for (std::size_t i=1; i<directory.size(); ++i)
+        if (directory[i-1]->mHash[0] == directory[i]->mHash[0]
+            && directory[i-1]->mHash[1] == directory[i]->mHash[1])
+            std::cout << "WARNING: " << directory[i-1]->mName << " and " << directory[i]->mName
+                << " have the same hash, the game will only find one of them" << std::endl;
+
+    std::vector<uint32_t> nameOffsets;
+    uint32_t namesSize = 0;
+    for (std::vector<PackedFile*>::iterator it = directory.begin(); it != directory.end(); ++it)
+    {
+        nameOffsets.push_back(namesSize);
+        namesSize += static_cast<uint32_t>((*it)->mName.size()) + 1;
+    }
+
+    bfs::ofstream out(bfs::path(info.filename), std::ios::binary);
+    if (!out.is_open())
+    {
+        std::cout << "ERROR: failed to open " << info.filename << " for writing" << std::endl;
+        return 3;
+    }
+
+    uint32_t numFiles = static_cast<uint32_t>(directory.size());
+
+    // Header (see Bsa::BSAFile::readHeader for the layout)
+    write(out, uint32_t(0x100));
+    write(out, uint32_t(12 * numFiles + namesSize));
+    write(out, numFiles);
+
+    for (std::vector<PackedFile*>::iterator it = directory.begin(); it != directory.end(); ++it)
+    {
+        write(out, (*it)->mSize);
+        write(out, (*it)->mOffset);
+    }
+
+    for (std::vector<uint32_t>::iterator it = nameOffsets.begin(); it != nameOffsets.end(); ++it)
+        write(out, *it);
+
+    for (std::vector<PackedFile*>::iterator it = directory.begin(); it != directory.end(); ++it)
+        out.write((*it)->mName.c_str(), (*it)->mName.size() + 1);
+
+    for (std::vector<PackedFile*>::iterator it = directory.begin(); it != directory.end(); ++it)
+    {
+        write(out, (*it)->mHash[0]);
+        write(out, (*it)->mHash[1]);
+    }
+
+    boost::uintmax_t dataStart = static_cast<boost::uintmax_t>(out.tellp());
+    for (std::vector<PackedFile*>::iterator it = dataOrder.begin(); it != dataOrder.end(); ++it)
+    {
+        std::cout << "Adding " << (*it)->mName << std::endl;
+
+        bfs::ifstream in((*it)->mSource, std::ios::binary);
+        if ((*it)->mSize > 0)
+            out << in.rdbuf();
+
+        if (!in || static_cast<boost::uintmax_t>(out.tellp()) != dataStart + (*it)->mOffset + (*it)->mSize)
+        {
+            std::cout << "ERROR: failed to add " << (*it)->mSource << std::endl;
+            return 3;
+        }
+    }
+
+    out.close();
+    if (out.fail())
+    {
+        std::cout << "ERROR: failed to write " << info.filename << std::endl;
+        return 3;
+    }
+
+    return 0;
+}
+
+int pack(Arguments& info)
+{
+    bfs::path indir (info.outdir);
+    if (!bfs::is_directory(indir))
+    {
+        std::cout << "ERROR: " << indir << " is not a directory." << std::endl;
+        return 3;
+    }
+
+    std::vector<PackedFile> files;
+    addFiles(indir, "", files);
+
+    // Lay out the data by directory, so that reading the files of one directory stays local
+    std::vector<PackedFile*> dataOrder;
+    for (std::vector<PackedFile>::iterator it = files.begin(); it != files.end(); ++it)
+        dataOrder.push_back(&*it);
+    std::sort(dataOrder.begin(), dataOrder.end(), isBeforeInDirectory);
+
+    std::vector<uint32_t> nameOffsets;
+    uint32_t namesSize = 0;
+    for (std::vector<PackedFile*>::iterator it = dataOrder.begin(); it != dataOrder.end(); ++it)
+    {
+        nameOffsets.push_back(namesSize);
+        namesSize += static_cast<uint32_t>((*it)->mName.size()) + 1;
+    }
+
+    bfs::ofstream out(bfs::path(info.filename), std::ios::binary);
+    if (!out.is_open())
+    {
+        std::cout << "ERROR: failed to open " << info.filename << " for writing" << std::endl;
+        return 3;
+    }
+
+    uint32_t numFiles = static_cast<uint32_t>(dataOrder.size());
+
+    // Header (see Bsa::PackFile for the layout)
+    write(out, Bsa::PackFile::sMagic);
+    write(out, Bsa::PackFile::sVersion);
+    write(out, numFiles);
+    write(out, namesSize);
+
+    // The records are written once the stored sizes are known
+    const boost::uintmax_t recordsStart = static_cast<boost::uintmax_t>(out.tellp());
+    std::vector<uint32_t> records (4 * numFiles);
+    if (numFiles > 0)
+        out.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(uint32_t));
+
+    for (std::vector<PackedFile*>::iterator it = dataOrder.begin(); it != dataOrder.end(); ++it)
+        out.write((*it)->mName.c_str(), (*it)->mName.size() + 1);
+
+    boost::uintmax_t offset = static_cast<boost::uintmax_t>(out.tellp());
+    boost::uintmax_t totalSize = 0;
+    std::vector<char> data;
+    std::vector<char> compressed;
+    for (std::size_t i=0; i<dataOrder.size(); ++i)
+    {
+        const PackedFile& file = *dataOrder[i];
+
+        data.resize(file.mSize);
+        bfs::ifstream in(file.mSource, std::ios::binary);
+        if (file.mSize > 0)
+            in.read(&data[0], data.size());
+        if (!in)
+        {
+            std::cout << "ERROR: failed to read " << file.mSource << std::endl;
+            return 3;
+        }
+
+        compressed.clear();
+        Files::compressLz4(data.empty() ? NULL : &data[0], data.size(), compressed);
+
+        // Keep the file as it is if compressing does not make it smaller
+        const std::vector<char>& stored = compressed.size() < data.size() ? compressed : data;
 
-        // Get a stream for the file to extract
-        // (inefficient because getFile iter on the list again)
-        Files::IStreamPtr data = bsa.getFile(archivePath);
-        bfs::ofstream out(target, std::ios::binary);
+        if (offset + stored.size() > 0xffffffff)
+            throw std::runtime_error("Files too large for a pack archive");
 
-        // Write the file to disk
-        std::cout << "Extracting " << target << std::endl;
-        out << data->rdbuf();
-        out.close();
+        records[4*i] = static_cast<uint32_t>(offset);
+        records[4*i+1] = static_cast<uint32_t>(stored.size());
+        records[4*i+2] = file.mSize;
+        records[4*i+3] = nameOffsets[i];
+
+        std::cout << "Adding " << file.mName << " (" << file.mSize << " -> " << stored.size() << " bytes)" << std::endl;
+
+        if (!stored.empty())
+            out.write(&stored[0], stored.size());
+        offset += stored.size();
+        totalSize += file.mSize;
     }
 
+    out.seekp(recordsStart);
+    if (numFiles > 0)
+        out.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(uint32_t));
+
+    out.close();
+    if (out.fail())
+    {
+        std::cout << "ERROR: failed to write " << info.filename << std::endl;
+        return 3;
+    }
+
+    std::cout << "Packed " << numFiles << " files of " << totalSize << " bytes into " << offset << " bytes" << std::endl;
+
     return 0;
 }
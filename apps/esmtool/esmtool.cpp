@@ -5,8 +5,15 @@
 #include <map>
 #include <set>
 #include <fstream>
+#include <sstream>
+#include <memory>
 
 #include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/crc.hpp>
 
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
@@ -14,10 +21,11 @@
 
 #include "record.hpp"
 
-#define ESMTOOL_VERSION 1.2
+#define ESMTOOL_VERSION 1.3
 
 // Create a local alias for brevity
 namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
 
 struct ESMData
 {
@@ -70,7 +78,7 @@ struct Arguments
 
 bool parseOptions (int argc, char** argv, Arguments &info)
 {
-    bpo::options_description desc("Inspect and extract from Morrowind ES files (ESM, ESP, ESS)\nSyntax: esmtool [options] mode infile [outfile]\nAllowed modes:\n  dump\t Dumps all readable data from the input file.\n  clone\t Clones the input file to the output file.\n  comp\t Compares the given files.\n\nAllowed options");
+    bpo::options_description desc("Inspect and extract from Morrowind ES files (ESM, ESP, ESS)\nSyntax: esmtool [options] mode infile [outfile]\nAllowed modes:\n  dump\t Dumps all readable data from the input file.\n  clone\t Clones the input file to the output file.\n  comp\t Compares the given files.\n  index\t Writes an index of the records of the input file next to it, which\n\t dump then uses to seek to the records selected by --type and --name.\n  diff\t Lists the records that differ between the given files, using their indexes.\n\nAllowed options");
 
     desc.add_options()
         ("help,h", "print help message.")
@@ -80,9 +88,9 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         // with other modes including clone, dump, and raw.
         ("type,t", bpo::value< std::vector<std::string> >(),
          "Show only records of this type (four character record code).  May "
-         "be specified multiple times.  Only affects dump mode.")
+         "be specified multiple times.  Only affects dump and diff modes.")
         ("name,n", bpo::value<std::string>(),
-         "Show only the record with this name.  Only affects dump mode.")
+         "Show only the record with this name.  Only affects dump and diff modes.")
         ("plain,p", "Print contents of dialogs, books and scripts. "
          "(skipped by default)"
          "Only affects dump mode.")
@@ -158,7 +166,8 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         info.name = variables["name"].as<std::string>();
 
     info.mode = variables["mode"].as<std::string>();
-    if (!(info.mode == "dump" || info.mode == "clone" || info.mode == "comp"))
+    if (!(info.mode == "dump" || info.mode == "clone" || info.mode == "comp"
+        || info.mode == "index" || info.mode == "diff"))
     {
         std::cout << std::endl << "ERROR: invalid mode \"" << info.mode << "\"" << std::endl << std::endl
                   << desc << finalText << std::endl;
@@ -207,6 +216,8 @@ void loadCell(ESM::Cell &cell, ESM::ESMReader &esm, Arguments& info);
 int load(Arguments& info);
 int clone(Arguments& info);
 int comp(Arguments& info);
+int index(Arguments& info);
+int diff(Arguments& info);
 
 int main(int argc, char**argv)
 {
@@ -222,6 +233,10 @@ int main(int argc, char**argv)
             return clone(info);
         else if (info.mode == "comp")
             return comp(info);
+        else if (info.mode == "index")
+            return index(info);
+        else if (info.mode == "diff")
+            return diff(info);
         else
         {
             std::cout << "Invalid or no mode specified, dying horribly. Have a nice day." << std::endl;
@@ -298,6 +313,8 @@ void printRaw(ESM::ESMReader &esm)
     }
 }
 
+int loadIndexed(Arguments& info);
+
 int load(Arguments& info)
 {
     ESM::ESMReader& esm = info.reader;
@@ -322,6 +339,14 @@ int load(Arguments& info)
             return 0;
         }
 
+        // With an index, only the selected records need to be read
+        if (info.mode == "dump" && (!info.types.empty() || !info.name.empty()))
+        {
+            int result = loadIndexed(info);
+            if (result >= 0)
+                return result;
+        }
+
         bool quiet = (info.quiet_given || info.mode == "clone");
         bool loadCells = (info.loadcells_given || info.mode == "clone");
         bool save = (info.mode == "clone");
@@ -572,3 +597,315 @@ int comp(Arguments& info)
 
     return 0;
 }
+
+/// Position and contents of a record, as stored in the index of a file
+struct IndexEntry
+{
+    ESM::NAME mType;
+    uint32_t mFlags;
+    size_t mOffset;
+    size_t mSize; // including the record header
+    uint32_t mChecksum;
+    std::string mId;
+};
+
+typedef std::vector<IndexEntry> Index;
+
+static const char* sIndexMagic = "ESMTOOL_INDEX";
+static const int sIndexVersion = 1;
+
+std::string getIndexName(const std::string& filename)
+{
+    return filename + ".idx";
+}
+
+/// Header line of the index, which ties it to the state of the file it was built from
+std::string getIndexHeader(const std::string& filename)
+{
+    bfs::path path (filename);
+
+    std::ostringstream stream;
+    stream << sIndexMagic << " " << sIndexVersion << " " << bfs::file_size(path)
+        << " " << bfs::last_write_time(path);
+    return stream.str();
+}
+
+/// Read the index of \a filename, if it has one that is up to date.
+bool readIndex(const std::string& filename, Index& index)
+{
+    bfs::ifstream stream (bfs::path(getIndexName(filename)));
+    if (!stream.is_open())
+        return false;
+
+    std::string line;
+    if (!std::getline(stream, line) || line != getIndexHeader(filename))
+        return false;
+
+    index.clear();
+    while (std::getline(stream, line))
+    {
+        std::string::size_type idStart = line.find('\t');
+        if (idStart == std::string::npos)
+            return false;
+
+        std::istringstream fields (line.substr(0, idStart));
+        std::string type;
+        IndexEntry entry;
+        if (!(fields >> type >> entry.mFlags >> entry.mOffset >> entry.mSize >> entry.mChecksum))
+            return false;
+
+        entry.mType.assign(type);
+        entry.mId = line.substr(idStart + 1);
+        index.push_back(entry);
+    }
+
+    return true;
+}
+
+void writeIndex(const std::string& filename, const Index& index)
+{
+    bfs::ofstream stream (bfs::path(getIndexName(filename)));
+    if (!stream.is_open())
+        throw std::runtime_error("Failed to open " + getIndexName(filename) + " for writing");
+
+    stream << getIndexHeader(filename) << "\n";
+    for (Index::const_iterator it = index.begin(); it != index.end(); ++it)
+        stream << it->mType.toString() << " " << it->mFlags << " " << it->mOffset << " " << it->mSize
+            << " " << it->mChecksum << "\t" << it->mId << "\n";
+
+    if (!stream)
+        throw std::runtime_error("Failed to write " + getIndexName(filename));
+}
+
+/// Build the index of \a filename in one pass through its records, and write it next to the file.
+void buildIndex(const std::string& filename, const std::string& encoding, Index& index)
+{
+    ESM::ESMReader esm;
+    ToUTF8::Utf8Encoder encoder (ToUTF8::calculateEncoding(encoding));
+    esm.setEncoder(&encoder);
+    esm.open(filename);
+
+    index.clear();
+    while (esm.hasMoreRecs())
+    {
+        IndexEntry entry;
+        entry.mOffset = esm.getFileOffset();
+        entry.mType = esm.getRecName();
+        esm.getRecHeader(entry.mFlags);
+        entry.mSize = 16 + esm.getContext().leftRec;
+        entry.mChecksum = 0;
+
+        // The IDs of some record types are only known after loading them
+        std::auto_ptr<EsmTool::RecordBase> record (EsmTool::RecordBase::create(entry.mType));
+        if (record.get())
+        {
+            record->load(esm);
+            entry.mId = record->getId();
+        }
+        esm.skipRecord();
+
+        index.push_back(entry);
+    }
+    esm.close();
+
+    // The checksums are taken from the raw records, in a single pass through the file
+    bfs::ifstream stream (bfs::path(filename), std::ios::binary);
+    std::vector<char> buffer;
+    for (Index::iterator it = index.begin(); it != index.end(); ++it)
+    {
+        buffer.resize(it->mSize);
+        stream.seekg(it->mOffset);
+        if (!stream.read(&buffer[0], buffer.size()))
+            throw std::runtime_error("Failed to read the records of " + filename);
+
+        boost::crc_32_type crc;
+        crc.process_bytes(&buffer[0], buffer.size());
+        it->mChecksum = crc.checksum();
+    }
+
+    writeIndex(filename, index);
+}
+
+/// Read the index of \a filename, or build it if it has none or it is out of date.
+/// @note Stores the error in \a error instead of throwing, so that it can run on its own thread.
+void getIndex(const std::string& filename, const std::string& encoding, Index& index, std::string& error)
+{
+    try
+    {
+        if (!readIndex(filename, index))
+            buildIndex(filename, encoding, index);
+    }
+    catch (std::exception& e)
+    {
+        error = e.what();
+    }
+}
+
+bool isSelected(const Arguments& info, const IndexEntry& entry)
+{
+    if (!info.types.empty()
+        && std::find(info.types.begin(), info.types.end(), entry.mType.toString()) == info.types.end())
+        return false;
+
+    return info.name.empty() || Misc::StringUtils::ciEqual(info.name, entry.mId);
+}
+
+int index(Arguments& info)
+{
+    Index index;
+    buildIndex(info.filename, info.encoding, index);
+
+    std::cout << "Wrote the index of " << index.size() << " records to " << getIndexName(info.filename)
+        << std::endl;
+    return 0;
+}
+
+/// Dump the records selected by type and name, seeking to them through the index of the file.
+/// @return -1 if the file has no index that is up to date
+int loadIndexed(Arguments& info)
+{
+    Index index;
+    if (!readIndex(info.filename, index))
+        return -1;
+
+    std::cout << "Using the index " << getIndexName(info.filename) << std::endl;
+
+    ESM::ESMReader& esm = info.reader;
+    esm.open(info.filename);
+
+    bool quiet = info.quiet_given;
+    ESM::ESM_Context context = esm.getContext();
+    size_t fileSize = context.leftFile + context.filePos;
+
+    for (Index::const_iterator it = index.begin(); it != index.end(); ++it)
+    {
+        if (!isSelected(info, *it))
+            continue;
+
+        context.filePos = it->mOffset;
+        context.leftFile = fileSize - it->mOffset;
+        context.leftRec = 0;
+        context.leftSub = 0;
+        context.subCached = false;
+        esm.restoreContext(context);
+
+        ESM::NAME n = esm.getRecName();
+        uint32_t flags;
+        esm.getRecHeader(flags);
+
+        std::auto_ptr<EsmTool::RecordBase> record (EsmTool::RecordBase::create(n));
+        if (!record.get())
+            continue;
+
+        record->setFlags(static_cast<int>(flags));
+        record->setPrintPlain(info.plain_given);
+        record->load(esm);
+
+        if (!quiet)
+        {
+            std::cout << "\nRecord: " << n.toString() << " '" << record->getId() << "'\n";
+            record->print();
+        }
+
+        if (record->getType().val == ESM::REC_CELL && info.loadcells_given)
+            loadCell(record->cast<ESM::Cell>()->get(), esm, info);
+
+        ++info.data.mRecordStats[n.val];
+    }
+
+    return 0;
+}
+
+/// Key of a record for comparing files: its type and ID, and which one of the records with this type and ID
+/// it is, for the records without a unique ID
+typedef std::map<std::string, const IndexEntry*> IndexKeys;
+
+void getIndexKeys(const Arguments& info, const Index& index, IndexKeys& keys)
+{
+    std::map<std::string, int> occurrences;
+    for (Index::const_iterator it = index.begin(); it != index.end(); ++it)
+    {
+        if (!isSelected(info, *it))
+            continue;
+
+        std::string key = it->mType.toString() + " '" + Misc::StringUtils::lowerCase(it->mId) + "'";
+        int occurrence = occurrences[key]++;
+        if (occurrence > 0)
+        {
+            std::ostringstream stream;
+            stream << key << " #" << occurrence + 1;
+            key = stream.str();
+        }
+        keys[key] = &*it;
+    }
+}
+
+int diff(Arguments& info)
+{
+    if (info.filename.empty() || info.outname.empty())
+    {
+        std::cout << "You need to specify two input files" << std::endl;
+        return 1;
+    }
+
+    // Both files are indexed at the same time
+    Index indexOne;
+    Index indexTwo;
+    std::string errorOne;
+    std::string errorTwo;
+    {
+        boost::thread thread (boost::bind(getIndex, boost::cref(info.filename), boost::cref(info.encoding),
+            boost::ref(indexOne), boost::ref(errorOne)));
+        getIndex(info.outname, info.encoding, indexTwo, errorTwo);
+        thread.join();
+    }
+
+    if (!errorOne.empty())
+    {
+        std::cout << "Failed to index " << info.filename << ": " << errorOne << std::endl;
+        return 1;
+    }
+    if (!errorTwo.empty())
+    {
+        std::cout << "Failed to index " << info.outname << ": " << errorTwo << std::endl;
+        return 1;
+    }
+
+    IndexKeys keysOne;
+    IndexKeys keysTwo;
+    getIndexKeys(info, indexOne, keysOne);
+    getIndexKeys(info, indexTwo, keysTwo);
+
+    int differences = 0;
+    IndexKeys::const_iterator one = keysOne.begin();
+    IndexKeys::const_iterator two = keysTwo.begin();
+    while (one != keysOne.end() || two != keysTwo.end())
+    {
+        if (two == keysTwo.end() || (one != keysOne.end() && one->first < two->first))
+        {
+            std::cout << "Only in " << info.filename << ": " << one->first << std::endl;
+            ++differences;
+            ++one;
+        }
+        else if (one == keysOne.end() || two->first < one->first)
+        {
+            std::cout << "Only in " << info.outname << ": " << two->first << std::endl;
+            ++differences;
+            ++two;
+        }
+        else
+        {
+            // The checksum covers the record header as well, so a changed flag is a difference too
+            if (one->second->mSize != two->second->mSize || one->second->mChecksum != two->second->mChecksum)
+            {
+                std::cout << "Changed: " << one->first << std::endl;
+                ++differences;
+            }
+            ++one;
+            ++two;
+        }
+    }
+
+    std::cout << differences << " different records" << std::endl;
+    return differences > 0 ? 1 : 0;
+}
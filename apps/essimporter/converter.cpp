@@ -1,11 +1,16 @@
 #include "converter.hpp"
 
 #include <stdexcept>
+#include <algorithm>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 #include <osgDB/WriteFile>
 
 #include <components/esm/creaturestate.hpp>
 #include <components/esm/containerstate.hpp>
+#include <components/esm/npcstate.hpp>
 
 #include "convertcrec.hpp"
 #include "convertcntc.hpp"
@@ -280,18 +285,54 @@ namespace ESSImport
             mIntCells[cell.mName] = newcell;
     }
 
-    void ConvertCell::writeCell(const Cell &cell, ESM::ESMWriter& esm)
+    /// Converts the references of the cells on a number of threads, with a separate output list per cell.
+    struct ConvertCell::ConvertJob
     {
-        ESM::Cell esmcell = cell.mCell;
-        esm.startRecord(ESM::REC_CSTA);
-        ESM::CellState csta;
-        csta.mHasFogOfWar = 0;
-        csta.mId = esmcell.getCellId();
-        csta.mId.save(esm);
-        // TODO csta.mLastRespawn;
-        // shouldn't be needed if we respawn on global schedule like in original MW
-        csta.mWaterLevel = esmcell.mWater;
-        csta.save(esm);
+        ConvertJob(const ConvertCell& converter, const std::vector<const Cell*>& cells)
+            : mConverter(converter)
+            , mCells(cells)
+            , mObjects(cells.size())
+            , mNext(0)
+        {
+        }
+
+        void run()
+        {
+            while (true)
+            {
+                size_t index;
+                {
+                    boost::mutex::scoped_lock lock(mMutex);
+                    if (mNext >= mCells.size() || !mError.empty())
+                        return;
+                    index = mNext++;
+                }
+
+                try
+                {
+                    mConverter.convertRefs(*mCells[index], mObjects[index]);
+                }
+                catch (std::exception& e)
+                {
+                    boost::mutex::scoped_lock lock(mMutex);
+                    if (mError.empty())
+                        mError = e.what();
+                }
+            }
+        }
+
+        const ConvertCell& mConverter;
+        const std::vector<const Cell*>& mCells;
+        std::vector<ObjectList> mObjects;
+
+        boost::mutex mMutex;
+        size_t mNext;
+        std::string mError;
+    };
+
+    void ConvertCell::convertRefs(const Cell &cell, ObjectList& objects) const
+    {
+        objects.reserve(cell.mRefs.size());
 
         for (std::vector<CellRef>::const_iterator refIt = cell.mRefs.begin(); refIt != cell.mRefs.end(); ++refIt)
         {
@@ -307,14 +348,13 @@ namespace ESSImport
                 out.mRefID = cellref.mIndexedRefId;
                 std::string idLower = Misc::StringUtils::lowerCase(out.mRefID);
 
-                ESM::ObjectState objstate;
-                objstate.blank();
-                objstate.mRef = out;
-                objstate.mRef.mRefID = idLower;
-                objstate.mHasCustomState = false;
-                convertCellRef(cellref, objstate);
-                esm.writeHNT ("OBJE", 0);
-                objstate.save(esm);
+                boost::shared_ptr<ESM::ObjectState> objstate (new ESM::ObjectState);
+                objstate->blank();
+                objstate->mRef = out;
+                objstate->mRef.mRefID = idLower;
+                objstate->mHasCustomState = false;
+                convertCellRef(cellref, *objstate);
+                objects.push_back(std::make_pair(0, objstate));
                 continue;
             }
             else
@@ -331,21 +371,20 @@ namespace ESSImport
                             std::make_pair(refIndex, out.mRefID));
                 if (npccIt != mContext->mNpcChanges.end())
                 {
-                    ESM::NpcState objstate;
-                    objstate.blank();
-                    objstate.mRef = out;
-                    objstate.mRef.mRefID = idLower;
+                    boost::shared_ptr<ESM::NpcState> objstate (new ESM::NpcState);
+                    objstate->blank();
+                    objstate->mRef = out;
+                    objstate->mRef.mRefID = idLower;
                     // TODO: need more micromanagement here so we don't overwrite values
                     // from the ESM with default values
                     if (cellref.mHasACDT)
-                        convertACDT(cellref.mACDT, objstate.mCreatureStats);
+                        convertACDT(cellref.mACDT, objstate->mCreatureStats);
                     if (cellref.mHasACSC)
-                        convertACSC(cellref.mACSC, objstate.mCreatureStats);
-                    convertNpcData(cellref, objstate.mNpcStats);
-                    convertNPCC(npccIt->second, objstate);
-                    convertCellRef(cellref, objstate);
-                    esm.writeHNT ("OBJE", ESM::REC_NPC_);
-                    objstate.save(esm);
+                        convertACSC(cellref.mACSC, objstate->mCreatureStats);
+                    convertNpcData(cellref, objstate->mNpcStats);
+                    convertNPCC(npccIt->second, *objstate);
+                    convertCellRef(cellref, *objstate);
+                    objects.push_back(std::make_pair(ESM::REC_NPC_, objstate));
                     continue;
                 }
 
@@ -353,14 +392,13 @@ namespace ESSImport
                             std::make_pair(refIndex, out.mRefID));
                 if (cntcIt != mContext->mContainerChanges.end())
                 {
-                    ESM::ContainerState objstate;
-                    objstate.blank();
-                    objstate.mRef = out;
-                    objstate.mRef.mRefID = idLower;
-                    convertCNTC(cntcIt->second, objstate);
-                    convertCellRef(cellref, objstate);
-                    esm.writeHNT ("OBJE", ESM::REC_CONT);
-                    objstate.save(esm);
+                    boost::shared_ptr<ESM::ContainerState> objstate (new ESM::ContainerState);
+                    objstate->blank();
+                    objstate->mRef = out;
+                    objstate->mRef.mRefID = idLower;
+                    convertCNTC(cntcIt->second, *objstate);
+                    convertCellRef(cellref, *objstate);
+                    objects.push_back(std::make_pair(ESM::REC_CONT, objstate));
                     continue;
                 }
 
@@ -368,20 +406,19 @@ namespace ESSImport
                             std::make_pair(refIndex, out.mRefID));
                 if (crecIt != mContext->mCreatureChanges.end())
                 {
-                    ESM::CreatureState objstate;
-                    objstate.blank();
-                    objstate.mRef = out;
-                    objstate.mRef.mRefID = idLower;
+                    boost::shared_ptr<ESM::CreatureState> objstate (new ESM::CreatureState);
+                    objstate->blank();
+                    objstate->mRef = out;
+                    objstate->mRef.mRefID = idLower;
                     // TODO: need more micromanagement here so we don't overwrite values
                     // from the ESM with default values
                     if (cellref.mHasACDT)
-                        convertACDT(cellref.mACDT, objstate.mCreatureStats);
+                        convertACDT(cellref.mACDT, objstate->mCreatureStats);
                     if (cellref.mHasACSC)
-                        convertACSC(cellref.mACSC, objstate.mCreatureStats);
-                    convertCREC(crecIt->second, objstate);
-                    convertCellRef(cellref, objstate);
-                    esm.writeHNT ("OBJE", ESM::REC_CREA);
-                    objstate.save(esm);
+                        convertACSC(cellref.mACSC, objstate->mCreatureStats);
+                    convertCREC(crecIt->second, *objstate);
+                    convertCellRef(cellref, *objstate);
+                    objects.push_back(std::make_pair(ESM::REC_CREA, objstate));
                     continue;
                 }
 
@@ -390,17 +427,54 @@ namespace ESSImport
                 throw std::runtime_error(error.str());
             }
         }
+    }
+
+    void ConvertCell::writeCell(const Cell &cell, const ObjectList& objects, ESM::ESMWriter& esm)
+    {
+        ESM::Cell esmcell = cell.mCell;
+        esm.startRecord(ESM::REC_CSTA);
+        ESM::CellState csta;
+        csta.mHasFogOfWar = 0;
+        csta.mId = esmcell.getCellId();
+        csta.mId.save(esm);
+        // TODO csta.mLastRespawn;
+        // shouldn't be needed if we respawn on global schedule like in original MW
+        csta.mWaterLevel = esmcell.mWater;
+        csta.save(esm);
+
+        for (ObjectList::const_iterator it = objects.begin(); it != objects.end(); ++it)
+        {
+            esm.writeHNT ("OBJE", it->first);
+            it->second->save(esm);
+        }
 
         esm.endRecord(ESM::REC_CSTA);
     }
 
     void ConvertCell::write(ESM::ESMWriter &esm)
     {
+        std::vector<const Cell*> cells;
         for (std::map<std::string, Cell>::const_iterator it = mIntCells.begin(); it != mIntCells.end(); ++it)
-            writeCell(it->second, esm);
-
+            cells.push_back(&it->second);
         for (std::map<std::pair<int, int>, Cell>::const_iterator it = mExtCells.begin(); it != mExtCells.end(); ++it)
-            writeCell(it->second, esm);
+            cells.push_back(&it->second);
+
+        // The cells are independent of each other, convert them in parallel and write them in order afterwards
+        ConvertJob job(*this, cells);
+        {
+            size_t numThreads = std::max(1u, boost::thread::hardware_concurrency());
+            boost::thread_group threads;
+            for (size_t i=1; i<numThreads; ++i)
+                threads.create_thread(boost::bind(&ConvertJob::run, &job));
+            job.run();
+            threads.join_all();
+        }
+
+        if (!job.mError.empty())
+            throw std::runtime_error(job.mError);
+
+        for (size_t i=0; i<cells.size(); ++i)
+            writeCell(*cells[i], job.mObjects[i], esm);
 
         for (std::vector<ESM::CustomMarker>::const_iterator it = mMarkers.begin(); it != mMarkers.end(); ++it)
         {
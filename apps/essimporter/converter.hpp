@@ -3,6 +3,8 @@
 
 #include <limits>
 
+#include <boost/shared_ptr.hpp>
+
 #include <osg/Image>
 #include <osg/ref_ptr>
 
@@ -14,6 +16,7 @@
 #include <components/esm/loadclas.hpp>
 #include <components/esm/loadglob.hpp>
 #include <components/esm/cellstate.hpp>
+#include <components/esm/objectstate.hpp>
 #include <components/esm/loadfact.hpp>
 #include <components/esm/dialoguestate.hpp>
 #include <components/esm/custommarkerstate.hpp>
@@ -342,7 +345,15 @@ private:
 
     std::vector<ESM::CustomMarker> mMarkers;
 
-    void writeCell(const Cell& cell, ESM::ESMWriter &esm);
+    /// The converted references of a cell, with the record type to write for each
+    typedef std::vector<std::pair<int, boost::shared_ptr<ESM::ObjectState> > > ObjectList;
+
+    struct ConvertJob;
+
+    /// @note Only reads the context, so that the cells can be converted on a number of threads.
+    void convertRefs(const Cell& cell, ObjectList& objects) const;
+
+    void writeCell(const Cell& cell, const ObjectList& objects, ESM::ESMWriter &esm);
 };
 
 class ConvertKLST : public Converter
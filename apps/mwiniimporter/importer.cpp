@@ -886,17 +886,21 @@ void MwIniImporter::setInputEncoding(const ToUTF8::FromType &encoding)
 std::time_t MwIniImporter::lastWriteTime(const boost::filesystem::path& filename, std::time_t defaultTime)
 {
     std::time_t writeTime(defaultTime);
-    if (boost::filesystem::exists(filename))
-    {
-        // FixMe: remove #if when Boost dependency for Linux builds updated
-        // This allows Linux to build until then
+
+    // The error codes replace a separate check for the existence of the file, each of these is a file system query
+    boost::system::error_code ec;
+    // FixMe: remove #if when Boost dependency for Linux builds updated
+    // This allows Linux to build until then
 #if (BOOST_VERSION >= 104800)
-        // need to resolve any symlinks so that we get time of file, not symlink
-        boost::filesystem::path resolved = boost::filesystem::canonical(filename);
+    // need to resolve any symlinks so that we get time of file, not symlink
+    boost::filesystem::path resolved = boost::filesystem::canonical(filename, ec);
 #else
-        boost::filesystem::path resolved = filename;
+    boost::filesystem::path resolved = filename;
 #endif
-        writeTime = boost::filesystem::last_write_time(resolved);
+    std::time_t time = ec ? 0 : boost::filesystem::last_write_time(resolved, ec);
+    if (!ec)
+    {
+        writeTime = time;
         std::cout << "content file: " << resolved << " timestamp = (" << writeTime <<
             ") " << asctime(localtime(&writeTime)) << std::endl;
     }
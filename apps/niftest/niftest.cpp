@@ -1,10 +1,17 @@
 ///Program to test .nif files both on the FileSystem and in BSA archives.
 
 #include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <cstdlib>
+#include <algorithm>
+
+#include <osg/Timer>
 
 #include <components/nif/niffile.hpp>
+#include <components/nifosg/nifloader.hpp>
+#include <components/nifbullet/bulletnifloader.hpp>
+#include <components/resource/texturemanager.hpp>
 #include <components/files/constrainedfilestream.hpp>
 #include <components/vfs/manager.hpp>
 #include <components/vfs/bsaarchive.hpp>
@@ -12,6 +19,8 @@
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 // Create local aliases for brevity
 namespace bpo = boost::program_options;
@@ -68,7 +77,7 @@ void readVFS(VFS::Archive* anArchive,std::string archivePath = "")
                 if(!archivePath.empty() && !isBSA(archivePath))
                 {
 //                     std::cout << "Reading BSA File: " << name << std::endl;
-                    readVFS(new VFS::BsaArchive(archivePath+name),archivePath+name+"/");
+                    readVFS(new VFS::BsaArchive(archivePath+name, true),archivePath+name+"/");
 //                     std::cout << "Done with BSA File: " << name << std::endl;
                 }
             }
@@ -80,16 +89,211 @@ void readVFS(VFS::Archive* anArchive,std::string archivePath = "")
     }
 }
 
-std::vector<std::string> parseOptions (int argc, char** argv)
+struct Options
+{
+    std::vector<std::string> mInputs;
+
+    bool mBulk;
+    bool mConvert;
+    bool mTimes;
+    unsigned int mThreads;
+    unsigned int mSlowest;
+};
+
+/// Parse and optionally convert all nif files of a virtual file system on a number of threads
+class BulkTest
+{
+public:
+    struct Result
+    {
+        std::string mName;
+        double mParseTime;
+        double mConvertTime;
+        bool mFailed;
+    };
+
+    BulkTest(const VFS::Manager* vfs, const Options& options)
+        : mVFS(vfs)
+        , mOptions(options)
+        , mTextureManager(vfs)
+        , mNext(0)
+    {
+        const std::map<std::string, VFS::File*>& index = vfs->getIndex();
+        for (std::map<std::string, VFS::File*>::const_iterator it = index.begin(); it != index.end(); ++it)
+            if (isNIF(it->first))
+                mNames.push_back(it->first);
+        mResults.resize(mNames.size());
+    }
+
+    void run()
+    {
+        NifBullet::BulletNifLoader bulletLoader;
+
+        while (true)
+        {
+            size_t index;
+            {
+                boost::mutex::scoped_lock lock(mMutex);
+                if (mNext >= mNames.size())
+                    return;
+                index = mNext++;
+            }
+
+            Result& result = mResults[index];
+            result.mName = mNames[index];
+            result.mParseTime = 0;
+            result.mConvertTime = 0;
+            result.mFailed = false;
+
+            osg::Timer_t start = osg::Timer::instance()->tick();
+            try
+            {
+                Nif::NIFFilePtr file (new Nif::NIFFile(mVFS->getNormalized(result.mName), result.mName));
+
+                osg::Timer_t parsed = osg::Timer::instance()->tick();
+                result.mParseTime = osg::Timer::instance()->delta_s(start, parsed);
+
+                if (mOptions.mConvert)
+                {
+                    NifOsg::Loader::load(file, &mTextureManager);
+                    bulletLoader.load(file);
+                    result.mConvertTime = osg::Timer::instance()->delta_s(parsed, osg::Timer::instance()->tick());
+                }
+            }
+            catch (std::exception& e)
+            {
+                result.mFailed = true;
+
+                boost::mutex::scoped_lock lock(mMutex);
+                std::cerr << "ERROR, an exception has occurred:  " << e.what() << std::endl;
+            }
+
+            if (mOptions.mTimes)
+            {
+                boost::mutex::scoped_lock lock(mMutex);
+                std::cout << std::fixed << std::setprecision(2) << result.mName << ": parse "
+                    << result.mParseTime * 1000 << " ms, convert " << result.mConvertTime * 1000 << " ms" << std::endl;
+            }
+        }
+    }
+
+    /// @note Only call once all threads have finished.
+    const std::vector<Result>& getResults() const
+    {
+        return mResults;
+    }
+
+private:
+    const VFS::Manager* mVFS;
+    const Options& mOptions;
+
+    // Guards its caches itself, so that it can be shared by the threads
+    Resource::TextureManager mTextureManager;
+
+    std::vector<std::string> mNames;
+
+    boost::mutex mMutex;
+    size_t mNext;
+
+    std::vector<Result> mResults;
+};
+
+bool isSlower(const BulkTest::Result* left, const BulkTest::Result* right)
+{
+    return left->mParseTime + left->mConvertTime > right->mParseTime + right->mConvertTime;
+}
+
+/// Merge the given BSA files and directories into one virtual file system, like the game does, and test
+/// all nif files in it.
+/// @return Number of files that failed
+size_t readBulk(const Options& options)
+{
+    VFS::Manager vfs(false);
+
+    for (std::vector<std::string>::const_iterator it = options.mInputs.begin(); it != options.mInputs.end(); ++it)
+    {
+        if (isBSA(*it))
+            vfs.addArchive(new VFS::BsaArchive(*it, true));
+        else if (bfs::is_directory(bfs::path(*it)))
+            vfs.addArchive(new VFS::FileSystemArchive(*it));
+        else
+            std::cerr << "ERROR:  \"" << *it << "\" is not a bsa file or directory!" << std::endl;
+    }
+    vfs.buildIndex();
+
+    BulkTest test(&vfs, options);
+
+    osg::Timer_t start = osg::Timer::instance()->tick();
+    {
+        boost::thread_group threads;
+        for (unsigned int i=1; i<options.mThreads; ++i)
+            threads.create_thread(boost::bind(&BulkTest::run, &test));
+        test.run();
+        threads.join_all();
+    }
+    double total = osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+
+    const std::vector<BulkTest::Result>& results = test.getResults();
+
+    size_t failed = 0;
+    double parseTime = 0;
+    double convertTime = 0;
+    std::vector<const BulkTest::Result*> slowest;
+    for (std::vector<BulkTest::Result>::const_iterator it = results.begin(); it != results.end(); ++it)
+    {
+        if (it->mFailed)
+            ++failed;
+        parseTime += it->mParseTime;
+        convertTime += it->mConvertTime;
+        slowest.push_back(&*it);
+    }
+
+    size_t numSlowest = std::min<size_t>(options.mSlowest, slowest.size());
+    std::partial_sort(slowest.begin(), slowest.begin() + numSlowest, slowest.end(), isSlower);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << results.size() << " nif files, " << failed << " failed, in " << total << " s on "
+        << options.mThreads << " threads" << std::endl;
+    std::cout << "Total parse time " << parseTime << " s";
+    if (options.mConvert)
+        std::cout << ", total convert time " << convertTime << " s";
+    std::cout << std::endl;
+
+    if (numSlowest > 0)
+    {
+        std::cout << "Slowest files:" << std::endl;
+        for (size_t i=0; i<numSlowest; ++i)
+        {
+            std::cout << "  " << slowest[i]->mName << ": parse " << slowest[i]->mParseTime * 1000 << " ms";
+            if (options.mConvert)
+                std::cout << ", convert " << slowest[i]->mConvertTime * 1000 << " ms";
+            std::cout << std::endl;
+        }
+    }
+
+    return failed;
+}
+
+Options parseOptions (int argc, char** argv)
 {
     bpo::options_description desc("Ensure that OpenMW can use the provided NIF and BSA files\n\n"
         "Usages:\n"
         "  niftool <nif files, BSA files, or directories>\n"
         "      Scan the file or directories for nif errors.\n\n"
+        "  niftool --bulk [-c] [-t threads] <BSA files and data directories>\n"
+        "      Merge the inputs like the game does, test all nif files in them\n"
+        "      on several threads, and report the slowest files.\n\n"
         "Allowed options");
     desc.add_options()
         ("help,h", "print help message.")
         ("input-file", bpo::value< std::vector<std::string> >(), "input file")
+        ("bulk,b", "test all nif files of the inputs at once, and time them.")
+        ("convert,c", "in bulk mode, also convert the files to scene graphs and collision shapes.")
+        ("threads,t", bpo::value<unsigned int>()->default_value(0),
+            "number of threads in bulk mode (0 for one per processor core).")
+        ("times", "in bulk mode, print the times of every file.")
+        ("slowest", bpo::value<unsigned int>()->default_value(10),
+            "number of the slowest files to report in bulk mode.")
         ;
 
     //Default option if none provided
@@ -118,7 +322,16 @@ std::vector<std::string> parseOptions (int argc, char** argv)
     }
     if (variables.count("input-file"))
     {
-        return variables["input-file"].as< std::vector<std::string> >();
+        Options options;
+        options.mInputs = variables["input-file"].as< std::vector<std::string> >();
+        options.mBulk = variables.count("bulk") != 0;
+        options.mConvert = variables.count("convert") != 0;
+        options.mTimes = variables.count("times") != 0;
+        options.mThreads = variables["threads"].as<unsigned int>();
+        if (options.mThreads == 0)
+            options.mThreads = std::max(1u, boost::thread::hardware_concurrency());
+        options.mSlowest = variables["slowest"].as<unsigned int>();
+        return options;
     }
 
     std::cout << "No input files or directories specified!" << std::endl;
@@ -128,7 +341,12 @@ std::vector<std::string> parseOptions (int argc, char** argv)
 
 int main(int argc, char **argv)
 {
-    std::vector<std::string> files = parseOptions (argc, argv);
+    Options options = parseOptions (argc, argv);
+
+    if (options.mBulk)
+        return readBulk(options) == 0 ? 0 : 1;
+
+    const std::vector<std::string>& files = options.mInputs;
 
 //     std::cout << "Reading Files" << std::endl;
     for(std::vector<std::string>::const_iterator it=files.begin(); it!=files.end(); ++it)
@@ -144,7 +362,7 @@ int main(int argc, char **argv)
              else if(isBSA(name))
              {
 //                 std::cout << "Reading BSA File: " << name << std::endl;
-                readVFS(new VFS::BsaArchive(name));
+                readVFS(new VFS::BsaArchive(name, true));
              }
              else if(bfs::is_directory(bfs::path(name)))
              {
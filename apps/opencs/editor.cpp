@@ -31,7 +31,7 @@ CS::Editor::Editor ()
 
     mVFS.reset(new VFS::Manager(mFsStrict));
 
-    VFS::registerArchives(mVFS.get(), Files::Collections(config.first, !mFsStrict), config.second, true);
+    VFS::registerArchives(mVFS.get(), Files::Collections(config.first, !mFsStrict), config.second, true, false);
 
     mDocumentManager.setVFS(mVFS.get());
 
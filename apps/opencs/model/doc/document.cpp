@@ -10,6 +10,8 @@
 #include <components/files/configurationmanager.hpp>
 #endif
 
+#include "../tools/reportmodel.hpp"
+
 void CSMDoc::Document::addGmsts()
 {
     static const char *gmstFloats[] =
@@ -2256,7 +2258,7 @@ CSMDoc::Document::Document (const VFS::Manager* vfs, const Files::ConfigurationM
   mSavingOperation (*this, mProjectPath, encoding),
   mSaving (&mSavingOperation),
   mResDir(resDir),
-  mRunner (mProjectPath), mDirty (false), mIdCompletionManager(mData)
+  mRunner (mProjectPath), mDirty (false), mReferencesToLoad (0), mIdCompletionManager(mData)
 {
     if (mContentFiles.empty())
         throw std::runtime_error ("Empty content file sequence");
@@ -2305,6 +2307,8 @@ CSMDoc::Document::Document (const VFS::Manager* vfs, const Files::ConfigurationM
         this, SLOT (reportMessage (const CSMDoc::Message&, int)));
 
     connect (&mRunner, SIGNAL (runStateChanged()), this, SLOT (runStateChanged()));
+
+    connect (&mReferenceLoader, SIGNAL (timeout()), this, SLOT (loadReferences()));
 }
 
 CSMDoc::Document::~Document()
@@ -2337,6 +2341,9 @@ int CSMDoc::Document::getState() const
     if (int operations = mTools.getRunningOperations())
         state |= State_Locked | State_Operation | operations;
 
+    if (mReferenceLoader.isActive())
+        state |= State_Locked | State_Loading;
+
     return state;
 }
 
@@ -2487,6 +2494,41 @@ void CSMDoc::Document::runStateChanged()
     emit stateChanged (getState(), this);
 }
 
+void CSMDoc::Document::loadReferences()
+{
+    const int batchingSize = 10; // cells, do not block the user interface for too long
+
+    Messages messages (Message::Severity_Error);
+
+    bool done = false;
+
+    try
+    {
+        for (int i=0; i<batchingSize && !done; ++i)
+            done = mData.continueLoadingReferences (messages);
+    }
+    catch (const std::exception& e)
+    {
+        messages.add (CSMWorld::UniversalId::Type_None,
+            std::string ("Failed to load references: ") + e.what(), "", Message::Severity_SeriousError);
+        done = true;
+    }
+
+    CSMWorld::UniversalId log (CSMWorld::UniversalId::Type_LoadErrorLog, 0);
+
+    for (Messages::Iterator iter (messages.begin()); iter!=messages.end(); ++iter)
+        getReport (log)->add (*iter);
+
+    if (done)
+    {
+        mReferenceLoader.stop();
+        emit stateChanged (getState(), this);
+    }
+    else
+        emit progress (mReferencesToLoad-mData.getPendingReferences(), mReferencesToLoad,
+            State_Loading, 1, this);
+}
+
 void CSMDoc::Document::progress (int current, int max, int type)
 {
     emit progress (current, max, type, 1, this);
@@ -2497,6 +2539,14 @@ CSMWorld::IdCompletionManager &CSMDoc::Document::getIdCompletionManager()
     return mIdCompletionManager;
 }
 
+void CSMDoc::Document::startLoadingReferences()
+{
+    mReferencesToLoad = mData.getPendingReferences();
+
+    if (mReferencesToLoad>0)
+        mReferenceLoader.start (0);
+}
+
 void CSMDoc::Document::flagAsDirty()
 {
     mDirty = true;
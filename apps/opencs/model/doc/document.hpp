@@ -69,6 +69,8 @@ namespace CSMDoc
             Blacklist mBlacklist;
             Runner mRunner;
             bool mDirty;
+            QTimer mReferenceLoader;
+            int mReferencesToLoad;
 
             CSMWorld::IdCompletionManager mIdCompletionManager;
 
@@ -155,6 +157,10 @@ namespace CSMDoc
 
             void flagAsDirty();
 
+            void startLoadingReferences();
+            ///< Load the references of the cells in slices, while the document is open already.
+            /// Editing and all operations are locked meanwhile.
+
         signals:
 
             void stateChanged (int state, CSMDoc::Document *document);
@@ -175,6 +181,8 @@ namespace CSMDoc
 
             void runStateChanged();
 
+            void loadReferences();
+
         public slots:
 
             void progress (int current, int max, int type);
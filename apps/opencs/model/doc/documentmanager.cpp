@@ -112,6 +112,8 @@ void CSMDoc::DocumentManager::setBlacklistedScripts (const std::vector<std::stri
 
 void CSMDoc::DocumentManager::documentLoaded (Document *document)
 {
+    document->startLoadingReferences();
+
     emit documentAdded (document);
     emit loadingStopped (document, true, "");
 }
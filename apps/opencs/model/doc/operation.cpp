@@ -1,15 +1,70 @@
 #include "operation.hpp"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include <QTimer>
+#include <QThreadPool>
+#include <QRunnable>
 
 #include "../world/universalid.hpp"
 
 #include "state.hpp"
 #include "stage.hpp"
 
+namespace
+{
+    /// Steps of thread-safe stages per thread of the pool in one batch
+    const int sStepsPerThread = 16;
+
+    struct Step
+    {
+        CSMDoc::Stage *mStage;
+        int mStep;
+        CSMDoc::Messages mMessages;
+        bool mFailed;
+        std::string mError;
+
+        Step (CSMDoc::Stage *stage, int step, CSMDoc::Message::Severity defaultSeverity)
+        : mStage (stage), mStep (step), mMessages (defaultSeverity), mFailed (false)
+        {}
+
+        void perform()
+        {
+            try
+            {
+                mStage->perform (mStep, mMessages);
+            }
+            catch (const std::exception& e)
+            {
+                mFailed = true;
+                mError = e.what();
+            }
+        }
+    };
+
+    class StepRunnable : public QRunnable
+    {
+            std::vector<Step>& mSteps;
+            std::size_t mBegin;
+            std::size_t mEnd;
+
+        public:
+
+            StepRunnable (std::vector<Step>& steps, std::size_t begin, std::size_t end)
+            : mSteps (steps), mBegin (begin), mEnd (end)
+            {}
+
+            virtual void run()
+            {
+                for (std::size_t i=mBegin; i<mEnd; ++i)
+                    if (mSteps[i].mStage->isThreadSafe())
+                        mSteps[i].perform();
+            }
+    };
+}
+
 void CSMDoc::Operation::prepareStages()
 {
     mCurrentStage = mStages.begin();
@@ -32,6 +87,7 @@ CSMDoc::Operation::Operation (int type, bool ordered, bool finalAlways)
   mDefaultSeverity (Message::Severity_Error)
 {
     mTimer = new QTimer (this);
+    mThreadPool = new QThreadPool (this);
 }
 
 CSMDoc::Operation::~Operation()
@@ -97,36 +153,76 @@ void CSMDoc::Operation::executeStage()
         mPrepared = true;
     }
 
-    Messages messages (mDefaultSeverity);
+    // At most one step of a stage that is not thread-safe, performed on this thread
+    std::vector<Step> steps;
+    int serialStep = -1;
+    int maxSteps = std::max (1, mThreadPool->maxThreadCount()) * sStepsPerThread;
 
-    while (mCurrentStage!=mStages.end())
+    while (mCurrentStage!=mStages.end() && static_cast<int> (steps.size())<maxSteps)
     {
         if (mCurrentStep>=mCurrentStage->second)
         {
             mCurrentStep = 0;
             ++mCurrentStage;
+
+            if (mOrdered && !steps.empty())
+                break;
         }
-        else
+        else if (mCurrentStage->first->isThreadSafe())
         {
-            try
-            {
-                mCurrentStage->first->perform (mCurrentStep++, messages);
-            }
-            catch (const std::exception& e)
-            {
-                emit reportMessage (Message (CSMWorld::UniversalId(), e.what(), "", Message::Severity_SeriousError), mType);
-                abort();
-            }
-
-            ++mCurrentStepTotal;
-            break;
+            steps.push_back (Step (mCurrentStage->first, mCurrentStep++, mDefaultSeverity));
+        }
+        else if (serialStep==-1)
+        {
+            serialStep = steps.size();
+            steps.push_back (Step (mCurrentStage->first, mCurrentStep++, mDefaultSeverity));
         }
+        else
+            break;
     }
 
+    // Split the steps into one contiguous chunk per thread, all but the serial one are performed there
+    std::size_t parallelSteps = steps.size() - (serialStep==-1 ? 0 : 1);
+
+    if (parallelSteps>1)
+    {
+        std::size_t chunks = std::min (steps.size(),
+            static_cast<std::size_t> (std::max (1, mThreadPool->maxThreadCount())));
+
+        for (std::size_t i=0; i<chunks; ++i)
+            mThreadPool->start (new StepRunnable (steps, steps.size()*i/chunks, steps.size()*(i+1)/chunks));
+
+        if (serialStep!=-1)
+            steps[serialStep].perform();
+
+        mThreadPool->waitForDone();
+    }
+    else
+    {
+        for (std::vector<Step>::iterator iter (steps.begin()); iter!=steps.end(); ++iter)
+            iter->perform();
+    }
+
+    mCurrentStepTotal += steps.size();
+
     emit progress (mCurrentStepTotal, mTotalSteps ? mTotalSteps : 1, mType);
 
-    for (Messages::Iterator iter (messages.begin()); iter!=messages.end(); ++iter)
-        emit reportMessage (*iter, mType);
+    bool failed = false;
+
+    for (std::vector<Step>::const_iterator step (steps.begin()); step!=steps.end(); ++step)
+    {
+        if (step->mFailed)
+        {
+            emit reportMessage (Message (CSMWorld::UniversalId(), step->mError, "", Message::Severity_SeriousError), mType);
+            failed = true;
+        }
+
+        for (Messages::Iterator iter (step->mMessages.begin()); iter!=step->mMessages.end(); ++iter)
+            emit reportMessage (*iter, mType);
+    }
+
+    if (failed)
+        abort();
 
     if (mCurrentStage==mStages.end())
         operationDone();
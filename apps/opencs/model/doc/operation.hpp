@@ -10,6 +10,8 @@
 
 #include "messages.hpp"
 
+class QThreadPool;
+
 namespace CSMWorld
 {
     class UniversalId;
@@ -34,6 +36,7 @@ namespace CSMDoc
             bool mError;
             bool mConnected;
             QTimer *mTimer;
+            QThreadPool *mThreadPool;
             bool mPrepared;
             Message::Severity mDefaultSeverity;
 
@@ -74,6 +77,9 @@ namespace CSMDoc
         private slots:
 
             void executeStage();
+            ///< Performs one step, or a batch of steps of stages that are thread-safe, \see
+            /// Stage::isThreadSafe. The steps of a batch can span several stages, unless the stages are
+            /// ordered. Their messages are reported in the order of the steps.
 
         protected slots:
 
@@ -7,6 +7,17 @@
 #include "savingstages.hpp"
 #include "document.hpp"
 
+template<class CollectionT>
+void CSMDoc::Saving::appendCollectionStages (const CollectionT& collection, CSMWorld::Scope scope)
+{
+    WriteCollectionStage<CollectionT> *stage =
+        new WriteCollectionStage<CollectionT> (collection, mState, scope);
+
+    appendStage (stage);
+
+    appendStage (new WriteBuffersStage (stage->getBuffers(), mState));
+}
+
 CSMDoc::Saving::Saving (Document& document, const boost::filesystem::path& projectPath,
     ToUTF8::FromType encoding)
 : Operation (State_Saving, true, true), mDocument (document), mState (*this, projectPath, encoding)
@@ -16,14 +27,11 @@ CSMDoc::Saving::Saving (Document& document, const boost::filesystem::path& proje
 
     appendStage (new WriteHeaderStage (mDocument, mState, true));
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Filter> > (
-        mDocument.getData().getFilters(), mState, CSMWorld::Scope_Project));
+    appendCollectionStages (mDocument.getData().getFilters(), CSMWorld::Scope_Project);
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::DebugProfile> > (
-        mDocument.getData().getDebugProfiles(), mState, CSMWorld::Scope_Project));
+    appendCollectionStages (mDocument.getData().getDebugProfiles(), CSMWorld::Scope_Project);
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Script> > (
-        mDocument.getData().getScripts(), mState, CSMWorld::Scope_Project));
+    appendCollectionStages (mDocument.getData().getScripts(), CSMWorld::Scope_Project);
 
     appendStage (new CloseSaveStage (mState));
 
@@ -32,55 +40,41 @@ CSMDoc::Saving::Saving (Document& document, const boost::filesystem::path& proje
 
     appendStage (new WriteHeaderStage (mDocument, mState, false));
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Global> >
-        (mDocument.getData().getGlobals(), mState));
+    appendCollectionStages (mDocument.getData().getGlobals());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::GameSetting> >
-        (mDocument.getData().getGmsts(), mState));
+    appendCollectionStages (mDocument.getData().getGmsts());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Skill> >
-        (mDocument.getData().getSkills(), mState));
+    appendCollectionStages (mDocument.getData().getSkills());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Class> >
-        (mDocument.getData().getClasses(), mState));
+    appendCollectionStages (mDocument.getData().getClasses());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Faction> >
-        (mDocument.getData().getFactions(), mState));
+    appendCollectionStages (mDocument.getData().getFactions());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Race> >
-        (mDocument.getData().getRaces(), mState));
+    appendCollectionStages (mDocument.getData().getRaces());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Sound> >
-        (mDocument.getData().getSounds(), mState));
+    appendCollectionStages (mDocument.getData().getSounds());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Script> >
-        (mDocument.getData().getScripts(), mState));
+    appendCollectionStages (mDocument.getData().getScripts());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Region> >
-        (mDocument.getData().getRegions(), mState));
+    appendCollectionStages (mDocument.getData().getRegions());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::BirthSign> >
-        (mDocument.getData().getBirthsigns(), mState));
+    appendCollectionStages (mDocument.getData().getBirthsigns());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Spell> >
-        (mDocument.getData().getSpells(), mState));
+    appendCollectionStages (mDocument.getData().getSpells());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::Enchantment> >
-        (mDocument.getData().getEnchantments(), mState));
+    appendCollectionStages (mDocument.getData().getEnchantments());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::BodyPart> >
-        (mDocument.getData().getBodyParts(), mState));
+    appendCollectionStages (mDocument.getData().getBodyParts());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::SoundGenerator> >
-        (mDocument.getData().getSoundGens(), mState));
+    appendCollectionStages (mDocument.getData().getSoundGens());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::MagicEffect> >
-        (mDocument.getData().getMagicEffects(), mState));
+    appendCollectionStages (mDocument.getData().getMagicEffects());
 
-    appendStage (new WriteCollectionStage<CSMWorld::IdCollection<ESM::StartScript> >
-        (mDocument.getData().getStartScripts(), mState));
+    appendCollectionStages (mDocument.getData().getStartScripts());
 
-    appendStage (new WriteRefIdCollectionStage (mDocument, mState));
+    WriteRefIdCollectionStage *refIdStage = new WriteRefIdCollectionStage (mDocument, mState);
+    appendStage (refIdStage);
+    appendStage (new WriteBuffersStage (refIdStage->getBuffers(), mState));
 
     appendStage (new CollectionReferencesStage (mDocument, mState));
 
@@ -5,6 +5,8 @@
 
 #include <components/to_utf8/to_utf8.hpp>
 
+#include "../world/scope.hpp"
+
 #include "operation.hpp"
 #include "savingstate.hpp"
 
@@ -19,6 +21,12 @@ namespace CSMDoc
             Document& mDocument;
             SavingState mState;
 
+            template<class CollectionT>
+            void appendCollectionStages (const CollectionT& collection,
+                CSMWorld::Scope scope = CSMWorld::Scope_Content);
+            ///< Append a stage that serialises the records of \a collection and one that writes
+            /// them to the file.
+
         public:
 
             Saving (Document& document, const boost::filesystem::path& projectPath,
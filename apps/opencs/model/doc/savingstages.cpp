@@ -176,18 +176,82 @@ void CSMDoc::WriteDialogueCollectionStage::perform (int stage, Messages& message
 }
 
 
+CSMDoc::BufferWriter::BufferWriter (std::string& buffer, ToUTF8::FromType encoding)
+: mBuffer (buffer), mEncoder (encoding)
+{
+    mWriter.setEncoder (&mEncoder);
+    mWriter.setVersion();
+    mWriter.saveRaw (mStream);
+}
+
+CSMDoc::BufferWriter::~BufferWriter()
+{
+    mBuffer = mStream.str();
+}
+
+ESM::ESMWriter& CSMDoc::BufferWriter::getWriter()
+{
+    return mWriter;
+}
+
+
+CSMDoc::WriteBuffersStage::WriteBuffersStage (std::vector<std::string>& buffers,
+    SavingState& state)
+: mBuffers (buffers), mState (state)
+{}
+
+int CSMDoc::WriteBuffersStage::setup()
+{
+    return 1;
+}
+
+void CSMDoc::WriteBuffersStage::perform (int stage, Messages& messages)
+{
+    for (std::vector<std::string>::iterator iter (mBuffers.begin()); iter!=mBuffers.end(); ++iter)
+    {
+        if (!iter->empty())
+            mState.getWriter().write (iter->data(), iter->size());
+
+        std::string().swap (*iter);
+    }
+}
+
+
 CSMDoc::WriteRefIdCollectionStage::WriteRefIdCollectionStage (Document& document, SavingState& state)
 : mDocument (document), mState (state)
 {}
 
 int CSMDoc::WriteRefIdCollectionStage::setup()
 {
-    return mDocument.getData().getReferenceables().getSize();
+    int size = mDocument.getData().getReferenceables().getSize();
+
+    int steps = size/100;
+    if (size%100) ++steps;
+
+    mBuffers.clear();
+    mBuffers.resize (steps);
+
+    return steps;
 }
 
 void CSMDoc::WriteRefIdCollectionStage::perform (int stage, Messages& messages)
 {
-    mDocument.getData().getReferenceables().save (stage, mState.getWriter());
+    BufferWriter buffer (mBuffers[stage], mState.getEncoding());
+
+    int size = mDocument.getData().getReferenceables().getSize();
+
+    for (int i=stage*100; i<stage*100+100 && i<size; ++i)
+        mDocument.getData().getReferenceables().save (i, buffer.getWriter());
+}
+
+bool CSMDoc::WriteRefIdCollectionStage::isThreadSafe() const
+{
+    return true;
+}
+
+std::vector<std::string>& CSMDoc::WriteRefIdCollectionStage::getBuffers()
+{
+    return mBuffers;
 }
 
 
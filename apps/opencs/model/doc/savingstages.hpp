@@ -1,6 +1,10 @@
 #ifndef CSM_DOC_SAVINGSTAGES_H
 #define CSM_DOC_SAVINGSTAGES_H
 
+#include <sstream>
+#include <string>
+#include <vector>
+
 #include "stage.hpp"
 
 #include "../world/record.hpp"
@@ -8,6 +12,9 @@
 #include "../world/scope.hpp"
 
 #include <components/esm/defs.hpp>
+#include <components/esm/esmwriter.hpp>
+
+#include <components/to_utf8/to_utf8.hpp>
 
 #include "savingstate.hpp"
 
@@ -63,12 +70,40 @@ namespace CSMDoc
     };
 
 
+    /// \brief Writes records into a buffer, on any thread
+    ///
+    /// The buffer gets the records, when the writer is destroyed.
+    class BufferWriter
+    {
+            std::string& mBuffer;
+            std::ostringstream mStream;
+            ToUTF8::Utf8Encoder mEncoder;
+            ESM::ESMWriter mWriter;
+
+            // not implemented
+            BufferWriter (const BufferWriter&);
+            BufferWriter& operator= (const BufferWriter&);
+
+        public:
+
+            BufferWriter (std::string& buffer, ToUTF8::FromType encoding);
+
+            ~BufferWriter();
+
+            ESM::ESMWriter& getWriter();
+    };
+
+    /// \brief Writes the records of a collection
+    ///
+    /// The steps serialise chunks of records into buffers of their own, from several threads.
+    /// The buffers are written to the file by a following WriteBuffersStage.
     template<class CollectionT>
     class WriteCollectionStage : public Stage
     {
             const CollectionT& mCollection;
             SavingState& mState;
             CSMWorld::Scope mScope;
+            std::vector<std::string> mBuffers;
 
         public:
 
@@ -80,6 +115,10 @@ namespace CSMDoc
 
             virtual void perform (int stage, Messages& messages);
             ///< Messages resulting from this stage will be appended to \a messages.
+
+            virtual bool isThreadSafe() const;
+
+            std::vector<std::string>& getBuffers();
     };
 
     template<class CollectionT>
@@ -91,29 +130,76 @@ namespace CSMDoc
     template<class CollectionT>
     int WriteCollectionStage<CollectionT>::setup()
     {
-        return mCollection.getSize();
+        int size = mCollection.getSize();
+
+        int steps = size/100;
+        if (size%100) ++steps;
+
+        mBuffers.clear();
+        mBuffers.resize (steps);
+
+        return steps;
     }
 
     template<class CollectionT>
     void WriteCollectionStage<CollectionT>::perform (int stage, Messages& messages)
     {
-        if (CSMWorld::getScopeFromId (mCollection.getRecord (stage).get().mId)!=mScope)
-            return;
+        BufferWriter buffer (mBuffers[stage], mState.getEncoding());
+        ESM::ESMWriter& writer = buffer.getWriter();
 
-        ESM::ESMWriter& writer = mState.getWriter();
-        CSMWorld::RecordBase::State state = mCollection.getRecord (stage).mState;
-        typename CollectionT::ESXRecord record = mCollection.getRecord (stage).get();
+        int size = mCollection.getSize();
 
-        if (state == CSMWorld::RecordBase::State_Modified ||
-            state == CSMWorld::RecordBase::State_ModifiedOnly ||
-            state == CSMWorld::RecordBase::State_Deleted)
+        for (int i=stage*100; i<stage*100+100 && i<size; ++i)
         {
-            writer.startRecord (record.sRecordId);
-            record.save (writer, state == CSMWorld::RecordBase::State_Deleted);
-            writer.endRecord (record.sRecordId);
+            const CSMWorld::Record<typename CollectionT::ESXRecord>& record = mCollection.getRecord (i);
+
+            // records that are only in the base are not written, so do not copy them either
+            if (record.mState != CSMWorld::RecordBase::State_Modified &&
+                record.mState != CSMWorld::RecordBase::State_ModifiedOnly &&
+                record.mState != CSMWorld::RecordBase::State_Deleted)
+                continue;
+
+            if (CSMWorld::getScopeFromId (record.get().mId)!=mScope)
+                continue;
+
+            typename CollectionT::ESXRecord data = record.get();
+
+            writer.startRecord (data.sRecordId);
+            data.save (writer, record.mState == CSMWorld::RecordBase::State_Deleted);
+            writer.endRecord (data.sRecordId);
         }
     }
 
+    template<class CollectionT>
+    bool WriteCollectionStage<CollectionT>::isThreadSafe() const
+    {
+        return true;
+    }
+
+    template<class CollectionT>
+    std::vector<std::string>& WriteCollectionStage<CollectionT>::getBuffers()
+    {
+        return mBuffers;
+    }
+
+
+    /// \brief Writes the buffers of a stage to the file, in order
+    class WriteBuffersStage : public Stage
+    {
+            std::vector<std::string>& mBuffers;
+            SavingState& mState;
+
+        public:
+
+            WriteBuffersStage (std::vector<std::string>& buffers, SavingState& state);
+
+            virtual int setup();
+            ///< \return number of steps
+
+            virtual void perform (int stage, Messages& messages);
+            ///< Messages resulting from this stage will be appended to \a messages.
+    };
+
 
     class WriteDialogueCollectionStage : public Stage
     {
@@ -133,10 +219,12 @@ namespace CSMDoc
     };
 
 
+    /// \brief Writes the referenceables into buffers, \see WriteCollectionStage
     class WriteRefIdCollectionStage : public Stage
     {
             Document& mDocument;
             SavingState& mState;
+            std::vector<std::string> mBuffers;
 
         public:
 
@@ -147,6 +235,10 @@ namespace CSMDoc
 
             virtual void perform (int stage, Messages& messages);
             ///< Messages resulting from this stage will be appended to \a messages.
+
+            virtual bool isThreadSafe() const;
+
+            std::vector<std::string>& getBuffers();
     };
 
 
@@ -5,7 +5,7 @@
 
 CSMDoc::SavingState::SavingState (Operation& operation, const boost::filesystem::path& projectPath,
     ToUTF8::FromType encoding)
-: mOperation (operation), mEncoder (encoding),  mProjectPath (projectPath), mProjectFile (false)
+: mOperation (operation), mEncoding (encoding), mEncoder (encoding),  mProjectPath (projectPath), mProjectFile (false)
 {
     mWriter.setEncoder (&mEncoder);
 }
@@ -58,6 +58,11 @@ ESM::ESMWriter& CSMDoc::SavingState::getWriter()
     return mWriter;
 }
 
+ToUTF8::FromType CSMDoc::SavingState::getEncoding() const
+{
+    return mEncoding;
+}
+
 bool CSMDoc::SavingState::isProjectFile() const
 {
     return mProjectFile;
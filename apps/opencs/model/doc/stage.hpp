@@ -23,6 +23,13 @@ namespace CSMDoc
 
             virtual void perform (int stage, Messages& messages) = 0;
             ///< Messages resulting from this stage will be appended to \a messages.
+
+            virtual bool isThreadSafe() const;
+            ///< Can different steps be performed at the same time, from threads other than the
+            /// thread of the operation? They are performed in no particular order then, so a step
+            /// must not depend on the state that other steps leave behind.
+            ///
+            /// Default implementation: return false
     };
 }
 
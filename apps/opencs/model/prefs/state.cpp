@@ -128,6 +128,9 @@ void CSMPrefs::State::declare()
     declareInt ("char-after", "Characters after search string", 10).
         setTooltip ("Maximum number of character to display in search result after the searched text");
     declareBool ("auto-delete", "Delete row from result table after a successful replace", true);
+    declareBool ("index", "Index text for searching", true).
+        setTooltip ("Look up the records that might match a text or ID search in an index, instead "
+        "of searching all records. The index needs memory, and is built by the first search.");
 
     declareCategory ("Scripts");
     declareBool ("show-linenum", "Show Line Numbers", true).
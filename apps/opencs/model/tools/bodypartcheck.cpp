@@ -49,3 +49,8 @@ void CSMTools::BodyPartCheckStage::perform (int stage, CSMDoc::Messages &message
     else if ( mRaces.searchId( bodyPart.mRace ) == -1 )
         messages.push_back(std::make_pair( id, bodyPart.mId + " has invalid race." ));
 }
+
+bool CSMTools::BodyPartCheckStage::isThreadSafe() const
+{
+    return true;
+}
@@ -29,6 +29,8 @@ namespace CSMTools
 
         virtual void perform( int stage, CSMDoc::Messages &messages );
         ///< Messages resulting from this tage will be appended to \a messages.
+
+        virtual bool isThreadSafe() const;
     };
 }
 
@@ -34,6 +34,7 @@ namespace CSMTools
         virtual int setup();
 
         virtual void perform (int stage, CSMDoc::Messages& messages);
+        virtual bool isThreadSafe() const;
     };
 }
 
@@ -19,6 +19,7 @@ namespace CSMTools
                 const CSMWorld::IdCollection<ESM::Script>& scripts);
 
             virtual void perform(int stage, CSMDoc::Messages& messages);
+            virtual bool isThreadSafe() const;
             virtual int setup();
 
         private:
@@ -81,7 +82,6 @@ namespace CSMTools
             const CSMWorld::IdCollection<ESM::Class>& mClasses;
             const CSMWorld::IdCollection<ESM::Faction>& mFactions;
             const CSMWorld::IdCollection<ESM::Script>& mScripts;
-            bool mPlayerPresent;
     };
 }
 #endif // REFERENCEABLECHECKSTAGE_H
@@ -104,3 +104,8 @@ int CSMTools::ReferenceCheckStage::setup()
 {
     return mReferences.getSize();
 }
+
+bool CSMTools::ReferenceCheckStage::isThreadSafe() const
+{
+    return true;
+}
@@ -15,6 +15,7 @@ namespace CSMTools
                 const CSMWorld::IdCollection<ESM::Faction>& factions);
 
             virtual void perform(int stage, CSMDoc::Messages& messages);
+            virtual bool isThreadSafe() const;
             virtual int setup();
 
         private:
@@ -35,3 +35,8 @@ void CSMTools::RegionCheckStage::perform (int stage, CSMDoc::Messages& messages)
 
     /// \todo check data members that can't be edited in the table view
 }
+
+bool CSMTools::RegionCheckStage::isThreadSafe() const
+{
+    return true;
+}
@@ -248,6 +248,21 @@ void CSMTools::Search::setPadding (int before, int after)
     mPaddingAfter = after;
 }
 
+CSMTools::Search::Type CSMTools::Search::getType() const
+{
+    return mType;
+}
+
+const std::string& CSMTools::Search::getText() const
+{
+    return mText;
+}
+
+const std::set<int>& CSMTools::Search::getColumns() const
+{
+    return mColumns;
+}
+
 void CSMTools::Search::replace (CSMDoc::Document& document, CSMWorld::IdTableBase *model,
     const CSMWorld::UniversalId& id, const std::string& messageHint,
     const std::string& replaceText) const
@@ -84,6 +84,16 @@ namespace CSMTools
 
             void setPadding (int before, int after);
 
+            Type getType() const;
+
+            // The text of a text or ID search.
+            const std::string& getText() const;
+
+            // Columns that are searched.
+            //
+            // \attention *this needs to be configured for the model.
+            const std::set<int>& getColumns() const;
+
             // Configuring *this for the model is not necessary when calling this function.
             void replace (CSMDoc::Document& document, CSMWorld::IdTableBase *model,
                 const CSMWorld::UniversalId& id, const std::string& messageHint,
@@ -0,0 +1,230 @@
+#include "searchindex.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include <QMutexLocker>
+
+#include "../world/idtablebase.hpp"
+
+#include "search.hpp"
+
+namespace
+{
+    /// Hashes of the three character sequences of \a text, case folded like a case insensitive search.
+    /// Different sequences can share a hash, so the rows found still need to be searched.
+    void getTrigrams (const QString& text, std::vector<unsigned int>& trigrams)
+    {
+        QString folded = text.toCaseFolded();
+
+        for (int i=0; i+2<folded.size(); ++i)
+        {
+            unsigned int hash = folded[i].unicode();
+            hash = hash * 65599u + folded[i+1].unicode();
+            hash = hash * 65599u + folded[i+2].unicode();
+            trigrams.push_back (hash);
+        }
+    }
+
+    void sortUnique (std::vector<unsigned int>& trigrams)
+    {
+        std::sort (trigrams.begin(), trigrams.end());
+        trigrams.erase (std::unique (trigrams.begin(), trigrams.end()), trigrams.end());
+    }
+
+    bool isSmaller (const std::vector<int> *left, const std::vector<int> *right)
+    {
+        return left->size()<right->size();
+    }
+}
+
+CSMTools::SearchIndex::Index::Index() : mBuilt (false) {}
+
+void CSMTools::SearchIndex::Index::clear()
+{
+    mBuilt = false;
+    std::vector<std::vector<unsigned int> >().swap (mRowTrigrams);
+    mTrigramRows.clear();
+    mModifiedRows.clear();
+}
+
+void CSMTools::SearchIndex::getRowTrigrams (const Search& search, int row,
+    std::vector<unsigned int>& trigrams) const
+{
+    trigrams.clear();
+
+    const std::set<int>& columns = search.getColumns();
+
+    for (std::set<int>::const_iterator iter (columns.begin()); iter!=columns.end(); ++iter)
+        getTrigrams (mModel->data (mModel->index (row, *iter)).toString(), trigrams);
+
+    sortUnique (trigrams);
+}
+
+void CSMTools::SearchIndex::build (Index& index, const Search& search)
+{
+    index.clear();
+
+    int rows = mModel->rowCount();
+    index.mRowTrigrams.resize (rows);
+
+    for (int row=0; row<rows; ++row)
+    {
+        std::vector<unsigned int>& trigrams = index.mRowTrigrams[row];
+        getRowTrigrams (search, row, trigrams);
+
+        for (std::vector<unsigned int>::const_iterator iter (trigrams.begin());
+            iter!=trigrams.end(); ++iter)
+            index.mTrigramRows[*iter].push_back (row);
+    }
+
+    index.mBuilt = true;
+}
+
+void CSMTools::SearchIndex::update (Index& index, const Search& search, int row)
+{
+    if (row<0 || row>=static_cast<int> (index.mRowTrigrams.size()))
+        return;
+
+    std::vector<unsigned int>& trigrams = index.mRowTrigrams[row];
+
+    for (std::vector<unsigned int>::const_iterator iter (trigrams.begin()); iter!=trigrams.end(); ++iter)
+    {
+        std::map<unsigned int, std::vector<int> >::iterator rows = index.mTrigramRows.find (*iter);
+
+        if (rows!=index.mTrigramRows.end())
+        {
+            std::vector<int>::iterator found =
+                std::lower_bound (rows->second.begin(), rows->second.end(), row);
+
+            if (found!=rows->second.end() && *found==row)
+                rows->second.erase (found);
+
+            if (rows->second.empty())
+                index.mTrigramRows.erase (rows);
+        }
+    }
+
+    getRowTrigrams (search, row, trigrams);
+
+    for (std::vector<unsigned int>::const_iterator iter (trigrams.begin()); iter!=trigrams.end(); ++iter)
+    {
+        std::vector<int>& rows = index.mTrigramRows[*iter];
+        rows.insert (std::lower_bound (rows.begin(), rows.end(), row), row);
+    }
+}
+
+void CSMTools::SearchIndex::markModified (int first, int last)
+{
+    QMutexLocker lock (&mMutex);
+
+    Index *indices[] = { &mText, &mId };
+
+    for (int i=0; i<2; ++i)
+        if (indices[i]->mBuilt)
+            for (int row=first; row<=last; ++row)
+                indices[i]->mModifiedRows.insert (row);
+}
+
+CSMTools::SearchIndex::SearchIndex (const CSMWorld::IdTableBase *model)
+: mModel (model)
+{
+    // Connected directly, so that the rows are marked before the next search, in whichever thread
+    connect (model, SIGNAL (dataChanged (const QModelIndex&, const QModelIndex&)),
+        this, SLOT (dataChanged (const QModelIndex&, const QModelIndex&)), Qt::DirectConnection);
+    connect (model, SIGNAL (rowsInserted (const QModelIndex&, int, int)),
+        this, SLOT (rowsChanged (const QModelIndex&, int, int)), Qt::DirectConnection);
+    connect (model, SIGNAL (rowsRemoved (const QModelIndex&, int, int)),
+        this, SLOT (rowsChanged (const QModelIndex&, int, int)), Qt::DirectConnection);
+    connect (model, SIGNAL (rowsMoved (const QModelIndex&, int, int, const QModelIndex&, int)),
+        this, SLOT (structureChanged()), Qt::DirectConnection);
+    connect (model, SIGNAL (layoutChanged()), this, SLOT (structureChanged()), Qt::DirectConnection);
+    connect (model, SIGNAL (modelReset()), this, SLOT (structureChanged()), Qt::DirectConnection);
+}
+
+bool CSMTools::SearchIndex::isIndexed (const Search& search)
+{
+    if (search.getType()!=Search::Type_Text && search.getType()!=Search::Type_Id)
+        return false;
+
+    std::vector<unsigned int> trigrams;
+    getTrigrams (QString::fromUtf8 (search.getText().c_str()), trigrams);
+    return !trigrams.empty();
+}
+
+void CSMTools::SearchIndex::findRows (const Search& search, std::vector<int>& rows)
+{
+    QMutexLocker lock (&mMutex);
+
+    Index& index = search.getType()==Search::Type_Text ? mText : mId;
+
+    if (!index.mBuilt)
+        build (index, search);
+    else
+    {
+        for (std::set<int>::const_iterator iter (index.mModifiedRows.begin());
+            iter!=index.mModifiedRows.end(); ++iter)
+            update (index, search, *iter);
+    }
+
+    index.mModifiedRows.clear();
+
+    std::vector<unsigned int> trigrams;
+    getTrigrams (QString::fromUtf8 (search.getText().c_str()), trigrams);
+    sortUnique (trigrams);
+
+    std::vector<const std::vector<int> *> lists;
+
+    for (std::vector<unsigned int>::const_iterator iter (trigrams.begin()); iter!=trigrams.end(); ++iter)
+    {
+        std::map<unsigned int, std::vector<int> >::const_iterator found = index.mTrigramRows.find (*iter);
+
+        if (found==index.mTrigramRows.end())
+            return;
+
+        lists.push_back (&found->second);
+    }
+
+    if (lists.empty())
+        return;
+
+    // Intersect the rows, starting with the fewest
+    std::sort (lists.begin(), lists.end(), isSmaller);
+
+    std::vector<int> result (*lists.front());
+
+    for (std::size_t i=1; i<lists.size() && !result.empty(); ++i)
+    {
+        std::vector<int> intersection;
+        std::set_intersection (result.begin(), result.end(), lists[i]->begin(), lists[i]->end(),
+            std::back_inserter (intersection));
+        result.swap (intersection);
+    }
+
+    rows.insert (rows.end(), result.begin(), result.end());
+}
+
+void CSMTools::SearchIndex::dataChanged (const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    // A change of a nested table modifies the record it belongs to
+    if (topLeft.parent().isValid())
+        markModified (topLeft.parent().row(), topLeft.parent().row());
+    else
+        markModified (topLeft.row(), bottomRight.row());
+}
+
+void CSMTools::SearchIndex::rowsChanged (const QModelIndex& parent, int start, int end)
+{
+    if (parent.isValid())
+        markModified (parent.row(), parent.row());
+    else
+        structureChanged();
+}
+
+void CSMTools::SearchIndex::structureChanged()
+{
+    QMutexLocker lock (&mMutex);
+
+    mText.clear();
+    mId.clear();
+}
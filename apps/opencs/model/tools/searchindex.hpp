@@ -0,0 +1,82 @@
+#ifndef CSM_TOOLS_SEARCHINDEX_H
+#define CSM_TOOLS_SEARCHINDEX_H
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <QObject>
+#include <QMutex>
+#include <QString>
+
+class QModelIndex;
+
+namespace CSMWorld
+{
+    class IdTableBase;
+}
+
+namespace CSMTools
+{
+    class Search;
+
+    /// \brief Index of the three character sequences in the searched columns of a table
+    ///
+    /// Finds the rows that may match a text or ID search, without looking at the other rows. The
+    /// index is built on first use. Modified rows are indexed again on the next use, while inserting,
+    /// removing or reordering rows makes the index be built again.
+    ///
+    /// The index is updated from the thread of the searches, the model only marks rows as modified.
+    class SearchIndex : public QObject
+    {
+            Q_OBJECT
+
+            struct Index
+            {
+                bool mBuilt;
+                std::vector<std::vector<unsigned int> > mRowTrigrams; // sorted
+                std::map<unsigned int, std::vector<int> > mTrigramRows; // sorted
+                std::set<int> mModifiedRows;
+
+                Index();
+
+                void clear();
+            };
+
+            const CSMWorld::IdTableBase *mModel;
+            QMutex mMutex;
+            Index mText;
+            Index mId;
+
+            void getRowTrigrams (const Search& search, int row, std::vector<unsigned int>& trigrams) const;
+
+            void build (Index& index, const Search& search);
+
+            void update (Index& index, const Search& search, int row);
+
+            void markModified (int first, int last);
+
+        public:
+
+            SearchIndex (const CSMWorld::IdTableBase *model);
+
+            /// Can the rows for \a search be looked up in an index?
+            static bool isIndexed (const Search& search);
+
+            /// Add the rows that might match \a search to \a rows, in ascending order. The rows
+            /// that do not have all three character sequences of the search text are left out.
+            ///
+            /// \attention \a search needs to be configured for the model and indexed.
+            void findRows (const Search& search, std::vector<int>& rows);
+
+        private slots:
+
+            void dataChanged (const QModelIndex& topLeft, const QModelIndex& bottomRight);
+
+            void rowsChanged (const QModelIndex& parent, int start, int end);
+
+            void structureChanged();
+    };
+}
+
+#endif
@@ -2,10 +2,12 @@
 
 #include "../world/idtablebase.hpp"
 
+#include "../prefs/state.hpp"
+
 #include "searchoperation.hpp"
 
 CSMTools::SearchStage::SearchStage (const CSMWorld::IdTableBase *model)
-: mModel (model), mOperation (0)
+: mModel (model), mOperation (0), mIndex (model), mUseIndex (false)
 {}
 
 int CSMTools::SearchStage::setup()
@@ -14,13 +16,23 @@ int CSMTools::SearchStage::setup()
         mSearch = mOperation->getSearch();
 
     mSearch.configure (mModel);
-        
+
+    mRows.clear();
+    mUseIndex = CSMPrefs::get()["Search & Replace"]["index"].isTrue() &&
+        SearchIndex::isIndexed (mSearch);
+
+    if (mUseIndex)
+    {
+        mIndex.findRows (mSearch, mRows);
+        return mRows.size();
+    }
+
     return mModel->rowCount();
 }
 
 void CSMTools::SearchStage::perform (int stage, CSMDoc::Messages& messages)
 {
-    mSearch.searchRow (mModel, stage, messages);
+    mSearch.searchRow (mModel, mUseIndex ? mRows[stage] : stage, messages);
 }
 
 void CSMTools::SearchStage::setOperation (const SearchOperation *operation)
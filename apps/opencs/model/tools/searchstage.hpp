@@ -4,6 +4,7 @@
 #include "../doc/stage.hpp"
 
 #include "search.hpp"
+#include "searchindex.hpp"
 
 namespace CSMWorld
 {
@@ -19,6 +20,9 @@ namespace CSMTools
             const CSMWorld::IdTableBase *mModel;
             Search mSearch;
             const SearchOperation *mOperation;
+            SearchIndex mIndex;
+            bool mUseIndex;
+            std::vector<int> mRows; // rows to search if mUseIndex
 
         public:
 
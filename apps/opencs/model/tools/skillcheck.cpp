@@ -39,3 +39,8 @@ void CSMTools::SkillCheckStage::perform (int stage, CSMDoc::Messages& messages)
     if (skill.mDescription.empty())
         messages.push_back (std::make_pair (id, skill.mId + " has an empty description"));
 }
+
+bool CSMTools::SkillCheckStage::isThreadSafe() const
+{
+    return true;
+}
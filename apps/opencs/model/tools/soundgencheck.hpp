@@ -24,6 +24,8 @@ namespace CSMTools
 
             virtual void perform(int stage, CSMDoc::Messages &messages);
             ///< Messages resulting from this stage will be appended to \a messages.
+
+            virtual bool isThreadSafe() const;
     };
 }
 
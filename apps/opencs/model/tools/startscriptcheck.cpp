@@ -28,3 +28,8 @@ int CSMTools::StartScriptCheckStage::setup()
 {
     return mStartScripts.getSize();
 }
+
+bool CSMTools::StartScriptCheckStage::isThreadSafe() const
+{
+    return true;
+}
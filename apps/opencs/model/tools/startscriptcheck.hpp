@@ -21,6 +21,7 @@ namespace CSMTools
                 const CSMWorld::IdCollection<ESM::Script>& scripts);
 
             virtual void perform(int stage, CSMDoc::Messages& messages);
+            virtual bool isThreadSafe() const;
             virtual int setup();
     };
 }
@@ -8,6 +8,14 @@
 #include <stdexcept>
 #include <functional>
 
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include <boost/tr1/tr1/unordered_map>
+#elif defined HAVE_UNORDERED_MAP
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif
+
 #include <QVariant>
 
 #include <components/misc/stringops.hpp>
@@ -39,6 +47,28 @@ namespace CSMWorld
         return record.mId;
     }
 
+    /// \brief Case-insensitive hash of IDs, so that looking up an ID needs no lower-case copy of it
+    struct IdHash
+    {
+        std::size_t operator() (const std::string& id) const
+        {
+            std::size_t hash = 0;
+
+            for (std::string::const_iterator iter (id.begin()); iter!=id.end(); ++iter)
+                hash = hash * 31 + static_cast<unsigned char> (Misc::StringUtils::toLower (*iter));
+
+            return hash;
+        }
+    };
+
+    struct IdEqual
+    {
+        bool operator() (const std::string& left, const std::string& right) const
+        {
+            return Misc::StringUtils::ciEqual (left, right);
+        }
+    };
+
     /// \brief Single-type record collection
     template<typename ESXRecordT, typename IdAccessorT = IdAccessor<ESXRecordT> >
     class Collection : public CollectionBase
@@ -50,9 +80,13 @@ namespace CSMWorld
         private:
 
             std::vector<Record<ESXRecordT> > mRecords;
-            std::map<std::string, int> mIndex;
+            std::map<std::string, int> mIndex; // lower-case ID, index
+            std::tr1::unordered_map<std::string, std::map<std::string, int>::iterator, IdHash, IdEqual>
+                mHashIndex; // for looking up mIndex entries without comparing IDs
             std::vector<Column<ESXRecordT> *> mColumns;
 
+            void addToIndex (const std::string& id, int index);
+
             // not implemented
             Collection (const Collection&);
             Collection& operator= (const Collection&);
@@ -100,6 +134,10 @@ namespace CSMWorld
 
             virtual void removeRows (int index, int count) ;
 
+            void removeRecords (const std::vector<int>& indices);
+            ///< Remove the records at \a indices, which must be sorted and must not contain an index
+            /// twice. The index is adjusted in one pass, instead of once for every record.
+
             virtual void appendBlankRecord (const std::string& id,
                 UniversalId::Type type = UniversalId::Type_None);
             ///< \param type Will be ignored, unless the collection supports multiple record types
@@ -144,6 +182,12 @@ namespace CSMWorld
             /// If the index is invalid either generally (by being out of range) or for the particular
             /// record, an exception is thrown.
 
+            void insertRecords (const std::vector<Record<ESXRecordT> >& records, int index);
+            ///< Insert \a records before index. The index is adjusted in one pass, instead of
+            /// once for every record.
+            ///
+            /// If the index is out of range, an exception is thrown.
+
             virtual bool reorderRows (int baseIndex, const std::vector<int>& newOrder);
             ///< Reorder the rows [baseIndex, baseIndex+newOrder.size()) according to the indices
             /// given in \a newOrder (baseIndex+newOrder[0] specifies the new index of row baseIndex).
@@ -170,6 +214,16 @@ namespace CSMWorld
         return mRecords;
     }
 
+    template<typename ESXRecordT, typename IdAccessorT>
+    void Collection<ESXRecordT, IdAccessorT>::addToIndex (const std::string& id, int index)
+    {
+        std::pair<std::map<std::string, int>::iterator, bool> result =
+            mIndex.insert (std::make_pair (Misc::StringUtils::lowerCase (id), index));
+
+        if (result.second)
+            mHashIndex.insert (std::make_pair (result.first->first, result.first));
+    }
+
     template<typename ESXRecordT, typename IdAccessorT>
     bool Collection<ESXRecordT, IdAccessorT>::reorderRowsImp (int baseIndex,
         const std::vector<int>& newOrder)
@@ -234,9 +288,9 @@ namespace CSMWorld
     {
         std::string id = Misc::StringUtils::lowerCase (IdAccessorT().getId (record));
 
-        std::map<std::string, int>::iterator iter = mIndex.find (id);
+        int index = searchId (id);
 
-        if (iter==mIndex.end())
+        if (index==-1)
         {
             Record<ESXRecordT> record2;
             record2.mState = Record<ESXRecordT>::State_ModifiedOnly;
@@ -246,7 +300,7 @@ namespace CSMWorld
         }
         else
         {
-            mRecords[iter->second].setModified (record);
+            mRecords[index].setModified (record);
         }
     }
 
@@ -324,15 +378,13 @@ namespace CSMWorld
     template<typename ESXRecordT, typename IdAccessorT>
     void  Collection<ESXRecordT, IdAccessorT>::purge()
     {
-        int i = 0;
+        std::vector<int> erased;
 
-        while (i<static_cast<int> (mRecords.size()))
-        {
+        for (int i=0; i<static_cast<int> (mRecords.size()); ++i)
             if (mRecords[i].isErased())
-                removeRows (i, 1);
-            else
-                ++i;
-        }
+                erased.push_back (i);
+
+        removeRecords (erased);
     }
 
     template<typename ESXRecordT, typename IdAccessorT>
@@ -353,6 +405,7 @@ namespace CSMWorld
                 }
                 else
                 {
+                    mHashIndex.erase (iter->first);
                     mIndex.erase (iter++);
                 }
             }
@@ -361,6 +414,47 @@ namespace CSMWorld
         }
     }
 
+    template<typename ESXRecordT, typename IdAccessorT>
+    void Collection<ESXRecordT, IdAccessorT>::removeRecords (const std::vector<int>& indices)
+    {
+        if (indices.empty())
+            return;
+
+        // compact the records
+        std::size_t target = indices.front();
+        std::vector<int>::const_iterator next = indices.begin();
+
+        for (std::size_t i=indices.front(); i<mRecords.size(); ++i)
+        {
+            if (next!=indices.end() && static_cast<int> (i)==*next)
+                ++next;
+            else
+                mRecords[target++] = mRecords[i];
+        }
+
+        mRecords.erase (mRecords.begin()+target, mRecords.end());
+
+        // adjust index by the number of removed records before each one
+        typename std::map<std::string, int>::iterator iter = mIndex.begin();
+
+        while (iter!=mIndex.end())
+        {
+            std::vector<int>::const_iterator removed =
+                std::lower_bound (indices.begin(), indices.end(), iter->second);
+
+            if (removed!=indices.end() && *removed==iter->second)
+            {
+                mHashIndex.erase (iter->first);
+                mIndex.erase (iter++);
+            }
+            else
+            {
+                iter->second -= removed-indices.begin();
+                ++iter;
+            }
+        }
+    }
+
     template<typename ESXRecordT, typename IdAccessorT>
     void  Collection<ESXRecordT, IdAccessorT>::appendBlankRecord (const std::string& id,
         UniversalId::Type type)
@@ -379,14 +473,13 @@ namespace CSMWorld
     template<typename ESXRecordT, typename IdAccessorT>
     int Collection<ESXRecordT, IdAccessorT>::searchId (const std::string& id) const
     {
-        std::string id2 = Misc::StringUtils::lowerCase(id);
+        typename std::tr1::unordered_map<std::string, std::map<std::string, int>::iterator,
+            IdHash, IdEqual>::const_iterator iter = mHashIndex.find (id);
 
-        std::map<std::string, int>::const_iterator iter = mIndex.find (id2);
-
-        if (iter==mIndex.end())
+        if (iter==mHashIndex.end())
             return -1;
 
-        return iter->second;
+        return iter->second->second;
     }
 
     template<typename ESXRecordT, typename IdAccessorT>
@@ -458,8 +551,33 @@ namespace CSMWorld
                      ++(iter->second);
         }
 
-        mIndex.insert (std::make_pair (Misc::StringUtils::lowerCase (IdAccessorT().getId (
-            record2.get())), index));
+        addToIndex (IdAccessorT().getId (record2.get()), index);
+    }
+
+    template<typename ESXRecordT, typename IdAccessorT>
+    void Collection<ESXRecordT, IdAccessorT>::insertRecords (
+        const std::vector<Record<ESXRecordT> >& records, int index)
+    {
+        if (index<0 || index>static_cast<int> (mRecords.size()))
+            throw std::runtime_error ("index out of range");
+
+        if (records.empty())
+            return;
+
+        int count = static_cast<int> (records.size());
+
+        if (index<static_cast<int> (mRecords.size()))
+        {
+            for (std::map<std::string, int>::iterator iter (mIndex.begin()); iter!=mIndex.end();
+                ++iter)
+                 if (iter->second>=index)
+                     iter->second += count;
+        }
+
+        mRecords.insert (mRecords.begin()+index, records.begin(), records.end());
+
+        for (int i=0; i<count; ++i)
+            addToIndex (IdAccessorT().getId (records[i].get()), index+i);
     }
 
     template<typename ESXRecordT, typename IdAccessorT>
@@ -911,11 +911,11 @@ bool CSMWorld::Data::continueLoading (CSMDoc::Messages& messages)
 
     if (!mReader->hasMoreRecs())
     {
-        if (mBase)
+        if (mBase || (!mPendingReferences.empty() && mPendingReferences.back().mReader==mReader))
         {
             // Don't delete the Reader yet. Some record types store a reference to the Reader to handle on-demand loading.
             // We don't store non-base reader, because everything going into modified will be
-            // fully loaded during the initial loading process.
+            // fully loaded during the initial loading process, except for the references.
             boost::shared_ptr<ESM::ESMReader> ptr(mReader);
             mReaders.push_back(ptr);
         }
@@ -979,8 +979,21 @@ bool CSMWorld::Data::continueLoading (CSMDoc::Messages& messages)
                 messages.add (id, "Logic error: cell index out of bounds", "", CSMDoc::Message::Severity_Error);
                 index = mCells.getSize()-1;
             }
-            std::string cellId = Misc::StringUtils::lowerCase (mCells.getId (index));
-            mRefs.load (*mReader, index, mBase, mRefLoadCache[cellId], messages);
+
+            // The references make up most of the records. They are loaded once the document is
+            // open, so that the other records can be viewed meanwhile.
+            if (mReader->hasMoreSubs())
+            {
+                PendingReferences references;
+                references.mReader = mReader;
+                references.mContext = mReader->getContext();
+                references.mCellId = Misc::StringUtils::lowerCase (mCells.getId (index));
+                references.mBase = mBase;
+                mPendingReferences.push_back (references);
+
+                mReader->skipRecord();
+            }
+
             break;
         }
 
@@ -1109,6 +1122,34 @@ bool CSMWorld::Data::continueLoading (CSMDoc::Messages& messages)
     return false;
 }
 
+int CSMWorld::Data::getPendingReferences() const
+{
+    return static_cast<int> (mPendingReferences.size());
+}
+
+bool CSMWorld::Data::continueLoadingReferences (CSMDoc::Messages& messages)
+{
+    if (mPendingReferences.empty())
+        return true;
+
+    PendingReferences references = mPendingReferences.front();
+    mPendingReferences.pop_front();
+
+    // skip the references of a cell that has been removed by a later content file
+    int index = mCells.searchId (references.mCellId);
+
+    if (index!=-1)
+    {
+        IdTable& table = dynamic_cast<IdTable&> (*getTableModel (UniversalId::Type_References));
+
+        references.mReader->restoreContext (references.mContext);
+        mRefs.load (*references.mReader, index, references.mBase, mRefLoadCache[references.mCellId],
+            messages, &table);
+    }
+
+    return mPendingReferences.empty();
+}
+
 bool CSMWorld::Data::hasId (const std::string& id) const
 {
     return
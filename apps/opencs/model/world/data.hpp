@@ -1,6 +1,7 @@
 #ifndef CSM_WOLRD_DATA_H
 #define CSM_WOLRD_DATA_H
 
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -9,6 +10,7 @@
 #include <QObject>
 #include <QModelIndex>
 
+#include <components/esm/esmcommon.hpp>
 #include <components/esm/loadglob.hpp>
 #include <components/esm/loadgmst.hpp>
 #include <components/esm/loadskil.hpp>
@@ -117,6 +119,17 @@ namespace CSMWorld
 
             std::vector<boost::shared_ptr<ESM::ESMReader> > mReaders;
 
+            /// The references of a cell, which are loaded after the other records
+            struct PendingReferences
+            {
+                ESM::ESMReader *mReader;
+                ESM::ESM_Context mContext;
+                std::string mCellId;
+                bool mBase;
+            };
+
+            std::deque<PendingReferences> mPendingReferences;
+
             // not implemented
             Data (const Data&);
             Data& operator= (const Data&);
@@ -279,6 +292,18 @@ namespace CSMWorld
 
             bool continueLoading (CSMDoc::Messages& messages);
             ///< \return Finished?
+            ///
+            /// \note The references of the cells are not loaded, but left to
+            /// continueLoadingReferences.
+
+            int getPendingReferences() const;
+            ///< Return the number of cells, whose references are not loaded yet.
+
+            bool continueLoadingReferences (CSMDoc::Messages& messages);
+            ///< Load the references of the next cell, in the order of the content files, and
+            /// notify the views of the references table.
+            ///
+            /// \return Finished?
 
             bool hasId (const std::string& id) const;
 
@@ -188,6 +188,18 @@ void CSMWorld::IdTable::setRecord (const std::string& id, const RecordBase& reco
     }
 }
 
+void CSMWorld::IdTable::beginAppendRows (int count)
+{
+    int size = mIdCollection->getSize();
+
+    beginInsertRows (QModelIndex(), size, size+count-1);
+}
+
+void CSMWorld::IdTable::endAppendRows()
+{
+    endInsertRows();
+}
+
 const CSMWorld::RecordBase& CSMWorld::IdTable::getRecord (const std::string& id) const
 {
     return mIdCollection->getRecord (id);
@@ -63,6 +63,14 @@ namespace CSMWorld
                     UniversalId::Type type = UniversalId::Type_None);
             ///< Add record or overwrite existing recrod.
 
+            void beginAppendRows (int count);
+            ///< Notify the views, that \a count records are about to be appended to the collection
+            /// directly.
+            ///
+            /// \attention Must be followed by endAppendRows, once the records are appended.
+
+            void endAppendRows();
+
             const RecordBase& getRecord (const std::string& id) const;
 
             virtual int searchColumnIndex (Columns::ColumnId id) const;
@@ -2,6 +2,8 @@
 
 #include <vector>
 
+#include <QTimer>
+
 #include "idtablebase.hpp"
 
 namespace
@@ -51,9 +53,13 @@ bool CSMWorld::IdTableProxyModel::filterAcceptsRow (int sourceRow, const QModelI
 
 CSMWorld::IdTableProxyModel::IdTableProxyModel (QObject *parent)
     : QSortFilterProxyModel (parent), 
+      mRefreshTimer (new QTimer (this)),
       mSourceModel(NULL)
 {
     setSortCaseSensitivity (Qt::CaseInsensitive);
+
+    mRefreshTimer->setSingleShot (true);
+    connect (mRefreshTimer, SIGNAL (timeout()), this, SLOT (refreshFilter()));
 }
 
 QModelIndex CSMWorld::IdTableProxyModel::getModelIndex (const std::string& id, int column) const
@@ -121,13 +127,21 @@ QString CSMWorld::IdTableProxyModel::getRecordId(int sourceRow) const
 
 void CSMWorld::IdTableProxyModel::refreshFilter()
 {
+    mRefreshTimer->stop();
     updateColumnMap();
     invalidateFilter();
 }
 
+void CSMWorld::IdTableProxyModel::scheduleRefresh()
+{
+    // QSortFilterProxyModel keeps itself consistent meanwhile
+    if (!mRefreshTimer->isActive())
+        mRefreshTimer->start (0);
+}
+
 void CSMWorld::IdTableProxyModel::sourceRowsInserted(const QModelIndex &parent, int /*start*/, int end)
 {
-    refreshFilter();
+    scheduleRefresh();
     if (!parent.isValid())
     {
         emit rowAdded(getRecordId(end).toUtf8().constData());
@@ -136,10 +150,10 @@ void CSMWorld::IdTableProxyModel::sourceRowsInserted(const QModelIndex &parent,
 
 void CSMWorld::IdTableProxyModel::sourceRowsRemoved(const QModelIndex &/*parent*/, int /*start*/, int /*end*/)
 {
-    refreshFilter();
+    scheduleRefresh();
 }
 
 void CSMWorld::IdTableProxyModel::sourceDataChanged(const QModelIndex &/*topLeft*/, const QModelIndex &/*bottomRight*/)
 {
-    refreshFilter();
+    scheduleRefresh();
 }
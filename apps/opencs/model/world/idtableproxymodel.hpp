@@ -9,6 +9,8 @@
 
 #include <QSortFilterProxyModel>
 
+class QTimer;
+
 #include "../filter/node.hpp"
 
 #include "columns.hpp"
@@ -27,6 +29,8 @@ namespace CSMWorld
             typedef std::map<Columns::ColumnId, std::vector<std::string> > EnumColumnCache;
             mutable EnumColumnCache mEnumColumnCache;
 
+            QTimer *mRefreshTimer;
+
         protected:
 
             IdTableBase *mSourceModel;
@@ -45,10 +49,16 @@ namespace CSMWorld
 
             void setFilter (const boost::shared_ptr<CSMFilter::Node>& filter);
 
+        public slots:
+
             void refreshFilter();
 
         protected:
 
+            void scheduleRefresh();
+            ///< Refresh the filter once control returns to the event loop, so that a bulk change of
+            /// the source model (e.g. a command macro) is filtered and sorted only once.
+
             virtual bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
 
             virtual bool filterAcceptsRow (int sourceRow, const QModelIndex& sourceParent) const;
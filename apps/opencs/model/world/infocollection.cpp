@@ -1,5 +1,6 @@
 #include "infocollection.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <iterator>
 
@@ -219,9 +220,6 @@ void CSMWorld::InfoCollection::removeDialogueInfos(const std::string& dialogueId
         }
     }
 
-    while (!erasedRecords.empty())
-    {
-        removeRows(erasedRecords.back(), 1);
-        erasedRecords.pop_back();
-    }
+    std::sort(erasedRecords.begin(), erasedRecords.end());
+    removeRecords(erasedRecords);
 }
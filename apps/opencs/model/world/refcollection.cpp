@@ -10,14 +10,34 @@
 #include "cell.hpp"
 #include "universalid.hpp"
 #include "record.hpp"
+#include "idtable.hpp"
+
+void CSMWorld::RefCollection::appendRecords (std::vector<Record<CellRef> >& records, IdTable *table)
+{
+    if (records.empty())
+        return;
+
+    if (table)
+        table->beginAppendRows (static_cast<int> (records.size()));
+
+    insertRecords (records, getSize());
+
+    if (table)
+        table->endAppendRows();
+
+    records.clear();
+}
 
 void CSMWorld::RefCollection::load (ESM::ESMReader& reader, int cellIndex, bool base,
-    std::map<ESM::RefNum, std::string>& cache, CSMDoc::Messages& messages)
+    std::map<ESM::RefNum, std::string>& cache, CSMDoc::Messages& messages, IdTable *table)
 {
     Record<Cell> cell = mCells.getRecord (cellIndex);
 
     Cell& cell2 = base ? cell.mBase : cell.mModified;
 
+    // new references, which are appended together
+    std::vector<Record<CellRef> > newRecords;
+
     CellRef ref;
     ESM::MovedCellRef mref;
     bool isDeleted = false;
@@ -90,19 +110,29 @@ void CSMWorld::RefCollection::load (ESM::ESMReader& reader, int cellIndex, bool
                 continue;
             }
 
+            appendRecords (newRecords, table);
+
             int index = getIndex (iter->second);
 
             Record<CellRef> record = getRecord (index);
 
             if (base)
             {
-                removeRows (index, 1);
+                if (table)
+                    table->removeRows (index, 1);
+                else
+                    removeRows (index, 1);
+
                 cache.erase (iter);
             }
             else
             {
                 record.mState = RecordBase::State_Deleted;
-                setRecord (index, record);
+
+                if (table)
+                    table->setRecord (iter->second, record);
+                else
+                    setRecord (index, record);
             }
 
             continue;
@@ -117,7 +147,7 @@ void CSMWorld::RefCollection::load (ESM::ESMReader& reader, int cellIndex, bool
             record.mState = base ? RecordBase::State_BaseOnly : RecordBase::State_ModifiedOnly;
             (base ? record.mBase : record.mModified) = ref;
 
-            appendRecord (record);
+            newRecords.push_back (record);
 
             cache.insert (std::make_pair (ref.mRefNum, ref.mId));
         }
@@ -126,15 +156,22 @@ void CSMWorld::RefCollection::load (ESM::ESMReader& reader, int cellIndex, bool
             // old reference -> merge
             ref.mId = iter->second;
 
+            appendRecords (newRecords, table);
+
             int index = getIndex (ref.mId);
 
             Record<CellRef> record = getRecord (index);
             record.mState = base ? RecordBase::State_BaseOnly : RecordBase::State_Modified;
             (base ? record.mBase : record.mModified) = ref;
 
-            setRecord (index, record);
+            if (table)
+                table->setRecord (ref.mId, record);
+            else
+                setRecord (index, record);
         }
     }
+
+    appendRecords (newRecords, table);
 }
 
 std::string CSMWorld::RefCollection::getNewId()
@@ -2,6 +2,7 @@
 #define CSM_WOLRD_REFCOLLECTION_H
 
 #include <map>
+#include <vector>
 
 #include "../doc/stage.hpp"
 
@@ -13,6 +14,7 @@ namespace CSMWorld
 {
     struct Cell;
     class UniversalId;
+    class IdTable;
 
     /// \brief References in cells
     class RefCollection : public Collection<CellRef>
@@ -20,6 +22,9 @@ namespace CSMWorld
             Collection<Cell>& mCells;
             int mNextId;
 
+            void appendRecords (std::vector<Record<CellRef> >& records, IdTable *table);
+            ///< Append \a records in one go and clear them.
+
         public:
             // MSVC needs the constructor for a class inheriting a template to be defined in header
             RefCollection (Collection<Cell>& cells)
@@ -27,8 +32,12 @@ namespace CSMWorld
             {}
 
             void load (ESM::ESMReader& reader, int cellIndex, bool base,
-                std::map<ESM::RefNum, std::string>& cache, CSMDoc::Messages& messages);
+                std::map<ESM::RefNum, std::string>& cache, CSMDoc::Messages& messages,
+                IdTable *table = 0);
             ///< Load a sequence of references.
+            ///
+            /// \param table If not 0, the model of *this, which is notified of the changes. Used for
+            /// loading references while the document is already open.
 
             std::string getNewId();
     };
@@ -20,6 +20,7 @@ void CSVDoc::Operation::updateLabel (int threads)
             case CSMDoc::State_Verifying: name = "verifying"; break;
             case CSMDoc::State_Searching: name = "searching"; break;
             case CSMDoc::State_Merging: name = "merging"; break;
+            case CSMDoc::State_Loading: name = "loading references"; break;
         }
 
         std::ostringstream stream;
@@ -42,6 +43,11 @@ CSVDoc::Operation::Operation (int type, QWidget* parent) : mType (type), mStalli
     /// \todo Add a cancel button or a pop up menu with a cancel item
     initWidgets();
     setBarColor( type);
+
+    // the document can not be used without all of its references
+    if (type==CSMDoc::State_Loading)
+        mAbortButton->setEnabled (false);
+
     updateLabel();
 
     /// \todo assign different progress bar colours to allow the user to distinguish easily between operation types
@@ -383,6 +383,7 @@ void CSVDoc::View::updateActions()
 {
     bool editing = !(mDocument->getState() & CSMDoc::State_Locked);
     bool running = mDocument->getState() & CSMDoc::State_Running;
+    bool loading = mDocument->getState() & CSMDoc::State_Loading;
 
     for (std::vector<QAction *>::iterator iter (mEditingActions.begin()); iter!=mEditingActions.end(); ++iter)
         (*iter)->setEnabled (editing);
@@ -390,14 +391,14 @@ void CSVDoc::View::updateActions()
     mUndo->setEnabled (editing & mDocument->getUndoStack().canUndo());
     mRedo->setEnabled (editing & mDocument->getUndoStack().canRedo());
 
-    mSave->setEnabled (!(mDocument->getState() & CSMDoc::State_Saving) && !running);
-    mVerify->setEnabled (!(mDocument->getState() & CSMDoc::State_Verifying));
+    mSave->setEnabled (!(mDocument->getState() & CSMDoc::State_Saving) && !running && !loading);
+    mVerify->setEnabled (!(mDocument->getState() & CSMDoc::State_Verifying) && !loading);
 
-    mGlobalDebugProfileMenu->updateActions (running);
+    mGlobalDebugProfileMenu->updateActions (running || loading);
     mStopDebug->setEnabled (running);
 
     mMerge->setEnabled (mDocument->getContentFiles().size()>1 &&
-        !(mDocument->getState() & CSMDoc::State_Merging));
+        !(mDocument->getState() & CSMDoc::State_Merging) && !loading);
 }
 
 CSVDoc::View::View (ViewManager& viewManager, CSMDoc::Document *document, int totalViews)
@@ -476,7 +477,7 @@ void CSVDoc::View::updateDocumentState()
     static const int operations[] =
     {
         CSMDoc::State_Saving, CSMDoc::State_Verifying, CSMDoc::State_Searching,
-        CSMDoc::State_Merging,
+        CSMDoc::State_Merging, CSMDoc::State_Loading,
         -1 // end marker
     };
 
@@ -1,17 +1,27 @@
 #include "pagedworldspacewidget.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <set>
 #include <sstream>
+#include <vector>
 
 #include <QMouseEvent>
 #include <QApplication>
 
+#include <osg/Timer>
 #include <osgGA/TrackballManipulator>
 
 #include <components/esm/loadland.hpp>
+#include <components/misc/stringops.hpp>
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/sceneutil/workqueue.hpp>
 
 #include "../../model/world/tablemimedata.hpp"
 #include "../../model/world/idtable.hpp"
+#include "../../model/world/columns.hpp"
 
 #include "../widget/scenetooltoggle.hpp"
 #include "../widget/scenetoolmode.hpp"
@@ -20,10 +30,54 @@
 #include "editmode.hpp"
 #include "elements.hpp"
 
+namespace
+{
+    class PreloadedModels : public osg::Referenced
+    {
+        public:
+
+            std::vector<osg::ref_ptr<const osg::Referenced> > mModels;
+    };
+
+    /// \brief Loads the models of a cell in the background, so that creating its objects only
+    /// instantiates them.
+    class CellPreloadItem : public SceneUtil::WorkItem
+    {
+            std::set<std::string> mModels;
+            Resource::SceneManager *mSceneManager;
+            osg::ref_ptr<PreloadedModels> mResult;
+
+        public:
+
+            CellPreloadItem (const std::set<std::string>& models, Resource::SceneManager *sceneManager,
+                PreloadedModels *result)
+            : mModels (models), mSceneManager (sceneManager), mResult (result)
+            {}
+
+            virtual void doWork()
+            {
+                for (std::set<std::string>::const_iterator iter (mModels.begin());
+                    iter!=mModels.end(); ++iter)
+                {
+                    try
+                    {
+                        osg::ref_ptr<const osg::Node> model = mSceneManager->getTemplate (*iter);
+                        mResult->mModels.push_back (model.get());
+                    }
+                    catch (const std::exception&)
+                    {
+                        // reported again, when the object is created
+                    }
+                }
+
+                mTicket->signalDone();
+            }
+    };
+}
+
 bool CSVRender::PagedWorldspaceWidget::adjustCells()
 {
     bool modified = false;
-    bool wasEmpty = mCells.empty();
 
     const CSMWorld::IdCollection<CSMWorld::Cell>& cells = mDocument.getData().getCells();
 
@@ -74,52 +128,163 @@ bool CSVRender::PagedWorldspaceWidget::adjustCells()
                 ++iter;
             }
         }
+
+        // cancel the loading of removed cells
+        std::map<CSMWorld::CellCoordinates, LoadingCell>::iterator loading (mLoadingCells.begin());
+
+        while (loading!=mLoadingCells.end())
+        {
+            if (!mSelection.has (loading->first))
+            {
+                if (loading->second.mTicket)
+                    loading->second.mTicket->cancel();
+
+                mLoadingCells.erase (loading++);
+            }
+            else
+                ++loading;
+        }
     }
 
     // add
     for (CSMWorld::CellSelection::Iterator iter (mSelection.begin()); iter!=mSelection.end();
         ++iter)
     {
-        if (mCells.find (*iter)==mCells.end())
-        {
+        if (!isCellInScene (*iter))
             addCellToScene (*iter);
-            modified = true;
-        }
     }
 
+    startLoadingCells();
+
     if (modified)
     {
         for (std::map<CSMWorld::CellCoordinates, Cell *>::const_iterator iter (mCells.begin());
             iter!=mCells.end(); ++iter)
+            iter->second->setCellArrows (getCellArrows (iter->second->getCoordinates()));
+    }
+
+    return modified;
+}
+
+bool CSVRender::PagedWorldspaceWidget::isCellInScene (const CSMWorld::CellCoordinates& coordinates) const
+{
+    return mCells.find (coordinates)!=mCells.end() ||
+        mLoadingCells.find (coordinates)!=mLoadingCells.end();
+}
+
+int CSVRender::PagedWorldspaceWidget::getCellArrows (const CSMWorld::CellCoordinates& coordinates) const
+{
+    int mask = 0;
+
+    for (int i=CellArrow::Direction_North; i<=CellArrow::Direction_East; i *= 2)
+    {
+        CSMWorld::CellCoordinates neighbour (coordinates);
+
+        switch (i)
         {
-            int mask = 0;
+            case CellArrow::Direction_North: neighbour = coordinates.move (0, 1); break;
+            case CellArrow::Direction_West: neighbour = coordinates.move (-1, 0); break;
+            case CellArrow::Direction_South: neighbour = coordinates.move (0, -1); break;
+            case CellArrow::Direction_East: neighbour = coordinates.move (1, 0); break;
+        }
 
-            for (int i=CellArrow::Direction_North; i<=CellArrow::Direction_East; i *= 2)
-            {
-                CSMWorld::CellCoordinates coordinates (iter->second->getCoordinates());
+        if (!mSelection.has (neighbour))
+            mask |= i;
+    }
 
-                switch (i)
-                {
-                    case CellArrow::Direction_North: coordinates = coordinates.move (0, 1); break;
-                    case CellArrow::Direction_West: coordinates = coordinates.move (-1, 0); break;
-                    case CellArrow::Direction_South: coordinates = coordinates.move (0, -1); break;
-                    case CellArrow::Direction_East: coordinates = coordinates.move (1, 0); break;
-                }
+    return mask;
+}
 
-                if (!mSelection.has (coordinates))
-                    mask |= i;
-            }
+void CSVRender::PagedWorldspaceWidget::startLoadingCells()
+{
+    // the models of the references of each cell that is not loading yet
+    std::map<std::string, std::set<std::string> > cellModels;
+
+    for (std::map<CSMWorld::CellCoordinates, LoadingCell>::const_iterator iter (mLoadingCells.begin());
+        iter!=mLoadingCells.end(); ++iter)
+        if (!iter->second.mTicket)
+            cellModels[Misc::StringUtils::lowerCase (iter->first.getId (mWorldspace))];
+
+    if (cellModels.empty())
+        return;
+
+    // one pass over the references for all cells
+    const CSMWorld::RefCollection& references = mDocument.getData().getReferences();
+    const CSMWorld::RefIdCollection& referenceables = mDocument.getData().getReferenceables();
+    int modelColumn = referenceables.findColumnIndex (CSMWorld::Columns::ColumnId_Model);
+
+    for (int i=0; i<references.getSize(); ++i)
+    {
+        const CSMWorld::Record<CSMWorld::CellRef>& record = references.getRecord (i);
+
+        if (record.mState==CSMWorld::RecordBase::State_Deleted)
+            continue;
+
+        std::map<std::string, std::set<std::string> >::iterator models =
+            cellModels.find (Misc::StringUtils::lowerCase (record.get().mCell));
+
+        if (models==cellModels.end())
+            continue;
+
+        int index = referenceables.searchId (record.get().mRefID);
+
+        if (index==-1)
+            continue;
+
+        std::string model = referenceables.getData (index, modelColumn).toString().toUtf8().constData();
+
+        if (!model.empty())
+            models->second.insert ("meshes\\" + model);
+    }
+
+    // The cells nearest to the camera are loaded first. Without any cells in the scene the
+    // camera is not placed yet, so the centre of the selection is used instead.
+    double centreX = 0;
+    double centreY = 0;
+
+    if (!mCells.empty())
+    {
+        osg::Vec3d eye, centre, up;
+        mView->getCamera()->getViewMatrixAsLookAt (eye, centre, up);
+        centreX = eye.x() / ESM::Land::REAL_SIZE;
+        centreY = eye.y() / ESM::Land::REAL_SIZE;
+    }
+    else if (mSelection.begin()!=mSelection.end())
+    {
+        int cells = 0;
 
-            iter->second->setCellArrows (mask);
+        for (CSMWorld::CellSelection::Iterator iter (mSelection.begin()); iter!=mSelection.end();
+            ++iter, ++cells)
+        {
+            centreX += iter->getX() + 0.5;
+            centreY += iter->getY() + 0.5;
         }
+
+        centreX /= cells;
+        centreY /= cells;
     }
 
-    /// \todo do not overwrite manipulator object
-    /// \todo move code to useViewHint function
-    if (modified && wasEmpty)
-        mView->setCameraManipulator(new osgGA::TrackballManipulator);
+    Resource::SceneManager *sceneManager =
+        mDocument.getData().getResourceSystem()->getSceneManager();
 
-    return modified;
+    for (std::map<CSMWorld::CellCoordinates, LoadingCell>::iterator iter (mLoadingCells.begin());
+        iter!=mLoadingCells.end(); ++iter)
+    {
+        if (iter->second.mTicket)
+            continue;
+
+        int distance = static_cast<int> (std::max (
+            std::abs (iter->first.getX() + 0.5 - centreX), std::abs (iter->first.getY() + 0.5 - centreY)));
+
+        osg::ref_ptr<PreloadedModels> preloaded (new PreloadedModels);
+        iter->second.mModels = preloaded;
+        iter->second.mTicket = mWorkQueue->addWorkItem (new CellPreloadItem (
+            cellModels[Misc::StringUtils::lowerCase (iter->first.getId (mWorldspace))], sceneManager,
+            preloaded), -distance);
+    }
+
+    if (!mCellLoadTimer->isActive())
+        mCellLoadTimer->start();
 }
 
 void CSVRender::PagedWorldspaceWidget::addVisibilitySelectorButtons (
@@ -191,7 +356,7 @@ void CSVRender::PagedWorldspaceWidget::handleMouseClick (osg::ref_ptr<TagBase> t
                 {
                     CSMWorld::CellCoordinates newCoordinates = coordinates.move (x, y);
 
-                    if (mCells.find (newCoordinates)==mCells.end())
+                    if (!isCellInScene (newCoordinates))
                     {
                         addCellToScene (newCoordinates);
                         mSelection.add (newCoordinates);
@@ -200,7 +365,7 @@ void CSVRender::PagedWorldspaceWidget::handleMouseClick (osg::ref_ptr<TagBase> t
 
                     if (button=="s-edit")
                     {
-                        if (mCells.find (coordinates)!=mCells.end())
+                        if (isCellInScene (coordinates))
                         {
                             removeCellFromScene (coordinates);
                             mSelection.remove (coordinates);
@@ -301,6 +466,12 @@ std::string CSVRender::PagedWorldspaceWidget::getStartupInstruction()
 
 void CSVRender::PagedWorldspaceWidget::addCellToScene (
     const CSMWorld::CellCoordinates& coordinates)
+{
+    if (!isCellInScene (coordinates))
+        mLoadingCells.insert (std::make_pair (coordinates, LoadingCell()));
+}
+
+void CSVRender::PagedWorldspaceWidget::createCell (const CSMWorld::CellCoordinates& coordinates)
 {
     const CSMWorld::IdCollection<CSMWorld::Cell>& cells = mDocument.getData().getCells();
 
@@ -325,6 +496,17 @@ void CSVRender::PagedWorldspaceWidget::removeCellFromScene (
         delete iter->second;
         mCells.erase (iter);
     }
+
+    std::map<CSMWorld::CellCoordinates, LoadingCell>::iterator loading =
+        mLoadingCells.find (coordinates);
+
+    if (loading!=mLoadingCells.end())
+    {
+        if (loading->second.mTicket)
+            loading->second.mTicket->cancel();
+
+        mLoadingCells.erase (loading);
+    }
 }
 
 void CSVRender::PagedWorldspaceWidget::addCellSelection (int x, int y)
@@ -335,7 +517,7 @@ void CSVRender::PagedWorldspaceWidget::addCellSelection (int x, int y)
     for (CSMWorld::CellSelection::Iterator iter (newSelection.begin()); iter!=newSelection.end();
         ++iter)
     {
-        if (mCells.find (*iter)==mCells.end())
+        if (!isCellInScene (*iter))
         {
             addCellToScene (*iter);
             mSelection.add (*iter);
@@ -366,9 +548,13 @@ void CSVRender::PagedWorldspaceWidget::moveCellSelection (int x, int y)
 }
 
 CSVRender::PagedWorldspaceWidget::PagedWorldspaceWidget (QWidget* parent, CSMDoc::Document& document)
-: WorldspaceWidget (document, parent), mDocument (document), mWorldspace ("std::default"),
-  mControlElements(NULL), mDisplayCellCoord(true)
+: WorldspaceWidget (document, parent), mDocument (document), mWorkQueue (new SceneUtil::WorkQueue),
+  mCellLoadTimer (new QTimer (this)), mWorldspace ("std::default"), mControlElements(NULL),
+  mDisplayCellCoord(true)
 {
+    mCellLoadTimer->setInterval (20);
+    connect (mCellLoadTimer, SIGNAL (timeout()), this, SLOT (cellsLoaded()));
+
     QAbstractItemModel *cells =
         document.getData().getTableModel (CSMWorld::UniversalId::Type_Cells);
 
@@ -545,3 +731,46 @@ void CSVRender::PagedWorldspaceWidget::cellAdded (const QModelIndex& index, int
     if (adjustCells())
         flagAsModified();
 }
+
+void CSVRender::PagedWorldspaceWidget::cellsLoaded()
+{
+    bool wasEmpty = mCells.empty();
+    bool added = false;
+
+    osg::Timer_t start = osg::Timer::instance()->tick();
+
+    // keep the user interface responsive, the rest of the cells are added on the next timeout
+    const double timeBudget = 20; // ms
+
+    std::map<CSMWorld::CellCoordinates, LoadingCell>::iterator iter (mLoadingCells.begin());
+
+    while (iter!=mLoadingCells.end() &&
+        osg::Timer::instance()->delta_m (start, osg::Timer::instance()->tick())<timeBudget)
+    {
+        if (iter->second.mTicket && iter->second.mTicket->isDone())
+        {
+            createCell (iter->first);
+            mLoadingCells.erase (iter++);
+            added = true;
+        }
+        else
+            ++iter;
+    }
+
+    if (mLoadingCells.empty())
+        mCellLoadTimer->stop();
+
+    if (!added)
+        return;
+
+    for (std::map<CSMWorld::CellCoordinates, Cell *>::const_iterator cell (mCells.begin());
+        cell!=mCells.end(); ++cell)
+        cell->second->setCellArrows (getCellArrows (cell->second->getCoordinates()));
+
+    /// \todo do not overwrite manipulator object
+    /// \todo move code to useViewHint function
+    if (wasEmpty)
+        mView->setCameraManipulator(new osgGA::TrackballManipulator);
+
+    flagAsModified();
+}
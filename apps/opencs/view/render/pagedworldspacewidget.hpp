@@ -2,6 +2,10 @@
 #define OPENCS_VIEW_PAGEDWORLDSPACEWIDGET_H
 
 #include <map>
+#include <memory>
+
+#include <osg/ref_ptr>
+#include <osg/Referenced>
 
 #include "../../model/world/cellselection.hpp"
 
@@ -13,6 +17,12 @@ namespace CSVWidget
    class SceneToolToggle;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+    class WorkTicket;
+}
+
 namespace CSVRender
 {
     class TextOverlay;
@@ -22,9 +32,19 @@ namespace CSVRender
     {
             Q_OBJECT
 
+            /// A cell, whose models are loaded in the background before it is added to the scene
+            struct LoadingCell
+            {
+                osg::ref_ptr<SceneUtil::WorkTicket> mTicket; // 0, if the loading has not started yet
+                osg::ref_ptr<osg::Referenced> mModels; // keeps the loaded models in the cache
+            };
+
             CSMDoc::Document& mDocument;
             CSMWorld::CellSelection mSelection;
             std::map<CSMWorld::CellCoordinates, Cell *> mCells;
+            std::map<CSMWorld::CellCoordinates, LoadingCell> mLoadingCells;
+            std::auto_ptr<SceneUtil::WorkQueue> mWorkQueue;
+            QTimer *mCellLoadTimer;
             std::string mWorldspace;
             CSVWidget::SceneToolToggle *mControlElements;
             bool mDisplayCellCoord;
@@ -33,6 +53,19 @@ namespace CSVRender
 
             std::pair<int, int> getCoordinatesFromId(const std::string& record) const;
 
+            /// Is the cell in the scene or being loaded?
+            bool isCellInScene (const CSMWorld::CellCoordinates& coordinates) const;
+
+            /// Return the arrows a cell at \a coordinates needs towards the cells that are not
+            /// selected.
+            int getCellArrows (const CSMWorld::CellCoordinates& coordinates) const;
+
+            /// Start loading the models of the cells that have been added to the scene, the cells
+            /// nearest to the camera first.
+            void startLoadingCells();
+
+            void createCell (const CSMWorld::CellCoordinates& coordinates);
+
             /// Bring mCells into sync with mSelection again.
             ///
             /// \return Any cells added or removed?
@@ -54,6 +87,8 @@ namespace CSVRender
             virtual std::string getStartupInstruction();
 
             /// \note Does not update the view or any cell marker
+            ///
+            /// \note The cell is shown once its models are loaded; see startLoadingCells
             void addCellToScene (const CSMWorld::CellCoordinates& coordinates);
 
             /// \note Does not update the view or any cell marker
@@ -116,6 +151,9 @@ namespace CSVRender
 
             virtual void cellAdded (const QModelIndex& index, int start, int end);
 
+            /// Add the cells, whose models have been loaded, to the scene.
+            void cellsLoaded();
+
     };
 }
 
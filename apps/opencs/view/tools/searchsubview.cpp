@@ -103,7 +103,7 @@ void CSVTools::SearchSubView::setEditLock (bool locked)
 
 void CSVTools::SearchSubView::stateChanged (int state, CSMDoc::Document *document)
 {
-    mSearchBox.setSearchMode (!(state & CSMDoc::State_Searching));
+    mSearchBox.setSearchMode (!(state & (CSMDoc::State_Searching | CSMDoc::State_Loading)));
 }
 
 void CSVTools::SearchSubView::startSearch (const CSMTools::Search& search)
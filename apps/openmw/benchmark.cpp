@@ -0,0 +1,166 @@
+#include "benchmark.hpp"
+
+#include <sstream>
+#include <stdexcept>
+
+#include <osg/Math>
+#include <osg/Stats>
+#include <osgViewer/Viewer>
+
+#include "mwbase/environment.hpp"
+#include "mwbase/world.hpp"
+#include "mwbase/statemanager.hpp"
+
+#include "mwworld/ptr.hpp"
+
+namespace
+{
+    // The timings of the GPU and of the draw thread are only known a few frames later
+    const unsigned int sTimingsDelay = 10;
+
+    void writeTiming (std::ostream& stream, const osg::Stats* stats, unsigned int frameNumber, const std::string& name)
+    {
+        double value = 0;
+        stream << ',';
+        if (stats && stats->getAttribute (frameNumber, name, value))
+            stream << value * 1000;
+    }
+}
+
+namespace OMW
+{
+    const double Benchmark::sTimeStep = 1.0/60;
+
+    const unsigned int Benchmark::sSeed = 1;
+
+    Benchmark::Benchmark (const std::string& path)
+    : mSegment (0), mStarted (false), mTime (0)
+    {
+        boost::filesystem::ifstream stream (path);
+        if (!stream.is_open())
+            throw std::runtime_error ("failed to open benchmark path " + path);
+
+        std::string line;
+        for (int lineNumber = 1; std::getline (stream, line); ++lineNumber)
+        {
+            if (line.find_first_not_of (" \t\r") == std::string::npos || line[line.find_first_not_of (" \t")] == '#')
+                continue;
+
+            std::istringstream lineStream (line);
+            Point point;
+            if (!(lineStream >> point.mTime >> point.mPosition.x() >> point.mPosition.y() >> point.mPosition.z()
+                >> point.mPitch >> point.mYaw))
+            {
+                std::ostringstream error;
+                error << "invalid point in line " << lineNumber << " of benchmark path " << path;
+                throw std::runtime_error (error.str());
+            }
+
+            point.mPitch = osg::DegreesToRadians (point.mPitch);
+            point.mYaw = osg::DegreesToRadians (point.mYaw);
+
+            if (!mPath.empty() && point.mTime < mPath.back().mTime)
+            {
+                std::ostringstream error;
+                error << "point in line " << lineNumber << " of benchmark path " << path << " is out of order";
+                throw std::runtime_error (error.str());
+            }
+
+            mPath.push_back (point);
+        }
+
+        if (mPath.empty())
+            throw std::runtime_error ("benchmark path " + path + " has no points");
+
+        const std::string outputPath = path + ".csv";
+        mOutput.open (outputPath);
+        if (!mOutput.is_open())
+            throw std::runtime_error ("failed to open benchmark output " + outputPath);
+
+        mOutput << "frame,time,frame ms,script ms,mechanics ms,physics ms,cull ms,draw ms,gpu ms\n";
+    }
+
+    void Benchmark::start (osgViewer::Viewer& viewer)
+    {
+        mStarted = true;
+
+        viewer.getViewerStats()->collectStats ("frame_rate", true);
+        if (osg::Stats* stats = viewer.getCamera()->getStats())
+        {
+            stats->collectStats ("rendering", true);
+            stats->collectStats ("gpu", true);
+        }
+
+        // Fly through walls, and do not fall
+        MWBase::World* world = MWBase::Environment::get().getWorld();
+        if (world->toggleCollisionMode())
+            world->toggleCollisionMode();
+    }
+
+    bool Benchmark::update (osgViewer::Viewer& viewer)
+    {
+        if (MWBase::Environment::get().getStateManager()->getState() != MWBase::StateManager::State_Running)
+            return true;
+
+        if (!mStarted)
+            start (viewer);
+        else
+            mTime += sTimeStep;
+
+        if (mTime > mPath.back().mTime)
+        {
+            finish (viewer);
+            return false;
+        }
+
+        while (mSegment+1 < mPath.size() && mPath[mSegment+1].mTime <= mTime)
+            ++mSegment;
+
+        const Point& from = mPath[mSegment];
+        const Point& to = mPath[std::min (mSegment+1, mPath.size()-1)];
+        const float ratio = to.mTime > from.mTime ? static_cast<float> ((mTime - from.mTime) / (to.mTime - from.mTime)) : 0.f;
+
+        const osg::Vec3f position = from.mPosition + (to.mPosition - from.mPosition) * ratio;
+        const float pitch = from.mPitch + (to.mPitch - from.mPitch) * ratio;
+        const float yaw = from.mYaw + (to.mYaw - from.mYaw) * ratio;
+
+        MWBase::World* world = MWBase::Environment::get().getWorld();
+        MWWorld::Ptr player = world->moveObject (world->getPlayerPtr(), position.x(), position.y(), position.z());
+        world->rotateObject (player, pitch, 0, yaw);
+
+        mPending.push_back (std::make_pair (viewer.getFrameStamp()->getFrameNumber(), mTime));
+        writeTimings (viewer, false);
+
+        return true;
+    }
+
+    void Benchmark::finish (osgViewer::Viewer& viewer)
+    {
+        writeTimings (viewer, true);
+        mOutput.flush();
+    }
+
+    void Benchmark::writeTimings (osgViewer::Viewer& viewer, bool all)
+    {
+        const unsigned int latest = viewer.getFrameStamp()->getFrameNumber();
+        const osg::Stats* viewerStats = viewer.getViewerStats();
+        const osg::Stats* cameraStats = viewer.getCamera()->getStats();
+
+        while (!mPending.empty() && (all || mPending.front().first + sTimingsDelay <= latest))
+        {
+            const unsigned int frameNumber = mPending.front().first;
+
+            mOutput << frameNumber << ',' << mPending.front().second;
+            writeTiming (mOutput, viewerStats, frameNumber, "Frame duration");
+            writeTiming (mOutput, viewerStats, frameNumber, "script_time_taken");
+            writeTiming (mOutput, viewerStats, frameNumber, "mechanics_time_taken");
+            writeTiming (mOutput, viewerStats, frameNumber, "physics_time_taken");
+            writeTiming (mOutput, cameraStats, frameNumber, "Cull traversal time taken");
+            writeTiming (mOutput, cameraStats, frameNumber, "Draw traversal time taken");
+            writeTiming (mOutput, cameraStats, frameNumber, "GPU draw time taken");
+            mOutput << '\n';
+
+            mPending.pop_front();
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <osg/Vec3f>
+
+namespace osgViewer
+{
+    class Viewer;
+}
+
+namespace OMW
+{
+    /// \brief Flies the player along a recorded path, and writes how long each part of every frame took
+    ///
+    /// The path file has a line "time x y z pitch yaw" for each point of the path, in seconds since the start,
+    /// game units and degrees, sorted by time. Empty lines and lines starting with # are ignored. The player
+    /// moves between the points in straight lines, without collision.
+    ///
+    /// The timings are written as comma separated values to the path file name with ".csv" appended.
+    class Benchmark
+    {
+        public:
+
+            /// Time step of the game while benchmarking, in seconds
+            static const double sTimeStep;
+
+            /// Seed of the random number generator while benchmarking
+            static const unsigned int sSeed;
+
+            /// @note Throws an exception if the path file can not be read.
+            Benchmark (const std::string& path);
+
+            /// Move the player to where the path is after the time the benchmark ran for. Does nothing until a
+            /// game is running. Call once per frame, while the physics system is not running.
+            /// @return Is the path still to be completed?
+            bool update (osgViewer::Viewer& viewer);
+
+            /// Write the timings of the frames that are not written yet.
+            void finish (osgViewer::Viewer& viewer);
+
+        private:
+
+            struct Point
+            {
+                double mTime;
+                osg::Vec3f mPosition;
+                // radians
+                float mPitch;
+                float mYaw;
+            };
+
+            std::vector<Point> mPath;
+            std::size_t mSegment;
+            bool mStarted;
+            double mTime;
+
+            boost::filesystem::ofstream mOutput;
+
+            // Frames whose timings are not written yet, <frame number, time on the path>
+            std::deque<std::pair<unsigned int, double> > mPending;
+
+            void start (osgViewer::Viewer& viewer);
+
+            /// @param all Also write the latest frames, before all of their timings are available.
+            void writeTimings (osgViewer::Viewer& viewer, bool all);
+    };
+}
+
+#endif
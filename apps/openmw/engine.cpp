@@ -1,10 +1,15 @@
 #include "engine.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <iomanip>
+#include <sstream>
 
 #include <boost/filesystem/fstream.hpp>
 
+#include <OpenThreads/Thread>
+
 #include <osgViewer/ViewerEventHandlers>
 #include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
@@ -12,6 +17,7 @@
 #include <SDL.h>
 
 #include <components/misc/rng.hpp>
+#include <components/misc/profiler.hpp>
 
 #include <components/vfs/manager.hpp>
 #include <components/vfs/registerarchives.hpp>
@@ -21,23 +27,32 @@
 
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/texturemanager.hpp>
+#include <components/resource/scenemanager.hpp>
+
+#include <components/sceneutil/workqueue.hpp>
 
 #include <components/compiler/extensions0.hpp>
 
 #include <components/files/configurationmanager.hpp>
+#include <components/files/directorycache.hpp>
 #include <components/translation/translation.hpp>
 
 #include <components/version/version.hpp>
 
+#include "benchmark.hpp"
+#include "replay.hpp"
+
 #include "mwinput/inputmanagerimp.hpp"
 
 #include "mwgui/windowmanagerimp.hpp"
 
 #include "mwscript/scriptmanagerimp.hpp"
+#include "mwscript/scriptcache.hpp"
 #include "mwscript/extensions.hpp"
 #include "mwscript/interpretercontext.hpp"
 
 #include "mwsound/soundmanagerimp.hpp"
+#include "mwsound/loudnesscache.hpp"
 
 #include "mwworld/class.hpp"
 #include "mwworld/player.hpp"
@@ -66,17 +81,48 @@ namespace
 
 void OMW::Engine::executeLocalScripts()
 {
+    OPENMW_PROFILE_ZONE ("Engine::executeLocalScripts");
+
     MWWorld::LocalScripts& localScripts = mEnvironment.getWorld()->getLocalScripts();
 
+    // Scripts of objects far from the player run once per interval. The golden ratio spreads their
+    // phases, so that not all of them run in the same frame.
+    const bool throttle = mLocalScriptThrottleDistance > 0 && mLocalScriptInterval > 0;
+    double previousTime = 0;
+    double time = 0;
+    osg::Vec3f playerPos;
+    if (throttle)
+    {
+        previousTime = mLocalScriptTime / mLocalScriptInterval;
+        mLocalScriptTime += mEnvironment.getFrameDuration();
+        time = mLocalScriptTime / mLocalScriptInterval;
+        playerPos = mEnvironment.getWorld()->getPlayerPtr().getRefData().getPosition().asVec3();
+    }
+
+    MWScript::InterpreterContext interpreterContext (0, MWWorld::Ptr());
+
     localScripts.startIteration();
 
-    while (!localScripts.isFinished())
+    for (int index = 0; !localScripts.isFinished(); ++index)
     {
         std::pair<std::string, MWWorld::Ptr> script = localScripts.getNext();
 
-        MWScript::InterpreterContext interpreterContext (
-            &script.second.getRefData().getLocals(), script.second);
+        if (throttle)
+        {
+            const double phase = std::fmod(index * 0.618034, 1.0);
+            const bool due = std::floor(time + phase) != std::floor(previousTime + phase);
+
+            // Items in containers have no position of their own
+            if (!due && script.second.isInCell()
+                && (script.second.getRefData().getPosition().asVec3() - playerPos).length2()
+                    > mLocalScriptThrottleDistance * mLocalScriptThrottleDistance
+                && mEnvironment.getScriptManager()->canThrottle(script.first))
+                continue;
+        }
+
+        interpreterContext.reset (&script.second.getRefData().getLocals(), script.second);
         mEnvironment.getScriptManager()->run (script.first, interpreterContext);
+        ++mLocalScriptsRun;
     }
 
     localScripts.setIgnore (MWWorld::Ptr());
@@ -84,14 +130,23 @@ void OMW::Engine::executeLocalScripts()
 
 void OMW::Engine::frame(float frametime)
 {
+    OPENMW_PROFILE_ZONE ("Engine::frame");
+
     try
     {
         mStartTick = mViewer->getStartTick();
         mEnvironment.setFrameDuration (frametime);
+        mLocalScriptsRun = 0;
+
+        // movement solved while the last frame rendered
+        mEnvironment.getWorld()->finishPhysicsAsync();
 
         // update input
         mEnvironment.getInputManager()->update(frametime, false);
 
+        if (mBenchmark.get() && !mBenchmark->update (*mViewer))
+            mEnvironment.getStateManager()->requestQuit();
+
         // When the window is minimized, pause the game. Currently this *has* to be here to work around a MyGUI bug.
         // If we are not currently rendering, then RenderItems will not be reused resulting in a memory leak upon changing widget textures (fixed in MyGUI 3.3.2),
         // and destroyed widgets will not be deleted (not fixed yet, https://github.com/MyGUI/mygui/issues/21)
@@ -185,6 +240,15 @@ void OMW::Engine::frame(float frametime)
         stats->setAttribute(frameNumber, "physics_time_taken", osg::Timer::instance()->delta_s(beforePhysicsTick, afterPhysicsTick));
         stats->setAttribute(frameNumber, "physics_time_end", osg::Timer::instance()->delta_s(mStartTick, afterPhysicsTick));
 
+        stats->setAttribute(frameNumber, "local_scripts_run", mLocalScriptsRun);
+
+        mEnvironment.getWorld()->reportStats(frameNumber, *stats);
+        mEnvironment.getSoundManager()->reportStats(frameNumber, *stats);
+        mEnvironment.getMechanicsManager()->reportStats(frameNumber, *stats);
+        mResourceSystem->reportStats(frameNumber, *stats);
+
+        // solve the movement for the next frame while this one renders
+        mEnvironment.getWorld()->startPhysicsAsync();
     }
     catch (const std::exception& e)
     {
@@ -204,12 +268,19 @@ OMW::Engine::Engine(Files::ConfigurationManager& configurationManager)
   , mWarningsMode (1)
   , mScriptConsoleMode (false)
   , mActivationDistanceOverride(-1)
+  , mHeadless(false)
+  , mTimeStep(0.f)
+  , mQuitAfter(0.0)
   , mGrab(true)
   , mExportFonts(false)
   , mScriptContext (0)
   , mFSStrict (false)
   , mScriptBlacklistUse (true)
   , mNewGame (false)
+  , mLocalScriptThrottleDistance (0)
+  , mLocalScriptInterval (0)
+  , mLocalScriptTime (0)
+  , mLocalScriptsRun (0)
   , mCfgMgr(configurationManager)
 {
     Misc::Rng::init();
@@ -295,6 +366,41 @@ void OMW::Engine::setSkipMenu (bool skipMenu, bool newGame)
     mNewGame = newGame;
 }
 
+void OMW::Engine::setBenchmark (const std::string& path)
+{
+    mBenchmarkPath = path;
+}
+
+void OMW::Engine::setProfile (const std::string& path)
+{
+    mProfilePath = path;
+}
+
+void OMW::Engine::setRecord (const std::string& path)
+{
+    mRecordPath = path;
+}
+
+void OMW::Engine::setReplay (const std::string& path)
+{
+    mReplayPath = path;
+}
+
+void OMW::Engine::setHeadless (bool headless)
+{
+    mHeadless = headless;
+}
+
+void OMW::Engine::setTimeStep (float timeStep)
+{
+    mTimeStep = timeStep;
+}
+
+void OMW::Engine::setQuitAfter (double seconds)
+{
+    mQuitAfter = seconds;
+}
+
 std::string OMW::Engine::loadSettings (Settings::Manager & settings)
 {
     // Create the settings manager and load default settings file
@@ -322,6 +428,17 @@ void OMW::Engine::createWindow(Settings::Manager& settings)
     int screen = settings.getInt("screen", "Video");
     int width = settings.getInt("resolution x", "Video");
     int height = settings.getInt("resolution y", "Video");
+
+    if (mHeadless)
+    {
+        // Only for SDL input and the size of the GUI, never shown and without a graphics context,
+        // so that the viewer is never realized and nothing is rendered
+        mWindow = SDL_CreateWindow("OpenMW", 0, 0, width, height, SDL_WINDOW_HIDDEN);
+        if (!mWindow)
+            throw std::runtime_error(std::string("Failed to create SDL window: ") + SDL_GetError());
+        mViewer->getCamera()->setViewport(0, 0, width, height);
+        return;
+    }
     bool fullscreen = settings.getBool("fullscreen", "Video");
     bool windowBorder = settings.getBool("window border", "Video");
     bool vsync = settings.getBool("vsync", "Video");
@@ -407,6 +524,17 @@ void OMW::Engine::createWindow(Settings::Manager& settings)
     camera->setGraphicsContext(graphicsWindow);
     camera->setViewport(0, 0, width, height);
 
+    // The game logic changes the scene graph between frames. What it changes is double buffered or marked DYNAMIC,
+    // so that the draw of a frame can overlap with the simulation of the next frame.
+    // The water reflection and refraction become slave cameras of the viewer then, see MWRender::Water
+    if (Settings::Manager::getBool("draw thread", "Video") && OpenThreads::GetNumberOfProcessors() > 1
+            && Settings::Manager::getBool("parallel cull", "Video"))
+        mViewer->setThreadingModel(osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext);
+    else if (Settings::Manager::getBool("draw thread", "Video") && OpenThreads::GetNumberOfProcessors() > 1)
+        mViewer->setThreadingModel(osgViewer::ViewerBase::DrawThreadPerContext);
+    else
+        mViewer->setThreadingModel(osgViewer::ViewerBase::SingleThreaded);
+
     mViewer->realize();
 }
 
@@ -447,7 +575,19 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
 
     mVFS.reset(new VFS::Manager(mFSStrict));
 
-    VFS::registerArchives(mVFS.get(), mFileCollections, mArchives, true);
+    {
+        Files::DirectoryCache directoryCache;
+        const bool useDirectoryCache = Settings::Manager::getBool("cache data directories", "General");
+        const boost::filesystem::path directoryCacheFile = mCfgMgr.getCachePath() / "datadirectories.cache";
+        if (useDirectoryCache)
+            directoryCache.load(directoryCacheFile);
+
+        VFS::registerArchives(mVFS.get(), mFileCollections, mArchives, true,
+            Settings::Manager::getBool("memory map archives", "General"), useDirectoryCache ? &directoryCache : NULL);
+
+        if (useDirectoryCache)
+            directoryCache.save(directoryCacheFile);
+    }
 
     mResourceSystem.reset(new Resource::ResourceSystem(mVFS.get()));
     mResourceSystem->getTextureManager()->setUnRefImageDataAfterApply(true);
@@ -458,6 +598,19 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
         Settings::Manager::getInt("anisotropy", "General"),
         NULL
     );
+    mResourceSystem->getTextureManager()->setTextureBudget(
+        static_cast<size_t>(std::max(0, Settings::Manager::getInt("texture budget", "General"))) * 1024 * 1024,
+        Settings::Manager::getInt("streamed texture size", "General"));
+    if (Settings::Manager::getBool("scene cache", "General"))
+        mResourceSystem->getSceneManager()->setSceneCacheDirectory(mCfgMgr.getCachePath() / "scenes");
+    if (Settings::Manager::getBool("collision shape cache", "General"))
+        mResourceSystem->setBvhCacheDirectory(mCfgMgr.getCachePath() / "collision");
+    if (Settings::Manager::getBool("texture cache", "General"))
+        mResourceSystem->getTextureManager()->setTextureCacheDirectory(mCfgMgr.getCachePath() / "textures");
+
+    const int numThreads = std::max(1, Settings::Manager::getInt("preload num threads", "General"));
+    mEnvironment.setWorkQueue(new SceneUtil::WorkQueue(numThreads));
+    mResourceSystem->getTextureManager()->setWorkQueue(mEnvironment.getWorkQueue());
 
     // Create input and UI first to set up a bootstrapping environment for
     // showing a loading screen and keeping the window responsive while doing so
@@ -486,6 +639,8 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
 
     MWInput::InputManager* input = new MWInput::InputManager (mWindow, mViewer, mScreenCaptureHandler, keybinderUser, keybinderUserExists, gameControllerdb, mGrab);
     mEnvironment.setInputManager (input);
+    if (mReplay.get())
+        input->setEventRecorder (mReplay.get());
 
     std::string myguiResources = (mResDir / "mygui").string();
     osg::ref_ptr<osg::Group> guiRoot = new osg::Group;
@@ -494,11 +649,17 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     MWGui::WindowManager* window = new MWGui::WindowManager(mViewer, guiRoot, mResourceSystem.get(),
                 mCfgMgr.getLogPath().string() + std::string("/"), myguiResources,
                 mScriptConsoleMode, mTranslationDataStorage, mEncoding, mExportFonts, mFallbackMap,
-                Version::getOpenmwVersionDescription(mResDir.string()));
+                Version::getOpenmwVersionDescription(mResDir.string()), mCfgMgr.getCachePath().string());
     mEnvironment.setWindowManager (window);
 
     // Create sound system
-    mEnvironment.setSoundManager (new MWSound::SoundManager(mVFS.get(), mUseSound));
+    std::auto_ptr<MWSound::LoudnessCache> loudnessCache;
+    if (Settings::Manager::getBool("loudness cache", "Sound"))
+    {
+        loudnessCache.reset(new MWSound::LoudnessCache(mCfgMgr.getCachePath() / "loudness.cache"));
+        loudnessCache->load(Version::getOpenmwVersionDescription(mResDir.string()));
+    }
+    mEnvironment.setSoundManager (new MWSound::SoundManager(mVFS.get(), mUseSound, loudnessCache.release()));
 
     if (!mSkipMenu)
     {
@@ -507,11 +668,27 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
             window->playVideo(logo, true);
     }
 
+    boost::filesystem::path contentSnapshot;
+    if (Settings::Manager::getBool("content snapshot", "General"))
+    {
+        // The records are stored converted, so the snapshot depends on the encoding
+        std::ostringstream name;
+        name << "content-" << static_cast<int>(mEncoding) << ".snapshot";
+        contentSnapshot = mCfgMgr.getCachePath() / name.str();
+    }
+
+    boost::filesystem::path navigationCache;
+    if (Settings::Manager::getBool("navigation grid cache", "Physics"))
+        navigationCache = mCfgMgr.getCachePath() / "navigation";
+
     // Create the world
     mEnvironment.setWorld( new MWWorld::World (mViewer, rootNode, mResourceSystem.get(),
         mFileCollections, mContentFiles, mEncoder, mFallbackMap,
-        mActivationDistanceOverride, mCellName, mStartupScript, mResDir.string()));
+        mActivationDistanceOverride, mCellName, mStartupScript, mResDir.string(), contentSnapshot, navigationCache));
     mEnvironment.getWorld()->setupPlayer();
+
+    // After creating the world, which adds resource managers of its own
+    mResourceSystem->setExpiryDelay(Settings::Manager::getFloat("cache expiry delay", "Cells"));
     input->setPlayer(&mEnvironment.getWorld()->getPlayer());
 
     window->setStore(mEnvironment.getWorld()->getStore());
@@ -529,9 +706,29 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     mScriptContext = new MWScript::CompilerContext (MWScript::CompilerContext::Type_Full);
     mScriptContext->setExtensions (&mExtensions);
 
-    mEnvironment.setScriptManager (new MWScript::ScriptManager (mEnvironment.getWorld()->getStore(),
+    std::auto_ptr<MWScript::ScriptCache> scriptCache;
+    if (Settings::Manager::getBool("script cache", "General"))
+    {
+        // The world has already checked that all content files exist
+        std::vector<boost::filesystem::path> contentFiles;
+        for (std::vector<std::string>::const_iterator it = mContentFiles.begin(); it != mContentFiles.end(); ++it)
+        {
+            const Files::MultiDirCollection& collection =
+                mFileCollections.getCollection(boost::filesystem::path(*it).extension().string());
+            contentFiles.push_back(collection.getPath(*it));
+        }
+
+        std::vector<std::string> keywords;
+        mExtensions.listKeywords(keywords);
+
+        scriptCache.reset(new MWScript::ScriptCache(mCfgMgr.getCachePath() / "scripts.cache"));
+        scriptCache->load(Version::getOpenmwVersionDescription(mResDir.string()), keywords, contentFiles);
+    }
+
+    MWScript::ScriptManager* scriptManager = new MWScript::ScriptManager (mEnvironment.getWorld()->getStore(),
         mVerboseScripts, *mScriptContext, mWarningsMode,
-        mScriptBlacklistUse ? mScriptBlacklist : std::vector<std::string>()));
+        mScriptBlacklistUse ? mScriptBlacklist : std::vector<std::string>(), scriptCache.release());
+    mEnvironment.setScriptManager (scriptManager);
 
     // Create game mechanics system
     MWMechanics::MechanicsManager* mechanics = new MWMechanics::MechanicsManager;
@@ -541,7 +738,13 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     mEnvironment.setJournal (new MWDialogue::Journal);
     mEnvironment.setDialogueManager (new MWDialogue::DialogueManager (mExtensions, mVerboseScripts, mTranslationDataStorage));
 
+    mLocalScriptThrottleDistance = Settings::Manager::getFloat("local script throttle distance", "Game");
+    mLocalScriptInterval = Settings::Manager::getFloat("local script throttle interval", "Game");
+
     // scripts
+    if (!mCompileAll && Settings::Manager::getBool("precompile scripts", "General"))
+        scriptManager->startPrecompilation(mEnvironment.getWorkQueue());
+
     if (mCompileAll)
     {
         std::pair<int, int> result = mEnvironment.getScriptManager()->compileAll();
@@ -618,6 +821,19 @@ void OMW::Engine::go()
 {
     assert (!mContentFiles.empty());
 
+    // Includes the loading of the content files
+    if (!mProfilePath.empty())
+        Misc::Profiler::start (mProfilePath);
+
+    if (mHeadless)
+    {
+        // Nothing to show the menu or play sounds with
+        mUseSound = false;
+        mGrab = false;
+        if (mSaveGameFile.empty())
+            mSkipMenu = true;
+    }
+
     mViewer = new osgViewer::Viewer;
 
     osg::ref_ptr<osgViewer::StatsHandler> statshandler = new osgViewer::StatsHandler;
@@ -629,6 +845,64 @@ void OMW::Engine::go()
                                    "mechanics_time_taken", 1000.0, true, false, "mechanics_time_begin", "mechanics_time_end", 10000);
     statshandler->addUserStatsLine("Physics", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
                                    "physics_time_taken", 1000.0, true, false, "physics_time_begin", "physics_time_end", 10000);
+    statshandler->addUserStatsLine("Light sets hit", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "light_stateset_hits", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Light sets new", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "light_stateset_misses", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Light sets", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "light_stateset_cached", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Occlusion tests", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "occlusion_tested", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Occluded", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "occlusion_culled", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Physics actors", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "physics_solved_actors", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Solve/actor us", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "physics_solve_time_per_actor", 1000000.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Sweeps", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "physics_sweeps", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Trace downs", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "physics_trace_downs", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Contact tests", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "physics_contact_tests", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Collision objects", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "physics_collision_objects", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Sound cache MB", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "sound_buffer_cache_size", 1.0/(1024*1024), false, false, "", "", 0);
+    statshandler->addUserStatsLine("Sound buffers unused", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "sound_buffer_cache_unused", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Sound cache hits", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "sound_buffer_cache_hits", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Sound cache misses", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "sound_buffer_cache_misses", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Sound cache evictions", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "sound_buffer_cache_evictions", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Sounds playing", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "sound_playing", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Sounds virtual", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "sound_virtual", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Textures", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "resource_textures", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Texture MB", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "resource_texture_bytes", 1.0/(1024*1024), false, false, "", "", 0);
+    statshandler->addUserStatsLine("NIF files", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "resource_nif_files", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Scene templates", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "resource_scene_templates", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Shared states", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "resource_shared_states", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Bullet shapes", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "resource_bullet_shapes", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Sync loads", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "resource_sync_loads", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Actors", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "mechanics_actors", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("AI actors", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "mechanics_actors_ai", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Voices", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "sound_voices", 1.0, false, false, "", "", 0);
+    statshandler->addUserStatsLine("Local scripts", osg::Vec4f(1.f, 1.f, 1.f, 1.f), osg::Vec4f(1.f, 1.f, 1.f, 1.f),
+                                   "local_scripts_run", 1.0, false, false, "", "", 0);
 
     mViewer->addEventHandler(statshandler);
 
@@ -645,6 +919,19 @@ void OMW::Engine::go()
     ToUTF8::Utf8Encoder encoder (mEncoding);
     mEncoder = &encoder;
 
+    if (!mBenchmarkPath.empty())
+    {
+        // the same run every time
+        Misc::Rng::init (Benchmark::sSeed);
+        mBenchmark.reset (new Benchmark (mBenchmarkPath));
+    }
+
+    // Seeds the RNG too, so after the benchmark
+    if (!mReplayPath.empty())
+        mReplay.reset (new Replay (mReplayPath, false));
+    else if (!mRecordPath.empty())
+        mReplay.reset (new Replay (mRecordPath, true));
+
     prepareEngine (settings);
 
     if (!mSaveGameFile.empty())
@@ -674,12 +961,27 @@ void OMW::Engine::go()
     // Start the main rendering loop
     osg::Timer frameTimer;
     double simulationTime = 0.0;
+    double runTime = 0.0;
     float framerateLimit = Settings::Manager::getFloat("framerate limit", "Video");
+    if (mTimeStep > 0.f || (mReplay.get() && !mReplay->isRecording()))
+        framerateLimit = 0.f;
     while (!mViewer->done() && !mEnvironment.getStateManager()->hasQuitRequest())
     {
         double dt = frameTimer.time_s();
         frameTimer.setStartTick();
         dt = std::min(dt, 0.2);
+        if (mBenchmark.get())
+            dt = Benchmark::sTimeStep;
+        else if (mTimeStep > 0.f)
+            dt = mTimeStep;
+
+        // A replay ends the game when it ran out of frames
+        if (mReplay.get() && !mReplay->beginFrame (dt))
+            break;
+
+        runTime += dt;
+        if (mQuitAfter > 0.0 && runTime > mQuitAfter)
+            break;
 
         bool guiActive = mEnvironment.getWindowManager()->isGuiMode();
         if (!guiActive)
@@ -687,21 +989,29 @@ void OMW::Engine::go()
 
         mViewer->advance(simulationTime);
 
+        // The simulation time stands still while a menu is open, so that nothing expires during that time
+        mResourceSystem->updateCache(simulationTime);
+
         frame(dt);
 
-        if (!mEnvironment.getInputManager()->isWindowVisible())
+        if (mHeadless)
+        {
+            // The simulation all happens in frame(), the scene graph traversals only serve the drawing
+        }
+        else if (!mEnvironment.getInputManager()->isWindowVisible())
         {
             OpenThreads::Thread::microSleep(5000);
             continue;
         }
         else
         {
+            OPENMW_PROFILE_ZONE ("Engine::renderFrame");
             mViewer->eventTraversal();
             mViewer->updateTraversal();
             mViewer->renderingTraversals();
         }
 
-        if (framerateLimit > 0.f)
+        if (framerateLimit > 0.f && !mBenchmark.get())
         {
             double thisFrameTime = frameTimer.time_s();
             double minFrameTime = 1.0 / framerateLimit;
@@ -712,6 +1022,13 @@ void OMW::Engine::go()
         }
     }
 
+    if (mBenchmark.get())
+        mBenchmark->finish (*mViewer);
+    if (mReplay.get())
+        mReplay->finish();
+
+    Misc::Profiler::stop();
+
     // Save user settings
     settings.saveUser(settingspath);
 
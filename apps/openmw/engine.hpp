@@ -62,6 +62,9 @@ struct SDL_Window;
 
 namespace OMW
 {
+    class Benchmark;
+    class Replay;
+
     /// \brief Main engine class, that brings together all the components of OpenMW
     class Engine
     {
@@ -90,6 +93,17 @@ namespace OMW
             std::string mStartupScript;
             int mActivationDistanceOverride;
             std::string mSaveGameFile;
+            std::string mBenchmarkPath;
+            std::string mProfilePath;
+            std::auto_ptr<Benchmark> mBenchmark;
+            std::string mRecordPath;
+            std::string mReplayPath;
+            std::auto_ptr<Replay> mReplay;
+            bool mHeadless;
+            // In seconds, 0 for the real frame time
+            float mTimeStep;
+            // In seconds, 0 to run until quit
+            double mQuitAfter;
             // Grab mouse?
             bool mGrab;
 
@@ -105,6 +119,12 @@ namespace OMW
             bool mScriptBlacklistUse;
             bool mNewGame;
 
+            float mLocalScriptThrottleDistance;
+            float mLocalScriptInterval;
+            double mLocalScriptTime;
+            // For the on-screen stats
+            unsigned int mLocalScriptsRun;
+
             osg::Timer_t mStartTick;
 
             // not implemented
@@ -166,6 +186,33 @@ namespace OMW
 
             void setGrabMouse(bool grab) { mGrab = grab; }
 
+            /// Fly along the path in the given file with a fixed time step, and write the frame timings,
+            /// see Benchmark. An empty path disables benchmarking.
+            void setBenchmark (const std::string& path);
+
+            /// Record the profiler zones from startup to quitting, and write them to the given file, see
+            /// Misc::Profiler. An empty path disables profiling.
+            void setProfile (const std::string& path);
+
+            /// Record the input, the frame times and the random seed to the given file, see Replay.
+            /// An empty path disables recording.
+            void setRecord (const std::string& path);
+
+            /// Replay a file written with setRecord, then quit. An empty path disables replaying.
+            void setReplay (const std::string& path);
+
+            /// Run the simulation without showing a window or rendering anything, and without sound.
+            /// Implies skipping the main menu.
+            /// @note Without a display, set SDL_VIDEODRIVER=dummy.
+            void setHeadless (bool headless);
+
+            /// Advance the game by a fixed time step each frame instead of the real frame time, and
+            /// do not limit the frame rate. 0 uses the real frame time.
+            void setTimeStep (float timeStep);
+
+            /// Quit once the frames added up to the given time in seconds. 0 runs until quit.
+            void setQuitAfter (double seconds);
+
             /// Initialise and enter main loop.
             void go();
 
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <cstdio>
 
@@ -164,6 +165,31 @@ bool parseOptions (int argc, char** argv, OMW::Engine& engine, Files::Configurat
         ("new-game", bpo::value<bool>()->implicit_value(true)
             ->default_value(false), "run new game sequence (ignored if skip-menu=0)")
 
+        ("benchmark", bpo::value<std::string>()->default_value(""),
+            "fly along the camera path in the given file with a fixed time step and write the frame timings to the file name with .csv appended "
+            "(use with load-savegame or skip-menu)")
+
+        ("profile", bpo::value<std::string>()->default_value(""),
+            "record the profiler zones from startup to quitting and write them to the given file as Chrome trace events "
+            "(needs a build with OPENMW_PROFILING)")
+
+        ("record", bpo::value<std::string>()->default_value(""),
+            "record the input, the frame times and the random seed to the given file, for replaying the session")
+
+        ("replay", bpo::value<std::string>()->default_value(""),
+            "replay the input and the frame times recorded with record from the given file, then quit "
+            "(use with the same content files, settings and load-savegame or skip-menu as the recording)")
+
+        ("headless", bpo::value<bool>()->implicit_value(true)
+            ->default_value(false), "run the game without showing a window, rendering or sound, e.g. for soak tests "
+            "(skips the main menu unless used with load-savegame; without a display set SDL_VIDEODRIVER=dummy)")
+
+        ("timestep", bpo::value<float>()->default_value(0.f),
+            "advance the game by this many seconds each frame without limiting the frame rate, 0 for real time")
+
+        ("quit-after", bpo::value<double>()->default_value(0.0),
+            "quit once this many seconds were simulated, counting the time steps, 0 to run until quit")
+
         ("fs-strict", bpo::value<bool>()->implicit_value(true)
             ->default_value(false), "strict file system handling (no case folding)")
 
@@ -274,6 +300,13 @@ bool parseOptions (int argc, char** argv, OMW::Engine& engine, Files::Configurat
     engine.setScriptBlacklist (variables["script-blacklist"].as<StringsVector>());
     engine.setScriptBlacklistUse (variables["script-blacklist-use"].as<bool>());
     engine.setSaveGameFile (variables["load-savegame"].as<std::string>());
+    engine.setBenchmark (variables["benchmark"].as<std::string>());
+    engine.setProfile (variables["profile"].as<std::string>());
+    engine.setRecord (variables["record"].as<std::string>());
+    engine.setReplay (variables["replay"].as<std::string>());
+    engine.setHeadless (variables["headless"].as<bool>());
+    engine.setTimeStep (std::max(0.f, variables["timestep"].as<float>()));
+    engine.setQuitAfter (std::max(0.0, variables["quit-after"].as<double>()));
 
     // other settings
     engine.setSoundUsage(!variables["no-sound"].as<bool>());
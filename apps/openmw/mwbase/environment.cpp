@@ -2,6 +2,8 @@
 
 #include <cassert>
 
+#include <components/sceneutil/workqueue.hpp>
+
 #include "world.hpp"
 #include "scriptmanager.hpp"
 #include "dialoguemanager.hpp"
@@ -17,7 +19,7 @@ MWBase::Environment *MWBase::Environment::sThis = 0;
 MWBase::Environment::Environment()
 : mWorld (0), mSoundManager (0), mScriptManager (0), mWindowManager (0),
   mMechanicsManager (0),  mDialogueManager (0), mJournal (0), mInputManager (0), mStateManager (0),
-  mFrameDuration (0)
+  mWorkQueue (0), mFrameDuration (0)
 {
     assert (!sThis);
     sThis = this;
@@ -74,6 +76,11 @@ void MWBase::Environment::setStateManager (StateManager *stateManager)
     mStateManager = stateManager;
 }
 
+void MWBase::Environment::setWorkQueue (SceneUtil::WorkQueue *workQueue)
+{
+    mWorkQueue = workQueue;
+}
+
 void MWBase::Environment::setFrameDuration (float duration)
 {
     mFrameDuration = duration;
@@ -133,6 +140,12 @@ MWBase::StateManager *MWBase::Environment::getStateManager() const
     return mStateManager;
 }
 
+SceneUtil::WorkQueue *MWBase::Environment::getWorkQueue() const
+{
+    assert (mWorkQueue);
+    return mWorkQueue;
+}
+
 float MWBase::Environment::getFrameDuration() const
 {
     return mFrameDuration;
@@ -140,6 +153,10 @@ float MWBase::Environment::getFrameDuration() const
 
 void MWBase::Environment::cleanup()
 {
+    // Stop the jobs first, they may use any of the subsystems
+    delete mWorkQueue;
+    mWorkQueue = 0;
+
     delete mMechanicsManager;
     mMechanicsManager = 0;
 
@@ -1,6 +1,11 @@
 #ifndef GAME_BASE_ENVIRONMENT_H
 #define GAME_BASE_ENVIRONMENT_H
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace MWBase
 {
     class World;
@@ -32,6 +37,7 @@ namespace MWBase
             Journal *mJournal;
             InputManager *mInputManager;
             StateManager *mStateManager;
+            SceneUtil::WorkQueue *mWorkQueue;
             float mFrameDuration;
 
             Environment (const Environment&);
@@ -64,6 +70,9 @@ namespace MWBase
 
             void setStateManager (StateManager *stateManager);
 
+            void setWorkQueue (SceneUtil::WorkQueue *workQueue);
+            ///< Set the queue for jobs done in background threads.
+
             void setFrameDuration (float duration);
             ///< Set length of current frame in seconds.
 
@@ -85,6 +94,8 @@ namespace MWBase
 
             StateManager *getStateManager() const;
 
+            SceneUtil::WorkQueue *getWorkQueue() const;
+
             float getFrameDuration() const;
 
             void cleanup();
@@ -4,6 +4,7 @@
 #include <string>
 #include <deque>
 #include <map>
+#include <vector>
 
 #include <stdint.h>
 
@@ -42,6 +43,9 @@ namespace MWBase
             typedef std::map<std::string, MWDialogue::Topic> TTopicContainer; // topic-id, topic-content
             typedef TTopicContainer::const_iterator TTopicIter;
 
+            typedef std::map<std::string, std::vector<const MWDialogue::Quest*> > TQuestNameContainer; // quest name, quests
+            typedef TQuestNameContainer::const_iterator TQuestNameIter;
+
         public:
 
             Journal() {}
@@ -80,6 +84,14 @@ namespace MWBase
             virtual TQuestIter questEnd() const = 0;
             ///< Iterator pointing past the last quest.
 
+            virtual TQuestNameIter questNameBegin() const = 0;
+            ///< Iterator pointing to the first quest name (sorted by name), with the quests that have this name
+            ///
+            /// \note Quests without a name are not listed, they do not appear in the quest book.
+
+            virtual TQuestNameIter questNameEnd() const = 0;
+            ///< Iterator pointing past the last quest name.
+
             virtual TTopicIter topicBegin() const = 0;
             ///< Iterator pointing to the first topic (sorted by topic ID)
             ///
@@ -88,6 +100,9 @@ namespace MWBase
             virtual TTopicIter topicEnd() const = 0;
             ///< Iterator pointing past the last topic.
 
+            virtual TTopicIter topicLowerBound (const std::string& topicId) const = 0;
+            ///< Iterator pointing to the first topic whose ID is not sorted before \a topicId.
+
             virtual int countSavedGameRecords() const = 0;
 
             virtual void write (ESM::ESMWriter& writer, Loading::Listener& progress) const = 0;
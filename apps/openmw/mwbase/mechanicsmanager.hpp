@@ -9,6 +9,7 @@
 namespace osg
 {
     class Vec3f;
+    class Stats;
 }
 
 namespace ESM
@@ -70,6 +71,9 @@ namespace MWBase
             /// \param paused In game type does not currently advance (this usually means some GUI
             /// component is up).
 
+            virtual void reportStats (unsigned int frameNumber, osg::Stats& stats) const = 0;
+            ///< Record the numbers of actors and of actors whose AI ran in the last update.
+
             virtual void advanceTime (float duration) = 0;
 
             virtual void setPlayerName (const std::string& name) = 0;
@@ -87,8 +91,9 @@ namespace MWBase
             virtual void setPlayerClass (const ESM::Class& class_) = 0;
             ///< Set player class to custom class.
 
-            virtual void rest(bool sleep) = 0;
-            ///< If the player is sleeping or waiting, this should be called every hour.
+            virtual void rest(int hours, bool sleep) = 0;
+            ///< If the player is sleeping or waiting, this should be called for the hours that passed, after
+            /// advancing the time. Any number of hours is handled in one go.
             /// @param sleep is the player sleeping or waiting?
 
             virtual int getHoursToRest() const = 0;
@@ -184,6 +189,12 @@ namespace MWBase
             virtual void getObjectsInRange (const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& objects) = 0;
             virtual void getActorsInRange(const osg::Vec3f &position, float radius, std::vector<MWWorld::Ptr> &objects) = 0;
 
+            /// Plan the way between two exterior positions in different cells, through the points where the pathgrids
+            /// of the cells meet. The graph of these points is built on the first call.
+            /// @param waypoints The points to walk to in turn, without the start and end.
+            /// @return false if the positions are in the same cell, or there is no way between them.
+            virtual bool findExteriorPath(const osg::Vec3f& start, const osg::Vec3f& end, std::vector<osg::Vec3f>& waypoints) = 0;
+
             ///Returns the list of actors which are siding with the given actor in fights
             /**ie AiFollow or AiEscort is active and the target is the actor **/
             virtual std::list<MWWorld::Ptr> getActorsSidingWith(const MWWorld::Ptr& actor) = 0;
@@ -16,6 +16,7 @@ namespace Compiler
 namespace MWScript
 {
     class GlobalScripts;
+    class ScriptProfile;
 }
 
 namespace MWBase
@@ -49,7 +50,19 @@ namespace MWBase
             virtual const Compiler::Locals& getLocals (const std::string& name) = 0;
             ///< Return locals for script \a name.
 
+            virtual bool canThrottle (const std::string& name) = 0;
+            ///< May script \a name be run less often than once per frame? False for scripts that
+            /// measure time by the frame duration (GetSecondsPassed), for scripts that opt out by
+            /// declaring a local variable NoThrottle and for scripts that are not compiled yet.
+
             virtual MWScript::GlobalScripts& getGlobalScripts() = 0;
+
+            virtual MWScript::ScriptProfile& getProfile() = 0;
+            ///< Execution statistics of the scripts run by run(), collected while enabled.
+
+            virtual void waitForPrecompilation() = 0;
+            ///< Wait until the scripts compiled in the background, if any, are done. Must be called
+            /// before the records that compiling depends on change.
    };
 }
 
@@ -7,6 +7,11 @@
 
 #include "../mwworld/ptr.hpp"
 
+namespace osg
+{
+    class Stats;
+}
+
 namespace MWWorld
 {
     class CellStore;
@@ -170,6 +175,17 @@ namespace MWBase
 
             virtual void updatePtr(const MWWorld::ConstPtr& old, const MWWorld::ConstPtr& updated) = 0;
 
+            virtual void preloadSounds(MWWorld::CellStore *cell) = 0;
+            ///< Start loading the sounds of the sound generators of the creatures in \a cell, so that the
+            /// first footsteps and attacks do not wait for them, unless sounds are not loaded in the
+            /// background. The buffer cache keeps these sounds longer while \a cell is active.
+
+            virtual void unloadSounds(const MWWorld::CellStore *cell) = 0;
+            ///< Undo preloadSounds for a cell that is no longer active.
+
+            virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) = 0;
+            ///< Report the state of the buffer cache and the counters since the last report.
+
             virtual void clear() = 0;
     };
 }
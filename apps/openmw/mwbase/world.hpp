@@ -17,6 +17,7 @@ namespace osg
     class Matrixf;
     class Quat;
     class Image;
+    class Stats;
 }
 
 namespace Loading
@@ -285,9 +286,24 @@ namespace MWBase
             ///< Queues movement for \a ptr (in local space), to be applied in the next call to
             /// doPhysics.
 
+            virtual void startPhysicsAsync() = 0;
+            ///< With [Physics] "async movement", start solving the queued movement in the background, to be applied
+            /// by the next doPhysics. Call at the end of the frame, so that the solving overlaps with rendering.
+            /// Nothing may use the physics until finishPhysicsAsync.
+
+            virtual void finishPhysicsAsync() = 0;
+            ///< Wait for the movement started by startPhysicsAsync. Call at the start of the frame.
+
+            virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) const = 0;
+            ///< Set the counts of the physics work since the last call as attributes of the frame.
+
             virtual bool castRay (float x1, float y1, float z1, float x2, float y2, float z2) = 0;
             ///< cast a Ray and return true if there is an object in the ray path.
 
+            virtual bool findNavigationPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                                            std::vector<osg::Vec3f>& path) const = 0;
+            ///< Find a path on the navigation grid of the cell, see MWPhysics::PhysicsSystem::findNavigationPath.
+
             virtual bool toggleCollisionMode() = 0;
             ///< Toggle collision mode for player. If disabled player object should ignore
             /// collisions and gravity.
@@ -417,6 +433,17 @@ namespace MWBase
             virtual bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor) = 0;
             ///< get Line of Sight (morrowind stupid implementation)
 
+            virtual void getLOS(const MWWorld::ConstPtr& actor, const std::vector<MWWorld::ConstPtr>& targetActors,
+                                std::vector<bool>& results) = 0;
+            ///< get Line of Sight to each of the targets, in one batch of ray casts
+
+            virtual void getActorsInRange(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out) const = 0;
+            ///< Add the actors with a collision shape within the radius of the position to \a out, sorted by MWWorld::Ptr.
+            /// Does not go through all actors, see MWPhysics::PhysicsSystem::getActorsInRange
+
+            virtual bool hasActorCollisionShape(const MWWorld::ConstPtr& actor) const = 0;
+            ///< Can the actor be found with getActorsInRange?
+
             virtual float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist) = 0;
 
             virtual void enableActorCollision(const MWWorld::Ptr& actor, bool enable) = 0;
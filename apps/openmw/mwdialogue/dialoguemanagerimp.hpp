@@ -13,6 +13,8 @@
 
 #include "../mwscript/compilercontext.hpp"
 
+#include "infoconditions.hpp"
+
 namespace ESM
 {
     struct Dialogue;
@@ -31,6 +33,8 @@ namespace MWDialogue
 
             std::set<std::string> mActorKnownTopics;
 
+            InfoConditions mInfoConditions;
+
             Translation::Storage& mTranslationDataStorage;
             MWScript::CompilerContext mCompilerContext;
             std::ostream mErrorStream;
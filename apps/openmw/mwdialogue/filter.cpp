@@ -20,15 +20,16 @@
 #include "../mwmechanics/actorutil.hpp"
 
 #include "selectwrapper.hpp"
+#include "infoconditions.hpp"
 
 bool MWDialogue::Filter::testActor (const ESM::DialInfo& info) const
 {
-    bool isCreature = (mActor.getTypeName() != typeid (ESM::NPC).name());
+    bool isCreature = mActorIsCreature;
 
     // actor id
     if (!info.mActor.empty())
     {
-        if ( !Misc::StringUtils::ciEqual(info.mActor, mActor.getCellRef().getRefId()))
+        if ( !Misc::StringUtils::ciEqual(info.mActor, mActorId))
             return false;
     }
     else if (isCreature)
@@ -130,8 +131,9 @@ bool MWDialogue::Filter::testPlayer (const ESM::DialInfo& info) const
 
 bool MWDialogue::Filter::testSelectStructs (const ESM::DialInfo& info) const
 {
-    for (std::vector<ESM::DialInfo::SelectStruct>::const_iterator iter (info.mSelects.begin());
-        iter != info.mSelects.end(); ++iter)
+    const InfoConditions::Selects& selects = mConditions.get (info);
+
+    for (InfoConditions::Selects::const_iterator iter (selects.begin()); iter != selects.end(); ++iter)
         if (!testSelectStruct (*iter))
             return false;
 
@@ -193,7 +195,7 @@ bool MWDialogue::Filter::testSelectStructNumeric (const SelectWrapper& select) c
             if (scriptName.empty())
                 return false; // no script
 
-            std::string name = Misc::StringUtils::lowerCase (select.getName());
+            const std::string& name = select.getName();
 
             const Compiler::Locals& localDefs =
                 MWBase::Environment::get().getScriptManager()->getLocals (scriptName);
@@ -471,7 +473,7 @@ bool MWDialogue::Filter::getSelectStructBoolean (const SelectWrapper& select) co
             const Compiler::Locals& localDefs =
                 MWBase::Environment::get().getScriptManager()->getLocals (scriptName);
 
-            return localDefs.getIndex (Misc::StringUtils::lowerCase (select.getName()))==-1;
+            return localDefs.getIndex (select.getName())==-1;
         }
 
         case SelectWrapper::Function_SameGender:
@@ -590,10 +592,19 @@ bool MWDialogue::Filter::hasFactionRankReputationRequirements (const MWWorld::Pt
     return stats.getFactionReputation (factionId)>=faction.mData.mRankData[rank].mFactReaction;
 }
 
-MWDialogue::Filter::Filter (const MWWorld::Ptr& actor, int choice, bool talkedToPlayer)
-: mActor (actor), mChoice (choice), mTalkedToPlayer (talkedToPlayer)
+MWDialogue::Filter::Filter (const MWWorld::Ptr& actor, int choice, bool talkedToPlayer,
+    const InfoConditions& conditions)
+: mActor (actor), mConditions (conditions),
+  mActorId (Misc::StringUtils::lowerCase (actor.getCellRef().getRefId())),
+  mActorIsCreature (actor.getTypeName() != typeid (ESM::NPC).name()),
+  mChoice (choice), mTalkedToPlayer (talkedToPlayer)
 {}
 
+void MWDialogue::Filter::getCandidates (const ESM::Dialogue& dialogue, std::vector<const ESM::DialInfo *>& infos) const
+{
+    mConditions.getCandidates (dialogue, mActorId, mActorIsCreature, infos);
+}
+
 const ESM::DialInfo* MWDialogue::Filter::search (const ESM::Dialogue& dialogue, const bool fallbackToInfoRefusal) const
 {
     std::vector<const ESM::DialInfo *> suitableInfos = list (dialogue, fallbackToInfoRefusal, false);
@@ -606,11 +617,14 @@ const ESM::DialInfo* MWDialogue::Filter::search (const ESM::Dialogue& dialogue,
 
 std::vector<const ESM::DialInfo *> MWDialogue::Filter::listAll (const ESM::Dialogue& dialogue) const
 {
+    std::vector<const ESM::DialInfo *> candidates;
+    getCandidates (dialogue, candidates);
+
     std::vector<const ESM::DialInfo *> infos;
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin(); iter!=dialogue.mInfo.end(); ++iter)
+    for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin(); iter!=candidates.end(); ++iter)
     {
-        if (testActor (*iter))
-            infos.push_back(&*iter);
+        if (testActor (**iter))
+            infos.push_back(*iter);
     }
     return infos;
 }
@@ -622,14 +636,17 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
     bool infoRefusal = false;
 
+    std::vector<const ESM::DialInfo *> candidates;
+    getCandidates (dialogue, candidates);
+
     // Iterate over topic responses to find a matching one
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin();
-        iter!=dialogue.mInfo.end(); ++iter)
+    for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin();
+        iter!=candidates.end(); ++iter)
     {
-        if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter))
+        if (testActor (**iter) && testPlayer (**iter) && testSelectStructs (**iter))
         {
-            if (testDisposition (*iter, invertDisposition)) {
-                infos.push_back(&*iter);
+            if (testDisposition (**iter, invertDisposition)) {
+                infos.push_back(*iter);
                 if (!searchAll)
                     break;
             }
@@ -648,10 +665,12 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
         const ESM::Dialogue& infoRefusalDialogue = *dialogues.find ("Info Refusal");
 
-        for (ESM::Dialogue::InfoContainer::const_iterator iter = infoRefusalDialogue.mInfo.begin();
-            iter!=infoRefusalDialogue.mInfo.end(); ++iter)
-            if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter) && testDisposition(*iter, invertDisposition)) {
-                infos.push_back(&*iter);
+        getCandidates (infoRefusalDialogue, candidates);
+
+        for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin();
+            iter!=candidates.end(); ++iter)
+            if (testActor (**iter) && testPlayer (**iter) && testSelectStructs (**iter) && testDisposition(**iter, invertDisposition)) {
+                infos.push_back(*iter);
                 if (!searchAll)
                     break;
             }
@@ -662,10 +681,13 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
 bool MWDialogue::Filter::responseAvailable (const ESM::Dialogue& dialogue) const
 {
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin();
-        iter!=dialogue.mInfo.end(); ++iter)
+    std::vector<const ESM::DialInfo *> candidates;
+    getCandidates (dialogue, candidates);
+
+    for (std::vector<const ESM::DialInfo *>::const_iterator iter = candidates.begin();
+        iter!=candidates.end(); ++iter)
     {
-        if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter))
+        if (testActor (**iter) && testPlayer (**iter) && testSelectStructs (**iter))
             return true;
     }
 
@@ -1,6 +1,7 @@
 #ifndef GAME_MWDIALOGUE_FILTER_H
 #define GAME_MWDIALOGUE_FILTER_H
 
+#include <string>
 #include <vector>
 
 #include "../mwworld/ptr.hpp"
@@ -14,13 +15,20 @@ namespace ESM
 namespace MWDialogue
 {
     class SelectWrapper;
+    class InfoConditions;
 
     class Filter
     {
             MWWorld::Ptr mActor;
+            const InfoConditions& mConditions;
+            std::string mActorId; // lower case
+            bool mActorIsCreature;
             int mChoice;
             bool mTalkedToPlayer;
 
+            void getCandidates (const ESM::Dialogue& dialogue, std::vector<const ESM::DialInfo *>& infos) const;
+            ///< Get the infos of \a dialogue that are not for another actor.
+
             bool testActor (const ESM::DialInfo& info) const;
             ///< Is this the right actor for this \a info?
 
@@ -51,7 +59,8 @@ namespace MWDialogue
 
         public:
 
-            Filter (const MWWorld::Ptr& actor, int choice, bool talkedToPlayer);
+            /// @param conditions The decoded select rules of the responses, kept across filters.
+            Filter (const MWWorld::Ptr& actor, int choice, bool talkedToPlayer, const InfoConditions& conditions);
 
             std::vector<const ESM::DialInfo *> list (const ESM::Dialogue& dialogue,
                 bool fallbackToInfoRefusal, bool searchAll, bool invertDisposition=false) const;
@@ -0,0 +1,156 @@
+#include "infoconditions.hpp"
+
+#include <algorithm>
+
+#include <components/esm/loadinfo.hpp>
+#include <components/esm/loaddial.hpp>
+
+#include <components/misc/stringops.hpp>
+
+#include "../mwbase/environment.hpp"
+#include "../mwbase/world.hpp"
+
+#include "../mwworld/esmstore.hpp"
+
+namespace
+{
+    /// Relative cost of testing a select function. Functions that gate quests and choices are cheap lookups
+    /// and reject most responses, so they are tested first.
+    int getCost (MWDialogue::SelectWrapper::Function function)
+    {
+        switch (function)
+        {
+            case MWDialogue::SelectWrapper::Function_None:
+            case MWDialogue::SelectWrapper::Function_False:
+            case MWDialogue::SelectWrapper::Function_Choice:
+            case MWDialogue::SelectWrapper::Function_TalkedToPc:
+            case MWDialogue::SelectWrapper::Function_NotId:
+            case MWDialogue::SelectWrapper::Function_NotClass:
+            case MWDialogue::SelectWrapper::Function_NotRace:
+            case MWDialogue::SelectWrapper::Function_SameGender:
+            case MWDialogue::SelectWrapper::Function_PcGender:
+
+                return 0;
+
+            case MWDialogue::SelectWrapper::Function_Journal:
+            case MWDialogue::SelectWrapper::Function_Global:
+            case MWDialogue::SelectWrapper::Function_Dead:
+
+                return 1;
+
+            case MWDialogue::SelectWrapper::Function_Item:
+            case MWDialogue::SelectWrapper::Function_PcClothingModifier:
+            case MWDialogue::SelectWrapper::Function_RankRequirement:
+            case MWDialogue::SelectWrapper::Function_RankLow:
+            case MWDialogue::SelectWrapper::Function_RankHigh:
+            case MWDialogue::SelectWrapper::Function_NotCell:
+            case MWDialogue::SelectWrapper::Function_Local:
+            case MWDialogue::SelectWrapper::Function_NotLocal:
+
+                return 3;
+
+            case MWDialogue::SelectWrapper::Function_Detected:
+            case MWDialogue::SelectWrapper::Function_ShouldAttack:
+
+                return 4;
+
+            default:
+
+                // Stats of the actor or the player
+                return 2;
+        }
+    }
+
+    struct CostLess
+    {
+        bool operator() (const MWDialogue::SelectWrapper& left, const MWDialogue::SelectWrapper& right) const
+        {
+            return getCost (left.getFunction()) < getCost (right.getFunction());
+        }
+    };
+}
+
+namespace MWDialogue
+{
+    InfoConditions::InfoConditions()
+    : mGeneration (0)
+    {}
+
+    void InfoConditions::checkGeneration() const
+    {
+        // A replaced dialogue may have left responses behind at the addresses of the new ones
+        unsigned int generation = MWBase::Environment::get().getWorld()->getStore().get<ESM::Dialogue>().getGeneration();
+        if (generation != mGeneration)
+        {
+            mSelects.clear();
+            mIndices.clear();
+            mGeneration = generation;
+        }
+    }
+
+    const InfoConditions::Selects& InfoConditions::get (const ESM::DialInfo& info) const
+    {
+        checkGeneration();
+
+        SelectsMap::iterator found = mSelects.find (&info);
+        if (found != mSelects.end())
+            return found->second;
+
+        Selects& selects = mSelects[&info];
+        selects.reserve (info.mSelects.size());
+        for (std::vector<ESM::DialInfo::SelectStruct>::const_iterator iter (info.mSelects.begin());
+            iter != info.mSelects.end(); ++iter)
+            selects.push_back (SelectWrapper (*iter));
+
+        std::stable_sort (selects.begin(), selects.end(), CostLess());
+
+        return selects;
+    }
+
+    const InfoConditions::DialogueIndex& InfoConditions::getIndex (const ESM::Dialogue& dialogue) const
+    {
+        IndexMap::iterator found = mIndices.find (&dialogue);
+        if (found != mIndices.end())
+            return found->second;
+
+        DialogueIndex& index = mIndices[&dialogue];
+        std::size_t position = 0;
+        for (ESM::Dialogue::InfoContainer::const_iterator iter (dialogue.mInfo.begin());
+            iter != dialogue.mInfo.end(); ++iter, ++position)
+        {
+            if (iter->mActor.empty())
+                index.mAnyActor.push_back (std::make_pair (position, &*iter));
+            else
+                index.mByActor[Misc::StringUtils::lowerCase (iter->mActor)].push_back (std::make_pair (position, &*iter));
+        }
+
+        return index;
+    }
+
+    void InfoConditions::getCandidates (const ESM::Dialogue& dialogue, const std::string& actorId, bool creature,
+        std::vector<const ESM::DialInfo*>& infos) const
+    {
+        checkGeneration();
+
+        const DialogueIndex& index = getIndex (dialogue);
+
+        static const IndexedInfos none;
+        std::map<std::string, IndexedInfos>::const_iterator found = index.mByActor.find (actorId);
+        const IndexedInfos& forActor = found != index.mByActor.end() ? found->second : none;
+        const IndexedInfos& anyActor = creature ? none : index.mAnyActor;
+
+        infos.clear();
+        infos.reserve (forActor.size() + anyActor.size());
+
+        // Merge both lists back into the order of the dialogue
+        IndexedInfos::const_iterator left = forActor.begin();
+        IndexedInfos::const_iterator right = anyActor.begin();
+        while (left != forActor.end() || right != anyActor.end())
+        {
+            if (right == anyActor.end() || (left != forActor.end() && left->first < right->first))
+                infos.push_back ((left++)->second);
+            else
+                infos.push_back ((right++)->second);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef GAME_MWDIALOGUE_INFOCONDITIONS_H
+#define GAME_MWDIALOGUE_INFOCONDITIONS_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "selectwrapper.hpp"
+
+namespace ESM
+{
+    struct DialInfo;
+    struct Dialogue;
+}
+
+namespace MWDialogue
+{
+    /// @brief The select rules of the dialogue responses, decoded ahead of time, and the responses of each dialogue
+    /// indexed by actor.
+    /// @par The rules of a response are decoded once, when the response is first filtered, and ordered so that the
+    /// cheap checks that most often fail, such as journal indices, globals and choices, come before the ones that
+    /// have to look through inventories or test awareness. All rules must match, so the order does not change the
+    /// result.
+    /// @par Most responses are meant for one actor only. The index of a dialogue, built when it is first filtered,
+    /// lets the filter skip the responses for other actors without looking at them.
+    /// @par Rules and indices are made again after the dialogue records changed.
+    class InfoConditions
+    {
+        public:
+
+            typedef std::vector<SelectWrapper> Selects;
+
+            InfoConditions();
+
+            /// Get the select rules of \a info, in the order they should be tested.
+            const Selects& get (const ESM::DialInfo& info) const;
+
+            /// Get the responses of \a dialogue that may be meant for an actor, in the order of the dialogue.
+            /// These are the responses for the actor's ID, and, unless the actor is a creature, the responses that
+            /// are not for a specific actor.
+            /// @param actorId ID of the actor, in lower case
+            void getCandidates (const ESM::Dialogue& dialogue, const std::string& actorId, bool creature,
+                std::vector<const ESM::DialInfo*>& infos) const;
+
+        private:
+
+            // Responses with their positions in the dialogue
+            typedef std::vector<std::pair<std::size_t, const ESM::DialInfo*> > IndexedInfos;
+
+            struct DialogueIndex
+            {
+                IndexedInfos mAnyActor;
+                std::map<std::string, IndexedInfos> mByActor; // key in lower case
+            };
+
+            /// Forget rules and indices if the store of the dialogues changed since they were made.
+            void checkGeneration() const;
+
+            const DialogueIndex& getIndex (const ESM::Dialogue& dialogue) const;
+
+            typedef std::map<const ESM::DialInfo*, Selects> SelectsMap;
+            mutable SelectsMap mSelects;
+            typedef std::map<const ESM::Dialogue*, DialogueIndex> IndexMap;
+            mutable IndexMap mIndices;
+            mutable unsigned int mGeneration;
+    };
+}
+
+#endif
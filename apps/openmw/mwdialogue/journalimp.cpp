@@ -28,11 +28,27 @@ namespace MWDialogue
                 mQuests.insert (std::make_pair (id, Quest (id)));
 
             iter = result.first;
+
+            addQuestName (iter->second);
         }
 
         return iter->second;
     }
 
+    void Journal::addQuestName (const Quest& quest)
+    {
+        // The name is looked up in the dialogue of the quest, so this is only done once per quest
+        std::string name = quest.getName();
+        if (!name.empty())
+            mQuestNames[name].push_back (&quest);
+    }
+
+    void Journal::addJournalEntry (const StampedJournalEntry& entry)
+    {
+        mJournal.push_back (entry);
+        mJournalInfos.insert (std::make_pair (entry.mTopic, entry.mInfoId));
+    }
+
     Topic& Journal::getTopic (const std::string& id)
     {
         TTopicContainer::iterator iter = mTopics.find (id);
@@ -73,19 +89,20 @@ namespace MWDialogue
         mJournal.clear();
         mQuests.clear();
         mTopics.clear();
+        mQuestNames.clear();
+        mJournalInfos.clear();
     }
 
     void Journal::addEntry (const std::string& id, int index)
     {
         // bail out of we already have heard this...
         std::string infoId = JournalEntry::idFromIndex (id, index);
-        for (TEntryIter i = mJournal.begin (); i != mJournal.end (); ++i)
-            if (i->mTopic == id && i->mInfoId == infoId)
-                return;
+        if (mJournalInfos.find (std::make_pair (id, infoId)) != mJournalInfos.end())
+            return;
 
         StampedJournalEntry entry = StampedJournalEntry::makeFromQuest (id, index);
 
-        mJournal.push_back (entry);
+        addJournalEntry (entry);
 
         Quest& quest = getQuest (id);
 
@@ -150,6 +167,16 @@ namespace MWDialogue
         return mQuests.end();
     }
 
+    Journal::TQuestNameIter Journal::questNameBegin() const
+    {
+        return mQuestNames.begin();
+    }
+
+    Journal::TQuestNameIter Journal::questNameEnd() const
+    {
+        return mQuestNames.end();
+    }
+
     Journal::TTopicIter Journal::topicBegin() const
     {
         return mTopics.begin();
@@ -160,6 +187,11 @@ namespace MWDialogue
         return mTopics.end();
     }
 
+    Journal::TTopicIter Journal::topicLowerBound (const std::string& topicId) const
+    {
+        return mTopics.lower_bound (topicId);
+    }
+
     int Journal::countSavedGameRecords() const
     {
         int count = static_cast<int> (mQuests.size());
@@ -243,7 +275,7 @@ namespace MWDialogue
 
                     case ESM::JournalEntry::Type_Journal:
 
-                        mJournal.push_back (record);
+                        addJournalEntry (record);
                         break;
 
                     case ESM::JournalEntry::Type_Topic:
@@ -260,6 +292,8 @@ namespace MWDialogue
             if (isThere (record.mTopic))
             {
                 std::pair<TQuestContainer::iterator, bool> result = mQuests.insert (std::make_pair (record.mTopic, record));
+                if (result.second)
+                    addQuestName (result.first->second);
                 // reapply quest index, this is to handle users upgrading from only
                 // Morrowind.esm (no quest states) to Morrowind.esm + Tribunal.esm
                 result.first->second.setIndex(record.mState);
@@ -1,6 +1,8 @@
 #ifndef GAME_MWDIALOG_JOURNAL_H
 #define GAME_MWDIALOG_JOURNAL_H
 
+#include <set>
+
 #include "../mwbase/journal.hpp"
 
 #include "journalentry.hpp"
@@ -15,8 +17,17 @@ namespace MWDialogue
             TQuestContainer mQuests;
             TTopicContainer mTopics;
 
+            TQuestNameContainer mQuestNames;
+
+            // The topic and info ID of each entry of the main journal
+            std::set<std::pair<std::string, std::string> > mJournalInfos;
+
         private:
 
+            void addQuestName (const Quest& quest);
+
+            void addJournalEntry (const StampedJournalEntry& entry);
+
             Quest& getQuest (const std::string& id);
 
             Topic& getTopic (const std::string& id);
@@ -59,6 +70,14 @@ namespace MWDialogue
             virtual TQuestIter questEnd() const;
             ///< Iterator pointing past the last quest.
 
+            virtual TQuestNameIter questNameBegin() const;
+            ///< Iterator pointing to the first quest name (sorted by name), with the quests that have this name
+            ///
+            /// \note Quests without a name are not listed, they do not appear in the quest book.
+
+            virtual TQuestNameIter questNameEnd() const;
+            ///< Iterator pointing past the last quest name.
+
             virtual TTopicIter topicBegin() const;
             ///< Iterator pointing to the first topic (sorted by topic ID)
             ///
@@ -67,6 +86,9 @@ namespace MWDialogue
             virtual TTopicIter topicEnd() const;
             ///< Iterator pointing past the last topic.
 
+            virtual TTopicIter topicLowerBound (const std::string& topicId) const;
+            ///< Iterator pointing to the first topic whose ID is not sorted before \a topicId.
+
             virtual int countSavedGameRecords() const;
 
             virtual void write (ESM::ESMWriter& writer, Loading::Listener& progress) const;
@@ -5,13 +5,16 @@
 #include <cctype>
 #include <stdexcept>
 #include <vector>
-#include <algorithm>    // std::reverse
+#include <algorithm>    // std::sort
 
 #include <components/misc/stringops.hpp>
 
 namespace MWDialogue
 {
 
+/// @brief Finds keywords in text, case-insensitively and only where a word starts.
+/// @note The keywords are lower-cased when seeded and kept in a trie of flat arrays, which is built again on the
+/// first search after seeding. Scanning text then only looks up each character in the children of the current node.
 template <typename string_t, typename value_t>
 class KeywordSearch
 {
@@ -26,46 +29,53 @@ public:
         value_t mValue;
     };
 
+    KeywordSearch () : mTrieValid (false) {}
+
     void seed (string_t keyword, value_t value)
     {
         if (keyword.empty())
             return;
-        seed_impl  (/*std::move*/ (keyword), /*std::move*/ (value), 0, mRoot);
+
+        string_t key = keyword;
+        for (typename string_t::iterator it = key.begin(); it != key.end(); ++it)
+            *it = Misc::StringUtils::toLower (*it);
+
+        typename Keywords::iterator found = mKeywords.find (key);
+        if (found != mKeywords.end())
+        {
+            if (found->second.mKeyword == keyword)
+                throw std::runtime_error ("duplicate keyword inserted");
+            // same keyword in a different case, the first one is kept
+            return;
+        }
+
+        Keyword& entry = mKeywords[key];
+        entry.mKeyword = /*std::move*/ (keyword);
+        entry.mValue = /*std::move*/ (value);
+
+        mTrieValid = false;
     }
 
     void clear ()
     {
-        mRoot.mChildren.clear ();
-        mRoot.mKeyword.clear ();
+        mKeywords.clear ();
+        mNodes.clear ();
+        mEdges.clear ();
+        mTrieValues.clear ();
+        mTrieValid = false;
     }
 
     bool containsKeyword (string_t keyword, value_t& value)
     {
-        typename Entry::childen_t::iterator current;
-        typename Entry::childen_t::iterator next;
+        for (typename string_t::iterator it = keyword.begin(); it != keyword.end(); ++it)
+            *it = Misc::StringUtils::toLower (*it);
 
-        current = mRoot.mChildren.find (Misc::StringUtils::toLower (*keyword.begin()));
-        if (current == mRoot.mChildren.end())
+        typename Keywords::const_iterator found = mKeywords.find (keyword);
+        if (found == mKeywords.end())
             return false;
-        else if (current->second.mKeyword.size() && Misc::StringUtils::ciEqual(current->second.mKeyword, keyword))
-        {
-            value = current->second.mValue;
-            return true;
-        }
 
-        for (Point i = ++keyword.begin(); i != keyword.end(); ++i)
-        {
-            next = current->second.mChildren.find(Misc::StringUtils::toLower (*i));
-            if (next == current->second.mChildren.end())
-                return false;
-            if (Misc::StringUtils::ciEqual(next->second.mKeyword, keyword))
-            {
-                value = next->second.mValue;
-                return true;
-            }
-            current = next;
-        }
-        return false;
+        value = found->second.mValue;
+        return true;
     }
 
     static bool sortMatches(const Match& left, const Match& right)
@@ -75,6 +85,9 @@ public:
 
     void highlightKeywords (Point beg, Point end, std::vector<Match>& out)
     {
+        if (!mTrieValid)
+            buildTrie ();
+
         std::vector<Match> matches;
         for (Point i = beg; i != end; ++i)
         {
@@ -87,74 +100,41 @@ public:
                     continue;
             }
 
-
-            // check first character
-            typename Entry::childen_t::iterator candidate = mRoot.mChildren.find (Misc::StringUtils::toLower (*i));
-
-            // no match, on to next character
-            if (candidate == mRoot.mChildren.end ())
+            // follow the text down the trie, remembering the longest keyword passed on the way
+            int node = mRootChildren[static_cast<unsigned char> (Misc::StringUtils::toLower (*i))];
+            if (node < 0)
                 continue;
 
-            // see how far the match goes
+            int keyword = -1;
+            Point keywordEnd = i;
             Point j = i;
-
-            // some keywords might be longer variations of other keywords, so we definitely need a list of candidates
-            // the first element in the pair is length of the match, i.e. depth from the first character on
-            std::vector< typename std::pair<int, typename Entry::childen_t::iterator> > candidates;
-
-            while ((j + 1) != end)
+            for (;;)
             {
-                typename Entry::childen_t::iterator next = candidate->second.mChildren.find (Misc::StringUtils::toLower (*++j));
-
-                if (next == candidate->second.mChildren.end ())
+                ++j;
+                if (mNodes[node].mKeyword >= 0)
                 {
-                    if (candidate->second.mKeyword.size() > 0)
-                        candidates.push_back(std::make_pair((j-i), candidate));
-                    break;
+                    keyword = mNodes[node].mKeyword;
+                    keywordEnd = j;
                 }
 
-                candidate = next;
+                if (j == end)
+                    break;
 
-                if (candidate->second.mKeyword.size() > 0)
-                    candidates.push_back(std::make_pair((j-i), candidate));
+                node = findChild (node, static_cast<unsigned char> (Misc::StringUtils::toLower (*j)));
+                if (node < 0)
+                    break;
             }
 
-            if (candidates.empty())
-                continue; // didn't match enough to disambiguate, on to next character
-
-            // shorter candidates will be added to the vector first. however, we want to check against longer candidates first
-            std::reverse(candidates.begin(), candidates.end());
-
-            for (typename std::vector< std::pair<int, typename Entry::childen_t::iterator> >::iterator it = candidates.begin();
-                 it != candidates.end(); ++it)
-            {
-                candidate = it->second;
-                // try to match the rest of the keyword
-                Point k = i + it->first;
-                typename string_t::const_iterator t = candidate->second.mKeyword.begin () + (k - i);
-
-
-                while (k != end && t != candidate->second.mKeyword.end ())
-                {
-                    if (Misc::StringUtils::toLower (*k) != Misc::StringUtils::toLower (*t))
-                        break;
-
-                    ++k, ++t;
-                }
-
-                // didn't match full keyword, try the next candidate
-                if (t != candidate->second.mKeyword.end ())
-                    continue;
+            if (keyword < 0)
+                continue;
 
-                // found a keyword, but there might still be longer keywords that start somewhere _within_ this keyword
-                // we will resolve these overlapping keywords later, choosing the longest one in case of conflict
-                Match match;
-                match.mValue = candidate->second.mValue;
-                match.mBeg = i;
-                match.mEnd = k;
-                matches.push_back(match);
-                break;
-            }
+            // found a keyword, but there might still be longer keywords that start somewhere _within_ this keyword
+            // we will resolve these overlapping keywords later, choosing the longest one in case of conflict
+            Match match;
+            match.mValue = mTrieValues[keyword];
+            match.mBeg = i;
+            match.mEnd = keywordEnd;
+            matches.push_back(match);
         }
 
         // resolve overlapping keywords
@@ -201,54 +181,162 @@ public:
 
 private:
 
-    struct Entry
+    struct Keyword
     {
-        typedef std::map <wchar_t, Entry> childen_t;
-
         string_t mKeyword;
         value_t mValue;
-        childen_t mChildren;
     };
 
-    void seed_impl (string_t keyword, value_t value, size_t depth, Entry  & entry)
+    // by the lower-cased keyword
+    typedef std::map <string_t, Keyword> Keywords;
+
+    struct Node
     {
-        int ch = Misc::StringUtils::toLower (keyword.at (depth));
+        // the children are mEdges [mFirstEdge, mFirstEdge + mEdgeCount), sorted by character
+        int mFirstEdge;
+        int mEdgeCount;
+        // index into mTrieValues of the keyword ending here, or -1
+        int mKeyword;
+    };
+
+    struct Edge
+    {
+        unsigned char mChar;
+        int mNode;
+    };
 
-        typename Entry::childen_t::iterator j = entry.mChildren.find (ch);
+    int findChild (int node, unsigned char ch) const
+    {
+        const Node& parent = mNodes[node];
+        int first = parent.mFirstEdge;
+        int last = first + parent.mEdgeCount;
 
-        if (j == entry.mChildren.end ())
+        // the lower-cased keywords rarely branch much, except near the root
+        while (last - first > 8)
         {
-            entry.mChildren [ch].mValue = /*std::move*/ (value);
-            entry.mChildren [ch].mKeyword = /*std::move*/ (keyword);
+            int middle = (first + last) / 2;
+            if (mEdges[middle].mChar < ch)
+                first = middle + 1;
+            else
+                last = middle;
         }
-        else
+        for (; first < last; ++first)
         {
-            if (j->second.mKeyword.size () > 0)
-            {
-                if (keyword == j->second.mKeyword)
-                    throw std::runtime_error ("duplicate keyword inserted");
+            if (mEdges[first].mChar == ch)
+                return mEdges[first].mNode;
+            if (mEdges[first].mChar > ch)
+                break;
+        }
+        return -1;
+    }
 
-                value_t pushValue = /*std::move*/ (j->second.mValue);
-                string_t pushKeyword = /*std::move*/ (j->second.mKeyword);
+    typedef std::pair<const string_t*, const Keyword*> Key;
 
-                if (depth >= pushKeyword.size ())
-                    throw std::runtime_error ("unexpected");
+    // by the unsigned value of the characters, the order of the edges
+    static bool compareKeys (const Key& left, const Key& right)
+    {
+        return std::lexicographical_compare (left.first->begin(), left.first->end(),
+            right.first->begin(), right.first->end(), compareChars);
+    }
 
-                if (depth+1 < pushKeyword.size())
-                {
-                    seed_impl (/*std::move*/ (pushKeyword), /*std::move*/ (pushValue), depth+1, j->second);
-                    j->second.mKeyword.clear ();
-                }
+    static bool compareChars (char left, char right)
+    {
+        return static_cast<unsigned char> (left) < static_cast<unsigned char> (right);
+    }
+
+    void buildTrie ()
+    {
+        mNodes.clear ();
+        mEdges.clear ();
+        mTrieValues.clear ();
+
+        std::vector<Key> sortedKeys;
+        sortedKeys.reserve (mKeywords.size ());
+        for (typename Keywords::const_iterator it = mKeywords.begin(); it != mKeywords.end(); ++it)
+            sortedKeys.push_back (Key (&it->first, &it->second));
+        std::sort (sortedKeys.begin (), sortedKeys.end (), compareKeys);
+
+        std::vector<const string_t*> keys;
+        keys.reserve (sortedKeys.size ());
+        for (typename std::vector<Key>::const_iterator it = sortedKeys.begin(); it != sortedKeys.end(); ++it)
+        {
+            keys.push_back (it->first);
+            mTrieValues.push_back (it->second->mValue);
+        }
+
+        std::fill (mRootChildren, mRootChildren + 256, -1);
+
+        // the keys are sorted, so the keys below each node are a contiguous range
+        size_t begin = 0;
+        while (begin < keys.size ())
+        {
+            unsigned char ch = static_cast<unsigned char> ((*keys[begin])[0]);
+            size_t end = begin + 1;
+            while (end < keys.size () && static_cast<unsigned char> ((*keys[end])[0]) == ch)
+                ++end;
+
+            mRootChildren[ch] = addNode ();
+            buildNode (mRootChildren[ch], keys, begin, end, 1);
+            begin = end;
+        }
+
+        mTrieValid = true;
+    }
+
+    int addNode ()
+    {
+        Node node;
+        node.mFirstEdge = 0;
+        node.mEdgeCount = 0;
+        node.mKeyword = -1;
+        mNodes.push_back (node);
+        return static_cast<int> (mNodes.size ()) - 1;
+    }
+
+    /// @param begin, end Range of the keys starting with the \a depth characters that lead to \a node
+    void buildNode (int node, const std::vector<const string_t*>& keys, size_t begin, size_t end, size_t depth)
+    {
+        if (keys[begin]->size () == depth)
+            mNodes[node].mKeyword = static_cast<int> (begin++);
+
+        // reserve the edges of this node first, so they are contiguous
+        int firstEdge = static_cast<int> (mEdges.size ());
+        for (size_t i = begin; i < end; ++i)
+        {
+            unsigned char ch = static_cast<unsigned char> ((*keys[i])[depth]);
+            if (i == begin || ch != mEdges.back ().mChar)
+            {
+                Edge edge;
+                edge.mChar = ch;
+                edge.mNode = -1;
+                mEdges.push_back (edge);
             }
-            if (depth+1 == keyword.size())
-                j->second.mKeyword = value;
-            else // depth+1 < keyword.size()
-                seed_impl (/*std::move*/ (keyword), /*std::move*/ (value), depth+1, j->second);
         }
+        mNodes[node].mFirstEdge = firstEdge;
+        mNodes[node].mEdgeCount = static_cast<int> (mEdges.size ()) - firstEdge;
 
+        int edge = firstEdge;
+        while (begin < end)
+        {
+            unsigned char ch = static_cast<unsigned char> ((*keys[begin])[depth]);
+            size_t childEnd = begin + 1;
+            while (childEnd < end && static_cast<unsigned char> ((*keys[childEnd])[depth]) == ch)
+                ++childEnd;
+
+            int child = addNode ();
+            mEdges[edge++].mNode = child;
+            buildNode (child, keys, begin, childEnd, depth + 1);
+            begin = childEnd;
+        }
     }
 
-    Entry mRoot;
+    Keywords mKeywords;
+
+    bool mTrieValid;
+    int mRootChildren[256];
+    std::vector<Node> mNodes;
+    std::vector<Edge> mEdges;
+    std::vector<value_t> mTrieValues;
 };
 
 }
@@ -20,13 +20,15 @@
 #include <components/compiler/scriptparser.hpp>
 
 #include "filter.hpp"
+#include "infoconditions.hpp"
 
 namespace
 {
 
 void test(const MWWorld::Ptr& actor, int &compiled, int &total, const Compiler::Extensions* extensions, int warningsMode)
 {
-    MWDialogue::Filter filter(actor, 0, false);
+    MWDialogue::InfoConditions conditions;
+    MWDialogue::Filter filter(actor, 0, false, conditions);
 
     MWScript::CompilerContext compilerContext(MWScript::CompilerContext::Type_Dialogue);
     compilerContext.setExtensions(extensions);
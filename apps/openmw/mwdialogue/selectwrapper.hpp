@@ -1,14 +1,15 @@
 #ifndef GAME_MWDIALOGUE_SELECTWRAPPER_H
 #define GAME_MWDIALOGUE_SELECTWRAPPER_H
 
+#include <string>
+
 #include <components/esm/loadinfo.hpp>
 
 namespace MWDialogue
 {
+    /// @brief A select rule of a dialogue response, decoded once.
     class SelectWrapper
     {
-            const ESM::DialInfo::SelectStruct& mSelect;
-
         public:
 
             enum Function
@@ -57,7 +58,26 @@ namespace MWDialogue
 
         private:
 
-            Function decodeFunction() const;
+            Function mFunction;
+            Type mType;
+            int mArgument;
+            bool mNpcOnly;
+            char mComparison;
+            ESM::VarType mValueType;
+            int mIntValue;
+            float mFloatValue;
+            std::string mName;
+
+            static Function decodeFunction (int index);
+
+            static int decodeArgument (int index);
+
+            Type decodeType() const;
+
+            bool decodeNpcOnly() const;
+
+            template<typename T>
+            bool selectCompareImp (T value) const;
 
         public:
 
@@ -78,7 +98,7 @@ namespace MWDialogue
 
             bool selectCompare (bool value) const;
 
-            std::string getName() const;
+            const std::string& getName() const;
             ///< Return case-smashed name.
     };
 }
@@ -253,11 +253,19 @@ struct TypesetBookImpl::Typesetter : BookTypesetter
     Book::Content const * mCurrentContent;
     Alignment mCurrentAlignment;
 
+    // State of the pagination before the last section of the previous complete (), which is where the next one
+    // resumes, as more text may have been added to that section since.
+    size_t mPagedSections;
+    size_t mPagedPages;
+    int mPagedStart;
+    int mPagedStop;
+
     Typesetter (size_t width, size_t height) :
         mPageWidth (width), mPageHeight(height),
         mSection (NULL), mLine (NULL), mRun (NULL),
         mCurrentContent (NULL),
-        mCurrentAlignment (AlignLeft)
+        mCurrentAlignment (AlignLeft),
+        mPagedSections (0), mPagedPages (0), mPagedStart (0), mPagedStop (0)
     {
         mBook = boost::make_shared <Book> ();
     }
@@ -380,14 +388,23 @@ struct TypesetBookImpl::Typesetter : BookTypesetter
 
     TypesetBook::Ptr complete ()
     {
-        int curPageStart = 0;
-        int curPageStop  = 0;
-
         add_partial_text();
 
-        std::vector <Alignment>::iterator sa = mSectionAlignment.begin ();
-        for (Sections::iterator i = mBook->mSections.begin (); i != mBook->mSections.end (); ++i, ++sa)
+        mBook->mPages.resize (mPagedPages);
+        int curPageStart = mPagedStart;
+        int curPageStop  = mPagedStop;
+
+        std::vector <Alignment>::iterator sa = mSectionAlignment.begin () + mPagedSections;
+        for (Sections::iterator i = mBook->mSections.begin () + mPagedSections; i != mBook->mSections.end (); ++i, ++sa)
         {
+            if (i + 1 == mBook->mSections.end ())
+            {
+                mPagedSections = i - mBook->mSections.begin ();
+                mPagedPages = mBook->mPages.size ();
+                mPagedStart = curPageStart;
+                mPagedStop = curPageStop;
+            }
+
             // apply alignment to individual lines...
             for (Lines::iterator j = i->mLines.begin (); j != i->mLines.end (); ++j)
             {
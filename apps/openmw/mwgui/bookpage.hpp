@@ -92,6 +92,8 @@ namespace MWGui
         virtual void write (Style * Style, size_t Begin, size_t End) = 0;
 
         /// Finalize the document layout, and return a pointer to it.
+        /// \note More text may be written afterwards and complete () called again, which returns the same book
+        /// with only the new text paginated.
         virtual TypesetBook::Ptr complete () = 0;
     };
 
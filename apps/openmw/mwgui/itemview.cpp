@@ -20,6 +20,10 @@ namespace MWGui
 ItemView::ItemView()
     : mModel(NULL)
     , mScrollView(NULL)
+    , mDragArea(NULL)
+    , mRows(1)
+    , mFirstItem(0)
+    , mItemCount(0)
 {
 }
 
@@ -48,39 +52,39 @@ void ItemView::initialiseOverride()
         throw std::runtime_error("Item view needs a scroll view");
 
     mScrollView->setCanvasAlign(MyGUI::Align::Left | MyGUI::Align::Top);
+
+    // The scroll view has no event for its scroll bars, so check its offset each frame
+    MyGUI::Gui::getInstance().eventFrameStart += MyGUI::newDelegate(this, &ItemView::onFrame);
+}
+
+void ItemView::shutdownOverride()
+{
+    MyGUI::Gui::getInstance().eventFrameStart -= MyGUI::newDelegate(this, &ItemView::onFrame);
+
+    mItemWidgets.clear();
+    mDragArea = NULL;
+
+    Base::shutdownOverride();
 }
 
 void ItemView::layoutWidgets()
 {
-    if (!mScrollView->getChildCount())
+    if (!mDragArea)
         return;
 
-    int x = 0;
-    int y = 0;
-    MyGUI::Widget* dragArea = mScrollView->getChildAt(0);
+    int count = mModel ? static_cast<int>(mModel->getItemCount()) : 0;
     int maxHeight = mScrollView->getHeight();
 
     int rows = maxHeight/42;
     rows = std::max(rows, 1);
-    bool showScrollbar = int(std::ceil(dragArea->getChildCount()/float(rows))) > mScrollView->getWidth()/42;
+    bool showScrollbar = int(std::ceil(count/float(rows))) > mScrollView->getWidth()/42;
     if (showScrollbar)
         maxHeight -= 18;
 
-    for (unsigned int i=0; i<dragArea->getChildCount(); ++i)
-    {
-        MyGUI::Widget* w = dragArea->getChildAt(i);
-
-        w->setPosition(x, y);
-
-        y += 42;
-
-        if (y > maxHeight-42 && i < dragArea->getChildCount()-1)
-        {
-            x += 42;
-            y = 0;
-        }
-    }
-    x += 42;
+    // Items are placed in columns from top to bottom
+    mRows = std::max(maxHeight/42, 1);
+    int columns = std::max((count + mRows - 1) / mRows, 1);
+    int x = columns * 42;
 
     MyGUI::IntSize size = MyGUI::IntSize(std::max(mScrollView->getSize().width, x), mScrollView->getSize().height);
 
@@ -90,33 +94,51 @@ void ItemView::layoutWidgets()
     mScrollView->setCanvasSize(size);
     mScrollView->setVisibleVScroll(true);
     mScrollView->setVisibleHScroll(true);
-    dragArea->setSize(size);
+    mDragArea->setSize(size);
+
+    updateVisibleItems(true);
 }
 
-void ItemView::update()
+void ItemView::updateVisibleItems(bool force)
 {
-    while (mScrollView->getChildCount())
-        MyGUI::Gui::getInstance().destroyWidget(mScrollView->getChildAt(0));
+    mViewOffset = mScrollView->getViewOffset();
 
-    if (!mModel)
-        return;
-
-    mModel->update();
+    int count = mModel ? static_cast<int>(mModel->getItemCount()) : 0;
+    // Include the partially visible columns on either side
+    int firstColumn = std::max(-mViewOffset.left, 0) / 42;
+    int columns = mScrollView->getWidth() / 42 + 2;
+    int first = std::min(firstColumn * mRows, count);
+    int end = std::min((firstColumn + columns) * mRows, count);
 
-    MyGUI::Widget* dragArea = mScrollView->createWidget<MyGUI::Widget>("",0,0,mScrollView->getWidth(),mScrollView->getHeight(),
-                                                                       MyGUI::Align::Stretch);
-    dragArea->setNeedMouseFocus(true);
-    dragArea->eventMouseButtonClick += MyGUI::newDelegate(this, &ItemView::onSelectedBackground);
-    dragArea->eventMouseWheel += MyGUI::newDelegate(this, &ItemView::onMouseWheelMoved);
+    if (!force && first == mFirstItem && end - first == mItemCount)
+        return;
+    mFirstItem = first;
+    mItemCount = end - first;
 
-    for (ItemModel::ModelIndex i=0; i<static_cast<int>(mModel->getItemCount()); ++i)
+    while (static_cast<int>(mItemWidgets.size()) < mItemCount)
     {
-        const ItemStack& item = mModel->getItem(i);
-
-        ItemWidget* itemWidget = dragArea->createWidget<ItemWidget>("MW_ItemIcon",
+        ItemWidget* itemWidget = mDragArea->createWidget<ItemWidget>("MW_ItemIcon",
             MyGUI::IntCoord(0, 0, 42, 42), MyGUI::Align::Default);
         itemWidget->setUserString("ToolTipType", "ItemModelIndex");
-        itemWidget->setUserData(std::make_pair(i, mModel));
+        itemWidget->eventMouseButtonClick += MyGUI::newDelegate(this, &ItemView::onSelectedItem);
+        itemWidget->eventMouseWheel += MyGUI::newDelegate(this, &ItemView::onMouseWheelMoved);
+        mItemWidgets.push_back(itemWidget);
+    }
+
+    for (int i=0; i<static_cast<int>(mItemWidgets.size()); ++i)
+    {
+        ItemWidget* itemWidget = mItemWidgets[i];
+        if (i >= mItemCount)
+        {
+            itemWidget->setVisible(false);
+            continue;
+        }
+
+        ItemModel::ModelIndex index = mFirstItem + i;
+        const ItemStack& item = mModel->getItem(index);
+
+        itemWidget->setPosition(index / mRows * 42, index % mRows * 42);
+        itemWidget->setUserData(std::make_pair(index, mModel));
         ItemWidget::ItemState state = ItemWidget::None;
         if (item.mType == ItemStack::Type_Barter)
             state = ItemWidget::Barter;
@@ -124,14 +146,33 @@ void ItemView::update()
             state = ItemWidget::Equip;
         itemWidget->setItem(item.mBase, state);
         itemWidget->setCount(item.mCount);
+        itemWidget->setVisible(true);
+    }
+}
 
-        itemWidget->eventMouseButtonClick += MyGUI::newDelegate(this, &ItemView::onSelectedItem);
-        itemWidget->eventMouseWheel += MyGUI::newDelegate(this, &ItemView::onMouseWheelMoved);
+void ItemView::update()
+{
+    if (mModel)
+        mModel->update();
+
+    if (!mDragArea)
+    {
+        mDragArea = mScrollView->createWidget<MyGUI::Widget>("",0,0,mScrollView->getWidth(),mScrollView->getHeight(),
+                                                             MyGUI::Align::Stretch);
+        mDragArea->setNeedMouseFocus(true);
+        mDragArea->eventMouseButtonClick += MyGUI::newDelegate(this, &ItemView::onSelectedBackground);
+        mDragArea->eventMouseWheel += MyGUI::newDelegate(this, &ItemView::onMouseWheelMoved);
     }
 
     layoutWidgets();
 }
 
+void ItemView::onFrame(float dt)
+{
+    if (mDragArea && mScrollView->getViewOffset() != mViewOffset)
+        updateVisibleItems(false);
+}
+
 void ItemView::resetScrollBars()
 {
     mScrollView->setViewOffset(MyGUI::IntPoint(0, 0));
@@ -1,12 +1,15 @@
 #ifndef MWGUI_ITEMVIEW_H
 #define MWGUI_ITEMVIEW_H
 
+#include <vector>
+
 #include <MyGUI_Widget.h>
 
 #include "itemmodel.hpp"
 
 namespace MWGui
 {
+    class ItemWidget;
 
     class ItemView : public MyGUI::Widget
     {
@@ -34,9 +37,16 @@ namespace MWGui
 
     private:
         virtual void initialiseOverride();
+        virtual void shutdownOverride();
 
         void layoutWidgets();
 
+        /// Show the items of the visible columns, on as many widgets as needed. The widgets are kept and reused,
+        /// so large models only cost widgets for what fits in the view.
+        void updateVisibleItems(bool force);
+
+        void onFrame(float dt);
+
         virtual void setSize(const MyGUI::IntSize& _value);
         virtual void setCoord(const MyGUI::IntCoord& _value);
 
@@ -46,6 +56,14 @@ namespace MWGui
 
         ItemModel* mModel;
         MyGUI::ScrollView* mScrollView;
+        MyGUI::Widget* mDragArea;
+
+        std::vector<ItemWidget*> mItemWidgets;
+        int mRows;
+        // Range of the shown items for the current view offset
+        int mFirstItem;
+        int mItemCount;
+        MyGUI::IntPoint mViewOffset;
 
     };
 
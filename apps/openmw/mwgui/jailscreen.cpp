@@ -80,8 +80,7 @@ namespace MWGui
         MWWorld::Ptr player = MWMechanics::getPlayer();
 
         MWBase::Environment::get().getWorld()->advanceTime(mDays * 24);
-        for (int i=0; i<mDays*24; ++i)
-            MWBase::Environment::get().getMechanicsManager()->rest(true);
+        MWBase::Environment::get().getMechanicsManager()->rest(mDays * 24, true);
 
         std::set<int> skills;
         for (int day=0; day<mDays; ++day)
@@ -156,7 +156,7 @@ MWGui::BookTypesetter::Utf8Span to_utf8_span (char const * text)
 typedef TypesetBook::Ptr book;
 
 JournalBooks::JournalBooks (JournalViewModel::Ptr model) :
-    mModel (model)
+    mModel (model), mJournalHeaderStyle (NULL), mJournalBodyStyle (NULL), mJournalEntryCount (0), mJournalTopicCount (0)
 {
 }
 
@@ -176,14 +176,39 @@ book JournalBooks::createEmptyJournalBook ()
 
 book JournalBooks::createJournalBook ()
 {
-    BookTypesetter::Ptr typesetter = createTypesetter ();
+    size_t entryCount = mModel->getJournalEntryCount ();
+    size_t topicCount = mModel->getTopicCount ();
 
-    BookTypesetter::Style* header = typesetter->createStyle ("", MyGUI::Colour (0.60f, 0.00f, 0.00f));
-    BookTypesetter::Style* body   = typesetter->createStyle ("", MyGUI::Colour::Black);
+    if (!mJournalTypesetter || entryCount < mJournalEntryCount || topicCount != mJournalTopicCount)
+    {
+        clearJournalBook ();
 
-    mModel->visitJournalEntries ("", AddJournalEntry (typesetter, body, header, true));
+        mJournalTypesetter = createTypesetter ();
+        mJournalHeaderStyle = mJournalTypesetter->createStyle ("", MyGUI::Colour (0.60f, 0.00f, 0.00f));
+        mJournalBodyStyle   = mJournalTypesetter->createStyle ("", MyGUI::Colour::Black);
+        mJournalTopicCount = topicCount;
+    }
 
-    return typesetter->complete ();
+    if (!mJournalBook || entryCount != mJournalEntryCount)
+    {
+        mModel->visitJournalEntriesFrom (mJournalEntryCount,
+            AddJournalEntry (mJournalTypesetter, mJournalBodyStyle, mJournalHeaderStyle, true));
+        mJournalEntryCount = entryCount;
+
+        mJournalBook = mJournalTypesetter->complete ();
+    }
+
+    return mJournalBook;
+}
+
+void JournalBooks::clearJournalBook ()
+{
+    mJournalTypesetter.reset ();
+    mJournalHeaderStyle = NULL;
+    mJournalBodyStyle = NULL;
+    mJournalEntryCount = 0;
+    mJournalTopicCount = 0;
+    mJournalBook.reset ();
 }
 
 book JournalBooks::createTopicBook (uintptr_t topicId)
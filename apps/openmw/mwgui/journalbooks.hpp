@@ -16,14 +16,26 @@ namespace MWGui
         JournalBooks (JournalViewModel::Ptr model);
 
         Book createEmptyJournalBook ();
+        /// The book of all entries is kept, and only entries added since are typeset when it is created again,
+        /// unless topics were added, which may highlight other text.
         Book createJournalBook ();
         Book createTopicBook (uintptr_t topicId);
         Book createTopicBook (const std::string& topicId);
         Book createQuestBook (const std::string& questName);
         Book createTopicIndexBook ();
 
+        /// Forget the kept book of all entries, for a new game.
+        void clearJournalBook ();
+
     private:
         BookTypesetter::Ptr createTypesetter ();
+
+        BookTypesetter::Ptr mJournalTypesetter;
+        BookTypesetter::Style* mJournalHeaderStyle;
+        BookTypesetter::Style* mJournalBodyStyle;
+        size_t mJournalEntryCount;
+        size_t mJournalTopicCount;
+        Book mJournalBook;
     };
 }
 
@@ -1,5 +1,7 @@
 #include "journalviewmodel.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <map>
 #include <sstream>
 #include <boost/make_shared.hpp>
@@ -199,38 +201,25 @@ struct JournalViewModelImpl : JournalViewModel
     {
         MWBase::Journal * journal = MWBase::Environment::get ().getJournal ();
 
-        std::set<std::string> visitedQuests;
-
         // Note that for purposes of the journal GUI, quests are identified by the name, not the ID, so several
         // different quest IDs can end up in the same quest log. A quest log should be considered finished
         // when any quest ID in that log is finished.
-        for (MWBase::Journal::TQuestIter i = journal->questBegin (); i != journal->questEnd (); ++i)
+        for (MWBase::Journal::TQuestNameIter i = journal->questNameBegin (); i != journal->questNameEnd (); ++i)
         {
-            const MWDialogue::Quest& quest = i->second;
-
             bool isFinished = false;
-            for (MWBase::Journal::TQuestIter j = journal->questBegin (); j != journal->questEnd (); ++j)
+            for (std::vector<const MWDialogue::Quest*>::const_iterator j = i->second.begin (); j != i->second.end (); ++j)
             {
-                if (quest.getName() == j->second.getName() && j->second.isFinished())
+                if ((*j)->isFinished())
+                {
                     isFinished = true;
+                    break;
+                }
             }
 
             if (active_only && isFinished)
                 continue;
 
-            // Unfortunately Morrowind.esm has no quest names, since the quest book was added with tribunal.
-            // Note that even with Tribunal, some quests still don't have quest names. I'm assuming those are not supposed
-            // to appear in the quest book.
-            if (!quest.getName().empty())
-            {
-                // Don't list the same quest name twice
-                if (visitedQuests.find(quest.getName()) != visitedQuests.end())
-                    continue;
-
-                visitor (quest.getName(), isFinished);
-
-                visitedQuests.insert(quest.getName());
-            }
+            visitor (i->first, isFinished);
         }
     }
 
@@ -276,24 +265,22 @@ struct JournalViewModelImpl : JournalViewModel
 
         if (!questName.empty())
         {
-            std::vector<MWDialogue::Quest const*> quests;
-            for (MWBase::Journal::TQuestIter questIt = journal->questBegin(); questIt != journal->questEnd(); ++questIt)
+            // The info IDs of the entries of all quests with this name
+            std::set<std::string> infoIds;
+            for (MWBase::Journal::TQuestNameIter questIt = journal->questNameBegin(); questIt != journal->questNameEnd(); ++questIt)
             {
-                if (Misc::StringUtils::ciEqual(questIt->second.getName(), questName))
-                    quests.push_back(&questIt->second);
+                if (!Misc::StringUtils::ciEqual(questIt->first, questName))
+                    continue;
+
+                for (std::vector<const MWDialogue::Quest*>::const_iterator quest = questIt->second.begin(); quest != questIt->second.end(); ++quest)
+                    for (MWDialogue::Topic::TEntryIter j = (*quest)->begin (); j != (*quest)->end (); ++j)
+                        infoIds.insert(j->mInfoId);
             }
 
             for(MWBase::Journal::TEntryIter i = journal->begin(); i != journal->end (); ++i)
             {
-                for (std::vector<MWDialogue::Quest const*>::iterator questIt = quests.begin(); questIt != quests.end(); ++questIt)
-                {
-                    MWDialogue::Quest const* quest = *questIt;
-                    for (MWDialogue::Topic::TEntryIter j = quest->begin (); j != quest->end (); ++j)
-                    {
-                        if (i->mInfoId == j->mInfoId)
-                            visitor (JournalEntryImpl <MWBase::Journal::TEntryIter> (this, i));
-                    }
-                }
+                if (infoIds.find(i->mInfoId) != infoIds.end())
+                    visitor (JournalEntryImpl <MWBase::Journal::TEntryIter> (this, i));
             }
         }
         else
@@ -303,6 +290,30 @@ struct JournalViewModelImpl : JournalViewModel
         }
     }
 
+    void visitJournalEntriesFrom (size_t first, boost::function <void (JournalEntry const &)> visitor) const
+    {
+        MWBase::Journal * journal = MWBase::Environment::get().getJournal();
+
+        MWBase::Journal::TEntryIter i = journal->begin();
+        std::advance (i, std::min (first, getJournalEntryCount ()));
+        for(; i != journal->end (); ++i)
+            visitor (JournalEntryImpl <MWBase::Journal::TEntryIter> (this, i));
+    }
+
+    size_t getJournalEntryCount () const
+    {
+        MWBase::Journal * journal = MWBase::Environment::get().getJournal();
+
+        return std::distance (journal->begin (), journal->end ());
+    }
+
+    size_t getTopicCount () const
+    {
+        MWBase::Journal * journal = MWBase::Environment::get().getJournal();
+
+        return std::distance (journal->topicBegin (), journal->topicEnd ());
+    }
+
     void visitTopicName (TopicId topicId, boost::function <void (Utf8Span)> visitor) const
     {
         MWDialogue::Topic const & topic = * reinterpret_cast <MWDialogue::Topic const *> (topicId);
@@ -313,11 +324,11 @@ struct JournalViewModelImpl : JournalViewModel
     {
         MWBase::Journal * journal = MWBase::Environment::get().getJournal();
 
-        for (MWBase::Journal::TTopicIter i = journal->topicBegin (); i != journal->topicEnd (); ++i)
+        // The topic IDs are lower case and sorted, so the topics starting with the character follow each other
+        const char lowerCharacter = Misc::StringUtils::toLower(character);
+        for (MWBase::Journal::TTopicIter i = journal->topicLowerBound (std::string(1, lowerCharacter));
+             i != journal->topicEnd () && i->first [0] == lowerCharacter; ++i)
         {
-            if (i->first [0] != Misc::StringUtils::toLower(character))
-                continue;
-
             visitor (i->second.getName());
         }
 
@@ -74,6 +74,15 @@ namespace MWGui
         /// If \a questName is empty, simply visits all journal entries
         virtual void visitJournalEntries (const std::string& questName, boost::function <void (JournalEntry const &)> visitor) const = 0;
 
+        /// walks over all journal entries, after the first \a first ones
+        virtual void visitJournalEntriesFrom (size_t first, boost::function <void (JournalEntry const &)> visitor) const = 0;
+
+        /// returns the number of journal entries, which are only ever added to the end
+        virtual size_t getJournalEntryCount () const = 0;
+
+        /// returns the number of known topics, which decide the hyperlinks in the text of the entries
+        virtual size_t getTopicCount () const = 0;
+
         /// provides the name of the topic specified by its id
         virtual void visitTopicName (TopicId topicId, boost::function <void (Utf8Span)> visitor) const = 0;
 
@@ -255,6 +255,11 @@ namespace
             mTopicIndexBook.reset ();
         }
 
+        void clear ()
+        {
+            clearJournalBook ();
+        }
+
         void setVisible (bool newValue)
         {
             WindowBase::setVisible (newValue);
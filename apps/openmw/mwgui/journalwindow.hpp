@@ -19,6 +19,9 @@ namespace MWGui
 
         /// show/hide the journal window
         virtual void setVisible (bool newValue) = 0;
+
+        /// forget the typeset journal, for a new game
+        virtual void clear () = 0;
     };
 }
 
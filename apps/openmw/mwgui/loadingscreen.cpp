@@ -1,7 +1,14 @@
 #include "loadingscreen.hpp"
 
+#include <algorithm>
+#include <limits>
+
+#include <OpenThreads/Thread>
+
 #include <osgViewer/Viewer>
 
+#include <osgUtil/IncrementalCompileOperation>
+
 #include <osg/Texture2D>
 
 #include <MyGUI_RenderManager.h>
@@ -38,6 +45,9 @@ namespace MWGui
         , mLoadingOnTime(0.0)
         , mImportantLabel(false)
         , mProgress(0)
+        , mCompileMaxObjects(0)
+        , mCompileTargetFrameRate(0.0)
+        , mCompileMinimumTime(0.0)
     {
         mMainWidget->setSize(MyGUI::RenderManager::getInstance().getViewSize());
 
@@ -130,10 +140,17 @@ namespace MWGui
         if (mMainWidget->getVisible())
             return;
 
-        if (mViewer->getIncrementalCompileOperation())
+        if (osgUtil::IncrementalCompileOperation* ico = mViewer->getIncrementalCompileOperation())
         {
-            mViewer->getIncrementalCompileOperation()->setMaximumNumOfObjectsToCompilePerFrame(100);
-            mViewer->getIncrementalCompileOperation()->setTargetFrameRate(mTargetFrameRate);
+            mCompileMaxObjects = ico->getMaximumNumOfObjectsToCompilePerFrame();
+            mCompileTargetFrameRate = ico->getTargetFrameRate();
+            mCompileMinimumTime = ico->getMinimumTimeAvailableForGLCompileAndDeletePerFrame();
+
+            // Limited by time rather than by the number of objects, the loading screen leaves most of each frame
+            // to compiling
+            ico->setMaximumNumOfObjectsToCompilePerFrame(std::numeric_limits<unsigned int>::max());
+            ico->setTargetFrameRate(mTargetFrameRate);
+            ico->setMinimumTimeAvailableForGLCompileAndDeletePerFrame(0.5 / mTargetFrameRate);
         }
 
         bool showWallpaper = (MWBase::Environment::get().getStateManager()->getState()
@@ -195,6 +212,16 @@ namespace MWGui
         //std::cout << "loading took " << mTimer.time_m() - mLoadingOnTime << std::endl;
         setVisible(false);
 
+        if (osgUtil::IncrementalCompileOperation* ico = mViewer->getIncrementalCompileOperation())
+        {
+            if (mCompileMaxObjects > 0)
+            {
+                ico->setMaximumNumOfObjectsToCompilePerFrame(mCompileMaxObjects);
+                ico->setTargetFrameRate(mCompileTargetFrameRate);
+                ico->setMinimumTimeAvailableForGLCompileAndDeletePerFrame(mCompileMinimumTime);
+            }
+        }
+
         MWBase::Environment::get().getWindowManager()->removeGuiMode(GM_Loading);
         MWBase::Environment::get().getWindowManager()->removeGuiMode(GM_LoadingWallpaper);
     }
@@ -242,6 +269,17 @@ namespace MWGui
         draw();
     }
 
+    void LoadingScreen::idle()
+    {
+        draw();
+
+        // Sleep until the next frame is due, at least a millisecond when nothing was drawn, rather than taking time
+        // from the threads doing the work
+        double frameTime = 1000.0 / mTargetFrameRate;
+        double wait = mLastRenderTime + frameTime - mTimer.time_m();
+        OpenThreads::Thread::microSleep(static_cast<unsigned int>(std::max(1.0, std::min(frameTime, wait)) * 1000.0));
+    }
+
     bool LoadingScreen::needToDrawLoadingScreen()
     {
         if ( mTimer.time_m() <= mLastRenderTime + (1.0/mTargetFrameRate) * 1000.0)
@@ -269,7 +307,8 @@ namespace MWGui
 
     void LoadingScreen::draw()
     {
-        if (!needToDrawLoadingScreen())
+        // Nothing to draw with when running headless
+        if (!mViewer->isRealized() || !needToDrawLoadingScreen())
             return;
 
         bool showWallpaper = (MWBase::Environment::get().getStateManager()->getState()
@@ -40,6 +40,7 @@ namespace MWGui
         virtual void setProgressRange (size_t range);
         virtual void setProgress (size_t value);
         virtual void increaseProgress (size_t increase=1);
+        virtual void idle();
 
         virtual void setVisible(bool visible);
 
@@ -61,6 +62,11 @@ namespace MWGui
 
         size_t mProgress;
 
+        // The settings of the IncrementalCompileOperation outside of loading screens
+        unsigned int mCompileMaxObjects;
+        double mCompileTargetFrameRate;
+        double mCompileMinimumTime;
+
         MyGUI::Widget* mLoadingBox;
 
         MyGUI::TextBox* mLoadingText;
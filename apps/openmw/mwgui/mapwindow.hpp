@@ -181,7 +181,8 @@ namespace MWGui
     class MapWindow : public MWGui::WindowPinnableBase, public LocalMapBase, public NoDrop
     {
     public:
-        MapWindow(CustomMarkerCollection& customMarkers, DragAndDrop* drag, MWRender::LocalMap* localMapRender);
+        /// @param cachePath Where to cache the global map, see MWRender::GlobalMap.
+        MapWindow(CustomMarkerCollection& customMarkers, DragAndDrop* drag, MWRender::LocalMap* localMapRender, const std::string& cachePath);
         virtual ~MapWindow();
 
         void setCellName(const std::string& cellName);
@@ -20,47 +20,53 @@
 
 namespace
 {
-    bool compareType(const std::string& type1, const std::string& type2)
+    int getTypeOrder(const std::string& type)
     {
         // this defines the sorting order of types. types that are first in the vector appear before other types.
-        std::vector<std::string> mapping;
-        mapping.push_back( typeid(ESM::Weapon).name() );
-        mapping.push_back( typeid(ESM::Armor).name() );
-        mapping.push_back( typeid(ESM::Clothing).name() );
-        mapping.push_back( typeid(ESM::Potion).name() );
-        mapping.push_back( typeid(ESM::Ingredient).name() );
-        mapping.push_back( typeid(ESM::Apparatus).name() );
-        mapping.push_back( typeid(ESM::Book).name() );
-        mapping.push_back( typeid(ESM::Light).name() );
-        mapping.push_back( typeid(ESM::Miscellaneous).name() );
-        mapping.push_back( typeid(ESM::Lockpick).name() );
-        mapping.push_back( typeid(ESM::Repair).name() );
-        mapping.push_back( typeid(ESM::Probe).name() );
-
-        assert( std::find(mapping.begin(), mapping.end(), type1) != mapping.end() );
-        assert( std::find(mapping.begin(), mapping.end(), type2) != mapping.end() );
-
-        return std::find(mapping.begin(), mapping.end(), type1) < std::find(mapping.begin(), mapping.end(), type2);
+        static std::vector<std::string> mapping;
+        if (mapping.empty())
+        {
+            mapping.push_back( typeid(ESM::Weapon).name() );
+            mapping.push_back( typeid(ESM::Armor).name() );
+            mapping.push_back( typeid(ESM::Clothing).name() );
+            mapping.push_back( typeid(ESM::Potion).name() );
+            mapping.push_back( typeid(ESM::Ingredient).name() );
+            mapping.push_back( typeid(ESM::Apparatus).name() );
+            mapping.push_back( typeid(ESM::Book).name() );
+            mapping.push_back( typeid(ESM::Light).name() );
+            mapping.push_back( typeid(ESM::Miscellaneous).name() );
+            mapping.push_back( typeid(ESM::Lockpick).name() );
+            mapping.push_back( typeid(ESM::Repair).name() );
+            mapping.push_back( typeid(ESM::Probe).name() );
+        }
+
+        std::vector<std::string>::const_iterator found = std::find(mapping.begin(), mapping.end(), type);
+        assert( found != mapping.end() );
+        return static_cast<int>(found - mapping.begin());
     }
 
+    /// An item with the keys it is sorted by, so that they are looked up once per item rather than in every
+    /// comparison.
+    struct SortEntry
+    {
+        MWGui::ItemStack mItem;
+        int mTypeOrder;
+        std::string mName;
+    };
+
     struct Compare
     {
         bool mSortByType;
         Compare() : mSortByType(true) {}
-        bool operator() (const MWGui::ItemStack& left, const MWGui::ItemStack& right)
+        bool operator() (const SortEntry& left, const SortEntry& right) const
         {
-            if (mSortByType && left.mType != right.mType)
-                return left.mType < right.mType;
+            if (mSortByType && left.mItem.mType != right.mItem.mType)
+                return left.mItem.mType < right.mItem.mType;
 
-            if (left.mBase.getTypeName() == right.mBase.getTypeName())
-            {
-                std::string leftName = Misc::StringUtils::lowerCase(left.mBase.getClass().getName(left.mBase));
-                std::string rightName = Misc::StringUtils::lowerCase(right.mBase.getClass().getName(right.mBase));
+            if (left.mTypeOrder != right.mTypeOrder)
+                return left.mTypeOrder < right.mTypeOrder;
 
-                return leftName.compare(rightName) < 0;
-            }
-            else
-                return compareType(left.mBase.getTypeName(), right.mBase.getTypeName());
+            return left.mName.compare(right.mName) < 0;
         }
     };
 }
@@ -169,7 +175,8 @@ namespace MWGui
 
         size_t count = mSourceModel->getItemCount();
 
-        mItems.clear();
+        std::vector<SortEntry> entries;
+        entries.reserve(count);
         for (size_t i=0; i<count; ++i)
         {
             ItemStack item = mSourceModel->getItem(i);
@@ -185,12 +192,23 @@ namespace MWGui
             }
 
             if (item.mCount > 0 && filterAccepts(item))
-                mItems.push_back(item);
+            {
+                entries.push_back(SortEntry());
+                SortEntry& entry = entries.back();
+                entry.mItem = item;
+                entry.mTypeOrder = getTypeOrder(item.mBase.getTypeName());
+                entry.mName = Misc::StringUtils::lowerCase(item.mBase.getClass().getName(item.mBase));
+            }
         }
 
         Compare cmp;
         cmp.mSortByType = mSortByType;
-        std::sort(mItems.begin(), mItems.end(), cmp);
+        std::sort(entries.begin(), entries.end(), cmp);
+
+        mItems.clear();
+        mItems.reserve(entries.size());
+        for (std::vector<SortEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+            mItems.push_back(it->mItem);
     }
 
 }
@@ -22,6 +22,12 @@
 #include "tooltips.hpp"
 
 
+namespace
+{
+    // Read for every effect in every frame
+    const Settings::Value<bool> sShowEffectDuration ("show effect duration", "Game");
+}
+
 namespace MWGui
 {
 
@@ -136,7 +142,7 @@ namespace MWGui
                     }
                 }
                 if (effectIt->mRemainingTime > -1 &&
-                        Settings::Manager::getBool("show effect duration","Game")) {
+                        sShowEffectDuration.get()) {
                     sourcesDescription += " #{sDuration}: ";
                     float duration = effectIt->mRemainingTime;
                     if (duration > 3600) {
@@ -177,8 +177,7 @@ namespace MWGui
 
         // advance time
         MWBase::Environment::get().getWorld ()->advanceTime (2);
-        MWBase::Environment::get().getMechanicsManager()->rest(false);
-        MWBase::Environment::get().getMechanicsManager()->rest(false);
+        MWBase::Environment::get().getMechanicsManager()->rest(2, false);
 
         mProgressBar.setVisible(true);
         mProgressBar.setProgress(0, 2);
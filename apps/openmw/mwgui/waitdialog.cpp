@@ -55,6 +55,7 @@ namespace MWGui
         , mSleeping(false)
         , mHours(1)
         , mManualHours(1)
+        , mWaitedHours(0)
         , mFadeTimeRemaining(0)
         , mInterruptAt(-1)
         , mProgressBar()
@@ -143,6 +144,7 @@ namespace MWGui
         setVisible(false);
 
         mHours = hoursToWait;
+        mWaitedHours = 0;
 
         // FIXME: move this somewhere else?
         mInterruptAt = -1;
@@ -189,12 +191,22 @@ namespace MWGui
     void WaitDialog::onWaitingProgressChanged(int cur, int total)
     {
         mProgressBar.setProgress(cur, total);
-        MWBase::Environment::get().getWorld()->advanceTime(1);
-        MWBase::Environment::get().getMechanicsManager()->rest(mSleeping);
+        ++mWaitedHours;
+    }
+
+    void WaitDialog::advanceWaitedTime()
+    {
+        if (mWaitedHours <= 0)
+            return;
+
+        MWBase::Environment::get().getWorld()->advanceTime(mWaitedHours);
+        MWBase::Environment::get().getMechanicsManager()->rest(mWaitedHours, mSleeping);
+        mWaitedHours = 0;
     }
 
     void WaitDialog::onWaitingInterrupted()
     {
+        advanceWaitedTime();
         MWBase::Environment::get().getWindowManager()->messageBox("#{sSleepInterrupt}");
         MWBase::Environment::get().getWorld()->spawnRandomCreature(mInterruptCreatureList);
         stopWaiting();
@@ -258,6 +270,7 @@ namespace MWGui
 
     void WaitDialog::stopWaiting ()
     {
+        advanceWaitedTime();
         MWBase::Environment::get().getWindowManager()->fadeScreenIn(0.2f);
         mProgressBar.setVisible (false);
         MWBase::Environment::get().getWindowManager()->removeGuiMode (GM_Rest);
@@ -268,6 +281,8 @@ namespace MWGui
 
     void WaitDialog::wakeUp ()
     {
+        // The hours slept so far still count as sleep
+        advanceWaitedTime();
         mSleeping = false;
         mTimeAdvancer.stop();
         stopWaiting();
@@ -52,6 +52,7 @@ namespace MWGui
         bool mSleeping;
         int mHours;
         int mManualHours; // stores the hours to rest selected via slider
+        int mWaitedHours; // hours that passed on the progress bar, but not in the world yet
         float mFadeTimeRemaining;
 
         int mInterruptAt;
@@ -72,6 +73,9 @@ namespace MWGui
 
         void startWaiting(int hoursToWait);
         void stopWaiting();
+
+        /// Advance the world by the waited hours all at once, rather than hour by hour while the screen is dark.
+        void advanceWaitedTime();
     };
 
 }
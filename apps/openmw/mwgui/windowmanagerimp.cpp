@@ -45,6 +45,7 @@
 #include <components/sdlutil/sdlcursormanager.hpp>
 
 #include <components/misc/resourcehelpers.hpp>
+#include <components/misc/profiler.hpp>
 
 #include "../mwbase/inputmanager.hpp"
 #include "../mwbase/statemanager.hpp"
@@ -116,7 +117,8 @@ namespace MWGui
     WindowManager::WindowManager(
             osgViewer::Viewer* viewer, osg::Group* guiRoot, Resource::ResourceSystem* resourceSystem
             , const std::string& logpath, const std::string& resourcePath, bool consoleOnlyScripts,
-            Translation::Storage& translationDataStorage, ToUTF8::FromType encoding, bool exportFonts, const std::map<std::string, std::string>& fallbackMap, const std::string& versionDescription)
+            Translation::Storage& translationDataStorage, ToUTF8::FromType encoding, bool exportFonts, const std::map<std::string, std::string>& fallbackMap, const std::string& versionDescription,
+            const std::string& cachePath)
       : mStore(NULL)
       , mResourceSystem(resourceSystem)
       , mViewer(viewer)
@@ -192,6 +194,7 @@ namespace MWGui
       , mFallbackMap(fallbackMap)
       , mShowOwned(0)
       , mVersionDescription(versionDescription)
+      , mCachePath(cachePath)
     {
         float uiScale = Settings::Manager::getFloat("scaling factor", "GUI");
         mGuiPlatform = new osgMyGUI::Platform(viewer, guiRoot, resourceSystem->getTextureManager(), uiScale);
@@ -283,7 +286,7 @@ namespace MWGui
         mRecharge = new Recharge();
         mMenu = new MainMenu(w, h, mResourceSystem->getVFS(), mVersionDescription);
         mLocalMapRender = new MWRender::LocalMap(mViewer);
-        mMap = new MapWindow(mCustomMarkers, mDragAndDrop, mLocalMapRender);
+        mMap = new MapWindow(mCustomMarkers, mDragAndDrop, mLocalMapRender, mCachePath);
         trackWindow(mMap, "map");
         mStatsWindow = new StatsWindow(mDragAndDrop);
         trackWindow(mStatsWindow, "stats");
@@ -481,6 +484,8 @@ namespace MWGui
 
     void WindowManager::update()
     {
+        OPENMW_PROFILE_ZONE ("WindowManager::update");
+
         cleanupGarbage();
 
         mHud->update();
@@ -951,6 +956,8 @@ namespace MWGui
 
     void WindowManager::onFrame (float frameDuration)
     {
+        OPENMW_PROFILE_ZONE ("WindowManager::onFrame");
+
         mMessageBoxManager->onFrame(frameDuration);
 
         mToolTips->onFrame(frameDuration);
@@ -1669,6 +1676,7 @@ namespace MWGui
         mContainerWindow->resetReference();
         mCompanionWindow->resetReference();
         mConsole->resetReference();
+        mJournal->clear();
 
         mSelectedSpell.clear();
 
@@ -2001,6 +2009,10 @@ namespace MWGui
 
     void WindowManager::createCursors()
     {
+        // Decompressing the cursor images needs a graphics context, and there is no cursor to show when headless
+        if (!mViewer->isRealized())
+            return;
+
         MyGUI::ResourceManager::EnumeratorPtr enumerator = MyGUI::ResourceManager::getInstance().getEnumerator();
         while (enumerator.next())
         {
@@ -161,6 +161,11 @@ namespace MWInput
         return mWindowVisible;
     }
 
+    void InputManager::setEventRecorder(SDLUtil::EventRecorder* recorder)
+    {
+        mInputManager->setEventRecorder(recorder);
+    }
+
     void InputManager::setPlayerControlsEnabled(bool enabled)
     {
         int nPlayerChannels = 17;
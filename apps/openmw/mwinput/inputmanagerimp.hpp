@@ -88,6 +88,9 @@ namespace MWInput
 
         void setPlayer (MWWorld::Player* player) { mPlayer = player; }
 
+        /// Record the input events, or replace them with recorded ones. NULL to handle them as they come.
+        void setEventRecorder (SDLUtil::EventRecorder* recorder);
+
         virtual void changeInputMode(bool guiMode);
 
         virtual void processChangedSettings(const Settings::CategorySettingVector& changed);
@@ -19,8 +19,9 @@ namespace MWMechanics
 
         MWWorld::TimeStamp now = MWBase::Environment::get().getWorld()->getTimeStamp();
 
-        // Erase no longer active spells and effects
-        if (mLastUpdate!=now)
+        // Erase no longer active spells and effects, once the first of them ran out
+        const float timeScale = MWBase::Environment::get().getWorld()->getTimeScaleFactor();
+        if (mLastUpdate!=now && (now>=mNextExpiry || timeScale!=mExpiryTimeScale))
         {
             TContainer::iterator iter (mSpells.begin());
             while (iter!=mSpells.end())
@@ -49,8 +50,10 @@ namespace MWMechanics
                 }
             }
 
-            mLastUpdate = now;
+            // The spells that are left may run out at other times now
+            rebuild = true;
         }
+        mLastUpdate = now;
 
         if (mSpellsChanged)
         {
@@ -67,6 +70,9 @@ namespace MWMechanics
         MWWorld::TimeStamp now = MWBase::Environment::get().getWorld()->getTimeStamp();
 
         mEffects = MagicEffects();
+        mExpiryTimeScale = MWBase::Environment::get().getWorld()->getTimeScaleFactor();
+        mNextExpiry = now;
+        bool hasExpiry = false;
 
         for (TIterator iter (begin()); iter!=end(); ++iter)
         {
@@ -74,6 +80,13 @@ namespace MWMechanics
 
             const std::vector<ActiveEffect>& effects = iter->second.mEffects;
 
+            // A spell without effects is erased right away
+            if (effects.empty())
+            {
+                mNextExpiry = now;
+                hasExpiry = true;
+            }
+
             for (std::vector<ActiveEffect>::const_iterator effectIt = effects.begin(); effectIt != effects.end(); ++effectIt)
             {
                 double duration = effectIt->mDuration;
@@ -83,13 +96,25 @@ namespace MWMechanics
 
                 if (end>now)
                     mEffects.add(MWMechanics::EffectKey(effectIt->mEffectId, effectIt->mArg), MWMechanics::EffectParam(effectIt->mMagnitude));
+
+                if (!hasExpiry || end<mNextExpiry)
+                {
+                    mNextExpiry = end;
+                    hasExpiry = true;
+                }
             }
         }
+
+        // Without any effects, nothing can run out until spells are added
+        if (!hasExpiry)
+            mNextExpiry = now + 24.0 * 365;
     }
 
     ActiveSpells::ActiveSpells()
         : mSpellsChanged (false)
         , mLastUpdate (MWBase::Environment::get().getWorld()->getTimeStamp())
+        , mNextExpiry (mLastUpdate)
+        , mExpiryTimeScale (0.f)
     {}
 
     const MagicEffects& ActiveSpells::getMagicEffects() const
@@ -50,6 +50,9 @@ namespace MWMechanics
             mutable MagicEffects mEffects;
             mutable bool mSpellsChanged;
             mutable MWWorld::TimeStamp mLastUpdate;
+            // The time when the first effect runs out, with the time scale it was calculated for
+            mutable MWWorld::TimeStamp mNextExpiry;
+            mutable float mExpiryTimeScale;
 
             void update() const;
             
@@ -6,6 +6,7 @@ namespace MWMechanics
 {
 
     Actor::Actor(const MWWorld::Ptr &ptr, MWRender::Animation *animation)
+        : mTimeSinceAiUpdate(0.f)
     {
         mCharacterController.reset(new CharacterController(ptr, animation));
     }
@@ -25,4 +26,14 @@ namespace MWMechanics
         return mAiState;
     }
 
+    float Actor::getTimeSinceAiUpdate() const
+    {
+        return mTimeSinceAiUpdate;
+    }
+
+    void Actor::setTimeSinceAiUpdate(float time)
+    {
+        mTimeSinceAiUpdate = time;
+    }
+
 }
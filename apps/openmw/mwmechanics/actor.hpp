@@ -31,10 +31,15 @@ namespace MWMechanics
 
         AiState& getAiState();
 
+        /// The game time since the AI packages of the actor last ran, see AiScheduler.
+        float getTimeSinceAiUpdate() const;
+        void setTimeSinceAiUpdate(float time);
+
     private:
         std::auto_ptr<CharacterController> mCharacterController;
 
         AiState mAiState;
+        float mTimeSinceAiUpdate;
     };
 
 }
@@ -1,12 +1,20 @@
 #include "actors.hpp"
 
 #include <typeinfo>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
+
+#include <osg/Stats>
 
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
 #include <components/esm/loadnpc.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/settings/settings.hpp>
+#include <components/misc/profiler.hpp>
 
 #include "../mwworld/esmstore.hpp"
 #include "../mwworld/class.hpp"
@@ -99,7 +107,7 @@ void adjustCommandedActor (const MWWorld::Ptr& actor)
 
     bool hasCommandPackage = false;
 
-    std::list<MWMechanics::AiPackage*>::const_iterator it;
+    MWMechanics::AiSequence::TIterator it;
     for (it = stats.getAiSequence().begin(); it != stats.getAiSequence().end(); ++it)
     {
         if ((*it)->getTypeId() == MWMechanics::AiPackage::TypeIdFollow &&
@@ -125,7 +133,7 @@ void adjustCommandedActor (const MWWorld::Ptr& actor)
 void getRestorationPerHourOfSleep (const MWWorld::Ptr& ptr, float& health, float& magicka)
 {
     MWMechanics::CreatureStats& stats = ptr.getClass().getCreatureStats (ptr);
-    const MWWorld::Store<ESM::GameSetting>& settings = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>();
+    const MWWorld::GmstRegistry& gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
 
     bool stunted = stats.getMagicEffects ().get(ESM::MagicEffect::StuntedMagicka).getMagnitude() > 0;
     int endurance = stats.getAttribute (ESM::Attribute::Endurance).getModified ();
@@ -135,11 +143,21 @@ void getRestorationPerHourOfSleep (const MWWorld::Ptr& ptr, float& health, float
     magicka = 0;
     if (!stunted)
     {
-        float fRestMagicMult = settings.find("fRestMagicMult")->getFloat ();
+        float fRestMagicMult = gmsts.getFloat(MWWorld::GmstRegistry::fRestMagicMult);
         magicka = fRestMagicMult * stats.getAttribute(ESM::Attribute::Intelligence).getModified();
     }
 }
 
+float getMaxHeadTrackDistance (const MWWorld::Ptr& actor)
+{
+    const MWWorld::GmstRegistry& gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
+    float maxDistance = gmsts.getFloat(MWWorld::GmstRegistry::fMaxHeadTrackDistance);
+    const ESM::Cell* currentCell = actor.getCell()->getCell();
+    if (!currentCell->isExterior() && !(currentCell->mData.mFlags & ESM::Cell::QuasiEx))
+        maxDistance *= gmsts.getFloat(MWWorld::GmstRegistry::fInteriorHeadTrackMult);
+    return maxDistance;
+}
+
 }
 
 namespace MWMechanics
@@ -174,7 +192,7 @@ namespace MWMechanics
             if (caster.isEmpty() || !caster.getClass().isActor())
                 return;
 
-            static const float fSoulgemMult = world->getStore().get<ESM::GameSetting>().find("fSoulgemMult")->getFloat();
+            const float fSoulgemMult = world->getStore().getGmsts().getFloat(MWWorld::GmstRegistry::fSoulgemMult);
 
             int creatureSoulValue = mCreature.get<ESM::Creature>()->mBase->mData.mSoul;
             if (creatureSoulValue == 0)
@@ -227,28 +245,105 @@ namespace MWMechanics
     };
 
     void Actors::updateActor (const MWWorld::Ptr& ptr, float duration)
+    {
+        bool wasDead = ptr.getClass().getCreatureStats(ptr).isDead();
+        updateActorStats(ptr, duration);
+        applyMagicEffects(ptr, duration, wasDead);
+    }
+
+    void Actors::updateActorStats (const MWWorld::Ptr& ptr, float duration)
     {
         // magic effects
         adjustMagicEffects (ptr);
         if (ptr.getClass().getCreatureStats(ptr).needToRecalcDynamicStats())
             calculateDynamicStats (ptr);
 
-        calculateCreatureStatModifiers (ptr, duration);
+        calculateStatModifiers (ptr);
+        if (ptr.getClass().isNpc())
+            calculateNpcStatModifiers(ptr, duration);
+
         // fatigue restoration
         calculateRestoration(ptr, duration);
     }
 
+    class Actors::UpdateStatsItem : public SceneUtil::WorkItem
+    {
+    public:
+        /// @param error Receives the message of an exception thrown by the update, to be raised again by the main thread.
+        UpdateStatsItem(Actors& actors, const std::vector<MWWorld::Ptr>& ptrs, size_t begin, size_t end, float duration,
+                        std::string* error)
+            : mActors(actors), mPtrs(ptrs), mBegin(begin), mEnd(end), mDuration(duration), mError(error)
+        {
+        }
+
+        virtual void doWork()
+        {
+            try
+            {
+                for (size_t i = mBegin; i < mEnd; ++i)
+                    mActors.updateActorStats(mPtrs[i], mDuration);
+            }
+            catch (std::exception& e)
+            {
+                *mError = e.what();
+            }
+            mTicket->signalDone();
+        }
+
+    private:
+        Actors& mActors;
+        const std::vector<MWWorld::Ptr>& mPtrs;
+        size_t mBegin;
+        size_t mEnd;
+        float mDuration;
+        std::string* mError;
+    };
+
+    void Actors::updateActorStats (const std::vector<MWWorld::Ptr>& actors, float duration)
+    {
+        // A death in god mode changes the stats of the player, see CreatureStats::setDynamic
+        const bool parallel = mWorkQueue.get() && !MWBase::Environment::get().getWorld()->getGodModeState();
+
+        // One range of actors per mechanics thread, and one for this thread
+        size_t numRanges = std::max(size_t(1), std::min(actors.size(), size_t(parallel ? mNumThreads + 1 : 1)));
+        size_t rangeSize = (actors.size() + numRanges - 1) / numRanges;
+
+        // The settings are read again lazily when the store changed, which must not happen on several threads at once
+        if (numRanges > 1)
+            MWBase::Environment::get().getWorld()->getStore().getGmsts().update();
+
+        // The first error of each range, the one of this thread first. Raised once all ranges are done, since the
+        // mechanics threads read the actors.
+        std::vector<std::string> errors(numRanges);
+
+        std::vector<osg::ref_ptr<SceneUtil::WorkTicket> > tickets;
+        for (size_t begin = rangeSize, range = 1; begin < actors.size(); begin += rangeSize, ++range)
+            tickets.push_back(mWorkQueue->addWorkItem(new UpdateStatsItem(*this, actors, begin,
+                                                                          std::min(begin + rangeSize, actors.size()), duration,
+                                                                          &errors[range])));
+
+        try
+        {
+            for (size_t i = 0; i < std::min(rangeSize, actors.size()); ++i)
+                updateActorStats(actors[i], duration);
+        }
+        catch (std::exception& e)
+        {
+            errors[0] = e.what();
+        }
+
+        for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = tickets.begin(); it != tickets.end(); ++it)
+            (*it)->waitTillDone();
+
+        for (std::vector<std::string>::const_iterator it = errors.begin(); it != errors.end(); ++it)
+            if (!it->empty())
+                throw std::runtime_error(*it);
+    }
+
     void Actors::updateHeadTracking(const MWWorld::Ptr& actor, const MWWorld::Ptr& targetActor,
                                     MWWorld::Ptr& headTrackTarget, float& sqrHeadTrackDistance)
     {
-        static const float fMaxHeadTrackDistance = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                .find("fMaxHeadTrackDistance")->getFloat();
-        static const float fInteriorHeadTrackMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                .find("fInteriorHeadTrackMult")->getFloat();
-        float maxDistance = fMaxHeadTrackDistance;
-        const ESM::Cell* currentCell = actor.getCell()->getCell();
-        if (!currentCell->isExterior() && !(currentCell->mData.mFlags & ESM::Cell::QuasiEx))
-            maxDistance *= fInteriorHeadTrackMult;
+        const float maxDistance = getMaxHeadTrackDistance(actor);
 
         const ESM::Position& actor1Pos = actor.getRefData().getPosition();
         const ESM::Position& actor2Pos = targetActor.getRefData().getPosition();
@@ -342,7 +437,7 @@ namespace MWMechanics
         }
 
         // start combat if target actor is in combat with someone we are following
-        for (std::list<MWMechanics::AiPackage*>::const_iterator it = creatureStats.getAiSequence().begin(); it != creatureStats.getAiSequence().end(); ++it)
+        for (MWMechanics::AiSequence::TIterator it = creatureStats.getAiSequence().begin(); it != creatureStats.getAiSequence().end(); ++it)
         {
             if (!(*it)->sideWithTarget())
                 continue;
@@ -381,7 +476,6 @@ namespace MWMechanics
     void Actors::updateNpc (const MWWorld::Ptr& ptr, float duration)
     {
         updateDrowning(ptr, duration);
-        calculateNpcStatModifiers(ptr, duration);
         updateEquippedLight(ptr, duration);
     }
 
@@ -391,17 +485,24 @@ namespace MWMechanics
         if (creatureStats.isDead())
             return;
 
-        MagicEffects now = creatureStats.getSpells().getMagicEffects();
-
+        // Each source keeps the sum of its own effects up to date, so the total only needs to be calculated again
+        // when one of them changed
+        const MagicEffects& spells = creatureStats.getSpells().getMagicEffects();
+        const MagicEffects& activeSpells = creatureStats.getActiveSpells().getMagicEffects();
+        const MagicEffects* inventory = NULL;
         if (creature.getTypeName()==typeid (ESM::NPC).name())
-        {
-            MWWorld::InventoryStore& store = creature.getClass().getInventoryStore (creature);
-            now += store.getMagicEffects();
-        }
+            inventory = &creature.getClass().getInventoryStore (creature).getMagicEffects();
 
-        now += creatureStats.getActiveSpells().getMagicEffects();
+        const unsigned int inventoryState = inventory ? inventory->getStateId() : 0;
+        if (!creatureStats.haveMagicEffectSourcesChanged(spells.getStateId(), activeSpells.getStateId(), inventoryState))
+            return;
+
+        MagicEffects now = spells;
+        if (inventory)
+            now += *inventory;
+        now += activeSpells;
 
-        creatureStats.modifyMagicEffects(now);
+        creatureStats.modifyMagicEffects(now, spells.getStateId(), activeSpells.getStateId(), inventoryState);
     }
 
     void Actors::calculateDynamicStats (const MWWorld::Ptr& ptr)
@@ -411,10 +512,11 @@ namespace MWMechanics
         int intelligence = creatureStats.getAttribute(ESM::Attribute::Intelligence).getModified();
 
         float base = 1.f;
+        const MWWorld::GmstRegistry& gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
         if (ptr == getPlayer())
-            base = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find("fPCbaseMagickaMult")->getFloat();
+            base = gmsts.getFloat(MWWorld::GmstRegistry::fPCbaseMagickaMult);
         else
-            base = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find("fNPCbaseMagickaMult")->getFloat();
+            base = gmsts.getFloat(MWWorld::GmstRegistry::fNPCbaseMagickaMult);
 
         double magickaFactor = base +
             creatureStats.getMagicEffects().get (EffectKey (ESM::MagicEffect::FortifyMaximumMagicka)).getMagnitude() * 0.1;
@@ -425,13 +527,13 @@ namespace MWMechanics
         creatureStats.setMagicka(magicka);
     }
 
-    void Actors::restoreDynamicStats (const MWWorld::Ptr& ptr, bool sleep)
+    void Actors::restoreDynamicStats (const MWWorld::Ptr& ptr, int hours, bool sleep)
     {
         if (ptr.getClass().getCreatureStats(ptr).isDead())
             return;
 
         MWMechanics::CreatureStats& stats = ptr.getClass().getCreatureStats (ptr);
-        const MWWorld::Store<ESM::GameSetting>& settings = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>();
+        const MWWorld::GmstRegistry& gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
 
         if (sleep)
         {
@@ -439,11 +541,11 @@ namespace MWMechanics
             getRestorationPerHourOfSleep(ptr, health, magicka);
 
             DynamicStat<float> stat = stats.getHealth();
-            stat.setCurrent(stat.getCurrent() + health);
+            stat.setCurrent(stat.getCurrent() + health * hours);
             stats.setHealth(stat);
 
             stat = stats.getMagicka();
-            stat.setCurrent(stat.getCurrent() + magicka);
+            stat.setCurrent(stat.getCurrent() + magicka * hours);
             stats.setMagicka(stat);
         }
 
@@ -454,15 +556,15 @@ namespace MWMechanics
             normalizedEncumbrance = 1;
 
         // restore fatigue
-        float fFatigueReturnBase = settings.find("fFatigueReturnBase")->getFloat ();
-        float fFatigueReturnMult = settings.find("fFatigueReturnMult")->getFloat ();
-        float fEndFatigueMult = settings.find("fEndFatigueMult")->getFloat ();
+        float fFatigueReturnBase = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueReturnBase);
+        float fFatigueReturnMult = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueReturnMult);
+        float fEndFatigueMult = gmsts.getFloat(MWWorld::GmstRegistry::fEndFatigueMult);
 
         float x = fFatigueReturnBase + fFatigueReturnMult * (1 - normalizedEncumbrance);
         x *= fEndFatigueMult * endurance;
 
         DynamicStat<float> fatigue = stats.getFatigue();
-        fatigue.setCurrent (fatigue.getCurrent() + 3600 * x);
+        fatigue.setCurrent (fatigue.getCurrent() + 3600 * x * hours);
         stats.setFatigue (fatigue);
     }
 
@@ -476,9 +578,9 @@ namespace MWMechanics
         int endurance = stats.getAttribute (ESM::Attribute::Endurance).getModified ();
 
         // restore fatigue
-        const MWWorld::Store<ESM::GameSetting>& settings = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>();
-        static const float fFatigueReturnBase = settings.find("fFatigueReturnBase")->getFloat ();
-        static const float fFatigueReturnMult = settings.find("fFatigueReturnMult")->getFloat ();
+        const MWWorld::GmstRegistry& gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
+        const float fFatigueReturnBase = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueReturnBase);
+        const float fFatigueReturnMult = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueReturnMult);
 
         float x = fFatigueReturnBase + fFatigueReturnMult * endurance;
 
@@ -488,33 +590,17 @@ namespace MWMechanics
     }
 
     void Actors::calculateCreatureStatModifiers (const MWWorld::Ptr& ptr, float duration)
+    {
+        bool wasDead = ptr.getClass().getCreatureStats(ptr).isDead();
+        calculateStatModifiers(ptr);
+        applyMagicEffects(ptr, duration, wasDead);
+    }
+
+    void Actors::calculateStatModifiers (const MWWorld::Ptr& ptr)
     {
         CreatureStats &creatureStats = ptr.getClass().getCreatureStats(ptr);
         const MagicEffects &effects = creatureStats.getMagicEffects();
 
-        bool wasDead = creatureStats.isDead();
-
-        if (duration > 0)
-        {
-            for (MagicEffects::Collection::const_iterator it = effects.begin(); it != effects.end(); ++it)
-            {
-                // tickable effects (i.e. effects having a lasting impact after expiry)
-                effectTick(creatureStats, ptr, it->first, it->second.getMagnitude() * duration);
-
-                // instant effects are already applied on spell impact in spellcasting.cpp, but may also come from permanent abilities
-                if (it->second.getMagnitude() > 0)
-                {
-                    CastSpell cast(ptr, ptr);
-                    if (cast.applyInstantEffect(ptr, ptr, it->first, it->second.getMagnitude()))
-                    {
-                        creatureStats.getActiveSpells().purgeEffect(it->first.mId);
-                        if (ptr.getClass().hasInventoryStore(ptr))
-                            ptr.getClass().getInventoryStore(ptr).purgeEffect(it->first.mId);
-                    }
-                }
-            }
-        }
-
         // attributes
         for(int i = 0;i < ESM::Attribute::Length;++i)
         {
@@ -526,23 +612,6 @@ namespace MWMechanics
             creatureStats.setAttribute(i, stat);
         }
 
-        {
-            Spells & spells = creatureStats.getSpells();
-            for (Spells::TIterator it = spells.begin(); it != spells.end(); ++it)
-            {
-                if (spells.getCorprusSpells().find(it->first) != spells.getCorprusSpells().end())
-                {
-                    if (MWBase::Environment::get().getWorld()->getTimeStamp() >= spells.getCorprusSpells().at(it->first).mNextWorsening)
-                    {
-                        spells.worsenCorprus(it->first);
-
-                        if (ptr == getPlayer())
-                            MWBase::Environment::get().getWindowManager()->messageBox("#{sMagicCorprusWorsens}");
-                    }
-                }
-            }
-        }
-
         // dynamic stats
         for(int i = 0;i < 3;++i)
         {
@@ -578,6 +647,50 @@ namespace MWMechanics
             stat.setModifier(static_cast<int>(effects.get(ESM::MagicEffect::TurnUndead).getMagnitude()));
             creatureStats.setAiSetting(CreatureStats::AI_Flee, stat);
         }
+    }
+
+    void Actors::applyMagicEffects (const MWWorld::Ptr& ptr, float duration, bool wasDead)
+    {
+        CreatureStats &creatureStats = ptr.getClass().getCreatureStats(ptr);
+        const MagicEffects &effects = creatureStats.getMagicEffects();
+
+        if (duration > 0)
+        {
+            for (MagicEffects::Collection::const_iterator it = effects.begin(); it != effects.end(); ++it)
+            {
+                // tickable effects (i.e. effects having a lasting impact after expiry)
+                effectTick(creatureStats, ptr, it->first, it->second.getMagnitude() * duration);
+
+                // instant effects are already applied on spell impact in spellcasting.cpp, but may also come from permanent abilities
+                if (it->second.getMagnitude() > 0)
+                {
+                    CastSpell cast(ptr, ptr);
+                    if (cast.applyInstantEffect(ptr, ptr, it->first, it->second.getMagnitude()))
+                    {
+                        creatureStats.getActiveSpells().purgeEffect(it->first.mId);
+                        if (ptr.getClass().hasInventoryStore(ptr))
+                            ptr.getClass().getInventoryStore(ptr).purgeEffect(it->first.mId);
+                    }
+                }
+            }
+        }
+
+        {
+            Spells & spells = creatureStats.getSpells();
+            for (Spells::TIterator it = spells.begin(); it != spells.end(); ++it)
+            {
+                if (spells.getCorprusSpells().find(it->first) != spells.getCorprusSpells().end())
+                {
+                    if (MWBase::Environment::get().getWorld()->getTimeStamp() >= spells.getCorprusSpells().at(it->first).mNextWorsening)
+                    {
+                        spells.worsenCorprus(it->first);
+
+                        if (ptr == getPlayer())
+                            MWBase::Environment::get().getWindowManager()->messageBox("#{sMagicCorprusWorsens}");
+                    }
+                }
+            }
+        }
 
         if (!wasDead && creatureStats.isDead())
         {
@@ -624,7 +737,7 @@ namespace MWMechanics
         if ((effects.get(ESM::MagicEffect::CalmHumanoid).getMagnitude() > 0 && ptr.getClass().isNpc())
                 || (effects.get(ESM::MagicEffect::CalmCreature).getMagnitude() > 0 && !ptr.getClass().isNpc()))
         {
-            for (std::list<AiPackage*>::const_iterator it = creatureStats.getAiSequence().begin(); it != creatureStats.getAiSequence().end(); )
+            for (AiSequence::TIterator it = creatureStats.getAiSequence().begin(); it != creatureStats.getAiSequence().end(); )
             {
                 if ((*it)->getTypeId() == AiPackage::TypeIdCombat)
                     it = creatureStats.getAiSequence().erase(it);
@@ -728,7 +841,7 @@ namespace MWMechanics
             if(timeLeft == 0.0f)
             {
                 // If drowning, apply 3 points of damage per second
-                static const float fSuffocationDamage = world->getStore().get<ESM::GameSetting>().find("fSuffocationDamage")->getFloat();
+                const float fSuffocationDamage = world->getStore().getGmsts().getFloat(MWWorld::GmstRegistry::fSuffocationDamage);
                 DynamicStat<float> health = stats.getHealth();
                 health.setCurrent(health.getCurrent() - fSuffocationDamage*duration);
                 stats.setHealth(health);
@@ -744,7 +857,7 @@ namespace MWMechanics
         }
         else
         {
-            static const float fHoldBreathTime = world->getStore().get<ESM::GameSetting>().find("fHoldBreathTime")->getFloat();
+            const float fHoldBreathTime = world->getStore().getGmsts().getFloat(MWWorld::GmstRegistry::fHoldBreathTime);
             stats.setTimeToStartDrowning(fHoldBreathTime);
         }
     }
@@ -861,7 +974,7 @@ namespace MWMechanics
             if (ptr.getClass().isClass(ptr, "Guard") && creatureStats.getAiSequence().getTypeId() != AiPackage::TypeIdPursue && !creatureStats.getAiSequence().isInCombat())
             {
                 const MWWorld::ESMStore& esmStore = MWBase::Environment::get().getWorld()->getStore();
-                static const int cutoff = esmStore.get<ESM::GameSetting>().find("iCrimeThreshold")->getInt();
+                const int cutoff = esmStore.getGmsts().getInt(MWWorld::GmstRegistry::iCrimeThreshold);
                 // Force dialogue on sight if bounty is greater than the cutoff
                 // In vanilla morrowind, the greeting dialogue is scripted to either arrest the player (< 5000 bounty) or attack (>= 5000 bounty)
                 if (   player.getClass().getNpcStats(player).getBounty() >= cutoff
@@ -869,7 +982,7 @@ namespace MWMechanics
                     && MWBase::Environment::get().getWorld()->getLOS(ptr, player)
                     && MWBase::Environment::get().getMechanicsManager()->awarenessCheck(player, ptr))
                 {
-                    static const int iCrimeThresholdMultiplier = esmStore.get<ESM::GameSetting>().find("iCrimeThresholdMultiplier")->getInt();
+                    const int iCrimeThresholdMultiplier = esmStore.getGmsts().getInt(MWWorld::GmstRegistry::iCrimeThresholdMultiplier);
                     if (player.getClass().getNpcStats(player).getBounty() >= cutoff * iCrimeThresholdMultiplier)
                         MWBase::Environment::get().getMechanicsManager()->startCombat(ptr, player);
                     else
@@ -902,7 +1015,12 @@ namespace MWMechanics
         }
     }
 
-    Actors::Actors() {}
+    Actors::Actors()
+        : mNumThreads(std::max(0, Settings::Manager::getInt("mechanics threads", "Game")))
+    {
+        if (mNumThreads > 0)
+            mWorkQueue.reset(new SceneUtil::WorkQueue(mNumThreads));
+    }
 
     Actors::~Actors()
     {
@@ -961,6 +1079,16 @@ namespace MWMechanics
 
     void Actors::update (float duration, bool paused)
     {
+        OPENMW_PROFILE_ZONE ("Actors::update");
+
+        // Actors without a collision shape are not found by World::getActorsInRange, getObjectsInRange adds them
+        mActorsWithoutCollisionShape.clear();
+        for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+        {
+            if (!MWBase::Environment::get().getWorld()->hasActorCollisionShape(iter->first))
+                mActorsWithoutCollisionShape.push_back(iter->first);
+        }
+
         if(!paused)
         {
             static float timerUpdateAITargets = 0;
@@ -982,7 +1110,25 @@ namespace MWMechanics
 
             /// \todo move update logic to Actor class where appropriate
 
-             // AI and magic effects update
+            std::vector<MWWorld::Ptr> neighbours;
+
+            const ESM::Position& playerPos = player.getRefData().getPosition();
+            const osg::Vec3f playerFacing(std::sin(playerPos.rot[2]), std::cos(playerPos.rot[2]), 0.f);
+            mAiScheduler.beginFrame();
+
+            // Magic effects update. The stats of each actor only depend on the actor itself, so they are calculated in
+            // parallel, and the effects that change other objects are applied afterwards.
+            mLivingActors.clear();
+            for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+            {
+                if (!iter->first.getClass().getCreatureStats(iter->first).isDead())
+                    mLivingActors.push_back(iter->first);
+            }
+            updateActorStats(mLivingActors, duration);
+            for(std::vector<MWWorld::Ptr>::iterator it(mLivingActors.begin()); it != mLivingActors.end(); ++it)
+                applyMagicEffects(*it, duration, false);
+
+             // AI update
             for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
             {
                 bool inProcessingRange = (player.getRefData().getPosition().asVec3() - iter->first.getRefData().getPosition().asVec3()).length2()
@@ -995,19 +1141,23 @@ namespace MWMechanics
 
                 if (!iter->first.getClass().getCreatureStats(iter->first).isDead())
                 {
-                    updateActor(iter->first, duration);
                     if (MWBase::Environment::get().getMechanicsManager()->isAIActive() && inProcessingRange)
                     {
                         if (timerUpdateAITargets == 0)
                         {
-                            if (iter->first != player)
+                            if (iter->first != player) // player is not AI-controlled
+                            {
                                 adjustCommandedActor(iter->first);
 
-                            for(PtrActorMap::iterator it(mActors.begin()); it != mActors.end(); ++it)
-                            {
-                                if (it->first == iter->first || iter->first == player) // player is not AI-controlled
-                                    continue;
-                                engageCombat(iter->first, it->first, it->first == player);
+                                // engageCombat ignores the actors further away
+                                neighbours.clear();
+                                getObjectsInRange(iter->first.getRefData().getPosition().asVec3(), 7168, neighbours);
+                                for(std::vector<MWWorld::Ptr>::iterator it(neighbours.begin()); it != neighbours.end(); ++it)
+                                {
+                                    if (*it == iter->first)
+                                        continue;
+                                    engageCombat(iter->first, *it, *it == player);
+                                }
                             }
                         }
                         if (timerUpdateHeadTrack == 0)
@@ -1015,11 +1165,14 @@ namespace MWMechanics
                             float sqrHeadTrackDistance = std::numeric_limits<float>::max();
                             MWWorld::Ptr headTrackTarget;
 
-                            for(PtrActorMap::iterator it(mActors.begin()); it != mActors.end(); ++it)
+                            neighbours.clear();
+                            getObjectsInRange(iter->first.getRefData().getPosition().asVec3(),
+                                              getMaxHeadTrackDistance(iter->first), neighbours);
+                            for(std::vector<MWWorld::Ptr>::iterator it(neighbours.begin()); it != neighbours.end(); ++it)
                             {
-                                if (it->first == iter->first)
+                                if (*it == iter->first)
                                     continue;
-                                updateHeadTracking(iter->first, it->first, headTrackTarget, sqrHeadTrackDistance);
+                                updateHeadTracking(iter->first, *it, headTrackTarget, sqrHeadTrackDistance);
                             }
                             iter->second->getCharacterController()->setHeadTrackTarget(headTrackTarget);
                         }
@@ -1030,8 +1183,23 @@ namespace MWMechanics
                         if (iter->first != player)
                         {
                             CreatureStats &stats = iter->first.getClass().getCreatureStats(iter->first);
-                            if (isConscious(iter->first))
-                                stats.getAiSequence().execute(iter->first, *iter->second->getCharacterController(), iter->second->getAiState(), duration);
+                            const float timeSinceUpdate = iter->second->getTimeSinceAiUpdate() + duration;
+                            const osg::Vec3f toActor = iter->first.getRefData().getPosition().asVec3() - playerPos.asVec3();
+                            if (!isConscious(iter->first))
+                                iter->second->setTimeSinceAiUpdate(0.f);
+                            else if (mAiScheduler.isUpdateDue(toActor.length(), toActor * playerFacing >= 0.f,
+                                                              stats.getAiSequence().isInCombat(), timeSinceUpdate))
+                            {
+                                mAiScheduler.startUpdate();
+                                stats.getAiSequence().execute(iter->first, *iter->second->getCharacterController(), iter->second->getAiState(), timeSinceUpdate);
+                                mAiScheduler.endUpdate();
+                                iter->second->setTimeSinceAiUpdate(0.f);
+                            }
+                            else
+                            {
+                                stats.getAiSequence().steer(iter->first, duration);
+                                iter->second->setTimeSinceAiUpdate(timeSinceUpdate);
+                            }
 
                             if (stats.getAiSequence().isInCombat() && !stats.isDead()) hostilesCount++;
                         }
@@ -1122,9 +1290,9 @@ namespace MWMechanics
                 static float sneakSkillTimer = 0.f; // times sneak skill progress from "avoid notice"
 
                 const MWWorld::ESMStore& esmStore = MWBase::Environment::get().getWorld()->getStore();
-                const int radius = esmStore.get<ESM::GameSetting>().find("fSneakUseDist")->getInt();
+                const int radius = static_cast<int>(esmStore.getGmsts().getFloat(MWWorld::GmstRegistry::fSneakUseDist));
 
-                static float fSneakUseDelay = esmStore.get<ESM::GameSetting>().find("fSneakUseDelay")->getFloat();
+                const float fSneakUseDelay = esmStore.getGmsts().getFloat(MWWorld::GmstRegistry::fSneakUseDelay);
 
                 if (sneakTimer >= fSneakUseDelay)
                     sneakTimer = 0.f;
@@ -1136,16 +1304,29 @@ namespace MWMechanics
 
                     bool detected = false;
 
+                    // is the player in range, cast the rays to all of those at once
+                    std::vector<MWWorld::Ptr> inRange;
+                    std::vector<MWWorld::ConstPtr> inRangeConst;
                     for (PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
                     {
                         if (iter->first == player)  // not the player
                             continue;
 
-                        // is the player in range and can they be detected
-                        if ((iter->first.getRefData().getPosition().asVec3() - player.getRefData().getPosition().asVec3()).length2() <= radius*radius
-                            && MWBase::Environment::get().getWorld()->getLOS(player, iter->first))
+                        if ((iter->first.getRefData().getPosition().asVec3() - player.getRefData().getPosition().asVec3()).length2() <= radius*radius)
                         {
-                            if (MWBase::Environment::get().getMechanicsManager()->awarenessCheck(player, iter->first))
+                            inRange.push_back(iter->first);
+                            inRangeConst.push_back(iter->first);
+                        }
+                    }
+                    std::vector<bool> lineOfSight;
+                    MWBase::Environment::get().getWorld()->getLOS(player, inRangeConst, lineOfSight);
+
+                    for (size_t i=0; i<inRange.size(); ++i)
+                    {
+                        // can they be detected
+                        if (lineOfSight[i])
+                        {
+                            if (MWBase::Environment::get().getMechanicsManager()->awarenessCheck(player, inRange[i]))
                             {
                                 detected = true;
                                 avoidedNotice = false;
@@ -1237,10 +1418,10 @@ namespace MWMechanics
         }
     }
 
-    void Actors::restoreDynamicStats(bool sleep)
+    void Actors::restoreDynamicStats(int hours, bool sleep)
     {
         for(PtrActorMap::iterator iter(mActors.begin());iter != mActors.end();++iter)
-            restoreDynamicStats(iter->first, sleep);
+            restoreDynamicStats(iter->first, hours, sleep);
     }
 
     int Actors::getHoursToRest(const MWWorld::Ptr &ptr) const
@@ -1306,9 +1487,24 @@ namespace MWMechanics
 
     void Actors::getObjectsInRange(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out)
     {
-        for (PtrActorMap::iterator iter = mActors.begin(); iter != mActors.end(); ++iter)
+        // Only look at the actors near the position, which the physics knows
+        std::vector<MWWorld::Ptr> found;
+        MWBase::Environment::get().getWorld()->getActorsInRange(position, radius, found);
+        for (std::vector<MWWorld::Ptr>::const_iterator it = mActorsWithoutCollisionShape.begin();
+             it != mActorsWithoutCollisionShape.end(); ++it)
         {
-            if ((iter->first.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
+            PtrActorMap::const_iterator iter = mActors.find(*it);
+            if (iter != mActors.end() && (iter->first.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
+                found.push_back(iter->first);
+        }
+
+        // In the order of mActors, like a search of all actors would have it
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+        for (std::vector<MWWorld::Ptr>::const_iterator it = found.begin(); it != found.end(); ++it)
+        {
+            PtrActorMap::const_iterator iter = mActors.find(*it);
+            if (iter != mActors.end())
                 out.push_back(iter->first);
         }
     }
@@ -1324,7 +1520,7 @@ namespace MWMechanics
                 continue;
 
             // An actor counts as following if AiFollow or AiEscort is the current AiPackage, or there are only Combat packages before the AiFollow/AiEscort package
-            for (std::list<MWMechanics::AiPackage*>::const_iterator it = stats.getAiSequence().begin(); it != stats.getAiSequence().end(); ++it)
+            for (MWMechanics::AiSequence::TIterator it = stats.getAiSequence().begin(); it != stats.getAiSequence().end(); ++it)
             {
                 if ((*it)->sideWithTarget() && (*it)->getTarget() == actor)
                     list.push_back(iter->first);
@@ -1346,7 +1542,7 @@ namespace MWMechanics
                 continue;
 
             // An actor counts as following if AiFollow is the current AiPackage, or there are only Combat packages before the AiFollow package
-            for (std::list<MWMechanics::AiPackage*>::const_iterator it = stats.getAiSequence().begin(); it != stats.getAiSequence().end(); ++it)
+            for (MWMechanics::AiSequence::TIterator it = stats.getAiSequence().begin(); it != stats.getAiSequence().end(); ++it)
             {
                 if ((*it)->followTargetThroughDoors() && (*it)->getTarget() == actor)
                     list.push_back(iter->first);
@@ -1368,7 +1564,7 @@ namespace MWMechanics
                 continue;
 
             // An actor counts as following if AiFollow is the current AiPackage, or there are only Combat packages before the AiFollow package
-            for (std::list<MWMechanics::AiPackage*>::const_iterator it = stats.getAiSequence().begin(); it != stats.getAiSequence().end(); ++it)
+            for (MWMechanics::AiSequence::TIterator it = stats.getAiSequence().begin(); it != stats.getAiSequence().end(); ++it)
             {
                 if ((*it)->getTypeId() == MWMechanics::AiPackage::TypeIdFollow)
                 {
@@ -1391,7 +1587,7 @@ namespace MWMechanics
         std::vector<MWWorld::Ptr> neighbors;
         osg::Vec3f position (actor.getRefData().getPosition().asVec3());
         getObjectsInRange(position,
-            MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find("fAlarmRadius")->getFloat(),
+            MWBase::Environment::get().getWorld()->getStore().getGmsts().getFloat(MWWorld::GmstRegistry::fAlarmRadius),
             neighbors); //only care about those within the alarm disance
         for(std::vector<MWWorld::Ptr>::iterator iter(neighbors.begin());iter != neighbors.end();++iter)
         {
@@ -1437,9 +1633,16 @@ namespace MWMechanics
             it->second = NULL;
         }
         mActors.clear();
+        mActorsWithoutCollisionShape.clear();
         mDeathCount.clear();
     }
 
+    void Actors::reportStats(unsigned int frameNumber, osg::Stats& stats) const
+    {
+        stats.setAttribute(frameNumber, "mechanics_actors", mActors.size());
+        stats.setAttribute(frameNumber, "mechanics_actors_ai", mAiScheduler.getNumUpdates());
+    }
+
     void Actors::updateMagicEffects(const MWWorld::Ptr &ptr)
     {
         adjustMagicEffects(ptr);
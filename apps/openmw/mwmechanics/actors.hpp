@@ -7,7 +7,10 @@
 #include <map>
 #include <list>
 
+#include <memory>
+
 #include "movement.hpp"
+#include "aischeduler.hpp"
 #include "../mwbase/world.hpp"
 
 namespace MWWorld
@@ -16,6 +19,16 @@ namespace MWWorld
     class CellStore;
 }
 
+namespace osg
+{
+    class Stats;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace MWMechanics
 {
     class Actor;
@@ -33,6 +46,24 @@ namespace MWMechanics
             void calculateCreatureStatModifiers (const MWWorld::Ptr& ptr, float duration);
             void calculateNpcStatModifiers (const MWWorld::Ptr& ptr, float duration);
 
+            /// The modifiers of the attributes, dynamic stats and AI settings from the current magic effects.
+            /// @note Only changes the actor itself, see updateActorStats.
+            void calculateStatModifiers (const MWWorld::Ptr& ptr);
+
+            /// The effects of the current magic effects on other objects and the game: effect ticks, instant
+            /// effects, corprus, kills, calm, bound items and summons.
+            /// @param wasDead Was the actor dead before its stats were updated this frame?
+            void applyMagicEffects (const MWWorld::Ptr& ptr, float duration, bool wasDead);
+
+            /// The part of updateActor() that only reads the global state and only changes the actor itself, so
+            /// that it can run for many actors in parallel.
+            void updateActorStats (const MWWorld::Ptr& ptr, float duration);
+
+            class UpdateStatsItem;
+
+            /// Run updateActorStats() for the given actors, on this thread and the mechanics threads.
+            void updateActorStats (const std::vector<MWWorld::Ptr>& actors, float duration);
+
             void calculateRestoration (const MWWorld::Ptr& ptr, float duration);
 
             void updateDrowning (const MWWorld::Ptr& ptr, float duration);
@@ -76,6 +107,8 @@ namespace MWMechanics
             void update (float duration, bool paused);
             ///< Update actor stats and store desired velocity vectors in \a movement
 
+            void reportStats (unsigned int frameNumber, osg::Stats& stats) const;
+
             void updateActor (const MWWorld::Ptr& ptr, float duration);
             ///< This function is normally called automatically during the update process, but it can
             /// also be called explicitly at any time to force an update.
@@ -89,10 +122,11 @@ namespace MWMechanics
             void updateHeadTracking(const MWWorld::Ptr& actor, const MWWorld::Ptr& targetActor,
                                             MWWorld::Ptr& headTrackTarget, float& sqrHeadTrackDistance);
 
-            void restoreDynamicStats(bool sleep);
-            ///< If the player is sleeping, this should be called every hour.
+            void restoreDynamicStats(int hours, bool sleep);
+            ///< If the player is sleeping or waiting, this should be called for the hours that passed.
 
-            void restoreDynamicStats(const MWWorld::Ptr& actor, bool sleep);
+            /// The stats only go up at a constant rate until they are full, so any number of hours is restored at once.
+            void restoreDynamicStats(const MWWorld::Ptr& actor, int hours, bool sleep);
 
             int getHoursToRest(const MWWorld::Ptr& ptr) const;
             ///< Calculate how many hours the given actor needs to rest in order to be fully healed
@@ -110,6 +144,8 @@ namespace MWMechanics
         bool checkAnimationPlaying(const MWWorld::Ptr& ptr, const std::string& groupName);
 
             void getObjectsInRange(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out);
+            ///< Add the actors within the radius to \a out, in the order of the actor map. Uses the physics to find
+            /// the actors near the position, instead of going through all of them.
 
             ///Returns the list of actors which are siding with the given actor in fights
             /**ie AiFollow or AiEscort is active and the target is the actor **/
@@ -134,6 +170,17 @@ namespace MWMechanics
     private:
         PtrActorMap mActors;
 
+        // Refreshed by update(), so a removed actor may remain until then. Only use the ones still in mActors.
+        std::vector<MWWorld::Ptr> mActorsWithoutCollisionShape;
+
+        AiScheduler mAiScheduler;
+
+        // Updates the stats of actors together with the main thread, see [Game] "mechanics threads". NULL to update
+        // them on the main thread only.
+        std::auto_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        int mNumThreads;
+        std::vector<MWWorld::Ptr> mLivingActors;
+
     };
 }
 
@@ -87,6 +87,7 @@ namespace MWMechanics
         const MWWorld::CellStore* mCell;
         boost::shared_ptr<Action> mCurrentAction;
         float mActionCooldown;
+        ActionRatingCache mActionRatings;
         float mStrength;
         bool mForceNoShortcut;
         ESM::Position mShortcutFailPos;
@@ -105,6 +106,7 @@ namespace MWMechanics
         mCell(NULL),
         mCurrentAction(),
         mActionCooldown(0),
+        mActionRatings(),
         mStrength(),
         mForceNoShortcut(false),
         mLastActorPos(0,0,0),
@@ -246,7 +248,7 @@ namespace MWMechanics
         boost::shared_ptr<Action>& currentAction = storage.mCurrentAction;
         if (characterController.readyToPrepareAttack())
         {
-            currentAction = prepareNextAction(actor, target);
+            currentAction = prepareNextAction(actor, target, storage.mActionRatings);
             actionCooldown = currentAction->getActionCooldown();
         }
 
@@ -83,116 +83,145 @@ int numEffectsToCure (const MWWorld::Ptr& actor, int effectFilter=-1)
     return toCure;
 }
 
+float getWeaponEnchantmentRating (const MWWorld::Ptr& item, const MWWorld::Ptr& actor, const MWWorld::Ptr& target)
+{
+    if (item.getTypeName() != typeid(ESM::Weapon).name())
+        return 0.f;
+
+    const ESM::Weapon* weapon = item.get<ESM::Weapon>()->mBase;
+    if (weapon->mEnchant.empty())
+        return 0.f;
+
+    const ESM::Enchantment* enchantment = MWBase::Environment::get().getWorld()->getStore().get<ESM::Enchantment>().find(weapon->mEnchant);
+    if (enchantment->mData.mType != ESM::Enchantment::WhenStrikes)
+        return 0.f;
+
+    return MWMechanics::rateEffects(enchantment->mEffects, actor, target);
 }
 
-namespace MWMechanics
+/// @param enchantmentRating See getWeaponEnchantmentRating, only added if the enchantment has enough charge
+float rateWeaponWithEnchantment (const MWWorld::Ptr &item, const MWWorld::Ptr& actor, float enchantmentRating,
+                                 int type, float arrowRating, float boltRating)
 {
+    if (item.getTypeName() != typeid(ESM::Weapon).name())
+        return 0.f;
 
-    float ratePotion (const MWWorld::Ptr &item, const MWWorld::Ptr& actor)
-    {
-        if (item.getTypeName() != typeid(ESM::Potion).name())
-            return 0.f;
+    const ESM::Weapon* weapon = item.get<ESM::Weapon>()->mBase;
 
-        const ESM::Potion* potion = item.get<ESM::Potion>()->mBase;
-        return rateEffects(potion->mEffects, actor, MWWorld::Ptr());
+    if (type != -1 && weapon->mData.mType != type)
+        return 0.f;
+
+    float rating=0.f;
+
+    if (weapon->mData.mType >= ESM::Weapon::MarksmanBow)
+    {
+        rating = (weapon->mData.mChop[0] + weapon->mData.mChop[1]) / 2.f;
+    }
+    else
+    {
+        for (int i=0; i<2; ++i)
+        {
+            rating += weapon->mData.mSlash[i];
+            rating += weapon->mData.mThrust[i];
+            rating += weapon->mData.mChop[i];
+        }
+        rating /= 6.f;
     }
 
-    float rateWeapon (const MWWorld::Ptr &item, const MWWorld::Ptr& actor, const MWWorld::Ptr& target, int type,
-                      float arrowRating, float boltRating)
+    if (item.getClass().hasItemHealth(item))
     {
-        if (item.getTypeName() != typeid(ESM::Weapon).name())
+        if (item.getClass().getItemHealth(item) == 0)
             return 0.f;
+        rating *= item.getClass().getItemHealth(item) / float(item.getClass().getItemMaxHealth(item));
+    }
 
-        const ESM::Weapon* weapon = item.get<ESM::Weapon>()->mBase;
-
-        if (type != -1 && weapon->mData.mType != type)
-            return 0.f;
+    if (weapon->mData.mType == ESM::Weapon::MarksmanBow)
+    {
+        if (arrowRating <= 0.f)
+            rating = 0.f;
+        else
+            rating += arrowRating;
+    }
+    else if (weapon->mData.mType == ESM::Weapon::MarksmanCrossbow)
+    {
+        if (boltRating <= 0.f)
+            rating = 0.f;
+        else
+            rating += boltRating;
+    }
 
-        float rating=0.f;
+    if (!weapon->mEnchant.empty())
+    {
+        const ESM::Enchantment* enchantment = MWBase::Environment::get().getWorld()->getStore().get<ESM::Enchantment>().find(weapon->mEnchant);
+        if (item.getCellRef().getEnchantmentCharge() == -1
+                || item.getCellRef().getEnchantmentCharge() >= enchantment->mData.mCost)
+            rating += enchantmentRating;
+    }
 
-        if (weapon->mData.mType >= ESM::Weapon::MarksmanBow)
-        {
-            rating = (weapon->mData.mChop[0] + weapon->mData.mChop[1]) / 2.f;
-        }
-        else
-        {
-            for (int i=0; i<2; ++i)
-            {
-                rating += weapon->mData.mSlash[i];
-                rating += weapon->mData.mThrust[i];
-                rating += weapon->mData.mChop[i];
-            }
-            rating /= 6.f;
-        }
+    int skill = item.getClass().getEquipmentSkill(item);
+    if (skill != -1)
+        rating *= actor.getClass().getSkill(actor, skill) / 100.f;
 
-        if (item.getClass().hasItemHealth(item))
-        {
-            if (item.getClass().getItemHealth(item) == 0)
-                return 0.f;
-            rating *= item.getClass().getItemHealth(item) / float(item.getClass().getItemMaxHealth(item));
-        }
+    return rating;
+}
 
-        if (weapon->mData.mType == ESM::Weapon::MarksmanBow)
-        {
-            if (arrowRating <= 0.f)
-                rating = 0.f;
-            else
-                rating += arrowRating;
-        }
-        else if (weapon->mData.mType == ESM::Weapon::MarksmanCrossbow)
-        {
-            if (boltRating <= 0.f)
-                rating = 0.f;
-            else
-                rating += boltRating;
-        }
+/// @param effectsRating The rating of the effects of the spell, see MWMechanics::rateEffects
+float rateSpellWithEffects (const ESM::Spell *spell, const MWWorld::Ptr &actor, const MWWorld::Ptr& target, float effectsRating)
+{
+    const MWMechanics::CreatureStats& stats = actor.getClass().getCreatureStats(actor);
 
-        if (!weapon->mEnchant.empty())
-        {
-            const ESM::Enchantment* enchantment = MWBase::Environment::get().getWorld()->getStore().get<ESM::Enchantment>().find(weapon->mEnchant);
-            if (enchantment->mData.mType == ESM::Enchantment::WhenStrikes
-                    && (item.getCellRef().getEnchantmentCharge() == -1
-                        || item.getCellRef().getEnchantmentCharge() >= enchantment->mData.mCost))
-                rating += rateEffects(enchantment->mEffects, actor, target);
-        }
+    if (MWMechanics::getSpellSuccessChance(spell, actor) == 0)
+        return 0.f;
 
-        int skill = item.getClass().getEquipmentSkill(item);
-        if (skill != -1)
-            rating *= actor.getClass().getSkill(actor, skill) / 100.f;
+    if (spell->mData.mType != ESM::Spell::ST_Spell)
+        return 0.f;
 
-        return rating;
+    // Don't make use of racial bonus spells, like MW. Can be made optional later
+    if (actor.getClass().isNpc())
+    {
+        std::string raceid = actor.get<ESM::NPC>()->mBase->mRace;
+        const ESM::Race* race = MWBase::Environment::get().getWorld()->getStore().get<ESM::Race>().find(raceid);
+        if (race->mPowers.exists(spell->mId))
+            return 0.f;
     }
 
-    float rateSpell(const ESM::Spell *spell, const MWWorld::Ptr &actor, const MWWorld::Ptr& target)
-    {
-        const CreatureStats& stats = actor.getClass().getCreatureStats(actor);
+    if (spell->mData.mCost > stats.getMagicka().getCurrent())
+        return 0.f;
 
-        if (MWMechanics::getSpellSuccessChance(spell, actor) == 0)
-            return 0.f;
+    // Spells don't stack, so early out if the spell is still active on the target
+    int types = getRangeTypes(spell->mEffects);
+    if ((types & Self) && stats.getActiveSpells().isSpellActive(spell->mId))
+        return 0.f;
+    if ( ((types & Touch) || (types & Target)) && target.getClass().getCreatureStats(target).getActiveSpells().isSpellActive(spell->mId))
+        return 0.f;
 
-        if (spell->mData.mType != ESM::Spell::ST_Spell)
-            return 0.f;
+    return effectsRating;
+}
 
-        // Don't make use of racial bonus spells, like MW. Can be made optional later
-        if (actor.getClass().isNpc())
-        {
-            std::string raceid = actor.get<ESM::NPC>()->mBase->mRace;
-            const ESM::Race* race = MWBase::Environment::get().getWorld()->getStore().get<ESM::Race>().find(raceid);
-            if (race->mPowers.exists(spell->mId))
-                return 0.f;
-        }
+}
 
-        if (spell->mData.mCost > stats.getMagicka().getCurrent())
-            return 0.f;
+namespace MWMechanics
+{
 
-        // Spells don't stack, so early out if the spell is still active on the target
-        int types = getRangeTypes(spell->mEffects);
-        if ((types & Self) && stats.getActiveSpells().isSpellActive(spell->mId))
-            return 0.f;
-        if ( ((types & Touch) || (types & Target)) && target.getClass().getCreatureStats(target).getActiveSpells().isSpellActive(spell->mId))
+    float ratePotion (const MWWorld::Ptr &item, const MWWorld::Ptr& actor)
+    {
+        if (item.getTypeName() != typeid(ESM::Potion).name())
             return 0.f;
 
-        return rateEffects(spell->mEffects, actor, target);
+        const ESM::Potion* potion = item.get<ESM::Potion>()->mBase;
+        return rateEffects(potion->mEffects, actor, MWWorld::Ptr());
+    }
+
+    float rateWeapon (const MWWorld::Ptr &item, const MWWorld::Ptr& actor, const MWWorld::Ptr& target, int type,
+                      float arrowRating, float boltRating)
+    {
+        return rateWeaponWithEnchantment(item, actor, getWeaponEnchantmentRating(item, actor, target),
+                                         type, arrowRating, boltRating);
+    }
+
+    float rateSpell(const ESM::Spell *spell, const MWWorld::Ptr &actor, const MWWorld::Ptr& target)
+    {
+        return rateSpellWithEffects(spell, actor, target, rateEffects(spell->mEffects, actor, target));
     }
 
     float rateMagicItem(const MWWorld::Ptr &ptr, const MWWorld::Ptr &actor, const MWWorld::Ptr& target)
@@ -454,7 +483,85 @@ namespace MWMechanics
         // Already done in AiCombat itself
     }
 
-    boost::shared_ptr<Action> prepareNextAction(const MWWorld::Ptr &actor, const MWWorld::Ptr &target)
+    ActionRatingCache::ActionRatingCache()
+        : mStore(NULL)
+        , mStoreStateId(0)
+    {
+    }
+
+    void ActionRatingCache::update(const MWWorld::Ptr &actor, const MWWorld::Ptr &target)
+    {
+        const MWWorld::ContainerStore* store = actor.getClass().hasInventoryStore(actor) ?
+                    &actor.getClass().getInventoryStore(actor) : NULL;
+        if (target == mTarget && store == mStore && (!store || store->getStateId() == mStoreStateId))
+            return;
+
+        if (target != mTarget)
+            mSpellRatings.clear();
+
+        mTarget = target;
+        mStore = store;
+        mPotions.clear();
+        mMagicItems.clear();
+        mArrows.clear();
+        mBolts.clear();
+        mWeapons.clear();
+        if (!store)
+            return;
+
+        MWWorld::InventoryStore& inventory = actor.getClass().getInventoryStore(actor);
+        mStoreStateId = inventory.getStateId();
+        for (MWWorld::ContainerStoreIterator it = inventory.begin(); it != inventory.end(); ++it)
+        {
+            float rating = ratePotion(*it, actor);
+            if (rating > 0.f)
+                mPotions.push_back(Item(it, rating));
+
+            rating = rateMagicItem(*it, actor, target);
+            if (rating > 0.f)
+                mMagicItems.push_back(Item(it, rating));
+
+            if (it->getTypeName() != typeid(ESM::Weapon).name())
+                continue;
+
+            const int type = it->get<ESM::Weapon>()->mBase->mData.mType;
+            const Item weapon(it, getWeaponEnchantmentRating(*it, actor, target));
+            if (type == ESM::Weapon::Arrow)
+                mArrows.push_back(weapon);
+            else if (type == ESM::Weapon::Bolt)
+                mBolts.push_back(weapon);
+            else
+            {
+                std::vector<int> equipmentSlots = it->getClass().getEquipmentSlots(*it).first;
+                if (std::find(equipmentSlots.begin(), equipmentSlots.end(), (int)MWWorld::InventoryStore::Slot_CarriedRight)
+                        != equipmentSlots.end())
+                    mWeapons.push_back(weapon);
+            }
+        }
+    }
+
+    const ActionRatingCache::ItemList& ActionRatingCache::getWeapons(int type) const
+    {
+        if (type == ESM::Weapon::Arrow)
+            return mArrows;
+        if (type == ESM::Weapon::Bolt)
+            return mBolts;
+        return mWeapons;
+    }
+
+    float ActionRatingCache::getSpellEffectsRating(const ESM::Spell *spell, const MWWorld::Ptr &actor, const MWWorld::Ptr &target)
+    {
+        std::map<const ESM::Spell*, float>::const_iterator found = mSpellRatings.find(spell);
+        if (found != mSpellRatings.end())
+            return found->second;
+
+        const float rating = rateEffects(spell->mEffects, actor, target);
+        mSpellRatings[spell] = rating;
+        return rating;
+    }
+
+    boost::shared_ptr<Action> prepareNextAction(const MWWorld::Ptr &actor, const MWWorld::Ptr &target,
+                                                ActionRatingCache& cache)
     {
         Spells& spells = actor.getClass().getCreatureStats(actor).getSpells();
 
@@ -467,65 +574,61 @@ namespace MWMechanics
             return bestAction;
         }
 
+        cache.update(actor, target);
+
         if (actor.getClass().hasInventoryStore(actor))
         {
-            MWWorld::InventoryStore& store = actor.getClass().getInventoryStore(actor);
-
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (ActionRatingCache::ItemList::const_iterator it = cache.getPotions().begin(); it != cache.getPotions().end(); ++it)
             {
-                float rating = ratePotion(*it, actor);
-                if (rating > bestActionRating)
+                if (it->mRating > bestActionRating)
                 {
-                    bestActionRating = rating;
-                    bestAction.reset(new ActionPotion(*it));
+                    bestActionRating = it->mRating;
+                    bestAction.reset(new ActionPotion(*it->mIterator));
                 }
             }
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (ActionRatingCache::ItemList::const_iterator it = cache.getMagicItems().begin(); it != cache.getMagicItems().end(); ++it)
             {
-                float rating = rateMagicItem(*it, actor, target);
-                if (rating > bestActionRating)
+                if (it->mRating > bestActionRating)
                 {
-                    bestActionRating = rating;
-                    bestAction.reset(new ActionEnchantedItem(it));
+                    bestActionRating = it->mRating;
+                    bestAction.reset(new ActionEnchantedItem(it->mIterator));
                 }
             }
 
             float bestArrowRating = 0;
             MWWorld::Ptr bestArrow;
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            const ActionRatingCache::ItemList& arrows = cache.getWeapons(ESM::Weapon::Arrow);
+            for (ActionRatingCache::ItemList::const_iterator it = arrows.begin(); it != arrows.end(); ++it)
             {
-                float rating = rateWeapon(*it, actor, target, ESM::Weapon::Arrow);
+                float rating = rateWeaponWithEnchantment(*it->mIterator, actor, it->mRating, ESM::Weapon::Arrow, 0.f, 0.f);
                 if (rating > bestArrowRating)
                 {
                     bestArrowRating = rating;
-                    bestArrow = *it;
+                    bestArrow = *it->mIterator;
                 }
             }
 
             float bestBoltRating = 0;
             MWWorld::Ptr bestBolt;
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            const ActionRatingCache::ItemList& bolts = cache.getWeapons(ESM::Weapon::Bolt);
+            for (ActionRatingCache::ItemList::const_iterator it = bolts.begin(); it != bolts.end(); ++it)
             {
-                float rating = rateWeapon(*it, actor, target, ESM::Weapon::Bolt);
+                float rating = rateWeaponWithEnchantment(*it->mIterator, actor, it->mRating, ESM::Weapon::Bolt, 0.f, 0.f);
                 if (rating > bestBoltRating)
                 {
                     bestBoltRating = rating;
-                    bestBolt = *it;
+                    bestBolt = *it->mIterator;
                 }
             }
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            const ActionRatingCache::ItemList& weapons = cache.getWeapons(-1);
+            for (ActionRatingCache::ItemList::const_iterator it = weapons.begin(); it != weapons.end(); ++it)
             {
-                std::vector<int> equipmentSlots = it->getClass().getEquipmentSlots(*it).first;
-                if (std::find(equipmentSlots.begin(), equipmentSlots.end(), (int)MWWorld::InventoryStore::Slot_CarriedRight)
-                        == equipmentSlots.end())
-                    continue;
-
-                float rating = rateWeapon(*it, actor, target, -1, bestArrowRating, bestBoltRating);
+                float rating = rateWeaponWithEnchantment(*it->mIterator, actor, it->mRating, -1, bestArrowRating, bestBoltRating);
                 if (rating > bestActionRating)
                 {
-                    const ESM::Weapon* weapon = it->get<ESM::Weapon>()->mBase;
+                    const ESM::Weapon* weapon = it->mIterator->get<ESM::Weapon>()->mBase;
 
                     MWWorld::Ptr ammo;
                     if (weapon->mData.mType == ESM::Weapon::MarksmanBow)
@@ -534,7 +637,7 @@ namespace MWMechanics
                         ammo = bestBolt;
 
                     bestActionRating = rating;
-                    bestAction.reset(new ActionWeapon(*it, ammo));
+                    bestAction.reset(new ActionWeapon(*it->mIterator, ammo));
                 }
             }
         }
@@ -543,7 +646,7 @@ namespace MWMechanics
         {
             const ESM::Spell* spell = it->first;
 
-            float rating = rateSpell(spell, actor, target);
+            float rating = rateSpellWithEffects(spell, actor, target, cache.getSpellEffectsRating(spell, actor, target));
             if (rating > bestActionRating)
             {
                 bestActionRating = rating;
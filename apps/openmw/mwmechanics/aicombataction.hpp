@@ -1,6 +1,9 @@
 #ifndef OPENMW_AICOMBAT_ACTION_H
 #define OPENMW_AICOMBAT_ACTION_H
 
+#include <map>
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
 
 #include "../mwworld/ptr.hpp"
@@ -80,11 +83,58 @@ namespace MWMechanics
                       int type=-1, float arrowRating=0.f, float boltRating=0.f);
 
     /// @note target may be empty
+    /// @note The ratings of effects are kept by ActionRatingCache until the inventory or target changes, so they
+    /// must not depend on the changing state of the actor or target.
     float rateEffect (const ESM::ENAMstruct& effect, const MWWorld::Ptr& actor, const MWWorld::Ptr& target);
     /// @note target may be empty
     float rateEffects (const ESM::EffectList& list, const MWWorld::Ptr& actor, const MWWorld::Ptr& target);
 
-    boost::shared_ptr<Action> prepareNextAction (const MWWorld::Ptr& actor, const MWWorld::Ptr& target);
+    /// @brief The parts of the action ratings of an actor that only change with its inventory and target, so that
+    /// prepareNextAction does not rate every item and spell from scratch each time.
+    /// @par What still changes during the fight, like the health of weapons, the magicka of the actor and the spells
+    /// active on the target, is checked when the actions are rated.
+    class ActionRatingCache
+    {
+    public:
+        struct Item
+        {
+            Item(const MWWorld::ContainerStoreIterator& iterator, float rating) : mIterator(iterator), mRating(rating) {}
+            MWWorld::ContainerStoreIterator mIterator;
+            float mRating;
+        };
+        typedef std::vector<Item> ItemList;
+
+        ActionRatingCache();
+
+        /// Forget the ratings if the inventory of the actor or the target changed since they were made.
+        void update(const MWWorld::Ptr& actor, const MWWorld::Ptr& target);
+
+        /// Potions and one-use magic items with a positive rating.
+        const ItemList& getPotions() const { return mPotions; }
+        const ItemList& getMagicItems() const { return mMagicItems; }
+
+        /// Weapons of the given type, or for the right hand if -1, with the rating of their enchantment.
+        const ItemList& getWeapons(int type) const;
+
+        /// @return The rating of the effects of the spell on the target.
+        float getSpellEffectsRating(const ESM::Spell* spell, const MWWorld::Ptr& actor, const MWWorld::Ptr& target);
+
+    private:
+        const MWWorld::ContainerStore* mStore;
+        int mStoreStateId;
+        MWWorld::Ptr mTarget;
+
+        ItemList mPotions;
+        ItemList mMagicItems;
+        ItemList mArrows;
+        ItemList mBolts;
+        ItemList mWeapons;
+
+        std::map<const ESM::Spell*, float> mSpellRatings;
+    };
+
+    boost::shared_ptr<Action> prepareNextAction (const MWWorld::Ptr& actor, const MWWorld::Ptr& target,
+                                                 ActionRatingCache& cache);
 }
 
 #endif
@@ -1,6 +1,7 @@
 #include "aipackage.hpp"
 
 #include <cmath>
+#include <vector>
 
 #include <components/esm/loadcell.hpp>
 #include <components/esm/loadland.hpp>
@@ -8,6 +9,7 @@
 
 #include "../mwbase/world.hpp"
 #include "../mwbase/environment.hpp"
+#include "../mwbase/mechanicsmanager.hpp"
 #include "../mwworld/class.hpp"
 #include "../mwworld/cellstore.hpp"
 #include "creaturestats.hpp"
@@ -18,8 +20,52 @@
 #include "actorutil.hpp"
 #include "coordinateconverter.hpp"
 
+namespace
+{
+    const size_t sPoolGranularity = 16;
+    // Pools for packages of up to 1024 bytes, anything larger is allocated as usual
+    const size_t sNumPools = 64;
+
+    size_t getPoolIndex(size_t size)
+    {
+        return (size - 1) / sPoolGranularity;
+    }
+
+    std::vector<void*>& getPool(size_t size)
+    {
+        // Never destroyed, so packages can still be deleted after the static objects are
+        static std::vector<void*>* pools = new std::vector<void*>[sNumPools];
+        return pools[getPoolIndex(size)];
+    }
+}
+
 MWMechanics::AiPackage::~AiPackage() {}
 
+void* MWMechanics::AiPackage::operator new (size_t size)
+{
+    if (size == 0 || getPoolIndex(size) >= sNumPools)
+        return ::operator new(size);
+
+    std::vector<void*>& pool = getPool(size);
+    if (pool.empty())
+        return ::operator new((getPoolIndex(size) + 1) * sPoolGranularity);
+
+    void* pointer = pool.back();
+    pool.pop_back();
+    return pointer;
+}
+
+void MWMechanics::AiPackage::operator delete (void* pointer, size_t size)
+{
+    if (!pointer)
+        return;
+
+    if (size == 0 || getPoolIndex(size) >= sNumPools)
+        ::operator delete(pointer);
+    else
+        getPool(size).push_back(pointer);
+}
+
 MWWorld::Ptr MWMechanics::AiPackage::getTarget()
 {
     return MWWorld::Ptr();
@@ -35,7 +81,7 @@ bool MWMechanics::AiPackage::followTargetThroughDoors() const
     return false;
 }
 
-MWMechanics::AiPackage::AiPackage() : mTimer(0.26f) { //mTimer starts at .26 to force initial pathbuild
+MWMechanics::AiPackage::AiPackage() : mTimer(0.26f), mCellPathPlanned(false) { //mTimer starts at .26 to force initial pathbuild
 
 }
 
@@ -92,6 +138,49 @@ bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, ESM::Pathgrid::Po
     return false;
 }
 
+bool MWMechanics::AiPackage::travelTo(const MWWorld::Ptr& actor, ESM::Pathgrid::Point dest, float duration)
+{
+    if (!actor.getCell()->getCell()->isExterior())
+        return pathTo(actor, dest, duration);
+
+    if (!mCellPathPlanned || distance(mCellPathDest, dest) > 10)
+    {
+        mCellPath.clear();
+        std::vector<osg::Vec3f> waypoints;
+        if (MWBase::Environment::get().getMechanicsManager()->findExteriorPath(
+                    actor.getRefData().getPosition().asVec3(), PathFinder::MakeOsgVec3(dest), waypoints))
+        {
+            for (std::vector<osg::Vec3f>::const_iterator it = waypoints.begin(); it != waypoints.end(); ++it)
+                mCellPath.push_back(PathFinder::MakePathgridPoint(*it));
+        }
+        mCellPathDest = dest;
+        mCellPathPlanned = true;
+    }
+
+    if (mCellPath.empty())
+        return pathTo(actor, dest, duration);
+
+    // Refine the way to the next point only, within the current cell
+    if (pathTo(actor, mCellPath.front(), duration))
+    {
+        mCellPath.pop_front();
+        mTimer = 0.26f; // force the path to the next point to be built
+    }
+    return false;
+}
+
+void MWMechanics::AiPackage::steer(const MWWorld::Ptr& actor, float duration)
+{
+    if (!mPathFinder.isPathConstructed())
+        return;
+
+    const ESM::Position& pos = actor.getRefData().getPosition();
+    if (mPathFinder.checkPathCompleted(pos.pos[0], pos.pos[1]))
+        actor.getClass().getMovementSettings(actor).mPosition[1] = 0;
+    else
+        zTurn(actor, mPathFinder.getZAngleToNext(pos.pos[0], pos.pos[1]));
+}
+
 void MWMechanics::AiPackage::evadeObstacles(const MWWorld::Ptr& actor, float duration, const ESM::Position& pos)
 {
     zTurn(actor, mPathFinder.getZAngleToNext(pos.pos[0], pos.pos[1]));
@@ -50,6 +50,11 @@ namespace MWMechanics
             ///Default Deconstructor
             virtual ~AiPackage();
 
+            /// Packages are created and deleted all the time, so their memory is kept in pools by size and reused.
+            /// @note Only for the main thread.
+            static void* operator new (size_t size);
+            static void operator delete (void* pointer, size_t size);
+
             ///Clones the package
             virtual AiPackage *clone() const = 0;
 
@@ -69,6 +74,10 @@ namespace MWMechanics
             /// Simulates the passing of time
             virtual void fastForward(const MWWorld::Ptr& actor, AiState& state) {}
 
+            /// Cheaply follow the current path in the frames the package does not execute, see AiScheduler. By
+            /// default, turns towards the next point of mPathFinder, and stops at the end of the path.
+            virtual void steer(const MWWorld::Ptr& actor, float duration);
+
             /// Get the target actor the AI is targeted at (not applicable to all AI packages, default return empty Ptr)
             virtual MWWorld::Ptr getTarget();
 
@@ -85,6 +94,11 @@ namespace MWMechanics
             /** \return If the actor has arrived at his destination **/
             bool pathTo(const MWWorld::Ptr& actor, ESM::Pathgrid::Point dest, float duration);
 
+            /// Like pathTo(), but plans the way to a destination in another exterior cell once, through the points where
+            /// the pathgrids of the cells meet, and walks to each of them in turn with pathTo().
+            /** \return If the actor has arrived at his destination **/
+            bool travelTo(const MWWorld::Ptr& actor, ESM::Pathgrid::Point dest, float duration);
+
             virtual bool doesPathNeedRecalc(ESM::Pathgrid::Point dest, const ESM::Cell *cell);
 
             void evadeObstacles(const MWWorld::Ptr& actor, float duration, const ESM::Position& pos);
@@ -97,6 +111,11 @@ namespace MWMechanics
 
             ESM::Pathgrid::Point mPrevDest;
 
+            // The points left to walk through on the way planned by travelTo(), and the destination it was planned for
+            std::list<ESM::Pathgrid::Point> mCellPath;
+            ESM::Pathgrid::Point mCellPathDest;
+            bool mCellPathPlanned;
+
             bool isWithinMaxRange(const osg::Vec3f& pos1, const osg::Vec3f& pos2) const
             {
                 // Maximum travel distance for vanilla compatibility.
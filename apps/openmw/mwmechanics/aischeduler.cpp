@@ -0,0 +1,57 @@
+#include "aischeduler.hpp"
+
+#include <algorithm>
+
+#include <components/settings/settings.hpp>
+
+namespace MWMechanics
+{
+    AiScheduler::AiScheduler()
+        : mFullRateDistance(std::max(0.f, Settings::Manager::getFloat("ai full rate distance", "Game")))
+        , mMaxDistance(7168) // the AI processing distance, see Actors::update
+        , mMaxInterval(std::max(0.f, Settings::Manager::getFloat("ai max update interval", "Game")))
+        , mBudget(std::max(0.f, Settings::Manager::getFloat("ai update budget", "Game")) / 1000.0)
+        , mUsedTime(0.0)
+        , mNumUpdates(0)
+        , mUpdateStart(0)
+    {
+    }
+
+    void AiScheduler::beginFrame()
+    {
+        mUsedTime = 0.0;
+        mNumUpdates = 0;
+    }
+
+    bool AiScheduler::isUpdateDue(float distance, bool visible, bool inCombat, float timeSinceUpdate) const
+    {
+        if (inCombat || distance <= mFullRateDistance || mFullRateDistance >= mMaxDistance)
+            return true;
+
+        float interval = mMaxInterval * std::min(1.f, (distance - mFullRateDistance) / (mMaxDistance - mFullRateDistance));
+        if (!visible)
+            interval *= 2;
+
+        if (timeSinceUpdate < interval)
+            return false;
+
+        // Over the budget, wait for a later frame unless this actor already waited for long
+        return mBudget <= 0.0 || mUsedTime < mBudget || timeSinceUpdate >= interval * 2;
+    }
+
+    void AiScheduler::startUpdate()
+    {
+        mUpdateStart = osg::Timer::instance()->tick();
+        ++mNumUpdates;
+    }
+
+    void AiScheduler::endUpdate()
+    {
+        mUsedTime += osg::Timer::instance()->delta_s(mUpdateStart, osg::Timer::instance()->tick());
+    }
+
+    unsigned int AiScheduler::getNumUpdates() const
+    {
+        return mNumUpdates;
+    }
+}
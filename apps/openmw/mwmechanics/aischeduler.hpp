@@ -0,0 +1,48 @@
+#ifndef GAME_MWMECHANICS_AISCHEDULER_H
+#define GAME_MWMECHANICS_AISCHEDULER_H
+
+#include <osg/Timer>
+
+namespace MWMechanics
+{
+    /// @brief Decides how often the AI packages of each actor run, so that actors far from the player or behind them
+    /// think less often, within a time budget per frame.
+    /// @par Actors near the player and actors in combat run every frame. Further away, the time between runs grows
+    /// with the distance, and doubles behind the player. Once the budget of a frame is used up, the actors that are
+    /// due wait for the next frame, but no longer than twice their usual time. Between runs, actors only steer along
+    /// their path, see AiSequence::steer.
+    class AiScheduler
+    {
+    public:
+        AiScheduler();
+
+        /// Start counting the time of a new frame.
+        void beginFrame();
+
+        /// Should the AI packages of an actor run this frame?
+        /// @param distance The distance to the player.
+        /// @param visible Is the actor in front of the player?
+        /// @param timeSinceUpdate The game time since the packages last ran.
+        bool isUpdateDue(float distance, bool visible, bool inCombat, float timeSinceUpdate) const;
+
+        /// Call around the run of the AI packages of an actor, to count its time.
+        void startUpdate();
+        void endUpdate();
+
+        /// The number of actors whose AI packages ran since beginFrame().
+        unsigned int getNumUpdates() const;
+
+    private:
+        float mFullRateDistance;
+        float mMaxDistance;
+        float mMaxInterval;
+        // In seconds, 0 for no limit
+        double mBudget;
+
+        double mUsedTime;
+        unsigned int mNumUpdates;
+        osg::Timer_t mUpdateStart;
+    };
+}
+
+#endif
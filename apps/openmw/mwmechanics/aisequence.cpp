@@ -1,5 +1,6 @@
 #include "aisequence.hpp"
 
+#include <algorithm>
 #include <limits>
 
 #include "aipackage.hpp"
@@ -24,8 +25,8 @@ namespace MWMechanics
 
 void AiSequence::copy (const AiSequence& sequence)
 {
-    for (std::list<AiPackage *>::const_iterator iter (sequence.mPackages.begin());
-        iter!=sequence.mPackages.end(); ++iter)
+    mPackages.reserve (mPackages.size() + sequence.mPackages.size());
+    for (TIterator iter (sequence.mPackages.begin()); iter!=sequence.mPackages.end(); ++iter)
         mPackages.push_back ((*iter)->clone());
 }
 
@@ -75,32 +76,29 @@ bool AiSequence::getCombatTarget(MWWorld::Ptr &targetActor) const
     return !targetActor.isEmpty();
 }
 
-std::list<AiPackage*>::const_iterator AiSequence::begin() const
+AiSequence::TIterator AiSequence::begin() const
 {
     return mPackages.begin();
 }
 
-std::list<AiPackage*>::const_iterator AiSequence::end() const
+AiSequence::TIterator AiSequence::end() const
 {
     return mPackages.end();
 }
 
-std::list<AiPackage*>::const_iterator AiSequence::erase(std::list<AiPackage*>::const_iterator package)
+AiSequence::TIterator AiSequence::erase(TIterator package)
 {
     // Not sure if manually terminated packages should trigger mDone, probably not?
-    for(std::list<AiPackage*>::iterator it = mPackages.begin(); it != mPackages.end(); ++it)
-    {
-        if (package == it)
-        {
-            return mPackages.erase(it);
-        }
-    }
-    throw std::runtime_error("can't find package to erase");
+    TIterator begin = mPackages.begin();
+    if (package < begin || package >= TIterator(mPackages.end()))
+        throw std::runtime_error("can't find package to erase");
+
+    return mPackages.erase(mPackages.begin() + (package - begin));
 }
 
 bool AiSequence::isInCombat() const
 {
-    for(std::list<AiPackage*>::const_iterator it = mPackages.begin(); it != mPackages.end(); ++it)
+    for(TIterator it = mPackages.begin(); it != mPackages.end(); ++it)
     {
         if ((*it)->getTypeId() == AiPackage::TypeIdCombat)
             return true;
@@ -110,7 +108,7 @@ bool AiSequence::isInCombat() const
 
 bool AiSequence::isInCombat(const MWWorld::Ptr &actor) const
 {
-    for(std::list<AiPackage*>::const_iterator it = mPackages.begin(); it != mPackages.end(); ++it)
+    for(TIterator it = mPackages.begin(); it != mPackages.end(); ++it)
     {
         if ((*it)->getTypeId() == AiPackage::TypeIdCombat)
         {
@@ -124,7 +122,7 @@ bool AiSequence::isInCombat(const MWWorld::Ptr &actor) const
 
 void AiSequence::stopCombat()
 {
-    for(std::list<AiPackage*>::iterator it = mPackages.begin(); it != mPackages.end(); )
+    for(TContainer::iterator it = mPackages.begin(); it != mPackages.end(); )
     {
         if ((*it)->getTypeId() == AiPackage::TypeIdCombat)
             it = mPackages.erase(it);
@@ -135,7 +133,7 @@ void AiSequence::stopCombat()
 
 void AiSequence::stopPursuit()
 {
-    for(std::list<AiPackage*>::iterator it = mPackages.begin(); it != mPackages.end(); )
+    for(TContainer::iterator it = mPackages.begin(); it != mPackages.end(); )
     {
         if ((*it)->getTypeId() == AiPackage::TypeIdPursue)
             it = mPackages.erase(it);
@@ -161,12 +159,12 @@ void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& charac
             // if active package is combat one, choose nearest target
             if (mLastAiPackage == AiPackage::TypeIdCombat)
             {
-                std::list<AiPackage *>::iterator itActualCombat;
+                TContainer::iterator itActualCombat;
 
                 float nearestDist = std::numeric_limits<float>::max();
                 osg::Vec3f vActorPos = actor.getRefData().getPosition().asVec3();
 
-                for(std::list<AiPackage *>::iterator it = mPackages.begin(); it != mPackages.end();)
+                for(TContainer::iterator it = mPackages.begin(); it != mPackages.end();)
                 {
                     if ((*it)->getTypeId() != AiPackage::TypeIdCombat) break;
 
@@ -202,7 +200,7 @@ void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& charac
                     if (nearestDist < std::numeric_limits<float>::max() && mPackages.begin() != itActualCombat)
                     {
                         // move combat package with nearest target to the front
-                        mPackages.splice(mPackages.begin(), mPackages, itActualCombat);
+                        std::rotate(mPackages.begin(), itActualCombat, itActualCombat + 1);
                     }
 
                     package = mPackages.front();
@@ -219,8 +217,7 @@ void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& charac
             {
                 // To account for the rare case where AiPackage::execute() queued another AI package
                 // (e.g. AiPursue executing a dialogue script that uses startCombat)
-                std::list<MWMechanics::AiPackage*>::iterator toRemove =
-                        std::find(mPackages.begin(), mPackages.end(), package);
+                TContainer::iterator toRemove = std::find(mPackages.begin(), mPackages.end(), package);
                 mPackages.erase(toRemove);
                 delete package;
                 mDone = true;
@@ -233,9 +230,15 @@ void AiSequence::execute (const MWWorld::Ptr& actor, CharacterController& charac
     }
 }
 
+void AiSequence::steer (const MWWorld::Ptr& actor, float duration)
+{
+    if (actor != getPlayer() && !mPackages.empty())
+        mPackages.front()->steer(actor, duration);
+}
+
 void AiSequence::clear()
 {
-    for (std::list<AiPackage *>::const_iterator iter (mPackages.begin()); iter!=mPackages.end(); ++iter)
+    for (TIterator iter (mPackages.begin()); iter!=mPackages.end(); ++iter)
         delete *iter;
 
     mPackages.clear();
@@ -249,7 +252,7 @@ void AiSequence::stack (const AiPackage& package, const MWWorld::Ptr& actor)
     if (package.getTypeId() == AiPackage::TypeIdCombat || package.getTypeId() == AiPackage::TypeIdPursue)
     {
         // Notify AiWander of our current position so we can return to it after combat finished
-        for (std::list<AiPackage *>::const_iterator iter (mPackages.begin()); iter!=mPackages.end(); ++iter)
+        for (TIterator iter (mPackages.begin()); iter!=mPackages.end(); ++iter)
         {
             if((*iter)->getTypeId() == AiPackage::TypeIdPursue && package.getTypeId() == AiPackage::TypeIdPursue
                 && static_cast<const AiPursue*>(*iter)->getTarget() == static_cast<const AiPursue*>(&package)->getTarget())
@@ -266,7 +269,7 @@ void AiSequence::stack (const AiPackage& package, const MWWorld::Ptr& actor)
         }
     }
 
-    for(std::list<AiPackage *>::iterator it = mPackages.begin(); it != mPackages.end(); ++it)
+    for(TContainer::iterator it = mPackages.begin(); it != mPackages.end(); ++it)
     {
         if((*it)->getPriority() <= package.getPriority())
         {
@@ -275,7 +278,7 @@ void AiSequence::stack (const AiPackage& package, const MWWorld::Ptr& actor)
         }
     }
 
-    mPackages.push_front (package.clone());
+    mPackages.insert (mPackages.begin(), package.clone());
 }
 
 AiPackage* MWMechanics::AiSequence::getActivePackage()
@@ -326,7 +329,7 @@ void AiSequence::fill(const ESM::AIPackageList &list)
 
 void AiSequence::writeState(ESM::AiSequence::AiSequence &sequence) const
 {
-    for (std::list<AiPackage *>::const_iterator iter (mPackages.begin()); iter!=mPackages.end(); ++iter)
+    for (TIterator iter (mPackages.begin()); iter!=mPackages.end(); ++iter)
     {
         (*iter)->writeState(sequence);
     }
@@ -1,7 +1,7 @@
 #ifndef GAME_MWMECHANICS_AISEQUENCE_H
 #define GAME_MWMECHANICS_AISEQUENCE_H
 
-#include <list>
+#include <vector>
 
 #include <components/esm/loadnpc.hpp>
 //#include "aistate.hpp"
@@ -34,8 +34,13 @@ namespace MWMechanics
     /** The top-most AI package is run each frame. When completed, it is removed from the stack. **/
     class AiSequence
     {
-            ///AiPackages to run though
-            std::list<AiPackage *> mPackages;
+        public:
+            typedef std::vector<AiPackage*> TContainer;
+            typedef TContainer::const_iterator TIterator;
+
+        private:
+            ///AiPackages to run though, the first one is active
+            TContainer mPackages;
 
             ///Finished with top AIPackage, set for one frame
             bool mDone;
@@ -59,10 +64,10 @@ namespace MWMechanics
             virtual ~AiSequence();
 
             /// Iterator may be invalidated by any function calls other than begin() or end().
-            std::list<AiPackage*>::const_iterator begin() const;
-            std::list<AiPackage*>::const_iterator end() const;
+            TIterator begin() const;
+            TIterator end() const;
 
-            std::list<AiPackage*>::const_iterator erase (std::list<AiPackage*>::const_iterator package);
+            TIterator erase (TIterator package);
 
             /// Returns currently executing AiPackage type
             /** \see enum AiPackage::TypeId **/
@@ -98,6 +103,9 @@ namespace MWMechanics
             /// Execute current package, switching if needed.
             void execute (const MWWorld::Ptr& actor, CharacterController& characterController, MWMechanics::AiState& state, float duration);
 
+            /// Keep the actor on the path of the current package, for the frames the packages do not run, see AiScheduler.
+            void steer (const MWWorld::Ptr& actor, float duration);
+
             /// Simulate the passing of time using the currently active AI package
             void fastForward(const MWWorld::Ptr &actor, AiState &state);
 
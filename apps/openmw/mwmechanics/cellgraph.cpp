@@ -0,0 +1,299 @@
+#include "cellgraph.hpp"
+
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include <components/esm/loadcell.hpp>
+#include <components/esm/loadland.hpp>
+#include <components/esm/loadpgrd.hpp>
+
+#include "../mwworld/esmstore.hpp"
+
+namespace
+{
+    // Points this close to the border of a cell can be part of a portal
+    const float sBorderDistance = 768.f;
+    // The largest distance between the points of a portal
+    const float sMaxPortalDistance = 1024.f;
+
+    osg::Vec3f toWorld(const ESM::Pathgrid::Point& point, int x, int y)
+    {
+        return osg::Vec3f(static_cast<float>(point.mX + x * ESM::Land::REAL_SIZE),
+                          static_cast<float>(point.mY + y * ESM::Land::REAL_SIZE),
+                          static_cast<float>(point.mZ));
+    }
+
+    int findRoot(std::vector<int>& parents, int point)
+    {
+        while (parents[point] != point)
+        {
+            parents[point] = parents[parents[point]];
+            point = parents[point];
+        }
+        return point;
+    }
+
+    // The edges of a pathgrid always go both ways, so its connected components are the same as its strongly
+    // connected components, and cheaper to find
+    void findComponents(const ESM::Pathgrid& pathgrid, std::vector<int>& components)
+    {
+        components.resize(pathgrid.mPoints.size());
+        for (size_t i = 0; i < components.size(); ++i)
+            components[i] = static_cast<int>(i);
+
+        for (ESM::Pathgrid::EdgeList::const_iterator it = pathgrid.mEdges.begin(); it != pathgrid.mEdges.end(); ++it)
+        {
+            const int root0 = findRoot(components, it->mV0);
+            const int root1 = findRoot(components, it->mV1);
+            if (root0 != root1)
+                components[root0] = root1;
+        }
+
+        for (size_t i = 0; i < components.size(); ++i)
+            components[i] = findRoot(components, static_cast<int>(i));
+    }
+
+    std::pair<int, int> getCellIndex(const osg::Vec3f& position)
+    {
+        return std::make_pair(static_cast<int>(std::floor(position.x() / ESM::Land::REAL_SIZE)),
+                              static_cast<int>(std::floor(position.y() / ESM::Land::REAL_SIZE)));
+    }
+}
+
+namespace MWMechanics
+{
+    CellGraph::CellGraph()
+        : mIsBuilt(false)
+    {
+    }
+
+    void CellGraph::build(const MWWorld::ESMStore& store)
+    {
+        mCells.clear();
+        mNodes.clear();
+
+        const MWWorld::Store<ESM::Pathgrid>& pathgrids = store.get<ESM::Pathgrid>();
+        const MWWorld::Store<ESM::Cell>& cells = store.get<ESM::Cell>();
+        for (MWWorld::Store<ESM::Cell>::iterator it = cells.extBegin(); it != cells.extEnd(); ++it)
+        {
+            const ESM::Pathgrid* pathgrid = pathgrids.search(it->getGridX(), it->getGridY());
+            if (!pathgrid || pathgrid->mPoints.empty())
+                continue;
+
+            Cell& cell = mCells[std::make_pair(it->getGridX(), it->getGridY())];
+            cell.mPathgrid = pathgrid;
+            findComponents(*pathgrid, cell.mComponents);
+        }
+
+        for (CellMap::const_iterator it = mCells.begin(); it != mCells.end(); ++it)
+        {
+            addPortals(it->first.first, it->first.second, 1, 0);
+            addPortals(it->first.first, it->first.second, 0, 1);
+        }
+
+        // Link the portals within each cell
+        for (CellMap::const_iterator it = mCells.begin(); it != mCells.end(); ++it)
+        {
+            const std::map<int, int>& pointNodes = it->second.mPointNodes;
+            for (std::map<int, int>::const_iterator a = pointNodes.begin(); a != pointNodes.end(); ++a)
+            {
+                std::map<int, int>::const_iterator b = a;
+                for (++b; b != pointNodes.end(); ++b)
+                {
+                    if (mNodes[a->second].mComponent != mNodes[b->second].mComponent)
+                        continue;
+                    const float cost = (mNodes[a->second].mPosition - mNodes[b->second].mPosition).length();
+                    addEdge(a->second, b->second, cost);
+                    addEdge(b->second, a->second, cost);
+                }
+            }
+        }
+
+        mIsBuilt = true;
+    }
+
+    void CellGraph::addPortals(int x, int y, int dx, int dy)
+    {
+        CellMap::iterator first = mCells.find(std::make_pair(x, y));
+        CellMap::iterator second = mCells.find(std::make_pair(x + dx, y + dy));
+        if (first == mCells.end() || second == mCells.end())
+            return;
+
+        // The points near the shared border in each cell, in local co-ordinates along the direction
+        const ESM::Pathgrid& firstGrid = *first->second.mPathgrid;
+        const ESM::Pathgrid& secondGrid = *second->second.mPathgrid;
+        std::vector<int> secondPoints;
+        for (int i = 0; i < static_cast<int>(secondGrid.mPoints.size()); ++i)
+        {
+            const int along = dx ? secondGrid.mPoints[i].mX : secondGrid.mPoints[i].mY;
+            if (along < sBorderDistance)
+                secondPoints.push_back(i);
+        }
+        if (secondPoints.empty())
+            return;
+
+        for (int i = 0; i < static_cast<int>(firstGrid.mPoints.size()); ++i)
+        {
+            const int along = dx ? firstGrid.mPoints[i].mX : firstGrid.mPoints[i].mY;
+            if (along < ESM::Land::REAL_SIZE - sBorderDistance)
+                continue;
+
+            // Portal to the closest point on the other side
+            const osg::Vec3f position = toWorld(firstGrid.mPoints[i], x, y);
+            int closest = -1;
+            float closestDistance = sMaxPortalDistance;
+            for (std::vector<int>::const_iterator it = secondPoints.begin(); it != secondPoints.end(); ++it)
+            {
+                const float distance = (toWorld(secondGrid.mPoints[*it], x + dx, y + dy) - position).length();
+                if (distance <= closestDistance)
+                {
+                    closest = *it;
+                    closestDistance = distance;
+                }
+            }
+            if (closest < 0)
+                continue;
+
+            const int from = getNode(first->second, x, y, i);
+            const int to = getNode(second->second, x + dx, y + dy, closest);
+            addEdge(from, to, closestDistance);
+            addEdge(to, from, closestDistance);
+        }
+    }
+
+    int CellGraph::getNode(Cell& cell, int x, int y, int point)
+    {
+        std::map<int, int>::const_iterator found = cell.mPointNodes.find(point);
+        if (found != cell.mPointNodes.end())
+            return found->second;
+
+        Node node;
+        node.mPosition = toWorld(cell.mPathgrid->mPoints[point], x, y);
+        node.mComponent = cell.mComponents[point];
+        mNodes.push_back(node);
+
+        const int index = static_cast<int>(mNodes.size()) - 1;
+        cell.mPointNodes[point] = index;
+        return index;
+    }
+
+    void CellGraph::addEdge(int from, int to, float cost)
+    {
+        std::vector<Edge>& edges = mNodes[from].mEdges;
+        for (std::vector<Edge>::const_iterator it = edges.begin(); it != edges.end(); ++it)
+        {
+            if (it->mNode == to)
+                return;
+        }
+
+        Edge edge;
+        edge.mNode = to;
+        edge.mCost = cost;
+        edges.push_back(edge);
+    }
+
+    void CellGraph::getConnectedNodes(const osg::Vec3f& position, std::vector<int>& nodes) const
+    {
+        const std::pair<int, int> index = getCellIndex(position);
+        CellMap::const_iterator found = mCells.find(index);
+        if (found == mCells.end() || found->second.mPointNodes.empty())
+            return;
+
+        const Cell& cell = found->second;
+        int closest = 0;
+        float closestDistance = std::numeric_limits<float>::max();
+        for (int i = 0; i < static_cast<int>(cell.mPathgrid->mPoints.size()); ++i)
+        {
+            const float distance = (toWorld(cell.mPathgrid->mPoints[i], index.first, index.second) - position).length2();
+            if (distance < closestDistance)
+            {
+                closest = i;
+                closestDistance = distance;
+            }
+        }
+
+        for (std::map<int, int>::const_iterator it = cell.mPointNodes.begin(); it != cell.mPointNodes.end(); ++it)
+        {
+            if (mNodes[it->second].mComponent == cell.mComponents[closest])
+                nodes.push_back(it->second);
+        }
+    }
+
+    bool CellGraph::findPath(const osg::Vec3f& start, const osg::Vec3f& end, std::vector<osg::Vec3f>& waypoints) const
+    {
+        if (getCellIndex(start) == getCellIndex(end))
+            return false;
+
+        std::vector<int> startNodes;
+        std::vector<int> endNodes;
+        getConnectedNodes(start, startNodes);
+        getConnectedNodes(end, endNodes);
+        if (startNodes.empty() || endNodes.empty())
+            return false;
+
+        // A* with the straight distance to the end, from all nodes connected to the start at once. The end is an extra
+        // node after the others, that the nodes connected to it lead to.
+        const int endNode = static_cast<int>(mNodes.size());
+        std::vector<float> scores(mNodes.size() + 1, std::numeric_limits<float>::max());
+        std::vector<int> parents(mNodes.size() + 1, -1);
+        std::vector<bool> closed(mNodes.size() + 1, false);
+        std::vector<bool> isEndNode(mNodes.size(), false);
+        for (std::vector<int>::const_iterator it = endNodes.begin(); it != endNodes.end(); ++it)
+            isEndNode[*it] = true;
+
+        typedef std::pair<float, int> OpenEntry;
+        std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry> > open;
+        for (std::vector<int>::const_iterator it = startNodes.begin(); it != startNodes.end(); ++it)
+        {
+            scores[*it] = (mNodes[*it].mPosition - start).length();
+            open.push(OpenEntry(scores[*it] + (mNodes[*it].mPosition - end).length(), *it));
+        }
+
+        while (!open.empty())
+        {
+            const int current = open.top().second;
+            open.pop();
+            if (current == endNode)
+                break;
+            if (closed[current])
+                continue;
+            closed[current] = true;
+
+            const Node& node = mNodes[current];
+            if (isEndNode[current])
+            {
+                const float score = scores[current] + (node.mPosition - end).length();
+                if (score < scores[endNode])
+                {
+                    scores[endNode] = score;
+                    parents[endNode] = current;
+                    open.push(OpenEntry(score, endNode));
+                }
+            }
+
+            for (std::vector<Edge>::const_iterator it = node.mEdges.begin(); it != node.mEdges.end(); ++it)
+            {
+                if (closed[it->mNode])
+                    continue;
+                const float score = scores[current] + it->mCost;
+                if (score < scores[it->mNode])
+                {
+                    scores[it->mNode] = score;
+                    parents[it->mNode] = current;
+                    open.push(OpenEntry(score + (mNodes[it->mNode].mPosition - end).length(), it->mNode));
+                }
+            }
+        }
+
+        if (parents[endNode] < 0)
+            return false;
+
+        std::vector<osg::Vec3f> reversed;
+        for (int node = parents[endNode]; node >= 0; node = parents[node])
+            reversed.push_back(mNodes[node].mPosition);
+        waypoints.assign(reversed.rbegin(), reversed.rend());
+        return true;
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef GAME_MWMECHANICS_CELLGRAPH_H
+#define GAME_MWMECHANICS_CELLGRAPH_H
+
+#include <map>
+#include <vector>
+
+#include <osg/Vec3f>
+
+namespace ESM
+{
+    struct Pathgrid;
+}
+
+namespace MWWorld
+{
+    class ESMStore;
+}
+
+namespace MWMechanics
+{
+    /// @brief The graph of the points where the pathgrids of neighbouring exterior cells meet, for planning a way
+    /// across cells before the PathgridGraph of each cell refines it.
+    /// @par A portal is a pair of pathgrid points close to each other on both sides of the border of two cells. The
+    /// points of the portals of a cell are linked to each other if they are connected in the pathgrid of the cell.
+    /// The costs of the links are the straight distances, so the planned way is only as short as the pathgrids are
+    /// straight.
+    class CellGraph
+    {
+        public:
+            CellGraph();
+
+            /// Find the portals of all exterior pathgrids.
+            void build(const MWWorld::ESMStore& store);
+
+            bool isBuilt() const { return mIsBuilt; }
+
+            /// Plan the way from start to end, which are in different exterior cells.
+            /// @param waypoints The portal points to walk to in turn, in world co-ordinates, without the start and end.
+            /// @return false if the start and end are in the same cell, or there is no way between them.
+            bool findPath(const osg::Vec3f& start, const osg::Vec3f& end, std::vector<osg::Vec3f>& waypoints) const;
+
+        private:
+            struct Edge
+            {
+                int mNode;
+                float mCost;
+            };
+
+            struct Node
+            {
+                osg::Vec3f mPosition; // world co-ordinates
+                int mComponent; // connected component of the point in the pathgrid of its cell
+                std::vector<Edge> mEdges;
+            };
+
+            struct Cell
+            {
+                const ESM::Pathgrid* mPathgrid;
+                // The connected component of each point
+                std::vector<int> mComponents;
+                // The node of each point that is part of a portal
+                std::map<int, int> mPointNodes;
+            };
+
+            typedef std::map<std::pair<int, int>, Cell> CellMap;
+            CellMap mCells;
+            std::vector<Node> mNodes;
+            bool mIsBuilt;
+
+            /// Connect the points near the border of the cell to the points of the neighbouring cell in the
+            /// direction (dx, dy), which is (1, 0) or (0, 1).
+            void addPortals(int x, int y, int dx, int dy);
+
+            int getNode(Cell& cell, int x, int y, int point);
+
+            void addEdge(int from, int to, float cost);
+
+            /// The nodes of the cell that are connected to the pathgrid point closest to the position.
+            void getConnectedNodes(const osg::Vec3f& position, std::vector<int>& nodes) const;
+    };
+}
+
+#endif
@@ -119,18 +119,18 @@ MWMechanics::CharacterState runStateToWalkState (MWMechanics::CharacterState sta
 float getFallDamage(const MWWorld::Ptr& ptr, float fallHeight)
 {
     MWBase::World *world = MWBase::Environment::get().getWorld();
-    const MWWorld::Store<ESM::GameSetting> &store = world->getStore().get<ESM::GameSetting>();
+    const MWWorld::GmstRegistry &gmsts = world->getStore().getGmsts();
 
-    const float fallDistanceMin = store.find("fFallDamageDistanceMin")->getFloat();
+    const float fallDistanceMin = gmsts.getFloat(MWWorld::GmstRegistry::fFallDamageDistanceMin);
 
     if (fallHeight >= fallDistanceMin)
     {
         const float acrobaticsSkill = static_cast<float>(ptr.getClass().getSkill(ptr, ESM::Skill::Acrobatics));
         const float jumpSpellBonus = ptr.getClass().getCreatureStats(ptr).getMagicEffects().get(ESM::MagicEffect::Jump).getMagnitude();
-        const float fallAcroBase = store.find("fFallAcroBase")->getFloat();
-        const float fallAcroMult = store.find("fFallAcroMult")->getFloat();
-        const float fallDistanceBase = store.find("fFallDistanceBase")->getFloat();
-        const float fallDistanceMult = store.find("fFallDistanceMult")->getFloat();
+        const float fallAcroBase = gmsts.getFloat(MWWorld::GmstRegistry::fFallAcroBase);
+        const float fallAcroMult = gmsts.getFloat(MWWorld::GmstRegistry::fFallAcroMult);
+        const float fallDistanceBase = gmsts.getFloat(MWWorld::GmstRegistry::fFallDistanceBase);
+        const float fallDistanceMult = gmsts.getFloat(MWWorld::GmstRegistry::fFallDistanceMult);
 
         float x = fallHeight - fallDistanceMin;
         x -= (1.5f * acrobaticsSkill) + jumpSpellBonus;
@@ -1279,8 +1279,8 @@ bool CharacterController::updateWeaponState()
                     mAttackType = "shoot";
                 else
                 {
-                    if(isWeapon && mPtr == getPlayer() &&
-                            Settings::Manager::getBool("best attack", "Game"))
+                    static const Settings::Value<bool> bestAttack ("best attack", "Game");
+                    if(isWeapon && mPtr == getPlayer() && bestAttack.get())
                     {
                         MWWorld::ContainerStoreIterator weapon = mPtr.getClass().getInventoryStore(mPtr).getSlot(MWWorld::InventoryStore::Slot_CarriedRight);
                         mAttackType = getBestAttack(weapon->get<ESM::Weapon>()->mBase);
@@ -1610,16 +1610,16 @@ void CharacterController::update(float duration)
         }
 
         // reduce fatigue
-        const MWWorld::Store<ESM::GameSetting> &gmst = world->getStore().get<ESM::GameSetting>();
+        const MWWorld::GmstRegistry &gmsts = world->getStore().getGmsts();
         float fatigueLoss = 0;
-        static const float fFatigueRunBase = gmst.find("fFatigueRunBase")->getFloat();
-        static const float fFatigueRunMult = gmst.find("fFatigueRunMult")->getFloat();
-        static const float fFatigueSwimWalkBase = gmst.find("fFatigueSwimWalkBase")->getFloat();
-        static const float fFatigueSwimRunBase = gmst.find("fFatigueSwimRunBase")->getFloat();
-        static const float fFatigueSwimWalkMult = gmst.find("fFatigueSwimWalkMult")->getFloat();
-        static const float fFatigueSwimRunMult = gmst.find("fFatigueSwimRunMult")->getFloat();
-        static const float fFatigueSneakBase = gmst.find("fFatigueSneakBase")->getFloat();
-        static const float fFatigueSneakMult = gmst.find("fFatigueSneakMult")->getFloat();
+        const float fFatigueRunBase = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueRunBase);
+        const float fFatigueRunMult = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueRunMult);
+        const float fFatigueSwimWalkBase = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueSwimWalkBase);
+        const float fFatigueSwimRunBase = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueSwimRunBase);
+        const float fFatigueSwimWalkMult = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueSwimWalkMult);
+        const float fFatigueSwimRunMult = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueSwimRunMult);
+        const float fFatigueSneakBase = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueSneakBase);
+        const float fFatigueSneakMult = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueSneakMult);
 
         const float encumbrance = cls.getEncumbrance(mPtr) / cls.getCapacity(mPtr);
         if (encumbrance < 1)
@@ -1664,8 +1664,8 @@ void CharacterController::update(float duration)
             forcestateupdate = (mJumpState != JumpState_InAir);
             jumpstate = JumpState_InAir;
 
-            static const float fJumpMoveBase = gmst.find("fJumpMoveBase")->getFloat();
-            static const float fJumpMoveMult = gmst.find("fJumpMoveMult")->getFloat();
+            const float fJumpMoveBase = gmsts.getFloat(MWWorld::GmstRegistry::fJumpMoveBase);
+            const float fJumpMoveMult = gmsts.getFloat(MWWorld::GmstRegistry::fJumpMoveMult);
             float factor = fJumpMoveBase + fJumpMoveMult * mPtr.getClass().getSkill(mPtr, ESM::Skill::Acrobatics)/100.f;
             factor = std::min(1.f, factor);
             vec.x() *= factor;
@@ -1692,9 +1692,8 @@ void CharacterController::update(float duration)
                     cls.skillUsageSucceeded(mPtr, ESM::Skill::Acrobatics, 0);
 
                 // decrease fatigue
-                const MWWorld::Store<ESM::GameSetting> &gmst = world->getStore().get<ESM::GameSetting>();
-                const float fatigueJumpBase = gmst.find("fFatigueJumpBase")->getFloat();
-                const float fatigueJumpMult = gmst.find("fFatigueJumpMult")->getFloat();
+                const float fatigueJumpBase = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueJumpBase);
+                const float fatigueJumpMult = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueJumpMult);
                 float normalizedEncumbrance = mPtr.getClass().getNormalizedEncumbrance(mPtr);
                 if (normalizedEncumbrance > 1)
                     normalizedEncumbrance = 1;
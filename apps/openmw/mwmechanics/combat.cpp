@@ -81,10 +81,10 @@ namespace MWMechanics
                     blocker.getRefData().getBaseNode()->getAttitude() * osg::Vec3f(0,1,0),
                     osg::Vec3f(0,0,1)));
 
-        const MWWorld::Store<ESM::GameSetting>& gmst = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>();
-        if (angleDegrees < gmst.find("fCombatBlockLeftAngle")->getFloat())
+        const MWWorld::GmstRegistry& gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
+        if (angleDegrees < gmsts.getFloat(MWWorld::GmstRegistry::fCombatBlockLeftAngle))
             return false;
-        if (angleDegrees > gmst.find("fCombatBlockRightAngle")->getFloat())
+        if (angleDegrees > gmsts.getFloat(MWWorld::GmstRegistry::fCombatBlockRightAngle))
             return false;
 
         MWMechanics::CreatureStats& attackerStats = attacker.getClass().getCreatureStats(attacker);
@@ -92,11 +92,11 @@ namespace MWMechanics
         float blockTerm = blocker.getClass().getSkill(blocker, ESM::Skill::Block) + 0.2f * blockerStats.getAttribute(ESM::Attribute::Agility).getModified()
             + 0.1f * blockerStats.getAttribute(ESM::Attribute::Luck).getModified();
         float enemySwing = attackStrength;
-        float swingTerm = enemySwing * gmst.find("fSwingBlockMult")->getFloat() + gmst.find("fSwingBlockBase")->getFloat();
+        float swingTerm = enemySwing * gmsts.getFloat(MWWorld::GmstRegistry::fSwingBlockMult) + gmsts.getFloat(MWWorld::GmstRegistry::fSwingBlockBase);
 
         float blockerTerm = blockTerm * swingTerm;
         if (blocker.getClass().getMovementSettings(blocker).mPosition[1] <= 0)
-            blockerTerm *= gmst.find("fBlockStillBonus")->getFloat();
+            blockerTerm *= gmsts.getFloat(MWWorld::GmstRegistry::fBlockStillBonus);
         blockerTerm *= blockerStats.getFatigueTerm();
 
         int attackerSkill = 0;
@@ -109,8 +109,8 @@ namespace MWMechanics
         attackerTerm *= attackerStats.getFatigueTerm();
 
         int x = int(blockerTerm - attackerTerm);
-        int iBlockMaxChance = gmst.find("iBlockMaxChance")->getInt();
-        int iBlockMinChance = gmst.find("iBlockMinChance")->getInt();
+        int iBlockMaxChance = gmsts.getInt(MWWorld::GmstRegistry::iBlockMaxChance);
+        int iBlockMinChance = gmsts.getInt(MWWorld::GmstRegistry::iBlockMinChance);
         x = std::min(iBlockMaxChance, std::max(iBlockMinChance, x));
 
         if (Misc::Rng::roll0to99() < x)
@@ -124,9 +124,9 @@ namespace MWMechanics
                 inv.unequipItem(*shield, blocker);
 
             // Reduce blocker fatigue
-            const float fFatigueBlockBase = gmst.find("fFatigueBlockBase")->getFloat();
-            const float fFatigueBlockMult = gmst.find("fFatigueBlockMult")->getFloat();
-            const float fWeaponFatigueBlockMult = gmst.find("fWeaponFatigueBlockMult")->getFloat();
+            const float fFatigueBlockBase = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueBlockBase);
+            const float fFatigueBlockMult = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueBlockMult);
+            const float fWeaponFatigueBlockMult = gmsts.getFloat(MWWorld::GmstRegistry::fWeaponFatigueBlockMult);
             MWMechanics::DynamicStat<float> fatigue = blockerStats.getFatigue();
             float normalizedEncumbrance = blocker.getClass().getNormalizedEncumbrance(blocker);
             normalizedEncumbrance = std::min(1.f, normalizedEncumbrance);
@@ -160,7 +160,7 @@ namespace MWMechanics
 
         if ((weapon.get<ESM::Weapon>()->mBase->mData.mFlags & ESM::Weapon::Silver)
                 && actor.getClass().isNpc() && actor.getClass().getNpcStats(actor).isWerewolf())
-            damage *= MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find("fWereWolfSilverWeaponDamageMult")->getFloat();
+            damage *= MWBase::Environment::get().getWorld()->getStore().getGmsts().getFloat(MWWorld::GmstRegistry::fWereWolfSilverWeaponDamageMult);
 
         if (damage == 0 && attacker == getPlayer())
             MWBase::Environment::get().getWindowManager()->messageBox("#{sMagicTargetResistsWeapons}");
@@ -170,7 +170,7 @@ namespace MWMechanics
                        const osg::Vec3f& hitPosition, float attackStrength)
     {
         MWBase::World *world = MWBase::Environment::get().getWorld();
-        const MWWorld::Store<ESM::GameSetting> &gmst = world->getStore().get<ESM::GameSetting>();
+        const MWWorld::GmstRegistry &gmsts = world->getStore().getGmsts();
 
         if(victim.isEmpty() || !victim.getClass().isActor() || victim.getClass().getCreatureStats(victim).isDead())
             // Can't hit non-actors or dead actors
@@ -212,7 +212,7 @@ namespace MWMechanics
             attacker.getClass().skillUsageSucceeded(attacker, weapskill, 0);
 
         if (victim.getClass().getCreatureStats(victim).getKnockedDown())
-            damage *= gmst.find("fCombatKODamageMult")->getFloat();
+            damage *= gmsts.getFloat(MWWorld::GmstRegistry::fCombatKODamageMult);
 
         // Apply "On hit" effect of the weapon
         bool appliedEnchantment = applyEnchantment(attacker, victim, weapon, hitPosition);
@@ -226,7 +226,7 @@ namespace MWMechanics
         if (victim != getPlayer()
                 && !appliedEnchantment)
         {
-            float fProjectileThrownStoreChance = gmst.find("fProjectileThrownStoreChance")->getFloat();
+            float fProjectileThrownStoreChance = gmsts.getFloat(MWWorld::GmstRegistry::fProjectileThrownStoreChance);
             if (Misc::Rng::rollProbability() < fProjectileThrownStoreChance / 100.f)
                 victim.getClass().getContainerStore(victim).add(projectile, 1, victim);
         }
@@ -240,7 +240,7 @@ namespace MWMechanics
         const MWMechanics::MagicEffects &mageffects = stats.getMagicEffects();
 
         MWBase::World *world = MWBase::Environment::get().getWorld();
-        const MWWorld::Store<ESM::GameSetting> &gmst = world->getStore().get<ESM::GameSetting>();
+        const MWWorld::GmstRegistry &gmsts = world->getStore().getGmsts();
 
         float defenseTerm = 0;
         MWMechanics::CreatureStats& victimStats = victim.getClass().getCreatureStats(victim);
@@ -257,10 +257,10 @@ namespace MWMechanics
                 defenseTerm = victimStats.getEvasion();
             }
             defenseTerm += std::min(100.f,
-                                    gmst.find("fCombatInvisoMult")->getFloat() *
+                                    gmsts.getFloat(MWWorld::GmstRegistry::fCombatInvisoMult) *
                                     victimStats.getMagicEffects().get(ESM::MagicEffect::Chameleon).getMagnitude());
             defenseTerm += std::min(100.f,
-                                    gmst.find("fCombatInvisoMult")->getFloat() *
+                                    gmsts.getFloat(MWWorld::GmstRegistry::fCombatInvisoMult) *
                                     victimStats.getMagicEffects().get(ESM::MagicEffect::Invisibility).getMagnitude());
         }
         float attackTerm = skillValue +
@@ -306,7 +306,7 @@ namespace MWMechanics
 
             x = std::min(100.f, x + elementResistance);
 
-            static const float fElementalShieldMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find("fElementalShieldMult")->getFloat();
+            const float fElementalShieldMult = MWBase::Environment::get().getWorld()->getStore().getGmsts().getFloat(MWWorld::GmstRegistry::fElementalShieldMult);
             x = fElementalShieldMult * magnitude * (1.f - 0.01f * x);
 
             // Note swapped victim and attacker, since the attacker takes the damage here.
@@ -331,7 +331,7 @@ namespace MWMechanics
         {
             int weaphealth = weapon.getClass().getItemHealth(weapon);
 
-            const float fWeaponDamageMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find("fWeaponDamageMult")->getFloat();
+            const float fWeaponDamageMult = MWBase::Environment::get().getWorld()->getStore().getGmsts().getFloat(MWWorld::GmstRegistry::fWeaponDamageMult);
             float x = std::max(1.f, fWeaponDamageMult * damage);
 
             weaphealth -= std::min(int(x), weaphealth);
@@ -356,10 +356,9 @@ namespace MWMechanics
             damage *= (float(weaphealth) / weapmaxhealth);
         }
 
-        static const float fDamageStrengthBase = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                .find("fDamageStrengthBase")->getFloat();
-        static const float fDamageStrengthMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                .find("fDamageStrengthMult")->getFloat();
+        const MWWorld::GmstRegistry& gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
+        const float fDamageStrengthBase = gmsts.getFloat(MWWorld::GmstRegistry::fDamageStrengthBase);
+        const float fDamageStrengthMult = gmsts.getFloat(MWWorld::GmstRegistry::fDamageStrengthMult);
         damage *= fDamageStrengthBase +
                 (attacker.getClass().getCreatureStats(attacker).getAttribute(ESM::Attribute::Strength).getModified() * fDamageStrengthMult * 0.1f);
     }
@@ -370,8 +369,8 @@ namespace MWMechanics
         // calculations. Some mods recommend using it, so we may want to include an
         // option for it.
         const MWWorld::ESMStore& store = MWBase::Environment::get().getWorld()->getStore();
-        float minstrike = store.get<ESM::GameSetting>().find("fMinHandToHandMult")->getFloat();
-        float maxstrike = store.get<ESM::GameSetting>().find("fMaxHandToHandMult")->getFloat();
+        float minstrike = store.getGmsts().getFloat(MWWorld::GmstRegistry::fMinHandToHandMult);
+        float maxstrike = store.getGmsts().getFloat(MWWorld::GmstRegistry::fMaxHandToHandMult);
         damage  = static_cast<float>(attacker.getClass().getSkill(attacker, ESM::Skill::HandToHand));
         damage *= minstrike + ((maxstrike-minstrike)*attackStrength);
 
@@ -386,7 +385,7 @@ namespace MWMechanics
             damage *= MWBase::Environment::get().getWorld()->getGlobalFloat("werewolfclawmult");
         }
         if(healthdmg)
-            damage *= store.get<ESM::GameSetting>().find("fHandtoHandHealthPer")->getFloat();
+            damage *= store.getGmsts().getFloat(MWWorld::GmstRegistry::fHandtoHandHealthPer);
 
         MWBase::SoundManager *sndMgr = MWBase::Environment::get().getSoundManager();
         if(isWerewolf)
@@ -402,10 +401,10 @@ namespace MWMechanics
     void applyFatigueLoss(const MWWorld::Ptr &attacker, const MWWorld::Ptr &weapon, float attackStrength)
     {
         // somewhat of a guess, but using the weapon weight makes sense
-        const MWWorld::Store<ESM::GameSetting>& store = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>();
-        const float fFatigueAttackBase = store.find("fFatigueAttackBase")->getFloat();
-        const float fFatigueAttackMult = store.find("fFatigueAttackMult")->getFloat();
-        const float fWeaponFatigueMult = store.find("fWeaponFatigueMult")->getFloat();
+        const MWWorld::GmstRegistry& gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
+        const float fFatigueAttackBase = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueAttackBase);
+        const float fFatigueAttackMult = gmsts.getFloat(MWWorld::GmstRegistry::fFatigueAttackMult);
+        const float fWeaponFatigueMult = gmsts.getFloat(MWWorld::GmstRegistry::fWeaponFatigueMult);
         CreatureStats& stats = attacker.getClass().getCreatureStats(attacker);
         MWMechanics::DynamicStat<float> fatigue = stats.getFatigue();
         const float normalizedEncumbrance = attacker.getClass().getNormalizedEncumbrance(attacker);
@@ -26,6 +26,8 @@ namespace MWMechanics
     {
         for (int i=0; i<4; ++i)
             mAiSettings[i] = 0;
+        for (int i=0; i<3; ++i)
+            mMagicEffectSources[i] = 0;
     }
 
     const AiSequence& CreatureStats::getAiSequence() const
@@ -209,6 +211,25 @@ namespace MWMechanics
             mRecalcMagicka = true;
 
         mMagicEffects.setModifiers(effects);
+
+        for (int i=0; i<3; ++i)
+            mMagicEffectSources[i] = 0;
+    }
+
+    bool CreatureStats::haveMagicEffectSourcesChanged(unsigned int spells, unsigned int activeSpells, unsigned int inventory) const
+    {
+        return mMagicEffectSources[0] != spells || mMagicEffectSources[1] != activeSpells
+                || mMagicEffectSources[2] != inventory;
+    }
+
+    void CreatureStats::modifyMagicEffects(const MagicEffects &effects, unsigned int spells, unsigned int activeSpells,
+                                           unsigned int inventory)
+    {
+        modifyMagicEffects(effects);
+
+        mMagicEffectSources[0] = spells;
+        mMagicEffectSources[1] = activeSpells;
+        mMagicEffectSources[2] = inventory;
     }
 
     void CreatureStats::setAiSetting (AiSetting index, Stat<int> value)
@@ -554,6 +575,8 @@ namespace MWMechanics
         mActiveSpells.readState(state.mActiveSpells);
         mAiSequence.readState(state.mAiSequence);
         mMagicEffects.readState(state.mMagicEffects);
+        for (int i=0; i<3; ++i)
+            mMagicEffectSources[i] = 0;
 
         mSummonedCreatures = state.mSummonedCreatureMap;
         mSummonGraveyard = state.mSummonGraveyard;
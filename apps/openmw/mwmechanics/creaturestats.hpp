@@ -31,6 +31,9 @@ namespace MWMechanics
         Spells mSpells;
         ActiveSpells mActiveSpells;
         MagicEffects mMagicEffects;
+        // The states of the spells, active spells and inventory that the modifiers of mMagicEffects were last set
+        // from, or 0, see MagicEffects::getStateId
+        unsigned int mMagicEffectSources[3];
         Stat<int> mAiSettings[4];
         AiSequence mAiSequence;
         bool mDead;
@@ -133,6 +136,14 @@ namespace MWMechanics
         /// Set Modifier for each magic effect according to \a effects. Does not touch Base values.
         void modifyMagicEffects(const MagicEffects &effects);
 
+        /// @return Did the given sources change since the last modifyMagicEffects from them?
+        /// @param inventory 0 for actors without an inventory store
+        bool haveMagicEffectSourcesChanged(unsigned int spells, unsigned int activeSpells, unsigned int inventory) const;
+
+        /// Set Modifier for each magic effect according to \a effects, which are the sum of the given sources.
+        void modifyMagicEffects(const MagicEffects &effects, unsigned int spells, unsigned int activeSpells,
+                                unsigned int inventory);
+
         void setAttackingOrSpell(bool attackingOrSpell);
 
         void setLevel(int level);
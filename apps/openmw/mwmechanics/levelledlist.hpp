@@ -7,7 +7,6 @@
 
 #include "../mwworld/ptr.hpp"
 #include "../mwworld/esmstore.hpp"
-#include "../mwworld/manualref.hpp"
 #include "../mwworld/class.hpp"
 #include "../mwbase/world.hpp"
 #include "../mwbase/environment.hpp"
@@ -20,7 +19,8 @@ namespace MWMechanics
     /// @return ID of resulting item, or empty if none
     inline std::string getLevelledItem (const ESM::LevelledListBase* levItem, bool creature, unsigned char failChance=0)
     {
-        const std::vector<ESM::LevelledListBase::LevelItem>& items = levItem->mList;
+        const MWWorld::LevelledListTables::Table& table =
+                MWBase::Environment::get().getWorld()->getStore().getLevelledLists().get(*levItem);
 
         const MWWorld::Ptr& player = getPlayer();
         int playerLevel = player.getClass().getCreatureStats(player).getLevel();
@@ -30,55 +30,30 @@ namespace MWMechanics
         if (Misc::Rng::roll0to99() < failChance)
             return std::string();
 
-        std::vector<std::string> candidates;
-        int highestLevel = 0;
-        for (std::vector<ESM::LevelledListBase::LevelItem>::const_iterator it = items.begin(); it != items.end(); ++it)
-        {
-            if (it->mLevel > highestLevel && it->mLevel <= playerLevel)
-                highestLevel = it->mLevel;
-        }
-
         // For levelled creatures, the flags are swapped. This file format just makes so much sense.
         bool allLevels = (levItem->mFlags & ESM::ItemLevList::AllLevels) != 0;
         if (creature)
             allLevels = levItem->mFlags & ESM::CreatureLevList::AllLevels;
 
-        std::pair<int, std::string> highest = std::make_pair(-1, "");
-        for (std::vector<ESM::LevelledListBase::LevelItem>::const_iterator it = items.begin(); it != items.end(); ++it)
-        {
-            if (playerLevel >= it->mLevel
-                    && (allLevels || it->mLevel == highestLevel))
-            {
-                candidates.push_back(it->mId);
-                if (it->mLevel >= highest.first)
-                    highest = std::make_pair(it->mLevel, it->mId);
-            }
-        }
-        if (candidates.empty())
+        std::pair<MWWorld::LevelledListTables::Table::iterator, MWWorld::LevelledListTables::Table::iterator> candidates =
+                table.getCandidates(playerLevel, allLevels);
+        if (candidates.first == candidates.second)
             return std::string();
-        std::string item = candidates[Misc::Rng::rollDice(candidates.size())];
+        const MWWorld::LevelledListTables::Entry& item =
+                *(candidates.first + Misc::Rng::rollDice(static_cast<int>(candidates.second - candidates.first)));
 
         // Vanilla doesn't fail on nonexistent items in levelled lists
-        if (!MWBase::Environment::get().getWorld()->getStore().find(Misc::StringUtils::lowerCase(item)))
+        if (!item.mExists)
         {
-            std::cerr << "Warning: ignoring nonexistent item '" << item << "' in levelled list '" << levItem->mId << "'" << std::endl;
+            std::cerr << "Warning: ignoring nonexistent item '" << item.mId << "' in levelled list '" << levItem->mId << "'" << std::endl;
             return std::string();
         }
 
         // Is this another levelled item or a real item?
-        MWWorld::ManualRef ref (MWBase::Environment::get().getWorld()->getStore(), item, 1);
-        if (ref.getPtr().getTypeName() != typeid(ESM::ItemLevList).name()
-                && ref.getPtr().getTypeName() != typeid(ESM::CreatureLevList).name())
-        {
-            return item;
-        }
+        if (!item.mList)
+            return item.mId;
         else
-        {
-            if (ref.getPtr().getTypeName() == typeid(ESM::ItemLevList).name())
-                return getLevelledItem(ref.getPtr().get<ESM::ItemLevList>()->mBase, false, failChance);
-            else
-                return getLevelledItem(ref.getPtr().get<ESM::CreatureLevList>()->mBase, true, failChance);
-        }
+            return getLevelledItem(item.mList, item.mCreatureList, failChance);
     }
 
 }
@@ -1,12 +1,26 @@
 #include "magiceffects.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 
 #include <stdexcept>
 
+#include <OpenThreads/Atomic>
+
 #include <components/esm/effectlist.hpp>
 #include <components/esm/magiceffects.hpp>
 
+namespace
+{
+    // The actors update their effects on several threads
+    OpenThreads::Atomic sNextStateId;
+
+    bool isKeyLess (const MWMechanics::MagicEffects::Collection::value_type& left, const MWMechanics::EffectKey& right)
+    {
+        return left.first < right;
+    }
+}
+
 namespace MWMechanics
 {
     EffectKey::EffectKey() : mId (0), mArg (-1) {}
@@ -86,28 +100,81 @@ namespace MWMechanics
         return *this;
     }
 
+    MagicEffects::MagicEffects()
+    {
+        updateIndex();
+        flagAsModified();
+    }
+
+    void MagicEffects::flagAsModified()
+    {
+        mStateId = ++sNextStateId;
+    }
+
+    int MagicEffects::find (const EffectKey& key) const
+    {
+        if (key.mArg == -1 && key.mId >= 0 && key.mId < ESM::MagicEffect::Length)
+            return mIndex[key.mId];
+
+        Collection::const_iterator iter = std::lower_bound (mCollection.begin(), mCollection.end(), key, isKeyLess);
+        if (iter==mCollection.end() || key < iter->first)
+            return -1;
+        return static_cast<int>(iter - mCollection.begin());
+    }
+
+    int MagicEffects::insert (const EffectKey& key, const EffectParam& param)
+    {
+        Collection::iterator iter = std::lower_bound (mCollection.begin(), mCollection.end(), key, isKeyLess);
+        iter = mCollection.insert (iter, std::make_pair (key, param));
+        updateIndex();
+        return static_cast<int>(iter - mCollection.begin());
+    }
+
+    void MagicEffects::updateIndex()
+    {
+        std::fill (mIndex, mIndex + ESM::MagicEffect::Length, -1);
+        for (size_t i = 0; i < mCollection.size(); ++i)
+        {
+            const EffectKey& key = mCollection[i].first;
+            if (key.mArg == -1 && key.mId >= 0 && key.mId < ESM::MagicEffect::Length)
+                mIndex[key.mId] = static_cast<short>(i);
+        }
+    }
+
     void MagicEffects::remove(const EffectKey &key)
     {
-        mCollection.erase(key);
+        int index = find (key);
+        if (index != -1)
+        {
+            mCollection.erase (mCollection.begin() + index);
+            updateIndex();
+            flagAsModified();
+        }
     }
 
     void MagicEffects::add (const EffectKey& key, const EffectParam& param)
     {
-        Collection::iterator iter = mCollection.find (key);
+        int index = find (key);
 
-        if (iter==mCollection.end())
+        if (index==-1)
         {
-            mCollection.insert (std::make_pair (key, param));
+            insert (key, param);
         }
         else
         {
-            iter->second += param;
+            mCollection[index].second += param;
         }
+
+        flagAsModified();
     }
 
     void MagicEffects::modifyBase(const EffectKey &key, int diff)
     {
-        mCollection[key].modifyBase(diff);
+        int index = find (key);
+        if (index==-1)
+            index = insert (key, EffectParam());
+        mCollection[index].second.modifyBase(diff);
+        flagAsModified();
     }
 
     void MagicEffects::setModifiers(const MagicEffects &effects)
@@ -119,43 +186,57 @@ namespace MWMechanics
 
         for (Collection::const_iterator it = effects.begin(); it != effects.end(); ++it)
         {
-            mCollection[it->first].setModifier(it->second.getModifier());
+            if (find(it->first) == -1)
+            {
+                EffectParam param;
+                param.setModifier(it->second.getModifier());
+                insert(it->first, param);
+            }
         }
+
+        flagAsModified();
     }
 
     MagicEffects& MagicEffects::operator+= (const MagicEffects& effects)
     {
-        if (this==&effects)
-        {
-            MagicEffects temp (effects);
-            *this += temp;
-            return *this;
-        }
+        // Merge the two sorted collections
+        Collection result;
+        result.reserve (mCollection.size() + effects.mCollection.size());
 
-        for (Collection::const_iterator iter (effects.begin()); iter!=effects.end(); ++iter)
+        Collection::const_iterator left = mCollection.begin();
+        Collection::const_iterator right = effects.mCollection.begin();
+        while (left!=mCollection.end() || right!=effects.mCollection.end())
         {
-            Collection::iterator result = mCollection.find (iter->first);
-
-            if (result!=mCollection.end())
-                result->second += iter->second;
+            if (right==effects.mCollection.end() || (left!=mCollection.end() && left->first < right->first))
+                result.push_back (*left++);
+            else if (left==mCollection.end() || right->first < left->first)
+                result.push_back (*right++);
             else
-                mCollection.insert (*iter);
+            {
+                result.push_back (std::make_pair (left->first, left->second + right->second));
+                ++left;
+                ++right;
+            }
         }
 
+        mCollection.swap (result);
+        updateIndex();
+        flagAsModified();
+
         return *this;
     }
 
     EffectParam MagicEffects::get (const EffectKey& key) const
     {
-        Collection::const_iterator iter = mCollection.find (key);
+        int index = find (key);
 
-        if (iter==mCollection.end())
+        if (index==-1)
         {
             return EffectParam();
         }
         else
         {
-            return iter->second;
+            return mCollection[index].second;
         }
     }
 
@@ -166,9 +247,9 @@ namespace MWMechanics
         // adding/changing
         for (Collection::const_iterator iter (now.begin()); iter!=now.end(); ++iter)
         {
-            Collection::const_iterator other = prev.mCollection.find (iter->first);
+            int other = prev.find (iter->first);
 
-            if (other==prev.end())
+            if (other==-1)
             {
                 // adding
                 result.add (iter->first, iter->second);
@@ -176,15 +257,14 @@ namespace MWMechanics
             else
             {
                 // changing
-                result.add (iter->first, iter->second - other->second);
+                result.add (iter->first, iter->second - prev.mCollection[other].second);
             }
         }
 
         // removing
         for (Collection::const_iterator iter (prev.begin()); iter!=prev.end(); ++iter)
         {
-            Collection::const_iterator other = now.mCollection.find (iter->first);
-            if (other==now.end())
+            if (now.find (iter->first)==-1)
             {
                 result.add (iter->first, EffectParam() - iter->second);
             }
@@ -210,7 +290,15 @@ namespace MWMechanics
     {
         for (std::map<int, int>::const_iterator it = state.mEffects.begin(); it != state.mEffects.end(); ++it)
         {
-            mCollection[EffectKey(it->first)].setBase(it->second);
+            EffectParam param;
+            param.setBase(it->second);
+            int index = find(EffectKey(it->first));
+            if (index==-1)
+                insert(EffectKey(it->first), param);
+            else
+                mCollection[index].second.setBase(it->second);
         }
+
+        flagAsModified();
     }
 }
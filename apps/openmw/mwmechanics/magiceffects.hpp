@@ -1,8 +1,10 @@
 #ifndef GAME_MWMECHANICS_MAGICEFFECTS_H
 #define GAME_MWMECHANICS_MAGICEFFECTS_H
 
-#include <map>
 #include <string>
+#include <vector>
+
+#include <components/esm/loadmgef.hpp>
 
 namespace ESM
 {
@@ -80,18 +82,43 @@ namespace MWMechanics
     };
 
     /// \brief Effects currently affecting a NPC or creature
+    /// @par The effects are kept in a vector sorted by key, with the position of each effect without a skill or
+    /// attribute argument indexed by its id, so that the frequent lookups of these effects do not need a search.
     class MagicEffects
     {
         public:
 
-            typedef std::map<EffectKey, EffectParam> Collection;
+            typedef std::vector<std::pair<EffectKey, EffectParam> > Collection;
 
         private:
 
             Collection mCollection;
 
+            // The position in mCollection of the effect with each id and without an argument, or -1
+            short mIndex[ESM::MagicEffect::Length];
+
+            /// @return The position of the effect in mCollection, or -1 if it is not present.
+            int find (const EffectKey& key) const;
+
+            /// Add an effect that is not present yet.
+            /// @return Its position in mCollection.
+            int insert (const EffectKey& key, const EffectParam& param);
+
+            void updateIndex();
+
+            // Identifies the contents, see getStateId()
+            unsigned int mStateId;
+
+            void flagAsModified();
+
         public:
 
+            MagicEffects();
+
+            /// @return A number that is different for each change of any MagicEffects, and the same for copies,
+            /// so that sums of effects only need to be calculated again when one of their parts changed.
+            unsigned int getStateId() const { return mStateId; }
+
             Collection::const_iterator begin() const { return mCollection.begin(); }
 
             Collection::const_iterator end() const { return mCollection.end(); }
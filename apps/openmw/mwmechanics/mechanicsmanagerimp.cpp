@@ -3,6 +3,7 @@
 #include <limits.h>
 
 #include <components/misc/rng.hpp>
+#include <components/misc/profiler.hpp>
 
 #include <components/esm/esmwriter.hpp>
 #include <components/esm/stolenitems.hpp>
@@ -19,6 +20,7 @@
 
 #include "../mwworld/class.hpp"
 #include "../mwworld/player.hpp"
+#include "../mwworld/cellloadstats.hpp"
 
 #include "../mwmechanics/aicombat.hpp"
 #include "../mwmechanics/aipursue.hpp"
@@ -320,6 +322,7 @@ namespace MWMechanics
 
     void MechanicsManager::add(const MWWorld::Ptr& ptr)
     {
+        MWWorld::CellLoadStats::ScopedPhase phase (MWWorld::CellLoadStats::Phase_Mechanics);
         if(ptr.getClass().isActor())
             mActors.addActor(ptr);
         else
@@ -358,6 +361,11 @@ namespace MWMechanics
         mWatched = ptr;
     }
 
+    void MechanicsManager::reportStats(unsigned int frameNumber, osg::Stats& stats) const
+    {
+        mActors.reportStats(frameNumber, stats);
+    }
+
     void MechanicsManager::advanceTime (float duration)
     {
         // Uses ingame time, but scaled to real time
@@ -368,6 +376,8 @@ namespace MWMechanics
 
     void MechanicsManager::update(float duration, bool paused)
     {
+        OPENMW_PROFILE_ZONE ("MechanicsManager::update");
+
         if(!mWatched.isEmpty())
         {
             MWBase::WindowManager *winMgr = MWBase::Environment::get().getWindowManager();
@@ -499,9 +509,9 @@ namespace MWMechanics
         mObjects.update(duration, paused);
     }
 
-    void MechanicsManager::rest(bool sleep)
+    void MechanicsManager::rest(int hours, bool sleep)
     {
-        mActors.restoreDynamicStats (sleep);
+        mActors.restoreDynamicStats (hours, sleep);
         mActors.fastForwardAi();
     }
 
@@ -956,25 +966,25 @@ namespace MWMechanics
     std::vector<std::pair<std::string, int> > MechanicsManager::getStolenItemOwners(const std::string& itemid)
     {
         std::vector<std::pair<std::string, int> > result;
-        StolenItemsMap::const_iterator it = mStolenItems.find(Misc::StringUtils::lowerCase(itemid));
+        StolenItemsMap::const_iterator it = mStolenItems.find(ESM::RefId(itemid));
         if (it == mStolenItems.end())
             return result;
         else
         {
             const OwnerMap& owners = it->second;
             for (OwnerMap::const_iterator ownerIt = owners.begin(); ownerIt != owners.end(); ++ownerIt)
-                result.push_back(std::make_pair(ownerIt->first.first, ownerIt->second));
+                result.push_back(std::make_pair(ownerIt->first.first.getRefIdString(), ownerIt->second));
             return result;
         }
     }
 
     bool MechanicsManager::isItemStolenFrom(const std::string &itemid, const std::string &ownerid)
     {
-        StolenItemsMap::const_iterator it = mStolenItems.find(Misc::StringUtils::lowerCase(itemid));
+        StolenItemsMap::const_iterator it = mStolenItems.find(ESM::RefId(itemid));
         if (it == mStolenItems.end())
             return false;
         const OwnerMap& owners = it->second;
-        OwnerMap::const_iterator ownerFound = owners.find(std::make_pair(Misc::StringUtils::lowerCase(ownerid), false));
+        OwnerMap::const_iterator ownerFound = owners.find(std::make_pair(ESM::RefId(ownerid), false));
         return ownerFound != owners.end();
     }
 
@@ -983,7 +993,7 @@ namespace MWMechanics
         MWWorld::ContainerStore& store = player.getClass().getContainerStore(player);
         for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
         {
-            StolenItemsMap::iterator stolenIt = mStolenItems.find(Misc::StringUtils::lowerCase(it->getCellRef().getRefId()));
+            StolenItemsMap::iterator stolenIt = mStolenItems.find(it->getCellRef().getInternedRefId());
             if (stolenIt == mStolenItems.end())
                 continue;
             OwnerMap& owners = stolenIt->second;
@@ -1035,17 +1045,16 @@ namespace MWMechanics
             return;
 
         Owner owner;
-        owner.first = ownerCellRef->getOwner();
+        owner.first = ESM::RefId(ownerCellRef->getOwner());
         owner.second = false;
         if (owner.first.empty())
         {
-            owner.first = ownerCellRef->getFaction();
+            owner.first = ESM::RefId(ownerCellRef->getFaction());
             owner.second = true;
         }
-        Misc::StringUtils::lowerCaseInPlace(owner.first);
 
         if (!Misc::StringUtils::ciEqual(item.getCellRef().getRefId(), MWWorld::ContainerStore::sGoldId))
-            mStolenItems[Misc::StringUtils::lowerCase(item.getCellRef().getRefId())][owner] += count;
+            mStolenItems[item.getCellRef().getInternedRefId()][owner] += count;
 
         commitCrime(ptr, victim, OT_Theft, item.getClass().getValue(item) * count);
     }
@@ -1326,7 +1335,7 @@ namespace MWMechanics
         // Attacking an NPC that is already in combat with any other NPC is not a crime
         AiSequence& seq = targetStats.getAiSequence();
         bool isFightingNpc = false;
-        for (std::list<AiPackage*>::const_iterator it = seq.begin(); it != seq.end(); ++it)
+        for (AiSequence::TIterator it = seq.begin(); it != seq.end(); ++it)
         {
             if ((*it)->getTypeId() == AiPackage::TypeIdCombat)
             {
@@ -1487,6 +1496,13 @@ namespace MWMechanics
         mActors.getObjectsInRange(position, radius, objects);
     }
 
+    bool MechanicsManager::findExteriorPath(const osg::Vec3f& start, const osg::Vec3f& end, std::vector<osg::Vec3f>& waypoints)
+    {
+        if (!mCellGraph.isBuilt())
+            mCellGraph.build(MWBase::Environment::get().getWorld()->getStore());
+        return mCellGraph.findPath(start, end, waypoints);
+    }
+
     std::list<MWWorld::Ptr> MechanicsManager::getActorsSidingWith(const MWWorld::Ptr& actor)
     {
         return mActors.getActorsSidingWith(actor);
@@ -1517,7 +1533,12 @@ namespace MWMechanics
         mActors.write(writer, listener);
 
         ESM::StolenItems items;
-        items.mStolenItems = mStolenItems;
+        for (StolenItemsMap::const_iterator it = mStolenItems.begin(); it != mStolenItems.end(); ++it)
+        {
+            std::map<std::pair<std::string, bool>, int>& owners = items.mStolenItems[it->first.getRefIdString()];
+            for (OwnerMap::const_iterator ownerIt = it->second.begin(); ownerIt != it->second.end(); ++ownerIt)
+                owners[std::make_pair(ownerIt->first.first.getRefIdString(), ownerIt->first.second)] = ownerIt->second;
+        }
         writer.startRecord(ESM::REC_STLN);
         items.write(writer);
         writer.endRecord(ESM::REC_STLN);
@@ -1529,7 +1550,13 @@ namespace MWMechanics
         {
             ESM::StolenItems items;
             items.load(reader);
-            mStolenItems = items.mStolenItems;
+            mStolenItems.clear();
+            for (ESM::StolenItems::StolenItemsMap::const_iterator it = items.mStolenItems.begin(); it != items.mStolenItems.end(); ++it)
+            {
+                OwnerMap& owners = mStolenItems[ESM::RefId(it->first)];
+                for (std::map<std::pair<std::string, bool>, int>::const_iterator ownerIt = it->second.begin(); ownerIt != it->second.end(); ++ownerIt)
+                    owners[std::make_pair(ESM::RefId(ownerIt->first.first), ownerIt->first.second)] += ownerIt->second;
+            }
         }
         else
             mActors.readRecord(reader, type);
@@ -1,6 +1,8 @@
 #ifndef GAME_MWMECHANICS_MECHANICSMANAGERIMP_H
 #define GAME_MWMECHANICS_MECHANICSMANAGERIMP_H
 
+#include <components/esm/refid.hpp>
+
 #include "../mwbase/mechanicsmanager.hpp"
 
 #include "../mwworld/ptr.hpp"
@@ -9,6 +11,7 @@
 #include "npcstats.hpp"
 #include "objects.hpp"
 #include "actors.hpp"
+#include "cellgraph.hpp"
 
 namespace MWWorld
 {
@@ -30,9 +33,11 @@ namespace MWMechanics
             Objects mObjects;
             Actors mActors;
 
-            typedef std::pair<std::string, bool> Owner; // < Owner id, bool isFaction >
+            CellGraph mCellGraph;
+
+            typedef std::pair<ESM::RefId, bool> Owner; // < Owner id, bool isFaction >
             typedef std::map<Owner, int> OwnerMap; // < Owner, number of stolen items with this id from this owner >
-            typedef std::map<std::string, OwnerMap> StolenItemsMap;
+            typedef std::map<ESM::RefId, OwnerMap> StolenItemsMap;
             StolenItemsMap mStolenItems;
 
         public:
@@ -65,6 +70,8 @@ namespace MWMechanics
             /// \param paused In game type does not currently advance (this usually means some GUI
             /// component is up).
 
+            virtual void reportStats (unsigned int frameNumber, osg::Stats& stats) const;
+
             virtual void advanceTime (float duration);
 
             virtual void setPlayerName (const std::string& name);
@@ -82,8 +89,9 @@ namespace MWMechanics
             virtual void setPlayerClass (const ESM::Class& class_);
             ///< Set player class to custom class.
 
-            virtual void rest(bool sleep);
-            ///< If the player is sleeping or waiting, this should be called every hour.
+            virtual void rest(int hours, bool sleep);
+            ///< If the player is sleeping or waiting, this should be called for the hours that passed, after
+            /// advancing the time. Any number of hours is handled in one go.
             /// @param sleep is the player sleeping or waiting?
 
             virtual int getHoursToRest() const;
@@ -150,6 +158,8 @@ namespace MWMechanics
             virtual void getObjectsInRange (const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& objects);
             virtual void getActorsInRange(const osg::Vec3f &position, float radius, std::vector<MWWorld::Ptr> &objects);
 
+            virtual bool findExteriorPath(const osg::Vec3f& start, const osg::Vec3f& end, std::vector<osg::Vec3f>& waypoints);
+
             virtual std::list<MWWorld::Ptr> getActorsSidingWith(const MWWorld::Ptr& actor);
             virtual std::list<MWWorld::Ptr> getActorsFollowing(const MWWorld::Ptr& actor);
             virtual std::list<int> getActorsFollowingIndices(const MWWorld::Ptr& actor);
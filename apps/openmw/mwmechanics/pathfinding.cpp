@@ -184,6 +184,17 @@ namespace MWMechanics
             }
         }
 
+        // The navigation grid, if it is enabled and built, knows the way better than the path grid
+        std::vector<osg::Vec3f> navigationPath;
+        if (MWBase::Environment::get().getWorld()->findNavigationPath(cell, MakeOsgVec3(startPoint), MakeOsgVec3(endPoint),
+                                                                      navigationPath))
+        {
+            for (std::vector<osg::Vec3f>::const_iterator it = navigationPath.begin(); it != navigationPath.end(); ++it)
+                mPath.push_back(MakePathgridPoint(*it));
+            mPath.push_back(endPoint);
+            return;
+        }
+
         if(mCell != cell || !mPathgrid)
         {
             mCell = cell;
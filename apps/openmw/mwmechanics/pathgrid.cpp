@@ -1,5 +1,8 @@
 #include "pathgrid.hpp"
 
+#include <algorithm>
+#include <functional>
+
 #include "../mwbase/world.hpp"
 #include "../mwbase/environment.hpp"
 
@@ -45,6 +48,11 @@ namespace
         //return distance(a, b);
         return manhattan(a, b);
     }
+
+    // Pathgrids with up to this many points get a next hop table, of 2 bytes per pair of points
+    const int sMaxNextHopPoints = 128;
+
+    const unsigned short sNoHop = 0xffff;
 }
 
 namespace MWMechanics
@@ -53,20 +61,21 @@ namespace MWMechanics
         : mCell(NULL)
         , mPathgrid(NULL)
         , mIsExterior(0)
-        , mGraph(0)
         , mIsGraphConstructed(false)
+        , mSearchNumber(0)
         , mSCCId(0)
         , mSCCIndex(0)
     {
     }
 
     /*
-     * mGraph is populated with the cost of each allowed edge.
+     * mEdgeTargets and mEdgeCosts are populated with each allowed edge,
+     * grouped by the point they start from.
      *
      * The data structure is based on the code in buildPath2() but modified.
      * Please check git history if interested.
      *
-     * mGraph[v].edges[i].index = w
+     * mEdgeTargets[mEdgeOffsets[v] + i] = w
      *
      *   v = point index of location "from"
      *   i = index of edges from point v
@@ -75,14 +84,8 @@ namespace MWMechanics
      *
      * Example: (notice from p(0) to p(2) is not allowed in this example)
      *
-     *   mGraph[0].edges[0].index = 1
-     *            .edges[1].index = 3
-     *
-     *   mGraph[1].edges[0].index = 0
-     *            .edges[1].index = 2
-     *            .edges[2].index = 3
-     *
-     *   mGraph[2].edges[0].index = 1
+     *   mEdgeOffsets = 0, 2, 5, 6, ...
+     *   mEdgeTargets = 1, 3,  0, 2, 3,  1, ...
      *
      *   (etc, etc)
      *
@@ -111,19 +114,25 @@ namespace MWMechanics
             return false;
 
 
-        mGraph.resize(mPathgrid->mPoints.size());
+        // Count the edges of each point first, so they can be stored in order of their points
+        const int pointsSize = static_cast<int> (mPathgrid->mPoints.size());
+        mEdgeOffsets.assign(pointsSize + 1, 0);
+        for(int i = 0; i < static_cast<int> (mPathgrid->mEdges.size()); i++)
+            mEdgeOffsets[mPathgrid->mEdges[i].mV0 + 1]++;
+        for(int v = 0; v < pointsSize; v++)
+            mEdgeOffsets[v + 1] += mEdgeOffsets[v];
+
+        mEdgeTargets.resize(mPathgrid->mEdges.size());
+        mEdgeCosts.resize(mPathgrid->mEdges.size());
+        std::vector<int> next(mEdgeOffsets.begin(), mEdgeOffsets.end() - 1);
         for(int i = 0; i < static_cast<int> (mPathgrid->mEdges.size()); i++)
         {
-            ConnectedPoint neighbour;
-            neighbour.cost = costAStar(mPathgrid->mPoints[mPathgrid->mEdges[i].mV0],
-                                       mPathgrid->mPoints[mPathgrid->mEdges[i].mV1]);
             // forward path of the edge
-            neighbour.index = mPathgrid->mEdges[i].mV1;
-            mGraph[mPathgrid->mEdges[i].mV0].edges.push_back(neighbour);
-            // reverse path of the edge
-            // NOTE: These are redundant, ESM already contains the required reverse paths
-            //neighbour.index = mPathgrid->mEdges[i].mV0;
-            //mGraph[mPathgrid->mEdges[i].mV1].edges.push_back(neighbour);
+            // NOTE: The reverse paths are redundant, ESM already contains them
+            const int edge = next[mPathgrid->mEdges[i].mV0]++;
+            mEdgeTargets[edge] = mPathgrid->mEdges[i].mV1;
+            mEdgeCosts[edge] = costAStar(mPathgrid->mPoints[mPathgrid->mEdges[i].mV0],
+                                         mPathgrid->mPoints[mPathgrid->mEdges[i].mV1]);
         }
         buildConnectedPoints();
         mIsGraphConstructed = true;
@@ -137,11 +146,12 @@ namespace MWMechanics
         mSCCPoint[v].second = mSCCIndex; // lowlink
         mSCCIndex++;
         mSCCStack.push_back(v);
+        mSCCOnStack[v] = true;
         int w;
 
-        for(int i = 0; i < static_cast<int> (mGraph[v].edges.size()); i++)
+        for(int i = mEdgeOffsets[v]; i < mEdgeOffsets[v+1]; i++)
         {
-            w = mGraph[v].edges[i].index;
+            w = mEdgeTargets[i];
             if(mSCCPoint[w].first == -1) // not visited
             {
                 recursiveStrongConnect(w); // recurse
@@ -150,7 +160,7 @@ namespace MWMechanics
             }
             else
             {
-                if(find(mSCCStack.begin(), mSCCStack.end(), w) != mSCCStack.end())
+                if(mSCCOnStack[w])
                     mSCCPoint[v].second = std::min(mSCCPoint[v].second,
                                                    mSCCPoint[w].first);
             }
@@ -162,7 +172,8 @@ namespace MWMechanics
             {
                 w = mSCCStack.back();
                 mSCCStack.pop_back();
-                mGraph[w].componentId = mSCCId;
+                mSCCOnStack[w] = false;
+                mComponents[w] = mSCCId;
             }
             while(w != v);
             mSCCId++;
@@ -171,13 +182,12 @@ namespace MWMechanics
     }
 
     /*
-     * mGraph contains the strongly connected component group id's along
-     * with pre-calculated edge costs.
+     * mComponents contains the strongly connected component group id's.
      *
      * A cell can have disjointed pathgrids, e.g. Seyda Neen has 3
      *
-     * mGraph for Seyda Neen will therefore have 3 different values.  When
-     * selecting a random pathgrid point for AiWander, mGraph can be checked
+     * mComponents for Seyda Neen will therefore have 3 different values.  When
+     * selecting a random pathgrid point for AiWander, mComponents can be checked
      * for quickly finding whether the destination is reachable.
      *
      * Otherwise, buildPath can automatically select a closest reachable end
@@ -185,12 +195,12 @@ namespace MWMechanics
      *
      * Using Tarjan's algorithm:
      *
-     *  mGraph                   | graph G   |
-     *  mSCCPoint                | V         | derived from mPoints
-     *  mGraph[v].edges          | E (for v) |
-     *  mSCCIndex                | index     | tracking smallest unused index
-     *  mSCCStack                | S         |
-     *  mGraph[v].edges[i].index | w         |
+     *  mEdgeOffsets, mEdgeTargets | graph G   |
+     *  mSCCPoint                  | V         | derived from mPoints
+     *  mEdgeOffsets[v] to [v+1]   | E (for v) |
+     *  mSCCIndex                  | index     | tracking smallest unused index
+     *  mSCCStack                  | S         |
+     *  mEdgeTargets[i]            | w         |
      *
      */
     void PathgridGraph::buildConnectedPoints()
@@ -201,6 +211,8 @@ namespace MWMechanics
         int pointsSize = static_cast<int> (mPathgrid->mPoints.size());
         mSCCPoint.resize(pointsSize, std::pair<int, int> (-1, -1));
         mSCCStack.reserve(pointsSize);
+        mSCCOnStack.resize(pointsSize, false);
+        mComponents.resize(pointsSize, -1);
 
         for(int v = 0; v < pointsSize; v++)
         {
@@ -211,35 +223,133 @@ namespace MWMechanics
 
     bool PathgridGraph::isPointConnected(const int start, const int end) const
     {
-        return (mGraph[start].componentId == mGraph[end].componentId);
+        return (mComponents[start] == mComponents[end]);
+    }
+
+    void PathgridGraph::beginSearch() const
+    {
+        const size_t pointsSize = mPathgrid->mPoints.size();
+        if (mSearchMarks.size() != pointsSize)
+        {
+            mScores.resize(pointsSize);
+            mParents.resize(pointsSize);
+            mSearchMarks.assign(pointsSize, 0);
+            mSearchNumber = 0;
+        }
+
+        mSearchNumber += 2;
+        if (mSearchNumber < 2) // wrapped around, so old marks could look like new ones
+        {
+            std::fill(mSearchMarks.begin(), mSearchMarks.end(), 0);
+            mSearchNumber = 2;
+        }
+        mOpenSet.clear();
     }
 
     /*
      * NOTE: Based on buildPath2(), please check git history if interested
-     *       Should consider using a 3rd party library version (e.g. boost)
      *
      * Find the shortest path to the target goal using a well known algorithm.
-     * Uses mGraph which has pre-computed costs for allowed edges.  It is assumed
-     * that mGraph is already constructed.
+     * Uses the pre-computed costs of the allowed edges.  It is assumed
+     * that the graph is already constructed.
      *
-     * Should be possible to make this MT safe.
+     * Input params:
+     *   start, goal - pathgrid point indexes (for this cell)
      *
+     * Variables:
+     *   mOpenSet - heap of point indexes to be traversed, lowest estimated cost at the front
+     *   mSearchMarks - tells which points are reached, and which are already traversed
+     *   mScores - past accumulated costs indexed by point index
+     *   mParents - the point each point was reached from, indexed by point index
+     */
+    bool PathgridGraph::search(int start, int goal, std::vector<int>* order) const
+    {
+        beginSearch();
+        const unsigned int reached = mSearchNumber;
+        const unsigned int closed = mSearchNumber + 1;
+
+        mScores[start] = 0;
+        mParents[start] = -1;
+        mSearchMarks[start] = reached;
+        mOpenSet.push_back(OpenEntry(goal < 0 ? 0.f : costAStar(mPathgrid->mPoints[start], mPathgrid->mPoints[goal]), start));
+
+        while(!mOpenSet.empty())
+        {
+            std::pop_heap(mOpenSet.begin(), mOpenSet.end(), std::greater<OpenEntry>());
+            const int current = mOpenSet.back().second;
+            mOpenSet.pop_back();
+
+            // A point is pushed again when a cheaper way to it is found, the older entries are left behind
+            if(mSearchMarks[current] == closed)
+                continue;
+            mSearchMarks[current] = closed; // remember we've been here
+            if(order)
+                order->push_back(current);
+
+            if(current == goal)
+                return true;
+
+            // check all edges for the current point index
+            for(int j = mEdgeOffsets[current]; j < mEdgeOffsets[current+1]; j++)
+            {
+                const int dest = mEdgeTargets[j];
+                if(mSearchMarks[dest] == closed)
+                    continue;
+
+                const float tentative_g = mScores[current] + mEdgeCosts[j];
+                if(mSearchMarks[dest] != reached || tentative_g < mScores[dest])
+                {
+                    mSearchMarks[dest] = reached;
+                    mParents[dest] = current;
+                    mScores[dest] = tentative_g;
+                    float fScore = tentative_g;
+                    if(goal >= 0)
+                        fScore += costAStar(mPathgrid->mPoints[dest], mPathgrid->mPoints[goal]);
+                    mOpenSet.push_back(OpenEntry(fScore, dest));
+                    std::push_heap(mOpenSet.begin(), mOpenSet.end(), std::greater<OpenEntry>());
+                }
+            }
+        }
+
+        return goal < 0;
+    }
+
+    /*
+     * Search the shortest paths from each point to all others, and keep only
+     * the first step of each.  Any step of a shortest path is on a shortest
+     * path to the goal, so following the steps from a point gives the whole
+     * path.
+     */
+    void PathgridGraph::buildNextHops() const
+    {
+        const int pointsSize = static_cast<int> (mPathgrid->mPoints.size());
+        mNextHops.assign(pointsSize * pointsSize, sNoHop);
+
+        std::vector<int> order;
+        order.reserve(pointsSize);
+        for(int start = 0; start < pointsSize; start++)
+        {
+            order.clear();
+            search(start, -1, &order);
+
+            // The points are closed after the points they are reached from
+            unsigned short* hops = &mNextHops[start * pointsSize];
+            hops[start] = static_cast<unsigned short>(start);
+            for(size_t i = 1; i < order.size(); i++)
+            {
+                const int point = order[i];
+                const int parent = mParents[point];
+                hops[point] = (parent == start) ? static_cast<unsigned short>(point) : hops[parent];
+            }
+        }
+    }
+
+    /*
      * Returns path which may be empty.  path contains pathgrid points in local
      * cell co-ordinates (indoors) or world co-ordinates (external).
      *
      * Input params:
      *   start, goal - pathgrid point indexes (for this cell)
-     *
-     * Variables:
-     *   openset - point indexes to be traversed, lowest cost at the front
-     *   closedset - point indexes already traversed
-     *   gScore - past accumulated costs vector indexed by point index
-     *   fScore - future estimated costs vector indexed by point index
-     *
-     * TODO: An intersting exercise might be to cache the paths created for a
-     *       start/goal pair.  To cache the results the paths need to be in
-     *       pathgrid points form (currently they are converted to world
-     *       co-ordinates).  Essentially trading speed w/ memory.
      */
     std::list<ESM::Pathgrid::Point> PathgridGraph::aStarSearch(const int start,
                                                                const int goal) const
@@ -250,73 +360,33 @@ namespace MWMechanics
             return path; // there is no path, return an empty path
         }
 
-        int graphSize = static_cast<int> (mGraph.size());
-        std::vector<float> gScore (graphSize, -1);
-        std::vector<float> fScore (graphSize, -1);
-        std::vector<int> graphParent (graphSize, -1);
-
-        // gScore & fScore keep costs for each pathgrid point in mPoints
-        gScore[start] = 0;
-        fScore[start] = costAStar(mPathgrid->mPoints[start], mPathgrid->mPoints[goal]);
-
-        std::list<int> openset;
-        std::list<int> closedset;
-        openset.push_back(start);
-
-        int current = -1;
-
-        while(!openset.empty())
+        const int pointsSize = static_cast<int> (mPathgrid->mPoints.size());
+        if(pointsSize <= sMaxNextHopPoints)
         {
-            current = openset.front(); // front has the lowest cost
-            openset.pop_front();
-
-            if(current == goal)
-                break;
-
-            closedset.push_back(current); // remember we've been here
+            if(mNextHops.empty())
+                buildNextHops();
 
-            // check all edges for the current point index
-            for(int j = 0; j < static_cast<int> (mGraph[current].edges.size()); j++)
+            path.push_back(mPathgrid->mPoints[start]);
+            for(int current = start; current != goal;)
             {
-                if(std::find(closedset.begin(), closedset.end(), mGraph[current].edges[j].index) ==
-                   closedset.end())
-                {
-                    // not in closedset - i.e. have not traversed this edge destination
-                    int dest = mGraph[current].edges[j].index;
-                    float tentative_g = gScore[current] + mGraph[current].edges[j].cost;
-                    bool isInOpenSet = std::find(openset.begin(), openset.end(), dest) != openset.end();
-                    if(!isInOpenSet
-                        || tentative_g < gScore[dest])
-                    {
-                        graphParent[dest] = current;
-                        gScore[dest] = tentative_g;
-                        fScore[dest] = tentative_g + costAStar(mPathgrid->mPoints[dest],
-                                                               mPathgrid->mPoints[goal]);
-                        if(!isInOpenSet)
-                        {
-                            // add this edge to openset, lowest cost goes to the front
-                            // TODO: if this causes performance problems a hash table may help
-                            std::list<int>::iterator it = openset.begin();
-                            for(it = openset.begin(); it!= openset.end(); ++it)
-                            {
-                                if(fScore[*it] > fScore[dest])
-                                    break;
-                            }
-                            openset.insert(it, dest);
-                        }
-                    }
-                } // if in closedset, i.e. traversed this edge already, try the next edge
+                const unsigned short next = mNextHops[current * pointsSize + goal];
+                if(next == sNoHop)
+                    return std::list<ESM::Pathgrid::Point>(); // for some reason couldn't build a path
+                current = next;
+                path.push_back(mPathgrid->mPoints[current]);
             }
+            return path;
         }
 
-        if(current != goal)
+        if(!search(start, goal, NULL))
             return path; // for some reason couldn't build a path
 
         // reconstruct path to return, using local co-ordinates
-        while(graphParent[current] != -1)
+        int current = goal;
+        while(mParents[current] != -1)
         {
             path.push_front(mPathgrid->mPoints[current]);
-            current = graphParent[current];
+            current = mParents[current];
         }
 
         // add first node to path explicitly
@@ -324,4 +394,3 @@ namespace MWMechanics
         return path;
     }
 }
-
@@ -3,6 +3,7 @@
 
 #include <components/esm/loadpgrd.hpp>
 #include <list>
+#include <vector>
 
 namespace ESM
 {
@@ -16,6 +17,12 @@ namespace MWWorld
 
 namespace MWMechanics
 {
+    /// @brief The graph of the pathgrid of a cell, frozen once it is loaded.
+    /// @par The edges of all points are kept in one array, so a search only touches a few contiguous arrays. The
+    /// search state is kept between searches, so they do not allocate. Small pathgrids get
+    /// a table of the first step of the shortest path between each pair of points on their first search, after which
+    /// a search only follows the table.
+    /// @note Not thread safe, since searches share their state.
     class PathgridGraph
     {
         public:
@@ -40,17 +47,11 @@ namespace MWMechanics
             const ESM::Pathgrid *mPathgrid;
             bool mIsExterior;
 
-            struct ConnectedPoint // edge
-            {
-                int index; // pathgrid point index of neighbour
-                float cost;
-            };
-
-            struct Node // point
-            {
-                int componentId;
-                std::vector<ConnectedPoint> edges; // neighbours
-            };
+            // The edges of point v are mEdgeTargets[mEdgeOffsets[v]] to mEdgeTargets[mEdgeOffsets[v+1]-1], with
+            // the costs at the same indexes of mEdgeCosts
+            std::vector<int> mEdgeOffsets;
+            std::vector<int> mEdgeTargets;
+            std::vector<float> mEdgeCosts;
 
             // componentId is an integer indicating the groups of connected
             // pathgrid points (all connected points will have the same value)
@@ -61,13 +62,34 @@ namespace MWMechanics
             //   48, 49, 50, 51, 84, 85, 86, 87, 88, 89, 90 (ship & office)
             //   all other pathgrid points are the third set
             //
-            std::vector<Node> mGraph;
+            std::vector<int> mComponents;
             bool mIsGraphConstructed;
 
+            // The point to go to next from point v to reach point w is mNextHops[v * size + w], or 0xffff if w is
+            // not reachable. Built by the first search, for small pathgrids only.
+            mutable std::vector<unsigned short> mNextHops;
+            void buildNextHops() const;
+
+            // The search state, reused by all searches. A point was reached by the current search if its
+            // mSearchMarks entry is mSearchNumber, and is closed if its entry is mSearchNumber + 1.
+            typedef std::pair<float, int> OpenEntry; // first is the estimated cost, second the point index
+            mutable std::vector<OpenEntry> mOpenSet;
+            mutable std::vector<float> mScores;
+            mutable std::vector<int> mParents;
+            mutable std::vector<unsigned int> mSearchMarks;
+            mutable unsigned int mSearchNumber;
+            void beginSearch() const;
+
+            // Find the points of the path from start to goal with A* using the costs of the edges, or with Dijkstra
+            // if there is no goal (-1), and record them in mParents. Returns true if the goal was reached.
+            // If order is not NULL, the points are added to it in the order they are closed.
+            bool search(int start, int goal, std::vector<int>* order) const;
+
             // variables used to calculate connected components
             int mSCCId;
             int mSCCIndex;
             std::vector<int> mSCCStack;
+            std::vector<bool> mSCCOnStack;
             typedef std::pair<int, int> VPair; // first is index, second is lowlink
             std::vector<VPair> mSCCPoint;
             // methods used to calculate connected components
@@ -109,8 +109,8 @@ namespace MWMechanics
             x *= it->mArea * 0.05f * magicEffect->mData.mBaseCost;
             if (it->mRange == ESM::RT_Target)
                 x *= 1.5f;
-            static const float fEffectCostMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find(
-                        "fEffectCostMult")->getFloat();
+            const float fEffectCostMult = MWBase::Environment::get().getWorld()->getStore().getGmsts().getFloat(
+                        MWWorld::GmstRegistry::fEffectCostMult);
             x *= fEffectCostMult;
 
             float s = 2.0f * actor.getClass().getSkill(actor, spellSchoolToSkill(magicEffect->mData.mSchool));
@@ -797,8 +797,8 @@ namespace MWMechanics
             CreatureStats& stats = mCaster.getClass().getCreatureStats(mCaster);
 
             // Reduce fatigue (note that in the vanilla game, both GMSTs are 0, and there's no fatigue loss)
-            static const float fFatigueSpellBase = store.get<ESM::GameSetting>().find("fFatigueSpellBase")->getFloat();
-            static const float fFatigueSpellMult = store.get<ESM::GameSetting>().find("fFatigueSpellMult")->getFloat();
+            const float fFatigueSpellBase = store.getGmsts().getFloat(MWWorld::GmstRegistry::fFatigueSpellBase);
+            const float fFatigueSpellMult = store.getGmsts().getFloat(MWWorld::GmstRegistry::fFatigueSpellMult);
             DynamicStat<float> fatigue = stats.getFatigue();
             const float normalizedEncumbrance = mCaster.getClass().getNormalizedEncumbrance(mCaster);
             float fatigueLoss = spell->mData.mCost * (fFatigueSpellBase + normalizedEncumbrance * fFatigueSpellMult);
@@ -1073,8 +1073,8 @@ namespace MWMechanics
             float timeDiff = std::min(7.f, std::max(0.f, std::abs(time - 13)));
             float damageScale = 1.f - timeDiff / 7.f;
             // When cloudy, the sun damage effect is halved
-            static float fMagicSunBlockedMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>().find(
-                        "fMagicSunBlockedMult")->getFloat();
+            const float fMagicSunBlockedMult = MWBase::Environment::get().getWorld()->getStore().getGmsts().getFloat(
+                        MWWorld::GmstRegistry::fMagicSunBlockedMult);
 
             int weather = MWBase::Environment::get().getWorld()->getCurrentWeather();
             if (weather > 1)
@@ -15,6 +15,11 @@
 
 namespace MWMechanics
 {
+    Spells::Spells()
+        : mEffectsDirty(true)
+    {
+    }
+
     Spells::TIterator Spells::begin() const
     {
         return mSpells.begin();
@@ -67,6 +72,7 @@ namespace MWMechanics
             }
 
             mSpells.insert (std::make_pair (spell, random));
+            mEffectsDirty = true;
         }
     }
 
@@ -89,14 +95,15 @@ namespace MWMechanics
             if (mPermanentSpellEffects.find(spell) != mPermanentSpellEffects.end())
             {
                 MagicEffects & effects = mPermanentSpellEffects[spell];
-                for (MagicEffects::Collection::const_iterator effectIt = effects.begin(); effectIt != effects.end();)
+                std::vector<EffectKey> harmfulEffects;
+                for (MagicEffects::Collection::const_iterator effectIt = effects.begin(); effectIt != effects.end(); ++effectIt)
                 {
                     const ESM::MagicEffect * magicEffect = MWBase::Environment::get().getWorld()->getStore().get<ESM::MagicEffect>().find(effectIt->first.mId);
                     if (magicEffect->mData.mFlags & ESM::MagicEffect::Harmful)
-                        effects.remove((effectIt++)->first);
-                    else
-                        ++effectIt;
+                        harmfulEffects.push_back(effectIt->first);
                 }
+                for (std::vector<EffectKey>::const_iterator effectIt = harmfulEffects.begin(); effectIt != harmfulEffects.end(); ++effectIt)
+                    effects.remove(*effectIt);
             }
             mCorprusSpells.erase(corprusIt);
         }
@@ -104,13 +111,16 @@ namespace MWMechanics
         if (iter!=mSpells.end())
             mSpells.erase (iter);
 
+        mEffectsDirty = true;
+
         if (spellId==mSelectedSpell)
             mSelectedSpell.clear();
     }
 
-    MagicEffects Spells::getMagicEffects() const
+    const MagicEffects& Spells::getMagicEffects() const
     {
-        // TODO: These are recalculated every frame, no need to do that
+        if (!mEffectsDirty)
+            return mEffects;
 
         MagicEffects effects;
 
@@ -139,12 +149,15 @@ namespace MWMechanics
             effects += it->second;
         }
 
-        return effects;
+        mEffects = effects;
+        mEffectsDirty = false;
+        return mEffects;
     }
 
     void Spells::clear()
     {
         mSpells.clear();
+        mEffectsDirty = true;
     }
 
     void Spells::setSelectedSpell (const std::string& spellId)
@@ -204,6 +217,7 @@ namespace MWMechanics
             else
                 ++iter;
         }
+        mEffectsDirty = true;
     }
 
     void Spells::purgeBlightDisease()
@@ -216,6 +230,7 @@ namespace MWMechanics
             else
                 ++iter;
         }
+        mEffectsDirty = true;
     }
 
     void Spells::purgeCorprusDisease()
@@ -228,6 +243,7 @@ namespace MWMechanics
             else
                 ++iter;
         }
+        mEffectsDirty = true;
     }
 
     void Spells::purgeCurses()
@@ -240,6 +256,7 @@ namespace MWMechanics
             else
                 ++iter;
         }
+        mEffectsDirty = true;
     }
 
     void Spells::visitEffectSources(EffectSourceVisitor &visitor) const
@@ -276,6 +293,7 @@ namespace MWMechanics
 
         // update worsened effects
         mPermanentSpellEffects[spell] = MagicEffects();
+        mEffectsDirty = true;
         int i=0;
         for (std::vector<ESM::ENAMstruct>::const_iterator effectIt = spell->mEffects.mList.begin(); effectIt != spell->mEffects.mList.end(); ++effectIt, ++i)
         {
@@ -326,6 +344,8 @@ namespace MWMechanics
 
     void Spells::readState(const ESM::SpellState &state)
     {
+        mEffectsDirty = true;
+
         for (ESM::SpellState::TContainer::const_iterator it = state.mSpells.begin(); it != state.mSpells.end(); ++it)
         {
             // Discard spells that are no longer available due to changed content files
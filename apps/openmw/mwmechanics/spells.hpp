@@ -58,11 +58,17 @@ namespace MWMechanics
 
             std::map<SpellKey, CorprusStats> mCorprusSpells;
 
+            // The sum of the effects, recalculated when the spells change
+            mutable MagicEffects mEffects;
+            mutable bool mEffectsDirty;
+
             /// Get spell from ID, throws exception if not found
             const ESM::Spell* getSpell(const std::string& id) const;
 
         public:
 
+            Spells();
+
             void worsenCorprus(const ESM::Spell* spell);
             static bool hasCorprusEffect(const ESM::Spell *spell);
             const std::map<SpellKey, CorprusStats> & getCorprusSpells() const;
@@ -92,7 +98,7 @@ namespace MWMechanics
             ///< If the spell to be removed is the selected spell, the selected spell will be changed to
             /// no spell (empty string).
 
-            MagicEffects getMagicEffects() const;
+            const MagicEffects& getMagicEffects() const;
             ///< Return sum of magic effects resulting from abilities, blights, deseases and curses.
 
             void clear();
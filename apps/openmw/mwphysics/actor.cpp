@@ -21,6 +21,7 @@ Actor::Actor(const MWWorld::Ptr& ptr, osg::ref_ptr<Resource::BulletShapeInstance
   , mCollisionObject(0), mForce(0.f, 0.f, 0.f), mOnGround(false)
   , mInternalCollisionMode(true)
   , mExternalCollisionMode(true)
+  , mHasTickPositions(false)
   , mCollisionWorld(world)
 {
     mPtr = ptr;
@@ -164,4 +165,12 @@ void Actor::setCanWaterWalk(bool waterWalk)
     }
 }
 
+void Actor::setTickPositions(const osg::Vec3f& previous, const osg::Vec3f& current, const osg::Vec3f& reported)
+{
+    mHasTickPositions = true;
+    mPreviousTickPosition = previous;
+    mTickPosition = current;
+    mReportedPosition = reported;
+}
+
 }
@@ -120,6 +120,14 @@ namespace MWPhysics
         void setWalkingOnWater(bool walkingOnWater);
         bool isWalkingOnWater() const;
 
+        /// With a fixed physics timestep: the positions after the last two steps, and the position between them that
+        /// was reported to the world. The next steps continue from there, unless the actor was moved by something else.
+        void setTickPositions(const osg::Vec3f& previous, const osg::Vec3f& current, const osg::Vec3f& reported);
+        bool hasTickPositions() const { return mHasTickPositions; }
+        const osg::Vec3f& getPreviousTickPosition() const { return mPreviousTickPosition; }
+        const osg::Vec3f& getTickPosition() const { return mTickPosition; }
+        const osg::Vec3f& getReportedPosition() const { return mReportedPosition; }
+
     private:
         /// Removes then re-adds the collision object to the dynamics world
         void updateCollisionMask();
@@ -144,6 +152,11 @@ namespace MWPhysics
         bool mInternalCollisionMode;
         bool mExternalCollisionMode;
 
+        bool mHasTickPositions;
+        osg::Vec3f mPreviousTickPosition;
+        osg::Vec3f mTickPosition;
+        osg::Vec3f mReportedPosition;
+
         btCollisionWorld* mCollisionWorld;
 
         Actor(const Actor&);
@@ -0,0 +1,629 @@
+#include "navigator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <osg/Math>
+
+#include <BulletCollision/CollisionDispatch/btCollisionObject.h>
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionShapes/btSphereShape.h>
+#include <BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
+
+#include <components/esm/loadcell.hpp>
+#include <components/esm/loadland.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include "../mwworld/cellstore.hpp"
+
+namespace
+{
+
+    /// Increase when the sampling changes
+    const int sFormatVersion = 1;
+
+    // Like the movement solver
+    const float sMaxSlope = 49.0f;
+    const float sStepSizeUp = 34.0f;
+
+    // The distance between the columns of the grid
+    const float sSpacing = 64.f;
+    // Larger cells use a larger spacing
+    const int sMaxColumns = 512;
+    // The head room an actor needs above a point
+    const float sAgentHeight = 80.f;
+    // The radius of the sphere swept between two points to look for obstacles
+    const float sAgentRadius = 16.f;
+    // How far a position may be above or below a node to stand on it
+    const float sMaxNodeDistanceZ = 64.f;
+    // Hard limits, for the time spent on a column or a path
+    const unsigned int sMaxHitsPerColumn = 16;
+    const unsigned int sMaxNodesPerColumn = 15;
+    const unsigned int sMaxSearchedNodes = 20000;
+
+    const int sDirections[8][2] = { {1,0}, {1,1}, {0,1}, {-1,1}, {-1,0}, {-1,-1}, {0,-1}, {1,-1} };
+
+    const char sMagic[4] = { 'O', 'N', 'A', 'V' };
+
+    const uint64_t sHashBasis = 14695981039346656037ull;
+
+    uint64_t hashData(const void* data, size_t size, uint64_t hash)
+    {
+        // FNV-1a
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i=0; i<size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /// The closest hit of a ray, ignoring the back faces of triangles. A ray from above then passes through the roofs
+    /// of interiors, whose meshes only face inwards.
+    bool castRay(btCollisionWorld* world, const btVector3& from, const btVector3& to, btVector3& hitPoint, btVector3& hitNormal)
+    {
+        btCollisionWorld::ClosestRayResultCallback callback(from, to);
+        callback.m_flags |= btTriangleRaycastCallback::kF_FilterBackfaces;
+        world->rayTest(from, to, callback);
+        if (!callback.hasHit())
+            return false;
+        hitPoint = callback.m_hitPointWorld;
+        hitNormal = callback.m_hitNormalWorld;
+        return true;
+    }
+
+}
+
+namespace MWPhysics
+{
+
+    NavGeometry::NavGeometry()
+        : mAabbMin(0,0,0)
+        , mAabbMax(0,0,0)
+        , mHash(sHashBasis)
+    {
+        mCollisionConfiguration = new btDefaultCollisionConfiguration();
+        mDispatcher = new btCollisionDispatcher(mCollisionConfiguration);
+        mBroadphase = new btDbvtBroadphase();
+        mCollisionWorld = new btCollisionWorld(mDispatcher, mBroadphase, mCollisionConfiguration);
+    }
+
+    NavGeometry::~NavGeometry()
+    {
+        for (std::vector<btCollisionObject*>::iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+        {
+            mCollisionWorld->removeCollisionObject(*it);
+            delete *it;
+        }
+
+        delete mCollisionWorld;
+        delete mCollisionConfiguration;
+        delete mDispatcher;
+        delete mBroadphase;
+    }
+
+    void NavGeometry::addCollisionObject(const btCollisionObject &object, const osg::Referenced *holdObject, const std::string &name)
+    {
+        btCollisionObject* copy = new btCollisionObject;
+        copy->setCollisionShape(const_cast<btCollisionShape*>(object.getCollisionShape()));
+        copy->setWorldTransform(object.getWorldTransform());
+        mCollisionWorld->addCollisionObject(copy);
+        mObjects.push_back(copy);
+        mHoldObjects.push_back(holdObject);
+
+        btVector3 aabbMin, aabbMax;
+        copy->getCollisionShape()->getAabb(copy->getWorldTransform(), aabbMin, aabbMax);
+        if (mObjects.size() == 1)
+        {
+            mAabbMin = aabbMin;
+            mAabbMax = aabbMax;
+        }
+        else
+        {
+            mAabbMin.setMin(aabbMin);
+            mAabbMax.setMax(aabbMax);
+        }
+
+        addToHash(name.data(), name.size());
+        const btTransform& transform = copy->getWorldTransform();
+        for (int i=0; i<3; ++i)
+        {
+            const btScalar row[4] = { transform.getBasis()[i].x(), transform.getBasis()[i].y(), transform.getBasis()[i].z(),
+                                      transform.getOrigin()[i] };
+            addToHash(row, sizeof(row));
+        }
+        const btVector3& scaling = copy->getCollisionShape()->getLocalScaling();
+        const btScalar scale[3] = { scaling.x(), scaling.y(), scaling.z() };
+        addToHash(scale, sizeof(scale));
+    }
+
+    void NavGeometry::addToHash(const void *data, size_t size)
+    {
+        mHash = hashData(data, size, mHash);
+    }
+
+    // ---------------------------------------------------------------
+
+    NavGrid::NavGrid()
+        : mOriginX(0.f)
+        , mOriginY(0.f)
+        , mSpacing(sSpacing)
+        , mNumX(0)
+        , mNumY(0)
+    {
+    }
+
+    void NavGrid::build(NavGeometry &geometry, const osg::Vec2f &min, const osg::Vec2f &max)
+    {
+        mColumns.clear();
+        mNodes.clear();
+
+        mSpacing = std::max(sSpacing, std::max(max.x() - min.x(), max.y() - min.y()) / sMaxColumns);
+        mOriginX = min.x();
+        mOriginY = min.y();
+        mNumX = std::max(0, static_cast<int>(std::ceil((max.x() - min.x()) / mSpacing)));
+        mNumY = std::max(0, static_cast<int>(std::ceil((max.y() - min.y()) / mSpacing)));
+
+        btCollisionWorld* world = geometry.getCollisionWorld();
+        const float top = geometry.getAabbMax().z() + 1.f;
+        const float bottom = geometry.getAabbMin().z() - 1.f;
+        const float minNormalZ = std::cos(osg::DegreesToRadians(sMaxSlope));
+
+        // Cast down through each column, and keep the walkable surfaces with head room
+        mColumns.reserve(mNumX * mNumY + 1);
+        for (int y=0; y<mNumY; ++y)
+        {
+            for (int x=0; x<mNumX; ++x)
+            {
+                const unsigned int column = static_cast<unsigned int>(mColumns.size());
+                mColumns.push_back(static_cast<unsigned int>(mNodes.size()));
+
+                const float posX = mOriginX + (x + 0.5f) * mSpacing;
+                const float posY = mOriginY + (y + 0.5f) * mSpacing;
+                float from = top;
+                unsigned int numNodes = 0;
+                for (unsigned int hit=0; hit<sMaxHitsPerColumn && from > bottom && numNodes < sMaxNodesPerColumn; ++hit)
+                {
+                    btVector3 hitPoint, hitNormal;
+                    if (!castRay(world, btVector3(posX, posY, from), btVector3(posX, posY, bottom), hitPoint, hitNormal))
+                        break;
+
+                    const float z = hitPoint.z();
+                    btVector3 ceilingPoint, ceilingNormal;
+                    if (hitNormal.z() >= minNormalZ
+                            && !castRay(world, btVector3(posX, posY, z + 1.f), btVector3(posX, posY, z + sAgentHeight),
+                                        ceilingPoint, ceilingNormal))
+                    {
+                        Node node;
+                        node.mZ = z;
+                        node.mColumn = column;
+                        node.mLinks = 0;
+                        mNodes.push_back(node);
+                        ++numNodes;
+                    }
+                    from = z - 1.f;
+                }
+            }
+        }
+        mColumns.push_back(static_cast<unsigned int>(mNodes.size()));
+
+        // Link each node with the neighbours in one half of the directions, the links back are set with them
+        for (size_t node=0; node<mNodes.size(); ++node)
+        {
+            const int x = mNodes[node].mColumn % mNumX;
+            const int y = mNodes[node].mColumn / mNumX;
+            for (int direction=0; direction<4; ++direction)
+            {
+                const int neighbourX = x + sDirections[direction][0];
+                const int neighbourY = y + sDirections[direction][1];
+                if (neighbourX < 0 || neighbourX >= mNumX || neighbourY < 0 || neighbourY >= mNumY)
+                    continue;
+                link(geometry, static_cast<int>(node), direction, neighbourY * mNumX + neighbourX);
+            }
+        }
+    }
+
+    void NavGrid::link(NavGeometry &geometry, int node, int direction, int neighbourColumn)
+    {
+        const osg::Vec3f position = getPosition(node);
+        const float distance = mSpacing * ((direction % 2) ? std::sqrt(2.f) : 1.f);
+        const float maxClimb = sStepSizeUp + distance * std::tan(osg::DegreesToRadians(sMaxSlope));
+
+        // The neighbour closest in height
+        int neighbour = -1;
+        float neighbourClimb = maxClimb;
+        for (unsigned int i=mColumns[neighbourColumn]; i<mColumns[neighbourColumn+1]; ++i)
+        {
+            const float climb = std::abs(mNodes[i].mZ - position.z());
+            if (climb <= neighbourClimb)
+            {
+                neighbour = static_cast<int>(i);
+                neighbourClimb = climb;
+            }
+        }
+        if (neighbour < 0)
+            return;
+
+        // Look for obstacles above the height of a step
+        const float kneeHeight = sStepSizeUp + sAgentRadius + 2.f;
+        const osg::Vec3f neighbourPosition = getPosition(neighbour);
+        btTransform from, to;
+        from.setIdentity();
+        from.setOrigin(btVector3(position.x(), position.y(), position.z() + kneeHeight));
+        to.setIdentity();
+        to.setOrigin(btVector3(neighbourPosition.x(), neighbourPosition.y(), neighbourPosition.z() + kneeHeight));
+
+        btSphereShape sphere(sAgentRadius);
+        btCollisionWorld::ClosestConvexResultCallback callback(from.getOrigin(), to.getOrigin());
+        geometry.getCollisionWorld()->convexSweepTest(&sphere, from, to, callback);
+        if (callback.hasHit())
+            return;
+
+        const unsigned int opposite = (direction + 4) % 8;
+        mNodes[node].mLinks |= (neighbour - mColumns[neighbourColumn] + 1) << (direction * 4);
+        mNodes[neighbour].mLinks |= (node - mColumns[mNodes[node].mColumn] + 1) << (opposite * 4);
+    }
+
+    osg::Vec3f NavGrid::getPosition(int node) const
+    {
+        const Node& data = mNodes[node];
+        return osg::Vec3f(mOriginX + (data.mColumn % mNumX + 0.5f) * mSpacing,
+                          mOriginY + (data.mColumn / mNumX + 0.5f) * mSpacing,
+                          data.mZ);
+    }
+
+    int NavGrid::getNeighbour(int node, int direction, unsigned int link) const
+    {
+        const int x = mNodes[node].mColumn % mNumX + sDirections[direction][0];
+        const int y = mNodes[node].mColumn / mNumX + sDirections[direction][1];
+        return mColumns[y * mNumX + x] + link - 1;
+    }
+
+    int NavGrid::findNodeInColumn(int x, int y, const osg::Vec3f &position, float &distance) const
+    {
+        if (x < 0 || x >= mNumX || y < 0 || y >= mNumY)
+            return -1;
+
+        int found = -1;
+        const int column = y * mNumX + x;
+        for (unsigned int i=mColumns[column]; i<mColumns[column+1]; ++i)
+        {
+            if (std::abs(mNodes[i].mZ - position.z()) > sMaxNodeDistanceZ)
+                continue;
+            const float nodeDistance = (getPosition(i) - position).length();
+            if (nodeDistance < distance)
+            {
+                found = static_cast<int>(i);
+                distance = nodeDistance;
+            }
+        }
+        return found;
+    }
+
+    int NavGrid::findNode(const osg::Vec3f &position) const
+    {
+        if (mNumX == 0 || mNumY == 0)
+            return -1;
+
+        const int x = static_cast<int>(std::floor((position.x() - mOriginX) / mSpacing));
+        const int y = static_cast<int>(std::floor((position.y() - mOriginY) / mSpacing));
+
+        float distance = std::numeric_limits<float>::max();
+        int found = findNodeInColumn(x, y, position, distance);
+        if (found >= 0)
+            return found;
+
+        // Standing next to a wall may leave the own column without a node
+        for (int direction=0; direction<8; ++direction)
+        {
+            int node = findNodeInColumn(x + sDirections[direction][0], y + sDirections[direction][1], position, distance);
+            if (node >= 0)
+                found = node;
+        }
+        return found;
+    }
+
+    bool NavGrid::findPath(const osg::Vec3f &start, const osg::Vec3f &end, std::vector<osg::Vec3f> &path) const
+    {
+        const int startNode = findNode(start);
+        const int endNode = findNode(end);
+        if (startNode < 0 || endNode < 0)
+            return false;
+
+        // A* search
+        typedef std::pair<float, int> QueueEntry;
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > open;
+        std::vector<float> costs(mNodes.size(), std::numeric_limits<float>::max());
+        std::vector<int> parents(mNodes.size(), -1);
+        std::vector<bool> closed(mNodes.size(), false);
+
+        const osg::Vec3f endPosition = getPosition(endNode);
+        costs[startNode] = 0.f;
+        open.push(QueueEntry((getPosition(startNode) - endPosition).length(), startNode));
+
+        unsigned int numSearched = 0;
+        while (!open.empty())
+        {
+            const int node = open.top().second;
+            open.pop();
+            if (node == endNode)
+                break;
+            if (closed[node])
+                continue;
+            closed[node] = true;
+            if (++numSearched > sMaxSearchedNodes)
+                return false;
+
+            const osg::Vec3f position = getPosition(node);
+            for (int direction=0; direction<8; ++direction)
+            {
+                const unsigned int link = (mNodes[node].mLinks >> (direction * 4)) & 0xf;
+                if (!link)
+                    continue;
+                const int neighbour = getNeighbour(node, direction, link);
+                if (closed[neighbour])
+                    continue;
+                const osg::Vec3f neighbourPosition = getPosition(neighbour);
+                const float cost = costs[node] + (neighbourPosition - position).length();
+                if (cost < costs[neighbour])
+                {
+                    costs[neighbour] = cost;
+                    parents[neighbour] = node;
+                    open.push(QueueEntry(cost + (neighbourPosition - endPosition).length(), neighbour));
+                }
+            }
+        }
+
+        if (endNode != startNode && parents[endNode] < 0)
+            return false;
+
+        std::vector<int> nodes;
+        for (int node = endNode; node != startNode; node = parents[node])
+            nodes.push_back(node);
+
+        // Only keep the points where the direction changes, and the last one
+        path.clear();
+        osg::Vec3f previous = getPosition(startNode);
+        for (std::vector<int>::reverse_iterator it = nodes.rbegin(); it != nodes.rend(); ++it)
+        {
+            const osg::Vec3f position = getPosition(*it);
+            std::vector<int>::reverse_iterator next = it + 1;
+            if (next != nodes.rend())
+            {
+                const osg::Vec3f nextPosition = getPosition(*next);
+                const bool sameX = (position.x() - previous.x()) == (nextPosition.x() - position.x());
+                const bool sameY = (position.y() - previous.y()) == (nextPosition.y() - position.y());
+                if (sameX && sameY)
+                {
+                    previous = position;
+                    continue;
+                }
+            }
+            path.push_back(position);
+            previous = position;
+        }
+        return true;
+    }
+
+    bool NavGrid::read(std::istream &stream)
+    {
+        char magic[4];
+        int version = 0;
+        stream.read(magic, sizeof(magic));
+        stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+        if (!stream.good() || !std::equal(magic, magic + sizeof(magic), sMagic) || version != sFormatVersion)
+            return false;
+
+        unsigned int numNodes = 0;
+        stream.read(reinterpret_cast<char*>(&mOriginX), sizeof(mOriginX));
+        stream.read(reinterpret_cast<char*>(&mOriginY), sizeof(mOriginY));
+        stream.read(reinterpret_cast<char*>(&mSpacing), sizeof(mSpacing));
+        stream.read(reinterpret_cast<char*>(&mNumX), sizeof(mNumX));
+        stream.read(reinterpret_cast<char*>(&mNumY), sizeof(mNumY));
+        stream.read(reinterpret_cast<char*>(&numNodes), sizeof(numNodes));
+        if (!stream.good() || mNumX < 0 || mNumY < 0 || mNumX > sMaxColumns || mNumY > sMaxColumns
+                || numNodes > static_cast<unsigned int>(mNumX * mNumY) * sMaxNodesPerColumn)
+        {
+            mNumX = mNumY = 0;
+            return false;
+        }
+
+        mColumns.resize(mNumX * mNumY + 1);
+        mNodes.resize(numNodes);
+        stream.read(reinterpret_cast<char*>(&mColumns[0]), mColumns.size() * sizeof(unsigned int));
+        if (numNodes > 0)
+            stream.read(reinterpret_cast<char*>(&mNodes[0]), mNodes.size() * sizeof(Node));
+        if (stream.fail() || mColumns.back() != numNodes)
+        {
+            mColumns.clear();
+            mNodes.clear();
+            mNumX = mNumY = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void NavGrid::write(std::ostream &stream) const
+    {
+        const unsigned int numNodes = static_cast<unsigned int>(mNodes.size());
+        stream.write(sMagic, sizeof(sMagic));
+        stream.write(reinterpret_cast<const char*>(&sFormatVersion), sizeof(sFormatVersion));
+        stream.write(reinterpret_cast<const char*>(&mOriginX), sizeof(mOriginX));
+        stream.write(reinterpret_cast<const char*>(&mOriginY), sizeof(mOriginY));
+        stream.write(reinterpret_cast<const char*>(&mSpacing), sizeof(mSpacing));
+        stream.write(reinterpret_cast<const char*>(&mNumX), sizeof(mNumX));
+        stream.write(reinterpret_cast<const char*>(&mNumY), sizeof(mNumY));
+        stream.write(reinterpret_cast<const char*>(&numNodes), sizeof(numNodes));
+        stream.write(reinterpret_cast<const char*>(&mColumns[0]), mColumns.size() * sizeof(unsigned int));
+        if (numNodes > 0)
+            stream.write(reinterpret_cast<const char*>(&mNodes[0]), mNodes.size() * sizeof(Node));
+    }
+
+    // ---------------------------------------------------------------
+
+    struct Navigator::Build : public osg::Referenced
+    {
+        osg::ref_ptr<NavGeometry> mGeometry;
+        osg::ref_ptr<NavGrid> mGrid;
+        osg::Vec2f mMin;
+        osg::Vec2f mMax;
+        // Empty to not store the grid
+        boost::filesystem::path mCachePath;
+    };
+
+    class Navigator::BuildItem : public SceneUtil::WorkItem
+    {
+    public:
+        BuildItem(Build* build)
+            : mBuild(build)
+        {
+        }
+
+        virtual void doWork()
+        {
+            if (!read())
+            {
+                osg::ref_ptr<NavGrid> grid = new NavGrid;
+                grid->build(*mBuild->mGeometry, mBuild->mMin, mBuild->mMax);
+                mBuild->mGrid = grid;
+                write();
+            }
+            mTicket->signalDone();
+        }
+
+    private:
+        bool read()
+        {
+            const boost::filesystem::path& path = mBuild->mCachePath;
+            if (path.empty() || !boost::filesystem::exists(path))
+                return false;
+
+            boost::filesystem::ifstream stream(path, std::ios::binary);
+            osg::ref_ptr<NavGrid> grid = new NavGrid;
+            if (!stream.is_open() || !grid->read(stream))
+            {
+                std::cerr << "Failed to read cached navigation grid " << path.filename().string() << std::endl;
+                return false;
+            }
+            mBuild->mGrid = grid;
+            return true;
+        }
+
+        void write()
+        {
+            const boost::filesystem::path& path = mBuild->mCachePath;
+            if (path.empty())
+                return;
+
+            // Write to a temporary file first, so a grid is never left half written
+            boost::filesystem::path tempPath = path;
+            tempPath += ".tmp";
+            try
+            {
+                if (!boost::filesystem::exists(path.parent_path()))
+                    boost::filesystem::create_directories(path.parent_path());
+
+                {
+                    boost::filesystem::ofstream stream(tempPath, std::ios::binary | std::ios::out | std::ios::trunc);
+                    if (!stream.is_open())
+                        throw std::runtime_error("can not open file for writing");
+                    mBuild->mGrid->write(stream);
+                    if (stream.fail())
+                        throw std::runtime_error("write operation failed");
+                }
+
+                boost::filesystem::rename(tempPath, path);
+            }
+            catch (std::exception& e)
+            {
+                std::cerr << "Failed to cache navigation grid " << path.filename().string() << ": " << e.what() << std::endl;
+                boost::system::error_code ec;
+                boost::filesystem::remove(tempPath, ec);
+            }
+        }
+
+        osg::ref_ptr<Build> mBuild;
+    };
+
+    Navigator::Navigator(const boost::filesystem::path &cacheDirectory)
+        : mCacheDirectory(cacheDirectory)
+        , mWorkQueue(new SceneUtil::WorkQueue(1))
+    {
+    }
+
+    Navigator::~Navigator()
+    {
+        // Waits for the build in progress, the others are cancelled
+        mWorkQueue.reset();
+    }
+
+    void Navigator::addCell(const MWWorld::CellStore *cell, osg::ref_ptr<NavGeometry> geometry)
+    {
+        removeCell(cell);
+        if (geometry->isEmpty())
+            return;
+
+        osg::ref_ptr<Build> build = new Build;
+        build->mGeometry = geometry;
+        if (cell->getCell()->isExterior())
+        {
+            // Objects may reach into the neighbouring cells, only sample this one
+            const float cellSize = ESM::Land::REAL_SIZE;
+            build->mMin = osg::Vec2f(cell->getCell()->getGridX() * cellSize, cell->getCell()->getGridY() * cellSize);
+            build->mMax = build->mMin + osg::Vec2f(cellSize, cellSize);
+        }
+        else
+        {
+            build->mMin = osg::Vec2f(geometry->getAabbMin().x(), geometry->getAabbMin().y());
+            build->mMax = osg::Vec2f(geometry->getAabbMax().x(), geometry->getAabbMax().y());
+        }
+
+        if (!mCacheDirectory.empty())
+        {
+            const std::string name = cell->getCell()->getDescription();
+            std::ostringstream fileName;
+            fileName << std::hex << std::setfill('0')
+                     << std::setw(16) << hashData(name.data(), name.size(), sHashBasis) << '-'
+                     << std::setw(16) << geometry->getHash() << '-'
+                     << std::dec << sFormatVersion << ".nav";
+            build->mCachePath = mCacheDirectory / fileName.str();
+        }
+
+        Cell& entry = mCells[cell];
+        entry.mBuild = build;
+        entry.mTicket = mWorkQueue->addWorkItem(new BuildItem(build));
+    }
+
+    void Navigator::removeCell(const MWWorld::CellStore *cell)
+    {
+        CellMap::iterator found = mCells.find(cell);
+        if (found == mCells.end())
+            return;
+        // A build in progress finishes on its own, its item keeps the build alive
+        found->second.mTicket->cancel();
+        mCells.erase(found);
+    }
+
+    bool Navigator::findPath(const MWWorld::CellStore *cell, const osg::Vec3f &start, const osg::Vec3f &end,
+                             std::vector<osg::Vec3f> &path) const
+    {
+        CellMap::const_iterator found = mCells.find(cell);
+        if (found == mCells.end() || !found->second.mTicket->isDone() || !found->second.mBuild->mGrid)
+            return false;
+        return found->second.mBuild->mGrid->findPath(start, end, path);
+    }
+
+}
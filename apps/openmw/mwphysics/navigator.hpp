@@ -0,0 +1,177 @@
+#ifndef OPENMW_MWPHYSICS_NAVIGATOR_H
+#define OPENMW_MWPHYSICS_NAVIGATOR_H
+
+#include <stdint.h>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Vec2f>
+#include <osg/Vec3f>
+
+#include <LinearMath/btVector3.h>
+
+class btCollisionObject;
+class btCollisionWorld;
+class btBroadphaseInterface;
+class btDefaultCollisionConfiguration;
+class btCollisionDispatcher;
+
+namespace MWWorld
+{
+    class CellStore;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+    class WorkTicket;
+}
+
+namespace MWPhysics
+{
+
+    /// The static collision geometry of a cell, copied from the collision world of the PhysicsSystem, so that a
+    /// NavGrid can be built from it in the background while the original world changes.
+    class NavGeometry : public osg::Referenced
+    {
+    public:
+        NavGeometry();
+        ~NavGeometry();
+
+        /// Add a copy of the collision object, which shares its shape.
+        /// @param holdObject Keeps the shape alive while this geometry exists.
+        /// @param name Identifies the shape in the hash, e.g. the name of the model.
+        void addCollisionObject(const btCollisionObject& object, const osg::Referenced* holdObject, const std::string& name);
+
+        /// Add data to the hash that tells if a cached NavGrid is still valid.
+        void addToHash(const void* data, size_t size);
+
+        uint64_t getHash() const { return mHash; }
+
+        bool isEmpty() const { return mObjects.empty(); }
+
+        /// The bounds of all objects.
+        const btVector3& getAabbMin() const { return mAabbMin; }
+        const btVector3& getAabbMax() const { return mAabbMax; }
+
+        btCollisionWorld* getCollisionWorld() { return mCollisionWorld; }
+
+    private:
+        btDefaultCollisionConfiguration* mCollisionConfiguration;
+        btCollisionDispatcher* mDispatcher;
+        btBroadphaseInterface* mBroadphase;
+        btCollisionWorld* mCollisionWorld;
+
+        std::vector<btCollisionObject*> mObjects;
+        std::vector<osg::ref_ptr<const osg::Referenced> > mHoldObjects;
+
+        btVector3 mAabbMin;
+        btVector3 mAabbMax;
+        uint64_t mHash;
+    };
+
+    /// @brief Points that actors can stand on, sampled in a regular grid from the collision geometry of a cell, and the
+    /// links between the neighbouring points that actors can walk between.
+    /// @par Each column of the grid has a point for each floor with head room above it, so buildings with several
+    /// floors are covered too. Points are linked to the points in the eight neighbouring columns that are no more than
+    /// a walkable slope or step up or down, if there is no obstacle in between.
+    class NavGrid : public osg::Referenced
+    {
+    public:
+        NavGrid();
+
+        /// Sample the geometry in the given horizontal bounds. Slow, meant to run in the background.
+        void build(NavGeometry& geometry, const osg::Vec2f& min, const osg::Vec2f& max);
+
+        /// @return false if the data is not a valid grid, which leaves this grid empty.
+        bool read(std::istream& stream);
+        void write(std::ostream& stream) const;
+
+        /// Find a path from the start to the end, if they are both on the grid.
+        /// @param path The points to walk to after the start, without the end itself.
+        /// @return true if there is a path.
+        /// @note Thread safe.
+        bool findPath(const osg::Vec3f& start, const osg::Vec3f& end, std::vector<osg::Vec3f>& path) const;
+
+    private:
+        struct Node
+        {
+            float mZ;
+            unsigned int mColumn;
+            // For each of the eight directions, four bits of 1 + the index of the linked node in the neighbouring
+            // column, or 0 if the direction is not linked.
+            unsigned int mLinks;
+        };
+
+        osg::Vec3f getPosition(int node) const;
+
+        /// The node in the given direction, of the given link.
+        int getNeighbour(int node, int direction, unsigned int link) const;
+
+        /// @return The node that the position stands on, or -1 if there is none.
+        int findNode(const osg::Vec3f& position) const;
+
+        int findNodeInColumn(int x, int y, const osg::Vec3f& position, float& distance) const;
+
+        void link(NavGeometry& geometry, int node, int direction, int neighbourColumn);
+
+        float mOriginX;
+        float mOriginY;
+        float mSpacing;
+        int mNumX;
+        int mNumY;
+
+        // The index of the first node of each column, and the number of nodes at the end
+        std::vector<unsigned int> mColumns;
+        std::vector<Node> mNodes;
+    };
+
+    /// @brief Builds the NavGrids of the active cells on a background thread, and finds paths on them.
+    /// @par The grids are stored in the cache directory by the name of the cell and the hash of its geometry, so a
+    /// cell is only sampled again after its objects or terrain changed.
+    /// @note The grid of a cell is not updated when its objects move later on.
+    class Navigator
+    {
+    public:
+        /// @param cacheDirectory Empty to not store the grids.
+        Navigator(const boost::filesystem::path& cacheDirectory);
+        ~Navigator();
+
+        /// Start building the grid of the cell from the given geometry, replacing any existing grid.
+        void addCell(const MWWorld::CellStore* cell, osg::ref_ptr<NavGeometry> geometry);
+
+        void removeCell(const MWWorld::CellStore* cell);
+
+        /// Find a path in the cell, see NavGrid::findPath.
+        /// @return false if the grid of the cell does not have a path, or is not built yet.
+        bool findPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                      std::vector<osg::Vec3f>& path) const;
+
+    private:
+        struct Build;
+        class BuildItem;
+
+        struct Cell
+        {
+            osg::ref_ptr<Build> mBuild;
+            osg::ref_ptr<SceneUtil::WorkTicket> mTicket;
+        };
+
+        typedef std::map<const MWWorld::CellStore*, Cell> CellMap;
+        CellMap mCells;
+
+        boost::filesystem::path mCacheDirectory;
+
+        std::auto_ptr<SceneUtil::WorkQueue> mWorkQueue;
+    };
+
+}
+
+#endif
@@ -1,8 +1,12 @@
 #include "physicssystem.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 #include <osg/Group>
+#include <osg/Stats>
+#include <osg/Timer>
+#include <osg/observer_ptr>
 
 #include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
 #include <BulletCollision/CollisionShapes/btConeShape.h>
@@ -16,12 +20,20 @@
 #include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
 #include <LinearMath/btQuickprof.h>
 
+#include <OpenThreads/Atomic>
+
 #include <components/nifbullet/bulletnifloader.hpp>
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/bulletshapemanager.hpp>
 
 #include <components/esm/loadgmst.hpp>
+#include <components/esm/loadland.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include <components/settings/settings.hpp>
+
+#include <components/misc/profiler.hpp>
 
 #include <components/nifosg/particle.hpp> // FindRecIndexVisitor
 
@@ -46,6 +58,7 @@
 #include "actor.hpp"
 #include "convert.hpp"
 #include "trace.h"
+#include "navigator.hpp"
 
 namespace MWPhysics
 {
@@ -57,6 +70,12 @@ namespace MWPhysics
     // Arbitrary number. To prevent infinite loops. They shouldn't happen but it's good to be prepared.
     static const int sMaxIterations = 8;
 
+    // For the viewer stats, counted on all threads and taken by PhysicsSystem::reportStats
+    static OpenThreads::Atomic sNumTraceDowns;
+    static OpenThreads::Atomic sNumContactTests;
+    static OpenThreads::Atomic sNumSolvedActors;
+    static OpenThreads::Atomic sSolveMicroseconds;
+
     // FIXME: move to a separate file
     class MovementSolver
     {
@@ -196,6 +215,8 @@ namespace MWPhysics
     public:
         static osg::Vec3f traceDown(const MWWorld::Ptr &ptr, Actor* actor, btCollisionWorld* collisionWorld, float maxHeight)
         {
+            ++sNumTraceDowns;
+
             osg::Vec3f position(ptr.getRefData().getPosition().asVec3());
 
             ActorTracer tracer;
@@ -233,12 +254,11 @@ namespace MWPhysics
             }
         }
 
-        static osg::Vec3f move(const MWWorld::Ptr &ptr, Actor* physicActor, const osg::Vec3f &movement, float time,
+        static osg::Vec3f move(const MWWorld::Ptr &ptr, Actor* physicActor, osg::Vec3f position, const osg::Vec3f &movement, float time,
                                   bool isFlying, float waterlevel, float slowFall, btCollisionWorld* collisionWorld,
                                std::map<MWWorld::Ptr, MWWorld::Ptr>& standingCollisionTracker)
         {
             const ESM::Position& refpos = ptr.getRefData().getPosition();
-            osg::Vec3f position(refpos.asVec3());
 
             // Early-out for totally static creatures
             // (Not sure if gravity should still apply?)
@@ -264,8 +284,8 @@ namespace MWPhysics
             // While this is strictly speaking wrong, it's needed for MW compatibility.
             position.z() += halfExtents.z();
 
-            static const float fSwimHeightScale = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                    .find("fSwimHeightScale")->getFloat();
+            const MWWorld::GmstRegistry &gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
+            const float fSwimHeightScale = gmsts.getFloat(MWWorld::GmstRegistry::fSwimHeightScale);
             float swimlevel = waterlevel + halfExtents.z() - (physicActor->getRenderingHalfExtents().z() * 2 * fSwimHeightScale);
 
             ActorTracer tracer;
@@ -300,8 +320,7 @@ namespace MWPhysics
             {
                 osg::Vec3f stormDirection = MWBase::Environment::get().getWorld()->getStormDirection();
                 float angleDegrees = osg::RadiansToDegrees(std::acos(stormDirection * velocity / (stormDirection.length() * velocity.length())));
-                static const float fStromWalkMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                        .find("fStromWalkMult")->getFloat();
+                const float fStromWalkMult = gmsts.getFloat(MWWorld::GmstRegistry::fStromWalkMult);
                 velocity *= 1.f-(fStromWalkMult * (angleDegrees/180.f));
             }
 
@@ -458,13 +477,75 @@ namespace MWPhysics
         }
     };
 
+    static void solveMovement(std::vector<MovementJob>& jobs, size_t begin, size_t end, float time, int numSteps,
+                              btCollisionWorld* collisionWorld)
+    {
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        for (size_t i=begin; i<end; ++i)
+        {
+            MovementJob& job = jobs[i];
+            osg::Vec3f position = job.mPosition;
+            for (int step=0; step<numSteps; ++step)
+            {
+                job.mPreviousPosition = position;
+                position = MovementSolver::move(job.mActor->getPtr(), job.mActor, position, job.mMovement, time, job.mIsFlying,
+                                                job.mWaterLevel, job.mSlowFall, collisionWorld, job.mStandingCollisions);
+            }
+            job.mNewPosition = position;
+        }
+        sNumSolvedActors += static_cast<unsigned int>(end - begin);
+        sSolveMicroseconds += static_cast<unsigned int>(osg::Timer::instance()->delta_u(startTick, osg::Timer::instance()->tick()));
+    }
+
+    /// Solves a range of the movement jobs on a worker thread.
+    /// @note The solver only changes the actor it moves. The collision world is only read, so all jobs see the positions
+    /// of the other actors from before the movement, no matter in which order they are solved.
+    class SolveMovementItem : public SceneUtil::WorkItem
+    {
+    public:
+        /// @param error Receives the message of an exception thrown by the solver, to be raised again by the main thread.
+        SolveMovementItem(std::vector<MovementJob>& jobs, size_t begin, size_t end, float time, int numSteps,
+                          btCollisionWorld* collisionWorld, std::string* error)
+            : mJobs(jobs), mBegin(begin), mEnd(end), mTime(time), mNumSteps(numSteps), mCollisionWorld(collisionWorld)
+            , mError(error)
+        {
+        }
+
+        virtual void doWork()
+        {
+            OPENMW_PROFILE_ZONE ("PhysicsSystem::solveMovement");
+
+            try
+            {
+                solveMovement(mJobs, mBegin, mEnd, mTime, mNumSteps, mCollisionWorld);
+            }
+            catch (std::exception& e)
+            {
+                *mError = e.what();
+            }
+            mTicket->signalDone();
+        }
+
+    private:
+        std::vector<MovementJob>& mJobs;
+        size_t mBegin;
+        size_t mEnd;
+        float mTime;
+        int mNumSteps;
+        btCollisionWorld* mCollisionWorld;
+        std::string* mError;
+    };
+
 
     // ---------------------------------------------------------------
 
-    class HeightField
+    class HeightField : public osg::Referenced
     {
     public:
-        HeightField(const float* heights, int x, int y, float triSize, float sqrtVerts)
+        HeightField(const float* heights, int x, int y, float triSize, float sqrtVerts, const osg::Referenced* holdObject)
+            : mHeights(heights)
+            , mNumHeights(static_cast<int>(sqrtVerts*sqrtVerts))
+            , mHoldObject(holdObject)
         {
             // find the minimum and maximum heights (needed for bullet)
             float minh = heights[0];
@@ -503,9 +584,28 @@ namespace MWPhysics
             return mCollisionObject;
         }
 
+        const float* getHeights() const
+        {
+            return mHeights;
+        }
+
+        int getNumHeights() const
+        {
+            return mNumHeights;
+        }
+
+        const osg::Referenced* getHoldObject() const
+        {
+            return mHoldObject.get();
+        }
+
     private:
         btHeightfieldTerrainShape* mShape;
+        const float* mHeights;
+        int mNumHeights;
         btCollisionObject* mCollisionObject;
+        // The shape does not copy the heights
+        osg::ref_ptr<const osg::Referenced> mHoldObject;
     };
 
     // --------------------------------------------------------------
@@ -566,6 +666,11 @@ namespace MWPhysics
             return !mShapeInstance->mAnimatedShapes.empty();
         }
 
+        const Resource::BulletShapeInstance* getShapeInstance() const
+        {
+            return mShapeInstance.get();
+        }
+
         void animateCollisionShapes(btCollisionWorld* collisionWorld)
         {
             if (mShapeInstance->mAnimatedShapes.empty())
@@ -575,37 +680,47 @@ namespace MWPhysics
 
             btCompoundShape* compound = dynamic_cast<btCompoundShape*>(mShapeInstance->getCollisionShape());
 
+            // Shapes whose nodes did not move keep their transforms, and the AABB is only updated if any of them moved,
+            // so idle animated objects are cheap
+            bool changed = false;
             for (std::map<int, int>::iterator it = mShapeInstance->mAnimatedShapes.begin(); it != mShapeInstance->mAnimatedShapes.end();)
             {
                 int recIndex = it->first;
                 int shapeIndex = it->second;
 
-                NifOsg::FindGroupByRecIndex visitor(recIndex);
-                mPtr.getRefData().getBaseNode()->accept(visitor);
-                if (!visitor.mFound)
+                osg::NodePath path;
+                if (!getCachedNodePath(recIndex, path))
                 {
-                    std::cerr << "animateCollisionShapes: Can't find node " << recIndex << std::endl;
-                    return;
-                }
-
-                osg::NodePath path = visitor.mFoundPath;
-                path.erase(path.begin());
+                    NifOsg::FindGroupByRecIndex visitor(recIndex);
+                    mPtr.getRefData().getBaseNode()->accept(visitor);
+                    if (!visitor.mFound)
+                    {
+                        std::cerr << "animateCollisionShapes: Can't find node " << recIndex << std::endl;
+                        return;
+                    }
 
-                // Attempt to remove "animated" shapes that are not actually animated
-                // We may get these because the BulletNifLoader does not know if a .kf file with additional controllers will be attached later on.
-                // On the first animateCollisionShapes call, we'll consider the graph completely loaded (with extra controllers and what not),
-                // so now we can better decide if the shape is really animated.
-                bool animated = false;
-                for (osg::NodePath::iterator nodePathIt = path.begin(); nodePathIt != path.end(); ++nodePathIt)
-                {
-                    osg::Node* node = *nodePathIt;
-                    if (node->getUpdateCallback())
-                        animated = true;
-                }
-                if (!animated)
-                {
-                    mShapeInstance->mAnimatedShapes.erase(it++);
-                    break;
+                    path = visitor.mFoundPath;
+                    ObserverNodePath& cachedPath = mNodePaths[recIndex];
+                    cachedPath.assign(path.begin(), path.end());
+                    path.erase(path.begin());
+
+                    // Attempt to remove "animated" shapes that are not actually animated
+                    // We may get these because the BulletNifLoader does not know if a .kf file with additional controllers will be attached later on.
+                    // On the first animateCollisionShapes call, we'll consider the graph completely loaded (with extra controllers and what not),
+                    // so now we can better decide if the shape is really animated.
+                    bool animated = false;
+                    for (osg::NodePath::iterator nodePathIt = path.begin(); nodePathIt != path.end(); ++nodePathIt)
+                    {
+                        osg::Node* node = *nodePathIt;
+                        if (node->getUpdateCallback())
+                            animated = true;
+                    }
+                    if (!animated)
+                    {
+                        mNodePaths.erase(recIndex);
+                        mShapeInstance->mAnimatedShapes.erase(it++);
+                        break;
+                    }
                 }
 
                 osg::Matrixf matrix = osg::computeLocalToWorld(path);
@@ -618,31 +733,84 @@ namespace MWPhysics
                     for (int j=0; j<3; ++j)
                         transform.getBasis()[i][j] = matrix(j,i); // NB column/row major difference
 
-                compound->getChildShape(shapeIndex)->setLocalScaling(compound->getLocalScaling() * toBullet(scale));
-                compound->updateChildTransform(shapeIndex, transform);
+                btCollisionShape* childShape = compound->getChildShape(shapeIndex);
+                const btVector3 localScaling = compound->getLocalScaling() * toBullet(scale);
+                if (!(childShape->getLocalScaling() == localScaling) || !(compound->getChildTransform(shapeIndex) == transform))
+                {
+                    childShape->setLocalScaling(localScaling);
+                    compound->updateChildTransform(shapeIndex, transform);
+                    changed = true;
+                }
 
                 ++it;
             }
 
-            collisionWorld->updateSingleAabb(mCollisionObject.get());
+            if (changed)
+                collisionWorld->updateSingleAabb(mCollisionObject.get());
         }
 
     private:
+        typedef std::vector<osg::observer_ptr<osg::Node> > ObserverNodePath;
+
+        /// Get the path below the base node to the node of an animated shape, as found by an earlier search.
+        /// @return false if there is no such path, or the scene graph of the object was replaced since.
+        bool getCachedNodePath(int recIndex, osg::NodePath& path) const
+        {
+            std::map<int, ObserverNodePath>::const_iterator found = mNodePaths.find(recIndex);
+            if (found == mNodePaths.end() || found->second.empty()
+                    || found->second.front() != mPtr.getRefData().getBaseNode())
+                return false;
+
+            for (ObserverNodePath::const_iterator it = found->second.begin()+1; it != found->second.end(); ++it)
+            {
+                osg::Node* node = it->get();
+                if (!node)
+                    return false;
+                path.push_back(node);
+            }
+            return true;
+        }
+
         std::auto_ptr<btCollisionObject> mCollisionObject;
         osg::ref_ptr<Resource::BulletShapeInstance> mShapeInstance;
         bool mSolid;
+
+        // The paths to the nodes of the animated shapes, starting with the base node, by record index
+        std::map<int, ObserverNodePath> mNodePaths;
     };
 
     // ---------------------------------------------------------------
 
-    PhysicsSystem::PhysicsSystem(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> parentNode)
+    PhysicsSystem::PhysicsSystem(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> parentNode,
+                                 const boost::filesystem::path& navigationCacheDirectory)
         : mShapeManager(new Resource::BulletShapeManager(resourceSystem->getVFS(), resourceSystem->getSceneManager(), resourceSystem->getNifFileManager()))
+        , mResourceSystem(resourceSystem)
+        , mActorQueryMargin(0.f)
         , mDebugDrawEnabled(false)
+        , mNumMovementThreads(std::max(0, Settings::Manager::getInt("movement solver threads", "Physics")))
+        , mAsyncMovement(Settings::Manager::getBool("async movement", "Physics"))
+        , mAsyncMovementQueued(false)
+        , mFixedTimestep(Settings::Manager::getBool("fixed timestep", "Physics"))
+        , mTickTime(1.f / std::max(1.f, Settings::Manager::getFloat("tick rate", "Physics")))
+        , mMovementStepTime(0.f)
+        , mMovementNumSteps(0)
+        , mMovementInterpolation(1.f)
         , mTimeAccum(0.0f)
+        , mLineOfSightTime(0.0)
+        , mLineOfSightCacheTime(std::max(0.f, Settings::Manager::getFloat("line of sight cache time", "Physics")))
         , mWaterHeight(0)
         , mWaterEnabled(false)
         , mParentNode(parentNode)
     {
+        // Asynchronous mode leaves all of the solving to the worker threads
+        if (mAsyncMovement)
+            mNumMovementThreads = std::max(1, mNumMovementThreads);
+        if (mNumMovementThreads > 0)
+            mMovementWorkQueue.reset(new SceneUtil::WorkQueue(mNumMovementThreads));
+
+        if (Settings::Manager::getBool("navigation grid", "Physics"))
+            mNavigator.reset(new Navigator(navigationCacheDirectory));
+
         mCollisionConfiguration = new btDefaultCollisionConfiguration();
         mDispatcher = new btCollisionDispatcher(mCollisionConfiguration);
         mBroadphase = new btDbvtBroadphase();
@@ -652,17 +820,28 @@ namespace MWPhysics
         // Don't update AABBs of all objects every frame. Most objects in MW are static, so we don't need this.
         // Should a "static" object ever be moved, we have to update its AABB manually using DynamicsWorld::updateSingleAabb.
         mCollisionWorld->setForceUpdateAllAabbs(false);
+
+        if (!resourceSystem->getBvhCacheDirectory().empty())
+            mShapeManager->setBvhCacheDirectory(resourceSystem->getBvhCacheDirectory());
+
+        mResourceSystem->addResourceManager(mShapeManager.get());
     }
 
     PhysicsSystem::~PhysicsSystem()
     {
+        waitForQueuedMovement();
+
+        // Waits for the grid in progress, which may still use the collision shapes
+        mNavigator.reset();
+
+        mResourceSystem->removeResourceManager(mShapeManager.get());
+
         if (mWaterCollisionObject.get())
             mCollisionWorld->removeCollisionObject(mWaterCollisionObject.get());
 
         for (HeightFieldMap::iterator it = mHeightFields.begin(); it != mHeightFields.end(); ++it)
         {
             mCollisionWorld->removeCollisionObject(it->second->getCollisionObject());
-            delete it->second;
         }
 
         for (ObjectMap::iterator it = mObjects.begin(); it != mObjects.end(); ++it)
@@ -682,6 +861,11 @@ namespace MWPhysics
         delete mBroadphase;
     }
 
+    Resource::BulletShapeManager *PhysicsSystem::getShapeManager()
+    {
+        return mShapeManager.get();
+    }
+
     bool PhysicsSystem::toggleDebugRendering()
     {
         mDebugDrawEnabled = !mDebugDrawEnabled;
@@ -775,10 +959,10 @@ namespace MWPhysics
                                                                      const osg::Quat &orient,
                                                                       float queryDistance)
     {
-        const MWWorld::Store<ESM::GameSetting> &store = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>();
+        const MWWorld::GmstRegistry &gmsts = MWBase::Environment::get().getWorld()->getStore().getGmsts();
 
-        btConeShape shape (osg::DegreesToRadians(store.find("fCombatAngleXY")->getFloat()/2.0f), queryDistance);
-        shape.setLocalScaling(btVector3(1, 1, osg::DegreesToRadians(store.find("fCombatAngleZ")->getFloat()/2.0f) /
+        btConeShape shape (osg::DegreesToRadians(gmsts.getFloat(MWWorld::GmstRegistry::fCombatAngleXY)/2.0f), queryDistance);
+        shape.setLocalScaling(btVector3(1, 1, osg::DegreesToRadians(gmsts.getFloat(MWWorld::GmstRegistry::fCombatAngleZ)/2.0f) /
                                               shape.getRadius()));
 
         // The shape origin is its center, so we have to move it forward by half the length. The
@@ -797,6 +981,7 @@ namespace MWPhysics
         DeepestNotMeContactTestResultCallback resultCallback(me, toBullet(origin));
         resultCallback.m_collisionFilterGroup = CollisionType_Actor;
         resultCallback.m_collisionFilterMask = CollisionType_World | CollisionType_Door | CollisionType_HeightMap | CollisionType_Actor;
+        ++sNumContactTests;
         mCollisionWorld->contactTest(&object, resultCallback);
 
         if (resultCallback.mObject)
@@ -912,6 +1097,155 @@ namespace MWPhysics
         return result;
     }
 
+    class PhysicsSystem::RayQueryItem : public SceneUtil::WorkItem
+    {
+    public:
+        RayQueryItem(const PhysicsSystem& physics, const std::vector<RayQuery>& queries, size_t begin, size_t end,
+                     std::vector<RayResult>& results)
+            : mPhysics(physics), mQueries(queries), mBegin(begin), mEnd(end), mResults(results)
+        {
+        }
+
+        virtual void doWork()
+        {
+            mPhysics.runRayQueries(mQueries, mBegin, mEnd, mResults);
+            mTicket->signalDone();
+        }
+
+    private:
+        const PhysicsSystem& mPhysics;
+        const std::vector<RayQuery>& mQueries;
+        size_t mBegin;
+        size_t mEnd;
+        std::vector<RayResult>& mResults;
+    };
+
+    void PhysicsSystem::runRayQueries(const std::vector<RayQuery> &queries, size_t begin, size_t end, std::vector<RayResult> &results) const
+    {
+        for (size_t i=begin; i<end; ++i)
+        {
+            const RayQuery& query = queries[i];
+            const btVector3 btFrom = toBullet(query.mFrom);
+            const btVector3 btTo = toBullet(query.mTo);
+
+            RayResult& result = results[i];
+            result.mHit = false;
+
+            if (query.mRadius > 0.f)
+            {
+                btCollisionWorld::ClosestConvexResultCallback callback(btFrom, btTo);
+                callback.m_collisionFilterGroup = query.mGroup;
+                callback.m_collisionFilterMask = query.mMask;
+
+                btSphereShape shape(query.mRadius);
+                const btQuaternion btrot = btQuaternion::getIdentity();
+                convexSweepTest(&shape, btTransform(btrot, btFrom), btTransform(btrot, btTo), mCollisionWorld, callback);
+
+                if (callback.hasHit())
+                {
+                    result.mHit = true;
+                    result.mHitPos = toOsg(callback.m_hitPointWorld);
+                    result.mHitNormal = toOsg(callback.m_hitNormalWorld);
+                }
+                continue;
+            }
+
+            const btCollisionObject* me = NULL;
+            if (!query.mIgnore.isEmpty())
+            {
+                const Actor* actor = getActor(query.mIgnore);
+                if (actor)
+                    me = actor->getCollisionObject();
+            }
+
+            ClosestNotMeRayResultCallback resultCallback(me, btFrom, btTo);
+            resultCallback.m_collisionFilterGroup = query.mGroup;
+            resultCallback.m_collisionFilterMask = query.mMask;
+
+            rayTest(btFrom, btTo, mCollisionWorld, resultCallback);
+
+            if (resultCallback.hasHit())
+            {
+                result.mHit = true;
+                result.mHitPos = toOsg(resultCallback.m_hitPointWorld);
+                result.mHitNormal = toOsg(resultCallback.m_hitNormalWorld);
+                if (PtrHolder* ptrHolder = static_cast<PtrHolder*>(resultCallback.m_collisionObject->getUserPointer()))
+                    result.mHitObject = ptrHolder->getPtr();
+            }
+        }
+    }
+
+    void PhysicsSystem::castRays(const std::vector<RayQuery> &queries, std::vector<RayResult> &results) const
+    {
+        results.resize(queries.size());
+
+        // One range of queries per worker thread, and one for this thread
+        size_t numRanges = mMovementWorkQueue.get() ? mNumMovementThreads + 1 : 1;
+        numRanges = std::max(size_t(1), std::min(queries.size(), numRanges));
+        size_t rangeSize = (queries.size() + numRanges - 1) / numRanges;
+
+        std::vector<osg::ref_ptr<SceneUtil::WorkTicket> > tickets;
+        for (size_t begin = rangeSize; begin < queries.size(); begin += rangeSize)
+            tickets.push_back(mMovementWorkQueue->addWorkItem(new RayQueryItem(*this, queries, begin,
+                                                                               std::min(begin + rangeSize, queries.size()), results)));
+
+        runRayQueries(queries, 0, std::min(rangeSize, queries.size()), results);
+
+        for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = tickets.begin(); it != tickets.end(); ++it)
+            (*it)->waitTillDone();
+    }
+
+    const PhysicsSystem::LineOfSight* PhysicsSystem::findLineOfSight(const Actor *actor1, const Actor *actor2,
+                                                                     const osg::Vec3f &eye1, const osg::Vec3f &eye2) const
+    {
+        if (mLineOfSightCacheTime <= 0.f)
+            return NULL;
+
+        // The same ray serves both directions
+        bool swapped = actor2 < actor1;
+        LineOfSightCache::const_iterator found = mLineOfSightCache.find(swapped ? std::make_pair(actor2, actor1)
+                                                                                : std::make_pair(actor1, actor2));
+        if (found == mLineOfSightCache.end())
+            return NULL;
+
+        const LineOfSight& entry = found->second;
+        const osg::Vec3f& cachedEye1 = swapped ? entry.mEye2 : entry.mEye1;
+        const osg::Vec3f& cachedEye2 = swapped ? entry.mEye1 : entry.mEye2;
+
+        // Distant pairs change less for the same movement, so they are kept longer, up to four times
+        static const float sMaxMove = 16.f;
+        float distance = (eye1 - eye2).length();
+        float maxAge = mLineOfSightCacheTime * std::min(4.f, std::max(1.f, distance / 1024.f));
+        if (mLineOfSightTime - entry.mTime > maxAge
+                || (eye1 - cachedEye1).length2() > sMaxMove*sMaxMove || (eye2 - cachedEye2).length2() > sMaxMove*sMaxMove)
+            return NULL;
+
+        return &entry;
+    }
+
+    void PhysicsSystem::addLineOfSight(const Actor *actor1, const Actor *actor2,
+                                       const osg::Vec3f &eye1, const osg::Vec3f &eye2, bool visible) const
+    {
+        if (mLineOfSightCacheTime <= 0.f)
+            return;
+
+        LineOfSight entry;
+        entry.mTime = mLineOfSightTime;
+        entry.mVisible = visible;
+        if (actor2 < actor1)
+        {
+            entry.mEye1 = eye2;
+            entry.mEye2 = eye1;
+            mLineOfSightCache[std::make_pair(actor2, actor1)] = entry;
+        }
+        else
+        {
+            entry.mEye1 = eye1;
+            entry.mEye2 = eye2;
+            mLineOfSightCache[std::make_pair(actor1, actor2)] = entry;
+        }
+    }
+
     bool PhysicsSystem::getLineOfSight(const MWWorld::ConstPtr &actor1, const MWWorld::ConstPtr &actor2) const
     {
         const Actor* physactor1 = getActor(actor1);
@@ -923,11 +1257,104 @@ namespace MWPhysics
         osg::Vec3f pos1 (physactor1->getPosition() + osg::Vec3f(0,0,physactor1->getHalfExtents().z() * 0.8)); // eye level
         osg::Vec3f pos2 (physactor2->getPosition() + osg::Vec3f(0,0,physactor2->getHalfExtents().z() * 0.8));
 
+        if (const LineOfSight* cached = findLineOfSight(physactor1, physactor2, pos1, pos2))
+            return cached->mVisible;
+
         RayResult result = castRay(pos1, pos2, MWWorld::Ptr(), CollisionType_World|CollisionType_HeightMap|CollisionType_Door);
 
+        addLineOfSight(physactor1, physactor2, pos1, pos2, !result.mHit);
         return !result.mHit;
     }
 
+    void PhysicsSystem::getLineOfSight(const MWWorld::ConstPtr &actor, const std::vector<MWWorld::ConstPtr> &targets,
+                                       std::vector<bool> &results) const
+    {
+        results.assign(targets.size(), false);
+
+        const Actor* physactor1 = getActor(actor);
+        if (!physactor1)
+            return;
+        osg::Vec3f pos1 (physactor1->getPosition() + osg::Vec3f(0,0,physactor1->getHalfExtents().z() * 0.8)); // eye level
+
+        std::vector<RayQuery> queries;
+        std::vector<size_t> targetIndices;
+        std::vector<const Actor*> targetActors;
+        for (size_t i=0; i<targets.size(); ++i)
+        {
+            const Actor* physactor2 = getActor(targets[i]);
+            if (!physactor2)
+                continue;
+            osg::Vec3f pos2 (physactor2->getPosition() + osg::Vec3f(0,0,physactor2->getHalfExtents().z() * 0.8));
+            if (const LineOfSight* cached = findLineOfSight(physactor1, physactor2, pos1, pos2))
+            {
+                results[i] = cached->mVisible;
+                continue;
+            }
+            queries.push_back(RayQuery(pos1, pos2, MWWorld::ConstPtr(), CollisionType_World|CollisionType_HeightMap|CollisionType_Door));
+            targetIndices.push_back(i);
+            targetActors.push_back(physactor2);
+        }
+
+        std::vector<RayResult> rayResults;
+        castRays(queries, rayResults);
+        for (size_t i=0; i<rayResults.size(); ++i)
+        {
+            results[targetIndices[i]] = !rayResults[i].mHit;
+            addLineOfSight(physactor1, targetActors[i], pos1, queries[i].mTo, !rayResults[i].mHit);
+        }
+    }
+
+    class ActorsInRangeCallback : public btBroadphaseAabbCallback
+    {
+    public:
+        ActorsInRangeCallback(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out)
+            : mPosition(position), mSqrRadius(radius*radius), mOut(out)
+        {
+        }
+
+        virtual bool process(const btBroadphaseProxy* proxy)
+        {
+            if (proxy->m_collisionFilterGroup != CollisionType_Actor)
+                return true;
+            const btCollisionObject* object = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+            PtrHolder* holder = static_cast<PtrHolder*>(object->getUserPointer());
+            if (!holder)
+                return true;
+            MWWorld::Ptr ptr = holder->getPtr();
+            if ((ptr.getRefData().getPosition().asVec3() - mPosition).length2() <= mSqrRadius)
+                mOut.push_back(ptr);
+            return true;
+        }
+
+    private:
+        osg::Vec3f mPosition;
+        float mSqrRadius;
+        std::vector<MWWorld::Ptr>& mOut;
+    };
+
+    void PhysicsSystem::getActorsInRange(const osg::Vec3f &position, float radius, std::vector<MWWorld::Ptr> &out) const
+    {
+        // The collision boxes are offset from the actor positions, so look a bit further than the radius
+        const float extent = radius + mActorQueryMargin;
+        const btVector3 aabbMin = toBullet(position) - btVector3(extent, extent, extent);
+        const btVector3 aabbMax = toBullet(position) + btVector3(extent, extent, extent);
+
+        std::vector<MWWorld::Ptr> found;
+        ActorsInRangeCallback callback(position, radius, found);
+        mCollisionWorld->getBroadphase()->aabbTest(aabbMin, aabbMax, callback);
+
+        // The broadphase order is arbitrary, the callers expect the order of the mechanics actor map
+        std::sort(found.begin(), found.end());
+        out.insert(out.end(), found.begin(), found.end());
+    }
+
+    void PhysicsSystem::updateActorQueryMargin(const Actor *actor)
+    {
+        const osg::Vec3f offset = actor->getPosition() - actor->getPtr().getRefData().getPosition().asVec3();
+        // Plus a bit, for rounding errors of the broadphase bounds
+        mActorQueryMargin = std::max(mActorQueryMargin, offset.length() + 1.f);
+    }
+
     // physactor->getOnGround() is not a reliable indicator of whether the actor
     // is on the ground (defaults to false, which means code blocks such as
     // CharacterController::update() may falsely detect "falling").
@@ -1040,6 +1467,7 @@ namespace MWPhysics
         ContactTestResultCallback resultCallback (me);
         resultCallback.m_collisionFilterGroup = collisionGroup;
         resultCallback.m_collisionFilterMask = collisionMask;
+        ++sNumContactTests;
         mCollisionWorld->contactTest(me, resultCallback);
         return resultCallback.mResult;
     }
@@ -1053,9 +1481,9 @@ namespace MWPhysics
             return MovementSolver::traceDown(ptr, found->second, mCollisionWorld, maxHeight);
     }
 
-    void PhysicsSystem::addHeightField (const float* heights, int x, int y, float triSize, float sqrtVerts)
+    void PhysicsSystem::addHeightField (const float* heights, int x, int y, float triSize, float sqrtVerts, const osg::Referenced* holdObject)
     {
-        HeightField *heightfield = new HeightField(heights, x, y, triSize, sqrtVerts);
+        osg::ref_ptr<HeightField> heightfield = new HeightField(heights, x, y, triSize, sqrtVerts, holdObject);
         mHeightFields[std::make_pair(x,y)] = heightfield;
 
         mCollisionWorld->addCollisionObject(heightfield->getCollisionObject(), CollisionType_HeightMap,
@@ -1068,7 +1496,6 @@ namespace MWPhysics
         if(heightfield != mHeightFields.end())
         {
             mCollisionWorld->removeCollisionObject(heightfield->second->getCollisionObject());
-            delete heightfield->second;
             mHeightFields.erase(heightfield);
         }
     }
@@ -1105,6 +1532,23 @@ namespace MWPhysics
         ActorMap::iterator foundActor = mActors.find(ptr);
         if (foundActor != mActors.end())
         {
+            waitForQueuedMovement();
+            for (std::vector<MovementJob>::iterator it = mMovementJobs.begin(); it != mMovementJobs.end();)
+            {
+                if (it->mActor == foundActor->second)
+                    it = mMovementJobs.erase(it);
+                else
+                    ++it;
+            }
+
+            for (LineOfSightCache::iterator it = mLineOfSightCache.begin(); it != mLineOfSightCache.end();)
+            {
+                if (it->first.first == foundActor->second || it->first.second == foundActor->second)
+                    mLineOfSightCache.erase(it++);
+                else
+                    ++it;
+            }
+
             delete foundActor->second;
             mActors.erase(foundActor);
         }
@@ -1147,6 +1591,13 @@ namespace MWPhysics
         }
 
         updateCollisionMapPtr(mStandingCollisions, old, updated);
+
+        for (std::vector<MovementJob>::iterator it = mMovementJobs.begin(); it != mMovementJobs.end(); ++it)
+        {
+            if (it->mPtr == old)
+                it->mPtr = updated;
+            updateCollisionMapPtr(it->mStandingCollisions, old, updated);
+        }
     }
 
     Actor *PhysicsSystem::getActor(const MWWorld::Ptr &ptr)
@@ -1180,6 +1631,7 @@ namespace MWPhysics
         {
             foundActor->second->updateScale();
             mCollisionWorld->updateSingleAabb(foundActor->second->getCollisionObject());
+            updateActorQueryMargin(foundActor->second);
             return;
         }
     }
@@ -1189,15 +1641,17 @@ namespace MWPhysics
         ObjectMap::iterator found = mObjects.find(ptr);
         if (found != mObjects.end())
         {
+            const btTransform previous = found->second->getCollisionObject()->getWorldTransform();
             found->second->setRotation(toBullet(ptr.getRefData().getBaseNode()->getAttitude()));
-            mCollisionWorld->updateSingleAabb(found->second->getCollisionObject());
+            updateAabbIfMoved(found->second->getCollisionObject(), previous);
             return;
         }
         ActorMap::iterator foundActor = mActors.find(ptr);
         if (foundActor != mActors.end())
         {
+            const btTransform previous = foundActor->second->getCollisionObject()->getWorldTransform();
             foundActor->second->updateRotation();
-            mCollisionWorld->updateSingleAabb(foundActor->second->getCollisionObject());
+            updateAabbIfMoved(foundActor->second->getCollisionObject(), previous);
             return;
         }
     }
@@ -1207,19 +1661,28 @@ namespace MWPhysics
         ObjectMap::iterator found = mObjects.find(ptr);
         if (found != mObjects.end())
         {
+            const btTransform previous = found->second->getCollisionObject()->getWorldTransform();
             found->second->setOrigin(toBullet(ptr.getRefData().getPosition().asVec3()));
-            mCollisionWorld->updateSingleAabb(found->second->getCollisionObject());
+            updateAabbIfMoved(found->second->getCollisionObject(), previous);
             return;
         }
         ActorMap::iterator foundActor = mActors.find(ptr);
         if (foundActor != mActors.end())
         {
+            const btTransform previous = foundActor->second->getCollisionObject()->getWorldTransform();
             foundActor->second->updatePosition();
-            mCollisionWorld->updateSingleAabb(foundActor->second->getCollisionObject());
+            updateAabbIfMoved(foundActor->second->getCollisionObject(), previous);
             return;
         }
     }
 
+    void PhysicsSystem::updateAabbIfMoved(btCollisionObject *object, const btTransform &previous)
+    {
+        // Most actors and objects are touched every frame without moving, and their AABBs stay valid
+        if (!(object->getWorldTransform() == previous))
+            mCollisionWorld->updateSingleAabb(object);
+    }
+
     void PhysicsSystem::addActor (const MWWorld::Ptr& ptr, const std::string& mesh) {
         osg::ref_ptr<Resource::BulletShapeInstance> shapeInstance = mShapeManager->createInstance(mesh);
         if (!shapeInstance)
@@ -1227,6 +1690,7 @@ namespace MWPhysics
 
         Actor* actor = new Actor(ptr, shapeInstance, mCollisionWorld);
         mActors.insert(std::make_pair(ptr, actor));
+        updateActorQueryMargin(actor);
     }
 
     bool PhysicsSystem::toggleCollisionMode()
@@ -1260,70 +1724,272 @@ namespace MWPhysics
 
     void PhysicsSystem::clearQueuedMovement()
     {
+        waitForQueuedMovement();
         mMovementQueue.clear();
+        mMovementJobs.clear();
+        mAsyncMovementQueued = false;
         mStandingCollisions.clear();
     }
 
-    const PtrVelocityList& PhysicsSystem::applyQueuedMovement(float dt)
+    void PhysicsSystem::createMovementJobs(std::vector<MovementJob>& jobs)
     {
-        mMovementResults.clear();
+        const MWBase::World *world = MWBase::Environment::get().getWorld();
 
-        mTimeAccum += dt;
-        if(mTimeAccum >= 1.0f/60.0f)
+        // Resolve the settings the solver reads now, since the first read after a change of the store updates them
+        const MWWorld::GmstRegistry &gmsts = world->getStore().getGmsts();
+        gmsts.getFloat(MWWorld::GmstRegistry::fSwimHeightScale);
+        gmsts.getFloat(MWWorld::GmstRegistry::fStromWalkMult);
+
+        jobs.reserve(mMovementQueue.size());
+
+        PtrVelocityList::iterator iter = mMovementQueue.begin();
+        for(;iter != mMovementQueue.end();++iter)
         {
-            // Collision events should be available on every frame
-            mStandingCollisions.clear();
+            ActorMap::iterator foundActor = mActors.find(iter->first);
+            if (foundActor == mActors.end()) // actor was already removed from the scene
+                continue;
+            Actor* physicActor = foundActor->second;
+
+            float waterlevel = -std::numeric_limits<float>::max();
+            const MWWorld::CellStore *cell = iter->first.getCell();
+            if(cell->getCell()->hasWater())
+                waterlevel = cell->getWaterLevel();
+
+            const osg::Vec3f position = iter->first.getRefData().getPosition().asVec3();
+
+            const MWMechanics::MagicEffects& effects = iter->first.getClass().getCreatureStats(iter->first).getMagicEffects();
+
+            bool waterCollision = false;
+            if (effects.get(ESM::MagicEffect::WaterWalking).getMagnitude()
+                    && cell->getCell()->hasWater()
+                    && !world->isUnderwater(iter->first.getCell(),
+                                           osg::Vec3f(iter->first.getRefData().getPosition().asVec3())))
+                waterCollision = true;
+
+            physicActor->setCanWaterWalk(waterCollision);
+
+            // Slow fall reduces fall speed by a factor of (effect magnitude / 200)
+            float slowFall = 1.f - std::max(0.f, std::min(1.f, effects.get(ESM::MagicEffect::SlowFall).getMagnitude() * 0.005f));
+
+            MovementJob job;
+            job.mPtr = iter->first;
+            job.mActor = physicActor;
+            job.mMovement = iter->second;
+            job.mIsFlying = world->isFlying(iter->first);
+            job.mWaterLevel = waterlevel;
+            job.mSlowFall = slowFall;
+            job.mOldHeight = position.z();
+            job.mStartPosition = position;
+            job.mPosition = position;
+            job.mPreviousPosition = position;
+            // Continue from the last step, unless something else moved the actor since
+            if (mFixedTimestep && physicActor->hasTickPositions() && physicActor->getReportedPosition() == position)
+            {
+                job.mPosition = physicActor->getTickPosition();
+                job.mPreviousPosition = physicActor->getPreviousTickPosition();
+            }
+            jobs.push_back(job);
+        }
+    }
 
-            const MWBase::World *world = MWBase::Environment::get().getWorld();
-            PtrVelocityList::iterator iter = mMovementQueue.begin();
-            for(;iter != mMovementQueue.end();++iter)
+    void PhysicsSystem::solveMovementJobs(std::vector<MovementJob>& jobs, bool wait)
+    {
+        // One range of jobs per worker thread, and one for this thread if it has to wait anyway
+        size_t numRanges = mMovementWorkQueue.get() && mMovementNumSteps > 0 ? mNumMovementThreads : 0;
+        if (wait || numRanges == 0)
+            ++numRanges;
+        numRanges = std::max(size_t(1), std::min(jobs.size(), numRanges));
+        size_t rangeSize = (jobs.size() + numRanges - 1) / numRanges;
+
+        // No jobs are in progress, so the errors can be reset
+        mMovementErrors.assign(numRanges, std::string());
+
+        size_t begin = 0;
+        size_t range = 0;
+        if (wait || mMovementNumSteps == 0)
+        {
+            begin = rangeSize;
+            try
+            {
+                solveMovement(jobs, 0, std::min(rangeSize, jobs.size()), mMovementStepTime, mMovementNumSteps, mCollisionWorld);
+            }
+            catch (std::exception& e)
             {
-                float waterlevel = -std::numeric_limits<float>::max();
-                const MWWorld::CellStore *cell = iter->first.getCell();
-                if(cell->getCell()->hasWater())
-                    waterlevel = cell->getWaterLevel();
+                mMovementErrors[range] = e.what();
+            }
+            ++range;
+        }
+        for (; begin < jobs.size(); begin += rangeSize, ++range)
+            mMovementTickets.push_back(mMovementWorkQueue->addWorkItem(new SolveMovementItem(jobs, begin,
+                                                std::min(begin + rangeSize, jobs.size()), mMovementStepTime,
+                                                mMovementNumSteps, mCollisionWorld, &mMovementErrors[range])));
 
-                float oldHeight = iter->first.getRefData().getPosition().pos[2];
+        if (wait)
+        {
+            waitForQueuedMovement();
+            raiseMovementErrors();
+        }
+    }
+
+    void PhysicsSystem::raiseMovementErrors()
+    {
+        for (std::vector<std::string>::iterator it = mMovementErrors.begin(); it != mMovementErrors.end(); ++it)
+        {
+            if (!it->empty())
+            {
+                std::string error = *it;
+                mMovementErrors.clear();
+                throw std::runtime_error(error);
+            }
+        }
+        mMovementErrors.clear();
+    }
 
-                const MWMechanics::MagicEffects& effects = iter->first.getClass().getCreatureStats(iter->first).getMagicEffects();
+    void PhysicsSystem::applyMovementJobs(const std::vector<MovementJob>& jobs)
+    {
+        // Collision events should be available on every frame, and last until the next step
+        if (mMovementNumSteps > 0)
+            mStandingCollisions.clear();
 
-                bool waterCollision = false;
-                if (effects.get(ESM::MagicEffect::WaterWalking).getMagnitude()
-                        && cell->getCell()->hasWater()
-                        && !world->isUnderwater(iter->first.getCell(),
-                                               osg::Vec3f(iter->first.getRefData().getPosition().asVec3())))
-                    waterCollision = true;
+        for (std::vector<MovementJob>::const_iterator it = jobs.begin(); it != jobs.end(); ++it)
+        {
+            // In asynchronous mode, the actor may have been removed since
+            ActorMap::const_iterator foundActor = mActors.find(it->mPtr);
+            if (foundActor == mActors.end() || foundActor->second != it->mActor)
+                continue;
+
+            // In asynchronous mode, a script or the mechanics may also have placed the actor elsewhere since, e.g. with
+            // SetPos. The result was solved from the old position, applying it would move the actor back.
+            if (it->mPtr.getRefData().getPosition().asVec3() != it->mStartPosition)
+                continue;
+
+            osg::Vec3f position = it->mNewPosition;
+            if (mFixedTimestep)
+            {
+                position = it->mPreviousPosition + (it->mNewPosition - it->mPreviousPosition) * mMovementInterpolation;
+                it->mActor->setTickPositions(it->mPreviousPosition, it->mNewPosition, position);
+            }
 
-                ActorMap::iterator foundActor = mActors.find(iter->first);
-                if (foundActor == mActors.end()) // actor was already removed from the scene
-                    continue;
-                Actor* physicActor = foundActor->second;
-                physicActor->setCanWaterWalk(waterCollision);
+            float heightDiff = position.z() - it->mOldHeight;
 
-                // Slow fall reduces fall speed by a factor of (effect magnitude / 200)
-                float slowFall = 1.f - std::max(0.f, std::min(1.f, effects.get(ESM::MagicEffect::SlowFall).getMagnitude() * 0.005f));
+            if (heightDiff < 0)
+                it->mPtr.getClass().getCreatureStats(it->mPtr).addToFallHeight(-heightDiff);
 
-                osg::Vec3f newpos = MovementSolver::move(physicActor->getPtr(), physicActor, iter->second, mTimeAccum,
-                                                            world->isFlying(iter->first),
-                                                            waterlevel, slowFall, mCollisionWorld, mStandingCollisions);
+            if (mMovementNumSteps > 0)
+                mStandingCollisions.insert(it->mStandingCollisions.begin(), it->mStandingCollisions.end());
 
-                float heightDiff = newpos.z() - oldHeight;
+            mMovementResults.push_back(std::make_pair(it->mPtr, position));
+        }
+    }
 
-                if (heightDiff < 0)
-                    iter->first.getClass().getCreatureStats(iter->first).addToFallHeight(-heightDiff);
+    const PtrVelocityList& PhysicsSystem::applyQueuedMovement(float dt)
+    {
+        OPENMW_PROFILE_ZONE ("PhysicsSystem::applyQueuedMovement");
 
-                mMovementResults.push_back(std::make_pair(iter->first, newpos));
+        mMovementResults.clear();
+
+        if (mAsyncMovement)
+        {
+            waitForQueuedMovement();
+            if (!mMovementJobs.empty())
+            {
+                // A range that failed has no results, so none of the jobs are applied, like in synchronous mode
+                try
+                {
+                    raiseMovementErrors();
+                }
+                catch (std::exception&)
+                {
+                    mMovementJobs.clear();
+                    throw;
+                }
+                applyMovementJobs(mMovementJobs);
+                mMovementJobs.clear();
             }
+            // The movement kept last time was never solved, so solve its time together with this frame's
+            if (mAsyncMovementQueued)
+                mTimeAccum += mMovementStepTime * mMovementNumSteps;
+            mAsyncMovementQueued = false;
+        }
+
+        mTimeAccum += dt;
+
+        // Drop the lines of sight that are too old for any distance
+        mLineOfSightTime += dt;
+        for (LineOfSightCache::iterator it = mLineOfSightCache.begin(); it != mLineOfSightCache.end();)
+        {
+            if (mLineOfSightTime - it->second.mTime > mLineOfSightCacheTime * 4.f)
+                mLineOfSightCache.erase(it++);
+            else
+                ++it;
+        }
 
+        if (mFixedTimestep)
+        {
+            mMovementStepTime = mTickTime;
+            mMovementNumSteps = static_cast<int>(mTimeAccum / mTickTime);
+            mTimeAccum -= mMovementNumSteps * mTickTime;
+            mMovementInterpolation = mTimeAccum / mTickTime;
+        }
+        else if (mTimeAccum >= mTickTime)
+        {
+            mMovementStepTime = mTimeAccum;
+            mMovementNumSteps = 1;
+            mMovementInterpolation = 1.f;
             mTimeAccum = 0.0f;
         }
+        else
+        {
+            mMovementQueue.clear();
+            return mMovementResults;
+        }
+
+        if (mAsyncMovement)
+        {
+            // Keep the queue for solveQueuedMovementAsync()
+            mAsyncMovementQueued = true;
+            return mMovementResults;
+        }
+
+        std::vector<MovementJob> jobs;
+        createMovementJobs(jobs);
+        solveMovementJobs(jobs, true);
+        applyMovementJobs(jobs);
+
         mMovementQueue.clear();
 
         return mMovementResults;
     }
 
+    void PhysicsSystem::solveQueuedMovementAsync()
+    {
+        OPENMW_PROFILE_ZONE ("PhysicsSystem::solveQueuedMovementAsync");
+
+        if (!mAsyncMovementQueued)
+            return;
+        mAsyncMovementQueued = false;
+
+        waitForQueuedMovement();
+        mMovementJobs.clear();
+        createMovementJobs(mMovementJobs);
+        mMovementQueue.clear();
+
+        solveMovementJobs(mMovementJobs, false);
+    }
+
+    void PhysicsSystem::waitForQueuedMovement()
+    {
+        OPENMW_PROFILE_ZONE ("PhysicsSystem::waitForQueuedMovement");
+
+        for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mMovementTickets.begin(); it != mMovementTickets.end(); ++it)
+            (*it)->waitTillDone();
+        mMovementTickets.clear();
+    }
+
     void PhysicsSystem::stepSimulation(float dt)
     {
+        OPENMW_PROFILE_ZONE ("PhysicsSystem::stepSimulation");
+
         for (std::set<Object*>::iterator it = mAnimatedObjects.begin(); it != mAnimatedObjects.end(); ++it)
             (*it)->animateCollisionShapes(mCollisionWorld);
 
@@ -1331,6 +1997,19 @@ namespace MWPhysics
         CProfileManager::Increment_Frame_Counter();
     }
 
+    void PhysicsSystem::reportStats(unsigned int frameNumber, osg::Stats &stats) const
+    {
+        const unsigned int numSolved = sNumSolvedActors.exchange(0);
+        const unsigned int solveMicroseconds = sSolveMicroseconds.exchange(0);
+
+        stats.setAttribute(frameNumber, "physics_solved_actors", numSolved);
+        stats.setAttribute(frameNumber, "physics_solve_time_per_actor", numSolved ? solveMicroseconds / 1000000.0 / numSolved : 0.0);
+        stats.setAttribute(frameNumber, "physics_sweeps", takeNumSweeps());
+        stats.setAttribute(frameNumber, "physics_trace_downs", sNumTraceDowns.exchange(0));
+        stats.setAttribute(frameNumber, "physics_contact_tests", sNumContactTests.exchange(0));
+        stats.setAttribute(frameNumber, "physics_collision_objects", mCollisionWorld->getNumCollisionObjects());
+    }
+
     void PhysicsSystem::debugDraw()
     {
         if (mDebugDrawer.get())
@@ -1412,4 +2091,69 @@ namespace MWPhysics
         mCollisionWorld->addCollisionObject(mWaterCollisionObject.get(), CollisionType_Water,
                                                     CollisionType_Actor);
     }
+
+    void PhysicsSystem::addNavigationCell(const MWWorld::CellStore *cell)
+    {
+        if (!mNavigator.get())
+            return;
+
+        // Objects reaching into an exterior cell are part of its geometry, whichever cell they belong to
+        const bool exterior = cell->getCell()->isExterior();
+        const float cellSize = ESM::Land::REAL_SIZE;
+        const btVector3 cellMin(cell->getCell()->getGridX() * cellSize, cell->getCell()->getGridY() * cellSize, 0.f);
+        const btVector3 cellMax(cellMin.x() + cellSize, cellMin.y() + cellSize, 0.f);
+
+        osg::ref_ptr<NavGeometry> geometry = new NavGeometry;
+        for (ObjectMap::const_iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+        {
+            const Object* object = it->second;
+            btCollisionObject* collisionObject = const_cast<Object*>(object)->getCollisionObject();
+            // Animated objects and doors move, and the grid would not follow them
+            if (object->isAnimated() || !collisionObject->getBroadphaseHandle()
+                    || collisionObject->getBroadphaseHandle()->m_collisionFilterGroup != CollisionType_World)
+                continue;
+
+            if (exterior)
+            {
+                btVector3 aabbMin, aabbMax;
+                collisionObject->getCollisionShape()->getAabb(collisionObject->getWorldTransform(), aabbMin, aabbMax);
+                if (aabbMax.x() < cellMin.x() || aabbMin.x() > cellMax.x()
+                        || aabbMax.y() < cellMin.y() || aabbMin.y() > cellMax.y())
+                    continue;
+            }
+            else if (it->first.getCell() != cell)
+                continue;
+
+            geometry->addCollisionObject(*collisionObject, object->getShapeInstance(),
+                                         it->first.getClass().getModel(it->first));
+        }
+
+        if (exterior)
+        {
+            HeightFieldMap::const_iterator heightfield = mHeightFields.find(
+                        std::make_pair(cell->getCell()->getGridX(), cell->getCell()->getGridY()));
+            if (heightfield != mHeightFields.end())
+            {
+                geometry->addCollisionObject(*heightfield->second->getCollisionObject(), heightfield->second.get(), "");
+                geometry->addToHash(heightfield->second->getHeights(),
+                                    heightfield->second->getNumHeights() * sizeof(float));
+            }
+        }
+
+        mNavigator->addCell(cell, geometry);
+    }
+
+    void PhysicsSystem::removeNavigationCell(const MWWorld::CellStore *cell)
+    {
+        if (mNavigator.get())
+            mNavigator->removeCell(cell);
+    }
+
+    bool PhysicsSystem::findNavigationPath(const MWWorld::CellStore *cell, const osg::Vec3f &start, const osg::Vec3f &end,
+                                           std::vector<osg::Vec3f> &path) const
+    {
+        if (!mNavigator.get())
+            return false;
+        return mNavigator->findPath(cell, start, end, path);
+    }
 }
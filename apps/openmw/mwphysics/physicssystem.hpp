@@ -4,10 +4,14 @@
 #include <memory>
 #include <map>
 #include <set>
+#include <vector>
 
 #include <osg/Quat>
+#include <osg/Vec3f>
 #include <osg/ref_ptr>
 
+#include <boost/filesystem/path.hpp>
+
 #include "../mwworld/ptr.hpp"
 
 #include "collisiontype.hpp"
@@ -15,6 +19,8 @@
 namespace osg
 {
     class Group;
+    class Referenced;
+    class Stats;
 }
 
 namespace MWRender
@@ -32,12 +38,19 @@ namespace Resource
     class ResourceSystem;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+    class WorkTicket;
+}
+
 class btCollisionWorld;
 class btBroadphaseInterface;
 class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
 class btCollisionObject;
 class btCollisionShape;
+class btTransform;
 
 namespace MWPhysics
 {
@@ -46,13 +59,39 @@ namespace MWPhysics
     class HeightField;
     class Object;
     class Actor;
+    class Navigator;
+
+    /// The queued movement of one actor, see PhysicsSystem::applyQueuedMovement.
+    struct MovementJob
+    {
+        MWWorld::Ptr mPtr;
+        Actor* mActor;
+        osg::Vec3f mMovement;
+        bool mIsFlying;
+        float mWaterLevel;
+        float mSlowFall;
+        float mOldHeight;
+
+        // The position of the object when the job was created, to tell whether something else moved it since
+        osg::Vec3f mStartPosition;
+        // Where to move from, and the position before the last step
+        osg::Vec3f mPosition;
+        osg::Vec3f mPreviousPosition;
+        osg::Vec3f mNewPosition;
+        // The standing collisions of this actor only, so that actors can be solved in parallel
+        std::map<MWWorld::Ptr, MWWorld::Ptr> mStandingCollisions;
+    };
 
     class PhysicsSystem
     {
         public:
-            PhysicsSystem (Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> parentNode);
+            /// @param navigationCacheDirectory Where to store the navigation grids, see Navigator. Empty to not store them.
+            PhysicsSystem (Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> parentNode,
+                           const boost::filesystem::path& navigationCacheDirectory);
             ~PhysicsSystem ();
 
+            Resource::BulletShapeManager* getShapeManager();
+
             void enableWater(float height);
             void setWaterHeight(float height);
             void disableWater();
@@ -73,7 +112,8 @@ namespace MWPhysics
             void updatePosition (const MWWorld::Ptr& ptr);
 
 
-            void addHeightField (const float* heights, int x, int y, float triSize, float sqrtVerts);
+            /// @param holdObject Kept referenced while the heightfield exists, since the heights are not copied.
+            void addHeightField (const float* heights, int x, int y, float triSize, float sqrtVerts, const osg::Referenced* holdObject);
 
             void removeHeightField (int x, int y);
 
@@ -82,6 +122,9 @@ namespace MWPhysics
             void stepSimulation(float dt);
             void debugDraw();
 
+            /// Set the physics counts since the last call as attributes of the frame, for the on-screen stats.
+            void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
+
             std::vector<MWWorld::Ptr> getCollisions(const MWWorld::ConstPtr &ptr, int collisionGroup, int collisionMask) const; ///< get handles this object collides with
             osg::Vec3f traceDown(const MWWorld::Ptr &ptr, float maxHeight);
 
@@ -111,9 +154,44 @@ namespace MWPhysics
 
             RayResult castSphere(const osg::Vec3f& from, const osg::Vec3f& to, float radius);
 
+            /// A ray like castRay(), or a sphere sweep like castSphere() if mRadius is not 0, for castRays().
+            struct RayQuery
+            {
+                RayQuery(const osg::Vec3f& from, const osg::Vec3f& to, MWWorld::ConstPtr ignore = MWWorld::ConstPtr(),
+                         int mask = CollisionType_World|CollisionType_HeightMap|CollisionType_Actor|CollisionType_Door,
+                         int group = 0xff, float radius = 0.f)
+                    : mFrom(from), mTo(to), mIgnore(ignore), mMask(mask), mGroup(group), mRadius(radius)
+                {
+                }
+
+                osg::Vec3f mFrom;
+                osg::Vec3f mTo;
+                /// Optional, a Ptr to ignore in the results
+                MWWorld::ConstPtr mIgnore;
+                int mMask;
+                int mGroup;
+                float mRadius;
+            };
+
+            /// Run many queries at once. They only read the collision world, so they are spread over this thread and
+            /// the movement solver threads.
+            /// @param results Resized to the number of queries, in the same order.
+            void castRays(const std::vector<RayQuery>& queries, std::vector<RayResult>& results) const;
+
             /// Return true if actor1 can see actor2.
+            /// @note The result is cached for both directions, until either actor moved, or for a time that grows with
+            /// the distance between them.
             bool getLineOfSight(const MWWorld::ConstPtr& actor1, const MWWorld::ConstPtr& actor2) const;
 
+            /// Which of the targets the actor can see, like getLineOfSight(), with one castRays() for the ones not in the cache.
+            void getLineOfSight(const MWWorld::ConstPtr& actor, const std::vector<MWWorld::ConstPtr>& targets,
+                                std::vector<bool>& results) const;
+
+            /// Add the actors within the radius of the position to \a out, sorted by MWWorld::Ptr. Only the actors near the
+            /// position are looked at, using the broadphase of the collision world.
+            /// @note Actors without a collision shape are not found.
+            void getActorsInRange(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out) const;
+
             bool isOnGround (const MWWorld::Ptr& actor);
 
             /// Get physical half extents (scaled) of the given actor.
@@ -131,8 +209,17 @@ namespace MWPhysics
             void queueObjectMovement(const MWWorld::Ptr &ptr, const osg::Vec3f &velocity);
 
             /// Apply all queued movements, then clear the list.
+            /// @note In asynchronous mode ([Physics] "async movement"), returns the movement solved since the last
+            /// solveQueuedMovementAsync() instead, and keeps the queued movement for the next solveQueuedMovementAsync().
             const PtrVelocityList& applyQueuedMovement(float dt);
 
+            /// In asynchronous mode, start solving the movement kept by applyQueuedMovement on the worker threads,
+            /// e.g. while the frame renders. Nothing may use the physics system until waitForQueuedMovement().
+            void solveQueuedMovementAsync();
+
+            /// Wait until the movement started by solveQueuedMovementAsync() is solved.
+            void waitForQueuedMovement();
+
             /// Clear the queued movements list without applying.
             void clearQueuedMovement();
 
@@ -159,6 +246,19 @@ namespace MWPhysics
 
             bool isOnSolidGround (const MWWorld::Ptr& actor) const;
 
+            /// Start building the navigation grid of the cell in the background, from the static objects and terrain
+            /// that are in the collision world now. Does nothing unless [Physics] "navigation grid" is enabled.
+            /// @note Call when the objects of the cell are loaded.
+            void addNavigationCell(const MWWorld::CellStore* cell);
+
+            void removeNavigationCell(const MWWorld::CellStore* cell);
+
+            /// Find a path on the navigation grid of the cell.
+            /// @param path The points to walk to after the start, without the end.
+            /// @return false if there is no path, or the grid of the cell is not built yet.
+            bool findNavigationPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                                    std::vector<osg::Vec3f>& path) const;
+
         private:
 
             void updateWater();
@@ -169,6 +269,7 @@ namespace MWPhysics
             btCollisionWorld* mCollisionWorld;
 
             std::auto_ptr<Resource::BulletShapeManager> mShapeManager;
+            Resource::ResourceSystem* mResourceSystem;
 
             typedef std::map<MWWorld::ConstPtr, Object*> ObjectMap;
             ObjectMap mObjects;
@@ -178,7 +279,14 @@ namespace MWPhysics
             typedef std::map<MWWorld::ConstPtr, Actor*> ActorMap;
             ActorMap mActors;
 
-            typedef std::map<std::pair<int, int>, HeightField*> HeightFieldMap;
+            // The largest distance of an actor's collision box center from its position, for getActorsInRange()
+            float mActorQueryMargin;
+            void updateActorQueryMargin(const Actor* actor);
+
+            /// Update the AABB of the collision object, unless its transform is still the previous one.
+            void updateAabbIfMoved(btCollisionObject* object, const btTransform& previous);
+
+            typedef std::map<std::pair<int, int>, osg::ref_ptr<HeightField> > HeightFieldMap;
             HeightFieldMap mHeightFields;
 
             bool mDebugDrawEnabled;
@@ -191,11 +299,79 @@ namespace MWPhysics
             // replaces all occurences of 'old' in the map by 'updated', no matter if its a key or value
             void updateCollisionMapPtr(CollisionMap& map, const MWWorld::Ptr &old, const MWWorld::Ptr &updated);
 
+            class RayQueryItem;
+
+            /// Run the given queries. Only reads the collision world, so it can run on any thread.
+            void runRayQueries(const std::vector<RayQuery>& queries, size_t begin, size_t end, std::vector<RayResult>& results) const;
+
+            /// Turn the queued movement into jobs for the actors that are still in the scene.
+            void createMovementJobs(std::vector<MovementJob>& jobs);
+
+            /// Hand the jobs to the worker threads, to move them by the current steps. If \a wait, also solve some of them
+            /// on this thread and wait for all.
+            void solveMovementJobs(std::vector<MovementJob>& jobs, bool wait);
+
+            /// Add the results of solved jobs to mMovementResults, and apply their fall heights and standing collisions.
+            void applyMovementJobs(const std::vector<MovementJob>& jobs);
+
+            /// Throw the first error of the last solved movement jobs again, if there was one. Call after
+            /// waitForQueuedMovement(), so that no thread uses the jobs any more.
+            void raiseMovementErrors();
+
             PtrVelocityList mMovementQueue;
             PtrVelocityList mMovementResults;
 
+            // Solves the movement of actors in parallel with the main thread. NULL to solve it on the main thread only.
+            // Separate from the global work queue, which may be busy loading for a while.
+            std::auto_ptr<SceneUtil::WorkQueue> mMovementWorkQueue;
+
+            // NULL unless [Physics] "navigation grid" is enabled
+            std::auto_ptr<Navigator> mNavigator;
+            int mNumMovementThreads;
+            std::vector<osg::ref_ptr<SceneUtil::WorkTicket> > mMovementTickets;
+            // The error of each range of the movement jobs in progress, empty if it was solved
+            std::vector<std::string> mMovementErrors;
+
+            // Asynchronous mode: the jobs solved by the worker threads between solveQueuedMovementAsync() and the next
+            // applyQueuedMovement()
+            bool mAsyncMovement;
+            bool mAsyncMovementQueued;
+            std::vector<MovementJob> mMovementJobs;
+
+            // With a fixed timestep, the movement is solved in steps of mTickTime, and the results are interpolated
+            // between the last two steps. Otherwise, in one step once at least mTickTime passed.
+            bool mFixedTimestep;
+            float mTickTime;
+
+            // The steps of the current movement, and where to report the actors between the last two steps
+            float mMovementStepTime;
+            int mMovementNumSteps;
+            float mMovementInterpolation;
+
             float mTimeAccum;
 
+            struct LineOfSight
+            {
+                // The eye positions the ray was cast between
+                osg::Vec3f mEye1;
+                osg::Vec3f mEye2;
+                double mTime;
+                bool mVisible;
+            };
+            // By the pair of actors, the one with the lower address first
+            typedef std::map<std::pair<const Actor*, const Actor*>, LineOfSight> LineOfSightCache;
+            mutable LineOfSightCache mLineOfSightCache;
+            // The game time the line of sight cache is at, advanced by applyQueuedMovement
+            double mLineOfSightTime;
+            // In seconds, for actors close to each other. 0 disables the cache.
+            float mLineOfSightCacheTime;
+
+            /// The cached line of sight between the actors at the given eye positions, if it is still valid.
+            const LineOfSight* findLineOfSight(const Actor* actor1, const Actor* actor2,
+                                               const osg::Vec3f& eye1, const osg::Vec3f& eye2) const;
+            void addLineOfSight(const Actor* actor1, const Actor* actor2,
+                                const osg::Vec3f& eye1, const osg::Vec3f& eye2, bool visible) const;
+
             float mWaterHeight;
             float mWaterEnabled;
 
@@ -2,7 +2,11 @@
 
 #include <map>
 
+#include <OpenThreads/Atomic>
+
 #include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/BroadphaseCollision/btBroadphaseInterface.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
 #include <BulletCollision/CollisionShapes/btConvexShape.h>
 #include <BulletCollision/CollisionShapes/btCylinderShape.h>
 
@@ -13,6 +17,9 @@
 namespace MWPhysics
 {
 
+// For the viewer stats, counted on all threads
+static OpenThreads::Atomic sNumSweeps;
+
 class ClosestNotMeConvexResultCallback : public btCollisionWorld::ClosestConvexResultCallback
 {
 public:
@@ -49,6 +56,95 @@ protected:
     const btScalar mMinSlopeDot;
 };
 
+/// Sweeps the shape against each object whose bounds overlap the bounds of the sweep.
+/// @note btCollisionWorld::convexSweepTest finds the objects with a ray test of the broadphase, which uses a stack stored
+/// in the broadphase, so sweeps could not run on several threads at once. The aabbTest of the broadphase keeps its stack local.
+class SweepAabbCallback : public btBroadphaseAabbCallback
+{
+public:
+    SweepAabbCallback(const btConvexShape* shape, const btTransform& from, const btTransform& to,
+                      btCollisionWorld::ConvexResultCallback& resultCallback)
+        : mShape(shape), mFrom(from), mTo(to), mResultCallback(resultCallback)
+    {
+    }
+
+    virtual bool process(const btBroadphaseProxy* proxy)
+    {
+        const btCollisionObject* object = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+        if (mResultCallback.needsCollision(object->getBroadphaseHandle()))
+            btCollisionWorld::objectQuerySingle(mShape, mFrom, mTo, object, object->getCollisionShape(),
+                                                object->getWorldTransform(), mResultCallback, 0.f);
+        return true;
+    }
+
+private:
+    const btConvexShape* mShape;
+    const btTransform& mFrom;
+    const btTransform& mTo;
+    btCollisionWorld::ConvexResultCallback& mResultCallback;
+};
+
+void convexSweepTest(const btConvexShape* shape, const btTransform& from, const btTransform& to,
+                     btCollisionWorld* world, btCollisionWorld::ConvexResultCallback& resultCallback)
+{
+    ++sNumSweeps;
+
+    btVector3 aabbMin, aabbMax, toMin, toMax;
+    shape->getAabb(from, aabbMin, aabbMax);
+    shape->getAabb(to, toMin, toMax);
+    aabbMin.setMin(toMin);
+    aabbMax.setMax(toMax);
+
+    SweepAabbCallback callback(shape, from, to, resultCallback);
+    world->getBroadphase()->aabbTest(aabbMin, aabbMax, callback);
+}
+
+/// Tests the ray against each object whose bounds it passes through.
+/// @note btDbvtBroadphase::rayTest uses a stack stored in the broadphase, the static btDbvt::rayTest a local one.
+class RayTestCollider : public btDbvt::ICollide
+{
+public:
+    RayTestCollider(const btTransform& from, const btTransform& to, btCollisionWorld::RayResultCallback& resultCallback)
+        : mFrom(from), mTo(to), mResultCallback(resultCallback)
+    {
+    }
+
+    virtual void Process(const btDbvtNode* leaf)
+    {
+        const btBroadphaseProxy* proxy = static_cast<const btBroadphaseProxy*>(leaf->data);
+        const btCollisionObject* object = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+        if (mResultCallback.needsCollision(object->getBroadphaseHandle()))
+            btCollisionWorld::rayTestSingle(mFrom, mTo, object, object->getCollisionShape(),
+                                            object->getWorldTransform(), mResultCallback);
+    }
+
+private:
+    const btTransform& mFrom;
+    const btTransform& mTo;
+    btCollisionWorld::RayResultCallback& mResultCallback;
+};
+
+unsigned int takeNumSweeps()
+{
+    return sNumSweeps.exchange(0);
+}
+
+void rayTest(const btVector3& from, const btVector3& to, btCollisionWorld* world,
+             btCollisionWorld::RayResultCallback& resultCallback)
+{
+    btTransform fromTrans, toTrans;
+    fromTrans.setIdentity();
+    fromTrans.setOrigin(from);
+    toTrans.setIdentity();
+    toTrans.setOrigin(to);
+
+    RayTestCollider collider(fromTrans, toTrans, resultCallback);
+    btDbvtBroadphase* broadphase = static_cast<btDbvtBroadphase*>(world->getBroadphase());
+    // The dynamic and the static set
+    for (int i=0; i<2; ++i)
+        btDbvt::rayTest(broadphase->m_sets[i].m_root, from, to, collider);
+}
+
 
 void ActorTracer::doTrace(btCollisionObject *actor, const osg::Vec3f& start, const osg::Vec3f& end, btCollisionWorld* world)
 {
@@ -68,8 +164,7 @@ void ActorTracer::doTrace(btCollisionObject *actor, const osg::Vec3f& start, con
 
     btCollisionShape *shape = actor->getCollisionShape();
     assert(shape->isConvex());
-    world->convexSweepTest(static_cast<btConvexShape*>(shape),
-                                               from, to, newTraceCallback);
+    convexSweepTest(static_cast<btConvexShape*>(shape), from, to, world, newTraceCallback);
 
     // Copy the hit data over to our trace results struct:
     if(newTraceCallback.hasHit())
@@ -109,7 +204,7 @@ void ActorTracer::findGround(const Actor* actor, const osg::Vec3f& start, const
     halfExtents[2] = 1.0f;
     btCylinderShapeZ base(halfExtents);
 
-    world->convexSweepTest(&base, from, to, newTraceCallback);
+    convexSweepTest(&base, from, to, world, newTraceCallback);
     if(newTraceCallback.hasHit())
     {
         const btVector3& tracehitnormal = newTraceCallback.m_hitNormalWorld;
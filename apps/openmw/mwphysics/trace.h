@@ -3,14 +3,29 @@
 
 #include <osg/Vec3f>
 
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+
 class btCollisionObject;
-class btCollisionWorld;
+class btConvexShape;
 
 
 namespace MWPhysics
 {
     class Actor;
 
+    /// Like btCollisionWorld::convexSweepTest, but only reads the collision world, so it is safe to call from several
+    /// threads while the world is not changed. Only supports translating sweeps.
+    void convexSweepTest(const btConvexShape* shape, const btTransform& from, const btTransform& to,
+                         btCollisionWorld* world, btCollisionWorld::ConvexResultCallback& resultCallback);
+
+    /// The number of convexSweepTest() calls on all threads since the last call, for the viewer stats.
+    unsigned int takeNumSweeps();
+
+    /// Like btCollisionWorld::rayTest, but only reads the collision world, so it is safe to call from several threads
+    /// while the world is not changed. The world must use a btDbvtBroadphase.
+    void rayTest(const btVector3& from, const btVector3& to, btCollisionWorld* world,
+                 btCollisionWorld::RayResultCallback& resultCallback);
+
     struct ActorTracer
     {
         osg::Vec3f mEndPos;
@@ -6,6 +6,7 @@
 #include <osg/PositionAttitudeTransform>
 #include <osg/TexGen>
 #include <osg/TexEnvCombine>
+#include <osg/Uniform>
 #include <osg/ComputeBoundsVisitor>
 #include <osg/MatrixTransform>
 #include <osg/Geode>
@@ -69,6 +70,8 @@ namespace
             texGen->setMode(osg::TexGen::SPHERE_MAP);
 
             stateset->setTextureAttributeAndModes(mTexUnit, texGen, osg::StateAttribute::ON|osg::StateAttribute::OVERRIDE);
+            // The same for geometry skinned in the shader, see SceneUtil::RigGeometry
+            stateset->addUniform(new osg::Uniform("sphereMapTexUnit1", true), osg::StateAttribute::ON|osg::StateAttribute::OVERRIDE);
 
             osg::TexEnvCombine* texEnv = new osg::TexEnvCombine;
             texEnv->setSource0_RGB(osg::TexEnvCombine::CONSTANT);
@@ -316,10 +319,13 @@ namespace MWRender
         , mPtr(ptr)
         , mResourceSystem(resourceSystem)
         , mAccumulate(1.f, 1.f, 0.f)
+        , mEffectPool(resourceSystem, 2)
         , mTextKeyListener(NULL)
         , mHeadYawRadians(0.f)
         , mHeadPitchRadians(0.f)
         , mAlpha(1.f)
+        , mLodDistance(0.f)
+        , mLodMaxUpdateInterval(1)
     {
         for(size_t i = 0;i < sNumBlendMasks;i++)
             mAnimationTimePtr[i].reset(new AnimationTime);
@@ -344,6 +350,14 @@ namespace MWRender
             mSkeleton->setActive(active);
     }
 
+    void Animation::setLod(float distance, unsigned int maxUpdateInterval)
+    {
+        mLodDistance = distance;
+        mLodMaxUpdateInterval = maxUpdateInterval;
+        if (mSkeleton)
+            mSkeleton->setLod(distance, maxUpdateInterval);
+    }
+
     void Animation::updatePtr(const MWWorld::Ptr &ptr)
     {
         mPtr = ptr;
@@ -1005,6 +1019,7 @@ namespace MWRender
                 skel->addChild(created);
             }
             mSkeleton = skel.get();
+            mSkeleton->setLod(mLodDistance, mLodMaxUpdateInterval);
             mObjectRoot = skel;
             mInsert->addChild(mObjectRoot);
         }
@@ -1182,34 +1197,27 @@ namespace MWRender
 
             parentNode = found->second;
         }
-        osg::ref_ptr<osg::Node> node = mResourceSystem->getSceneManager()->createInstance(model, parentNode);
+        params.mTexture = texture;
+        params.mInstance = mEffectPool.acquire(model, texture);
+        osg::ref_ptr<osg::Node> node = params.mInstance.mNode;
 
-        node->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
-
-        params.mObjects = PartHolderPtr(new PartHolder(node));
-
-        SceneUtil::FindMaxControllerLengthVisitor findMaxLengthVisitor;
-        node->accept(findMaxLengthVisitor);
+        if (params.mInstance.mCreated)
+        {
+            node->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
 
-        // FreezeOnCull doesn't work so well with effect particles, that tend to have moving emitters
-        SceneUtil::DisableFreezeOnCullVisitor disableFreezeOnCullVisitor;
-        node->accept(disableFreezeOnCullVisitor);
+            // FreezeOnCull doesn't work so well with effect particles, that tend to have moving emitters
+            SceneUtil::DisableFreezeOnCullVisitor disableFreezeOnCullVisitor;
+            node->accept(disableFreezeOnCullVisitor);
+        }
 
-        params.mMaxControllerLength = findMaxLengthVisitor.getMaxLength();
+        mResourceSystem->getSceneManager()->attachTo(node, parentNode);
 
-        node->setNodeMask(Mask_Effect);
+        params.mObjects = PartHolderPtr(new PartHolder(node));
 
         params.mLoop = loop;
         params.mEffectId = effectId;
         params.mBoneName = bonename;
 
-        params.mAnimTime = boost::shared_ptr<EffectAnimationTime>(new EffectAnimationTime);
-
-        SceneUtil::AssignControllerSourcesVisitor assignVisitor(boost::shared_ptr<SceneUtil::ControllerSource>(params.mAnimTime));
-        node->accept(assignVisitor);
-
-        overrideTexture(texture, mResourceSystem, node);
-
         // TODO: in vanilla morrowind the effect is scaled based on the host object's bounding box.
 
         mEffects.push_back(params);
@@ -1221,6 +1229,7 @@ namespace MWRender
         {
             if (it->mEffectId == effectId)
             {
+                releaseEffect(*it);
                 mEffects.erase(it);
                 return;
             }
@@ -1240,19 +1249,21 @@ namespace MWRender
     {
         for (std::vector<EffectParams>::iterator it = mEffects.begin(); it != mEffects.end(); )
         {
-            it->mAnimTime->addTime(duration);
+            EffectPool::Instance& instance = it->mInstance;
+            instance.mAnimTime->addTime(duration);
 
-            if (it->mAnimTime->getTime() >= it->mMaxControllerLength)
+            if (instance.mAnimTime->getTime() >= instance.mMaxControllerLength)
             {
                 if (it->mLoop)
                 {
                     // Start from the beginning again; carry over the remainder
                     // Not sure if this is actually needed, the controller function might already handle loops
-                    float remainder = it->mAnimTime->getTime() - it->mMaxControllerLength;
-                    it->mAnimTime->resetTime(remainder);
+                    float remainder = instance.mAnimTime->getTime() - instance.mMaxControllerLength;
+                    instance.mAnimTime->resetTime(remainder);
                 }
                 else
                 {
+                    releaseEffect(*it);
                     it = mEffects.erase(it);
                     continue;
                 }
@@ -1261,6 +1272,13 @@ namespace MWRender
         }
     }
 
+    void Animation::releaseEffect(EffectParams &effect)
+    {
+        // Detaches the node, unless the effect is still shared
+        effect.mObjects.reset();
+        mEffectPool.release(effect.mModelName, effect.mTexture, effect.mInstance);
+    }
+
     bool Animation::upperBodyReady() const
     {
         for (AnimStateMap::const_iterator stateiter = mStates.begin(); stateiter != mStates.end(); ++stateiter)
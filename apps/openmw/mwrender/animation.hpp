@@ -5,6 +5,8 @@
 
 #include <components/sceneutil/controller.hpp>
 
+#include "effectpool.hpp"
+
 namespace ESM
 {
     struct Light;
@@ -240,9 +242,9 @@ protected:
     struct EffectParams
     {
         std::string mModelName; // Just here so we don't add the same effect twice
+        std::string mTexture;
         PartHolderPtr mObjects;
-        boost::shared_ptr<EffectAnimationTime> mAnimTime;
-        float mMaxControllerLength;
+        EffectPool::Instance mInstance;
         int mEffectId;
         bool mLoop;
         std::string mBoneName;
@@ -250,6 +252,12 @@ protected:
 
     std::vector<EffectParams> mEffects;
 
+    // Finished effects, for reuse by the next effect with the same model
+    EffectPool mEffectPool;
+
+    /// Detach the effect, and keep its instance in the pool.
+    void releaseEffect(EffectParams& effect);
+
     TextKeyListener* mTextKeyListener;
 
     osg::ref_ptr<RotateController> mHeadController;
@@ -260,6 +268,10 @@ protected:
 
     float mAlpha;
 
+    // Applied to each skeleton created by setObjectRoot
+    float mLodDistance;
+    unsigned int mLodMaxUpdateInterval;
+
     /* Sets the appropriate animations on the bone groups based on priority.
      */
     void resetActiveGroups();
@@ -326,6 +338,10 @@ public:
     /// @see SceneUtil::Skeleton::setActive
     void setActive(bool active);
 
+    /// Set the animation level of detail of the object skeleton, including skeletons created later on.
+    /// @see SceneUtil::Skeleton::setLod
+    void setLod(float distance, unsigned int maxUpdateInterval);
+
     osg::Group* getOrCreateObjectRoot();
 
     osg::Group* getObjectRoot();
@@ -191,10 +191,15 @@ namespace MWRender
 
     void InventoryPreview::setViewport(int sizeX, int sizeY)
     {
-        sizeX = std::max(sizeX, 0);
-        sizeY = std::max(sizeY, 0);
+        sizeX = std::min(mSizeX, std::max(sizeX, 0));
+        sizeY = std::min(mSizeY, std::max(sizeY, 0));
 
-        mCamera->setViewport(0, 0, std::min(mSizeX, sizeX), std::min(mSizeY, sizeY));
+        // Resizing the window past the texture size does not change the preview
+        const osg::Viewport* viewport = mCamera->getViewport();
+        if (viewport && viewport->width() == sizeX && viewport->height() == sizeY)
+            return;
+
+        mCamera->setViewport(0, 0, sizeX, sizeY);
 
         redraw();
     }
@@ -204,10 +209,23 @@ namespace MWRender
         if (!mAnimation.get())
             return;
 
+        MWWorld::InventoryStore &inv = mCharacter.getClass().getInventoryStore(mCharacter);
+
+        // Most inventory changes do not touch the equipment, those leave the preview as it is
+        std::vector<std::string> equipment (MWWorld::InventoryStore::Slots);
+        for (int slot = 0; slot < MWWorld::InventoryStore::Slots; ++slot)
+        {
+            MWWorld::ContainerStoreIterator equipped = inv.getSlot(slot);
+            if (equipped != inv.end())
+                equipment[slot] = equipped->getCellRef().getRefId();
+        }
+        if (equipment == mEquipment)
+            return;
+        mEquipment.swap(equipment);
+
         mAnimation->showWeapons(true);
         mAnimation->updateParts();
 
-        MWWorld::InventoryStore &inv = mCharacter.getClass().getInventoryStore(mCharacter);
         MWWorld::ContainerStoreIterator iter = inv.getSlot(MWWorld::InventoryStore::Slot_CarriedRight);
         std::string groupname;
         bool showCarriedLeft = true;
@@ -309,6 +327,9 @@ namespace MWRender
         mNode->setScale(scale);
 
         mCamera->setViewMatrixAsLookAt(mPosition * scale.z(), mLookAt * scale.z(), osg::Vec3f(0,0,1));
+
+        // The new animation shows no equipment yet
+        mEquipment.clear();
     }
 
     // --------------------------------------------------------------------------------------------------
@@ -3,6 +3,8 @@
 
 #include <osg/ref_ptr>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <osg/PositionAttitudeTransform>
 
@@ -80,13 +82,17 @@ namespace MWRender
 
         void updatePtr(const MWWorld::Ptr& ptr);
 
-        void update(); // Render preview again, e.g. after changed equipment
+        void update(); // Render preview again, e.g. after changed equipment. Does nothing if the equipment is unchanged.
         void setViewport(int sizeX, int sizeY);
 
         int getSlotSelected(int posX, int posY);
 
     protected:
         virtual void onSetup();
+
+    private:
+        /// The IDs of the items in each equipment slot at the last update, empty before the first update of an animation
+        std::vector<std::string> mEquipment;
     };
 
     class UpdateCameraCallback;
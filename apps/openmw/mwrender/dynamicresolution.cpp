@@ -0,0 +1,225 @@
+#include "dynamicresolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <osg/Camera>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Texture2D>
+#include <osg/Depth>
+#include <osg/Stats>
+
+#include <osgViewer/Viewer>
+
+#include <components/settings/settings.hpp>
+
+#include "vismask.hpp"
+#include "renderbin.hpp"
+
+namespace
+{
+    // The scale is adjusted at most once in this many frames, from the GPU draw time of the second half of them.
+    // The timer queries are read back a few frames late, so the first half may still be drawn at the old scale.
+    const unsigned int sAdjustInterval = 20;
+
+    // The largest change of the scale in one adjustment
+    const float sMaxStep = 0.1f;
+
+    // The scale is only raised when the frames take less than this part of the target time, so that it does not
+    // keep going up and down around the target.
+    const float sRaiseThreshold = 0.8f;
+}
+
+namespace MWRender
+{
+
+    DynamicResolution::DynamicResolution(osgViewer::Viewer *viewer, osg::Group *rootNode, osg::Group *sceneRoot)
+        : mViewer(viewer)
+        , mRootNode(rootNode)
+        , mSceneRoot(sceneRoot)
+        , mWidth(0)
+        , mHeight(0)
+        , mScale(1.f)
+        , mSamples(std::max(0, Settings::Manager::getInt("antialiasing", "Video")))
+        , mMinScale(std::min(1.f, std::max(0.1f, Settings::Manager::getFloat("minimum resolution scale", "Video"))))
+        , mTargetTime(std::max(1.f, Settings::Manager::getFloat("dynamic resolution target", "Video")))
+        , mLastAdjustFrame(0)
+    {
+        mUpscaleCamera = new osg::Camera;
+        mUpscaleCamera->setNodeMask(Mask_RenderToTexture);
+        mUpscaleCamera->setReferenceFrame(osg::Camera::ABSOLUTE_RF);
+        mUpscaleCamera->setRenderOrder(osg::Camera::NESTED_RENDER);
+        mUpscaleCamera->setProjectionMatrix(osg::Matrix::identity());
+        mUpscaleCamera->setViewMatrix(osg::Matrix::identity());
+        mUpscaleCamera->setClearMask(0);
+
+        osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry);
+        osg::ref_ptr<osg::Vec3Array> vertices (new osg::Vec3Array);
+        vertices->push_back(osg::Vec3f(-1.f, -1.f, 0.f));
+        vertices->push_back(osg::Vec3f(1.f, -1.f, 0.f));
+        vertices->push_back(osg::Vec3f(1.f, 1.f, 0.f));
+        vertices->push_back(osg::Vec3f(-1.f, 1.f, 0.f));
+        geometry->setVertexArray(vertices);
+
+        mTexCoords = new osg::Vec2Array(4);
+        geometry->setTexCoordArray(0, mTexCoords, osg::Array::BIND_PER_VERTEX);
+
+        osg::ref_ptr<osg::Vec4Array> colors (new osg::Vec4Array);
+        colors->push_back(osg::Vec4f(1.f, 1.f, 1.f, 1.f));
+        geometry->setColorArray(colors, osg::Array::BIND_OVERALL);
+
+        geometry->addPrimitiveSet(new osg::DrawArrays(GL_QUADS, 0, 4));
+        // The texture coordinates change with the scale, while the previous frame may still be drawing
+        geometry->setDataVariance(osg::Object::DYNAMIC);
+        geometry->setUseDisplayList(false);
+        geometry->setCullingActive(false);
+
+        osg::ref_ptr<osg::Geode> geode (new osg::Geode);
+        geode->addDrawable(geometry);
+        mUpscaleCamera->addChild(geode);
+
+        osg::StateSet* stateset = mUpscaleCamera->getOrCreateStateSet();
+        // The texture is replaced when the window is resized
+        stateset->setDataVariance(osg::Object::DYNAMIC);
+        stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF|osg::StateAttribute::OVERRIDE);
+        stateset->setMode(GL_FOG, osg::StateAttribute::OFF|osg::StateAttribute::OVERRIDE);
+        stateset->setMode(GL_CULL_FACE, osg::StateAttribute::OFF);
+        stateset->setMode(GL_BLEND, osg::StateAttribute::OFF);
+        stateset->setAttributeAndModes(new osg::Depth(osg::Depth::ALWAYS, 0.0, 1.0, false), osg::StateAttribute::ON);
+        // Drawn before anything else of the main camera, e.g. the debug geometry of the pathgrid
+        stateset->setRenderBinDetails(RenderBin_Upscale, "RenderBin");
+
+        mRootNode->addChild(mUpscaleCamera);
+
+        mRootNode->removeChild(mSceneRoot);
+
+        const osg::Viewport* viewport = mViewer->getCamera()->getViewport();
+        createSceneCamera(static_cast<int>(viewport->width()), static_cast<int>(viewport->height()));
+
+        // Enables the timer queries around the draw of the main camera
+        if (osg::Stats* stats = mViewer->getCamera()->getStats())
+            stats->collectStats("gpu", true);
+    }
+
+    DynamicResolution::~DynamicResolution()
+    {
+        if (mSceneCamera)
+        {
+            mSceneCamera->removeChild(mSceneRoot);
+            mRootNode->removeChild(mSceneCamera);
+        }
+        mRootNode->removeChild(mUpscaleCamera);
+        mRootNode->addChild(mSceneRoot);
+    }
+
+    void DynamicResolution::createSceneCamera(int width, int height)
+    {
+        width = std::max(1, width);
+        height = std::max(1, height);
+
+        // A camera that is being drawn can not be given new attachments, so a resize replaces it
+        if (mSceneCamera)
+        {
+            mSceneCamera->removeChild(mSceneRoot);
+            mRootNode->removeChild(mSceneCamera);
+        }
+
+        mWidth = width;
+        mHeight = height;
+
+        osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D);
+        texture->setInternalFormat(GL_RGB);
+        texture->setTextureSize(width, height);
+        texture->setResizeNonPowerOfTwoHint(false);
+        texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+        texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+
+        mSceneCamera = new osg::Camera;
+        mSceneCamera->setName("Scene Camera");
+        mSceneCamera->setNodeMask(Mask_RenderToTexture);
+        // Uses the view and projection of the main camera
+        mSceneCamera->setReferenceFrame(osg::Camera::RELATIVE_RF);
+        mSceneCamera->setProjectionMatrix(osg::Matrix::identity());
+        mSceneCamera->setViewMatrix(osg::Matrix::identity());
+        // After the other render to texture cameras, the scene uses the water reflection of this frame
+        mSceneCamera->setRenderOrder(osg::Camera::PRE_RENDER, 1);
+        mSceneCamera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT, osg::Camera::PIXEL_BUFFER_RTT);
+        mSceneCamera->attach(osg::Camera::COLOR_BUFFER, texture, 0, 0, false, mSamples, 0);
+        mSceneCamera->attach(osg::Camera::DEPTH_BUFFER, GL_DEPTH_COMPONENT24);
+        mSceneCamera->setClearMask(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+        mSceneCamera->setCullSettings(*mViewer->getCamera());
+        mSceneCamera->setClearColor(mViewer->getCamera()->getClearColor());
+        mSceneCamera->addChild(mSceneRoot);
+
+        mRootNode->addChild(mSceneCamera);
+
+        mUpscaleCamera->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
+
+        updateViewport();
+    }
+
+    void DynamicResolution::updateViewport()
+    {
+        int width = std::max(1, static_cast<int>(mWidth * mScale));
+        int height = std::max(1, static_cast<int>(mHeight * mScale));
+
+        // A new Viewport, the one of the previous frame may still be in use by the draw
+        mSceneCamera->setViewport(new osg::Viewport(0, 0, width, height));
+
+        float s = width / static_cast<float>(mWidth);
+        float t = height / static_cast<float>(mHeight);
+        (*mTexCoords)[0] = osg::Vec2f(0.f, 0.f);
+        (*mTexCoords)[1] = osg::Vec2f(s, 0.f);
+        (*mTexCoords)[2] = osg::Vec2f(s, t);
+        (*mTexCoords)[3] = osg::Vec2f(0.f, t);
+        mTexCoords->dirty();
+    }
+
+    void DynamicResolution::update()
+    {
+        osg::Camera* camera = mViewer->getCamera();
+
+        const osg::Viewport* viewport = camera->getViewport();
+        if (static_cast<int>(viewport->width()) != mWidth || static_cast<int>(viewport->height()) != mHeight)
+            createSceneCamera(static_cast<int>(viewport->width()), static_cast<int>(viewport->height()));
+
+        // The cull mask is changed by the render mode toggles, the clear color by the fog
+        mSceneCamera->setCullSettings(*camera);
+        mSceneCamera->setClearColor(camera->getClearColor());
+
+        const osg::Stats* stats = camera->getStats();
+        unsigned int frameNumber = mViewer->getFrameStamp()->getFrameNumber();
+        if (!stats || frameNumber < mLastAdjustFrame + sAdjustInterval)
+            return;
+
+        double gpuTime = 0.0;
+        if (!stats->getAveragedAttribute(frameNumber - sAdjustInterval/2, frameNumber - 1, "GPU draw time taken", gpuTime)
+                || gpuTime <= 0.0)
+            return;
+
+        mLastAdjustFrame = frameNumber;
+
+        float time = static_cast<float>(gpuTime * 1000.0);
+        if (time < mTargetTime && time > mTargetTime * sRaiseThreshold)
+            return;
+
+        // The GPU time mostly grows with the number of pixels, i.e. the square of the scale
+        float scale = mScale * std::sqrt(mTargetTime / time);
+        scale = std::max(mScale - sMaxStep, std::min(mScale + sMaxStep, scale));
+        scale = std::max(mMinScale, std::min(1.f, scale));
+        if (scale == mScale)
+            return;
+
+        mScale = scale;
+        updateViewport();
+    }
+
+    float DynamicResolution::getScale() const
+    {
+        return mScale;
+    }
+
+}
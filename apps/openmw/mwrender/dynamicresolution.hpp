@@ -0,0 +1,67 @@
+#ifndef OPENMW_MWRENDER_DYNAMICRESOLUTION_H
+#define OPENMW_MWRENDER_DYNAMICRESOLUTION_H
+
+#include <osg/ref_ptr>
+
+namespace osg
+{
+    class Group;
+    class Camera;
+    class Texture2D;
+    class Vec2Array;
+}
+
+namespace osgViewer
+{
+    class Viewer;
+}
+
+namespace MWRender
+{
+
+    /// @brief Renders the scene to a texture of a lower resolution than the window when the GPU takes longer than a
+    /// target time to draw a frame, and stretches the texture over the window before the GUI is drawn on top.
+    /// @par The scale of the resolution follows the GPU draw time of recent frames, as measured by the timer queries of
+    /// osgViewer. The render to texture cameras outside of the scene root, e.g. for the water and the local map, keep
+    /// their own sizes.
+    class DynamicResolution
+    {
+    public:
+        /// Moves \a sceneRoot from \a rootNode to a camera rendering to the scene texture.
+        DynamicResolution(osgViewer::Viewer* viewer, osg::Group* rootNode, osg::Group* sceneRoot);
+        ~DynamicResolution();
+
+        /// Follow the settings of the main camera and the window size, and adjust the scale to the GPU draw time
+        /// of the last frames. Call once per frame, before the rendering traversals.
+        void update();
+
+        /// The ratio of the scene resolution to the window resolution, in each direction.
+        float getScale() const;
+
+    private:
+        void createSceneCamera(int width, int height);
+
+        void updateViewport();
+
+        osg::ref_ptr<osgViewer::Viewer> mViewer;
+        osg::ref_ptr<osg::Group> mRootNode;
+        osg::ref_ptr<osg::Group> mSceneRoot;
+
+        osg::ref_ptr<osg::Camera> mSceneCamera;
+        osg::ref_ptr<osg::Camera> mUpscaleCamera;
+        osg::ref_ptr<osg::Vec2Array> mTexCoords;
+
+        int mWidth;
+        int mHeight;
+        float mScale;
+        int mSamples;
+
+        float mMinScale;
+        float mTargetTime; // milliseconds
+
+        unsigned int mLastAdjustFrame;
+    };
+
+}
+
+#endif
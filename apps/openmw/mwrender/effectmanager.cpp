@@ -5,11 +5,7 @@
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/scenemanager.hpp>
 
-#include <components/sceneutil/controller.hpp>
-
 #include "animation.hpp"
-#include "vismask.hpp"
-#include "util.hpp"
 
 namespace MWRender
 {
@@ -17,6 +13,7 @@ namespace MWRender
 EffectManager::EffectManager(osg::ref_ptr<osg::Group> parent, Resource::ResourceSystem* resourceSystem)
     : mParentNode(parent)
     , mResourceSystem(resourceSystem)
+    , mPool(resourceSystem, 8)
 {
 }
 
@@ -27,29 +24,18 @@ EffectManager::~EffectManager()
 
 void EffectManager::addEffect(const std::string &model, const std::string& textureOverride, const osg::Vec3f &worldPosition, float scale)
 {
-    osg::ref_ptr<osg::Node> node = mResourceSystem->getSceneManager()->createInstance(model);
-
-    node->setNodeMask(Mask_Effect);
-
     Effect effect;
-    effect.mAnimTime.reset(new EffectAnimationTime);
-
-    SceneUtil::FindMaxControllerLengthVisitor findMaxLengthVisitor;
-    node->accept(findMaxLengthVisitor);
-    effect.mMaxControllerLength = findMaxLengthVisitor.getMaxLength();
+    effect.mModel = model;
+    effect.mTextureOverride = textureOverride;
+    effect.mInstance = mPool.acquire(model, textureOverride);
 
     osg::ref_ptr<osg::PositionAttitudeTransform> trans = new osg::PositionAttitudeTransform;
     trans->setPosition(worldPosition);
     trans->setScale(osg::Vec3f(scale, scale, scale));
-    trans->addChild(node);
-
-    SceneUtil::AssignControllerSourcesVisitor assignVisitor(effect.mAnimTime);
-    node->accept(assignVisitor);
-
-    overrideTexture(textureOverride, mResourceSystem, node);
+    trans->addChild(effect.mInstance.mNode);
 
     mParentNode->addChild(trans);
-    mResourceSystem->getSceneManager()->notifyAttached(node);
+    mResourceSystem->getSceneManager()->notifyAttached(effect.mInstance.mNode);
 
     mEffects[trans] = effect;
 }
@@ -58,11 +44,14 @@ void EffectManager::update(float dt)
 {
     for (EffectMap::iterator it = mEffects.begin(); it != mEffects.end(); )
     {
-        it->second.mAnimTime->addTime(dt);
+        EffectPool::Instance& instance = it->second.mInstance;
+        instance.mAnimTime->addTime(dt);
 
-        if (it->second.mAnimTime->getTime() >= it->second.mMaxControllerLength)
+        if (instance.mAnimTime->getTime() >= instance.mMaxControllerLength)
         {
             mParentNode->removeChild(it->first);
+            it->first->removeChild(instance.mNode);
+            mPool.release(it->second.mModel, it->second.mTextureOverride, instance);
             mEffects.erase(it++);
         }
         else
@@ -77,6 +66,7 @@ void EffectManager::clear()
         mParentNode->removeChild(it->first);
     }
     mEffects.clear();
+    mPool.clear();
 }
 
 }
@@ -6,7 +6,7 @@
 
 #include <osg/ref_ptr>
 
-#include <boost/shared_ptr.hpp>
+#include "effectpool.hpp"
 
 namespace osg
 {
@@ -22,8 +22,6 @@ namespace Resource
 
 namespace MWRender
 {
-    class EffectAnimationTime;
-
     // Note: effects attached to another object should be managed by MWRender::Animation::addEffect.
     // This class manages "free" effects, i.e. attached to a dedicated scene node in the world.
     class EffectManager
@@ -43,8 +41,9 @@ namespace MWRender
     private:
         struct Effect
         {
-            float mMaxControllerLength;
-            boost::shared_ptr<EffectAnimationTime> mAnimTime;
+            std::string mModel;
+            std::string mTextureOverride;
+            EffectPool::Instance mInstance;
         };
 
         typedef std::map<osg::ref_ptr<osg::PositionAttitudeTransform>, Effect> EffectMap;
@@ -53,6 +52,9 @@ namespace MWRender
         osg::ref_ptr<osg::Group> mParentNode;
         Resource::ResourceSystem* mResourceSystem;
 
+        // Finished effects, for reuse by the next effect with the same model
+        EffectPool mPool;
+
         EffectManager(const EffectManager&);
         void operator=(const EffectManager&);
     };
@@ -0,0 +1,159 @@
+#include "effectpool.hpp"
+
+#include <osg/Geode>
+#include <osg/Version>
+
+#include <osgParticle/ParticleSystem>
+
+#include <components/nifosg/particle.hpp>
+
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
+
+#include <components/sceneutil/controller.hpp>
+
+#include "animation.hpp"
+#include "vismask.hpp"
+#include "util.hpp"
+
+namespace
+{
+
+    /// Finds the particle systems and emitters of an effect, to tell if it can be reused, and to reset it.
+    class FindParticlesVisitor : public osg::NodeVisitor
+    {
+    public:
+        FindParticlesVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+        {
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            if (NifOsg::Emitter* emitter = dynamic_cast<NifOsg::Emitter*>(&node))
+                mEmitters.push_back(emitter);
+            traverse(node);
+        }
+
+        virtual void apply(osg::Geode& geode)
+        {
+            for (unsigned int i=0; i<geode.getNumDrawables(); ++i)
+            {
+                if (osgParticle::ParticleSystem* partsys = dynamic_cast<osgParticle::ParticleSystem*>(geode.getDrawable(i)))
+                    mParticleSystems.push_back(partsys);
+            }
+        }
+
+#if OSG_VERSION_GREATER_OR_EQUAL(3,3,3)
+        // in OSG 3.3 and up Drawables can be directly in the scene graph without a Geode decorating them.
+        virtual void apply(osg::Drawable& drawable)
+        {
+            if (osgParticle::ParticleSystem* partsys = dynamic_cast<osgParticle::ParticleSystem*>(&drawable))
+                mParticleSystems.push_back(partsys);
+        }
+#endif
+
+        bool hasParticles() const
+        {
+            for (std::vector<osgParticle::ParticleSystem*>::const_iterator it = mParticleSystems.begin(); it != mParticleSystems.end(); ++it)
+            {
+                if ((*it)->numParticles() > (*it)->numDeadParticles())
+                    return true;
+            }
+            return false;
+        }
+
+        void reset()
+        {
+            for (std::vector<osgParticle::ParticleSystem*>::iterator it = mParticleSystems.begin(); it != mParticleSystems.end(); ++it)
+            {
+                for (int i=0; i<(*it)->numParticles(); ++i)
+                {
+                    if ((*it)->getParticle(i)->isAlive())
+                        (*it)->destroyParticle(i);
+                }
+            }
+            for (std::vector<NifOsg::Emitter*>::iterator it = mEmitters.begin(); it != mEmitters.end(); ++it)
+                (*it)->skipNextEmission();
+        }
+
+    private:
+        std::vector<osgParticle::ParticleSystem*> mParticleSystems;
+        std::vector<NifOsg::Emitter*> mEmitters;
+    };
+
+}
+
+namespace MWRender
+{
+
+EffectPool::Instance::Instance()
+    : mMaxControllerLength(0.f)
+    , mCreated(false)
+    , mReusable(false)
+{
+}
+
+EffectPool::EffectPool(Resource::ResourceSystem *resourceSystem, unsigned int maxPerEffect)
+    : mResourceSystem(resourceSystem)
+    , mMaxPerEffect(maxPerEffect)
+{
+}
+
+EffectPool::Instance EffectPool::acquire(const std::string &model, const std::string &texture)
+{
+    InstanceMap::iterator found = mInstances.find(std::make_pair(model, texture));
+    if (found != mInstances.end() && !found->second.empty())
+    {
+        Instance instance = found->second.back();
+        found->second.pop_back();
+        instance.mCreated = false;
+        return instance;
+    }
+
+    Instance instance;
+    instance.mCreated = true;
+    instance.mNode = mResourceSystem->getSceneManager()->createInstance(model);
+    instance.mNode->setNodeMask(Mask_Effect);
+
+    SceneUtil::FindMaxControllerLengthVisitor findMaxLengthVisitor;
+    instance.mNode->accept(findMaxLengthVisitor);
+    instance.mMaxControllerLength = findMaxLengthVisitor.getMaxLength();
+
+    instance.mAnimTime.reset(new EffectAnimationTime);
+    SceneUtil::AssignControllerSourcesVisitor assignVisitor(boost::shared_ptr<SceneUtil::ControllerSource>(instance.mAnimTime));
+    instance.mNode->accept(assignVisitor);
+
+    overrideTexture(texture, mResourceSystem, instance.mNode);
+
+    FindParticlesVisitor findParticlesVisitor;
+    instance.mNode->accept(findParticlesVisitor);
+    instance.mReusable = !findParticlesVisitor.hasParticles();
+
+    return instance;
+}
+
+void EffectPool::release(const std::string &model, const std::string &texture, const Instance &instance)
+{
+    if (!instance.mReusable || instance.mNode->getNumParents())
+        return;
+
+    std::vector<Instance>& instances = mInstances[std::make_pair(model, texture)];
+    if (instances.size() >= mMaxPerEffect)
+        return;
+
+    FindParticlesVisitor findParticlesVisitor;
+    instance.mNode->accept(findParticlesVisitor);
+    findParticlesVisitor.reset();
+
+    instance.mAnimTime->resetTime(0.f);
+
+    instances.push_back(instance);
+}
+
+void EffectPool::clear()
+{
+    mInstances.clear();
+}
+
+}
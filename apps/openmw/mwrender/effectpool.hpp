@@ -0,0 +1,71 @@
+#ifndef OPENMW_MWRENDER_EFFECTPOOL_H
+#define OPENMW_MWRENDER_EFFECTPOOL_H
+
+#include <string>
+#include <map>
+#include <vector>
+
+#include <osg/ref_ptr>
+
+#include <boost/shared_ptr.hpp>
+
+namespace osg
+{
+    class Node;
+}
+
+namespace Resource
+{
+    class ResourceSystem;
+}
+
+namespace MWRender
+{
+    class EffectAnimationTime;
+
+    /// @brief Keeps the instances of finished effects, so that the next effect with the same model and texture reuses
+    /// one instead of cloning the scene template again.
+    /// @par A released instance is reset to its start: its EffectAnimationTime, which all of its controllers use as
+    /// their source, goes back to 0, and its particles are removed. Instances of models that start with particles are
+    /// not kept, since those particles can not be restored.
+    class EffectPool
+    {
+    public:
+        struct Instance
+        {
+            Instance();
+
+            osg::ref_ptr<osg::Node> mNode;
+            boost::shared_ptr<EffectAnimationTime> mAnimTime;
+            float mMaxControllerLength;
+
+            /// Is this a new instance, rather than a reused one?
+            bool mCreated;
+
+            bool mReusable;
+        };
+
+        /// @param maxPerEffect How many unused instances of the same model and texture to keep.
+        EffectPool(Resource::ResourceSystem* resourceSystem, unsigned int maxPerEffect);
+
+        /// Get an instance of the effect, with the node mask, texture override and controller sources set up.
+        /// @note The caller attaches the node, and then calls SceneManager::notifyAttached for it.
+        Instance acquire(const std::string& model, const std::string& texture);
+
+        /// Keep an instance from acquire() that was detached from the scene, to reuse it.
+        void release(const std::string& model, const std::string& texture, const Instance& instance);
+
+        /// Drop all kept instances.
+        void clear();
+
+    private:
+        Resource::ResourceSystem* mResourceSystem;
+        unsigned int mMaxPerEffect;
+
+        typedef std::map<std::pair<std::string, std::string>, std::vector<Instance> > InstanceMap;
+        InstanceMap mInstances;
+    };
+
+}
+
+#endif
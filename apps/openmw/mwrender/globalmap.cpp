@@ -1,6 +1,14 @@
 #include "globalmap.hpp"
 
 #include <climits>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <osg/Image>
 #include <osg/Texture2D>
@@ -16,6 +24,7 @@
 #include <components/files/memorystream.hpp>
 
 #include <components/esm/globalmap.hpp>
+#include <components/sceneutil/workqueue.hpp>
 
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
@@ -59,6 +68,113 @@ namespace
     }
 
 
+    /// The colour of each height value of ESM::Land::LandData::mWnam on the global map.
+    class BaseMapColors : public osg::Referenced
+    {
+    public:
+        BaseMapColors()
+        {
+            for (int height = SCHAR_MIN; height <= SCHAR_MAX; ++height)
+            {
+                unsigned char* rgb = mColors + (height - SCHAR_MIN) * 3;
+
+                float y = (height << 4) / 2048.f;
+                if (y < 0)
+                {
+                    rgb[0] = static_cast<unsigned char>(14 * y + 38);
+                    rgb[1] = static_cast<unsigned char>(20 * y + 56);
+                    rgb[2] = static_cast<unsigned char>(18 * y + 51);
+                }
+                else if (y < 0.3f)
+                {
+                    if (y < 0.1f)
+                        y *= 8.f;
+                    else
+                    {
+                        y -= 0.1f;
+                        y += 0.8f;
+                    }
+                    rgb[0] = static_cast<unsigned char>(66 - 32 * y);
+                    rgb[1] = static_cast<unsigned char>(48 - 23 * y);
+                    rgb[2] = static_cast<unsigned char>(33 - 16 * y);
+                }
+                else
+                {
+                    y -= 0.3f;
+                    y *= 1.428f;
+                    rgb[0] = static_cast<unsigned char>(34 - 29 * y);
+                    rgb[1] = static_cast<unsigned char>(25 - 20 * y);
+                    rgb[2] = static_cast<unsigned char>(17 - 12 * y);
+                }
+            }
+        }
+
+        const unsigned char* get(signed char height) const
+        {
+            return mColors + (height - SCHAR_MIN) * 3;
+        }
+
+    private:
+        unsigned char mColors[256 * 3];
+    };
+
+    /// Fills the rows of the global map image that show the given rows of cells.
+    class FillBaseMapItem : public SceneUtil::WorkItem
+    {
+    public:
+        /// @param heights The mWnam of each cell, by cell column and then row.
+        FillBaseMapItem(osg::Image* image, const std::vector<signed char>& heights, const BaseMapColors* colors, int cellSize,
+                        int cellsX, int cellsY, int beginY, int endY)
+            : mImage(image), mHeights(heights), mColors(colors), mCellSize(cellSize)
+            , mCellsX(cellsX), mCellsY(cellsY), mBeginY(beginY), mEndY(endY)
+        {
+        }
+
+        virtual void doWork()
+        {
+            unsigned char* data = mImage->data();
+            const int width = mCellsX * mCellSize;
+
+            // The row and column of the 9x9 height samples of each texel within a cell
+            std::vector<int> vertex(mCellSize);
+            for (int i=0; i<mCellSize; ++i)
+                vertex[i] = static_cast<int>(float(i) / float(mCellSize) * 9);
+
+            for (int y = mBeginY; y < mEndY; ++y)
+            {
+                for (int cellY=0; cellY<mCellSize; ++cellY)
+                {
+                    unsigned char* row = data + (y * mCellSize + cellY) * width * 3;
+                    for (int x = 0; x < mCellsX; ++x)
+                    {
+                        const signed char* heights = &mHeights[(x * mCellsY + y) * 81 + vertex[cellY] * 9];
+                        unsigned char* texel = row + x * mCellSize * 3;
+                        for (int cellX=0; cellX<mCellSize; ++cellX)
+                        {
+                            const unsigned char* rgb = mColors->get(heights[vertex[cellX]]);
+                            texel[0] = rgb[0];
+                            texel[1] = rgb[1];
+                            texel[2] = rgb[2];
+                            texel += 3;
+                        }
+                    }
+                }
+            }
+
+            mTicket->signalDone();
+        }
+
+    private:
+        osg::ref_ptr<osg::Image> mImage;
+        const std::vector<signed char>& mHeights;
+        osg::ref_ptr<const BaseMapColors> mColors;
+        int mCellSize;
+        int mCellsX;
+        int mCellsY;
+        int mBeginY;
+        int mEndY;
+    };
+
     class CameraUpdateGlobalCallback : public osg::NodeCallback
     {
     public:
@@ -95,8 +211,9 @@ namespace
 namespace MWRender
 {
 
-    GlobalMap::GlobalMap(osg::Group* root)
-        : mRoot(root)
+    GlobalMap::GlobalMap(osg::Group* root, const std::string& cachePath)
+        : mCachePath(cachePath)
+        , mRoot(root)
         , mWidth(0)
         , mHeight(0)
         , mMinX(0), mMaxX(0)
@@ -132,15 +249,44 @@ namespace MWRender
         mWidth = mCellSize*(mMaxX-mMinX+1);
         mHeight = mCellSize*(mMaxY-mMinY+1);
 
+        std::string cacheFile, contentDescription;
+        getCacheFile(cacheFile, contentDescription);
+
+        osg::ref_ptr<osg::Image> image;
+        if (!cacheFile.empty())
+            image = readCachedBaseMap(cacheFile, contentDescription);
+        if (!image)
+        {
+            image = createBaseMap(loadingListener);
+            if (!cacheFile.empty())
+                writeCachedBaseMap(cacheFile, contentDescription, *image);
+        }
+
+        mBaseTexture = new osg::Texture2D;
+        mBaseTexture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        mBaseTexture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+        mBaseTexture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+        mBaseTexture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        mBaseTexture->setImage(image);
+        mBaseTexture->setResizeNonPowerOfTwoHint(false);
+
+        clear();
+    }
+
+    osg::ref_ptr<osg::Image> GlobalMap::createBaseMap(Loading::Listener* loadingListener)
+    {
+        const MWWorld::ESMStore &esmStore =
+            MWBase::Environment::get().getWorld()->getStore();
+
         loadingListener->loadingOn();
         loadingListener->setLabel("Creating map");
         loadingListener->setProgressRange((mMaxX-mMinX+1) * (mMaxY-mMinY+1));
         loadingListener->setProgress(0);
 
-        osg::ref_ptr<osg::Image> image = new osg::Image;
-        image->allocateImage(mWidth, mHeight, 1, GL_RGB, GL_UNSIGNED_BYTE);
-        unsigned char* data = image->data();
-
+        // The land has to be read one cell after another, the image is then filled in parallel
+        const int cellsX = mMaxX-mMinX+1;
+        const int cellsY = mMaxY-mMinY+1;
+        std::vector<signed char> heights (cellsX * cellsY * 81, SCHAR_MIN);
         for (int x = mMinX; x <= mMaxX; ++x)
         {
             for (int y = mMinY; y <= mMaxY; ++y)
@@ -152,78 +298,104 @@ namespace MWRender
                     int mask = ESM::Land::DATA_WNAM;
                     if (!land->isDataLoaded(mask))
                         land->loadData(mask);
+
+                    const ESM::Land::LandData *landData = land->getLandData (ESM::Land::DATA_WNAM);
+                    if (landData)
+                        std::copy(landData->mWnam, landData->mWnam + 81, heights.begin() + ((x-mMinX) * cellsY + (y-mMinY)) * 81);
+
+                    land->unloadData();
                 }
+                loadingListener->increaseProgress();
+            }
+        }
 
-                const ESM::Land::LandData *landData =
-                    land ? land->getLandData (ESM::Land::DATA_WNAM) : 0;
+        osg::ref_ptr<BaseMapColors> colors = new BaseMapColors;
 
-                for (int cellY=0; cellY<mCellSize; ++cellY)
-                {
-                    for (int cellX=0; cellX<mCellSize; ++cellX)
-                    {
-                        int vertexX = static_cast<int>(float(cellX)/float(mCellSize) * 9);
-                        int vertexY = static_cast<int>(float(cellY) / float(mCellSize) * 9);
+        osg::ref_ptr<osg::Image> image = new osg::Image;
+        image->allocateImage(mWidth, mHeight, 1, GL_RGB, GL_UNSIGNED_BYTE);
 
-                        int texelX = (x-mMinX) * mCellSize + cellX;
-                        int texelY = (y-mMinY) * mCellSize + cellY;
+        SceneUtil::WorkQueue* workQueue = MWBase::Environment::get().getWorkQueue();
+        std::vector<osg::ref_ptr<SceneUtil::WorkTicket> > tickets;
+        const int rowsPerItem = 4;
+        for (int y = 0; y < cellsY; y += rowsPerItem)
+            tickets.push_back(workQueue->addWorkItem(new FillBaseMapItem(image, heights, colors, mCellSize, cellsX, cellsY,
+                                                                         y, std::min(y + rowsPerItem, cellsY))));
+        for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = tickets.begin(); it != tickets.end(); ++it)
+            (*it)->waitTillDone();
 
-                        unsigned char r,g,b;
+        loadingListener->loadingOff();
+        return image;
+    }
 
-                        float y = 0;
-                        if (landData)
-                            y = (landData->mWnam[vertexY * 9 + vertexX] << 4) / 2048.f;
-                        else
-                            y = (SCHAR_MIN << 4) / 2048.f;
-                        if (y < 0)
-                        {
-                            r = static_cast<unsigned char>(14 * y + 38);
-                            g = static_cast<unsigned char>(20 * y + 56);
-                            b = static_cast<unsigned char>(18 * y + 51);
-                        }
-                        else if (y < 0.3f)
-                        {
-                            if (y < 0.1f)
-                                y *= 8.f;
-                            else
-                            {
-                                y -= 0.1f;
-                                y += 0.8f;
-                            }
-                            r = static_cast<unsigned char>(66 - 32 * y);
-                            g = static_cast<unsigned char>(48 - 23 * y);
-                            b = static_cast<unsigned char>(33 - 16 * y);
-                        }
-                        else
-                        {
-                            y -= 0.3f;
-                            y *= 1.428f;
-                            r = static_cast<unsigned char>(34 - 29 * y);
-                            g = static_cast<unsigned char>(25 - 20 * y);
-                            b = static_cast<unsigned char>(17 - 12 * y);
-                        }
+    void GlobalMap::getCacheFile(std::string &file, std::string &contentDescription) const
+    {
+        file.clear();
+        if (mCachePath.empty() || !Settings::Manager::getBool("global map cache", "Map"))
+            return;
 
-                        data[texelY * mWidth * 3 + texelX * 3] = r;
-                        data[texelY * mWidth * 3 + texelX * 3+1] = g;
-                        data[texelY * mWidth * 3 + texelX * 3+2] = b;
-                    }
-                }
-                loadingListener->increaseProgress();
-                if (land)
-                    land->unloadData();
-            }
+        // Increase the version whenever the map is made differently
+        std::ostringstream stream;
+        stream << "version 1\n";
+        stream << "cell size " << mCellSize << "\n";
+        stream << "cells " << mMinX << " " << mMaxX << " " << mMinY << " " << mMaxY << "\n";
+        const std::vector<std::string>& contentFiles = MWBase::Environment::get().getWorld()->getContentFiles();
+        for (std::vector<std::string>::const_iterator it = contentFiles.begin(); it != contentFiles.end(); ++it)
+            stream << *it << "\n";
+        contentDescription = stream.str();
+
+        std::ostringstream name;
+        name << "globalmap-" << std::hex << std::setw(16) << std::setfill('0') << boost::hash<std::string>()(contentDescription) << ".cache";
+        file = (boost::filesystem::path(mCachePath) / name.str()).string();
+    }
+
+    osg::ref_ptr<osg::Image> GlobalMap::readCachedBaseMap(const std::string &file, const std::string &contentDescription) const
+    {
+        boost::filesystem::ifstream stream;
+        stream.open(boost::filesystem::path(file), std::ios_base::in | std::ios_base::binary);
+        if (!stream.is_open())
+            return osg::ref_ptr<osg::Image>();
+
+        // A different description means a hash collision
+        unsigned int descriptionSize = 0;
+        stream.read(reinterpret_cast<char*>(&descriptionSize), sizeof(descriptionSize));
+        if (!stream.good() || descriptionSize != contentDescription.size())
+            return osg::ref_ptr<osg::Image>();
+        std::string description(descriptionSize, '\0');
+        stream.read(&description[0], descriptionSize);
+        if (!stream.good() || description != contentDescription)
+            return osg::ref_ptr<osg::Image>();
+
+        osg::ref_ptr<osg::Image> image = new osg::Image;
+        image->allocateImage(mWidth, mHeight, 1, GL_RGB, GL_UNSIGNED_BYTE);
+        stream.read(reinterpret_cast<char*>(image->data()), image->getTotalSizeInBytes());
+        if (stream.gcount() != static_cast<std::streamsize>(image->getTotalSizeInBytes()))
+        {
+            std::cerr << "Failed to read the cached global map " << file << std::endl;
+            return osg::ref_ptr<osg::Image>();
         }
+        return image;
+    }
 
-        mBaseTexture = new osg::Texture2D;
-        mBaseTexture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
-        mBaseTexture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
-        mBaseTexture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
-        mBaseTexture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
-        mBaseTexture->setImage(image);
-        mBaseTexture->setResizeNonPowerOfTwoHint(false);
+    void GlobalMap::writeCachedBaseMap(const std::string &file, const std::string &contentDescription, const osg::Image &image) const
+    {
+        try
+        {
+            boost::filesystem::create_directories(boost::filesystem::path(mCachePath));
 
-        clear();
+            boost::filesystem::ofstream stream;
+            stream.open(boost::filesystem::path(file), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
 
-        loadingListener->loadingOff();
+            unsigned int descriptionSize = contentDescription.size();
+            stream.write(reinterpret_cast<const char*>(&descriptionSize), sizeof(descriptionSize));
+            stream.write(contentDescription.data(), descriptionSize);
+            stream.write(reinterpret_cast<const char*>(image.data()), image.getTotalSizeInBytes());
+            if (!stream.good())
+                std::cerr << "Failed to write the global map cache " << file << std::endl;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to write the global map cache " << file << ": " << e.what() << std::endl;
+        }
     }
 
     void GlobalMap::worldPosToImageSpace(float x, float z, float& imageX, float& imageY)
@@ -30,9 +30,11 @@ namespace MWRender
     class GlobalMap
     {
     public:
-        GlobalMap(osg::Group* root);
+        /// @param cachePath Where to cache the base map between runs, for the same content files.
+        GlobalMap(osg::Group* root, const std::string& cachePath);
         ~GlobalMap();
 
+        /// Create the base map from the land of the exterior cells, or load it from the cache.
         void render(Loading::Listener* loadingListener);
 
         int getWidth() const { return mWidth; }
@@ -78,6 +80,19 @@ namespace MWRender
 
         int mCellSize;
 
+        std::string mCachePath;
+
+        /// Create the base map image from the land of the exterior cells.
+        osg::ref_ptr<osg::Image> createBaseMap(Loading::Listener* loadingListener);
+
+        /// The file caching the base map of the current content files, and the content description it is checked against.
+        void getCacheFile(std::string& file, std::string& contentDescription) const;
+
+        /// @return NULL if there is no matching cached base map.
+        osg::ref_ptr<osg::Image> readCachedBaseMap(const std::string& file, const std::string& contentDescription) const;
+
+        void writeCachedBaseMap(const std::string& file, const std::string& contentDescription, const osg::Image& image) const;
+
         osg::ref_ptr<osg::Group> mRoot;
 
         typedef std::vector<osg::ref_ptr<osg::Camera> > CameraVector;
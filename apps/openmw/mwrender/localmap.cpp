@@ -1,6 +1,8 @@
 #include "localmap.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #include <stdint.h>
 
 #include <osg/Fog>
@@ -16,6 +18,7 @@
 #include <components/esm/loadcell.hpp>
 #include <components/settings/settings.hpp>
 #include <components/sceneutil/visitor.hpp>
+#include <components/sceneutil/workqueue.hpp>
 #include <components/files/memorystream.hpp>
 
 #include "../mwbase/environment.hpp"
@@ -63,13 +66,123 @@ namespace
         return val*val;
     }
 
+    /// @return NULL if the data could not be read
+    osg::ref_ptr<osg::Image> readFogOfWar(const std::vector<char>& data)
+    {
+        // TODO: deprecate tga and use raw data instead
+
+        osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("tga");
+        if (!readerwriter)
+        {
+            std::cerr << "Unable to load fog, can't find a tga ReaderWriter" << std::endl;
+            return osg::ref_ptr<osg::Image>();
+        }
+
+        Files::IMemStream in(&data[0], data.size());
+
+        osgDB::ReaderWriter::ReadResult result = readerwriter->readImage(in);
+        if (!result.success())
+        {
+            std::cerr << "Failed to read fog: " << result.message() << " code " << result.status() << std::endl;
+            return osg::ref_ptr<osg::Image>();
+        }
+
+        osg::ref_ptr<osg::Image> image = result.getImage();
+        image->flipVertical();
+        return image;
+    }
+
+    /// @note Flips the image.
+    void writeFogOfWar(osg::Image& image, std::vector<char>& data)
+    {
+        std::ostringstream ostream;
+
+        osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("tga");
+        if (!readerwriter)
+        {
+            std::cerr << "Unable to write fog, can't find a tga ReaderWriter" << std::endl;
+            return;
+        }
+
+        // extra flip is unfortunate, but required for compatibility with older versions
+        image.flipVertical();
+        osgDB::ReaderWriter::WriteResult result = readerwriter->writeImage(image, ostream);
+        if (!result.success())
+        {
+            std::cerr << "Unable to write fog: " << result.message() << " code " << result.status() << std::endl;
+            return;
+        }
+
+        std::string str = ostream.str();
+        data = std::vector<char>(str.begin(), str.end());
+    }
+
 }
 
 namespace MWRender
 {
 
+/// Decodes the fog of war of map segments, or encodes the fog of war of a cell for its CellStore, in the background.
+class LocalMap::FogOfWarJob : public osg::Referenced
+{
+public:
+    FogOfWarJob()
+        : mCell(NULL)
+        , mFog(new ESM::FogState)
+    {
+    }
+
+    void run()
+    {
+        for (unsigned int i=0; i<mFog->mFogTextures.size(); ++i)
+        {
+            if (mCell)
+            {
+                if (mImages[i])
+                    writeFogOfWar(*mImages[i], mFog->mFogTextures[i].mImageData);
+            }
+            else if (mFog->mFogTextures[i].mImageData.empty())
+                mImages.push_back(osg::ref_ptr<osg::Image>());
+            else
+                mImages.push_back(readFogOfWar(mFog->mFogTextures[i].mImageData));
+        }
+    }
+
+    // For decoding, the segment of each fog texture
+    std::vector<std::pair<int, int> > mSegments;
+
+    // For encoding, the cell to set the fog state of, NULL for decoding
+    MWWorld::CellStore* mCell;
+
+    std::auto_ptr<ESM::FogState> mFog;
+
+    // For encoding, copies of the images of the fog textures, NULL for the segments without a fog of war.
+    // For decoding, the decoded images of the fog textures, NULL if they could not be read.
+    std::vector<osg::ref_ptr<osg::Image> > mImages;
+};
+
+class LocalMap::FogOfWarItem : public SceneUtil::WorkItem
+{
+public:
+    FogOfWarItem(FogOfWarJob* job)
+        : mJob(job)
+    {
+    }
+
+    virtual void doWork()
+    {
+        mJob->run();
+        mTicket->signalDone();
+    }
+
+private:
+    osg::ref_ptr<FogOfWarJob> mJob;
+};
+
 LocalMap::LocalMap(osgViewer::Viewer* viewer)
     : mViewer(viewer)
+    , mSegmentsPerFrame(std::max(0, Settings::Manager::getInt("local map segments per frame", "Map")))
+    , mWorkQueue(MWBase::Environment::get().getWorkQueue())
     , mMapResolution(Settings::Manager::getInt("local map resolution", "Map"))
     , mMapWorldSize(8192.f)
     , mAngle(0.f)
@@ -86,6 +199,9 @@ LocalMap::LocalMap(osgViewer::Viewer* viewer)
 
 LocalMap::~LocalMap()
 {
+    // The background work only uses its own copies of the fog of war
+    mFogOfWarWork.clear();
+
     for (CameraVector::iterator it = mActiveCameras.begin(); it != mActiveCameras.end(); ++it)
         mRoot->removeChild(*it);
     for (CameraVector::iterator it = mCamerasPendingRemoval.begin(); it != mCamerasPendingRemoval.end(); ++it)
@@ -100,24 +216,39 @@ const osg::Vec2f LocalMap::rotatePoint(const osg::Vec2f& point, const osg::Vec2f
 
 void LocalMap::clear()
 {
+    // The CellStores of the removed cells may be gone already
+    mFogOfWarWork.clear();
+    mQueuedRenders.clear();
     mSegments.clear();
 }
 
 void LocalMap::saveFogOfWar(MWWorld::CellStore* cell)
 {
+    // The fog of war of the removed cells has to be in their CellStores too, in case the game is being saved
+    finishFogOfWarWork(true);
+
+    osg::ref_ptr<FogOfWarJob> job = createSaveFogOfWarJob(cell);
+    if (job)
+    {
+        job->run();
+        cell->setFog(job->mFog.release());
+    }
+}
+
+osg::ref_ptr<LocalMap::FogOfWarJob> LocalMap::createSaveFogOfWarJob(MWWorld::CellStore* cell)
+{
+    osg::ref_ptr<FogOfWarJob> job = new FogOfWarJob;
+    job->mCell = cell;
+
     if (!mInterior)
     {
         const MapSegment& segment = mSegments[std::make_pair(cell->getCell()->getGridX(), cell->getCell()->getGridY())];
 
-        if (segment.mFogOfWarImage && segment.mHasFogState)
-        {
-            std::auto_ptr<ESM::FogState> fog (new ESM::FogState());
-            fog->mFogTextures.push_back(ESM::FogTexture());
-
-            segment.saveFogOfWar(fog->mFogTextures.back());
+        if (!segment.mFogOfWarImage || !segment.mHasFogState)
+            return osg::ref_ptr<FogOfWarJob>();
 
-            cell->setFog(fog.release());
-        }
+        job->mFog->mFogTextures.push_back(ESM::FogTexture());
+        job->mImages.push_back(new osg::Image(*segment.mFogOfWarImage, osg::CopyOp::DEEP_COPY_ALL));
     }
     else
     {
@@ -128,7 +259,7 @@ void LocalMap::saveFogOfWar(MWWorld::CellStore* cell)
         const int segsX = static_cast<int>(std::ceil(length.x() / mMapWorldSize));
         const int segsY = static_cast<int>(std::ceil(length.y() / mMapWorldSize));
 
-        std::auto_ptr<ESM::FogState> fog (new ESM::FogState());
+        ESM::FogState* fog = job->mFog.get();
 
         fog->mBounds.mMinX = mBounds.xMin();
         fog->mBounds.mMaxX = mBounds.xMax();
@@ -144,18 +275,50 @@ void LocalMap::saveFogOfWar(MWWorld::CellStore* cell)
             {
                 const MapSegment& segment = mSegments[std::make_pair(x,y)];
 
-                fog->mFogTextures.push_back(ESM::FogTexture());
-
                 // saving even if !segment.mHasFogState so we don't mess up the segmenting
                 // plus, older openmw versions can't deal with empty images
-                segment.saveFogOfWar(fog->mFogTextures.back());
-
+                fog->mFogTextures.push_back(ESM::FogTexture());
                 fog->mFogTextures.back().mX = x;
                 fog->mFogTextures.back().mY = y;
+
+                if (segment.mFogOfWarImage)
+                    job->mImages.push_back(new osg::Image(*segment.mFogOfWarImage, osg::CopyOp::DEEP_COPY_ALL));
+                else
+                    job->mImages.push_back(osg::ref_ptr<osg::Image>());
             }
         }
+    }
+
+    return job;
+}
 
-        cell->setFog(fog.release());
+void LocalMap::finishFogOfWarWork(bool wait)
+{
+    for (std::vector<FogOfWarWork>::iterator it = mFogOfWarWork.begin(); it != mFogOfWarWork.end();)
+    {
+        if (!it->mTicket->isDone())
+        {
+            if (!wait)
+            {
+                ++it;
+                continue;
+            }
+            it->mTicket->waitTillDone();
+        }
+
+        FogOfWarJob& job = *it->mJob;
+        if (job.mCell)
+            job.mCell->setFog(job.mFog.release());
+        else
+        {
+            for (unsigned int i=0; i<job.mSegments.size(); ++i)
+            {
+                SegmentMap::iterator found = mSegments.find(job.mSegments[i]);
+                if (found != mSegments.end() && found->second.mLoadingFogState)
+                    found->second.loadFogOfWar(job.mImages[i]);
+            }
+        }
+        it = mFogOfWarWork.erase(it);
     }
 }
 
@@ -172,7 +335,7 @@ osg::ref_ptr<osg::Camera> LocalMap::createOrthographicCamera(float x, float y, f
     camera->setClearMask(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     camera->setRenderOrder(osg::Camera::PRE_RENDER);
 
-    camera->setCullMask(Mask_Scene|Mask_SimpleWater|Mask_Terrain);
+    camera->setCullMask(Mask_Scene|Mask_SimpleWater|Mask_Terrain|Mask_MergedStatics);
     camera->setNodeMask(Mask_RenderToTexture);
 
     osg::ref_ptr<osg::StateSet> stateset = new osg::StateSet;
@@ -221,34 +384,128 @@ void LocalMap::setupRenderToTexture(osg::ref_ptr<osg::Camera> camera, int x, int
 
     camera->attach(osg::Camera::COLOR_BUFFER, texture);
 
-    camera->addChild(mSceneRoot);
-    mRoot->addChild(camera);
-    mActiveCameras.push_back(camera);
+    QueuedRender render;
+    render.mCamera = camera;
+    render.mSegment = std::make_pair(x, y);
+    for (std::vector<QueuedRender>::iterator it = mQueuedRenders.begin(); it != mQueuedRenders.end(); ++it)
+    {
+        // Replaces the outdated render of the same segment
+        if (it->mSegment == render.mSegment)
+        {
+            mQueuedRenders.erase(it);
+            break;
+        }
+    }
+    mQueuedRenders.push_back(render);
 
     MapSegment& segment = mSegments[std::make_pair(x, y)];
     segment.mMapTexture = texture;
 }
 
+namespace
+{
+    struct CloserToPlayer
+    {
+        CloserToPlayer(const osg::Vec3f& playerPos) : mPlayerPos(playerPos.x(), playerPos.y()) {}
+
+        template <class T>
+        bool operator() (const T& a, const T& b) const
+        {
+            return getDistance2(*a.mCamera) < getDistance2(*b.mCamera);
+        }
+
+        float getDistance2(const osg::Camera& camera) const
+        {
+            osg::Vec3f center = camera.getInverseViewMatrix().getTrans();
+            return (osg::Vec2f(center.x(), center.y()) - mPlayerPos).length2();
+        }
+
+        osg::Vec2f mPlayerPos;
+    };
+}
+
+void LocalMap::startQueuedRenders()
+{
+    if (mQueuedRenders.empty())
+        return;
+
+    std::vector<QueuedRender>::iterator end = mQueuedRenders.end();
+    if (mSegmentsPerFrame > 0 && mQueuedRenders.size() > static_cast<unsigned int>(mSegmentsPerFrame))
+    {
+        end = mQueuedRenders.begin() + mSegmentsPerFrame;
+        // The segments around the player are needed first, since the player is looking at them
+        MWWorld::Ptr player = MWBase::Environment::get().getWorld()->getPlayerPtr();
+        std::partial_sort(mQueuedRenders.begin(), end, mQueuedRenders.end(), CloserToPlayer(player.getRefData().getPosition().asVec3()));
+    }
+
+    for (std::vector<QueuedRender>::iterator it = mQueuedRenders.begin(); it != end; ++it)
+    {
+        it->mCamera->addChild(mSceneRoot);
+        mRoot->addChild(it->mCamera);
+        mActiveCameras.push_back(it->mCamera);
+    }
+    mQueuedRenders.erase(mQueuedRenders.begin(), end);
+}
+
 void LocalMap::requestMap(std::set<MWWorld::CellStore*> cells)
 {
+    // The fog states of the cells may still be encoded
+    finishFogOfWarWork(true);
+
+    osg::ref_ptr<FogOfWarJob> fogJob = new FogOfWarJob;
     for (std::set<MWWorld::CellStore*>::iterator it = cells.begin(); it != cells.end(); ++it)
     {
         MWWorld::CellStore* cell = *it;
         if (cell->isExterior())
-            requestExteriorMap(cell);
+            requestExteriorMap(cell, *fogJob);
         else
-            requestInteriorMap(cell);
+            requestInteriorMap(cell, *fogJob);
+    }
+
+    if (!fogJob->mSegments.empty())
+    {
+        FogOfWarWork work;
+        work.mJob = fogJob;
+        work.mTicket = mWorkQueue->addWorkItem(new FogOfWarItem(fogJob));
+        mFogOfWarWork.push_back(work);
     }
+
+    // Right away for the segment of the player, so that it is ready when the map opens
+    startQueuedRenders();
 }
 
 void LocalMap::removeCell(MWWorld::CellStore *cell)
 {
-    saveFogOfWar(cell);
+    // The segments have to be decoded before they can be saved
+    finishFogOfWarWork(true);
+
+    osg::ref_ptr<FogOfWarJob> job = createSaveFogOfWarJob(cell);
+    if (job)
+    {
+        FogOfWarWork work;
+        work.mJob = job;
+        work.mTicket = mWorkQueue->addWorkItem(new FogOfWarItem(job));
+        mFogOfWarWork.push_back(work);
+    }
 
     if (cell->isExterior())
-        mSegments.erase(std::make_pair(cell->getCell()->getGridX(), cell->getCell()->getGridY()));
+    {
+        std::pair<int, int> segment (cell->getCell()->getGridX(), cell->getCell()->getGridY());
+        mSegments.erase(segment);
+        for (std::vector<QueuedRender>::iterator it = mQueuedRenders.begin(); it != mQueuedRenders.end(); ++it)
+        {
+            if (it->mSegment == segment)
+            {
+                mQueuedRenders.erase(it);
+                break;
+            }
+        }
+    }
     else
+    {
         mSegments.clear();
+        mQueuedRenders.clear();
+    }
 }
 
 osg::ref_ptr<osg::Texture2D> LocalMap::getMapTexture(int x, int y)
@@ -283,6 +540,9 @@ void LocalMap::markForRemoval(osg::Camera *cam)
 
 void LocalMap::cleanupCameras()
 {
+    startQueuedRenders();
+    finishFogOfWarWork(false);
+
     if (mCamerasPendingRemoval.empty())
         return;
 
@@ -296,7 +556,7 @@ void LocalMap::cleanupCameras()
     mCamerasPendingRemoval.clear();
 }
 
-void LocalMap::requestExteriorMap(MWWorld::CellStore* cell)
+void LocalMap::requestExteriorMap(MWWorld::CellStore* cell, FogOfWarJob& fogJob)
 {
     mInterior = false;
 
@@ -314,17 +574,20 @@ void LocalMap::requestExteriorMap(MWWorld::CellStore* cell)
     MapSegment& segment = mSegments[std::make_pair(cell->getCell()->getGridX(), cell->getCell()->getGridY())];
     if (!segment.mFogOfWarImage)
     {
+        segment.initFogOfWar();
         if (cell->getFog())
-            segment.loadFogOfWar(cell->getFog()->mFogTextures.back());
-        else
-            segment.initFogOfWar();
+        {
+            segment.mLoadingFogState = true;
+            fogJob.mSegments.push_back(std::make_pair(x, y));
+            fogJob.mFog->mFogTextures.push_back(cell->getFog()->mFogTextures.back());
+        }
     }
 }
 
-void LocalMap::requestInteriorMap(MWWorld::CellStore* cell)
+void LocalMap::requestInteriorMap(MWWorld::CellStore* cell, FogOfWarJob& fogJob)
 {
     osg::ComputeBoundsVisitor computeBoundsVisitor;
-    computeBoundsVisitor.setTraversalMask(Mask_Scene|Mask_Terrain);
+    computeBoundsVisitor.setTraversalMask(Mask_Scene|Mask_Terrain|Mask_MergedStatics);
     mSceneRoot->accept(computeBoundsVisitor);
 
     osg::BoundingBox bounds = computeBoundsVisitor.getBoundingBox();
@@ -434,9 +697,8 @@ void LocalMap::requestInteriorMap(MWWorld::CellStore* cell)
             MapSegment& segment = mSegments[std::make_pair(x,y)];
             if (!segment.mFogOfWarImage)
             {
-                if (!cell->getFog())
-                    segment.initFogOfWar();
-                else
+                segment.initFogOfWar();
+                if (cell->getFog())
                 {
                     ESM::FogState* fog = cell->getFog();
 
@@ -447,7 +709,9 @@ void LocalMap::requestInteriorMap(MWWorld::CellStore* cell)
                         break;
                     }
 
-                    segment.loadFogOfWar(fog->mFogTextures[i]);
+                    segment.mLoadingFogState = true;
+                    fogJob.mSegments.push_back(std::make_pair(x, y));
+                    fogJob.mFog->mFogTextures.push_back(fog->mFogTextures[i]);
                 }
             }
             ++i;
@@ -554,35 +818,46 @@ void LocalMap::updatePlayer (const osg::Vec3f& position, const osg::Quat& orient
 
             MapSegment& segment = mSegments[std::make_pair(texX, texY)];
 
-            if (!segment.mFogOfWarImage || !segment.mMapTexture)
+            if (!segment.mFogOfWarImage || !segment.mMapTexture || segment.mLoadingFogState)
                 continue;
 
+            // Only the texels within the explore radius can change, the image is uploaded again only if they did
+            const float centerU = u*(sFogOfWarResolution-1) - mx*(sFogOfWarResolution-1);
+            const float centerV = v*(sFogOfWarResolution-1) - my*(sFogOfWarResolution-1);
+            const int minU = std::max(0, static_cast<int>(std::ceil(centerU - exploreRadius)));
+            const int maxU = std::min(sFogOfWarResolution-1, static_cast<int>(std::floor(centerU + exploreRadius)));
+            const int minV = std::max(0, static_cast<int>(std::ceil(centerV - exploreRadius)));
+            const int maxV = std::min(sFogOfWarResolution-1, static_cast<int>(std::floor(centerV + exploreRadius)));
+
+            bool changed = false;
             unsigned char* data = segment.mFogOfWarImage->data();
-            for (int texV = 0; texV<sFogOfWarResolution; ++texV)
+            for (int texV = minV; texV<=maxV; ++texV)
             {
-                for (int texU = 0; texU<sFogOfWarResolution; ++texU)
+                uint32_t* row = reinterpret_cast<uint32_t*>(data) + texV*sFogOfWarResolution;
+                for (int texU = minU; texU<=maxU; ++texU)
                 {
-                    float sqrDist = square((texU + mx*(sFogOfWarResolution-1)) - u*(sFogOfWarResolution-1))
-                            + square((texV + my*(sFogOfWarResolution-1)) - v*(sFogOfWarResolution-1));
-
-                    uint32_t clr = *(uint32_t*)data;
-                    uint8_t alpha = (clr >> 24);
+                    float sqrDist = square(texU - centerU) + square(texV - centerV);
 
-                    alpha = std::min( alpha, (uint8_t) (std::max(0.f, std::min(1.f, (sqrDist/sqrExploreRadius)))*255) );
-                    *(uint32_t*)data = (uint32_t) (alpha << 24);
-
-                    data += 4;
+                    uint8_t alpha = (row[texU] >> 24);
+                    uint8_t explored = (uint8_t) (std::max(0.f, std::min(1.f, (sqrDist/sqrExploreRadius)))*255);
+                    if (explored < alpha)
+                    {
+                        row[texU] = (uint32_t) (explored << 24);
+                        changed = true;
+                    }
                 }
             }
 
             segment.mHasFogState = true;
-            segment.mFogOfWarImage->dirty();
+            if (changed)
+                segment.mFogOfWarImage->dirty();
         }
     }
 }
 
 LocalMap::MapSegment::MapSegment()
     : mHasFogState(false)
+    , mLoadingFogState(false)
 {
 }
 
@@ -596,8 +871,8 @@ void LocalMap::MapSegment::createFogOfWarTexture()
     if (mFogOfWarTexture)
         return;
     mFogOfWarTexture = new osg::Texture2D;
-    // TODO: synchronize access? for now, the worst that could happen is the draw thread jumping a frame ahead.
-    //mFogOfWarTexture->setDataVariance(osg::Object::DYNAMIC);
+    // The image is written to while the map is open, so the GUI waits for the draw of a frame that uses the texture
+    mFogOfWarTexture->setDataVariance(osg::Object::DYNAMIC);
     mFogOfWarTexture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
     mFogOfWarTexture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
     mFogOfWarTexture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
@@ -621,35 +896,13 @@ void LocalMap::MapSegment::initFogOfWar()
     mFogOfWarTexture->setImage(mFogOfWarImage);
 }
 
-void LocalMap::MapSegment::loadFogOfWar(const ESM::FogTexture &esm)
+void LocalMap::MapSegment::loadFogOfWar(osg::Image* image)
 {
-    const std::vector<char>& data = esm.mImageData;
-    if (!data.size())
-    {
-        initFogOfWar();
-        return;
-    }
-
-    // TODO: deprecate tga and use raw data instead
-
-    osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("tga");
-    if (!readerwriter)
-    {
-        std::cerr << "Unable to load fog, can't find a tga ReaderWriter" << std::endl;
+    mLoadingFogState = false;
+    if (!image)
         return;
-    }
 
-    Files::IMemStream in(&data[0], data.size());
-
-    osgDB::ReaderWriter::ReadResult result = readerwriter->readImage(in);
-    if (!result.success())
-    {
-        std::cerr << "Failed to read fog: " << result.message() << " code " << result.status() << std::endl;
-        return;
-    }
-
-    mFogOfWarImage = result.getImage();
-    mFogOfWarImage->flipVertical();
+    mFogOfWarImage = image;
     mFogOfWarImage->dirty();
 
     createFogOfWarTexture();
@@ -657,32 +910,4 @@ void LocalMap::MapSegment::loadFogOfWar(const ESM::FogTexture &esm)
     mHasFogState = true;
 }
 
-void LocalMap::MapSegment::saveFogOfWar(ESM::FogTexture &fog) const
-{
-    if (!mFogOfWarImage)
-        return;
-
-    std::ostringstream ostream;
-
-    osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("tga");
-    if (!readerwriter)
-    {
-        std::cerr << "Unable to write fog, can't find a tga ReaderWriter" << std::endl;
-        return;
-    }
-
-    // extra flips are unfortunate, but required for compatibility with older versions
-    mFogOfWarImage->flipVertical();
-    osgDB::ReaderWriter::WriteResult result = readerwriter->writeImage(*mFogOfWarImage, ostream);
-    if (!result.success())
-    {
-        std::cerr << "Unable to write fog: " << result.message() << " code " << result.status() << std::endl;
-        return;
-    }
-    mFogOfWarImage->flipVertical();
-
-    std::string data = ostream.str();
-    fog.mImageData = std::vector<char>(data.begin(), data.end());
-}
-
 }
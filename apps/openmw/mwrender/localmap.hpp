@@ -24,6 +24,12 @@ namespace osgViewer
     class Viewer;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+    class WorkTicket;
+}
+
 namespace osg
 {
     class Texture2D;
@@ -51,6 +57,7 @@ namespace MWRender
 
         /**
          * Request a map render for the given cells. Render textures will be immediately created and can be retrieved with the getMapTexture function.
+         * @remarks The segments are rendered over the next frames, a few per frame, the ones closest to the player first.
          */
         void requestMap (std::set<MWWorld::CellStore*> cells);
 
@@ -72,6 +79,7 @@ namespace MWRender
          * Removes cameras that have already been rendered. Should be called every frame to ensure that
          * we do not render the same map more than once. Note, this cleanup is difficult to implement in an
          * automated fashion, since we can't alter the scene graph structure from within an update callback.
+         * @remarks Also starts the next queued segment renders, and finishes the fog of war work done in the background.
          */
         void cleanupCameras();
 
@@ -115,14 +123,47 @@ namespace MWRender
 
         CameraVector mCamerasPendingRemoval;
 
+        struct QueuedRender
+        {
+            osg::ref_ptr<osg::Camera> mCamera;
+            std::pair<int, int> mSegment;
+        };
+        // Map renders that were not started yet
+        std::vector<QueuedRender> mQueuedRenders;
+        // Started per frame, 0 for no limit
+        int mSegmentsPerFrame;
+
+        /// Start the queued renders of this frame.
+        void startQueuedRenders();
+
+        class FogOfWarJob;
+        class FogOfWarItem;
+
+        struct FogOfWarWork
+        {
+            osg::ref_ptr<FogOfWarJob> mJob;
+            osg::ref_ptr<SceneUtil::WorkTicket> mTicket;
+        };
+        // Fog of war being decoded for the segments, or encoded for cells that were removed
+        std::vector<FogOfWarWork> mFogOfWarWork;
+
+        SceneUtil::WorkQueue* mWorkQueue;
+
+        /// Apply the fog of war work that is done.
+        /// @param wait Wait for the work that is not done yet.
+        void finishFogOfWarWork(bool wait);
+
+        /// Make a job encoding the fog of war of the cell for its CellStore, or NULL if there is no fog state to save.
+        osg::ref_ptr<FogOfWarJob> createSaveFogOfWarJob(MWWorld::CellStore* cell);
+
         struct MapSegment
         {
             MapSegment();
             ~MapSegment();
 
             void initFogOfWar();
-            void loadFogOfWar(const ESM::FogTexture& fog);
-            void saveFogOfWar(ESM::FogTexture& fog) const;
+            /// @param image The decoded fog of war, or NULL to keep the initial fog of war.
+            void loadFogOfWar(osg::Image* image);
             void createFogOfWarTexture();
 
             osg::ref_ptr<osg::Texture2D> mMapTexture;
@@ -130,6 +171,8 @@ namespace MWRender
             osg::ref_ptr<osg::Image> mFogOfWarImage;
 
             bool mHasFogState;
+            // The fog of war is being decoded in the background. Until then, the segment is not explored.
+            bool mLoadingFogState;
         };
 
         typedef std::map<std::pair<int, int>, MapSegment> SegmentMap;
@@ -146,8 +189,9 @@ namespace MWRender
         float mAngle;
         const osg::Vec2f rotatePoint(const osg::Vec2f& point, const osg::Vec2f& center, const float angle);
 
-        void requestExteriorMap(MWWorld::CellStore* cell);
-        void requestInteriorMap(MWWorld::CellStore* cell);
+        /// @param fogJob Gets the fog of war of the cell to decode, if there is any.
+        void requestExteriorMap(MWWorld::CellStore* cell, FogOfWarJob& fogJob);
+        void requestInteriorMap(MWWorld::CellStore* cell, FogOfWarJob& fogJob);
 
         osg::ref_ptr<osg::Camera> createOrthographicCamera(float left, float top, float width, float height, const osg::Vec3d& upVector, float zmin, float zmax);
         void setupRenderToTexture(osg::ref_ptr<osg::Camera> camera, int x, int y);
@@ -38,6 +38,31 @@
 namespace
 {
 
+/// The skin body parts of a race, by the lowercase race id, in the order of the store. The store is only gone through
+/// once, on the first call, rather than for each race, gender and view mode.
+const std::vector<const ESM::BodyPart*>& getRaceSkinParts(const std::string& race)
+{
+    typedef std::map<std::string, std::vector<const ESM::BodyPart*> > RacePartsMap;
+    static RacePartsMap sRaceParts;
+    static bool sListed = false;
+
+    if (!sListed)
+    {
+        const MWWorld::ESMStore &store = MWBase::Environment::get().getWorld()->getStore();
+        const MWWorld::Store<ESM::BodyPart> &partStore = store.get<ESM::BodyPart>();
+        for(MWWorld::Store<ESM::BodyPart>::iterator it = partStore.begin(); it != partStore.end(); ++it)
+        {
+            if (it->mData.mType == ESM::BodyPart::MT_Skin)
+                sRaceParts[Misc::StringUtils::lowerCase(it->mRace)].push_back(&*it);
+        }
+        sListed = true;
+    }
+
+    static const std::vector<const ESM::BodyPart*> sNoParts;
+    RacePartsMap::const_iterator found = sRaceParts.find(race);
+    return found != sRaceParts.end() ? found->second : sNoParts;
+}
+
 std::string getVampireHead(const std::string& race, bool female)
 {
     static std::map <std::pair<std::string,int>, const ESM::BodyPart* > sVampireMapping;
@@ -46,22 +71,17 @@ std::string getVampireHead(const std::string& race, bool female)
 
     if (sVampireMapping.find(thisCombination) == sVampireMapping.end())
     {
-        const MWWorld::ESMStore &store = MWBase::Environment::get().getWorld()->getStore();
-        const MWWorld::Store<ESM::BodyPart> &partStore = store.get<ESM::BodyPart>();
-        for(MWWorld::Store<ESM::BodyPart>::iterator it = partStore.begin(); it != partStore.end(); ++it)
+        const std::vector<const ESM::BodyPart*>& raceParts = getRaceSkinParts(Misc::StringUtils::lowerCase(race));
+        for(std::vector<const ESM::BodyPart*>::const_iterator it = raceParts.begin(); it != raceParts.end(); ++it)
         {
-            const ESM::BodyPart& bodypart = *it;
+            const ESM::BodyPart& bodypart = **it;
             if (!bodypart.mData.mVampire)
                 continue;
-            if (bodypart.mData.mType != ESM::BodyPart::MT_Skin)
-                continue;
             if (bodypart.mData.mPart != ESM::BodyPart::MP_Head)
                 continue;
             if (female != (bodypart.mData.mFlags & ESM::BodyPart::BPF_Female))
                 continue;
-            if (!Misc::StringUtils::ciEqual(bodypart.mRace, race))
-                continue;
-            sVampireMapping[thisCombination] = &*it;
+            sVampireMapping[thisCombination] = *it;
         }
     }
 
@@ -521,6 +541,23 @@ void NpcAnimation::updateParts()
         return;
     }
 
+    // The parts are added again by their priorities, but the parts that are the same as before are kept,
+    // rather than being instanced and attached to the skeleton again
+    for (int i=0; i<ESM::PRT_Count; ++i)
+    {
+        mOldParts[i] = mObjectParts[i];
+        mOldPartSources[i] = mPartSources[i];
+    }
+
+    addParts();
+
+    // Detaches the parts that were not kept
+    for (int i=0; i<ESM::PRT_Count; ++i)
+        mOldParts[i].reset();
+}
+
+void NpcAnimation::addParts()
+{
     static const struct {
         int mSlot;
         int mBasePriority;
@@ -613,6 +650,8 @@ void NpcAnimation::updateParts()
             addOrReplaceIndividualPart(ESM::PRT_Shield, MWWorld::InventoryStore::Slot_CarriedLeft,
                                        1, "meshes\\"+light->mModel);
             addExtraLight(mObjectParts[ESM::PRT_Shield]->getNode()->asGroup(), light);
+            // The light is added to the part, so it must not be kept for another light
+            mPartSources[ESM::PRT_Shield] = PartSource();
         }
     }
 
@@ -668,20 +707,14 @@ void NpcAnimation::updateParts()
         std::vector<const ESM::BodyPart*> &parts = sRaceMapping[thisCombination];
         parts.resize(ESM::PRT_Count, NULL);
 
-        const MWWorld::ESMStore &store = MWBase::Environment::get().getWorld()->getStore();
-        const MWWorld::Store<ESM::BodyPart> &partStore = store.get<ESM::BodyPart>();
-        for(MWWorld::Store<ESM::BodyPart>::iterator it = partStore.begin(); it != partStore.end(); ++it)
+        const std::vector<const ESM::BodyPart*>& raceParts = getRaceSkinParts(race);
+        for(std::vector<const ESM::BodyPart*>::const_iterator it = raceParts.begin(); it != raceParts.end(); ++it)
         {
             if(isWerewolf)
                 break;
-            const ESM::BodyPart& bodypart = *it;
+            const ESM::BodyPart& bodypart = **it;
             if (bodypart.mData.mFlags & ESM::BodyPart::BPF_NotPlayable)
                 continue;
-            if (bodypart.mData.mType != ESM::BodyPart::MT_Skin)
-                continue;
-
-            if (!Misc::StringUtils::ciEqual(bodypart.mRace, mNpc->mRace))
-                continue;
 
             bool firstPerson = (bodypart.mId.size() >= 3)
                     && bodypart.mId[bodypart.mId.size()-3] == '1'
@@ -699,7 +732,7 @@ void NpcAnimation::updateParts()
                     while(bIt != sBodyPartMap.end() && bIt->first == bodypart.mData.mPart)
                     {
                         if(!parts[bIt->second])
-                            parts[bIt->second] = &*it;
+                            parts[bIt->second] = *it;
                         ++bIt;
                     }
                 }
@@ -713,7 +746,7 @@ void NpcAnimation::updateParts()
                 while(bIt != sBodyPartMap.end() && bIt->first == bodypart.mData.mPart)
                 {
                     if(!parts[bIt->second])
-                        parts[bIt->second] = &*it;
+                        parts[bIt->second] = *it;
                     ++bIt;
                 }
                 continue;
@@ -722,7 +755,7 @@ void NpcAnimation::updateParts()
             BodyPartMapType::const_iterator bIt = sBodyPartMap.lower_bound(BodyPartMapType::key_type(bodypart.mData.mPart));
             while(bIt != sBodyPartMap.end() && bIt->first == bodypart.mData.mPart)
             {
-                parts[bIt->second] = &*it;
+                parts[bIt->second] = *it;
                 ++bIt;
             }
         }
@@ -744,6 +777,24 @@ void NpcAnimation::updateParts()
         attachArrow();
 }
 
+NpcAnimation::PartSource::PartSource()
+    : mEnchantedGlow(false)
+{
+}
+
+NpcAnimation::PartSource::PartSource(const std::string& mesh, bool enchantedGlow, const osg::Vec4f* glowColor)
+    : mMesh(mesh)
+    , mEnchantedGlow(enchantedGlow)
+{
+    if (enchantedGlow && glowColor)
+        mGlowColor = *glowColor;
+}
+
+bool NpcAnimation::PartSource::operator== (const PartSource& other) const
+{
+    return !mMesh.empty() && mMesh == other.mMesh && mEnchantedGlow == other.mEnchantedGlow && mGlowColor == other.mGlowColor;
+}
+
 PartHolderPtr NpcAnimation::insertBoundedPart(const std::string& model, const std::string& bonename, const std::string& bonefilter, bool enchantedGlow, osg::Vec4f* glowColor)
 {
     osg::ref_ptr<osg::Node> instance = mResourceSystem->getSceneManager()->createInstance(model);
@@ -785,6 +836,7 @@ void NpcAnimation::removeIndividualPart(ESM::PartReferenceType type)
     mPartslots[type] = -1;
 
     mObjectParts[type].reset();
+    mPartSources[type] = PartSource();
     if (!mSoundIds[type].empty() && !mSoundsDisabled)
     {
         MWBase::Environment::get().getSoundManager()->stopSound3D(mPtr, mSoundIds[type]);
@@ -824,7 +876,12 @@ bool NpcAnimation::addOrReplaceIndividualPart(ESM::PartReferenceType type, int g
         const std::string& bonename = sPartList.at(type);
         // PRT_Hair seems to be the only type that breaks consistency and uses a filter that's different from the attachment bone
         const std::string bonefilter = (type == ESM::PRT_Hair) ? "hair" : bonename;
-        mObjectParts[type] = insertBoundedPart(mesh, bonename, bonefilter, enchantedGlow, glowColor);
+        PartSource source (mesh, enchantedGlow, glowColor);
+        if (mOldParts[type] && mOldPartSources[type] == source)
+            mObjectParts[type] = mOldParts[type];
+        else
+            mObjectParts[type] = insertBoundedPart(mesh, bonename, bonefilter, enchantedGlow, glowColor);
+        mPartSources[type] = source;
     }
     catch (std::exception& e)
     {
@@ -1007,7 +1064,11 @@ void NpcAnimation::showCarriedLeft(bool show)
                                    mesh, !iter->getClass().getEnchantment(*iter).empty(), &glowColor))
         {
             if (iter->getTypeName() == typeid(ESM::Light).name())
+            {
                 addExtraLight(mObjectParts[ESM::PRT_Shield]->getNode()->asGroup(), iter->get<ESM::Light>()->mBase);
+                // The light is added to the part, so it must not be kept for another light
+                mPartSources[ESM::PRT_Shield] = PartSource();
+            }
         }
     }
     else
@@ -1,6 +1,8 @@
 #ifndef GAME_RENDER_NPCANIMATION_H
 #define GAME_RENDER_NPCANIMATION_H
 
+#include <osg/Vec4f>
+
 #include "animation.hpp"
 
 #include "../mwworld/inventorystore.hpp"
@@ -38,10 +40,28 @@ private:
 
     bool mListenerDisabled;
 
+    /// What a bounded part was created from
+    struct PartSource
+    {
+        std::string mMesh;
+        bool mEnchantedGlow;
+        osg::Vec4f mGlowColor;
+
+        PartSource();
+        PartSource(const std::string& mesh, bool enchantedGlow, const osg::Vec4f* glowColor);
+
+        bool operator== (const PartSource& other) const;
+    };
+
     // Bounded Parts
     PartHolderPtr mObjectParts[ESM::PRT_Count];
+    PartSource mPartSources[ESM::PRT_Count];
     std::string mSoundIds[ESM::PRT_Count];
 
+    // The parts from before updateParts, to keep those that did not change. Only set during updateParts.
+    PartHolderPtr mOldParts[ESM::PRT_Count];
+    PartSource mOldPartSources[ESM::PRT_Count];
+
     const ESM::NPC *mNpc;
     std::string    mHeadModel;
     std::string    mHairModel;
@@ -74,6 +94,8 @@ private:
 
     void updateNpcBase();
 
+    void addParts();
+
     PartHolderPtr insertBoundedPart(const std::string &model, const std::string &bonename,
                                         const std::string &bonefilter, bool enchantedGlow, osg::Vec4f* glowColor=NULL);
 
@@ -1,8 +1,12 @@
 #include "objects.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <sstream>
+#include <typeinfo>
 
 #include <osg/Group>
+#include <osg/Program>
 #include <osg/Geode>
 #include <osg/UserDataContainer>
 #include <osg/Version>
@@ -10,10 +14,20 @@
 #include <osgParticle/ParticleSystem>
 #include <osgParticle/ParticleProcessor>
 
+#include <osgUtil/CullVisitor>
+
+#include <components/esm/records.hpp>
+
 #include <components/resource/scenemanager.hpp>
 
+#include <components/settings/settings.hpp>
+
 #include <components/sceneutil/visitor.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
+#include <components/sceneutil/staticmerger.hpp>
+#include <components/sceneutil/lightmanager.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/sceneutil/occlusionquery.hpp>
 
 #include "../mwworld/ptr.hpp"
 #include "../mwworld/class.hpp"
@@ -22,6 +36,7 @@
 #include "npcanimation.hpp"
 #include "creatureanimation.hpp"
 #include "vismask.hpp"
+#include "util.hpp"
 
 namespace
 {
@@ -79,6 +94,58 @@ namespace
         std::vector<osg::ref_ptr<osg::Node> > mToRemove;
     };
 
+    /// Culls an object that is further away than the view distance of its category, or that would cover fewer pixels than
+    /// the small feature size. Cameras without a perspective projection, like the ones of the maps, draw every object.
+    class ObjectCullCallback : public osg::NodeCallback
+    {
+    public:
+        /// @param viewDistance 0 for no limit
+        /// @param minPixelSize 0 for no limit
+        ObjectCullCallback(float viewDistance, float minPixelSize)
+            : mViewDistance(viewDistance)
+            , mMinPixelSize(minPixelSize)
+        {
+        }
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+            const osg::RefMatrix* projection = cv->getProjectionMatrix();
+            if (projection && (*projection)(3,3) == 0.0)
+            {
+                const osg::BoundingSphere& bound = node->getBound();
+                if (mViewDistance > 0.f && cv->getDistanceToViewPoint(bound.center(), true) - bound.radius() > mViewDistance)
+                    return;
+                if (mMinPixelSize > 0.f && cv->clampedPixelSize(bound) < mMinPixelSize)
+                    return;
+            }
+            traverse(node, nv);
+        }
+
+    private:
+        float mViewDistance;
+        float mMinPixelSize;
+    };
+
+    /// Makes the merged geometry of a cell in the background.
+    class MergeStaticsItem : public SceneUtil::WorkItem
+    {
+    public:
+        MergeStaticsItem(SceneUtil::StaticMerger* merger)
+            : mMerger(merger)
+        {
+        }
+
+        virtual void doWork()
+        {
+            mMerger->merge();
+            mTicket->signalDone();
+        }
+
+    private:
+        osg::ref_ptr<SceneUtil::StaticMerger> mMerger;
+    };
+
 }
 
 
@@ -88,42 +155,79 @@ namespace MWRender
 Objects::Objects(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> rootNode)
     : mRootNode(rootNode)
     , mResourceSystem(resourceSystem)
+    , mWorkQueue(NULL)
+    , mCellGroupSize(std::max(0.f, Settings::Manager::getFloat("cell group size", "Objects")))
+    , mMergeStatics(Settings::Manager::getBool("merge static objects", "Objects"))
+    , mMergeTileSize(Settings::Manager::getFloat("merged tile size", "Objects"))
+    , mMinInstances(0)
+    , mAnimationLodDistance(std::max(0.f, Settings::Manager::getFloat("animation lod distance", "Objects")))
+    , mAnimationLodInterval(std::max(1, Settings::Manager::getInt("animation lod max interval", "Objects")))
+    , mItemViewDistance(std::max(0.f, Settings::Manager::getFloat("item view distance", "Objects")))
+    , mFloraViewDistance(std::max(0.f, Settings::Manager::getFloat("flora view distance", "Objects")))
+    , mActorViewDistance(std::max(0.f, Settings::Manager::getFloat("actor view distance", "Objects")))
+    , mSmallFeatureSize(std::max(0.f, Settings::Manager::getFloat("small feature culling pixel size", "Objects")))
 {
+    if (Settings::Manager::getBool("occlusion culling", "Objects"))
+        mOcclusionQueries = new SceneUtil::OcclusionQueries(std::max(1, Settings::Manager::getInt("occlusion query threshold", "Objects")),
+                                                            std::max(1, Settings::Manager::getInt("occlusion query interval", "Objects")));
 }
 
 Objects::~Objects()
 {
+    while (!mMergedCells.empty())
+        unmergeCell(mMergedCells.begin());
+    for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mCancelled.begin(); it != mCancelled.end(); ++it)
+        (*it)->waitTillDone();
+
     for(PtrAnimationMap::iterator iter = mObjects.begin();iter != mObjects.end();++iter)
         delete iter->second;
     mObjects.clear();
 
     for (CellMap::iterator iter = mCellSceneNodes.begin(); iter != mCellSceneNodes.end(); ++iter)
-        iter->second->getParent(0)->removeChild(iter->second);
+        iter->second.mNode->getParent(0)->removeChild(iter->second.mNode);
     mCellSceneNodes.clear();
 }
 
-void Objects::insertBegin(const MWWorld::Ptr& ptr)
+Objects::CellNode& Objects::getCellNode(const MWWorld::CellStore *store)
 {
-    osg::ref_ptr<osg::Group> cellnode;
+    CellMap::iterator found = mCellSceneNodes.find(store);
+    if (found != mCellSceneNodes.end())
+        return found->second;
+
+    CellNode& cellNode = mCellSceneNodes[store];
+    cellNode.mNode = new osg::Group;
+    mRootNode->addChild(cellNode.mNode);
+    return cellNode;
+}
+
+osg::Group* Objects::getGroupNode(CellNode& cellNode, const osg::Vec3f& position)
+{
+    if (mCellGroupSize <= 0.f)
+        return cellNode.mNode;
+
+    std::pair<int, int> square (static_cast<int>(std::floor(position.x() / mCellGroupSize)),
+                                static_cast<int>(std::floor(position.y() / mCellGroupSize)));
 
-    CellMap::iterator found = mCellSceneNodes.find(ptr.getCell());
-    if (found == mCellSceneNodes.end())
+    osg::ref_ptr<osg::Group>& group = cellNode.mGroups[square];
+    if (!group)
     {
-        cellnode = new osg::Group;
-        mRootNode->addChild(cellnode);
-        mCellSceneNodes[ptr.getCell()] = cellnode;
+        group = new osg::Group;
+        cellNode.mNode->addChild(group);
     }
-    else
-        cellnode = found->second;
+    return group;
+}
+
+void Objects::insertBegin(const MWWorld::Ptr& ptr)
+{
+    const float *f = ptr.getRefData().getPosition().pos;
+    osg::Vec3f position(f[0], f[1], f[2]);
 
     osg::ref_ptr<SceneUtil::PositionAttitudeTransform> insert (new SceneUtil::PositionAttitudeTransform);
-    cellnode->addChild(insert);
+    getGroupNode(getCellNode(ptr.getCell()), position)->addChild(insert);
 
     insert->getOrCreateUserDataContainer()->addUserObject(new PtrHolder(ptr));
 
-    const float *f = ptr.getRefData().getPosition().pos;
-
-    insert->setPosition(osg::Vec3(f[0], f[1], f[2]));
+    insert->setPosition(position);
 
     const float scale = ptr.getCellRef().getScale();
     osg::Vec3f scaleVec(scale, scale, scale);
@@ -131,6 +235,26 @@ void Objects::insertBegin(const MWWorld::Ptr& ptr)
     insert->setScale(scaleVec);
 
     ptr.getRefData().setBaseNode(insert);
+
+    float viewDistance = getViewDistance(ptr);
+    if (viewDistance > 0.f || mSmallFeatureSize > 0.f)
+        insert->addCullCallback(new ObjectCullCallback(viewDistance, mSmallFeatureSize));
+}
+
+float Objects::getViewDistance(const MWWorld::Ptr &ptr) const
+{
+    const std::string& type = ptr.getTypeName();
+    if (type == typeid(ESM::NPC).name() || type == typeid(ESM::Creature).name())
+        return mActorViewDistance;
+    if (type == typeid(ESM::Container).name())
+        return (ptr.get<ESM::Container>()->mBase->mFlags & ESM::Container::Organic) ? mFloraViewDistance : 0.f;
+    // Lights are left out, as they are usually lamps and torches placed to light the scene
+    if (type == typeid(ESM::Miscellaneous).name() || type == typeid(ESM::Weapon).name() || type == typeid(ESM::Armor).name()
+            || type == typeid(ESM::Clothing).name() || type == typeid(ESM::Book).name() || type == typeid(ESM::Ingredient).name()
+            || type == typeid(ESM::Potion).name() || type == typeid(ESM::Apparatus).name() || type == typeid(ESM::Lockpick).name()
+            || type == typeid(ESM::Probe).name() || type == typeid(ESM::Repair).name())
+        return mItemViewDistance;
+    return 0.f;
 }
 
 void Objects::insertModel(const MWWorld::Ptr &ptr, const std::string &mesh, bool animated, bool allowLight)
@@ -161,6 +285,7 @@ void Objects::insertCreature(const MWWorld::Ptr &ptr, const std::string &mesh, b
         anim.reset(new CreatureWeaponAnimation(ptr, mesh, mResourceSystem));
     else
         anim.reset(new CreatureAnimation(ptr, mesh, mResourceSystem));
+    anim->setLod(mAnimationLodDistance, mAnimationLodInterval);
 
     mObjects.insert(std::make_pair(ptr, anim.release()));
 }
@@ -171,6 +296,7 @@ void Objects::insertNPC(const MWWorld::Ptr &ptr)
     ptr.getRefData().getBaseNode()->setNodeMask(Mask_Actor);
 
     std::auto_ptr<NpcAnimation> anim (new NpcAnimation(ptr, osg::ref_ptr<osg::Group>(ptr.getRefData().getBaseNode()), mResourceSystem));
+    anim->setLod(mAnimationLodDistance, mAnimationLodInterval);
 
     mObjects.insert(std::make_pair(ptr, anim.release()));
 }
@@ -180,6 +306,8 @@ bool Objects::removeObject (const MWWorld::Ptr& ptr)
     if(!ptr.getRefData().getBaseNode())
         return true;
 
+    unmergeObject(ptr);
+
     PtrAnimationMap::iterator iter = mObjects.find(ptr);
     if(iter != mObjects.end())
     {
@@ -196,6 +324,10 @@ bool Objects::removeObject (const MWWorld::Ptr& ptr)
 
 void Objects::removeCell(const MWWorld::CellStore* store)
 {
+    MergedCellMap::iterator merged = mMergedCells.find(store);
+    if (merged != mMergedCells.end())
+        unmergeCell(merged);
+
     for(PtrAnimationMap::iterator iter = mObjects.begin();iter != mObjects.end();)
     {
         if(iter->first.getCell() == store)
@@ -210,27 +342,37 @@ void Objects::removeCell(const MWWorld::CellStore* store)
     CellMap::iterator cell = mCellSceneNodes.find(store);
     if(cell != mCellSceneNodes.end())
     {
-        cell->second->getParent(0)->removeChild(cell->second);
+        cell->second.mNode->getParent(0)->removeChild(cell->second.mNode);
         mCellSceneNodes.erase(cell);
     }
 }
 
+void Objects::updatePosition(const MWWorld::Ptr &ptr)
+{
+    SceneUtil::PositionAttitudeTransform* objectNode = ptr.getRefData().getBaseNode();
+    if (!objectNode || mCellGroupSize <= 0.f)
+        return;
+
+    osg::Group* group = getGroupNode(getCellNode(ptr.getCell()), objectNode->getPosition());
+    if (objectNode->getNumParents() && objectNode->getParent(0) == group)
+        return;
+
+    // Keep the node alive while it is between the groups
+    osg::ref_ptr<osg::Node> node (objectNode);
+    if (objectNode->getNumParents())
+        objectNode->getParent(0)->removeChild(objectNode);
+    group->addChild(objectNode);
+}
+
 void Objects::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur)
 {
     osg::Node* objectNode = cur.getRefData().getBaseNode();
     if (!objectNode)
         return;
 
-    MWWorld::CellStore *newCell = cur.getCell();
+    unmergeObject(old);
 
-    osg::Group* cellnode;
-    if(mCellSceneNodes.find(newCell) == mCellSceneNodes.end()) {
-        cellnode = new osg::Group;
-        mRootNode->addChild(cellnode);
-        mCellSceneNodes[newCell] = cellnode;
-    } else {
-        cellnode = mCellSceneNodes[newCell];
-    }
+    osg::Group* groupnode = getGroupNode(getCellNode(cur.getCell()), cur.getRefData().getBaseNode()->getPosition());
 
     osg::UserDataContainer* userDataContainer = objectNode->getUserDataContainer();
     if (userDataContainer)
@@ -240,9 +382,10 @@ void Objects::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur)
                 userDataContainer->setUserObject(i, new PtrHolder(cur));
         }
 
+    osg::ref_ptr<osg::Node> node (objectNode);
     if (objectNode->getNumParents())
         objectNode->getParent(0)->removeChild(objectNode);
-    cellnode->addChild(objectNode);
+    groupnode->addChild(objectNode);
 
     PtrAnimationMap::iterator iter = mObjects.find(old);
     if(iter != mObjects.end())
@@ -254,6 +397,152 @@ void Objects::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur)
     }
 }
 
+void Objects::setWorkQueue(SceneUtil::WorkQueue *workQueue)
+{
+    mWorkQueue = workQueue;
+}
+
+void Objects::enableInstancing(const std::string &resourcePath)
+{
+    std::ostringstream maxInstances;
+    maxInstances << SceneUtil::StaticMerger::getMaxInstancesPerDraw();
+    std::map<std::string, std::string> defineMap;
+    defineMap.insert(std::make_pair(std::string("@maxInstances"), maxInstances.str()));
+
+    osg::ref_ptr<osg::Program> program (new osg::Program);
+    program->addShader(readShader(osg::Shader::VERTEX, resourcePath + "/shaders/objects_instanced_vertex.glsl", defineMap));
+    program->addShader(readShader(osg::Shader::FRAGMENT, resourcePath + "/shaders/objects_instanced_fragment.glsl"));
+
+    mInstancingStateSet = new osg::StateSet;
+    mInstancingStateSet->setAttributeAndModes(program, osg::StateAttribute::ON);
+    mInstancingStateSet->addUniform(new osg::Uniform("diffuseMap", 0));
+
+    mMinInstances = std::max(1, Settings::Manager::getInt("instancing minimum count", "Objects"));
+}
+
+void Objects::mergeStatics(const MWWorld::CellStore *store)
+{
+    if (!mMergeStatics || mMergedCells.find(store) != mMergedCells.end())
+        return;
+
+    MergedCell merged;
+    merged.mMerger = new SceneUtil::StaticMerger(mMergeTileSize, mMinInstances);
+    merged.mMerger->setThreadSafeRefUnref(true);
+
+    for (PtrAnimationMap::iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+    {
+        const MWWorld::ConstPtr& ptr = it->first;
+        if (ptr.getCell() != store || ptr.getTypeName() != typeid(ESM::Static).name())
+            continue;
+
+        const SceneUtil::PositionAttitudeTransform* baseNode = ptr.getRefData().getBaseNode();
+        const osg::Group* objectRoot = it->second->getObjectRoot();
+        if (!baseNode || !objectRoot || !SceneUtil::StaticMerger::canMerge(*objectRoot))
+            continue;
+
+        osg::Matrix transform;
+        baseNode->computeLocalToWorldMatrix(transform, NULL);
+        merged.mMerger->add(*objectRoot, transform);
+        merged.mObjects.insert(ptr);
+    }
+
+    // Nothing to gain
+    if (merged.mObjects.size() < 2)
+        return;
+
+    if (mWorkQueue)
+        merged.mTicket = mWorkQueue->addWorkItem(new MergeStaticsItem(merged.mMerger), -1);
+
+    MergedCell& entry = mMergedCells[store] = merged;
+
+    if (!mWorkQueue)
+    {
+        entry.mMerger->merge();
+        finishMerge(store, entry);
+    }
+}
+
+void Objects::finishMerge(const MWWorld::CellStore *store, MergedCell &merged)
+{
+    merged.mTicket = NULL;
+
+    osg::Group* mergedNode = merged.mMerger->getMergedNode();
+    for (unsigned int i=0; i<mergedNode->getNumChildren(); ++i)
+    {
+        mergedNode->getChild(i)->addCullCallback(new SceneUtil::LightListCallback);
+        // The tiles hold most of the geometry of a cell, so that hidden tiles save many draws
+        if (mOcclusionQueries)
+            mergedNode->setChild(i, mOcclusionQueries->createQueryNode(mergedNode->getChild(i)));
+    }
+    mergedNode->setNodeMask(Mask_MergedStatics);
+    const std::vector<osg::ref_ptr<osg::Group> >& instanced = merged.mMerger->getInstancedGroups();
+    for (std::vector<osg::ref_ptr<osg::Group> >::const_iterator it = instanced.begin(); it != instanced.end(); ++it)
+        (*it)->setStateSet(mInstancingStateSet);
+    getCellNode(store).mNode->addChild(mergedNode);
+
+    // Still traversed by intersection tests, but not drawn by any camera
+    for (std::set<MWWorld::ConstPtr>::const_iterator it = merged.mObjects.begin(); it != merged.mObjects.end(); ++it)
+    {
+        PtrAnimationMap::iterator found = mObjects.find(*it);
+        if (found != mObjects.end() && found->second->getObjectRoot())
+            found->second->getObjectRoot()->setNodeMask(Mask_UpdateVisitor);
+    }
+}
+
+void Objects::unmergeCell(MergedCellMap::iterator it)
+{
+    MergedCell& merged = it->second;
+    if (merged.mTicket)
+    {
+        merged.mTicket->cancel();
+        mCancelled.push_back(merged.mTicket);
+    }
+    else
+    {
+        osg::Group* mergedNode = merged.mMerger->getMergedNode();
+        if (mergedNode->getNumParents())
+            mergedNode->getParent(0)->removeChild(mergedNode);
+
+        for (std::set<MWWorld::ConstPtr>::const_iterator object = merged.mObjects.begin(); object != merged.mObjects.end(); ++object)
+        {
+            PtrAnimationMap::iterator found = mObjects.find(*object);
+            if (found != mObjects.end() && found->second->getObjectRoot())
+                found->second->getObjectRoot()->setNodeMask(~0u);
+        }
+    }
+
+    mMergedCells.erase(it);
+}
+
+void Objects::unmergeObject(const MWWorld::ConstPtr &ptr)
+{
+    MergedCellMap::iterator found = mMergedCells.find(ptr.getCell());
+    if (found != mMergedCells.end() && found->second.mObjects.find(ptr) != found->second.mObjects.end())
+        unmergeCell(found);
+}
+
+void Objects::update()
+{
+    for (MergedCellMap::iterator it = mMergedCells.begin(); it != mMergedCells.end(); ++it)
+    {
+        if (it->second.mTicket && it->second.mTicket->isDone())
+            finishMerge(it->first, it->second);
+    }
+
+    for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mCancelled.begin(); it != mCancelled.end();)
+    {
+        if ((*it)->isDone())
+            it = mCancelled.erase(it);
+        else
+            ++it;
+    }
+}
+
+SceneUtil::OcclusionQueries* Objects::getOcclusionQueries()
+{
+    return mOcclusionQueries.get();
+}
+
 Animation* Objects::getAnimation(const MWWorld::Ptr &ptr)
 {
     PtrAnimationMap::const_iterator iter = mObjects.find(ptr);
@@ -3,10 +3,13 @@
 
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 #include <osg/ref_ptr>
 #include <osg/Object>
+#include <osg/Vec3f>
 
 #include "../mwworld/ptr.hpp"
 
@@ -25,6 +28,14 @@ namespace Resource
     class ResourceSystem;
 }
 
+namespace SceneUtil
+{
+    class StaticMerger;
+    class OcclusionQueries;
+    class WorkQueue;
+    class WorkTicket;
+}
+
 namespace MWWorld
 {
     class CellStore;
@@ -59,7 +70,16 @@ public:
 class Objects{
     typedef std::map<MWWorld::ConstPtr,Animation*> PtrAnimationMap;
 
-    typedef std::map<const MWWorld::CellStore*, osg::ref_ptr<osg::Group> > CellMap;
+    // The objects of a cell are grouped by the square of the grid they are in, so that the cull and intersection
+    // visitors can skip a whole square at once
+    typedef std::map<std::pair<int, int>, osg::ref_ptr<osg::Group> > GroupGrid;
+    struct CellNode
+    {
+        osg::ref_ptr<osg::Group> mNode;
+        // Empty squares are kept until the cell is removed
+        GroupGrid mGroups;
+    };
+    typedef std::map<const MWWorld::CellStore*, CellNode> CellMap;
     CellMap mCellSceneNodes;
     PtrAnimationMap mObjects;
 
@@ -67,8 +87,55 @@ class Objects{
 
     void insertBegin(const MWWorld::Ptr& ptr);
 
+    CellNode& getCellNode(const MWWorld::CellStore* store);
+
+    /// The group for an object at \a position within the cell.
+    osg::Group* getGroupNode(CellNode& cellNode, const osg::Vec3f& position);
+
+    /// The view distance of the category of the object, 0 for no limit.
+    float getViewDistance(const MWWorld::Ptr& ptr) const;
+
     Resource::ResourceSystem* mResourceSystem;
 
+    SceneUtil::WorkQueue* mWorkQueue;
+    // The size of the squares of the grid, 0 to put all objects of a cell in one group
+    float mCellGroupSize;
+    bool mMergeStatics;
+    float mMergeTileSize;
+    unsigned int mMinInstances;
+    // The animation level of detail of the actors, see SceneUtil::Skeleton::setLod
+    float mAnimationLodDistance;
+    unsigned int mAnimationLodInterval;
+    // Distances beyond which objects of these categories are not drawn, 0 for no limit
+    float mItemViewDistance;
+    float mFloraViewDistance;
+    float mActorViewDistance;
+    // Objects covering fewer pixels are not drawn, 0 for no limit
+    float mSmallFeatureSize;
+    // The shader program for instanced statics, NULL if instancing is disabled
+    osg::ref_ptr<osg::StateSet> mInstancingStateSet;
+    // For the tiles of the merged statics, NULL if occlusion culling is disabled
+    osg::ref_ptr<SceneUtil::OcclusionQueries> mOcclusionQueries;
+
+    struct MergedCell
+    {
+        // The objects hidden by the merged geometry. Kept for intersection tests, so that picking still finds their Ptr.
+        std::set<MWWorld::ConstPtr> mObjects;
+        osg::ref_ptr<SceneUtil::StaticMerger> mMerger;
+        // Not done yet
+        osg::ref_ptr<SceneUtil::WorkTicket> mTicket;
+    };
+    typedef std::map<const MWWorld::CellStore*, MergedCell> MergedCellMap;
+    MergedCellMap mMergedCells;
+
+    // Merges that were dropped before they were done, waited for by the destructor
+    std::vector<osg::ref_ptr<SceneUtil::WorkTicket> > mCancelled;
+
+    void finishMerge(const MWWorld::CellStore* store, MergedCell& merged);
+
+    /// Show the separate objects of the cell again.
+    void unmergeCell(MergedCellMap::iterator it);
+
 public:
     Objects(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> rootNode);
     ~Objects();
@@ -88,6 +155,30 @@ public:
 
     void removeCell(const MWWorld::CellStore* store);
 
+    void setWorkQueue(SceneUtil::WorkQueue* workQueue);
+
+    /// Draw static meshes that repeat often within a merged tile instanced, instead of merging them.
+    /// @param resourcePath Where to find the instancing shaders.
+    /// @note Needs GL_ARB_draw_instanced. Instanced objects are lit by the sun and the ambient light only.
+    void enableInstancing(const std::string& resourcePath);
+
+    /// Merge the geometry of the static objects of the cell, so that they are drawn with fewer draw calls.
+    /// Objects that use controllers, particles, lights or transparency are left out.
+    /// @note Call once all objects of the cell are inserted. The merged geometry is made on the work queue if there is one.
+    void mergeStatics(const MWWorld::CellStore* store);
+
+    /// Show the object separately again if it was merged, before it is changed.
+    void unmergeObject(const MWWorld::ConstPtr& ptr);
+
+    /// Attach the merged geometry that was finished on the work queue.
+    void update();
+
+    /// The occlusion queries of the merged statics, NULL if occlusion culling is disabled.
+    SceneUtil::OcclusionQueries* getOcclusionQueries();
+
+    /// Move the object to the group of its new position within the cell, call after its position changed.
+    void updatePosition(const MWWorld::Ptr& ptr);
+
     /// Updates containing cell for object rendering data
     void updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur);
 
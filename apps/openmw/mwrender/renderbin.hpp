@@ -7,6 +7,7 @@ namespace MWRender
     /// Defines the render bin numbers used in the OpenMW scene graph. The bin with the lowest number is rendered first.
     enum RenderBins
     {
+        RenderBin_Upscale = -2, // the scene texture of the DynamicResolution, in the main camera
         RenderBin_Sky = -1,
         RenderBin_Default = 0, // osg::StateSet::OPAQUE_BIN
         RenderBin_Water = 9,
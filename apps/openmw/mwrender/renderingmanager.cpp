@@ -2,6 +2,7 @@
 
 #include <stdexcept>
 #include <limits>
+#include <sstream>
 
 #include <osg/Light>
 #include <osg/LightModel>
@@ -10,6 +11,7 @@
 #include <osg/Group>
 #include <osg/UserDataContainer>
 #include <osg/ComputeBoundsVisitor>
+#include <osg/Program>
 
 #include <osgUtil/LineSegmentIntersector>
 #include <osgUtil/IncrementalCompileOperation>
@@ -22,17 +24,25 @@
 
 #include <components/settings/settings.hpp>
 
+#include <components/misc/profiler.hpp>
+
 #include <components/sceneutil/util.hpp>
 #include <components/sceneutil/lightmanager.hpp>
 #include <components/sceneutil/statesetupdater.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
+#include <components/sceneutil/riggeometry.hpp>
+#include <components/sceneutil/occlusionquery.hpp>
 
 #include <components/terrain/terraingrid.hpp>
+#include <components/terrain/quadtreeworld.hpp>
 
 #include <components/esm/loadcell.hpp>
 
+#include "../mwbase/environment.hpp"
+
 #include "../mwworld/fallback.hpp"
 #include "../mwworld/cellstore.hpp"
+#include "../mwworld/cellloadstats.hpp"
 
 #include "sky.hpp"
 #include "effectmanager.hpp"
@@ -42,6 +52,8 @@
 #include "camera.hpp"
 #include "water.hpp"
 #include "terrainstorage.hpp"
+#include "dynamicresolution.hpp"
+#include "util.hpp"
 
 namespace MWRender
 {
@@ -125,6 +137,65 @@ namespace MWRender
         bool mWireframe;
     };
 
+    /// Sets the parameters of the sun light in the update traversal. Alternates between two lights, so that a
+    /// frame that is still being drawn keeps the light it was culled with.
+    class SunLightUpdater : public osg::NodeCallback
+    {
+    public:
+        SunLightUpdater()
+            : mDiffuse(0,0,0,1)
+            , mSpecular(0,0,0,0)
+            , mPosition(0,0,1,0)
+            , mDirection(0,0,-1)
+        {
+            for (int i=0; i<2; ++i)
+            {
+                mLights[i] = new osg::Light;
+                mLights[i]->setAmbient(osg::Vec4f(0,0,0,1));
+                mLights[i]->setConstantAttenuation(1.f);
+            }
+        }
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            osg::Light* light = mLights[nv->getTraversalNumber()%2];
+            light->setDiffuse(mDiffuse);
+            light->setSpecular(mSpecular);
+            light->setPosition(mPosition);
+            light->setDirection(mDirection);
+            static_cast<osg::LightSource*>(node)->setLight(light);
+
+            traverse(node, nv);
+        }
+
+        void setDiffuse(const osg::Vec4f& diffuse)
+        {
+            mDiffuse = diffuse;
+        }
+
+        void setSpecular(const osg::Vec4f& specular)
+        {
+            mSpecular = specular;
+        }
+
+        void setPosition(const osg::Vec4f& position)
+        {
+            mPosition = position;
+        }
+
+        void setDirection(const osg::Vec3f& direction)
+        {
+            mDirection = direction;
+        }
+
+    private:
+        osg::ref_ptr<osg::Light> mLights[2];
+        osg::Vec4f mDiffuse;
+        osg::Vec4f mSpecular;
+        osg::Vec4f mPosition;
+        osg::Vec3f mDirection;
+    };
+
     RenderingManager::RenderingManager(osgViewer::Viewer* viewer, osg::ref_ptr<osg::Group> rootNode, Resource::ResourceSystem* resourceSystem,
                                        const MWWorld::Fallback* fallback, const std::string& resourcePath)
         : mViewer(viewer)
@@ -140,11 +211,14 @@ namespace MWRender
         , mFieldOfViewOverridden(false)
     {
         resourceSystem->getSceneManager()->setParticleSystemMask(MWRender::Mask_ParticleSystem);
+        resourceSystem->getSceneManager()->setBuildKdTrees(Settings::Manager::getBool("build kd trees", "Objects"));
 
         osg::ref_ptr<SceneUtil::LightManager> lightRoot = new SceneUtil::LightManager;
         lightRoot->setLightingMask(Mask_Lighting);
         mLightRoot = lightRoot;
         lightRoot->setStartLight(1);
+        if (Settings::Manager::getBool("cluster lights", "Lighting"))
+            lightRoot->setClusterGrid(16, 8, 16);
 
         mRootNode->addChild(lightRoot);
 
@@ -158,10 +232,37 @@ namespace MWRender
 
         mEffectManager.reset(new EffectManager(lightRoot, mResourceSystem));
 
-        mWater.reset(new Water(mRootNode, lightRoot, mResourceSystem, mViewer->getIncrementalCompileOperation(), fallback, resourcePath));
+        mWater.reset(new Water(mViewer, mRootNode, lightRoot, mResourceSystem, mViewer->getIncrementalCompileOperation(), fallback, resourcePath));
 
-        mTerrain.reset(new Terrain::TerrainGrid(lightRoot, mResourceSystem, mViewer->getIncrementalCompileOperation(),
-                                                new TerrainStorage(mResourceSystem->getVFS(), false), Mask_Terrain));
+        mTerrainStorage = new TerrainStorage(mResourceSystem->getVFS(), false);
+        if (Settings::Manager::getBool("distant land", "Terrain"))
+            mTerrain.reset(new Terrain::QuadTreeWorld(lightRoot, mResourceSystem, mViewer->getIncrementalCompileOperation(),
+                                                      mTerrainStorage, Mask_Terrain));
+        else
+            mTerrain.reset(new Terrain::TerrainGrid(lightRoot, mResourceSystem, mViewer->getIncrementalCompileOperation(),
+                                                    mTerrainStorage, Mask_Terrain));
+        mTerrain->setWorkQueue(MWBase::Environment::get().getWorkQueue());
+        if (Settings::Manager::getBool("shader", "Terrain"))
+        {
+            osg::ref_ptr<osg::Program> program (new osg::Program);
+            program->addShader(readShader(osg::Shader::VERTEX, resourcePath + "/shaders/terrain_vertex.glsl"));
+            program->addShader(readShader(osg::Shader::FRAGMENT, resourcePath + "/shaders/terrain_fragment.glsl"));
+            mTerrain->setShaderProgram(program);
+        }
+        mObjects->setWorkQueue(MWBase::Environment::get().getWorkQueue());
+        if (Settings::Manager::getBool("instancing", "Objects"))
+            mObjects->enableInstancing(resourcePath);
+        if (Settings::Manager::getBool("gpu skinning", "Objects"))
+        {
+            std::ostringstream maxBones;
+            maxBones << SceneUtil::RigGeometry::getMaxBones();
+            std::map<std::string, std::string> defineMap;
+            defineMap.insert(std::make_pair(std::string("@maxBones"), maxBones.str()));
+
+            osg::ref_ptr<osg::Program> program (new osg::Program);
+            program->addShader(readShader(osg::Shader::VERTEX, resourcePath + "/shaders/objects_skinned_vertex.glsl", defineMap));
+            SceneUtil::RigGeometry::setSkinningProgram(program);
+        }
 
         mCamera.reset(new Camera(mViewer->getCamera()));
 
@@ -169,12 +270,9 @@ namespace MWRender
 
         osg::ref_ptr<osg::LightSource> source = new osg::LightSource;
         source->setNodeMask(Mask_Lighting);
-        mSunLight = new osg::Light;
-        source->setLight(mSunLight);
-        mSunLight->setDiffuse(osg::Vec4f(0,0,0,1));
-        mSunLight->setAmbient(osg::Vec4f(0,0,0,1));
-        mSunLight->setSpecular(osg::Vec4f(0,0,0,0));
-        mSunLight->setConstantAttenuation(1.f);
+        mSunLight = new SunLightUpdater;
+        source->setLight(new osg::Light);
+        source->addUpdateCallback(mSunLight);
         lightRoot->addChild(source);
 
         lightRoot->getOrCreateStateSet()->setMode(GL_CULL_FACE, osg::StateAttribute::ON);
@@ -207,6 +305,7 @@ namespace MWRender
 
         mNearClip = Settings::Manager::getFloat("near clip", "Camera");
         mViewDistance = Settings::Manager::getFloat("viewing distance", "Camera");
+        mTerrain->setViewDistance(mViewDistance);
         mFieldOfView = Settings::Manager::getFloat("field of view", "Camera");
         mFirstPersonFieldOfView = Settings::Manager::getFloat("first person field of view", "Camera");
         updateProjectionMatrix();
@@ -214,6 +313,9 @@ namespace MWRender
 
         mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("near", mNearClip));
         mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("far", mViewDistance));
+
+        if (Settings::Manager::getBool("dynamic resolution", "Video") && mViewer->isRealized())
+            mDynamicResolution.reset(new DynamicResolution(mViewer, mRootNode, lightRoot));
     }
 
     RenderingManager::~RenderingManager()
@@ -230,6 +332,16 @@ namespace MWRender
         return mResourceSystem;
     }
 
+    Terrain::World* RenderingManager::getTerrain()
+    {
+        return mTerrain.get();
+    }
+
+    ESMTerrain::Storage* RenderingManager::getTerrainStorage()
+    {
+        return mTerrainStorage;
+    }
+
     osg::Group* RenderingManager::getLightRoot()
     {
         return mLightRoot.get();
@@ -280,7 +392,6 @@ namespace MWRender
 
     void RenderingManager::setSunColour(const osg::Vec4f &colour)
     {
-        // need to wrap this in a StateUpdater?
         mSunLight->setDiffuse(colour);
         mSunLight->setSpecular(colour);
     }
@@ -288,7 +399,6 @@ namespace MWRender
     void RenderingManager::setSunDirection(const osg::Vec3f &direction)
     {
         osg::Vec3 position = direction * -1;
-        // need to wrap this in a StateUpdater?
         mSunLight->setPosition(osg::Vec4(position.x(), position.y(), position.z(), 0));
 
         mSky->setSunDirection(position);
@@ -306,8 +416,13 @@ namespace MWRender
 
         mWater->changeCell(store);
 
+        // Interior and exterior cells are never loaded at the same time
+        mTerrain->setEnabled(store->getCell()->isExterior());
         if (store->getCell()->isExterior())
+        {
+            MWWorld::CellLoadStats::ScopedPhase phase (MWWorld::CellLoadStats::Phase_Terrain);
             mTerrain->loadCell(store->getCell()->getGridX(), store->getCell()->getGridY());
+        }
     }
 
     void RenderingManager::removeCell(const MWWorld::CellStore *store)
@@ -384,15 +499,23 @@ namespace MWRender
 
     void RenderingManager::update(float dt, bool paused)
     {
+        OPENMW_PROFILE_ZONE ("RenderingManager::update");
+
         if (!paused)
         {
             mEffectManager->update(dt);
             mSky->update(dt);
         }
 
+        mTerrain->update();
+        mObjects->update();
+
         mWater->update(dt);
         mCamera->update(dt, paused);
 
+        if (mDynamicResolution.get())
+            mDynamicResolution->update();
+
         osg::Vec3f focal, cameraPos;
         mCamera->getPosition(focal, cameraPos);
         mCurrentCameraPos = cameraPos;
@@ -417,6 +540,27 @@ namespace MWRender
                 mStateUpdater->setFogEnd(mViewDistance);
             }
         }
+
+        // The scene was not culled yet this frame, so the statistics are those of the previous frame
+        unsigned int frameNumber = mViewer->getFrameStamp()->getFrameNumber();
+        if (frameNumber > 0)
+        {
+            unsigned int hits, misses, cached;
+            static_cast<SceneUtil::LightManager*>(mLightRoot.get())->getStateSetCacheStats(hits, misses, cached);
+            osg::Stats* stats = mViewer->getViewerStats();
+            stats->setAttribute(frameNumber-1, "light_stateset_hits", hits);
+            stats->setAttribute(frameNumber-1, "light_stateset_misses", misses);
+            stats->setAttribute(frameNumber-1, "light_stateset_cached", cached);
+
+            if (SceneUtil::OcclusionQueries* occlusionQueries = mObjects->getOcclusionQueries())
+            {
+                unsigned int tested, drawn;
+                occlusionQueries->getStats(tested, drawn);
+                occlusionQueries->resetStats();
+                stats->setAttribute(frameNumber-1, "occlusion_tested", tested);
+                stats->setAttribute(frameNumber-1, "occlusion_culled", tested - drawn);
+            }
+        }
     }
 
     void RenderingManager::updatePlayerPtr(const MWWorld::Ptr &ptr)
@@ -440,16 +584,20 @@ namespace MWRender
             mCamera->rotateCamera(-ptr.getRefData().getPosition().rot[0], -ptr.getRefData().getPosition().rot[2], false);
         }
 
+        mObjects->unmergeObject(ptr);
         ptr.getRefData().getBaseNode()->setAttitude(rot);
     }
 
     void RenderingManager::moveObject(const MWWorld::Ptr &ptr, const osg::Vec3f &pos)
     {
+        mObjects->unmergeObject(ptr);
         ptr.getRefData().getBaseNode()->setPosition(pos);
+        mObjects->updatePosition(ptr);
     }
 
     void RenderingManager::scaleObject(const MWWorld::Ptr &ptr, const osg::Vec3f &scale)
     {
+        mObjects->unmergeObject(ptr);
         ptr.getRefData().getBaseNode()->setScale(scale);
 
         if (ptr == mCamera->getTrackingPtr()) // update height of camera
@@ -515,6 +663,10 @@ namespace MWRender
 
     void RenderingManager::screenshot(osg::Image *image, int w, int h)
     {
+        // Nothing is rendered when running headless, the image stays empty
+        if (!mViewer->isRealized())
+            return;
+
         osg::ref_ptr<osg::Camera> rttCamera (new osg::Camera);
         rttCamera->setNodeMask(Mask_RenderToTexture);
         rttCamera->attach(osg::Camera::COLOR_BUFFER, image);
@@ -635,7 +787,7 @@ namespace MWRender
     {
         osg::ref_ptr<osgUtil::IntersectionVisitor> intersectionVisitor( new osgUtil::IntersectionVisitor(intersector));
         int mask = intersectionVisitor->getTraversalMask();
-        mask &= ~(Mask_RenderToTexture|Mask_Sky|Mask_Debug|Mask_Effect|Mask_Water|Mask_SimpleWater);
+        mask &= ~(Mask_RenderToTexture|Mask_Sky|Mask_Debug|Mask_Effect|Mask_Water|Mask_SimpleWater|Mask_MergedStatics);
         if (ignorePlayer)
             mask &= ~(Mask_Player);
         if (ignoreActors)
@@ -822,6 +974,7 @@ namespace MWRender
             else if (it->first == "Camera" && it->second == "viewing distance")
             {
                 mViewDistance = Settings::Manager::getFloat("viewing distance", "Camera");
+                mTerrain->setViewDistance(mViewDistance);
                 mStateUpdater->setFogEnd(mViewDistance);
                 updateProjectionMatrix();
             }
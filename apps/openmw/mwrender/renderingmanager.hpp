@@ -37,6 +37,11 @@ namespace Terrain
     class World;
 }
 
+namespace ESMTerrain
+{
+    class Storage;
+}
+
 namespace MWWorld
 {
     class Fallback;
@@ -46,6 +51,7 @@ namespace MWRender
 {
 
     class StateUpdater;
+    class SunLightUpdater;
 
     class EffectManager;
     class SkyManager;
@@ -53,6 +59,8 @@ namespace MWRender
     class Pathgrid;
     class Camera;
     class Water;
+    class TerrainStorage;
+    class DynamicResolution;
 
     class RenderingManager : public MWRender::RenderingInterface
     {
@@ -65,6 +73,11 @@ namespace MWRender
 
         Resource::ResourceSystem* getResourceSystem();
 
+        Terrain::World* getTerrain();
+
+        /// The storage of the terrain, which also provides the decoded land data for physics.
+        ESMTerrain::Storage* getTerrainStorage();
+
         osg::Group* getLightRoot();
 
         void setNightEyeFactor(float factor);
@@ -186,17 +199,20 @@ namespace MWRender
         osg::ref_ptr<osg::Group> mLightRoot;
         Resource::ResourceSystem* mResourceSystem;
 
-        osg::ref_ptr<osg::Light> mSunLight;
+        osg::ref_ptr<SunLightUpdater> mSunLight;
 
         std::auto_ptr<Pathgrid> mPathgrid;
         std::auto_ptr<Objects> mObjects;
         std::auto_ptr<Water> mWater;
         std::auto_ptr<Terrain::World> mTerrain;
+        // Owned by mTerrain
+        TerrainStorage* mTerrainStorage;
         std::auto_ptr<SkyManager> mSky;
         std::auto_ptr<EffectManager> mEffectManager;
         std::auto_ptr<NpcAnimation> mPlayerAnimation;
         osg::ref_ptr<SceneUtil::PositionAttitudeTransform> mPlayerNode;
         std::auto_ptr<Camera> mCamera;
+        std::auto_ptr<DynamicResolution> mDynamicResolution;
         osg::Vec3f mCurrentCameraPos;
 
         osg::ref_ptr<StateUpdater> mStateUpdater;
@@ -1,6 +1,9 @@
 #include "ripplesimulation.hpp"
 
 #include <iomanip>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
 
 #include <osg/PolygonOffset>
 #include <osg/Geode>
@@ -8,6 +11,10 @@
 #include <osg/Material>
 #include <osg/Depth>
 #include <osg/PositionAttitudeTransform>
+#include <osg/Camera>
+#include <osg/Geometry>
+#include <osg/Program>
+#include <osg/Uniform>
 #include <osgParticle/ParticleSystem>
 #include <osgParticle/ParticleSystemUpdater>
 
@@ -17,6 +24,7 @@
 #include <components/resource/resourcesystem.hpp>
 
 #include "vismask.hpp"
+#include "util.hpp"
 
 #include "../mwbase/world.hpp"
 #include "../mwbase/environment.hpp"
@@ -73,13 +81,193 @@ namespace
 
         node->setStateSet(stateset);
     }
+
+    // The ripple map has sMapSize x sMapSize texels, each covering sTexelSize world units
+    const int sMapSize = 512;
+    const float sTexelSize = 8.f;
+    // Two steps every sStepInterval seconds
+    const float sStepInterval = 1.f/30.f;
+    const int sMaxRipplesPerStep = 16;
+    const float sRippleRadius = 24.f;
+    const float sRippleStrength = 0.5f;
+
+    osg::ref_ptr<osg::Texture2D> createRippleTexture()
+    {
+        osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D);
+        texture->setTextureSize(sMapSize, sMapSize);
+        texture->setInternalFormat(GL_RGBA16F_ARB);
+        texture->setSourceFormat(GL_RGBA);
+        texture->setSourceType(GL_FLOAT);
+        // Outside of the map the water is calm
+        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_BORDER);
+        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_BORDER);
+        texture->setBorderColor(osg::Vec4d(0,0,0,0));
+        texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+        texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        return texture;
+    }
 }
 
 namespace MWRender
 {
 
+RippleMap::RippleMap(osg::Group *parent, const std::string &resourcePath)
+    : mParent(parent)
+    , mOriginX(0)
+    , mOriginY(0)
+    , mOffsetX(0)
+    , mOffsetY(0)
+    , mTimeSinceStep(0.f)
+    , mCleared(true)
+{
+    std::map<std::string, std::string> defineMap;
+    std::ostringstream maxRipples;
+    maxRipples << sMaxRipplesPerStep;
+    defineMap["@max_ripples"] = maxRipples.str();
+
+    osg::ref_ptr<osg::Program> program (new osg::Program);
+    program->addShader(readShader(osg::Shader::VERTEX, resourcePath + "/shaders/ripples_vertex.glsl"));
+    program->addShader(readShader(osg::Shader::FRAGMENT, resourcePath + "/shaders/ripples_fragment.glsl", defineMap));
+
+    osg::ref_ptr<osg::Geode> geode (new osg::Geode);
+    geode->addDrawable(osg::createTexturedQuadGeometry(osg::Vec3f(0,0,0), osg::Vec3f(1,0,0), osg::Vec3f(0,1,0)));
+
+    mTextures[0] = createRippleTexture();
+    mTextures[1] = createRippleTexture();
+
+    // Only the first step moves the heightfield and adds the new ripples
+    mOffsetUniform = new osg::Uniform("offset", osg::Vec2f(0,0));
+    mRipplesUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC4, "ripples", sMaxRipplesPerStep);
+    mNumRipplesUniform = new osg::Uniform("numRipples", 0);
+
+    for (int i=0; i<2; ++i)
+    {
+        osg::ref_ptr<osg::Camera> camera (new osg::Camera);
+        camera->setRenderOrder(osg::Camera::PRE_RENDER, i);
+        camera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
+        camera->setReferenceFrame(osg::Camera::ABSOLUTE_RF);
+        camera->setProjectionMatrixAsOrtho2D(0, 1, 0, 1);
+        camera->setViewMatrix(osg::Matrix::identity());
+        camera->setComputeNearFarMode(osg::Camera::DO_NOT_COMPUTE_NEAR_FAR);
+        camera->setViewport(0, 0, sMapSize, sMapSize);
+        // The quad covers the whole texture
+        camera->setClearMask(0);
+        camera->attach(osg::Camera::COLOR_BUFFER, mTextures[1-i]);
+        camera->setNodeMask(0);
+        camera->addChild(geode);
+
+        osg::StateSet* stateset = camera->getOrCreateStateSet();
+        stateset->setAttributeAndModes(program, osg::StateAttribute::ON);
+        stateset->setTextureAttributeAndModes(0, mTextures[i], osg::StateAttribute::ON);
+        stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+        stateset->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+        stateset->setMode(GL_BLEND, osg::StateAttribute::OFF);
+        stateset->setMode(GL_FOG, osg::StateAttribute::OFF|osg::StateAttribute::OVERRIDE);
+        stateset->addUniform(new osg::Uniform("heightMap", 0));
+        stateset->addUniform(new osg::Uniform("texelSize", 1.f/sMapSize));
+        if (i == 0)
+        {
+            // The uniforms change every step
+            stateset->setDataVariance(osg::Object::DYNAMIC);
+            stateset->addUniform(mOffsetUniform);
+            stateset->addUniform(mRipplesUniform);
+            stateset->addUniform(mNumRipplesUniform);
+        }
+        else
+        {
+            stateset->addUniform(new osg::Uniform("offset", osg::Vec2f(0,0)));
+            stateset->addUniform(new osg::Uniform("numRipples", 0));
+        }
+
+        mCameras[i] = camera;
+        mParent->addChild(camera);
+    }
+}
+
+RippleMap::~RippleMap()
+{
+    for (int i=0; i<2; ++i)
+        mParent->removeChild(mCameras[i]);
+}
+
+void RippleMap::addRipple(const osg::Vec2f &pos)
+{
+    if (mRipples.size() < static_cast<unsigned int>(sMaxRipplesPerStep))
+        mRipples.push_back(pos);
+}
+
+void RippleMap::update(float dt, const osg::Vec2f &center)
+{
+    // Move along in whole texels, so that the heightfield does not blur
+    int originX = static_cast<int>(std::floor(center.x() / sTexelSize)) - sMapSize/2;
+    int originY = static_cast<int>(std::floor(center.y() / sTexelSize)) - sMapSize/2;
+    mOffsetX += originX - mOriginX;
+    mOffsetY += originY - mOriginY;
+    mOriginX = originX;
+    mOriginY = originY;
+
+    mTimeSinceStep += dt;
+    bool step = mTimeSinceStep >= sStepInterval;
+    if (step)
+    {
+        // Don't try to catch up after a long frame
+        mTimeSinceStep = std::min(mTimeSinceStep - sStepInterval, sStepInterval);
+
+        // Reading from outside of the texture gives calm water
+        if (mCleared)
+            mOffsetUniform->set(osg::Vec2f(2.f, 2.f));
+        else
+            mOffsetUniform->set(osg::Vec2f(mOffsetX, mOffsetY) / sMapSize);
+
+        const float mapSize = sMapSize * sTexelSize;
+        for (unsigned int i=0; i<mRipples.size(); ++i)
+        {
+            osg::Vec2f coord = (mRipples[i] - osg::Vec2f(mOriginX, mOriginY) * sTexelSize) / mapSize;
+            mRipplesUniform->setElement(i, osg::Vec4f(coord.x(), coord.y(), sRippleRadius / mapSize, sRippleStrength));
+        }
+        mNumRipplesUniform->set(static_cast<int>(mRipples.size()));
+
+        mRipples.clear();
+        mOffsetX = 0;
+        mOffsetY = 0;
+        mCleared = false;
+    }
+
+    for (int i=0; i<2; ++i)
+        mCameras[i]->setNodeMask(step ? Mask_RenderToTexture : 0);
+}
+
+osg::Texture2D* RippleMap::getTexture()
+{
+    // The second step writes to the first texture
+    return mTextures[0];
+}
+
+osg::Vec2f RippleMap::getOrigin() const
+{
+    // The heightfield was last stepped at this origin
+    return osg::Vec2f(mOriginX - mOffsetX, mOriginY - mOffsetY) * sTexelSize;
+}
+
+float RippleMap::getSize() const
+{
+    return sMapSize * sTexelSize;
+}
+
+float RippleMap::getTexelSize() const
+{
+    return 1.f / sMapSize;
+}
+
+void RippleMap::clear()
+{
+    mCleared = true;
+    mRipples.clear();
+}
+
 RippleSimulation::RippleSimulation(osg::Group *parent, Resource::ResourceSystem* resourceSystem, const MWWorld::Fallback* fallback)
     : mParent(parent)
+    , mRippleMap(NULL)
 {
     osg::ref_ptr<osg::Geode> geode (new osg::Geode);
 
@@ -137,12 +325,18 @@ void RippleSimulation::update(float dt)
 
             currentPos.z() = mParticleNode->getPosition().z();
 
-            if (mParticleSystem->numParticles()-mParticleSystem->numDeadParticles() > 500)
+            if (!mRippleMap && mParticleSystem->numParticles()-mParticleSystem->numDeadParticles() > 500)
                 continue; // TODO: remove the oldest particle to make room?
 
             emitRipple(currentPos);
         }
     }
+
+    if (mRippleMap)
+    {
+        osg::Vec3f playerPos (MWBase::Environment::get().getWorld()->getPlayerPtr().getRefData().getPosition().asVec3());
+        mRippleMap->update(dt, osg::Vec2f(playerPos.x(), playerPos.y()));
+    }
 }
 
 
@@ -197,12 +391,26 @@ void RippleSimulation::emitRipple(const osg::Vec3f &pos)
 {
     if (std::abs(pos.z() - mParticleNode->getPosition().z()) < 20)
     {
+        if (mRippleMap)
+        {
+            mRippleMap->addRipple(osg::Vec2f(pos.x(), pos.y()));
+            return;
+        }
+
         osgParticle::Particle* p = mParticleSystem->createParticle(NULL);
         p->setPosition(osg::Vec3f(pos.x(), pos.y(), 0.f));
         p->setAngle(osg::Vec3f(0,0, Misc::Rng::rollProbability() * osg::PI * 2 - osg::PI));
     }
 }
 
+void RippleSimulation::setRippleMap(RippleMap *rippleMap)
+{
+    mRippleMap = rippleMap;
+    if (mRippleMap)
+        clear();
+    mParticleNode->setNodeMask(mRippleMap ? 0 : Mask_Effect);
+}
+
 void RippleSimulation::setWaterHeight(float height)
 {
     mParticleNode->setPosition(osg::Vec3f(0,0,height));
@@ -212,6 +420,9 @@ void RippleSimulation::clear()
 {
     for (int i=0; i<mParticleSystem->numParticles(); ++i)
         mParticleSystem->destroyParticle(i);
+
+    if (mRippleMap)
+        mRippleMap->clear();
 }
 
 
@@ -1,7 +1,11 @@
 #ifndef OPENMW_MWRENDER_RIPPLESIMULATION_H
 #define OPENMW_MWRENDER_RIPPLESIMULATION_H
 
+#include <string>
+#include <vector>
+
 #include <osg/ref_ptr>
+#include <osg/Vec2f>
 
 #include "../mwworld/ptr.hpp"
 
@@ -9,6 +13,9 @@ namespace osg
 {
     class Group;
     class PositionAttitudeTransform;
+    class Camera;
+    class Texture2D;
+    class Uniform;
 }
 
 namespace osgParticle
@@ -37,6 +44,60 @@ namespace MWRender
         float mForce;
     };
 
+    /// @brief Simulates ripples as a heightfield on the GPU, for the water shader.
+    /// @par The heightfield covers a square area around the player, and moves along with the player in steps of
+    /// whole texels. Two cameras rendering to a pair of textures advance it by two steps of a damped wave equation, at
+    /// a fixed rate. New ripples are added to the first step, so their cost does not grow with the number of ripples
+    /// on the water.
+    /// @see files/shaders/ripples_fragment.glsl
+    class RippleMap
+    {
+    public:
+        RippleMap(osg::Group* parent, const std::string& resourcePath);
+        ~RippleMap();
+
+        /// Add a ripple centered on the given world position to the next step.
+        void addRipple(const osg::Vec2f& pos);
+
+        /// @param center The world position to center the heightfield on.
+        void update(float dt, const osg::Vec2f& center);
+
+        /// The heightfield for the water shader, in the red channel.
+        osg::Texture2D* getTexture();
+
+        /// The world position of the lower left corner of the heightfield, and its size.
+        osg::Vec2f getOrigin() const;
+        float getSize() const;
+        float getTexelSize() const;
+
+        /// Calm the water, does not take effect before the next step.
+        void clear();
+
+    private:
+        osg::ref_ptr<osg::Group> mParent;
+
+        osg::ref_ptr<osg::Texture2D> mTextures[2];
+        // mCameras[i] steps from mTextures[i] to mTextures[1-i]
+        osg::ref_ptr<osg::Camera> mCameras[2];
+
+        osg::ref_ptr<osg::Uniform> mOffsetUniform;
+        osg::ref_ptr<osg::Uniform> mRipplesUniform;
+        osg::ref_ptr<osg::Uniform> mNumRipplesUniform;
+
+        // In texels
+        int mOriginX;
+        int mOriginY;
+        // In texels, how far the heightfield moved since the last step
+        int mOffsetX;
+        int mOffsetY;
+
+        // World positions of the ripples to add to the next step
+        std::vector<osg::Vec2f> mRipples;
+
+        float mTimeSinceStep;
+        bool mCleared;
+    };
+
     class RippleSimulation
     {
     public:
@@ -54,6 +115,10 @@ namespace MWRender
 
         void emitRipple(const osg::Vec3f& pos);
 
+        /// Add the ripples to the given heightfield instead of emitting ripple particles, or go back to
+        /// particles for NULL.
+        void setRippleMap(RippleMap* rippleMap);
+
         /// Change the height of the water surface, thus moving all ripples with it
         void setWaterHeight(float height);
 
@@ -67,6 +132,8 @@ namespace MWRender
         osg::ref_ptr<osg::PositionAttitudeTransform> mParticleNode;
 
         std::vector<Emitter> mEmitters;
+
+        RippleMap* mRippleMap;
     };
 
 }
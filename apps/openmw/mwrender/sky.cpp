@@ -18,12 +18,7 @@
 #include <osg/BlendFunc>
 #include <osg/AlphaFunc>
 
-#include <osgParticle/ParticleSystem>
-#include <osgParticle/ParticleSystemUpdater>
-#include <osgParticle/ModularEmitter>
-#include <osgParticle/BoxPlacer>
-#include <osgParticle/ConstantRateCounter>
-#include <osgParticle/RadialShooter>
+#include <OpenThreads/ScopedLock>
 
 #include <components/misc/rng.hpp>
 
@@ -110,9 +105,18 @@ namespace MWRender
 class AtmosphereUpdater : public SceneUtil::StateSetUpdater
 {
 public:
+    AtmosphereUpdater()
+    {
+        setApplyOnChangeOnly(true);
+    }
+
     void setEmissionColor(const osg::Vec4f& emissionColor)
     {
-        mEmissionColor = emissionColor;
+        if (emissionColor != mEmissionColor)
+        {
+            mEmissionColor = emissionColor;
+            dirty();
+        }
     }
 
 protected:
@@ -138,11 +142,17 @@ public:
     {
         // we just need a texture, its contents don't really matter
         mTexture = textureManager->getWarningTexture();
+
+        setApplyOnChangeOnly(true);
     }
 
     void setFade(const float fade)
     {
-        mColor.a() = fade;
+        if (fade != mColor.a())
+        {
+            mColor.a() = fade;
+            dirty();
+        }
     }
 
 protected:
@@ -177,24 +187,38 @@ public:
         : mAnimationTimer(0.f)
         , mOpacity(0.f)
     {
+        setApplyOnChangeOnly(true);
     }
 
     void setAnimationTimer(float timer)
     {
-        mAnimationTimer = timer;
+        if (timer != mAnimationTimer)
+        {
+            mAnimationTimer = timer;
+            dirty();
+        }
     }
 
     void setTexture(osg::ref_ptr<osg::Texture2D> texture)
     {
         mTexture = texture;
+        dirty();
     }
     void setEmissionColor(const osg::Vec4f& emissionColor)
     {
-        mEmissionColor = emissionColor;
+        if (emissionColor != mEmissionColor)
+        {
+            mEmissionColor = emissionColor;
+            dirty();
+        }
     }
     void setOpacity(float opacity)
     {
-        mOpacity = opacity;
+        if (opacity != mOpacity)
+        {
+            mOpacity = opacity;
+            dirty();
+        }
     }
 
 protected:
@@ -264,18 +288,8 @@ public:
 
     META_Node(MWRender, CameraRelativeTransform)
 
-    const osg::Vec3f& getLastEyePoint() const
-    {
-        return mEyePoint;
-    }
-
     virtual bool computeLocalToWorldMatrix(osg::Matrix& matrix, osg::NodeVisitor* nv) const
     {
-        if (nv->getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
-        {
-            mEyePoint = static_cast<osgUtil::CullVisitor*>(nv)->getEyePoint();
-        }
-
         if (_referenceFrame==RELATIVE_RF)
         {
             matrix.setTrans(osg::Vec3f(0.f,0.f,0.f));
@@ -334,9 +348,6 @@ public:
             cv->getCurrentCullingSet().popCurrentMask();
         }
     };
-private:
-    // eyePoint for the current frame
-    mutable osg::Vec3f mEyePoint;
 };
 
 class ModVertexAlphaVisitor : public osg::NodeVisitor
@@ -391,21 +402,21 @@ private:
 
 /// @brief Hides the node subgraph if the eye point is below water.
 /// @note Must be added as cull callback.
-/// @note Meant to be used on a node that is child of a CameraRelativeTransform.
-/// The current eye point must be retrieved by the CameraRelativeTransform since we can't get it anymore once we are in camera-relative space.
+/// @note Meant to be used on a node that is child of a CameraRelativeTransform. The eye point of the CullVisitor is
+/// camera-relative there, so it is taken from the view matrix of the camera instead.
 class UnderwaterSwitchCallback : public osg::NodeCallback
 {
 public:
-    UnderwaterSwitchCallback(CameraRelativeTransform* cameraRelativeTransform)
-        : mCameraRelativeTransform(cameraRelativeTransform)
-        , mEnabled(true)
+    UnderwaterSwitchCallback()
+        : mEnabled(true)
         , mWaterLevel(0.f)
     {
     }
 
     virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
     {
-        osg::Vec3f eyePoint = mCameraRelativeTransform->getLastEyePoint();
+        osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+        osg::Vec3f eyePoint = osg::Matrix::inverse(*cv->getCurrentRenderStage()->getInitialViewMatrix()).getTrans();
 
         if (mEnabled && eyePoint.z() < mWaterLevel)
             return;
@@ -423,7 +434,6 @@ public:
     }
 
 private:
-    osg::ref_ptr<CameraRelativeTransform> mCameraRelativeTransform;
     bool mEnabled;
     float mWaterLevel;
 };
@@ -506,14 +516,14 @@ public:
 
     void setColor(const osg::Vec4f& color)
     {
-        mUpdater->mColor.r() = color.r();
-        mUpdater->mColor.g() = color.g();
-        mUpdater->mColor.b() = color.b();
+        mUpdater->setColor(osg::Vec4f(color.r(), color.g(), color.b(), mUpdater->getColor().a()));
     }
 
     virtual void adjustTransparency(const float ratio)
     {
-        mUpdater->mColor.a() = ratio;
+        osg::Vec4f color = mUpdater->getColor();
+        color.a() = ratio;
+        mUpdater->setColor(color);
         if (mSunGlareCallback)
             mSunGlareCallback->setGlareView(ratio);
         if (mSunFlashCallback)
@@ -682,11 +692,24 @@ private:
     class Updater : public SceneUtil::StateSetUpdater
     {
     public:
-        osg::Vec4f mColor;
-
         Updater()
             : mColor(1.f, 1.f, 1.f, 1.f)
         {
+            setApplyOnChangeOnly(true);
+        }
+
+        void setColor(const osg::Vec4f& color)
+        {
+            if (color != mColor)
+            {
+                mColor = color;
+                dirty();
+            }
+        }
+
+        const osg::Vec4f& getColor() const
+        {
+            return mColor;
         }
 
         virtual void setDefaults(osg::StateSet* stateset)
@@ -700,6 +723,9 @@ private:
             mat->setDiffuse(osg::Material::FRONT_AND_BACK, osg::Vec4f(0,0,0,mColor.a()));
             mat->setEmission(osg::Material::FRONT_AND_BACK, osg::Vec4f(mColor.r(), mColor.g(), mColor.b(), 1));
         }
+
+    private:
+        osg::Vec4f mColor;
     };
 
     class OcclusionCallback : public osg::NodeCallback
@@ -723,6 +749,8 @@ private:
 
             float dt = MWBase::Environment::get().getFrameDuration();
 
+            // Different cameras may be culled in parallel
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
             float lastRatio = mLastRatio[osg::observer_ptr<osg::Camera>(camera)];
 
             float change = dt*10;
@@ -742,6 +770,7 @@ private:
         osg::ref_ptr<osg::OcclusionQueryNode> mOcclusionQueryTotalPixels;
 
         std::map<osg::observer_ptr<osg::Camera>, float> mLastRatio;
+        OpenThreads::Mutex mMutex;
     };
 
     /// SunFlashCallback handles fading/scaling of a node depending on occlusion query result. Must be attached as a cull callback.
@@ -931,6 +960,7 @@ public:
         : CelestialBody(parentNode, scaleFactor, 2)
         , mType(type)
         , mPhase(MoonState::Phase_Unspecified)
+        , mAlpha(1.f)
         , mUpdater(new Updater(textureManager))
     {
         setPhase(MoonState::Phase_Full);
@@ -946,7 +976,7 @@ public:
 
     virtual void adjustTransparency(const float ratio)
     {
-        mUpdater->mTransparency *= ratio;
+        mUpdater->setTransparency(mAlpha * ratio);
     }
 
     void setState(const MoonState& state)
@@ -966,18 +996,20 @@ public:
         mTransform->setAttitude(attX * rotZ);
 
         setPhase(state.mPhase);
-        mUpdater->mTransparency = state.mMoonAlpha;
-        mUpdater->mShadowBlend = state.mShadowBlend;
+        // The weather fades the moon further, see adjustTransparency()
+        mAlpha = state.mMoonAlpha;
+        mUpdater->setTransparency(mAlpha);
+        mUpdater->setShadowBlend(state.mShadowBlend);
     }
 
     void setAtmosphereColor(const osg::Vec4f& color)
     {
-        mUpdater->mAtmosphereColor = color;
+        mUpdater->setAtmosphereColor(color);
     }
 
     void setColor(const osg::Vec4f& color)
     {
-        mUpdater->mMoonColor = color;
+        mUpdater->setMoonColor(color);
     }
 
     unsigned int getPhaseInt() const
@@ -1013,6 +1045,43 @@ private:
             , mAtmosphereColor(1.0f, 1.0f, 1.0f, 1.0f)
             , mMoonColor(1.0f, 1.0f, 1.0f, 1.0f)
         {
+            setApplyOnChangeOnly(true);
+        }
+
+        void setTransparency(float transparency)
+        {
+            if (transparency != mTransparency)
+            {
+                mTransparency = transparency;
+                dirty();
+            }
+        }
+
+        void setShadowBlend(float shadowBlend)
+        {
+            if (shadowBlend != mShadowBlend)
+            {
+                mShadowBlend = shadowBlend;
+                dirty();
+            }
+        }
+
+        void setAtmosphereColor(const osg::Vec4f& color)
+        {
+            if (color != mAtmosphereColor)
+            {
+                mAtmosphereColor = color;
+                dirty();
+            }
+        }
+
+        void setMoonColor(const osg::Vec4f& color)
+        {
+            if (color != mMoonColor)
+            {
+                mMoonColor = color;
+                dirty();
+            }
         }
 
         virtual void setDefaults(osg::StateSet* stateset)
@@ -1059,6 +1128,7 @@ private:
 
     Type mType;
     MoonState::Phase mPhase;
+    float mAlpha;
     osg::ref_ptr<Updater> mUpdater;
 
     void setPhase(const MoonState::Phase& phase)
@@ -1130,7 +1200,7 @@ SkyManager::SkyManager(osg::Group* parentNode, Resource::SceneManager* sceneMana
     mEarlyRenderBinRoot->getOrCreateStateSet()->setMode(GL_CLIP_PLANE0, osg::StateAttribute::OFF);
     mRootNode->addChild(mEarlyRenderBinRoot);
 
-    mUnderwaterSwitch = new UnderwaterSwitchCallback(skyroot);
+    mUnderwaterSwitch = new UnderwaterSwitchCallback;
 }
 
 void SkyManager::create()
@@ -1192,42 +1262,159 @@ void SkyManager::create()
     mCreated = true;
 }
 
-class RainShooter : public osgParticle::Shooter
+/// Rain drops falling through a fixed volume around the camera. A drop that reaches the end of its life
+/// starts again at the top of the volume, so the number of drops and the cost of a frame are constant and
+/// nothing is allocated after the creation.
+/// @par The drops are one Geometry, updated in place each frame and drawn with a single call. Two of them
+/// are alternated by frame number, so one can be updated while the other is drawn.
+class RainDrops : public osg::Group
 {
 public:
-    RainShooter()
-        : mAngle(0.f)
-    {
-    }
+    RainDrops(unsigned int numDrops, float lifeTime)
+        : mLifeTime(lifeTime)
+        , mAngle(0.f)
+        , mLastTime(-1.0)
+        , mDrops(numDrops)
+    {
+        // Start the drops one after another, at a constant rate. Until then, their age is negative.
+        for (unsigned int i=0; i<mDrops.size(); ++i)
+            mDrops[i].mAge = -mLifeTime * (i+1) / mDrops.size();
+
+        osg::ref_ptr<osg::Vec2Array> texCoords (new osg::Vec2Array);
+        texCoords->reserve(mDrops.size() * 4);
+        for (unsigned int i=0; i<mDrops.size(); ++i)
+        {
+            texCoords->push_back(osg::Vec2f(0,0));
+            texCoords->push_back(osg::Vec2f(1,0));
+            texCoords->push_back(osg::Vec2f(1,1));
+            texCoords->push_back(osg::Vec2f(0,1));
+        }
 
-    virtual void shoot(osgParticle::Particle* particle) const
-    {
-        particle->setVelocity(mVelocity);
-        particle->setAngle(osg::Vec3f(-mAngle, 0, (Misc::Rng::rollProbability() * 2 - 1) * osg::PI));
+        for (int i=0; i<2; ++i)
+        {
+            osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry);
+            geometry->setVertexArray(new osg::Vec3Array(mDrops.size() * 4));
+            geometry->setTexCoordArray(0, texCoords, osg::Array::BIND_PER_VERTEX);
+            geometry->addPrimitiveSet(new osg::DrawArrays(GL_QUADS, 0, mDrops.size() * 4));
+            geometry->setUseDisplayList(false);
+            geometry->setUseVertexBufferObjects(true);
+            // The drops are always around the camera
+            geometry->setCullingActive(false);
+
+            osg::ref_ptr<osg::Geode> geode (new osg::Geode);
+            geode->addDrawable(geometry);
+            geode->setCullingActive(false);
+            addChild(geode);
+
+            mGeometry[i] = geometry;
+        }
+
+        setCullingActive(false);
+        setNumChildrenRequiringUpdateTraversal(getNumChildrenRequiringUpdateTraversal()+1);
     }
 
+    /// For the drops that start from now on.
     void setVelocity(const osg::Vec3f& velocity)
     {
         mVelocity = velocity;
     }
 
+    /// Tilt of the drops that start from now on, in radians.
     void setAngle(float angle)
     {
         mAngle = angle;
     }
 
-    virtual osg::Object* cloneType() const
+    virtual void traverse(osg::NodeVisitor& nv)
     {
-        return new RainShooter;
+        if (nv.getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR)
+        {
+            const osg::FrameStamp* frameStamp = nv.getFrameStamp();
+            double time = frameStamp->getSimulationTime();
+            float dt = mLastTime < 0 ? 0.f : static_cast<float>(time - mLastTime);
+            mLastTime = time;
+
+            update(dt, *mGeometry[frameStamp->getFrameNumber() % 2]);
+        }
+        else if (nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
+            getChild(nv.getFrameStamp()->getFrameNumber() % 2)->accept(nv);
+        else
+            osg::Group::traverse(nv);
     }
-    virtual osg::Object* clone(const osg::CopyOp &) const
+
+private:
+    struct Drop
+    {
+        osg::Vec3f mPosition;
+        osg::Vec3f mVelocity;
+        // The edges of the quad for a size of 1
+        osg::Vec3f mAxisX;
+        osg::Vec3f mAxisY;
+        float mAge;
+    };
+
+    void spawn(Drop& drop, float age)
     {
-        return new RainShooter(*this);
+        // Rain_Diameter
+        drop.mPosition = osg::Vec3f((Misc::Rng::rollProbability() * 2 - 1) * 300,
+                                    (Misc::Rng::rollProbability() * 2 - 1) * 300, 300);
+        drop.mVelocity = mVelocity;
+        drop.mAge = 0.f;
+
+        osg::Matrixf rotation (osg::Matrixf::rotate(-mAngle, osg::Vec3f(1,0,0), 0, osg::Vec3f(0,1,0),
+                                                    (Misc::Rng::rollProbability() * 2 - 1) * osg::PI, osg::Vec3f(0,0,1)));
+        drop.mAxisX = rotation.preMult(osg::Vec3f(0.1f,0,0));
+        drop.mAxisY = rotation.preMult(osg::Vec3f(0,0,-1));
+
+        advance(drop, age);
     }
 
-private:
+    void advance(Drop& drop, float dt)
+    {
+        drop.mPosition += drop.mVelocity * dt;
+        drop.mAge += dt;
+    }
+
+    void update(float dt, osg::Geometry& geometry)
+    {
+        osg::Vec3Array* vertices = static_cast<osg::Vec3Array*>(geometry.getVertexArray());
+
+        for (unsigned int i=0; i<mDrops.size(); ++i)
+        {
+            Drop& drop = mDrops[i];
+            if (drop.mAge < 0.f)
+            {
+                drop.mAge += dt;
+                if (drop.mAge < 0.f)
+                    continue; // not started yet, the vertices are still all 0
+                spawn(drop, drop.mAge);
+            }
+            else if (drop.mAge + dt >= mLifeTime)
+                spawn(drop, drop.mAge + dt - mLifeTime);
+            else
+                advance(drop, dt);
+
+            // The drops grow from 5 to 15 over their life
+            float size = 5.f + 10.f * drop.mAge / mLifeTime;
+            osg::Vec3f x = drop.mAxisX * size;
+            osg::Vec3f y = drop.mAxisY * size;
+
+            (*vertices)[i*4] = drop.mPosition - x - y;
+            (*vertices)[i*4+1] = drop.mPosition + x - y;
+            (*vertices)[i*4+2] = drop.mPosition + x + y;
+            (*vertices)[i*4+3] = drop.mPosition - x + y;
+        }
+
+        vertices->dirty();
+    }
+
+    float mLifeTime;
     osg::Vec3f mVelocity;
     float mAngle;
+    double mLastTime;
+
+    std::vector<Drop> mDrops;
+    osg::ref_ptr<osg::Geometry> mGeometry[2];
 };
 
 // Updater for alpha value on a node's StateSet. Assumes the node has an existing Material StateAttribute.
@@ -1237,11 +1424,16 @@ public:
     AlphaFader()
         : mAlpha(1.f)
     {
+        setApplyOnChangeOnly(true);
     }
 
     void setAlpha(float alpha)
     {
-        mAlpha = alpha;
+        if (alpha != mAlpha)
+        {
+            mAlpha = alpha;
+            dirty();
+        }
     }
 
     virtual void setDefaults(osg::StateSet* stateset)
@@ -1331,12 +1523,10 @@ void SkyManager::createRain()
 
     mRainNode = new osg::Group;
 
-    mRainParticleSystem = new osgParticle::ParticleSystem;
-    mRainParticleSystem->setParticleAlignment(osgParticle::ParticleSystem::FIXED);
-    mRainParticleSystem->setAlignVectorX(osg::Vec3f(0.1,0,0));
-    mRainParticleSystem->setAlignVectorY(osg::Vec3f(0,0,-1));
+    // 600 drops per second that fall for 1 second
+    mRainDrops = new RainDrops(600, 1.f);
 
-    osg::ref_ptr<osg::StateSet> stateset (mRainParticleSystem->getOrCreateStateSet());
+    osg::ref_ptr<osg::StateSet> stateset (mRainDrops->getOrCreateStateSet());
     stateset->setTextureAttributeAndModes(0, mSceneManager->getTextureManager()->getTexture2D("textures/tx_raindrop_01.dds",
         osg::Texture::CLAMP, osg::Texture::CLAMP), osg::StateAttribute::ON);
     stateset->setNestRenderBins(false);
@@ -1344,37 +1534,7 @@ void SkyManager::createRain()
     stateset->setMode(GL_CULL_FACE, osg::StateAttribute::OFF);
     stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
 
-    osgParticle::Particle& particleTemplate = mRainParticleSystem->getDefaultParticleTemplate();
-    particleTemplate.setSizeRange(osgParticle::rangef(5.f, 15.f));
-    particleTemplate.setAlphaRange(osgParticle::rangef(1.f, 1.f));
-    particleTemplate.setLifeTime(1);
-
-    osg::ref_ptr<osgParticle::ModularEmitter> emitter (new osgParticle::ModularEmitter);
-    emitter->setParticleSystem(mRainParticleSystem);
-
-    osg::ref_ptr<osgParticle::BoxPlacer> placer (new osgParticle::BoxPlacer);
-    placer->setXRange(-300, 300); // Rain_Diameter
-    placer->setYRange(-300, 300);
-    placer->setZRange(300, 300);
-    emitter->setPlacer(placer);
-
-    osg::ref_ptr<osgParticle::ConstantRateCounter> counter (new osgParticle::ConstantRateCounter);
-    counter->setNumberOfParticlesPerSecondToCreate(600.0);
-    emitter->setCounter(counter);
-
-    osg::ref_ptr<RainShooter> shooter (new RainShooter);
-    mRainShooter = shooter;
-    emitter->setShooter(shooter);
-
-    osg::ref_ptr<osgParticle::ParticleSystemUpdater> updater (new osgParticle::ParticleSystemUpdater);
-    updater->addParticleSystem(mRainParticleSystem);
-
-    osg::ref_ptr<osg::Geode> geode (new osg::Geode);
-    geode->addDrawable(mRainParticleSystem);
-
-    mRainNode->addChild(emitter);
-    mRainNode->addChild(geode);
-    mRainNode->addChild(updater);
+    mRainNode->addChild(mRainDrops);
 
     mRainFader = new RainFader;
     mRainNode->addUpdateCallback(mRainFader);
@@ -1391,8 +1551,7 @@ void SkyManager::destroyRain()
 
     mRootNode->removeChild(mRainNode);
     mRainNode = NULL;
-    mRainParticleSystem = NULL;
-    mRainShooter = NULL;
+    mRainDrops = NULL;
     mRainFader = NULL;
 }
 
@@ -1462,12 +1621,12 @@ void SkyManager::setMoonColour (bool red)
 
 void SkyManager::updateRainParameters()
 {
-    if (mRainShooter)
+    if (mRainDrops)
     {
         float windFactor = mWindSpeed/3.f;
         float angle = windFactor * osg::PI/4;
-        mRainShooter->setVelocity(osg::Vec3f(0, mRainSpeed * windFactor, -mRainSpeed));
-        mRainShooter->setAngle(angle);
+        mRainDrops->setVelocity(osg::Vec3f(0, mRainSpeed * windFactor, -mRainSpeed));
+        mRainDrops->setAngle(angle);
     }
 }
 
@@ -15,11 +15,6 @@ namespace osg
     class Material;
 }
 
-namespace osgParticle
-{
-    class ParticleSystem;
-}
-
 namespace Resource
 {
     class SceneManager;
@@ -32,7 +27,7 @@ namespace MWRender
     class CloudUpdater;
     class Sun;
     class Moon;
-    class RainShooter;
+    class RainDrops;
     class RainFader;
     class AlphaFader;
     class UnderwaterSwitchCallback;
@@ -191,8 +186,7 @@ namespace MWRender
         std::auto_ptr<Moon> mSecunda;
 
         osg::ref_ptr<osg::Group> mRainNode;
-        osg::ref_ptr<osgParticle::ParticleSystem> mRainParticleSystem;
-        osg::ref_ptr<RainShooter> mRainShooter;
+        osg::ref_ptr<RainDrops> mRainDrops;
         osg::ref_ptr<RainFader> mRainFader;
 
         bool mCreated;
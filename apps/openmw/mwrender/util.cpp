@@ -1,7 +1,12 @@
 #include "util.hpp"
 
+#include <sstream>
+
 #include <osg/Node>
 
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/fstream.hpp>
+
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/texturemanager.hpp>
 #include <components/misc/resourcehelpers.hpp>
@@ -28,4 +33,27 @@ void overrideTexture(const std::string &texture, Resource::ResourceSystem *resou
     node->setStateSet(stateset);
 }
 
+osg::ref_ptr<osg::Shader> readShader (osg::Shader::Type type, const std::string& file, const std::map<std::string, std::string>& defineMap)
+{
+    osg::ref_ptr<osg::Shader> shader (new osg::Shader(type));
+
+    // use boost in favor of osg::Shader::readShaderFile, to handle utf-8 path issues on Windows
+    boost::filesystem::ifstream inStream;
+    inStream.open(boost::filesystem::path(file));
+    std::stringstream strstream;
+    strstream << inStream.rdbuf();
+
+    std::string shaderSource = strstream.str();
+
+    for (std::map<std::string, std::string>::const_iterator it = defineMap.begin(); it != defineMap.end(); ++it)
+    {
+        size_t pos = shaderSource.find(it->first);
+        if (pos != std::string::npos)
+            shaderSource.replace(pos, it->first.length(), it->second);
+    }
+
+    shader->setShaderSource(shaderSource);
+    return shader;
+}
+
 }
@@ -2,6 +2,9 @@
 #define OPENMW_MWRENDER_UTIL_H
 
 #include <osg/ref_ptr>
+#include <osg/Shader>
+
+#include <map>
 #include <string>
 
 namespace osg
@@ -19,6 +22,10 @@ namespace MWRender
 
     void overrideTexture(const std::string& texture, Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Node> node);
 
+    /// Read a shader from a file, replacing the first occurrence of each key of the define map with its value.
+    osg::ref_ptr<osg::Shader> readShader (osg::Shader::Type type, const std::string& file,
+                                          const std::map<std::string, std::string>& defineMap = std::map<std::string, std::string>());
+
 }
 
 #endif
@@ -37,7 +37,10 @@ namespace MWRender
         Mask_RenderToTexture = (1<<15),
 
         // Set on a camera's cull mask to enable the LightManager
-        Mask_Lighting = (1<<16)
+        Mask_Lighting = (1<<16),
+
+        // Merged geometry of static objects, left out of intersection tests in favour of the separate objects
+        Mask_MergedStatics = (1<<17)
     };
 
 }
@@ -1,6 +1,7 @@
 #include "water.hpp"
 
 #include <iomanip>
+#include <algorithm>
 
 #include <osg/Fog>
 #include <osg/Depth>
@@ -24,11 +25,14 @@
 #include <osgUtil/IncrementalCompileOperation>
 #include <osgUtil/CullVisitor>
 
+#include <osgViewer/Viewer>
+
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/texturemanager.hpp>
 
 #include <components/nifosg/controller.hpp>
 #include <components/sceneutil/controller.hpp>
+#include <components/sceneutil/statesetupdater.hpp>
 
 #include <components/settings/settings.hpp>
 
@@ -40,6 +44,7 @@
 #include "vismask.hpp"
 #include "ripplesimulation.hpp"
 #include "renderbin.hpp"
+#include "util.hpp"
 
 namespace
 {
@@ -249,29 +254,6 @@ public:
     }
 };
 
-osg::ref_ptr<osg::Shader> readShader (osg::Shader::Type type, const std::string& file, const std::map<std::string, std::string>& defineMap = std::map<std::string, std::string>())
-{
-    osg::ref_ptr<osg::Shader> shader (new osg::Shader(type));
-
-    // use boost in favor of osg::Shader::readShaderFile, to handle utf-8 path issues on Windows
-    boost::filesystem::ifstream inStream;
-    inStream.open(boost::filesystem::path(file));
-    std::stringstream strstream;
-    strstream << inStream.rdbuf();
-
-    std::string shaderSource = strstream.str();
-
-    for (std::map<std::string, std::string>::const_iterator it = defineMap.begin(); it != defineMap.end(); ++it)
-    {
-        size_t pos = shaderSource.find(it->first);
-        if (pos != std::string::npos)
-            shaderSource.replace(pos, it->first.length(), it->second);
-    }
-
-    shader->setShaderSource(shaderSource);
-    return shader;
-}
-
 osg::ref_ptr<osg::Image> readPngImage (const std::string& file)
 {
     // use boost in favor of osgDB::readImage, to handle utf-8 path issues on Windows
@@ -293,6 +275,34 @@ osg::ref_ptr<osg::Image> readPngImage (const std::string& file)
 }
 
 
+/// Apply the [Water] settings that reduce the detail of the reflection and refraction, independently of the main view.
+void setupRttDetail(osg::Camera& camera, unsigned int cullMask)
+{
+    if (!Settings::Manager::getBool("reflect actors", "Water"))
+        cullMask &= ~(Mask_Actor|Mask_Player);
+    camera.setCullMask(cullMask);
+
+    // Drops small objects and distant actors, whose bounds cover fewer pixels
+    float smallFeatureSize = Settings::Manager::getFloat("reflection small feature culling pixel size", "Water");
+    if (smallFeatureSize > 0.f)
+    {
+        camera.setCullingMode(camera.getCullingMode() | osg::CullSettings::SMALL_FEATURE_CULLING);
+        camera.setSmallFeatureCullingPixelSize(smallFeatureSize);
+    }
+
+    // Switches LOD nodes to their coarser children closer to the camera
+    camera.setLODScale(std::max(1.f, Settings::Manager::getFloat("reflection lod scale", "Water")));
+
+    if (Settings::Manager::getBool("simple reflection materials", "Water"))
+    {
+        // Only the base texture, the glow, dark and detail maps of the fixed function pipeline are added on the
+        // following units. Shaders sample their textures regardless of the texture modes.
+        osg::StateSet* stateset = camera.getOrCreateStateSet();
+        for (unsigned int unit=1; unit<8; ++unit)
+            stateset->setTextureMode(unit, GL_TEXTURE_2D, osg::StateAttribute::OFF|osg::StateAttribute::OVERRIDE);
+    }
+}
+
 class Refraction : public osg::Camera
 {
 public:
@@ -304,7 +314,7 @@ public:
         setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
         setReferenceFrame(osg::Camera::RELATIVE_RF);
 
-        setCullMask(Mask_Effect|Mask_Scene|Mask_Terrain|Mask_Actor|Mask_ParticleSystem|Mask_Sky|Mask_Sun|Mask_Player|Mask_Lighting);
+        setupRttDetail(*this, Mask_Effect|Mask_Scene|Mask_MergedStatics|Mask_Terrain|Mask_Actor|Mask_ParticleSystem|Mask_Sky|Mask_Sun|Mask_Player|Mask_Lighting);
         setNodeMask(Mask_RenderToTexture);
         setViewport(0, 0, rttSize, rttSize);
 
@@ -380,7 +390,7 @@ public:
         setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
         setReferenceFrame(osg::Camera::RELATIVE_RF);
 
-        setCullMask(Mask_Effect|Mask_Scene|Mask_Terrain|Mask_Actor|Mask_ParticleSystem|Mask_Sky|Mask_Player|Mask_Lighting);
+        setupRttDetail(*this, Mask_Effect|Mask_Scene|Mask_MergedStatics|Mask_Terrain|Mask_Actor|Mask_ParticleSystem|Mask_Sky|Mask_Player|Mask_Lighting);
         setNodeMask(Mask_RenderToTexture);
 
         unsigned int rttSize = Settings::Manager::getInt("rtt size", "Water");
@@ -456,9 +466,34 @@ public:
     }
 };
 
-Water::Water(osg::Group *parent, osg::Group* sceneRoot, Resource::ResourceSystem *resourceSystem, osgUtil::IncrementalCompileOperation *ico,
-             const MWWorld::Fallback* fallback, const std::string& resourcePath)
-    : mParent(parent)
+/// Tells the water shader where the ripple map is.
+class RippleAreaUpdater : public SceneUtil::StateSetUpdater
+{
+public:
+    RippleAreaUpdater(const RippleMap* rippleMap)
+        : mRippleMap(rippleMap)
+    {
+    }
+
+    virtual void setDefaults(osg::StateSet* stateset)
+    {
+        stateset->addUniform(new osg::Uniform("rippleArea", osg::Vec3f()));
+    }
+
+    virtual void apply(osg::StateSet* stateset, osg::NodeVisitor* /*nv*/)
+    {
+        osg::Vec2f origin = mRippleMap->getOrigin();
+        stateset->getUniform("rippleArea")->set(osg::Vec3f(origin.x(), origin.y(), mRippleMap->getSize()));
+    }
+
+private:
+    const RippleMap* mRippleMap;
+};
+
+Water::Water(osgViewer::Viewer* viewer, osg::Group *parent, osg::Group* sceneRoot, Resource::ResourceSystem *resourceSystem,
+             osgUtil::IncrementalCompileOperation *ico, const MWWorld::Fallback* fallback, const std::string& resourcePath)
+    : mViewer(viewer)
+    , mParent(parent)
     , mSceneRoot(sceneRoot)
     , mResourceSystem(resourceSystem)
     , mFallback(fallback)
@@ -466,6 +501,8 @@ Water::Water(osg::Group *parent, osg::Group* sceneRoot, Resource::ResourceSystem
     , mEnabled(true)
     , mToggled(true)
     , mTop(0)
+    , mRttUpdateInterval(std::max(1, Settings::Manager::getInt("reflection update interval", "Water")))
+    , mFramesSinceRttUpdate(mRttUpdateInterval)
 {
     mSimulation.reset(new RippleSimulation(parent, resourceSystem, fallback));
 
@@ -500,28 +537,37 @@ void Water::updateWaterMaterial()
 {
     if (mReflection)
     {
-        mParent->removeChild(mReflection);
+        removeRttCamera(mReflection);
         mReflection = NULL;
     }
     if (mRefraction)
     {
-        mParent->removeChild(mRefraction);
+        removeRttCamera(mRefraction);
         mRefraction = NULL;
     }
+    mWaterGeode->setUpdateCallback(NULL);
+    mSimulation->setRippleMap(NULL);
+    mRippleMap.reset();
 
     if (Settings::Manager::getBool("shader", "Water"))
     {
+        if (Settings::Manager::getBool("gpu ripples", "Water"))
+        {
+            mRippleMap.reset(new RippleMap(mParent, mResourcePath));
+            mSimulation->setRippleMap(mRippleMap.get());
+        }
+
         mReflection = new Reflection;
         mReflection->setWaterLevel(mTop);
         mReflection->setScene(mSceneRoot);
-        mParent->addChild(mReflection);
+        addRttCamera(mReflection);
 
         if (Settings::Manager::getBool("refraction", "Water"))
         {
             mRefraction = new Refraction;
             mRefraction->setWaterLevel(mTop);
             mRefraction->setScene(mSceneRoot);
-            mParent->addChild(mRefraction);
+            addRttCamera(mRefraction);
         }
 
         createShaderWaterStateSet(mWaterGeode, mReflection, mRefraction);
@@ -529,6 +575,7 @@ void Water::updateWaterMaterial()
     else
         createSimpleWaterStateSet(mWaterGeode, mFallback->getFallbackFloat("Water_World_Alpha"));
 
+    mFramesSinceRttUpdate = mRttUpdateInterval;
     updateVisible();
 }
 
@@ -581,6 +628,7 @@ void Water::createShaderWaterStateSet(osg::Node* node, Reflection* reflection, R
     // use a define map to conditionally compile the shader
     std::map<std::string, std::string> defineMap;
     defineMap.insert(std::make_pair(std::string("@refraction_enabled"), std::string(refraction ? "1" : "0")));
+    defineMap.insert(std::make_pair(std::string("@ripples_enabled"), std::string(mRippleMap.get() ? "1" : "0")));
 
     osg::ref_ptr<osg::Shader> vertexShader (readShader(osg::Shader::VERTEX, mResourcePath + "/shaders/water_vertex.glsl", defineMap));
     osg::ref_ptr<osg::Shader> fragmentShader (readShader(osg::Shader::FRAGMENT, mResourcePath + "/shaders/water_fragment.glsl", defineMap));
@@ -618,6 +666,13 @@ void Water::createShaderWaterStateSet(osg::Node* node, Reflection* reflection, R
         shaderStateset->setAttributeAndModes(depth, osg::StateAttribute::ON);
     }
 
+    if (mRippleMap.get())
+    {
+        shaderStateset->setTextureAttributeAndModes(4, mRippleMap->getTexture(), osg::StateAttribute::ON);
+        shaderStateset->addUniform(new osg::Uniform("rippleMap", 4));
+        shaderStateset->addUniform(new osg::Uniform("rippleTexelSize", mRippleMap->getTexelSize()));
+    }
+
     shaderStateset->setMode(GL_CULL_FACE, osg::StateAttribute::OFF);
 
     osg::ref_ptr<osg::Program> program (new osg::Program);
@@ -626,7 +681,10 @@ void Water::createShaderWaterStateSet(osg::Node* node, Reflection* reflection, R
     shaderStateset->setAttributeAndModes(program, osg::StateAttribute::ON);
 
     node->setStateSet(shaderStateset);
-    node->setUpdateCallback(NULL);
+    if (mRippleMap.get())
+        node->setUpdateCallback(new RippleAreaUpdater(mRippleMap.get()));
+    else
+        node->setUpdateCallback(NULL);
 }
 
 void Water::processChangedSettings(const Settings::CategorySettingVector& settings)
@@ -638,18 +696,69 @@ Water::~Water()
 {
     mParent->removeChild(mWaterNode);
 
+    mSimulation->setRippleMap(NULL);
+
     if (mReflection)
     {
-        mParent->removeChild(mReflection);
+        removeRttCamera(mReflection);
         mReflection = NULL;
     }
     if (mRefraction)
     {
-        mParent->removeChild(mRefraction);
+        removeRttCamera(mRefraction);
         mRefraction = NULL;
     }
 }
 
+void Water::addRttCamera(osg::Camera *camera)
+{
+    if (mViewer->getThreadingModel() != osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext)
+    {
+        mParent->addChild(camera);
+        return;
+    }
+
+    // The slave only holds the water camera, below the state of the parent that the nested camera would inherit.
+    // It has the view and projection of the main camera, and draws nothing itself.
+    osg::ref_ptr<osg::Group> parentState (new osg::Group);
+    parentState->setStateSet(mParent->getOrCreateStateSet());
+    parentState->addChild(camera);
+
+    osg::Camera* mainCamera = mViewer->getCamera();
+    osg::ref_ptr<osg::Camera> slave (new osg::Camera);
+    slave->setGraphicsContext(mainCamera->getGraphicsContext());
+    slave->setViewport(new osg::Viewport(*mainCamera->getViewport()));
+    slave->setRenderOrder(osg::Camera::PRE_RENDER);
+    slave->setClearMask(0);
+    slave->setAllowEventFocus(false);
+    slave->addChild(parentState);
+
+    // The cull threads are created for the cameras the viewer has when the threading starts
+    mViewer->stopThreading();
+    mViewer->addSlave(slave, false);
+    mViewer->startThreading();
+
+    mSlaves[camera] = slave;
+}
+
+void Water::removeRttCamera(osg::Camera *camera)
+{
+    std::map<osg::Camera*, osg::ref_ptr<osg::Camera> >::iterator found = mSlaves.find(camera);
+    if (found == mSlaves.end())
+    {
+        mParent->removeChild(camera);
+        return;
+    }
+
+    mViewer->stopThreading();
+    mViewer->removeSlave(mViewer->findSlaveIndexForCamera(found->second));
+    found->second->setGraphicsContext(NULL);
+    mViewer->startThreading();
+
+    found->second->removeChildren(0, found->second->getNumChildren());
+    mSlaves.erase(found);
+}
+
 void Water::setEnabled(bool enabled)
 {
     mEnabled = enabled;
@@ -688,16 +797,28 @@ void Water::setHeight(const float height)
 void Water::update(float dt)
 {
     mSimulation->update(dt);
+
+    // The reflection and refraction were rendered last frame if they were due
+    if (mFramesSinceRttUpdate >= mRttUpdateInterval)
+        mFramesSinceRttUpdate = 0;
+    ++mFramesSinceRttUpdate;
+    updateVisible();
 }
 
 void Water::updateVisible()
 {
     bool visible = mEnabled && mToggled;
     mWaterNode->setNodeMask(visible ? ~0 : 0);
+
+    // The textures of hidden water are outdated, render them as soon as it is shown again
+    if (!visible)
+        mFramesSinceRttUpdate = mRttUpdateInterval;
+    // Between updates, the water keeps using the textures of the last update
+    bool updateRtt = visible && mFramesSinceRttUpdate >= mRttUpdateInterval;
     if (mRefraction)
-        mRefraction->setNodeMask(visible ? Mask_RenderToTexture : 0);
+        mRefraction->setNodeMask(updateRtt ? Mask_RenderToTexture : 0);
     if (mReflection)
-        mReflection->setNodeMask(visible ? Mask_RenderToTexture : 0);
+        mReflection->setNodeMask(updateRtt ? Mask_RenderToTexture : 0);
 }
 
 bool Water::toggle()
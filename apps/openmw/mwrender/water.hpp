@@ -2,6 +2,7 @@
 #define OPENMW_MWRENDER_WATER_H
 
 #include <memory>
+#include <map>
 
 #include <osg/ref_ptr>
 #include <osg/Vec3f>
@@ -14,6 +15,12 @@ namespace osg
     class PositionAttitudeTransform;
     class Geode;
     class Node;
+    class Camera;
+}
+
+namespace osgViewer
+{
+    class Viewer;
 }
 
 namespace osgUtil
@@ -39,12 +46,14 @@ namespace MWRender
     class Refraction;
     class Reflection;
     class RippleSimulation;
+    class RippleMap;
 
     /// Water rendering
     class Water
     {
         static const int CELL_SIZE = 8192;
 
+        osg::ref_ptr<osgViewer::Viewer> mViewer;
         osg::ref_ptr<osg::Group> mParent;
         osg::ref_ptr<osg::Group> mSceneRoot;
         osg::ref_ptr<osg::PositionAttitudeTransform> mWaterNode;
@@ -54,16 +63,25 @@ namespace MWRender
         osg::ref_ptr<osgUtil::IncrementalCompileOperation> mIncrementalCompileOperation;
 
         std::auto_ptr<RippleSimulation> mSimulation;
+        // Only with the water shader, see the "gpu ripples" setting
+        std::auto_ptr<RippleMap> mRippleMap;
 
         osg::ref_ptr<Refraction> mRefraction;
         osg::ref_ptr<Reflection> mReflection;
 
+        // The slave cameras of the viewer holding the reflection and refraction, with a cull thread per camera
+        std::map<osg::Camera*, osg::ref_ptr<osg::Camera> > mSlaves;
+
         const std::string mResourcePath;
 
         bool mEnabled;
         bool mToggled;
         float mTop;
 
+        // The reflection and refraction are rendered once every mRttUpdateInterval frames
+        int mRttUpdateInterval;
+        int mFramesSinceRttUpdate;
+
         osg::Vec3f getSceneNodeCoordinates(int gridX, int gridY);
         void updateVisible();
 
@@ -75,8 +93,14 @@ namespace MWRender
 
         void updateWaterMaterial();
 
+        /// Add a render to texture camera of the water to the parent, or when the viewer culls each camera in a
+        /// thread of its own, to a slave camera of the viewer, so that it is culled in parallel with the main view.
+        void addRttCamera(osg::Camera* camera);
+
+        void removeRttCamera(osg::Camera* camera);
+
     public:
-        Water(osg::Group* parent, osg::Group* sceneRoot,
+        Water(osgViewer::Viewer* viewer, osg::Group* parent, osg::Group* sceneRoot,
               Resource::ResourceSystem* resourceSystem, osgUtil::IncrementalCompileOperation* ico, const MWWorld::Fallback* fallback,
               const std::string& resourcePath);
         ~Water();
@@ -41,7 +41,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string objectID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& objectID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     // discard additional arguments (reset), because we have no idea what they mean.
@@ -90,7 +90,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string actorID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& actorID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Float duration = runtime[0].mFloat;
@@ -125,10 +125,10 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string actorID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& actorID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
-                    std::string cellID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& cellID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Float duration = runtime[0].mFloat;
@@ -286,7 +286,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string actorID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& actorID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Float duration = runtime[0].mFloat;
@@ -321,10 +321,10 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string actorID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& actorID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
-                    std::string cellID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& cellID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Float duration = runtime[0].mFloat;
@@ -372,7 +372,7 @@ namespace MWScript
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
                     MWWorld::Ptr observer = R()(runtime);
-                    std::string actorID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& actorID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWWorld::Ptr actor = MWBase::Environment::get().getWorld()->getPtr(actorID, true);
@@ -401,7 +401,7 @@ namespace MWScript
 
                     MWWorld::Ptr source = R()(runtime);
 
-                    std::string actorID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& actorID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
 
@@ -422,7 +422,7 @@ namespace MWScript
                 virtual void execute (Interpreter::Runtime &runtime)
                 {
                     MWWorld::Ptr actor = R()(runtime);
-                    std::string testedTargetId = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& testedTargetId = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     const MWMechanics::CreatureStats& creatureStats = actor.getClass().getCreatureStats(actor);
@@ -445,7 +445,7 @@ namespace MWScript
                 virtual void execute (Interpreter::Runtime &runtime)
                 {
                     MWWorld::Ptr actor = R()(runtime);
-                    std::string targetID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& targetID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWWorld::Ptr target = MWBase::Environment::get().getWorld()->getPtr(targetID, true);
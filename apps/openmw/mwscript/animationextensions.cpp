@@ -42,7 +42,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string group = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& group = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Integer mode = 0;
@@ -69,7 +69,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string group = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& group = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Integer loops = runtime[0].mInteger;
@@ -40,7 +40,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string cell = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& cell = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     ESM::Position pos;
@@ -112,7 +112,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string name = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& name = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     if (!MWMechanics::getPlayer().isInCell())
@@ -3,6 +3,7 @@
 #include "../mwworld/esmstore.hpp"
 
 #include <components/esm/loaddial.hpp>
+#include <components/esm/loadglob.hpp>
 
 #include <components/compiler/locals.hpp>
 
@@ -17,9 +18,28 @@
 namespace MWScript
 {
     CompilerContext::CompilerContext (Type type)
-    : mType (type)
+    : mType (type), mStore (0), mScriptManager (0)
     {}
 
+    CompilerContext::CompilerContext (Type type, const MWWorld::ESMStore& store,
+        MWBase::ScriptManager& scriptManager)
+    : mType (type), mStore (&store), mScriptManager (&scriptManager)
+    {}
+
+    const MWWorld::ESMStore& CompilerContext::getStore() const
+    {
+        if (mStore)
+            return *mStore;
+        return MWBase::Environment::get().getWorld()->getStore();
+    }
+
+    MWBase::ScriptManager& CompilerContext::getScriptManager() const
+    {
+        if (mScriptManager)
+            return *mScriptManager;
+        return *MWBase::Environment::get().getScriptManager();
+    }
+
     bool CompilerContext::canDeclareLocals() const
     {
         return mType==Type_Full;
@@ -27,7 +47,23 @@ namespace MWScript
 
     char CompilerContext::getGlobalType (const std::string& name) const
     {
-        return MWBase::Environment::get().getWorld()->getGlobalVariableType (name);
+        if (!mStore)
+            return MWBase::Environment::get().getWorld()->getGlobalVariableType (name);
+
+        // Same as MWWorld::Globals::getType, which the world fills from these records
+        const ESM::Global *global = mStore->get<ESM::Global>().search (name);
+
+        if (!global)
+            return ' ';
+
+        switch (global->mValue.getType())
+        {
+            case ESM::VT_Short: return 's';
+            case ESM::VT_Long: return 'l';
+            case ESM::VT_Float: return 'f';
+
+            default: return ' ';
+        }
     }
 
     std::pair<char, bool> CompilerContext::getMemberType (const std::string& name,
@@ -36,14 +72,13 @@ namespace MWScript
         std::string script;
         bool reference = false;
 
-        if (const ESM::Script *scriptRecord =
-            MWBase::Environment::get().getWorld()->getStore().get<ESM::Script>().search (id))
+        if (const ESM::Script *scriptRecord = getStore().get<ESM::Script>().search (id))
         {
             script = scriptRecord->mId;
         }
         else
         {
-            MWWorld::ManualRef ref (MWBase::Environment::get().getWorld()->getStore(), id);
+            MWWorld::ManualRef ref (getStore(), id);
 
             script = ref.getPtr().getClass().getScript (ref.getPtr());
             reference = true;
@@ -52,7 +87,7 @@ namespace MWScript
         char type = ' ';
 
         if (!script.empty())
-            type = MWBase::Environment::get().getScriptManager()->getLocals (script).getType (
+            type = getScriptManager().getLocals (script).getType (
                 Misc::StringUtils::lowerCase (name));
 
         return std::make_pair (type, reference);
@@ -60,8 +95,7 @@ namespace MWScript
 
     bool CompilerContext::isId (const std::string& name) const
     {
-        const MWWorld::ESMStore &store =
-            MWBase::Environment::get().getWorld()->getStore();
+        const MWWorld::ESMStore &store = getStore();
 
         return
             store.get<ESM::Activator>().search (name) ||
@@ -89,8 +123,7 @@ namespace MWScript
 
     bool CompilerContext::isJournalId (const std::string& name) const
     {
-        const MWWorld::ESMStore &store =
-            MWBase::Environment::get().getWorld()->getStore();
+        const MWWorld::ESMStore &store = getStore();
 
         const ESM::Dialogue *topic = store.get<ESM::Dialogue>().search (name);
 
@@ -3,6 +3,16 @@
 
 #include <components/compiler/context.hpp>
 
+namespace MWWorld
+{
+    class ESMStore;
+}
+
+namespace MWBase
+{
+    class ScriptManager;
+}
+
 namespace MWScript
 {
     class CompilerContext : public Compiler::Context
@@ -19,11 +29,24 @@ namespace MWScript
         private:
 
             Type mType;
+            const MWWorld::ESMStore* mStore;
+            MWBase::ScriptManager* mScriptManager;
+
+            const MWWorld::ESMStore& getStore() const;
+
+            MWBase::ScriptManager& getScriptManager() const;
 
         public:
 
             CompilerContext (Type type);
 
+            /// Look up records in the given store and the locals of other scripts in the given script
+            /// manager, instead of going through MWBase::Environment. Global variables are then taken
+            /// from the records of the store rather than from the world.
+            /// @note Such a context can be used on any thread, as long as the store does not change and
+            /// the script manager is thread safe.
+            CompilerContext (Type type, const MWWorld::ESMStore& store, MWBase::ScriptManager& scriptManager);
+
             /// Is the compiler allowed to declare local variables?
             virtual bool canDeclareLocals() const;
 
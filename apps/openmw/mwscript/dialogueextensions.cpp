@@ -28,7 +28,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string quest = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& quest = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Integer index = runtime[0].mInteger;
@@ -53,7 +53,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string quest = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& quest = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Integer index = runtime[0].mInteger;
@@ -69,7 +69,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string quest = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& quest = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     int index = MWBase::Environment::get().getJournal()->getJournalIndex (quest);
@@ -85,7 +85,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string topic = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& topic = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWBase::Environment::get().getDialogueManager()->addTopic(topic);
@@ -101,7 +101,7 @@ namespace MWScript
                     MWBase::DialogueManager* dialogue = MWBase::Environment::get().getDialogueManager();
                     while(arg0>0)
                     {
-                        std::string question = runtime.getStringLiteral (runtime[0].mInteger);
+                        const std::string& question = runtime.getStringLiteral (runtime[0].mInteger);
                         runtime.pop();
                         arg0 = arg0 -1;
                         Interpreter::Type_Integer choice = 1;
@@ -206,10 +206,10 @@ namespace MWScript
 
             virtual void execute (Interpreter::Runtime& runtime)
             {
-                std::string faction1 = runtime.getStringLiteral (runtime[0].mInteger);
+                const std::string& faction1 = runtime.getStringLiteral (runtime[0].mInteger);
                 runtime.pop();
 
-                std::string faction2 = runtime.getStringLiteral (runtime[0].mInteger);
+                const std::string& faction2 = runtime.getStringLiteral (runtime[0].mInteger);
                 runtime.pop();
 
                 int modReaction = runtime[0].mInteger;
@@ -225,10 +225,10 @@ namespace MWScript
 
             virtual void execute (Interpreter::Runtime& runtime)
             {
-                std::string faction1 = runtime.getStringLiteral (runtime[0].mInteger);
+                const std::string& faction1 = runtime.getStringLiteral (runtime[0].mInteger);
                 runtime.pop();
 
-                std::string faction2 = runtime.getStringLiteral (runtime[0].mInteger);
+                const std::string& faction2 = runtime.getStringLiteral (runtime[0].mInteger);
                 runtime.pop();
 
                 runtime.push(MWBase::Environment::get().getDialogueManager()
@@ -242,10 +242,10 @@ namespace MWScript
 
             virtual void execute (Interpreter::Runtime& runtime)
             {
-                std::string faction1 = runtime.getStringLiteral (runtime[0].mInteger);
+                const std::string& faction1 = runtime.getStringLiteral (runtime[0].mInteger);
                 runtime.pop();
 
-                std::string faction2 = runtime.getStringLiteral (runtime[0].mInteger);
+                const std::string& faction2 = runtime.getStringLiteral (runtime[0].mInteger);
                 runtime.pop();
 
                 int newValue = runtime[0].mInteger;
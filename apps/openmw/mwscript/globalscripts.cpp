@@ -2,8 +2,10 @@
 
 #include <cassert>
 #include <iostream>
+#include <algorithm>
 
 #include <components/misc/stringops.hpp>
+#include <components/misc/profiler.hpp>
 #include <components/esm/esmwriter.hpp>
 #include <components/esm/globalscript.hpp>
 
@@ -14,6 +16,29 @@
 
 #include "interpretercontext.hpp"
 
+namespace
+{
+    typedef std::map<std::string, MWScript::GlobalScriptDesc>::iterator ScriptIter;
+
+    struct CompareNames
+    {
+        bool operator() (const ScriptIter& left, const ScriptIter& right) const
+        {
+            return left->first < right->first;
+        }
+
+        bool operator() (const ScriptIter& script, const std::string& name) const
+        {
+            return script->first < name;
+        }
+
+        bool operator() (const std::string& name, const ScriptIter& script) const
+        {
+            return name < script->first;
+        }
+    };
+}
+
 namespace MWScript
 {
     GlobalScriptDesc::GlobalScriptDesc() : mRunning (false) {}
@@ -33,16 +58,15 @@ namespace MWScript
             if (const ESM::Script *script = mStore.get<ESM::Script>().find (name))
             {
                 GlobalScriptDesc desc;
-                desc.mRunning = true;
                 desc.mLocals.configure (*script);
                 desc.mId = targetId;
 
-                mScripts.insert (std::make_pair (name, desc));
+                setRunning (mScripts.insert (std::make_pair (name, desc)).first, true);
             }
         }
         else if (!iter->second.mRunning)
         {
-            iter->second.mRunning = true;
+            setRunning (iter, true);
             iter->second.mId = targetId;
         }
     }
@@ -53,7 +77,23 @@ namespace MWScript
             mScripts.find (::Misc::StringUtils::lowerCase (name));
 
         if (iter!=mScripts.end())
-            iter->second.mRunning = false;
+            setRunning (iter, false);
+    }
+
+    void GlobalScripts::setRunning (ScriptIter script, bool running)
+    {
+        if (script->second.mRunning == running)
+            return;
+
+        script->second.mRunning = running;
+
+        std::vector<ScriptIter>::iterator found =
+            std::lower_bound (mRunningScripts.begin(), mRunningScripts.end(), script->first, CompareNames());
+
+        if (running)
+            mRunningScripts.insert (found, script);
+        else if (found!=mRunningScripts.end() && *found==script)
+            mRunningScripts.erase (found);
     }
 
     bool GlobalScripts::isRunning (const std::string& name) const
@@ -69,23 +109,28 @@ namespace MWScript
 
     void GlobalScripts::run()
     {
-        for (std::map<std::string, GlobalScriptDesc>::iterator iter (mScripts.begin());
-            iter!=mScripts.end(); ++iter)
+        OPENMW_PROFILE_ZONE ("GlobalScripts::run");
+
+        MWScript::InterpreterContext interpreterContext (0, MWWorld::Ptr());
+
+        // The scripts that run can start and stop other scripts, so the next one is looked up after each script. Like
+        // going through all scripts by name, this runs the scripts started with a later name in the same frame.
+        std::vector<ScriptIter>::const_iterator next = mRunningScripts.begin();
+        while (next!=mRunningScripts.end())
         {
-            if (iter->second.mRunning)
-            {
-                MWWorld::Ptr ptr;
+            ScriptIter iter = *next;
 
-                MWScript::InterpreterContext interpreterContext (
-                    &iter->second.mLocals, MWWorld::Ptr(), iter->second.mId);
+            interpreterContext.reset (&iter->second.mLocals, MWWorld::Ptr(), iter->second.mId);
 
-                MWBase::Environment::get().getScriptManager()->run (iter->first, interpreterContext);
-            }
+            MWBase::Environment::get().getScriptManager()->run (iter->first, interpreterContext);
+
+            next = std::upper_bound (mRunningScripts.begin(), mRunningScripts.end(), iter->first, CompareNames());
         }
     }
 
     void GlobalScripts::clear()
     {
+        mRunningScripts.clear();
         mScripts.clear();
     }
 
@@ -181,7 +226,7 @@ namespace MWScript
                     return true;
             }
 
-            iter->second.mRunning = script.mRunning!=0;
+            setRunning (iter, script.mRunning!=0);
             iter->second.mLocals.read (script.mLocals, script.mId);
             iter->second.mId = script.mTargetId;
 
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #include <stdint.h>
 
@@ -40,6 +41,13 @@ namespace MWScript
             const MWWorld::ESMStore& mStore;
             std::map<std::string, GlobalScriptDesc> mScripts;
 
+            typedef std::map<std::string, GlobalScriptDesc>::iterator ScriptIter;
+
+            // The running scripts, sorted by name like mScripts, so that run() does not need to go through all scripts
+            std::vector<ScriptIter> mRunningScripts;
+
+            void setRunning (ScriptIter script, bool running);
+
         public:
 
             GlobalScripts (const MWWorld::ESMStore& store);
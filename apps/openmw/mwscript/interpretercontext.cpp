@@ -148,6 +148,21 @@ namespace MWScript
             mTargetId = reference.getCellRef().getRefId();
     }
 
+    void InterpreterContext::reset (MWScript::Locals *locals, const MWWorld::Ptr& reference,
+        const std::string& targetId)
+    {
+        mLocals = locals;
+        mReference = reference;
+        mActivated = MWWorld::Ptr();
+        mActivationHandled = false;
+
+        // Assigning keeps the memory of the string
+        if (targetId.empty() && !reference.isEmpty())
+            mTargetId.assign (reference.getCellRef().getRefId());
+        else
+            mTargetId.assign (targetId);
+    }
+
     int InterpreterContext::getLocalShort (int index) const
     {
         if (!mLocals)
@@ -58,6 +58,11 @@ namespace MWScript
                 const std::string& targetId = "");
             ///< The ownership of \a locals is not transferred. 0-pointer allowed.
 
+            void reset (MWScript::Locals *locals, const MWWorld::Ptr& reference,
+                const std::string& targetId = "");
+            ///< Make the context the same as a newly constructed one, for running the next script
+            /// without constructing a context for each.
+
             virtual int getLocalShort (int index) const;
 
             virtual int getLocalLong (int index) const;
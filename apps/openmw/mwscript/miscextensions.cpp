@@ -1,6 +1,9 @@
 #include "miscextensions.hpp"
 
 #include <cstdlib>
+#include <sstream>
+
+#include <boost/filesystem/fstream.hpp>
 
 #include <components/compiler/extensions.hpp>
 #include <components/compiler/opcodes.hpp>
@@ -31,6 +34,7 @@
 
 #include "interpretercontext.hpp"
 #include "ref.hpp"
+#include "scriptprofile.hpp"
 
 namespace
 {
@@ -78,7 +82,7 @@ namespace MWScript
 
             virtual void execute (Interpreter::Runtime& runtime)
             {
-                std::string name = runtime.getStringLiteral (runtime[0].mInteger);
+                const std::string& name = runtime.getStringLiteral (runtime[0].mInteger);
                 runtime.pop();
 
                 bool allowSkipping = runtime[0].mInteger != 0;
@@ -414,7 +418,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string effect = runtime.getStringLiteral(runtime[0].mInteger);
+                    const std::string& effect = runtime.getStringLiteral(runtime[0].mInteger);
                     runtime.pop();
 
                     char *end;
@@ -444,10 +448,10 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string creature = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& creature = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
-                    std::string gem = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& gem = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     const MWWorld::ESMStore& store = MWBase::Environment::get().getWorld()->getStore();
@@ -467,7 +471,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string soul = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& soul = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     // throw away additional arguments
@@ -496,7 +500,7 @@ namespace MWScript
 
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string item = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& item = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Integer amount = runtime[0].mInteger;
@@ -540,7 +544,7 @@ namespace MWScript
 
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string soul = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& soul = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWWorld::ContainerStore& store = ptr.getClass().getContainerStore (ptr);
@@ -606,7 +610,7 @@ namespace MWScript
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
                     MWWorld::Ptr ptr = R()(runtime);
-                    std::string id = runtime.getStringLiteral(runtime[0].mInteger);
+                    const std::string& id = runtime.getStringLiteral(runtime[0].mInteger);
                     runtime.pop();
 
                     const MWMechanics::CreatureStats& stats = ptr.getClass().getCreatureStats(ptr);
@@ -764,7 +768,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string objectID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& objectID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWMechanics::CreatureStats &stats = ptr.getClass().getCreatureStats(ptr);
@@ -783,7 +787,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string objectID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& objectID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWMechanics::CreatureStats &stats = ptr.getClass().getCreatureStats(ptr);
@@ -923,6 +927,73 @@ namespace MWScript
             }
         };
 
+        class OpToggleScriptProfiler : public Interpreter::Opcode0
+        {
+        public:
+            virtual void execute (Interpreter::Runtime& runtime)
+            {
+                ScriptProfile& profile = MWBase::Environment::get().getScriptManager()->getProfile();
+                profile.setEnabled(!profile.isEnabled());
+
+                runtime.getContext().report(profile.isEnabled() ? "Script Profiler -> On" : "Script Profiler -> Off");
+            }
+        };
+
+        class OpShowScriptProfile : public Interpreter::Opcode1
+        {
+        public:
+            virtual void execute (Interpreter::Runtime& runtime, unsigned int arg0)
+            {
+                int count = 10;
+                if (arg0 > 0)
+                {
+                    count = runtime[0].mInteger;
+                    runtime.pop();
+                }
+
+                ScriptProfile::SortedEntries entries;
+                MWBase::Environment::get().getScriptManager()->getProfile().getSorted(entries);
+
+                if (entries.empty())
+                {
+                    runtime.getContext().report("No scripts profiled, see ToggleScriptProfiler");
+                    return;
+                }
+
+                std::ostringstream str;
+                str.setf(std::ios::fixed);
+                str.precision(3);
+                for (int i = 0; i < count && i < static_cast<int>(entries.size()); ++i)
+                {
+                    const ScriptProfile::Entry& entry = entries[i].second;
+                    str << entries[i].first << ": " << entry.mCalls << " calls, "
+                        << entry.mTotalTime * 1000 << " ms total, " << entry.mMaxTime * 1000 << " ms max, "
+                        << entry.mInstructions << " instructions" << std::endl;
+                }
+
+                runtime.getContext().report(str.str());
+            }
+        };
+
+        class OpExportScriptProfile : public Interpreter::Opcode0
+        {
+        public:
+            virtual void execute (Interpreter::Runtime& runtime)
+            {
+                const std::string& file = runtime.getStringLiteral(runtime[0].mInteger);
+                runtime.pop();
+
+                boost::filesystem::ofstream stream(boost::filesystem::path(file), std::ios::out | std::ios::trunc);
+                if (stream.is_open())
+                    MWBase::Environment::get().getScriptManager()->getProfile().writeCsv(stream);
+
+                if (!stream.is_open() || !stream)
+                    runtime.getContext().report("Failed to write script profile to " + file);
+                else
+                    runtime.getContext().report("Wrote script profile to " + file);
+            }
+        };
+
         class OpToggleGodMode : public Interpreter::Opcode0
         {
             public:
@@ -942,7 +1013,7 @@ namespace MWScript
             {
                 MWWorld::Ptr ptr = R()(runtime);
 
-                std::string spell = runtime.getStringLiteral (runtime[0].mInteger);
+                const std::string& spell = runtime.getStringLiteral (runtime[0].mInteger);
                 runtime.pop();
 
                 std::string targetId = ::Misc::StringUtils::lowerCase(runtime.getStringLiteral (runtime[0].mInteger));
@@ -965,7 +1036,7 @@ namespace MWScript
             {
                 MWWorld::Ptr ptr = R()(runtime);
 
-                std::string spell = runtime.getStringLiteral (runtime[0].mInteger);
+                const std::string& spell = runtime.getStringLiteral (runtime[0].mInteger);
                 runtime.pop();
 
                 MWMechanics::CastSpell cast(ptr, ptr);
@@ -1073,7 +1144,7 @@ namespace MWScript
 
                 while (arg0 > 0)
                 {
-                    std::string notes = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& notes = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
                     if (!notes.empty())
                         msg << "Notes: " << notes << std::endl;
@@ -1236,6 +1307,9 @@ namespace MWScript
             interpreter.installSegment5 (Compiler::Misc::opcodeShowVarsExplicit, new OpShowVars<ExplicitRef>);
             interpreter.installSegment5 (Compiler::Misc::opcodeToggleGodMode, new OpToggleGodMode);
             interpreter.installSegment5 (Compiler::Misc::opcodeToggleScripts, new OpToggleScripts);
+            interpreter.installSegment5 (Compiler::Misc::opcodeToggleScriptProfiler, new OpToggleScriptProfiler);
+            interpreter.installSegment3 (Compiler::Misc::opcodeShowScriptProfile, new OpShowScriptProfile);
+            interpreter.installSegment5 (Compiler::Misc::opcodeExportScriptProfile, new OpExportScriptProfile);
             interpreter.installSegment5 (Compiler::Misc::opcodeDisableLevitation, new OpEnableLevitation<false>);
             interpreter.installSegment5 (Compiler::Misc::opcodeEnableLevitation, new OpEnableLevitation<true>);
             interpreter.installSegment5 (Compiler::Misc::opcodeCast, new OpCast<ImplicitRef>);
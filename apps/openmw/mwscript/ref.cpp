@@ -10,7 +10,7 @@
 MWWorld::Ptr MWScript::ExplicitRef::operator() (Interpreter::Runtime& runtime, bool required,
     bool activeOnly) const
 {
-    std::string id = runtime.getStringLiteral(runtime[0].mInteger);
+    const std::string& id = runtime.getStringLiteral(runtime[0].mInteger);
     runtime.pop();
 
     if (required)
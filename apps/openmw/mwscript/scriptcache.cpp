@@ -0,0 +1,237 @@
+#include "scriptcache.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/misc/stringops.hpp>
+
+namespace
+{
+    const boost::uint32_t sMagic = 0x4353574f; // "OWSC"
+
+    /// Increase when the layout of the cache or the code generated by the compiler changes
+    const boost::uint32_t sFormatVersion = 1;
+
+    const char sLocalTypes[3] = { 's', 'l', 'f' };
+
+    // FNV-1a
+    const boost::uint64_t sHashBasis = 14695981039346656037ull;
+
+    boost::uint64_t hash (const char* data, size_t size, boost::uint64_t hash)
+    {
+        for (size_t i=0; i<size; ++i)
+        {
+            hash ^= static_cast<unsigned char> (data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    boost::uint64_t hash (const std::string& string, boost::uint64_t value)
+    {
+        // Include the terminator, so that consecutive strings can not be mistaken for each other
+        return hash (string.c_str(), string.size()+1, value);
+    }
+
+    template<typename T>
+    boost::uint64_t hashValue (const T& data, boost::uint64_t value)
+    {
+        return hash (reinterpret_cast<const char*> (&data), sizeof (T), value);
+    }
+
+    template<typename T>
+    void write (std::ostream& stream, const T& data)
+    {
+        stream.write (reinterpret_cast<const char*> (&data), sizeof (T));
+    }
+
+    void write (std::ostream& stream, const std::string& string)
+    {
+        write (stream, static_cast<boost::uint32_t> (string.size()));
+        stream.write (string.c_str(), string.size());
+    }
+
+    template<typename T>
+    void read (std::istream& stream, T& data)
+    {
+        if (!stream.read (reinterpret_cast<char*> (&data), sizeof (T)))
+            throw std::runtime_error ("unexpected end of file");
+    }
+
+    void read (std::istream& stream, std::string& string)
+    {
+        boost::uint32_t size = 0;
+        read (stream, size);
+        string.resize (size);
+        if (size && !stream.read (&string[0], size))
+            throw std::runtime_error ("unexpected end of file");
+    }
+}
+
+namespace MWScript
+{
+    ScriptCache::ScriptCache (const boost::filesystem::path& file)
+    : mFile (file), mKey (0), mChanged (false)
+    {
+    }
+
+    void ScriptCache::load (const std::string& version, const std::vector<std::string>& keywords,
+        const std::vector<boost::filesystem::path>& contentFiles)
+    {
+        mKey = hashValue (sFormatVersion, hash (version, sHashBasis));
+        for (std::vector<std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it)
+            mKey = hash (*it, mKey);
+        for (std::vector<boost::filesystem::path>::const_iterator it = contentFiles.begin(); it != contentFiles.end(); ++it)
+        {
+            mKey = hash (it->string(), mKey);
+            mKey = hashValue (static_cast<boost::uint64_t> (boost::filesystem::file_size (*it)), mKey);
+            mKey = hashValue (static_cast<boost::int64_t> (boost::filesystem::last_write_time (*it)), mKey);
+        }
+
+        mEntries.clear();
+        mChanged = false;
+
+        boost::filesystem::ifstream stream (mFile, std::ios::binary);
+        if (!stream.is_open())
+            return;
+
+        try
+        {
+            boost::uint32_t magic = 0;
+            boost::uint64_t key = 0;
+            read (stream, magic);
+            read (stream, key);
+            if (magic != sMagic || key != mKey)
+            {
+                std::cout << "Script cache " << mFile.string() << " is outdated" << std::endl;
+                // Replace it with the scripts of the current content files
+                mChanged = true;
+                return;
+            }
+
+            boost::uint32_t count = 0;
+            read (stream, count);
+
+            std::map<std::string, Entry> entries;
+            for (boost::uint32_t i=0; i<count; ++i)
+            {
+                std::string name;
+                read (stream, name);
+
+                Entry& entry = entries[name];
+                read (stream, entry.mTextHash);
+
+                boost::uint32_t size = 0;
+                read (stream, size);
+                entry.mCode.resize (size);
+                if (size && !stream.read (reinterpret_cast<char*> (&entry.mCode[0]), size * sizeof (Interpreter::Type_Code)))
+                    throw std::runtime_error ("unexpected end of file");
+
+                for (int type=0; type<3; ++type)
+                {
+                    read (stream, size);
+                    entry.mLocals[type].resize (size);
+                    for (boost::uint32_t local=0; local<size; ++local)
+                        read (stream, entry.mLocals[type][local]);
+                }
+            }
+
+            mEntries.swap (entries);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to read script cache " << mFile.string() << ": " << e.what() << std::endl;
+            mChanged = true;
+        }
+    }
+
+    bool ScriptCache::get (const std::string& name, const std::string& text,
+        std::vector<Interpreter::Type_Code>& code, Compiler::Locals& locals) const
+    {
+        std::map<std::string, Entry>::const_iterator found = mEntries.find (Misc::StringUtils::lowerCase (name));
+        if (found == mEntries.end() || found->second.mTextHash != hash (text, sHashBasis))
+            return false;
+
+        code = found->second.mCode;
+
+        locals.clear();
+        for (int type=0; type<3; ++type)
+        {
+            const std::vector<std::string>& names = found->second.mLocals[type];
+            for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+                locals.declare (sLocalTypes[type], *it);
+        }
+
+        return true;
+    }
+
+    void ScriptCache::add (const std::string& name, const std::string& text,
+        const std::vector<Interpreter::Type_Code>& code, const Compiler::Locals& locals)
+    {
+        Entry& entry = mEntries[Misc::StringUtils::lowerCase (name)];
+        entry.mTextHash = hash (text, sHashBasis);
+        entry.mCode = code;
+        for (int type=0; type<3; ++type)
+            entry.mLocals[type] = locals.get (sLocalTypes[type]);
+
+        mChanged = true;
+    }
+
+    void ScriptCache::save()
+    {
+        if (!mChanged)
+            return;
+
+        // Write to a temporary file first, so the cache is never left half written
+        boost::filesystem::path tempFile = mFile;
+        tempFile += ".tmp";
+
+        try
+        {
+            if (mFile.has_parent_path() && !boost::filesystem::exists (mFile.parent_path()))
+                boost::filesystem::create_directories (mFile.parent_path());
+
+            {
+                boost::filesystem::ofstream stream (tempFile, std::ios::binary | std::ios::out | std::ios::trunc);
+                if (!stream.is_open())
+                    throw std::runtime_error ("can not open file for writing");
+                stream.exceptions (std::ios::failbit | std::ios::badbit);
+
+                write (stream, sMagic);
+                write (stream, mKey);
+                write (stream, static_cast<boost::uint32_t> (mEntries.size()));
+
+                for (std::map<std::string, Entry>::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+                {
+                    write (stream, it->first);
+                    write (stream, it->second.mTextHash);
+
+                    const std::vector<Interpreter::Type_Code>& code = it->second.mCode;
+                    write (stream, static_cast<boost::uint32_t> (code.size()));
+                    if (!code.empty())
+                        stream.write (reinterpret_cast<const char*> (&code[0]), code.size() * sizeof (Interpreter::Type_Code));
+
+                    for (int type=0; type<3; ++type)
+                    {
+                        const std::vector<std::string>& names = it->second.mLocals[type];
+                        write (stream, static_cast<boost::uint32_t> (names.size()));
+                        for (std::vector<std::string>::const_iterator name = names.begin(); name != names.end(); ++name)
+                            write (stream, *name);
+                    }
+                }
+            }
+
+            boost::filesystem::rename (tempFile, mFile);
+            mChanged = false;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to write script cache " << mFile.string() << ": " << e.what() << std::endl;
+            boost::system::error_code ec;
+            boost::filesystem::remove (tempFile, ec);
+        }
+    }
+}
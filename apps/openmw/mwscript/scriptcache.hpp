@@ -0,0 +1,65 @@
+#ifndef GAME_SCRIPT_SCRIPTCACHE_H
+#define GAME_SCRIPT_SCRIPTCACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/cstdint.hpp>
+
+#include <components/compiler/locals.hpp>
+
+#include <components/interpreter/types.hpp>
+
+namespace MWScript
+{
+    /// @brief Persistent cache of compiled scripts, so that scripts do not have to be compiled again on the next start.
+    /// @par Compiling a script depends on more than its text: on the global variables, the IDs of objects and the
+    /// locals of other scripts. The cache is therefore only used if it was made from the same content files, in the
+    /// same order and unchanged in size or modification time, with the same version of the engine and the same
+    /// keywords. Each script is then looked up by a hash of its text.
+    class ScriptCache
+    {
+        public:
+
+            ScriptCache (const boost::filesystem::path& file);
+
+            /// Read all scripts from the cache file at once. A missing, outdated or damaged file just leaves the
+            /// cache empty.
+            /// @param version Description of the engine version
+            /// @param keywords Keywords of all known instructions and functions
+            /// @param contentFiles Paths of the content files, in load order
+            void load (const std::string& version, const std::vector<std::string>& keywords,
+                const std::vector<boost::filesystem::path>& contentFiles);
+
+            /// Get the compiled script with the given name, if its text is unchanged.
+            /// @return Was the script found?
+            bool get (const std::string& name, const std::string& text,
+                std::vector<Interpreter::Type_Code>& code, Compiler::Locals& locals) const;
+
+            /// Add a successfully compiled script.
+            void add (const std::string& name, const std::string& text,
+                const std::vector<Interpreter::Type_Code>& code, const Compiler::Locals& locals);
+
+            /// Write the cache file, if scripts were added since loading.
+            /// @note Errors are logged and otherwise ignored, the cache is an optimization only.
+            void save();
+
+        private:
+
+            struct Entry
+            {
+                boost::uint64_t mTextHash;
+                std::vector<Interpreter::Type_Code> mCode;
+                std::vector<std::string> mLocals[3];
+            };
+
+            boost::filesystem::path mFile;
+            boost::uint64_t mKey;
+            std::map<std::string, Entry> mEntries;
+            bool mChanged;
+    };
+}
+
+#endif
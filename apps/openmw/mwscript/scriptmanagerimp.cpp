@@ -6,6 +6,8 @@
 #include <exception>
 #include <algorithm>
 
+#include <osg/Timer>
+
 #include <components/esm/loadscpt.hpp>
 
 #include <components/misc/stringops.hpp>
@@ -13,20 +15,51 @@
 #include <components/compiler/scanner.hpp>
 #include <components/compiler/context.hpp>
 #include <components/compiler/exception.hpp>
+#include <components/compiler/generator.hpp>
+#include <components/compiler/optimizer.hpp>
 #include <components/compiler/quickfileparser.hpp>
 
+#include <components/sceneutil/workqueue.hpp>
+
 #include "../mwworld/esmstore.hpp"
 
 #include "extensions.hpp"
+#include "scriptcache.hpp"
+#include "compilercontext.hpp"
+
+namespace
+{
+    const size_t sPrecompileBatchSize = 64;
+}
 
 namespace MWScript
 {
+    class PrecompileItem : public SceneUtil::WorkItem
+    {
+        public:
+
+            PrecompileItem (ScriptManager& scriptManager, const std::vector<std::string>& names)
+            : mScriptManager (scriptManager), mNames (names)
+            {}
+
+            virtual void doWork()
+            {
+                mScriptManager.precompile (mNames, *mTicket);
+                mTicket->signalDone();
+            }
+
+        private:
+
+            ScriptManager& mScriptManager;
+            std::vector<std::string> mNames;
+    };
+
     ScriptManager::ScriptManager (const MWWorld::ESMStore& store, bool verbose,
         Compiler::Context& compilerContext, int warningsMode,
-        const std::vector<std::string>& scriptBlacklist)
+        const std::vector<std::string>& scriptBlacklist, ScriptCache* cache)
     : mErrorHandler (std::cerr), mStore (store), mVerbose (verbose),
       mCompilerContext (compilerContext), mParser (mErrorHandler, mCompilerContext),
-      mOpcodesInstalled (false), mGlobalScripts (store)
+      mOpcodesInstalled (false), mGlobalScripts (store), mWarningsMode (warningsMode), mCache (cache)
     {
         mErrorHandler.setWarningsMode (warningsMode);
 
@@ -37,13 +70,43 @@ namespace MWScript
         std::sort (mScriptBlacklist.begin(), mScriptBlacklist.end());
     }
 
+    ScriptManager::~ScriptManager()
+    {
+        for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mPrecompileTickets.begin();
+            it != mPrecompileTickets.end(); ++it)
+            (*it)->cancel();
+        waitForPrecompilation();
+
+        if (mCache.get())
+            mCache->save();
+    }
+
     bool ScriptManager::compile (const std::string& name)
     {
-        mParser.reset();
-        mErrorHandler.reset();
+        return compile (name, mParser, mErrorHandler, mCompilerContext);
+    }
+
+    bool ScriptManager::compile (const std::string& name, Compiler::FileParser& parser,
+        Compiler::StreamErrorHandler& errorHandler, const Compiler::Context& context)
+    {
+        parser.reset();
+        errorHandler.reset();
 
         if (const ESM::Script *script = mStore.get<ESM::Script>().find (name))
         {
+            if (mCache.get())
+            {
+                std::vector<Interpreter::Type_Code> code;
+                Compiler::Locals locals;
+
+                boost::mutex::scoped_lock lock (mMutex);
+                if (mCache->get (name, script->mScriptText, code, locals))
+                {
+                    mScripts.insert (std::make_pair (name, std::make_pair (Interpreter::Program (code), locals)));
+                    return true;
+                }
+            }
+
             if (mVerbose)
                 std::cout << "compiling script: " << name << std::endl;
 
@@ -52,11 +115,11 @@ namespace MWScript
             {
                 std::istringstream input (script->mScriptText);
 
-                Compiler::Scanner scanner (mErrorHandler, input, mCompilerContext.getExtensions());
+                Compiler::Scanner scanner (errorHandler, input, context.getExtensions());
 
-                scanner.scan (mParser);
+                scanner.scan (parser);
 
-                if (!mErrorHandler.isGood())
+                if (!errorHandler.isGood())
                     Success = false;
             }
             catch (const Compiler::SourceException&)
@@ -81,8 +144,13 @@ namespace MWScript
             if (Success)
             {
                 std::vector<Interpreter::Type_Code> code;
-                mParser.getCode (code);
-                mScripts.insert (std::make_pair (name, std::make_pair (code, mParser.getLocals())));
+                parser.getCode (code);
+                Compiler::optimize (code);
+
+                boost::mutex::scoped_lock lock (mMutex);
+                if (mCache.get())
+                    mCache->add (name, script->mScriptText, code, parser.getLocals());
+                mScripts.insert (std::make_pair (name, std::make_pair (Interpreter::Program (code), parser.getLocals())));
 
                 return true;
             }
@@ -94,19 +162,19 @@ namespace MWScript
     void ScriptManager::run (const std::string& name, Interpreter::Context& interpreterContext)
     {
         // compile script
-        ScriptCollection::iterator iter = mScripts.find (name);
+        ScriptCollection::iterator iter = findScript (name);
 
         if (iter==mScripts.end())
         {
             if (!compile (name))
             {
                 // failed -> ignore script from now on.
-                std::vector<Interpreter::Type_Code> empty;
-                mScripts.insert (std::make_pair (name, std::make_pair (empty, Compiler::Locals())));
+                boost::mutex::scoped_lock lock (mMutex);
+                mScripts.insert (std::make_pair (name, std::make_pair (Interpreter::Program(), Compiler::Locals())));
                 return;
             }
 
-            iter = mScripts.find (name);
+            iter = findScript (name);
             assert (iter!=mScripts.end());
         }
 
@@ -120,7 +188,18 @@ namespace MWScript
                     mOpcodesInstalled = true;
                 }
 
-                mInterpreter.run (&iter->second.first[0], iter->second.first.size(), interpreterContext);
+                if (mProfile.isEnabled())
+                {
+                    const unsigned long instructions = mInterpreter.getExecutedInstructions();
+                    const osg::Timer_t start = osg::Timer::instance()->tick();
+
+                    mInterpreter.run (iter->second.first, interpreterContext);
+
+                    mProfile.add (name, osg::Timer::instance()->delta_s (start, osg::Timer::instance()->tick()),
+                        mInterpreter.getExecutedInstructions() - instructions);
+                }
+                else
+                    mInterpreter.run (iter->second.first, interpreterContext);
             }
             catch (const std::exception& e)
             {
@@ -149,6 +228,12 @@ namespace MWScript
                     ++success;
             }
 
+        if (mCache.get())
+        {
+            boost::mutex::scoped_lock lock (mMutex);
+            mCache->save();
+        }
+
         return std::make_pair (count, success);
     }
 
@@ -157,17 +242,17 @@ namespace MWScript
         std::string name2 = Misc::StringUtils::lowerCase (name);
 
         {
+            boost::mutex::scoped_lock lock (mMutex);
+
             ScriptCollection::iterator iter = mScripts.find (name2);
 
             if (iter!=mScripts.end())
                 return iter->second.second;
-        }
 
-        {
-            std::map<std::string, Compiler::Locals>::iterator iter = mOtherLocals.find (name2);
+            std::map<std::string, Compiler::Locals>::iterator iter2 = mOtherLocals.find (name2);
 
-            if (iter!=mOtherLocals.end())
-                return iter->second;
+            if (iter2!=mOtherLocals.end())
+                return iter2->second;
         }
 
         if (const ESM::Script *script = mStore.get<ESM::Script>().search (name2))
@@ -179,11 +264,16 @@ namespace MWScript
 
             Compiler::Locals locals;
 
+            // Not mErrorHandler, this may be called while compiling in the background
+            Compiler::StreamErrorHandler errorHandler (std::cerr);
+            errorHandler.setWarningsMode (mWarningsMode);
+
             std::istringstream stream (script->mScriptText);
-            Compiler::QuickFileParser parser (mErrorHandler, mCompilerContext, locals);
-            Compiler::Scanner scanner (mErrorHandler, stream, mCompilerContext.getExtensions());
+            Compiler::QuickFileParser parser (errorHandler, mCompilerContext, locals);
+            Compiler::Scanner scanner (errorHandler, stream, mCompilerContext.getExtensions());
             scanner.scan (parser);
 
+            boost::mutex::scoped_lock lock (mMutex);
             std::map<std::string, Compiler::Locals>::iterator iter =
                 mOtherLocals.insert (std::make_pair (name2, locals)).first;
 
@@ -193,8 +283,88 @@ namespace MWScript
         throw std::logic_error ("script " + name + " does not exist");
     }
 
+    bool ScriptManager::canThrottle (const std::string& name)
+    {
+        std::map<std::string, bool>::const_iterator found = mThrottleable.find (name);
+        if (found != mThrottleable.end())
+            return found->second;
+
+        ScriptCollection::iterator iter = findScript (name);
+        if (iter == mScripts.end())
+            return false;
+
+        // GetSecondsPassed returns the duration of the last frame, not the time since the script last ran
+        const bool throttleable = iter->second.second.getIndex ("nothrottle") == -1 &&
+            !iter->second.first.contains (Compiler::Generator::segment5 (50));
+
+        mThrottleable.insert (std::make_pair (name, throttleable));
+        return throttleable;
+    }
+
+    void ScriptManager::startPrecompilation (SceneUtil::WorkQueue* workQueue)
+    {
+        const MWWorld::Store<ESM::Script>& scripts = mStore.get<ESM::Script>();
+
+        std::vector<std::string> names;
+        for (MWWorld::Store<ESM::Script>::iterator iter = scripts.begin(); iter != scripts.end(); ++iter)
+            if (!std::binary_search (mScriptBlacklist.begin(), mScriptBlacklist.end(),
+                Misc::StringUtils::lowerCase (iter->mId)))
+                names.push_back (iter->mId);
+
+        // Small batches at a low priority, so that the loading of resources is not held up for long
+        for (size_t begin = 0; begin < names.size(); begin += sPrecompileBatchSize)
+        {
+            std::vector<std::string> batch (names.begin() + begin,
+                names.begin() + std::min (begin + sPrecompileBatchSize, names.size()));
+            mPrecompileTickets.push_back (workQueue->addWorkItem (new PrecompileItem (*this, batch), -1));
+        }
+    }
+
+    void ScriptManager::waitForPrecompilation()
+    {
+        for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mPrecompileTickets.begin();
+            it != mPrecompileTickets.end(); ++it)
+            (*it)->waitTillDone();
+        mPrecompileTickets.clear();
+    }
+
+    void ScriptManager::precompile (const std::vector<std::string>& names, SceneUtil::WorkTicket& ticket)
+    {
+        Compiler::StreamErrorHandler errorHandler (std::cerr);
+        errorHandler.setWarningsMode (mWarningsMode);
+
+        CompilerContext context (CompilerContext::Type_Full, mStore, *this);
+        context.setExtensions (mCompilerContext.getExtensions());
+
+        Compiler::FileParser parser (errorHandler, context);
+
+        for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end() && !ticket.isCancelled(); ++it)
+        {
+            if (findScript (*it) != mScripts.end())
+                continue;
+
+            if (!compile (*it, parser, errorHandler, context))
+            {
+                // failed -> ignore script from now on, like run() does
+                boost::mutex::scoped_lock lock (mMutex);
+                mScripts.insert (std::make_pair (*it, std::make_pair (Interpreter::Program(), Compiler::Locals())));
+            }
+        }
+    }
+
+    ScriptManager::ScriptCollection::iterator ScriptManager::findScript (const std::string& name)
+    {
+        boost::mutex::scoped_lock lock (mMutex);
+        return mScripts.find (name);
+    }
+
     GlobalScripts& ScriptManager::getGlobalScripts()
     {
         return mGlobalScripts;
     }
+
+    ScriptProfile& ScriptManager::getProfile()
+    {
+        return mProfile;
+    }
 }
@@ -2,7 +2,13 @@
 #define GAME_SCRIPT_SCRIPTMANAGER_H
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include <osg/ref_ptr>
 
 #include <components/compiler/streamerrorhandler.hpp>
 #include <components/compiler/fileparser.hpp>
@@ -13,6 +19,7 @@
 #include "../mwbase/scriptmanager.hpp"
 
 #include "globalscripts.hpp"
+#include "scriptprofile.hpp"
 
 namespace MWWorld
 {
@@ -24,6 +31,12 @@ namespace Compiler
     class Context;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+    class WorkTicket;
+}
+
 namespace Interpreter
 {
     class Context;
@@ -32,6 +45,9 @@ namespace Interpreter
 
 namespace MWScript
 {
+    class ScriptCache;
+    class PrecompileItem;
+
     class ScriptManager : public MWBase::ScriptManager
     {
             Compiler::StreamErrorHandler mErrorHandler;
@@ -42,19 +58,40 @@ namespace MWScript
             Interpreter::Interpreter mInterpreter;
             bool mOpcodesInstalled;
 
-            typedef std::pair<std::vector<Interpreter::Type_Code>, Compiler::Locals> CompiledScript;
+            typedef std::pair<Interpreter::Program, Compiler::Locals> CompiledScript;
             typedef std::map<std::string, CompiledScript> ScriptCollection;
 
             ScriptCollection mScripts;
             GlobalScripts mGlobalScripts;
             std::map<std::string, Compiler::Locals> mOtherLocals;
+            std::map<std::string, bool> mThrottleable;
+            ScriptProfile mProfile;
             std::vector<std::string> mScriptBlacklist;
+            int mWarningsMode;
+            std::auto_ptr<ScriptCache> mCache;
+
+            // Guards mScripts, mOtherLocals and mCache, which scripts compiled in the background are added to
+            boost::mutex mMutex;
+            std::vector<osg::ref_ptr<SceneUtil::WorkTicket> > mPrecompileTickets;
+
+            friend class PrecompileItem;
+
+            bool compile (const std::string& name, Compiler::FileParser& parser,
+                Compiler::StreamErrorHandler& errorHandler, const Compiler::Context& context);
+
+            /// Compile the given scripts, unless they are compiled already. Stops early if the ticket is cancelled.
+            void precompile (const std::vector<std::string>& names, SceneUtil::WorkTicket& ticket);
+
+            ScriptCollection::iterator findScript (const std::string& name);
 
         public:
 
+            /// @param cache Cache of compiled scripts, may be NULL. Ownership is transferred.
             ScriptManager (const MWWorld::ESMStore& store, bool verbose,
                 Compiler::Context& compilerContext, int warningsMode,
-                const std::vector<std::string>& scriptBlacklist);
+                const std::vector<std::string>& scriptBlacklist, ScriptCache* cache = NULL);
+
+            virtual ~ScriptManager();
 
             virtual void run (const std::string& name, Interpreter::Context& interpreterContext);
             ///< Run the script with the given name (compile first, if not compiled yet)
@@ -70,7 +107,19 @@ namespace MWScript
             virtual const Compiler::Locals& getLocals (const std::string& name);
             ///< Return locals for script \a name.
 
+            virtual bool canThrottle (const std::string& name);
+            ///< May script \a name be run less often than once per frame?
+
             virtual GlobalScripts& getGlobalScripts();
+
+            virtual ScriptProfile& getProfile();
+
+            /// Compile all scripts on the threads of the given work queue, so that run() does not have to compile
+            /// them later on.
+            /// @note The records of the store must not change until waitForPrecompilation() returns.
+            void startPrecompilation (SceneUtil::WorkQueue* workQueue);
+
+            virtual void waitForPrecompilation();
     };
 }
 
@@ -0,0 +1,86 @@
+#include "scriptprofile.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    struct TotalTimeGreater
+    {
+        bool operator() (const std::pair<std::string, MWScript::ScriptProfile::Entry>& left,
+            const std::pair<std::string, MWScript::ScriptProfile::Entry>& right) const
+        {
+            return left.second.mTotalTime > right.second.mTotalTime;
+        }
+    };
+}
+
+namespace MWScript
+{
+    ScriptProfile::Entry::Entry()
+    : mCalls (0), mTotalTime (0), mMaxTime (0), mInstructions (0)
+    {}
+
+    ScriptProfile::ScriptProfile()
+    : mEnabled (false)
+    {}
+
+    bool ScriptProfile::isEnabled() const
+    {
+        return mEnabled;
+    }
+
+    void ScriptProfile::setEnabled (bool enabled)
+    {
+        if (enabled && !mEnabled)
+            clear();
+        mEnabled = enabled;
+    }
+
+    void ScriptProfile::add (const std::string& name, double time, unsigned long instructions)
+    {
+        Entry& entry = mEntries[name];
+        ++entry.mCalls;
+        entry.mTotalTime += time;
+        entry.mMaxTime = std::max (entry.mMaxTime, time);
+        entry.mInstructions += instructions;
+    }
+
+    void ScriptProfile::clear()
+    {
+        mEntries.clear();
+    }
+
+    void ScriptProfile::getSorted (SortedEntries& entries) const
+    {
+        entries.assign (mEntries.begin(), mEntries.end());
+        std::stable_sort (entries.begin(), entries.end(), TotalTimeGreater());
+    }
+
+    void ScriptProfile::writeCsv (std::ostream& stream) const
+    {
+        SortedEntries entries;
+        getSorted (entries);
+
+        stream << "script,calls,total ms,max ms,mean ms,instructions,instructions per call\n";
+        for (SortedEntries::const_iterator it = entries.begin(); it != entries.end(); ++it)
+        {
+            const Entry& entry = it->second;
+            // IDs may contain commas and spaces, so always quote them
+            std::string name;
+            for (std::string::const_iterator c = it->first.begin(); c != it->first.end(); ++c)
+            {
+                if (*c == '"')
+                    name += '"';
+                name += *c;
+            }
+
+            stream << '"' << name << "\","
+                   << entry.mCalls << ','
+                   << entry.mTotalTime * 1000 << ','
+                   << entry.mMaxTime * 1000 << ','
+                   << entry.mTotalTime * 1000 / entry.mCalls << ','
+                   << entry.mInstructions << ','
+                   << entry.mInstructions / entry.mCalls << '\n';
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef GAME_SCRIPT_SCRIPTPROFILE_H
+#define GAME_SCRIPT_SCRIPTPROFILE_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+namespace MWScript
+{
+    /// @brief Execution statistics of each script, collected by the script manager while enabled.
+    /// @note Times and instructions include those of scripts run from within the script, e.g. by activation.
+    class ScriptProfile
+    {
+        public:
+
+            struct Entry
+            {
+                unsigned int mCalls;
+                double mTotalTime; // seconds
+                double mMaxTime; // seconds
+                boost::uint64_t mInstructions;
+
+                Entry();
+            };
+
+            typedef std::vector<std::pair<std::string, Entry> > SortedEntries;
+
+            ScriptProfile();
+
+            bool isEnabled() const;
+
+            /// Start collecting, with the previous statistics cleared, or stop collecting.
+            void setEnabled (bool enabled);
+
+            void add (const std::string& name, double time, unsigned long instructions);
+
+            void clear();
+
+            /// Get the statistics of all scripts, the most expensive in total first.
+            void getSorted (SortedEntries& entries) const;
+
+            /// Write the statistics of all scripts as comma separated values, with a header line.
+            void writeCsv (std::ostream& stream) const;
+
+        private:
+
+            bool mEnabled;
+            std::map<std::string, Entry> mEntries;
+    };
+}
+
+#endif
@@ -84,7 +84,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string region = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& region = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Integer id = runtime[0].mInteger;
@@ -100,7 +100,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime, unsigned int arg0)
                 {
-                    std::string region = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& region = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     std::vector<char> chances;
@@ -31,10 +31,10 @@ namespace MWScript
                     MWScript::InterpreterContext& context
                         = static_cast<MWScript::InterpreterContext&> (runtime.getContext());
 
-                    std::string file = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& file = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
-                    std::string text = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& text = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWBase::Environment::get().getSoundManager()->say (ptr, file);
@@ -63,7 +63,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string sound = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& sound = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWBase::Environment::get().getSoundManager()->streamMusic (sound);
@@ -76,7 +76,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string sound = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& sound = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWBase::Environment::get().getSoundManager()->playSound (sound, 1.0, 1.0);
@@ -89,7 +89,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string sound = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& sound = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Float volume = runtime[0].mFloat;
@@ -115,7 +115,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string sound = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& sound = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWBase::Environment::get().getSoundManager()->playSound3D(ptr, sound, 1.0, 1.0,
@@ -138,7 +138,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string sound = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& sound = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Float volume = runtime[0].mFloat;
@@ -164,7 +164,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string sound = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& sound = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWBase::Environment::get().getSoundManager()->stopSound3D (ptr, sound);
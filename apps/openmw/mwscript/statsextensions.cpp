@@ -435,7 +435,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string id = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& id = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     // make sure a spell with this ID actually exists.
@@ -478,7 +478,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string spellid = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& spellid = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     ptr.getClass().getCreatureStats (ptr).getActiveSpells().removeEffects(spellid);
@@ -511,7 +511,7 @@ namespace MWScript
 
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string id = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& id = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Integer value = 0;
@@ -727,7 +727,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string id = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& id = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime[0].mInteger = MWBase::Environment::get().getMechanicsManager()->countDeaths (id);
                 }
         };
@@ -83,7 +83,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
                     Interpreter::Type_Float angle = osg::DegreesToRadians(runtime[0].mFloat);
                     runtime.pop();
@@ -112,7 +112,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     if (axis == "x")
@@ -141,7 +141,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     if (axis=="x")
@@ -170,7 +170,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     if(axis == "x")
@@ -207,7 +207,7 @@ namespace MWScript
                         MWBase::Environment::get().getWorld()->getPlayer().setTeleported(true);
                     }
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
                     Interpreter::Type_Float pos = runtime[0].mFloat;
                     runtime.pop();
@@ -245,7 +245,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     if(axis == "x")
@@ -290,7 +290,7 @@ namespace MWScript
                     runtime.pop();
                     Interpreter::Type_Float zRot = runtime[0].mFloat;
                     runtime.pop();
-                    std::string cellID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& cellID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     MWWorld::CellStore* store = 0;
@@ -393,9 +393,9 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string itemID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& itemID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
-                    std::string cellID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& cellID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Float x = runtime[0].mFloat;
@@ -447,7 +447,7 @@ namespace MWScript
 
                 virtual void execute (Interpreter::Runtime& runtime)
                 {
-                    std::string itemID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& itemID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Float x = runtime[0].mFloat;
@@ -498,7 +498,7 @@ namespace MWScript
                         ? MWMechanics::getPlayer()
                         : R()(runtime);
 
-                    std::string itemID = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& itemID = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
 
                     Interpreter::Type_Integer count = runtime[0].mInteger;
@@ -561,7 +561,7 @@ namespace MWScript
                 {
                     const MWWorld::Ptr& ptr = R()(runtime);
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
                     Interpreter::Type_Float rotation = osg::DegreesToRadians(runtime[0].mFloat*MWBase::Environment::get().getFrameDuration());
                     runtime.pop();
@@ -590,7 +590,7 @@ namespace MWScript
                 {
                     MWWorld::Ptr ptr = R()(runtime);
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
                     Interpreter::Type_Float rotation = osg::DegreesToRadians(runtime[0].mFloat*MWBase::Environment::get().getFrameDuration());
                     runtime.pop();
@@ -655,7 +655,7 @@ namespace MWScript
                     if (!ptr.isInCell())
                         return;
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
                     Interpreter::Type_Float movement = (runtime[0].mFloat*MWBase::Environment::get().getFrameDuration());
                     runtime.pop();
@@ -699,7 +699,7 @@ namespace MWScript
                     if (!ptr.isInCell())
                         return;
 
-                    std::string axis = runtime.getStringLiteral (runtime[0].mInteger);
+                    const std::string& axis = runtime.getStringLiteral (runtime[0].mInteger);
                     runtime.pop();
                     Interpreter::Type_Float movement = (runtime[0].mFloat*MWBase::Environment::get().getFrameDuration());
                     runtime.pop();
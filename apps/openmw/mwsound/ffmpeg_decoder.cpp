@@ -8,6 +8,16 @@
 
 #include <components/vfs/manager.hpp>
 
+namespace
+{
+    // The size of the buffer between the VFS stream and the demuxer. Without a buffer, every read of the demuxer,
+    // down to single header fields, goes through the stream.
+    const int sIOBufferSize = 32768;
+
+    // The most memory readAll reserves up front from the duration of the stream, in case the duration is wrong
+    const size_t sMaxReserveSize = 16*1024*1024;
+}
+
 namespace MWSound
 {
 
@@ -188,25 +198,33 @@ void FFmpeg_Decoder::open(const std::string &fname)
     if((mFormatCtx=avformat_alloc_context()) == NULL)
         fail("Failed to allocate context");
 
-    mFormatCtx->pb = avio_alloc_context(NULL, 0, 0, this, readPacket, writePacket, seek);
-    if(!mFormatCtx->pb || avformat_open_input(&mFormatCtx, fname.c_str(), NULL, NULL) != 0)
+    unsigned char* buffer = static_cast<unsigned char*>(av_malloc(sIOBufferSize));
+    if(!buffer)
+    {
+        avformat_free_context(mFormatCtx);
+        mFormatCtx = NULL;
+        fail("Failed to allocate input buffer");
+    }
+
+    AVIOContext* pb = avio_alloc_context(buffer, sIOBufferSize, 0, this, readPacket, writePacket, seek);
+    if(!pb)
+    {
+        av_free(buffer);
+        avformat_free_context(mFormatCtx);
+        mFormatCtx = NULL;
+        fail("Failed to allocate input stream");
+    }
+
+    mFormatCtx->pb = pb;
+    if(avformat_open_input(&mFormatCtx, fname.c_str(), NULL, NULL) != 0)
     {
-        // "Note that a user-supplied AVFormatContext will be freed on failure".
+        // "Note that a user-supplied AVFormatContext will be freed on failure", but not the user-supplied AVIOContext.
+        // The buffer may have been replaced by the demuxer.
         if (mFormatCtx)
-        {
-            if (mFormatCtx->pb != NULL)
-            {
-                if (mFormatCtx->pb->buffer != NULL)
-                {
-                    av_free(mFormatCtx->pb->buffer);
-                    mFormatCtx->pb->buffer = NULL;
-                }
-                av_free(mFormatCtx->pb);
-                mFormatCtx->pb = NULL;
-            }
             avformat_free_context(mFormatCtx);
-        }
         mFormatCtx = NULL;
+        av_free(pb->buffer);
+        av_free(pb);
         fail("Failed to allocate input stream");
     }
 
@@ -380,6 +398,17 @@ void FFmpeg_Decoder::readAll(std::vector<char> &output)
     if(!mStream)
         fail("No audio stream");
 
+    // Reserve the decoded size of the stream, so that the data of short sounds is decoded without reallocations
+    if((*mStream)->duration != (int64_t)AV_NOPTS_VALUE && (*mStream)->duration > 0)
+    {
+        double samples = (*mStream)->duration * av_q2d((*mStream)->time_base) * (*mStream)->codec->sample_rate;
+        size_t frameSize = av_get_channel_layout_nb_channels(mOutputChannelLayout) *
+                           av_get_bytes_per_sample(mOutputSampleFormat);
+        double size = samples * frameSize;
+        if(size > 0.0 && size <= sMaxReserveSize)
+            output.reserve(output.size() + static_cast<size_t>(size));
+    }
+
     while(getAVAudioData())
     {
         size_t got = mFrame->nb_samples * av_get_channel_layout_nb_channels(mOutputChannelLayout) *
@@ -1,6 +1,7 @@
 #include "loudness.hpp"
 
 #include <stdint.h>
+#include <cmath>
 #include <limits>
 
 #include "soundmanagerimp.hpp"
@@ -8,54 +9,78 @@
 namespace MWSound
 {
 
-void Sound_Loudness::analyzeLoudness(const std::vector< char >& data, int sampleRate, ChannelConfig chans, SampleType type, float valuesPerSecond)
+void Sound_Loudness::startAnalysis(int sampleRate, ChannelConfig chans, SampleType type, float valuesPerSecond)
 {
-    int samplesPerSegment = static_cast<int>(sampleRate / valuesPerSecond);
-    int numSamples = bytesToFrames(data.size(), chans, type);
-    int advance = framesToBytes(1, chans, type);
+    mSamplesPerSegment = std::max(static_cast<int>(sampleRate / valuesPerSecond), 1);
+    mChannelConfig = chans;
+    mSampleType = type;
 
     mSamplesPerSec = valuesPerSecond;
     mSamples.clear();
-    mSamples.reserve(numSamples/samplesPerSegment);
+    mSegmentSum = 0.0f;
+    mSegmentSamples = 0;
+    mReady = false;
+    mAnalyzing = true;
+}
+
+void Sound_Loudness::appendData(const char *data, size_t size)
+{
+    if(!mAnalyzing)
+        return;
 
-    int segment=0;
-    int sample=0;
-    while (segment < numSamples/samplesPerSegment)
+    size_t numSamples = bytesToFrames(size, mChannelConfig, mSampleType);
+    size_t advance = framesToBytes(1, mChannelConfig, mSampleType);
+
+    for(size_t sample = 0;sample < numSamples;++sample)
     {
-        float sum=0;
-        int samplesAdded = 0;
-        while (sample < numSamples && sample < (segment+1)*samplesPerSegment)
+        // get sample on a scale from -1 to 1
+        float value = 0;
+        if (mSampleType == SampleType_UInt8)
+            value = ((char)(data[sample*advance]^0x80))/128.f;
+        else if (mSampleType == SampleType_Int16)
         {
-            // get sample on a scale from -1 to 1
-            float value = 0;
-            if (type == SampleType_UInt8)
-                value = ((char)(data[sample*advance]^0x80))/128.f;
-            else if (type == SampleType_Int16)
-            {
-                value = *reinterpret_cast<const int16_t*>(&data[sample*advance]);
-                value /= float(std::numeric_limits<int16_t>::max());
-            }
-            else if (type == SampleType_Float32)
-            {
-                value = *reinterpret_cast<const float*>(&data[sample*advance]);
-                value = std::max(-1.f, std::min(1.f, value)); // Float samples *should* be scaled to [-1,1] already.
-            }
-
-            sum += value*value;
-            ++samplesAdded;
-            ++sample;
+            value = *reinterpret_cast<const int16_t*>(&data[sample*advance]);
+            value /= float(std::numeric_limits<int16_t>::max());
+        }
+        else if (mSampleType == SampleType_Float32)
+        {
+            value = *reinterpret_cast<const float*>(&data[sample*advance]);
+            value = std::max(-1.f, std::min(1.f, value)); // Float samples *should* be scaled to [-1,1] already.
         }
 
-        float rms = 0; // root mean square
-        if (samplesAdded > 0)
-            rms = std::sqrt(sum / samplesAdded);
-        mSamples.push_back(rms);
-        ++segment;
+        mSegmentSum += value*value;
+        if(++mSegmentSamples == mSamplesPerSegment)
+        {
+            // root mean square
+            mSamples.push_back(std::sqrt(mSegmentSum / mSegmentSamples));
+            mSegmentSum = 0.0f;
+            mSegmentSamples = 0;
+        }
     }
+}
 
+void Sound_Loudness::finishAnalysis()
+{
+    if(!mAnalyzing)
+        return;
+    mAnalyzing = false;
     mReady = true;
 }
 
+void Sound_Loudness::cancelAnalysis()
+{
+    if(!mAnalyzing)
+        return;
+    mAnalyzing = false;
+    mSamples.clear();
+}
+
+void Sound_Loudness::setLoudness(float valuesPerSecond, const std::vector<float> &values)
+{
+    mSamplesPerSec = valuesPerSecond;
+    mSamples = values;
+    mReady = true;
+}
 
 float Sound_Loudness::getLoudnessAtTime(float sec) const
 {
@@ -14,25 +14,54 @@ class Sound_Loudness {
     std::vector<float> mSamples;
     volatile bool mReady;
 
+    // State of the analysis while the sound is decoded
+    bool mAnalyzing;
+    int mSamplesPerSegment;
+    ChannelConfig mChannelConfig;
+    SampleType mSampleType;
+    float mSegmentSum;
+    int mSegmentSamples;
+
 public:
-    Sound_Loudness() : mSamplesPerSec(0.0f), mReady(false) { }
+    Sound_Loudness()
+      : mSamplesPerSec(0.0f), mReady(false), mAnalyzing(false), mSamplesPerSegment(0)
+      , mChannelConfig(ChannelConfig_Mono), mSampleType(SampleType_Int16), mSegmentSum(0.0f), mSegmentSamples(0)
+    { }
 
     /**
-     * Analyzes the energy (closely related to loudness) of a sound buffer.
-     * The buffer will be divided into segments according to \a valuesPerSecond,
+     * Starts analyzing the energy (closely related to loudness) of a sound,
+     * as its samples are passed to appendData while it is decoded.
+     * The sound will be divided into segments according to \a valuesPerSecond,
      * and for each segment a loudness value in the range of [0,1] will be computed.
-     * @param data the sound buffer to analyze, containing raw samples
-     * @param sampleRate the sample rate of the sound buffer
-     * @param chans channel layout of the buffer
-     * @param type sample type of the buffer
+     * @param sampleRate the sample rate of the sound
+     * @param chans channel layout of the sound
+     * @param type sample type of the sound
      * @param valuesPerSecond How many loudness values per second of audio to compute.
      */
-    void analyzeLoudness(const std::vector<char>& data, int sampleRate,
-                         ChannelConfig chans, SampleType type,
-                         float valuesPerSecond);
+    void startAnalysis(int sampleRate, ChannelConfig chans, SampleType type, float valuesPerSecond);
+
+    /// Analyzes the next raw samples of the sound. Incomplete frames at the end are ignored.
+    void appendData(const char *data, size_t size);
+
+    /// Marks the values as complete, after all of the sound was appended. A partial segment at the
+    /// end does not get a value.
+    void finishAnalysis();
+
+    /// Discards the values of an analysis that was not finished, so that it can be started again.
+    void cancelAnalysis();
 
+    bool isAnalyzing() const { return mAnalyzing; }
     bool isReady() { return mReady; }
+
+    /// @note Values are available as soon as their segment was appended.
     float getLoudnessAtTime(float sec) const;
+
+    float getValuesPerSecond() const { return mSamplesPerSec; }
+    const std::vector<float>& getLoudness() const { return mSamples; }
+
+    /// Replaces the values with those of an earlier analysis, see LoudnessCache.
+    /// @note Must not be called while analyzing.
+    void setLoudness(float valuesPerSecond, const std::vector<float> &values);
 };
 
 }
@@ -0,0 +1,196 @@
+#include "loudnesscache.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "loudness.hpp"
+
+namespace
+{
+    const boost::uint32_t sMagic = 0x434c574f; // "OWLC"
+
+    /// Increase when the layout of the cache or the loudness analysis changes
+    const boost::uint32_t sFormatVersion = 1;
+
+    // FNV-1a
+    boost::uint64_t hash (const char* data, size_t size, boost::uint64_t hash)
+    {
+        for (size_t i=0; i<size; ++i)
+        {
+            hash ^= static_cast<unsigned char> (data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    void write (std::ostream& stream, const T& data)
+    {
+        stream.write (reinterpret_cast<const char*> (&data), sizeof (T));
+    }
+
+    void write (std::ostream& stream, const std::string& string)
+    {
+        write (stream, static_cast<boost::uint32_t> (string.size()));
+        stream.write (string.c_str(), string.size());
+    }
+
+    template<typename T>
+    void read (std::istream& stream, T& data)
+    {
+        if (!stream.read (reinterpret_cast<char*> (&data), sizeof (T)))
+            throw std::runtime_error ("unexpected end of file");
+    }
+
+    void read (std::istream& stream, std::string& string)
+    {
+        boost::uint32_t size = 0;
+        read (stream, size);
+        string.resize (size);
+        if (size && !stream.read (&string[0], size))
+            throw std::runtime_error ("unexpected end of file");
+    }
+}
+
+namespace MWSound
+{
+    LoudnessCache::LoudnessCache (const boost::filesystem::path& file)
+    : mFile (file), mKey (0), mChanged (false)
+    {
+    }
+
+    void LoudnessCache::load (const std::string& version)
+    {
+        mKey = hash (version.c_str(), version.size(), 14695981039346656037ull);
+        mKey = hash (reinterpret_cast<const char*> (&sFormatVersion), sizeof (sFormatVersion), mKey);
+
+        mEntries.clear();
+        mChanged = false;
+
+        boost::filesystem::ifstream stream (mFile, std::ios::binary);
+        if (!stream.is_open())
+            return;
+
+        try
+        {
+            boost::uint32_t magic = 0;
+            boost::uint64_t key = 0;
+            read (stream, magic);
+            read (stream, key);
+            if (magic != sMagic || key != mKey)
+            {
+                std::cout << "Loudness cache " << mFile.string() << " is outdated" << std::endl;
+                mChanged = true;
+                return;
+            }
+
+            boost::uint32_t count = 0;
+            read (stream, count);
+
+            std::map<std::string, Entry> entries;
+            for (boost::uint32_t i=0; i<count; ++i)
+            {
+                std::string name;
+                read (stream, name);
+
+                Entry& entry = entries[name];
+                read (stream, entry.mSize);
+                read (stream, entry.mValuesPerSecond);
+
+                boost::uint32_t size = 0;
+                read (stream, size);
+                entry.mValues.resize (size);
+                if (size && !stream.read (reinterpret_cast<char*> (&entry.mValues[0]), size))
+                    throw std::runtime_error ("unexpected end of file");
+            }
+
+            mEntries.swap (entries);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to read loudness cache " << mFile.string() << ": " << e.what() << std::endl;
+            mChanged = true;
+        }
+    }
+
+    bool LoudnessCache::get (const std::string& name, boost::uint64_t size, Sound_Loudness& loudness) const
+    {
+        std::map<std::string, Entry>::const_iterator found = mEntries.find (name);
+        if (found == mEntries.end() || found->second.mSize != size)
+            return false;
+
+        const std::vector<unsigned char>& values = found->second.mValues;
+        std::vector<float> samples (values.size());
+        for (size_t i=0; i<values.size(); ++i)
+            samples[i] = values[i] / 255.f;
+
+        loudness.setLoudness (found->second.mValuesPerSecond, samples);
+        return true;
+    }
+
+    void LoudnessCache::add (const std::string& name, boost::uint64_t size, const Sound_Loudness& loudness)
+    {
+        Entry& entry = mEntries[name];
+        entry.mSize = size;
+        entry.mValuesPerSecond = loudness.getValuesPerSecond();
+
+        const std::vector<float>& samples = loudness.getLoudness();
+        entry.mValues.resize (samples.size());
+        for (size_t i=0; i<samples.size(); ++i)
+            entry.mValues[i] = static_cast<unsigned char> (std::min (std::max (samples[i], 0.f), 1.f) * 255.f + 0.5f);
+
+        mChanged = true;
+    }
+
+    void LoudnessCache::save()
+    {
+        if (!mChanged)
+            return;
+
+        // Write to a temporary file first, so the cache is never left half written
+        boost::filesystem::path tempFile = mFile;
+        tempFile += ".tmp";
+
+        try
+        {
+            if (mFile.has_parent_path() && !boost::filesystem::exists (mFile.parent_path()))
+                boost::filesystem::create_directories (mFile.parent_path());
+
+            {
+                boost::filesystem::ofstream stream (tempFile, std::ios::binary | std::ios::out | std::ios::trunc);
+                if (!stream.is_open())
+                    throw std::runtime_error ("can not open file for writing");
+                stream.exceptions (std::ios::failbit | std::ios::badbit);
+
+                write (stream, sMagic);
+                write (stream, mKey);
+                write (stream, static_cast<boost::uint32_t> (mEntries.size()));
+
+                for (std::map<std::string, Entry>::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+                {
+                    write (stream, it->first);
+                    write (stream, it->second.mSize);
+                    write (stream, it->second.mValuesPerSecond);
+
+                    const std::vector<unsigned char>& values = it->second.mValues;
+                    write (stream, static_cast<boost::uint32_t> (values.size()));
+                    if (!values.empty())
+                        stream.write (reinterpret_cast<const char*> (&values[0]), values.size());
+                }
+            }
+
+            boost::filesystem::rename (tempFile, mFile);
+            mChanged = false;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to write loudness cache " << mFile.string() << ": " << e.what() << std::endl;
+            boost::system::error_code ec;
+            boost::filesystem::remove (tempFile, ec);
+        }
+    }
+}
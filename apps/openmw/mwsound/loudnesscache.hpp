@@ -0,0 +1,56 @@
+#ifndef GAME_SOUND_LOUDNESSCACHE_H
+#define GAME_SOUND_LOUDNESSCACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/cstdint.hpp>
+
+namespace MWSound
+{
+    class Sound_Loudness;
+
+    /// @brief Persistent cache of the loudness ("lip") data of voice files, so that voices played in an earlier
+    /// session do not have to be analyzed again. Each voice is looked up by its file name and size.
+    class LoudnessCache
+    {
+        public:
+
+            LoudnessCache (const boost::filesystem::path& file);
+
+            /// Read all voices from the cache file at once. A missing, outdated or damaged file just leaves the
+            /// cache empty.
+            /// @param version Description of the engine version
+            void load (const std::string& version);
+
+            /// Get the loudness of the voice with the given name, if its file size is unchanged.
+            /// @return Was the voice found?
+            bool get (const std::string& name, boost::uint64_t size, Sound_Loudness& loudness) const;
+
+            /// Add the completely analyzed loudness of a voice.
+            void add (const std::string& name, boost::uint64_t size, const Sound_Loudness& loudness);
+
+            /// Write the cache file, if voices were added since loading.
+            /// @note Errors are logged and otherwise ignored, the cache is an optimization only.
+            void save();
+
+        private:
+
+            struct Entry
+            {
+                boost::uint64_t mSize;
+                float mValuesPerSecond;
+                // Loudness values in [0,1], quantized to 1/255
+                std::vector<unsigned char> mValues;
+            };
+
+            boost::filesystem::path mFile;
+            boost::uint64_t mKey;
+            std::map<std::string, Entry> mEntries;
+            bool mChanged;
+    };
+}
+
+#endif
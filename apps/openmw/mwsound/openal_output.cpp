@@ -41,6 +41,17 @@ ALC_API ALCboolean ALC_APIENTRY alcResetDeviceSOFT(ALCdevice *device, const ALCi
 #endif
 #endif
 
+#ifndef AL_SOFT_deferred_updates
+#define AL_SOFT_deferred_updates 1
+#define AL_DEFERRED_UPDATES_SOFT                 0xC002
+typedef ALvoid (AL_APIENTRY*LPALDEFERUPDATESSOFT)(void);
+typedef ALvoid (AL_APIENTRY*LPALPROCESSUPDATESSOFT)(void);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API ALvoid AL_APIENTRY alDeferUpdatesSOFT(void);
+AL_API ALvoid AL_APIENTRY alProcessUpdatesSOFT(void);
+#endif
+#endif
+
 
 #define MAKE_PTRID(id) ((void*)(uintptr_t)id)
 #define GET_PTRID(ptr) ((ALuint)(uintptr_t)ptr)
@@ -64,6 +75,13 @@ void getFunc(T& func, ALCdevice *device, const char *name)
     convertPointer(func, funcPtr);
 }
 
+template<typename T>
+void getFunc(T& func, const char *name)
+{
+    void* funcPtr = alGetProcAddress(name);
+    convertPointer(func, funcPtr);
+}
+
 }
 
 namespace MWSound
@@ -196,21 +214,37 @@ static ALenum getALFormat(ChannelConfig chans, SampleType type)
 class OpenAL_SoundStream
 {
     static const ALuint sNumBuffers = 6;
+    // Playback starts after a short first buffer, the following ones are
+    // twice as long as the one before up to the steady length
+    static const ALfloat sStartBufferLength;
     static const ALfloat sBufferLength;
 
 private:
     ALuint mSource;
 
     ALuint mBuffers[sNumBuffers];
+    ALuint mBufferFrames[sNumBuffers];
     ALint mCurrentBufIdx;
+    // Frames in the buffers queued on the source, including processed ones
+    ALuint mQueuedFrames;
+    ALuint mNextBufferFrames;
 
     ALenum mFormat;
     ALsizei mSampleRate;
-    ALuint mBufferSize;
+    ChannelConfig mChannelConfig;
+    SampleType mSampleType;
+    ALuint mStartBufferFrames;
+    ALuint mBufferFramesMax;
     ALuint mFrameSize;
     ALint mSilence;
 
     DecoderPtr mDecoder;
+    std::vector<char> mData;
+
+    // Analyzed as the stream is decoded, unless it was ready or analyzed by
+    // another stream
+    Sound_Loudness *mLoudness;
+    bool mAnalyzeLoudness;
 
     volatile bool mIsFinished;
 
@@ -222,19 +256,89 @@ private:
     friend class OpenAL_Output;
 
 public:
-    OpenAL_SoundStream(ALuint src, DecoderPtr decoder);
+    OpenAL_SoundStream(ALuint src, DecoderPtr decoder, Sound_Loudness *loudness);
     ~OpenAL_SoundStream();
 
     bool isPlaying();
     double getStreamDelay() const;
     double getStreamOffset() const;
+    float getCurrentLoudness() const;
+
+    // Called with the stream thread's mutex locked, like process
+    void startLoudnessAnalysis();
+    void cancelLoudnessAnalysis();
 
     bool process();
-    ALint refillQueue();
+    ALint refillQueue(ALuint maxQueued);
 };
+const ALfloat OpenAL_SoundStream::sStartBufferLength = 0.03125f;
 const ALfloat OpenAL_SoundStream::sBufferLength = 0.125f;
 
 
+//
+// Sound data decoded by the background thread, for a buffer to be made from
+//
+struct OpenAL_SoundLoading : public Sound_Loading {
+    DecoderPtr mDecoder;
+    std::string mFileName;
+
+    std::vector<char> mData;
+    ALenum mFormat;
+    int mSampleRate;
+
+    // Set by the background thread, guarded by its mutex
+    bool mDone;
+    bool mFailed;
+
+    OpenAL_SoundLoading(DecoderPtr decoder, const std::string &fname)
+      : mDecoder(decoder), mFileName(fname), mFormat(AL_NONE), mSampleRate(0), mDone(false), mFailed(false)
+    { }
+};
+typedef boost::shared_ptr<OpenAL_SoundLoading> OpenAL_SoundLoadingPtr;
+
+
+static void decodeSound(DecoderPtr decoder, const std::string &fname, std::vector<char> &data,
+                        ALenum &format, int &srate)
+{
+    // Workaround: Bethesda at some point converted some of the files to mp3, but the references were kept as .wav.
+    if(decoder->mResourceMgr->exists(fname))
+        decoder->open(fname);
+    else
+    {
+        std::string file = fname;
+        std::string::size_type pos = file.rfind('.');
+        if(pos != std::string::npos)
+            file = file.substr(0, pos)+".mp3";
+        decoder->open(file);
+    }
+
+    ChannelConfig chans;
+    SampleType type;
+
+    decoder->getInfo(&srate, &chans, &type);
+    format = getALFormat(chans, type);
+
+    decoder->readAll(data);
+    decoder->close();
+}
+
+static ALuint createBuffer(const std::vector<char> &data, ALenum format, int srate)
+{
+    ALuint buf = 0;
+    try {
+        alGenBuffers(1, &buf);
+        alBufferData(buf, format, &data[0], data.size(), srate);
+        throwALerror();
+    }
+    catch(...) {
+        if(buf && alIsBuffer(buf))
+            alDeleteBuffers(1, &buf);
+        throw;
+    }
+    return buf;
+}
+
+
 //
 // A background streaming thread (keeps active streams processed)
 //
@@ -242,8 +346,8 @@ struct OpenAL_Output::StreamThread {
     typedef std::vector<OpenAL_SoundStream*> StreamVec;
     StreamVec mStreams;
 
-    typedef std::vector<std::pair<DecoderPtr,Sound_Loudness*> > DecoderLoudnessVec;
-    DecoderLoudnessVec mDecoderLoudness;
+    typedef std::deque<OpenAL_SoundLoadingPtr> SoundLoadingDq;
+    SoundLoadingDq mSoundLoading;
 
     volatile bool mQuitNow;
     boost::mutex mMutex;
@@ -268,42 +372,57 @@ struct OpenAL_Output::StreamThread {
         boost::unique_lock<boost::mutex> lock(mMutex);
         while(!mQuitNow)
         {
+            // Come back when the first stream has used up about half of its
+            // queue, or when woken up for new work
+            double wait = 0.25;
             StreamVec::iterator iter = mStreams.begin();
             while(iter != mStreams.end())
             {
                 if((*iter)->process() == false)
                     iter = mStreams.erase(iter);
                 else
+                {
+                    try {
+                        wait = std::min(wait, (*iter)->getStreamDelay() * 0.5);
+                    }
+                    catch(std::exception&) {
+                        wait = 0.0;
+                    }
                     ++iter;
+                }
             }
 
-            // Only do one loudness decode at a time, in case it takes particularly long we don't
-            // want to block up anything.
-            DecoderLoudnessVec::iterator dliter = mDecoderLoudness.begin();
-            if(dliter != mDecoderLoudness.end())
+            // Sounds waiting to be played go first, one at a time
+            if(!mSoundLoading.empty())
             {
-                DecoderPtr decoder = dliter->first;
-                Sound_Loudness *loudness = dliter->second;
-                mDecoderLoudness.erase(dliter);
+                OpenAL_SoundLoadingPtr loading = mSoundLoading.front();
+                mSoundLoading.pop_front();
                 lock.unlock();
 
-                std::vector<char> data;
-                ChannelConfig chans = ChannelConfig_Mono;
-                SampleType type = SampleType_Int16;
-                int srate = 48000;
+                bool failed = false;
                 try {
-                    decoder->getInfo(&srate, &chans, &type);
-                    decoder->readAll(data);
+                    decodeSound(loading->mDecoder, loading->mFileName, loading->mData,
+                                loading->mFormat, loading->mSampleRate);
                 }
                 catch(std::exception &e) {
-                    std::cerr<< "Failed to decode audio: "<<e.what() <<std::endl;
+                    std::cerr<< "Failed to load audio from "<<loading->mFileName<<": "<<e.what() <<std::endl;
+                    failed = true;
                 }
+                loading->mDecoder.reset();
 
-                loudness->analyzeLoudness(data, srate, chans, type, static_cast<float>(sLoudnessFPS));
                 lock.lock();
+                loading->mFailed = failed;
+                loading->mDone = true;
                 continue;
             }
-            mCondVar.timed_wait(lock, boost::posix_time::milliseconds(50));
+
+            if(mStreams.empty())
+                mCondVar.wait(lock);
+            else
+            {
+                int ms = std::max(static_cast<int>(wait*1000.0), 5);
+                mCondVar.timed_wait(lock, boost::posix_time::milliseconds(ms));
+            }
         }
     }
 
@@ -312,6 +431,7 @@ struct OpenAL_Output::StreamThread {
         boost::unique_lock<boost::mutex> lock(mMutex);
         if(std::find(mStreams.begin(), mStreams.end(), stream) == mStreams.end())
         {
+            stream->startLoudnessAnalysis();
             mStreams.push_back(stream);
             lock.unlock();
             mCondVar.notify_all();
@@ -323,19 +443,22 @@ struct OpenAL_Output::StreamThread {
         boost::lock_guard<boost::mutex> lock(mMutex);
         StreamVec::iterator iter = std::find(mStreams.begin(), mStreams.end(), stream);
         if(iter != mStreams.end()) mStreams.erase(iter);
+        if(stream) stream->cancelLoudnessAnalysis();
     }
 
     void removeAll()
     {
         boost::lock_guard<boost::mutex> lock(mMutex);
+        for(StreamVec::iterator iter = mStreams.begin();iter != mStreams.end();++iter)
+            (*iter)->cancelLoudnessAnalysis();
         mStreams.clear();
-        mDecoderLoudness.clear();
+        mSoundLoading.clear();
     }
 
-    void add(DecoderPtr decoder, Sound_Loudness *loudness)
+    void add(OpenAL_SoundLoadingPtr loading)
     {
         boost::unique_lock<boost::mutex> lock(mMutex);
-        mDecoderLoudness.push_back(std::make_pair(decoder, loudness));
+        mSoundLoading.push_back(loading);
         lock.unlock();
         mCondVar.notify_all();
     }
@@ -346,8 +469,9 @@ private:
 };
 
 
-OpenAL_SoundStream::OpenAL_SoundStream(ALuint src, DecoderPtr decoder)
-  : mSource(src), mCurrentBufIdx(0), mFrameSize(0), mSilence(0), mDecoder(decoder), mIsFinished(false)
+OpenAL_SoundStream::OpenAL_SoundStream(ALuint src, DecoderPtr decoder, Sound_Loudness *loudness)
+  : mSource(src), mCurrentBufIdx(0), mQueuedFrames(0), mNextBufferFrames(0), mFrameSize(0), mSilence(0)
+  , mDecoder(decoder), mLoudness(loudness), mAnalyzeLoudness(false), mIsFinished(false)
 {
     alGenBuffers(sNumBuffers, mBuffers);
     throwALerror();
@@ -368,9 +492,15 @@ OpenAL_SoundStream::OpenAL_SoundStream(ALuint src, DecoderPtr decoder)
             case SampleType_Float32: mSilence = 0x00; break;
         }
 
+        mChannelConfig = chans;
+        mSampleType = type;
+
         mFrameSize = framesToBytes(1, chans, type);
-        mBufferSize = static_cast<ALuint>(sBufferLength*srate);
-        mBufferSize *= mFrameSize;
+        mBufferFramesMax = std::max(static_cast<ALuint>(sBufferLength*srate), 1u);
+        mStartBufferFrames = std::min(std::max(static_cast<ALuint>(sStartBufferLength*srate), 1u), mBufferFramesMax);
+        mNextBufferFrames = mStartBufferFrames;
+        for(ALuint i = 0;i < sNumBuffers;i++)
+            mBufferFrames[i] = 0;
     }
     catch(std::exception&)
     {
@@ -410,9 +540,7 @@ double OpenAL_SoundStream::getStreamDelay() const
     alGetSourcei(mSource, AL_SOURCE_STATE, &state);
     if(state == AL_PLAYING || state == AL_PAUSED)
     {
-        ALint queued;
-        alGetSourcei(mSource, AL_BUFFERS_QUEUED, &queued);
-        ALint inqueue = mBufferSize/mFrameSize*queued - offset;
+        ALint inqueue = mQueuedFrames - offset;
         d = (double)inqueue / (double)mSampleRate;
     }
 
@@ -430,9 +558,7 @@ double OpenAL_SoundStream::getStreamOffset() const
     alGetSourcei(mSource, AL_SOURCE_STATE, &state);
     if(state == AL_PLAYING || state == AL_PAUSED)
     {
-        ALint queued;
-        alGetSourcei(mSource, AL_BUFFERS_QUEUED, &queued);
-        ALint inqueue = mBufferSize/mFrameSize*queued - offset;
+        ALint inqueue = mQueuedFrames - offset;
         t = (double)(mDecoder->getSampleOffset() - inqueue) / (double)mSampleRate;
     }
     else
@@ -446,28 +572,60 @@ double OpenAL_SoundStream::getStreamOffset() const
     return t;
 }
 
+void OpenAL_SoundStream::startLoudnessAnalysis()
+{
+    if(mLoudness && !mLoudness->isReady() && !mLoudness->isAnalyzing())
+    {
+        mLoudness->startAnalysis(mSampleRate, mChannelConfig, mSampleType, static_cast<float>(sLoudnessFPS));
+        mAnalyzeLoudness = true;
+    }
+}
+
+void OpenAL_SoundStream::cancelLoudnessAnalysis()
+{
+    if(mAnalyzeLoudness)
+    {
+        mLoudness->cancelAnalysis();
+        mAnalyzeLoudness = false;
+    }
+}
+
+float OpenAL_SoundStream::getCurrentLoudness() const
+{
+    if(!mLoudness)
+        return 0.0f;
+    return mLoudness->getLoudnessAtTime(static_cast<float>(getStreamOffset()));
+}
+
 bool OpenAL_SoundStream::process()
 {
     try {
-        if(refillQueue() > 0)
+        ALint state;
+        alGetSourcei(mSource, AL_SOURCE_STATE, &state);
+        if(state != AL_PLAYING && state != AL_PAUSED)
         {
-            ALint state;
-            alGetSourcei(mSource, AL_SOURCE_STATE, &state);
-            if(state != AL_PLAYING && state != AL_PAUSED)
-            {
-                refillQueue();
+            // Not started yet, or an underrun. Start again with a short
+            // buffer, so that there is little to decode before playing.
+            mNextBufferFrames = mStartBufferFrames;
+            if(refillQueue(1) > 0)
                 alSourcePlay(mSource);
-            }
         }
+        refillQueue(sNumBuffers);
     }
     catch(std::exception&) {
         std::cout<< "Error updating stream \""<<mDecoder->getName()<<"\"" <<std::endl;
         mIsFinished = true;
     }
+
+    if(mIsFinished && mAnalyzeLoudness)
+    {
+        mLoudness->finishAnalysis();
+        mAnalyzeLoudness = false;
+    }
     return !mIsFinished;
 }
 
-ALint OpenAL_SoundStream::refillQueue()
+ALint OpenAL_SoundStream::refillQueue(ALuint maxQueued)
 {
     ALint processed;
     alGetSourcei(mSource, AL_BUFFERS_PROCESSED, &processed);
@@ -475,29 +633,42 @@ ALint OpenAL_SoundStream::refillQueue()
     {
         ALuint buf;
         alSourceUnqueueBuffers(mSource, 1, &buf);
+        for(ALuint i = 0;i < sNumBuffers;i++)
+        {
+            if(mBuffers[i] == buf)
+            {
+                mQueuedFrames -= mBufferFrames[i];
+                mBufferFrames[i] = 0;
+                break;
+            }
+        }
         --processed;
     }
 
     ALint queued;
     alGetSourcei(mSource, AL_BUFFERS_QUEUED, &queued);
-    if(!mIsFinished && (ALuint)queued < sNumBuffers)
+    for(;!mIsFinished && (ALuint)queued < maxQueued;++queued)
     {
-        std::vector<char> data(mBufferSize);
-        for(;!mIsFinished && (ALuint)queued < sNumBuffers;++queued)
+        ALuint frames = mNextBufferFrames;
+        mNextBufferFrames = std::min(mNextBufferFrames*2, mBufferFramesMax);
+
+        mData.resize(frames*mFrameSize);
+        size_t got = mDecoder->read(&mData[0], mData.size());
+        if(mAnalyzeLoudness)
+            mLoudness->appendData(&mData[0], got);
+        if(got < mData.size())
         {
-            size_t got = mDecoder->read(&data[0], data.size());
-            if(got < data.size())
-            {
-                mIsFinished = true;
-                memset(&data[got], mSilence, data.size()-got);
-            }
-            if(got > 0)
-            {
-                ALuint bufid = mBuffers[mCurrentBufIdx];
-                alBufferData(bufid, mFormat, &data[0], data.size(), mSampleRate);
-                alSourceQueueBuffers(mSource, 1, &bufid);
-                mCurrentBufIdx = (mCurrentBufIdx+1) % sNumBuffers;
-            }
+            mIsFinished = true;
+            memset(&mData[got], mSilence, mData.size()-got);
+        }
+        if(got > 0)
+        {
+            ALuint bufid = mBuffers[mCurrentBufIdx];
+            alBufferData(bufid, mFormat, &mData[0], mData.size(), mSampleRate);
+            alSourceQueueBuffers(mSource, 1, &bufid);
+            mBufferFrames[mCurrentBufIdx] = frames;
+            mQueuedFrames += frames;
+            mCurrentBufIdx = (mCurrentBufIdx+1) % sNumBuffers;
         }
     }
 
@@ -559,6 +730,19 @@ void OpenAL_Output::init(const std::string &devname)
     alDistanceModel(AL_INVERSE_DISTANCE_CLAMPED);
     throwALerror();
 
+    mDeferUpdates = 0;
+    mProcessUpdates = 0;
+    if(alIsExtensionPresent("AL_SOFT_deferred_updates"))
+    {
+        getFunc(mDeferUpdates, "alDeferUpdatesSOFT");
+        getFunc(mProcessUpdates, "alProcessUpdatesSOFT");
+        if(!mDeferUpdates || !mProcessUpdates)
+        {
+            mDeferUpdates = 0;
+            mProcessUpdates = 0;
+        }
+    }
+
     ALCint maxmono=0, maxstereo=0;
     alcGetIntegerv(mDevice, ALC_MONO_SOURCES, 1, &maxmono);
     alcGetIntegerv(mDevice, ALC_STEREO_SOURCES, 1, &maxstereo);
@@ -716,43 +900,44 @@ Sound_Handle OpenAL_Output::loadSound(const std::string &fname)
 {
     throwALerror();
 
-    DecoderPtr decoder = mManager.getDecoder();
-    // Workaround: Bethesda at some point converted some of the files to mp3, but the references were kept as .wav.
-    if(decoder->mResourceMgr->exists(fname))
-        decoder->open(fname);
-    else
-    {
-        std::string file = fname;
-        std::string::size_type pos = file.rfind('.');
-        if(pos != std::string::npos)
-            file = file.substr(0, pos)+".mp3";
-        decoder->open(file);
-    }
-
     std::vector<char> data;
-    ChannelConfig chans;
-    SampleType type;
     ALenum format;
     int srate;
 
-    decoder->getInfo(&srate, &chans, &type);
-    format = getALFormat(chans, type);
+    decodeSound(mManager.getDecoder(), fname, data, format, srate);
 
-    decoder->readAll(data);
-    decoder->close();
+    return MAKE_PTRID(createBuffer(data, format, srate));
+}
 
-    ALuint buf = 0;
-    try {
-        alGenBuffers(1, &buf);
-        alBufferData(buf, format, &data[0], data.size(), srate);
-        throwALerror();
+Sound_LoadingPtr OpenAL_Output::loadSoundAsync(const std::string &fname)
+{
+    OpenAL_SoundLoadingPtr loading(new OpenAL_SoundLoading(mManager.getDecoder(), fname));
+    mStreamThread->add(loading);
+    return loading;
+}
+
+bool OpenAL_Output::finishLoadSound(Sound_LoadingPtr loading, Sound_Handle &data)
+{
+    OpenAL_SoundLoading *sound = static_cast<OpenAL_SoundLoading*>(loading.get());
+    {
+        boost::lock_guard<boost::mutex> lock(mStreamThread->mMutex);
+        if(!sound->mDone)
+            return false;
     }
-    catch(...) {
-        if(buf && alIsBuffer(buf))
-            alDeleteBuffers(1, &buf);
-        throw;
+
+    data = 0;
+    if(!sound->mFailed)
+    {
+        try {
+            throwALerror();
+            data = MAKE_PTRID(createBuffer(sound->mData, sound->mFormat, sound->mSampleRate));
+        }
+        catch(std::exception &e) {
+            std::cerr<< "Failed to load audio from "<<sound->mFileName<<": "<<e.what() <<std::endl;
+        }
     }
-    return MAKE_PTRID(buf);
+    std::vector<char>().swap(sound->mData);
+    return true;
 }
 
 void OpenAL_Output::unloadSound(Sound_Handle data)
@@ -788,6 +973,23 @@ size_t OpenAL_Output::getSoundDataSize(Sound_Handle data) const
     return (ALuint)size;
 }
 
+float OpenAL_Output::getSoundDuration(Sound_Handle data) const
+{
+    ALuint buffer = GET_PTRID(data);
+    ALint size = 0, freq = 0, channels = 0, bits = 0;
+
+    alGetBufferi(buffer, AL_SIZE, &size);
+    alGetBufferi(buffer, AL_FREQUENCY, &freq);
+    alGetBufferi(buffer, AL_CHANNELS, &channels);
+    alGetBufferi(buffer, AL_BITS, &bits);
+    throwALerror();
+
+    int frameSize = channels * bits / 8;
+    if(freq <= 0 || frameSize <= 0)
+        return 0.0f;
+    return static_cast<float>(size / frameSize) / freq;
+}
+
 
 void OpenAL_Output::initCommon2D(ALuint source, const osg::Vec3f &pos, ALfloat gain, ALfloat pitch, bool loop, bool useenv)
 {
@@ -833,24 +1035,39 @@ void OpenAL_Output::initCommon3D(ALuint source, const osg::Vec3f &pos, ALfloat m
     alSource3f(source, AL_VELOCITY, 0.0f, 0.0f, 0.0f);
 }
 
-void OpenAL_Output::updateCommon(ALuint source, const osg::Vec3f& pos, ALfloat maxdist, ALfloat gain, ALfloat pitch, bool useenv, bool is3d)
+void OpenAL_Output::updateCommon(ALuint source, Sound &sound)
 {
-    if(is3d)
+    const osg::Vec3f &pos = sound.getPosition();
+    ALfloat gain = sound.getRealVolume();
+    ALfloat pitch = sound.getPitch();
+    if(sound.getIs3D())
     {
-        if((pos - mListenerPos).length2() > maxdist*maxdist)
+        if((pos - mListenerPos).length2() > sound.getMaxDistance()*sound.getMaxDistance())
             gain = 0.0f;
     }
-    if(useenv && mListenerEnv == Env_Underwater)
+    if(sound.getUseEnv() && mListenerEnv == Env_Underwater)
     {
         gain *= 0.9f;
         pitch *= 0.7f;
     }
 
-    alSourcef(source, AL_GAIN, gain);
-    alSourcef(source, AL_PITCH, pitch);
-    alSourcefv(source, AL_POSITION, pos.ptr());
-    alSource3f(source, AL_DIRECTION, 0.0f, 0.0f, 0.0f);
-    alSource3f(source, AL_VELOCITY, 0.0f, 0.0f, 0.0f);
+    // Most sounds do not change from one update to the next, so only pass
+    // on what did. Direction and velocity are never changed after init.
+    if(gain != sound.mOutputGain)
+    {
+        alSourcef(source, AL_GAIN, gain);
+        sound.mOutputGain = gain;
+    }
+    if(pitch != sound.mOutputPitch)
+    {
+        alSourcef(source, AL_PITCH, pitch);
+        sound.mOutputPitch = pitch;
+    }
+    if(pos != sound.mOutputPos)
+    {
+        alSourcefv(source, AL_POSITION, pos.ptr());
+        sound.mOutputPos = pos;
+    }
 }
 
 
@@ -882,6 +1099,7 @@ void OpenAL_Output::playSound(MWBase::SoundPtr sound, Sound_Handle data, float o
     }
 
     sound->mHandle = MAKE_PTRID(source);
+    sound->resetOutput();
 }
 
 void OpenAL_Output::playSound3D(MWBase::SoundPtr sound, Sound_Handle data, float offset)
@@ -913,6 +1131,7 @@ void OpenAL_Output::playSound3D(MWBase::SoundPtr sound, Sound_Handle data, float
     }
 
     sound->mHandle = MAKE_PTRID(source);
+    sound->resetOutput();
 }
 
 void OpenAL_Output::finishSound(MWBase::SoundPtr sound)
@@ -940,17 +1159,33 @@ bool OpenAL_Output::isSoundPlaying(MWBase::SoundPtr sound)
     return state == AL_PLAYING || state == AL_PAUSED;
 }
 
+float OpenAL_Output::getSoundOffset(MWBase::SoundPtr sound)
+{
+    if(!sound->mHandle) return 0.0f;
+    ALuint source = GET_PTRID(sound->mHandle);
+    ALfloat offset = 0.0f;
+
+    alGetSourcef(source, AL_SEC_OFFSET, &offset);
+    throwALerror();
+
+    return offset;
+}
+
+size_t OpenAL_Output::getFreeSourceCount() const
+{
+    return mFreeSources.size();
+}
+
 void OpenAL_Output::updateSound(MWBase::SoundPtr sound)
 {
     if(!sound->mHandle) return;
     ALuint source = GET_PTRID(sound->mHandle);
 
-    updateCommon(source, sound->getPosition(), sound->getMaxDistance(), sound->getRealVolume(),
-                 sound->getPitch(), sound->getUseEnv(), sound->getIs3D());
+    updateCommon(source, *sound);
 }
 
 
-void OpenAL_Output::streamSound(DecoderPtr decoder, MWBase::SoundStreamPtr sound)
+void OpenAL_Output::streamSound(DecoderPtr decoder, MWBase::SoundStreamPtr sound, Sound_Loudness *loudness)
 {
     OpenAL_SoundStream *stream = 0;
     ALuint source;
@@ -967,7 +1202,7 @@ void OpenAL_Output::streamSound(DecoderPtr decoder, MWBase::SoundStreamPtr sound
                      false, sound->getUseEnv());
         throwALerror();
 
-        stream = new OpenAL_SoundStream(source, decoder);
+        stream = new OpenAL_SoundStream(source, decoder, loudness);
         mStreamThread->add(stream);
         mActiveStreams.push_back(sound);
     }
@@ -979,9 +1214,10 @@ void OpenAL_Output::streamSound(DecoderPtr decoder, MWBase::SoundStreamPtr sound
     }
 
     sound->mHandle = stream;
+    sound->resetOutput();
 }
 
-void OpenAL_Output::streamSound3D(DecoderPtr decoder, MWBase::SoundStreamPtr sound)
+void OpenAL_Output::streamSound3D(DecoderPtr decoder, MWBase::SoundStreamPtr sound, Sound_Loudness *loudness)
 {
     OpenAL_SoundStream *stream = 0;
     ALuint source;
@@ -998,7 +1234,7 @@ void OpenAL_Output::streamSound3D(DecoderPtr decoder, MWBase::SoundStreamPtr sou
                      sound->getRealVolume(), sound->getPitch(), false, sound->getUseEnv());
         throwALerror();
 
-        stream = new OpenAL_SoundStream(source, decoder);
+        stream = new OpenAL_SoundStream(source, decoder, loudness);
         mStreamThread->add(stream);
         mActiveStreams.push_back(sound);
     }
@@ -1010,6 +1246,7 @@ void OpenAL_Output::streamSound3D(DecoderPtr decoder, MWBase::SoundStreamPtr sou
     }
 
     sound->mHandle = stream;
+    sound->resetOutput();
 }
 
 void OpenAL_Output::finishStream(MWBase::SoundStreamPtr sound)
@@ -1053,25 +1290,40 @@ bool OpenAL_Output::isStreamPlaying(MWBase::SoundStreamPtr sound)
     return stream->isPlaying();
 }
 
+float OpenAL_Output::getStreamLoudness(MWBase::SoundStreamPtr sound)
+{
+    if(!sound->mHandle) return 0.0f;
+    OpenAL_SoundStream *stream = reinterpret_cast<OpenAL_SoundStream*>(sound->mHandle);
+    boost::lock_guard<boost::mutex> lock(mStreamThread->mMutex);
+    return stream->getCurrentLoudness();
+}
+
 void OpenAL_Output::updateStream(MWBase::SoundStreamPtr sound)
 {
     if(!sound->mHandle) return;
     OpenAL_SoundStream *stream = reinterpret_cast<OpenAL_SoundStream*>(sound->mHandle);
     ALuint source = stream->mSource;
 
-    updateCommon(source, sound->getPosition(), sound->getMaxDistance(), sound->getRealVolume(),
-                 sound->getPitch(), sound->getUseEnv(), sound->getIs3D());
+    updateCommon(source, *sound);
 }
 
 
 void OpenAL_Output::startUpdate()
 {
-    alcSuspendContext(alcGetCurrentContext());
+    // Have the changes of the whole update applied at once. Suspending the
+    // context does nothing on most implementations, unlike deferring.
+    if(mDeferUpdates)
+        mDeferUpdates();
+    else
+        alcSuspendContext(alcGetCurrentContext());
 }
 
 void OpenAL_Output::finishUpdate()
 {
-    alcProcessContext(alcGetCurrentContext());
+    if(mProcessUpdates)
+        mProcessUpdates();
+    else
+        alcProcessContext(alcGetCurrentContext());
 }
 
 
@@ -1144,14 +1396,9 @@ void OpenAL_Output::resumeSounds(int types)
 }
 
 
-void OpenAL_Output::loadLoudnessAsync(DecoderPtr decoder, Sound_Loudness *loudness)
-{
-    mStreamThread->add(decoder, loudness);
-}
-
 
 OpenAL_Output::OpenAL_Output(SoundManager &mgr)
-  : Sound_Output(mgr), mDevice(0), mContext(0)
+  : Sound_Output(mgr), mDevice(0), mContext(0), mDeferUpdates(0), mProcessUpdates(0)
   , mListenerPos(0.0f, 0.0f, 0.0f), mListenerEnv(Env_Normal)
   , mStreamThread(new StreamThread)
 {
@@ -21,6 +21,10 @@ namespace MWSound
         ALCdevice *mDevice;
         ALCcontext *mContext;
 
+        // From AL_SOFT_deferred_updates, if supported
+        void (AL_APIENTRY*mDeferUpdates)();
+        void (AL_APIENTRY*mProcessUpdates)();
+
         typedef std::deque<ALuint> IDDq;
         IDDq mFreeSources;
 
@@ -38,7 +42,7 @@ namespace MWSound
         void initCommon2D(ALuint source, const osg::Vec3f &pos, ALfloat gain, ALfloat pitch, bool loop, bool useenv);
         void initCommon3D(ALuint source, const osg::Vec3f &pos, ALfloat mindist, ALfloat maxdist, ALfloat gain, ALfloat pitch, bool loop, bool useenv);
 
-        void updateCommon(ALuint source, const osg::Vec3f &pos, ALfloat maxdist, ALfloat gain, ALfloat pitch, bool useenv, bool is3d);
+        void updateCommon(ALuint source, Sound &sound);
 
         OpenAL_Output& operator=(const OpenAL_Output &rhs);
         OpenAL_Output(const OpenAL_Output &rhs);
@@ -53,21 +57,27 @@ namespace MWSound
         virtual void disableHrtf();
 
         virtual Sound_Handle loadSound(const std::string &fname);
+        virtual Sound_LoadingPtr loadSoundAsync(const std::string &fname);
+        virtual bool finishLoadSound(Sound_LoadingPtr loading, Sound_Handle &data);
         virtual void unloadSound(Sound_Handle data);
         virtual size_t getSoundDataSize(Sound_Handle data) const;
+        virtual float getSoundDuration(Sound_Handle data) const;
 
         virtual void playSound(MWBase::SoundPtr sound, Sound_Handle data, float offset);
         virtual void playSound3D(MWBase::SoundPtr sound, Sound_Handle data, float offset);
         virtual void finishSound(MWBase::SoundPtr sound);
         virtual bool isSoundPlaying(MWBase::SoundPtr sound);
+        virtual float getSoundOffset(MWBase::SoundPtr sound);
+        virtual size_t getFreeSourceCount() const;
         virtual void updateSound(MWBase::SoundPtr sound);
 
-        virtual void streamSound(DecoderPtr decoder, MWBase::SoundStreamPtr sound);
-        virtual void streamSound3D(DecoderPtr decoder, MWBase::SoundStreamPtr sound);
+        virtual void streamSound(DecoderPtr decoder, MWBase::SoundStreamPtr sound, Sound_Loudness *loudness);
+        virtual void streamSound3D(DecoderPtr decoder, MWBase::SoundStreamPtr sound, Sound_Loudness *loudness);
         virtual void finishStream(MWBase::SoundStreamPtr sound);
         virtual double getStreamDelay(MWBase::SoundStreamPtr sound);
         virtual double getStreamOffset(MWBase::SoundStreamPtr sound);
         virtual bool isStreamPlaying(MWBase::SoundStreamPtr sound);
+        virtual float getStreamLoudness(MWBase::SoundStreamPtr sound);
         virtual void updateStream(MWBase::SoundStreamPtr sound);
 
         virtual void startUpdate();
@@ -78,8 +88,6 @@ namespace MWSound
         virtual void pauseSounds(int types);
         virtual void resumeSounds(int types);
 
-        virtual void loadLoudnessAsync(DecoderPtr decoder, Sound_Loudness *loudness);
-
         OpenAL_Output(SoundManager &mgr);
         virtual ~OpenAL_Output();
     };
@@ -22,6 +22,20 @@ namespace MWSound
     protected:
         Sound_Instance mHandle;
 
+        // Last values given to the output, so unchanged sounds can be skipped
+        float mOutputGain;
+        float mOutputPitch;
+        osg::Vec3f mOutputPos;
+
+        // For when the output (re)initializes the source with the current
+        // position. Gain and pitch are updated the next time regardless.
+        void resetOutput()
+        {
+            mOutputGain = -1.0f;
+            mOutputPitch = -1.0f;
+            mOutputPos = mPos;
+        }
+
         friend class OpenAL_Output;
 
     public:
@@ -56,11 +70,13 @@ namespace MWSound
           : mPos(pos), mVolume(vol), mBaseVolume(basevol), mPitch(pitch)
           , mMinDistance(mindist), mMaxDistance(maxdist), mFlags(flags)
           , mFadeOutTime(0.0f), mHandle(0)
+          , mOutputGain(-1.0f), mOutputPitch(-1.0f), mOutputPos(pos)
         { }
         Sound(float vol, float basevol, float pitch, int flags)
           : mPos(0.0f, 0.0f, 0.0f), mVolume(vol), mBaseVolume(basevol), mPitch(pitch)
           , mMinDistance(1.0f), mMaxDistance(1000.0f), mFlags(flags)
           , mFadeOutTime(0.0f), mHandle(0)
+          , mOutputGain(-1.0f), mOutputPitch(-1.0f), mOutputPos(0.0f, 0.0f, 0.0f)
         { }
     };
 
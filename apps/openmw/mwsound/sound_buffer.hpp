@@ -1,6 +1,7 @@
 #ifndef GAME_SOUND_SOUND_BUFFER_H
 #define GAME_SOUND_SOUND_BUFFER_H
 
+#include <list>
 #include <string>
 
 #include "soundmanagerimp.hpp"
@@ -20,11 +21,23 @@ namespace MWSound
         float mMinDist, mMaxDist;
 
         Sound_Handle mHandle;
+        // Set while the sound is decoded in the background
+        Sound_LoadingPtr mLoading;
 
         size_t mUses;
 
+        // Bytes counted in the buffer cache for the loaded sound
+        size_t mDataSize;
+        // Number of active cells with creatures that make the sound. Unused
+        // buffers of such sounds are the last to be freed.
+        size_t mCellUses;
+        // Position in the list of unused buffers, if it is in there
+        std::list<Sound_Buffer*>::iterator mUnusedPos;
+        bool mIsUnused;
+
         Sound_Buffer(std::string resname, float volume, float mindist, float maxdist)
           : mResourceName(resname), mVolume(volume), mMinDist(mindist), mMaxDist(maxdist), mHandle(0), mUses(0)
+          , mDataSize(0), mCellUses(0), mIsUnused(false)
         { }
     };
 }
@@ -5,6 +5,8 @@
 #include <memory>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 #include "soundmanagerimp.hpp"
 
 namespace MWSound
@@ -19,6 +21,14 @@ namespace MWSound
     // An opaque handle for the implementation's sound instances.
     typedef void *Sound_Instance;
 
+    // A sound being decoded in the background, see Sound_Output::loadSoundAsync.
+    class Sound_Loading
+    {
+    public:
+        virtual ~Sound_Loading() { }
+    };
+    typedef boost::shared_ptr<Sound_Loading> Sound_LoadingPtr;
+
     class Sound_Output
     {
         SoundManager &mManager;
@@ -32,21 +42,36 @@ namespace MWSound
         virtual void disableHrtf() = 0;
 
         virtual Sound_Handle loadSound(const std::string &fname) = 0;
+        // Starts decoding a sound on the background thread. The buffer is made
+        // by finishLoadSound once the sound is decoded.
+        virtual Sound_LoadingPtr loadSoundAsync(const std::string &fname) = 0;
+        // Returns false while the sound is still being decoded. Otherwise sets
+        // the handle to the new buffer, or to 0 if the sound failed to load.
+        virtual bool finishLoadSound(Sound_LoadingPtr loading, Sound_Handle &data) = 0;
         virtual void unloadSound(Sound_Handle data) = 0;
         virtual size_t getSoundDataSize(Sound_Handle data) const = 0;
+        // Length of the sound in seconds, at normal pitch
+        virtual float getSoundDuration(Sound_Handle data) const = 0;
 
         virtual void playSound(MWBase::SoundPtr sound, Sound_Handle data, float offset) = 0;
         virtual void playSound3D(MWBase::SoundPtr sound, Sound_Handle data, float offset) = 0;
         virtual void finishSound(MWBase::SoundPtr sound) = 0;
         virtual bool isSoundPlaying(MWBase::SoundPtr sound) = 0;
+        // Current playback position of the sound in seconds
+        virtual float getSoundOffset(MWBase::SoundPtr sound) = 0;
+        // Number of sources that sounds and streams can still be played on
+        virtual size_t getFreeSourceCount() const = 0;
         virtual void updateSound(MWBase::SoundPtr sound) = 0;
 
-        virtual void streamSound(DecoderPtr decoder, MWBase::SoundStreamPtr sound) = 0;
-        virtual void streamSound3D(DecoderPtr decoder, MWBase::SoundStreamPtr sound) = 0;
+        virtual void streamSound(DecoderPtr decoder, MWBase::SoundStreamPtr sound, Sound_Loudness *loudness) = 0;
+        virtual void streamSound3D(DecoderPtr decoder, MWBase::SoundStreamPtr sound, Sound_Loudness *loudness) = 0;
         virtual void finishStream(MWBase::SoundStreamPtr sound) = 0;
         virtual double getStreamDelay(MWBase::SoundStreamPtr sound) = 0;
         virtual double getStreamOffset(MWBase::SoundStreamPtr sound) = 0;
         virtual bool isStreamPlaying(MWBase::SoundStreamPtr sound) = 0;
+        // Loudness at the current offset of a stream that was started with
+        // loudness data, as far as it is analyzed
+        virtual float getStreamLoudness(MWBase::SoundStreamPtr sound) = 0;
         virtual void updateStream(MWBase::SoundStreamPtr sound) = 0;
 
         virtual void startUpdate() = 0;
@@ -57,11 +82,6 @@ namespace MWSound
         virtual void pauseSounds(int types) = 0;
         virtual void resumeSounds(int types) = 0;
 
-        // HACK: The sound output implementation really shouldn't be handling
-        // asynchronous loudness data loading, but it's currently where we have
-        // a background processing thread.
-        virtual void loadLoudnessAsync(DecoderPtr decoder, Sound_Loudness *loudness) = 0;
-
         Sound_Output& operator=(const Sound_Output &rhs);
         Sound_Output(const Sound_Output &rhs);
 
@@ -2,9 +2,11 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 #include <map>
 
 #include <osg/Matrixf>
+#include <osg/Stats>
 
 #include <components/misc/rng.hpp>
 
@@ -27,14 +29,50 @@
 #include "openal_output.hpp"
 #define SOUND_OUT "OpenAL"
 #include "ffmpeg_decoder.hpp"
+#include "loudnesscache.hpp"
 #ifndef SOUND_IN
 #define SOUND_IN "FFmpeg"
 #endif
 
 
+namespace
+{
+    // Sources kept free for the streams of voices, music and movies, which
+    // can not be played virtually
+    const size_t sStreamSources = 4;
+
+    // How much more audible a virtual sound has to be than a playing one to
+    // take its source
+    const float sStealFactor = 1.5f;
+    const int sMaxStealsPerUpdate = 4;
+
+    struct VoiceRank
+    {
+        float mAudibility;
+        MWWorld::ConstPtr mPtr;
+        MWBase::SoundPtr mSound;
+
+        VoiceRank(float audibility, const MWWorld::ConstPtr &ptr, MWBase::SoundPtr sound)
+          : mAudibility(audibility), mPtr(ptr), mSound(sound)
+        { }
+    };
+
+    struct VoiceRankGreater
+    {
+        bool operator()(const VoiceRank &lhs, const VoiceRank &rhs) const
+        { return lhs.mAudibility > rhs.mAudibility; }
+    };
+
+    struct VoiceRankLess
+    {
+        bool operator()(const VoiceRank &lhs, const VoiceRank &rhs) const
+        { return lhs.mAudibility < rhs.mAudibility; }
+    };
+}
+
 namespace MWSound
 {
-    SoundManager::SoundManager(const VFS::Manager* vfs, bool useSound)
+    SoundManager::SoundManager(const VFS::Manager* vfs, bool useSound, LoudnessCache* loudnessCache)
         : mVFS(vfs)
         , mOutput(new DEFAULT_OUTPUT(*this))
         , mMasterVolume(1.0f)
@@ -42,8 +80,14 @@ namespace MWSound
         , mMusicVolume(1.0f)
         , mVoiceVolume(1.0f)
         , mFootstepsVolume(1.0f)
+        , mLoudnessCache(loudnessCache)
         , mSoundBuffers(new SoundBufferList::element_type())
         , mBufferCacheSize(0)
+        , mCacheHits(0)
+        , mCacheMisses(0)
+        , mCacheEvictions(0)
+        , mLoadInBackground(false)
+        , mCreatureSoundsListed(false)
         , mListenerUnderwater(false)
         , mListenerPos(0,0,0)
         , mListenerDir(1,0,0)
@@ -66,6 +110,8 @@ namespace MWSound
         mBufferCacheMax *= 1024*1024;
         mBufferCacheMin = std::min(mBufferCacheMin*1024*1024, mBufferCacheMax);
 
+        mLoadInBackground = Settings::Manager::getBool("load sounds in background", "Sound");
+
         if(!useSound)
             return;
 
@@ -118,11 +164,23 @@ namespace MWSound
         for(;sfxiter != mSoundBuffers->end();++sfxiter)
         {
             if(sfxiter->mHandle)
-                mOutput->unloadSound(sfxiter->mHandle);
-            sfxiter->mHandle = 0;
+                unloadBuffer(&*sfxiter);
+            sfxiter->mIsUnused = false;
         }
         mUnusedBuffers.clear();
         mOutput.reset();
+
+        if(mLoudnessCache.get())
+        {
+            // Voices that were stopped early are analyzed again the next time
+            std::vector<UncachedVoice>::const_iterator voice = mUncachedVoices.begin();
+            for(;voice != mUncachedVoices.end();++voice)
+            {
+                if(voice->mLoudness->isReady())
+                    mLoudnessCache->add(voice->mName, voice->mSize, *voice->mLoudness);
+            }
+            mLoudnessCache->save();
+        }
     }
 
     // Return a new decoder instance, used as needed by the output implementations
@@ -177,82 +235,425 @@ namespace MWSound
     }
 
     // Lookup a soundId for its sound data (resource name, local volume,
-    // minRange, and maxRange), and ensure it's ready for use.
-    Sound_Buffer *SoundManager::loadSound(const std::string &soundId)
+    // minRange, and maxRange), adding it if it was not used yet.
+    Sound_Buffer *SoundManager::getSoundBuffer(const std::string &soundId)
     {
-        Sound_Buffer *sfx;
         NameBufferMap::const_iterator snd = mBufferNameMap.find(soundId);
         if(snd != mBufferNameMap.end())
-            sfx = snd->second;
+            return snd->second;
+
+        MWBase::World *world = MWBase::Environment::get().getWorld();
+        const ESM::Sound *sound = world->getStore().get<ESM::Sound>().find(soundId);
+        return insertSound(soundId, sound);
+    }
+
+    // Lookup a soundId for its sound data (resource name, local volume,
+    // minRange, and maxRange), and ensure it's ready for use.
+    Sound_Buffer *SoundManager::loadSound(const std::string &soundId)
+    {
+        Sound_Buffer *sfx = getSoundBuffer(soundId);
+
+        if(sfx->mHandle)
+            ++mCacheHits;
         else
+            ++mCacheMisses;
+
+        if(!sfx->mHandle && !sfx->mLoading)
         {
-            MWBase::World *world = MWBase::Environment::get().getWorld();
-            const ESM::Sound *sound = world->getStore().get<ESM::Sound>().find(soundId);
-            sfx = insertSound(soundId, sound);
+            sfx->mHandle = mOutput->loadSound(sfx->mResourceName);
+            addToCache(sfx);
         }
-
-        if(!sfx->mHandle)
+        else if(!sfx->mHandle)
         {
+            // Already loading in the background, but needed right now
             sfx->mHandle = mOutput->loadSound(sfx->mResourceName);
-            mBufferCacheSize += mOutput->getSoundDataSize(sfx->mHandle);
+            sfx->mLoading.reset();
+            mLoadingBuffers.erase(std::find(mLoadingBuffers.begin(), mLoadingBuffers.end(), sfx));
+            addToCache(sfx);
+        }
+
+        return sfx;
+    }
+
+    Sound_Buffer *SoundManager::loadSoundAsync(const std::string &soundId)
+    {
+        if(!mLoadInBackground)
+            return loadSound(soundId);
+
+        Sound_Buffer *sfx = getSoundBuffer(soundId);
+        if(sfx->mHandle)
+            ++mCacheHits;
+        else
+            ++mCacheMisses;
+        startLoading(sfx);
+        return sfx;
+    }
+
+    void SoundManager::startLoading(Sound_Buffer *sfx)
+    {
+        if(sfx->mHandle || sfx->mLoading)
+            return;
+
+        sfx->mLoading = mOutput->loadSoundAsync(sfx->mResourceName);
+        mLoadingBuffers.push_back(sfx);
+    }
+
+    void SoundManager::finishLoading()
+    {
+        std::vector<Sound_Buffer*>::iterator iter = mLoadingBuffers.begin();
+        while(iter != mLoadingBuffers.end())
+        {
+            Sound_Buffer *sfx = *iter;
+            Sound_Handle handle = 0;
+            if(!mOutput->finishLoadSound(sfx->mLoading, handle))
+            {
+                ++iter;
+                continue;
+            }
+
+            sfx->mLoading.reset();
+            sfx->mHandle = handle;
+            if(handle)
+                addToCache(sfx);
+            iter = mLoadingBuffers.erase(iter);
+        }
+    }
 
+    void SoundManager::addToCache(Sound_Buffer *sfx)
+    {
+        sfx->mDataSize = mOutput->getSoundDataSize(sfx->mHandle);
+        mBufferCacheSize += sfx->mDataSize;
+
+        if(mBufferCacheSize > mBufferCacheMax)
+        {
+            freeBuffers(mBufferCacheMin, false);
             if(mBufferCacheSize > mBufferCacheMax)
+                freeBuffers(mBufferCacheMin, true);
+            if(mBufferCacheSize > mBufferCacheMax)
+                std::cerr<< "No unused sound buffers to free, using "<<mBufferCacheSize<<" bytes!" <<std::endl;
+        }
+        // Virtual sounds use the buffer already
+        if(sfx->mUses == 0)
+        {
+            sfx->mUnusedPos = mUnusedBuffers.insert(mUnusedBuffers.begin(), sfx);
+            sfx->mIsUnused = true;
+        }
+    }
+
+    void SoundManager::freeBuffers(size_t size, bool freeCellBuffers)
+    {
+        SoundList::iterator iter = mUnusedBuffers.end();
+        while(iter != mUnusedBuffers.begin() && mBufferCacheSize > size)
+        {
+            --iter;
+            Sound_Buffer *unused = *iter;
+            if(!freeCellBuffers && unused->mCellUses > 0)
+                continue;
+
+            iter = mUnusedBuffers.erase(iter);
+            unused->mIsUnused = false;
+            unloadBuffer(unused);
+            ++mCacheEvictions;
+        }
+    }
+
+    void SoundManager::unloadBuffer(Sound_Buffer *sfx)
+    {
+        mBufferCacheSize -= sfx->mDataSize;
+        mOutput->unloadSound(sfx->mHandle);
+        sfx->mHandle = 0;
+        sfx->mDataSize = 0;
+    }
+
+    void SoundManager::useBuffer(Sound_Buffer *sfx)
+    {
+        if(sfx->mUses++ == 0 && sfx->mIsUnused)
+        {
+            mUnusedBuffers.erase(sfx->mUnusedPos);
+            sfx->mIsUnused = false;
+        }
+    }
+
+    void SoundManager::releaseBuffer(Sound_Buffer *sfx)
+    {
+        if(sfx->mUses-- == 1 && sfx->mHandle)
+        {
+            sfx->mUnusedPos = mUnusedBuffers.insert(mUnusedBuffers.begin(), sfx);
+            sfx->mIsUnused = true;
+        }
+    }
+
+    void SoundManager::playBuffer(const MWWorld::ConstPtr &ptr, MWBase::SoundPtr sound, Sound_Buffer *sfx, float offset)
+    {
+        if(sfx->mHandle && mOutput->getFreeSourceCount() > sStreamSources)
+        {
+            startSound(ptr, sound, sfx, offset);
+            useBuffer(sfx);
+            return;
+        }
+
+        // Either the buffer is still loading or there is no source left for
+        // it, so track the sound until updateVirtualSounds can start it
+        VirtualSound virt;
+        virt.mSound = sound;
+        virt.mBuffer = sfx;
+        virt.mOffset = offset;
+        mVirtualSounds[ptr].push_back(virt);
+        useBuffer(sfx);
+    }
+
+    void SoundManager::startSound(const MWWorld::ConstPtr &ptr, MWBase::SoundPtr sound, Sound_Buffer *sfx, float offset)
+    {
+        if(sound->getIs3D())
+            mOutput->playSound3D(sound, sfx->mHandle, offset);
+        else
+            mOutput->playSound(sound, sfx->mHandle, offset);
+        mActiveSounds[ptr].push_back(std::make_pair(sound, sfx));
+    }
+
+    float SoundManager::getAudibility(const Sound &sound) const
+    {
+        float gain = sound.getRealVolume();
+        if(sound.getIs3D())
+        {
+            // Roughly the inverse distance clamped attenuation of the output
+            float dist = (sound.getPosition() - mListenerPos).length();
+            if(dist > sound.getMaxDistance())
+                return 0.0f;
+            gain *= sound.getMinDistance() / std::max(dist, sound.getMinDistance());
+        }
+        // Footsteps are plentiful and the least missed
+        if(sound.getPlayType() == Play_TypeFoot)
+            gain *= 0.5f;
+        return gain;
+    }
+
+    void SoundManager::virtualizeSound(const MWWorld::ConstPtr &ptr, MWBase::SoundPtr sound)
+    {
+        SoundMap::iterator snditer = mActiveSounds.find(ptr);
+        if(snditer == mActiveSounds.end())
+            return;
+        SoundBufferRefPairList::iterator sndidx = snditer->second.begin();
+        for(;sndidx != snditer->second.end();++sndidx)
+        {
+            if(sndidx->first != sound)
+                continue;
+
+            VirtualSound virt;
+            virt.mSound = sound;
+            virt.mBuffer = sndidx->second;
+            virt.mOffset = mOutput->getSoundOffset(sound);
+            mOutput->finishSound(sound);
+            // The use of the buffer moves along with the sound
+            mVirtualSounds[ptr].push_back(virt);
+
+            snditer->second.erase(sndidx);
+            if(snditer->second.empty())
+                mActiveSounds.erase(snditer);
+            return;
+        }
+    }
+
+    void SoundManager::startVirtualSound(const MWWorld::ConstPtr &ptr, MWBase::SoundPtr sound)
+    {
+        VirtualSoundMap::iterator virtiter = mVirtualSounds.find(ptr);
+        if(virtiter == mVirtualSounds.end())
+            return;
+        VirtualSoundList::iterator sndidx = virtiter->second.begin();
+        for(;sndidx != virtiter->second.end();++sndidx)
+        {
+            if(sndidx->mSound != sound)
+                continue;
+
+            Sound_Buffer *sfx = sndidx->mBuffer;
+            float offset = sndidx->mOffset;
+            virtiter->second.erase(sndidx);
+            if(virtiter->second.empty())
+                mVirtualSounds.erase(virtiter);
+
+            try {
+                startSound(ptr, sound, sfx, offset);
+            }
+            catch(std::exception &e) {
+                std::cerr<< "Sound Error: "<<e.what() <<std::endl;
+                releaseBuffer(sfx);
+            }
+            return;
+        }
+    }
+
+    void SoundManager::updateVirtualSounds(float duration)
+    {
+        std::vector<VoiceRank> virtualRanks;
+
+        VirtualSoundMap::iterator virtiter = mVirtualSounds.begin();
+        while(virtiter != mVirtualSounds.end())
+        {
+            const MWWorld::ConstPtr &ptr = virtiter->first;
+            VirtualSoundList::iterator sndidx = virtiter->second.begin();
+            while(sndidx != virtiter->second.end())
             {
-                do {
-                    if(mUnusedBuffers.empty())
+                MWBase::SoundPtr sound = sndidx->mSound;
+                Sound_Buffer *sfx = sndidx->mBuffer;
+                if(sound->getPlayType() & mPausedSoundTypes)
+                {
+                    ++sndidx;
+                    continue;
+                }
+
+                bool keep = sfx->mLoading || sfx->mHandle;
+                if(keep && !ptr.isEmpty() && sound->getIs3D())
+                {
+                    const osg::Vec3f objpos(ptr.getRefData().getPosition().asVec3());
+                    sound->setPosition(objpos);
+                    if(sound->getDistanceCull() && (mListenerPos - objpos).length2() > 2000*2000)
+                        keep = false;
+                }
+
+                // Sounds still waiting for their buffer start from their
+                // initial offset, the others keep time as if they played
+                if(keep && !sfx->mLoading)
+                {
+                    sndidx->mOffset += duration * sound->getPitch();
+                    float length = mOutput->getSoundDuration(sfx->mHandle);
+                    if(sndidx->mOffset >= length)
                     {
-                        std::cerr<< "No unused sound buffers to free, using "<<mBufferCacheSize<<" bytes!" <<std::endl;
-                        break;
+                        if(sound->getIsLooping() && length > 0.0f)
+                            sndidx->mOffset = std::fmod(sndidx->mOffset, length);
+                        else
+                            keep = false;
                     }
-                    Sound_Buffer *unused = mUnusedBuffers.back();
+                }
+
+                if(!keep)
+                {
+                    releaseBuffer(sfx);
+                    sndidx = virtiter->second.erase(sndidx);
+                    continue;
+                }
 
-                    mBufferCacheSize -= mOutput->getSoundDataSize(unused->mHandle);
-                    mOutput->unloadSound(unused->mHandle);
-                    unused->mHandle = 0;
+                sound->updateFade(duration);
+                if(!sfx->mLoading)
+                {
+                    float audibility = getAudibility(*sound);
+                    if(audibility > 0.0f)
+                        virtualRanks.push_back(VoiceRank(audibility, ptr, sound));
+                }
+                ++sndidx;
+            }
+            if(virtiter->second.empty())
+                mVirtualSounds.erase(virtiter++);
+            else
+                ++virtiter;
+        }
 
-                    mUnusedBuffers.pop_back();
-                } while(mBufferCacheSize > mBufferCacheMin);
+        // Playing sounds that can not be heard give up their source right
+        // away, the others are candidates to have it stolen by louder ones
+        std::vector<VoiceRank> activeRanks;
+        std::vector<VoiceRank> inaudible;
+        SoundMap::iterator snditer = mActiveSounds.begin();
+        for(;snditer != mActiveSounds.end();++snditer)
+        {
+            SoundBufferRefPairList::iterator sndidx = snditer->second.begin();
+            for(;sndidx != snditer->second.end();++sndidx)
+            {
+                MWBase::SoundPtr sound = sndidx->first;
+                if(sound->getPlayType() & mPausedSoundTypes)
+                    continue;
+                float audibility = getAudibility(*sound);
+                if(audibility > 0.0f || !sound->getIs3D())
+                    activeRanks.push_back(VoiceRank(audibility, snditer->first, sound));
+                else
+                    inaudible.push_back(VoiceRank(audibility, snditer->first, sound));
             }
-            mUnusedBuffers.push_front(sfx);
         }
+        for(std::vector<VoiceRank>::iterator it = inaudible.begin();it != inaudible.end();++it)
+            virtualizeSound(it->mPtr, it->mSound);
 
-        return sfx;
+        if(virtualRanks.empty())
+            return;
+
+        std::sort(virtualRanks.begin(), virtualRanks.end(), VoiceRankGreater());
+        std::sort(activeRanks.begin(), activeRanks.end(), VoiceRankLess());
+
+        size_t freeSources = mOutput->getFreeSourceCount();
+        std::vector<VoiceRank>::iterator quietest = activeRanks.begin();
+        int steals = 0;
+        std::vector<VoiceRank>::iterator candidate = virtualRanks.begin();
+        for(;candidate != virtualRanks.end();++candidate)
+        {
+            if(freeSources <= sStreamSources)
+            {
+                // Only take the source of a clearly quieter sound, so that
+                // sounds of similar audibility do not keep trading places
+                if(steals >= sMaxStealsPerUpdate || quietest == activeRanks.end() ||
+                   quietest->mAudibility*sStealFactor >= candidate->mAudibility)
+                    break;
+                virtualizeSound(quietest->mPtr, quietest->mSound);
+                ++quietest;
+                ++steals;
+            }
+            else
+                --freeSources;
+            startVirtualSound(candidate->mPtr, candidate->mSound);
+        }
+    }
+
+    bool SoundManager::isSoundVirtual(MWBase::SoundPtr sound) const
+    {
+        VirtualSoundMap::const_iterator penditer = mVirtualSounds.begin();
+        for(;penditer != mVirtualSounds.end();++penditer)
+        {
+            VirtualSoundList::const_iterator sndidx = penditer->second.begin();
+            for(;sndidx != penditer->second.end();++sndidx)
+            {
+                if(sndidx->mSound == sound)
+                    return true;
+            }
+        }
+        return false;
     }
 
     DecoderPtr SoundManager::loadVoice(const std::string &voicefile, Sound_Loudness **lipdata)
     {
         DecoderPtr decoder = getDecoder();
         // Workaround: Bethesda at some point converted some of the files to mp3, but the references were kept as .wav.
-        if(mVFS->exists(voicefile))
-            decoder->open(voicefile);
-        else
+        std::string file = voicefile;
+        if(!mVFS->exists(file))
         {
-            std::string file = voicefile;
             std::string::size_type pos = file.rfind('.');
             if(pos != std::string::npos)
                 file = file.substr(0, pos)+".mp3";
-            decoder->open(file);
         }
+        decoder->open(file);
 
         NameLoudnessRefMap::iterator lipiter = mVoiceLipNameMap.find(voicefile);
-        if(lipiter != mVoiceLipNameMap.end())
+        if(lipiter == mVoiceLipNameMap.end())
         {
-            *lipdata = lipiter->second;
-            return decoder;
-        }
-
-        mVoiceLipBuffers.insert(mVoiceLipBuffers.end(), Sound_Loudness());
-        lipiter = mVoiceLipNameMap.insert(
-            std::make_pair(voicefile, &mVoiceLipBuffers.back())
-        ).first;
+            mVoiceLipBuffers.insert(mVoiceLipBuffers.end(), Sound_Loudness());
+            lipiter = mVoiceLipNameMap.insert(
+                std::make_pair(voicefile, &mVoiceLipBuffers.back())
+            ).first;
 
-        mOutput->loadLoudnessAsync(decoder, lipiter->second);
+            if(mLoudnessCache.get())
+            {
+                // The size tells apart voices replaced by a mod of the same name
+                Files::IStreamPtr stream = mVFS->get(file);
+                stream->seekg(0, std::ios::end);
+                UncachedVoice voice;
+                voice.mName = file;
+                voice.mSize = static_cast<boost::uint64_t>(stream->tellg());
+                voice.mLoudness = lipiter->second;
+                if(!mLoudnessCache->get(voice.mName, voice.mSize, *voice.mLoudness))
+                    mUncachedVoices.push_back(voice);
+            }
+        }
 
         *lipdata = lipiter->second;
         return decoder;
     }
 
-    MWBase::SoundStreamPtr SoundManager::playVoice(DecoderPtr decoder, const osg::Vec3f &pos, bool playlocal)
+    MWBase::SoundStreamPtr SoundManager::playVoice(DecoderPtr decoder, Sound_Loudness *lipdata, const osg::Vec3f &pos, bool playlocal)
     {
         MWBase::World* world = MWBase::Environment::get().getWorld();
         static const float fAudioMinDistanceMult = world->getStore().get<ESM::GameSetting>().find("fAudioMinDistanceMult")->getFloat();
@@ -267,13 +668,13 @@ namespace MWSound
         if(playlocal)
         {
             sound.reset(new Stream(1.0f, basevol, 1.0f, Play_Normal|Play_TypeVoice|Play_2D));
-            mOutput->streamSound(decoder, sound);
+            mOutput->streamSound(decoder, sound, lipdata);
         }
         else
         {
             sound.reset(new Stream(pos, 1.0f, basevol, 1.0f, minDistance, maxDistance,
                                    Play_Normal|Play_TypeVoice|Play_3D));
-            mOutput->streamSound3D(decoder, sound);
+            mOutput->streamSound3D(decoder, sound, lipdata);
         }
         return sound;
     }
@@ -327,7 +728,7 @@ namespace MWSound
 
             mMusic.reset(new Stream(1.0f, volumeFromType(Play_TypeMusic), 1.0f,
                                     Play_NoEnv|Play_TypeMusic|Play_2D));
-            mOutput->streamSound(decoder, mMusic);
+            mOutput->streamSound(decoder, mMusic, NULL);
         }
         catch(std::exception &e) {
             std::cout << "Music Error: " << e.what() << "\n";
@@ -404,24 +805,19 @@ namespace MWSound
             mVFS->normalizeFilename(voicefile);
             DecoderPtr decoder = loadVoice(voicefile, &loudness);
 
-            if(!loudness->isReady())
-                mPendingSaySounds[ptr] = std::make_pair(decoder, loudness);
-            else
-            {
-                MWBase::World *world = MWBase::Environment::get().getWorld();
-                const osg::Vec3f pos = world->getActorHeadTransform(ptr).getTrans();
+            MWBase::World *world = MWBase::Environment::get().getWorld();
+            const osg::Vec3f pos = world->getActorHeadTransform(ptr).getTrans();
 
-                SaySoundMap::iterator oldIt = mActiveSaySounds.find(ptr);
-                if (oldIt != mActiveSaySounds.end())
-                {
-                    mOutput->finishStream(oldIt->second.first);
-                    mActiveSaySounds.erase(oldIt);
-                }
+            SaySoundMap::iterator oldIt = mActiveSaySounds.find(ptr);
+            if (oldIt != mActiveSaySounds.end())
+            {
+                mOutput->finishStream(oldIt->second);
+                mActiveSaySounds.erase(oldIt);
+            }
 
-                MWBase::SoundStreamPtr sound = playVoice(decoder, pos, (ptr == MWMechanics::getPlayer()));
+            MWBase::SoundStreamPtr sound = playVoice(decoder, loudness, pos, (ptr == MWMechanics::getPlayer()));
 
-                mActiveSaySounds.insert(std::make_pair(ptr, std::make_pair(sound, loudness)));
-            }
+            mActiveSaySounds.insert(std::make_pair(ptr, sound));
         }
         catch(std::exception &e)
         {
@@ -434,10 +830,7 @@ namespace MWSound
         SaySoundMap::const_iterator snditer = mActiveSaySounds.find(ptr);
         if(snditer != mActiveSaySounds.end())
         {
-            MWBase::SoundStreamPtr sound = snditer->second.first;
-            Sound_Loudness *loudness = snditer->second.second;
-            float sec = mOutput->getStreamOffset(sound);
-            return loudness->getLoudnessAtTime(sec);
+            return mOutput->getStreamLoudness(snditer->second);
         }
 
         return 0.0f;
@@ -455,20 +848,15 @@ namespace MWSound
             mVFS->normalizeFilename(voicefile);
             DecoderPtr decoder = loadVoice(voicefile, &loudness);
 
-            if(!loudness->isReady())
-                mPendingSaySounds[MWWorld::ConstPtr()] = std::make_pair(decoder, loudness);
-            else
+            SaySoundMap::iterator oldIt = mActiveSaySounds.find(MWWorld::ConstPtr());
+            if (oldIt != mActiveSaySounds.end())
             {
-                SaySoundMap::iterator oldIt = mActiveSaySounds.find(MWWorld::ConstPtr());
-                if (oldIt != mActiveSaySounds.end())
-                {
-                    mOutput->finishStream(oldIt->second.first);
-                    mActiveSaySounds.erase(oldIt);
-                }
-
-                mActiveSaySounds.insert(std::make_pair(MWWorld::ConstPtr(),
-                                                       std::make_pair(playVoice(decoder, osg::Vec3f(), true), loudness)));
+                mOutput->finishStream(oldIt->second);
+                mActiveSaySounds.erase(oldIt);
             }
+
+            mActiveSaySounds.insert(std::make_pair(MWWorld::ConstPtr(),
+                                                   playVoice(decoder, loudness, osg::Vec3f(), true)));
         }
         catch(std::exception &e)
         {
@@ -480,12 +868,8 @@ namespace MWSound
     {
         SaySoundMap::const_iterator snditer = mActiveSaySounds.find(ptr);
         if(snditer != mActiveSaySounds.end())
-        {
-            if(mOutput->isStreamPlaying(snditer->second.first))
-                return false;
-            return true;
-        }
-        return mPendingSaySounds.find(ptr) == mPendingSaySounds.end();
+            return !mOutput->isStreamPlaying(snditer->second);
+        return true;
     }
 
     void SoundManager::stopSay(const MWWorld::ConstPtr &ptr)
@@ -493,10 +877,9 @@ namespace MWSound
         SaySoundMap::iterator snditer = mActiveSaySounds.find(ptr);
         if(snditer != mActiveSaySounds.end())
         {
-            mOutput->finishStream(snditer->second.first);
+            mOutput->finishStream(snditer->second);
             mActiveSaySounds.erase(snditer);
         }
-        mPendingSaySounds.erase(ptr);
     }
 
 
@@ -508,7 +891,7 @@ namespace MWSound
         try
         {
             track.reset(new Stream(1.0f, volumeFromType(type), 1.0f, Play_NoEnv|type|Play_2D));
-            mOutput->streamSound(decoder, track);
+            mOutput->streamSound(decoder, track, NULL);
 
             TrackList::iterator iter = std::lower_bound(mActiveTracks.begin(), mActiveTracks.end(), track);
             mActiveTracks.insert(iter, track);
@@ -541,18 +924,11 @@ namespace MWSound
             return sound;
         try
         {
-            Sound_Buffer *sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
+            Sound_Buffer *sfx = loadSoundAsync(Misc::StringUtils::lowerCase(soundId));
             float basevol = volumeFromType(type);
 
             sound.reset(new Sound(volume * sfx->mVolume, basevol, pitch, mode|type|Play_2D));
-            mOutput->playSound(sound, sfx->mHandle, offset);
-            if(sfx->mUses++ == 0)
-            {
-                SoundList::iterator iter = std::find(mUnusedBuffers.begin(), mUnusedBuffers.end(), sfx);
-                if(iter != mUnusedBuffers.end())
-                    mUnusedBuffers.erase(iter);
-            }
-            mActiveSounds[MWWorld::ConstPtr()].push_back(std::make_pair(sound, sfx));
+            playBuffer(MWWorld::ConstPtr(), sound, sfx, offset);
         }
         catch(std::exception&)
         {
@@ -570,33 +946,22 @@ namespace MWSound
             return sound;
         try
         {
-            // Look up the sound in the ESM data
-            Sound_Buffer *sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
-            float basevol = volumeFromType(type);
             const ESM::Position &pos = ptr.getRefData().getPosition();
             const osg::Vec3f objpos(pos.asVec3());
 
             if((mode&Play_RemoveAtDistance) && (mListenerPos-objpos).length2() > 2000*2000)
                 return MWBase::SoundPtr();
 
+            // Look up the sound in the ESM data
+            Sound_Buffer *sfx = loadSoundAsync(Misc::StringUtils::lowerCase(soundId));
+            float basevol = volumeFromType(type);
+
             if(!(mode&Play_NoPlayerLocal) && ptr == MWMechanics::getPlayer())
-            {
                 sound.reset(new Sound(volume * sfx->mVolume, basevol, pitch, mode|type|Play_2D));
-                mOutput->playSound(sound, sfx->mHandle, offset);
-            }
             else
-            {
                 sound.reset(new Sound(objpos, volume * sfx->mVolume, basevol, pitch,
                                       sfx->mMinDist, sfx->mMaxDist, mode|type|Play_3D));
-                mOutput->playSound3D(sound, sfx->mHandle, offset);
-            }
-            if(sfx->mUses++ == 0)
-            {
-                SoundList::iterator iter = std::find(mUnusedBuffers.begin(), mUnusedBuffers.end(), sfx);
-                if(iter != mUnusedBuffers.end())
-                    mUnusedBuffers.erase(iter);
-            }
-            mActiveSounds[ptr].push_back(std::make_pair(sound, sfx));
+            playBuffer(ptr, sound, sfx, offset);
         }
         catch(std::exception&)
         {
@@ -615,19 +980,12 @@ namespace MWSound
         try
         {
             // Look up the sound in the ESM data
-            Sound_Buffer *sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
+            Sound_Buffer *sfx = loadSoundAsync(Misc::StringUtils::lowerCase(soundId));
             float basevol = volumeFromType(type);
 
             sound.reset(new Sound(initialPos, volume * sfx->mVolume, basevol, pitch,
                                   sfx->mMinDist, sfx->mMaxDist, mode|type|Play_3D));
-            mOutput->playSound3D(sound, sfx->mHandle, offset);
-            if(sfx->mUses++ == 0)
-            {
-                SoundList::iterator iter = std::find(mUnusedBuffers.begin(), mUnusedBuffers.end(), sfx);
-                if(iter != mUnusedBuffers.end())
-                    mUnusedBuffers.erase(iter);
-            }
-            mActiveSounds[MWWorld::ConstPtr()].push_back(std::make_pair(sound, sfx));
+            playBuffer(MWWorld::ConstPtr(), sound, sfx, offset);
         }
         catch(std::exception &)
         {
@@ -639,16 +997,61 @@ namespace MWSound
 
     void SoundManager::stopSound(MWBase::SoundPtr sound)
     {
-        if (sound.get())
-            mOutput->finishSound(sound);
+        if (!sound.get())
+            return;
+
+        mOutput->finishSound(sound);
+
+        VirtualSoundMap::iterator penditer = mVirtualSounds.begin();
+        for(;penditer != mVirtualSounds.end();++penditer)
+        {
+            VirtualSoundList::iterator sndidx = penditer->second.begin();
+            for(;sndidx != penditer->second.end();++sndidx)
+            {
+                if(sndidx->mSound == sound)
+                {
+                    releaseBuffer(sndidx->mBuffer);
+                    penditer->second.erase(sndidx);
+                    if(penditer->second.empty())
+                        mVirtualSounds.erase(penditer);
+                    return;
+                }
+            }
+        }
+    }
+
+    void SoundManager::stopVirtualSounds(const MWWorld::ConstPtr &ptr, Sound_Buffer *sfx)
+    {
+        VirtualSoundMap::iterator penditer = mVirtualSounds.find(ptr);
+        if(penditer == mVirtualSounds.end())
+            return;
+
+        VirtualSoundList::iterator sndidx = penditer->second.begin();
+        while(sndidx != penditer->second.end())
+        {
+            if(!sfx || sndidx->mBuffer == sfx)
+            {
+                releaseBuffer(sndidx->mBuffer);
+                sndidx = penditer->second.erase(sndidx);
+            }
+            else
+                ++sndidx;
+        }
+        if(penditer->second.empty())
+            mVirtualSounds.erase(penditer);
     }
 
     void SoundManager::stopSound3D(const MWWorld::ConstPtr &ptr, const std::string& soundId)
     {
+        Sound_Buffer *sfx = lookupSound(Misc::StringUtils::lowerCase(soundId));
+        if(!sfx)
+            return;
+
+        stopVirtualSounds(ptr, sfx);
+
         SoundMap::iterator snditer = mActiveSounds.find(ptr);
         if(snditer != mActiveSounds.end())
         {
-            Sound_Buffer *sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
             SoundBufferRefPairList::iterator sndidx = snditer->second.begin();
             for(;sndidx != snditer->second.end();++sndidx)
             {
@@ -660,6 +1063,8 @@ namespace MWSound
 
     void SoundManager::stopSound3D(const MWWorld::ConstPtr &ptr)
     {
+        stopVirtualSounds(ptr, NULL);
+
         SoundMap::iterator snditer = mActiveSounds.find(ptr);
         if(snditer != mActiveSounds.end())
         {
@@ -671,6 +1076,22 @@ namespace MWSound
 
     void SoundManager::stopSound(const MWWorld::CellStore *cell)
     {
+        VirtualSoundMap::iterator penditer = mVirtualSounds.begin();
+        while(penditer != mVirtualSounds.end())
+        {
+            if(penditer->first != MWWorld::ConstPtr() &&
+               penditer->first != MWMechanics::getPlayer() &&
+               penditer->first.getCell() == cell)
+            {
+                VirtualSoundList::iterator sndidx = penditer->second.begin();
+                for(;sndidx != penditer->second.end();++sndidx)
+                    releaseBuffer(sndidx->mBuffer);
+                mVirtualSounds.erase(penditer++);
+            }
+            else
+                ++penditer;
+        }
+
         SoundMap::iterator snditer = mActiveSounds.begin();
         while(snditer != mActiveSounds.end())
         {
@@ -691,7 +1112,7 @@ namespace MWSound
                sayiter->first != MWMechanics::getPlayer() &&
                sayiter->first.getCell() == cell)
             {
-                mOutput->finishStream(sayiter->second.first);
+                mOutput->finishStream(sayiter->second);
             }
             ++sayiter;
         }
@@ -699,10 +1120,15 @@ namespace MWSound
 
     void SoundManager::stopSound(const std::string& soundId)
     {
+        Sound_Buffer *sfx = lookupSound(Misc::StringUtils::lowerCase(soundId));
+        if(!sfx)
+            return;
+
+        stopVirtualSounds(MWWorld::ConstPtr(), sfx);
+
         SoundMap::iterator snditer = mActiveSounds.find(MWWorld::ConstPtr());
         if(snditer != mActiveSounds.end())
         {
-            Sound_Buffer *sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
             SoundBufferRefPairList::iterator sndidx = snditer->second.begin();
             for(;sndidx != snditer->second.end();++sndidx)
             {
@@ -715,10 +1141,13 @@ namespace MWSound
     void SoundManager::fadeOutSound3D(const MWWorld::ConstPtr &ptr,
             const std::string& soundId, float duration)
     {
+        Sound_Buffer *sfx = lookupSound(Misc::StringUtils::lowerCase(soundId));
+        if(!sfx)
+            return;
+
         SoundMap::iterator snditer = mActiveSounds.find(ptr);
         if(snditer != mActiveSounds.end())
         {
-            Sound_Buffer *sfx = loadSound(Misc::StringUtils::lowerCase(soundId));
             SoundBufferRefPairList::iterator sndidx = snditer->second.begin();
             for(;sndidx != snditer->second.end();++sndidx)
             {
@@ -726,14 +1155,39 @@ namespace MWSound
                     sndidx->first->setFadeout(duration);
             }
         }
+        VirtualSoundMap::iterator penditer = mVirtualSounds.find(ptr);
+        if(penditer != mVirtualSounds.end())
+        {
+            VirtualSoundList::iterator sndidx = penditer->second.begin();
+            for(;sndidx != penditer->second.end();++sndidx)
+            {
+                if(sndidx->mBuffer == sfx)
+                    sndidx->mSound->setFadeout(duration);
+            }
+        }
     }
 
     bool SoundManager::getSoundPlaying(const MWWorld::ConstPtr &ptr, const std::string& soundId) const
     {
+        Sound_Buffer *sfx = lookupSound(Misc::StringUtils::lowerCase(soundId));
+        if(!sfx)
+            return false;
+
+        // Sounds waiting for their buffers count as playing, so that scripts do not start them again
+        VirtualSoundMap::const_iterator penditer = mVirtualSounds.find(ptr);
+        if(penditer != mVirtualSounds.end())
+        {
+            VirtualSoundList::const_iterator sndidx = penditer->second.begin();
+            for(;sndidx != penditer->second.end();++sndidx)
+            {
+                if(sndidx->mBuffer == sfx)
+                    return true;
+            }
+        }
+
         SoundMap::const_iterator snditer = mActiveSounds.find(ptr);
         if(snditer != mActiveSounds.end())
         {
-            Sound_Buffer *sfx = lookupSound(Misc::StringUtils::lowerCase(soundId));
             SoundBufferRefPairList::const_iterator sndidx = snditer->second.begin();
             for(;sndidx != snditer->second.end();++sndidx)
             {
@@ -857,6 +1311,8 @@ namespace MWSound
             env
         );
 
+        finishLoading();
+
         // Check if any sounds are finished playing, and trash them
         SoundMap::iterator snditer = mActiveSounds.begin();
         while(snditer != mActiveSounds.end())
@@ -882,9 +1338,7 @@ namespace MWSound
                 if(!mOutput->isSoundPlaying(sound))
                 {
                     mOutput->finishSound(sound);
-                    Sound_Buffer *sfx = sndidx->second;
-                    if(sfx->mUses-- == 1)
-                        mUnusedBuffers.push_front(sfx);
+                    releaseBuffer(sndidx->second);
                     sndidx = snditer->second.erase(sndidx);
                 }
                 else
@@ -901,51 +1355,14 @@ namespace MWSound
                 ++snditer;
         }
 
-        SayDecoderMap::iterator penditer = mPendingSaySounds.begin();
-        while(penditer != mPendingSaySounds.end())
-        {
-            Sound_Loudness *loudness = penditer->second.second;
-            if(loudness->isReady())
-            {
-                try {
-                    DecoderPtr decoder = penditer->second.first;
-                    decoder->rewind();
-
-                    MWBase::SoundStreamPtr sound;
-                    MWWorld::ConstPtr ptr = penditer->first;
-
-                    SaySoundMap::iterator old = mActiveSaySounds.find(ptr);
-                    if (old != mActiveSaySounds.end())
-                    {
-                        mOutput->finishStream(old->second.first);
-                        mActiveSaySounds.erase(old);
-                    }
-
-                    if(ptr == MWWorld::ConstPtr())
-                        sound = playVoice(decoder, osg::Vec3f(), true);
-                    else
-                    {
-                        MWBase::World *world = MWBase::Environment::get().getWorld();
-                        const osg::Vec3f pos = world->getActorHeadTransform(ptr).getTrans();
-                        sound = playVoice(decoder, pos, (ptr == MWMechanics::getPlayer()));
-                    }
-                    mActiveSaySounds.insert(std::make_pair(ptr, std::make_pair(sound, loudness)));
-                }
-                catch(std::exception &e) {
-                    std::cerr<< "Sound Error: "<<e.what() <<std::endl;
-                }
-
-                mPendingSaySounds.erase(penditer++);
-            }
-            else
-                ++penditer;
-        }
+        // After finished sounds have returned their sources
+        updateVirtualSounds(duration);
 
         SaySoundMap::iterator sayiter = mActiveSaySounds.begin();
         while(sayiter != mActiveSaySounds.end())
         {
             MWWorld::ConstPtr ptr = sayiter->first;
-            MWBase::SoundStreamPtr sound = sayiter->second.first;
+            MWBase::SoundStreamPtr sound = sayiter->second;
             if(!ptr.isEmpty() && sound->getIs3D())
             {
                 MWBase::World *world = MWBase::Environment::get().getWorld();
@@ -994,7 +1411,7 @@ namespace MWSound
         if(mListenerUnderwater)
         {
             // Play underwater sound (after updating sounds)
-            if(!(mUnderwaterSound && mOutput->isSoundPlaying(mUnderwaterSound)))
+            if(!(mUnderwaterSound && (mOutput->isSoundPlaying(mUnderwaterSound) || isSoundVirtual(mUnderwaterSound))))
                 mUnderwaterSound = playSound("Underwater", 1.0f, 1.0f, Play_TypeSfx, Play_LoopNoEnv);
         }
         mOutput->finishUpdate();
@@ -1040,7 +1457,7 @@ namespace MWSound
         SaySoundMap::iterator sayiter = mActiveSaySounds.begin();
         for(;sayiter != mActiveSaySounds.end();++sayiter)
         {
-            MWBase::SoundStreamPtr sound = sayiter->second.first;
+            MWBase::SoundStreamPtr sound = sayiter->second;
             sound->setBaseVolume(volumeFromType(sound->getPlayType()));
             mOutput->updateStream(sound);
         }
@@ -1080,19 +1497,117 @@ namespace MWSound
         SaySoundMap::iterator sayiter = mActiveSaySounds.find(old);
         if(sayiter != mActiveSaySounds.end())
         {
-            SoundLoudnessPair sndlist = sayiter->second;
+            MWBase::SoundStreamPtr sound = sayiter->second;
             mActiveSaySounds.erase(sayiter);
-            mActiveSaySounds[updated] = sndlist;
+            mActiveSaySounds[updated] = sound;
         }
-        SayDecoderMap::iterator penditer = mPendingSaySounds.find(old);
-        if(penditer != mPendingSaySounds.end())
+        VirtualSoundMap::iterator pendsnditer = mVirtualSounds.find(old);
+        if(pendsnditer != mVirtualSounds.end())
         {
-            DecoderLoudnessPair dl = penditer->second;
-            mPendingSaySounds.erase(penditer);
-            mPendingSaySounds[updated] = dl;
+            VirtualSoundList sndlist = pendsnditer->second;
+            mVirtualSounds.erase(pendsnditer);
+            mVirtualSounds[updated] = sndlist;
         }
     }
 
+    namespace
+    {
+        struct ListCreaturesVisitor
+        {
+            std::vector<std::string> mIds;
+
+            bool operator()(const MWWorld::Ptr &ptr)
+            {
+                const MWWorld::LiveCellRef<ESM::Creature> *ref = ptr.get<ESM::Creature>();
+                // Creatures that are copies of others use their sounds
+                const std::string &id = ref->mBase->mOriginal.empty() ? ptr.getCellRef().getRefId() : ref->mBase->mOriginal;
+                mIds.push_back(Misc::StringUtils::lowerCase(id));
+                return true;
+            }
+        };
+    }
+
+    void SoundManager::preloadSounds(MWWorld::CellStore *cell)
+    {
+        if(!mOutput->isInitialized() || mCellBuffers.find(cell) != mCellBuffers.end())
+            return;
+
+        if(!mCreatureSoundsListed)
+        {
+            const MWWorld::Store<ESM::SoundGenerator> &store =
+                MWBase::Environment::get().getWorld()->getStore().get<ESM::SoundGenerator>();
+            for(MWWorld::Store<ESM::SoundGenerator>::iterator iter = store.begin();iter != store.end();++iter)
+            {
+                if(!iter->mCreature.empty())
+                    mCreatureSounds[Misc::StringUtils::lowerCase(iter->mCreature)].push_back(
+                        Misc::StringUtils::lowerCase(iter->mSound));
+            }
+            mCreatureSoundsListed = true;
+        }
+
+        ListCreaturesVisitor visitor;
+        cell->forEachType<ESM::Creature>(visitor);
+
+        std::sort(visitor.mIds.begin(), visitor.mIds.end());
+        visitor.mIds.erase(std::unique(visitor.mIds.begin(), visitor.mIds.end()), visitor.mIds.end());
+
+        std::vector<Sound_Buffer*> &buffers = mCellBuffers[cell];
+        for(std::vector<std::string>::const_iterator id = visitor.mIds.begin();id != visitor.mIds.end();++id)
+        {
+            CreatureSoundMap::const_iterator sounds = mCreatureSounds.find(*id);
+            if(sounds == mCreatureSounds.end())
+                continue;
+
+            for(std::vector<std::string>::const_iterator sound = sounds->second.begin();sound != sounds->second.end();++sound)
+            {
+                try {
+                    Sound_Buffer *sfx = getSoundBuffer(*sound);
+                    ++sfx->mCellUses;
+                    buffers.push_back(sfx);
+                    if(mLoadInBackground)
+                        startLoading(sfx);
+                }
+                catch(std::exception &e) {
+                    std::cerr<< "Failed to preload sound "<<*sound<<": "<<e.what() <<std::endl;
+                }
+            }
+        }
+    }
+
+    void SoundManager::unloadSounds(const MWWorld::CellStore *cell)
+    {
+        CellBufferMap::iterator found = mCellBuffers.find(cell);
+        if(found == mCellBuffers.end())
+            return;
+
+        std::vector<Sound_Buffer*>::iterator iter = found->second.begin();
+        for(;iter != found->second.end();++iter)
+            --(*iter)->mCellUses;
+        mCellBuffers.erase(found);
+    }
+
+    void SoundManager::reportStats(unsigned int frameNumber, osg::Stats &stats)
+    {
+        size_t numPlaying = 0;
+        for(SoundMap::const_iterator iter = mActiveSounds.begin();iter != mActiveSounds.end();++iter)
+            numPlaying += iter->second.size();
+        size_t numVirtual = 0;
+        for(VirtualSoundMap::const_iterator iter = mVirtualSounds.begin();iter != mVirtualSounds.end();++iter)
+            numVirtual += iter->second.size();
+
+        stats.setAttribute(frameNumber, "sound_buffer_cache_size", mBufferCacheSize);
+        stats.setAttribute(frameNumber, "sound_buffer_cache_unused", mUnusedBuffers.size());
+        stats.setAttribute(frameNumber, "sound_buffer_cache_hits", mCacheHits);
+        stats.setAttribute(frameNumber, "sound_buffer_cache_misses", mCacheMisses);
+        stats.setAttribute(frameNumber, "sound_buffer_cache_evictions", mCacheEvictions);
+        stats.setAttribute(frameNumber, "sound_playing", numPlaying);
+        stats.setAttribute(frameNumber, "sound_virtual", numVirtual);
+        stats.setAttribute(frameNumber, "sound_voices", mActiveSaySounds.size());
+        mCacheHits = 0;
+        mCacheMisses = 0;
+        mCacheEvictions = 0;
+    }
+
     // Default readAll implementation, for decoders that can't do anything
     // better
     void Sound_Decoder::readAll(std::vector<char> &output)
@@ -1167,22 +1682,30 @@ namespace MWSound
             for(;sndidx != snditer->second.end();++sndidx)
             {
                 mOutput->finishSound(sndidx->first);
-                Sound_Buffer *sfx = sndidx->second;
-                if(sfx->mUses-- == 1)
-                    mUnusedBuffers.push_front(sfx);
+                releaseBuffer(sndidx->second);
             }
         }
         mActiveSounds.clear();
+        VirtualSoundMap::iterator penditer = mVirtualSounds.begin();
+        for(;penditer != mVirtualSounds.end();++penditer)
+        {
+            VirtualSoundList::iterator sndidx = penditer->second.begin();
+            for(;sndidx != penditer->second.end();++sndidx)
+                releaseBuffer(sndidx->mBuffer);
+        }
+        mVirtualSounds.clear();
         SaySoundMap::iterator sayiter = mActiveSaySounds.begin();
         for(;sayiter != mActiveSaySounds.end();++sayiter)
-            mOutput->finishStream(sayiter->second.first);
+            mOutput->finishStream(sayiter->second);
         mActiveSaySounds.clear();
         TrackList::iterator trkiter = mActiveTracks.begin();
         for(;trkiter != mActiveTracks.end();++trkiter)
             mOutput->finishStream(*trkiter);
         mActiveTracks.clear();
-        mPendingSaySounds.clear();
         mUnderwaterSound.reset();
         stopMusic();
+
+        while(!mCellBuffers.empty())
+            unloadSounds(mCellBuffers.begin()->first);
     }
 }
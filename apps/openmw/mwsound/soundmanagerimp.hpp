@@ -5,9 +5,12 @@
 #include <string>
 #include <utility>
 #include <deque>
+#include <list>
 #include <map>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
 
 #include <components/settings/settings.hpp>
 
@@ -30,6 +33,7 @@ namespace MWSound
     struct Sound_Decoder;
     class Sound;
     class Sound_Buffer;
+    class LoudnessCache;
 
     enum Environment {
         Env_Normal,
@@ -75,23 +79,63 @@ namespace MWSound
         typedef std::map<std::string,Sound_Loudness*> NameLoudnessRefMap;
         NameLoudnessRefMap mVoiceLipNameMap;
 
-        // NOTE: unused buffers are stored in front-newest order.
-        typedef std::deque<Sound_Buffer*> SoundList;
+        std::auto_ptr<LoudnessCache> mLoudnessCache;
+        // Voices that were not in the loudness cache, added to it once they
+        // are analyzed
+        struct UncachedVoice
+        {
+            std::string mName;
+            boost::uint64_t mSize;
+            Sound_Loudness *mLoudness;
+        };
+        std::vector<UncachedVoice> mUncachedVoices;
+
+        // NOTE: unused buffers are stored in front-newest order, so the least
+        // recently used ones are freed first.
+        typedef std::list<Sound_Buffer*> SoundList;
         SoundList mUnusedBuffers;
 
+        // Buffers of the sounds of the creatures in each active cell, see
+        // Sound_Buffer::mCellUses
+        typedef std::map<const MWWorld::CellStore*,std::vector<Sound_Buffer*> > CellBufferMap;
+        CellBufferMap mCellBuffers;
+
+        // For the stats overlay, since the last report
+        unsigned int mCacheHits;
+        unsigned int mCacheMisses;
+        unsigned int mCacheEvictions;
+
         typedef std::pair<MWBase::SoundPtr,Sound_Buffer*> SoundBufferRefPair;
         typedef std::vector<SoundBufferRefPair> SoundBufferRefPairList;
         typedef std::map<MWWorld::ConstPtr,SoundBufferRefPairList> SoundMap;
         SoundMap mActiveSounds;
 
-        typedef std::pair<MWBase::SoundStreamPtr,Sound_Loudness*> SoundLoudnessPair;
-        typedef std::map<MWWorld::ConstPtr,SoundLoudnessPair> SaySoundMap;
+        bool mLoadInBackground;
+        // Buffers being decoded in the background
+        std::vector<Sound_Buffer*> mLoadingBuffers;
+
+        // Sounds that are not given a source, either because their buffer is
+        // still loading or because louder sounds are using all of them. They
+        // keep time without being heard, and are started from their current
+        // offset once a source is available. Each holds a use of its buffer.
+        struct VirtualSound
+        {
+            MWBase::SoundPtr mSound;
+            Sound_Buffer *mBuffer;
+            float mOffset;
+        };
+        typedef std::vector<VirtualSound> VirtualSoundList;
+        typedef std::map<MWWorld::ConstPtr,VirtualSoundList> VirtualSoundMap;
+        VirtualSoundMap mVirtualSounds;
+
+        // Sound IDs of the sound generators of each creature ID, in lower case
+        typedef std::map<std::string,std::vector<std::string> > CreatureSoundMap;
+        CreatureSoundMap mCreatureSounds;
+        bool mCreatureSoundsListed;
+
+        typedef std::map<MWWorld::ConstPtr,MWBase::SoundStreamPtr> SaySoundMap;
         SaySoundMap mActiveSaySounds;
 
-        typedef std::pair<DecoderPtr,Sound_Loudness*> DecoderLoudnessPair;
-        typedef std::map<MWWorld::ConstPtr,DecoderLoudnessPair> SayDecoderMap;
-        SayDecoderMap mPendingSaySounds;
-
         typedef std::vector<MWBase::SoundStreamPtr> TrackList;
         TrackList mActiveTracks;
 
@@ -110,13 +154,46 @@ namespace MWSound
         Sound_Buffer *insertSound(const std::string &soundId, const ESM::Sound *sound);
 
         Sound_Buffer *lookupSound(const std::string &soundId) const;
+        Sound_Buffer *getSoundBuffer(const std::string &soundId);
         Sound_Buffer *loadSound(const std::string &soundId);
 
-        // Ensures the loudness/"lip" data gets loaded, and returns a decoder
-        // to start streaming
+        // Like loadSound, but leaves the buffer to be loaded in the background
+        // if that is enabled. The buffer's handle is 0 until then.
+        Sound_Buffer *loadSoundAsync(const std::string &soundId);
+        void startLoading(Sound_Buffer *sfx);
+        void finishLoading();
+
+        // Counts the size of a newly loaded buffer, freeing unused buffers as
+        // needed
+        void addToCache(Sound_Buffer *sfx);
+        // Frees the least recently used buffers until the cache is no bigger
+        // than the size, skipping those of creatures in active cells unless
+        // requested
+        void freeBuffers(size_t size, bool freeCellBuffers);
+        void unloadBuffer(Sound_Buffer *sfx);
+        void useBuffer(Sound_Buffer *sfx);
+        void releaseBuffer(Sound_Buffer *sfx);
+
+        // Plays the sound, or makes it virtual until its buffer is loaded and
+        // a source is free
+        void playBuffer(const MWWorld::ConstPtr &ptr, MWBase::SoundPtr sound, Sound_Buffer *sfx, float offset);
+        void startSound(const MWWorld::ConstPtr &ptr, MWBase::SoundPtr sound, Sound_Buffer *sfx, float offset);
+        // Estimated gain of the sound at the listener, weighted by its type
+        float getAudibility(const Sound &sound) const;
+        void virtualizeSound(const MWWorld::ConstPtr &ptr, MWBase::SoundPtr sound);
+        void startVirtualSound(const MWWorld::ConstPtr &ptr, MWBase::SoundPtr sound);
+        // Advances the virtual sounds, then gives the sources to the most
+        // audible sounds
+        void updateVirtualSounds(float duration);
+        bool isSoundVirtual(MWBase::SoundPtr sound) const;
+        // Stops the virtual sounds of the buffer, or all of them if it is NULL
+        void stopVirtualSounds(const MWWorld::ConstPtr &ptr, Sound_Buffer *sfx);
+
+        // Returns a decoder to start streaming, and the loudness/"lip" data,
+        // which is analyzed while the voice is streamed the first time
         DecoderPtr loadVoice(const std::string &voicefile, Sound_Loudness **lipdata);
 
-        MWBase::SoundStreamPtr playVoice(DecoderPtr decoder, const osg::Vec3f &pos, bool playlocal);
+        MWBase::SoundStreamPtr playVoice(DecoderPtr decoder, Sound_Loudness *lipdata, const osg::Vec3f &pos, bool playlocal);
 
         void streamMusicFull(const std::string& filename);
         void updateSounds(float duration);
@@ -132,7 +209,8 @@ namespace MWSound
         friend class OpenAL_Output;
 
     public:
-        SoundManager(const VFS::Manager* vfs, bool useSound);
+        /// @param loudnessCache Cache of the loudness of voices, may be NULL. Ownership is transferred.
+        SoundManager(const VFS::Manager* vfs, bool useSound, LoudnessCache* loudnessCache = NULL);
         virtual ~SoundManager();
 
         virtual void processChangedSettings(const Settings::CategorySettingVector& settings);
@@ -236,6 +314,13 @@ namespace MWSound
 
         virtual void updatePtr (const MWWorld::ConstPtr& old, const MWWorld::ConstPtr& updated);
 
+        virtual void preloadSounds(MWWorld::CellStore *cell);
+
+        virtual void unloadSounds(const MWWorld::CellStore *cell);
+
+        virtual void reportStats(unsigned int frameNumber, osg::Stats &stats);
+        ///< Start loading the sounds of the sound generators of the creatures in \a cell.
+
         virtual void clear();
     };
 }
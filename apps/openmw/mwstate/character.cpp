@@ -62,7 +62,8 @@ void MWState::Character::addSlot (const ESM::SavedGame& profile)
 
     // Append an index if necessary to ensure a unique file
     int i=0;
-    while (boost::filesystem::exists(slot.mPath))
+    // Also check the slots, their files may not be written yet
+    while (boost::filesystem::exists(slot.mPath) || findSlot (slot.mPath))
     {
            std::ostringstream test;
            test << stream.str();
@@ -159,6 +160,28 @@ const MWState::Slot *MWState::Character::updateSlot (const Slot *slot, const ESM
     return &mSlots.back();
 }
 
+const MWState::Slot *MWState::Character::findSlot (const boost::filesystem::path& path) const
+{
+    for (std::vector<Slot>::const_iterator iter (mSlots.begin()); iter!=mSlots.end(); ++iter)
+        if (iter->mPath==path)
+            return &*iter;
+
+    return 0;
+}
+
+void MWState::Character::setScreenshot (const Slot *slot, const std::vector<char>& screenshot)
+{
+    int index = slot - &mSlots[0];
+
+    if (index<0 || index>=static_cast<int> (mSlots.size()))
+    {
+        // sanity check; not entirely reliable
+        throw std::logic_error ("slot not found");
+    }
+
+    mSlots[index].mProfile.mScreenshot = screenshot;
+}
+
 MWState::Character::SlotIterator MWState::Character::begin() const
 {
     return mSlots.rbegin();
@@ -53,6 +53,12 @@ namespace MWState
             ///
             /// \attention The \a slot pointer will be invalidated by this call.
 
+            const Slot *findSlot (const boost::filesystem::path& path) const;
+            ///< \return 0 if there is no slot for this file.
+
+            void setScreenshot (const Slot *slot, const std::vector<char>& screenshot);
+            /// \note Slot must belong to this character.
+
             SlotIterator begin() const;
             ///<  Any call to createSlot and updateSlot can invalidate the returned iterator.
 
@@ -0,0 +1,215 @@
+#include "savewriter.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <osgDB/Registry>
+
+#include <components/esm/esmwriter.hpp>
+#include <components/esm/defs.hpp>
+
+#include <components/files/lz4.hpp>
+
+MWState::SaveWriter::SaveWriter()
+: mQuit (false), mBusy (false)
+{
+    mThread = boost::thread (boost::bind (&SaveWriter::run, this));
+}
+
+MWState::SaveWriter::~SaveWriter()
+{
+    // Finish the queued saves, nothing may get lost on quit
+    wait();
+
+    {
+        boost::mutex::scoped_lock lock (mMutex);
+        mQuit = true;
+    }
+    mCondition.notify_all();
+    mThread.join();
+}
+
+void MWState::SaveWriter::queue (Job& job)
+{
+    boost::mutex::scoped_lock lock (mMutex);
+
+    mJobs.push_back (Job());
+    Job& queued = mJobs.back();
+    queued.mCharacter = job.mCharacter;
+    queued.mPath = job.mPath;
+    queued.mProfile = job.mProfile;
+    queued.mScreenshot = job.mScreenshot;
+    queued.mRecordCount = job.mRecordCount;
+    queued.mRecords.swap (job.mRecords);
+    queued.mCompress = job.mCompress;
+
+    mCondition.notify_all();
+}
+
+bool MWState::SaveWriter::popResult (Result& result)
+{
+    boost::mutex::scoped_lock lock (mMutex);
+
+    if (mResults.empty())
+        return false;
+
+    result = mResults.front();
+    mResults.pop_front();
+    return true;
+}
+
+void MWState::SaveWriter::wait()
+{
+    boost::mutex::scoped_lock lock (mMutex);
+
+    while (!mJobs.empty() || mBusy)
+        mCondition.wait (lock);
+}
+
+void MWState::SaveWriter::run()
+{
+    while (true)
+    {
+        Job job;
+
+        {
+            boost::mutex::scoped_lock lock (mMutex);
+
+            while (mJobs.empty() && !mQuit)
+                mCondition.wait (lock);
+
+            if (mJobs.empty())
+                return;
+
+            Job& front = mJobs.front();
+            job.mCharacter = front.mCharacter;
+            job.mPath = front.mPath;
+            job.mProfile = front.mProfile;
+            job.mScreenshot = front.mScreenshot;
+            job.mRecordCount = front.mRecordCount;
+            job.mRecords.swap (front.mRecords);
+            job.mCompress = front.mCompress;
+            mJobs.pop_front();
+
+            mBusy = true;
+        }
+
+        Result result;
+        result.mCharacter = job.mCharacter;
+        result.mPath = job.mPath;
+
+        try
+        {
+            if (job.mScreenshot)
+                encodeScreenshot (*job.mScreenshot, result.mScreenshot);
+
+            writeFile (job, result.mScreenshot);
+        }
+        catch (const std::exception& e)
+        {
+            result.mError = e.what();
+        }
+
+        {
+            boost::mutex::scoped_lock lock (mMutex);
+            mResults.push_back (result);
+            mBusy = false;
+        }
+        mCondition.notify_all();
+    }
+}
+
+void MWState::SaveWriter::encodeScreenshot (const osg::Image& image, std::vector<char>& data)
+{
+    osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("jpg");
+    if (!readerwriter)
+    {
+        std::cerr << "Unable to write screenshot, can't find a jpg ReaderWriter" << std::endl;
+        return;
+    }
+
+    std::ostringstream ostream;
+    osgDB::ReaderWriter::WriteResult result = readerwriter->writeImage(image, ostream);
+    if (!result.success())
+    {
+        std::cerr << "Unable to write screenshot: " << result.message() << " code " << result.status() << std::endl;
+        return;
+    }
+
+    std::string encoded = ostream.str();
+    data = std::vector<char>(encoded.begin(), encoded.end());
+}
+
+void MWState::SaveWriter::writeFile (const Job& job, const std::vector<char>& screenshot)
+{
+    ESM::SavedGame profile = job.mProfile;
+    profile.mScreenshot = screenshot;
+
+    // Write to a temporary file first. If there is an error during the save process, we don't want to trash the
+    // existing save file we are overwriting.
+    boost::filesystem::path tempPath = job.mPath;
+    tempPath += ".tmp";
+
+    try
+    {
+        {
+            boost::filesystem::ofstream filestream (tempPath, std::ios::binary);
+            if (!filestream.is_open())
+                throw std::runtime_error("Failed to open " + tempPath.string() + " for writing");
+
+            // A compressed save is assembled in memory, then compressed as a whole
+            std::ostringstream buffer;
+            std::ostream& stream = job.mCompress ? static_cast<std::ostream&> (buffer) : filestream;
+
+            ESM::ESMWriter writer;
+
+            for (std::vector<std::string>::const_iterator iter (profile.mContentFiles.begin());
+                iter!=profile.mContentFiles.end(); ++iter)
+                writer.addMaster (*iter, 0); // not using the size information anyway -> use value of 0
+
+            writer.setFormat (ESM::SavedGame::sCurrentFormat);
+
+            // all unused
+            writer.setVersion(0);
+            writer.setType(0);
+            writer.setAuthor("");
+            writer.setDescription("");
+
+            writer.setRecordCount (job.mRecordCount);
+
+            writer.save (stream);
+
+            writer.startRecord (ESM::REC_SAVE);
+            profile.save (writer);
+            writer.endRecord (ESM::REC_SAVE);
+
+            writer.close();
+
+            stream.write (job.mRecords.data(), job.mRecords.size());
+
+            if (job.mCompress)
+            {
+                const std::string uncompressed = buffer.str();
+                std::vector<char> compressed;
+                Files::compressLz4 (uncompressed.data(), uncompressed.size(), compressed);
+                filestream.write (&compressed[0], compressed.size());
+            }
+
+            if (filestream.fail())
+                throw std::runtime_error("Write operation failed (file stream)");
+        }
+
+        boost::filesystem::rename (tempPath, job.mPath);
+    }
+    catch (...)
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove (tempPath, ec);
+        throw;
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef GAME_STATE_SAVEWRITER_H
+#define GAME_STATE_SAVEWRITER_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/thread.hpp>
+
+#include <osg/ref_ptr>
+#include <osg/Image>
+
+#include <components/esm/savedgame.hpp>
+
+namespace MWState
+{
+    class Character;
+
+    /// \brief Writes saved games to disk on a background thread
+    ///
+    /// The game state is serialized on the main thread. Encoding the screenshot, writing the
+    /// header and copying the records to the file happen on the writer thread. Saves are written
+    /// in the order they were queued.
+    class SaveWriter
+    {
+        public:
+
+            struct Job
+            {
+                Character *mCharacter;
+                boost::filesystem::path mPath;
+
+                /// Profile for the SAVE record, without the screenshot
+                ESM::SavedGame mProfile;
+                osg::ref_ptr<osg::Image> mScreenshot;
+
+                /// Total number of records following the TES3 header
+                int mRecordCount;
+                /// All records following the SAVE record
+                std::string mRecords;
+
+                /// Compress the whole file into an LZ4 frame
+                bool mCompress;
+            };
+
+            struct Result
+            {
+                Character *mCharacter;
+                boost::filesystem::path mPath;
+                std::vector<char> mScreenshot;
+                /// Empty if the save was written successfully
+                std::string mError;
+            };
+
+            SaveWriter();
+            ~SaveWriter();
+
+            void queue (Job& job);
+            ///< Takes over the contents of \a job.
+
+            bool popResult (Result& result);
+            ///< Take out the result of a finished save, if there is one.
+
+            void wait();
+            ///< Block until all queued saves are written.
+
+        private:
+
+            SaveWriter (const SaveWriter&);
+            ///< Not implemented
+
+            SaveWriter& operator= (const SaveWriter&);
+            ///< Not implemented
+
+            void run();
+
+            static void encodeScreenshot (const osg::Image& image, std::vector<char>& data);
+
+            static void writeFile (const Job& job, const std::vector<char>& screenshot);
+
+            boost::mutex mMutex;
+            boost::condition_variable mCondition;
+            boost::thread mThread;
+            bool mQuit;
+            bool mBusy;
+
+            std::deque<Job> mJobs;
+            std::deque<Result> mResults;
+    };
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "statemanagerimp.hpp"
 
+#include <iostream>
+
 #include <components/esm/esmwriter.hpp>
 #include <components/esm/esmreader.hpp>
 #include <components/esm/cellid.hpp>
@@ -13,8 +15,6 @@
 
 #include <osg/Image>
 
-#include <osgDB/Registry>
-
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/operations.hpp>
 
@@ -40,8 +40,13 @@
 
 #include "../mwscript/globalscripts.hpp"
 
+#include "savewriter.hpp"
+
 void MWState::StateManager::cleanup (bool force)
 {
+    // Starting or loading a game changes records, which scripts compiled in the background depend on
+    MWBase::Environment::get().getScriptManager()->waitForPrecompilation();
+
     if (mState!=State_NoGame || force)
     {
         MWBase::Environment::get().getSoundManager()->clear();
@@ -88,10 +93,17 @@ std::map<int, int> MWState::StateManager::buildContentFileIndexMap (const ESM::E
 
 MWState::StateManager::StateManager (const boost::filesystem::path& saves, const std::string& game)
 : mQuitRequest (false), mAskLoadRecent(false), mState (State_NoGame), mCharacterManager (saves, game), mTimePlayed (0)
+, mSaveWriter (new SaveWriter)
 {
 
 }
 
+MWState::StateManager::~StateManager()
+{
+    // Finish writing, before the characters the saves belong to go away
+    mSaveWriter.reset();
+}
+
 void MWState::StateManager::requestQuit()
 {
     mQuitRequest = true;
@@ -200,34 +212,25 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
         profile.mTimePlayed = mTimePlayed;
         profile.mDescription = description;
 
-        writeScreenshot(profile.mScreenshot);
+        // The screenshot is taken now, but encoded by the save writer
+        int screenshotW = 259*2, screenshotH = 133*2; // *2 to get some nice antialiasing
+        osg::ref_ptr<osg::Image> screenshot (new osg::Image);
+        world.screenshot(screenshot.get(), screenshotW, screenshotH);
 
+        Character* character = getCurrentCharacter();
         if (!slot)
-            slot = getCurrentCharacter()->createSlot (profile);
+            slot = character->createSlot (profile);
         else
-            slot = getCurrentCharacter()->updateSlot (slot, profile);
+            slot = character->updateSlot (slot, profile);
 
-        // Write to a memory stream first. If there is an exception during the save process, we don't want to trash the
-        // existing save file we are overwriting.
+        // Serialize the game state into memory. Only the writer's header is written to the file by the save writer,
+        // so the records following it are taken out of the stream.
         std::stringstream stream;
 
         ESM::ESMWriter writer;
 
-        const std::vector<std::string>& current =
-            MWBase::Environment::get().getWorld()->getContentFiles();
-
-        for (std::vector<std::string>::const_iterator iter (current.begin()); iter!=current.end();
-            ++iter)
-            writer.addMaster (*iter, 0); // not using the size information anyway -> use value of 0
-
         writer.setFormat (ESM::SavedGame::sCurrentFormat);
 
-        // all unused
-        writer.setVersion(0);
-        writer.setType(0);
-        writer.setAuthor("");
-        writer.setDescription("");
-
         int recordCount =         1 // saved game header
                 +MWBase::Environment::get().getJournal()->countSavedGameRecords()
                 +MWBase::Environment::get().getWorld()->countSavedGameRecords()
@@ -235,9 +238,9 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
                 +MWBase::Environment::get().getDialogueManager()->countSavedGameRecords()
                 +MWBase::Environment::get().getWindowManager()->countSavedGameRecords()
                 +MWBase::Environment::get().getMechanicsManager()->countSavedGameRecords();
-        writer.setRecordCount (recordCount);
 
         writer.save (stream);
+        const std::streampos recordsStart = stream.tellp();
 
         Loading::Listener& listener = *MWBase::Environment::get().getWindowManager()->getLoadingScreen();
         // Using only Cells for progress information, since they typically have the largest records by far
@@ -246,10 +249,6 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
 
         Loading::ScopedLoad load(&listener);
 
-        writer.startRecord (ESM::REC_SAVE);
-        slot->mProfile.save (writer);
-        writer.endRecord (ESM::REC_SAVE);
-
         MWBase::Environment::get().getJournal()->write (writer, listener);
         MWBase::Environment::get().getDialogueManager()->write (writer, listener);
         MWBase::Environment::get().getWorld()->write (writer, listener);
@@ -258,23 +257,24 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
         MWBase::Environment::get().getMechanicsManager()->write(writer, listener);
 
         // Ensure we have written the number of records that was estimated
-        if (writer.getRecordCount() != recordCount+1) // 1 extra for TES3 record
-            std::cerr << "Warning: number of written savegame records does not match. Estimated: " << recordCount+1 << ", written: " << writer.getRecordCount() << std::endl;
+        if (writer.getRecordCount() != recordCount) // 1 extra for TES3 record, SAVE record is written later
+            std::cerr << "Warning: number of written savegame records does not match. Estimated: " << recordCount+1 << ", written: " << writer.getRecordCount()+1 << std::endl;
 
         writer.close();
 
         if (stream.fail())
             throw std::runtime_error("Write operation failed (memory stream)");
 
-        // All good, write to file
-        boost::filesystem::ofstream filestream (slot->mPath, std::ios::binary);
-        filestream << stream.rdbuf();
+        SaveWriter::Job job;
+        job.mCharacter = character;
+        job.mPath = slot->mPath;
+        job.mProfile = profile;
+        job.mScreenshot = screenshot;
+        job.mRecordCount = recordCount;
+        job.mRecords = stream.str().substr(static_cast<size_t>(recordsStart));
+        job.mCompress = Settings::Manager::getBool ("compress", "Saves");
 
-        if (filestream.fail())
-            throw std::runtime_error("Write operation failed (file stream)");
-
-        Settings::Manager::setString ("character", "Saves",
-            slot->mPath.parent_path().filename().string());
+        mSaveWriter->queue(job);
     }
     catch (const std::exception& e)
     {
@@ -293,6 +293,49 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
     }
 }
 
+void MWState::StateManager::finishSaves (bool wait)
+{
+    if (wait)
+        mSaveWriter->wait();
+
+    SaveWriter::Result result;
+    while (mSaveWriter->popResult(result))
+    {
+        // The character may have been deleted in the meantime
+        bool found = false;
+        for (std::list<Character>::const_iterator it = mCharacterManager.begin(); it != mCharacterManager.end(); ++it)
+            if (&*it == result.mCharacter)
+                found = true;
+        if (!found)
+            continue;
+
+        const Slot* slot = result.mCharacter->findSlot(result.mPath);
+
+        if (result.mError.empty())
+        {
+            if (slot)
+                result.mCharacter->setScreenshot(slot, result.mScreenshot);
+
+            Settings::Manager::setString ("character", "Saves",
+                result.mPath.parent_path().filename().string());
+            continue;
+        }
+
+        std::stringstream error;
+        error << "Failed to save game: " << result.mError;
+
+        std::cerr << error.str() << std::endl;
+
+        std::vector<std::string> buttons;
+        buttons.push_back("#{sOk}");
+        MWBase::Environment::get().getWindowManager()->interactiveMessageBox(error.str(), buttons);
+
+        // If no file was written, clean up the slot
+        if (slot && !boost::filesystem::exists(slot->mPath))
+            result.mCharacter->deleteSlot(slot);
+    }
+}
+
 void MWState::StateManager::quickSave (std::string name)
 {
     if (!(mState==State_Running &&
@@ -350,12 +393,16 @@ void MWState::StateManager::loadGame(const std::string& filepath)
 
 void MWState::StateManager::loadGame (const Character *character, const std::string& filepath)
 {
+    // The file may still be waiting to be written
+    finishSaves(true);
+
     try
     {
         cleanup();
 
+        // Read from memory, so that the world can read the references of cells later
         ESM::ESMReader reader;
-        reader.open (filepath);
+        reader.openInMemory (filepath);
 
         if (reader.getFormat() > ESM::SavedGame::sCurrentFormat)
             throw std::runtime_error("This save file was created using a newer version of OpenMW and is thus not supported. Please upgrade to the newest OpenMW version to load this file.");
@@ -524,6 +571,9 @@ void MWState::StateManager::quickLoad()
 
 void MWState::StateManager::deleteGame(const MWState::Character *character, const MWState::Slot *slot)
 {
+    // Only wait, handling the results could invalidate the slot
+    mSaveWriter->wait();
+
     mCharacterManager.deleteSlot(character, slot);
 }
 
@@ -549,6 +599,8 @@ void MWState::StateManager::update (float duration)
 {
     mTimePlayed += duration;
 
+    finishSaves(false);
+
     // Note: It would be nicer to trigger this from InputManager, i.e. the very beginning of the frame update.
     if (mAskLoadRecent)
     {
@@ -596,31 +648,3 @@ bool MWState::StateManager::verifyProfile(const ESM::SavedGame& profile) const
     }
     return true;
 }
-
-void MWState::StateManager::writeScreenshot(std::vector<char> &imageData) const
-{
-    int screenshotW = 259*2, screenshotH = 133*2; // *2 to get some nice antialiasing
-
-    osg::ref_ptr<osg::Image> screenshot (new osg::Image);
-
-    MWBase::Environment::get().getWorld()->screenshot(screenshot.get(), screenshotW, screenshotH);
-
-    osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("jpg");
-    if (!readerwriter)
-    {
-        std::cerr << "Unable to write screenshot, can't find a jpg ReaderWriter" << std::endl;
-        return;
-    }
-
-    std::ostringstream ostream;
-    osgDB::ReaderWriter::WriteResult result = readerwriter->writeImage(*screenshot, ostream);
-    if (!result.success())
-    {
-        std::cerr << "Unable to write screenshot: " << result.message() << " code " << result.status() << std::endl;
-        return;
-    }
-
-    std::string data = ostream.str();
-    imageData = std::vector<char>(data.begin(), data.end());
-
-}
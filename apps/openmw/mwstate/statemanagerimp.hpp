@@ -2,6 +2,7 @@
 #define GAME_STATE_STATEMANAGER_H
 
 #include <map>
+#include <memory>
 
 #include "../mwbase/statemanager.hpp"
 
@@ -11,6 +12,8 @@
 
 namespace MWState
 {
+    class SaveWriter;
+
     class StateManager : public MWBase::StateManager
     {
             bool mQuitRequest;
@@ -18,6 +21,7 @@ namespace MWState
             State mState;
             CharacterManager mCharacterManager;
             double mTimePlayed;
+            std::auto_ptr<SaveWriter> mSaveWriter;
 
         private:
 
@@ -25,7 +29,9 @@ namespace MWState
 
             bool verifyProfile (const ESM::SavedGame& profile) const;
 
-            void writeScreenshot (std::vector<char>& imageData) const;
+            void finishSaves (bool wait);
+            ///< Handle the results of saves written in the background.
+            /// \param wait Wait for all queued saves to be written first.
 
             std::map<int, int> buildContentFileIndexMap (const ESM::ESMReader& reader) const;
 
@@ -33,6 +39,8 @@ namespace MWState
 
             StateManager (const boost::filesystem::path& saves, const std::string& game);
 
+            virtual ~StateManager();
+
             virtual void requestQuit();
 
             virtual bool hasQuitRequest() const;
@@ -0,0 +1,171 @@
+#ifndef GAME_MWWORLD_BLOCKLIST_H
+#define GAME_MWWORLD_BLOCKLIST_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <vector>
+
+namespace MWWorld
+{
+    /// @brief Sequence that keeps its elements in blocks of contiguous memory, for use in place of a std::list.
+    ///
+    /// Elements can only be added to the end. Like with a std::list, elements keep their address and iterators stay
+    /// valid while elements are added, but visiting the elements in turn does not have to follow a pointer for each.
+    /// The first blocks are small, so that short sequences do not waste memory.
+    /// @note Iterators refer to an element by its position, so an end iterator refers to the first element added
+    /// after it was made.
+    template <typename T>
+    class BlockList
+    {
+            std::vector<T*> mBlocks;
+            size_t mSize;
+
+            // The blocks hold 8, 16, 32 and then 64 elements each
+            enum { FirstBlockSize = 8, LastBlockSize = 64, LastBlockStart = 56, GrowingBlocks = 3 };
+
+            static size_t getBlockSize (size_t block)
+            {
+                return block<GrowingBlocks ? FirstBlockSize<<block : LastBlockSize;
+            }
+
+            T* getElement (size_t index) const
+            {
+                if (index>=LastBlockStart)
+                {
+                    index -= LastBlockStart;
+                    return mBlocks[GrowingBlocks + index/LastBlockSize] + index%LastBlockSize;
+                }
+
+                size_t block = 0;
+                while (index>=getBlockSize (block))
+                    index -= getBlockSize (block++);
+                return mBlocks[block] + index;
+            }
+
+            template <typename Value, typename List>
+            class Iterator : public std::iterator<std::bidirectional_iterator_tag, Value>
+            {
+                    List* mList;
+                    size_t mIndex;
+
+                public:
+
+                    Iterator() : mList (0), mIndex (0) {}
+
+                    Iterator (List* list, size_t index) : mList (list), mIndex (index) {}
+
+                    // to a const_iterator
+                    operator Iterator<const Value, List>() const { return Iterator<const Value, List> (mList, mIndex); }
+
+                    Value& operator*() const { return *mList->getElement (mIndex); }
+
+                    Value* operator->() const { return mList->getElement (mIndex); }
+
+                    Iterator& operator++() { ++mIndex; return *this; }
+
+                    Iterator operator++ (int) { Iterator iter = *this; ++mIndex; return iter; }
+
+                    Iterator& operator--() { --mIndex; return *this; }
+
+                    Iterator operator-- (int) { Iterator iter = *this; --mIndex; return iter; }
+
+                    bool operator== (const Iterator& other) const { return mIndex==other.mIndex && mList==other.mList; }
+
+                    bool operator!= (const Iterator& other) const { return !(*this==other); }
+            };
+
+        public:
+
+            typedef T value_type;
+            typedef Iterator<T, const BlockList> iterator;
+            typedef Iterator<const T, const BlockList> const_iterator;
+
+            BlockList() : mSize (0) {}
+
+            BlockList (const BlockList& list) : mSize (0)
+            {
+                for (const_iterator iter = list.begin(); iter!=list.end(); ++iter)
+                    push_back (*iter);
+            }
+
+            BlockList& operator= (const BlockList& list)
+            {
+                if (&list!=this)
+                {
+                    BlockList copy (list);
+                    swap (copy);
+                }
+                return *this;
+            }
+
+            ~BlockList()
+            {
+                clear();
+            }
+
+            void swap (BlockList& list)
+            {
+                mBlocks.swap (list.mBlocks);
+                std::swap (mSize, list.mSize);
+            }
+
+            void clear()
+            {
+                for (size_t i=0; i<mSize; ++i)
+                    getElement (i)->~T();
+                for (size_t i=0; i<mBlocks.size(); ++i)
+                    ::operator delete (mBlocks[i]);
+                mBlocks.clear();
+                mSize = 0;
+            }
+
+            void push_back (const T& value)
+            {
+                size_t capacity = 0;
+                for (size_t i=0; i<mBlocks.size(); ++i)
+                    capacity += getBlockSize (i);
+
+                if (mSize==capacity)
+                    mBlocks.push_back (static_cast<T*> (::operator new (getBlockSize (mBlocks.size()) * sizeof (T))));
+
+                try
+                {
+                    new (getElement (mSize)) T (value);
+                }
+                catch (...)
+                {
+                    if (mSize==capacity)
+                    {
+                        ::operator delete (mBlocks.back());
+                        mBlocks.pop_back();
+                    }
+                    throw;
+                }
+                ++mSize;
+            }
+
+            size_t size() const { return mSize; }
+
+            bool empty() const { return mSize==0; }
+
+            iterator begin() { return iterator (this, 0); }
+
+            iterator end() { return iterator (this, mSize); }
+
+            const_iterator begin() const { return const_iterator (this, 0); }
+
+            const_iterator end() const { return const_iterator (this, mSize); }
+
+            T& front() { return *getElement (0); }
+
+            const T& front() const { return *getElement (0); }
+
+            T& back() { return *getElement (mSize-1); }
+
+            const T& back() const { return *getElement (mSize-1); }
+    };
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include "cellloadstats.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/niffilemanager.hpp>
+#include <components/resource/texturemanager.hpp>
+
+namespace
+{
+    MWWorld::CellLoadStats* sCurrent = NULL;
+    MWWorld::CellLoadStats::ScopedPhase* sInnermost = NULL;
+
+    const char* const sPhaseNames[MWWorld::CellLoadStats::Phase_Count] =
+    {
+        "refs", "pathgrid", "rendering", "terrain", "physics", "mechanics"
+    };
+}
+
+namespace MWWorld
+{
+    CellLoadStats::CellLoadStats (const std::string& description, Resource::ResourceSystem* resourceSystem, double threshold)
+    : mDescription (description)
+    , mResourceSystem (resourceSystem)
+    , mThreshold (threshold)
+    , mActive (sCurrent == NULL)
+    , mThread (boost::this_thread::get_id())
+    , mStart (osg::Timer::instance()->tick())
+    , mNifLoads (resourceSystem->getNifFileManager()->getSynchronousLoads())
+    , mTextureLoads (resourceSystem->getTextureManager()->getSynchronousLoads())
+    {
+        for (int i=0; i<Phase_Count; ++i)
+            mTimes[i] = 0;
+
+        if (mActive)
+            sCurrent = this;
+    }
+
+    CellLoadStats::~CellLoadStats()
+    {
+        if (!mActive)
+            return;
+        sCurrent = NULL;
+
+        double total = osg::Timer::instance()->delta_s (mStart, osg::Timer::instance()->tick());
+        if (total < mThreshold)
+            return;
+
+        double other = total;
+        std::ostringstream stream;
+        stream << std::fixed << std::setprecision (1);
+        stream << mDescription << " took " << total * 1000 << " ms:";
+        for (int i=0; i<Phase_Count; ++i)
+        {
+            stream << " " << sPhaseNames[i] << " " << mTimes[i] * 1000 << ",";
+            other -= mTimes[i];
+        }
+        stream << " other " << other * 1000 << " ms; "
+               << mResourceSystem->getNifFileManager()->getSynchronousLoads() - mNifLoads << " NIF files and "
+               << mResourceSystem->getTextureManager()->getSynchronousLoads() - mTextureLoads << " textures loaded";
+
+        std::cout << stream.str() << std::endl;
+    }
+
+    CellLoadStats::ScopedPhase::ScopedPhase (Phase phase)
+    : mStats (NULL), mPhase (phase), mOuter (NULL), mStart (0), mInnerTime (0)
+    {
+        if (sCurrent && boost::this_thread::get_id() == sCurrent->mThread)
+        {
+            mStats = sCurrent;
+            mOuter = sInnermost;
+            sInnermost = this;
+            mStart = osg::Timer::instance()->tick();
+        }
+    }
+
+    CellLoadStats::ScopedPhase::~ScopedPhase()
+    {
+        if (!mStats)
+            return;
+
+        double elapsed = osg::Timer::instance()->delta_s (mStart, osg::Timer::instance()->tick());
+        mStats->mTimes[mPhase] += elapsed - mInnerTime;
+        if (mOuter)
+            mOuter->mInnerTime += elapsed;
+        sInnermost = mOuter;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef GAME_MWWORLD_CELLLOADSTATS_H
+#define GAME_MWWORLD_CELLLOADSTATS_H
+
+#include <string>
+
+#include <boost/thread/thread.hpp>
+
+#include <osg/Timer>
+
+namespace Resource
+{
+    class ResourceSystem;
+}
+
+namespace MWWorld
+{
+    /// \brief Times the phases of a cell change, to find out why loading the cells took long.
+    ///
+    /// Only one cell change is timed at a time, on the thread that started timing it. The phases are
+    /// marked with ScopedPhase wherever they happen, and only count while a cell change is timed. A phase
+    /// within another one is not counted towards the outer phase.
+    class CellLoadStats
+    {
+        public:
+
+            enum Phase
+            {
+                Phase_Refs,
+                Phase_Pathgrid,
+                Phase_Rendering,
+                Phase_Terrain,
+                Phase_Physics,
+                Phase_Mechanics,
+                Phase_Count
+            };
+
+            /// Start timing a cell change, until destroyed.
+            /// @param description What is loaded, for the log.
+            /// @param threshold Log the times if the cell change took longer than this, in seconds.
+            CellLoadStats (const std::string& description, Resource::ResourceSystem* resourceSystem, double threshold);
+
+            ~CellLoadStats();
+
+            class ScopedPhase
+            {
+                public:
+                    ScopedPhase (Phase phase);
+                    ~ScopedPhase();
+
+                private:
+                    // NULL unless a cell change is timed on this thread
+                    CellLoadStats* mStats;
+                    Phase mPhase;
+                    ScopedPhase* mOuter;
+                    osg::Timer_t mStart;
+                    double mInnerTime;
+            };
+
+        private:
+
+            friend class ScopedPhase;
+
+            std::string mDescription;
+            Resource::ResourceSystem* mResourceSystem;
+            double mThreshold;
+            // Unless another cell change was already timed, which this one is part of
+            bool mActive;
+            boost::thread::id mThread;
+            osg::Timer_t mStart;
+            unsigned int mNifLoads;
+            unsigned int mTextureLoads;
+            double mTimes[Phase_Count];
+
+            CellLoadStats (const CellLoadStats&);
+            CellLoadStats& operator= (const CellLoadStats&);
+    };
+}
+
+#endif
@@ -0,0 +1,210 @@
+#include "cellpreloader.hpp"
+
+#include <set>
+#include <string>
+
+#include <components/misc/resourcehelpers.hpp>
+#include <components/misc/profiler.hpp>
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/resource/bulletshapemanager.hpp>
+#include <components/resource/bulletshape.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/terrain/world.hpp>
+#include <components/vfs/manager.hpp>
+
+#include "cellstore.hpp"
+#include "class.hpp"
+
+namespace
+{
+
+    struct ListModelsVisitor
+    {
+        const VFS::Manager* mVFS;
+        std::set<std::string> mModels;
+
+        ListModelsVisitor(const VFS::Manager* vfs)
+            : mVFS(vfs)
+        {
+        }
+
+        bool operator() (const MWWorld::Ptr& ptr)
+        {
+            // Only what Scene::insertCell adds to the scene
+            if (ptr.getRefData().isDeleted() || !ptr.getRefData().isEnabled())
+                return true;
+
+            std::string model = ptr.getClass().getModel(ptr);
+            if (!model.empty())
+                mModels.insert(Misc::ResourceHelpers::correctActorModelPath(model, mVFS));
+            return true;
+        }
+    };
+
+}
+
+namespace MWWorld
+{
+
+    /// @brief The resources loaded by a PreloadItem, kept referenced so they stay in the resource caches.
+    class PreloadedObjects : public osg::Referenced
+    {
+    public:
+        std::vector<osg::ref_ptr<const osg::Referenced> > mObjects;
+    };
+
+    /// @brief Loads the models and collision shapes of a cell in the background.
+    class PreloadItem : public SceneUtil::WorkItem
+    {
+    public:
+        PreloadItem(const std::set<std::string>& models, Resource::SceneManager* sceneManager,
+                    Resource::BulletShapeManager* bulletShapeManager, PreloadedObjects* result)
+            : mModels(models)
+            , mSceneManager(sceneManager)
+            , mBulletShapeManager(bulletShapeManager)
+            , mResult(result)
+        {
+        }
+
+        virtual void doWork()
+        {
+            OPENMW_PROFILE_ZONE ("CellPreloader::preload");
+
+            for (std::set<std::string>::const_iterator it = mModels.begin(); it != mModels.end(); ++it)
+            {
+                try
+                {
+                    osg::ref_ptr<const osg::Node> scene = mSceneManager->getTemplate(*it);
+                    mResult->mObjects.push_back(scene.get());
+
+                    osg::ref_ptr<Resource::BulletShape> shape = mBulletShapeManager->getShape(*it);
+                    if (shape)
+                        mResult->mObjects.push_back(shape.get());
+                }
+                catch (std::exception&)
+                {
+                    // Reported again when the cell is loaded
+                }
+            }
+            mTicket->signalDone();
+        }
+
+    private:
+        std::set<std::string> mModels;
+        Resource::SceneManager* mSceneManager;
+        Resource::BulletShapeManager* mBulletShapeManager;
+        osg::ref_ptr<PreloadedObjects> mResult;
+    };
+
+    CellPreloader::CellPreloader(Resource::ResourceSystem *resourceSystem, Resource::BulletShapeManager *bulletShapeManager, Terrain::World *terrain)
+        : mResourceSystem(resourceSystem)
+        , mBulletShapeManager(bulletShapeManager)
+        , mTerrain(terrain)
+        , mWorkQueue(NULL)
+        , mTime(0.0)
+        , mExpiryDelay(0.f)
+    {
+    }
+
+    CellPreloader::~CellPreloader()
+    {
+        clear();
+
+        for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mCancelled.begin(); it != mCancelled.end(); ++it)
+            (*it)->waitTillDone();
+    }
+
+    void CellPreloader::preload(CellStore *cell)
+    {
+        if (!mWorkQueue)
+            return;
+
+        PreloadMap::iterator found = mPreloadCells.find(cell);
+        if (found != mPreloadCells.end())
+        {
+            found->second.mTimeStamp = mTime;
+            return;
+        }
+
+        if (cell->getState() != CellStore::State_Loaded)
+            cell->load();
+
+        ListModelsVisitor visitor (mResourceSystem->getVFS());
+        cell->forEach(visitor);
+
+        // Read the files of the models on the prefetch thread in the meantime, so the work item only has to parse them
+        mResourceSystem->getVFS()->prefetch(std::vector<std::string>(visitor.mModels.begin(), visitor.mModels.end()));
+
+        PreloadEntry entry;
+        entry.mTimeStamp = mTime;
+        entry.mObjects = new PreloadedObjects;
+        entry.mObjects->setThreadSafeRefUnref(true);
+        // After everything that is needed right away
+        entry.mTicket = mWorkQueue->addWorkItem(new PreloadItem(visitor.mModels, mResourceSystem->getSceneManager(),
+                                                                mBulletShapeManager, entry.mObjects), -1);
+        mPreloadCells[cell] = entry;
+
+        if (cell->isExterior())
+            mTerrain->preloadCell(cell->getCell()->getGridX(), cell->getCell()->getGridY());
+    }
+
+    bool CellPreloader::isPreloading(const CellStore *cell) const
+    {
+        PreloadMap::const_iterator found = mPreloadCells.find(cell);
+        return found != mPreloadCells.end() && !found->second.mTicket->isDone();
+    }
+
+    void CellPreloader::update(float duration)
+    {
+        mTime += duration;
+
+        for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();)
+        {
+            if (it->second.mTimeStamp < mTime - mExpiryDelay)
+                erase(it++);
+            else
+                ++it;
+        }
+
+        for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mCancelled.begin(); it != mCancelled.end();)
+        {
+            if ((*it)->isDone())
+                it = mCancelled.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void CellPreloader::setExpiryDelay(float expiryDelay)
+    {
+        mExpiryDelay = expiryDelay;
+    }
+
+    void CellPreloader::setWorkQueue(SceneUtil::WorkQueue *workQueue)
+    {
+        mWorkQueue = workQueue;
+    }
+
+    void CellPreloader::clear()
+    {
+        while (!mPreloadCells.empty())
+            erase(mPreloadCells.begin());
+    }
+
+    void CellPreloader::erase(PreloadMap::iterator it)
+    {
+        if (!it->second.mTicket->isDone())
+        {
+            it->second.mTicket->cancel();
+            mCancelled.push_back(it->second.mTicket);
+        }
+
+        const CellStore* cell = it->first;
+        if (cell->isExterior())
+            mTerrain->clearPreloadedCell(cell->getCell()->getGridX(), cell->getCell()->getGridY());
+
+        mPreloadCells.erase(it);
+    }
+
+}
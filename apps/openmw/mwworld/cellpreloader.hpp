@@ -0,0 +1,92 @@
+#ifndef GAME_MWWORLD_CELLPRELOADER_H
+#define GAME_MWWORLD_CELLPRELOADER_H
+
+#include <map>
+#include <vector>
+
+#include <osg/ref_ptr>
+#include <osg/Referenced>
+
+namespace Resource
+{
+    class ResourceSystem;
+    class BulletShapeManager;
+}
+
+namespace Terrain
+{
+    class World;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+    class WorkTicket;
+}
+
+namespace MWWorld
+{
+    class CellStore;
+    class PreloadedObjects;
+
+    /// @brief Loads the models, textures, collision shapes and terrain of cells on the work queue, before
+    /// the cells are needed, so that inserting the cells only has to create instances from the resource caches.
+    /// @par The preloaded resources stay referenced until the cell was not requested for the expiry delay,
+    /// so they are not dropped from the resource caches in the meantime.
+    class CellPreloader
+    {
+    public:
+        CellPreloader(Resource::ResourceSystem* resourceSystem, Resource::BulletShapeManager* bulletShapeManager, Terrain::World* terrain);
+        ~CellPreloader();
+
+        /// Start preloading the given cell, unless it is preloaded already. Without a work queue, nothing is preloaded.
+        /// @note Loads the references of the cell, if they are not loaded yet.
+        void preload(CellStore* cell);
+
+        /// Is the given cell requested, but not preloaded yet?
+        bool isPreloading(const CellStore* cell) const;
+
+        /// Advance the clock used for expiring, and drop the preloaded cells that were not requested for the expiry delay.
+        /// @note Call once per frame.
+        void update(float duration);
+
+        /// How long to keep preloaded cells once they are no longer requested, in seconds.
+        void setExpiryDelay(float expiryDelay);
+
+        void setWorkQueue(SceneUtil::WorkQueue* workQueue);
+
+        /// Drop all preloaded cells.
+        /// @note Must be called before the preloaded CellStores are destroyed.
+        void clear();
+
+    private:
+        Resource::ResourceSystem* mResourceSystem;
+        Resource::BulletShapeManager* mBulletShapeManager;
+        Terrain::World* mTerrain;
+        SceneUtil::WorkQueue* mWorkQueue;
+
+        double mTime;
+        float mExpiryDelay;
+
+        struct PreloadEntry
+        {
+            // Last time the cell was requested
+            double mTimeStamp;
+            osg::ref_ptr<PreloadedObjects> mObjects;
+            osg::ref_ptr<SceneUtil::WorkTicket> mTicket;
+        };
+        typedef std::map<const CellStore*, PreloadEntry> PreloadMap;
+        PreloadMap mPreloadCells;
+
+        // Preloads that were dropped before they were done. They still use the resource managers, so the destructor waits for them.
+        std::vector<osg::ref_ptr<SceneUtil::WorkTicket> > mCancelled;
+
+        void erase(PreloadMap::iterator it);
+
+        CellPreloader(const CellPreloader&);
+        void operator = (const CellPreloader&);
+    };
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define OPENMW_MWWORLD_CELLREF_H
 
 #include <components/esm/cellref.hpp>
+#include <components/esm/refid.hpp>
 
 namespace ESM
 {
@@ -18,6 +19,7 @@ namespace MWWorld
 
         CellRef (const ESM::CellRef& ref)
             : mCellRef(ref)
+            , mRefId(ref.mRefID)
         {
             mChanged = false;
         }
@@ -34,6 +36,9 @@ namespace MWWorld
         // Id of object being referenced
         std::string getRefId() const;
 
+        // Id of object being referenced, for fast comparisons
+        const ESM::RefId& getInternedRefId() const { return mRefId; }
+
         // For doors - true if this door teleports to somewhere else, false
         // if it should open through animation.
         bool getTeleport() const;
@@ -113,6 +118,7 @@ namespace MWWorld
     private:
         bool mChanged;
         ESM::CellRef mCellRef;
+        ESM::RefId mRefId;
     };
 
 }
@@ -1,6 +1,7 @@
 #include "cells.hpp"
 
 #include <iostream>
+#include <algorithm>
 
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
@@ -16,6 +17,30 @@
 #include "containerstore.hpp"
 #include "cellstore.hpp"
 
+namespace
+{
+    /// How many preloaded cells keep the references they listed, for loading them without reading the content files
+    /// again. The ones listed earlier drop theirs.
+    const size_t sMaxListedCells = 64;
+
+    /// Would searching the listed cells in turn come across \a left before \a right?
+    bool isSearchedFirst (const MWWorld::CellStore& left, const MWWorld::CellStore& right)
+    {
+        const ESM::Cell* leftCell = left.getCell();
+        const ESM::Cell* rightCell = right.getCell();
+
+        if (leftCell->isExterior()!=rightCell->isExterior())
+            return leftCell->isExterior();
+
+        // The exteriors are searched in reverse, see Cells::getPtr
+        if (leftCell->isExterior())
+            return std::make_pair (rightCell->getGridX(), rightCell->getGridY()) <
+                std::make_pair (leftCell->getGridX(), leftCell->getGridY());
+
+        return Misc::StringUtils::ciLess (leftCell->mName, rightCell->mName);
+    }
+}
+
 MWWorld::CellStore *MWWorld::Cells::getCellStore (const ESM::Cell *cell)
 {
     if (cell->mData.mFlags & ESM::Cell::Interior)
@@ -25,7 +50,7 @@ MWWorld::CellStore *MWWorld::Cells::getCellStore (const ESM::Cell *cell)
 
         if (result==mInteriors.end())
         {
-            result = mInteriors.insert (std::make_pair (lowerName, CellStore (cell, mStore, mReader))).first;
+            result = mInteriors.insert (std::make_pair (lowerName, CellStore (cell, mStore, mReader, &mRefIdIndex))).first;
         }
 
         return &result->second;
@@ -38,7 +63,7 @@ MWWorld::CellStore *MWWorld::Cells::getCellStore (const ESM::Cell *cell)
         if (result==mExteriors.end())
         {
             result = mExteriors.insert (std::make_pair (
-                std::make_pair (cell->getGridX(), cell->getGridY()), CellStore (cell, mStore, mReader))).first;
+                std::make_pair (cell->getGridX(), cell->getGridY()), CellStore (cell, mStore, mReader, &mRefIdIndex))).first;
 
         }
 
@@ -50,23 +75,10 @@ void MWWorld::Cells::clear()
 {
     mInteriors.clear();
     mExteriors.clear();
-    std::fill(mIdCache.begin(), mIdCache.end(), std::make_pair("", (MWWorld::CellStore*)0));
-    mIdCacheIndex = 0;
-}
-
-MWWorld::Ptr MWWorld::Cells::getPtrAndCache (const std::string& name, CellStore& cellStore)
-{
-    Ptr ptr = getPtr (name, cellStore);
-
-    if (!ptr.isEmpty() && ptr.isInCell())
-    {
-        mIdCache[mIdCacheIndex].first = name;
-        mIdCache[mIdCacheIndex].second = &cellStore;
-        if (++mIdCacheIndex>=mIdCache.size())
-            mIdCacheIndex = 0;
-    }
-
-    return ptr;
+    mRefIdIndex.clear();
+    mLastUsed.clear();
+    mListedCells.clear();
+    mSavedGame.reset();
 }
 
 void MWWorld::Cells::writeCell (ESM::ESMWriter& writer, CellStore& cell) const
@@ -87,9 +99,7 @@ void MWWorld::Cells::writeCell (ESM::ESMWriter& writer, CellStore& cell) const
 }
 
 MWWorld::Cells::Cells (const MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& reader)
-: mStore (store), mReader (reader),
-  mIdCache (40, std::pair<std::string, CellStore *> ("", (CellStore*)0)), /// \todo make cache size configurable
-  mIdCacheIndex (0)
+: mStore (store), mReader (reader), mUnloadCount (0)
 {}
 
 MWWorld::CellStore *MWWorld::Cells::getExterior (int x, int y)
@@ -116,7 +126,7 @@ MWWorld::CellStore *MWWorld::Cells::getExterior (int x, int y)
         }
 
         result = mExteriors.insert (std::make_pair (
-            std::make_pair (x, y), CellStore (cell, mStore, mReader))).first;
+            std::make_pair (x, y), CellStore (cell, mStore, mReader, &mRefIdIndex))).first;
     }
 
     if (result->second.getState()!=CellStore::State_Loaded)
@@ -136,7 +146,7 @@ MWWorld::CellStore *MWWorld::Cells::getInterior (const std::string& name)
     {
         const ESM::Cell *cell = mStore.get<ESM::Cell>().find(lowerName);
 
-        result = mInteriors.insert (std::make_pair (lowerName, CellStore (cell, mStore, mReader))).first;
+        result = mInteriors.insert (std::make_pair (lowerName, CellStore (cell, mStore, mReader, &mRefIdIndex))).first;
     }
 
     if (result->second.getState()!=CellStore::State_Loaded)
@@ -157,10 +167,29 @@ MWWorld::CellStore *MWWorld::Cells::getCell (const ESM::CellId& id)
 
 MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name, CellStore& cell,
     bool searchInContainers)
+{
+    return getPtr (ESM::RefId (name), cell, searchInContainers);
+}
+
+MWWorld::Ptr MWWorld::Cells::getPtr (const ESM::RefId& name, CellStore& cell,
+    bool searchInContainers)
 {
     if (cell.getState()==CellStore::State_Unloaded)
+    {
         cell.preload ();
 
+        if (cell.getState()==CellStore::State_Preloaded)
+        {
+            mListedCells.push_back (&cell);
+            if (mListedCells.size() > sMaxListedCells)
+            {
+                // A no-op if the cell was loaded meanwhile
+                mListedCells.front()->dropListedRefs();
+                mListedCells.pop_front();
+            }
+        }
+    }
+
     if (cell.getState()==CellStore::State_Preloaded)
     {
         if (cell.hasId (name))
@@ -177,22 +206,32 @@ MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name, CellStore& cell,
         return ptr;
 
     if (searchInContainers)
-        return cell.searchInContainer (name);
+        return cell.searchInContainer (name.getRefIdString());
 
     return Ptr();
 }
 
 MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name)
 {
-    // First check the cache
-    for (std::vector<std::pair<std::string, CellStore *> >::iterator iter (mIdCache.begin());
-        iter!=mIdCache.end(); ++iter)
-        if (iter->first==name && iter->second)
-        {
-            Ptr ptr = getPtr (name, *iter->second);
-            if (!ptr.isEmpty())
-                return ptr;
-        }
+    return getPtr (ESM::RefId (name));
+}
+
+MWWorld::Ptr MWWorld::Cells::getPtr (const ESM::RefId& name)
+{
+    // First check the loaded cells, which are indexed.
+    // If several cells have the reference, pick the one the search of the listed cells below would have come
+    // across first.
+    if (const RefIdIndex::Entries* entries = mRefIdIndex.find (name))
+    {
+        CellStore* found = NULL;
+        for (RefIdIndex::Entries::const_iterator iter (entries->begin()); iter!=entries->end(); ++iter)
+            if (MWWorld::CellStore::isAccessible (iter->mRef->mData, iter->mRef->mRef) &&
+                (!found || isSearchedFirst (*iter->mCell, *found)))
+                found = iter->mCell;
+
+        if (found)
+            return found->search (name);
+    }
 
     // Then check cells that are already listed
     // Search in reverse, this is a workaround for an ambiguous chargen_plank reference in the vanilla game.
@@ -200,7 +239,10 @@ MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name)
     for (std::map<std::pair<int, int>, CellStore>::reverse_iterator iter = mExteriors.rbegin();
         iter!=mExteriors.rend(); ++iter)
     {
-        Ptr ptr = getPtrAndCache (name, iter->second);
+        if (iter->second.getState()==CellStore::State_Loaded)
+            continue;
+
+        Ptr ptr = getPtr (name, iter->second);
         if (!ptr.isEmpty())
             return ptr;
     }
@@ -208,7 +250,10 @@ MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name)
     for (std::map<std::string, CellStore>::iterator iter = mInteriors.begin();
         iter!=mInteriors.end(); ++iter)
     {
-        Ptr ptr = getPtrAndCache (name, iter->second);
+        if (iter->second.getState()==CellStore::State_Loaded)
+            continue;
+
+        Ptr ptr = getPtr (name, iter->second);
         if (!ptr.isEmpty())
             return ptr;
     }
@@ -221,7 +266,10 @@ MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name)
     {
         CellStore *cellStore = getCellStore (&(*iter));
 
-        Ptr ptr = getPtrAndCache (name, *cellStore);
+        if (cellStore->getState()==CellStore::State_Loaded)
+            continue;
+
+        Ptr ptr = getPtr (name, *cellStore);
 
         if (!ptr.isEmpty())
             return ptr;
@@ -231,7 +279,10 @@ MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name)
     {
         CellStore *cellStore = getCellStore (&(*iter));
 
-        Ptr ptr = getPtrAndCache (name, *cellStore);
+        if (cellStore->getState()==CellStore::State_Loaded)
+            continue;
+
+        Ptr ptr = getPtr (name, *cellStore);
 
         if (!ptr.isEmpty())
             return ptr;
@@ -243,12 +294,13 @@ MWWorld::Ptr MWWorld::Cells::getPtr (const std::string& name)
 
 void MWWorld::Cells::getExteriorPtrs(const std::string &name, std::vector<MWWorld::Ptr> &out)
 {
+    const ESM::RefId id (name);
     const MWWorld::Store<ESM::Cell> &cells = mStore.get<ESM::Cell>();
     for (MWWorld::Store<ESM::Cell>::iterator iter = cells.extBegin(); iter != cells.extEnd(); ++iter)
     {
         CellStore *cellStore = getCellStore (&(*iter));
 
-        Ptr ptr = getPtrAndCache (name, *cellStore);
+        Ptr ptr = getPtr (id, *cellStore);
 
         if (!ptr.isEmpty())
             out.push_back(ptr);
@@ -257,30 +309,76 @@ void MWWorld::Cells::getExteriorPtrs(const std::string &name, std::vector<MWWorl
 
 void MWWorld::Cells::getInteriorPtrs(const std::string &name, std::vector<MWWorld::Ptr> &out)
 {
+    const ESM::RefId id (name);
     const MWWorld::Store<ESM::Cell> &cells = mStore.get<ESM::Cell>();
     for (MWWorld::Store<ESM::Cell>::iterator iter = cells.intBegin(); iter != cells.intEnd(); ++iter)
     {
         CellStore *cellStore = getCellStore (&(*iter));
 
-        Ptr ptr = getPtrAndCache (name, *cellStore);
+        Ptr ptr = getPtr (id, *cellStore);
 
         if (!ptr.isEmpty())
             out.push_back(ptr);
     }
 }
 
+void MWWorld::Cells::unloadUnused (const std::set<const CellStore*>& inUse, std::size_t maxUnused)
+{
+    ++mUnloadCount;
+
+    // <last used, cell>
+    std::vector<std::pair<unsigned int, CellStore*> > unused;
+
+    for (std::map<std::pair<int, int>, CellStore>::iterator iter (mExteriors.begin());
+        iter!=mExteriors.end(); ++iter)
+        addUnused (iter->second, inUse, unused);
+
+    for (std::map<std::string, CellStore>::iterator iter (mInteriors.begin());
+        iter!=mInteriors.end(); ++iter)
+        addUnused (iter->second, inUse, unused);
+
+    if (unused.size()<=maxUnused)
+        return;
+
+    // Unload the cells that were not used for the longest time
+    std::vector<std::pair<unsigned int, CellStore*> >::iterator last = unused.end() - maxUnused;
+    std::nth_element (unused.begin(), last, unused.end());
+
+    for (std::vector<std::pair<unsigned int, CellStore*> >::iterator iter (unused.begin()); iter!=last; ++iter)
+    {
+        mLastUsed.erase (iter->second);
+        iter->second->unload();
+    }
+}
+
+void MWWorld::Cells::addUnused (CellStore& cell, const std::set<const CellStore*>& inUse,
+    std::vector<std::pair<unsigned int, CellStore*> >& unused)
+{
+    if (cell.getState()!=CellStore::State_Loaded)
+        return;
+
+    // Cells loaded since the last call count as used now
+    std::map<const CellStore*, unsigned int>::iterator lastUsed =
+        mLastUsed.insert (std::make_pair (&cell, mUnloadCount)).first;
+
+    if (inUse.find (&cell)!=inUse.end())
+        lastUsed->second = mUnloadCount;
+    else if (cell.canUnload())
+        unused.push_back (std::make_pair (lastUsed->second, &cell));
+}
+
 int MWWorld::Cells::countSavedGameRecords() const
 {
     int count = 0;
 
     for (std::map<std::string, CellStore>::const_iterator iter (mInteriors.begin());
         iter!=mInteriors.end(); ++iter)
-        if (iter->second.hasState())
+        if (iter->second.hasChangedState())
             ++count;
 
     for (std::map<std::pair<int, int>, CellStore>::const_iterator iter (mExteriors.begin());
         iter!=mExteriors.end(); ++iter)
-        if (iter->second.hasState())
+        if (iter->second.hasChangedState())
             ++count;
 
     return count;
@@ -290,7 +388,7 @@ void MWWorld::Cells::write (ESM::ESMWriter& writer, Loading::Listener& progress)
 {
     for (std::map<std::pair<int, int>, CellStore>::iterator iter (mExteriors.begin());
         iter!=mExteriors.end(); ++iter)
-        if (iter->second.hasState())
+        if (iter->second.hasChangedState())
         {
             writeCell (writer, iter->second);
             progress.increaseProgress();
@@ -298,7 +396,7 @@ void MWWorld::Cells::write (ESM::ESMWriter& writer, Loading::Listener& progress)
 
     for (std::map<std::string, CellStore>::iterator iter (mInteriors.begin());
         iter!=mInteriors.end(); ++iter)
-        if (iter->second.hasState())
+        if (iter->second.hasChangedState())
         {
             writeCell (writer, iter->second);
             progress.increaseProgress();
@@ -356,6 +454,38 @@ bool MWWorld::Cells::readRecord (ESM::ESMReader& reader, uint32_t type,
         if (state.mHasFogOfWar)
             cellStore->readFog(reader);
 
+        // Leave the references of cells that are not loaded yet in the file until they are needed,
+        // unless some of them were moved to another cell
+        if (cellStore->getState()!=CellStore::State_Loaded && reader.isMapped())
+        {
+            const ESM::ESM_Context references = reader.getContext();
+
+            bool moved = false;
+            while (reader.hasMoreSubs() && !moved)
+            {
+                reader.getSubName();
+                moved = reader.retSubName()=="MVRF";
+                reader.skipHSub();
+            }
+
+            if (!moved)
+            {
+                boost::shared_ptr<CellStore::SavedGame> savedGame = mSavedGame.lock();
+                if (!savedGame)
+                {
+                    savedGame.reset (new CellStore::SavedGame);
+                    savedGame->mReader = reader;
+                    savedGame->mContentFileMap = contentFileMap;
+                    mSavedGame = savedGame;
+                }
+
+                cellStore->deferReferences (savedGame, references);
+                return true;
+            }
+
+            reader.restoreContext (references);
+        }
+
         if (cellStore->getState()!=CellStore::State_Loaded)
             cellStore->load ();
 
@@ -3,9 +3,16 @@
 
 #include <map>
 #include <list>
+#include <deque>
+#include <set>
 #include <string>
 
-#include "ptr.hpp"
+#include <boost/weak_ptr.hpp>
+
+#include <components/esm/refid.hpp>
+
+#include "cellstore.hpp"
+#include "refidindex.hpp"
 
 namespace ESM
 {
@@ -29,20 +36,29 @@ namespace MWWorld
     {
             const MWWorld::ESMStore& mStore;
             std::vector<ESM::ESMReader>& mReader;
+            /// The references of the loaded cells
+            RefIdIndex mRefIdIndex;
             mutable std::map<std::string, CellStore> mInteriors;
             mutable std::map<std::pair<int, int>, CellStore> mExteriors;
-            std::vector<std::pair<std::string, CellStore *> > mIdCache;
-            std::size_t mIdCacheIndex;
+            /// When each loaded cell was last in use, in calls of unloadUnused()
+            std::map<const CellStore*, unsigned int> mLastUsed;
+            unsigned int mUnloadCount;
+            /// The preloaded cells that may still keep their references in memory, oldest first
+            std::deque<CellStore*> mListedCells;
+            /// Shared by the cells whose references are still in the saved game
+            boost::weak_ptr<CellStore::SavedGame> mSavedGame;
 
             Cells (const Cells&);
             Cells& operator= (const Cells&);
 
             CellStore *getCellStore (const ESM::Cell *cell);
 
-            Ptr getPtrAndCache (const std::string& name, CellStore& cellStore);
-
             void writeCell (ESM::ESMWriter& writer, CellStore& cell) const;
 
+            /// Add \a cell to \a unused, with the time it was last used, if it is loaded and could be unloaded.
+            void addUnused (CellStore& cell, const std::set<const CellStore*>& inUse,
+                std::vector<std::pair<unsigned int, CellStore*> >& unused);
+
         public:
 
             void clear();
@@ -56,22 +72,24 @@ namespace MWWorld
             CellStore *getCell (const ESM::CellId& id);
 
             Ptr getPtr (const std::string& name, CellStore& cellStore, bool searchInContainers = false);
+            Ptr getPtr (const ESM::RefId& name, CellStore& cellStore, bool searchInContainers = false);
             ///< \param searchInContainers Only affect loaded cells.
-            /// @note name must be lower case
 
-            /// @note name must be lower case
             Ptr getPtr (const std::string& name);
+            Ptr getPtr (const ESM::RefId& name);
 
             /// Get all Ptrs referencing \a name in exterior cells
             /// @note Due to the current implementation of getPtr this only supports one Ptr per cell.
-            /// @note name must be lower case
             void getExteriorPtrs (const std::string& name, std::vector<MWWorld::Ptr>& out);
 
             /// Get all Ptrs referencing \a name in interior cells
             /// @note Due to the current implementation of getPtr this only supports one Ptr per cell.
-            /// @note name must be lower case
             void getInteriorPtrs (const std::string& name, std::vector<MWWorld::Ptr>& out);
 
+            /// Unload the loaded cells that are not in use, except for the \a maxUnused that were in use most recently.
+            /// @note Cells with references moved to or from other cells are kept, see CellStore::canUnload().
+            void unloadUnused (const std::set<const CellStore*>& inUse, std::size_t maxUnused);
+
             int countSavedGameRecords() const;
 
             void write (ESM::ESMWriter& writer, Loading::Listener& progress) const;
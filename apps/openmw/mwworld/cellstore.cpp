@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <sstream>
 
 #include <components/esm/cellstate.hpp>
 #include <components/esm/cellid.hpp>
@@ -14,6 +15,7 @@
 #include <components/esm/fogstate.hpp>
 #include <components/esm/creaturelevliststate.hpp>
 #include <components/esm/doorstate.hpp>
+#include <components/esm/savedgame.hpp>
 
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
@@ -24,6 +26,8 @@
 #include "esmstore.hpp"
 #include "class.hpp"
 #include "containerstore.hpp"
+#include "refidindex.hpp"
+#include "cellloadstats.hpp"
 
 namespace
 {
@@ -64,6 +68,33 @@ namespace
         return MWWorld::Ptr();
     }
 
+    template<typename T>
+    bool isSavedReference (const MWWorld::LiveCellRef<T>& ref)
+    {
+        if (!ref.mData.hasChanged() && !ref.mRef.hasChanged() && ref.mRef.hasContentFile())
+        {
+            // Reference that came from a content file and has not been changed -> ignore
+            return false;
+        }
+        if (ref.mData.getCount()==0 && !ref.mRef.hasContentFile())
+        {
+            // Deleted reference that did not come from a content file -> ignore
+            return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    bool hasSavedReferences (const MWWorld::CellRefList<T>& collection)
+    {
+        for (typename MWWorld::CellRefList<T>::List::const_iterator
+            iter (collection.mList.begin());
+            iter!=collection.mList.end(); ++iter)
+            if (isSavedReference (*iter))
+                return true;
+        return false;
+    }
+
     template<typename RecordType, typename T>
     void writeReferenceCollection (ESM::ESMWriter& writer,
         const MWWorld::CellRefList<T>& collection)
@@ -75,16 +106,8 @@ namespace
                 iter (collection.mList.begin());
                 iter!=collection.mList.end(); ++iter)
             {
-                if (!iter->mData.hasChanged() && !iter->mRef.hasChanged() && iter->mRef.hasContentFile())
-                {
-                    // Reference that came from a content file and has not been changed -> ignore
+                if (!isSavedReference (*iter))
                     continue;
-                }
-                if (iter->mData.getCount()==0 && !iter->mRef.hasContentFile())
-                {
-                    // Deleted reference that did not come from a content file -> ignore
-                    continue;
-                }
 
                 RecordType state;
                 iter->save (state);
@@ -178,7 +201,7 @@ namespace MWWorld
 
         if (const X *ptr = store.search (ref.mRefID))
         {
-            typename std::list<LiveRef>::iterator iter =
+            typename List::iterator iter =
                 std::find(mList.begin(), mList.end(), ref.mRefNum);
 
             LiveRef liveCellRef (ref, ptr);
@@ -311,14 +334,23 @@ namespace MWWorld
 
     void CellStore::updateMergedRefs()
     {
+        if (mRefIdIndex)
+            for (std::vector<LiveCellRefBase*>::const_iterator it = mMergedRefs.begin(); it != mMergedRefs.end(); ++it)
+                mRefIdIndex->remove(*it, this);
+
         mMergedRefs.clear();
         MergeVisitor visitor(mMergedRefs, mMovedHere, mMovedToAnotherCell);
         forEachInternal(visitor);
         visitor.merge();
+
+        if (mRefIdIndex)
+            for (std::vector<LiveCellRefBase*>::const_iterator it = mMergedRefs.begin(); it != mMergedRefs.end(); ++it)
+                mRefIdIndex->add(*it, this);
     }
 
-    CellStore::CellStore (const ESM::Cell *cell, const MWWorld::ESMStore& esmStore, std::vector<ESM::ESMReader>& readerList)
-        : mStore(esmStore), mReader(readerList), mCell (cell), mState (State_Unloaded), mHasState (false), mLastRespawn(0,0)
+    CellStore::CellStore (const ESM::Cell *cell, const MWWorld::ESMStore& esmStore, std::vector<ESM::ESMReader>& readerList,
+        RefIdIndex* refIdIndex)
+        : mStore(esmStore), mReader(readerList), mRefIdIndex(refIdIndex), mCell (cell), mState (State_Unloaded), mHasState (false), mRefsListed (false), mLastRespawn(0,0)
     {
         mWaterLevel = cell->mWater;
     }
@@ -338,7 +370,37 @@ namespace MWWorld
         return mHasState;
     }
 
+    bool CellStore::hasChangedState() const
+    {
+        if (!mHasState)
+            return false;
+
+        // The references are not known before loading. Keep the state a previous save had.
+        if (mState!=State_Loaded)
+            return true;
+
+        if (mFogState.get() || mWaterLevel!=mCell->mWater || !mMovedToAnotherCell.empty())
+            return true;
+
+        return hasSavedReferences (mActivators) || hasSavedReferences (mPotions) ||
+            hasSavedReferences (mAppas) || hasSavedReferences (mArmors) ||
+            hasSavedReferences (mBooks) || hasSavedReferences (mClothes) ||
+            hasSavedReferences (mContainers) || hasSavedReferences (mCreatures) ||
+            hasSavedReferences (mDoors) || hasSavedReferences (mIngreds) ||
+            hasSavedReferences (mCreatureLists) || hasSavedReferences (mItemLists) ||
+            hasSavedReferences (mLights) || hasSavedReferences (mLockpicks) ||
+            hasSavedReferences (mMiscItems) || hasSavedReferences (mNpcs) ||
+            hasSavedReferences (mProbes) || hasSavedReferences (mRepairs) ||
+            hasSavedReferences (mStatics) || hasSavedReferences (mWeapons) ||
+            hasSavedReferences (mBodyParts);
+    }
+
     bool CellStore::hasId (const std::string& id) const
+    {
+        return hasId (ESM::RefId (id));
+    }
+
+    bool CellStore::hasId (const ESM::RefId& id) const
     {
         if (mState==State_Unloaded)
             return false;
@@ -353,10 +415,10 @@ namespace MWWorld
     struct SearchVisitor
     {
         PtrType mFound;
-        std::string mIdToFind;
+        ESM::RefId mIdToFind;
         bool operator()(const PtrType& ptr)
         {
-            if (ptr.getCellRef().getRefId() == mIdToFind)
+            if (ptr.getCellRef().getInternedRefId() == mIdToFind)
             {
                 mFound = ptr;
                 return false;
@@ -367,6 +429,24 @@ namespace MWWorld
 
     Ptr CellStore::search (const std::string& id)
     {
+        return search (ESM::RefId (id));
+    }
+
+    Ptr CellStore::search (const ESM::RefId& id)
+    {
+        if (mRefIdIndex && mState==State_Loaded)
+        {
+            mHasState = true;
+
+            // The references of this cell are in the order forEach would visit them
+            if (const RefIdIndex::Entries* entries = mRefIdIndex->find (id))
+                for (RefIdIndex::Entries::const_iterator it = entries->begin(); it != entries->end(); ++it)
+                    if (it->mCell==this && isAccessible (it->mRef->mData, it->mRef->mRef))
+                        return Ptr (it->mRef, this);
+
+            return Ptr();
+        }
+
         SearchVisitor<MWWorld::Ptr> searchVisitor;
         searchVisitor.mIdToFind = id;
         forEach(searchVisitor);
@@ -375,6 +455,21 @@ namespace MWWorld
 
     ConstPtr CellStore::searchConst (const std::string& id) const
     {
+        return searchConst (ESM::RefId (id));
+    }
+
+    ConstPtr CellStore::searchConst (const ESM::RefId& id) const
+    {
+        if (mRefIdIndex && mState==State_Loaded)
+        {
+            if (const RefIdIndex::Entries* entries = mRefIdIndex->find (id))
+                for (RefIdIndex::Entries::const_iterator it = entries->begin(); it != entries->end(); ++it)
+                    if (it->mCell==this && isAccessible (it->mRef->mData, it->mRef->mRef))
+                        return ConstPtr (it->mRef, this);
+
+            return ConstPtr();
+        }
+
         SearchVisitor<MWWorld::ConstPtr> searchVisitor;
         searchVisitor.mIdToFind = id;
         forEachConst(searchVisitor);
@@ -423,6 +518,8 @@ namespace MWWorld
     {
         if (mState!=State_Loaded)
         {
+            CellLoadStats::ScopedPhase phase (CellLoadStats::Phase_Refs);
+
             if (mState==State_Preloaded)
                 mIds.clear();
 
@@ -430,8 +527,17 @@ namespace MWWorld
 
             mState = State_Loaded;
 
+            if (mSavedGame.get())
+            {
+                boost::shared_ptr<SavedGame> savedGame;
+                savedGame.swap (mSavedGame);
+                savedGame->mReader.restoreContext (mSavedReferences);
+                readReferences (savedGame->mReader, savedGame->mContentFileMap, NULL);
+            }
+
             // TODO: the pathgrid graph only needs to be loaded for active cells, so move this somewhere else.
             // In a simple test, loading the graph for all cells in MW + expansions took 200 ms
+            CellLoadStats::ScopedPhase pathgridPhase (CellLoadStats::Phase_Pathgrid);
             mPathgridGraph.load(this);
         }
     }
@@ -440,6 +546,13 @@ namespace MWWorld
     {
         if (mState==State_Unloaded)
         {
+            // The list would lack references from a saved game
+            if (mSavedGame.get())
+            {
+                load ();
+                return;
+            }
+
             listRefs ();
 
             mState = State_Preloaded;
@@ -463,14 +576,12 @@ namespace MWWorld
             mCell->restore (esm[index], i);
 
             ESM::CellRef ref;
+            ref.mRefNum.mContentFile = ESM::RefNum::RefNum_NoContentFile;
 
             // Get each reference in turn
             bool deleted = false;
             while (mCell->getNextRef (esm[index], ref, deleted))
             {
-                if (deleted)
-                    continue;
-
                 // Don't list reference if it was moved to a different cell.
                 ESM::MovedCellRefTracker::const_iterator iter =
                     std::find(mCell->mMovedRefs.begin(), mCell->mMovedRefs.end(), ref.mRefNum);
@@ -478,16 +589,22 @@ namespace MWWorld
                     continue;
                 }
 
-                mIds.push_back (Misc::StringUtils::lowerCase (ref.mRefID));
+                // Deleted references are kept too, loadRef needs them to delete the references of earlier content files
+                mListedRefs.push_back (std::make_pair (ref, deleted));
+
+                if (!deleted)
+                    mIds.push_back (ESM::RefId (ref.mRefID));
             }
         }
 
+        mRefsListed = true;
+
         // List moved references, from separately tracked list.
         for (ESM::CellRefTracker::const_iterator it = mCell->mLeasedRefs.begin(); it != mCell->mLeasedRefs.end(); ++it)
         {
             const ESM::CellRef &ref = *it;
 
-            mIds.push_back(Misc::StringUtils::lowerCase(ref.mRefID));
+            mIds.push_back(ESM::RefId(ref.mRefID));
         }
 
         std::sort (mIds.begin(), mIds.end());
@@ -502,28 +619,39 @@ namespace MWWorld
         if (mCell->mContextList.empty())
             return; // this is a dynamically generated cell -> skipping.
 
-        // Load references from all plugins that do something with this cell.
-        for (size_t i = 0; i < mCell->mContextList.size(); i++)
+        // Listed by preload() already
+        if (mRefsListed)
         {
-            // Reopen the ESM reader and seek to the right position.
-            int index = mCell->mContextList.at(i).index;
-            mCell->restore (esm[index], i);
+            for (std::vector<std::pair<ESM::CellRef, bool> >::iterator it = mListedRefs.begin(); it != mListedRefs.end(); ++it)
+                loadRef (it->first, it->second);
 
-            ESM::CellRef ref;
-            ref.mRefNum.mContentFile = ESM::RefNum::RefNum_NoContentFile;
-
-            // Get each reference in turn
-            bool deleted = false;
-            while(mCell->getNextRef(esm[index], ref, deleted))
+            dropListedRefs();
+        }
+        else
+        {
+            // Load references from all plugins that do something with this cell.
+            for (size_t i = 0; i < mCell->mContextList.size(); i++)
             {
-                // Don't load reference if it was moved to a different cell.
-                ESM::MovedCellRefTracker::const_iterator iter =
-                    std::find(mCell->mMovedRefs.begin(), mCell->mMovedRefs.end(), ref.mRefNum);
-                if (iter != mCell->mMovedRefs.end()) {
-                    continue;
-                }
+                // Reopen the ESM reader and seek to the right position.
+                int index = mCell->mContextList.at(i).index;
+                mCell->restore (esm[index], i);
 
-                loadRef (ref, deleted);
+                ESM::CellRef ref;
+                ref.mRefNum.mContentFile = ESM::RefNum::RefNum_NoContentFile;
+
+                // Get each reference in turn
+                bool deleted = false;
+                while(mCell->getNextRef(esm[index], ref, deleted))
+                {
+                    // Don't load reference if it was moved to a different cell.
+                    ESM::MovedCellRefTracker::const_iterator iter =
+                        std::find(mCell->mMovedRefs.begin(), mCell->mMovedRefs.end(), ref.mRefNum);
+                    if (iter != mCell->mMovedRefs.end()) {
+                        continue;
+                    }
+
+                    loadRef (ref, deleted);
+                }
             }
         }
 
@@ -538,6 +666,12 @@ namespace MWWorld
         updateMergedRefs();
     }
 
+    void CellStore::dropListedRefs()
+    {
+        std::vector<std::pair<ESM::CellRef, bool> >().swap (mListedRefs);
+        mRefsListed = false;
+    }
+
     bool CellStore::isExterior() const
     {
         return mCell->isExterior();
@@ -673,6 +807,13 @@ namespace MWWorld
         }
     }
 
+    void CellStore::deferReferences (const boost::shared_ptr<SavedGame>& savedGame, const ESM::ESM_Context& references)
+    {
+        mHasState = true;
+        mSavedGame = savedGame;
+        mSavedReferences = references;
+    }
+
     void CellStore::readReferences (ESM::ESMReader& reader, const std::map<int, int>& contentFileMap, GetCellStoreCallback* callback)
     {
         mHasState = true;
@@ -882,6 +1023,79 @@ namespace MWWorld
         return mFogState.get();
     }
 
+    bool CellStore::canUnload() const
+    {
+        return mState==State_Loaded && mMovedHere.empty() && mMovedToAnotherCell.empty();
+    }
+
+    void CellStore::unload()
+    {
+        if (!canUnload())
+            throw std::runtime_error ("unload: cell is not loaded, or has references moved to or from other cells");
+
+        bool changed = hasChangedState();
+
+        boost::shared_ptr<SavedGame> savedGame;
+        ESM::ESM_Context references;
+        if (changed)
+        {
+            // The references as a saved game has them, in a file of their own
+            std::ostringstream stream;
+            ESM::ESMWriter writer;
+            writer.setFormat (ESM::SavedGame::sCurrentFormat);
+            writer.save (stream);
+            writer.startRecord (ESM::REC_CSTA);
+            writeReferences (writer);
+            writer.endRecord (ESM::REC_CSTA);
+            writer.close();
+
+            const std::string& data = stream.str();
+            savedGame.reset (new SavedGame);
+            savedGame->mReader.openInMemory (boost::shared_ptr<std::vector<char> > (
+                new std::vector<char> (data.begin(), data.end())), "unloaded cell " + mCell->getDescription());
+            savedGame->mReader.getRecName();
+            savedGame->mReader.getRecHeader();
+            references = savedGame->mReader.getContext();
+
+            // The references were written with the indices of the current content files
+            for (int i=0; i<static_cast<int> (mReader.size()); ++i)
+                savedGame->mContentFileMap[i] = i;
+        }
+
+        if (mRefIdIndex)
+            for (std::vector<LiveCellRefBase*>::const_iterator it = mMergedRefs.begin(); it != mMergedRefs.end(); ++it)
+                mRefIdIndex->remove(*it, this);
+        mMergedRefs.clear();
+
+        mActivators.mList.clear();
+        mPotions.mList.clear();
+        mAppas.mList.clear();
+        mArmors.mList.clear();
+        mBooks.mList.clear();
+        mClothes.mList.clear();
+        mContainers.mList.clear();
+        mCreatures.mList.clear();
+        mDoors.mList.clear();
+        mIngreds.mList.clear();
+        mCreatureLists.mList.clear();
+        mItemLists.mList.clear();
+        mLights.mList.clear();
+        mLockpicks.mList.clear();
+        mMiscItems.mList.clear();
+        mNpcs.mList.clear();
+        mProbes.mList.clear();
+        mRepairs.mList.clear();
+        mStatics.mList.clear();
+        mWeapons.mList.clear();
+        mBodyParts.mList.clear();
+
+        mState = State_Unloaded;
+        mHasState = false;
+
+        if (changed)
+            deferReferences (savedGame, references);
+    }
+
     void CellStore::respawn()
     {
         if (mState == State_Loaded)
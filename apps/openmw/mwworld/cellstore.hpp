@@ -32,6 +32,7 @@
 #include <components/esm/loadnpc.hpp>
 #include <components/esm/loadmisc.hpp>
 #include <components/esm/loadbody.hpp>
+#include <components/esm/esmreader.hpp>
 
 #include "../mwmechanics/pathgrid.hpp"  // TODO: maybe belongs in mwworld
 
@@ -48,6 +49,7 @@ namespace ESM
 namespace MWWorld
 {
     class ESMStore;
+    class RefIdIndex;
 
     /// \brief Mutable state of a cell
     class CellStore
@@ -59,10 +61,13 @@ namespace MWWorld
                 State_Unloaded, State_Preloaded, State_Loaded
             };
 
+            struct SavedGame;
+
         private:
 
             const MWWorld::ESMStore& mStore;
             std::vector<ESM::ESMReader>& mReader;
+            RefIdIndex* mRefIdIndex;
 
             // Even though fog actually belongs to the player and not cells,
             // it makes sense to store it here since we need it once for each cell.
@@ -72,7 +77,13 @@ namespace MWWorld
             const ESM::Cell *mCell;
             State mState;
             bool mHasState;
-            std::vector<std::string> mIds;
+            // Set by deferReferences()
+            boost::shared_ptr<SavedGame> mSavedGame;
+            ESM::ESM_Context mSavedReferences;
+            std::vector<ESM::RefId> mIds;
+            // The references read by listRefs(), with their deleted flag, so that loadRefs() does not read them again
+            std::vector<std::pair<ESM::CellRef, bool> > mListedRefs;
+            bool mRefsListed;
             float mWaterLevel;
 
             MWWorld::TimeStamp mLastRespawn;
@@ -114,7 +125,7 @@ namespace MWWorld
             /// Moves object from the given cell to this cell.
             void moveFrom(const MWWorld::Ptr& object, MWWorld::CellStore* from);
 
-            /// Repopulate mMergedRefs.
+            /// Repopulate mMergedRefs, and update the references mRefIdIndex has of this cell.
             void updateMergedRefs();
 
             // helper function for forEachInternal
@@ -196,28 +207,37 @@ namespace MWWorld
             }
 
             /// @param readerList The readers to use for loading of the cell on-demand.
+            /// @param refIdIndex Index to list the references of this cell in while loaded, may be NULL.
             CellStore (const ESM::Cell *cell_,
                        const MWWorld::ESMStore& store,
-                       std::vector<ESM::ESMReader>& readerList);
+                       std::vector<ESM::ESMReader>& readerList,
+                       RefIdIndex* refIdIndex = NULL);
 
             const ESM::Cell *getCell() const;
 
             State getState() const;
 
             bool hasState() const;
-            ///< Does this cell have state that needs to be stored in a saved game file?
+            ///< Has this cell been used in a way that may have changed its state?
+
+            bool hasChangedState() const;
+            ///< Does this cell have state that needs to be stored in a saved game file? Cells that
+            /// were visited, but whose references and fog are still as in the content files, do not.
 
             bool hasId (const std::string& id) const;
+            bool hasId (const ESM::RefId& id) const;
             ///< May return true for deleted IDs when in preload state. Will return false, if cell is
             /// unloaded.
             /// @note Will not account for moved references which may exist in Loaded state. Use search() instead if the cell is loaded.
 
             Ptr search (const std::string& id);
+            Ptr search (const ESM::RefId& id);
             ///< Will return an empty Ptr if cell is not loaded. Does not check references in
             /// containers.
             /// @note Triggers CellStore hasState flag.
 
             ConstPtr searchConst (const std::string& id) const;
+            ConstPtr searchConst (const ESM::RefId& id) const;
             ///< Will return an empty Ptr if cell is not loaded. Does not check references in
             /// containers.
             /// @note Does not trigger CellStore hasState flag.
@@ -359,9 +379,36 @@ namespace MWWorld
             /// @param callback to use for retrieving of additional CellStore objects by ID (required for resolving moved references)
             void readReferences (ESM::ESMReader& reader, const std::map<int, int>& contentFileMap, GetCellStoreCallback* callback);
 
+            /// @brief A saved game that the references of cells are read from when they are first needed.
+            struct SavedGame
+            {
+                /// Must read from memory, see ESM::ESMReader::openInMemory
+                ESM::ESMReader mReader;
+                std::map<int, int> mContentFileMap;
+            };
+
+            void deferReferences (const boost::shared_ptr<SavedGame>& savedGame, const ESM::ESM_Context& references);
+            ///< Read the references of this cell from \a savedGame when the cell is loaded, instead of
+            /// now. \a references is their position in the file of \a savedGame.
+            /// @note Cells with references moved to another cell must use readReferences(), since the
+            /// other cell would not know about these references until this one is loaded.
+
+            bool canUnload() const;
+            ///< Is the cell loaded, without references moved to or from other cells? The other cells
+            /// would lose track of these.
+
+            void unload();
+            ///< Drop the references of this cell, to be loaded again when they are needed. References that were
+            /// changed are kept in memory in the form of a saved game, see deferReferences().
+            /// @note Only for cells that are not in the scene. Ptrs of the references become invalid.
+            /// @note Throws an exception unless canUnload().
+
             void respawn ();
             ///< Check mLastRespawn and respawn references if necessary. This is a no-op if the cell is not loaded.
 
+            void dropListedRefs();
+            ///< Free the references kept from preload(). Loading the cell reads them from the content files again.
+
             bool isPointConnected(const int start, const int end) const;
 
             std::list<ESM::Pathgrid::Point> aStarSearch(const int start, const int end) const;
@@ -39,23 +39,16 @@ namespace
     }
 
     template<typename T>
-    MWWorld::Ptr searchId (MWWorld::CellRefList<T>& list, const std::string& id,
-        MWWorld::ContainerStore *store)
+    void indexList (MWWorld::CellRefList<T>& list, MWWorld::ContainerStore *store,
+        std::map<std::string, std::vector<MWWorld::Ptr> >& index)
     {
-        std::string id2 = Misc::StringUtils::lowerCase (id);
-
         for (typename MWWorld::CellRefList<T>::List::iterator iter (list.mList.begin());
              iter!=list.mList.end(); ++iter)
         {
-            if (Misc::StringUtils::ciEqual(iter->mBase->mId, id2))
-            {
-                MWWorld::Ptr ptr (&*iter, 0);
-                ptr.setContainerStore (store);
-                return ptr;
-            }
+            MWWorld::Ptr ptr (&*iter, 0);
+            ptr.setContainerStore (store);
+            index[Misc::StringUtils::lowerCase (iter->mBase->mId)].push_back (ptr);
         }
-
-        return MWWorld::Ptr();
     }
 }
 
@@ -113,7 +106,7 @@ void MWWorld::ContainerStore::storeStates (const CellRefList<T>& collection,
 
 const std::string MWWorld::ContainerStore::sGoldId = "gold_001";
 
-MWWorld::ContainerStore::ContainerStore() : mCachedWeight (0), mWeightUpToDate (false) {}
+MWWorld::ContainerStore::ContainerStore() : mCachedWeight (0), mWeightUpToDate (false), mStateId (0) {}
 
 MWWorld::ContainerStore::~ContainerStore() {}
 
@@ -127,12 +120,42 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::end()
     return ContainerStoreIterator (this);
 }
 
+const std::vector<MWWorld::Ptr>* MWWorld::ContainerStore::getStacks (const std::string& id)
+{
+    if (!mItemIndex.mUpToDate)
+    {
+        mItemIndex.mStacks.clear();
+        indexList (potions, this, mItemIndex.mStacks);
+        indexList (appas, this, mItemIndex.mStacks);
+        indexList (armors, this, mItemIndex.mStacks);
+        indexList (books, this, mItemIndex.mStacks);
+        indexList (clothes, this, mItemIndex.mStacks);
+        indexList (ingreds, this, mItemIndex.mStacks);
+        indexList (lights, this, mItemIndex.mStacks);
+        indexList (lockpicks, this, mItemIndex.mStacks);
+        indexList (miscItems, this, mItemIndex.mStacks);
+        indexList (probes, this, mItemIndex.mStacks);
+        indexList (repairs, this, mItemIndex.mStacks);
+        indexList (weapons, this, mItemIndex.mStacks);
+        mItemIndex.mUpToDate = true;
+    }
+
+    std::map<std::string, std::vector<Ptr> >::const_iterator found =
+        mItemIndex.mStacks.find (Misc::StringUtils::lowerCase (id));
+    if (found == mItemIndex.mStacks.end())
+        return NULL;
+    return &found->second;
+}
+
 int MWWorld::ContainerStore::count(const std::string &id)
 {
+    const std::vector<Ptr>* stacks = getStacks (id);
+    if (!stacks)
+        return 0;
+
     int total=0;
-    for (MWWorld::ContainerStoreIterator iter (begin()); iter!=end(); ++iter)
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), id))
-            total += iter->getRefData().getCount();
+    for (std::vector<Ptr>::const_iterator iter (stacks->begin()); iter!=stacks->end(); ++iter)
+        total += iter->getRefData().getCount();
     return total;
 }
 
@@ -170,6 +193,7 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::restack(const MWWorld::
             iter->getRefData().setCount(iter->getRefData().getCount() + item.getRefData().getCount());
             item.getRefData().setCount(0);
             retval = iter;
+            flagAsModified();
             break;
         }
     }
@@ -366,9 +390,15 @@ int MWWorld::ContainerStore::remove(const std::string& itemId, int count, const
 {
     int toRemove = count;
 
-    for (ContainerStoreIterator iter(begin()); iter != end() && toRemove > 0; ++iter)
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), itemId))
-            toRemove -= remove(*iter, toRemove, actor);
+    const std::vector<Ptr>* found = getStacks (itemId);
+    if (found)
+    {
+        // Removing modifies the index
+        std::vector<Ptr> stacks (*found);
+        for (std::vector<Ptr>::const_iterator iter (stacks.begin()); iter != stacks.end() && toRemove > 0; ++iter)
+            if (iter->getRefData().getCount() > 0)
+                toRemove -= remove(*iter, toRemove, actor);
+    }
 
     flagAsModified();
 
@@ -558,6 +588,13 @@ void MWWorld::ContainerStore::clear()
 void MWWorld::ContainerStore::flagAsModified()
 {
     mWeightUpToDate = false;
+    mItemIndex.mUpToDate = false;
+    ++mStateId;
+}
+
+int MWWorld::ContainerStore::getStateId() const
+{
+    return mStateId;
 }
 
 float MWWorld::ContainerStore::getWeight() const
@@ -632,79 +669,10 @@ int MWWorld::ContainerStore::getType (const ConstPtr& ptr)
 
 MWWorld::Ptr MWWorld::ContainerStore::search (const std::string& id)
 {
-    {
-        Ptr ptr = searchId (potions, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (appas, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (armors, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (books, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (clothes, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (ingreds, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (lights, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (lockpicks, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (miscItems, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (probes, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (repairs, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (weapons, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    return Ptr();
+    const std::vector<Ptr>* stacks = getStacks (id);
+    if (!stacks)
+        return Ptr();
+    return stacks->front();
 }
 
 void MWWorld::ContainerStore::writeState (ESM::InventoryState& state) const
@@ -767,6 +735,8 @@ void MWWorld::ContainerStore::readState (const ESM::InventoryState& inventory)
 
 
     mLevelledItemMap = inventory.mLevelledItemMap;
+
+    flagAsModified();
 }
 
 
@@ -4,6 +4,7 @@
 #include <iterator>
 #include <map>
 #include <utility>
+#include <vector>
 
 #include <components/esm/loadalch.hpp>
 #include <components/esm/loadappa.hpp>
@@ -75,6 +76,25 @@ namespace MWWorld
 
             mutable float mCachedWeight;
             mutable bool mWeightUpToDate;
+            int mStateId;
+
+            /// The stacks of each item ID, including the deleted ones, in the order of search().
+            /// Rebuilt on first use after the contents changed.
+            struct ItemIndex
+            {
+                std::map<std::string, std::vector<Ptr> > mStacks; // by lower case ID
+                bool mUpToDate;
+
+                ItemIndex() : mUpToDate (false) {}
+                // A copy refers to the items of another store
+                ItemIndex (const ItemIndex&) : mUpToDate (false) {}
+                ItemIndex& operator= (const ItemIndex&) { mStacks.clear(); mUpToDate = false; return *this; }
+            };
+            ItemIndex mItemIndex;
+
+            /// @return The stacks with this ID, or NULL if there are none.
+            const std::vector<Ptr>* getStacks (const std::string& id);
+
             ContainerStoreIterator addImp (const Ptr& ptr, int count);
             void addInitialItem (const std::string& id, const std::string& owner, int count, bool topLevel=true, const std::string& levItem = "");
 
@@ -141,6 +161,10 @@ namespace MWWorld
             /// @return How many items with refID \a id are in this container?
             int count (const std::string& id);
 
+            /// @return A number that changes whenever items are added or removed, to tell if information derived
+            /// from the contents is still valid.
+            int getStateId() const;
+
         protected:
             ContainerStoreIterator addNewStack (const ConstPtr& ptr, int count);
             ///< Add the item to this container (do not try to stack it onto existing items)
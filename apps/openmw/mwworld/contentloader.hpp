@@ -21,6 +21,11 @@ struct ContentLoader
     {
     }
 
+    /// Called for all content files in load order, before the first load() call. Allows work to be done ahead of time.
+    virtual void prepare(const boost::filesystem::path& filepath, int index)
+    {
+    }
+
     virtual void load(const boost::filesystem::path& filepath, int& index)
     {
       std::cout << "Loading content file " << filepath.string() << std::endl;
@@ -0,0 +1,213 @@
+#include "contentsnapshot.hpp"
+
+#include <iostream>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/esm/esmwriter.hpp>
+#include <components/loadinglistener/loadinglistener.hpp>
+
+#include "esmstore.hpp"
+
+namespace
+{
+    /// Increase when the layout of records or of the snapshot itself changes
+    const uint32_t sFormatVersion = 1;
+
+    const uint32_t sKeyRecord = ESM::FourCC<'S','K','E','Y'>::value;
+    const uint32_t sLocationsRecord = ESM::FourCC<'S','L','O','C'>::value;
+}
+
+namespace MWWorld
+{
+
+    ContentSnapshot::ContentSnapshot(const boost::filesystem::path &file)
+        : mFile(file)
+    {
+    }
+
+    bool ContentSnapshot::open(const std::vector<boost::filesystem::path> &contentFiles)
+    {
+        if (!boost::filesystem::exists(mFile))
+            return false;
+
+        try
+        {
+            if (readHeader(contentFiles))
+                return true;
+            std::cout << "Content snapshot " << mFile.string() << " is outdated" << std::endl;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to read content snapshot " << mFile.string() << ": " << e.what() << std::endl;
+        }
+
+        mReader.close();
+        mFileNames.clear();
+        mLocations.clear();
+        return false;
+    }
+
+    bool ContentSnapshot::readHeader(const std::vector<boost::filesystem::path> &contentFiles)
+    {
+        mReader.openMapped(mFile.string());
+
+        if (!mReader.hasMoreRecs() || mReader.getRecName().val != sKeyRecord)
+            return false;
+        mReader.getRecHeader();
+
+        uint32_t version = 0;
+        mReader.getHNT(version, "VERS");
+        if (version != sFormatVersion)
+            return false;
+
+        for (std::vector<boost::filesystem::path>::const_iterator it = contentFiles.begin(); it != contentFiles.end(); ++it)
+        {
+            if (!mReader.isNextSub("FNAM") || mReader.getHString() != it->string())
+                return false;
+
+            uint64_t size = 0;
+            int64_t modified = 0;
+            mReader.getHNT(size, "SIZE");
+            mReader.getHNT(modified, "MTIM");
+            if (size != boost::filesystem::file_size(*it) || modified != boost::filesystem::last_write_time(*it))
+                return false;
+
+            mFileNames.push_back(it->string());
+        }
+        if (mReader.hasMoreSubs())
+            return false;
+
+        for (size_t i=0; i<contentFiles.size(); ++i)
+        {
+            if (!mReader.hasMoreRecs() || mReader.getRecName().val != sLocationsRecord)
+                return false;
+            mReader.getRecHeader();
+
+            mLocations.push_back(std::vector<Location>());
+            std::vector<Location>& locations = mLocations.back();
+
+            mReader.getSubNameIs("DATA");
+            mReader.getSubHeader();
+            const uint32_t size = mReader.getSubSize();
+            if (size % sizeof(Location) != 0)
+                mReader.fail("Invalid record locations");
+            locations.resize(size / sizeof(Location));
+            if (!locations.empty())
+                mReader.getExact(&locations[0], size);
+        }
+
+        return true;
+    }
+
+    void ContentSnapshot::getDependentRecords(size_t position, int index, ParsedContentFile &parsed) const
+    {
+        const std::vector<Location>& locations = mLocations.at(position);
+
+        parsed.mEntries.reserve(locations.size());
+        for (std::vector<Location>::const_iterator it = locations.begin(); it != locations.end(); ++it)
+        {
+            ParsedContentFile::Entry entry;
+            entry.mType = it->mType;
+            entry.mRecord = NULL;
+            entry.mContext.filename = mFileNames[position];
+            entry.mContext.leftRec = it->mLeftRec;
+            entry.mContext.leftSub = it->mLeftSub;
+            entry.mContext.leftFile = static_cast<size_t>(it->mLeftFile);
+            entry.mContext.recName.val = it->mRecName;
+            entry.mContext.subName.val = it->mSubName;
+            entry.mContext.index = index;
+            entry.mContext.subCached = it->mSubCached != 0;
+            entry.mContext.filePos = static_cast<size_t>(it->mFilePos);
+            parsed.mEntries.push_back(entry);
+        }
+    }
+
+    void ContentSnapshot::load(ESMStore &store, Loading::Listener* listener)
+    {
+        mReader.setStringPool(&store.getStringPool());
+        store.loadSnapshot(mReader, listener);
+        mReader.close();
+    }
+
+    void ContentSnapshot::write(const std::vector<boost::filesystem::path> &contentFiles, const ESMStore &store) const
+    {
+        // Write to a temporary file first, so a snapshot is never left half written
+        boost::filesystem::path tempFile = mFile;
+        tempFile += ".tmp";
+
+        try
+        {
+            if (mFile.has_parent_path() && !boost::filesystem::exists(mFile.parent_path()))
+                boost::filesystem::create_directories(mFile.parent_path());
+
+            {
+                boost::filesystem::ofstream stream(tempFile, std::ios::binary | std::ios::out | std::ios::trunc);
+                if (!stream.is_open())
+                    throw std::runtime_error("can not open file for writing");
+                stream.exceptions(std::ios::failbit | std::ios::badbit);
+
+                ESM::ESMWriter writer;
+                writer.setFormat(0);
+                writer.setDescription("OpenMW content snapshot");
+                writer.save(stream);
+
+                writer.startRecord(sKeyRecord);
+                writer.writeHNT("VERS", sFormatVersion);
+                for (std::vector<boost::filesystem::path>::const_iterator it = contentFiles.begin(); it != contentFiles.end(); ++it)
+                {
+                    writer.writeHNString("FNAM", it->string());
+                    writer.writeHNT("SIZE", static_cast<uint64_t>(boost::filesystem::file_size(*it)));
+                    writer.writeHNT("MTIM", static_cast<int64_t>(boost::filesystem::last_write_time(*it)));
+                }
+                writer.endRecord(sKeyRecord);
+
+                for (size_t i=0; i<contentFiles.size(); ++i)
+                {
+                    ESM::ESMReader reader;
+                    reader.setIndex(static_cast<int>(i));
+                    reader.open(contentFiles[i].string());
+
+                    ParsedContentFile parsed;
+                    store.locateDependentRecords(reader, parsed);
+
+                    std::vector<Location> locations;
+                    locations.reserve(parsed.mEntries.size());
+                    for (std::vector<ParsedContentFile::Entry>::const_iterator it = parsed.mEntries.begin(); it != parsed.mEntries.end(); ++it)
+                    {
+                        Location location;
+                        location.mType = it->mType;
+                        location.mLeftRec = it->mContext.leftRec;
+                        location.mLeftSub = it->mContext.leftSub;
+                        location.mRecName = it->mContext.recName.val;
+                        location.mSubName = it->mContext.subName.val;
+                        location.mSubCached = it->mContext.subCached;
+                        location.mLeftFile = it->mContext.leftFile;
+                        location.mFilePos = it->mContext.filePos;
+                        locations.push_back(location);
+                    }
+
+                    writer.startRecord(sLocationsRecord);
+                    writer.startSubRecord("DATA");
+                    if (!locations.empty())
+                        writer.write(reinterpret_cast<const char*>(&locations[0]), locations.size() * sizeof(Location));
+                    writer.endRecord("DATA");
+                    writer.endRecord(sLocationsRecord);
+                }
+
+                store.writeSnapshot(writer);
+                writer.close();
+            }
+
+            boost::filesystem::rename(tempFile, mFile);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to write content snapshot " << mFile.string() << ": " << e.what() << std::endl;
+            boost::system::error_code ec;
+            boost::filesystem::remove(tempFile, ec);
+        }
+    }
+
+}
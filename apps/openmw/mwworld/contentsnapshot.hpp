@@ -0,0 +1,69 @@
+#ifndef OPENMW_MWWORLD_CONTENTSNAPSHOT_H
+#define OPENMW_MWWORLD_CONTENTSNAPSHOT_H
+
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+#include <components/esm/esmreader.hpp>
+
+namespace Loading
+{
+    class Listener;
+}
+
+namespace MWWorld
+{
+    class ESMStore;
+    class ParsedContentFile;
+
+    /// @brief The merged records of a list of content files, saved so that the next start with the same
+    /// content files does not have to read and merge all of them again.
+    /// @par The snapshot holds the records of all stores with independent records, as they were after the
+    /// last content file was loaded, and the locations of all other records in the content files. Those are
+    /// still loaded from the content files, in order. The snapshot is only used if none of the content files
+    /// changed in size or modification time.
+    /// @par The snapshot is an ESM file itself, and is memory mapped for reading.
+    class ContentSnapshot
+    {
+    public:
+        ContentSnapshot(const boost::filesystem::path& file);
+
+        /// Open the snapshot, if it was made from the given content files, in this order.
+        /// @return Can the snapshot be used? Is false if it does not exist, or is outdated or damaged.
+        bool open(const std::vector<boost::filesystem::path>& contentFiles);
+
+        /// Get the locations of records in the given content file that are not in the snapshot.
+        /// @param position Position of the file in the list passed to open().
+        void getDependentRecords(size_t position, int index, ParsedContentFile& parsed) const;
+
+        /// Load the records in the snapshot into the given store.
+        void load(ESMStore& store, Loading::Listener* listener);
+
+        /// Make a snapshot of the given store, after loading the given content files into it.
+        void write(const std::vector<boost::filesystem::path>& contentFiles, const ESMStore& store) const;
+
+    private:
+        /// Leaves the reader at the first record of the store.
+        bool readHeader(const std::vector<boost::filesystem::path>& contentFiles);
+
+        struct Location
+        {
+            uint32_t mType;
+            uint32_t mLeftRec;
+            uint32_t mLeftSub;
+            uint32_t mRecName;
+            uint32_t mSubName;
+            uint32_t mSubCached;
+            uint64_t mLeftFile;
+            uint64_t mFilePos;
+        };
+
+        boost::filesystem::path mFile;
+        ESM::ESMReader mReader;
+        std::vector<std::string> mFileNames;
+        std::vector<std::vector<Location> > mLocations;
+    };
+}
+
+#endif
@@ -3,10 +3,59 @@
 #include <stdexcept>
 #include <sstream>
 #include <typeinfo>
+#include <map>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+namespace
+{
+    // Each class of custom data has its own size, so a pool per size is a pool per class
+    typedef std::map<std::size_t, std::vector<void*> > Pools;
+
+    Pools& getPools()
+    {
+        // Never destroyed, so custom data can still be deleted after the static objects are
+        static Pools* pools = new Pools;
+        return *pools;
+    }
+
+    boost::mutex& getPoolMutex()
+    {
+        static boost::mutex* mutex = new boost::mutex;
+        return *mutex;
+    }
+}
 
 namespace MWWorld
 {
 
+void* CustomData::operator new (std::size_t size)
+{
+    {
+        boost::mutex::scoped_lock lock (getPoolMutex());
+
+        std::vector<void*>& pool = getPools()[size];
+        if (!pool.empty())
+        {
+            void* pointer = pool.back();
+            pool.pop_back();
+            return pointer;
+        }
+    }
+
+    return ::operator new (size);
+}
+
+void CustomData::operator delete (void* pointer, std::size_t size)
+{
+    if (!pointer)
+        return;
+
+    boost::mutex::scoped_lock lock (getPoolMutex());
+    getPools()[size].push_back (pointer);
+}
+
 MWClass::CreatureCustomData &CustomData::asCreatureCustomData()
 {
     std::stringstream error;
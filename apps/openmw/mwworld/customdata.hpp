@@ -1,6 +1,8 @@
 #ifndef GAME_MWWORLD_CUSTOMDATA_H
 #define GAME_MWWORLD_CUSTOMDATA_H
 
+#include <cstddef>
+
 namespace MWClass
 {
     class CreatureCustomData;
@@ -19,6 +21,11 @@ namespace MWWorld
 
             virtual ~CustomData() {}
 
+            /// The data of every actor and container in the active cells is created on first use and
+            /// copied with the references, so its memory is kept in pools by type and reused.
+            static void* operator new (std::size_t size);
+            static void operator delete (void* pointer, std::size_t size);
+
             virtual CustomData *clone() const = 0;
 
             // Fast version of dynamic_cast<X&>. Needs to be overridden in the respective class.
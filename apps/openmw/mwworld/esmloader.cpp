@@ -1,7 +1,16 @@
 #include "esmloader.hpp"
 #include "esmstore.hpp"
+#include "contentsnapshot.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
 
 #include <components/esm/esmreader.hpp>
+#include <components/settings/settings.hpp>
+#include <components/to_utf8/to_utf8.hpp>
 
 namespace MWWorld
 {
@@ -12,20 +21,226 @@ EsmLoader::EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& read
   , mEsm(readers)
   , mStore(store)
   , mEncoder(encoder)
+  , mMapFiles(Settings::Manager::getBool("memory map content files", "General"))
+  , mParallel(Settings::Manager::getBool("parallel content loading", "General"))
+  , mNumWorkers(0)
+  , mQuit(false)
+  , mSnapshotChecked(false)
+  , mSnapshotUsed(false)
+  , mNextLoad(0)
+  , mMaxAhead(0)
 {
 }
 
+EsmLoader::~EsmLoader()
+{
+  stopWorkers();
+}
+
+void EsmLoader::stopWorkers()
+{
+  {
+    boost::mutex::scoped_lock lock(mMutex);
+    mQuit = true;
+  }
+  mCondition.notify_all();
+  mWorkers.join_all();
+}
+
+void EsmLoader::openReader(ESM::ESMReader& reader, const boost::filesystem::path& filepath, int index,
+                           ToUTF8::Utf8Encoder* encoder)
+{
+  reader.setEncoder(encoder);
+  reader.setStringPool(&mStore.getStringPool());
+  reader.setIndex(index);
+  if (mMapFiles)
+      reader.openMapped(filepath.string());
+  else
+      reader.open(filepath.string());
+}
+
+void EsmLoader::prepare(const boost::filesystem::path& filepath, int index)
+{
+  boost::mutex::scoped_lock lock(mMutex);
+
+  ParseJob job;
+  job.mPath = filepath;
+  job.mIndex = index;
+  job.mStarted = false;
+  job.mDone = false;
+  mJobs.push_back(job);
+
+  mCondition.notify_all();
+}
+
+void EsmLoader::startWorkers()
+{
+  boost::mutex::scoped_lock lock(mMutex);
+
+  // The main thread stays busy inserting the parsed records
+  mNumWorkers = std::max(2u, boost::thread::hardware_concurrency()) - 1;
+  // Bounds the memory used by parsed records waiting to be loaded
+  mMaxAhead = mNumWorkers + 1;
+
+  for (size_t i=0; i<mNumWorkers; ++i)
+    mWorkers.create_thread(boost::bind(&EsmLoader::runWorker, this));
+}
+
+void EsmLoader::setSnapshot(const boost::filesystem::path& file)
+{
+  mSnapshot.reset(new ContentSnapshot(file));
+}
+
+void EsmLoader::saveSnapshot()
+{
+  if (!mSnapshot || mSnapshotUsed || mJobs.empty())
+    return;
+
+  std::vector<boost::filesystem::path> paths;
+  for (std::vector<ParseJob>::const_iterator it = mJobs.begin(); it != mJobs.end(); ++it)
+    paths.push_back(it->mPath);
+
+  mSnapshot->write(paths, mStore);
+}
+
+void EsmLoader::runWorker()
+{
+  while (true)
+  {
+    size_t jobIndex = 0;
+    boost::filesystem::path path;
+    int index = 0;
+
+    {
+      boost::mutex::scoped_lock lock(mMutex);
+      while (true)
+      {
+        if (mQuit)
+          return;
+
+        bool found = false;
+        for (jobIndex = mNextLoad; jobIndex < mJobs.size() && jobIndex < mNextLoad + mMaxAhead; ++jobIndex)
+        {
+          if (!mJobs[jobIndex].mStarted)
+          {
+            found = true;
+            break;
+          }
+        }
+        if (found)
+          break;
+
+        mCondition.wait(lock);
+      }
+
+      mJobs[jobIndex].mStarted = true;
+      path = mJobs[jobIndex].mPath;
+      index = mJobs[jobIndex].mIndex;
+    }
+
+    boost::shared_ptr<ParsedContentFile> parsed(new ParsedContentFile);
+    std::string error;
+    try
+    {
+      // The encoder has an internal buffer, so each thread needs its own
+      std::auto_ptr<ToUTF8::Utf8Encoder> encoder;
+      if (mEncoder)
+        encoder.reset(new ToUTF8::Utf8Encoder(*mEncoder));
+
+      ESM::ESMReader reader;
+      openReader(reader, path, index, encoder.get());
+      mStore.parse(reader, *parsed);
+    }
+    catch (std::exception& e)
+    {
+      parsed.reset();
+      error = e.what();
+      if (error.empty())
+        error = "Failed to parse " + path.string();
+    }
+
+    {
+      boost::mutex::scoped_lock lock(mMutex);
+      mJobs[jobIndex].mParsed = parsed;
+      mJobs[jobIndex].mError = error;
+      mJobs[jobIndex].mDone = true;
+    }
+    mCondition.notify_all();
+  }
+}
+
 void EsmLoader::load(const boost::filesystem::path& filepath, int& index)
 {
   ContentLoader::load(filepath.filename(), index);
 
+  if (!mSnapshotChecked)
+  {
+    mSnapshotChecked = true;
+
+    if (mSnapshot)
+    {
+      std::vector<boost::filesystem::path> paths;
+      for (std::vector<ParseJob>::const_iterator it = mJobs.begin(); it != mJobs.end(); ++it)
+        paths.push_back(it->mPath);
+      mSnapshotUsed = !paths.empty() && paths.front() == filepath && mSnapshot->open(paths);
+    }
+
+    if (mSnapshotUsed)
+      mSnapshot->load(mStore, &mListener);
+    else if (mParallel && !mJobs.empty())
+      startWorkers();
+  }
+
   ESM::ESMReader lEsm;
-  lEsm.setEncoder(mEncoder);
-  lEsm.setIndex(index);
+  openReader(lEsm, filepath, index, mEncoder);
   lEsm.setGlobalReaderList(&mEsm);
-  lEsm.open(filepath.string());
   mEsm[index] = lEsm;
-  mStore.load(mEsm[index], &mListener);
+
+  if (mSnapshotUsed)
+  {
+    for (size_t i=0; i<mJobs.size(); ++i)
+    {
+      if (mJobs[i].mIndex != index)
+        continue;
+
+      // Only the records that are not part of the snapshot are left to load
+      ParsedContentFile parsed;
+      mSnapshot->getDependentRecords(i, index, parsed);
+      mStore.load(mEsm[index], parsed, &mListener);
+      return;
+    }
+    throw std::runtime_error("Content file " + filepath.string() + " is not part of the content snapshot");
+  }
+
+  boost::shared_ptr<ParsedContentFile> parsed;
+  std::string error;
+  {
+    boost::mutex::scoped_lock lock(mMutex);
+    for (size_t i=mNextLoad; i<mJobs.size() && mNumWorkers > 0; ++i)
+    {
+      if (mJobs[i].mIndex != index)
+        continue;
+
+      mNextLoad = i;
+      mCondition.notify_all();
+      while (!mJobs[i].mDone)
+        mCondition.wait(lock);
+
+      parsed.swap(mJobs[i].mParsed);
+      error = mJobs[i].mError;
+      mNextLoad = i+1;
+      mCondition.notify_all();
+      break;
+    }
+  }
+
+  if (!error.empty())
+    throw std::runtime_error(error);
+
+  if (parsed)
+    mStore.load(mEsm[index], *parsed, &mListener);
+  else
+    mStore.load(mEsm[index], &mListener);
 }
 
 } /* namespace MWWorld */
@@ -2,6 +2,11 @@
 #define ESMLOADER_HPP
 
 #include <vector>
+#include <map>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
 
 #include "contentloader.hpp"
 
@@ -19,18 +24,70 @@ namespace MWWorld
 {
 
 class ESMStore;
+class ParsedContentFile;
+class ContentSnapshot;
 
 struct EsmLoader : public ContentLoader
 {
     EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& readers,
       ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener);
+    ~EsmLoader();
+
+    /// Parse the file on a worker thread, if parallel content file parsing is enabled.
+    void prepare(const boost::filesystem::path& filepath, int index);
 
     void load(const boost::filesystem::path& filepath, int& index);
 
+    /// Use a snapshot of the merged content in the given file, if it matches the prepared content files.
+    /// @note Call before prepare().
+    void setSnapshot(const boost::filesystem::path& file);
+
+    /// Write the snapshot set with setSnapshot(), if it was not used. Call after all content files are loaded.
+    void saveSnapshot();
+
     private:
+      struct ParseJob
+      {
+          boost::filesystem::path mPath;
+          int mIndex;
+          bool mStarted;
+          bool mDone;
+          boost::shared_ptr<ParsedContentFile> mParsed;
+          std::string mError;
+      };
+
+      void openReader(ESM::ESMReader& reader, const boost::filesystem::path& filepath, int index,
+                      ToUTF8::Utf8Encoder* encoder);
+
+      void runWorker();
+
+      void startWorkers();
+
+      void stopWorkers();
+
       std::vector<ESM::ESMReader>& mEsm;
       MWWorld::ESMStore& mStore;
       ToUTF8::Utf8Encoder* mEncoder;
+
+      bool mMapFiles;
+      bool mParallel;
+
+      boost::mutex mMutex;
+      boost::condition_variable mCondition;
+      boost::thread_group mWorkers;
+      size_t mNumWorkers;
+      bool mQuit;
+
+      boost::scoped_ptr<ContentSnapshot> mSnapshot;
+      /// Was the snapshot checked against the content files yet?
+      bool mSnapshotChecked;
+      bool mSnapshotUsed;
+
+      /// Jobs in the order the files will be loaded. Workers only process them if parallel loading is enabled.
+      std::vector<ParseJob> mJobs;
+      /// Index of the job for the file that is loaded next. Workers stay at most mMaxAhead jobs ahead of that.
+      size_t mNextLoad;
+      size_t mMaxAhead;
 };
 
 } /* namespace MWWorld */
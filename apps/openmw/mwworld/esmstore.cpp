@@ -27,12 +27,14 @@ static bool isCacheableRecord(int id)
     return false;
 }
 
-void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
+ParsedContentFile::~ParsedContentFile()
 {
-    listener->setProgressRange(1000);
-
-    ESM::Dialogue *dialogue = 0;
+    for (std::vector<Entry>::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+        delete it->mRecord;
+}
 
+void ESMStore::resolveMasters(ESM::ESMReader &esm)
+{
     // Land texture loading needs to use a separate internal store for each plugin.
     // We set the number of plugins here to avoid continual resizes during loading,
     // and so we can properly verify if valid plugin indices are being passed to the
@@ -66,6 +68,62 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
         }
         mast.index = index;
     }
+}
+
+void ESMStore::loadRecord(ESM::ESMReader &esm, ESM::NAME n, ESM::Dialogue *&dialogue)
+{
+    // Look up the record type.
+    std::map<int, StoreBase *>::iterator it = mStores.find(n.val);
+
+    if (it == mStores.end()) {
+        if (n.val == ESM::REC_INFO) {
+            if (dialogue)
+            {
+                dialogue->readInfo(esm, esm.getIndex() != 0);
+            }
+            else
+            {
+                std::cerr << "error: info record without dialog" << std::endl;
+                esm.skipRecord();
+            }
+        } else if (n.val == ESM::REC_MGEF) {
+            mMagicEffects.load (esm);
+        } else if (n.val == ESM::REC_SKIL) {
+            mSkills.load (esm);
+        }
+        else if (n.val==ESM::REC_FILT || n.val == ESM::REC_DBGP)
+        {
+            // ignore project file only records
+            esm.skipRecord();
+        }
+        else {
+            std::stringstream error;
+            error << "Unknown record: " << n.toString();
+            throw std::runtime_error(error.str());
+        }
+    } else {
+        RecordId id = it->second->load(esm);
+        if (id.mIsDeleted)
+        {
+            it->second->eraseStatic(id.mId);
+            return;
+        }
+
+        if (n.val==ESM::REC_DIAL) {
+            dialogue = const_cast<ESM::Dialogue*>(mDialogs.find(id.mId));
+        } else {
+            dialogue = 0;
+        }
+    }
+}
+
+void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
+{
+    listener->setProgressRange(1000);
+
+    ESM::Dialogue *dialogue = 0;
+
+    resolveMasters(esm);
 
     // Loop through all records
     while(esm.hasMoreRecs())
@@ -73,49 +131,112 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
         ESM::NAME n = esm.getRecName();
         esm.getRecHeader();
 
-        // Look up the record type.
-        std::map<int, StoreBase *>::iterator it = mStores.find(n.val);
+        loadRecord(esm, n, dialogue);
 
-        if (it == mStores.end()) {
-            if (n.val == ESM::REC_INFO) {
-                if (dialogue)
-                {
-                    dialogue->readInfo(esm, esm.getIndex() != 0);
-                }
-                else
-                {
-                    std::cerr << "error: info record without dialog" << std::endl;
-                    esm.skipRecord();
-                }
-            } else if (n.val == ESM::REC_MGEF) {
-                mMagicEffects.load (esm);
-            } else if (n.val == ESM::REC_SKIL) {
-                mSkills.load (esm);
-            }
-            else if (n.val==ESM::REC_FILT || n.val == ESM::REC_DBGP)
-            {
-                // ignore project file only records
-                esm.skipRecord();
-            }
-            else {
-                std::stringstream error;
-                error << "Unknown record: " << n.toString();
-                throw std::runtime_error(error.str());
-            }
-        } else {
-            RecordId id = it->second->load(esm);
-            if (id.mIsDeleted)
-            {
-                it->second->eraseStatic(id.mId);
-                continue;
-            }
+        listener->setProgress(static_cast<size_t>(esm.getFileOffset() / (float)esm.getFileSize() * 1000));
+    }
+}
 
-            if (n.val==ESM::REC_DIAL) {
-                dialogue = const_cast<ESM::Dialogue*>(mDialogs.find(id.mId));
-            } else {
+void ESMStore::parse(ESM::ESMReader &esm, ParsedContentFile &parsed) const
+{
+    while(esm.hasMoreRecs())
+    {
+        ParsedContentFile::Entry entry;
+        entry.mType = esm.getRecName().val;
+        esm.getRecHeader();
+
+        std::map<int, StoreBase *>::const_iterator it = mStores.find(entry.mType);
+        entry.mRecord = (it != mStores.end()) ? it->second->parse(esm) : NULL;
+        if (!entry.mRecord)
+        {
+            entry.mContext = esm.getContext();
+            esm.skipRecord();
+        }
+
+        parsed.mEntries.push_back(entry);
+    }
+}
+
+void ESMStore::load(ESM::ESMReader &esm, const ParsedContentFile &parsed, Loading::Listener* listener)
+{
+    listener->setProgressRange(1000);
+
+    ESM::Dialogue *dialogue = 0;
+
+    resolveMasters(esm);
+
+    const size_t count = parsed.mEntries.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const ParsedContentFile::Entry& entry = parsed.mEntries[i];
+
+        if (entry.mRecord)
+        {
+            StoreBase* store = mStores[entry.mType];
+            RecordId id = store->insertParsed(*entry.mRecord);
+            if (id.mIsDeleted)
+                store->eraseStatic(id.mId);
+            else
                 dialogue = 0;
-            }
         }
+        else
+        {
+            esm.restoreContext(entry.mContext);
+            ESM::NAME n;
+            n.val = entry.mType;
+            loadRecord(esm, n, dialogue);
+        }
+
+        listener->setProgress(static_cast<size_t>((i + 1) / (float)count * 1000));
+    }
+}
+
+void ESMStore::locateDependentRecords(ESM::ESMReader &esm, ParsedContentFile &parsed) const
+{
+    while(esm.hasMoreRecs())
+    {
+        ParsedContentFile::Entry entry;
+        entry.mType = esm.getRecName().val;
+        esm.getRecHeader();
+
+        std::map<int, StoreBase *>::const_iterator it = mStores.find(entry.mType);
+        if (it == mStores.end() || !it->second->hasIndependentRecords())
+        {
+            entry.mRecord = NULL;
+            entry.mContext = esm.getContext();
+            parsed.mEntries.push_back(entry);
+        }
+        esm.skipRecord();
+    }
+}
+
+void ESMStore::writeSnapshot(ESM::ESMWriter &writer) const
+{
+    for (std::map<int, StoreBase *>::const_iterator it = mStores.begin(); it != mStores.end(); ++it)
+    {
+        if (it->second->hasIndependentRecords())
+            it->second->writeStatic(writer);
+    }
+}
+
+void ESMStore::loadSnapshot(ESM::ESMReader &esm, Loading::Listener* listener)
+{
+    listener->setProgressRange(1000);
+
+    while(esm.hasMoreRecs())
+    {
+        ESM::NAME n = esm.getRecName();
+        esm.getRecHeader();
+
+        std::map<int, StoreBase *>::iterator it = mStores.find(n.val);
+        if (it == mStores.end() || !it->second->hasIndependentRecords())
+        {
+            std::stringstream error;
+            error << "Unexpected record in snapshot: " << n.toString();
+            throw std::runtime_error(error.str());
+        }
+        it->second->load(esm);
+
         listener->setProgress(static_cast<size_t>(esm.getFileOffset() / (float)esm.getFileSize() * 1000));
     }
 }
@@ -141,6 +262,8 @@ void ESMStore::setUp()
     mMagicEffects.setUp();
     mAttributes.setUp();
     mDialogs.setUp();
+    mGmsts.setUp();
+    mLevelledLists.setUp();
 }
 
     int ESMStore::countSavedGameRecords() const
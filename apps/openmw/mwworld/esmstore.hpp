@@ -5,7 +5,10 @@
 #include <stdexcept>
 
 #include <components/esm/records.hpp>
+#include <components/misc/stringpool.hpp>
 #include "store.hpp"
+#include "gmstregistry.hpp"
+#include "levelledlisttables.hpp"
 
 namespace Loading
 {
@@ -14,6 +17,31 @@ namespace Loading
 
 namespace MWWorld
 {
+    /// @brief The records of one content file, parsed ahead of time by ESMStore::parse.
+    class ParsedContentFile
+    {
+        struct Entry
+        {
+            int mType;
+            /// NULL if the record has to be loaded in order, starting from mContext
+            ParsedRecord* mRecord;
+            ESM::ESM_Context mContext;
+        };
+
+        std::vector<Entry> mEntries;
+
+        friend class ESMStore;
+        friend class ContentSnapshot;
+
+        // not implemented
+        ParsedContentFile(const ParsedContentFile&);
+        ParsedContentFile& operator=(const ParsedContentFile&);
+
+    public:
+        ParsedContentFile() {}
+        ~ParsedContentFile();
+    };
+
     class ESMStore
     {
         Store<ESM::Activator>       mActivators;
@@ -65,6 +93,13 @@ namespace MWWorld
         // Special entry which is hardcoded and not loaded from an ESM
         Store<ESM::Attribute>   mAttributes;
 
+        GmstRegistry mGmsts;
+
+        LevelledListTables mLevelledLists;
+
+        /// IDs referenced by records, shared by all readers of the content files
+        Misc::StringPool mStringPool;
+
         // Lookup of all IDs. Makes looking up references faster. Just
         // maps the id name to the record type.
         std::map<std::string, int> mIds;
@@ -74,6 +109,11 @@ namespace MWWorld
 
         unsigned int mDynamicCount;
 
+        /// Find the indices of the masters of the given file in the global reader list.
+        void resolveMasters(ESM::ESMReader &esm);
+
+        void loadRecord(ESM::ESMReader &esm, ESM::NAME name, ESM::Dialogue *&dialogue);
+
     public:
         /// \todo replace with SharedIterator<StoreBase>
         typedef std::map<int, StoreBase *>::const_iterator iterator;
@@ -98,7 +138,9 @@ namespace MWWorld
         }
 
         ESMStore()
-          : mDynamicCount(0)
+          : mGmsts(mGameSettings)
+          , mLevelledLists(*this)
+          , mDynamicCount(0)
         {
             mStores[ESM::REC_ACTI] = &mActivators;
             mStores[ESM::REC_ALCH] = &mPotions;
@@ -160,6 +202,41 @@ namespace MWWorld
 
         void load(ESM::ESMReader &esm, Loading::Listener* listener);
 
+        /// Parse the records of a content file as far as possible without modifying the store,
+        /// so that the expensive part of loading can be done on another thread. Records that
+        /// depend on the ones before them are only located, to be loaded later on.
+        /// @note Thread safe, as long as each thread uses its own reader and encoder.
+        void parse(ESM::ESMReader &esm, ParsedContentFile &parsed) const;
+
+        /// Load a content file that was parsed with parse(). The result is the same as for
+        /// load(esm, listener), with the reader only being used for the records that were not parsed.
+        void load(ESM::ESMReader &esm, const ParsedContentFile &parsed, Loading::Listener* listener);
+
+        /// Locate the records of a content file that can not be part of a snapshot, without loading anything.
+        /// The result can be passed to load(esm, parsed, listener) when loading the others from a snapshot.
+        void locateDependentRecords(ESM::ESMReader &esm, ParsedContentFile &parsed) const;
+
+        /// Write the records loaded from content files into a snapshot, for all stores with independent records.
+        void writeSnapshot(ESM::ESMWriter &writer) const;
+
+        /// Load the records written by writeSnapshot(), up to the end of the file.
+        void loadSnapshot(ESM::ESMReader &esm, Loading::Listener* listener);
+
+        /// Game settings used by the mechanics, to be read without looking them up by name.
+        const GmstRegistry &getGmsts() const {
+            return mGmsts;
+        }
+
+        /// The levelled lists prepared for picking their entries by level.
+        const LevelledListTables &getLevelledLists() const {
+            return mLevelledLists;
+        }
+
+        /// String pool to set on readers of the content files, see ESM::ESMReader::intern().
+        Misc::StringPool &getStringPool() {
+            return mStringPool;
+        }
+
         template <class T>
         const Store<T> &get() const {
             throw std::runtime_error("Storage for this type not exist");
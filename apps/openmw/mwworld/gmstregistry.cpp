@@ -0,0 +1,143 @@
+#include "gmstregistry.hpp"
+
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+namespace MWWorld
+{
+    // Must be in the same order as the enums
+    const char *const GmstRegistry::sFloatNames[Float_Count] =
+    {
+        "fAlarmRadius",
+        "fBlockStillBonus",
+        "fCombatAngleXY",
+        "fCombatAngleZ",
+        "fCombatBlockLeftAngle",
+        "fCombatBlockRightAngle",
+        "fCombatInvisoMult",
+        "fCombatKODamageMult",
+        "fDamageStrengthBase",
+        "fDamageStrengthMult",
+        "fEffectCostMult",
+        "fElementalShieldMult",
+        "fEndFatigueMult",
+        "fFallAcroBase",
+        "fFallAcroMult",
+        "fFallDamageDistanceMin",
+        "fFallDistanceBase",
+        "fFallDistanceMult",
+        "fFatigueAttackBase",
+        "fFatigueAttackMult",
+        "fFatigueBlockBase",
+        "fFatigueBlockMult",
+        "fFatigueJumpBase",
+        "fFatigueJumpMult",
+        "fFatigueReturnBase",
+        "fFatigueReturnMult",
+        "fFatigueRunBase",
+        "fFatigueRunMult",
+        "fFatigueSneakBase",
+        "fFatigueSneakMult",
+        "fFatigueSpellBase",
+        "fFatigueSpellMult",
+        "fFatigueSwimRunBase",
+        "fFatigueSwimRunMult",
+        "fFatigueSwimWalkBase",
+        "fFatigueSwimWalkMult",
+        "fHandtoHandHealthPer",
+        "fHoldBreathTime",
+        "fInteriorHeadTrackMult",
+        "fJumpMoveBase",
+        "fJumpMoveMult",
+        "fMagicSunBlockedMult",
+        "fMaxHandToHandMult",
+        "fMaxHeadTrackDistance",
+        "fMinHandToHandMult",
+        "fNPCbaseMagickaMult",
+        "fPCbaseMagickaMult",
+        "fProjectileThrownStoreChance",
+        "fRestMagicMult",
+        "fSneakUseDelay",
+        "fSneakUseDist",
+        "fSoulgemMult",
+        "fStromWalkMult",
+        "fSuffocationDamage",
+        "fSwimHeightScale",
+        "fSwingBlockBase",
+        "fSwingBlockMult",
+        "fWeaponDamageMult",
+        "fWeaponFatigueBlockMult",
+        "fWeaponFatigueMult",
+        "fWereWolfSilverWeaponDamageMult",
+    };
+
+    const char *const GmstRegistry::sIntNames[Int_Count] =
+    {
+        "iBlockMaxChance",
+        "iBlockMinChance",
+        "iCrimeThreshold",
+        "iCrimeThresholdMultiplier",
+    };
+
+    GmstRegistry::GmstRegistry(const Store<ESM::GameSetting> &store)
+        : mStore(&store)
+        , mGeneration(0)
+    {
+        // A missing name would leave a NULL entry at the end
+        assert(sFloatNames[Float_Count-1] != NULL);
+        assert(sIntNames[Int_Count-1] != NULL);
+    }
+
+    void GmstRegistry::setUp()
+    {
+        refresh();
+    }
+
+    void GmstRegistry::refresh() const
+    {
+        // A setting without a usable value is treated like a missing one, so the error is only raised when it is used
+        for (int i=0; i<Float_Count; ++i)
+        {
+            mFloatFound[i] = false;
+            mFloats[i] = 0.f;
+            if (const ESM::GameSetting *setting = mStore->search(sFloatNames[i]))
+            {
+                try
+                {
+                    mFloats[i] = setting->getFloat();
+                    mFloatFound[i] = true;
+                }
+                catch (std::exception&)
+                {
+                }
+            }
+        }
+
+        for (int i=0; i<Int_Count; ++i)
+        {
+            mIntFound[i] = false;
+            mInts[i] = 0;
+            if (const ESM::GameSetting *setting = mStore->search(sIntNames[i]))
+            {
+                try
+                {
+                    mInts[i] = setting->getInt();
+                    mIntFound[i] = true;
+                }
+                catch (std::exception&)
+                {
+                }
+            }
+        }
+
+        mGeneration = mStore->getGeneration();
+    }
+
+    void GmstRegistry::notFound(const char *name)
+    {
+        std::ostringstream msg;
+        msg << ESM::GameSetting::getRecordType() << " '" << name << "' not found";
+        throw std::runtime_error(msg.str());
+    }
+}
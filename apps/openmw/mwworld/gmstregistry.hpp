@@ -0,0 +1,147 @@
+#ifndef OPENMW_MWWORLD_GMSTREGISTRY_H
+#define OPENMW_MWWORLD_GMSTREGISTRY_H
+
+#include <components/esm/loadgmst.hpp>
+
+#include "store.hpp"
+
+namespace MWWorld
+{
+    /// @brief Game settings that are read by the mechanics every frame, resolved ahead of time.
+    /// @par Values are looked up by index instead of by name. They are read again from the store
+    /// whenever GameSetting records were added or removed.
+    class GmstRegistry
+    {
+    public:
+        enum Float
+        {
+            fAlarmRadius,
+            fBlockStillBonus,
+            fCombatAngleXY,
+            fCombatAngleZ,
+            fCombatBlockLeftAngle,
+            fCombatBlockRightAngle,
+            fCombatInvisoMult,
+            fCombatKODamageMult,
+            fDamageStrengthBase,
+            fDamageStrengthMult,
+            fEffectCostMult,
+            fElementalShieldMult,
+            fEndFatigueMult,
+            fFallAcroBase,
+            fFallAcroMult,
+            fFallDamageDistanceMin,
+            fFallDistanceBase,
+            fFallDistanceMult,
+            fFatigueAttackBase,
+            fFatigueAttackMult,
+            fFatigueBlockBase,
+            fFatigueBlockMult,
+            fFatigueJumpBase,
+            fFatigueJumpMult,
+            fFatigueReturnBase,
+            fFatigueReturnMult,
+            fFatigueRunBase,
+            fFatigueRunMult,
+            fFatigueSneakBase,
+            fFatigueSneakMult,
+            fFatigueSpellBase,
+            fFatigueSpellMult,
+            fFatigueSwimRunBase,
+            fFatigueSwimRunMult,
+            fFatigueSwimWalkBase,
+            fFatigueSwimWalkMult,
+            fHandtoHandHealthPer,
+            fHoldBreathTime,
+            fInteriorHeadTrackMult,
+            fJumpMoveBase,
+            fJumpMoveMult,
+            fMagicSunBlockedMult,
+            fMaxHandToHandMult,
+            fMaxHeadTrackDistance,
+            fMinHandToHandMult,
+            fNPCbaseMagickaMult,
+            fPCbaseMagickaMult,
+            fProjectileThrownStoreChance,
+            fRestMagicMult,
+            fSneakUseDelay,
+            fSneakUseDist,
+            fSoulgemMult,
+            fStromWalkMult,
+            fSuffocationDamage,
+            fSwimHeightScale,
+            fSwingBlockBase,
+            fSwingBlockMult,
+            fWeaponDamageMult,
+            fWeaponFatigueBlockMult,
+            fWeaponFatigueMult,
+            fWereWolfSilverWeaponDamageMult,
+
+            Float_Count
+        };
+
+        enum Int
+        {
+            iBlockMaxChance,
+            iBlockMinChance,
+            iCrimeThreshold,
+            iCrimeThresholdMultiplier,
+
+            Int_Count
+        };
+
+        GmstRegistry(const Store<ESM::GameSetting> &store);
+
+        /// Resolve all settings now, instead of on first use. Called by ESMStore::setUp().
+        void setUp();
+
+        /// Read the settings again now if GameSetting records were added or removed, instead of on the next use.
+        /// @note Call before reading the settings on several threads at once, the lazy update is not thread safe.
+        void update() const
+        {
+            if (mStore->getGeneration() != mGeneration)
+                refresh();
+        }
+
+        /// @note Throws an exception if the setting does not exist, like Store::find.
+        float getFloat(Float setting) const
+        {
+            if (mStore->getGeneration() != mGeneration)
+                refresh();
+            if (!mFloatFound[setting])
+                notFound(sFloatNames[setting]);
+            return mFloats[setting];
+        }
+
+        /// @note Throws an exception if the setting does not exist, like Store::find.
+        int getInt(Int setting) const
+        {
+            if (mStore->getGeneration() != mGeneration)
+                refresh();
+            if (!mIntFound[setting])
+                notFound(sIntNames[setting]);
+            return mInts[setting];
+        }
+
+        static const char *getName(Float setting) { return sFloatNames[setting]; }
+        static const char *getName(Int setting) { return sIntNames[setting]; }
+
+    private:
+        void refresh() const;
+
+        static void notFound(const char *name);
+
+        static const char *const sFloatNames[Float_Count];
+        static const char *const sIntNames[Int_Count];
+
+        const Store<ESM::GameSetting> *mStore;
+        mutable unsigned int mGeneration;
+
+        mutable float mFloats[Float_Count];
+        mutable bool mFloatFound[Float_Count];
+        mutable int mInts[Int_Count];
+        mutable bool mIntFound[Int_Count];
+    };
+}
+
+#endif
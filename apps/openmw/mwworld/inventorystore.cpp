@@ -166,6 +166,10 @@ void MWWorld::InventoryStore::equip (int slot, const ContainerStoreIterator& ite
     if (std::find (slots_.first.begin(), slots_.first.end(), slot)==slots_.first.end())
         throw std::runtime_error ("invalid slot");
 
+    // Notify once, after the new item is equipped
+    bool updatesEnabled = mUpdatesEnabled;
+    mUpdatesEnabled = false;
+
     if (mSlots[slot] != end())
         unequipSlot(slot, actor);
 
@@ -177,6 +181,8 @@ void MWWorld::InventoryStore::equip (int slot, const ContainerStoreIterator& ite
 
     mSlots[slot] = iterator;
 
+    mUpdatesEnabled = updatesEnabled;
+
     flagAsModified();
 
     fireEquipmentChangedEvent(actor);
@@ -186,14 +192,26 @@ void MWWorld::InventoryStore::equip (int slot, const ContainerStoreIterator& ite
 
 void MWWorld::InventoryStore::unequipAll(const MWWorld::Ptr& actor)
 {
+    bool updatesEnabled = mUpdatesEnabled;
     mUpdatesEnabled = false;
+
+    bool changed = false;
     for (int slot=0; slot < MWWorld::InventoryStore::Slots; ++slot)
-        unequipSlot(slot, actor);
+    {
+        if (mSlots[slot] != end())
+        {
+            unequipSlot(slot, actor);
+            changed = true;
+        }
+    }
 
-    mUpdatesEnabled = true;
+    mUpdatesEnabled = updatesEnabled;
 
-    fireEquipmentChangedEvent(actor);
-    updateMagicEffects(actor);
+    if (changed)
+    {
+        fireEquipmentChangedEvent(actor);
+        updateMagicEffects(actor);
+    }
 }
 
 MWWorld::ContainerStoreIterator MWWorld::InventoryStore::getSlot (int slot)
@@ -219,35 +237,49 @@ void MWWorld::InventoryStore::autoEquip (const MWWorld::Ptr& actor)
     TSlots slots_;
     initSlots (slots_);
 
+    // The skill and value of the item chosen for each slot so far
+    std::vector<int> slotSkills (slots_.size(), -1);
+    std::vector<int> slotValues (slots_.size(), 0);
+
+    // The skills of the actor, looked up on first use
+    std::map<int, int> actorSkills;
+
+    const std::string& actorId = actor.getCellRef().getRefId();
+    int equipAnyItem = -1; // not looked up yet
+
     // Disable model update during auto-equip
+    bool updatesEnabled = mUpdatesEnabled;
     mUpdatesEnabled = false;
 
-    for (ContainerStoreIterator iter (begin()); iter!=end(); ++iter)
+    // Only armor, clothing and weapons have slots other than the right hand.
+    // Lights are not auto equipped either, handled in Actors::updateEquippedLight based on environment light.
+    for (ContainerStoreIterator iter (begin (Type_Armor | Type_Clothing | Type_Weapon)); iter!=end(); ++iter)
     {
         Ptr test = *iter;
 
-        // Don't autoEquip lights. Handled in Actors::updateEquippedLight based on environment light.
-        if (test.getTypeName() == typeid(ESM::Light).name())
-        {
-            continue;
-        }
-
         // Only autoEquip if we are the original owner of the item.
         // This stops merchants from auto equipping anything you sell to them.
         // ...unless this is a companion, he should always equip items given to him.
-        if (!Misc::StringUtils::ciEqual(test.getCellRef().getOwner(), actor.getCellRef().getRefId()) &&
-                (actor.getClass().getScript(actor).empty() ||
-                !actor.getRefData().getLocals().getIntVar(actor.getClass().getScript(actor), "companion"))
-                && !actor.getClass().getCreatureStats(actor).isDead() // Corpses can be dressed up by the player as desired
-                )
+        if (!Misc::StringUtils::ciEqual(test.getCellRef().getOwner(), actorId))
         {
-            continue;
+            if (equipAnyItem == -1)
+            {
+                const std::string& script = actor.getClass().getScript(actor);
+                equipAnyItem = (!script.empty() && actor.getRefData().getLocals().getIntVar(script, "companion"))
+                        || actor.getClass().getCreatureStats(actor).isDead(); // Corpses can be dressed up by the player as desired
+            }
+
+            if (!equipAnyItem)
+                continue;
         }
-        int testSkill = test.getClass().getEquipmentSkill (test);
 
         std::pair<std::vector<int>, bool> itemsSlots =
             iter->getClass().getEquipmentSlots (*iter);
 
+        int testSkill = -2; // not looked up yet
+        int testValue = 0;
+        int canBeEquipped = -1;
+
         for (std::vector<int>::const_iterator iter2 (itemsSlots.first.begin());
             iter2!=itemsSlots.first.end(); ++iter2)
         {
@@ -255,43 +287,51 @@ void MWWorld::InventoryStore::autoEquip (const MWWorld::Ptr& actor)
                 // Equipping weapons is handled by AiCombat. Anything else (lockpicks, probes) can't be used by NPCs anyway (yet)
                 continue;
 
-            if (slots_.at (*iter2)!=end())
+            if (testSkill == -2)
             {
-                Ptr old = *slots_.at (*iter2);
+                testSkill = test.getClass().getEquipmentSkill (test);
+                testValue = test.getClass().getValue (test);
+            }
 
+            if (slots_.at (*iter2)!=end())
+            {
                 // check skill
-                int oldSkill = old.getClass().getEquipmentSkill (old);
+                int oldSkill = slotSkills[*iter2];
 
                 bool use = false;
                 if (testSkill!=-1 && oldSkill==-1)
                     use = true;
                 else if (testSkill!=-1 && oldSkill!=-1 && testSkill!=oldSkill)
                 {
-                    if (actor.getClass().getSkill(actor, oldSkill) > actor.getClass().getSkill (actor, testSkill))
+                    std::map<int, int>::iterator oldLevel = actorSkills.find (oldSkill);
+                    if (oldLevel == actorSkills.end())
+                        oldLevel = actorSkills.insert (std::make_pair (oldSkill, actor.getClass().getSkill(actor, oldSkill))).first;
+                    std::map<int, int>::iterator testLevel = actorSkills.find (testSkill);
+                    if (testLevel == actorSkills.end())
+                        testLevel = actorSkills.insert (std::make_pair (testSkill, actor.getClass().getSkill(actor, testSkill))).first;
+
+                    if (oldLevel->second > testLevel->second)
                         continue; // rejected, because old item better matched the NPC's skills.
 
-                    if (actor.getClass().getSkill(actor, oldSkill) < actor.getClass().getSkill (actor, testSkill))
+                    if (oldLevel->second < testLevel->second)
                         use = true;
                 }
 
                 if (!use)
                 {
                     // check value
-                    if (old.getClass().getValue (old)>=
-                        test.getClass().getValue (test))
+                    if (slotValues[*iter2] >= testValue)
                     {
                         continue;
                     }
                 }
             }
 
-            switch(test.getClass().canBeEquipped (test, actor).first)
-            {
-                case 0:
-                    continue;
-                default:
-                    break;
-            }
+            if (canBeEquipped == -1)
+                canBeEquipped = test.getClass().canBeEquipped (test, actor).first;
+
+            if (canBeEquipped == 0)
+                continue;
 
             if (!itemsSlots.second) // if itemsSlots.second is true, item can stay stacked when equipped
             {
@@ -303,6 +343,8 @@ void MWWorld::InventoryStore::autoEquip (const MWWorld::Ptr& actor)
             }
 
             slots_[*iter2] = iter;
+            slotSkills[*iter2] = testSkill;
+            slotValues[*iter2] = testValue;
             break;
         }
     }
@@ -317,7 +359,7 @@ void MWWorld::InventoryStore::autoEquip (const MWWorld::Ptr& actor)
             break;
         }
     }
-    mUpdatesEnabled = true;
+    mUpdatesEnabled = updatesEnabled;
 
     if (changed)
     {
@@ -485,6 +527,10 @@ int MWWorld::InventoryStore::remove(const Ptr& item, int count, const Ptr& actor
 {
     int retCount = ContainerStore::remove(item, count, actor);
 
+    // Notify once for the unequipped item and its replacement
+    bool updatesEnabled = mUpdatesEnabled;
+    mUpdatesEnabled = false;
+
     bool wasEquipped = false;
     if (!item.getRefData().getCount())
     {
@@ -512,6 +558,14 @@ int MWWorld::InventoryStore::remove(const Ptr& item, int count, const Ptr& actor
             autoEquip(actor);
     }
 
+    mUpdatesEnabled = updatesEnabled;
+
+    if (wasEquipped)
+    {
+        fireEquipmentChangedEvent(actor);
+        updateMagicEffects(actor);
+    }
+
     if (item.getRefData().getCount() == 0 && mSelectedEnchantItem != end()
             && *mSelectedEnchantItem == item)
     {
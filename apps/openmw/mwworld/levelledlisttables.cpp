@@ -0,0 +1,120 @@
+#include "levelledlisttables.hpp"
+
+#include <algorithm>
+
+#include <components/esm/loadlevlist.hpp>
+#include <components/misc/stringops.hpp>
+
+#include "esmstore.hpp"
+
+namespace
+{
+    struct LevelLess
+    {
+        bool operator()(const MWWorld::LevelledListTables::Entry& entry, int level) const
+        {
+            return entry.mLevel < level;
+        }
+
+        bool operator()(int level, const MWWorld::LevelledListTables::Entry& entry) const
+        {
+            return level < entry.mLevel;
+        }
+
+        bool operator()(const MWWorld::LevelledListTables::Entry& left, const MWWorld::LevelledListTables::Entry& right) const
+        {
+            return left.mLevel < right.mLevel;
+        }
+    };
+}
+
+namespace MWWorld
+{
+    std::pair<LevelledListTables::Table::iterator, LevelledListTables::Table::iterator>
+        LevelledListTables::Table::getCandidates(int level, bool allLevels) const
+    {
+        iterator end = std::upper_bound(mEntries.begin(), mEntries.end(), level, LevelLess());
+        if (allLevels || end == mEntries.begin())
+            return std::make_pair(mEntries.begin(), end);
+
+        iterator begin = std::lower_bound(mEntries.begin(), end, (end - 1)->mLevel, LevelLess());
+        return std::make_pair(begin, end);
+    }
+
+    LevelledListTables::LevelledListTables(const ESMStore& store)
+        : mStore(store)
+        , mItemListGeneration(0)
+        , mCreatureListGeneration(0)
+    {
+    }
+
+    void LevelledListTables::setUp()
+    {
+        mTables.clear();
+        checkGenerations();
+
+        const Store<ESM::ItemLevList>& itemLists = mStore.get<ESM::ItemLevList>();
+        for (Store<ESM::ItemLevList>::iterator it = itemLists.begin(); it != itemLists.end(); ++it)
+            build(*it, mTables[&*it]);
+
+        const Store<ESM::CreatureLevList>& creatureLists = mStore.get<ESM::CreatureLevList>();
+        for (Store<ESM::CreatureLevList>::iterator it = creatureLists.begin(); it != creatureLists.end(); ++it)
+            build(*it, mTables[&*it]);
+    }
+
+    const LevelledListTables::Table& LevelledListTables::get(const ESM::LevelledListBase& list) const
+    {
+        checkGenerations();
+
+        TableMap::iterator found = mTables.find(&list);
+        if (found != mTables.end())
+            return found->second;
+
+        Table& table = mTables[&list];
+        build(list, table);
+        return table;
+    }
+
+    void LevelledListTables::build(const ESM::LevelledListBase& list, Table& table) const
+    {
+        table.mEntries.clear();
+        table.mEntries.reserve(list.mList.size());
+        for (std::vector<ESM::LevelledListBase::LevelItem>::const_iterator it = list.mList.begin(); it != list.mList.end(); ++it)
+        {
+            Entry entry;
+            entry.mLevel = it->mLevel;
+            entry.mId = it->mId;
+            entry.mList = 0;
+            entry.mCreatureList = false;
+
+            const std::string id = Misc::StringUtils::lowerCase(it->mId);
+            const int type = mStore.find(id);
+            entry.mExists = type != 0;
+            if (type == ESM::REC_LEVI)
+                entry.mList = mStore.get<ESM::ItemLevList>().search(id);
+            else if (type == ESM::REC_LEVC)
+            {
+                entry.mList = mStore.get<ESM::CreatureLevList>().search(id);
+                entry.mCreatureList = true;
+            }
+
+            table.mEntries.push_back(entry);
+        }
+
+        std::stable_sort(table.mEntries.begin(), table.mEntries.end(), LevelLess());
+    }
+
+    void LevelledListTables::checkGenerations() const
+    {
+        // A replaced or removed list may have left a table behind at the address of its record, and the nested
+        // lists of the entries may have changed as well
+        const unsigned int itemListGeneration = mStore.get<ESM::ItemLevList>().getGeneration();
+        const unsigned int creatureListGeneration = mStore.get<ESM::CreatureLevList>().getGeneration();
+        if (itemListGeneration != mItemListGeneration || creatureListGeneration != mCreatureListGeneration)
+        {
+            mTables.clear();
+            mItemListGeneration = itemListGeneration;
+            mCreatureListGeneration = creatureListGeneration;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef OPENMW_MWWORLD_LEVELLEDLISTTABLES_H
+#define OPENMW_MWWORLD_LEVELLEDLISTTABLES_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ESM
+{
+    struct LevelledListBase;
+}
+
+namespace MWWorld
+{
+    class ESMStore;
+
+    /// @brief The entries of the levelled lists sorted by level, with the records they refer to looked up ahead of time.
+    /// @par Finding the entries of a list that can be picked at a level is a binary search instead of a scan of the
+    /// list. The tables of all lists are built when the store is set up, and built again on demand after a levelled
+    /// list was added, replaced or removed.
+    class LevelledListTables
+    {
+    public:
+        struct Entry
+        {
+            int mLevel;
+            std::string mId;
+            /// The nested list that the entry refers to, or 0 if it refers to any other record.
+            const ESM::LevelledListBase* mList;
+            bool mCreatureList;
+            /// False if there is no record with the ID.
+            bool mExists;
+        };
+
+        struct Table
+        {
+            typedef std::vector<Entry>::const_iterator iterator;
+
+            /// Sorted by level, in the order of the list within a level.
+            std::vector<Entry> mEntries;
+
+            /// The entries that can be picked at the given level.
+            /// @param allLevels Pick from all entries up to the level, instead of only those of the highest level.
+            std::pair<iterator, iterator> getCandidates(int level, bool allLevels) const;
+        };
+
+        LevelledListTables(const ESMStore& store);
+
+        /// Build the tables of all levelled lists in the store.
+        void setUp();
+
+        const Table& get(const ESM::LevelledListBase& list) const;
+
+    private:
+        void build(const ESM::LevelledListBase& list, Table& table) const;
+
+        /// Forget the tables if the stores of the levelled lists changed since they were built.
+        void checkGenerations() const;
+
+        const ESMStore& mStore;
+
+        typedef std::map<const ESM::LevelledListBase*, Table> TableMap;
+        mutable TableMap mTables;
+        mutable unsigned int mItemListGeneration;
+        mutable unsigned int mCreatureListGeneration;
+    };
+}
+
+#endif
@@ -6,7 +6,6 @@
 #include <components/esm/projectilestate.hpp>
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/scenemanager.hpp>
-#include <components/sceneutil/controller.hpp>
 #include <components/sceneutil/visitor.hpp>
 #include <components/sceneutil/lightmanager.hpp>
 
@@ -43,6 +42,7 @@ namespace MWWorld
         , mResourceSystem(resourceSystem)
         , mRendering(rendering)
         , mPhysics(physics)
+        , mModelPool(resourceSystem, 16)
     {
 
     }
@@ -92,24 +92,36 @@ namespace MWWorld
             attachTo = rotateNode;
         }
 
-        mResourceSystem->getSceneManager()->createInstance(model, attachTo);
+        state.mModel = model;
+        state.mInstance = mModelPool.acquire(model, std::string());
+        attachTo->addChild(state.mInstance.mNode);
 
-        SceneUtil::DisableFreezeOnCullVisitor disableFreezeOnCullVisitor;
-        state.mNode->accept(disableFreezeOnCullVisitor);
+        if (state.mInstance.mCreated)
+        {
+            SceneUtil::DisableFreezeOnCullVisitor disableFreezeOnCullVisitor;
+            state.mInstance.mNode->accept(disableFreezeOnCullVisitor);
+        }
 
         state.mNode->addCullCallback(new SceneUtil::LightListCallback);
 
         mParent->addChild(state.mNode);
+        mResourceSystem->getSceneManager()->notifyAttached(state.mInstance.mNode);
+    }
 
-        state.mEffectAnimationTime.reset(new MWRender::EffectAnimationTime);
+    void ProjectileManager::removeModel(State &state)
+    {
+        mParent->removeChild(state.mNode);
 
-        SceneUtil::AssignControllerSourcesVisitor assignVisitor (state.mEffectAnimationTime);
-        state.mNode->accept(assignVisitor);
+        osg::ref_ptr<osg::Node> node = state.mInstance.mNode;
+        while (node->getNumParents())
+            node->getParent(0)->removeChild(node);
+
+        mModelPool.release(state.mModel, std::string(), state.mInstance);
     }
 
     void ProjectileManager::update(State& state, float duration)
     {
-        state.mEffectAnimationTime->addTime(duration);
+        state.mInstance.mAnimTime->addTime(duration);
     }
 
     void ProjectileManager::launchMagicBolt(const std::string &model, const std::string &sound,
@@ -187,6 +199,8 @@ namespace MWWorld
 
     void ProjectileManager::moveMagicBolts(float duration)
     {
+        MWWorld::CellStore* playerCell = MWMechanics::getPlayer().getCell();
+
         for (std::vector<MagicBoltState>::iterator it = mMagicBolts.begin(); it != mMagicBolts.end();)
         {
             osg::Quat orient = it->mNode->getAttitude();
@@ -232,7 +246,7 @@ namespace MWWorld
             }
 
             // Explodes when hitting water
-            if (MWBase::Environment::get().getWorld()->isUnderwater(MWMechanics::getPlayer().getCell(), newPos))
+            if (MWBase::Environment::get().getWorld()->isUnderwater(playerCell, newPos))
                 hit = true;
 
             if (hit)
@@ -240,7 +254,7 @@ namespace MWWorld
                 MWBase::Environment::get().getWorld()->explodeSpell(pos, it->mEffects, caster, ESM::RT_Target, it->mSpellId, it->mSourceName);
 
                 MWBase::Environment::get().getSoundManager()->stopSound(it->mSound);
-                mParent->removeChild(it->mNode);
+                removeModel(*it);
 
                 it = mMagicBolts.erase(it);
                 continue;
@@ -252,6 +266,8 @@ namespace MWWorld
 
     void ProjectileManager::moveProjectiles(float duration)
     {
+        MWWorld::CellStore* playerCell = MWMechanics::getPlayer().getCell();
+
         for (std::vector<ProjectileState>::iterator it = mProjectiles.begin(); it != mProjectiles.end();)
         {
             // gravity constant - must be way lower than the gravity affecting actors, since we're not
@@ -274,7 +290,7 @@ namespace MWWorld
             // TODO: use a proper btRigidBody / btGhostObject?
             MWPhysics::PhysicsSystem::RayResult result = mPhysics->castRay(pos, newPos, caster, 0xff, MWPhysics::CollisionType_Projectile);
 
-            bool underwater = MWBase::Environment::get().getWorld()->isUnderwater(MWMechanics::getPlayer().getCell(), newPos);
+            bool underwater = MWBase::Environment::get().getWorld()->isUnderwater(playerCell, newPos);
             if (result.mHit || underwater)
             {
                 if (result.mHit)
@@ -300,7 +316,7 @@ namespace MWWorld
                 if (underwater)
                     mRendering->emitWaterRipple(newPos);
 
-                mParent->removeChild(it->mNode);
+                removeModel(*it);
                 it = mProjectiles.erase(it);
                 continue;
             }
@@ -313,12 +329,12 @@ namespace MWWorld
     {
         for (std::vector<ProjectileState>::iterator it = mProjectiles.begin(); it != mProjectiles.end(); ++it)
         {
-            mParent->removeChild(it->mNode);
+            removeModel(*it);
         }
         mProjectiles.clear();
         for (std::vector<MagicBoltState>::iterator it = mMagicBolts.begin(); it != mMagicBolts.end(); ++it)
         {
-            mParent->removeChild(it->mNode);
+            removeModel(*it);
             MWBase::Environment::get().getSoundManager()->stopSound(it->mSound);
         }
         mMagicBolts.clear();
@@ -10,6 +10,8 @@
 
 #include "../mwbase/soundmanager.hpp"
 
+#include "../mwrender/effectpool.hpp"
+
 #include "ptr.hpp"
 
 namespace MWPhysics
@@ -35,7 +37,6 @@ namespace Resource
 
 namespace MWRender
 {
-    class EffectAnimationTime;
     class RenderingManager;
 }
 
@@ -71,10 +72,14 @@ namespace MWWorld
         MWRender::RenderingManager* mRendering;
         MWPhysics::PhysicsSystem* mPhysics;
 
+        /// The model instances of finished projectiles, reused by the next projectiles with the same model
+        MWRender::EffectPool mModelPool;
+
         struct State
         {
             osg::ref_ptr<osg::PositionAttitudeTransform> mNode;
-            boost::shared_ptr<MWRender::EffectAnimationTime> mEffectAnimationTime;
+            MWRender::EffectPool::Instance mInstance;
+            std::string mModel;
 
             int mActorId;
 
@@ -121,6 +126,8 @@ namespace MWWorld
         void moveMagicBolts(float dt);
 
         void createModel (State& state, const std::string& model, const osg::Vec3f& pos, const osg::Quat& orient, bool rotate);
+        /// Detach the model of \a state, and keep its instance for the next projectile with that model.
+        void removeModel (State& state);
         void update (State& state, float duration);
 
         void operator=(const ProjectileManager&);
@@ -0,0 +1,156 @@
+#ifndef OPENMW_MWWORLD_RECORDINDEX_H
+#define OPENMW_MWWORLD_RECORDINDEX_H
+
+#include <string>
+#include <vector>
+
+#include <components/misc/stringops.hpp>
+
+namespace MWWorld
+{
+    /// @brief Open addressing hash index of records by their ID, compared case-insensitively.
+    /// @par Lookups neither allocate nor need the ID in lower case.
+    /// @note Only pointers are stored, so the records must stay at the same address, and keep
+    /// their ID, for as long as they are indexed.
+    template <class T>
+    class RecordIndex
+    {
+        struct Slot
+        {
+            size_t mHash;
+            /// NULL for an empty slot
+            T* mRecord;
+        };
+
+        std::vector<Slot> mSlots;
+        size_t mSize;
+
+        static size_t hash(const char* id, size_t length)
+        {
+            // FNV-1a
+            size_t hash = 2166136261u;
+            for (size_t i=0; i<length; ++i)
+            {
+                hash ^= static_cast<unsigned char>(Misc::StringUtils::toLower(id[i]));
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        static bool equal(const std::string& recordId, const char* id, size_t length)
+        {
+            if (recordId.size() != length)
+                return false;
+            for (size_t i=0; i<length; ++i)
+                if (Misc::StringUtils::toLower(recordId[i]) != Misc::StringUtils::toLower(id[i]))
+                    return false;
+            return true;
+        }
+
+        /// @return Slot of the given ID, or the empty slot to insert it into.
+        size_t findSlot(size_t hash, const char* id, size_t length) const
+        {
+            const size_t mask = mSlots.size() - 1;
+            size_t slot = hash & mask;
+            while (mSlots[slot].mRecord)
+            {
+                if (mSlots[slot].mHash == hash && equal(mSlots[slot].mRecord->mId, id, length))
+                    break;
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+
+        void rehash(size_t size)
+        {
+            std::vector<Slot> old;
+            old.swap(mSlots);
+
+            Slot empty;
+            empty.mHash = 0;
+            empty.mRecord = NULL;
+            mSlots.assign(size, empty);
+
+            const size_t mask = size - 1;
+            for (typename std::vector<Slot>::const_iterator it = old.begin(); it != old.end(); ++it)
+            {
+                if (!it->mRecord)
+                    continue;
+                size_t slot = it->mHash & mask;
+                while (mSlots[slot].mRecord)
+                    slot = (slot + 1) & mask;
+                mSlots[slot] = *it;
+            }
+        }
+
+    public:
+        RecordIndex()
+            : mSize(0)
+        {
+        }
+
+        T* search(const char* id, size_t length) const
+        {
+            if (mSize == 0)
+                return NULL;
+            return mSlots[findSlot(hash(id, length), id, length)].mRecord;
+        }
+
+        T* search(const std::string& id) const
+        {
+            return search(id.c_str(), id.size());
+        }
+
+        /// Add the given record, replacing a record with the same ID.
+        void insert(T* record)
+        {
+            // Keep the load factor at or below 1/2, so probe sequences stay short
+            if (2 * (mSize + 1) > mSlots.size())
+                rehash(mSlots.empty() ? 16 : 2 * mSlots.size());
+
+            const size_t recordHash = hash(record->mId.c_str(), record->mId.size());
+            Slot& slot = mSlots[findSlot(recordHash, record->mId.c_str(), record->mId.size())];
+            if (!slot.mRecord)
+                ++mSize;
+            slot.mHash = recordHash;
+            slot.mRecord = record;
+        }
+
+        void erase(const std::string& id)
+        {
+            if (mSize == 0)
+                return;
+
+            const size_t mask = mSlots.size() - 1;
+            size_t slot = findSlot(hash(id.c_str(), id.size()), id.c_str(), id.size());
+            if (!mSlots[slot].mRecord)
+                return;
+
+            // Move following entries of the probe sequence up, instead of leaving a tombstone
+            for (size_t next = (slot + 1) & mask; mSlots[next].mRecord; next = (next + 1) & mask)
+            {
+                const size_t home = mSlots[next].mHash & mask;
+                const bool reachable = (slot <= next) ? (slot < home && home <= next) : (slot < home || home <= next);
+                if (reachable)
+                    continue;
+                mSlots[slot] = mSlots[next];
+                slot = next;
+            }
+            mSlots[slot].mRecord = NULL;
+            --mSize;
+        }
+
+        void clear()
+        {
+            mSlots.clear();
+            mSize = 0;
+        }
+
+        size_t size() const
+        {
+            return mSize;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,45 @@
+#include "refidindex.hpp"
+
+#include "livecellref.hpp"
+
+namespace MWWorld
+{
+    void RefIdIndex::add (LiveCellRefBase* ref, CellStore* cell)
+    {
+        Entry entry;
+        entry.mRef = ref;
+        entry.mCell = cell;
+        mEntries[&ref->mRef.getInternedRefId().getRefIdString()].push_back (entry);
+    }
+
+    void RefIdIndex::remove (LiveCellRefBase* ref, CellStore* cell)
+    {
+        Map::iterator found = mEntries.find (&ref->mRef.getInternedRefId().getRefIdString());
+        if (found == mEntries.end())
+            return;
+
+        Entries& entries = found->second;
+        for (Entries::iterator it = entries.begin(); it != entries.end(); ++it)
+            if (it->mRef == ref && it->mCell == cell)
+            {
+                entries.erase (it);
+                break;
+            }
+
+        if (entries.empty())
+            mEntries.erase (found);
+    }
+
+    const RefIdIndex::Entries* RefIdIndex::find (const ESM::RefId& id) const
+    {
+        Map::const_iterator found = mEntries.find (&id.getRefIdString());
+        if (found == mEntries.end())
+            return NULL;
+        return &found->second;
+    }
+
+    void RefIdIndex::clear()
+    {
+        mEntries.clear();
+    }
+}
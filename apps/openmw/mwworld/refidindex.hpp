@@ -0,0 +1,57 @@
+#ifndef GAME_MWWORLD_REFIDINDEX_H
+#define GAME_MWWORLD_REFIDINDEX_H
+
+#include <string>
+#include <vector>
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include <boost/tr1/tr1/unordered_map>
+#elif defined HAVE_UNORDERED_MAP
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif
+
+#include <components/esm/refid.hpp>
+
+namespace MWWorld
+{
+    struct LiveCellRefBase;
+    class CellStore;
+
+    /// @brief The references of all loaded cells by their ID, so that a reference can be found without
+    /// searching each cell.
+    /// @note The cells keep the index up to date whenever the references they list change, see
+    /// CellStore::updateMergedRefs.
+    class RefIdIndex
+    {
+        public:
+
+            struct Entry
+            {
+                LiveCellRefBase* mRef;
+                CellStore* mCell;
+            };
+
+            typedef std::vector<Entry> Entries;
+
+            void add (LiveCellRefBase* ref, CellStore* cell);
+
+            void remove (LiveCellRefBase* ref, CellStore* cell);
+
+            /// @return The references with the given ID, the ones of each cell in the order the cell lists them,
+            /// or NULL if there are none.
+            const Entries* find (const ESM::RefId& id) const;
+
+            void clear();
+
+        private:
+
+            // By the interned ID, which is unique to each ID
+            typedef std::tr1::unordered_map<const std::string*, Entries> Map;
+
+            Map mEntries;
+    };
+}
+
+#endif
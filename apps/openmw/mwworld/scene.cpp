@@ -2,11 +2,19 @@
 
 #include <limits>
 #include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <typeinfo>
+
+#include <osg/Timer>
 
 #include <components/loadinglistener/loadinglistener.hpp>
 #include <components/misc/resourcehelpers.hpp>
+#include <components/misc/profiler.hpp>
 #include <components/settings/settings.hpp>
 #include <components/resource/resourcesystem.hpp>
+#include <components/terrain/world.hpp>
+#include <components/esmterrain/storage.hpp>
 
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
@@ -15,6 +23,7 @@
 #include "../mwbase/windowmanager.hpp"
 
 #include "../mwrender/renderingmanager.hpp"
+#include "../mwrender/objects.hpp"
 
 #include "../mwphysics/physicssystem.hpp"
 
@@ -24,19 +33,39 @@
 #include "class.hpp"
 #include "cellvisitors.hpp"
 #include "cellstore.hpp"
+#include "cellpreloader.hpp"
+#include "cellloadstats.hpp"
 
 namespace
 {
 
-    void addObject(const MWWorld::Ptr& ptr, MWPhysics::PhysicsSystem& physics,
-                   MWRender::RenderingManager& rendering)
+    // Distance from the center of the cell grid at which the grid is moved: 1/2 cell size + threshold
+    const float sCellGridChangeDistance = 8192/2 + 1024;
+
+    // Read by the preloading every frame
+    const Settings::Value<int> sHalfGridSize ("exterior cell load distance", "Cells");
+
+    std::string getModel(const MWWorld::Ptr& ptr, MWRender::RenderingManager& rendering)
     {
         std::string model = Misc::ResourceHelpers::correctActorModelPath(ptr.getClass().getModel(ptr), rendering.getResourceSystem()->getVFS());
         std::string id = ptr.getCellRef().getRefId();
         if (id == "prisonmarker" || id == "divinemarker" || id == "templemarker" || id == "northmarker")
             model = ""; // marker objects that have a hardcoded function in the game logic, should be hidden from the player
-        ptr.getClass().insertObjectRendering(ptr, model, rendering);
-        ptr.getClass().insertObject (ptr, model, physics);
+        return model;
+    }
+
+    void addObject(const MWWorld::Ptr& ptr, MWPhysics::PhysicsSystem& physics,
+                   MWRender::RenderingManager& rendering)
+    {
+        std::string model = getModel(ptr, rendering);
+        {
+            MWWorld::CellLoadStats::ScopedPhase phase (MWWorld::CellLoadStats::Phase_Rendering);
+            ptr.getClass().insertObjectRendering(ptr, model, rendering);
+        }
+        {
+            MWWorld::CellLoadStats::ScopedPhase phase (MWWorld::CellLoadStats::Phase_Physics);
+            ptr.getClass().insertObject (ptr, model, physics);
+        }
 
         if (ptr.getClass().isActor())
             rendering.addWaterRippleEmitter(ptr);
@@ -139,6 +168,62 @@ namespace
         }
     };
 
+    struct PendingObject
+    {
+        MWWorld::Ptr mPtr;
+        std::set<const MWWorld::LiveCellRefBase*>* mProcessed;
+        bool mRenderOnly;
+        // Objects the player and actors can stand on first, then actors, so they can be placed on the ground, then the rest,
+        // then the objects of render-only cells
+        int mGroup;
+        float mDistance2;
+
+        bool operator< (const PendingObject& other) const
+        {
+            if (mGroup != other.mGroup)
+                return mGroup < other.mGroup;
+            return mDistance2 < other.mDistance2;
+        }
+    };
+
+    struct ListPendingObjectsVisitor
+    {
+        std::set<const MWWorld::LiveCellRefBase*>& mProcessed;
+        bool mRenderOnly;
+        osg::Vec3f mPlayerPos;
+        std::vector<PendingObject>& mObjects;
+
+        ListPendingObjectsVisitor(std::set<const MWWorld::LiveCellRefBase*>& processed, bool renderOnly,
+                                  const osg::Vec3f& playerPos, std::vector<PendingObject>& objects)
+            : mProcessed(processed), mRenderOnly(renderOnly), mPlayerPos(playerPos), mObjects(objects)
+        {
+        }
+
+        bool operator() (const MWWorld::Ptr& ptr)
+        {
+            if (mProcessed.find(ptr.getBase()) != mProcessed.end())
+                return true;
+
+            PendingObject object;
+            object.mPtr = ptr;
+            object.mProcessed = &mProcessed;
+            object.mRenderOnly = mRenderOnly;
+            const std::string& type = ptr.getTypeName();
+            if (mRenderOnly)
+                object.mGroup = 3;
+            else if (ptr.getClass().isActor())
+                object.mGroup = 1;
+            else if (type == typeid(ESM::Static).name() || type == typeid(ESM::Door).name()
+                     || type == typeid(ESM::Activator).name() || type == typeid(ESM::Container).name())
+                object.mGroup = 0;
+            else
+                object.mGroup = 2;
+            object.mDistance2 = (ptr.getRefData().getPosition().asVec3() - mPlayerPos).length2();
+            mObjects.push_back(object);
+            return true;
+        }
+    };
+
 }
 
 
@@ -179,7 +264,17 @@ namespace MWWorld
 
     void Scene::update (float duration, bool paused)
     {
-        if (mNeedMapUpdate)
+        OPENMW_PROFILE_ZONE ("Scene::update");
+
+        insertPendingObjects(true);
+
+        // Wait for all objects of the active cells, so that they show on the map
+        bool activeCellsLoading = false;
+        for (LoadingCells::const_iterator it = mLoadingCells.begin(); it != mLoadingCells.end(); ++it)
+            if (!it->second.mRenderOnly)
+                activeCellsLoading = true;
+
+        if (mNeedMapUpdate && !activeCellsLoading)
         {
             // Note: exterior cell maps must be updated, even if they were visited before, because the set of surrounding cells might be different
             // (and objects in a different cell can "bleed" into another cells map if they cross the border)
@@ -200,11 +295,115 @@ namespace MWWorld
             }
         }
 
+        if (mPreloadEnabled && !paused)
+        {
+            preloadCells(duration);
+            if (mPreloadDoors)
+                preloadDoorDestinations();
+        }
+        mPreloader->update(duration);
+
         mRendering.update (duration, paused);
     }
 
+    void Scene::preloadCells(float duration)
+    {
+        OPENMW_PROFILE_ZONE ("Scene::preloadCells");
+
+        if (!mCurrentCell || !mCurrentCell->isExterior() || mActiveCells.empty())
+        {
+            mHasLastPlayerPos = false;
+            return;
+        }
+
+        MWBase::World* world = MWBase::Environment::get().getWorld();
+        const osg::Vec3f playerPos = world->getPlayerPtr().getRefData().getPosition().asVec3();
+        const osg::Vec3f moved = playerPos - mLastPlayerPos;
+        const bool hadLastPlayerPos = mHasLastPlayerPos;
+        mLastPlayerPos = playerPos;
+        mHasLastPlayerPos = true;
+
+        // Moving more than a cell in one frame is a teleport, which says nothing about where the player is heading
+        if (!hadLastPlayerPos || duration <= 0.f || moved.length() > ESM::Land::REAL_SIZE)
+            return;
+
+        const osg::Vec3f predictedPos = playerPos + moved * (mPredictionTime / duration);
+
+        int cellX, cellY;
+        getGridCenter(cellX, cellY);
+        float centerX, centerY;
+        world->indexToPosition(cellX, cellY, centerX, centerY, true);
+        float distance = std::max(std::abs(centerX-predictedPos.x()), std::abs(centerY-predictedPos.y()));
+        if (distance <= sCellGridChangeDistance)
+            return;
+
+        int newX, newY;
+        world->positionToIndex(predictedPos.x(), predictedPos.y(), newX, newY);
+
+        const int halfGridSize = sHalfGridSize.get();
+        for (int x=newX-halfGridSize; x<=newX+halfGridSize; ++x)
+        {
+            for (int y=newY-halfGridSize; y<=newY+halfGridSize; ++y)
+            {
+                CellStore* cell = world->getExterior(x, y);
+                if (!isCellActive(*cell))
+                    mPreloader->preload(cell);
+            }
+        }
+    }
+
+    void Scene::preloadDoorDestinations()
+    {
+        MWBase::World* world = MWBase::Environment::get().getWorld();
+        const osg::Vec3f playerPos = world->getPlayerPtr().getRefData().getPosition().asVec3();
+        const float maxDistance2 = world->getMaxActivationDistance() * world->getMaxActivationDistance();
+
+        for (CellStoreCollection::const_iterator active = mActiveCells.begin(); active != mActiveCells.end(); ++active)
+        {
+            const CellRefList<ESM::Door>& doors = (*active)->getReadOnlyDoors();
+            for (CellRefList<ESM::Door>::List::const_iterator door = doors.mList.begin(); door != doors.mList.end(); ++door)
+            {
+                if (!door->mRef.getTeleport() || door->mData.isDeleted() || !door->mData.isEnabled())
+                    continue;
+                if ((door->mData.getPosition().asVec3() - playerPos).length2() > maxDistance2)
+                    continue;
+
+                try
+                {
+                    const std::string destCell = door->mRef.getDestCell();
+                    if (!destCell.empty())
+                    {
+                        mPreloader->preload(world->getInterior(destCell));
+                        continue;
+                    }
+
+                    // The same cells as changeToExteriorCell loads
+                    const ESM::Position dest = door->mRef.getDoorDest();
+                    int cellX, cellY;
+                    world->positionToIndex(dest.pos[0], dest.pos[1], cellX, cellY);
+                    const int halfGridSize = sHalfGridSize.get();
+                    for (int x=cellX-halfGridSize; x<=cellX+halfGridSize; ++x)
+                    {
+                        for (int y=cellY-halfGridSize; y<=cellY+halfGridSize; ++y)
+                        {
+                            CellStore* cell = world->getExterior(x, y);
+                            if (!isCellActive(*cell))
+                                mPreloader->preload(cell);
+                        }
+                    }
+                }
+                catch (std::exception&)
+                {
+                    // The door leads nowhere. Reported when it is used.
+                }
+            }
+        }
+    }
+
     void Scene::unloadCell (CellStoreCollection::iterator iter)
     {
+        OPENMW_PROFILE_ZONE ("Scene::unloadCell");
+
         std::cout << "Unloading cell\n";
         ListAndResetObjectsVisitor visitor;
 
@@ -226,6 +425,8 @@ namespace MWWorld
                 mPhysics->removeHeightField ((*iter)->getCell()->getGridX(), (*iter)->getCell()->getGridY());
         }
 
+        mPhysics->removeNavigationCell(*iter);
+
         MWBase::Environment::get().getMechanicsManager()->drop (*iter);
 
         mRendering.removeCell(*iter);
@@ -234,15 +435,71 @@ namespace MWWorld
         MWBase::Environment::get().getWorld()->getLocalScripts().clearCell (*iter);
 
         MWBase::Environment::get().getSoundManager()->stopSound (*iter);
+        MWBase::Environment::get().getSoundManager()->unloadSounds (*iter);
+        mLoadingCells.erase(*iter);
         mActiveCells.erase(*iter);
+        ++mActiveCellsGeneration;
     }
 
-    void Scene::loadCell (CellStore *cell, Loading::Listener* loadingListener)
+    void Scene::unloadRenderOnlyCell (CellStoreCollection::iterator iter, bool unloadTerrain)
     {
+        CellStore* cell = *iter;
+
+        ListAndResetObjectsVisitor visitor;
+        cell->forEach<ListAndResetObjectsVisitor>(visitor);
+
+        mRendering.getObjects().removeCell(cell);
+        if (unloadTerrain)
+            mRendering.getTerrain()->unloadCell(cell->getCell()->getGridX(), cell->getCell()->getGridY());
+
+        mLoadingCells.erase(cell);
+        mRenderOnlyCells.erase(iter);
+    }
+
+    void Scene::loadRenderOnlyCell (CellStore *cell)
+    {
+        if (!mRenderOnlyCells.insert(cell).second)
+            return;
+
+        if (cell->getState() != CellStore::State_Loaded)
+            cell->load();
+
+        // Inserted once the models are in the resource caches, so the far cells never block a frame on loading
+        mPreloader->preload(cell);
+
+        LoadingCell loading;
+        loading.mRenderOnly = true;
+        mLoadingCells[cell] = loading;
+    }
+
+    void Scene::preloadBehindLoadingScreen(const std::vector<CellStore*>& cells, Loading::Listener* loadingListener)
+    {
+        OPENMW_PROFILE_ZONE ("Scene::preloadBehindLoadingScreen");
+
+        // The references are still read here, the ESM readers are not thread safe
+        for (std::vector<CellStore*>::const_iterator it = cells.begin(); it != cells.end(); ++it)
+            mPreloader->preload(*it);
+
+        for (std::vector<CellStore*>::const_iterator it = cells.begin(); it != cells.end();)
+        {
+            if (mPreloader->isPreloading(*it))
+                // Draws the loading screen, which also compiles the loaded objects on the GPU
+                loadingListener->idle();
+            else
+                ++it;
+        }
+    }
+
+    void Scene::loadCell (CellStore *cell, Loading::Listener* loadingListener, bool incremental)
+    {
+        OPENMW_PROFILE_ZONE ("Scene::loadCell");
+
         std::pair<CellStoreCollection::iterator, bool> result = mActiveCells.insert(cell);
 
         if(result.second)
         {
+            ++mActiveCellsGeneration;
+
             std::cout << "Loading cell " << cell->getCell()->getDescription() << std::endl;
 
             float verts = ESM::Land::LAND_SIZE;
@@ -251,29 +508,38 @@ namespace MWWorld
             // Load terrain physics first...
             if (cell->getCell()->isExterior())
             {
-                ESM::Land* land =
-                    MWBase::Environment::get().getWorld()->getStore().get<ESM::Land>().search(
-                        cell->getCell()->getGridX(),
-                        cell->getCell()->getGridY()
-                    );
-                if (land && land->mDataTypes&ESM::Land::DATA_VHGT) {
-                    // Actually only VHGT is needed here, but we'll need the rest for rendering anyway.
-                    // Load everything now to reduce IO overhead.
-                    const int flags = ESM::Land::DATA_VCLR|ESM::Land::DATA_VHGT|ESM::Land::DATA_VNML|ESM::Land::DATA_VTEX;
-
-                    const ESM::Land::LandData *data = land->getLandData (flags);
-                    mPhysics->addHeightField (data->mHeights, cell->getCell()->getGridX(), cell->getCell()->getGridY(),
-                        worldsize / (verts-1), verts);
-                }
+                // Shares the heights decoded for rendering
+                osg::ref_ptr<const ESMTerrain::LandObject> land = mRendering.getTerrainStorage()->getLandObject(
+                            cell->getCell()->getGridX(), cell->getCell()->getGridY());
+                CellLoadStats::ScopedPhase phase (CellLoadStats::Phase_Physics);
+                if (land && land->hasHeights())
+                    mPhysics->addHeightField (land->getHeights(), cell->getCell()->getGridX(), cell->getCell()->getGridY(),
+                        worldsize / (verts-1), verts, land.get());
             }
 
             cell->respawn();
 
+            MWBase::Environment::get().getSoundManager()->preloadSounds(cell);
+
             // ... then references. This is important for adjustPosition to work correctly.
             /// \todo rescale depending on the state of a new GMST
-            insertCell (*cell, true, loadingListener);
+            if (incremental)
+                mLoadingCells[cell] = LoadingCell();
+            else
+            {
+                insertCell (*cell, true, loadingListener);
+                {
+                    CellLoadStats::ScopedPhase phase (CellLoadStats::Phase_Rendering);
+                    mRendering.getObjects().mergeStatics(cell);
+                }
+                CellLoadStats::ScopedPhase phase (CellLoadStats::Phase_Physics);
+                mPhysics->addNavigationCell(cell);
+            }
 
-            mRendering.addCell(cell);
+            {
+                CellLoadStats::ScopedPhase phase (CellLoadStats::Phase_Rendering);
+                mRendering.addCell(cell);
+            }
             bool waterEnabled = cell->getCell()->hasWater() || cell->isExterior();
             float waterLevel = cell->getWaterLevel();
             mRendering.setWaterEnabled(waterEnabled);
@@ -300,7 +566,12 @@ namespace MWWorld
         while (active!=mActiveCells.end())
             unloadCell (active++);
         assert(mActiveCells.empty());
+        while (!mRenderOnlyCells.empty())
+            unloadRenderOnlyCell(mRenderOnlyCells.begin());
         mCurrentCell = NULL;
+
+        // The cells are about to be cleared
+        mPreloader->clear();
     }
 
     void Scene::playerMoved(const osg::Vec3f &pos)
@@ -313,20 +584,29 @@ namespace MWWorld
         getGridCenter(cellX, cellY);
         float centerX, centerY;
         MWBase::Environment::get().getWorld()->indexToPosition(cellX, cellY, centerX, centerY, true);
-        const float maxDistance = 8192/2 + 1024; // 1/2 cell size + threshold
         float distance = std::max(std::abs(centerX-pos.x()), std::abs(centerY-pos.y()));
-        if (distance > maxDistance)
+        if (distance > sCellGridChangeDistance)
         {
             int newX, newY;
             MWBase::Environment::get().getWorld()->positionToIndex(pos.x(), pos.y(), newX, newY);
-            changeCellGrid(newX, newY);
+            changeCellGrid(newX, newY, mIncrementalInsertion);
             //mRendering.updateTerrain();
         }
     }
 
-    void Scene::changeCellGrid (int X, int Y)
+    void Scene::changeCellGrid (int X, int Y, bool incremental)
     {
+        OPENMW_PROFILE_ZONE ("Scene::changeCellGrid");
+
+        std::ostringstream description;
+        description << "Changing to the cell grid around " << X << ", " << Y;
+        CellLoadStats stats (description.str(), mRendering.getResourceSystem(), mCellLoadLogThreshold);
+
         Loading::Listener* loadingListener = MWBase::Environment::get().getWindowManager()->getLoadingScreen();
+        // Does not show anything
+        Loading::Listener noLoadingScreen;
+        if (incremental)
+            loadingListener = &noLoadingScreen;
         Loading::ScopedLoad load(loadingListener);
 
         //mRendering.enableTerrain(true);
@@ -334,7 +614,8 @@ namespace MWWorld
         std::string loadingExteriorText = "#{sLoadingMessage3}";
         loadingListener->setLabel(loadingExteriorText);
 
-        const int halfGridSize = Settings::Manager::getInt("exterior cell load distance", "Cells");
+        const int halfGridSize = sHalfGridSize.get();
+        const int renderGridSize = std::max(halfGridSize, Settings::Manager::getInt("exterior cell render distance", "Cells"));
 
         CellStoreCollection::iterator active = mActiveCells.begin();
         while (active!=mActiveCells.end())
@@ -352,7 +633,22 @@ namespace MWWorld
             unloadCell (active++);
         }
 
+        CellStoreCollection::iterator renderOnly = mRenderOnlyCells.begin();
+        while (renderOnly!=mRenderOnlyCells.end())
+        {
+            int distance = std::max(std::abs(X-(*renderOnly)->getCell()->getGridX()),
+                                    std::abs(Y-(*renderOnly)->getCell()->getGridY()));
+            if (distance > renderGridSize)
+                unloadRenderOnlyCell (renderOnly++);
+            else if (distance <= halfGridSize)
+                // Loaded fully below, the terrain can stay
+                unloadRenderOnlyCell (renderOnly++, false);
+            else
+                ++renderOnly;
+        }
+
         int refsToLoad = 0;
+        std::vector<CellStore*> newCells;
         // get the number of refs to load
         for (int x=X-halfGridSize; x<=X+halfGridSize; ++x)
         {
@@ -372,12 +668,19 @@ namespace MWWorld
                 }
 
                 if (iter==mActiveCells.end())
-                    refsToLoad += MWBase::Environment::get().getWorld()->getExterior(x, y)->count();
+                {
+                    CellStore *cell = MWBase::Environment::get().getWorld()->getExterior(x, y);
+                    refsToLoad += cell->count();
+                    newCells.push_back(cell);
+                }
             }
         }
 
         loadingListener->setProgressRange(refsToLoad);
 
+        if (!incremental)
+            preloadBehindLoadingScreen(newCells, loadingListener);
+
         // Load cells
         for (int x=X-halfGridSize; x<=X+halfGridSize; ++x)
         {
@@ -400,11 +703,29 @@ namespace MWWorld
                 {
                     CellStore *cell = MWBase::Environment::get().getWorld()->getExterior(x, y);
 
-                    loadCell (cell, loadingListener);
+                    loadCell (cell, loadingListener, incremental);
                 }
             }
         }
 
+        // The ring around the grid is only rendered
+        for (int x=X-renderGridSize; x<=X+renderGridSize; ++x)
+        {
+            for (int y=Y-renderGridSize; y<=Y+renderGridSize; ++y)
+            {
+                if (std::max(std::abs(x-X), std::abs(y-Y)) > halfGridSize)
+                    loadRenderOnlyCell(MWBase::Environment::get().getWorld()->getExterior(x, y));
+            }
+        }
+
+        // Cells kept from the last grid may not be complete yet
+        if (!incremental)
+        {
+            insertPendingObjects(false);
+            // Behind the loading screen, so the terrain may as well be complete on the first frame
+            mRendering.getTerrain()->waitForLoadedCells();
+        }
+
         CellStore* current = MWBase::Environment::get().getWorld()->getExterior(X,Y);
         MWBase::Environment::get().getWindowManager()->changeCell(current);
 
@@ -449,8 +770,18 @@ namespace MWWorld
     }
 
     Scene::Scene (MWRender::RenderingManager& rendering, MWPhysics::PhysicsSystem *physics)
-    : mCurrentCell (0), mCellChanged (false), mPhysics(physics), mRendering(rendering), mNeedMapUpdate(false)
+    : mCurrentCell (0), mActiveCellsGeneration (0), mCellChanged (false), mPhysics(physics), mRendering(rendering), mNeedMapUpdate(false)
+    , mPreloadEnabled(Settings::Manager::getBool("preload enabled", "Cells"))
+    , mPreloadDoors(Settings::Manager::getBool("preload doors", "Cells"))
+    , mPredictionTime(Settings::Manager::getFloat("preload prediction time", "Cells"))
+    , mHasLastPlayerPos(false)
+    , mIncrementalInsertion(Settings::Manager::getBool("insert objects incrementally", "Cells"))
+    , mInsertionTimeBudget(Settings::Manager::getFloat("insertion time budget", "Cells"))
+    , mCellLoadLogThreshold(Settings::Manager::getFloat("cell load log threshold", "Cells") / 1000.0)
     {
+        mPreloader.reset(new CellPreloader(rendering.getResourceSystem(), physics->getShapeManager(), rendering.getTerrain()));
+        mPreloader->setWorkQueue(MWBase::Environment::get().getWorkQueue());
+        mPreloader->setExpiryDelay(Settings::Manager::getFloat("preload cell expiry delay", "Cells"));
     }
 
     Scene::~Scene()
@@ -467,8 +798,15 @@ namespace MWWorld
         return mActiveCells;
     }
 
+    unsigned int Scene::getActiveCellsGeneration() const
+    {
+        return mActiveCellsGeneration;
+    }
+
     void Scene::changeToInteriorCell (const std::string& cellName, const ESM::Position& position)
     {
+        CellLoadStats stats ("Changing to " + cellName, mRendering.getResourceSystem(), mCellLoadLogThreshold);
+
         CellStore *cell = MWBase::Environment::get().getWorld()->getInterior(cellName);
         bool loadcell = (mCurrentCell == NULL);
         if(!loadcell)
@@ -508,10 +846,14 @@ namespace MWWorld
             unloadCell (active++);
             ++current;
         }
+        while (!mRenderOnlyCells.empty())
+            unloadRenderOnlyCell(mRenderOnlyCells.begin());
 
         int refsToLoad = cell->count();
         loadingListener->setProgressRange(refsToLoad);
 
+        preloadBehindLoadingScreen(std::vector<CellStore*>(1, cell), loadingListener);
+
         // Load cell.
         loadCell (cell, loadingListener);
 
@@ -561,14 +903,117 @@ namespace MWWorld
 
     void Scene::insertCell (CellStore &cell, bool rescale, Loading::Listener* loadingListener)
     {
+        OPENMW_PROFILE_ZONE ("Scene::insertCell");
+
         InsertVisitor insertVisitor (cell, rescale, *loadingListener, *mPhysics, mRendering);
         cell.forEach (insertVisitor);
 
         // do adjustPosition (snapping actors to ground) after objects are loaded, so we don't depend on the loading order
+        CellLoadStats::ScopedPhase phase (CellLoadStats::Phase_Physics);
         AdjustPositionVisitor adjustPosVisitor;
         cell.forEach (adjustPosVisitor);
     }
 
+    void Scene::insertPendingObjects(bool timeSliced)
+    {
+        if (mLoadingCells.empty())
+            return;
+
+        osg::Timer_t start = osg::Timer::instance()->tick();
+
+        const osg::Vec3f playerPos = MWBase::Environment::get().getWorld()->getPlayerPtr().getRefData().getPosition().asVec3();
+
+        // Listed again every time, since scripts may have moved, enabled or added objects meanwhile
+        std::vector<PendingObject> objects;
+        // Render-only cells wait for their models to be preloaded
+        std::set<CellStore*> incomplete;
+        for (LoadingCells::iterator it = mLoadingCells.begin(); it != mLoadingCells.end(); ++it)
+        {
+            if (it->second.mRenderOnly)
+            {
+                if (mPreloader->isPreloading(it->first))
+                {
+                    incomplete.insert(it->first);
+                    continue;
+                }
+                if (!it->second.mTerrainLoaded)
+                {
+                    // Uses the preloaded terrain
+                    mRendering.getTerrain()->loadCell(it->first->getCell()->getGridX(), it->first->getCell()->getGridY());
+                    it->second.mTerrainLoaded = true;
+                }
+            }
+            ListPendingObjectsVisitor visitor (it->second.mProcessed, it->second.mRenderOnly, playerPos, objects);
+            it->first->forEach(visitor);
+        }
+        std::sort(objects.begin(), objects.end());
+
+        Loading::Listener noLoadingScreen;
+        AdjustPositionVisitor adjustPosVisitor;
+        std::vector<PendingObject>::const_iterator it = objects.begin();
+        for (; it != objects.end(); ++it)
+        {
+            if (timeSliced && it != objects.begin()
+                    && osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick()) > mInsertionTimeBudget)
+                break;
+
+            const Ptr& ptr = it->mPtr;
+            it->mProcessed->insert(ptr.getBase());
+
+            // Already added by a script
+            if (ptr.getRefData().getBaseNode())
+                continue;
+
+            if (it->mRenderOnly)
+            {
+                insertObjectRendering(ptr);
+                continue;
+            }
+
+            InsertVisitor insertVisitor (*ptr.getCell(), true, noLoadingScreen, *mPhysics, mRendering);
+            insertVisitor(ptr);
+            adjustPosVisitor(ptr);
+        }
+
+        // Cells without objects left are complete
+        for (; it != objects.end(); ++it)
+            incomplete.insert(it->mPtr.getCell());
+        for (LoadingCells::iterator cell = mLoadingCells.begin(); cell != mLoadingCells.end();)
+        {
+            if (incomplete.find(cell->first) == incomplete.end())
+            {
+                mRendering.getObjects().mergeStatics(cell->first);
+                if (!cell->second.mRenderOnly)
+                    mPhysics->addNavigationCell(cell->first);
+                mLoadingCells.erase(cell++);
+            }
+            else
+                ++cell;
+        }
+    }
+
+    void Scene::insertObjectRendering(const Ptr& ptr)
+    {
+        if (ptr.getCellRef().getScale()<0.5)
+            ptr.getCellRef().setScale(0.5);
+        else if (ptr.getCellRef().getScale()>2)
+            ptr.getCellRef().setScale(2);
+
+        // Actors are left out, they would stand still without the mechanics
+        if (ptr.getRefData().isDeleted() || !ptr.getRefData().isEnabled() || ptr.getClass().isActor())
+            return;
+
+        try
+        {
+            ptr.getClass().insertObjectRendering(ptr, getModel(ptr, mRendering), mRendering);
+            updateObjectRotation(ptr, false);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "error during rendering '" << ptr.getCellRef().getRefId() << "': " << e.what() << std::endl;
+        }
+    }
+
     void Scene::addObjectToScene (const Ptr& ptr)
     {
         try
@@ -593,8 +1038,21 @@ namespace MWWorld
             mRendering.removeWaterRippleEmitter(ptr);
     }
 
+    void Scene::getCellsInUse (std::set<const CellStore*>& cells) const
+    {
+        cells.insert (mActiveCells.begin(), mActiveCells.end());
+        cells.insert (mRenderOnlyCells.begin(), mRenderOnlyCells.end());
+        for (LoadingCells::const_iterator it = mLoadingCells.begin(); it != mLoadingCells.end(); ++it)
+            cells.insert (it->first);
+    }
+
     bool Scene::isCellActive(const CellStore &cell)
     {
+        // There is one CellStore per cell, so this is the common case. Comparing the cell IDs is
+        // expensive, isCellActive is called for every moving object and door each frame.
+        if (mActiveCells.find(const_cast<CellStore*>(&cell)) != mActiveCells.end())
+            return true;
+
         CellStoreCollection::iterator active = mActiveCells.begin();
         while (active != mActiveCells.end()) {
             if (**active == cell) {
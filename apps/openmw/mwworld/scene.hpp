@@ -7,11 +7,11 @@
 #include "globals.hpp"
 
 #include <set>
+#include <map>
+#include <vector>
+#include <memory>
 
-namespace osg
-{
-    class Vec3f;
-}
+#include <osg/Vec3f>
 
 namespace ESM
 {
@@ -43,6 +43,8 @@ namespace MWWorld
 {
     class Player;
     class CellStore;
+    class CellPreloader;
+    class LiveCellRefBase;
 
     class Scene
     {
@@ -54,19 +56,71 @@ namespace MWWorld
 
             CellStore* mCurrentCell; // the cell the player is in
             CellStoreCollection mActiveCells;
+            unsigned int mActiveCellsGeneration;
             bool mCellChanged;
             MWPhysics::PhysicsSystem *mPhysics;
             MWRender::RenderingManager& mRendering;
 
             bool mNeedMapUpdate;
 
+            std::auto_ptr<CellPreloader> mPreloader;
+            bool mPreloadEnabled;
+            bool mPreloadDoors;
+            float mPredictionTime;
+            osg::Vec3f mLastPlayerPos;
+            bool mHasLastPlayerPos;
+
+            // Exterior cells around the active grid that are only rendered, without physics or mechanics
+            CellStoreCollection mRenderOnlyCells;
+
+            struct LoadingCell
+            {
+                // The objects that were handled already
+                std::set<const LiveCellRefBase*> mProcessed;
+                bool mRenderOnly;
+                bool mTerrainLoaded;
+
+                LoadingCell() : mRenderOnly(false), mTerrainLoaded(false) {}
+            };
+            // Cells whose objects are inserted over several frames
+            typedef std::map<CellStore*, LoadingCell> LoadingCells;
+            LoadingCells mLoadingCells;
+            bool mIncrementalInsertion;
+            float mInsertionTimeBudget;
+            // In seconds
+            double mCellLoadLogThreshold;
+
             void insertCell (CellStore &cell, bool rescale, Loading::Listener* loadingListener);
 
+            /// Add the rendering of an object of a render-only cell. Actors are left out.
+            void insertObjectRendering(const Ptr& ptr);
+
+            /// Render the cell once its models are preloaded, without adding it to the active cells.
+            void loadRenderOnlyCell (CellStore *cell);
+
+            /// @param unloadTerrain Keep the terrain when the cell is about to become active.
+            void unloadRenderOnlyCell (CellStoreCollection::iterator iter, bool unloadTerrain = true);
+
+            /// Insert the objects of the loading cells, nearest and solid objects first.
+            /// @param timeSliced Stop once the insertion time budget is used up, otherwise insert all objects.
+            void insertPendingObjects(bool timeSliced);
+
             // Load and unload cells as necessary to create a cell grid with "X" and "Y" in the center
-            void changeCellGrid (int X, int Y);
+            /// @param incremental Insert the objects of new cells over the next frames, without a loading screen.
+            void changeCellGrid (int X, int Y, bool incremental = false);
 
             void getGridCenter(int& cellX, int& cellY);
 
+            /// Preload the cells of the grid the player would be in after moving on for the prediction time.
+            void preloadCells(float duration);
+
+            /// Preload the destinations of the teleport doors within activation distance of the player.
+            void preloadDoorDestinations();
+
+            /// Load the models and collision shapes of the cells on the work queue, and keep the loading screen
+            /// drawn until they are done, so that loading the cells afterwards only creates instances.
+            void preloadBehindLoadingScreen(const std::vector<CellStore*>& cells, Loading::Listener* loadingListener);
+
         public:
 
             Scene (MWRender::RenderingManager& rendering, MWPhysics::PhysicsSystem *physics);
@@ -75,7 +129,8 @@ namespace MWWorld
 
             void unloadCell (CellStoreCollection::iterator iter);
 
-            void loadCell (CellStore *cell, Loading::Listener* loadingListener);
+            /// @param incremental Leave inserting the objects of the cell to the next updates.
+            void loadCell (CellStore *cell, Loading::Listener* loadingListener, bool incremental = false);
 
             void playerMoved (const osg::Vec3f& pos);
 
@@ -85,6 +140,9 @@ namespace MWWorld
 
             const CellStoreCollection& getActiveCells () const;
 
+            /// Increased whenever a cell is added to or removed from the active cells.
+            unsigned int getActiveCellsGeneration() const;
+
             bool hasCellChanged() const;
             ///< Has the set of active cells changed, since the last frame?
 
@@ -112,6 +170,9 @@ namespace MWWorld
 
             bool isCellActive(const CellStore &cell);
 
+            /// Get the cells that are active, rendered or about to be rendered.
+            void getCellsInUse (std::set<const CellStore*>& cells) const;
+
             Ptr searchPtrViaActorId (int actorId);
     };
 }
@@ -6,6 +6,7 @@
 #include <components/loadinglistener/loadinglistener.hpp>
 #include <components/misc/rng.hpp>
 
+#include <memory>
 #include <stdexcept>
 #include <sstream>
 
@@ -29,6 +30,30 @@ namespace
         }
     };
 
+    /// Record header flags that are not kept by the record's save(), see Store::writeStatic
+    template<typename T>
+    uint32_t getRecordFlags(const T& record)
+    {
+        return 0;
+    }
+
+    uint32_t getRecordFlags(const ESM::NPC& record)
+    {
+        return record.mPersistent ? 0x0400 : 0;
+    }
+
+    uint32_t getRecordFlags(const ESM::Creature& record)
+    {
+        return record.mPersistent ? 0x0400 : 0;
+    }
+
+    template<typename T>
+    struct ParsedRecordT : public MWWorld::ParsedRecord
+    {
+        T mRecord;
+        bool mIsDeleted;
+    };
+
     struct Compare
     {
         bool operator()(const ESM::Land *x, const ESM::Land *y) {
@@ -108,13 +133,17 @@ namespace MWWorld
 
     template<typename T>
     Store<T>::Store()
+        : mGeneration(1)
     {
     }
 
     template<typename T>
     Store<T>::Store(const Store<T>& orig)
         : mStatic(orig.mStatic)
+        , mGeneration(1)
     {
+        for (typename Static::iterator it = mStatic.begin(); it != mStatic.end(); ++it)
+            mStaticIndex.insert(&it->second);
     }
 
     template<typename T>
@@ -124,32 +153,45 @@ namespace MWWorld
         assert(mShared.size() >= mStatic.size());
         mShared.erase(mShared.begin() + mStatic.size(), mShared.end());
         mDynamic.clear();
+        mDynamicIndex.clear();
+        ++mGeneration;
     }
 
     template<typename T>
     const T *Store<T>::search(const std::string &id) const
     {
-        T item;
-        item.mId = Misc::StringUtils::lowerCase(id);
-
-        typename Dynamic::const_iterator dit = mDynamic.find(item.mId);
-        if (dit != mDynamic.end()) {
-            return &dit->second;
-        }
-
-        typename std::map<std::string, T>::const_iterator it = mStatic.find(item.mId);
-
-        if (it != mStatic.end() && Misc::StringUtils::ciEqual(it->second.mId, id)) {
-            return &(it->second);
+        if (const T *record = mDynamicIndex.search(id))
+            return record;
+        return mStaticIndex.search(id);
+    }
+    template<typename T>
+    typename Store<T>::Handle Store<T>::resolve(const std::string &id) const
+    {
+        Handle handle;
+        handle.mId = Misc::StringUtils::lowerCase(id);
+        handle.mRecord = search(handle.mId);
+        handle.mGeneration = mGeneration;
+        return handle;
+    }
+    template<typename T>
+    const T *Store<T>::search(const Handle &handle) const
+    {
+        if (handle.mGeneration != mGeneration)
+        {
+            handle.mRecord = search(handle.mId);
+            handle.mGeneration = mGeneration;
         }
-
-        return 0;
+        return handle.mRecord;
+    }
+    template<typename T>
+    const T *Store<T>::search(const ESM::RefId &id) const
+    {
+        return search(id.getRefIdString());
     }
     template<typename T>
     bool Store<T>::isDynamic(const std::string &id) const
     {
-        typename Dynamic::const_iterator dit = mDynamic.find(id);
-        return (dit != mDynamic.end());
+        return mDynamicIndex.search(id) != NULL;
     }
     template<typename T>
     const T *Store<T>::searchRandom(const std::string &id) const
@@ -172,6 +214,22 @@ namespace MWWorld
         return ptr;
     }
     template<typename T>
+    const T *Store<T>::find(const Handle &handle) const
+    {
+        const T *ptr = search(handle);
+        if (ptr == 0) {
+            std::ostringstream msg;
+            msg << T::getRecordType() << " '" << handle.mId << "' not found";
+            throw std::runtime_error(msg.str());
+        }
+        return ptr;
+    }
+    template<typename T>
+    const T *Store<T>::find(const ESM::RefId &id) const
+    {
+        return find(id.getRefIdString());
+    }
+    template<typename T>
     const T *Store<T>::findRandom(const std::string &id) const
     {
         const T *ptr = searchRandom(id);
@@ -194,13 +252,51 @@ namespace MWWorld
 
         std::pair<typename Static::iterator, bool> inserted = mStatic.insert(std::make_pair(record.mId, record));
         if (inserted.second)
+        {
             mShared.push_back(&inserted.first->second);
+            mStaticIndex.insert(&inserted.first->second);
+            ++mGeneration;
+        }
         else
+        {
             inserted.first->second = record;
+            ++mGeneration;
+        }
 
         return RecordId(record.mId, isDeleted);
     }
     template<typename T>
+    ParsedRecord *Store<T>::parse(ESM::ESMReader &esm) const
+    {
+        std::auto_ptr<ParsedRecordT<T> > parsed(new ParsedRecordT<T>);
+        parsed->mIsDeleted = false;
+
+        parsed->mRecord.load(esm, parsed->mIsDeleted);
+        Misc::StringUtils::lowerCaseInPlace(parsed->mRecord.mId);
+
+        return parsed.release();
+    }
+    template<typename T>
+    RecordId Store<T>::insertParsed(ParsedRecord &record)
+    {
+        const ParsedRecordT<T>& parsed = static_cast<const ParsedRecordT<T>&>(record);
+
+        std::pair<typename Static::iterator, bool> inserted = mStatic.insert(std::make_pair(parsed.mRecord.mId, parsed.mRecord));
+        if (inserted.second)
+        {
+            mShared.push_back(&inserted.first->second);
+            mStaticIndex.insert(&inserted.first->second);
+            ++mGeneration;
+        }
+        else
+        {
+            inserted.first->second = parsed.mRecord;
+            ++mGeneration;
+        }
+
+        return RecordId(parsed.mRecord.mId, parsed.mIsDeleted);
+    }
+    template<typename T>
     void Store<T>::setUp()
     {
     }
@@ -245,8 +341,11 @@ namespace MWWorld
         T *ptr = &result.first->second;
         if (result.second) {
             mShared.push_back(ptr);
+            mDynamicIndex.insert(ptr);
+            ++mGeneration;
         } else {
             *ptr = item;
+            ++mGeneration;
         }
         return ptr;
     }
@@ -259,26 +358,31 @@ namespace MWWorld
         T *ptr = &result.first->second;
         if (result.second) {
             mShared.push_back(ptr);
+            mStaticIndex.insert(ptr);
+            ++mGeneration;
         } else {
             *ptr = item;
+            ++mGeneration;
         }
         return ptr;
     }
     template<typename T>
     bool Store<T>::eraseStatic(const std::string &id)
     {
-        T item;
-        item.mId = Misc::StringUtils::lowerCase(id);
+        std::string key = Misc::StringUtils::lowerCase(id);
 
-        typename std::map<std::string, T>::iterator it = mStatic.find(item.mId);
+        typename std::map<std::string, T>::iterator it = mStatic.find(key);
 
         if (it != mStatic.end() && Misc::StringUtils::ciEqual(it->second.mId, id)) {
+            mStaticIndex.erase(id);
+            ++mGeneration;
+
             // delete from the static part of mShared
             typename std::vector<T *>::iterator sharedIter = mShared.begin();
             typename std::vector<T *>::iterator end = sharedIter + mStatic.size();
 
             while (sharedIter != mShared.end() && sharedIter != end) {
-                if((*sharedIter)->mId == item.mId) {
+                if((*sharedIter)->mId == key) {
                     mShared.erase(sharedIter);
                     break;
                 }
@@ -298,7 +402,9 @@ namespace MWWorld
         if (it == mDynamic.end()) {
             return false;
         }
+        mDynamicIndex.erase(key);
         mDynamic.erase(it);
+        ++mGeneration;
 
         // have to reinit the whole shared part
         assert(mShared.size() >= mStatic.size());
@@ -314,6 +420,22 @@ namespace MWWorld
         return erase(item.mId);
     }
     template<typename T>
+    bool Store<T>::hasIndependentRecords() const
+    {
+        return true;
+    }
+    template<typename T>
+    void Store<T>::writeStatic(ESM::ESMWriter& writer) const
+    {
+        // The static records come first in mShared, in the order they were first loaded
+        for (typename std::vector<T *>::const_iterator it = mShared.begin(); it != mShared.begin() + mStatic.size(); ++it)
+        {
+            writer.startRecord (T::sRecordId, getRecordFlags(**it));
+            (*it)->save (writer);
+            writer.endRecord (T::sRecordId);
+        }
+    }
+    template<typename T>
     void Store<T>::write (ESM::ESMWriter& writer, Loading::Listener& progress) const
     {
         for (typename Dynamic::const_iterator iter (mDynamic.begin()); iter!=mDynamic.end();
@@ -1040,6 +1162,17 @@ namespace MWWorld
         }
     }
 
+    template <>
+    bool Store<ESM::Dialogue>::hasIndependentRecords() const {
+        return false;
+    }
+
+    template <>
+    ParsedRecord *Store<ESM::Dialogue>::parse(ESM::ESMReader &esm) const {
+        // Dialogues are merged with the ones loaded before, and the INFOs following them need to be added in order
+        return NULL;
+    }
+
     template <>
     inline RecordId Store<ESM::Dialogue>::load(ESM::ESMReader &esm) {
         // The original letter case of a dialogue ID is saved, because it's printed
@@ -1053,12 +1186,15 @@ namespace MWWorld
         if (found == mStatic.end())
         {
             dialogue.loadData(esm, isDeleted);
-            mStatic.insert(std::make_pair(idLower, dialogue));
+            std::pair<Static::iterator, bool> inserted = mStatic.insert(std::make_pair(idLower, dialogue));
+            mStaticIndex.insert(&inserted.first->second);
+            ++mGeneration;
         }
         else
         {
             found->second.loadData(esm, isDeleted);
             dialogue = found->second;
+            ++mGeneration;
         }
 
         return RecordId(dialogue.mId, isDeleted);
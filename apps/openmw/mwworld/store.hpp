@@ -5,7 +5,10 @@
 #include <vector>
 #include <map>
 
+#include <components/esm/refid.hpp>
+
 #include "recordcmp.hpp"
+#include "recordindex.hpp"
 
 namespace ESM
 {
@@ -27,6 +30,13 @@ namespace MWWorld
         RecordId(const std::string &id = "", bool isDeleted = false);
     };
 
+    /// @brief A record that was parsed ahead of time by StoreBase::parse, and is yet to be inserted into its store.
+    class ParsedRecord
+    {
+    public:
+        virtual ~ParsedRecord() {}
+    };
+
     class StoreBase
     {
     public:
@@ -41,6 +51,21 @@ namespace MWWorld
         virtual int getDynamicSize() const { return 0; }
         virtual RecordId load(ESM::ESMReader &esm) = 0;
 
+        /// Parse a record without modifying the store. Can be called concurrently, as long as each thread uses its own reader.
+        /// @return A record to be passed to insertParsed() later, or NULL if this store can only load() records in order.
+        virtual ParsedRecord* parse(ESM::ESMReader &esm) const { return NULL; }
+
+        /// Insert a record returned by parse(). Has the same effect as the load() call that was avoided.
+        virtual RecordId insertParsed(ParsedRecord &record) { return RecordId(); }
+
+        /// Do records of this store not depend on the records loaded before them? Only then can
+        /// the merged result of all content files be saved with writeStatic(), see ContentSnapshot.
+        virtual bool hasIndependentRecords() const { return false; }
+
+        /// Write the records loaded from content files, in their original order, so that
+        /// loading them with load() gives the same result.
+        virtual void writeStatic(ESM::ESMWriter& writer) const {}
+
         virtual bool eraseStatic(const std::string &id) {return false;}
         virtual void clearDynamic() {}
 
@@ -147,6 +172,13 @@ namespace MWWorld
         typedef std::map<std::string, T> Dynamic;
         typedef std::map<std::string, T> Static;
 
+        // The records are kept in the maps above, so their addresses stay valid. Lookups by ID go through these.
+        RecordIndex<T> mStaticIndex;
+        RecordIndex<T> mDynamicIndex;
+
+        /// Changed whenever a record is added, replaced or removed, see Handle
+        unsigned int mGeneration;
+
         friend class ESMStore;
 
     public:
@@ -155,12 +187,38 @@ namespace MWWorld
 
         typedef SharedIterator<T> iterator;
 
+        /// @brief A record ID that was resolved with resolve(), and can be looked up repeatedly at little cost.
+        /// @par The handle remembers the record it found, and only looks it up again after the store was
+        /// changed, so it stays valid when the record is removed or added later on.
+        class Handle
+        {
+            std::string mId;
+            mutable const T *mRecord;
+            mutable unsigned int mGeneration;
+
+            friend class Store<T>;
+
+        public:
+            Handle() : mRecord(NULL), mGeneration(0) {}
+
+            const std::string &getId() const { return mId; }
+        };
+
+        Handle resolve(const std::string &id) const;
+
+        /// Changes whenever a record is added, replaced or removed. Allows caching values taken from records.
+        unsigned int getGeneration() const { return mGeneration; }
+
         // setUp needs to be called again after
         virtual void clearDynamic();
         void setUp();
 
         const T *search(const std::string &id) const;
 
+        /// @return NULL if the record does not exist (anymore).
+        const T *search(const Handle &handle) const;
+        const T *search(const ESM::RefId &id) const;
+
         /**
          * Does the record with this ID come from the dynamic store?
          */
@@ -170,6 +228,8 @@ namespace MWWorld
         const T *searchRandom(const std::string &id) const;
 
         const T *find(const std::string &id) const;
+        const T *find(const Handle &handle) const;
+        const T *find(const ESM::RefId &id) const;
 
         /** Returns a random record that starts with the named ID. An exception is thrown if none
          * are found. */
@@ -192,6 +252,10 @@ namespace MWWorld
         bool erase(const T &item);
 
         RecordId load(ESM::ESMReader &esm);
+        ParsedRecord* parse(ESM::ESMReader &esm) const;
+        RecordId insertParsed(ParsedRecord &record);
+        bool hasIndependentRecords() const;
+        void writeStatic(ESM::ESMWriter& writer) const;
         void write(ESM::ESMWriter& writer, Loading::Listener& progress) const;
         RecordId read(ESM::ESMReader& reader);
     };
@@ -16,6 +16,7 @@
 #include <components/esm/cellid.hpp>
 
 #include <components/misc/rng.hpp>
+#include <components/misc/profiler.hpp>
 
 #include <components/files/collections.hpp>
 #include <components/misc/resourcehelpers.hpp>
@@ -92,6 +93,13 @@ namespace MWWorld
             return mLoaders.insert(std::make_pair(extension, loader)).second;
         }
 
+        void prepare(const boost::filesystem::path& filepath, int index)
+        {
+            LoadersContainer::iterator it(mLoaders.find(Misc::StringUtils::lowerCase(filepath.extension().string())));
+            if (it != mLoaders.end())
+                it->second->prepare(filepath, index);
+        }
+
         void load(const boost::filesystem::path& filepath, int& index)
         {
             LoadersContainer::iterator it(mLoaders.find(Misc::StringUtils::lowerCase(filepath.extension().string())));
@@ -153,15 +161,17 @@ namespace MWWorld
         const std::vector<std::string>& contentFiles,
         ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
         int activationDistanceOverride, const std::string& startCell, const std::string& startupScript,
-            const std::string& resourcePath)
+            const std::string& resourcePath, const boost::filesystem::path& contentSnapshot,
+            const boost::filesystem::path& navigationCache)
     : mResourceSystem(resourceSystem), mFallback(fallbackMap), mPlayer (0), mLocalScripts (mStore),
-      mSky (true), mCells (mStore, mEsm),
+      mSky (true), mCells (mStore, mEsm), mPtrCacheGeneration (0),
+      mMaxUnusedCells (std::max (0, Settings::Manager::getInt ("max unused cells", "Cells"))), mUnloadGeneration (0),
       mGodMode(false), mScriptsEnabled(true), mContentFiles (contentFiles),
       mActivationDistanceOverride (activationDistanceOverride), mStartupScript(startupScript),
       mStartCell (startCell), mTeleportEnabled(true),
       mLevitationEnabled(true), mGoToJail(false), mDaysInPrison(0)
     {
-        mPhysics = new MWPhysics::PhysicsSystem(resourceSystem, rootNode);
+        mPhysics = new MWPhysics::PhysicsSystem(resourceSystem, rootNode, navigationCache);
         mRendering = new MWRender::RenderingManager(viewer, rootNode, resourceSystem, &mFallback, resourcePath);
         mProjectileManager.reset(new ProjectileManager(mRendering->getLightRoot(), resourceSystem, mRendering, mPhysics));
 
@@ -178,8 +188,13 @@ namespace MWWorld
         gameContentLoader.addLoader(".omwaddon", &esmLoader);
         gameContentLoader.addLoader(".project", &esmLoader);
 
+        if (!contentSnapshot.empty())
+            esmLoader.setSnapshot(contentSnapshot);
+
         loadContentFiles(fileCollections, contentFiles, gameContentLoader);
 
+        esmLoader.saveSnapshot();
+
         listener->loadingOff();
 
         // insert records that may not be present in all versions of MW
@@ -310,6 +325,7 @@ namespace MWWorld
         }
 
         mCells.clear();
+        mPtrCache.clear();
 
         mDoorStates.clear();
 
@@ -637,22 +653,40 @@ namespace MWWorld
             return mPlayer->getPlayer();
         }
 
-        std::string lowerCaseName = Misc::StringUtils::lowerCase(name);
+        const ESM::RefId id (name);
+        const std::string& lowerCaseName = id.getRefIdString();
+
+        if (mPtrCacheGeneration != mWorldScene->getActiveCellsGeneration())
+        {
+            mPtrCache.clear();
+            mPtrCacheGeneration = mWorldScene->getActiveCellsGeneration();
+        }
+
+        PtrCache::iterator cached = mPtrCache.find (&lowerCaseName);
+        if (cached != mPtrCache.end())
+        {
+            const Ptr& ptr = cached->second;
+            if (CellStore::isAccessible (ptr.getRefData(), ptr.getCellRef()))
+                return ptr;
+            mPtrCache.erase (cached);
+        }
 
         for (Scene::CellStoreCollection::const_iterator iter (mWorldScene->getActiveCells().begin());
             iter!=mWorldScene->getActiveCells().end(); ++iter)
         {
-            // TODO: caching still doesn't work efficiently here (only works for the one CellStore that the reference is in)
             CellStore* cellstore = *iter;
-            Ptr ptr = mCells.getPtr (lowerCaseName, *cellstore, false);
+            Ptr ptr = mCells.getPtr (id, *cellstore, false);
 
             if (!ptr.isEmpty())
+            {
+                mPtrCache[&lowerCaseName] = ptr;
                 return ptr;
+            }
         }
 
         if (!activeOnly)
         {
-            ret = mCells.getPtr (lowerCaseName);
+            ret = mCells.getPtr (id);
             if (!ret.isEmpty())
                 return ret;
         }
@@ -1128,6 +1162,9 @@ namespace MWWorld
 
         if (currCell != newCell)
         {
+            // The cached Ptr would still refer to the old cell
+            mPtrCache.erase (&ESM::RefId (ptr.getCellRef().getRefId()).getRefIdString());
+
             removeContainerScripts(ptr);
 
             if (isPlayer)
@@ -1353,21 +1390,29 @@ namespace MWWorld
 
     void World::doPhysics(float duration)
     {
+        OPENMW_PROFILE_ZONE ("World::doPhysics");
+
         mPhysics->stepSimulation(duration);
         processDoors(duration);
 
         mProjectileManager->update(duration);
 
         const MWPhysics::PtrVelocityList &results = mPhysics->applyQueuedMovement(duration);
+        const MWWorld::Ptr playerPtr = getPlayerPtr();
         MWPhysics::PtrVelocityList::const_iterator player(results.end());
         for(MWPhysics::PtrVelocityList::const_iterator iter(results.begin());iter != results.end();++iter)
         {
-            if(iter->first == getPlayerPtr())
+            if(iter->first == playerPtr)
             {
                 // Handle player last, in case a cell transition occurs
                 player = iter;
                 continue;
             }
+
+            // Most actors are standing still, their scene nodes and collision objects are up to date
+            if (iter->first.getRefData().getPosition().asVec3() == iter->second)
+                continue;
+
             moveObjectImp(iter->first, iter->second.x(), iter->second.y(), iter->second.z());
         }
         if(player != results.end())
@@ -1376,6 +1421,21 @@ namespace MWWorld
         mPhysics->debugDraw();
     }
 
+    void World::startPhysicsAsync()
+    {
+        mPhysics->solveQueuedMovementAsync();
+    }
+
+    void World::finishPhysicsAsync()
+    {
+        mPhysics->waitForQueuedMovement();
+    }
+
+    void World::reportStats(unsigned int frameNumber, osg::Stats& stats) const
+    {
+        mPhysics->reportStats(frameNumber, stats);
+    }
+
     bool World::castRay (float x1, float y1, float z1, float x2, float y2, float z2)
     {
         osg::Vec3f a(x1,y1,z1);
@@ -1384,6 +1444,12 @@ namespace MWWorld
         return result.mHit;
     }
 
+    bool World::findNavigationPath(const CellStore *cell, const osg::Vec3f &start, const osg::Vec3f &end,
+                                   std::vector<osg::Vec3f> &path) const
+    {
+        return mPhysics->findNavigationPath(cell, start, end, path);
+    }
+
     void World::processDoors(float duration)
     {
         std::map<MWWorld::Ptr, int>::iterator it = mDoorStates.begin();
@@ -1538,6 +1604,8 @@ namespace MWWorld
 
     void World::update (float duration, bool paused)
     {
+        OPENMW_PROFILE_ZONE ("World::update");
+
         if (mGoToJail && !paused)
             goToJail();
 
@@ -1548,6 +1616,14 @@ namespace MWWorld
 
         mWorldScene->update (duration, paused);
 
+        if (mUnloadGeneration != mWorldScene->getActiveCellsGeneration())
+        {
+            mUnloadGeneration = mWorldScene->getActiveCellsGeneration();
+            std::set<const CellStore*> inUse;
+            mWorldScene->getCellsInUse (inUse);
+            mCells.unloadUnused (inUse, mMaxUnusedCells);
+        }
+
         updateWindowManager ();
 
         updateSoundListener();
@@ -2330,6 +2406,40 @@ namespace MWWorld
         return mPhysics->getLineOfSight(actor, targetActor);
     }
 
+    void World::getLOS(const MWWorld::ConstPtr& actor, const std::vector<MWWorld::ConstPtr>& targetActors,
+                       std::vector<bool>& results)
+    {
+        results.assign(targetActors.size(), false);
+        if (!actor.getRefData().isEnabled() || !actor.getRefData().getBaseNode())
+            return;
+
+        // cannot get LOS unless both NPC's are enabled and in an active cell
+        std::vector<MWWorld::ConstPtr> targets;
+        std::vector<size_t> indices;
+        for (size_t i=0; i<targetActors.size(); ++i)
+        {
+            if (!targetActors[i].getRefData().isEnabled() || !targetActors[i].getRefData().getBaseNode())
+                continue;
+            targets.push_back(targetActors[i]);
+            indices.push_back(i);
+        }
+
+        std::vector<bool> targetResults;
+        mPhysics->getLineOfSight(actor, targets, targetResults);
+        for (size_t i=0; i<targetResults.size(); ++i)
+            results[indices[i]] = targetResults[i];
+    }
+
+    void World::getActorsInRange(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out) const
+    {
+        mPhysics->getActorsInRange(position, radius, out);
+    }
+
+    bool World::hasActorCollisionShape(const MWWorld::ConstPtr& actor) const
+    {
+        return mPhysics->getActor(actor) != NULL;
+    }
+
     float World::getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist)
     {
         osg::Vec3f to (dir);
@@ -2479,6 +2589,7 @@ namespace MWWorld
     void World::loadContentFiles(const Files::Collections& fileCollections,
         const std::vector<std::string>& content, ContentLoader& contentLoader)
     {
+        std::vector<boost::filesystem::path> paths;
         std::vector<std::string>::const_iterator it(content.begin());
         std::vector<std::string>::const_iterator end(content.end());
         for (int idx = 0; it != end; ++it, ++idx)
@@ -2487,7 +2598,8 @@ namespace MWWorld
             const Files::MultiDirCollection& col = fileCollections.getCollection(filename.extension().string());
             if (col.doesExist(*it))
             {
-                contentLoader.load(col.getPath(*it), idx);
+                paths.push_back(col.getPath(*it));
+                contentLoader.prepare(paths.back(), idx);
             }
             else
             {
@@ -2496,6 +2608,9 @@ namespace MWWorld
                 throw std::runtime_error(msg.str());
             }
         }
+
+        for (int idx = 0; idx < static_cast<int>(paths.size()); ++idx)
+            contentLoader.load(paths[idx], idx);
     }
 
     bool World::startSpellCast(const Ptr &actor)
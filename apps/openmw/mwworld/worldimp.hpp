@@ -1,7 +1,10 @@
 #ifndef GAME_MWWORLD_WORLDIMP_H
 #define GAME_MWWORLD_WORLDIMP_H
 
+#include <map>
+
 #include <boost/shared_ptr.hpp>
+#include <boost/filesystem/path.hpp>
 
 #include <osg/ref_ptr>
 
@@ -94,6 +97,16 @@ namespace MWWorld
 
             Cells mCells;
 
+            // References found in the active cells by searchPtr, keyed by their interned ID. Cleared whenever the
+            // active cells change.
+            typedef std::map<const std::string*, Ptr> PtrCache;
+            PtrCache mPtrCache;
+            unsigned int mPtrCacheGeneration;
+
+            // Number of cells that are not in use to keep loaded, see Cells::unloadUnused
+            int mMaxUnusedCells;
+            unsigned int mUnloadGeneration;
+
             std::string mCurrentWorldSpace;
 
             boost::shared_ptr<ProjectileManager> mProjectileManager;
@@ -177,7 +190,8 @@ namespace MWWorld
                 const Files::Collections& fileCollections,
                 const std::vector<std::string>& contentFiles,
                 ToUTF8::Utf8Encoder* encoder, const std::map<std::string,std::string>& fallbackMap,
-                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath);
+                int activationDistanceOverride, const std::string& startCell, const std::string& startupScript, const std::string& resourcePath,
+                const boost::filesystem::path& contentSnapshot, const boost::filesystem::path& navigationCache);
 
             virtual ~World();
 
@@ -381,9 +395,24 @@ namespace MWWorld
             ///< Queues movement for \a ptr (in local space), to be applied in the next call to
             /// doPhysics.
 
+            virtual void startPhysicsAsync();
+            ///< With [Physics] "async movement", start solving the queued movement in the background, to be applied
+            /// by the next doPhysics. Call at the end of the frame, so that the solving overlaps with rendering.
+            /// Nothing may use the physics until finishPhysicsAsync.
+
+            virtual void finishPhysicsAsync();
+            ///< Wait for the movement started by startPhysicsAsync. Call at the start of the frame.
+
+            virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
+            ///< Set the counts of the physics work since the last call as attributes of the frame.
+
             virtual bool castRay (float x1, float y1, float z1, float x2, float y2, float z2);
             ///< cast a Ray and return true if there is an object in the ray path.
 
+            virtual bool findNavigationPath(const MWWorld::CellStore* cell, const osg::Vec3f& start, const osg::Vec3f& end,
+                                            std::vector<osg::Vec3f>& path) const;
+            ///< Find a path on the navigation grid of the cell, see MWPhysics::PhysicsSystem::findNavigationPath.
+
             virtual bool toggleCollisionMode();
             ///< Toggle collision mode for player. If disabled player object should ignore
             /// collisions and gravity.
@@ -521,6 +550,17 @@ namespace MWWorld
             virtual bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor);
             ///< get Line of Sight (morrowind stupid implementation)
 
+            virtual void getLOS(const MWWorld::ConstPtr& actor, const std::vector<MWWorld::ConstPtr>& targetActors,
+                                std::vector<bool>& results);
+            ///< get Line of Sight to each of the targets, in one batch of ray casts
+
+            virtual void getActorsInRange(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out) const;
+            ///< Add the actors with a collision shape within the radius of the position to \a out, sorted by MWWorld::Ptr.
+            /// Does not go through all actors, see MWPhysics::PhysicsSystem::getActorsInRange
+
+            virtual bool hasActorCollisionShape(const MWWorld::ConstPtr& actor) const;
+            ///< Can the actor be found with getActorsInRange?
+
             virtual float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist);
 
             virtual void enableActorCollision(const MWWorld::Ptr& actor, bool enable);
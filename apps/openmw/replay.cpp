@@ -0,0 +1,150 @@
+#include "replay.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <stdexcept>
+
+#include <boost/cstdint.hpp>
+
+#include <components/misc/rng.hpp>
+
+namespace
+{
+    const char sMagic[4] = { 'O', 'M', 'W', 'R' };
+    const boost::uint32_t sVersion = 1;
+
+    template <typename T>
+    void write (std::ostream& stream, const T& value)
+    {
+        stream.write (reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool read (std::istream& stream, T& value)
+    {
+        return static_cast<bool>(stream.read (reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+}
+
+namespace OMW
+{
+    Replay::Replay (const std::string& path, bool record)
+    : mRecording (record), mFrameTime (0), mNextCapture (0)
+    {
+        // SDL_Event is a plain union, written as it is. The size of it guards against replays of another build.
+        boost::uint32_t eventSize = sizeof(SDL_Event);
+        boost::uint32_t seed = 0;
+
+        if (mRecording)
+        {
+            mStream.open (path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!mStream.is_open())
+                throw std::runtime_error ("failed to open replay file for writing: " + path);
+
+            seed = static_cast<boost::uint32_t>(std::time(NULL));
+            mStream.write (sMagic, sizeof(sMagic));
+            write (mStream, sVersion);
+            write (mStream, eventSize);
+            write (mStream, seed);
+        }
+        else
+        {
+            mStream.open (path, std::ios::in | std::ios::binary);
+            if (!mStream.is_open())
+                throw std::runtime_error ("failed to open replay file: " + path);
+
+            char magic[sizeof(sMagic)];
+            boost::uint32_t version = 0;
+            boost::uint32_t fileEventSize = 0;
+            if (!mStream.read (magic, sizeof(magic)) || !std::equal (magic, magic + sizeof(magic), sMagic)
+                    || !read (mStream, version) || !read (mStream, fileEventSize) || !read (mStream, seed))
+                throw std::runtime_error ("not a replay file: " + path);
+            if (version != sVersion || fileEventSize != eventSize)
+                throw std::runtime_error ("replay file was recorded by an incompatible build: " + path);
+
+            if (!readFrame())
+                throw std::runtime_error ("replay file has no frames: " + path);
+        }
+
+        Misc::Rng::init (seed);
+    }
+
+    bool Replay::isRecording() const
+    {
+        return mRecording;
+    }
+
+    bool Replay::beginFrame (double& dt)
+    {
+        if (mRecording)
+        {
+            writeFrame();
+            mFrameTime = dt;
+            return true;
+        }
+
+        if (!readFrame())
+            return false;
+        dt = mFrameTime;
+        return true;
+    }
+
+    void Replay::finish()
+    {
+        if (!mRecording || !mStream.is_open())
+            return;
+
+        writeFrame();
+        mStream.close();
+    }
+
+    void Replay::captured (std::vector<SDL_Event>& events)
+    {
+        if (mRecording)
+        {
+            mCaptures.push_back (events);
+            return;
+        }
+
+        // A capture that was not recorded gets no events
+        if (mNextCapture < mCaptures.size())
+            events = mCaptures[mNextCapture++];
+        else
+            events.clear();
+    }
+
+    void Replay::writeFrame()
+    {
+        write (mStream, mFrameTime);
+        write (mStream, static_cast<boost::uint32_t>(mCaptures.size()));
+        for (std::vector<std::vector<SDL_Event> >::const_iterator it = mCaptures.begin(); it != mCaptures.end(); ++it)
+        {
+            write (mStream, static_cast<boost::uint32_t>(it->size()));
+            if (!it->empty())
+                mStream.write (reinterpret_cast<const char*>(&(*it)[0]), it->size() * sizeof(SDL_Event));
+        }
+        mCaptures.clear();
+    }
+
+    bool Replay::readFrame()
+    {
+        mCaptures.clear();
+        mNextCapture = 0;
+
+        boost::uint32_t numCaptures = 0;
+        if (!read (mStream, mFrameTime) || !read (mStream, numCaptures))
+            return false;
+
+        mCaptures.resize (numCaptures);
+        for (boost::uint32_t i=0; i<numCaptures; ++i)
+        {
+            boost::uint32_t numEvents = 0;
+            if (!read (mStream, numEvents))
+                return false;
+            mCaptures[i].resize (numEvents);
+            if (numEvents && !mStream.read (reinterpret_cast<char*>(&mCaptures[i][0]), numEvents * sizeof(SDL_Event)))
+                return false;
+        }
+        return true;
+    }
+}
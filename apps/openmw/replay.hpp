@@ -0,0 +1,59 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <components/sdlutil/events.hpp>
+
+namespace OMW
+{
+    /// \brief Records the input events, the frame times and the random seed of a session to a file, or replays them
+    ///
+    /// A replayed session gets the same input in the same frames, with the same frame times. The live input
+    /// is ignored meanwhile, except for closing the window. The game only plays out the same way as far as
+    /// it does not depend on timing, e.g. the AI update budget and the background loading still do.
+    ///
+    /// The file has a header with the seed of Misc::Rng, followed by the frames. Each frame has its time and
+    /// the events of every input capture during it; the first frame covers the startup, until the main loop.
+    class Replay : public SDLUtil::EventRecorder
+    {
+        public:
+
+            /// Start recording to the file at \a path, or replaying it. Seeds Misc::Rng, with a new seed when
+            /// recording and with the recorded seed when replaying.
+            /// @note Throws an exception if the file can not be opened, or is not a replay.
+            Replay (const std::string& path, bool record);
+
+            bool isRecording() const;
+
+            /// Start the next frame.
+            /// @param dt The frame time, which is recorded, or replaced by the recorded one.
+            /// @return Is there a frame to replay? Always true when recording.
+            bool beginFrame (double& dt);
+
+            /// Write the frame that is not written yet, when recording.
+            void finish();
+
+            virtual void captured (std::vector<SDL_Event>& events);
+
+        private:
+
+            bool mRecording;
+            boost::filesystem::fstream mStream;
+
+            // The frame that is being recorded or replayed
+            double mFrameTime;
+            std::vector<std::vector<SDL_Event> > mCaptures;
+            std::size_t mNextCapture;
+
+            void writeFrame();
+
+            /// @return Is there a frame left?
+            bool readFrame();
+    };
+}
+
+#endif
@@ -65,3 +65,40 @@ TEST_F(KeywordSearchTest, keyword_test_conflict_resolution3)
     ASSERT_TRUE (matches.size() == 1);
     ASSERT_TRUE (std::string(matches.front().mBeg, matches.front().mEnd) == "bar lock");
 }
+
+TEST_F(KeywordSearchTest, keyword_test_prefix_seeded_later)
+{
+    // a keyword that is the beginning of another one must be found regardless of the order of seeding
+    MWDialogue::KeywordSearch<std::string, int> search;
+    search.seed("dwemer ruins", 1);
+    search.seed("dwemer", 2);
+
+    std::string text = "ancient Dwemer artifacts";
+
+    std::vector<MWDialogue::KeywordSearch<std::string, int>::Match> matches;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+
+    ASSERT_TRUE (matches.size() == 1);
+    ASSERT_TRUE (std::string(matches.front().mBeg, matches.front().mEnd) == "Dwemer");
+    ASSERT_TRUE (matches.front().mValue == 2);
+
+    int value = 0;
+    ASSERT_TRUE (search.containsKeyword("DWEMER", value));
+    ASSERT_TRUE (value == 2);
+    ASSERT_FALSE (search.containsKeyword("dwem", value));
+}
+
+TEST_F(KeywordSearchTest, keyword_test_end_of_text)
+{
+    MWDialogue::KeywordSearch<std::string, int> search;
+    search.seed("a", 0);
+    search.seed("ab", 1);
+
+    std::string text = "x a";
+
+    std::vector<MWDialogue::KeywordSearch<std::string, int>::Match> matches;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+
+    ASSERT_TRUE (matches.size() == 1);
+    ASSERT_TRUE (std::string(matches.front().mBeg, matches.front().mEnd) == "a");
+}
@@ -313,3 +313,155 @@ TEST_F(StoreTest, overwrite_test)
 
     ASSERT_TRUE (overwrittenRec && overwrittenRec->mModel == "the_new_model");
 }
+
+/// Tests lookups through resolved handles, which need to follow records being deleted and inserted again.
+TEST_F(StoreTest, handle_test)
+{
+    const std::string recordId = "foobar";
+
+    typedef ESM::Apparatus RecordType;
+
+    RecordType record;
+    record.blank();
+    record.mId = recordId;
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    const MWWorld::Store<RecordType>& store = mEsmStore.get<RecordType>();
+
+    // resolving an ID that does not exist yet
+    MWWorld::Store<RecordType>::Handle handle = store.resolve("FooBar");
+    ASSERT_TRUE (store.search(handle) == NULL);
+
+    Files::IStreamPtr file = getEsmFile(record, false);
+    reader.open(file, "filename");
+    mEsmStore.load(reader, &dummyListener);
+    mEsmStore.setUp();
+
+    ASSERT_TRUE (store.search(handle) != NULL);
+    ASSERT_TRUE (store.search(handle) == store.search("FOOBAR"));
+
+    // interned IDs compare case-insensitively, and find the same record
+    ASSERT_TRUE (ESM::RefId("FooBar") == ESM::RefId(recordId));
+    ASSERT_TRUE (ESM::RefId("FooBar").getRefIdString() == recordId);
+    ASSERT_TRUE (store.search(ESM::RefId("FOOBAR")) == store.search(handle));
+
+    // a plugin deletes it
+    file = getEsmFile(record, true);
+    reader.open(file, "filename");
+    mEsmStore.load(reader, &dummyListener);
+    mEsmStore.setUp();
+
+    ASSERT_TRUE (store.search(handle) == NULL);
+    ASSERT_TRUE (store.search(recordId) == NULL);
+
+    // and another plugin inserts it again
+    file = getEsmFile(record, false);
+    reader.open(file, "filename");
+    mEsmStore.load(reader, &dummyListener);
+    mEsmStore.setUp();
+
+    ASSERT_TRUE (store.search(handle) != NULL);
+    ASSERT_TRUE (store.find(handle)->mId == recordId);
+}
+
+/// Tests that the GMST registry picks up settings changed by later content files.
+TEST_F(StoreTest, gmst_registry_test)
+{
+    ESM::GameSetting setting;
+    setting.blank();
+    setting.mId = MWWorld::GmstRegistry::getName(MWWorld::GmstRegistry::fJumpMoveBase);
+    setting.mValue.setType(ESM::VT_Float);
+    setting.mValue.setFloat(0.5f);
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    const MWWorld::GmstRegistry& gmsts = mEsmStore.getGmsts();
+
+    ASSERT_THROW (gmsts.getFloat(MWWorld::GmstRegistry::fJumpMoveBase), std::runtime_error);
+
+    Files::IStreamPtr file = getEsmFile(setting, false);
+    reader.open(file, "filename");
+    mEsmStore.load(reader, &dummyListener);
+    mEsmStore.setUp();
+
+    ASSERT_EQ (0.5f, gmsts.getFloat(MWWorld::GmstRegistry::fJumpMoveBase));
+
+    // a plugin changes the value
+    setting.mValue.setFloat(0.75f);
+    file = getEsmFile(setting, false);
+    reader.open(file, "filename");
+    mEsmStore.load(reader, &dummyListener);
+
+    ASSERT_EQ (0.75f, gmsts.getFloat(MWWorld::GmstRegistry::fJumpMoveBase));
+}
+
+/// Tests picking the entries of levelled lists by level, and that the tables follow lists changed by later content files.
+TEST_F(StoreTest, levelled_list_tables_test)
+{
+    ESM::Apparatus apparatus;
+    apparatus.blank();
+    apparatus.mId = "foobar";
+
+    ESM::ItemLevList list;
+    list.blank();
+    list.mId = "list";
+    ESM::LevelledListBase::LevelItem item;
+    item.mId = "foobar";
+    item.mLevel = 5;
+    list.mList.push_back(item);
+    item.mLevel = 1;
+    list.mList.push_back(item);
+    item.mId = "missing";
+    item.mLevel = 3;
+    list.mList.push_back(item);
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    Files::IStreamPtr file = getEsmFile(apparatus, false);
+    reader.open(file, "filename");
+    mEsmStore.load(reader, &dummyListener);
+    file = getEsmFile(list, false);
+    reader.open(file, "filename");
+    mEsmStore.load(reader, &dummyListener);
+    mEsmStore.setUp();
+
+    typedef MWWorld::LevelledListTables::Table Table;
+    const Table& table = mEsmStore.getLevelledLists().get(*mEsmStore.get<ESM::ItemLevList>().find("list"));
+    std::pair<Table::iterator, Table::iterator> candidates = table.getCandidates(0, true);
+    ASSERT_TRUE (candidates.first == candidates.second);
+
+    // only the entries of the highest level up to the given one
+    candidates = table.getCandidates(4, false);
+    ASSERT_EQ (1, candidates.second - candidates.first);
+    ASSERT_EQ ("missing", candidates.first->mId);
+    ASSERT_FALSE (candidates.first->mExists);
+
+    // all entries up to the given level, sorted by level
+    candidates = table.getCandidates(10, true);
+    ASSERT_EQ (3, candidates.second - candidates.first);
+    ASSERT_EQ (1, candidates.first->mLevel);
+    ASSERT_TRUE (candidates.first->mExists);
+    ASSERT_TRUE (candidates.first->mList == NULL);
+    ASSERT_EQ (5, (candidates.second - 1)->mLevel);
+
+    // a plugin changes the list
+    list.mList.resize(1);
+    file = getEsmFile(list, false);
+    reader.open(file, "filename");
+    mEsmStore.load(reader, &dummyListener);
+
+    const Table& changedTable = mEsmStore.getLevelledLists().get(*mEsmStore.get<ESM::ItemLevList>().find("list"));
+    candidates = changedTable.getCandidates(10, true);
+    ASSERT_EQ (1, candidates.second - candidates.first);
+    ASSERT_EQ (5, candidates.first->mLevel);
+}
@@ -535,9 +535,6 @@ bool Wizard::UnshieldWorker::installComponent(Component component, const QString
     QString tempPath(getPath() + QDir::separator() + QLatin1String("extract-temp"));
     QDir temp;
 
-    // Make sure the temporary folder is empty
-    removeDirectory(tempPath);
-
     if (!temp.mkpath(tempPath)) {
         emit error(tr("Cannot create temporary directory!"), tr("Failed to create %1.").arg(tempPath));
         return false;
@@ -545,7 +542,19 @@ bool Wizard::UnshieldWorker::installComponent(Component component, const QString
 
     temp.setPath(tempPath);
 
-    if (!temp.mkdir(name)) {
+    // Resume an interrupted extraction of the same cabinet, otherwise make sure the folder is empty
+    QString manifestPath(temp.absoluteFilePath(name + QLatin1String(".manifest")));
+
+    if (!openManifest(manifestPath, info.absoluteFilePath())) {
+        removeDirectory(temp.absoluteFilePath(name));
+
+        if (!mManifest.isOpen()) {
+            emit error(tr("Cannot create temporary file!"), tr("Failed to create %1.").arg(manifestPath));
+            return false;
+        }
+    }
+
+    if (!temp.exists(name) && !temp.mkdir(name)) {
         emit error(tr("Cannot create temporary directory!"), tr("Failed to create %1.").arg(temp.absoluteFilePath(name)));
         return false;
     }
@@ -556,7 +565,12 @@ bool Wizard::UnshieldWorker::installComponent(Component component, const QString
     }
 
     // Extract the installation files
-    if (!extractCab(info.absoluteFilePath(), temp.absolutePath()))
+    bool success = extractCab(info.absoluteFilePath(), temp.absolutePath());
+
+    mManifest.close();
+    mExtractedFiles.clear();
+
+    if (!success)
         return false;
 
     // Move the files from the temporary path to the destination folder
@@ -716,6 +730,63 @@ bool Wizard::UnshieldWorker::installComponent(Component component, const QString
 
 }
 
+bool Wizard::UnshieldWorker::openManifest(const QString &manifestPath, const QString &cabFile)
+{
+    // The first line names the cabinet and its size, every other line the index and size of a file
+    // that was extracted completely. Returns true when the extraction can be resumed, otherwise the
+    // manifest is started anew.
+    QFileInfo cabInfo(cabFile);
+    QString header(cabInfo.absoluteFilePath() + QLatin1Char('\t') + QString::number(cabInfo.size()));
+
+    mExtractedFiles.clear();
+    mManifest.close();
+    mManifest.setFileName(manifestPath);
+
+    if (mManifest.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&mManifest);
+        stream.setCodec(QTextCodec::codecForName("UTF-8"));
+
+        if (stream.readLine() == header) {
+            while (!stream.atEnd()) {
+                QStringList entry(stream.readLine().split(QLatin1Char(' ')));
+
+                if (entry.size() == 2)
+                    mExtractedFiles.insert(entry.at(0).toInt(), entry.at(1).toLongLong());
+            }
+        }
+
+        mManifest.close();
+    }
+
+    bool resume = !mExtractedFiles.isEmpty();
+
+    if (resume) {
+        if (mManifest.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+            return true;
+
+        mExtractedFiles.clear();
+    }
+
+    if (!mManifest.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    mManifest.write(header.toUtf8() + '\n');
+    mManifest.flush();
+    return false;
+}
+
+bool Wizard::UnshieldWorker::isExtracted(Unshield *unshield, const QString &fileName, int index)
+{
+    // A file that was moved out of the temporary folder, or only partly written, is extracted again
+    QHash<int, qint64>::const_iterator it = mExtractedFiles.constFind(index);
+
+    if (it == mExtractedFiles.constEnd())
+        return false;
+
+    qint64 size = static_cast<qint64>(unshield_file_size(unshield, index));
+    return it.value() == size && QFileInfo(fileName).size() == size;
+}
+
 bool Wizard::UnshieldWorker::extractFile(Unshield *unshield, const QString &destination, const QString &prefix, int index, int counter)
 {
     bool success = false;
@@ -754,14 +825,25 @@ bool Wizard::UnshieldWorker::extractFile(Unshield *unshield, const QString &dest
     emit textChanged(tr("Extracting: %1").arg(QString::fromUtf8(unshield_file_name(unshield, index))));
     emit progressChanged(progress);
 
+    if (isExtracted(unshield, fileName, index))
+        return true;
+
+    // libunshield compares the MD5 checksum of the cabinet with the saved data, the size is checked
+    // in case the disk ran full
     QByteArray array(fileName.toUtf8());
-    success = unshield_file_save(unshield, index, array.constData());
+    qint64 size = static_cast<qint64>(unshield_file_size(unshield, index));
+    success = unshield_file_save(unshield, index, array.constData())
+            && QFileInfo(fileName).size() == size;
 
     if (!success) {
         qDebug() << "error";
         dir.remove(fileName);
+        return success;
     }
 
+    mManifest.write(QByteArray::number(index) + ' ' + QByteArray::number(size) + '\n');
+    mManifest.flush();
+
     return success;
 }
 
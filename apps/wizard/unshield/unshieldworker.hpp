@@ -7,6 +7,8 @@
 #include <QWaitCondition>
 #include <QReadWriteLock>
 #include <QStringList>
+#include <QFile>
+#include <QHash>
 
 #include <libunshield.h>
 
@@ -61,6 +63,9 @@ namespace Wizard
         bool copyFile(const QString &source, const QString &destination, bool keepSource = true);
         bool copyDirectory(const QString &source, const QString &destination, bool keepSource = true);
 
+        bool openManifest(const QString &manifestPath, const QString &cabFile);
+        bool isExtracted(Unshield *unshield, const QString &fileName, int index);
+
         bool extractCab(const QString &cabFile, const QString &destination);
         bool extractFile(Unshield *unshield, const QString &destination, const QString &prefix, int index, int counter);
 
@@ -103,6 +108,10 @@ namespace Wizard
 
         QTextCodec *mIniCodec;
 
+        // The files of the current cabinet that were extracted before, by index, with their sizes
+        QHash<int, qint64> mExtractedFiles;
+        QFile mManifest;
+
         QWaitCondition mWait;
 
         QReadWriteLock mLock;
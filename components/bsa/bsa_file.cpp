@@ -28,6 +28,9 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <components/files/mappedfile.hpp>
+#include <components/files/memorystream.hpp>
+
 using namespace std;
 using namespace Bsa;
 
@@ -166,6 +169,24 @@ void BSAFile::open(const string &file)
     readHeader();
 }
 
+void BSAFile::mapIntoMemory()
+{
+    assert(isLoaded);
+
+    if (mMapping.get())
+        return;
+
+    boost::shared_ptr<Files::MappedFile> mapping (new Files::MappedFile);
+    mapping->open(filename.c_str());
+
+    // readHeader() checked the offsets against the size at that time
+    for (FileList::const_iterator it = files.begin(); it != files.end(); ++it)
+        if (size_t(it->offset) + it->fileSize > mapping->size())
+            fail("Archive was truncated after it was opened");
+
+    mMapping = mapping;
+}
+
 Files::IStreamPtr BSAFile::getFile(const char *file)
 {
     assert(file);
@@ -173,12 +194,21 @@ Files::IStreamPtr BSAFile::getFile(const char *file)
     if(i == -1)
         fail("File not found: " + string(file));
 
-    const FileStruct &fs = files[i];
-
-    return Files::openConstrainedFileStream (filename.c_str (), fs.offset, fs.fileSize);
+    return getFile(&files[i]);
 }
 
 Files::IStreamPtr BSAFile::getFile(const FileStruct *file)
 {
+    if (mMapping.get())
+        return Files::IStreamPtr(new Files::IMemStream(getFileData(file), file->fileSize));
+
     return Files::openConstrainedFileStream (filename.c_str (), file->offset, file->fileSize);
 }
+
+const char* BSAFile::getFileData(const FileStruct *file) const
+{
+    if (!mMapping.get())
+        return NULL;
+
+    return mMapping->data() + file->offset;
+}
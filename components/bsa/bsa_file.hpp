@@ -31,8 +31,15 @@
 
 #include <components/misc/stringops.hpp>
 
+#include <boost/shared_ptr.hpp>
+
 #include <components/files/constrainedfilestream.hpp>
 
+namespace Files
+{
+    class MappedFile;
+}
+
 
 namespace Bsa
 {
@@ -69,6 +76,9 @@ private:
     /// Used for error messages
     std::string filename;
 
+    /// View of the whole archive, if mapIntoMemory() was called
+    boost::shared_ptr<Files::MappedFile> mMapping;
+
     /// Case insensitive string comparison
     struct iltstr
     {
@@ -105,6 +115,15 @@ public:
     /// Open an archive file.
     void open(const std::string &file);
 
+    /** Map the opened archive into memory. Streams returned by getFile()
+        will then read straight from the mapping instead of opening the
+        archive again for each file.
+    */
+    void mapIntoMemory();
+
+    bool isMapped() const
+    { return mMapping.get() != NULL; }
+
     /* -----------------------------------
      * Archive file routines
      * -----------------------------------
@@ -121,6 +140,10 @@ public:
 
     Files::IStreamPtr getFile(const FileStruct* file);
 
+    /// Get a pointer to the contents of the given file, or NULL if the archive is not mapped into memory.
+    /// @note fileSize bytes are available. The pointer stays valid until this BSAFile is destroyed.
+    const char* getFileData(const FileStruct* file) const;
+
     /// Get a list of all files
     const FileList &getList() const
     { return files; }
@@ -0,0 +1,141 @@
+#include "packfile.hpp"
+
+#include <stdexcept>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <components/files/lz4.hpp>
+#include <components/files/memorystream.hpp>
+
+namespace Bsa
+{
+
+    /*
+     * The layout of a pack archive is as follows, all numbers are 32 bit little endian:
+     *
+     * - 16 bytes header:
+     *         magic number - "OMWP"
+     *         version - equal to 1
+     *         numfiles - number of files
+     *         namesize - size of the name buffer (see below)
+     *
+     * - 16 bytes*numfiles, each record contains:
+     *         offset of the data from the start of the archive
+     *         stored size - size of the data in the archive
+     *         size - size of the file once decompressed
+     *         offset into the name buffer
+     *
+     * - name buffer, each string is null-terminated
+     *
+     * - The rest of the archive is file data. A file whose stored size differs from its
+     *   size is a single LZ4 frame, otherwise it is stored as it is.
+     */
+
+    const uint32_t PackFile::sMagic;
+    const uint32_t PackFile::sVersion;
+
+    bool PackFile::isPackFile(const std::string &filename)
+    {
+        boost::filesystem::ifstream input(boost::filesystem::path(filename), std::ios_base::binary);
+        uint32_t magic = 0;
+        input.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        return input.good() && magic == sMagic;
+    }
+
+    void PackFile::open(const std::string &filename)
+    {
+        mFilename = filename;
+        mFiles.clear();
+        mNames.clear();
+
+        boost::filesystem::ifstream input(boost::filesystem::path(filename), std::ios_base::binary);
+        if (!input.is_open())
+            fail("Failed to open the archive");
+
+        std::streamoff fsize = 0;
+        if (input.seekg(0, std::ios_base::end))
+        {
+            fsize = input.tellg();
+            input.seekg(0);
+        }
+
+        uint32_t head[4];
+        if (fsize < std::streamoff(sizeof(head)) || !input.read(reinterpret_cast<char*>(head), sizeof(head)))
+            fail("File too small to be a valid pack archive");
+
+        if (head[0] != sMagic)
+            fail("Unrecognized pack header");
+        if (head[1] != sVersion)
+            fail("Unsupported pack version");
+
+        const size_t filenum = head[2];
+        const size_t namesize = head[3];
+        if (filenum * 16 + namesize > size_t(fsize) - sizeof(head))
+            fail("Directory information larger than entire archive");
+
+        std::vector<uint32_t> records(4 * filenum);
+        if (filenum)
+            input.read(reinterpret_cast<char*>(&records[0]), 16 * filenum);
+
+        mNames.resize(namesize);
+        if (namesize)
+            input.read(&mNames[0], namesize);
+
+        if (!input)
+            fail("Failed to read the directory");
+        if (namesize && mNames.back() != '\0')
+            fail("Name buffer is not terminated");
+
+        mFiles.resize(filenum);
+        for (size_t i=0; i<filenum; ++i)
+        {
+            FileStruct& file = mFiles[i];
+            file.mOffset = records[4*i];
+            file.mStoredSize = records[4*i+1];
+            file.mSize = records[4*i+2];
+
+            if (records[4*i+3] >= namesize)
+                fail("Archive contains names outside the name buffer");
+            file.mName = &mNames[records[4*i+3]];
+
+            if (std::streamoff(file.mOffset) + file.mStoredSize > fsize)
+                fail("Archive contains offsets outside itself");
+        }
+    }
+
+    Files::IStreamPtr PackFile::getFile(const FileStruct *file) const
+    {
+        if (!file->isCompressed())
+            return Files::openConstrainedFileStream(mFilename.c_str(), file->mOffset, file->mSize);
+
+        std::vector<char> compressedData(file->mStoredSize);
+        {
+            Files::IStreamPtr stream = Files::openConstrainedFileStream(mFilename.c_str(), file->mOffset, file->mStoredSize);
+            if (!compressedData.empty() && !stream->read(&compressedData[0], compressedData.size()))
+                fail(std::string("Failed to read ") + file->mName);
+        }
+
+        Files::SharedBuffer buffer (new std::vector<char>);
+        buffer->reserve(file->mSize);
+        try
+        {
+            Files::decompressLz4(compressedData.empty() ? NULL : &compressedData[0], compressedData.size(), *buffer);
+        }
+        catch (std::exception& e)
+        {
+            fail(std::string(e.what()) + " in " + file->mName);
+        }
+
+        if (buffer->size() != file->mSize)
+            fail(std::string("Unexpected size of ") + file->mName);
+
+        return Files::IStreamPtr(new Files::ISharedMemStream(buffer));
+    }
+
+    void PackFile::fail(const std::string &msg) const
+    {
+        throw std::runtime_error("Pack error: " + msg + "\nArchive: " + mFilename);
+    }
+
+}
@@ -0,0 +1,69 @@
+#ifndef OPENMW_COMPONENTS_BSA_PACKFILE_H
+#define OPENMW_COMPONENTS_BSA_PACKFILE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <components/files/constrainedfilestream.hpp>
+
+namespace Bsa
+{
+
+    /// @brief Reads pack archives, which hold the files of a directory tree one after another,
+    /// each compressed on its own in the LZ4 frame format. Written by "bsatool pack".
+    /// @par Compared to loose files, the archive is opened once and the files of a directory lie next to
+    /// each other on disk. Compared to a BSA archive, less data has to be read from disk.
+    class PackFile
+    {
+    public:
+        /// Represents one file entry in the archive
+        struct FileStruct
+        {
+            /// Offset of the data from the start of the archive
+            uint32_t mOffset;
+            /// Size of the data in the archive
+            uint32_t mStoredSize;
+            /// Size of the file once decompressed
+            uint32_t mSize;
+
+            /// Zero-terminated file name, with backslashes
+            const char* mName;
+
+            /// Files that would not get smaller are stored as they are
+            bool isCompressed() const { return mStoredSize != mSize; }
+        };
+        typedef std::vector<FileStruct> FileList;
+
+        /// The first four bytes of a pack archive
+        static const uint32_t sMagic = 0x50574d4f; // "OMWP"
+        static const uint32_t sVersion = 1;
+
+        /// Does the given file start like a pack archive?
+        static bool isPackFile(const std::string& filename);
+
+        /// Open an archive file and read its directory.
+        /// @note Throws an exception if the file is not a valid pack archive.
+        void open(const std::string& filename);
+
+        /// Open a file contained in the archive, decompressing it into memory if needed.
+        /// @note Thread safe, each call opens the archive on its own.
+        Files::IStreamPtr getFile(const FileStruct* file) const;
+
+        /// Get a list of all files
+        const FileList& getList() const { return mFiles; }
+
+    private:
+        void fail(const std::string& msg) const;
+
+        std::string mFilename;
+
+        FileList mFiles;
+
+        /// Filename string buffer
+        std::vector<char> mNames;
+    };
+
+}
+
+#endif
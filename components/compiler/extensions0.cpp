@@ -304,6 +304,10 @@ namespace Compiler
             extensions.registerInstruction("tgm", "", opcodeToggleGodMode);
             extensions.registerInstruction("togglegodmode", "", opcodeToggleGodMode);
             extensions.registerInstruction("togglescripts", "", opcodeToggleScripts);
+            extensions.registerInstruction("togglescriptprofiler", "", opcodeToggleScriptProfiler);
+            extensions.registerInstruction("tsp", "", opcodeToggleScriptProfiler);
+            extensions.registerInstruction("showscriptprofile", "/l", opcodeShowScriptProfile);
+            extensions.registerInstruction("exportscriptprofile", "S", opcodeExportScriptProfile);
             extensions.registerInstruction ("disablelevitation", "", opcodeDisableLevitation);
             extensions.registerInstruction ("enablelevitation", "", opcodeEnableLevitation);
             extensions.registerFunction ("getpcinjail", 'l', "", opcodeGetPcInJail);
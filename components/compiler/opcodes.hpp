@@ -279,6 +279,9 @@ namespace Compiler
         const int opcodeShowVarsExplicit = 0x200021e;
         const int opcodeToggleGodMode = 0x200021f;
         const int opcodeToggleScripts = 0x2000301;
+        const int opcodeToggleScriptProfiler = 0x2000302;
+        const int opcodeShowScriptProfile = 0x2002f;
+        const int opcodeExportScriptProfile = 0x2000303;
         const int opcodeDisableLevitation = 0x2000220;
         const int opcodeEnableLevitation = 0x2000221;
         const int opcodeCast = 0x2000227;
@@ -0,0 +1,560 @@
+#include "optimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstring>
+
+#include "generator.hpp"
+
+namespace
+{
+    typedef std::vector<Interpreter::Type_Code> CodeContainer;
+
+    // Opcodes of the engine, see components/interpreter/docs/vmformat.txt
+    const unsigned int opPushInt = 0;
+    const unsigned int opJumpForward = 1;
+    const unsigned int opJumpBackward = 2;
+
+    const unsigned int opIntToFloat = 3;
+    const unsigned int opFetchIntLiteral = 4;
+    const unsigned int opFetchFloatLiteral = 5;
+    const unsigned int opFloatToInt = 6;
+    const unsigned int opNegateInt = 7;
+    const unsigned int opNegateFloat = 8;
+    const unsigned int opAddInt = 9;
+    const unsigned int opAddFloat = 10;
+    const unsigned int opSubInt = 11;
+    const unsigned int opSubFloat = 12;
+    const unsigned int opMulInt = 13;
+    const unsigned int opMulFloat = 14;
+    const unsigned int opDivInt = 15;
+    const unsigned int opDivFloat = 16;
+    const unsigned int opIntToFloat1 = 17;
+    const unsigned int opFloatToInt1 = 18;
+    const unsigned int opReturn = 20;
+    const unsigned int opSkipOnZero = 24;
+    const unsigned int opSkipOnNonZero = 25;
+    const unsigned int opEqualInt = 26;
+    const unsigned int opGreaterOrEqualInt = 31;
+    const unsigned int opEqualFloat = 32;
+    const unsigned int opGreaterOrEqualFloat = 37;
+
+    bool isSegment0 (Interpreter::Type_Code code, unsigned int opcode)
+    {
+        return (code>>24)==opcode;
+    }
+
+    bool isSegment5 (Interpreter::Type_Code code, unsigned int opcode)
+    {
+        return code==Compiler::Generator::segment5 (opcode);
+    }
+
+    bool isJump (Interpreter::Type_Code code)
+    {
+        return isSegment0 (code, opJumpForward) || isSegment0 (code, opJumpBackward);
+    }
+
+    bool isSkip (Interpreter::Type_Code code)
+    {
+        return isSegment5 (code, opSkipOnZero) || isSegment5 (code, opSkipOnNonZero);
+    }
+
+    /// A literal pushed on the stack
+    struct Constant
+    {
+        bool mFloat;
+        Interpreter::Type_Integer mInteger;
+        Interpreter::Type_Float mFloatValue;
+
+        static Constant fromInteger (Interpreter::Type_Integer value)
+        {
+            Constant constant;
+            constant.mFloat = false;
+            constant.mInteger = value;
+            constant.mFloatValue = 0;
+            return constant;
+        }
+
+        static Constant fromFloat (Interpreter::Type_Float value)
+        {
+            Constant constant;
+            constant.mFloat = true;
+            constant.mInteger = 0;
+            constant.mFloatValue = value;
+            return constant;
+        }
+    };
+
+    /// The parts of a program, unpacked to be changed.
+    class Program
+    {
+            CodeContainer mCode;
+            std::vector<Interpreter::Type_Integer> mIntegers;
+            std::vector<Interpreter::Type_Float> mFloats;
+            CodeContainer mStrings;
+
+            // Jumps can only lead to instructions that are not removed or replaced halfway, and the
+            // instruction after a skip has to stay a single instruction
+            std::vector<bool> mTargets;
+            std::vector<bool> mSkipped;
+
+            // Result of a pass over the code
+            CodeContainer mNewCode;
+            std::vector<int> mNewJumpTargets; // old target of each new instruction that is a jump, or -1
+            std::vector<int> mNewIndices; // new index of each old instruction, or of the one after it if removed
+
+            bool isFixed (int index) const
+            {
+                return mTargets[index] || mSkipped[index];
+            }
+
+            /// Can the instructions from \a index up to \a count after it be replaced as a whole?
+            bool isFree (int index, int count) const
+            {
+                if (index+count>static_cast<int> (mCode.size()) || mSkipped[index])
+                    return false;
+
+                for (int i=index+1; i<index+count; ++i)
+                    if (isFixed (i))
+                        return false;
+
+                return true;
+            }
+
+            bool getConstant (int index, Constant& constant) const
+            {
+                if (!isFree (index, 2) || !isSegment0 (mCode[index], opPushInt))
+                    return false;
+
+                unsigned int literal = mCode[index] & 0xffffff;
+
+                if (isSegment5 (mCode[index+1], opFetchIntLiteral) && literal<mIntegers.size())
+                {
+                    constant = Constant::fromInteger (mIntegers[literal]);
+                    return true;
+                }
+
+                if (isSegment5 (mCode[index+1], opFetchFloatLiteral) && literal<mFloats.size())
+                {
+                    constant = Constant::fromFloat (mFloats[literal]);
+                    return true;
+                }
+
+                return false;
+            }
+
+            void emit (Interpreter::Type_Code code, int jumpTarget = -1)
+            {
+                mNewCode.push_back (code);
+                mNewJumpTargets.push_back (jumpTarget);
+            }
+
+            void emitConstant (const Constant& constant)
+            {
+                if (constant.mFloat)
+                {
+                    std::vector<Interpreter::Type_Float>::iterator iter =
+                        std::find (mFloats.begin(), mFloats.end(), constant.mFloatValue);
+
+                    // Keep -0 and 0 apart
+                    while (iter!=mFloats.end() &&
+                        std::memcmp (&*iter, &constant.mFloatValue, sizeof (Interpreter::Type_Float)))
+                        iter = std::find (iter+1, mFloats.end(), constant.mFloatValue);
+
+                    if (iter==mFloats.end())
+                        iter = mFloats.insert (mFloats.end(), constant.mFloatValue);
+
+                    emit (Compiler::Generator::segment0 (opPushInt, iter-mFloats.begin()));
+                    emit (Compiler::Generator::segment5 (opFetchFloatLiteral));
+                }
+                else
+                {
+                    std::vector<Interpreter::Type_Integer>::iterator iter =
+                        std::find (mIntegers.begin(), mIntegers.end(), constant.mInteger);
+
+                    if (iter==mIntegers.end())
+                        iter = mIntegers.insert (mIntegers.end(), constant.mInteger);
+
+                    emit (Compiler::Generator::segment0 (opPushInt, iter-mIntegers.begin()));
+                    emit (Compiler::Generator::segment5 (opFetchIntLiteral));
+                }
+            }
+
+            /// Replace the instructions from \a index, if they are a known pattern.
+            /// \return The number of instructions replaced, 0 for none.
+            int fold (int index, bool pushDirectly);
+
+            void findTargets();
+
+            bool pass (bool pushDirectly);
+
+        public:
+
+            explicit Program (const CodeContainer& code);
+
+            void optimize();
+
+            void getCode (CodeContainer& code) const;
+    };
+
+    bool foldUnary (const Constant& value, unsigned int opcode, Constant& result)
+    {
+        switch (opcode)
+        {
+            case opNegateInt:
+
+                if (value.mFloat || value.mInteger==INT_MIN)
+                    return false;
+
+                result = Constant::fromInteger (-value.mInteger);
+                return true;
+
+            case opNegateFloat:
+
+                if (!value.mFloat)
+                    return false;
+
+                result = Constant::fromFloat (-value.mFloatValue);
+                return true;
+
+            case opIntToFloat:
+
+                if (value.mFloat)
+                    return false;
+
+                result = Constant::fromFloat (static_cast<Interpreter::Type_Float> (value.mInteger));
+                return true;
+
+            case opFloatToInt:
+
+                // Out of range conversions are left to the run time
+                if (!value.mFloat || !(value.mFloatValue>INT_MIN && value.mFloatValue<INT_MAX))
+                    return false;
+
+                result = Constant::fromInteger (static_cast<Interpreter::Type_Integer> (value.mFloatValue));
+                return true;
+        }
+
+        return false;
+    }
+
+    template<typename T>
+    bool compare (unsigned int opcode, T left, T right)
+    {
+        switch (opcode)
+        {
+            case 0: return left==right;
+            case 1: return left!=right;
+            case 2: return left<right;
+            case 3: return left<=right;
+            case 4: return left>right;
+            default: return left>=right;
+        }
+    }
+
+    bool foldBinary (const Constant& left, const Constant& right, unsigned int opcode, Constant& result)
+    {
+        if (left.mFloat!=right.mFloat)
+            return false;
+
+        if (!left.mFloat)
+        {
+            // Integers wrap around like on any platform the engine runs on, without relying on it here
+            unsigned int a = static_cast<unsigned int> (left.mInteger);
+            unsigned int b = static_cast<unsigned int> (right.mInteger);
+
+            switch (opcode)
+            {
+                case opAddInt: result = Constant::fromInteger (static_cast<Interpreter::Type_Integer> (a+b)); return true;
+                case opSubInt: result = Constant::fromInteger (static_cast<Interpreter::Type_Integer> (a-b)); return true;
+                case opMulInt: result = Constant::fromInteger (static_cast<Interpreter::Type_Integer> (a*b)); return true;
+
+                case opDivInt:
+
+                    if (right.mInteger==0 || (left.mInteger==INT_MIN && right.mInteger==-1))
+                        return false;
+
+                    result = Constant::fromInteger (left.mInteger / right.mInteger);
+                    return true;
+            }
+
+            if (opcode>=opEqualInt && opcode<=opGreaterOrEqualInt)
+            {
+                result = Constant::fromInteger (compare (opcode-opEqualInt, left.mInteger, right.mInteger));
+                return true;
+            }
+        }
+        else
+        {
+            Interpreter::Type_Float a = left.mFloatValue;
+            Interpreter::Type_Float b = right.mFloatValue;
+
+            switch (opcode)
+            {
+                case opAddFloat: result = Constant::fromFloat (a+b); return true;
+                case opSubFloat: result = Constant::fromFloat (a-b); return true;
+                case opMulFloat: result = Constant::fromFloat (a*b); return true;
+
+                case opDivFloat:
+
+                    if (b==0)
+                        return false;
+
+                    result = Constant::fromFloat (a/b);
+                    return true;
+            }
+
+            if (opcode>=opEqualFloat && opcode<=opGreaterOrEqualFloat)
+            {
+                result = Constant::fromInteger (compare (opcode-opEqualFloat, a, b));
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    Program::Program (const CodeContainer& code)
+    {
+        assert (code.size()>=4);
+
+        CodeContainer::const_iterator iter = code.begin()+4;
+
+        mCode.assign (iter, iter+code[0]);
+        iter += code[0];
+
+        for (unsigned int i=0; i<code[1]; ++i, ++iter)
+        {
+            Interpreter::Type_Integer value;
+            std::memcpy (&value, &*iter, sizeof (value));
+            mIntegers.push_back (value);
+        }
+
+        for (unsigned int i=0; i<code[2]; ++i, ++iter)
+        {
+            Interpreter::Type_Float value;
+            std::memcpy (&value, &*iter, sizeof (value));
+            mFloats.push_back (value);
+        }
+
+        mStrings.assign (iter, iter+code[3]);
+    }
+
+    void Program::findTargets()
+    {
+        int size = static_cast<int> (mCode.size());
+
+        mTargets.assign (size+1, false);
+        mSkipped.assign (size+1, false);
+
+        for (int i=0; i<size; ++i)
+        {
+            unsigned int offset = mCode[i] & 0xffffff;
+
+            if (isSegment0 (mCode[i], opJumpForward))
+            {
+                if (i+offset<=static_cast<unsigned int> (size))
+                    mTargets[i+offset] = true;
+            }
+            else if (isSegment0 (mCode[i], opJumpBackward))
+            {
+                if (offset<=static_cast<unsigned int> (i))
+                    mTargets[i-offset] = true;
+            }
+            else if (isSkip (mCode[i]) && i+2<=size)
+            {
+                mSkipped[i+1] = true;
+                mTargets[i+2] = true;
+            }
+        }
+    }
+
+    int Program::fold (int index, bool pushDirectly)
+    {
+        Constant left;
+
+        if (getConstant (index, left))
+        {
+            if (pushDirectly && !left.mFloat && left.mInteger>=0 && left.mInteger<=0xffffff)
+            {
+                emit (Compiler::Generator::segment0 (opPushInt, left.mInteger));
+                return 2;
+            }
+
+            Constant result;
+
+            if (isFree (index, 3) && mCode[index+2]>>26==0x32 &&
+                foldUnary (left, mCode[index+2] & 0x3ffffff, result))
+            {
+                emitConstant (result);
+                return 3;
+            }
+
+            // An if-condition: skip followed by the jump to the end of the branch, which is the skipped instruction
+            if (!left.mFloat && isFree (index, 3) && isSegment5 (mCode[index+2], opSkipOnNonZero) &&
+                index+3<static_cast<int> (mCode.size()) && !mTargets[index+3] && isJump (mCode[index+3]))
+            {
+                if (left.mInteger==0)
+                {
+                    unsigned int offset = mCode[index+3] & 0xffffff;
+                    int target = isSegment0 (mCode[index+3], opJumpForward) ? index+3+offset : index+3-offset;
+                    emit (mCode[index+3], target);
+                }
+
+                return 4;
+            }
+
+            Constant right;
+
+            if (isFree (index, 5) && getConstant (index+2, right) && mCode[index+4]>>26==0x32)
+            {
+                unsigned int opcode = mCode[index+4] & 0x3ffffff;
+
+                if (opcode==opIntToFloat1 || opcode==opFloatToInt1)
+                {
+                    if (!foldUnary (left, opcode==opIntToFloat1 ? opIntToFloat : opFloatToInt, result))
+                        return 0;
+
+                    emitConstant (result);
+                    emitConstant (right);
+                    return 5;
+                }
+
+                if (foldBinary (left, right, opcode, result))
+                {
+                    emitConstant (result);
+                    return 5;
+                }
+            }
+        }
+
+        // A jump to the next instruction
+        if (isSegment0 (mCode[index], opJumpForward) && (mCode[index] & 0xffffff)==1 && !mSkipped[index])
+            return 1;
+
+        return 0;
+    }
+
+    bool Program::pass (bool pushDirectly)
+    {
+        findTargets();
+
+        int size = static_cast<int> (mCode.size());
+
+        mNewCode.clear();
+        mNewJumpTargets.clear();
+        mNewIndices.assign (size+1, 0);
+
+        bool changed = false;
+
+        for (int i=0; i<size;)
+        {
+            int newIndex = static_cast<int> (mNewCode.size());
+
+            if (int count = fold (i, pushDirectly))
+            {
+                for (int j=i; j<i+count; ++j)
+                    mNewIndices[j] = newIndex;
+
+                i += count;
+                changed = true;
+                continue;
+            }
+
+            Interpreter::Type_Code code = mCode[i];
+            unsigned int offset = code & 0xffffff;
+
+            mNewIndices[i] = newIndex;
+
+            if (isSegment0 (code, opJumpForward))
+                emit (code, i+offset);
+            else if (isSegment0 (code, opJumpBackward))
+                emit (code, i-offset);
+            else
+                emit (code);
+
+            ++i;
+
+            // Nothing can be reached after a jump or return, until the next jump target
+            if ((isJump (code) || isSegment5 (code, opReturn)) && !mSkipped[i-1])
+            {
+                for (; i<size && !isFixed (i); ++i)
+                {
+                    mNewIndices[i] = static_cast<int> (mNewCode.size());
+                    changed = true;
+                }
+            }
+        }
+
+        mNewIndices[size] = static_cast<int> (mNewCode.size());
+
+        if (!changed)
+            return false;
+
+        // The jump offsets are relative, so they change with the instructions around them
+        for (int i=0; i<static_cast<int> (mNewCode.size()); ++i)
+        {
+            if (mNewJumpTargets[i]==-1)
+                continue;
+
+            int offset = mNewIndices[mNewJumpTargets[i]]-i;
+
+            if (offset>=0)
+                mNewCode[i] = Compiler::Generator::segment0 (opJumpForward, offset);
+            else
+                mNewCode[i] = Compiler::Generator::segment0 (opJumpBackward, -offset);
+        }
+
+        mCode.swap (mNewCode);
+        return true;
+    }
+
+    void Program::optimize()
+    {
+        // Each pass only folds what it finds literals for, so nested expressions take several passes
+        while (pass (false)) {}
+
+        pass (true);
+    }
+
+    void Program::getCode (CodeContainer& code) const
+    {
+        code.clear();
+
+        code.push_back (static_cast<Interpreter::Type_Code> (mCode.size()));
+        code.push_back (static_cast<Interpreter::Type_Code> (mIntegers.size()));
+        code.push_back (static_cast<Interpreter::Type_Code> (mFloats.size()));
+        code.push_back (static_cast<Interpreter::Type_Code> (mStrings.size()));
+
+        code.insert (code.end(), mCode.begin(), mCode.end());
+
+        for (std::vector<Interpreter::Type_Integer>::const_iterator iter (mIntegers.begin());
+            iter!=mIntegers.end(); ++iter)
+        {
+            Interpreter::Type_Code value;
+            std::memcpy (&value, &*iter, sizeof (value));
+            code.push_back (value);
+        }
+
+        for (std::vector<Interpreter::Type_Float>::const_iterator iter (mFloats.begin());
+            iter!=mFloats.end(); ++iter)
+        {
+            Interpreter::Type_Code value;
+            std::memcpy (&value, &*iter, sizeof (value));
+            code.push_back (value);
+        }
+
+        code.insert (code.end(), mStrings.begin(), mStrings.end());
+    }
+}
+
+namespace Compiler
+{
+    void optimize (std::vector<Interpreter::Type_Code>& code)
+    {
+        Program program (code);
+        program.optimize();
+        program.getCode (code);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef COMPILER_OPTIMIZER_H_INCLUDED
+#define COMPILER_OPTIMIZER_H_INCLUDED
+
+#include <vector>
+
+#include <components/interpreter/types.hpp>
+
+namespace Compiler
+{
+    /// \brief Make compiled code execute fewer instructions, without changing what it does.
+    ///
+    /// Arithmetic, conversions and comparisons of literals are evaluated ahead of time, unless
+    /// they fail at run time (division by zero). If-conditions that are literals are resolved,
+    /// code that can not be reached is removed and jumps to the next instruction are dropped.
+    /// Integer literals small enough to be pushed directly are not fetched from the literal block
+    /// anymore.
+    ///
+    /// \param code A complete program as returned by Output::getCode, in the format described in
+    /// components/interpreter/docs/vmformat.txt.
+    /// \note Only opcodes of the engine are looked at, extensions are never touched.
+    void optimize (std::vector<Interpreter::Type_Code>& code);
+}
+
+#endif
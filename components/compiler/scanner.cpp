@@ -1,7 +1,6 @@
 #include "scanner.hpp"
 
 #include <cassert>
-#include <cctype>
 #include <sstream>
 #include <algorithm>
 #include <iterator>
@@ -13,14 +12,68 @@
 
 #include <components/misc/stringops.hpp>
 
+namespace
+{
+    enum CharacterClass
+    {
+        Class_Alpha = 1,
+        Class_Digit = 2,
+        Class_String = 4 ///< can be part of a name, - aside
+    };
+
+    /// Classes of the characters, like the C locale
+    class CharacterClasses
+    {
+            unsigned char mClasses[256];
+
+        public:
+
+            CharacterClasses()
+            {
+                std::fill (mClasses, mClasses+256, 0);
+
+                for (int c='a'; c<='z'; ++c)
+                    mClasses[c] = mClasses[c-'a'+'A'] = Class_Alpha | Class_String;
+
+                for (int c='0'; c<='9'; ++c)
+                    mClasses[c] = Class_Digit | Class_String;
+
+                mClasses[static_cast<unsigned char> ('_')] = Class_String;
+                /// \todo disable ` and ' when doing more stricter compiling
+                mClasses[static_cast<unsigned char> ('`')] = Class_String;
+                mClasses[static_cast<unsigned char> ('\'')] = Class_String;
+            }
+
+            bool is (char c, int classes) const
+            {
+                return (mClasses[static_cast<unsigned char> (c)] & classes)!=0;
+            }
+    };
+
+    const CharacterClasses sClasses;
+
+    bool isAlpha (char c)
+    {
+        return sClasses.is (c, Class_Alpha);
+    }
+
+    bool isDigit (char c)
+    {
+        return sClasses.is (c, Class_Digit);
+    }
+}
+
 namespace Compiler
 {
     bool Scanner::get (char& c)
     {
-        mStream.get (c);
-
-        if (!mStream.good())
+        if (mPos>=mSource.size())
+        {
+            mEOF = true;
             return false;
+        }
+
+        c = mSource[mPos++];
 
         mPrevLoc =mLoc;
 
@@ -42,7 +95,8 @@ namespace Compiler
 
     void Scanner::putback (char c)
     {
-        mStream.putback (c);
+        if (!mEOF)
+            --mPos;
         mLoc = mPrevLoc;
     }
 
@@ -120,7 +174,7 @@ namespace Compiler
             mLoc.mLiteral.clear();
             return true;
         }
-        else if (std::isalpha (c) || c=='_' || c=='"')
+        else if (isAlpha (c) || c=='_' || c=='"')
         {
             bool cont = false;
 
@@ -130,7 +184,7 @@ namespace Compiler
                 return cont;
             }
         }
-        else if (std::isdigit (c))
+        else if (isDigit (c))
         {
             bool cont = false;
 
@@ -172,7 +226,7 @@ namespace Compiler
 
         while (get (c))
         {
-            if (std::isdigit (c))
+            if (isDigit (c))
             {
                 value += c;
             }
@@ -211,10 +265,18 @@ namespace Compiler
         TokenLoc loc (mLoc);
         mLoc.mLiteral.clear();
 
-        std::istringstream stream (value);
-
         int intValue = 0;
-        stream >> intValue;
+
+        if (value.size()<=9) // can't overflow
+        {
+            for (std::string::const_iterator iter (value.begin()); iter!=value.end(); ++iter)
+                intValue = intValue*10 + (*iter-'0');
+        }
+        else
+        {
+            std::istringstream stream (value);
+            stream >> intValue;
+        }
 
         cont = parser.parseInt (intValue, loc, *this);
         return true;
@@ -231,12 +293,12 @@ namespace Compiler
 
         while (get (c))
         {
-            if (std::isdigit (c))
+            if (isDigit (c))
             {
                 value += c;
                 empty = false;
             }
-            else if (std::isalpha (c) || c=='_')
+            else if (isAlpha (c) || c=='_')
                 error = true;
             else
             {
@@ -393,7 +455,7 @@ namespace Compiler
             {
                 putback (c);
 
-                if (std::isdigit (c))
+                if (isDigit (c))
                     return scanFloat ("", parser, cont);
             }
 
@@ -550,15 +612,13 @@ namespace Compiler
         return true;
     }
 
-    bool Scanner::isStringCharacter (char c, bool lookAhead)
+    bool Scanner::isStringCharacter (char c, bool lookAhead) const
     {
-        return std::isalpha (c) || std::isdigit (c) || c=='_' ||
-            /// \todo disable this when doing more stricter compiling
-            c=='`' || c=='\'' ||
+        return sClasses.is (c, Class_String) ||
             /// \todo disable this when doing more stricter compiling. Also, find out who is
             /// responsible for allowing it in the first place and meet up with that person in
             /// a dark alley.
-            (c=='-' && (!lookAhead || isStringCharacter (mStream.peek(), false)));
+            (c=='-' && (!lookAhead || (mPos<mSource.size() && isStringCharacter (mSource[mPos], false))));
     }
 
     bool Scanner::isWhitespace (char c)
@@ -570,10 +630,12 @@ namespace Compiler
 
     Scanner::Scanner (ErrorHandler& errorHandler, std::istream& inputStream,
         const Extensions *extensions)
-    : mErrorHandler (errorHandler), mStream (inputStream), mExtensions (extensions),
+    : mErrorHandler (errorHandler), mStream (inputStream), mPos (0), mEOF (false), mExtensions (extensions),
       mPutback (Putback_None), mPutbackCode(0), mPutbackInteger(0), mPutbackFloat(0),
       mStrictKeywords (false)
     {
+        // Scan from memory, reading the stream one character at a time took most of the compile time
+        mSource.assign (std::istreambuf_iterator<char> (mStream), std::istreambuf_iterator<char>());
     }
 
     void Scanner::scan (Parser& parser)
@@ -30,6 +30,9 @@ namespace Compiler
             TokenLoc mLoc;
             TokenLoc mPrevLoc;
             std::istream& mStream;
+            std::string mSource; // the whole stream, read on construction
+            std::size_t mPos;
+            bool mEOF; // read past the end, nothing to put back anymore
             const Extensions *mExtensions;
             putback_type mPutback;
             int mPutbackCode;
@@ -94,7 +97,7 @@ namespace Compiler
 
             bool scanSpecial (char c, Parser& parser, bool& cont);
 
-            bool isStringCharacter (char c, bool lookAhead = true);
+            bool isStringCharacter (char c, bool lookAhead = true) const;
 
             static bool isWhitespace (char c);
 
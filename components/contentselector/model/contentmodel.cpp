@@ -6,9 +6,59 @@
 #include <QDir>
 #include <QTextCodec>
 #include <QDebug>
+#include <QThreadPool>
+#include <QRunnable>
 
 #include <components/esm/esmreader.hpp>
 
+namespace
+{
+    /// Reads the header of a content file on a thread of the pool.
+    class ReadHeaderRunnable : public QRunnable
+    {
+        std::string mPath;
+        std::string mEncoding;
+
+    public:
+
+        QStringList mGameFiles;
+        QString mAuthor;
+        QString mDescription;
+        int mFormat;
+        bool mFailed;
+        std::string mError;
+
+        ReadHeaderRunnable (const QString& path, const QString& encoding)
+        : mPath (path.toUtf8().constData()), mEncoding (encoding.toStdString()), mFormat (0), mFailed (false)
+        {
+            setAutoDelete (false);
+        }
+
+        virtual void run()
+        {
+            try
+            {
+                ESM::ESMReader fileReader;
+                ToUTF8::Utf8Encoder encoder (ToUTF8::calculateEncoding (mEncoding));
+                fileReader.setEncoder (&encoder);
+                fileReader.open (mPath);
+
+                foreach (const ESM::Header::MasterData &item, fileReader.getGameFiles())
+                    mGameFiles.append (QString::fromUtf8 (item.name.c_str()));
+
+                mAuthor = QString::fromUtf8 (fileReader.getAuthor().c_str());
+                mFormat = fileReader.getFormat();
+                mDescription = QString::fromUtf8 (fileReader.getDesc().c_str());
+            }
+            catch (const std::exception& e)
+            {
+                mFailed = true;
+                mError = e.what();
+            }
+        }
+    };
+}
+
 ContentSelectorModel::ContentModel::ContentModel(QObject *parent, QIcon warningIcon) :
     QAbstractTableModel(parent),
     mWarningIcon(warningIcon),
@@ -426,6 +476,8 @@ void ContentSelectorModel::ContentModel::addFiles(const QString &path)
     filters << "*.esp" << "*.esm" << "*.omwgame" << "*.omwaddon";
     dir.setNameFilters(filters);
 
+    QList<QFileInfo> infos;
+
     foreach (const QString &path, dir.entryList())
     {
         QFileInfo info(dir.absoluteFilePath(path));
@@ -433,41 +485,85 @@ void ContentSelectorModel::ContentModel::addFiles(const QString &path)
         if (item(info.absoluteFilePath()) != 0)
             continue;
 
-        try {
-            ESM::ESMReader fileReader;
-            ToUTF8::Utf8Encoder encoder =
-            ToUTF8::calculateEncoding(mEncoding.toStdString());
-            fileReader.setEncoder(&encoder);
-            fileReader.open(std::string(dir.absoluteFilePath(path).toUtf8().constData()));
+        infos.append(info);
+    }
 
-            EsmFile *file = new EsmFile(path);
+    // Read the headers that are not cached, or changed since, in parallel
+    QThreadPool threadPool;
+    QList<QPair<QString, ReadHeaderRunnable *> > readers;
 
-            foreach (const ESM::Header::MasterData &item, fileReader.getGameFiles())
-                file->addGameFile(QString::fromUtf8(item.name.c_str()));
+    foreach (const QFileInfo &info, infos)
+    {
+        QHash<QString, CachedHeader>::const_iterator cached = mHeaders.constFind(info.absoluteFilePath());
 
-            file->setAuthor     (QString::fromUtf8(fileReader.getAuthor().c_str()));
-            file->setDate       (info.lastModified());
-            file->setFormat     (fileReader.getFormat());
-            file->setFilePath       (info.absoluteFilePath());
-            file->setDescription(QString::fromUtf8(fileReader.getDesc().c_str()));
+        if (cached != mHeaders.constEnd() && cached->mSize == info.size() &&
+            cached->mModified == info.lastModified() && cached->mEncoding == mEncoding)
+            continue;
 
-            // HACK
-            // Load order constraint of Bloodmoon.esm needing Tribunal.esm is missing
-            // from the file supplied by Bethesda, so we have to add it ourselves
-            if (file->fileName().compare("Bloodmoon.esm", Qt::CaseInsensitive) == 0)
-            {
-                file->addGameFile(QString::fromUtf8("Tribunal.esm"));
-            }
+        ReadHeaderRunnable *reader = new ReadHeaderRunnable(info.absoluteFilePath(), mEncoding);
+        readers.append(qMakePair(info.absoluteFilePath(), reader));
+        threadPool.start(reader);
+    }
 
-            // Put the file in the table
-            addFile(file);
+    threadPool.waitForDone();
 
-        } catch(std::runtime_error &e) {
+    for (int i = 0; i < readers.size(); ++i)
+    {
+        ReadHeaderRunnable *reader = readers[i].second;
+
+        if (reader->mFailed)
+        {
             // An error occurred while reading the .esp
-            qWarning() << "Error reading addon file: " << e.what();
+            qWarning() << "Error reading addon file: " << reader->mError.c_str();
+            mHeaders.remove(readers[i].first);
+        }
+        else
+        {
+            QFileInfo info(readers[i].first);
+
+            CachedHeader& cached = mHeaders[readers[i].first];
+            cached.mSize = info.size();
+            cached.mModified = info.lastModified();
+            cached.mEncoding = mEncoding;
+            cached.mHeader.mGameFiles = reader->mGameFiles;
+            cached.mHeader.mAuthor = reader->mAuthor;
+            cached.mHeader.mDescription = reader->mDescription;
+            cached.mHeader.mFormat = reader->mFormat;
+        }
+
+        delete reader;
+    }
+
+    foreach (const QFileInfo &info, infos)
+    {
+        QHash<QString, CachedHeader>::const_iterator cached = mHeaders.constFind(info.absoluteFilePath());
+
+        if (cached == mHeaders.constEnd())
             continue;
+
+        const Header& header = cached->mHeader;
+
+        EsmFile *file = new EsmFile(info.fileName());
+
+        foreach (const QString &gameFile, header.mGameFiles)
+            file->addGameFile(gameFile);
+
+        file->setAuthor     (header.mAuthor);
+        file->setDate       (info.lastModified());
+        file->setFormat     (header.mFormat);
+        file->setFilePath       (info.absoluteFilePath());
+        file->setDescription(header.mDescription);
+
+        // HACK
+        // Load order constraint of Bloodmoon.esm needing Tribunal.esm is missing
+        // from the file supplied by Bethesda, so we have to add it ourselves
+        if (file->fileName().compare("Bloodmoon.esm", Qt::CaseInsensitive) == 0)
+        {
+            file->addGameFile(QString::fromUtf8("Tribunal.esm"));
         }
 
+        // Put the file in the table
+        addFile(file);
     }
 
     sortFiles();
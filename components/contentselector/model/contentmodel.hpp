@@ -4,6 +4,8 @@
 #include <QAbstractTableModel>
 #include <QStringList>
 #include <QSet>
+#include <QHash>
+#include <QDateTime>
 #include <QIcon>
 #include "loadordererror.hpp"
 
@@ -79,7 +81,26 @@ namespace ContentSelectorModel
 
         QString toolTip(const EsmFile *file) const;
 
+        /// The header of a content file, as read by ESM::ESMReader
+        struct Header
+        {
+            QStringList mGameFiles;
+            QString mAuthor;
+            QString mDescription;
+            int mFormat;
+        };
+
+        /// A header is read again when the file's size or modification date changed, or the encoding
+        struct CachedHeader
+        {
+            qint64 mSize;
+            QDateTime mModified;
+            QString mEncoding;
+            Header mHeader;
+        };
+
         ContentFileList mFiles;
+        QHash<QString, CachedHeader> mHeaders; // by absolute file path
         QHash<QString, Qt::CheckState> mCheckStates;
         QSet<QString> mPluginsWithLoadOrderError;
         QString mEncoding;
@@ -43,7 +43,7 @@ void ESM::CellRef::loadId (ESMReader& esm, bool wideRefNum)
 
     mRefNum.load (esm, wideRefNum);
 
-    mRefID = esm.getHNString ("NAME");
+    mRefID = esm.intern(esm.getHNStringView("NAME"));
 }
 
 void ESM::CellRef::loadData(ESMReader &esm, bool &isDeleted)
@@ -63,16 +63,16 @@ void ESM::CellRef::loadData(ESMReader &esm, bool &isDeleted)
                 esm.getHT(mScale);
                 break;
             case ESM::FourCC<'A','N','A','M'>::value:
-                mOwner = esm.getHString();
+                mOwner = esm.intern(esm.getHStringView());
                 break;
             case ESM::FourCC<'B','N','A','M'>::value:
-                mGlobalVariable = esm.getHString();
+                mGlobalVariable = esm.intern(esm.getHStringView());
                 break;
             case ESM::FourCC<'X','S','O','L'>::value:
-                mSoul = esm.getHString();
+                mSoul = esm.intern(esm.getHStringView());
                 break;
             case ESM::FourCC<'C','N','A','M'>::value:
-                mFaction = esm.getHString();
+                mFaction = esm.intern(esm.getHStringView());
                 break;
             case ESM::FourCC<'I','N','D','X'>::value:
                 esm.getHT(mFactionRank);
@@ -91,16 +91,16 @@ void ESM::CellRef::loadData(ESMReader &esm, bool &isDeleted)
                 mTeleport = true;
                 break;
             case ESM::FourCC<'D','N','A','M'>::value:
-                mDestCell = esm.getHString();
+                mDestCell = esm.intern(esm.getHStringView());
                 break;
             case ESM::FourCC<'F','L','T','V'>::value:
                 esm.getHT(mLockLevel);
                 break;
             case ESM::FourCC<'K','N','A','M'>::value:
-                mKey = esm.getHString();
+                mKey = esm.intern(esm.getHStringView());
                 break;
             case ESM::FourCC<'T','N','A','M'>::value:
-                mTrap = esm.getHString();
+                mTrap = esm.intern(esm.getHStringView());
                 break;
             case ESM::FourCC<'D','A','T','A'>::value:
                 esm.getHT(mPos, 24);
@@ -2,6 +2,11 @@
 
 #include <stdexcept>
 
+#include <components/files/lz4.hpp>
+#include <components/files/mappedfile.hpp>
+#include <components/files/memorystream.hpp>
+#include <components/misc/stringpool.hpp>
+
 namespace ESM
 {
 
@@ -25,6 +30,7 @@ ESMReader::ESMReader()
     , mBuffer(50*1024)
     , mGlobalReaderList(NULL)
     , mEncoder(NULL)
+    , mStringPool(NULL)
     , mFileSize(0)
 {
 }
@@ -36,8 +42,9 @@ int ESMReader::getFormat() const
 
 void ESMReader::restoreContext(const ESM_Context &rc)
 {
-    // Reopen the file if necessary
-    if (mCtx.filename != rc.filename)
+    // Reopen the file if necessary. A mapped file always gets a new stream, since the current
+    // one may be shared with the reader this one was copied from.
+    if (mCtx.filename != rc.filename || isMapped())
         openRaw(rc.filename);
 
     // Copy the data
@@ -71,9 +78,37 @@ void ESMReader::openRaw(Files::IStreamPtr _esm, const std::string& name)
 
 void ESMReader::openRaw(const std::string& filename)
 {
+    if (mMapping.get() && filename == mMappedFilename)
+    {
+        openRaw(Files::IStreamPtr(new Files::IMemStream(mMapping->data(), mMapping->size())), filename);
+        return;
+    }
+    if (mFileData.get() && filename == mMappedFilename)
+    {
+        openRaw(Files::IStreamPtr(new Files::ISharedMemStream(mFileData)), filename);
+        return;
+    }
+
+    mMapping.reset();
+    mFileData.reset();
+    mMappedFilename.clear();
     openRaw(Files::openConstrainedFileStream(filename.c_str()), filename);
 }
 
+void ESMReader::openMapped(const std::string &file)
+{
+    if (!mMapping.get() || file != mMappedFilename)
+    {
+        boost::shared_ptr<Files::MappedFile> mapping (new Files::MappedFile);
+        mapping->open(file.c_str());
+        mMapping = mapping;
+        mFileData.reset();
+        mMappedFilename = file;
+    }
+
+    open(Files::IStreamPtr(new Files::IMemStream(mMapping->data(), mMapping->size())), file);
+}
+
 void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
 {
     openRaw(_esm, name);
@@ -88,7 +123,52 @@ void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
 
 void ESMReader::open(const std::string &file)
 {
-    open (Files::openConstrainedFileStream (file.c_str ()), file);
+    Files::IStreamPtr stream = Files::openConstrainedFileStream (file.c_str ());
+
+    // Saved games may be compressed into an LZ4 frame as a whole
+    char magic[4];
+    stream->read (magic, sizeof (magic));
+    if (stream->gcount() == sizeof (magic) && Files::isLz4Frame (magic, sizeof (magic)))
+    {
+        stream.reset();
+        openInMemory (file);
+        return;
+    }
+
+    stream->clear();
+    stream->seekg (0, std::ios::beg);
+    open (stream, file);
+}
+
+void ESMReader::openInMemory(const std::string &file)
+{
+    Files::IStreamPtr stream = Files::openConstrainedFileStream (file.c_str ());
+    stream->seekg (0, std::ios::end);
+    Files::SharedBuffer data (new std::vector<char> (static_cast<size_t> (stream->tellg())));
+    stream->seekg (0, std::ios::beg);
+    if (!data->empty())
+        stream->read (&(*data)[0], data->size());
+    if (stream->gcount() != static_cast<std::streamsize> (data->size()))
+        throw std::runtime_error ("Failed to read " + file);
+    stream.reset();
+
+    if (Files::isLz4Frame (data->empty() ? NULL : &(*data)[0], data->size()))
+    {
+        Files::SharedBuffer decompressed (new std::vector<char>);
+        Files::decompressLz4 (&(*data)[0], data->size(), *decompressed);
+        data = decompressed;
+    }
+
+    openInMemory (data, file);
+}
+
+void ESMReader::openInMemory(const boost::shared_ptr<std::vector<char> >& data, const std::string &name)
+{
+    mMapping.reset();
+    mFileData = data;
+    mMappedFilename = name;
+
+    open (Files::IStreamPtr (new Files::ISharedMemStream (mFileData)), name);
 }
 
 int64_t ESMReader::getHNLong(const char *name)
@@ -100,18 +180,33 @@ int64_t ESMReader::getHNLong(const char *name)
 
 std::string ESMReader::getHNOString(const char* name)
 {
-    if (isNextSub(name))
-        return getHString();
-    return "";
+    return getHNOStringView(name).toString();
 }
 
 std::string ESMReader::getHNString(const char* name)
 {
-    getSubNameIs(name);
-    return getHString();
+    return getHNStringView(name).toString();
 }
 
 std::string ESMReader::getHString()
+{
+    return getHStringView().toString();
+}
+
+Misc::StringView ESMReader::getHNOStringView(const char* name)
+{
+    if (isNextSub(name))
+        return getHStringView();
+    return Misc::StringView();
+}
+
+Misc::StringView ESMReader::getHNStringView(const char* name)
+{
+    getSubNameIs(name);
+    return getHStringView();
+}
+
+Misc::StringView ESMReader::getHStringView()
 {
     getSubHeader();
 
@@ -126,10 +221,10 @@ std::string ESMReader::getHString()
         mCtx.leftRec--;
         char c;
         getExact(&c, 1);
-        return "";
+        return Misc::StringView();
     }
 
-    return getString(mCtx.leftSub);
+    return getStringView(mCtx.leftSub);
 }
 
 void ESMReader::getHExact(void*p, int size)
@@ -324,6 +419,11 @@ void ESMReader::getExact(void*x, int size)
 }
 
 std::string ESMReader::getString(int size)
+{
+    return getStringView(size).toString();
+}
+
+Misc::StringView ESMReader::getStringView(int size)
 {
     size_t s = size;
     if (mBuffer.size() <= s)
@@ -340,11 +440,19 @@ std::string ESMReader::getString(int size)
 
     size = strnlen(ptr, size);
 
-    // Convert to UTF8 and return
+    // Convert to UTF8
     if (mEncoder)
-        return mEncoder->getUtf8(ptr, size);
+        return mEncoder->getUtf8View(ptr, size);
 
-    return std::string (ptr, size);
+    return Misc::StringView(ptr, size);
+}
+
+const std::string& ESMReader::intern(const Misc::StringView& str)
+{
+    if (mStringPool)
+        return mStringPool->intern(str);
+    mInternBuffer.assign(str.data(), str.size());
+    return mInternBuffer;
 }
 
 void ESMReader::fail(const std::string &msg)
@@ -7,15 +7,28 @@
 #include <vector>
 #include <sstream>
 
+#include <boost/shared_ptr.hpp>
+
 #include <components/files/constrainedfilestream.hpp>
 
 #include <components/misc/stringops.hpp>
+#include <components/misc/stringview.hpp>
 
 #include <components/to_utf8/to_utf8.hpp>
 
 #include "esmcommon.hpp"
 #include "loadtes3.hpp"
 
+namespace Files
+{
+    class MappedFile;
+}
+
+namespace Misc
+{
+    class StringPool;
+}
+
 namespace ESM {
 
 class ESMReader
@@ -69,10 +82,30 @@ public:
   /// currently open file first, if any.
   void open(Files::IStreamPtr _esm, const std::string &name);
 
+  /// Load ES file, parses the header. Files compressed into an LZ4 frame are decompressed
+  /// into memory first.
   void open(const std::string &file);
 
   void openRaw(const std::string &filename);
 
+  /// Load ES file by mapping it into memory, parses the header.
+  /// Copies of this reader share the mapping, and get a read position of their own
+  /// on every restoreContext(), so they can be used as independent cursors.
+  /// @note Copies share the encoder, which is not thread safe. Give each copy its
+  /// own encoder before using copies on different threads.
+  void openMapped(const std::string &file);
+
+  /// Load ES file by reading it into memory as a whole, parses the header. Files compressed
+  /// into an LZ4 frame are decompressed. Copies of this reader can be used as independent
+  /// cursors, as with openMapped(), but the file itself is not kept open.
+  void openInMemory(const std::string &file);
+
+  /// Load ES file from \a data, which is shared with the reader and its copies, parses the header.
+  /// \a name takes the place of the file name, e.g. in error messages.
+  void openInMemory(const boost::shared_ptr<std::vector<char> >& data, const std::string &name);
+
+  bool isMapped() const { return mMapping.get() != NULL || mFileData.get() != NULL; }
+
   /// Get the current position in the file. Make sure that the file has been opened!
   size_t getFileOffset();
 
@@ -161,6 +194,12 @@ public:
   // Read a string, including the sub-record header (but not the name)
   std::string getHString();
 
+  // Variants of the string getters above that do not create a string. The view points into
+  // an internal buffer, and is only valid until the next read from this reader.
+  Misc::StringView getHNOStringView(const char* name);
+  Misc::StringView getHNStringView(const char* name);
+  Misc::StringView getHStringView();
+
   // Read the given number of bytes from a subrecord
   void getHExact(void*p, int size);
 
@@ -254,6 +293,13 @@ public:
   // Read the next 'size' bytes and return them as a string. Converts
   // them from native encoding to UTF8 in the process.
   std::string getString(int size);
+  Misc::StringView getStringView(int size);
+
+  /// Get the copy of the given string that is held by the string pool. Meant for IDs that are
+  /// repeated across many records.
+  /// @note If no pool is set, the string is copied into a buffer of the reader instead, and the
+  /// reference is only valid until the next call.
+  const std::string& intern(const Misc::StringView& str);
 
   void skip(int bytes);
 
@@ -263,6 +309,9 @@ public:
   /// Sets font encoder for ESM strings
   void setEncoder(ToUTF8::Utf8Encoder* encoder);
 
+  /// Sets the pool used by intern(). The pool can be shared by any number of readers.
+  void setStringPool(Misc::StringPool* pool) { mStringPool = pool; }
+
   /// Get record flags of last record
   unsigned int getRecordFlags() { return mRecordFlags; }
 
@@ -271,6 +320,13 @@ public:
 private:
   Files::IStreamPtr mEsm;
 
+  // Set by openMapped()
+  boost::shared_ptr<Files::MappedFile> mMapping;
+  // Set by openInMemory()
+  boost::shared_ptr<std::vector<char> > mFileData;
+  // Name of the file in mMapping or mFileData
+  std::string mMappedFilename;
+
   ESM_Context mCtx;
 
   unsigned int mRecordFlags;
@@ -284,6 +340,9 @@ private:
 
   std::vector<ESMReader> *mGlobalReaderList;
   ToUTF8::Utf8Encoder* mEncoder;
+  Misc::StringPool* mStringPool;
+  // Holds the result of intern() if no pool is set
+  std::string mInternBuffer;
 
   size_t mFileSize;
 
@@ -1,6 +1,7 @@
 #include "esmwriter.hpp"
 
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <stdexcept>
 
@@ -12,7 +13,6 @@ namespace ESM
         : mStream(NULL)
         , mEncoder (0)
         , mRecordCount (0)
-        , mCounting (true)
     {}
 
     unsigned int ESMWriter::getVersion() const
@@ -67,7 +67,7 @@ namespace ESM
     {
         mRecordCount = 0;
         mRecords.clear();
-        mCounting = true;
+        mBuffer.clear();
         mStream = &file;
 
         startRecord("TES3", 0);
@@ -77,6 +77,14 @@ namespace ESM
         endRecord("TES3");
     }
 
+    void ESMWriter::saveRaw(std::ostream& file)
+    {
+        mRecordCount = 0;
+        mRecords.clear();
+        mBuffer.clear();
+        mStream = &file;
+    }
+
     void ESMWriter::close()
     {
         if (!mRecords.empty())
@@ -87,17 +95,16 @@ namespace ESM
     {
         mRecordCount++;
 
-        writeName(name);
         RecordData rec;
         rec.name = name;
-        rec.position = mStream->tellp();
-        rec.size = 0;
+        mRecords.push_back(rec);
+
+        writeName(name);
+        mRecords.back().position = mBuffer.size();
         writeT<uint32_t>(0); // Size goes here
         writeT<uint32_t>(0); // Unused header?
         writeT(flags);
-        mRecords.push_back(rec);
-
-        assert(mRecords.back().size == 0);
+        mRecords.back().start = mBuffer.size();
     }
 
     void ESMWriter::startRecord (uint32_t name, uint32_t flags)
@@ -115,15 +122,14 @@ namespace ESM
         // Sub-record hierarchies are not properly supported in ESMReader. This should be fixed later.
         assert (mRecords.size() <= 1);
 
-        writeName(name);
         RecordData rec;
         rec.name = name;
-        rec.position = mStream->tellp();
-        rec.size = 0;
-        writeT<uint32_t>(0); // Size goes here
         mRecords.push_back(rec);
 
-        assert(mRecords.back().size == 0);
+        writeName(name);
+        mRecords.back().position = mBuffer.size();
+        writeT<uint32_t>(0); // Size goes here
+        mRecords.back().start = mBuffer.size();
     }
 
     void ESMWriter::endRecord(const std::string& name)
@@ -132,14 +138,11 @@ namespace ESM
         assert(rec.name == name);
         mRecords.pop_back();
 
-        mStream->seekp(rec.position);
-
-        mCounting = false;
-        write (reinterpret_cast<const char*> (&rec.size), sizeof(uint32_t));
-        mCounting = true;
-
-        mStream->seekp(0, std::ios::end);
+        uint32_t size = static_cast<uint32_t>(mBuffer.size() - rec.start);
+        std::memcpy(&mBuffer[rec.position], &size, sizeof(uint32_t));
 
+        if (mRecords.empty())
+            flush();
     }
 
     void ESMWriter::endRecord (uint32_t name)
@@ -211,13 +214,19 @@ namespace ESM
 
     void ESMWriter::write(const char* data, size_t size)
     {
-        if (mCounting && !mRecords.empty())
-        {
-            for (std::list<RecordData>::iterator it = mRecords.begin(); it != mRecords.end(); ++it)
-                it->size += size;
-        }
+        mBuffer.insert(mBuffer.end(), data, data + size);
+
+        if (mRecords.empty())
+            flush();
+    }
+
+    void ESMWriter::flush()
+    {
+        if (mBuffer.empty())
+            return;
 
-        mStream->write(data, size);
+        mStream->write(&mBuffer[0], mBuffer.size());
+        mBuffer.clear(); // keeps the memory for the next record
     }
 
     void ESMWriter::setEncoder(ToUTF8::Utf8Encoder* encoder)
@@ -3,6 +3,7 @@
 
 #include <iosfwd>
 #include <list>
+#include <vector>
 
 #include "esmcommon.hpp"
 #include "loadtes3.hpp"
@@ -19,8 +20,8 @@ class ESMWriter
         struct RecordData
         {
             std::string name;
-            std::streampos position;
-            uint32_t size;
+            size_t position; // of the size in the buffer
+            size_t start; // of the data in the buffer
         };
 
     public:
@@ -52,6 +53,9 @@ class ESMWriter
         void save(std::ostream& file);
         ///< Start saving a file by writing the TES3 header.
 
+        void saveRaw(std::ostream& file);
+        ///< Start saving records without a TES3 header, e.g. into a buffer that is copied into a file later.
+
         void close();
         ///< \note Does not close the stream.
 
@@ -127,12 +131,16 @@ public:
         void write(const char* data, size_t size);
 
     private:
+        void flush();
+        ///< Write the buffered records to the stream.
+
         std::list<RecordData> mRecords;
         std::ostream* mStream;
-        std::streampos mHeaderPos;
+        /// Each top-level record is put together in memory, so that its sizes can be filled in
+        /// without seeking, and then written to the stream in one go.
+        std::vector<char> mBuffer;
         ToUTF8::Utf8Encoder* mEncoder;
         int mRecordCount;
-        bool mCounting;
 
         Header mHeader;
     };
@@ -32,7 +32,7 @@ namespace ESM
                     mIcon = esm.getHString();
                     break;
                 case ESM::FourCC<'S','C','R','I'>::value:
-                    mScript = esm.getHString();
+                    mScript = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'F','N','A','M'>::value:
                     mName = esm.getHString();
@@ -27,7 +27,7 @@ namespace ESM
                     mModel = esm.getHString();
                     break;
                 case ESM::FourCC<'F','N','A','M'>::value:
-                    mRace = esm.getHString();
+                    mRace = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'B','Y','D','T'>::value:
                     esm.getHT(mData, 4);
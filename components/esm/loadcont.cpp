@@ -61,7 +61,7 @@ namespace ESM
                     hasFlags = true;
                     break;
                 case ESM::FourCC<'S','C','R','I'>::value:
-                    mScript = esm.getHString();
+                    mScript = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'N','P','C','O'>::value:
                     mInventory.add(esm);
@@ -46,7 +46,7 @@ namespace ESM {
                     mName = esm.getHString();
                     break;
                 case ESM::FourCC<'S','C','R','I'>::value:
-                    mScript = esm.getHString();
+                    mScript = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'N','P','D','T'>::value:
                     esm.getHT(mData, 96);
@@ -29,7 +29,7 @@ namespace ESM
                     mName = esm.getHString();
                     break;
                 case ESM::FourCC<'S','C','R','I'>::value:
-                    mScript = esm.getHString();
+                    mScript = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'S','N','A','M'>::value:
                     mOpenSound = esm.getHString();
@@ -44,14 +44,14 @@ namespace ESM
                     mActor = esm.getHString();
                     break;
                 case ESM::FourCC<'R','N','A','M'>::value:
-                    mRace = esm.getHString();
+                    mRace = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'C','N','A','M'>::value:
-                    mClass = esm.getHString();
+                    mClass = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'F','N','A','M'>::value:
                 {
-                    mFaction = esm.getHString();
+                    mFaction = esm.intern(esm.getHStringView());
                     if (mFaction == "FFFF")
                     {
                         mFactionLess = true;
@@ -37,7 +37,7 @@ namespace ESM
                     hasData = true;
                     break;
                 case ESM::FourCC<'S','C','R','I'>::value:
-                    mScript = esm.getHString();
+                    mScript = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'S','N','A','M'>::value:
                     mSound = esm.getHString();
@@ -39,22 +39,22 @@ namespace ESM
                     mName = esm.getHString();
                     break;
                 case ESM::FourCC<'R','N','A','M'>::value:
-                    mRace = esm.getHString();
+                    mRace = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'C','N','A','M'>::value:
-                    mClass = esm.getHString();
+                    mClass = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'A','N','A','M'>::value:
-                    mFaction = esm.getHString();
+                    mFaction = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'B','N','A','M'>::value:
-                    mHead = esm.getHString();
+                    mHead = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'K','N','A','M'>::value:
-                    mHair = esm.getHString();
+                    mHair = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'S','C','R','I'>::value:
-                    mScript = esm.getHString();
+                    mScript = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'N','P','D','T'>::value:
                     hasNpdt = true;
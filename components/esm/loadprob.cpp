@@ -34,7 +34,7 @@ namespace ESM
                     hasData = true;
                     break;
                 case ESM::FourCC<'S','C','R','I'>::value:
-                    mScript = esm.getHString();
+                    mScript = esm.intern(esm.getHStringView());
                     break;
                 case ESM::FourCC<'I','T','E','X'>::value:
                     mIcon = esm.getHString();
@@ -0,0 +1,71 @@
+#include "refid.hpp"
+
+#include <ostream>
+
+#include <components/misc/stringops.hpp>
+#include <components/misc/stringpool.hpp>
+
+namespace
+{
+    Misc::StringPool& getPool()
+    {
+        static Misc::StringPool pool;
+        return pool;
+    }
+
+    const std::string* getEmpty()
+    {
+        static const std::string* empty = &getPool().intern(Misc::StringView());
+        return empty;
+    }
+}
+
+namespace ESM
+{
+
+    RefId::RefId()
+        : mId(getEmpty())
+    {
+    }
+
+    RefId::RefId(const char* id)
+    {
+        assign(Misc::StringView(id));
+    }
+
+    RefId::RefId(const std::string& id)
+    {
+        assign(Misc::StringView(id));
+    }
+
+    RefId::RefId(const Misc::StringView& id)
+    {
+        assign(id);
+    }
+
+    void RefId::assign(const Misc::StringView& id)
+    {
+        if (id.empty())
+        {
+            mId = getEmpty();
+            return;
+        }
+
+        // Fold the case without allocating, unless the ID is unusually long
+        char buffer[64];
+        if (id.size() <= sizeof(buffer))
+        {
+            for (size_t i=0; i<id.size(); ++i)
+                buffer[i] = Misc::StringUtils::toLower(id[i]);
+            mId = &getPool().intern(Misc::StringView(buffer, id.size()));
+        }
+        else
+            mId = &getPool().intern(Misc::StringUtils::lowerCase(id.toString()));
+    }
+
+    std::ostream& operator<<(std::ostream& stream, const RefId& id)
+    {
+        return stream << id.getRefIdString();
+    }
+
+}
@@ -0,0 +1,45 @@
+#ifndef OPENMW_ESM_REFID_H
+#define OPENMW_ESM_REFID_H
+
+#include <iosfwd>
+#include <string>
+
+#include <components/misc/stringview.hpp>
+
+namespace ESM
+{
+    /// @brief Case-insensitive record ID, for use as a key and in frequent comparisons.
+    /// @par The ID is folded to lower case and interned once, when the RefId is made. Copying and comparing
+    /// RefIds for equality only involves a pointer; making a RefId of an ID that was seen before does not allocate.
+    /// @note Interned IDs are kept for the remainder of the process.
+    class RefId
+    {
+    public:
+        /// The empty ID
+        RefId();
+
+        explicit RefId(const char* id);
+        explicit RefId(const std::string& id);
+        explicit RefId(const Misc::StringView& id);
+
+        /// The ID in lower case
+        const std::string& getRefIdString() const { return *mId; }
+
+        bool empty() const { return mId->empty(); }
+
+        bool operator==(const RefId& other) const { return mId == other.mId; }
+        bool operator!=(const RefId& other) const { return mId != other.mId; }
+
+        /// Compares the IDs themselves, not their addresses, so containers are ordered the same in every run.
+        bool operator<(const RefId& other) const { return mId != other.mId && *mId < *other.mId; }
+
+    private:
+        void assign(const Misc::StringView& id);
+
+        const std::string* mId;
+    };
+
+    std::ostream& operator<<(std::ostream& stream, const RefId& id);
+}
+
+#endif
@@ -1,8 +1,11 @@
 #include "storage.hpp"
 
+#include <algorithm>
 #include <set>
 #include <iostream>
 
+#include <OpenThreads/ScopedLock>
+
 #include <osg/Image>
 #include <osg/Plane>
 
@@ -11,61 +14,49 @@
 #include <components/misc/resourcehelpers.hpp>
 #include <components/vfs/manager.hpp>
 
-namespace ESMTerrain
+namespace
 {
 
-    Storage::Storage(const VFS::Manager *vfs)
-        : mVFS(vfs)
-    {
-    }
-
-    const ESM::Land::LandData *Storage::getLandData (int cellX, int cellY, int flags)
-    {
-        if (const ESM::Land *land = getLand (cellX, cellY))
-            return land->getLandData (flags);
-
-        return 0;
-    }
-
-    bool Storage::getMinMaxHeights(float size, const osg::Vec2f &center, float &min, float &max)
+    /// The land of the cells of a terrain chunk and of the cells around it, so that the vertices at the edges of the
+    /// cells do not look up their neighbours one by one. Each cell is looked up the first time it is needed.
+    class LandGrid
     {
-        assert (size <= 1 && "Storage::getMinMaxHeights, chunk size should be <= 1 cell");
-
-        /// \todo investigate if min/max heights should be stored at load time in ESM::Land instead
-
-        osg::Vec2f origin = center - osg::Vec2f(size/2.f, size/2.f);
-
-        int cellX = static_cast<int>(std::floor(origin.x()));
-        int cellY = static_cast<int>(std::floor(origin.y()));
-
-        int startRow = (origin.x() - cellX) * ESM::Land::LAND_SIZE;
-        int startColumn = (origin.y() - cellY) * ESM::Land::LAND_SIZE;
-
-        int endRow = startRow + size * (ESM::Land::LAND_SIZE-1) + 1;
-        int endColumn = startColumn + size * (ESM::Land::LAND_SIZE-1) + 1;
+    public:
+        /// @param numCells The number of cells on each side of the chunk
+        LandGrid(ESMTerrain::Storage& storage, int startCellX, int startCellY, int numCells)
+            : mStorage(storage)
+            , mStartX(startCellX-1)
+            , mStartY(startCellY-1)
+            , mSize(numCells+2)
+            , mLand(mSize*mSize)
+            , mFound(mSize*mSize, false)
+        {
+        }
 
-        if (const ESM::Land::LandData *data = getLandData (cellX, cellY, ESM::Land::DATA_VHGT))
+        /// 0 for cells without a land record
+        const ESMTerrain::LandObject* get(int cellX, int cellY) const
         {
-            min = std::numeric_limits<float>::max();
-            max = -std::numeric_limits<float>::max();
-            for (int row=startRow; row<endRow; ++row)
+            assert(cellX >= mStartX && cellX < mStartX+mSize);
+            assert(cellY >= mStartY && cellY < mStartY+mSize);
+            int index = (cellY-mStartY)*mSize + cellX-mStartX;
+            if (!mFound[index])
             {
-                for (int col=startColumn; col<endColumn; ++col)
-                {
-                    float h = data->mHeights[col*ESM::Land::LAND_SIZE+row];
-                    if (h > max)
-                        max = h;
-                    if (h < min)
-                        min = h;
-                }
+                mLand[index] = mStorage.getLandObject(cellX, cellY);
+                mFound[index] = true;
             }
-            return true;
+            return mLand[index].get();
         }
 
-        return false;
-    }
+    private:
+        ESMTerrain::Storage& mStorage;
+        int mStartX;
+        int mStartY;
+        int mSize;
+        mutable std::vector<osg::ref_ptr<const ESMTerrain::LandObject> > mLand;
+        mutable std::vector<bool> mFound;
+    };
 
-    void Storage::fixNormal (osg::Vec3f& normal, int cellX, int cellY, int col, int row)
+    void fixNormal (osg::Vec3f& normal, const LandGrid& grid, int cellX, int cellY, int col, int row)
     {
         while (col >= ESM::Land::LAND_SIZE-1)
         {
@@ -88,29 +79,25 @@ namespace ESMTerrain
             row += ESM::Land::LAND_SIZE-1;
         }
 
-        if (const ESM::Land::LandData *data = getLandData (cellX, cellY, ESM::Land::DATA_VNML))
-        {
-            normal.x() = data->mNormals[col*ESM::Land::LAND_SIZE*3+row*3];
-            normal.y() = data->mNormals[col*ESM::Land::LAND_SIZE*3+row*3+1];
-            normal.z() = data->mNormals[col*ESM::Land::LAND_SIZE*3+row*3+2];
-            normal.normalize();
-        }
+        const ESMTerrain::LandObject* land = grid.get(cellX, cellY);
+        if (land && land->hasNormals())
+            normal = land->getNormals()[col*ESM::Land::LAND_SIZE+row];
         else
             normal = osg::Vec3f(0,0,1);
     }
 
-    void Storage::averageNormal(osg::Vec3f &normal, int cellX, int cellY, int col, int row)
+    void averageNormal(osg::Vec3f &normal, const LandGrid& grid, int cellX, int cellY, int col, int row)
     {
         osg::Vec3f n1,n2,n3,n4;
-        fixNormal(n1, cellX, cellY, col+1, row);
-        fixNormal(n2, cellX, cellY, col-1, row);
-        fixNormal(n3, cellX, cellY, col, row+1);
-        fixNormal(n4, cellX, cellY, col, row-1);
+        fixNormal(n1, grid, cellX, cellY, col+1, row);
+        fixNormal(n2, grid, cellX, cellY, col-1, row);
+        fixNormal(n3, grid, cellX, cellY, col, row+1);
+        fixNormal(n4, grid, cellX, cellY, col, row-1);
         normal = (n1+n2+n3+n4);
         normal.normalize();
     }
 
-    void Storage::fixColour (osg::Vec4f& color, int cellX, int cellY, int col, int row)
+    void fixColour (osg::Vec4f& color, const LandGrid& grid, int cellX, int cellY, int col, int row)
     {
         if (col == ESM::Land::LAND_SIZE-1)
         {
@@ -123,11 +110,13 @@ namespace ESMTerrain
             row = 0;
         }
 
-        if (const ESM::Land::LandData *data = getLandData (cellX, cellY, ESM::Land::DATA_VCLR))
+        const ESMTerrain::LandObject* land = grid.get(cellX, cellY);
+        if (land && land->hasColours())
         {
-            color.r() = data->mColours[col*ESM::Land::LAND_SIZE*3+row*3] / 255.f;
-            color.g() = data->mColours[col*ESM::Land::LAND_SIZE*3+row*3+1] / 255.f;
-            color.b() = data->mColours[col*ESM::Land::LAND_SIZE*3+row*3+2] / 255.f;
+            const osg::Vec4ub& colour = land->getColours()[col*ESM::Land::LAND_SIZE+row];
+            color.r() = colour.r() / 255.f;
+            color.g() = colour.g() / 255.f;
+            color.b() = colour.b() / 255.f;
         }
         else
         {
@@ -138,6 +127,144 @@ namespace ESMTerrain
 
     }
 
+}
+
+namespace ESMTerrain
+{
+
+    LandObject::LandObject(const ESM::Land &land)
+        : mMinHeight(-2048)
+        , mMaxHeight(-2048)
+        , mPlugin(land.mPlugin)
+    {
+        if (const ESM::Land::LandData *data = land.getLandData(ESM::Land::DATA_VHGT))
+        {
+            mHeights.assign(data->mHeights, data->mHeights + ESM::Land::LAND_NUM_VERTS);
+            mMinHeight = *std::min_element(mHeights.begin(), mHeights.end());
+            mMaxHeight = *std::max_element(mHeights.begin(), mHeights.end());
+        }
+
+        if (const ESM::Land::LandData *data = land.getLandData(ESM::Land::DATA_VNML))
+        {
+            mNormals.resize(ESM::Land::LAND_NUM_VERTS);
+            for (int i=0; i<ESM::Land::LAND_NUM_VERTS; ++i)
+            {
+                mNormals[i] = osg::Vec3f(data->mNormals[i*3], data->mNormals[i*3+1], data->mNormals[i*3+2]);
+                mNormals[i].normalize();
+            }
+        }
+
+        if (const ESM::Land::LandData *data = land.getLandData(ESM::Land::DATA_VCLR))
+        {
+            mColours.resize(ESM::Land::LAND_NUM_VERTS);
+            for (int i=0; i<ESM::Land::LAND_NUM_VERTS; ++i)
+                mColours[i] = osg::Vec4ub(data->mColours[i*3], data->mColours[i*3+1], data->mColours[i*3+2], 255);
+        }
+
+        if (const ESM::Land::LandData *data = land.getLandData(ESM::Land::DATA_VTEX))
+            mTextures.assign(data->mTextures, data->mTextures + ESM::Land::LAND_NUM_TEXTURES);
+    }
+
+    Storage::Storage(const VFS::Manager *vfs)
+        : mVFS(vfs)
+        , mLandCacheSize(256)
+    {
+    }
+
+    osg::ref_ptr<const LandObject> Storage::getLandObject(int cellX, int cellY)
+    {
+        CellCoord coord(cellX, cellY);
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mLandCacheMutex);
+            LandCache::iterator found = mLandCache.find(coord);
+            if (found != mLandCache.end())
+            {
+                mLandLru.splice(mLandLru.begin(), mLandLru, found->second.mLruPosition);
+                return found->second.mLand;
+            }
+        }
+
+        // Decode without holding the lock, so that threads reading other cells are not held up
+        osg::ref_ptr<const LandObject> landObject;
+        if (const ESM::Land* land = getLand(cellX, cellY))
+            landObject = new LandObject(*land);
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mLandCacheMutex);
+        LandCache::iterator found = mLandCache.find(coord);
+        if (found != mLandCache.end())
+        {
+            // Another thread decoded the same cell in the meantime
+            mLandLru.splice(mLandLru.begin(), mLandLru, found->second.mLruPosition);
+            return found->second.mLand;
+        }
+
+        mLandLru.push_front(coord);
+        LandCacheEntry& entry = mLandCache[coord];
+        entry.mLand = landObject;
+        entry.mLruPosition = mLandLru.begin();
+
+        while (mLandCache.size() > mLandCacheSize)
+        {
+            mLandCache.erase(mLandLru.back());
+            mLandLru.pop_back();
+        }
+
+        return landObject;
+    }
+
+    void Storage::loadCell(int cellX, int cellY)
+    {
+        for (int x = cellX-1; x <= cellX+1; ++x)
+            for (int y = cellY-1; y <= cellY+1; ++y)
+                getLandObject(x, y);
+    }
+
+    bool Storage::getMinMaxHeights(float size, const osg::Vec2f &center, float &min, float &max)
+    {
+        assert (size <= 1 && "Storage::getMinMaxHeights, chunk size should be <= 1 cell");
+
+        /// \todo investigate if min/max heights should be stored at load time in ESM::Land instead
+
+        osg::Vec2f origin = center - osg::Vec2f(size/2.f, size/2.f);
+
+        int cellX = static_cast<int>(std::floor(origin.x()));
+        int cellY = static_cast<int>(std::floor(origin.y()));
+
+        int startRow = (origin.x() - cellX) * ESM::Land::LAND_SIZE;
+        int startColumn = (origin.y() - cellY) * ESM::Land::LAND_SIZE;
+
+        int endRow = startRow + size * (ESM::Land::LAND_SIZE-1) + 1;
+        int endColumn = startColumn + size * (ESM::Land::LAND_SIZE-1) + 1;
+
+        osg::ref_ptr<const LandObject> land = getLandObject(cellX, cellY);
+        if (land && land->hasHeights())
+        {
+            if (startRow == 0 && startColumn == 0 && endRow == ESM::Land::LAND_SIZE && endColumn == ESM::Land::LAND_SIZE)
+            {
+                min = land->getMinHeight();
+                max = land->getMaxHeight();
+                return true;
+            }
+
+            min = std::numeric_limits<float>::max();
+            max = -std::numeric_limits<float>::max();
+            for (int row=startRow; row<endRow; ++row)
+            {
+                for (int col=startColumn; col<endColumn; ++col)
+                {
+                    float h = land->getHeight(row, col);
+                    if (h > max)
+                        max = h;
+                    if (h < min)
+                        min = h;
+                }
+            }
+            return true;
+        }
+
+        return false;
+    }
+
     void Storage::fillVertexBuffers (int lodLevel, float size, const osg::Vec2f& center,
                                             osg::ref_ptr<osg::Vec3Array> positions,
                                             osg::ref_ptr<osg::Vec3Array> normals,
@@ -157,6 +284,9 @@ namespace ESMTerrain
         normals->resize(numVerts*numVerts);
         colours->resize(numVerts*numVerts);
 
+        const int numCells = static_cast<int>(std::ceil(size));
+        const LandGrid grid(*this, startCellX, startCellY, numCells);
+
         osg::Vec3f normal;
         osg::Vec4f color;
 
@@ -164,14 +294,15 @@ namespace ESMTerrain
         float vertX = 0;
 
         float vertY_ = 0; // of current cell corner
-        for (int cellY = startCellY; cellY < startCellY + std::ceil(size); ++cellY)
+        for (int cellY = startCellY; cellY < startCellY + numCells; ++cellY)
         {
             float vertX_ = 0; // of current cell corner
-            for (int cellX = startCellX; cellX < startCellX + std::ceil(size); ++cellX)
+            for (int cellX = startCellX; cellX < startCellX + numCells; ++cellX)
             {
-                const ESM::Land::LandData *heightData = getLandData (cellX, cellY, ESM::Land::DATA_VHGT);
-                const ESM::Land::LandData *normalData = getLandData (cellX, cellY, ESM::Land::DATA_VNML);
-                const ESM::Land::LandData *colourData = getLandData (cellX, cellY, ESM::Land::DATA_VCLR);
+                const LandObject* land = grid.get(cellX, cellY);
+                const float* heightData = land && land->hasHeights() ? land->getHeights() : NULL;
+                const osg::Vec3f* normalData = land && land->hasNormals() ? land->getNormals() : NULL;
+                const osg::Vec4ub* colourData = land && land->hasColours() ? land->getColours() : NULL;
 
                 int rowStart = 0;
                 int colStart = 0;
@@ -195,7 +326,7 @@ namespace ESMTerrain
                     vertX = vertX_;
                     for (int row=rowStart; row<rowEnd; row += increment)
                     {
-                        int srcArrayIndex = col*ESM::Land::LAND_SIZE*3+row*3;
+                        int srcArrayIndex = col*ESM::Land::LAND_SIZE+row;
 
                         assert(row >= 0 && row < ESM::Land::LAND_SIZE);
                         assert(col >= 0 && col < ESM::Land::LAND_SIZE);
@@ -205,7 +336,7 @@ namespace ESMTerrain
 
                         float height = -2048;
                         if (heightData)
-                            height = heightData->mHeights[col*ESM::Land::LAND_SIZE + row];
+                            height = heightData[srcArrayIndex];
 
                         (*positions)[static_cast<unsigned int>(vertX*numVerts + vertY)]
                             = osg::Vec3f((vertX / float(numVerts - 1) - 0.5f) * size * 8192,
@@ -213,22 +344,17 @@ namespace ESMTerrain
                                          height);
 
                         if (normalData)
-                        {
-                            for (int i=0; i<3; ++i)
-                                normal[i] = normalData->mNormals[srcArrayIndex+i];
-
-                            normal.normalize();
-                        }
+                            normal = normalData[srcArrayIndex];
                         else
                             normal = osg::Vec3f(0,0,1);
 
                         // Normals apparently don't connect seamlessly between cells
                         if (col == ESM::Land::LAND_SIZE-1 || row == ESM::Land::LAND_SIZE-1)
-                            fixNormal(normal, cellX, cellY, col, row);
+                            fixNormal(normal, grid, cellX, cellY, col, row);
 
                         // some corner normals appear to be complete garbage (z < 0)
                         if ((row == 0 || row == ESM::Land::LAND_SIZE-1) && (col == 0 || col == ESM::Land::LAND_SIZE-1))
-                            averageNormal(normal, cellX, cellY, col, row);
+                            averageNormal(normal, grid, cellX, cellY, col, row);
 
                         assert(normal.z() > 0);
 
@@ -237,7 +363,7 @@ namespace ESMTerrain
                         if (colourData)
                         {
                             for (int i=0; i<3; ++i)
-                                color[i] = colourData->mColours[srcArrayIndex+i] / 255.f;
+                                color[i] = colourData[srcArrayIndex][i] / 255.f;
                         }
                         else
                         {
@@ -248,7 +374,7 @@ namespace ESMTerrain
 
                         // Unlike normals, colors mostly connect seamlessly between cells, but not always...
                         if (col == ESM::Land::LAND_SIZE-1 || row == ESM::Land::LAND_SIZE-1)
-                            fixColour(color, cellX, cellY, col, row);
+                            fixColour(color, grid, cellX, cellY, col, row);
 
                         color.a() = 1;
 
@@ -287,12 +413,13 @@ namespace ESMTerrain
         assert(x<ESM::Land::LAND_TEXTURE_SIZE);
         assert(y<ESM::Land::LAND_TEXTURE_SIZE);
 
-        if (const ESM::Land::LandData *data = getLandData (cellX, cellY, ESM::Land::DATA_VTEX))
+        osg::ref_ptr<const LandObject> land = getLandObject(cellX, cellY);
+        if (land && land->hasTextures())
         {
-            int tex = data->mTextures[y * ESM::Land::LAND_TEXTURE_SIZE + x];
+            int tex = land->getTexture(x, y);
             if (tex == 0)
                 return std::make_pair(0,0); // vtex 0 is always the base texture, regardless of plugin
-            return std::make_pair(tex, getLand (cellX, cellY)->mPlugin);
+            return std::make_pair(tex, land->getPlugin());
         }
         else
             return std::make_pair(0,0);
@@ -410,8 +537,8 @@ namespace ESMTerrain
         int cellX = static_cast<int>(std::floor(worldPos.x() / 8192.f));
         int cellY = static_cast<int>(std::floor(worldPos.y() / 8192.f));
 
-        const ESM::Land* land = getLand(cellX, cellY);
-        if (!land || !(land->mDataTypes&ESM::Land::DATA_VHGT))
+        osg::ref_ptr<const LandObject> land = getLandObject(cellX, cellY);
+        if (!land || !land->hasHeights())
             return -2048;
 
         // Mostly lifted from Ogre::Terrain::getHeightAtTerrainPosition
@@ -450,10 +577,10 @@ namespace ESMTerrain
         */
 
         // Build all 4 positions in normalized cell space, using point-sampled height
-        osg::Vec3f v0 (startXTS, startYTS, getVertexHeight(land, startX, startY) / 8192.f);
-        osg::Vec3f v1 (endXTS, startYTS, getVertexHeight(land, endX, startY) / 8192.f);
-        osg::Vec3f v2 (endXTS, endYTS, getVertexHeight(land, endX, endY) / 8192.f);
-        osg::Vec3f v3 (startXTS, endYTS, getVertexHeight(land, startX, endY) / 8192.f);
+        osg::Vec3f v0 (startXTS, startYTS, land->getHeight(startX, startY) / 8192.f);
+        osg::Vec3f v1 (endXTS, startYTS, land->getHeight(endX, startY) / 8192.f);
+        osg::Vec3f v2 (endXTS, endYTS, land->getHeight(endX, endY) / 8192.f);
+        osg::Vec3f v3 (startXTS, endYTS, land->getHeight(startX, endY) / 8192.f);
         // define this plane in terrain space
         osg::Plane plane;
         // FIXME: deal with differing triangle alignment
@@ -485,19 +612,15 @@ namespace ESMTerrain
 
     }
 
-    float Storage::getVertexHeight(const ESM::Land *land, int x, int y)
-    {
-        assert(x < ESM::Land::LAND_SIZE);
-        assert(y < ESM::Land::LAND_SIZE);
-        return land->getLandData()->mHeights[y * ESM::Land::LAND_SIZE + x];
-    }
-
     Terrain::LayerInfo Storage::getLayerInfo(const std::string& texture)
     {
         // Already have this cached?
-        std::map<std::string, Terrain::LayerInfo>::iterator found = mLayerInfoMap.find(texture);
-        if (found != mLayerInfoMap.end())
-            return found->second;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mLayerInfoMutex);
+            std::map<std::string, Terrain::LayerInfo>::iterator found = mLayerInfoMap.find(texture);
+            if (found != mLayerInfoMap.end())
+                return found->second;
+        }
 
         Terrain::LayerInfo info;
         info.mParallax = false;
@@ -527,7 +650,10 @@ namespace ESMTerrain
             info.mSpecular = true;
         }
 
-        mLayerInfoMap[texture] = info;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mLayerInfoMutex);
+            mLayerInfoMap[texture] = info;
+        }
 
         return info;
     }
@@ -1,6 +1,17 @@
 #ifndef COMPONENTS_ESM_TERRAIN_STORAGE_H
 #define COMPONENTS_ESM_TERRAIN_STORAGE_H
 
+#include <list>
+#include <map>
+#include <vector>
+
+#include <OpenThreads/Mutex>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Vec3f>
+#include <osg/Vec4ub>
+
 #include <components/terrain/storage.hpp>
 
 #include <components/esm/loadland.hpp>
@@ -14,6 +25,45 @@ namespace VFS
 namespace ESMTerrain
 {
 
+    /// @brief The vertex data of an ESM::Land record, decoded once so that rendering, physics and height queries can share it.
+    /// @par The arrays hold ESM::Land::LAND_SIZE * ESM::Land::LAND_SIZE vertices, row by row along the x-axis, like
+    /// ESM::Land::LandData. They are empty if the record has no data of their type.
+    /// @note Reference counted, so users such as physics heightfields keep the data alive after it left the cache of the Storage.
+    class LandObject : public osg::Referenced
+    {
+    public:
+        LandObject(const ESM::Land& land);
+
+        bool hasHeights() const { return !mHeights.empty(); }
+        bool hasNormals() const { return !mNormals.empty(); }
+        bool hasColours() const { return !mColours.empty(); }
+        bool hasTextures() const { return !mTextures.empty(); }
+
+        const float* getHeights() const { return &mHeights[0]; }
+        /// Normalized.
+        const osg::Vec3f* getNormals() const { return &mNormals[0]; }
+        const osg::Vec4ub* getColours() const { return &mColours[0]; }
+
+        float getHeight(int x, int y) const { return mHeights[y * ESM::Land::LAND_SIZE + x]; }
+
+        float getMinHeight() const { return mMinHeight; }
+        float getMaxHeight() const { return mMaxHeight; }
+
+        /// The VTEX index at the given texel, as ESM::Land::LandData::mTextures.
+        int getTexture(int x, int y) const { return mTextures[y * ESM::Land::LAND_TEXTURE_SIZE + x]; }
+
+        short getPlugin() const { return mPlugin; }
+
+    private:
+        std::vector<float> mHeights;
+        std::vector<osg::Vec3f> mNormals;
+        std::vector<osg::Vec4ub> mColours;
+        std::vector<unsigned short> mTextures;
+        float mMinHeight;
+        float mMaxHeight;
+        short mPlugin;
+    };
+
     /// @brief Feeds data from ESM terrain records (ESM::Land, ESM::LandTexture)
     ///        into the terrain component, converting it on the fly as needed.
     class Storage : public Terrain::Storage
@@ -27,15 +77,18 @@ namespace ESMTerrain
     public:
         Storage(const VFS::Manager* vfs);
 
-        /// Data is loaded first, if necessary. Will return a 0-pointer if there is no data for
-        /// any of the data types specified via \a flags. Will also return a 0-pointer if there
-        /// is no land record for the coordinates \a cellX / \a cellY.
-        const ESM::Land::LandData *getLandData (int cellX, int cellY, int flags);
+        /// Get the decoded data of the land record of a cell, decoding it first if it is not in the cache.
+        /// Returns a 0-pointer if there is no land record for the cell.
+        /// @note Thread safe, as long as the land record was loaded on the main thread before, see loadCell().
+        osg::ref_ptr<const LandObject> getLandObject (int cellX, int cellY);
 
         // Not implemented in this class, because we need different Store implementations for game and editor
         /// Get bounds of the whole terrain in cell units
         virtual void getBounds(float& minX, float& maxX, float& minY, float& maxY) = 0;
 
+        /// Loads and decodes the land data of the cell and of the cells around it, which are needed for its edges.
+        virtual void loadCell(int cellX, int cellY);
+
         /// Get the minimum and maximum heights of a terrain region.
         /// @note Will only be called for chunks with size = minBatchSize, i.e. leafs of the quad tree.
         ///        Larger chunks can simply merge AABB of children.
@@ -89,12 +142,6 @@ namespace ESMTerrain
     private:
         const VFS::Manager* mVFS;
 
-        void fixNormal (osg::Vec3f& normal, int cellX, int cellY, int col, int row);
-        void fixColour (osg::Vec4f& colour, int cellX, int cellY, int col, int row);
-        void averageNormal (osg::Vec3f& normal, int cellX, int cellY, int col, int row);
-
-        float getVertexHeight (const ESM::Land* land, int x, int y);
-
         // Since plugins can define new texture palettes, we need to know the plugin index too
         // in order to retrieve the correct texture name.
         // pair  <texture id, plugin id>
@@ -105,8 +152,25 @@ namespace ESMTerrain
         std::string getTextureName (UniqueTextureId id);
 
         std::map<std::string, Terrain::LayerInfo> mLayerInfoMap;
+        OpenThreads::Mutex mLayerInfoMutex;
 
         Terrain::LayerInfo getLayerInfo(const std::string& texture);
+
+        typedef std::pair<int, int> CellCoord;
+        // The least recently used cell is at the back
+        typedef std::list<CellCoord> LandLruList;
+        struct LandCacheEntry
+        {
+            // 0 for cells without a land record
+            osg::ref_ptr<const LandObject> mLand;
+            LandLruList::iterator mLruPosition;
+        };
+        typedef std::map<CellCoord, LandCacheEntry> LandCache;
+        LandCache mLandCache;
+        LandLruList mLandLru;
+        // The number of cells to keep decoded. Distant land chunks read many cells for one build.
+        unsigned int mLandCacheSize;
+        OpenThreads::Mutex mLandCacheMutex;
     };
 
 }
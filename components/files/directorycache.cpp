@@ -0,0 +1,163 @@
+#include "directorycache.hpp"
+
+#include <iostream>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+namespace
+{
+    const char* const sHeader = "OpenMW directory cache 1";
+}
+
+namespace Files
+{
+
+    DirectoryCache::DirectoryCache()
+        : mChanged(false)
+    {
+    }
+
+    void DirectoryCache::load(const boost::filesystem::path &file)
+    {
+        boost::filesystem::ifstream stream(file);
+        if (!stream.is_open())
+            return;
+
+        std::string line;
+        if (!std::getline(stream, line) || line != sHeader)
+            return;
+
+        std::map<std::string, Entry> entries;
+
+        // Each listing is one line "<mtime> <number of dirs> <number of files> <path>",
+        // followed by one line per subdirectory and one line per file.
+        while (std::getline(stream, line))
+        {
+            std::istringstream header(line);
+            long long modified;
+            size_t numDirectories, numFiles;
+            if (!(header >> modified >> numDirectories >> numFiles) || header.get() != ' ')
+                return;
+            std::string path;
+            std::getline(header, path);
+
+            Entry& entry = entries[path];
+            entry.mListing.mModified = static_cast<std::time_t>(modified);
+            entry.mUsed = false;
+
+            for (size_t i=0; i<numDirectories+numFiles; ++i)
+            {
+                if (!std::getline(stream, line))
+                    return;
+                (i < numDirectories ? entry.mListing.mDirectories : entry.mListing.mFiles).push_back(line);
+            }
+        }
+
+        boost::mutex::scoped_lock lock(mMutex);
+        mEntries.swap(entries);
+        mChanged = false;
+    }
+
+    void DirectoryCache::save(const boost::filesystem::path &file)
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+
+        // Entries of directories that were not seen this time are dropped, so
+        // the cache does not grow when data directories are removed
+        bool dropped = false;
+        for (std::map<std::string, Entry>::iterator it = mEntries.begin(); it != mEntries.end();)
+        {
+            if (!it->second.mUsed)
+            {
+                mEntries.erase(it++);
+                dropped = true;
+            }
+            else
+                ++it;
+        }
+
+        if (!mChanged && !dropped)
+            return;
+
+        try
+        {
+            if (file.has_parent_path() && !boost::filesystem::exists(file.parent_path()))
+                boost::filesystem::create_directories(file.parent_path());
+
+            boost::filesystem::ofstream stream(file, std::ios::out | std::ios::trunc);
+            if (!stream.is_open())
+                throw std::runtime_error("can not open file for writing");
+
+            stream << sHeader << '\n';
+            for (std::map<std::string, Entry>::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+            {
+                const Listing& listing = it->second.mListing;
+                stream << static_cast<long long>(listing.mModified) << ' ' << listing.mDirectories.size() << ' '
+                       << listing.mFiles.size() << ' ' << it->first << '\n';
+
+                for (std::vector<std::string>::const_iterator name = listing.mDirectories.begin(); name != listing.mDirectories.end(); ++name)
+                    stream << *name << '\n';
+                for (std::vector<std::string>::const_iterator name = listing.mFiles.begin(); name != listing.mFiles.end(); ++name)
+                    stream << *name << '\n';
+            }
+
+            mChanged = false;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to write directory cache " << file.string() << ": " << e.what() << std::endl;
+        }
+    }
+
+    DirectoryCache::Listing DirectoryCache::getListing(const boost::filesystem::path &directory)
+    {
+        const std::string key = directory.string();
+        const std::time_t modified = boost::filesystem::last_write_time(directory);
+
+        {
+            boost::mutex::scoped_lock lock(mMutex);
+            std::map<std::string, Entry>::iterator found = mEntries.find(key);
+            if (found != mEntries.end() && found->second.mListing.mModified == modified)
+            {
+                found->second.mUsed = true;
+                return found->second.mListing;
+            }
+        }
+
+        Listing listing;
+        listing.mModified = modified;
+
+        for (boost::filesystem::directory_iterator it (directory); it != boost::filesystem::directory_iterator(); ++it)
+        {
+            const std::string name = it->path().filename().string();
+            // Names are stored one per line
+            if (name.find('\n') != std::string::npos)
+                continue;
+
+            if (boost::filesystem::is_directory(it->status()))
+            {
+                // Like recursive_directory_iterator, don't follow symlinks to directories
+                if (!boost::filesystem::is_symlink(it->symlink_status()))
+                    listing.mDirectories.push_back(name);
+            }
+            else
+                listing.mFiles.push_back(name);
+        }
+
+        // Modification times only have a resolution of one second, so a directory changed again within the
+        // same second as it was listed would look unchanged. Don't cache those until they have settled.
+        if (modified < std::time(NULL) - 1)
+        {
+            boost::mutex::scoped_lock lock(mMutex);
+            Entry& entry = mEntries[key];
+            entry.mListing = listing;
+            entry.mUsed = true;
+            mChanged = true;
+        }
+
+        return listing;
+    }
+
+}
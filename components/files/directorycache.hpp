@@ -0,0 +1,59 @@
+#ifndef COMPONENTS_FILES_DIRECTORYCACHE_HPP
+#define COMPONENTS_FILES_DIRECTORYCACHE_HPP
+
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace Files
+{
+
+    /// @brief Persistent cache of directory listings, keyed by the modification time of each directory.
+    /// @par A directory's modification time changes whenever an entry is added, removed or renamed in it,
+    /// so a listing whose directory still has the recorded time can be used instead of reading the directory again.
+    /// @note Thread safe, the same cache may be used by several archives that are scanned concurrently.
+    class DirectoryCache
+    {
+    public:
+        struct Listing
+        {
+            std::time_t mModified;
+
+            /// Names of the subdirectories
+            std::vector<std::string> mDirectories;
+            /// Names of all other entries
+            std::vector<std::string> mFiles;
+        };
+
+        DirectoryCache();
+
+        /// Load listings from the given cache file. A missing or unreadable file just leaves the cache empty.
+        void load(const boost::filesystem::path& file);
+
+        /// Write the listings that were requested since loading back to the given cache file, if any changed.
+        /// @note Errors are logged and otherwise ignored, the cache is an optimization only.
+        void save(const boost::filesystem::path& file);
+
+        /// Get the listing of the given directory, from the cache if it is still up to date.
+        /// @note Throws an exception if the directory can not be read.
+        Listing getListing(const boost::filesystem::path& directory);
+
+    private:
+        struct Entry
+        {
+            Listing mListing;
+            bool mUsed;
+        };
+
+        boost::mutex mMutex;
+        std::map<std::string, Entry> mEntries;
+        bool mChanged;
+    };
+
+}
+
+#endif
@@ -0,0 +1,356 @@
+#include "lz4.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+
+    const uint32_t sFrameMagic = 0x184D2204;
+    // Skippable frames use the magic numbers 0x184D2A50 to 0x184D2A5F
+    const uint32_t sSkippableMask = 0xFFFFFFF0;
+    const uint32_t sSkippableMagic = 0x184D2A50;
+
+    const size_t sMaxOffset = 0xffff;
+    const int sHashBits = 16;
+    /// Block size ID 7, i.e. 4 MiB
+    const unsigned int sCompressedBlockSizeId = 7;
+    const size_t sCompressedBlockSize = size_t(1) << (8 + 2 * sCompressedBlockSizeId);
+
+    void fail(const char* message)
+    {
+        throw std::runtime_error(std::string("LZ4 error: ") + message);
+    }
+
+    uint32_t readUInt32(const unsigned char* data)
+    {
+        return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+    }
+
+    void writeUInt32(uint32_t value, std::vector<char>& out)
+    {
+        out.push_back(static_cast<char>(value & 0xff));
+        out.push_back(static_cast<char>((value >> 8) & 0xff));
+        out.push_back(static_cast<char>((value >> 16) & 0xff));
+        out.push_back(static_cast<char>((value >> 24) & 0xff));
+    }
+
+    uint32_t rotateLeft(uint32_t value, int bits)
+    {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    /// xxHash32 with seed 0, as used for the frame descriptor checksum. Only handles inputs shorter
+    /// than 16 bytes, which is all a frame descriptor can be.
+    uint32_t hashDescriptor(const unsigned char* data, size_t size)
+    {
+        const uint32_t prime1 = 2654435761u;
+        const uint32_t prime2 = 2246822519u;
+        const uint32_t prime3 = 3266489917u;
+        const uint32_t prime4 = 668265263u;
+        const uint32_t prime5 = 374761393u;
+
+        uint32_t hash = prime5 + static_cast<uint32_t>(size);
+        size_t i = 0;
+        for (; i + 4 <= size; i += 4)
+            hash = rotateLeft(hash + readUInt32(data + i) * prime3, 17) * prime4;
+        for (; i < size; ++i)
+            hash = rotateLeft(hash + data[i] * prime5, 11) * prime1;
+
+        hash ^= hash >> 15;
+        hash *= prime2;
+        hash ^= hash >> 13;
+        hash *= prime3;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    void writeLength(size_t length, std::vector<char>& out)
+    {
+        for (; length >= 255; length -= 255)
+            out.push_back(static_cast<char>(255));
+        out.push_back(static_cast<char>(length));
+    }
+
+    void writeSequence(const unsigned char* literals, size_t literalCount, size_t offset, size_t matchLength, std::vector<char>& out)
+    {
+        const size_t matchCode = matchLength ? matchLength - 4 : 0;
+        out.push_back(static_cast<char>(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+        if (literalCount >= 15)
+            writeLength(literalCount - 15, out);
+        out.insert(out.end(), reinterpret_cast<const char*>(literals), reinterpret_cast<const char*>(literals + literalCount));
+
+        // The last sequence of a block only has literals
+        if (!matchLength)
+            return;
+
+        out.push_back(static_cast<char>(offset & 0xff));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (matchCode >= 15)
+            writeLength(matchCode - 15, out);
+    }
+
+    /// Encode one block independently of the others, appending to out.
+    void encodeBlock(const unsigned char* in, size_t size, std::vector<uint32_t>& table, std::vector<char>& out)
+    {
+        // The format requires the last match to start at least 12 bytes before the end of the block,
+        // and the last 5 bytes to be literals
+        const size_t matchStartLimit = size > 12 ? size - 12 : 0;
+        const size_t matchEndLimit = size > 5 ? size - 5 : 0;
+        const uint32_t empty = 0xffffffffu;
+
+        std::fill(table.begin(), table.end(), empty);
+
+        size_t anchor = 0;
+        size_t pos = 0;
+        while (pos < matchStartLimit)
+        {
+            const uint32_t sequence = readUInt32(in + pos);
+            uint32_t& entry = table[(sequence * 2654435761u) >> (32 - sHashBits)];
+            const size_t candidate = entry;
+            entry = static_cast<uint32_t>(pos);
+
+            if (candidate == empty || pos - candidate > sMaxOffset || readUInt32(in + candidate) != sequence)
+            {
+                ++pos;
+                continue;
+            }
+
+            size_t length = 4;
+            while (pos + length < matchEndLimit && in[candidate + length] == in[pos + length])
+                ++length;
+
+            writeSequence(in + anchor, pos - anchor, pos - candidate, length, out);
+            pos += length;
+            anchor = pos;
+        }
+
+        writeSequence(in + anchor, size - anchor, 0, 0, out);
+    }
+
+    /// Decode one compressed block, appending to out. Matches may refer back to any data already in out.
+    void decodeBlock(const unsigned char* in, size_t size, std::vector<char>& out, size_t maxOutput)
+    {
+        const unsigned char* end = in + size;
+        const size_t outputStart = out.size();
+
+        while (in < end)
+        {
+            const unsigned int token = *in++;
+
+            size_t literals = token >> 4;
+            if (literals == 15)
+            {
+                unsigned char byte;
+                do
+                {
+                    if (in >= end)
+                        fail("truncated literal length");
+                    byte = *in++;
+                    literals += byte;
+                } while (byte == 255);
+            }
+
+            if (size_t(end - in) < literals)
+                fail("truncated literals");
+            if (out.size() - outputStart + literals > maxOutput)
+                fail("block exceeds the maximum block size");
+            out.insert(out.end(), reinterpret_cast<const char*>(in), reinterpret_cast<const char*>(in + literals));
+            in += literals;
+
+            // The last sequence of a block only has literals
+            if (in == end)
+                break;
+
+            if (end - in < 2)
+                fail("truncated match offset");
+            const size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+            in += 2;
+            if (offset == 0 || offset > out.size())
+                fail("invalid match offset");
+
+            size_t matchLength = token & 0xf;
+            if (matchLength == 15)
+            {
+                unsigned char byte;
+                do
+                {
+                    if (in >= end)
+                        fail("truncated match length");
+                    byte = *in++;
+                    matchLength += byte;
+                } while (byte == 255);
+            }
+            matchLength += 4;
+
+            if (out.size() - outputStart + matchLength > maxOutput)
+                fail("block exceeds the maximum block size");
+
+            // Matches may overlap the data they produce, so copy byte by byte
+            size_t from = out.size() - offset;
+            out.resize(out.size() + matchLength);
+            char* dest = &out[0];
+            for (size_t i = out.size() - matchLength; i < out.size(); ++i, ++from)
+                dest[i] = dest[from];
+        }
+    }
+
+}
+
+namespace Files
+{
+
+    bool isLz4Frame(const char *data, size_t size)
+    {
+        return size >= 4 && readUInt32(reinterpret_cast<const unsigned char*>(data)) == sFrameMagic;
+    }
+
+    void decompressLz4(const char *data, size_t size, std::vector<char> &out)
+    {
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char* end = in + size;
+
+        if (!isLz4Frame(data, size))
+            fail("not an LZ4 frame");
+
+        while (in < end)
+        {
+            if (end - in < 4)
+                fail("truncated frame");
+            const uint32_t magic = readUInt32(in);
+            in += 4;
+
+            if ((magic & sSkippableMask) == sSkippableMagic)
+            {
+                if (end - in < 4)
+                    fail("truncated skippable frame");
+                const uint32_t skip = readUInt32(in);
+                in += 4;
+                if (size_t(end - in) < skip)
+                    fail("truncated skippable frame");
+                in += skip;
+                continue;
+            }
+
+            if (magic != sFrameMagic)
+                fail("unknown frame magic number");
+
+            // Frame descriptor
+            if (end - in < 3)
+                fail("truncated frame descriptor");
+            const unsigned int flags = in[0];
+            const unsigned int blockDescriptor = in[1];
+            in += 2;
+
+            if ((flags >> 6) != 1)
+                fail("unsupported frame version");
+            if (flags & 0x1)
+                fail("frames using a dictionary are not supported");
+            const bool blockChecksums = (flags & 0x10) != 0;
+            const bool contentSize = (flags & 0x08) != 0;
+            const bool contentChecksum = (flags & 0x04) != 0;
+
+            const unsigned int blockSizeId = (blockDescriptor >> 4) & 0x7;
+            if (blockSizeId < 4)
+                fail("invalid maximum block size");
+            const size_t maxBlockSize = size_t(1) << (8 + 2 * blockSizeId);
+
+            if (contentSize)
+            {
+                if (end - in < 8)
+                    fail("truncated frame descriptor");
+                // Only used as a hint, so a bogus value can do no harm beyond reserving too little
+                const uint32_t low = readUInt32(in);
+                if (readUInt32(in + 4) == 0)
+                    out.reserve(out.size() + low);
+                in += 8;
+            }
+
+            // Header checksum
+            if (end - in < 1)
+                fail("truncated frame descriptor");
+            in += 1;
+
+            while (true)
+            {
+                if (end - in < 4)
+                    fail("truncated block size");
+                const uint32_t blockSize = readUInt32(in);
+                in += 4;
+
+                if (blockSize == 0)
+                    break;
+
+                const bool uncompressed = (blockSize & 0x80000000u) != 0;
+                const size_t dataSize = blockSize & 0x7FFFFFFFu;
+                if (size_t(end - in) < dataSize)
+                    fail("truncated block");
+                if (dataSize > maxBlockSize)
+                    fail("block exceeds the maximum block size");
+
+                if (uncompressed)
+                    out.insert(out.end(), reinterpret_cast<const char*>(in), reinterpret_cast<const char*>(in + dataSize));
+                else
+                    decodeBlock(in, dataSize, out, maxBlockSize);
+                in += dataSize;
+
+                if (blockChecksums)
+                {
+                    if (end - in < 4)
+                        fail("truncated block checksum");
+                    in += 4;
+                }
+            }
+
+            if (contentChecksum)
+            {
+                if (end - in < 4)
+                    fail("truncated content checksum");
+                in += 4;
+            }
+        }
+    }
+
+    void compressLz4(const char *data, size_t size, std::vector<char> &out)
+    {
+        writeUInt32(sFrameMagic, out);
+
+        // Frame descriptor: version 1, independent blocks, with the content size
+        unsigned char descriptor[10];
+        descriptor[0] = 0x40 | 0x20 | 0x08;
+        descriptor[1] = static_cast<unsigned char>(sCompressedBlockSizeId << 4);
+        const uint64_t contentSize = size;
+        for (int i=0; i<8; ++i)
+            descriptor[2 + i] = static_cast<unsigned char>(contentSize >> (8 * i));
+        out.insert(out.end(), reinterpret_cast<const char*>(descriptor), reinterpret_cast<const char*>(descriptor + sizeof(descriptor)));
+        out.push_back(static_cast<char>((hashDescriptor(descriptor, sizeof(descriptor)) >> 8) & 0xff));
+
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+        std::vector<uint32_t> table(size_t(1) << sHashBits);
+        std::vector<char> block;
+        for (size_t start = 0; start < size; start += sCompressedBlockSize)
+        {
+            const size_t blockSize = std::min(sCompressedBlockSize, size - start);
+
+            block.clear();
+            encodeBlock(in + start, blockSize, table, block);
+
+            // Store data that does not compress as it is
+            if (block.size() >= blockSize)
+            {
+                writeUInt32(static_cast<uint32_t>(blockSize) | 0x80000000u, out);
+                out.insert(out.end(), data + start, data + start + blockSize);
+            }
+            else
+            {
+                writeUInt32(static_cast<uint32_t>(block.size()), out);
+                out.insert(out.end(), block.begin(), block.end());
+            }
+        }
+
+        // End mark
+        writeUInt32(0, out);
+    }
+
+}
@@ -0,0 +1,25 @@
+#ifndef COMPONENTS_FILES_LZ4_HPP
+#define COMPONENTS_FILES_LZ4_HPP
+
+#include <cstdlib>
+#include <vector>
+
+namespace Files
+{
+
+    /// Does the given buffer start with the magic number of an LZ4 frame?
+    bool isLz4Frame(const char* data, size_t size);
+
+    /// @brief Decompress data in the LZ4 frame format, as written by the lz4 command line tool.
+    /// @par Concatenated and skippable frames are supported. Checksums are skipped and not verified.
+    /// @note Throws an exception if the data is not a valid LZ4 frame.
+    void decompressLz4(const char* data, size_t size, std::vector<char>& out);
+
+    /// @brief Compress data into a single LZ4 frame, that decompressLz4() and the lz4 command line tool can read.
+    /// @par Blocks are compressed independently with a fast greedy match finder; the frame has no checksums.
+    /// @note The frame is appended to \a out.
+    void compressLz4(const char* data, size_t size, std::vector<char>& out);
+
+}
+
+#endif
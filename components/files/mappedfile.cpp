@@ -0,0 +1,280 @@
+#include "mappedfile.hpp"
+
+#include <stdexcept>
+#include <sstream>
+#include <cassert>
+
+#if FILE_API == FILE_API_POSIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+#if FILE_API == FILE_API_WIN32
+#include <boost/locale.hpp>
+#endif
+
+namespace
+{
+    // data() of an empty file, which can not be mapped
+    const char sEmpty[1] = { 0 };
+}
+
+namespace Files
+{
+
+#if FILE_API == FILE_API_STDIO
+/*
+ *
+ *  Fallback implementation, reads the whole file into memory using c stdio
+ *
+ */
+
+MappedFile::MappedFile()
+    : mData(NULL)
+    , mSize(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData != NULL)
+        close();
+}
+
+void MappedFile::open(const char *filename)
+{
+    assert(mData == NULL);
+
+    FILE* handle = fopen(filename, "rb");
+
+    if (handle == NULL)
+    {
+        std::ostringstream os;
+        os << "Failed to open '" << filename << "' for reading.";
+        throw std::runtime_error(os.str());
+    }
+
+    long size = -1;
+    if (fseek(handle, 0, SEEK_END) == 0)
+        size = ftell(handle);
+
+    if (size < 0 || fseek(handle, 0, SEEK_SET) != 0)
+    {
+        fclose(handle);
+        throw std::runtime_error("A query operation on a file failed.");
+    }
+
+    if (size == 0)
+    {
+        fclose(handle);
+        mData = sEmpty;
+        mSize = 0;
+        return;
+    }
+
+    char* buffer = new char[size];
+    if (fread(buffer, 1, size, handle) != size_t(size))
+    {
+        delete[] buffer;
+        fclose(handle);
+        throw std::runtime_error("A read operation on a file failed.");
+    }
+    fclose(handle);
+
+    mData = buffer;
+    mSize = size;
+}
+
+void MappedFile::close()
+{
+    assert(mData != NULL);
+
+    if (mData != sEmpty)
+        delete[] mData;
+
+    mData = NULL;
+    mSize = 0;
+}
+
+#elif FILE_API == FILE_API_POSIX
+/*
+ *
+ *  Implementation of MappedFile methods using posix mmap
+ *
+ */
+
+MappedFile::MappedFile()
+    : mData(NULL)
+    , mSize(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData != NULL)
+        close();
+}
+
+void MappedFile::open(const char *filename)
+{
+    assert(mData == NULL);
+
+#ifdef O_BINARY
+    static const int openFlags = O_RDONLY | O_BINARY;
+#else
+    static const int openFlags = O_RDONLY;
+#endif
+
+    int handle = ::open(filename, openFlags, 0);
+
+    if (handle == -1)
+    {
+        std::ostringstream os;
+        os << "Failed to open '" << filename << "' for reading: " << strerror(errno);
+        throw std::runtime_error(os.str());
+    }
+
+    struct stat info;
+    if (::fstat(handle, &info) == -1)
+    {
+        std::ostringstream os;
+        os << "An fstat() call failed: " << strerror(errno);
+        ::close(handle);
+        throw std::runtime_error(os.str());
+    }
+
+    if (info.st_size == 0)
+    {
+        ::close(handle);
+        mData = sEmpty;
+        mSize = 0;
+        return;
+    }
+
+    void* mapping = ::mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+
+    // The mapping keeps its own reference to the file
+    ::close(handle);
+
+    if (mapping == MAP_FAILED)
+    {
+        std::ostringstream os;
+        os << "Failed to map '" << filename << "' into memory: " << strerror(errno);
+        throw std::runtime_error(os.str());
+    }
+
+    mData = static_cast<const char*>(mapping);
+    mSize = info.st_size;
+}
+
+void MappedFile::close()
+{
+    assert(mData != NULL);
+
+    if (mData != sEmpty)
+        ::munmap(const_cast<char*>(mData), mSize);
+
+    mData = NULL;
+    mSize = 0;
+}
+
+#elif FILE_API == FILE_API_WIN32
+/*
+ *
+ *  Implementation of MappedFile methods using Win32 file mappings
+ *
+ */
+
+MappedFile::MappedFile()
+    : mData(NULL)
+    , mSize(0)
+    , mHandle(INVALID_HANDLE_VALUE)
+    , mMapping(NULL)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData != NULL)
+        close();
+}
+
+void MappedFile::open(const char *filename)
+{
+    assert(mData == NULL);
+
+    std::wstring wname = boost::locale::conv::utf_to_utf<wchar_t>(filename);
+    HANDLE handle = CreateFileW(wname.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        std::ostringstream os;
+        os << "Failed to open '" << filename << "' for reading.";
+        throw std::runtime_error(os.str());
+    }
+
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(handle, &info))
+    {
+        CloseHandle(handle);
+        throw std::runtime_error("A query operation on a file failed.");
+    }
+
+    if (info.nFileSizeHigh != 0)
+    {
+        CloseHandle(handle);
+        throw std::runtime_error("Files greater than 4GB are not supported.");
+    }
+
+    if (info.nFileSizeLow == 0)
+    {
+        CloseHandle(handle);
+        mData = sEmpty;
+        mSize = 0;
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingW(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void* view = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+    if (view == NULL)
+    {
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        CloseHandle(handle);
+        std::ostringstream os;
+        os << "Failed to map '" << filename << "' into memory.";
+        throw std::runtime_error(os.str());
+    }
+
+    mHandle = handle;
+    mMapping = mapping;
+    mData = static_cast<const char*>(view);
+    mSize = info.nFileSizeLow;
+}
+
+void MappedFile::close()
+{
+    assert(mData != NULL);
+
+    if (mData != sEmpty)
+    {
+        UnmapViewOfFile(mData);
+        CloseHandle(mMapping);
+        CloseHandle(mHandle);
+    }
+
+    mHandle = INVALID_HANDLE_VALUE;
+    mMapping = NULL;
+    mData = NULL;
+    mSize = 0;
+}
+
+#endif
+
+}
@@ -0,0 +1,46 @@
+#ifndef COMPONENTS_FILES_MAPPEDFILE_HPP
+#define COMPONENTS_FILES_MAPPEDFILE_HPP
+
+#include <cstdlib>
+
+#include "lowlevelfile.hpp"
+
+namespace Files
+{
+
+    /// @brief Read-only view of an entire file mapped into the address space.
+    /// @par Where the platform has no mapping support, the file contents are read into memory instead,
+    /// so callers can always rely on data() pointing at the complete file.
+    /// @note The view is immutable once opened, so concurrent readers do not need any synchronization.
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        /// @note Throws an exception if the file can not be opened or mapped.
+        void open(const char* filename);
+        void close();
+
+        bool isOpen() const { return mData != NULL; }
+
+        const char* data() const { return mData; }
+        size_t size() const { return mSize; }
+
+    private:
+        // not implemented
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+
+        const char* mData;
+        size_t mSize;
+
+#if FILE_API == FILE_API_WIN32
+        HANDLE mHandle;
+        HANDLE mMapping;
+#endif
+    };
+
+}
+
+#endif
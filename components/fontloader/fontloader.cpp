@@ -82,45 +82,49 @@ namespace
         {
             // Hacks for polish font
             unsigned char win1250;
-            std::map<unsigned char, unsigned char> conv;
-            conv[0x80] = 0xc6;
-            conv[0x81] = 0x9c;
-            conv[0x82] = 0xe6;
-            conv[0x83] = 0xb3;
-            conv[0x84] = 0xf1;
-            conv[0x85] = 0xb9;
-            conv[0x86] = 0xbf;
-            conv[0x87] = 0x9f;
-            conv[0x88] = 0xea;
-            conv[0x89] = 0xea;
-            conv[0x8a] = 0x0; // not contained in win1250
-            conv[0x8b] = 0x0; // not contained in win1250
-            conv[0x8c] = 0x8f;
-            conv[0x8d] = 0xaf;
-            conv[0x8e] = 0xa5;
-            conv[0x8f] = 0x8c;
-            conv[0x90] = 0xca;
-            conv[0x93] = 0xa3;
-            conv[0x94] = 0xf6;
-            conv[0x95] = 0xf3;
-            conv[0x96] = 0xaf;
-            conv[0x97] = 0x8f;
-            conv[0x99] = 0xd3;
-            conv[0x9a] = 0xd1;
-            conv[0x9c] = 0x0; // not contained in win1250
-            conv[0xa0] = 0xb9;
-            conv[0xa1] = 0xaf;
-            conv[0xa2] = 0xf3;
-            conv[0xa3] = 0xbf;
-            conv[0xa4] = 0x0; // not contained in win1250
-            conv[0xe1] = 0x8c;
-            // Can't remember if this was supposed to read 0xe2, or is it just an extraneous copypaste?
-            //conv[0xe1] = 0x8c;
-            conv[0xe3] = 0x0; // not contained in win1250
-            conv[0xf5] = 0x0; // not contained in win1250
-
-            if (conv.find(c) != conv.end())
-                win1250 = conv[c];
+            static std::map<unsigned char, unsigned char> conv;
+            if (conv.empty())
+            {
+                conv[0x80] = 0xc6;
+                conv[0x81] = 0x9c;
+                conv[0x82] = 0xe6;
+                conv[0x83] = 0xb3;
+                conv[0x84] = 0xf1;
+                conv[0x85] = 0xb9;
+                conv[0x86] = 0xbf;
+                conv[0x87] = 0x9f;
+                conv[0x88] = 0xea;
+                conv[0x89] = 0xea;
+                conv[0x8a] = 0x0; // not contained in win1250
+                conv[0x8b] = 0x0; // not contained in win1250
+                conv[0x8c] = 0x8f;
+                conv[0x8d] = 0xaf;
+                conv[0x8e] = 0xa5;
+                conv[0x8f] = 0x8c;
+                conv[0x90] = 0xca;
+                conv[0x93] = 0xa3;
+                conv[0x94] = 0xf6;
+                conv[0x95] = 0xf3;
+                conv[0x96] = 0xaf;
+                conv[0x97] = 0x8f;
+                conv[0x99] = 0xd3;
+                conv[0x9a] = 0xd1;
+                conv[0x9c] = 0x0; // not contained in win1250
+                conv[0xa0] = 0xb9;
+                conv[0xa1] = 0xaf;
+                conv[0xa2] = 0xf3;
+                conv[0xa3] = 0xbf;
+                conv[0xa4] = 0x0; // not contained in win1250
+                conv[0xe1] = 0x8c;
+                // Can't remember if this was supposed to read 0xe2, or is it just an extraneous copypaste?
+                //conv[0xe1] = 0x8c;
+                conv[0xe3] = 0x0; // not contained in win1250
+                conv[0xf5] = 0x0; // not contained in win1250
+            }
+
+            std::map<unsigned char, unsigned char>::const_iterator found = conv.find(c);
+            if (found != conv.end())
+                win1250 = found->second;
             else
                 win1250 = c;
             return encoder.getUtf8(std::string(1, win1250));
@@ -318,6 +322,40 @@ namespace Gui
         source->addAttribute("value", std::string(bitmapFilename));
         MyGUI::xml::ElementPtr codes = root->createChild("Codes");
 
+        ToUTF8::Utf8Encoder encoder(mEncoding);
+
+        // More hacks! The french game uses several win1252 characters that are not included
+        // in the cp437 encoding of the font. Fall back to similar available characters.
+        typedef std::multimap<int, int> AdditionalMap; // <cp437, unicode>
+        static AdditionalMap additional;
+        if (additional.empty())
+        {
+            additional.insert(std::make_pair(39, 0x2019)); // apostrophe
+            additional.insert(std::make_pair(45, 0x2013)); // dash
+            additional.insert(std::make_pair(45, 0x2014)); // dash
+            additional.insert(std::make_pair(34, 0x201D)); // right double quotation mark
+            additional.insert(std::make_pair(34, 0x201C)); // left double quotation mark
+            additional.insert(std::make_pair(44, 0x201A));
+            additional.insert(std::make_pair(44, 0x201E));
+            additional.insert(std::make_pair(43, 0x2020));
+            additional.insert(std::make_pair(94, 0x02C6));
+            additional.insert(std::make_pair(37, 0x2030));
+            additional.insert(std::make_pair(83, 0x0160));
+            additional.insert(std::make_pair(60, 0x2039));
+            additional.insert(std::make_pair(79, 0x0152));
+            additional.insert(std::make_pair(90, 0x017D));
+            additional.insert(std::make_pair(39, 0x2019));
+            additional.insert(std::make_pair(126, 0x02DC));
+            additional.insert(std::make_pair(84, 0x2122));
+            additional.insert(std::make_pair(83, 0x0161));
+            additional.insert(std::make_pair(62, 0x203A));
+            additional.insert(std::make_pair(111, 0x0153));
+            additional.insert(std::make_pair(122, 0x017E));
+            additional.insert(std::make_pair(89, 0x0178));
+            additional.insert(std::make_pair(156, 0x00A2));
+            additional.insert(std::make_pair(46, 0x2026));
+        }
+
         for(int i = 0; i < 256; i++)
         {
             float x1 = data[i].top_left.x*width;
@@ -325,7 +363,6 @@ namespace Gui
             float w  = data[i].top_right.x*width - x1;
             float h  = data[i].bottom_left.y*height - y1;
 
-            ToUTF8::Utf8Encoder encoder(mEncoding);
             unsigned long unicodeVal = utf8ToUnicode(getUtf8(i, encoder, mEncoding));
 
             MyGUI::xml::ElementPtr code = codes->createChild("Code");
@@ -339,41 +376,11 @@ namespace Gui
                                + MyGUI::utility::toString((fontSize-data[i].ascent)));
             code->addAttribute("size", MyGUI::IntSize(static_cast<int>(data[i].width), static_cast<int>(data[i].height)));
 
-            // More hacks! The french game uses several win1252 characters that are not included
-            // in the cp437 encoding of the font. Fall back to similar available characters.
             if (mEncoding == ToUTF8::CP437)
             {
-                std::multimap<int, int> additional; // <cp437, unicode>
-                additional.insert(std::make_pair(39, 0x2019)); // apostrophe
-                additional.insert(std::make_pair(45, 0x2013)); // dash
-                additional.insert(std::make_pair(45, 0x2014)); // dash
-                additional.insert(std::make_pair(34, 0x201D)); // right double quotation mark
-                additional.insert(std::make_pair(34, 0x201C)); // left double quotation mark
-                additional.insert(std::make_pair(44, 0x201A));
-                additional.insert(std::make_pair(44, 0x201E));
-                additional.insert(std::make_pair(43, 0x2020));
-                additional.insert(std::make_pair(94, 0x02C6));
-                additional.insert(std::make_pair(37, 0x2030));
-                additional.insert(std::make_pair(83, 0x0160));
-                additional.insert(std::make_pair(60, 0x2039));
-                additional.insert(std::make_pair(79, 0x0152));
-                additional.insert(std::make_pair(90, 0x017D));
-                additional.insert(std::make_pair(39, 0x2019));
-                additional.insert(std::make_pair(126, 0x02DC));
-                additional.insert(std::make_pair(84, 0x2122));
-                additional.insert(std::make_pair(83, 0x0161));
-                additional.insert(std::make_pair(62, 0x203A));
-                additional.insert(std::make_pair(111, 0x0153));
-                additional.insert(std::make_pair(122, 0x017E));
-                additional.insert(std::make_pair(89, 0x0178));
-                additional.insert(std::make_pair(156, 0x00A2));
-                additional.insert(std::make_pair(46, 0x2026));
-
-                for (std::multimap<int, int>::iterator it = additional.begin(); it != additional.end(); ++it)
+                std::pair<AdditionalMap::const_iterator, AdditionalMap::const_iterator> range = additional.equal_range(i);
+                for (AdditionalMap::const_iterator it = range.first; it != range.second; ++it)
                 {
-                    if (it->first != i)
-                        continue;
-
                     MyGUI::xml::ElementPtr code = codes->createChild("Code");
                     code->addAttribute("index", it->second);
                     code->addAttribute("coord", MyGUI::utility::toString(x1) + " "
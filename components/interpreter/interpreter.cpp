@@ -1,5 +1,6 @@
 #include "interpreter.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 #include <stdexcept>
@@ -8,110 +9,126 @@
 
 namespace Interpreter
 {
-    void Interpreter::execute (Type_Code code)
-    {
-        unsigned int segSpec = code>>30;
+    Program::Program() : mDecodedBy (0) {}
 
-        switch (segSpec)
-        {
-            case 0:
-            {
-                int opcode = code>>24;
-                unsigned int arg0 = code & 0xffffff;
+    Program::Program (const std::vector<Type_Code>& code) : mCode (code), mDecodedBy (0) {}
 
-                std::map<int, Opcode1 *>::iterator iter = mSegment0.find (opcode);
+    Program::Program (const Type_Code *code, int codeSize) : mCode (code, code+codeSize), mDecodedBy (0) {}
 
-                if (iter==mSegment0.end())
-                    abortUnknownCode (0, opcode);
-
-                iter->second->execute (mRuntime, arg0);
-
-                return;
-            }
-
-            case 1:
-            {
-                int opcode = (code>>24) & 0x3f;
-                unsigned int arg0 = (code>>16) & 0xfff;
-                unsigned int arg1 = code & 0xfff;
-
-                std::map<int, Opcode2 *>::iterator iter = mSegment1.find (opcode);
-
-                if (iter==mSegment1.end())
-                    abortUnknownCode (1, opcode);
-
-                iter->second->execute (mRuntime, arg0, arg1);
-
-                return;
-            }
+    bool Program::empty() const
+    {
+        return mCode.empty();
+    }
 
-            case 2:
-            {
-                int opcode = (code>>20) & 0x3ff;
-                unsigned int arg0 = code & 0xfffff;
+    void Program::clear()
+    {
+        mCode.clear();
+        mInstructions.clear();
+        mStringLiterals.clear();
+        mDecodedBy = 0;
+    }
 
-                std::map<int, Opcode1 *>::iterator iter = mSegment2.find (opcode);
+    bool Program::contains (Type_Code instruction) const
+    {
+        if (mCode.size() < 4)
+            return false;
 
-                if (iter==mSegment2.end())
-                    abortUnknownCode (2, opcode);
+        const std::size_t end = std::min (mCode.size(), static_cast<std::size_t> (mCode[0]) + 4);
+        return std::find (mCode.begin() + 4, mCode.begin() + end, instruction) != mCode.begin() + end;
+    }
 
-                iter->second->execute (mRuntime, arg0);
+    void Interpreter::decode (Type_Code code, Program::Instruction& instruction) const
+    {
+        instruction.mOpcode0 = 0;
+        instruction.mArg0 = 0;
+        instruction.mArg1 = 0;
 
-                return;
-            }
-        }
+        unsigned int segSpec = code>>30;
 
-        segSpec = code>>26;
+        int segment = -1;
+        int opcode = 0;
+        bool found = false;
 
         switch (segSpec)
         {
-            case 0x30:
-            {
-                int opcode = (code>>8) & 0x3ffff;
-                unsigned int arg0 = code & 0xff;
-
-                std::map<int, Opcode1 *>::iterator iter = mSegment3.find (opcode);
-
-                if (iter==mSegment3.end())
-                    abortUnknownCode (3, opcode);
-
-                iter->second->execute (mRuntime, arg0);
-
-                return;
-            }
-
-            case 0x31:
-            {
-                int opcode = (code>>16) & 0x3ff;
-                unsigned int arg0 = (code>>8) & 0xff;
-                unsigned int arg1 = code & 0xff;
-
-                std::map<int, Opcode2 *>::iterator iter = mSegment4.find (opcode);
-
-                if (iter==mSegment4.end())
-                    abortUnknownCode (4, opcode);
-
-                iter->second->execute (mRuntime, arg0, arg1);
-
-                return;
-            }
+            case 0:
 
-            case 0x32:
-            {
-                int opcode = code & 0x3ffffff;
+                segment = 0;
+                opcode = code>>24;
+                instruction.mOpcode1 = mSegment0.find (opcode);
+                found = instruction.mOpcode1!=0;
+                instruction.mArguments = 1;
+                instruction.mArg0 = code & 0xffffff;
+                break;
 
-                std::map<int, Opcode0 *>::iterator iter = mSegment5.find (opcode);
+            case 1:
 
-                if (iter==mSegment5.end())
-                    abortUnknownCode (5, opcode);
+                segment = 1;
+                opcode = (code>>24) & 0x3f;
+                instruction.mOpcode2 = mSegment1.find (opcode);
+                found = instruction.mOpcode2!=0;
+                instruction.mArguments = 2;
+                instruction.mArg0 = (code>>16) & 0xfff;
+                instruction.mArg1 = code & 0xfff;
+                break;
 
-                iter->second->execute (mRuntime);
+            case 2:
 
-                return;
-            }
+                segment = 2;
+                opcode = (code>>20) & 0x3ff;
+                instruction.mOpcode1 = mSegment2.find (opcode);
+                found = instruction.mOpcode1!=0;
+                instruction.mArguments = 1;
+                instruction.mArg0 = code & 0xfffff;
+                break;
+
+            default:
+
+                switch (code>>26)
+                {
+                    case 0x30:
+
+                        segment = 3;
+                        opcode = (code>>8) & 0x3ffff;
+                        instruction.mOpcode1 = mSegment3.find (opcode);
+                        found = instruction.mOpcode1!=0;
+                        instruction.mArguments = 1;
+                        instruction.mArg0 = code & 0xff;
+                        break;
+
+                    case 0x31:
+
+                        segment = 4;
+                        opcode = (code>>16) & 0x3ff;
+                        instruction.mOpcode2 = mSegment4.find (opcode);
+                        found = instruction.mOpcode2!=0;
+                        instruction.mArguments = 2;
+                        instruction.mArg0 = (code>>8) & 0xff;
+                        instruction.mArg1 = code & 0xff;
+                        break;
+
+                    case 0x32:
+
+                        segment = 5;
+                        opcode = code & 0x3ffffff;
+                        instruction.mOpcode0 = mSegment5.find (opcode);
+                        found = instruction.mOpcode0!=0;
+                        instruction.mArguments = 0;
+                        break;
+                }
         }
 
-        abortUnknownSegment (code);
+        if (segment==-1)
+        {
+            instruction.mArguments = -2;
+            instruction.mArg0 = code;
+        }
+        else if (!found)
+        {
+            instruction.mArguments = -1;
+            instruction.mArg0 = segment;
+            instruction.mArg1 = opcode;
+        }
     }
 
     void Interpreter::abortUnknownCode (int segment, int opcode)
@@ -132,118 +149,122 @@ namespace Interpreter
         throw std::runtime_error (error.str());
     }
 
-    void Interpreter::begin()
+    Runtime& Interpreter::begin()
     {
-        if (mRunning)
-        {
-            mCallstack.push (mRuntime);
-            mRuntime.clear();
-        }
-        else
-        {
-            mRunning = true;
-        }
+        // Adding to a deque does not move the runtimes of the runs this one is nested in
+        if (mDepth==mRuntimes.size())
+            mRuntimes.push_back (Runtime());
+
+        return mRuntimes[mDepth++];
     }
 
     void Interpreter::end()
     {
-        if (mCallstack.empty())
-        {
-            mRuntime.clear();
-            mRunning = false;
-        }
-        else
-        {
-            mRuntime = mCallstack.top();
-            mCallstack.pop();
-        }
+        mRuntimes[--mDepth].clear();
     }
 
-    Interpreter::Interpreter() : mRunning (false)
+    Interpreter::Interpreter()
+    : mDepth (0), mExecutedInstructions (0), mSegment0 (32), mSegment1 (32), mSegment2 (512), mSegment3 (131072), mSegment4 (512),
+      mSegment5 (33554432)
     {}
 
-    Interpreter::~Interpreter()
-    {
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment0.begin());
-            iter!=mSegment0.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode2 *>::iterator iter (mSegment1.begin());
-            iter!=mSegment1.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment2.begin());
-            iter!=mSegment2.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment3.begin());
-            iter!=mSegment3.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode2 *>::iterator iter (mSegment4.begin());
-            iter!=mSegment4.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode0 *>::iterator iter (mSegment5.begin());
-            iter!=mSegment5.end(); ++iter)
-            delete iter->second;
-    }
+    Interpreter::~Interpreter() {}
 
     void Interpreter::installSegment0 (int code, Opcode1 *opcode)
     {
-        assert(mSegment0.find(code) == mSegment0.end());
-        mSegment0.insert (std::make_pair (code, opcode));
+        mSegment0.install (code, opcode);
     }
 
     void Interpreter::installSegment1 (int code, Opcode2 *opcode)
     {
-        assert(mSegment1.find(code) == mSegment1.end());
-        mSegment1.insert (std::make_pair (code, opcode));
+        mSegment1.install (code, opcode);
     }
 
     void Interpreter::installSegment2 (int code, Opcode1 *opcode)
     {
-        assert(mSegment2.find(code) == mSegment2.end());
-        mSegment2.insert (std::make_pair (code, opcode));
+        mSegment2.install (code, opcode);
     }
 
     void Interpreter::installSegment3 (int code, Opcode1 *opcode)
     {
-        assert(mSegment3.find(code) == mSegment3.end());
-        mSegment3.insert (std::make_pair (code, opcode));
+        mSegment3.install (code, opcode);
     }
 
     void Interpreter::installSegment4 (int code, Opcode2 *opcode)
     {
-        assert(mSegment4.find(code) == mSegment4.end());
-        mSegment4.insert (std::make_pair (code, opcode));
+        mSegment4.install (code, opcode);
     }
 
     void Interpreter::installSegment5 (int code, Opcode0 *opcode)
     {
-        assert(mSegment5.find(code) == mSegment5.end());
-        mSegment5.insert (std::make_pair (code, opcode));
+        mSegment5.install (code, opcode);
     }
 
     void Interpreter::run (const Type_Code *code, int codeSize, Context& context)
     {
-        assert (codeSize>=4);
+        Program program (code, codeSize);
+        run (program, context);
+    }
 
-        begin();
+    void Interpreter::run (Program& program, Context& context)
+    {
+        assert (program.mCode.size()>=4);
 
-        try
+        if (program.mDecodedBy!=this)
         {
-            mRuntime.configure (code, codeSize, context);
+            int opcodes = static_cast<int> (program.mCode[0]);
+            program.mInstructions.resize (opcodes);
+
+            for (int i=0; i<opcodes; ++i)
+                decode (program.mCode[4+i], program.mInstructions[i]);
+
+            // The string literal block is a sequence of null-terminated strings, padded to whole words. The
+            // padding can not be told from empty strings, and just adds a few of them at the end.
+            program.mStringLiterals.clear();
+            const std::size_t stringBegin = 4 + program.mCode[0] + program.mCode[1] + program.mCode[2];
+            if (program.mCode[3]>0 && stringBegin + program.mCode[3] <= program.mCode.size())
+            {
+                const char *literals = reinterpret_cast<const char *> (&program.mCode[stringBegin]);
+                const std::size_t size = program.mCode[3] * sizeof (Type_Code);
+
+                std::size_t offset = 0;
+                while (offset<size)
+                {
+                    std::size_t length = 0;
+                    while (offset+length<size && literals[offset+length])
+                        ++length;
+                    program.mStringLiterals.push_back (std::string (literals+offset, length));
+                    offset += length + 1;
+                }
+            }
+
+            program.mDecodedBy = this;
+        }
+
+        Runtime& runtime = begin();
 
-            int opcodes = static_cast<int> (code[0]);
+        try
+        {
+            runtime.configure (&program.mCode[0], static_cast<int> (program.mCode.size()),
+                program.mStringLiterals, context);
 
-            const Type_Code *codeBlock = code + 4;
+            const std::vector<Program::Instruction>& instructions = program.mInstructions;
+            int opcodes = static_cast<int> (program.mInstructions.size());
 
-            while (mRuntime.getPC()>=0 && mRuntime.getPC()<opcodes)
+            while (runtime.getPC()>=0 && runtime.getPC()<opcodes)
             {
-                Type_Code code = codeBlock[mRuntime.getPC()];
-                mRuntime.setPC (mRuntime.getPC()+1);
-                execute (code);
+                const Program::Instruction& instruction = instructions[runtime.getPC()];
+                runtime.setPC (runtime.getPC()+1);
+                ++mExecutedInstructions;
+
+                switch (instruction.mArguments)
+                {
+                    case 0: instruction.mOpcode0->execute (runtime); break;
+                    case 1: instruction.mOpcode1->execute (runtime, instruction.mArg0); break;
+                    case 2: instruction.mOpcode2->execute (runtime, instruction.mArg0, instruction.mArg1); break;
+                    case -1: abortUnknownCode (instruction.mArg0, instruction.mArg1); break;
+                    default: abortUnknownSegment (instruction.mArg0); break;
+                }
             }
         }
         catch (...)
@@ -254,4 +275,9 @@ namespace Interpreter
 
         end();
     }
+
+    unsigned long Interpreter::getExecutedInstructions() const
+    {
+        return mExecutedInstructions;
+    }
 }
@@ -1,8 +1,10 @@
 #ifndef INTERPRETER_INTERPRETER_H_INCLUDED
 #define INTERPRETER_INTERPRETER_H_INCLUDED
 
-#include <map>
-#include <stack>
+#include <cassert>
+#include <deque>
+#include <string>
+#include <vector>
 
 #include "runtime.hpp"
 #include "types.hpp"
@@ -12,30 +14,124 @@ namespace Interpreter
     class Opcode0;
     class Opcode1;
     class Opcode2;
+    class Interpreter;
+
+    /// @brief The handlers of the opcodes of a segment, in dense arrays indexed by opcode.
+    /// @par Opcodes of the engine are numbered from 0, and those of extensions from the start of the range that the
+    /// segment reserves for them, see vmformat.txt. Each of the two ranges has its own array.
+    template<typename T>
+    class OpcodeTable
+    {
+            std::vector<T *> mBuiltIn;
+            std::vector<T *> mExtensions;
+            int mExtensionBase;
+
+            // not implemented
+            OpcodeTable (const OpcodeTable&);
+            OpcodeTable& operator= (const OpcodeTable&);
+
+        public:
+
+            explicit OpcodeTable (int extensionBase) : mExtensionBase (extensionBase) {}
+
+            ~OpcodeTable()
+            {
+                for (typename std::vector<T *>::iterator iter (mBuiltIn.begin()); iter!=mBuiltIn.end(); ++iter)
+                    delete *iter;
+
+                for (typename std::vector<T *>::iterator iter (mExtensions.begin()); iter!=mExtensions.end(); ++iter)
+                    delete *iter;
+            }
+
+            void install (int code, T *opcode)
+            {
+                std::vector<T *>& table = code>=mExtensionBase ? mExtensions : mBuiltIn;
+                int index = code>=mExtensionBase ? code-mExtensionBase : code;
+
+                if (index>=static_cast<int> (table.size()))
+                    table.resize (index+1, 0);
+
+                assert (!table[index]);
+                table[index] = opcode;
+            }
+
+            /// @return 0 if the opcode is not installed.
+            T *find (int code) const
+            {
+                const std::vector<T *>& table = code>=mExtensionBase ? mExtensions : mBuiltIn;
+                int index = code>=mExtensionBase ? code-mExtensionBase : code;
+
+                return index<static_cast<int> (table.size()) ? table[index] : 0;
+            }
+    };
+
+    /// @brief The code of a script, with the opcodes of its instructions decoded and their handlers looked up.
+    /// @par The instructions are decoded the first time the program is run, by the interpreter that runs it.
+    class Program
+    {
+            struct Instruction
+            {
+                union
+                {
+                    Opcode0 *mOpcode0;
+                    Opcode1 *mOpcode1;
+                    Opcode2 *mOpcode2;
+                };
+
+                // -1 for an opcode that is not installed, with the segment and opcode as arguments, and -2 for
+                // an instruction outside of the segments, with the code as the first argument
+                int mArguments;
+                unsigned int mArg0;
+                unsigned int mArg1;
+            };
+
+            std::vector<Type_Code> mCode;
+            std::vector<Instruction> mInstructions;
+            std::vector<std::string> mStringLiterals;
+            const Interpreter *mDecodedBy;
+
+            friend class Interpreter;
+
+        public:
+
+            Program();
+
+            explicit Program (const std::vector<Type_Code>& code);
+
+            Program (const Type_Code *code, int codeSize);
+
+            bool empty() const;
+
+            void clear();
+
+            bool contains (Type_Code instruction) const;
+            ///< Does the code block contain the given instruction?
+    };
 
     class Interpreter
     {
-            std::stack<Runtime> mCallstack;
-            bool mRunning;
-            Runtime mRuntime;
-            std::map<int, Opcode1 *> mSegment0;
-            std::map<int, Opcode2 *> mSegment1;
-            std::map<int, Opcode1 *> mSegment2;
-            std::map<int, Opcode1 *> mSegment3;
-            std::map<int, Opcode2 *> mSegment4;
-            std::map<int, Opcode0 *> mSegment5;
+            // One runtime per nesting level of run(), kept for reuse, so that their stacks keep their capacity
+            std::deque<Runtime> mRuntimes;
+            std::size_t mDepth;
+            unsigned long mExecutedInstructions;
+            OpcodeTable<Opcode1> mSegment0;
+            OpcodeTable<Opcode2> mSegment1;
+            OpcodeTable<Opcode1> mSegment2;
+            OpcodeTable<Opcode1> mSegment3;
+            OpcodeTable<Opcode2> mSegment4;
+            OpcodeTable<Opcode0> mSegment5;
 
             // not implemented
             Interpreter (const Interpreter&);
             Interpreter& operator= (const Interpreter&);
 
-            void execute (Type_Code code);
+            void decode (Type_Code code, Program::Instruction& instruction) const;
 
             void abortUnknownCode (int segment, int opcode);
 
             void abortUnknownSegment (Type_Code code);
 
-            void begin();
+            Runtime& begin();
 
             void end();
 
@@ -64,6 +160,14 @@ namespace Interpreter
             ///< ownership of \a opcode is transferred to *this.
 
             void run (const Type_Code *code, int codeSize, Context& context);
+
+            void run (Program& program, Context& context);
+            ///< Decodes \a program first if it was not decoded by this interpreter yet. All opcodes must be
+            /// installed by then.
+
+            unsigned long getExecutedInstructions() const;
+            ///< Number of instructions executed so far, including those of nested runs. Wraps around; only
+            /// meant for taking differences.
     };
 }
 
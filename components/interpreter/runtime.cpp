@@ -2,11 +2,13 @@
 
 #include <stdexcept>
 #include <cassert>
-#include <cstring>
 
 namespace Interpreter
 {
-    Runtime::Runtime() : mContext (0), mCode (0), mCodeSize(0), mPC (0) {}
+    Runtime::Runtime() : mContext (0), mCode (0), mCodeSize(0), mStringLiterals (0), mPC (0)
+    {
+        mStack.reserve (64);
+    }
 
     int Runtime::getPC() const
     {
@@ -31,31 +33,22 @@ namespace Interpreter
         return *reinterpret_cast<const float *> (&literalBlock[index]);
     }
 
-    std::string Runtime::getStringLiteral (int index) const
+    const std::string& Runtime::getStringLiteral (int index) const
     {
-        assert (index>=0 && static_cast<int> (mCode[3])>0);
-
-        const char *literalBlock =
-            reinterpret_cast<const char *> (mCode + 4 + mCode[0] + mCode[1] + mCode[2]);
-
-        int offset = 0;
-
-        for (; index; --index)
-        {
-            offset += std::strlen (literalBlock+offset) + 1;
-            assert (offset/4<static_cast<int> (mCode[3]));
-        }
+        assert (mStringLiterals && index>=0 && index<static_cast<int> (mStringLiterals->size()));
 
-        return literalBlock+offset;
+        return (*mStringLiterals)[index];
     }
 
-    void Runtime::configure (const Type_Code *code, int codeSize, Context& context)
+    void Runtime::configure (const Type_Code *code, int codeSize,
+        const std::vector<std::string>& stringLiterals, Context& context)
     {
         clear();
 
         mContext = &context;
         mCode = code;
         mCodeSize = codeSize;
+        mStringLiterals = &stringLiterals;
         mPC = 0;
     }
 
@@ -64,6 +57,7 @@ namespace Interpreter
         mContext = 0;
         mCode = 0;
         mCodeSize = 0;
+        mStringLiterals = 0;
         mStack.clear();
     }
 
@@ -17,6 +17,7 @@ namespace Interpreter
             Context *mContext;
             const Type_Code *mCode;
             int mCodeSize;
+            const std::vector<std::string> *mStringLiterals;
             int mPC;
             std::vector<Data> mStack;
 
@@ -31,13 +32,16 @@ namespace Interpreter
 
             float getFloatLiteral (int index) const;
 
-            std::string getStringLiteral (int index) const;
+            const std::string& getStringLiteral (int index) const;
 
-            void configure (const Type_Code *code, int codeSize, Context& context);
-            ///< \a context and \a code must exist as least until either configure, clear or
-            /// the destructor is called. \a codeSize is given in 32-bit words.
+            void configure (const Type_Code *code, int codeSize,
+                const std::vector<std::string>& stringLiterals, Context& context);
+            ///< \a context, \a code and \a stringLiterals must exist as least until either configure,
+            /// clear or the destructor is called. \a codeSize is given in 32-bit words.
+            /// \a stringLiterals are the decoded strings of the string literal block.
 
             void clear();
+            ///< Keeps the memory of the stack for the next run.
 
             void setPC (int PC);
             ///< set program counter.
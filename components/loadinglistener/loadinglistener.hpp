@@ -29,6 +29,10 @@ namespace Loading
         virtual void setProgress (size_t value) {}
         /// Increase current progress, default by 1.
         virtual void increaseProgress (size_t increase = 1) {}
+
+        /// Keep the loading screen updated while other threads do the loading work. Call repeatedly until the work
+        /// is done, each call waits for up to one frame of the loading screen.
+        virtual void idle() {}
     };
 
     /// @brief Used for stopping a loading sequence when the object goes out of scope
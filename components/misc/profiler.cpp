@@ -0,0 +1,158 @@
+#include "profiler.hpp"
+
+#include <iostream>
+#include <vector>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace
+{
+    struct Event
+    {
+        const char* mName;
+        osg::Timer_t mStart;
+        osg::Timer_t mEnd;
+    };
+
+    /// The zones recorded by one thread. Only locked by stop() besides the thread itself, so hardly ever contended.
+    struct ThreadEvents
+    {
+        boost::mutex mMutex;
+        std::vector<Event> mEvents;
+        unsigned int mThreadId;
+    };
+
+    // Owned by sThreads, so that the events of a thread outlive it
+    void keepThreadEvents(ThreadEvents*) {}
+
+    boost::thread_specific_ptr<ThreadEvents> sThreadEvents(&keepThreadEvents);
+
+    boost::mutex sThreadsMutex;
+    std::vector<ThreadEvents*> sThreads;
+
+    std::string sPath;
+    osg::Timer_t sStartTick = 0;
+    ThreadEvents* sMainThread = NULL;
+
+    ThreadEvents& getThreadEvents()
+    {
+        ThreadEvents* events = sThreadEvents.get();
+        if (!events)
+        {
+            events = new ThreadEvents;
+            boost::mutex::scoped_lock lock(sThreadsMutex);
+            events->mThreadId = sThreads.size();
+            sThreads.push_back(events);
+            sThreadEvents.reset(events);
+        }
+        return *events;
+    }
+
+    void writeString(std::ostream& stream, const char* string)
+    {
+        stream << '"';
+        for (; *string; ++string)
+        {
+            if (*string == '"' || *string == '\\')
+                stream << '\\';
+            stream << *string;
+        }
+        stream << '"';
+    }
+}
+
+namespace Misc
+{
+
+    volatile bool Profiler::sRunning = false;
+
+    void Profiler::start(const std::string& path)
+    {
+#ifndef OPENMW_PROFILING
+        std::cerr << "Warning: built without OPENMW_PROFILING, the profile " << path << " will have no zones" << std::endl;
+#endif
+        if (sRunning)
+            stop();
+
+        {
+            boost::mutex::scoped_lock lock(sThreadsMutex);
+            for (std::vector<ThreadEvents*>::iterator it = sThreads.begin(); it != sThreads.end(); ++it)
+            {
+                boost::mutex::scoped_lock threadLock((*it)->mMutex);
+                (*it)->mEvents.clear();
+            }
+        }
+
+        sMainThread = &getThreadEvents();
+        sPath = path;
+        sStartTick = osg::Timer::instance()->tick();
+        sRunning = true;
+    }
+
+    void Profiler::stop()
+    {
+        if (!sRunning)
+            return;
+        sRunning = false;
+
+        boost::filesystem::ofstream stream(sPath);
+        if (!stream.is_open())
+        {
+            std::cerr << "Failed to open profile " << sPath << std::endl;
+            return;
+        }
+
+        const osg::Timer* timer = osg::Timer::instance();
+
+        stream << "{\"traceEvents\":[\n";
+        bool first = true;
+
+        boost::mutex::scoped_lock lock(sThreadsMutex);
+        for (std::vector<ThreadEvents*>::iterator it = sThreads.begin(); it != sThreads.end(); ++it)
+        {
+            boost::mutex::scoped_lock threadLock((*it)->mMutex);
+            if ((*it)->mEvents.empty())
+                continue;
+
+            if (!first)
+                stream << ",\n";
+            first = false;
+            stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << (*it)->mThreadId
+                   << ",\"args\":{\"name\":\"";
+            if (*it == sMainThread)
+                stream << "Main";
+            else
+                stream << "Thread " << (*it)->mThreadId;
+            stream << "\"}}";
+
+            // Complete events, with the times in microseconds since start()
+            for (std::vector<Event>::const_iterator event = (*it)->mEvents.begin(); event != (*it)->mEvents.end(); ++event)
+            {
+                stream << ",\n{\"name\":";
+                writeString(stream, event->mName);
+                stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << (*it)->mThreadId
+                       << ",\"ts\":" << timer->delta_u(sStartTick, event->mStart)
+                       << ",\"dur\":" << timer->delta_u(event->mStart, event->mEnd) << "}";
+            }
+            (*it)->mEvents.clear();
+        }
+
+        stream << "\n]}\n";
+        std::cout << "Profile written to " << sPath << std::endl;
+    }
+
+    void Profiler::record(const char* name, osg::Timer_t start, osg::Timer_t end)
+    {
+        ThreadEvents& events = getThreadEvents();
+        Event event;
+        event.mName = name;
+        event.mStart = start;
+        event.mEnd = end;
+
+        boost::mutex::scoped_lock lock(events.mMutex);
+        events.mEvents.push_back(event);
+    }
+
+}
@@ -0,0 +1,69 @@
+#ifndef OPENMW_COMPONENTS_MISC_PROFILER_H
+#define OPENMW_COMPONENTS_MISC_PROFILER_H
+
+#include <string>
+
+#include <osg/Timer>
+
+#ifdef OPENMW_PROFILING
+#define OPENMW_PROFILE_ZONE_CONCAT2(a, b) a##b
+#define OPENMW_PROFILE_ZONE_CONCAT(a, b) OPENMW_PROFILE_ZONE_CONCAT2(a, b)
+/// Record the rest of the enclosing scope as a zone with the given name, which must be a string literal.
+#define OPENMW_PROFILE_ZONE(name) Misc::Profiler::Zone OPENMW_PROFILE_ZONE_CONCAT(profilerZone, __LINE__) (name)
+#else
+#define OPENMW_PROFILE_ZONE(name)
+#endif
+
+namespace Misc
+{
+
+/*
+  Records how long named zones of the code took on each thread, and writes them in the Chrome trace event
+  format, for chrome://tracing or Perfetto. Zones are only recorded in builds with OPENMW_PROFILING, and
+  only between start() and stop(). The zones are marked with OPENMW_PROFILE_ZONE.
+*/
+class Profiler
+{
+public:
+
+    /// Start recording zones, to be written to the file at \a path when stopped.
+    /// @note The thread that calls start() is named the main thread in the trace.
+    static void start(const std::string& path);
+
+    /// Stop recording, and write the zones recorded since start().
+    static void stop();
+
+    static bool isRunning() { return sRunning; }
+
+    class Zone
+    {
+    public:
+        Zone(const char* name)
+            : mName(sRunning ? name : NULL)
+            , mStart(mName ? osg::Timer::instance()->tick() : 0)
+        {
+        }
+
+        ~Zone()
+        {
+            if (mName)
+                record(mName, mStart, osg::Timer::instance()->tick());
+        }
+
+    private:
+        // NULL unless the profiler was running when the zone was entered
+        const char* mName;
+        osg::Timer_t mStart;
+    };
+
+private:
+
+    // Only written by start() and stop(). Zones that see a stale value are recorded or left out as a whole.
+    static volatile bool sRunning;
+
+    static void record(const char* name, osg::Timer_t start, osg::Timer_t end);
+};
+
+}
+
+#endif
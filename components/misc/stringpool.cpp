@@ -0,0 +1,62 @@
+#include "stringpool.hpp"
+
+namespace Misc
+{
+
+    StringPool::StringPool()
+        : mBuckets(256)
+    {
+    }
+
+    size_t StringPool::hash(const StringView& str)
+    {
+        // FNV-1a
+        size_t hash = 2166136261u;
+        for (size_t i=0; i<str.size(); ++i)
+        {
+            hash ^= static_cast<unsigned char>(str[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    void StringPool::rehash(size_t buckets)
+    {
+        std::vector<std::vector<const std::string*> > old(buckets);
+        old.swap(mBuckets);
+
+        for (std::deque<std::string>::const_iterator it = mStrings.begin(); it != mStrings.end(); ++it)
+            mBuckets[hash(*it) & (buckets - 1)].push_back(&*it);
+    }
+
+    const std::string& StringPool::intern(const StringView& str)
+    {
+        const size_t strHash = hash(str);
+
+        boost::mutex::scoped_lock lock(mMutex);
+
+        std::vector<const std::string*>& bucket = mBuckets[strHash & (mBuckets.size() - 1)];
+        for (std::vector<const std::string*>::const_iterator it = bucket.begin(); it != bucket.end(); ++it)
+        {
+            if (StringView(**it) == str)
+                return **it;
+        }
+
+        mStrings.push_back(str.toString());
+        const std::string& pooled = mStrings.back();
+
+        if (mStrings.size() > 2 * mBuckets.size())
+            rehash(2 * mBuckets.size());
+        else
+            bucket.push_back(&pooled);
+
+        return pooled;
+    }
+
+    size_t StringPool::size() const
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        return mStrings.size();
+    }
+
+}
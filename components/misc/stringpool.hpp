@@ -0,0 +1,48 @@
+#ifndef OPENMW_COMPONENTS_MISC_STRINGPOOL_H
+#define OPENMW_COMPONENTS_MISC_STRINGPOOL_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "stringview.hpp"
+
+namespace Misc
+{
+
+    /// @brief Holds a single copy of each distinct string passed to it.
+    /// @par Strings that are already in the pool are found without allocating, and copies of a pooled
+    /// string share its storage where std::string is reference counted. Strings are only released when
+    /// the pool is destroyed.
+    /// @note Thread safe.
+    class StringPool
+    {
+    public:
+        StringPool();
+
+        /// @return The pooled copy of the given string. The reference stays valid for the lifetime of the pool.
+        const std::string& intern(const StringView& str);
+
+        /// Number of distinct strings in the pool.
+        size_t size() const;
+
+    private:
+        // not implemented
+        StringPool(const StringPool&);
+        StringPool& operator=(const StringPool&);
+
+        static size_t hash(const StringView& str);
+
+        void rehash(size_t buckets);
+
+        mutable boost::mutex mMutex;
+        /// Never shrinks, so references to its strings stay valid
+        std::deque<std::string> mStrings;
+        std::vector<std::vector<const std::string*> > mBuckets;
+    };
+
+}
+
+#endif
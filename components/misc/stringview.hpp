@@ -0,0 +1,62 @@
+#ifndef OPENMW_COMPONENTS_MISC_STRINGVIEW_H
+#define OPENMW_COMPONENTS_MISC_STRINGVIEW_H
+
+#include <cstring>
+#include <string>
+
+namespace Misc
+{
+
+    /// @brief A non-owning reference to a sequence of characters.
+    /// @note The characters are not copied, so they must stay valid for as long as the view is used.
+    class StringView
+    {
+    public:
+        StringView()
+            : mData(""), mSize(0)
+        {
+        }
+
+        StringView(const char* data, size_t size)
+            : mData(data), mSize(size)
+        {
+        }
+
+        StringView(const char* str)
+            : mData(str), mSize(std::strlen(str))
+        {
+        }
+
+        StringView(const std::string& str)
+            : mData(str.c_str()), mSize(str.size())
+        {
+        }
+
+        const char* data() const { return mData; }
+
+        size_t size() const { return mSize; }
+
+        bool empty() const { return mSize == 0; }
+
+        char operator[](size_t index) const { return mData[index]; }
+
+        std::string toString() const { return std::string(mData, mSize); }
+
+        bool operator==(const StringView& other) const
+        {
+            return mSize == other.mSize && std::memcmp(mData, other.mData, mSize) == 0;
+        }
+
+        bool operator!=(const StringView& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        const char* mData;
+        size_t mSize;
+    };
+
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "myguirendermanager.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 #include <MyGUI_Gui.h>
@@ -116,10 +117,20 @@ public:
 
         mReadFrom = (mReadFrom+1)%sNumBuffers;
         const std::vector<Batch>& vec = mBatchVector[mReadFrom];
+        const std::vector<MyGUI::Vertex>& vertices = mVertices[mReadFrom];
+        if (!vertices.empty())
+        {
+            // The vertices of all batches are in one array, so the pointers are only set once per frame.
+            // VBOs disabled due to crash in OSG: http://forum.openscenegraph.org/viewtopic.php?t=14909
+            const char* data = reinterpret_cast<const char*>(&vertices[0]);
+            glVertexPointer(3, GL_FLOAT, sizeof(MyGUI::Vertex), data);
+            glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(MyGUI::Vertex), data + 12);
+            glTexCoordPointer(2, GL_FLOAT, sizeof(MyGUI::Vertex), data + 16);
+        }
+
         for (std::vector<Batch>::const_iterator it = vec.begin(); it != vec.end(); ++it)
         {
             const Batch& batch = *it;
-            osg::VertexBufferObject *vbo = batch.mVertexBuffer;
 
             if (batch.mStateSet)
             {
@@ -131,24 +142,7 @@ public:
             if(texture)
                 state->applyTextureAttribute(0, texture);
 
-            // VBOs disabled due to crash in OSG: http://forum.openscenegraph.org/viewtopic.php?t=14909
-            osg::GLBufferObject* bufferobject = 0;//state->isVertexBufferObjectSupported() ? vbo->getOrCreateGLBufferObject(state->getContextID()) : 0;
-            if (0)//bufferobject)
-            {
-                state->bindVertexBufferObject(bufferobject);
-
-                glVertexPointer(3, GL_FLOAT, sizeof(MyGUI::Vertex), (char*)NULL);
-                glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(MyGUI::Vertex), (char*)NULL + 12);
-                glTexCoordPointer(2, GL_FLOAT, sizeof(MyGUI::Vertex), (char*)NULL + 16);
-            }
-            else
-            {
-                glVertexPointer(3, GL_FLOAT, sizeof(MyGUI::Vertex), (char*)vbo->getArray(0)->getDataPointer());
-                glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(MyGUI::Vertex), (char*)vbo->getArray(0)->getDataPointer() + 12);
-                glTexCoordPointer(2, GL_FLOAT, sizeof(MyGUI::Vertex), (char*)vbo->getArray(0)->getDataPointer() + 16);
-            }
-
-            glDrawArrays(GL_TRIANGLES, 0, batch.mVertexCount);
+            glDrawArrays(GL_TRIANGLES, static_cast<GLint>(batch.mFirstVertex), static_cast<GLsizei>(batch.mVertexCount));
 
             if (batch.mStateSet)
             {
@@ -205,25 +199,45 @@ public:
         // May be empty
         osg::ref_ptr<osg::Texture2D> mTexture;
 
-        osg::ref_ptr<osg::VertexBufferObject> mVertexBuffer;
-        // need to hold on to this too as the mVertexBuffer does not hold a ref to its own array
-        osg::ref_ptr<osg::UByteArray> mArray;
-
         // optional
         osg::ref_ptr<osg::StateSet> mStateSet;
 
+        // The range in the vertices of the frame
+        size_t mFirstVertex;
         size_t mVertexCount;
     };
 
-    void addBatch(const Batch& batch)
+    /// Draw \a count vertices with the given texture and StateSet. Joins the last batch if it has the same state,
+    /// so that consecutive widgets with the same texture are drawn at once.
+    void addBatch(osg::Texture2D* texture, osg::StateSet* stateset, const MyGUI::Vertex* vertices, size_t count)
     {
-        mBatchVector[mWriteTo].push_back(batch);
+        if (!count)
+            return;
+
+        std::vector<Batch>& batches = mBatchVector[mWriteTo];
+        std::vector<MyGUI::Vertex>& frameVertices = mVertices[mWriteTo];
+
+        if (!batches.empty() && batches.back().mTexture == texture && batches.back().mStateSet == stateset)
+            batches.back().mVertexCount += count;
+        else
+        {
+            Batch batch;
+            batch.mTexture = texture;
+            batch.mStateSet = stateset;
+            batch.mFirstVertex = frameVertices.size();
+            batch.mVertexCount = count;
+            batches.push_back(batch);
+        }
+
+        frameVertices.insert(frameVertices.end(), vertices, vertices + count);
     }
 
     void clear()
     {
         mWriteTo = (mWriteTo+1)%sNumBuffers;
         mBatchVector[mWriteTo].clear();
+        // Keeps the memory, the GUI needs about as many vertices every frame
+        mVertices[mWriteTo].clear();
     }
 
     META_Object(osgMyGUI, Drawable)
@@ -234,6 +248,8 @@ private:
 
     // double buffering approach, to avoid the need for synchronization with the draw thread
     std::vector<Batch> mBatchVector[sNumBuffers];
+    // The vertices of the batches, copied from the vertex buffers of the widgets
+    std::vector<MyGUI::Vertex> mVertices[sNumBuffers];
 
     int mWriteTo;
     mutable int mReadFrom;
@@ -241,21 +257,13 @@ private:
 
 class OSGVertexBuffer : public MyGUI::IVertexBuffer
 {
-    osg::ref_ptr<osg::VertexBufferObject> mBuffer;
-    osg::ref_ptr<osg::UByteArray> mVertexArray;
+    // Copied to the Drawable when rendered, so it is not used by the draw thread
+    std::vector<MyGUI::Vertex> mVertices;
 
     size_t mNeedVertexCount;
 
-    bool mQueuedForDrawing;
-
-    void destroy();
-    void create();
-
 public:
     OSGVertexBuffer();
-    virtual ~OSGVertexBuffer();
-
-    void markAsQueuedForDrawing();
 
     virtual void setVertexCount(size_t count);
     virtual size_t getVertexCount();
@@ -265,31 +273,17 @@ public:
 
 /*internal:*/
 
-    osg::VertexBufferObject *getBuffer() const { return mBuffer.get(); }
-    osg::UByteArray *getArray() const { return mVertexArray.get(); }
+    const MyGUI::Vertex *getVertices() const { return mVertices.empty() ? NULL : &mVertices[0]; }
+    size_t getSize() const { return mVertices.size(); }
 };
 
 OSGVertexBuffer::OSGVertexBuffer()
   : mNeedVertexCount(0)
-  , mQueuedForDrawing(false)
-{
-}
-
-OSGVertexBuffer::~OSGVertexBuffer()
-{
-    destroy();
-}
-
-void OSGVertexBuffer::markAsQueuedForDrawing()
 {
-    mQueuedForDrawing = true;
 }
 
 void OSGVertexBuffer::setVertexCount(size_t count)
 {
-    if(count == mNeedVertexCount)
-        return;
-
     mNeedVertexCount = count;
 }
 
@@ -300,48 +294,13 @@ size_t OSGVertexBuffer::getVertexCount()
 
 MyGUI::Vertex *OSGVertexBuffer::lock()
 {
-    if (mQueuedForDrawing || !mVertexArray)
-    {
-        // Force recreating the buffer, to make sure we are not modifying a buffer currently
-        // queued for rendering in the last frame's draw thread.
-        // a more efficient solution might be double buffering
-        destroy();
-        create();
-        mQueuedForDrawing = false;
-    }
-    else
-    {
-        mVertexArray->resize(mNeedVertexCount * sizeof(MyGUI::Vertex));
-    }
+    mVertices.resize(mNeedVertexCount);
 
-    MYGUI_PLATFORM_ASSERT(mBuffer.valid(), "Vertex buffer is not created");
-
-    return (MyGUI::Vertex*)&(*mVertexArray)[0];
+    return mVertices.empty() ? NULL : &mVertices[0];
 }
 
 void OSGVertexBuffer::unlock()
 {
-    mVertexArray->dirty();
-    mBuffer->dirty();
-}
-
-void OSGVertexBuffer::destroy()
-{
-    mBuffer = nullptr;
-    mVertexArray = nullptr;
-}
-
-void OSGVertexBuffer::create()
-{
-    MYGUI_PLATFORM_ASSERT(!mBuffer.valid(), "Vertex buffer already exist");
-
-    mVertexArray = new osg::UByteArray(mNeedVertexCount*sizeof(MyGUI::Vertex));
-
-    mBuffer = new osg::VertexBufferObject;
-    mBuffer->setDataVariance(osg::Object::DYNAMIC);
-    mBuffer->setUsage(GL_DYNAMIC_DRAW);
-    // NB mBuffer does not own the array
-    mBuffer->setArray(0, mVertexArray.get());
 }
 
 // ---------------------------------------------------------------------------
@@ -434,21 +393,18 @@ void RenderManager::begin()
 
 void RenderManager::doRender(MyGUI::IVertexBuffer *buffer, MyGUI::ITexture *texture, size_t count)
 {
-    Drawable::Batch batch;
-    batch.mVertexCount = count;
-    batch.mVertexBuffer = static_cast<OSGVertexBuffer*>(buffer)->getBuffer();
-    static_cast<OSGVertexBuffer*>(buffer)->markAsQueuedForDrawing();
-    batch.mArray = static_cast<OSGVertexBuffer*>(buffer)->getArray();
+    OSGVertexBuffer* vertexBuffer = static_cast<OSGVertexBuffer*>(buffer);
+    count = std::min(count, vertexBuffer->getSize());
+
+    osg::Texture2D* osgTexture = NULL;
     if (texture)
     {
-        batch.mTexture = static_cast<OSGTexture*>(texture)->getTexture();
-        if (batch.mTexture->getDataVariance() == osg::Object::DYNAMIC)
+        osgTexture = static_cast<OSGTexture*>(texture)->getTexture();
+        if (osgTexture->getDataVariance() == osg::Object::DYNAMIC)
             mDrawable->setDataVariance(osg::Object::DYNAMIC); // only for this frame, reset in begin()
     }
-    if (mInjectState)
-        batch.mStateSet = mInjectState;
 
-    mDrawable->addBatch(batch);
+    mDrawable->addBatch(osgTexture, mInjectState, vertexBuffer->getVertices(), count);
 }
 
 void RenderManager::setInjectState(osg::StateSet* stateSet)
@@ -18,17 +18,14 @@ NIFFile::NIFFile(Files::IStreamPtr stream, const std::string &name)
 
 NIFFile::~NIFFile()
 {
-    for (std::vector<Record*>::iterator it = records.begin() ; it != records.end(); ++it)
-    {
-        delete *it;
-    }
+    // The records are owned by mArena
 }
 
-template <typename NodeType> static Record* construct() { return new NodeType; }
+template <typename NodeType> static Record* construct(RecordArena& arena) { return arena.create<NodeType>(); }
 
 struct RecordFactoryEntry {
 
-    typedef Record* (*create_t) ();
+    typedef Record* (*create_t) (RecordArena&);
 
     create_t        mCreate;
     RecordType      mType;
@@ -36,7 +33,7 @@ struct RecordFactoryEntry {
 };
 
 ///Helper function for adding records to the factory map
-static std::pair<std::string,RecordFactoryEntry> makeEntry(std::string recName, Record* (*create_t) (), RecordType type)
+static std::pair<std::string,RecordFactoryEntry> makeEntry(std::string recName, Record* (*create_t) (RecordArena&), RecordType type)
 {
     RecordFactoryEntry anEntry = {create_t,type};
     return std::make_pair(recName, anEntry);
@@ -174,7 +171,7 @@ void NIFFile::parse(Files::IStreamPtr stream)
 
         if (entry != factories.end())
         {
-            r = entry->second.mCreate ();
+            r = entry->second.mCreate (mArena);
             r->recType = entry->second.mType;
         }
         else
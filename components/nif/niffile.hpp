@@ -10,6 +10,7 @@
 #include <components/files/constrainedfilestream.hpp>
 
 #include "record.hpp"
+#include "recordarena.hpp"
 
 namespace Nif
 {
@@ -26,6 +27,9 @@ class NIFFile
     /// File name, used for error messages and opening the file
     std::string filename;
 
+    /// Owns all records, also if parsing fails
+    RecordArena mArena;
+
     /// Record list
     std::vector<Record*> records;
 
@@ -6,7 +6,8 @@
 #include "nifstream.hpp"
 
 #include <sstream>
-#include <map>
+#include <vector>
+#include <algorithm>
 
 #include <boost/shared_ptr.hpp>
 
@@ -35,7 +36,8 @@ typedef KeyT<osg::Quat> QuaternionKey;
 
 template<typename T, T (NIFStream::*getValue)()>
 struct KeyMapT {
-    typedef std::map< float, KeyT<T> > MapType;
+    /// The keys and their times, sorted by time, with one key per time.
+    typedef std::vector< std::pair<float, KeyT<T> > > MapType;
 
     typedef T ValueType;
     typedef KeyT<T> KeyType;
@@ -50,6 +52,23 @@ struct KeyMapT {
 
     KeyMapT() : mInterpolationType(sLinearInterpolation) {}
 
+    /// Orders keys by their time, and a key by its time.
+    struct CompareTime
+    {
+        bool operator()(const typename MapType::value_type& left, const typename MapType::value_type& right) const
+        {
+            return left.first < right.first;
+        }
+        bool operator()(const typename MapType::value_type& key, float time) const
+        {
+            return key.first < time;
+        }
+        bool operator()(float time, const typename MapType::value_type& key) const
+        {
+            return time < key.first;
+        }
+    };
+
     //Read in a KeyGroup (see http://niftools.sourceforge.net/doc/nif/NiKeyframeData.html)
     void read(NIFStream *nif, bool force=false)
     {
@@ -62,6 +81,7 @@ struct KeyMapT {
             return;
 
         mKeys.clear();
+        mKeys.reserve(count);
 
         mInterpolationType = nif->getUInt();
 
@@ -74,7 +94,7 @@ struct KeyMapT {
             {
                 float time = nif->getFloat();
                 readValue(nifReference, key);
-                mKeys[time] = key;
+                mKeys.push_back(std::make_pair(time, key));
             }
         }
         else if(mInterpolationType == sQuadraticInterpolation)
@@ -83,7 +103,7 @@ struct KeyMapT {
             {
                 float time = nif->getFloat();
                 readQuadratic(nifReference, key);
-                mKeys[time] = key;
+                mKeys.push_back(std::make_pair(time, key));
             }
         }
         else if(mInterpolationType == sTBCInterpolation)
@@ -92,7 +112,7 @@ struct KeyMapT {
             {
                 float time = nif->getFloat();
                 readTBC(nifReference, key);
-                mKeys[time] = key;
+                mKeys.push_back(std::make_pair(time, key));
             }
         }
         //XYZ keys aren't actually read here.
@@ -122,9 +142,35 @@ struct KeyMapT {
             error << "Unhandled interpolation type: " << mInterpolationType;
             nif->file->fail(error.str());
         }
+
+        sortKeys();
     }
 
 private:
+    void sortKeys()
+    {
+        // The keys are usually stored in order already
+        for (size_t i=1; i<mKeys.size(); ++i)
+        {
+            if (mKeys[i].first <= mKeys[i-1].first)
+            {
+                std::stable_sort(mKeys.begin(), mKeys.end(), CompareTime());
+                break;
+            }
+        }
+
+        // A key replaces the keys of the same time that were read before it
+        size_t count = 0;
+        for (size_t i=0; i<mKeys.size(); ++i)
+        {
+            if (count > 0 && mKeys[count-1].first == mKeys[i].first)
+                mKeys[count-1] = mKeys[i];
+            else
+                mKeys[count++] = mKeys[i];
+        }
+        mKeys.resize(count);
+    }
+
     static void readValue(NIFStream &nif, KeyT<T> &key)
     {
         key.mValue = (nif.*getValue)();
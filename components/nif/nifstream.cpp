@@ -1,4 +1,9 @@
 #include "nifstream.hpp"
+
+#include <boost/static_assert.hpp>
+
+#include <osg/Endian>
+
 //For error reporting
 #include "niffile.hpp"
 
@@ -33,6 +38,27 @@ float NIFStream::read_le32f()
     return u.f;
 }
 
+void NIFStream::read_le16s(void* data, size_t count)
+{
+    inp->read(static_cast<char*>(data), count * 2);
+    if (osg::getCpuByteOrder() == osg::BigEndian)
+    {
+        char* bytes = static_cast<char*>(data);
+        for (size_t i = 0; i < count; i++)
+            osg::swapBytes2(bytes + 2 * i);
+    }
+}
+void NIFStream::read_le32s(void* data, size_t count)
+{
+    inp->read(static_cast<char*>(data), count * 4);
+    if (osg::getCpuByteOrder() == osg::BigEndian)
+    {
+        char* bytes = static_cast<char*>(data);
+        for (size_t i = 0; i < count; i++)
+            osg::swapBytes4(bytes + 4 * i);
+    }
+}
+
 //Public functions
 osg::Vec2f NIFStream::getVector2()
 {
@@ -103,41 +129,60 @@ std::string NIFStream::getVersionString()
     return result;
 }
 
+// The array types are read straight into their storage
+BOOST_STATIC_ASSERT(sizeof(float) == 4);
+BOOST_STATIC_ASSERT(sizeof(osg::Vec2f) == 2 * sizeof(float));
+BOOST_STATIC_ASSERT(sizeof(osg::Vec3f) == 3 * sizeof(float));
+BOOST_STATIC_ASSERT(sizeof(osg::Vec4f) == 4 * sizeof(float));
+BOOST_STATIC_ASSERT(sizeof(GLushort) == 2);
+
 void NIFStream::getUShorts(osg::VectorGLushort* vec, size_t size)
 {
-    vec->reserve(size);
-    for(size_t i = 0;i < size;i++)
-        vec->push_back(getUShort());
+    const size_t start = vec->size();
+    vec->resize(start + size);
+    if (size)
+        read_le16s(&(*vec)[start], size);
 }
 void NIFStream::getFloats(std::vector<float> &vec, size_t size)
 {
     vec.resize(size);
-    for(size_t i = 0;i < vec.size();i++)
-        vec[i] = getFloat();
+    if (size)
+        read_le32s(&vec[0], size);
 }
 void NIFStream::getVector2s(osg::Vec2Array* vec, size_t size)
 {
-    vec->reserve(size);
-    for(size_t i = 0;i < size;i++)
-        vec->push_back(getVector2());
+    const size_t start = vec->size();
+    vec->resize(start + size);
+    if (size)
+        read_le32s(&(*vec)[start], size * 2);
 }
 void NIFStream::getVector3s(osg::Vec3Array* vec, size_t size)
 {
-    vec->reserve(size);
-    for(size_t i = 0;i < size;i++)
-        vec->push_back(getVector3());
+    const size_t start = vec->size();
+    vec->resize(start + size);
+    if (size)
+        read_le32s(&(*vec)[start], size * 3);
 }
 void NIFStream::getVector4s(osg::Vec4Array* vec, size_t size)
 {
-    vec->reserve(size);
-    for(size_t i = 0;i < size;i++)
-        vec->push_back(getVector4());
+    const size_t start = vec->size();
+    vec->resize(start + size);
+    if (size)
+        read_le32s(&(*vec)[start], size * 4);
 }
 void NIFStream::getQuaternions(std::vector<osg::Quat> &quat, size_t size)
 {
+    // osg::Quat holds doubles in x, y, z, w order, while the file has floats in w, x, y, z order
+    std::vector<float> values(size * 4);
+    if (size)
+        read_le32s(&values[0], values.size());
+
     quat.resize(size);
     for(size_t i = 0;i < quat.size();i++)
-        quat[i] = getQuaternion();
+    {
+        const float* value = &values[i * 4];
+        quat[i] = osg::Quat(value[1], value[2], value[3], value[0]);
+    }
 }
 
 }
@@ -33,6 +33,10 @@ class NIFStream {
     uint32_t read_le32();
     float read_le32f();
 
+    /// Read a number of values in one go, then fix their byte order on big endian hosts
+    void read_le16s(void* data, size_t count);
+    void read_le32s(void* data, size_t count);
+
 public:
 
     NIFFile * const file;
@@ -0,0 +1,50 @@
+#include "recordarena.hpp"
+
+#include "record.hpp"
+
+namespace
+{
+    /// Enough for a few dozen typical records
+    const size_t sBlockSize = 16*1024;
+}
+
+namespace Nif
+{
+
+RecordArena::RecordArena()
+    : mNext(NULL)
+    , mEnd(NULL)
+{
+}
+
+RecordArena::~RecordArena()
+{
+    for (std::vector<Record*>::reverse_iterator it = mRecords.rbegin(); it != mRecords.rend(); ++it)
+        (*it)->~Record();
+
+    for (std::vector<char*>::iterator it = mBlocks.begin(); it != mBlocks.end(); ++it)
+        ::operator delete(*it);
+}
+
+void* RecordArena::allocate(size_t size, size_t alignment)
+{
+    size_t padding = mNext ? (alignment - reinterpret_cast<size_t>(mNext) % alignment) % alignment : 0;
+
+    if (!mNext || padding + size > static_cast<size_t>(mEnd - mNext))
+    {
+        // Memory from operator new is suitably aligned for any type
+        const size_t blockSize = size > sBlockSize ? size : sBlockSize;
+        mBlocks.reserve(mBlocks.size() + 1);
+        char* block = static_cast<char*>(::operator new(blockSize));
+        mBlocks.push_back(block);
+        mNext = block;
+        mEnd = block + blockSize;
+        padding = 0;
+    }
+
+    void* memory = mNext + padding;
+    mNext += padding + size;
+    return memory;
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef OPENMW_COMPONENTS_NIF_RECORDARENA_HPP
+#define OPENMW_COMPONENTS_NIF_RECORDARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include <boost/type_traits/alignment_of.hpp>
+
+namespace Nif
+{
+
+struct Record;
+
+/// @brief Owns the records of a NIF file. Records are placed one after another in large blocks,
+/// instead of being allocated one by one.
+/// @note The records are destroyed together with the arena, in reverse order of creation.
+class RecordArena
+{
+public:
+    RecordArena();
+    ~RecordArena();
+
+    /// Construct a record of the given type in the arena
+    template <class T>
+    T* create()
+    {
+        T* record = new (allocate(sizeof(T), boost::alignment_of<T>::value)) T;
+        mRecords.push_back(record);
+        return record;
+    }
+
+private:
+    RecordArena(const RecordArena&);
+    RecordArena& operator=(const RecordArena&);
+
+    void* allocate(size_t size, size_t alignment);
+
+    std::vector<char*> mBlocks;
+    /// Free space in the last block
+    char* mNext;
+    char* mEnd;
+
+    std::vector<Record*> mRecords;
+};
+
+}
+
+#endif
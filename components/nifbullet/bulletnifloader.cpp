@@ -42,6 +42,7 @@ namespace NifBullet
 BulletNifLoader::BulletNifLoader()
     : mCompoundShape(NULL)
     , mStaticMesh(NULL)
+    , mBuildBvh(true)
 {
 }
 
@@ -49,6 +50,11 @@ BulletNifLoader::~BulletNifLoader()
 {
 }
 
+void BulletNifLoader::setBuildBvh(bool build)
+{
+    mBuildBvh = build;
+}
+
 osg::ref_ptr<Resource::BulletShape> BulletNifLoader::load(const Nif::NIFFilePtr nif)
 {
     mShape = new Resource::BulletShape;
@@ -110,11 +116,11 @@ osg::ref_ptr<Resource::BulletShape> BulletNifLoader::load(const Nif::NIFFilePtr
             {
                 btTransform trans;
                 trans.setIdentity();
-                mCompoundShape->addChildShape(trans, new Resource::TriangleMeshShape(mStaticMesh,true));
+                mCompoundShape->addChildShape(trans, new Resource::TriangleMeshShape(mStaticMesh,true,mBuildBvh));
             }
         }
         else if (mStaticMesh)
-            mShape->mCollisionShape = new Resource::TriangleMeshShape(mStaticMesh,true);
+            mShape->mCollisionShape = new Resource::TriangleMeshShape(mStaticMesh,true,mBuildBvh);
 
         return mShape;
     }
@@ -290,7 +296,7 @@ void BulletNifLoader::handleNiTriShape(const Nif::NiTriShape *shape, int flags,
             childMesh->addTriangle(getbtVector(b1), getbtVector(b2), getbtVector(b3));
         }
 
-        Resource::TriangleMeshShape* childShape = new Resource::TriangleMeshShape(childMesh,true);
+        Resource::TriangleMeshShape* childShape = new Resource::TriangleMeshShape(childMesh,true,mBuildBvh);
 
         float scale = shape->trafo.scale;
         const Nif::Node* parent = shape;
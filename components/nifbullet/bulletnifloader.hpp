@@ -52,6 +52,10 @@ public:
 
     osg::ref_ptr<Resource::BulletShape> load(const Nif::NIFFilePtr file);
 
+    /// Build the BVHs of the triangle mesh shapes, which is the default. If not, the caller has to build them,
+    /// see Resource::BvhCache.
+    void setBuildBvh(bool build);
+
 private:
     bool findBoundingBox(const Nif::Node* node, int flags = 0);
 
@@ -65,6 +69,8 @@ private:
 
     btTriangleMesh* mStaticMesh;
 
+    bool mBuildBvh;
+
     osg::ref_ptr<Resource::BulletShape> mShape;
 };
 
@@ -50,19 +50,16 @@ namespace NifOsg
         typedef typename MapT::ValueType ValueT;
 
         ValueInterpolator()
-            : mDefaultVal(ValueT())
+            : mLastHighKey(0)
+            , mDefaultVal(ValueT())
         {
         }
 
         ValueInterpolator(boost::shared_ptr<const MapT> keys, ValueT defaultVal = ValueT())
-            : mKeys(keys)
+            : mLastHighKey(0)
+            , mKeys(keys)
             , mDefaultVal(defaultVal)
         {
-            if (keys)
-            {
-                mLastLowKey = mKeys->mKeys.end();
-                mLastHighKey = mKeys->mKeys.end();
-            }
         }
 
         ValueT interpKey(float time) const
@@ -72,49 +69,36 @@ namespace NifOsg
 
             const typename MapT::MapType & keys = mKeys->mKeys;
 
-            if(time <= keys.begin()->first)
-                return keys.begin()->second.mValue;
+            if(time <= keys.front().first)
+                return keys.front().second.mValue;
 
-            // retrieve the current position in the map, optimized for the most common case
+            // retrieve the current position in the track, optimized for the most common case
             // where time moves linearly along the keyframe track
-            typename MapT::MapType::const_iterator it = mLastHighKey;
-            if (mLastHighKey != keys.end())
+            size_t high = mLastHighKey;
+            if (!isBetweenKeys(keys, high, time))
             {
-                if (time > mLastHighKey->first)
+                // try if we're there by incrementing one
+                ++high;
+                if (!isBetweenKeys(keys, high, time))
                 {
-                    // try if we're there by incrementing one
-                    ++mLastLowKey;
-                    ++mLastHighKey;
-                    it = mLastHighKey;
+                    // still not there, reorient by a binary search of the whole track
+                    typename MapT::MapType::const_iterator it = std::lower_bound(keys.begin(), keys.end(), time, typename MapT::CompareTime());
+                    if (it == keys.end())
+                        return keys.back().second.mValue;
+                    high = it - keys.begin();
                 }
-                if (mLastHighKey == keys.end() || (time < mLastLowKey->first || time > mLastHighKey->first))
-                    it = keys.lower_bound(time); // still not there, reorient by performing lower_bound check on the whole map
             }
-            else
-                it = keys.lower_bound(time);
-
-            // now do the actual interpolation
-            if (it != keys.end())
-            {
-                float aTime = it->first;
-                const typename MapT::KeyType* aKey = &it->second;
-
-                // cache for next time
-                mLastHighKey = it;
 
-                assert (it != keys.begin()); // Shouldn't happen, was checked at beginning of this function
+            // cache for next time
+            mLastHighKey = high;
 
-                typename MapT::MapType::const_iterator last = --it;
-                mLastLowKey = last;
-                float aLastTime = last->first;
-                const typename MapT::KeyType* aLastKey = &last->second;
+            // now do the actual interpolation
+            const typename MapT::MapType::value_type& key = keys[high];
+            const typename MapT::MapType::value_type& lastKey = keys[high-1];
 
-                float a = (time - aLastTime) / (aTime - aLastTime);
+            float a = (time - lastKey.first) / (key.first - lastKey.first);
 
-                return InterpolationFunc()(aLastKey->mValue, aKey->mValue, a);
-            }
-            else
-                return keys.rbegin()->second.mValue;
+            return InterpolationFunc()(lastKey.second.mValue, key.second.mValue, a);
         }
 
         bool empty() const
@@ -123,8 +107,14 @@ namespace NifOsg
         }
 
     private:
-        mutable typename MapT::MapType::const_iterator mLastLowKey;
-        mutable typename MapT::MapType::const_iterator mLastHighKey;
+        /// Is \a time after the key before \a high, and not after the key \a high?
+        static bool isBetweenKeys(const typename MapT::MapType& keys, size_t high, float time)
+        {
+            return high > 0 && high < keys.size() && time > keys[high-1].first && time <= keys[high].first;
+        }
+
+        // The key at or after the last time looked up
+        mutable size_t mLastHighKey;
 
         boost::shared_ptr<const MapT> mKeys;
 
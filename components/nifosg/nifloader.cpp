@@ -8,6 +8,9 @@
 #include <osg/Version>
 #include <osg/LOD>
 
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
 // resource
 #include <components/misc/stringops.hpp>
 #include <components/misc/resourcehelpers.hpp>
@@ -180,6 +183,8 @@ namespace
             if (!geom)
                 return false;
 
+            // Only the first camera to cull the geometry in a frame morphs it, other cameras may cull it in parallel
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
             if (mLastFrameNumber == nv->getTraversalNumber())
                 return false;
             mLastFrameNumber = nv->getTraversalNumber();
@@ -189,6 +194,7 @@ namespace
         }
 
     private:
+        mutable OpenThreads::Mutex mMutex;
         mutable unsigned int mLastFrameNumber;
     };
 
@@ -1532,6 +1538,19 @@ namespace NifOsg
 
     osg::ref_ptr<osg::Node> Loader::load(Nif::NIFFilePtr file, Resource::TextureManager* textureManager)
     {
+        // Decode the textures at once, rather than one after another while converting
+        std::vector<std::string> textures;
+        for (size_t i=0; i<file->numRecords(); ++i)
+        {
+            const Nif::Record* record = file->getRecord(i);
+            if (record->recType != Nif::RC_NiSourceTexture)
+                continue;
+            const Nif::NiSourceTexture* st = static_cast<const Nif::NiSourceTexture*>(record);
+            if (st->external && !st->filename.empty())
+                textures.push_back(Misc::ResourceHelpers::correctTexturePath(st->filename, textureManager->getVFS()));
+        }
+        textureManager->prefetchImages(textures);
+
         LoaderImpl impl(file->getFilename());
         return impl.load(file, textureManager);
     }
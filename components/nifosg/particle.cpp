@@ -126,6 +126,30 @@ void GrowFadeAffector::operate(osgParticle::Particle* particle, double /* dt */)
     particle->setSizeRange(osgParticle::rangef(size, size));
 }
 
+void GrowFadeAffector::operateParticles(osgParticle::ParticleSystem *ps, double /* dt */)
+{
+    if (!isEnabled())
+        return;
+
+    const float invGrowTime = mGrowTime != 0.f ? 1.f / mGrowTime : 0.f;
+    const float invFadeTime = mFadeTime != 0.f ? 1.f / mFadeTime : 0.f;
+    for (int i=0; i<ps->numParticles(); ++i)
+    {
+        osgParticle::Particle* particle = ps->getParticle(i);
+        if (!particle->isAlive())
+            continue;
+
+        const float age = static_cast<float>(particle->getAge());
+        const float remaining = particle->getLifeTime() - age;
+        float size = mCachedDefaultSize;
+        if (age < mGrowTime && mGrowTime != 0.f)
+            size *= age * invGrowTime;
+        if (remaining < mFadeTime && mFadeTime != 0.f)
+            size *= remaining * invFadeTime;
+        particle->setSizeRange(osgParticle::rangef(size, size));
+    }
+}
+
 ParticleColorAffector::ParticleColorAffector(const Nif::NiColorData *clrdata)
     : mData(clrdata->mKeyMap, osg::Vec4f(1,1,1,1))
 {
@@ -150,6 +174,23 @@ void ParticleColorAffector::operate(osgParticle::Particle* particle, double /* d
     particle->setColorRange(osgParticle::rangev4(color, color));
 }
 
+void ParticleColorAffector::operateParticles(osgParticle::ParticleSystem *ps, double /* dt */)
+{
+    if (!isEnabled())
+        return;
+
+    for (int i=0; i<ps->numParticles(); ++i)
+    {
+        osgParticle::Particle* particle = ps->getParticle(i);
+        if (!particle->isAlive())
+            continue;
+
+        float time = static_cast<float>(particle->getAge()/particle->getLifeTime());
+        osg::Vec4f color = mData.interpKey(time);
+        particle->setColorRange(osgParticle::rangev4(color, color));
+    }
+}
+
 GravityAffector::GravityAffector(const Nif::NiGravity *gravity)
     : mForce(gravity->mForce)
     , mType(static_cast<ForceType>(gravity->mType))
@@ -217,8 +258,68 @@ void GravityAffector::operate(osgParticle::Particle *particle, double dt)
     }
 }
 
+void GravityAffector::operateParticles(osgParticle::ParticleSystem *ps, double dt)
+{
+    if (!isEnabled())
+        return;
+
+    const float magic = 1.6f;
+    const float force = static_cast<float>(mForce * dt * magic);
+    const int numParticles = ps->numParticles();
+    switch (mType)
+    {
+        case Type_Wind:
+        {
+            const osg::Vec3f velocity = mCachedWorldDirection * force;
+            if (mDecay == 0.f)
+            {
+                for (int i=0; i<numParticles; ++i)
+                {
+                    osgParticle::Particle* particle = ps->getParticle(i);
+                    if (particle->isAlive())
+                        particle->addVelocity(velocity);
+                }
+                break;
+            }
+
+            const osg::Plane gravityPlane(mCachedWorldDirection, mCachedWorldPosition);
+            for (int i=0; i<numParticles; ++i)
+            {
+                osgParticle::Particle* particle = ps->getParticle(i);
+                if (!particle->isAlive())
+                    continue;
+
+                float distance = std::abs(gravityPlane.distance(particle->getPosition()));
+                particle->addVelocity(velocity * std::exp(-1.f * mDecay * distance));
+            }
+            break;
+        }
+        case Type_Point:
+        {
+            for (int i=0; i<numParticles; ++i)
+            {
+                osgParticle::Particle* particle = ps->getParticle(i);
+                if (!particle->isAlive())
+                    continue;
+
+                osg::Vec3f diff = mCachedWorldPosition - particle->getPosition();
+
+                float decayFactor = 1.f;
+                if (mDecay != 0.f)
+                    decayFactor = std::exp(-1.f * mDecay * diff.length());
+
+                diff.normalize();
+
+                particle->addVelocity(diff * (force * decayFactor));
+            }
+            break;
+        }
+    }
+}
+
 Emitter::Emitter()
     : osgParticle::Emitter()
+    , mSkipNextEmission(false)
 {
 }
 
@@ -229,11 +330,13 @@ Emitter::Emitter(const Emitter &copy, const osg::CopyOp &copyop)
     , mShooter(copy.mShooter)
     // need a deep copy because the remainder is stored in the object
     , mCounter(osg::clone(copy.mCounter.get(), osg::CopyOp::DEEP_COPY_ALL))
+    , mSkipNextEmission(copy.mSkipNextEmission)
 {
 }
 
 Emitter::Emitter(const std::vector<int> &targets)
     : mTargets(targets)
+    , mSkipNextEmission(false)
 {
 }
 
@@ -252,8 +355,19 @@ void Emitter::setCounter(osgParticle::Counter *counter)
     mCounter = counter;
 }
 
+void Emitter::skipNextEmission()
+{
+    mSkipNextEmission = true;
+}
+
 void Emitter::emitParticles(double dt)
 {
+    if (mSkipNextEmission)
+    {
+        mSkipNextEmission = false;
+        return;
+    }
+
     int n = mCounter->numParticlesToCreate(dt);
     if (n == 0)
         return;
@@ -374,4 +488,27 @@ void PlanarCollider::operate(osgParticle::Particle *particle, double dt)
     }
 }
 
+void PlanarCollider::operateParticles(osgParticle::ParticleSystem *ps, double /* dt */)
+{
+    if (!isEnabled())
+        return;
+
+    const osg::Vec3f normal = mPlaneInParticleSpace.getNormal();
+    for (int i=0; i<ps->numParticles(); ++i)
+    {
+        osgParticle::Particle* particle = ps->getParticle(i);
+        if (!particle->isAlive())
+            continue;
+
+        float dotproduct = particle->getVelocity() * normal;
+        // Same test as osg::Plane::intersect for a sphere of radius 0
+        if (dotproduct > 0 && mPlaneInParticleSpace.distance(particle->getPosition()) > 0.f)
+        {
+            osg::Vec3f reflectedVelocity = particle->getVelocity() - normal * (2 * dotproduct);
+            reflectedVelocity *= mBounceFactor;
+            particle->setVelocity(reflectedVelocity);
+        }
+    }
+}
+
 }
@@ -5,6 +5,7 @@
 #include <osgParticle/Shooter>
 #include <osgParticle/Operator>
 #include <osgParticle/ModularEmitter>
+#include <osgParticle/ParticleSystem>
 
 #include <osg/NodeCallback>
 #include <osg/UserDataContainer>
@@ -93,6 +94,8 @@ namespace NifOsg
         float mLifetimeRandom;
     };
 
+    // The affectors and colliders override operateParticles() to update all particles of the system in one loop, with the
+    // values that are the same for all particles computed once. operate() does the same for a single particle.
     class PlanarCollider : public osgParticle::Operator
     {
     public:
@@ -104,6 +107,7 @@ namespace NifOsg
 
         virtual void beginOperate(osgParticle::Program* program);
         virtual void operate(osgParticle::Particle* particle, double dt);
+        virtual void operateParticles(osgParticle::ParticleSystem* ps, double dt);
 
     private:
         float mBounceFactor;
@@ -122,6 +126,7 @@ namespace NifOsg
 
         virtual void beginOperate(osgParticle::Program* program);
         virtual void operate(osgParticle::Particle* particle, double dt);
+        virtual void operateParticles(osgParticle::ParticleSystem* ps, double dt);
 
     private:
         float mGrowTime;
@@ -141,6 +146,7 @@ namespace NifOsg
         META_Object(NifOsg, ParticleColorAffector)
 
         virtual void operate(osgParticle::Particle* particle, double dt);
+        virtual void operateParticles(osgParticle::ParticleSystem* ps, double dt);
 
     private:
         Vec4Interpolator mData;
@@ -156,6 +162,7 @@ namespace NifOsg
         META_Object(NifOsg, GravityAffector)
 
         virtual void operate(osgParticle::Particle* particle, double dt);
+        virtual void operateParticles(osgParticle::ParticleSystem* ps, double dt);
         virtual void beginOperate(osgParticle::Program *);
 
     private:
@@ -203,6 +210,10 @@ namespace NifOsg
         void setPlacer(osgParticle::Placer* placer);
         void setCounter(osgParticle::Counter* counter);
 
+        /// Do not emit particles on the next update, like a newly attached emitter. For reusing an emitter that was
+        /// detached for a while, since the time step of its next update covers all that time.
+        void skipNextEmission();
+
     private:
         // NIF Record indices
         std::vector<int> mTargets;
@@ -210,6 +221,8 @@ namespace NifOsg
         osg::ref_ptr<osgParticle::Placer> mPlacer;
         osg::ref_ptr<osgParticle::Shooter> mShooter;
         osg::ref_ptr<osgParticle::Counter> mCounter;
+
+        bool mSkipNextEmission;
     };
 
 }
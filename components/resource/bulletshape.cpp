@@ -7,6 +7,50 @@
 #include <BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h>
 #include <BulletCollision/CollisionShapes/btCompoundShape.h>
 
+namespace
+{
+
+#if BT_BULLET_VERSION < 283
+/// Shares the mesh and BVH of another shape until it is scaled. Older Bullet versions can not wrap the other shape in a
+/// btScaledBvhTriangleMeshShape ( https://code.google.com/p/bullet/issues/detail?id=371 ), and scaling a
+/// btBvhTriangleMeshShape scales its mesh, so the mesh is only copied for scaled instances, which build their own BVH.
+class SharedTriangleMeshShape : public btBvhTriangleMeshShape
+{
+public:
+    SharedTriangleMeshShape(btBvhTriangleMeshShape* source)
+        : btBvhTriangleMeshShape(source->getMeshInterface(), source->usesQuantizedAabbCompression(), false)
+        , mOwnMesh(NULL)
+    {
+        // The pointer is safe because the BulletShapeInstance keeps a ref_ptr to the original BulletShape
+        setOptimizedBvh(source->getOptimizedBvh());
+    }
+
+    virtual ~SharedTriangleMeshShape()
+    {
+        delete mOwnMesh;
+    }
+
+    virtual void setLocalScaling(const btVector3& scaling)
+    {
+        if ((getLocalScaling() - scaling).length2() <= SIMD_EPSILON)
+            return;
+
+        if (!mOwnMesh)
+        {
+            mOwnMesh = new btTriangleMesh(*static_cast<btTriangleMesh*>(m_meshInterface));
+            m_meshInterface = mOwnMesh;
+        }
+        // Scales the mesh, and builds a BVH of its own
+        btBvhTriangleMeshShape::setLocalScaling(scaling);
+    }
+
+private:
+    btTriangleMesh* mOwnMesh;
+};
+#endif
+
+}
+
 namespace Resource
 {
 
@@ -16,6 +60,15 @@ BulletShape::BulletShape()
 
 }
 
+BulletShape::BulletShape(const BulletShape &copy, const osg::CopyOp &copyop)
+    : osg::Object(copy, copyop)
+    , mCollisionShape(copy.mCollisionShape ? duplicateCollisionShape(copy.mCollisionShape) : NULL)
+    , mCollisionBoxHalfExtents(copy.mCollisionBoxHalfExtents)
+    , mCollisionBoxTranslate(copy.mCollisionBoxTranslate)
+    , mAnimatedShapes(copy.mAnimatedShapes)
+{
+}
+
 BulletShape::~BulletShape()
 {
     deleteShape(mCollisionShape);
@@ -59,19 +112,7 @@ btCollisionShape* BulletShape::duplicateCollisionShape(btCollisionShape *shape)
 #if BT_BULLET_VERSION >= 283
         btScaledBvhTriangleMeshShape* newShape = new btScaledBvhTriangleMeshShape(trishape, btVector3(1.f, 1.f, 1.f));
 #else
-        // work around btScaledBvhTriangleMeshShape bug ( https://code.google.com/p/bullet/issues/detail?id=371 ) in older bullet versions
-        btTriangleMesh* oldMesh = static_cast<btTriangleMesh*>(trishape->getMeshInterface());
-        btTriangleMesh* newMesh = new btTriangleMesh(*oldMesh);
-
-        // Do not build a new bvh (not needed, since it's the same as the original shape's bvh)
-        bool buildBvh = true;
-        if (trishape->getOptimizedBvh())
-            buildBvh = false;
-        TriangleMeshShape* newShape = new TriangleMeshShape(newMesh, true, buildBvh);
-        // Set original shape's bvh via pointer
-        // The pointer is safe because the BulletShapeInstance keeps a ref_ptr to the original BulletShape
-        if (!buildBvh)
-            newShape->setOptimizedBvh(trishape->getOptimizedBvh());
+        btBvhTriangleMeshShape* newShape = new SharedTriangleMeshShape(trishape);
 #endif
         return newShape;
     }
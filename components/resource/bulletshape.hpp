@@ -3,7 +3,7 @@
 
 #include <map>
 
-#include <osg/Referenced>
+#include <osg/Object>
 #include <osg/ref_ptr>
 #include <osg/Vec3f>
 
@@ -15,12 +15,16 @@ namespace Resource
 {
 
     class BulletShapeInstance;
-    class BulletShape : public osg::Referenced
+    class BulletShape : public osg::Object
     {
     public:
         BulletShape();
+        /// @note The copy shares the triangle meshes of \a copy, which has to outlive it.
+        BulletShape(const BulletShape& copy, const osg::CopyOp& copyop);
         virtual ~BulletShape();
 
+        META_Object(Resource, BulletShape)
+
         btCollisionShape* mCollisionShape;
 
         // Used for actors. Note, ideally actors would use a separate loader - as it is
@@ -62,6 +66,7 @@ namespace Resource
     {
         TriangleMeshShape(btStridingMeshInterface* meshInterface, bool useQuantizedAabbCompression, bool buildBvh = true)
             : btBvhTriangleMeshShape(meshInterface, useQuantizedAabbCompression, buildBvh)
+            , mBvhBuffer(NULL)
         {
         }
 
@@ -69,7 +74,20 @@ namespace Resource
         {
             delete getTriangleInfoMap();
             delete m_meshInterface;
+            if (mBvhBuffer)
+                btAlignedFree(mBvhBuffer);
+        }
+
+        /// Use a BVH that was deserialized in place, see BvhCache. The shape must not have a BVH yet.
+        /// @param buffer Holds the BVH, allocated with btAlignedAlloc. The shape takes it over.
+        void setSerializedBvh(btOptimizedBvh* bvh, void* buffer)
+        {
+            setOptimizedBvh(bvh);
+            mBvhBuffer = buffer;
         }
+
+    private:
+        void* mBvhBuffer;
     };
 
 
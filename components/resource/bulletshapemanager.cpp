@@ -1,16 +1,22 @@
 #include "bulletshapemanager.hpp"
 
+#include <OpenThreads/ScopedLock>
+
 #include <osg/NodeVisitor>
 #include <osg/Geode>
+#include <osg/Stats>
 #include <osg/TriangleFunctor>
 
 #include <BulletCollision/CollisionShapes/btTriangleMesh.h>
+#include <BulletCollision/CollisionShapes/btCompoundShape.h>
 
 #include <components/vfs/manager.hpp>
 
 #include <components/nifbullet/bulletnifloader.hpp>
 
 #include "bulletshape.hpp"
+#include "bvhcache.hpp"
+#include "objectcache.hpp"
 #include "scenemanager.hpp"
 #include "niffilemanager.hpp"
 
@@ -95,8 +101,21 @@ private:
     btTriangleMesh* mTriangleMesh;
 };
 
+/// Set up the BVHs of the triangle mesh shapes that were created without one.
+static void setUpBvhs(const std::string& normalizedName, btCollisionShape* shape, const BvhCache& bvhCache)
+{
+    if (shape->isCompound())
+    {
+        btCompoundShape* compound = static_cast<btCompoundShape*>(shape);
+        for (int i=0; i<compound->getNumChildShapes(); ++i)
+            setUpBvhs(normalizedName, compound->getChildShape(i), bvhCache);
+    }
+    else if (TriangleMeshShape* meshShape = dynamic_cast<TriangleMeshShape*>(shape))
+        bvhCache.setUpBvh(normalizedName, *meshShape);
+}
+
 BulletShapeManager::BulletShapeManager(const VFS::Manager* vfs, SceneManager* sceneMgr, NifFileManager* nifFileManager)
-    : mVFS(vfs)
+    : ResourceManager(vfs)
     , mSceneManager(sceneMgr)
     , mNifFileManager(nifFileManager)
 {
@@ -108,15 +127,19 @@ BulletShapeManager::~BulletShapeManager()
 
 }
 
-osg::ref_ptr<BulletShapeInstance> BulletShapeManager::createInstance(const std::string &name)
+osg::ref_ptr<BulletShape> BulletShapeManager::getShape(const std::string &name)
 {
     std::string normalized = name;
     mVFS->normalizeFilename(normalized);
 
     osg::ref_ptr<BulletShape> shape;
-    Index::iterator it = mIndex.find(normalized);
-    if (it == mIndex.end())
+    osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(normalized);
+    if (obj)
+        shape = static_cast<BulletShape*>(obj.get());
+    else
     {
+        countLoad();
+
         size_t extPos = normalized.find_last_of('.');
         std::string ext;
         if (extPos != std::string::npos && extPos+1 < normalized.size())
@@ -125,7 +148,10 @@ osg::ref_ptr<BulletShapeInstance> BulletShapeManager::createInstance(const std::
         if (ext == "nif")
         {
             NifBullet::BulletNifLoader loader;
+            loader.setBuildBvh(!mBvhCache.get());
             shape = loader.load(mNifFileManager->get(normalized));
+            if (mBvhCache.get() && shape->mCollisionShape)
+                setUpBvhs(normalized, shape->mCollisionShape, *mBvhCache);
         }
         else
         {
@@ -137,16 +163,37 @@ osg::ref_ptr<BulletShapeInstance> BulletShapeManager::createInstance(const std::
             node->accept(visitor);
             shape = visitor.getShape();
             if (!shape)
-                return osg::ref_ptr<BulletShapeInstance>();
+                return osg::ref_ptr<BulletShape>();
         }
 
-        mIndex[normalized] = shape;
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mCacheMutex);
+        // Another thread may have loaded the same shape meanwhile
+        obj = mCache->getRefFromObjectCache(normalized);
+        if (obj)
+            return static_cast<BulletShape*>(obj.get());
+        addToCache(normalized, shape);
     }
-    else
-        shape = it->second;
+    return shape;
+}
+
+void BulletShapeManager::setBvhCacheDirectory(const boost::filesystem::path &directory)
+{
+    mBvhCache.reset(new BvhCache(directory));
+}
+
+osg::ref_ptr<BulletShapeInstance> BulletShapeManager::createInstance(const std::string &name)
+{
+    osg::ref_ptr<BulletShape> shape = getShape(name);
+    if (!shape)
+        return osg::ref_ptr<BulletShapeInstance>();
 
     osg::ref_ptr<BulletShapeInstance> instance = shape->makeInstance();
     return instance;
 }
 
+void BulletShapeManager::reportStats(unsigned int frameNumber, osg::Stats &stats) const
+{
+    stats.setAttribute(frameNumber, "resource_bullet_shapes", getCacheSize());
+}
+
 }
@@ -1,17 +1,17 @@
 #ifndef OPENMW_COMPONENTS_BULLETSHAPEMANAGER_H
 #define OPENMW_COMPONENTS_BULLETSHAPEMANAGER_H
 
-#include <map>
+#include <memory>
 #include <string>
 
+#include <boost/filesystem/path.hpp>
+
+#include <OpenThreads/Mutex>
+
 #include <osg/ref_ptr>
 
 #include "bulletshape.hpp"
-
-namespace VFS
-{
-    class Manager;
-}
+#include "resourcemanager.hpp"
 
 namespace Resource
 {
@@ -20,22 +20,34 @@ namespace Resource
 
     class BulletShape;
     class BulletShapeInstance;
+    class BvhCache;
 
-    class BulletShapeManager
+    class BulletShapeManager : public ResourceManager
     {
     public:
         BulletShapeManager(const VFS::Manager* vfs, SceneManager* sceneMgr, NifFileManager* nifFileManager);
         ~BulletShapeManager();
 
+        /// Get the shared shape of the given model, e.g. to keep it loaded.
+        /// @note This method is safe to call from any thread.
+        /// @return NULL if the model has no collision shape.
+        osg::ref_ptr<BulletShape> getShape(const std::string& name);
+
         osg::ref_ptr<BulletShapeInstance> createInstance(const std::string& name);
 
+        virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
+
+        /// Keep the BVHs of the triangle mesh shapes of NIF files in the given directory, see BvhCache.
+        void setBvhCacheDirectory(const boost::filesystem::path& directory);
+
     private:
-        const VFS::Manager* mVFS;
         SceneManager* mSceneManager;
         NifFileManager* mNifFileManager;
 
-        typedef std::map<std::string, osg::ref_ptr<BulletShape> > Index;
-        Index mIndex;
+        std::auto_ptr<BvhCache> mBvhCache;
+
+        // Serializes adding shapes to the cache, since shapes can be preloaded in the background
+        OpenThreads::Mutex mCacheMutex;
     };
 
 }
@@ -0,0 +1,169 @@
+#include "bvhcache.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <LinearMath/btScalar.h>
+#include <LinearMath/btAlignedAllocator.h>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+#include <BulletCollision/CollisionShapes/btStridingMeshInterface.h>
+
+#include "bulletshape.hpp"
+
+namespace
+{
+
+    /// Increase when the meshes made by NifBullet::BulletNifLoader change in a way the mesh hash does not show
+    const int sFormatVersion = 1;
+
+    const uint64_t sHashBasis = 14695981039346656037ull;
+
+    uint64_t hashData(const unsigned char* data, size_t size, uint64_t hash)
+    {
+        // FNV-1a
+        for (size_t i=0; i<size; ++i)
+        {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t hashMesh(const btStridingMeshInterface& mesh)
+    {
+        uint64_t hash = sHashBasis;
+        for (int part=0; part<mesh.getNumSubParts(); ++part)
+        {
+            const unsigned char* vertices = NULL;
+            const unsigned char* indices = NULL;
+            int numVertices, vertexStride, numFaces, indexStride;
+            PHY_ScalarType vertexType, indexType;
+            mesh.getLockedReadOnlyVertexIndexBase(&vertices, numVertices, vertexType, vertexStride,
+                                                  &indices, indexStride, numFaces, indexType, part);
+            hash = hashData(vertices, static_cast<size_t>(numVertices) * vertexStride, hash);
+            hash = hashData(indices, static_cast<size_t>(numFaces) * indexStride, hash);
+            mesh.unLockReadOnlyVertexBase(part);
+        }
+        return hash;
+    }
+
+}
+
+namespace Resource
+{
+
+    BvhCache::BvhCache(const boost::filesystem::path &directory)
+        : mDirectory(directory)
+    {
+    }
+
+    boost::filesystem::path BvhCache::getPath(const std::string &normalizedName, uint64_t meshHash, bool quantized) const
+    {
+        const unsigned char* name = reinterpret_cast<const unsigned char*>(normalizedName.data());
+        std::ostringstream fileName;
+        fileName << std::hex << std::setfill('0')
+                 << std::setw(16) << hashData(name, normalizedName.size(), sHashBasis) << '-'
+                 << std::setw(16) << meshHash << '-'
+                 << std::dec << sFormatVersion << '-' << BT_BULLET_VERSION << '-' << sizeof(void*) * 8
+                 << (quantized ? "q" : "") << ".bvh";
+        return mDirectory / fileName.str();
+    }
+
+    void BvhCache::setUpBvh(const std::string &normalizedName, TriangleMeshShape &shape) const
+    {
+        if (shape.getOptimizedBvh())
+            return;
+
+        const boost::filesystem::path path = getPath(normalizedName, hashMesh(*shape.getMeshInterface()),
+                                                     shape.usesQuantizedAabbCompression());
+        if (read(path, shape))
+            return;
+
+        shape.buildOptimizedBvh();
+        if (shape.getOptimizedBvh())
+            write(path, *shape.getOptimizedBvh());
+    }
+
+    bool BvhCache::read(const boost::filesystem::path &path, TriangleMeshShape &shape) const
+    {
+        void* buffer = NULL;
+        try
+        {
+            if (!boost::filesystem::exists(path))
+                return false;
+
+            boost::filesystem::ifstream stream(path, std::ios::binary);
+            if (!stream.is_open())
+                return false;
+
+            stream.seekg(0, std::ios::end);
+            const std::streamoff size = stream.tellg();
+            stream.seekg(0, std::ios::beg);
+            if (size <= 0)
+                return false;
+
+            // The BVH is used right where it is read, so the buffer has to be aligned like Bullet's own allocations
+            buffer = btAlignedAlloc(static_cast<size_t>(size), 16);
+            stream.read(static_cast<char*>(buffer), size);
+            if (stream.fail())
+                throw std::runtime_error("read operation failed");
+
+            btQuantizedBvh* bvh = btQuantizedBvh::deSerializeInPlace(buffer, static_cast<unsigned int>(size), false);
+            if (!bvh)
+                throw std::runtime_error("invalid data");
+
+            // btOptimizedBvh adds no data to btQuantizedBvh, see the Bullet ConcaveDemo
+            shape.setSerializedBvh(static_cast<btOptimizedBvh*>(bvh), buffer);
+            return true;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to read cached collision shape " << path.filename().string() << ": " << e.what() << std::endl;
+            if (buffer)
+                btAlignedFree(buffer);
+            return false;
+        }
+    }
+
+    void BvhCache::write(const boost::filesystem::path &path, btOptimizedBvh &bvh) const
+    {
+        // Write to a temporary file first, so a BVH is never left half written
+        boost::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+
+        const unsigned int size = bvh.calculateSerializeBufferSize();
+        void* buffer = btAlignedAlloc(size, 16);
+        try
+        {
+            if (!bvh.serialize(buffer, size, false))
+                throw std::runtime_error("serialization failed");
+
+            if (!boost::filesystem::exists(mDirectory))
+                boost::filesystem::create_directories(mDirectory);
+
+            {
+                boost::filesystem::ofstream stream(tempPath, std::ios::binary | std::ios::out | std::ios::trunc);
+                if (!stream.is_open())
+                    throw std::runtime_error("can not open file for writing");
+                stream.write(static_cast<const char*>(buffer), size);
+                if (stream.fail())
+                    throw std::runtime_error("write operation failed");
+            }
+
+            boost::filesystem::rename(tempPath, path);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to cache collision shape " << path.filename().string() << ": " << e.what() << std::endl;
+            boost::system::error_code ec;
+            boost::filesystem::remove(tempPath, ec);
+        }
+        btAlignedFree(buffer);
+    }
+
+}
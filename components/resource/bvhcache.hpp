@@ -0,0 +1,42 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_BVHCACHE_H
+#define OPENMW_COMPONENTS_RESOURCE_BVHCACHE_H
+
+#include <stdint.h>
+#include <string>
+
+#include <boost/filesystem/path.hpp>
+
+class btOptimizedBvh;
+
+namespace Resource
+{
+    struct TriangleMeshShape;
+
+    /// @brief Keeps the bounding volume hierarchies of triangle mesh collision shapes on disk, so they do not have to
+    /// be built again on the next run.
+    /// @par BVHs are stored by the name of the model and a hash of the triangles, so a changed mesh gets a new BVH.
+    /// They are stored in the in-place serialization format of btQuantizedBvh, which is read directly into the
+    /// memory the shape uses, and depends on the Bullet version and the pointer size.
+    /// @par The meshes themselves are quick to build from the NIF file, so they are not stored.
+    class BvhCache
+    {
+    public:
+        BvhCache(const boost::filesystem::path& directory);
+
+        /// Read the BVH of the given shape, which was created without one, or build it and store it.
+        /// @note Thread safe.
+        void setUpBvh(const std::string& normalizedName, TriangleMeshShape& shape) const;
+
+    private:
+        boost::filesystem::path getPath(const std::string& normalizedName, uint64_t meshHash, bool quantized) const;
+
+        bool read(const boost::filesystem::path& path, TriangleMeshShape& shape) const;
+
+        void write(const boost::filesystem::path& path, btOptimizedBvh& bvh) const;
+
+        boost::filesystem::path mDirectory;
+    };
+
+}
+
+#endif
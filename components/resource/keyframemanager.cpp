@@ -9,8 +9,7 @@ namespace Resource
 {
 
     KeyframeManager::KeyframeManager(const VFS::Manager* vfs)
-        : mCache(new osgDB::ObjectCache)
-        , mVFS(vfs)
+        : ResourceManager(vfs)
     {
     }
 
@@ -28,10 +27,11 @@ namespace Resource
             return osg::ref_ptr<const NifOsg::KeyframeHolder>(static_cast<NifOsg::KeyframeHolder*>(obj.get()));
         else
         {
+            countLoad();
             osg::ref_ptr<NifOsg::KeyframeHolder> loaded (new NifOsg::KeyframeHolder);
             NifOsg::Loader::loadKf(Nif::NIFFilePtr(new Nif::NIFFile(mVFS->getNormalized(normalized), normalized)), *loaded.get());
 
-            mCache->addEntryToObjectCache(normalized, loaded);
+            addToCache(normalized, loaded);
             return loaded;
         }
     }
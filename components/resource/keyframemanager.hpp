@@ -4,15 +4,7 @@
 #include <osg/ref_ptr>
 #include <string>
 
-namespace VFS
-{
-    class Manager;
-}
-
-namespace osgDB
-{
-    class ObjectCache;
-}
+#include "resourcemanager.hpp"
 
 namespace NifOsg
 {
@@ -23,23 +15,16 @@ namespace Resource
 {
 
     /// @brief Managing of keyframe resources
-    class KeyframeManager
+    class KeyframeManager : public ResourceManager
     {
     public:
         KeyframeManager(const VFS::Manager* vfs);
         ~KeyframeManager();
 
-        void clearCache();
-
         /// Retrieve a read-only keyframe resource by name (case-insensitive).
         /// @note This method is safe to call from any thread.
         /// @note Throws an exception if the resource is not found.
         osg::ref_ptr<const NifOsg::KeyframeHolder> get(const std::string& name);
-
-    private:
-        osg::ref_ptr<osgDB::ObjectCache> mCache;
-
-        const VFS::Manager* mVFS;
     };
 
 }
@@ -1,5 +1,13 @@
 #include "niffilemanager.hpp"
 
+#include <algorithm>
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <osg/Stats>
+
 #include <components/vfs/manager.hpp>
 
 #include "objectcache.hpp"
@@ -28,10 +36,60 @@ namespace Resource
         Nif::NIFFilePtr mNifFile;
     };
 
+    /// Parses a list of NIF files on a number of threads.
+    class ParseNifsJob
+    {
+    public:
+        ParseNifsJob(const VFS::Manager* vfs, const std::vector<std::string>& names)
+            : mVFS(vfs)
+            , mNames(names)
+            , mNext(0)
+            , mResults(names.size())
+        {
+        }
+
+        void run()
+        {
+            while (true)
+            {
+                size_t index;
+                {
+                    boost::mutex::scoped_lock lock(mMutex);
+                    if (mNext >= mNames.size())
+                        return;
+                    index = mNext++;
+                }
+
+                try
+                {
+                    mResults[index].reset(new Nif::NIFFile(mVFS->getNormalized(mNames[index]), mNames[index]));
+                }
+                catch (std::exception&)
+                {
+                    // Leave the file empty, get() reports the error when it is requested again
+                }
+            }
+        }
+
+        /// @note Only call once all threads have finished.
+        const std::vector<Nif::NIFFilePtr>& getResults() const
+        {
+            return mResults;
+        }
+
+    private:
+        const VFS::Manager* mVFS;
+        const std::vector<std::string>& mNames;
+
+        boost::mutex mMutex;
+        size_t mNext;
+
+        std::vector<Nif::NIFFilePtr> mResults;
+    };
+
     NifFileManager::NifFileManager(const VFS::Manager *vfs)
-        : mVFS(vfs)
+        : ResourceManager(vfs)
     {
-        mCache = new osgDB::ObjectCache;
     }
 
     NifFileManager::~NifFileManager()
@@ -39,13 +97,6 @@ namespace Resource
 
     }
 
-    void NifFileManager::clearCache()
-    {
-        // NIF files aren't needed any more when the converted objects are cached in SceneManager / BulletShapeManager,
-        // so we'll simply drop all nif files here, unlikely to need them again
-        mCache->clear();
-    }
-
     Nif::NIFFilePtr NifFileManager::get(const std::string &name)
     {
         osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(name);
@@ -53,11 +104,73 @@ namespace Resource
             return static_cast<NifFileHolder*>(obj.get())->mNifFile;
         else
         {
+            countLoad();
             Nif::NIFFilePtr file (new Nif::NIFFile(mVFS->getNormalized(name), name));
             obj = new NifFileHolder(file);
-            mCache->addEntryToObjectCache(name, obj);
+            addToCache(name, obj);
             return file;
         }
     }
 
+    void NifFileManager::getMany(const std::vector<std::string> &names, std::vector<Nif::NIFFilePtr> &out)
+    {
+        out.assign(names.size(), Nif::NIFFilePtr());
+
+        // Positions in names of each file that is not cached yet
+        std::map<std::string, std::vector<size_t> > missing;
+        for (size_t i=0; i<names.size(); ++i)
+        {
+            osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(names[i]);
+            if (obj)
+                out[i] = static_cast<NifFileHolder*>(obj.get())->mNifFile;
+            else
+                missing[names[i]].push_back(i);
+        }
+
+        if (missing.empty())
+            return;
+
+        std::vector<std::string> toLoad;
+        toLoad.reserve(missing.size());
+        for (std::map<std::string, std::vector<size_t> >::const_iterator it = missing.begin(); it != missing.end(); ++it)
+            toLoad.push_back(it->first);
+
+        ParseNifsJob job(mVFS, toLoad);
+        {
+            size_t numThreads = std::max(1u, boost::thread::hardware_concurrency());
+            numThreads = std::min(numThreads, toLoad.size());
+
+            boost::thread_group threads;
+            for (size_t i=1; i<numThreads; ++i)
+                threads.create_thread(boost::bind(&ParseNifsJob::run, &job));
+            job.run();
+            threads.join_all();
+        }
+
+        const std::vector<Nif::NIFFilePtr>& results = job.getResults();
+        for (size_t i=0; i<toLoad.size(); ++i)
+        {
+            Nif::NIFFilePtr file = results[i];
+            if (!file)
+                continue;
+            countLoad();
+
+            // Another thread may have loaded the same file in the meantime, keep the one in the cache then
+            osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(toLoad[i]);
+            if (obj)
+                file = static_cast<NifFileHolder*>(obj.get())->mNifFile;
+            else
+                addToCache(toLoad[i], new NifFileHolder(file));
+
+            const std::vector<size_t>& positions = missing[toLoad[i]];
+            for (std::vector<size_t>::const_iterator it = positions.begin(); it != positions.end(); ++it)
+                out[*it] = file;
+        }
+    }
+
+    void NifFileManager::reportStats(unsigned int frameNumber, osg::Stats &stats) const
+    {
+        stats.setAttribute(frameNumber, "resource_nif_files", getCacheSize());
+    }
+
 }
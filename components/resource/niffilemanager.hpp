@@ -1,43 +1,38 @@
 #ifndef OPENMW_COMPONENTS_RESOURCE_NIFFILEMANAGER_H
 #define OPENMW_COMPONENTS_RESOURCE_NIFFILEMANAGER_H
 
+#include <string>
+#include <vector>
+
 #include <osg/ref_ptr>
 
 #include <components/nif/niffile.hpp>
 
-namespace VFS
-{
-    class Manager;
-}
-
-namespace osgDB
-{
-    class ObjectCache;
-}
+#include "resourcemanager.hpp"
 
 namespace Resource
 {
 
     /// @brief Handles caching of NIFFiles.
     /// @note The NifFileManager is completely thread safe.
-    class NifFileManager
+    class NifFileManager : public ResourceManager
     {
     public:
         NifFileManager(const VFS::Manager* vfs);
         ~NifFileManager();
 
-        void clearCache();
-
         /// Retrieve a NIF file from the cache, or load it from the VFS if not cached yet.
         /// @note For performance reasons the NifFileManager does not handle case folding, needs
         /// to be done in advance by other managers accessing the NifFileManager.
         Nif::NIFFilePtr get(const std::string& name);
 
-    private:
-        // Use the osgDB::ObjectCache so objects are retrieved in thread safe way
-        osg::ref_ptr<osgDB::ObjectCache> mCache;
+        /// Retrieve a number of NIF files, loading the ones that are not cached yet concurrently.
+        /// @param out Receives the files in the order of \a names. Files that could not be loaded get an
+        /// empty pointer, use get() to find out why.
+        /// @note As with get(), the names need to be case folded in advance.
+        void getMany(const std::vector<std::string>& names, std::vector<Nif::NIFFilePtr>& out);
 
-        const VFS::Manager* mVFS;
+        virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
     };
 
 }
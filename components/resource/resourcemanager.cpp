@@ -0,0 +1,102 @@
+#include "resourcemanager.hpp"
+
+#include <OpenThreads/ScopedLock>
+
+#include "objectcache.hpp"
+
+namespace
+{
+    /// Gives access to the number of objects in the cache, which osgDB::ObjectCache does not.
+    class CountedObjectCache : public osgDB::ObjectCache
+    {
+    public:
+        unsigned int getSize()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
+            return _objectCache.size();
+        }
+    };
+}
+
+namespace Resource
+{
+
+    ResourceManager::ResourceManager(const VFS::Manager *vfs)
+        : mVFS(vfs)
+        , mCache(new CountedObjectCache)
+        , mExpiryDelay(0.0)
+        , mMainThread(boost::this_thread::get_id())
+        , mSynchronousLoads(0)
+        , mTakenLoads(0)
+        , mCacheTime(0.0)
+    {
+    }
+
+    ResourceManager::~ResourceManager()
+    {
+        // this has to be defined in the .cpp file as we can't delete incomplete types
+    }
+
+    void ResourceManager::updateCache(double referenceTime)
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mCacheTimeMutex);
+            mCacheTime = referenceTime;
+        }
+        mCache->updateTimeStampOfObjectsInCacheWithExternalReferences(referenceTime);
+        mCache->removeExpiredObjectsInCache(referenceTime - mExpiryDelay);
+    }
+
+    void ResourceManager::clearCache()
+    {
+        mCache->clear();
+    }
+
+    void ResourceManager::setExpiryDelay(double expiryDelay)
+    {
+        mExpiryDelay = expiryDelay;
+    }
+
+    const VFS::Manager* ResourceManager::getVFS() const
+    {
+        return mVFS;
+    }
+
+    void ResourceManager::reportStats(unsigned int frameNumber, osg::Stats &stats) const
+    {
+    }
+
+    unsigned int ResourceManager::takeSynchronousLoads()
+    {
+        unsigned int loads = mSynchronousLoads - mTakenLoads;
+        mTakenLoads = mSynchronousLoads;
+        return loads;
+    }
+
+    unsigned int ResourceManager::getSynchronousLoads() const
+    {
+        return mSynchronousLoads;
+    }
+
+    unsigned int ResourceManager::getCacheSize() const
+    {
+        return static_cast<CountedObjectCache*>(mCache.get())->getSize();
+    }
+
+    void ResourceManager::addToCache(const std::string &name, osg::Object *object)
+    {
+        double time;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mCacheTimeMutex);
+            time = mCacheTime;
+        }
+        mCache->addEntryToObjectCache(name, object, time);
+    }
+
+    void ResourceManager::countLoad()
+    {
+        if (boost::this_thread::get_id() == mMainThread)
+            ++mSynchronousLoads;
+    }
+
+}
@@ -0,0 +1,93 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_MANAGER_H
+#define OPENMW_COMPONENTS_RESOURCE_MANAGER_H
+
+#include <string>
+
+#include <osg/ref_ptr>
+
+#include <OpenThreads/Mutex>
+
+#include <boost/thread/thread.hpp>
+
+namespace VFS
+{
+    class Manager;
+}
+
+namespace osg
+{
+    class Stats;
+    class Object;
+}
+
+namespace osgDB
+{
+    class ObjectCache;
+}
+
+namespace Resource
+{
+
+    /// @brief Base class for managers that keep their resources in an osgDB::ObjectCache.
+    /// @par Resources are dropped from the cache when they have not been referenced outside of it for the
+    /// expiry delay, see updateCache().
+    class ResourceManager
+    {
+    public:
+        ResourceManager(const VFS::Manager* vfs);
+        virtual ~ResourceManager();
+
+        /// Drop the resources that were not referenced outside of the cache for the expiry delay.
+        /// @param referenceTime The current time. The game passes its simulation time, which stands still while a menu is
+        /// open, so that nothing expires then.
+        /// @note Call once per frame.
+        virtual void updateCache(double referenceTime);
+
+        /// Drop all resources from the cache, whether they are referenced or not.
+        virtual void clearCache();
+
+        /// How long to keep resources once they are no longer referenced, in seconds.
+        void setExpiryDelay(double expiryDelay);
+
+        const VFS::Manager* getVFS() const;
+
+        /// Record the size of the cache for the on-screen stats, see ResourceSystem::reportStats.
+        virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
+
+        /// The number of resources loaded on the thread that created the manager since the last call.
+        /// @note These are the loads that stall the frame, as opposed to those done by the cell preloader.
+        unsigned int takeSynchronousLoads();
+
+        /// The number of resources loaded on the thread that created the manager in total.
+        unsigned int getSynchronousLoads() const;
+
+    protected:
+        /// The number of resources in the cache.
+        unsigned int getCacheSize() const;
+
+        /// Call whenever a resource had to be loaded because it was not cached.
+        void countLoad();
+
+        /// Add a resource to the cache, stamped with the time of the last updateCache(), so that it stays cached for the
+        /// expiry delay even if nothing references it in the meantime.
+        /// @note May be called from any thread.
+        void addToCache(const std::string& name, osg::Object* object);
+
+        const VFS::Manager* mVFS;
+        osg::ref_ptr<osgDB::ObjectCache> mCache;
+        double mExpiryDelay;
+
+    private:
+        // Only counted and taken on this thread
+        boost::thread::id mMainThread;
+        unsigned int mSynchronousLoads;
+        unsigned int mTakenLoads;
+
+        // The time of the last updateCache(), read by addToCache() on the loading threads
+        double mCacheTime;
+        OpenThreads::Mutex mCacheTimeMutex;
+    };
+
+}
+
+#endif
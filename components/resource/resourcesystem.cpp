@@ -1,5 +1,9 @@
 #include "resourcesystem.hpp"
 
+#include <algorithm>
+
+#include <osg/Stats>
+
 #include "scenemanager.hpp"
 #include "texturemanager.hpp"
 #include "niffilemanager.hpp"
@@ -15,6 +19,11 @@ namespace Resource
         mKeyframeManager.reset(new KeyframeManager(vfs));
         mTextureManager.reset(new TextureManager(vfs));
         mSceneManager.reset(new SceneManager(vfs, mTextureManager.get(), mNifFileManager.get()));
+
+        addResourceManager(mNifFileManager.get());
+        addResourceManager(mKeyframeManager.get());
+        addResourceManager(mTextureManager.get());
+        addResourceManager(mSceneManager.get());
     }
 
     ResourceSystem::~ResourceSystem()
@@ -47,9 +56,54 @@ namespace Resource
         mNifFileManager->clearCache();
     }
 
+    void ResourceSystem::updateCache(double referenceTime)
+    {
+        for (std::vector<ResourceManager*>::iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+            (*it)->updateCache(referenceTime);
+    }
+
+    void ResourceSystem::setExpiryDelay(double expiryDelay)
+    {
+        for (std::vector<ResourceManager*>::iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+            (*it)->setExpiryDelay(expiryDelay);
+    }
+
+    void ResourceSystem::reportStats(unsigned int frameNumber, osg::Stats &stats)
+    {
+        unsigned int loads = 0;
+        for (std::vector<ResourceManager*>::iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+        {
+            (*it)->reportStats(frameNumber, stats);
+            loads += (*it)->takeSynchronousLoads();
+        }
+        stats.setAttribute(frameNumber, "resource_sync_loads", loads);
+    }
+
+    void ResourceSystem::addResourceManager(ResourceManager *resourceMgr)
+    {
+        mResourceManagers.push_back(resourceMgr);
+    }
+
+    void ResourceSystem::removeResourceManager(ResourceManager *resourceMgr)
+    {
+        std::vector<ResourceManager*>::iterator found = std::find(mResourceManagers.begin(), mResourceManagers.end(), resourceMgr);
+        if (found != mResourceManagers.end())
+            mResourceManagers.erase(found);
+    }
+
     const VFS::Manager* ResourceSystem::getVFS() const
     {
         return mVFS;
     }
 
+    void ResourceSystem::setBvhCacheDirectory(const boost::filesystem::path &directory)
+    {
+        mBvhCacheDirectory = directory;
+    }
+
+    const boost::filesystem::path& ResourceSystem::getBvhCacheDirectory() const
+    {
+        return mBvhCacheDirectory;
+    }
+
 }
@@ -2,12 +2,20 @@
 #define OPENMW_COMPONENTS_RESOURCE_RESOURCESYSTEM_H
 
 #include <memory>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
 
 namespace VFS
 {
     class Manager;
 }
 
+namespace osg
+{
+    class Stats;
+}
+
 namespace Resource
 {
 
@@ -15,6 +23,7 @@ namespace Resource
     class TextureManager;
     class NifFileManager;
     class KeyframeManager;
+    class ResourceManager;
 
     /// @brief Wrapper class that constructs and provides access to the most commonly used resource subsystems.
     /// @par Resource subsystems can be used with multiple OpenGL contexts, just like the OSG equivalents, but
@@ -33,16 +42,43 @@ namespace Resource
         /// Indicates to each resource manager to clear the cache, i.e. to drop cached objects that are no longer referenced.
         void clearCache();
 
+        /// Indicates to each resource manager to drop the cached objects that were not referenced for the expiry delay.
+        /// @param referenceTime The current time, usually the reference time of the frame stamp.
+        /// @note Call once per frame.
+        void updateCache(double referenceTime);
+
+        /// How long the resource managers keep cached objects once they are no longer referenced, in seconds.
+        void setExpiryDelay(double expiryDelay);
+
+        /// Record the cache sizes of the resource managers, and the number of resources they loaded on the main thread
+        /// since the last call, for the on-screen stats.
+        void reportStats(unsigned int frameNumber, osg::Stats& stats);
+
+        /// Add a resource manager owned elsewhere, so that its cache is updated along with the others.
+        /// @note The resource manager must be removed again before it is deleted.
+        void addResourceManager(ResourceManager* resourceMgr);
+        void removeResourceManager(ResourceManager* resourceMgr);
+
         const VFS::Manager* getVFS() const;
 
+        /// Where the collision shape managers, which are owned elsewhere, keep the BVHs of meshes between runs.
+        /// Empty if they should not. See BulletShapeManager::setBvhCacheDirectory.
+        void setBvhCacheDirectory(const boost::filesystem::path& directory);
+        const boost::filesystem::path& getBvhCacheDirectory() const;
+
     private:
         std::auto_ptr<SceneManager> mSceneManager;
         std::auto_ptr<TextureManager> mTextureManager;
         std::auto_ptr<NifFileManager> mNifFileManager;
         std::auto_ptr<KeyframeManager> mKeyframeManager;
 
+        // All resource managers, including those owned elsewhere
+        std::vector<ResourceManager*> mResourceManagers;
+
         const VFS::Manager* mVFS;
 
+        boost::filesystem::path mBvhCacheDirectory;
+
         ResourceSystem(const ResourceSystem&);
         void operator = (const ResourceSystem&);
     };
@@ -0,0 +1,390 @@
+#include "scenecache.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <osg/Geode>
+#include <osg/Texture2D>
+#include <osg/UserDataContainer>
+
+#include <osgDB/Registry>
+#include <osgDB/ObjectWrapper>
+#include <osgDB/Serializer>
+#include <osgDB/InputStream>
+#include <osgDB/OutputStream>
+
+#include <components/nifosg/nifloader.hpp>
+#include <components/nifosg/userdata.hpp>
+
+#include "texturemanager.hpp"
+
+namespace
+{
+
+    /// Increase when the scenes made by NifOsg::Loader or the stored user data change
+    const int sFormatVersion = 1;
+
+    uint64_t hashData(const char* data, size_t size, uint64_t hash)
+    {
+        // FNV-1a
+        for (size_t i=0; i<size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    const uint64_t sHashBasis = 14695981039346656037ull;
+
+    bool checkNodeData(const NifOsg::NodeUserData&)
+    {
+        return true;
+    }
+
+    bool readNodeData(osgDB::InputStream& is, NifOsg::NodeUserData& data)
+    {
+        is >> data.mIndex >> data.mScale;
+        for (int i=0; i<3; ++i)
+            for (int j=0; j<3; ++j)
+                is >> data.mRotationScale.mValues[i][j];
+        return true;
+    }
+
+    bool writeNodeData(osgDB::OutputStream& os, const NifOsg::NodeUserData& data)
+    {
+        os << data.mIndex << data.mScale;
+        for (int i=0; i<3; ++i)
+            for (int j=0; j<3; ++j)
+                os << data.mRotationScale.mValues[i][j];
+        os << std::endl;
+        return true;
+    }
+
+    bool checkTextKeys(const NifOsg::TextKeyMapHolder& holder)
+    {
+        return !holder.mTextKeys.empty();
+    }
+
+    bool readTextKeys(osgDB::InputStream& is, NifOsg::TextKeyMapHolder& holder)
+    {
+        unsigned int size = is.readSize();
+        is >> is.BEGIN_BRACKET;
+        for (unsigned int i=0; i<size; ++i)
+        {
+            float time;
+            std::string text;
+            is >> time;
+            is.readWrappedString(text);
+            holder.mTextKeys.insert(std::make_pair(time, text));
+        }
+        is >> is.END_BRACKET;
+        return true;
+    }
+
+    bool writeTextKeys(osgDB::OutputStream& os, const NifOsg::TextKeyMapHolder& holder)
+    {
+        os.writeSize(holder.mTextKeys.size());
+        os << os.BEGIN_BRACKET << std::endl;
+        for (NifOsg::TextKeyMap::const_iterator it = holder.mTextKeys.begin(); it != holder.mTextKeys.end(); ++it)
+        {
+            os << it->first;
+            os.writeWrappedString(it->second);
+            os << std::endl;
+        }
+        os << os.END_BRACKET << std::endl;
+        return true;
+    }
+
+    bool isNifOsgUserObject(const osg::Object* object)
+    {
+        return dynamic_cast<const NifOsg::NodeUserData*>(object) || dynamic_cast<const NifOsg::TextKeyMapHolder*>(object);
+    }
+
+    /// Checks that a scene only has objects the .osgb format can store. The NifOsg user data
+    /// has its own serializers, see below.
+    class CanStoreVisitor : public osg::NodeVisitor
+    {
+    public:
+        CanStoreVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mCanStore(true)
+        {
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            if (!canStore(node) || node.getUpdateCallback() || node.getCullCallback() || node.getEventCallback()
+                    || !canStore(node.getStateSet()))
+                mCanStore = false;
+
+            if (mCanStore)
+                traverse(node);
+        }
+
+        virtual void apply(osg::Geode& geode)
+        {
+            for (unsigned int i=0; i<geode.getNumDrawables() && mCanStore; ++i)
+            {
+                const osg::Drawable* drawable = geode.getDrawable(i);
+                if (!canStore(*drawable) || drawable->getUpdateCallback() || drawable->getCullCallback()
+                        || drawable->getDrawCallback() || !canStore(drawable->getStateSet()))
+                    mCanStore = false;
+            }
+
+            apply(static_cast<osg::Node&>(geode));
+        }
+
+        bool mCanStore;
+
+    private:
+        /// Is it a plain OSG object, without user data we can not store?
+        static bool canStore(const osg::Object& object)
+        {
+            if (std::strcmp(object.libraryName(), "osg") != 0)
+                return false;
+            if (object.getUserData())
+                return false;
+
+            const osg::UserDataContainer* container = object.getUserDataContainer();
+            if (container)
+                for (unsigned int i=0; i<container->getNumUserObjects(); ++i)
+                    if (!isNifOsgUserObject(container->getUserObject(i)))
+                        return false;
+            return true;
+        }
+
+        static bool canStore(const osg::StateSet* stateset)
+        {
+            if (!stateset)
+                return true;
+            if (!canStore(*stateset) || stateset->getUpdateCallback() || stateset->getEventCallback())
+                return false;
+
+            const osg::StateSet::AttributeList& attributes = stateset->getAttributeList();
+            for (osg::StateSet::AttributeList::const_iterator it = attributes.begin(); it != attributes.end(); ++it)
+                if (!canStore(*it->second.first) || it->second.first->getUpdateCallback())
+                    return false;
+
+            const osg::StateSet::TextureAttributeList& textureAttributes = stateset->getTextureAttributeList();
+            for (osg::StateSet::TextureAttributeList::const_iterator unit = textureAttributes.begin(); unit != textureAttributes.end(); ++unit)
+            {
+                for (osg::StateSet::AttributeList::const_iterator it = unit->begin(); it != unit->end(); ++it)
+                {
+                    const osg::StateAttribute* attribute = it->second.first.get();
+                    if (!canStore(*attribute) || attribute->getUpdateCallback())
+                        return false;
+
+                    // Textures are taken from the TextureManager by name when reading
+                    if (const osg::Texture* texture = dynamic_cast<const osg::Texture*>(attribute))
+                    {
+                        if (!dynamic_cast<const osg::Texture2D*>(texture) || texture->getName().empty())
+                            return false;
+                    }
+                }
+            }
+            return true;
+        }
+    };
+
+    /// Replaces the textures of a scene read from the cache with the ones of the TextureManager.
+    class ShareTexturesVisitor : public osg::NodeVisitor
+    {
+    public:
+        ShareTexturesVisitor(Resource::TextureManager* textureManager)
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mTextureManager(textureManager)
+        {
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            shareTextures(node.getStateSet());
+            traverse(node);
+        }
+
+        virtual void apply(osg::Geode& geode)
+        {
+            for (unsigned int i=0; i<geode.getNumDrawables(); ++i)
+                shareTextures(geode.getDrawable(i)->getStateSet());
+
+            apply(static_cast<osg::Node&>(geode));
+        }
+
+    private:
+        void shareTextures(osg::StateSet* stateset)
+        {
+            if (!stateset)
+                return;
+
+            for (unsigned int unit=0; unit<stateset->getTextureAttributeList().size(); ++unit)
+            {
+                const osg::StateSet::RefAttributePair* pair = stateset->getTextureAttributePair(unit, osg::StateAttribute::TEXTURE);
+                if (!pair)
+                    continue;
+
+                const osg::Texture2D* texture = dynamic_cast<const osg::Texture2D*>(pair->first.get());
+                if (!texture || texture->getName().empty())
+                    continue;
+
+                osg::ref_ptr<osg::Texture2D> shared = mTextureManager->getTexture2D(texture->getName(),
+                    texture->getWrap(osg::Texture::WRAP_S), texture->getWrap(osg::Texture::WRAP_T));
+                stateset->setTextureAttribute(unit, shared, pair->second);
+            }
+        }
+
+        Resource::TextureManager* mTextureManager;
+    };
+
+    /// Gives each referenced image as an empty placeholder, since the textures are replaced afterwards anyway.
+    class PlaceholderImageCallback : public osgDB::ReadFileCallback
+    {
+    public:
+        virtual osgDB::ReaderWriter::ReadResult readImage(const std::string& filename, const osgDB::Options* options)
+        {
+            osg::ref_ptr<osg::Image> image (new osg::Image);
+            return osgDB::ReaderWriter::ReadResult(image.get(), osgDB::ReaderWriter::ReadResult::FILE_LOADED);
+        }
+    };
+
+}
+
+// The wrappers are registered on startup, since this file is always linked in together with the SceneManager
+
+REGISTER_OBJECT_WRAPPER( NifOsg_NodeUserData,
+                         new NifOsg::NodeUserData,
+                         NifOsg::NodeUserData,
+                         "osg::Object NifOsg::NodeUserData" )
+{
+    ADD_USER_SERIALIZER( NodeData );
+}
+
+REGISTER_OBJECT_WRAPPER( NifOsg_TextKeyMapHolder,
+                         new NifOsg::TextKeyMapHolder,
+                         NifOsg::TextKeyMapHolder,
+                         "osg::Object NifOsg::TextKeyMapHolder" )
+{
+    ADD_USER_SERIALIZER( TextKeys );
+}
+
+namespace Resource
+{
+
+    SceneCache::SceneCache(const boost::filesystem::path &directory, TextureManager *textureManager)
+        : mDirectory(directory)
+        , mTextureManager(textureManager)
+    {
+    }
+
+    uint64_t SceneCache::hashSource(std::istream &stream)
+    {
+        uint64_t hash = sHashBasis;
+        char buffer[64*1024];
+        while (stream)
+        {
+            stream.read(buffer, sizeof(buffer));
+            hash = hashData(buffer, static_cast<size_t>(stream.gcount()), hash);
+        }
+        return hash;
+    }
+
+    boost::filesystem::path SceneCache::getPath(const std::string &normalizedName, uint64_t sourceHash) const
+    {
+        std::ostringstream name;
+        name << std::hex << std::setfill('0')
+             << std::setw(16) << hashData(normalizedName.data(), normalizedName.size(), sHashBasis) << '-'
+             << std::setw(16) << sourceHash << '-'
+             << std::dec << sFormatVersion << (NifOsg::Loader::getShowMarkers() ? "m" : "") << ".osgb";
+        return mDirectory / name.str();
+    }
+
+    osg::ref_ptr<osg::Node> SceneCache::read(const std::string &normalizedName, uint64_t sourceHash) const
+    {
+        const boost::filesystem::path path = getPath(normalizedName, sourceHash);
+
+        try
+        {
+            if (!boost::filesystem::exists(path))
+                return NULL;
+
+            osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+            if (!reader)
+                return NULL;
+
+            boost::filesystem::ifstream stream(path, std::ios::binary);
+            if (!stream.is_open())
+                return NULL;
+
+            osg::ref_ptr<osgDB::Options> options (new osgDB::Options);
+            options->setReadFileCallback(new PlaceholderImageCallback);
+
+            osgDB::ReaderWriter::ReadResult result = reader->readNode(stream, options);
+            if (!result.success() || !result.getNode())
+            {
+                std::cerr << "Failed to read cached scene for " << normalizedName << ": " << result.message() << std::endl;
+                return NULL;
+            }
+
+            osg::ref_ptr<osg::Node> scene = result.getNode();
+            ShareTexturesVisitor visitor(mTextureManager);
+            scene->accept(visitor);
+            return scene;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to read cached scene for " << normalizedName << ": " << e.what() << std::endl;
+            return NULL;
+        }
+    }
+
+    void SceneCache::write(const std::string &normalizedName, uint64_t sourceHash, const osg::Node &scene) const
+    {
+        CanStoreVisitor visitor;
+        const_cast<osg::Node&>(scene).accept(visitor);
+        if (!visitor.mCanStore)
+            return;
+
+        osgDB::ReaderWriter* writer = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+        if (!writer)
+            return;
+
+        const boost::filesystem::path path = getPath(normalizedName, sourceHash);
+        // Write to a temporary file first, so a scene is never left half written
+        boost::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+
+        try
+        {
+            if (!boost::filesystem::exists(mDirectory))
+                boost::filesystem::create_directories(mDirectory);
+
+            {
+                boost::filesystem::ofstream stream(tempPath, std::ios::binary | std::ios::out | std::ios::trunc);
+                if (!stream.is_open())
+                    throw std::runtime_error("can not open file for writing");
+
+                osg::ref_ptr<osgDB::Options> options (new osgDB::Options("WriteImageHint=UseExternal"));
+                osgDB::ReaderWriter::WriteResult result = writer->writeNode(scene, stream, options);
+                if (!result.success())
+                    throw std::runtime_error(result.message());
+                if (stream.fail())
+                    throw std::runtime_error("write operation failed");
+            }
+
+            boost::filesystem::rename(tempPath, path);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to cache scene for " << normalizedName << ": " << e.what() << std::endl;
+            boost::system::error_code ec;
+            boost::filesystem::remove(tempPath, ec);
+        }
+    }
+
+}
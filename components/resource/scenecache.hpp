@@ -0,0 +1,48 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_SCENECACHE_H
+#define OPENMW_COMPONENTS_RESOURCE_SCENECACHE_H
+
+#include <stdint.h>
+#include <istream>
+#include <string>
+
+#include <boost/filesystem/path.hpp>
+
+#include <osg/ref_ptr>
+#include <osg/Node>
+
+namespace Resource
+{
+    class TextureManager;
+
+    /// @brief Keeps converted NIF scenes on disk in the native OSG binary format (.osgb), so they
+    /// do not have to be converted again on the next run.
+    /// @par Scenes are stored by their name and a hash of the source file, so a changed file is
+    /// converted again. Only scenes made of plain OSG objects and NifOsg user data can be stored.
+    /// Scenes with controllers, particles or skinning are converted every time.
+    /// @par Textures are stored by name, and taken from the TextureManager when reading, so
+    /// they are shared with converted scenes and follow its filter settings.
+    class SceneCache
+    {
+    public:
+        SceneCache(const boost::filesystem::path& directory, TextureManager* textureManager);
+
+        /// Hash the rest of the given stream, i.e. the source file of a scene.
+        static uint64_t hashSource(std::istream& stream);
+
+        /// Read the scene converted from the given source file, if it is cached.
+        /// @return NULL if the scene is not cached, or could not be read.
+        osg::ref_ptr<osg::Node> read(const std::string& normalizedName, uint64_t sourceHash) const;
+
+        /// Store the scene converted from the given source file, if it can be stored.
+        void write(const std::string& normalizedName, uint64_t sourceHash, const osg::Node& scene) const;
+
+    private:
+        boost::filesystem::path getPath(const std::string& normalizedName, uint64_t sourceHash) const;
+
+        boost::filesystem::path mDirectory;
+        TextureManager* mTextureManager;
+    };
+
+}
+
+#endif
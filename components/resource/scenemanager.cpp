@@ -1,15 +1,21 @@
 #include "scenemanager.hpp"
 
+#include <OpenThreads/ScopedLock>
+
 #include <osg/Node>
 #include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/KdTree>
+#include <osg/Stats>
 #include <osg/UserDataContainer>
 #include <osg/Version>
 
 #include <osgParticle/ParticleSystem>
 
+#include <osgAnimation/MorphGeometry>
+
 #include <osgUtil/IncrementalCompileOperation>
 
-#include <osgDB/SharedStateManager>
 #include <osgDB/Registry>
 
 #include <components/nifosg/nifloader.hpp>
@@ -19,13 +25,60 @@
 
 #include <components/sceneutil/clone.hpp>
 #include <components/sceneutil/util.hpp>
+#include <components/sceneutil/riggeometry.hpp>
+
+#include <components/misc/profiler.hpp>
 
 #include "texturemanager.hpp"
 #include "niffilemanager.hpp"
+#include "scenecache.hpp"
+#include "sharedstatecache.hpp"
+#include "objectcache.hpp"
 
 namespace
 {
 
+    /// Builds a KdTree for the static geometry of a scene template. The instances share the Geometry, and with it the
+    /// KdTree, unless the geometry is skinned or morphed.
+    class BuildKdTreeVisitor : public osg::NodeVisitor
+    {
+    public:
+        BuildKdTreeVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+        {
+        }
+
+#if OSG_VERSION_LESS_THAN(3,3,3)
+        // Before OSG 3.3.3 the Drawables of a Geode are not traversed
+        virtual void apply(osg::Geode& geode)
+        {
+            for (unsigned int i=0; i<geode.getNumDrawables(); ++i)
+                build(geode.getDrawable(i));
+            traverse(geode);
+        }
+#else
+        virtual void apply(osg::Drawable& drawable)
+        {
+            build(&drawable);
+        }
+#endif
+
+    private:
+        void build(osg::Drawable* drawable)
+        {
+            osg::Geometry* geometry = drawable->asGeometry();
+            if (!geometry || geometry->getShape() || dynamic_cast<SceneUtil::RigGeometry*>(geometry)
+                    || dynamic_cast<osgAnimation::MorphGeometry*>(geometry))
+                return;
+
+            osg::ref_ptr<osg::KdTree> kdTree (new osg::KdTree);
+            if (kdTree->build(mBuildOptions, geometry))
+                geometry->setShape(kdTree);
+        }
+
+        osg::KdTree::BuildOptions mBuildOptions;
+    };
+
     class InitWorldSpaceParticlesVisitor : public osg::NodeVisitor
     {
     public:
@@ -106,19 +159,40 @@ namespace Resource
 {
 
     SceneManager::SceneManager(const VFS::Manager *vfs, Resource::TextureManager* textureManager, Resource::NifFileManager* nifFileManager)
-        : mVFS(vfs)
+        : ResourceManager(vfs)
         , mTextureManager(textureManager)
         , mNifFileManager(nifFileManager)
         , mParticleSystemMask(~0u)
+        , mBuildKdTrees(false)
+        , mSharedStateCache(new SharedStateCache)
     {
     }
 
     SceneManager::~SceneManager()
     {
         // this has to be defined in the .cpp file as we can't delete incomplete types
-
     }
 
+    /// @brief Keeps the template of a scene instance referenced, so that it stays in the cache while the instance is in use.
+    class TemplateRef : public osg::Object
+    {
+    public:
+        TemplateRef(const osg::Object* object)
+            : mObject(object)
+        {
+        }
+        TemplateRef() {}
+        TemplateRef(const TemplateRef& copy, const osg::CopyOp&)
+            : mObject(copy.mObject)
+        {
+        }
+
+        META_Object(Resource, TemplateRef)
+
+    private:
+        osg::ref_ptr<const osg::Object> mObject;
+    };
+
     /// @brief Callback to read image files from the VFS.
     class ImageReadCallback : public osgDB::ReadFileCallback
     {
@@ -152,11 +226,24 @@ namespace Resource
         return std::string();
     }
 
-    osg::ref_ptr<osg::Node> load (Files::IStreamPtr file, const std::string& normalizedFilename, Resource::TextureManager* textureMgr, Resource::NifFileManager* nifFileManager)
+    osg::ref_ptr<osg::Node> load (Files::IStreamPtr file, const std::string& normalizedFilename, Resource::TextureManager* textureMgr, Resource::NifFileManager* nifFileManager,
+                                  const Resource::SceneCache* sceneCache)
     {
         std::string ext = getFileExtension(normalizedFilename);
         if (ext == "nif")
-            return NifOsg::Loader::load(nifFileManager->get(normalizedFilename), textureMgr);
+        {
+            if (!sceneCache)
+                return NifOsg::Loader::load(nifFileManager->get(normalizedFilename), textureMgr);
+
+            const uint64_t sourceHash = Resource::SceneCache::hashSource(*file);
+            osg::ref_ptr<osg::Node> cached = sceneCache->read(normalizedFilename, sourceHash);
+            if (cached)
+                return cached;
+
+            osg::ref_ptr<osg::Node> loaded = NifOsg::Loader::load(nifFileManager->get(normalizedFilename), textureMgr);
+            sceneCache->write(normalizedFilename, sourceHash, *loaded);
+            return loaded;
+        }
         else
         {
             osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
@@ -186,44 +273,56 @@ namespace Resource
 
     osg::ref_ptr<const osg::Node> SceneManager::getTemplate(const std::string &name)
     {
+        OPENMW_PROFILE_ZONE ("SceneManager::getTemplate");
+
         std::string normalized = name;
         mVFS->normalizeFilename(normalized);
 
-        Index::iterator it = mIndex.find(normalized);
-        if (it == mIndex.end())
-        {
-            osg::ref_ptr<osg::Node> loaded;
-            try
-            {
-                Files::IStreamPtr file = mVFS->get(normalized);
+        osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(normalized);
+        if (obj)
+            return osg::ref_ptr<const osg::Node>(static_cast<osg::Node*>(obj.get()));
 
-                loaded = load(file, normalized, mTextureManager, mNifFileManager);
-            }
-            catch (std::exception& e)
-            {
-                std::cerr << "Failed to load '" << name << "': " << e.what() << ", using marker_error.nif instead" << std::endl;
-                Files::IStreamPtr file = mVFS->get("meshes/marker_error.nif");
-                normalized = "meshes/marker_error.nif";
-                loaded = load(file, normalized, mTextureManager, mNifFileManager);
-            }
+        countLoad();
 
-            osgDB::Registry::instance()->getOrCreateSharedStateManager()->share(loaded.get());
+        osg::ref_ptr<osg::Node> loaded;
+        try
+        {
+            Files::IStreamPtr file = mVFS->getNormalized(normalized);
 
-            if (mIncrementalCompileOperation)
-                mIncrementalCompileOperation->add(loaded);
+            loaded = load(file, normalized, mTextureManager, mNifFileManager, mSceneCache.get());
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to load '" << name << "': " << e.what() << ", using marker_error.nif instead" << std::endl;
+            Files::IStreamPtr file = mVFS->get("meshes/marker_error.nif");
+            normalized = "meshes/marker_error.nif";
+            loaded = load(file, normalized, mTextureManager, mNifFileManager, mSceneCache.get());
+        }
 
-            mIndex[normalized] = loaded;
-            return loaded;
+        if (mBuildKdTrees)
+        {
+            BuildKdTreeVisitor visitor;
+            loaded->accept(visitor);
         }
-        else
-            return it->second;
+
+        mSharedStateCache->share(loaded.get());
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mCacheMutex);
+        // Another thread may have loaded the same template meanwhile
+        obj = mCache->getRefFromObjectCache(normalized);
+        if (obj)
+            return osg::ref_ptr<const osg::Node>(static_cast<osg::Node*>(obj.get()));
+
+        if (mIncrementalCompileOperation)
+            mIncrementalCompileOperation->add(loaded);
+        addToCache(normalized, loaded);
+        return loaded;
     }
 
     osg::ref_ptr<osg::Node> SceneManager::createInstance(const std::string &name)
     {
         osg::ref_ptr<const osg::Node> scene = getTemplate(name);
-        osg::ref_ptr<osg::Node> cloned = osg::clone(scene.get(), SceneUtil::CopyOp());
-        return cloned;
+        return cloneTemplate(scene);
     }
 
     osg::ref_ptr<osg::Node> SceneManager::createInstance(const std::string &name, osg::Group* parentNode)
@@ -233,6 +332,29 @@ namespace Resource
         return cloned;
     }
 
+    void SceneManager::updateCache(double referenceTime)
+    {
+        ResourceManager::updateCache(referenceTime);
+
+        mSharedStateCache->prune();
+    }
+
+    void SceneManager::reportStats(unsigned int frameNumber, osg::Stats &stats) const
+    {
+        stats.setAttribute(frameNumber, "resource_scene_templates", getCacheSize());
+        stats.setAttribute(frameNumber, "resource_shared_states", mSharedStateCache->getCacheSize());
+    }
+
+    osg::ref_ptr<osg::Node> SceneManager::cloneTemplate(const osg::Node *scene) const
+    {
+        osg::ref_ptr<osg::Node> cloned = osg::clone(scene, SceneUtil::CopyOp());
+
+        // add a ref to the original template, to hint to the cache that it's still being used and should be kept in cache
+        cloned->getOrCreateUserDataContainer()->addUserObject(new TemplateRef(scene));
+
+        return cloned;
+    }
+
     void SceneManager::attachTo(osg::Node *instance, osg::Group *parentNode) const
     {
         parentNode->addChild(instance);
@@ -241,10 +363,7 @@ namespace Resource
 
     void SceneManager::releaseGLObjects(osg::State *state)
     {
-        for (Index::iterator it = mIndex.begin(); it != mIndex.end(); ++it)
-        {
-            it->second->releaseGLObjects(state);
-        }
+        mCache->releaseGLObjects(state);
     }
 
     void SceneManager::setIncrementalCompileOperation(osgUtil::IncrementalCompileOperation *ico)
@@ -258,11 +377,6 @@ namespace Resource
         node->accept(visitor);
     }
 
-    const VFS::Manager* SceneManager::getVFS() const
-    {
-        return mVFS;
-    }
-
     Resource::TextureManager* SceneManager::getTextureManager()
     {
         return mTextureManager;
@@ -273,4 +387,14 @@ namespace Resource
         mParticleSystemMask = mask;
     }
 
+    void SceneManager::setBuildKdTrees(bool build)
+    {
+        mBuildKdTrees = build;
+    }
+
+    void SceneManager::setSceneCacheDirectory(const boost::filesystem::path &directory)
+    {
+        mSceneCache.reset(new SceneCache(directory, mTextureManager));
+    }
+
 }
@@ -2,20 +2,24 @@
 #define OPENMW_COMPONENTS_RESOURCE_SCENEMANAGER_H
 
 #include <string>
-#include <map>
+#include <memory>
+
+#include <boost/filesystem/path.hpp>
+
+#include <OpenThreads/Mutex>
 
 #include <osg/ref_ptr>
 #include <osg/Node>
+#include <osg/Group>
+
+#include "resourcemanager.hpp"
 
 namespace Resource
 {
     class TextureManager;
     class NifFileManager;
-}
-
-namespace VFS
-{
-    class Manager;
+    class SceneCache;
+    class SharedStateCache;
 }
 
 namespace osgUtil
@@ -27,7 +31,7 @@ namespace Resource
 {
 
     /// @brief Handles loading and caching of scenes, e.g. NIF files
-    class SceneManager
+    class SceneManager : public ResourceManager
     {
     public:
         SceneManager(const VFS::Manager* vfs, Resource::TextureManager* textureManager, Resource::NifFileManager* nifFileManager);
@@ -46,6 +50,11 @@ namespace Resource
         /// @see getTemplate
         osg::ref_ptr<osg::Node> createInstance(const std::string& name, osg::Group* parentNode);
 
+        /// Also drops the shared state that is no longer used by any template.
+        virtual void updateCache(double referenceTime);
+
+        virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
+
         /// Attach the given scene instance to the given parent node
         /// @note You should have the parentNode in its intended position before calling this method,
         ///       so that world space particles of the \a instance get transformed correctly.
@@ -62,15 +71,24 @@ namespace Resource
         /// @note SceneManager::attachTo calls this method automatically, only needs to be called by users if manually attaching
         void notifyAttached(osg::Node* node) const;
 
-        const VFS::Manager* getVFS() const;
-
         Resource::TextureManager* getTextureManager();
 
         /// @param mask The node mask to apply to loaded particle system nodes.
         void setParticleSystemMask(unsigned int mask);
 
+        /// Build a KdTree for each static geometry of the scene templates loaded from now on, so that intersection
+        /// tests with their instances skip most triangles. Costs some memory and loading time.
+        /// @note Skinned and morphed geometry is left out, its vertices change once it is animated.
+        void setBuildKdTrees(bool build);
+
+        /// Keep converted NIF scenes in the given directory, and load them from there when the NIF file did not change.
+        /// @see SceneCache
+        void setSceneCacheDirectory(const boost::filesystem::path& directory);
+
     private:
-        const VFS::Manager* mVFS;
+        /// Clone the given template, and keep the template referenced from the instance.
+        osg::ref_ptr<osg::Node> cloneTemplate(const osg::Node* scene) const;
+
         Resource::TextureManager* mTextureManager;
         Resource::NifFileManager* mNifFileManager;
 
@@ -78,9 +96,15 @@ namespace Resource
 
         unsigned int mParticleSystemMask;
 
-        // observer_ptr?
-        typedef std::map<std::string, osg::ref_ptr<const osg::Node> > Index;
-        Index mIndex;
+        bool mBuildKdTrees;
+
+        std::auto_ptr<SceneCache> mSceneCache;
+
+        // Shares the state of equal materials across templates
+        std::auto_ptr<SharedStateCache> mSharedStateCache;
+
+        // Serializes adding templates to the cache, since templates can be loaded in the background
+        OpenThreads::Mutex mCacheMutex;
 
         SceneManager(const SceneManager&);
         void operator = (const SceneManager&);
@@ -0,0 +1,134 @@
+#include "sharedstatecache.hpp"
+
+#include <vector>
+
+#include <OpenThreads/ScopedLock>
+
+#include <osg/Node>
+#include <osg/Geode>
+#include <osg/NodeVisitor>
+#include <osg/Version>
+
+namespace Resource
+{
+
+    class ShareStateVisitor : public osg::NodeVisitor
+    {
+    public:
+        ShareStateVisitor(SharedStateCache& cache)
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mCache(cache)
+        {
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            if (node.getStateSet())
+                node.setStateSet(mCache.share(node.getStateSet()));
+            traverse(node);
+        }
+
+#if OSG_VERSION_LESS_THAN(3,3,3)
+        // Before OSG 3.3.3 the Drawables of a Geode are not traversed
+        virtual void apply(osg::Geode& geode)
+        {
+            for (unsigned int i=0; i<geode.getNumDrawables(); ++i)
+            {
+                osg::Drawable* drawable = geode.getDrawable(i);
+                if (drawable->getStateSet())
+                    drawable->setStateSet(mCache.share(drawable->getStateSet()));
+            }
+            apply(static_cast<osg::Node&>(geode));
+        }
+#endif
+
+    private:
+        SharedStateCache& mCache;
+    };
+
+    void SharedStateCache::share(osg::Node *node)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+        ShareStateVisitor visitor(*this);
+        node->accept(visitor);
+    }
+
+    osg::StateSet* SharedStateCache::share(osg::StateSet *stateset)
+    {
+        if (stateset->getDataVariance() == osg::Object::DYNAMIC || stateset->getUpdateCallback() || stateset->getEventCallback())
+            return stateset;
+
+        shareAttributes(stateset);
+
+        return mStateSets.insert(stateset).first->get();
+    }
+
+    osg::StateAttribute* SharedStateCache::share(osg::StateAttribute *attribute)
+    {
+        if (attribute->getDataVariance() == osg::Object::DYNAMIC || attribute->getUpdateCallback() || attribute->getEventCallback()
+                || attribute->asTexture())
+            return attribute;
+
+        return mAttributes.insert(attribute).first->get();
+    }
+
+    void SharedStateCache::shareAttributes(osg::StateSet *stateset)
+    {
+        // Collect the replacements first, setting an attribute changes the list that is iterated
+        typedef std::vector<std::pair<osg::StateAttribute*, osg::StateAttribute::OverrideValue> > Replacements;
+
+        Replacements replacements;
+        const osg::StateSet::AttributeList& attributes = stateset->getAttributeList();
+        for (osg::StateSet::AttributeList::const_iterator it = attributes.begin(); it != attributes.end(); ++it)
+        {
+            osg::StateAttribute* shared = share(it->second.first.get());
+            if (shared != it->second.first.get())
+                replacements.push_back(std::make_pair(shared, it->second.second));
+        }
+        for (Replacements::const_iterator it = replacements.begin(); it != replacements.end(); ++it)
+            stateset->setAttribute(it->first, it->second);
+
+        for (unsigned int unit=0; unit<stateset->getTextureAttributeList().size(); ++unit)
+        {
+            replacements.clear();
+            const osg::StateSet::AttributeList& textureAttributes = stateset->getTextureAttributeList()[unit];
+            for (osg::StateSet::AttributeList::const_iterator it = textureAttributes.begin(); it != textureAttributes.end(); ++it)
+            {
+                osg::StateAttribute* shared = share(it->second.first.get());
+                if (shared != it->second.first.get())
+                    replacements.push_back(std::make_pair(shared, it->second.second));
+            }
+            for (Replacements::const_iterator it = replacements.begin(); it != replacements.end(); ++it)
+                stateset->setTextureAttribute(unit, it->first, it->second);
+        }
+    }
+
+    void SharedStateCache::prune()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
+        // The StateSets first, they reference the attributes
+        for (StateSetSet::iterator it = mStateSets.begin(); it != mStateSets.end();)
+        {
+            if ((*it)->referenceCount() <= 1)
+                mStateSets.erase(it++);
+            else
+                ++it;
+        }
+        for (AttributeSet::iterator it = mAttributes.begin(); it != mAttributes.end();)
+        {
+            if ((*it)->referenceCount() <= 1)
+                mAttributes.erase(it++);
+            else
+                ++it;
+        }
+    }
+
+    unsigned int SharedStateCache::getCacheSize() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        return mStateSets.size() + mAttributes.size();
+    }
+
+}
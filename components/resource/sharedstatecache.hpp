@@ -0,0 +1,76 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_SHAREDSTATECACHE_H
+#define OPENMW_COMPONENTS_RESOURCE_SHAREDSTATECACHE_H
+
+#include <set>
+
+#include <OpenThreads/Mutex>
+
+#include <osg/ref_ptr>
+#include <osg/StateSet>
+#include <osg/StateAttribute>
+
+namespace osg
+{
+    class Node;
+}
+
+namespace Resource
+{
+
+    /// @brief Replaces equal StateSets and StateAttributes of scene templates by one shared object, so that
+    /// identical materials of different NIF files share their state and can be sorted together.
+    /// @par Unlike osgDB::SharedStateManager, the attributes are shared one by one, e.g. the same Material
+    /// is shared by StateSets that differ in their textures, and the objects no longer used by any template
+    /// are dropped on prune().
+    /// @par Objects with a DYNAMIC data variance or with callbacks are left alone. Textures are not
+    /// shared here, since the TextureManager already shares them by file.
+    /// @note Thread safe.
+    class SharedStateCache
+    {
+    public:
+        /// Share the StateSets of \a node and its children, and the attributes in them.
+        void share(osg::Node* node);
+
+        /// Drop the objects that are only referenced by the cache.
+        void prune();
+
+        /// The number of StateSets and StateAttributes in the cache.
+        unsigned int getCacheSize() const;
+
+    private:
+        struct LessAttribute
+        {
+            bool operator()(const osg::ref_ptr<osg::StateAttribute>& left, const osg::ref_ptr<osg::StateAttribute>& right) const
+            {
+                return left->compare(*right) < 0;
+            }
+        };
+
+        struct LessStateSet
+        {
+            // The attributes are shared first, so equal attributes are the same object already
+            bool operator()(const osg::ref_ptr<osg::StateSet>& left, const osg::ref_ptr<osg::StateSet>& right) const
+            {
+                return left->compare(*right, false) < 0;
+            }
+        };
+
+        typedef std::set<osg::ref_ptr<osg::StateAttribute>, LessAttribute> AttributeSet;
+        typedef std::set<osg::ref_ptr<osg::StateSet>, LessStateSet> StateSetSet;
+
+        friend class ShareStateVisitor;
+
+        osg::StateSet* share(osg::StateSet* stateset);
+
+        osg::StateAttribute* share(osg::StateAttribute* attribute);
+
+        void shareAttributes(osg::StateSet* stateset);
+
+        AttributeSet mAttributes;
+        StateSetSet mStateSets;
+        mutable OpenThreads::Mutex mMutex;
+    };
+
+}
+
+#endif
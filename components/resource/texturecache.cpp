@@ -0,0 +1,489 @@
+#include "texturecache.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <OpenThreads/ScopedLock>
+
+#include <osg/Texture>
+#include <osgDB/Registry>
+
+#include <components/sceneutil/workqueue.hpp>
+
+namespace
+{
+
+    /// Increase when the compression changes
+    const int sFormatVersion = 1;
+
+    uint64_t hashName(const std::string& name)
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i=0; i<name.size(); ++i)
+        {
+            hash ^= static_cast<unsigned char>(name[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /// An image with 8 bit RGBA pixels, the first row being the first row of the source image
+    struct Pixels
+    {
+        int mWidth;
+        int mHeight;
+        std::vector<unsigned char> mData;
+
+        const unsigned char* get(int x, int y) const
+        {
+            x = std::min(x, mWidth-1);
+            y = std::min(y, mHeight-1);
+            return &mData[(y * mWidth + x) * 4];
+        }
+    };
+
+    bool getPixels(const osg::Image& image, Pixels& pixels)
+    {
+        if (image.getDataType() != GL_UNSIGNED_BYTE || image.r() != 1 || image.s() < 1 || image.t() < 1)
+            return false;
+
+        int channels = 0;
+        switch (image.getPixelFormat())
+        {
+            case GL_RGB:
+            case GL_BGR:
+                channels = 3;
+                break;
+            case GL_RGBA:
+            case GL_BGRA:
+                channels = 4;
+                break;
+            case GL_LUMINANCE:
+                channels = 1;
+                break;
+            case GL_LUMINANCE_ALPHA:
+                channels = 2;
+                break;
+            default:
+                return false;
+        }
+        bool bgr = image.getPixelFormat() == GL_BGR || image.getPixelFormat() == GL_BGRA;
+
+        pixels.mWidth = image.s();
+        pixels.mHeight = image.t();
+        pixels.mData.resize(pixels.mWidth * pixels.mHeight * 4);
+        unsigned char* out = &pixels.mData[0];
+
+        for (int y=0; y<image.t(); ++y)
+        {
+            const unsigned char* in = image.data(0, y);
+            for (int x=0; x<image.s(); ++x, in += channels, out += 4)
+            {
+                switch (channels)
+                {
+                    case 1:
+                        out[0] = out[1] = out[2] = in[0];
+                        out[3] = 255;
+                        break;
+                    case 2:
+                        out[0] = out[1] = out[2] = in[0];
+                        out[3] = in[1];
+                        break;
+                    default:
+                        out[0] = in[bgr ? 2 : 0];
+                        out[1] = in[1];
+                        out[2] = in[bgr ? 0 : 2];
+                        out[3] = channels == 4 ? in[3] : 255;
+                        break;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// The next smaller mipmap, averaging 2x2 pixels
+    void halve(const Pixels& in, Pixels& out)
+    {
+        out.mWidth = std::max(1, in.mWidth/2);
+        out.mHeight = std::max(1, in.mHeight/2);
+        out.mData.resize(out.mWidth * out.mHeight * 4);
+
+        for (int y=0; y<out.mHeight; ++y)
+        {
+            for (int x=0; x<out.mWidth; ++x)
+            {
+                const unsigned char* a = in.get(x*2, y*2);
+                const unsigned char* b = in.get(x*2+1, y*2);
+                const unsigned char* c = in.get(x*2, y*2+1);
+                const unsigned char* d = in.get(x*2+1, y*2+1);
+                unsigned char* pixel = &out.mData[(y * out.mWidth + x) * 4];
+                for (int i=0; i<4; ++i)
+                    pixel[i] = static_cast<unsigned char>((a[i] + b[i] + c[i] + d[i] + 2) / 4);
+            }
+        }
+    }
+
+    unsigned short toRGB565(const int color[3])
+    {
+        return static_cast<unsigned short>(((color[0] * 31 + 127) / 255) << 11
+                                         | ((color[1] * 63 + 127) / 255) << 5
+                                         | ((color[2] * 31 + 127) / 255));
+    }
+
+    void fromRGB565(unsigned short value, int color[3])
+    {
+        int r = (value >> 11) & 31;
+        int g = (value >> 5) & 63;
+        int b = value & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    void writeShort(unsigned char* out, unsigned short value)
+    {
+        out[0] = static_cast<unsigned char>(value & 0xff);
+        out[1] = static_cast<unsigned char>(value >> 8);
+    }
+
+    /// Encode the colors of a 4x4 block, with the end points at the corners of their bounding box
+    void compressColors(const unsigned char block[16][4], unsigned char* out)
+    {
+        int low[3] = { 255, 255, 255 };
+        int high[3] = { 0, 0, 0 };
+        for (int i=0; i<16; ++i)
+            for (int c=0; c<3; ++c)
+            {
+                low[c] = std::min(low[c], static_cast<int>(block[i][c]));
+                high[c] = std::max(high[c], static_cast<int>(block[i][c]));
+            }
+
+        // Move the end points inwards a bit, which lowers the error of the colors in between
+        for (int c=0; c<3; ++c)
+        {
+            int inset = (high[c] - low[c]) / 16;
+            low[c] += inset;
+            high[c] -= inset;
+        }
+
+        // Pick the diagonal of the bounding box that follows the colors, by the sign of the covariance of
+        // each channel with the channel of the largest range
+        int widest = 0;
+        int mean[3] = { 0, 0, 0 };
+        for (int c=0; c<3; ++c)
+        {
+            if (high[c] - low[c] > high[widest] - low[widest])
+                widest = c;
+            for (int i=0; i<16; ++i)
+                mean[c] += block[i][c];
+        }
+        for (int c=0; c<3; ++c)
+        {
+            if (c == widest)
+                continue;
+            int covariance = 0;
+            for (int i=0; i<16; ++i)
+                covariance += (block[i][widest] * 16 - mean[widest]) * (block[i][c] * 16 - mean[c]) / 256;
+            if (covariance < 0)
+                std::swap(low[c], high[c]);
+        }
+
+        unsigned short color0 = toRGB565(high);
+        unsigned short color1 = toRGB565(low);
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        writeShort(out, color0);
+        writeShort(out + 2, color1);
+
+        unsigned int indices = 0;
+        if (color0 != color1)
+        {
+            int palette[4][3];
+            fromRGB565(color0, palette[0]);
+            fromRGB565(color1, palette[1]);
+            for (int c=0; c<3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int i=0; i<16; ++i)
+            {
+                int best = 0;
+                int bestDistance = -1;
+                for (int p=0; p<4; ++p)
+                {
+                    int distance = 0;
+                    for (int c=0; c<3; ++c)
+                    {
+                        int difference = block[i][c] - palette[p][c];
+                        distance += difference * difference;
+                    }
+                    if (bestDistance < 0 || distance < bestDistance)
+                    {
+                        best = p;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= static_cast<unsigned int>(best) << (i * 2);
+            }
+        }
+
+        for (int i=0; i<4; ++i)
+            out[4 + i] = static_cast<unsigned char>((indices >> (i * 8)) & 0xff);
+    }
+
+    /// Encode the alpha of a 4x4 block, interpolating between its lowest and highest value
+    void compressAlpha(const unsigned char block[16][4], unsigned char* out)
+    {
+        int low = 255;
+        int high = 0;
+        for (int i=0; i<16; ++i)
+        {
+            low = std::min(low, static_cast<int>(block[i][3]));
+            high = std::max(high, static_cast<int>(block[i][3]));
+        }
+
+        out[0] = static_cast<unsigned char>(high);
+        out[1] = static_cast<unsigned char>(low);
+
+        int palette[8];
+        palette[0] = high;
+        palette[1] = low;
+        for (int p=1; p<7; ++p)
+            palette[p+1] = ((7 - p) * high + p * low) / 7;
+
+        uint64_t indices = 0;
+        if (high != low)
+        {
+            for (int i=0; i<16; ++i)
+            {
+                int best = 0;
+                for (int p=1; p<8; ++p)
+                    if (std::abs(block[i][3] - palette[p]) < std::abs(block[i][3] - palette[best]))
+                        best = p;
+                indices |= static_cast<uint64_t>(best) << (i * 3);
+            }
+        }
+
+        for (int i=0; i<6; ++i)
+            out[2 + i] = static_cast<unsigned char>((indices >> (i * 8)) & 0xff);
+    }
+
+    void compressLevel(const Pixels& pixels, bool alpha, std::vector<unsigned char>& out)
+    {
+        const int blockSize = alpha ? 16 : 8;
+        for (int y=0; y<pixels.mHeight; y+=4)
+        {
+            for (int x=0; x<pixels.mWidth; x+=4)
+            {
+                unsigned char block[16][4];
+                for (int i=0; i<16; ++i)
+                    std::memcpy(block[i], pixels.get(x + i%4, y + i/4), 4);
+
+                size_t offset = out.size();
+                out.resize(offset + blockSize);
+                if (alpha)
+                {
+                    compressAlpha(block, &out[offset]);
+                    compressColors(block, &out[offset + 8]);
+                }
+                else
+                    compressColors(block, &out[offset]);
+            }
+        }
+    }
+
+}
+
+namespace Resource
+{
+
+    class CompressImageItem : public SceneUtil::WorkItem
+    {
+    public:
+        CompressImageItem(TextureCache* cache, const std::string& normalizedName, uint64_t sourceHash, osg::Image* image)
+            : mCache(cache)
+            , mNormalizedName(normalizedName)
+            , mSourceHash(sourceHash)
+            , mImage(image)
+        {
+        }
+
+        virtual void doWork()
+        {
+            if (!mTicket->isCancelled())
+                mCache->write(mNormalizedName, mSourceHash, *mImage);
+            mCache->finishWrite(mNormalizedName);
+            mTicket->signalDone();
+        }
+
+    private:
+        osg::ref_ptr<TextureCache> mCache;
+        std::string mNormalizedName;
+        uint64_t mSourceHash;
+        osg::ref_ptr<osg::Image> mImage;
+    };
+
+    TextureCache::TextureCache(const boost::filesystem::path &directory)
+        : mDirectory(directory)
+    {
+    }
+
+    boost::filesystem::path TextureCache::getPath(const std::string &normalizedName, uint64_t sourceHash) const
+    {
+        std::ostringstream name;
+        name << std::hex << std::setfill('0')
+             << std::setw(16) << hashName(normalizedName) << '-'
+             << std::setw(16) << sourceHash << '-'
+             << std::dec << sFormatVersion << ".dds";
+        return mDirectory / name.str();
+    }
+
+    osg::ref_ptr<osg::Image> TextureCache::read(const std::string &normalizedName, uint64_t sourceHash) const
+    {
+        const boost::filesystem::path path = getPath(normalizedName, sourceHash);
+
+        try
+        {
+            if (!boost::filesystem::exists(path))
+                return NULL;
+
+            osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension("dds");
+            if (!reader)
+                return NULL;
+
+            boost::filesystem::ifstream stream(path, std::ios::binary);
+            if (!stream.is_open())
+                return NULL;
+
+            osgDB::ReaderWriter::ReadResult result = reader->readImage(stream);
+            if (!result.success() || !result.getImage())
+            {
+                std::cerr << "Failed to read cached texture for " << normalizedName << ": " << result.message() << std::endl;
+                return NULL;
+            }
+            return result.getImage();
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to read cached texture for " << normalizedName << ": " << e.what() << std::endl;
+            return NULL;
+        }
+    }
+
+    void TextureCache::queueWrite(SceneUtil::WorkQueue *workQueue, const std::string &normalizedName, uint64_t sourceHash,
+                                  osg::Image *image)
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            if (!mQueued.insert(normalizedName).second)
+                return;
+        }
+
+        // Below the loading of scenes, which need the images first
+        workQueue->addWorkItem(new CompressImageItem(this, normalizedName, sourceHash, image), -1);
+    }
+
+    void TextureCache::finishWrite(const std::string &normalizedName)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        mQueued.erase(normalizedName);
+    }
+
+    void TextureCache::write(const std::string &normalizedName, uint64_t sourceHash, const osg::Image &image) const
+    {
+        osg::ref_ptr<osg::Image> compressed = compress(image);
+        if (!compressed)
+            return;
+
+        osgDB::ReaderWriter* writer = osgDB::Registry::instance()->getReaderWriterForExtension("dds");
+        if (!writer)
+            return;
+
+        const boost::filesystem::path path = getPath(normalizedName, sourceHash);
+        // Write to a temporary file first, so an image is never left half written
+        boost::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+
+        try
+        {
+            if (!boost::filesystem::exists(mDirectory))
+                boost::filesystem::create_directories(mDirectory);
+
+            {
+                boost::filesystem::ofstream stream(tempPath, std::ios::binary | std::ios::out | std::ios::trunc);
+                if (!stream.is_open())
+                    throw std::runtime_error("can not open file for writing");
+
+                // The rows are in the order of the source file already, like in the DDS files of the game
+                osg::ref_ptr<osgDB::Options> options (new osgDB::Options("ddsNoAutoFlipWrite"));
+                osgDB::ReaderWriter::WriteResult result = writer->writeImage(*compressed, stream, options);
+                if (!result.success())
+                    throw std::runtime_error(result.message());
+                if (stream.fail())
+                    throw std::runtime_error("write operation failed");
+            }
+
+            boost::filesystem::rename(tempPath, path);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to cache texture for " << normalizedName << ": " << e.what() << std::endl;
+            boost::system::error_code ec;
+            boost::filesystem::remove(tempPath, ec);
+        }
+    }
+
+    osg::ref_ptr<osg::Image> TextureCache::compress(const osg::Image &image)
+    {
+        Pixels pixels;
+        if (!getPixels(image, pixels))
+            return NULL;
+
+        bool alpha = false;
+        for (size_t i=3; i<pixels.mData.size() && !alpha; i+=4)
+            alpha = pixels.mData[i] != 255;
+
+        std::vector<unsigned char> data;
+        osg::Image::MipmapDataType mipmaps;
+        const int width = pixels.mWidth;
+        const int height = pixels.mHeight;
+
+        while (true)
+        {
+            compressLevel(pixels, alpha, data);
+            if (pixels.mWidth == 1 && pixels.mHeight == 1)
+                break;
+
+            mipmaps.push_back(static_cast<unsigned int>(data.size()));
+            Pixels smaller;
+            halve(pixels, smaller);
+            pixels.mWidth = smaller.mWidth;
+            pixels.mHeight = smaller.mHeight;
+            pixels.mData.swap(smaller.mData);
+        }
+
+        unsigned char* buffer = new unsigned char[data.size()];
+        std::memcpy(buffer, &data[0], data.size());
+
+        GLenum format = alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        osg::ref_ptr<osg::Image> compressed (new osg::Image);
+        compressed->setImage(width, height, 1, format, format, GL_UNSIGNED_BYTE, buffer, osg::Image::USE_NEW_DELETE);
+        compressed->setMipmapLevels(mipmaps);
+        compressed->setOrigin(osg::Image::TOP_LEFT);
+        return compressed;
+    }
+
+}
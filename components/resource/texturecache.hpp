@@ -0,0 +1,66 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_TEXTURECACHE_H
+#define OPENMW_COMPONENTS_RESOURCE_TEXTURECACHE_H
+
+#include <stdint.h>
+#include <set>
+#include <string>
+
+#include <boost/filesystem/path.hpp>
+
+#include <OpenThreads/Mutex>
+
+#include <osg/ref_ptr>
+#include <osg/Referenced>
+#include <osg/Image>
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
+namespace Resource
+{
+
+    /// @brief Keeps the images of textures that are not DDS files on disk, compressed to DXT1 or DXT5 with
+    /// all their mipmaps, so they take less memory and need no mipmaps generated when they are uploaded.
+    /// @par Images are stored by their name and a hash of the source file, like the scenes of the SceneCache,
+    /// so a changed file is compressed again. The compression runs on a work queue, the first load of a
+    /// texture still uses the source image.
+    class TextureCache : public osg::Referenced
+    {
+    public:
+        TextureCache(const boost::filesystem::path& directory);
+
+        /// Read the compressed image of the given source file, if it is cached.
+        /// @return NULL if the image is not cached, or could not be read.
+        osg::ref_ptr<osg::Image> read(const std::string& normalizedName, uint64_t sourceHash) const;
+
+        /// Compress the image of the given source file on the work queue and store it, unless it is being
+        /// compressed already.
+        void queueWrite(SceneUtil::WorkQueue* workQueue, const std::string& normalizedName, uint64_t sourceHash,
+                        osg::Image* image);
+
+        /// Compress the image of the given source file and store it, if its format is supported.
+        void write(const std::string& normalizedName, uint64_t sourceHash, const osg::Image& image) const;
+
+        /// Compress an image to DXT1, or to DXT5 if it has transparent pixels, with a full chain of mipmaps.
+        /// @return NULL if the pixel format of the image is not supported.
+        static osg::ref_ptr<osg::Image> compress(const osg::Image& image);
+
+    private:
+        boost::filesystem::path getPath(const std::string& normalizedName, uint64_t sourceHash) const;
+
+        void finishWrite(const std::string& normalizedName);
+
+        boost::filesystem::path mDirectory;
+
+        // Names of the images on the work queue
+        std::set<std::string> mQueued;
+        OpenThreads::Mutex mMutex;
+
+        friend class CompressImageItem;
+    };
+
+}
+
+#endif
@@ -1,14 +1,27 @@
 #include "texturemanager.hpp"
 
+#include <OpenThreads/ScopedLock>
+
 #include <osgDB/Registry>
 #include <osg/GLExtensions>
+#include <osg/Stats>
 #include <osg/Version>
 #include <osgViewer/Viewer>
 
 #include <stdexcept>
+#include <algorithm>
+#include <set>
+#include <cstring>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
 
 #include <components/vfs/manager.hpp>
 
+#include "objectcache.hpp"
+#include "scenecache.hpp"
+#include "texturecache.hpp"
+
 #ifdef OSG_LIBRARY_STATIC
 // This list of plugins should match with the list in the top-level CMakelists.txt.
 USE_OSGPLUGIN(png)
@@ -40,18 +53,63 @@ namespace
         return warningTexture;
     }
 
+    /// Copy of the mipmaps of \a image from the first one that is no larger than \a maxSize, or \a image
+    /// itself if it is no larger or has no mipmaps.
+    osg::ref_ptr<osg::Image> getSmallMipmaps(osg::Image* image, int maxSize)
+    {
+        unsigned int numLevels = image->getNumMipmapLevels();
+        unsigned int level = 0;
+        int width = image->s();
+        int height = image->t();
+        while (level+1 < numLevels && std::max(width, height) > maxSize)
+        {
+            ++level;
+            width = std::max(1, width/2);
+            height = std::max(1, height/2);
+        }
+        if (level == 0)
+            return image;
+
+        unsigned int offset = image->getMipmapOffset(level);
+        unsigned int size = image->getTotalSizeInBytesIncludingMipmaps() - offset;
+        unsigned char* data = new unsigned char[size];
+        std::memcpy(data, image->data() + offset, size);
+
+        osg::Image::MipmapDataType mipmaps;
+        for (unsigned int i=level+1; i<numLevels; ++i)
+            mipmaps.push_back(image->getMipmapOffset(i) - offset);
+
+        osg::ref_ptr<osg::Image> smaller (new osg::Image);
+        smaller->setFileName(image->getFileName());
+        smaller->setImage(width, height, 1, image->getInternalTextureFormat(), image->getPixelFormat(),
+                        image->getDataType(), data, osg::Image::USE_NEW_DELETE, image->getPacking());
+        smaller->setMipmapLevels(mipmaps);
+        smaller->setOrigin(image->getOrigin());
+        return smaller;
+    }
+
+    template <typename Age>
+    bool isOlder(const Age& left, const Age& right)
+    {
+        return left.first < right.first;
+    }
+
 }
 
 namespace Resource
 {
 
     TextureManager::TextureManager(const VFS::Manager *vfs)
-        : mVFS(vfs)
+        : ResourceManager(vfs)
         , mMinFilter(osg::Texture::LINEAR_MIPMAP_LINEAR)
         , mMagFilter(osg::Texture::LINEAR)
         , mMaxAnisotropy(1)
         , mWarningTexture(createWarningTexture())
         , mUnRefImageDataAfterApply(false)
+        , mWorkQueue(NULL)
+        , mTextureBytes(0)
+        , mTextureBudget(0)
+        , mStreamedSize(256)
     {
 
     }
@@ -61,11 +119,84 @@ namespace Resource
 
     }
 
+    void TextureManager::updateCache(double referenceTime)
+    {
+        ResourceManager::updateCache(referenceTime);
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        mDecodedImages.clear();
+        for (TextureMap::iterator it = mTextures.begin(); it != mTextures.end();)
+        {
+            CachedTexture& cached = it->second;
+            if (cached.mTimeStamp < 0 || cached.mTexture->referenceCount() > 1)
+                cached.mTimeStamp = referenceTime;
+            else if (cached.mTimeStamp < referenceTime - mExpiryDelay)
+            {
+                mTextureBytes -= cached.mBytes;
+                mTextures.erase(it++);
+                continue;
+            }
+            ++it;
+        }
+
+        if (mTextureBudget == 0 || mTextureBytes <= mTextureBudget)
+            return;
+
+        // Over the budget, drop the textures that are not in use early, the longest unused first
+        typedef std::pair<double, TextureMap::iterator> Age;
+        std::vector<Age> unused;
+        for (TextureMap::iterator it = mTextures.begin(); it != mTextures.end(); ++it)
+            if (it->second.mTexture->referenceCount() == 1)
+                unused.push_back(std::make_pair(it->second.mTimeStamp, it));
+        std::sort(unused.begin(), unused.end(), isOlder<Age>);
+
+        for (std::vector<Age>::const_iterator it = unused.begin();
+             it != unused.end() && mTextureBytes > mTextureBudget; ++it)
+        {
+            mTextureBytes -= it->second->second.mBytes;
+            mTextures.erase(it->second);
+        }
+    }
+
+    void TextureManager::clearCache()
+    {
+        ResourceManager::clearCache();
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        mTextures.clear();
+        mTextureBytes = 0;
+        mDecodedImages.clear();
+    }
+
+    void TextureManager::reportStats(unsigned int frameNumber, osg::Stats &stats) const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        stats.setAttribute(frameNumber, "resource_textures", mTextures.size());
+        stats.setAttribute(frameNumber, "resource_texture_bytes", mTextureBytes);
+    }
+
     void TextureManager::setUnRefImageDataAfterApply(bool unref)
     {
         mUnRefImageDataAfterApply = unref;
     }
 
+    void TextureManager::setTextureCacheDirectory(const boost::filesystem::path &directory)
+    {
+        mTextureCache = new TextureCache(directory);
+    }
+
+    void TextureManager::setWorkQueue(SceneUtil::WorkQueue *workQueue)
+    {
+        mWorkQueue = workQueue;
+    }
+
+    void TextureManager::setTextureBudget(size_t bytes, int streamedSize)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        mTextureBudget = bytes;
+        mStreamedSize = std::max(1, streamedSize);
+    }
+
     void TextureManager::setFilterSettings(const std::string &magfilter, const std::string &minfilter,
                                            const std::string &mipmap, int maxAnisotropy,
                                            osgViewer::Viewer *viewer)
@@ -111,9 +242,10 @@ namespace Resource
         mMagFilter = magFilter;
         mMaxAnisotropy = std::max(1, maxAnisotropy);
 
-        for (std::map<MapKey, osg::ref_ptr<osg::Texture2D> >::iterator it = mTextures.begin(); it != mTextures.end(); ++it)
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        for (TextureMap::iterator it = mTextures.begin(); it != mTextures.end(); ++it)
         {
-            osg::ref_ptr<osg::Texture2D> tex = it->second;
+            osg::ref_ptr<osg::Texture2D> tex = it->second.mTexture;
 
             // Keep mip-mapping disabled if the texture creator explicitely requested no mipmapping.
             osg::Texture::FilterMode oldMin = tex->getFilter(osg::Texture::MIN_FILTER);
@@ -187,51 +319,213 @@ namespace Resource
     {
         std::string normalized = filename;
         mVFS->normalizeFilename(normalized);
-        std::map<std::string, osg::ref_ptr<osg::Image> >::iterator found = mImages.find(normalized);
-        if (found != mImages.end())
-            return found->second;
-        else
+        osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(normalized);
+        if (obj)
+            return static_cast<osg::Image*>(obj.get());
+
+        countLoad();
+
+        Files::IStreamPtr stream;
+        try
         {
-            Files::IStreamPtr stream;
-            try
-            {
-                stream = mVFS->get(normalized.c_str());
-            }
-            catch (std::exception& e)
-            {
-                std::cerr << "Failed to open image: " << e.what() << std::endl;
-                return NULL;
-            }
+            stream = mVFS->getNormalized(normalized);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to open image: " << e.what() << std::endl;
+            return NULL;
+        }
+
+        osg::ref_ptr<osgDB::Options> opts (new osgDB::Options);
+        opts->setOptionString("dds_dxt1_detect_rgba"); // tx_creature_werewolf.dds isn't loading in the correct format without this option
+        size_t extPos = normalized.find_last_of('.');
+        std::string ext;
+        if (extPos != std::string::npos && extPos+1 < normalized.size())
+            ext = normalized.substr(extPos+1);
+        osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
+        if (!reader)
+        {
+            std::cerr << "Error loading " << filename << ": no readerwriter for '" << ext << "' found" << std::endl;
+            return NULL;
+        }
+
+        osgDB::ReaderWriter::ReadResult result = reader->readImage(*stream, opts);
+        if (!result.success())
+        {
+            std::cerr << "Error loading " << filename << ": " << result.message() << " code " << result.status() << std::endl;
+            return NULL;
+        }
+
+        osg::Image* image = result.getImage();
+        if (!checkSupported(image, filename))
+        {
+            return NULL;
+        }
 
-            osg::ref_ptr<osgDB::Options> opts (new osgDB::Options);
-            opts->setOptionString("dds_dxt1_detect_rgba"); // tx_creature_werewolf.dds isn't loading in the correct format without this option
-            size_t extPos = normalized.find_last_of('.');
-            std::string ext;
-            if (extPos != std::string::npos && extPos+1 < normalized.size())
-                ext = normalized.substr(extPos+1);
-            osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
-            if (!reader)
+        // Another thread may have loaded the same image meanwhile
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        obj = mCache->getRefFromObjectCache(normalized);
+        if (obj)
+            return static_cast<osg::Image*>(obj.get());
+        addToCache(normalized, image);
+        return image;
+    }
+
+    osg::ref_ptr<osg::Image> TextureManager::readTextureImage(const std::string &normalized, const std::string &filename)
+    {
+        size_t extPos = normalized.find_last_of('.');
+        std::string ext;
+        if (extPos != std::string::npos && extPos+1 < normalized.size())
+            ext = normalized.substr(extPos+1);
+
+        Files::IStreamPtr stream;
+        uint64_t sourceHash = 0;
+        bool useCache = mTextureCache && mWorkQueue && ext != "dds";
+        try
+        {
+            if (useCache)
             {
-                std::cerr << "Error loading " << filename << ": no readerwriter for '" << ext << "' found" << std::endl;
-                return NULL;
+                sourceHash = SceneCache::hashSource(*mVFS->getNormalized(normalized));
+
+                osg::ref_ptr<osg::Image> cached = mTextureCache->read(normalized, sourceHash);
+                if (cached)
+                {
+                    if (checkSupported(cached, filename))
+                        return cached;
+                    useCache = false;
+                }
             }
 
-            osgDB::ReaderWriter::ReadResult result = reader->readImage(*stream, opts);
-            if (!result.success())
+            stream = mVFS->getNormalized(normalized);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to open texture: " << e.what() << std::endl;
+            return NULL;
+        }
+
+        osg::ref_ptr<osgDB::Options> opts (new osgDB::Options);
+        opts->setOptionString("dds_dxt1_detect_rgba"); // tx_creature_werewolf.dds isn't loading in the correct format without this option
+        osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
+        if (!reader)
+        {
+            std::cerr << "Error loading " << filename << ": no readerwriter for '" << ext << "' found" << std::endl;
+            return NULL;
+        }
+
+        osgDB::ReaderWriter::ReadResult result = reader->readImage(*stream, opts);
+        if (!result.success())
+        {
+            std::cerr << "Error loading " << filename << ": " << result.message() << " code " << result.status() << std::endl;
+            return NULL;
+        }
+
+        osg::ref_ptr<osg::Image> image = result.getImage();
+        if (!checkSupported(image, filename))
+        {
+            return NULL;
+        }
+
+        // We need to flip images, because the Morrowind texture coordinates use the DirectX convention (top-left image origin),
+        // but OpenGL uses bottom left as the image origin.
+        // For some reason this doesn't concern DDS textures, which are already flipped when loaded.
+        if (ext != "dds")
+        {
+            image->flipVertical();
+        }
+
+        // Compressed from the flipped image, so the copy reads like a DDS file
+        if (useCache)
+            mTextureCache->queueWrite(mWorkQueue, normalized, sourceHash, image);
+
+        return image;
+    }
+
+    /// Decodes a list of images on a number of threads.
+    class DecodeImagesJob
+    {
+    public:
+        DecodeImagesJob(TextureManager* textureManager, const std::vector<std::string>& names)
+            : mTextureManager(textureManager)
+            , mNames(names)
+            , mNext(0)
+            , mResults(names.size())
+        {
+        }
+
+        void run()
+        {
+            while (true)
             {
-                std::cerr << "Error loading " << filename << ": " << result.message() << " code " << result.status() << std::endl;
-                return NULL;
+                size_t index;
+                {
+                    boost::mutex::scoped_lock lock(mMutex);
+                    if (mNext >= mNames.size())
+                        return;
+                    index = mNext++;
+                }
+
+                mResults[index] = mTextureManager->readTextureImage(mNames[index], mNames[index]);
             }
+        }
+
+        /// @note Only call once all threads have finished.
+        const std::vector<osg::ref_ptr<osg::Image> >& getResults() const
+        {
+            return mResults;
+        }
+
+    private:
+        TextureManager* mTextureManager;
+        const std::vector<std::string>& mNames;
+
+        boost::mutex mMutex;
+        size_t mNext;
+
+        std::vector<osg::ref_ptr<osg::Image> > mResults;
+    };
+
+    void TextureManager::prefetchImages(const std::vector<std::string> &filenames)
+    {
+        std::vector<std::string> toDecode;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
 
-            osg::Image* image = result.getImage();
-            if (!checkSupported(image, filename))
+            std::set<std::string> loaded;
+            for (TextureMap::const_iterator it = mTextures.begin(); it != mTextures.end(); ++it)
+                loaded.insert(it->first.second);
+
+            for (std::vector<std::string>::const_iterator it = filenames.begin(); it != filenames.end(); ++it)
             {
-                return NULL;
+                std::string normalized = *it;
+                mVFS->normalizeFilename(normalized);
+                if (!loaded.count(normalized) && !mDecodedImages.count(normalized)
+                        && std::find(toDecode.begin(), toDecode.end(), normalized) == toDecode.end())
+                    toDecode.push_back(normalized);
             }
+        }
 
-            mImages.insert(std::make_pair(normalized, image));
-            return image;
+        // A single image is decoded by getTexture2D() just as well
+        if (toDecode.size() < 2)
+            return;
+
+        DecodeImagesJob job(this, toDecode);
+        {
+            size_t numThreads = std::max(1u, boost::thread::hardware_concurrency());
+            numThreads = std::min(numThreads, toDecode.size());
+
+            boost::thread_group threads;
+            for (size_t i=1; i<numThreads; ++i)
+                threads.create_thread(boost::bind(&DecodeImagesJob::run, &job));
+            job.run();
+            threads.join_all();
         }
+
+        const std::vector<osg::ref_ptr<osg::Image> >& results = job.getResults();
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        for (size_t i=0; i<toDecode.size(); ++i)
+            mDecodedImages[toDecode[i]] = results[i];
     }
 
     osg::ref_ptr<osg::Texture2D> TextureManager::getTexture2D(const std::string &filename, osg::Texture::WrapMode wrapS, osg::Texture::WrapMode wrapT)
@@ -239,71 +533,88 @@ namespace Resource
         std::string normalized = filename;
         mVFS->normalizeFilename(normalized);
         MapKey key = std::make_pair(std::make_pair(wrapS, wrapT), normalized);
-        std::map<MapKey, osg::ref_ptr<osg::Texture2D> >::iterator found = mTextures.find(key);
-        if (found != mTextures.end())
         {
-            return found->second;
-        }
-        else
-        {
-            Files::IStreamPtr stream;
-            try
-            {
-                stream = mVFS->get(normalized.c_str());
-            }
-            catch (std::exception& e)
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            TextureMap::const_iterator found = mTextures.find(key);
+            if (found != mTextures.end())
             {
-                std::cerr << "Failed to open texture: " << e.what() << std::endl;
-                return mWarningTexture;
+                // Only a texture that is not in use gets its full mipmaps, as a draw thread may be using the others
+                const CachedTexture& cached = found->second;
+                if (!cached.mStreamed || cached.mTexture->referenceCount() > 1 || mTextureBudget == 0
+                        || mTextureBytes - cached.mBytes + cached.mFullBytes > mTextureBudget)
+                    return cached.mTexture;
             }
+        }
 
-            osg::ref_ptr<osgDB::Options> opts (new osgDB::Options);
-            opts->setOptionString("dds_dxt1_detect_rgba"); // tx_creature_werewolf.dds isn't loading in the correct format without this option
-            size_t extPos = normalized.find_last_of('.');
-            std::string ext;
-            if (extPos != std::string::npos && extPos+1 < normalized.size())
-                ext = normalized.substr(extPos+1);
-            osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
-            if (!reader)
-            {
-                std::cerr << "Error loading " << filename << ": no readerwriter for '" << ext << "' found" << std::endl;
-                return mWarningTexture;
-            }
+        countLoad();
 
-            osgDB::ReaderWriter::ReadResult result = reader->readImage(*stream, opts);
-            if (!result.success())
+        osg::ref_ptr<osg::Image> image;
+        bool decoded = false;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            std::map<std::string, osg::ref_ptr<osg::Image> >::iterator found = mDecodedImages.find(normalized);
+            if (found != mDecodedImages.end())
             {
-                std::cerr << "Error loading " << filename << ": " << result.message() << " code " << result.status() << std::endl;
-                return mWarningTexture;
+                image = found->second;
+                decoded = true;
+                mDecodedImages.erase(found);
             }
+        }
+        if (!decoded)
+            image = readTextureImage(normalized, filename);
 
-            osg::Image* image = result.getImage();
-            if (!checkSupported(image, filename))
-            {
-                return mWarningTexture;
-            }
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
 
-            // We need to flip images, because the Morrowind texture coordinates use the DirectX convention (top-left image origin),
-            // but OpenGL uses bottom left as the image origin.
-            // For some reason this doesn't concern DDS textures, which are already flipped when loaded.
-            if (ext != "dds")
+        // Another thread may have loaded the same texture meanwhile
+        TextureMap::iterator found = mTextures.find(key);
+        if (found != mTextures.end())
+        {
+            CachedTexture& cached = found->second;
+            if (image && cached.mStreamed && cached.mTexture->referenceCount() == 1
+                    && mTextureBytes - cached.mBytes + cached.mFullBytes <= mTextureBudget)
             {
-                image->flipVertical();
+                unsigned int bytes = image->getTotalSizeInBytesIncludingMipmaps();
+                cached.mTexture->setImage(image);
+                mTextureBytes += bytes - cached.mBytes;
+                cached.mBytes = cached.mFullBytes = bytes;
+                cached.mStreamed = false;
             }
+            return cached.mTexture;
+        }
 
-            osg::ref_ptr<osg::Texture2D> texture(new osg::Texture2D);
-            texture->setImage(image);
-            texture->setWrap(osg::Texture::WRAP_S, wrapS);
-            texture->setWrap(osg::Texture::WRAP_T, wrapT);
-            texture->setFilter(osg::Texture::MIN_FILTER, mMinFilter);
-            texture->setFilter(osg::Texture::MAG_FILTER, mMagFilter);
-            texture->setMaxAnisotropy(mMaxAnisotropy);
+        if (!image)
+            return mWarningTexture;
 
-            texture->setUnRefImageDataAfterApply(mUnRefImageDataAfterApply);
+        CachedTexture cached;
+        cached.mFullBytes = image->getTotalSizeInBytesIncludingMipmaps();
+        cached.mStreamed = false;
 
-            mTextures.insert(std::make_pair(key, texture));
-            return texture;
+        // Over the budget, start with the small mipmaps
+        if (mTextureBudget > 0 && mTextureBytes + cached.mFullBytes > mTextureBudget)
+        {
+            osg::ref_ptr<osg::Image> smaller = getSmallMipmaps(image, mStreamedSize);
+            cached.mStreamed = smaller != image;
+            image = smaller;
         }
+
+        osg::ref_ptr<osg::Texture2D> texture(new osg::Texture2D);
+        texture->setName(normalized);
+        texture->setImage(image);
+        texture->setWrap(osg::Texture::WRAP_S, wrapS);
+        texture->setWrap(osg::Texture::WRAP_T, wrapT);
+        texture->setFilter(osg::Texture::MIN_FILTER, mMinFilter);
+        texture->setFilter(osg::Texture::MAG_FILTER, mMagFilter);
+        texture->setMaxAnisotropy(mMaxAnisotropy);
+
+        texture->setUnRefImageDataAfterApply(mUnRefImageDataAfterApply);
+
+        cached.mTexture = texture;
+        // Stamped at the next cache update
+        cached.mTimeStamp = -1;
+        cached.mBytes = image->getTotalSizeInBytesIncludingMipmaps();
+        mTextureBytes += cached.mBytes;
+        mTextures.insert(std::make_pair(key, cached));
+        return texture;
     }
 
     osg::Texture2D* TextureManager::getWarningTexture()
@@ -3,31 +3,49 @@
 
 #include <string>
 #include <map>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+#include <OpenThreads/Mutex>
 
 #include <osg/ref_ptr>
 #include <osg/Image>
 #include <osg/Texture2D>
 
+#include "resourcemanager.hpp"
+
 namespace osgViewer
 {
     class Viewer;
 }
 
-namespace VFS
+namespace SceneUtil
 {
-    class Manager;
+    class WorkQueue;
 }
 
 namespace Resource
 {
 
+    class TextureCache;
+    class DecodeImagesJob;
+
     /// @brief Handles loading/caching of Images and Texture StateAttributes.
-    class TextureManager
+    class TextureManager : public ResourceManager
     {
     public:
         TextureManager(const VFS::Manager* vfs);
         ~TextureManager();
 
+        /// Drop the images and textures that were not referenced elsewhere for the expiry delay.
+        virtual void updateCache(double referenceTime);
+
+        virtual void clearCache();
+
+        /// Record the number of textures and the size of their image data.
+        virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
+
         void setFilterSettings(const std::string &magfilter, const std::string &minfilter,
                                const std::string &mipmap, int maxAnisotropy,
                                osgViewer::Viewer *view);
@@ -36,6 +54,25 @@ namespace Resource
         /// otherwise should be disabled to reduce memory usage.
         void setUnRefImageDataAfterApply(bool unref);
 
+        /// Limit the size of the texture data, 0 for no limit. While the textures are over the budget, new textures
+        /// only get the mipmaps up to \a streamedSize pixels, and textures that are not in use are dropped before
+        /// their expiry delay, the longest unused first. A texture gets its full mipmaps when it is requested
+        /// while it is not in use and the budget allows.
+        /// @note Only affects images with mipmaps, e.g. DDS files.
+        void setTextureBudget(size_t bytes, int streamedSize);
+
+        /// Use compressed copies of the textures that are not DDS files, kept in the given directory.
+        /// Textures that have no copy yet are compressed on the work queue, for the next time they are loaded.
+        /// @note Needs a work queue, see setWorkQueue().
+        void setTextureCacheDirectory(const boost::filesystem::path& directory);
+
+        void setWorkQueue(SceneUtil::WorkQueue* workQueue);
+
+        /// Decode the images of the given textures at the same time, on a number of threads, so that the next
+        /// getTexture2D() of each does not have to decode it. Textures that are loaded already are skipped.
+        /// @note The decoded images are kept until the next cache update.
+        void prefetchImages(const std::vector<std::string>& filenames);
+
         /// Create or retrieve a Texture2D using the specified image filename, and wrap parameters.
         /// Returns the dummy texture if the given texture is not found.
         osg::ref_ptr<osg::Texture2D> getTexture2D(const std::string& filename, osg::Texture::WrapMode wrapS, osg::Texture::WrapMode wrapT);
@@ -43,32 +80,60 @@ namespace Resource
         /// Create or retrieve an Image
         osg::ref_ptr<osg::Image> getImage(const std::string& filename);
 
-        const VFS::Manager* getVFS() { return mVFS; }
-
         osg::Texture2D* getWarningTexture();
 
     private:
-        const VFS::Manager* mVFS;
-
         osg::Texture::FilterMode mMinFilter;
         osg::Texture::FilterMode mMagFilter;
         int mMaxAnisotropy;
 
         typedef std::pair<std::pair<int, int>, std::string> MapKey;
 
-        std::map<std::string, osg::ref_ptr<osg::Image> > mImages;
-
-        std::map<MapKey, osg::ref_ptr<osg::Texture2D> > mTextures;
+        // Not in the object cache, which holds the images, since setFilterSettings needs to go through them
+        struct CachedTexture
+        {
+            osg::ref_ptr<osg::Texture2D> mTexture;
+            // Last time the texture was referenced outside of the cache
+            double mTimeStamp;
+            // Size of the image data, which may be dropped after it was applied
+            unsigned int mBytes;
+            // Size of the image data with all mipmaps
+            unsigned int mFullBytes;
+            // Are the largest mipmaps left out?
+            bool mStreamed;
+        };
+        typedef std::map<MapKey, CachedTexture> TextureMap;
+        TextureMap mTextures;
+
+        // Images decoded by prefetchImages(), NULL if decoding failed
+        std::map<std::string, osg::ref_ptr<osg::Image> > mDecodedImages;
+
+        // Total mBytes of mTextures
+        size_t mTextureBytes;
+
+        size_t mTextureBudget;
+        int mStreamedSize;
+
+        // Guards mTextures, and adding images, so that scenes can be loaded in the background
+        mutable OpenThreads::Mutex mMutex;
 
         osg::ref_ptr<osg::Texture2D> mWarningTexture;
 
         bool mUnRefImageDataAfterApply;
 
+        osg::ref_ptr<TextureCache> mTextureCache;
+        SceneUtil::WorkQueue* mWorkQueue;
+
+        /// Read an image for a texture, flipped to the OpenGL convention, or NULL if it fails.
+        osg::ref_ptr<osg::Image> readTextureImage(const std::string& normalized, const std::string& filename);
+
         /// @warning It is unsafe to call this function when a draw thread is using the textures. Call stopThreading() first!
         void setFilterSettings(osg::Texture::FilterMode minFilter, osg::Texture::FilterMode maxFilter, int maxAnisotropy);
 
         TextureManager(const TextureManager&);
         void operator = (const TextureManager&);
+
+        friend class DecodeImagesJob;
     };
 
 }
@@ -1,5 +1,7 @@
 #include "clone.hpp"
 
+#include <osg/Array>
+#include <osg/BufferObject>
 #include <osg/StateSet>
 #include <osg/Version>
 
@@ -15,6 +17,15 @@
 namespace SceneUtil
 {
 
+    osg::Array* cloneOutputArray(const osg::Array* array)
+    {
+        osg::Array* cloned = static_cast<osg::Array*>(array->clone(osg::CopyOp::DEEP_COPY_ALL));
+        // Use a buffer object of our own, rather than joining the one of the shared source arrays,
+        // which would change the geometry we cloned from
+        cloned->setVertexBufferObject(new osg::VertexBufferObject);
+        return cloned;
+    }
+
     CopyOp::CopyOp()
     {
         setCopyFlags(osg::CopyOp::DEEP_COPY_NODES
@@ -51,36 +62,13 @@ namespace SceneUtil
             return operator()(partsys);
         if (dynamic_cast<const osgAnimation::MorphGeometry*>(drawable))
         {
-            osg::CopyOp copyop = *this;
-            copyop.setCopyFlags(copyop.getCopyFlags()|osg::CopyOp::DEEP_COPY_ARRAYS);
-
-#if OSG_VERSION_LESS_THAN(3,5,0)
-            /*
-
-            Deep copy of primitives required to work around the following (bad?) code in osg::Geometry copy constructor:
-
-            if ((copyop.getCopyFlags() & osg::CopyOp::DEEP_COPY_ARRAYS))
-            {
-                if (_useVertexBufferObjects)
-                {
-                    // copying of arrays doesn't set up buffer objects so we'll need to force
-                    // Geometry to assign these, we'll do this by switching off VBO's then renabling them.
-                    setUseVertexBufferObjects(false);
-                    setUseVertexBufferObjects(true);
-                }
-            }
-
-            In case of DEEP_COPY_PRIMITIVES=Off, DEEP_COPY_ARRAYS=On, the above code makes a modification to the original const Geometry& we copied from,
-            causing problems if we relied on the original Geometry to remain static such as when it was added to an osgUtil::IncrementalCompileOperation.
-
-            Fixed in OSG 3.5 ( http://forum.openscenegraph.org/viewtopic.php?t=15217 ).
-
-            */
-
-            copyop.setCopyFlags(copyop.getCopyFlags()|osg::CopyOp::DEEP_COPY_PRIMITIVES);
-#endif
+            // The source arrays and morph targets stay shared, only the vertices are written by the morph.
+            // Normals are not morphed, see NifOsg::Loader.
+            osgAnimation::MorphGeometry* cloned = static_cast<osgAnimation::MorphGeometry*>(osg::clone(drawable, *this));
+            cloned->setVertexArray(cloneOutputArray(cloned->getVertexArray()));
+            if (cloned->getMorphNormals() && cloned->getNormalArray())
+                cloned->setNormalArray(cloneOutputArray(cloned->getNormalArray()), osg::Array::BIND_PER_VERTEX);
 
-            osg::Drawable* cloned = osg::clone(drawable, copyop);
             if (cloned->getUpdateCallback())
                 cloned->setUpdateCallback(osg::clone(cloned->getUpdateCallback(), *this));
             return cloned;
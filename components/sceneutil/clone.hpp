@@ -5,6 +5,11 @@
 
 #include <osg/CopyOp>
 
+namespace osg
+{
+    class Array;
+}
+
 namespace osgParticle
 {
     class ParticleProcessor;
@@ -15,10 +20,15 @@ namespace osgParticle
 namespace SceneUtil
 {
 
+    /// Copy an array that an animated geometry writes to, such as skinned vertices, for a new instance.
+    /// The copy gets its own buffer object.
+    osg::Array* cloneOutputArray(const osg::Array* array);
+
     /// @par Defines the cloning behaviour we need:
     /// * Assigns updated ParticleSystem pointers on cloned emitters and programs.
     /// * Creates deep copy of StateSets if they have a DYNAMIC data variance.
-    /// * Deep copies RigGeometry and MorphGeometry so they can animate without affecting clones.
+    /// * Copies RigGeometry and MorphGeometry so they can animate without affecting clones. Only the arrays
+    ///   written by the animation are copied, the source arrays and primitives are shared with the original.
     /// @warning Do not use an object of this class for more than one copy operation.
     class CopyOp : public osg::CopyOp
     {
@@ -1,15 +1,26 @@
 #include "lightmanager.hpp"
 
 #include <stdexcept>
+#include <algorithm>
+#include <cmath>
 
 #include <osg/NodeVisitor>
 #include <osg/Geode>
+#include <osg/Uniform>
+
+#include <OpenThreads/ScopedLock>
 
 #include <osgUtil/CullVisitor>
 
 #include <components/sceneutil/util.hpp>
 
-#include <boost/functional/hash.hpp>
+namespace
+{
+    // Updates until a light list state set that is not used any more is moved to the pool
+    const unsigned int sStateSetExpiry = 60;
+    // Pooled state sets kept per number of lights
+    const unsigned int sMaxPooledStateSets = 64;
+}
 
 namespace SceneUtil
 {
@@ -130,16 +141,28 @@ namespace SceneUtil
     };
 
     LightManager::LightManager()
-        : mStartLight(0)
+        : mClusterTilesX(0)
+        , mClusterTilesY(0)
+        , mClusterSlices(0)
+        , mUpdateCount(1)
+        , mStartLight(0)
         , mLightingMask(~0u)
+        , mStateSetHits(0)
+        , mStateSetMisses(0)
     {
         setUpdateCallback(new LightManagerUpdateCallback);
     }
 
     LightManager::LightManager(const LightManager &copy, const osg::CopyOp &copyop)
         : osg::Group(copy, copyop)
+        , mClusterTilesX(copy.mClusterTilesX)
+        , mClusterTilesY(copy.mClusterTilesY)
+        , mClusterSlices(copy.mClusterSlices)
+        , mUpdateCount(1)
         , mStartLight(copy.mStartLight)
         , mLightingMask(copy.mLightingMask)
+        , mStateSetHits(0)
+        , mStateSetMisses(0)
     {
 
     }
@@ -159,14 +182,48 @@ namespace SceneUtil
         mLights.clear();
         mLightsInViewSpace.clear();
 
-        // do an occasional cleanup for orphaned lights
+        // Keep the grids of the cameras that were rendered last frame, to reuse their storage
+        for (std::map<osg::observer_ptr<osg::Camera>, LightGrid>::iterator it = mLightGrids.begin(); it != mLightGrids.end();)
+        {
+            if (!it->first.valid() || it->second.mBuiltFrame != mUpdateCount)
+                mLightGrids.erase(it++);
+            else
+                ++it;
+        }
+        ++mUpdateCount;
+
+        mStateSetHits = 0;
+        mStateSetMisses = 0;
+
+        // Pool the state sets of light combinations that are not used any more. They were not drawn for a while,
+        // so the draw thread is done with them.
         for (int i=0; i<2; ++i)
         {
-            if (mStateSetCache[i].size() > 5000)
-                mStateSetCache[i].clear();
+            for (LightStateSetMap::iterator it = mStateSetCache[i].begin(); it != mStateSetCache[i].end();)
+            {
+                if (mUpdateCount - it->second.mLastUsed > sStateSetExpiry)
+                {
+                    size_t numLights = it->first.size();
+                    if (mStateSetPool.size() <= numLights)
+                        mStateSetPool.resize(numLights+1);
+                    if (mStateSetPool[numLights].size() < sMaxPooledStateSets)
+                        mStateSetPool[numLights].push_back(it->second);
+                    mStateSetCache[i].erase(it++);
+                }
+                else
+                    ++it;
+            }
         }
     }
 
+    void LightManager::getStateSetCacheStats(unsigned int &hits, unsigned int &misses, unsigned int &cached) const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        hits = mStateSetHits;
+        misses = mStateSetMisses;
+        cached = mStateSetCache[0].size() + mStateSetCache[1].size();
+    }
+
     void LightManager::addLight(LightSource* lightSource, const osg::Matrixf& worldMat, unsigned int frameNum)
     {
         LightSourceTransform l;
@@ -180,34 +237,57 @@ namespace SceneUtil
 
     osg::ref_ptr<osg::StateSet> LightManager::getLightListStateSet(const LightList &lightList, unsigned int frameNum)
     {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
         // possible optimization: return a StateSet containing all requested lights plus some extra lights (if a suitable one exists)
-        size_t hash = 0;
+        mLightIds.clear();
         for (unsigned int i=0; i<lightList.size();++i)
-            boost::hash_combine(hash, lightList[i]->mLightSource->getId());
+            mLightIds.push_back(lightList[i]->mLightSource->getId());
 
         LightStateSetMap& stateSetCache = mStateSetCache[frameNum%2];
 
-        LightStateSetMap::iterator found = stateSetCache.find(hash);
+        LightStateSetMap::iterator found = stateSetCache.find(mLightIds);
         if (found != stateSetCache.end())
-            return found->second;
-        else
         {
+            ++mStateSetHits;
+            found->second.mLastUsed = mUpdateCount;
+            return found->second.mStateSet;
+        }
 
-            std::vector<osg::ref_ptr<osg::Light> > lights;
-            for (unsigned int i=0; i<lightList.size();++i)
-                lights.push_back(lightList[i]->mLightSource->getLight(frameNum));
+        ++mStateSetMisses;
+
+        std::vector<osg::ref_ptr<osg::Light> > lights;
+        for (unsigned int i=0; i<lightList.size();++i)
+            lights.push_back(lightList[i]->mLightSource->getLight(frameNum));
 
-            osg::ref_ptr<LightStateAttribute> attr = new LightStateAttribute(mStartLight, lights);
+        // A new attribute even for pooled state sets, since osg::State skips applying the attribute it applied last
+        osg::ref_ptr<LightStateAttribute> attr = new LightStateAttribute(mStartLight, lights);
 
-            osg::ref_ptr<osg::StateSet> stateset = new osg::StateSet;
+        LightStateSetEntry entry;
+        if (lightList.size() < mStateSetPool.size() && !mStateSetPool[lightList.size()].empty())
+        {
+            // Enables the same light modes, so only the attribute has to be replaced
+            entry = mStateSetPool[lightList.size()].back();
+            mStateSetPool[lightList.size()].pop_back();
+            entry.mStateSet->setAttribute(attr, osg::StateAttribute::ON);
+        }
+        else
+        {
+            entry.mStateSet = new osg::StateSet;
 
             // don't use setAttributeAndModes, that does not support light indices!
-            stateset->setAttribute(attr, osg::StateAttribute::ON);
-            stateset->setAssociatedModes(attr, osg::StateAttribute::ON);
+            entry.mStateSet->setAttribute(attr, osg::StateAttribute::ON);
+            entry.mStateSet->setAssociatedModes(attr, osg::StateAttribute::ON);
 
-            stateSetCache.insert(std::make_pair(hash, stateset));
-            return stateset;
+            // For shaders, which can not tell which lights are enabled
+            entry.mLightCount = new osg::Uniform("lightCount", 0);
+            entry.mStateSet->addUniform(entry.mLightCount);
         }
+        entry.mLightCount->set(static_cast<int>(mStartLight + lightList.size()));
+        entry.mLastUsed = mUpdateCount;
+
+        stateSetCache.insert(std::make_pair(mLightIds, entry));
+        return entry.mStateSet;
     }
 
     const std::vector<LightManager::LightSourceTransform>& LightManager::getLights() const
@@ -217,6 +297,8 @@ namespace SceneUtil
 
     const std::vector<LightManager::LightSourceViewBound>& LightManager::getLightsInViewSpace(osg::Camera *camera, const osg::RefMatrix* viewMatrix)
     {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
         osg::observer_ptr<osg::Camera> camPtr (camera);
         std::map<osg::observer_ptr<osg::Camera>, LightSourceViewBoundCollection>::iterator it = mLightsInViewSpace.find(camPtr);
 
@@ -239,9 +321,201 @@ namespace SceneUtil
         return it->second;
     }
 
+    void LightManager::getIntersectingLights(osg::Camera *camera, const osg::RefMatrix *viewMatrix, const osg::RefMatrix *projectionMatrix,
+                                             const osg::BoundingSphere &viewBound, LightList &lightList)
+    {
+        lightList.clear();
+        if (!viewBound.valid())
+            return;
+
+        const LightSourceViewBoundCollection& lights = getLightsInViewSpace(camera, viewMatrix);
+        if (lights.empty())
+            return;
+
+        if (mClusterTilesX && mClusterTilesY && mClusterSlices)
+        {
+            LightGrid& grid = getLightGrid(camera, lights, projectionMatrix);
+            if (grid.mValid)
+            {
+                ClusterRange range = getClusterRange(grid, viewBound);
+                unsigned int numClusters = (range.mMaxX - range.mMinX + 1) * (range.mMaxY - range.mMinY + 1)
+                        * (range.mMaxSlice - range.mMinSlice + 1);
+
+                // For large bounds, visiting the clusters costs more than testing every light
+                if (numClusters < lights.size())
+                {
+                    if (++grid.mQueryNumber == 0)
+                    {
+                        std::fill(grid.mQueryStamps.begin(), grid.mQueryStamps.end(), 0);
+                        grid.mQueryNumber = 1;
+                    }
+
+                    grid.mCandidates.clear();
+                    for (unsigned int slice = range.mMinSlice; slice <= range.mMaxSlice; ++slice)
+                        for (unsigned int y = range.mMinY; y <= range.mMaxY; ++y)
+                            for (unsigned int x = range.mMinX; x <= range.mMaxX; ++x)
+                            {
+                                unsigned int cluster = (slice * mClusterTilesY + y) * mClusterTilesX + x;
+                                for (unsigned int i = grid.mOffsets[cluster]; i < grid.mOffsets[cluster+1]; ++i)
+                                {
+                                    unsigned int index = grid.mIndices[i];
+                                    if (grid.mQueryStamps[index] != grid.mQueryNumber)
+                                    {
+                                        grid.mQueryStamps[index] = grid.mQueryNumber;
+                                        grid.mCandidates.push_back(index);
+                                    }
+                                }
+                            }
+
+                    // Keep the order of the lights, so that the same lights always map to the same cached StateSet
+                    std::sort(grid.mCandidates.begin(), grid.mCandidates.end());
+                    for (std::vector<unsigned int>::const_iterator it = grid.mCandidates.begin(); it != grid.mCandidates.end(); ++it)
+                    {
+                        const LightSourceViewBound& l = lights[*it];
+                        if (l.mViewBound.intersects(viewBound))
+                            lightList.push_back(&l);
+                    }
+                    return;
+                }
+            }
+        }
+
+        for (unsigned int i=0; i<lights.size(); ++i)
+        {
+            const LightSourceViewBound& l = lights[i];
+            if (l.mViewBound.intersects(viewBound))
+                lightList.push_back(&l);
+        }
+    }
+
+    LightManager::LightGrid& LightManager::getLightGrid(osg::Camera *camera, const LightSourceViewBoundCollection& lights, const osg::RefMatrix *projectionMatrix)
+    {
+        // Only the map is shared, each camera's grid is used by the one thread culling that camera
+        LightGrid* gridPtr = NULL;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            gridPtr = &mLightGrids[osg::observer_ptr<osg::Camera>(camera)];
+        }
+        LightGrid& grid = *gridPtr;
+        if (grid.mBuiltFrame == mUpdateCount)
+            return grid;
+        grid.mBuiltFrame = mUpdateCount;
+
+        double left, right, bottom, top, zNear, zFar;
+        grid.mValid = projectionMatrix->getFrustum(left, right, bottom, top, zNear, zFar) && zNear > 0 && zFar > zNear;
+        if (!grid.mValid)
+            return grid;
+
+        grid.mLeft = left / zNear;
+        grid.mRight = right / zNear;
+        grid.mBottom = bottom / zNear;
+        grid.mTop = top / zNear;
+        grid.mNear = zNear;
+        grid.mSliceScale = mClusterSlices / std::log(zFar / zNear);
+        grid.mQueryStamps.assign(lights.size(), 0);
+        grid.mQueryNumber = 0;
+
+        // Counting sort of the lights by cluster
+        unsigned int numClusters = mClusterTilesX * mClusterTilesY * mClusterSlices;
+        grid.mOffsets.assign(numClusters + 1, 0);
+
+        std::vector<ClusterRange>& ranges = grid.mRanges;
+        ranges.clear();
+        for (unsigned int i=0; i<lights.size(); ++i)
+        {
+            ClusterRange range = getClusterRange(grid, lights[i].mViewBound);
+            ranges.push_back(range);
+            for (unsigned int slice = range.mMinSlice; slice <= range.mMaxSlice; ++slice)
+                for (unsigned int y = range.mMinY; y <= range.mMaxY; ++y)
+                    for (unsigned int x = range.mMinX; x <= range.mMaxX; ++x)
+                        ++grid.mOffsets[(slice * mClusterTilesY + y) * mClusterTilesX + x + 1];
+        }
+
+        for (unsigned int i=0; i<numClusters; ++i)
+            grid.mOffsets[i+1] += grid.mOffsets[i];
+
+        grid.mIndices.resize(grid.mOffsets.back());
+        std::vector<unsigned int>& next = grid.mNext;
+        next.assign(grid.mOffsets.begin(), grid.mOffsets.end() - 1);
+        for (unsigned int i=0; i<lights.size(); ++i)
+        {
+            const ClusterRange& range = ranges[i];
+            for (unsigned int slice = range.mMinSlice; slice <= range.mMaxSlice; ++slice)
+                for (unsigned int y = range.mMinY; y <= range.mMaxY; ++y)
+                    for (unsigned int x = range.mMinX; x <= range.mMaxX; ++x)
+                        grid.mIndices[next[(slice * mClusterTilesY + y) * mClusterTilesX + x]++] = i;
+        }
+
+        return grid;
+    }
+
+    namespace
+    {
+        unsigned int getCell(float value, float min, float max, unsigned int count)
+        {
+            float cell = std::floor((value - min) / (max - min) * count);
+            return static_cast<unsigned int>(std::max(0.f, std::min(cell, static_cast<float>(count - 1))));
+        }
+    }
+
+    LightManager::ClusterRange LightManager::getClusterRange(const LightGrid &grid, const osg::BoundingSphere &viewBound) const
+    {
+        // The camera looks along -z in view space
+        float minDepth = -viewBound.center().z() - viewBound.radius();
+        float maxDepth = -viewBound.center().z() + viewBound.radius();
+
+        ClusterRange range;
+        if (minDepth < grid.mNear)
+        {
+            // Clamped to the first slice. Reaches in front of the near plane, so may cover any part of the view.
+            range.mMinSlice = 0;
+            range.mMinX = 0;
+            range.mMaxX = mClusterTilesX - 1;
+            range.mMinY = 0;
+            range.mMaxY = mClusterTilesY - 1;
+        }
+        else
+        {
+            range.mMinSlice = getCell(std::log(minDepth / grid.mNear) * grid.mSliceScale, 0.f, mClusterSlices, mClusterSlices);
+
+            // The projection of the bounding box of the sphere, which is at its widest on the near or far side of the box
+            float minX = viewBound.center().x() - viewBound.radius();
+            float maxX = viewBound.center().x() + viewBound.radius();
+            float minY = viewBound.center().y() - viewBound.radius();
+            float maxY = viewBound.center().y() + viewBound.radius();
+            range.mMinX = getCell(std::min(minX / minDepth, minX / maxDepth), grid.mLeft, grid.mRight, mClusterTilesX);
+            range.mMaxX = getCell(std::max(maxX / minDepth, maxX / maxDepth), grid.mLeft, grid.mRight, mClusterTilesX);
+            range.mMinY = getCell(std::min(minY / minDepth, minY / maxDepth), grid.mBottom, grid.mTop, mClusterTilesY);
+            range.mMaxY = getCell(std::max(maxY / minDepth, maxY / maxDepth), grid.mBottom, grid.mTop, mClusterTilesY);
+        }
+
+        if (maxDepth < grid.mNear)
+            range.mMaxSlice = 0;
+        else
+            range.mMaxSlice = getCell(std::log(maxDepth / grid.mNear) * grid.mSliceScale, 0.f, mClusterSlices, mClusterSlices);
+
+        return range;
+    }
+
+    void LightManager::setClusterGrid(unsigned int tilesX, unsigned int tilesY, unsigned int slices)
+    {
+        mClusterTilesX = tilesX;
+        mClusterTilesY = tilesY;
+        mClusterSlices = slices;
+        mLightGrids.clear();
+    }
+
     void LightManager::setStartLight(int start)
     {
         mStartLight = start;
+
+        // The cached state sets enable the lights from the old start
+        mStateSetCache[0].clear();
+        mStateSetCache[1].clear();
+        mStateSetPool.clear();
+
+        // For the objects without a light list
+        getOrCreateStateSet()->addUniform(new osg::Uniform("lightCount", start));
     }
 
     int LightManager::getStartLight() const
@@ -278,97 +552,87 @@ namespace SceneUtil
     {
         osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
 
-        if (!mLightManager)
+        osg::StateSet* stateset = NULL;
         {
-            mLightManager = findLightManager(nv->getNodePath());
-            if (!mLightManager)
-            {
-                traverse(node, nv);
-                return;
-            }
+            // Different cameras may cull the node in parallel
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            stateset = getLightListStateSet(node, cv);
         }
 
-        if (!(cv->getCurrentCamera()->getCullMask() & mLightManager->getLightingMask()))
+        if (stateset)
         {
+            cv->pushStateSet(stateset);
+
             traverse(node, nv);
-            return;
+
+            cv->popStateSet();
         }
+        else
+            traverse(node, nv);
+    }
 
-        // Possible optimizations:
-        // - cull list of lights by the camera frustum
-        // - organize lights in a quad tree
+    osg::StateSet* LightListCallback::getLightListStateSet(osg::Node *node, osgUtil::CullVisitor *cv)
+    {
+        if (!mLightManager)
+        {
+            mLightManager = findLightManager(cv->getNodePath());
+            if (!mLightManager)
+                return NULL;
+        }
 
+        if (!(cv->getCurrentCamera()->getCullMask() & mLightManager->getLightingMask()))
+            return NULL;
 
         // update light list if necessary
         // makes sure we don't update it more than once per frame when rendering with multiple cameras
-        if (mLastFrameNumber != nv->getTraversalNumber())
+        if (mLastFrameNumber != cv->getTraversalNumber())
         {
-            mLastFrameNumber = nv->getTraversalNumber();
+            mLastFrameNumber = cv->getTraversalNumber();
 
             // Don't use Camera::getViewMatrix, that one might be relative to another camera!
             const osg::RefMatrix* viewMatrix = cv->getCurrentRenderStage()->getInitialViewMatrix();
-            const std::vector<LightManager::LightSourceViewBound>& lights = mLightManager->getLightsInViewSpace(cv->getCurrentCamera(), viewMatrix);
 
             // we do the intersections in view space
             osg::BoundingSphere nodeBound = node->getBound();
             osg::Matrixf mat = *cv->getModelViewMatrix();
             transformBoundingSphere(mat, nodeBound);
 
-            mLightList.clear();
-            for (unsigned int i=0; i<lights.size(); ++i)
-            {
-                const LightManager::LightSourceViewBound& l = lights[i];
-                if (l.mViewBound.intersects(nodeBound))
-                    mLightList.push_back(&l);
-            }
+            mLightManager->getIntersectingLights(cv->getCurrentCamera(), viewMatrix, cv->getProjectionMatrix(), nodeBound, mLightList);
         }
-        if (mLightList.size())
-        {
-            unsigned int maxLights = static_cast<unsigned int> (8 - mLightManager->getStartLight());
+        if (mLightList.empty())
+            return NULL;
 
-            osg::StateSet* stateset = NULL;
+        unsigned int maxLights = static_cast<unsigned int> (8 - mLightManager->getStartLight());
 
-            if (mLightList.size() > maxLights)
-            {
-                // remove lights culled by this camera
-                LightManager::LightList lightList = mLightList;
-                for (LightManager::LightList::iterator it = lightList.begin(); it != lightList.end() && lightList.size() > maxLights; )
-                {
-                    osg::CullStack::CullingStack& stack = cv->getModelViewCullingStack();
+        if (mLightList.size() <= maxLights)
+            return mLightManager->getLightListStateSet(mLightList, cv->getTraversalNumber());
 
-                    osg::BoundingSphere bs = (*it)->mViewBound;
-                    bs._radius = bs._radius*2;
-                    osg::CullingSet& cullingSet = stack.front();
-                    if (cullingSet.isCulled(bs))
-                    {
-                        it = lightList.erase(it);
-                        continue;
-                    }
-                    else
-                        ++it;
-                }
+        // remove lights culled by this camera
+        LightManager::LightList lightList = mLightList;
+        for (LightManager::LightList::iterator it = lightList.begin(); it != lightList.end() && lightList.size() > maxLights; )
+        {
+            osg::CullStack::CullingStack& stack = cv->getModelViewCullingStack();
 
-                if (lightList.size() > maxLights)
-                {
-                    // sort by proximity to camera, then get rid of furthest away lights
-                    std::sort(lightList.begin(), lightList.end(), sortLights);
-                    while (lightList.size() > maxLights)
-                        lightList.pop_back();
-                }
-                stateset = mLightManager->getLightListStateSet(lightList, nv->getTraversalNumber());
+            osg::BoundingSphere bs = (*it)->mViewBound;
+            bs._radius = bs._radius*2;
+            osg::CullingSet& cullingSet = stack.front();
+            if (cullingSet.isCulled(bs))
+            {
+                it = lightList.erase(it);
+                continue;
             }
             else
-                stateset = mLightManager->getLightListStateSet(mLightList, nv->getTraversalNumber());
-
-
-            cv->pushStateSet(stateset);
-
-            traverse(node, nv);
+                ++it;
+        }
 
-            cv->popStateSet();
+        if (lightList.size() > maxLights)
+        {
+            // sort by proximity to camera, then get rid of furthest away lights
+            std::sort(lightList.begin(), lightList.end(), sortLights);
+            while (lightList.size() > maxLights)
+                lightList.pop_back();
         }
-        else
-            traverse(node, nv);
+        return mLightManager->getLightListStateSet(lightList, cv->getTraversalNumber());
     }
 
     void configureLight(osg::Light *light, float radius, bool isExterior, bool outQuadInLin, bool useQuadratic,
@@ -5,6 +5,14 @@
 
 #include <osg/Group>
 #include <osg/NodeVisitor>
+#include <osg/Uniform>
+
+#include <OpenThreads/Mutex>
+
+namespace osgUtil
+{
+    class CullVisitor;
+}
 
 namespace SceneUtil
 {
@@ -91,10 +99,19 @@ namespace SceneUtil
         unsigned int getLightingMask() const;
 
         /// Set the first light index that should be used by this manager, typically the number of directional lights in the scene.
+        /// @par Shaders can read the number of lights in use, including the first ones, from the "lightCount" int uniform.
         void setStartLight(int start);
 
         int getStartLight() const;
 
+        /// Bin the lights into a grid of view space clusters, once per camera and frame, so that a LightListCallback only
+        /// tests the lights in the clusters its node overlaps, rather than every light in the scene.
+        /// @par The grid divides the view frustum into the given number of tiles horizontally and vertically, and into the
+        /// given number of depth slices, which grow exponentially with the distance from the camera. Cameras without a
+        /// perspective projection test every light.
+        /// @note Pass 0 for any of the dimensions to test every light. Defaults to 0.
+        void setClusterGrid(unsigned int tilesX, unsigned int tilesY, unsigned int slices);
+
         /// Internal use only, called automatically by the LightManager's UpdateCallback
         void update();
 
@@ -119,8 +136,19 @@ namespace SceneUtil
 
         typedef std::vector<const LightSourceViewBound*> LightList;
 
+        /// Get the lights of getLightsInViewSpace() that intersect the given view space bound, in the same order.
+        void getIntersectingLights(osg::Camera* camera, const osg::RefMatrix* viewMatrix, const osg::RefMatrix* projectionMatrix,
+                                   const osg::BoundingSphere& viewBound, LightList& lightList);
+
+        /// Get a state set applying the given lights, cached for as long as the same combination of lights is used.
+        /// @par State sets of combinations that were not used for a while are kept in a pool, and reused for new
+        /// combinations of as many lights, so that changes to the lights in view do not allocate new state sets.
         osg::ref_ptr<osg::StateSet> getLightListStateSet(const LightList& lightList, unsigned int frameNum);
 
+        /// The number of light list state sets found in the cache and created or taken from the pool, by the cull
+        /// traversals since the last update(), and the number of state sets currently cached.
+        void getStateSetCacheStats(unsigned int& hits, unsigned int& misses, unsigned int& cached) const;
+
     private:
         // Lights collected from the scene graph. Only valid during the cull traversal.
         std::vector<LightSourceTransform> mLights;
@@ -128,13 +156,75 @@ namespace SceneUtil
         typedef std::vector<LightSourceViewBound> LightSourceViewBoundCollection;
         std::map<osg::observer_ptr<osg::Camera>, LightSourceViewBoundCollection> mLightsInViewSpace;
 
-        // < Light list hash , StateSet >
-        typedef std::map<size_t, osg::ref_ptr<osg::StateSet> > LightStateSetMap;
+        unsigned int mClusterTilesX;
+        unsigned int mClusterTilesY;
+        unsigned int mClusterSlices;
+
+        struct ClusterRange
+        {
+            unsigned int mMinX, mMaxX;
+            unsigned int mMinY, mMaxY;
+            unsigned int mMinSlice, mMaxSlice;
+        };
+
+        struct LightGrid
+        {
+            LightGrid() : mBuiltFrame(0) {}
+
+            // The value of mUpdateCount when the grid was last built. The grid's storage is kept between frames.
+            unsigned int mBuiltFrame;
+            // False if the camera has no perspective projection
+            bool mValid;
+            // The frustum at a distance of 1 from the camera
+            float mLeft, mRight, mBottom, mTop;
+            float mNear;
+            // Slice index per log(distance / near)
+            float mSliceScale;
+            // Indices into the lights in view space, for each cluster from mOffsets[cluster] to mOffsets[cluster+1]
+            std::vector<unsigned int> mOffsets;
+            std::vector<unsigned int> mIndices;
+            // Marks the lights already found by the query with the same number, so each light is tested once
+            std::vector<unsigned int> mQueryStamps;
+            unsigned int mQueryNumber;
+            std::vector<unsigned int> mCandidates;
+            // Scratch space for building the grid
+            std::vector<ClusterRange> mRanges;
+            std::vector<unsigned int> mNext;
+        };
+        std::map<osg::observer_ptr<osg::Camera>, LightGrid> mLightGrids;
+        // Counts the calls to update(), starting at 1
+        unsigned int mUpdateCount;
+
+        LightGrid& getLightGrid(osg::Camera* camera, const LightSourceViewBoundCollection& lights, const osg::RefMatrix* projectionMatrix);
+
+        ClusterRange getClusterRange(const LightGrid& grid, const osg::BoundingSphere& viewBound) const;
+
+        struct LightStateSetEntry
+        {
+            osg::ref_ptr<osg::StateSet> mStateSet;
+            osg::ref_ptr<osg::Uniform> mLightCount;
+            // The value of mUpdateCount when the state set was last used
+            unsigned int mLastUsed;
+        };
+
+        // < Light ids , StateSet >, one map per frame parity, since the lights are double buffered
+        typedef std::map<std::vector<int>, LightStateSetEntry> LightStateSetMap;
         LightStateSetMap mStateSetCache[2];
+        // State sets evicted from the cache, by the number of lights they hold
+        std::vector<std::vector<LightStateSetEntry> > mStateSetPool;
+        // Scratch space for the cache key
+        std::vector<int> mLightIds;
+
+        unsigned int mStateSetHits;
+        unsigned int mStateSetMisses;
 
         int mStartLight;
 
         unsigned int mLightingMask;
+
+        // Guards the per camera maps and the state set cache, so that different cameras can be culled in parallel.
+        // The lights themselves are only changed by the update traversal.
+        mutable OpenThreads::Mutex mMutex;
     };
 
     /// To receive lighting, objects must be decorated by a LightListCallback. Light list callbacks must be added via
@@ -144,7 +234,7 @@ namespace SceneUtil
     /// light lists can result in degraded performance. Too coarse grained light lists can result in lights no longer
     /// rendering when the size of a light list exceeds the OpenGL limit on the number of concurrent lights (8). A good
     /// starting point is to attach a LightListCallback to each game object's base node.
-    /// @note Not thread safe for CullThreadPerCamera threading mode.
+    /// @note Safe for the cull traversals of different cameras in parallel, e.g. in the CullThreadPerCamera threading mode.
     class LightListCallback : public osg::NodeCallback
     {
     public:
@@ -163,6 +253,10 @@ namespace SceneUtil
         void operator()(osg::Node* node, osg::NodeVisitor* nv);
 
     private:
+        /// The state set to push for \a node, or NULL if it is not lit by the LightManager.
+        osg::StateSet* getLightListStateSet(osg::Node* node, osgUtil::CullVisitor* cv);
+
+        OpenThreads::Mutex mMutex;
         LightManager* mLightManager;
         unsigned int mLastFrameNumber;
         LightManager::LightList mLightList;
@@ -0,0 +1,77 @@
+#include "occlusionquery.hpp"
+
+#include <osg/OcclusionQueryNode>
+
+namespace SceneUtil
+{
+
+    // Set on the query node, counts the nodes in the view frustum
+    class OcclusionQueries::TestedCallback : public osg::NodeCallback
+    {
+    public:
+        TestedCallback(OcclusionQueries* queries)
+            : mQueries(queries)
+        {
+        }
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            ++mQueries->mTested;
+            traverse(node, nv);
+        }
+
+    private:
+        osg::ref_ptr<OcclusionQueries> mQueries;
+    };
+
+    // Set on the child of the query node, counts the nodes that passed their query
+    class OcclusionQueries::DrawnCallback : public osg::NodeCallback
+    {
+    public:
+        DrawnCallback(OcclusionQueries* queries)
+            : mQueries(queries)
+        {
+        }
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            ++mQueries->mDrawn;
+            traverse(node, nv);
+        }
+
+    private:
+        osg::ref_ptr<OcclusionQueries> mQueries;
+    };
+
+    OcclusionQueries::OcclusionQueries(unsigned int visibilityThreshold, unsigned int queryFrameCount)
+        : mVisibilityThreshold(visibilityThreshold)
+        , mQueryFrameCount(queryFrameCount)
+        , mTested(0)
+        , mDrawn(0)
+    {
+    }
+
+    osg::ref_ptr<osg::OcclusionQueryNode> OcclusionQueries::createQueryNode(osg::Node *child)
+    {
+        osg::ref_ptr<osg::OcclusionQueryNode> queryNode = new osg::OcclusionQueryNode;
+        queryNode->setVisibilityThreshold(mVisibilityThreshold);
+        queryNode->setQueryFrameCount(mQueryFrameCount);
+        queryNode->addCullCallback(new TestedCallback(this));
+        child->addCullCallback(new DrawnCallback(this));
+        queryNode->addChild(child);
+        return queryNode;
+    }
+
+    void OcclusionQueries::getStats(unsigned int &tested, unsigned int &drawn) const
+    {
+        tested = mTested;
+        drawn = mDrawn;
+    }
+
+    void OcclusionQueries::resetStats()
+    {
+        mTested.exchange(0);
+        mDrawn.exchange(0);
+    }
+
+}
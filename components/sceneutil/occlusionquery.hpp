@@ -0,0 +1,53 @@
+#ifndef OPENMW_COMPONENTS_SCENEUTIL_OCCLUSIONQUERY_H
+#define OPENMW_COMPONENTS_SCENEUTIL_OCCLUSIONQUERY_H
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+#include <OpenThreads/Atomic>
+
+namespace osg
+{
+    class Node;
+    class OcclusionQueryNode;
+}
+
+namespace SceneUtil
+{
+
+    /// @brief Creates the osg::OcclusionQueryNodes of a scene with the same settings, and counts how many nodes they culled.
+    /// @par A query node draws the bounding box of its children after the opaque geometry, and asks the GPU how many of its
+    /// pixels passed the depth test. The next cull of the same camera then skips the children if too few did, so the results
+    /// lag one frame or more behind.
+    /// @note The counts are atomic, so different cameras may be culled in parallel.
+    class OcclusionQueries : public osg::Referenced
+    {
+    public:
+        /// @param visibilityThreshold How many pixels of the bounding box have to be visible for the children to be drawn.
+        /// @param queryFrameCount Frames between the queries of a node. The last result is used in between.
+        OcclusionQueries(unsigned int visibilityThreshold, unsigned int queryFrameCount);
+
+        /// Create a query node with the given child.
+        osg::ref_ptr<osg::OcclusionQueryNode> createQueryNode(osg::Node* child);
+
+        /// The number of query nodes that were culled, and how many of them drew their children, since the last resetStats().
+        void getStats(unsigned int& tested, unsigned int& drawn) const;
+
+        void resetStats();
+
+    private:
+        class TestedCallback;
+        class DrawnCallback;
+        friend class TestedCallback;
+        friend class DrawnCallback;
+
+        unsigned int mVisibilityThreshold;
+        unsigned int mQueryFrameCount;
+
+        OpenThreads::Atomic mTested;
+        OpenThreads::Atomic mDrawn;
+    };
+
+}
+
+#endif
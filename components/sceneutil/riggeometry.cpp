@@ -3,10 +3,17 @@
 #include <stdexcept>
 #include <iostream>
 #include <cstdlib>
+#include <algorithm>
 
 #include <osg/Version>
 #include <osg/MatrixTransform>
+#include <osg/Material>
+#include <osg/Program>
+#include <osg/Uniform>
 
+#include <OpenThreads/ScopedLock>
+
+#include "clone.hpp"
 #include "skeleton.hpp"
 #include "util.hpp"
 
@@ -66,10 +73,56 @@ public:
     virtual osg::BoundingBox computeBound(const osg::Drawable&) const  { return osg::BoundingBox(); }
 };
 
+// Vertex attribute locations of the skinning shader. Not aliased by the fixed function arrays on NVIDIA drivers.
+const unsigned int boneIndicesAttribute = 6;
+const unsigned int boneWeightsAttribute = 7;
+
+// The most bones that skin a vertex in the shader
+const unsigned int maxVertexBones = 4;
+
+bool sortByWeight(const std::pair<unsigned int, float>& left, const std::pair<unsigned int, float>& right)
+{
+    return left.second > right.second;
+}
+
+/// The osg::Material::ColorMode of the material the geometry is drawn with, as the colorMode uniform of the skinning shader.
+int getColorMode(const osg::Geometry& geometry, const osg::NodePath& path)
+{
+    if (!geometry.getColorArray())
+        return 0;
+
+    const osg::Material* material = NULL;
+    if (geometry.getStateSet())
+        material = static_cast<const osg::Material*>(geometry.getStateSet()->getAttribute(osg::StateAttribute::MATERIAL));
+    for (osg::NodePath::const_reverse_iterator it = path.rbegin(); !material && it != path.rend(); ++it)
+    {
+        if ((*it)->getStateSet())
+            material = static_cast<const osg::Material*>((*it)->getStateSet()->getAttribute(osg::StateAttribute::MATERIAL));
+    }
+    if (!material)
+        return 0;
+
+    switch (material->getColorMode())
+    {
+    case osg::Material::EMISSION:
+        return 1;
+    case osg::Material::AMBIENT:
+        return 2;
+    case osg::Material::AMBIENT_AND_DIFFUSE:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+osg::ref_ptr<osg::Program> RigGeometry::sSkinningProgram;
+
 RigGeometry::RigGeometry()
     : mSkeleton(NULL)
     , mLastFrameNumber(0)
     , mBoundsFirstFrame(true)
+    , mPoseRadius(0.f)
+    , mOutOfViewBounds(false)
 {
     setCullCallback(new UpdateRigGeometry);
     setUpdateCallback(new UpdateRigBounds);
@@ -83,6 +136,8 @@ RigGeometry::RigGeometry(const RigGeometry &copy, const osg::CopyOp &copyop)
     , mInfluenceMap(copy.mInfluenceMap)
     , mLastFrameNumber(0)
     , mBoundsFirstFrame(true)
+    , mPoseRadius(0.f)
+    , mOutOfViewBounds(false)
 {
     setSourceGeometry(copy.mSourceGeometry);
 }
@@ -122,8 +177,24 @@ void RigGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeometry)
             setVertexAttribArray(vi,array);
     }
 
-    setVertexArray(dynamic_cast<osg::Array*>(from.getVertexArray()->clone(osg::CopyOp::DEEP_COPY_ALL)));
-    setNormalArray(dynamic_cast<osg::Array*>(from.getNormalArray()->clone(osg::CopyOp::DEEP_COPY_ALL)), osg::Array::BIND_PER_VERTEX);
+    // Only the skinned vertices and normals are our own, everything else is shared with the source geometry
+    setVertexArray(cloneOutputArray(from.getVertexArray()));
+    setNormalArray(cloneOutputArray(from.getNormalArray()), osg::Array::BIND_PER_VERTEX);
+}
+
+void RigGeometry::setSkinningProgram(osg::Program *program)
+{
+    if (program)
+    {
+        program->addBindAttribLocation("boneIndices", boneIndicesAttribute);
+        program->addBindAttribLocation("boneWeights", boneWeightsAttribute);
+    }
+    sSkinningProgram = program;
+}
+
+unsigned int RigGeometry::getMaxBones()
+{
+    return 64;
 }
 
 bool RigGeometry::initFromParentSkeleton(osg::NodeVisitor* nv)
@@ -151,8 +222,9 @@ bool RigGeometry::initFromParentSkeleton(osg::NodeVisitor* nv)
         return false;
     }
 
-    typedef std::map<unsigned short, std::vector<BoneWeight> > Vertex2BoneMap;
-    Vertex2BoneMap vertex2BoneMap;
+    const bool skinInShader = sSkinningProgram && mInfluenceMap->mMap.size() <= getMaxBones();
+
+    Vertex2BoneIndexMap vertex2BoneIndexMap;
     for (std::map<std::string, BoneInfluence>::const_iterator it = mInfluenceMap->mMap.begin(); it != mInfluenceMap->mMap.end(); ++it)
     {
         Bone* bone = mSkeleton->getBone(it->first);
@@ -164,51 +236,121 @@ bool RigGeometry::initFromParentSkeleton(osg::NodeVisitor* nv)
 
         mBoneSphereMap[bone] = it->second.mBoundSphere;
 
-        const BoneInfluence& bi = it->second;
+        const unsigned int boneIndex = mBones.size();
+        mBones.push_back(std::make_pair(bone, it->second.mInvBindMatrix));
 
         const std::map<unsigned short, float>& weights = it->second.mWeights;
         for (std::map<unsigned short, float>::const_iterator weightIt = weights.begin(); weightIt != weights.end(); ++weightIt)
-        {
-            std::vector<BoneWeight>& vec = vertex2BoneMap[weightIt->first];
+            vertex2BoneIndexMap[weightIt->first].push_back(std::make_pair(boneIndex, weightIt->second));
+    }
 
-            BoneWeight b = std::make_pair(std::make_pair(bone, bi.mInvBindMatrix), weightIt->second);
+    if (skinInShader && !mBones.empty())
+        initSkinningShader(vertex2BoneIndexMap, nv);
+    else
+        initInfluenceGroups(vertex2BoneIndexMap);
 
-            vec.push_back(b);
-        }
-    }
+    return true;
+}
 
-    for (Vertex2BoneMap::iterator it = vertex2BoneMap.begin(); it != vertex2BoneMap.end(); it++)
+void RigGeometry::initInfluenceGroups(const Vertex2BoneIndexMap &vertex2BoneIndexMap)
+{
+    typedef std::map<std::vector<std::pair<unsigned int, float> >, std::vector<unsigned short> > InfluenceGroupMap;
+    InfluenceGroupMap groups;
+    for (Vertex2BoneIndexMap::const_iterator it = vertex2BoneIndexMap.begin(); it != vertex2BoneIndexMap.end(); ++it)
+        groups[it->second].push_back(it->first);
+
+    mInfluenceGroups.reserve(groups.size());
+    mGroupVertices.reserve(vertex2BoneIndexMap.size());
+    for (InfluenceGroupMap::const_iterator it = groups.begin(); it != groups.end(); ++it)
     {
-        mBone2VertexMap[it->second].push_back(it->first);
+        for (std::vector<std::pair<unsigned int, float> >::const_iterator influenceIt = it->first.begin(); influenceIt != it->first.end(); ++influenceIt)
+        {
+            mInfluenceBones.push_back(influenceIt->first);
+            mInfluenceWeights.push_back(influenceIt->second);
+        }
+        mGroupVertices.insert(mGroupVertices.end(), it->second.begin(), it->second.end());
+
+        InfluenceGroup group;
+        group.mInfluenceEnd = mInfluenceBones.size();
+        group.mVertexEnd = mGroupVertices.size();
+        mInfluenceGroups.push_back(group);
     }
 
-    return true;
+    mSkinMatrices.resize(mBones.size());
 }
 
-void accumulateMatrix(const osg::Matrixf& invBindMatrix, const osg::Matrixf& matrix, float weight, osg::Matrixf& result)
+void RigGeometry::initSkinningShader(const Vertex2BoneIndexMap &vertex2BoneIndexMap, osg::NodeVisitor *nv)
 {
-    osg::Matrixf m = invBindMatrix * matrix;
-    float* ptr = m.ptr();
-    float* ptrresult = result.ptr();
-    ptrresult[0] += ptr[0] * weight;
-    ptrresult[1] += ptr[1] * weight;
-    ptrresult[2] += ptr[2] * weight;
+    const unsigned int numVertices = mSourceGeometry->getVertexArray()->getNumElements();
+    // Vertices without bones keep zero weights, which the shader leaves in place, like the CPU skinning does
+    osg::ref_ptr<osg::Vec4Array> boneIndices (new osg::Vec4Array(numVertices));
+    osg::ref_ptr<osg::Vec4Array> boneWeights (new osg::Vec4Array(numVertices));
 
-    ptrresult[4] += ptr[4] * weight;
-    ptrresult[5] += ptr[5] * weight;
-    ptrresult[6] += ptr[6] * weight;
+    for (Vertex2BoneIndexMap::const_iterator it = vertex2BoneIndexMap.begin(); it != vertex2BoneIndexMap.end(); ++it)
+    {
+        if (it->first >= numVertices)
+            continue;
+
+        std::vector<std::pair<unsigned int, float> > influences = it->second;
+        float weightScale = 1.f;
+        if (influences.size() > maxVertexBones)
+        {
+            // Keep the strongest bones, scaled up so that the vertex is not pulled towards the origin
+            std::sort(influences.begin(), influences.end(), sortByWeight);
+            float total = 0.f;
+            float kept = 0.f;
+            for (unsigned int i=0; i<influences.size(); ++i)
+            {
+                total += influences[i].second;
+                if (i < maxVertexBones)
+                    kept += influences[i].second;
+            }
+            if (kept > 0.f)
+                weightScale = total / kept;
+            influences.resize(maxVertexBones);
+        }
+
+        for (unsigned int i=0; i<influences.size(); ++i)
+        {
+            (*boneIndices)[it->first][i] = static_cast<float>(influences[i].first);
+            (*boneWeights)[it->first][i] = influences[i].second * weightScale;
+        }
+    }
 
-    ptrresult[8] += ptr[8] * weight;
-    ptrresult[9] += ptr[9] * weight;
-    ptrresult[10] += ptr[10] * weight;
+    setVertexAttribArray(boneIndicesAttribute, boneIndices, osg::Array::BIND_PER_VERTEX);
+    setVertexAttribArray(boneWeightsAttribute, boneWeights, osg::Array::BIND_PER_VERTEX);
+
+    // The shader does not write to the vertices, so they are shared with the source geometry and can stay on the GPU
+    setVertexArray(mSourceGeometry->getVertexArray());
+    if (mSourceGeometry->getNormalArray())
+        setNormalArray(mSourceGeometry->getNormalArray(), osg::Array::BIND_PER_VERTEX);
+    setUseVertexBufferObjects(true);
+
+    // The state set is shared with the source geometry, but the bone matrices are our own
+    osg::ref_ptr<osg::StateSet> stateset = getStateSet() ? osg::clone(getStateSet(), osg::CopyOp::SHALLOW_COPY) : new osg::StateSet;
+    stateset->setAttributeAndModes(sSkinningProgram, osg::StateAttribute::ON);
+    mBoneMatrices = new osg::Uniform(osg::Uniform::FLOAT_MAT4, "boneMatrices", mBones.size());
+    stateset->addUniform(mBoneMatrices);
+    stateset->addUniform(new osg::Uniform("colorMode", getColorMode(*this, nv->getNodePath())));
+    // Overridden by the glow effect, see MWRender::Animation
+    stateset->addUniform(new osg::Uniform("sphereMapTexUnit1", false));
+    setStateSet(stateset);
+}
 
-    ptrresult[12] += ptr[12] * weight;
-    ptrresult[13] += ptr[13] * weight;
-    ptrresult[14] += ptr[14] * weight;
+// Adds up all 16 elements, without branches, so that the compiler can vectorize the loop.
+// The caller restores the fourth column.
+inline void accumulateMatrix(const osg::Matrixf& matrix, float weight, osg::Matrixf& result)
+{
+    const float* ptr = matrix.ptr();
+    float* ptrresult = result.ptr();
+    for (int i=0; i<16; ++i)
+        ptrresult[i] += ptr[i] * weight;
 }
 
 void RigGeometry::update(osg::NodeVisitor* nv)
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
     if (!mSkeleton)
     {
         std::cerr << "RigGeometry rendering with no skeleton, should have been initialized by UpdateVisitor" << std::endl;
@@ -222,39 +364,59 @@ void RigGeometry::update(osg::NodeVisitor* nv)
 
     if (mLastFrameNumber == nv->getTraversalNumber())
         return;
+    // The bone controllers were skipped by the level of detail of the skeleton, this copy keeps the pose it was last skinned with
+    if (mLastFrameNumber != 0 && !mSkeleton->getBonesChanged(nv->getTraversalNumber()))
+        return;
     mLastFrameNumber = nv->getTraversalNumber();
 
     mSkeleton->updateBoneMatrices(nv);
 
+    if (mBoneMatrices)
+    {
+        for (unsigned int i=0; i<mBones.size(); ++i)
+            mBoneMatrices->setElement(i, mBones[i].second * mBones[i].first->mMatrixInSkeletonSpace * mGeomToSkelMatrix);
+        return;
+    }
+
     // skinning
-    osg::Vec3Array* positionSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getVertexArray());
-    osg::Vec3Array* normalSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getNormalArray());
+    for (unsigned int i=0; i<mBones.size(); ++i)
+        mSkinMatrices[i] = mBones[i].second * mBones[i].first->mMatrixInSkeletonSpace;
+
+    const osg::Vec3Array& positionSrc = *static_cast<osg::Vec3Array*>(mSourceGeometry->getVertexArray());
+    const osg::Vec3Array& normalSrc = *static_cast<osg::Vec3Array*>(mSourceGeometry->getNormalArray());
 
     osg::Vec3Array* positionDst = static_cast<osg::Vec3Array*>(getVertexArray());
     osg::Vec3Array* normalDst = static_cast<osg::Vec3Array*>(getNormalArray());
 
-    for (Bone2VertexMap::const_iterator it = mBone2VertexMap.begin(); it != mBone2VertexMap.end(); ++it)
+    unsigned int influence = 0;
+    unsigned int groupVertex = 0;
+    for (std::vector<InfluenceGroup>::const_iterator it = mInfluenceGroups.begin(); it != mInfluenceGroups.end(); ++it)
     {
         osg::Matrixf resultMat  (0, 0, 0, 0,
                                 0, 0, 0, 0,
                                 0, 0, 0, 0,
-                                0, 0, 0, 1);
+                                0, 0, 0, 0);
 
-        for (std::vector<BoneWeight>::const_iterator weightIt = it->first.begin(); weightIt != it->first.end(); ++weightIt)
-        {
-            Bone* bone = weightIt->first.first;
-            const osg::Matrix& invBindMatrix = weightIt->first.second;
-            float weight = weightIt->second;
-            const osg::Matrixf& boneMatrix = bone->mMatrixInSkeletonSpace;
-            accumulateMatrix(invBindMatrix, boneMatrix, weight, resultMat);
-        }
+        for (; influence < it->mInfluenceEnd; ++influence)
+            accumulateMatrix(mSkinMatrices[mInfluenceBones[influence]], mInfluenceWeights[influence], resultMat);
+
+        float* m = resultMat.ptr();
+        m[3] = m[7] = m[11] = 0.f;
+        m[15] = 1.f;
         resultMat = resultMat * mGeomToSkelMatrix;
 
-        for (std::vector<unsigned short>::const_iterator vertexIt = it->second.begin(); vertexIt != it->second.end(); ++vertexIt)
+        // The matrix is affine, so unlike Matrixf::preMult this does not need to divide by w
+        for (; groupVertex < it->mVertexEnd; ++groupVertex)
         {
-            unsigned short vertex = *vertexIt;
-            (*positionDst)[vertex] = resultMat.preMult((*positionSrc)[vertex]);
-            (*normalDst)[vertex] = osg::Matrix::transform3x3((*normalSrc)[vertex], resultMat);
+            const unsigned short vertex = mGroupVertices[groupVertex];
+            const osg::Vec3f& position = positionSrc[vertex];
+            (*positionDst)[vertex].set(position.x() * m[0] + position.y() * m[4] + position.z() * m[8] + m[12],
+                                       position.x() * m[1] + position.y() * m[5] + position.z() * m[9] + m[13],
+                                       position.x() * m[2] + position.y() * m[6] + position.z() * m[10] + m[14]);
+            const osg::Vec3f& normal = normalSrc[vertex];
+            (*normalDst)[vertex].set(normal.x() * m[0] + normal.y() * m[4] + normal.z() * m[8],
+                                     normal.x() * m[1] + normal.y() * m[5] + normal.z() * m[9],
+                                     normal.x() * m[2] + normal.y() * m[6] + normal.z() * m[10]);
         }
     }
 
@@ -274,6 +436,18 @@ void RigGeometry::updateBounds(osg::NodeVisitor *nv)
         return;
     mBoundsFirstFrame = false;
 
+    if (mPoseRadius > 0.f && !mSkeleton->isInView(nv->getTraversalNumber()))
+    {
+        if (!mOutOfViewBounds)
+        {
+            osg::Vec3f extent (mPoseRadius, mPoseRadius, mPoseRadius);
+            setBounds(osg::BoundingBox(mSkeletonOrigin - extent, mSkeletonOrigin + extent));
+            mOutOfViewBounds = true;
+        }
+        return;
+    }
+    mOutOfViewBounds = false;
+
     mSkeleton->updateBoneMatrices(nv);
 
     updateGeomToSkelMatrix(nv);
@@ -287,6 +461,18 @@ void RigGeometry::updateBounds(osg::NodeVisitor *nv)
         box.expandBy(bs);
     }
 
+    if (box.valid())
+    {
+        mSkeletonOrigin = mGeomToSkelMatrix.getTrans();
+        for (unsigned int i=0; i<8; ++i)
+            mPoseRadius = std::max(mPoseRadius, (box.corner(i) - mSkeletonOrigin).length());
+    }
+
+    setBounds(box);
+}
+
+void RigGeometry::setBounds(const osg::BoundingBox &box)
+{
     _boundingBox = box;
     _boundingBoxComputed = true;
 #if OSG_VERSION_GREATER_OR_EQUAL(3,3,3)
@@ -4,6 +4,14 @@
 #include <osg/Geometry>
 #include <osg/Matrixf>
 
+#include <OpenThreads/Mutex>
+
+namespace osg
+{
+    class Program;
+    class Uniform;
+}
+
 namespace SceneUtil
 {
 
@@ -13,6 +21,11 @@ namespace SceneUtil
     /// @brief Mesh skinning implementation.
     /// @note A RigGeometry may be attached directly to a Skeleton, or somewhere below a Skeleton.
     /// Note though that the RigGeometry ignores any transforms below the Skeleton, so the attachment point is not that important.
+    /// @par With a skinning program set, the vertices are skinned by the vertex shader. The bone matrices are then uploaded as
+    /// a uniform array, and the bone indices and weights of the vertices are vertex attributes. Geometry with more bones than
+    /// the shader supports is still skinned on the CPU. The bounds are always updated on the CPU.
+    /// @par While the skeleton is out of view, the bounds are a box around the skeleton's origin that holds all poses
+    /// seen so far, so that the bone matrices do not need to be updated for them.
     class RigGeometry : public osg::Geometry
     {
     public:
@@ -38,6 +51,13 @@ namespace SceneUtil
 
         void setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeom);
 
+        /// Set the program to skin with, or NULL to skin on the CPU. See files/shaders/objects_skinned_vertex.glsl.
+        /// @note Affects the RigGeometries that were not drawn yet.
+        static void setSkinningProgram(osg::Program* program);
+
+        /// The size of the boneMatrices uniform array of the skinning shader.
+        static unsigned int getMaxBones();
+
         // Called automatically by our CullCallback
         void update(osg::NodeVisitor* nv);
 
@@ -55,14 +75,6 @@ namespace SceneUtil
 
         typedef std::pair<Bone*, osg::Matrixf> BoneBindMatrixPair;
 
-        typedef std::pair<BoneBindMatrixPair, float> BoneWeight;
-
-        typedef std::vector<unsigned short> VertexList;
-
-        typedef std::map<std::vector<BoneWeight>, VertexList> Bone2VertexMap;
-
-        Bone2VertexMap mBone2VertexMap;
-
         typedef std::map<Bone*, osg::BoundingSpheref> BoneSphereMap;
 
         BoneSphereMap mBoneSphereMap;
@@ -70,9 +82,49 @@ namespace SceneUtil
         unsigned int mLastFrameNumber;
         bool mBoundsFirstFrame;
 
+        // The first camera to cull the geometry in a frame skins it, while other cameras may cull it in parallel
+        OpenThreads::Mutex mMutex;
+
+        // The origin of the skeleton in geometry space, and the largest distance of the bounds from it so far
+        osg::Vec3f mSkeletonOrigin;
+        float mPoseRadius;
+        bool mOutOfViewBounds;
+
+        // The bones found in the skeleton. For skinning in the shader, in the order of the boneMatrices uniform.
+        std::vector<BoneBindMatrixPair> mBones;
+        osg::ref_ptr<osg::Uniform> mBoneMatrices;
+
+        // For skinning on the CPU, the vertices are grouped by the bones and weights that influence them, so that each
+        // skinning matrix is only blended once per group. The influences and the vertices of all groups are stored back
+        // to back, in the order of the groups.
+        struct InfluenceGroup
+        {
+            unsigned int mInfluenceEnd;
+            unsigned int mVertexEnd;
+        };
+        std::vector<InfluenceGroup> mInfluenceGroups;
+        // Indices into mBones
+        std::vector<unsigned int> mInfluenceBones;
+        std::vector<float> mInfluenceWeights;
+        std::vector<unsigned short> mGroupVertices;
+
+        // From the bind pose to skeleton space, per bone, updated by each update()
+        std::vector<osg::Matrixf> mSkinMatrices;
+
+        static osg::ref_ptr<osg::Program> sSkinningProgram;
+
         bool initFromParentSkeleton(osg::NodeVisitor* nv);
 
+        typedef std::map<unsigned short, std::vector<std::pair<unsigned int, float> > > Vertex2BoneIndexMap;
+
+        void initInfluenceGroups(const Vertex2BoneIndexMap& vertex2BoneIndexMap);
+
+        /// Set up the vertex attributes and the state for skinning in the shader.
+        void initSkinningShader(const Vertex2BoneIndexMap& vertex2BoneIndexMap, osg::NodeVisitor* nv);
+
         void updateGeomToSkelMatrix(osg::NodeVisitor* nv);
+
+        void setBounds(const osg::BoundingBox& box);
     };
 
 }
@@ -3,19 +3,25 @@
 #include <osg/Transform>
 #include <osg/MatrixTransform>
 
+#include <OpenThreads/ScopedLock>
+
 #include <components/misc/stringops.hpp>
 
 #include <iostream>
+#include <algorithm>
 
 namespace SceneUtil
 {
 
-class InitBoneCacheVisitor : public osg::NodeVisitor
+class CollectBonesVisitor : public osg::NodeVisitor
 {
 public:
-    InitBoneCacheVisitor(std::map<std::string, std::pair<osg::NodePath, osg::MatrixTransform*> >& cache)
+    /// @param table The table to fill with the names and the hierarchy of the bones, or NULL to only collect the nodes.
+    CollectBonesVisitor(std::vector<osg::ref_ptr<osg::MatrixTransform> >& bones, BoneTable* table)
         : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
-        , mCache(cache)
+        , mBones(bones)
+        , mTable(table)
+        , mParent(-1)
     {
     }
 
@@ -25,44 +31,102 @@ public:
         if (!bone)
             return;
 
-        mCache[Misc::StringUtils::lowerCase(bone->getName())] = std::make_pair(getNodePath(), bone);
+        const int index = static_cast<int>(mBones.size());
+        mBones.push_back(bone);
+        if (mTable)
+        {
+            mTable->mIndices[Misc::StringUtils::lowerCase(bone->getName())] = index;
+            mTable->mParents.push_back(mParent);
+        }
 
+        const int parent = mParent;
+        mParent = index;
         traverse(node);
+        mParent = parent;
     }
 private:
-    std::map<std::string, std::pair<osg::NodePath, osg::MatrixTransform*> >& mCache;
+    std::vector<osg::ref_ptr<osg::MatrixTransform> >& mBones;
+    BoneTable* mTable;
+    int mParent;
 };
 
+BoneTable::BoneTable()
+    : mInitialized(false)
+{
+}
+
 Skeleton::Skeleton()
-    : mBoneCacheInit(false)
+    : mBoneTable(new BoneTable)
+    , mBoneNodesInit(false)
     , mNeedToUpdateBoneMatrices(true)
     , mActive(true)
     , mLastFrameNumber(0)
+    , mLodDistance(0.f)
+    , mMaxUpdateInterval(1)
+    , mLastAnimatedFrame(0)
+    , mAnimationStartFrame(0)
+    , mLastCullFrame(0)
+    , mViewDistance(0.f)
 {
 
 }
 
 Skeleton::Skeleton(const Skeleton &copy, const osg::CopyOp &copyop)
     : osg::Group(copy, copyop)
-    , mBoneCacheInit(false)
+    , mBoneTable(copy.mBoneTable)
+    , mBoneNodesInit(false)
     , mNeedToUpdateBoneMatrices(true)
     , mActive(copy.mActive)
     , mLastFrameNumber(0)
+    , mLodDistance(copy.mLodDistance)
+    , mMaxUpdateInterval(copy.mMaxUpdateInterval)
+    , mLastAnimatedFrame(0)
+    , mAnimationStartFrame(0)
+    , mLastCullFrame(0)
+    , mViewDistance(0.f)
 {
-
+    initBoneNodes();
 }
 
-Bone* Skeleton::getBone(const std::string &name)
+void Skeleton::initBoneNodes()
 {
-    if (!mBoneCacheInit)
+    mBoneNodesInit = true;
+
     {
-        InitBoneCacheVisitor visitor(mBoneCache);
-        accept(visitor);
-        mBoneCacheInit = true;
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mBoneTable->mMutex);
+        if (!mBoneTable->mInitialized)
+        {
+            CollectBonesVisitor visitor(mBoneNodes, mBoneTable.get());
+            accept(visitor);
+            mBoneTable->mInitialized = true;
+            return;
+        }
     }
 
-    BoneCache::iterator found = mBoneCache.find(Misc::StringUtils::lowerCase(name));
-    if (found == mBoneCache.end())
+    mBoneNodes.reserve(mBoneTable->mParents.size());
+    CollectBonesVisitor visitor(mBoneNodes, NULL);
+    accept(visitor);
+
+    // A copy of a skeleton that was changed after it was cloned, the shared table does not apply to it
+    if (mBoneNodes.size() != mBoneTable->mParents.size())
+    {
+        mBoneNodes.clear();
+        mBoneTable = new BoneTable;
+        initBoneNodes();
+    }
+}
+
+Bone* Skeleton::getBone(const std::string &name)
+{
+    if (!mBoneNodesInit)
+        initBoneNodes();
+
+    BoneTable::IndexMap::const_iterator found = mBoneTable->mIndices.find(Misc::StringUtils::lowerCase(name));
+    if (found == mBoneTable->mIndices.end())
+        return NULL;
+
+    // The node was removed from the skeleton since the nodes were collected
+    if (mBoneNodes[found->second]->getNumParents() == 0)
         return NULL;
 
     // find or insert in the bone hierarchy
@@ -72,18 +136,19 @@ Bone* Skeleton::getBone(const std::string &name)
         mRootBone.reset(new Bone);
     }
 
-    const osg::NodePath& path = found->second.first;
+    std::vector<unsigned int> path;
+    for (int index = found->second; index != -1; index = mBoneTable->mParents[index])
+        path.push_back(index);
+
     Bone* bone = mRootBone.get();
-    for (osg::NodePath::const_iterator it = path.begin(); it != path.end(); ++it)
+    for (std::vector<unsigned int>::reverse_iterator it = path.rbegin(); it != path.rend(); ++it)
     {
-        osg::MatrixTransform* matrixTransform = dynamic_cast<osg::MatrixTransform*>(*it);
-        if (!matrixTransform)
-            continue;
+        osg::MatrixTransform* matrixTransform = mBoneNodes[*it].get();
 
         Bone* child = NULL;
         for (unsigned int i=0; i<bone->mChildren.size(); ++i)
         {
-            if (bone->mChildren[i]->mNode == *it)
+            if (bone->mChildren[i]->mNode == matrixTransform)
             {
                 child = bone->mChildren[i];
                 break;
@@ -106,6 +171,8 @@ Bone* Skeleton::getBone(const std::string &name)
 
 void Skeleton::updateBoneMatrices(osg::NodeVisitor* nv)
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
     if (nv->getTraversalNumber() != mLastFrameNumber)
         mNeedToUpdateBoneMatrices = true;
 
@@ -135,13 +202,64 @@ bool Skeleton::getActive() const
     return mActive;
 }
 
+void Skeleton::setLod(float distance, unsigned int maxUpdateInterval)
+{
+    mLodDistance = distance;
+    mMaxUpdateInterval = std::max(1u, maxUpdateInterval);
+}
+
+bool Skeleton::getBonesChanged(unsigned int frameNumber) const
+{
+    return mLodDistance <= 0.f || mLastAnimatedFrame == 0 || frameNumber == mLastAnimatedFrame;
+}
+
+bool Skeleton::isInView(unsigned int frameNumber) const
+{
+    return mLastCullFrame+1 >= frameNumber;
+}
+
+unsigned int Skeleton::getUpdateInterval(unsigned int frameNumber) const
+{
+    if (mLodDistance <= 0.f)
+        return 1;
+    if (!isInView(frameNumber))
+        return mMaxUpdateInterval;
+    const unsigned int steps = static_cast<unsigned int>(mViewDistance / mLodDistance);
+    if (steps == 0)
+        return 1;
+    return std::min(steps + 2, mMaxUpdateInterval);
+}
+
 void Skeleton::traverse(osg::NodeVisitor& nv)
 {
-    if (!getActive() && nv.getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR
-            // need to process at least 2 frames before shutting off update, since we need to have both frame-alternating RigGeometries initialized
-            // this would be more naturally handled if the double-buffering was implemented in RigGeometry itself rather than in a FrameSwitch decorator node
-            && mLastFrameNumber != 0 && mLastFrameNumber+2 <= nv.getTraversalNumber())
-        return;
+    if (nv.getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR)
+    {
+        if (!getActive()
+                // need to process at least 2 frames before shutting off update, since we need to have both frame-alternating RigGeometries initialized
+                // this would be more naturally handled if the double-buffering was implemented in RigGeometry itself rather than in a FrameSwitch decorator node
+                && mLastFrameNumber != 0 && mLastFrameNumber+2 <= nv.getTraversalNumber())
+            return;
+
+        const unsigned int frameNumber = nv.getTraversalNumber();
+        const bool secondFrame = mLastAnimatedFrame == mAnimationStartFrame && frameNumber == mLastAnimatedFrame+1;
+        if (!secondFrame)
+        {
+            if (mLastAnimatedFrame != 0 && frameNumber < mAnimationStartFrame + getUpdateInterval(frameNumber))
+                return;
+            mAnimationStartFrame = frameNumber;
+        }
+        mLastAnimatedFrame = frameNumber;
+    }
+    else if (nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
+    {
+        float distance = nv.getDistanceToViewPoint(getBound().center(), true);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        if (mLastCullFrame != nv.getTraversalNumber())
+            mViewDistance = distance;
+        else
+            mViewDistance = std::min(mViewDistance, distance);
+        mLastCullFrame = nv.getTraversalNumber();
+    }
     osg::Group::traverse(nv);
 }
 
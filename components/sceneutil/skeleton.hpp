@@ -2,6 +2,9 @@
 #define OPENMW_COMPONENTS_NIFOSG_SKELETON_H
 
 #include <osg/Group>
+#include <osg/MatrixTransform>
+
+#include <OpenThreads/Mutex>
 
 #include <memory>
 
@@ -30,6 +33,26 @@ namespace SceneUtil
         void operator=(const Bone&);
     };
 
+    /// @brief The names and the hierarchy of the bone nodes of a skeleton, in depth first order.
+    /// @par Shared by the skeletons cloned from the same template, so that each of them only needs to collect its own nodes.
+    class BoneTable : public osg::Referenced
+    {
+    public:
+        BoneTable();
+
+        bool mInitialized;
+
+        /// Lower case bone name -> index of the bone
+        typedef std::map<std::string, unsigned int> IndexMap;
+        IndexMap mIndices;
+
+        /// The index of the parent bone of each bone, or -1 for a bone that is not below another bone
+        std::vector<int> mParents;
+
+        // Guards the initialization, for templates cloned in different threads
+        OpenThreads::Mutex mMutex;
+    };
+
     /// @brief Handles the bone matrices for any number of child RigGeometries.
     /// @par Bones should be created as osg::MatrixTransform children of the skeleton.
     /// To be a referenced by a RigGeometry, a bone needs to have a unique name.
@@ -53,6 +76,20 @@ namespace SceneUtil
 
         bool getActive() const;
 
+        /// Animation level of detail: run the bone controllers only on two out of n+2 frames when the skeleton is n times the
+        /// given distance away from the camera, and out of maxUpdateInterval frames when it was not in view of any camera.
+        /// @param distance 0 to run the bone controllers every frame.
+        /// @note The controllers evaluate the animation time of the frame they run in, so the animation does not fall behind.
+        /// @note The controllers run on two consecutive frames, so that the two RigGeometries alternated by the FrameSwitch
+        /// of the NIF loader both get the update traversal and are skinned.
+        void setLod(float distance, unsigned int maxUpdateInterval);
+
+        /// Did the bone controllers run in the given frame? If not, the RigGeometries do not need to be skinned again.
+        bool getBonesChanged(unsigned int frameNumber) const;
+
+        /// Was the skeleton in view of a camera in the frame before the given one?
+        bool isInView(unsigned int frameNumber) const;
+
         void traverse(osg::NodeVisitor& nv);
 
     private:
@@ -60,15 +97,34 @@ namespace SceneUtil
         // As far as the scene graph goes we support multiple root bones.
         std::auto_ptr<Bone> mRootBone;
 
-        typedef std::map<std::string, std::pair<osg::NodePath, osg::MatrixTransform*> > BoneCache;
-        BoneCache mBoneCache;
-        bool mBoneCacheInit;
+        // The table is filled by the first copy of a template, from the cloned nodes before anything is attached to them.
+        // Skeletons that were not cloned fill their own table when the first bone is retrieved.
+        osg::ref_ptr<BoneTable> mBoneTable;
+        // The bone nodes of this skeleton, in the order of the table
+        std::vector<osg::ref_ptr<osg::MatrixTransform> > mBoneNodes;
+        bool mBoneNodesInit;
+
+        void initBoneNodes();
 
         bool mNeedToUpdateBoneMatrices;
 
         bool mActive;
 
         unsigned int mLastFrameNumber;
+
+        float mLodDistance;
+        unsigned int mMaxUpdateInterval;
+        // The last frame the bone controllers ran in, and the first of the two frames they last ran in
+        unsigned int mLastAnimatedFrame;
+        unsigned int mAnimationStartFrame;
+        // The last frame the skeleton was in view, and its smallest distance to the cameras in that frame
+        unsigned int mLastCullFrame;
+        float mViewDistance;
+
+        // Guards the bone matrices and the cull state, for the cull traversals of different cameras in parallel
+        OpenThreads::Mutex mMutex;
+
+        unsigned int getUpdateInterval(unsigned int frameNumber) const;
     };
 
 }
@@ -3,6 +3,8 @@
 #include <osg/Node>
 #include <osg/NodeVisitor>
 
+#include <climits>
+
 namespace SceneUtil
 {
 
@@ -18,9 +20,32 @@ namespace SceneUtil
                 mStateSets[i] = static_cast<osg::StateSet*>(osg::clone(src, osg::CopyOp::SHALLOW_COPY));
                 setDefaults(mStateSets[i]);
             }
+            mNumDirty = 2;
+        }
+
+        unsigned int index = nv->getTraversalNumber()%2;
+        if (mApplyOnChangeOnly)
+        {
+            if (nv->getTraversalNumber() != mLastTraversal)
+            {
+                if (mNumDirty == 0)
+                {
+                    traverse(node, nv);
+                    return;
+                }
+
+                // After frames without changes the node may have either StateSet. The draw traversal of the last frame
+                // may still use it, so write to the other one.
+                index = (node->getStateSet() == mStateSets[0]) ? 1 : 0;
+                --mNumDirty;
+                mLastTraversal = nv->getTraversalNumber();
+                mLastIndex = index;
+            }
+            else
+                index = mLastIndex;
         }
 
-        osg::StateSet* stateset = mStateSets[nv->getTraversalNumber()%2];
+        osg::StateSet* stateset = mStateSets[index];
         node->setStateSet(stateset);
 
         apply(stateset, nv);
@@ -34,12 +59,31 @@ namespace SceneUtil
         mStateSets[1] = NULL;
     }
 
+    void StateSetUpdater::setApplyOnChangeOnly(bool enabled)
+    {
+        mApplyOnChangeOnly = enabled;
+        dirty();
+    }
+
+    void StateSetUpdater::dirty()
+    {
+        mNumDirty = 2;
+    }
+
     StateSetUpdater::StateSetUpdater()
+        : mApplyOnChangeOnly(false)
+        , mNumDirty(2)
+        , mLastTraversal(UINT_MAX)
+        , mLastIndex(0)
     {
     }
 
     StateSetUpdater::StateSetUpdater(const StateSetUpdater &copy, const osg::CopyOp &copyop)
         : osg::NodeCallback(copy, copyop)
+        , mApplyOnChangeOnly(copy.mApplyOnChangeOnly)
+        , mNumDirty(2)
+        , mLastTraversal(UINT_MAX)
+        , mLastIndex(0)
     {
     }
 
@@ -39,8 +39,22 @@ namespace SceneUtil
         /// Reset mStateSets, forcing a setDefaults() on the next frame. Can be used to change the defaults if needed.
         void reset();
 
+        /// Only apply the state after it changed, rather than every frame. Once both StateSets hold the current state,
+        /// the node keeps the StateSet it has.
+        /// @note Subclasses that enable this have to call dirty() whenever the state they apply changes.
+        void setApplyOnChangeOnly(bool enabled);
+
+        /// The state changed, and has to be applied to both StateSets again. See setApplyOnChangeOnly().
+        void dirty();
+
     private:
         osg::ref_ptr<osg::StateSet> mStateSets[2];
+
+        bool mApplyOnChangeOnly;
+        // The number of StateSets that do not hold the current state yet
+        unsigned int mNumDirty;
+        unsigned int mLastTraversal;
+        unsigned int mLastIndex;
     };
 
     /// @brief A variant of the StateSetController that can be made up of multiple controllers all controlling the same target.
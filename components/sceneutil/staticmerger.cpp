@@ -0,0 +1,474 @@
+#include "staticmerger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Transform>
+#include <osg/Camera>
+#include <osg/Material>
+#include <osg/TexEnv>
+#include <osg/Texture2D>
+#include <osg/Version>
+
+#include <osgUtil/Optimizer>
+
+#include "lightmanager.hpp"
+
+namespace
+{
+
+    /// Checks that a subgraph only has what a merged copy can reproduce: plain groups, transforms and geometry, without
+    /// callbacks or anything that has to be drawn in order.
+    class CanMergeVisitor : public osg::NodeVisitor
+    {
+    public:
+        CanMergeVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mCanMerge(true)
+        {
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            if (!canMerge(node))
+                mCanMerge = false;
+
+            if (mCanMerge)
+                traverse(node);
+        }
+
+        virtual void apply(osg::Geode& geode)
+        {
+            if (typeid(geode) != typeid(osg::Geode) || !canMergeCallbacks(geode) || !canMerge(geode.getStateSet()))
+                mCanMerge = false;
+
+            for (unsigned int i=0; i<geode.getNumDrawables() && mCanMerge; ++i)
+                if (!canMerge(*geode.getDrawable(i)))
+                    mCanMerge = false;
+        }
+
+#if OSG_VERSION_GREATER_OR_EQUAL(3,3,3)
+        virtual void apply(osg::Drawable& drawable)
+        {
+            if (!canMerge(drawable))
+                mCanMerge = false;
+        }
+#endif
+
+        bool mCanMerge;
+
+    private:
+        static bool canMergeCallbacks(const osg::Node& node)
+        {
+            if (node.getUpdateCallback() || node.getEventCallback())
+                return false;
+
+            // Light lists are made for the merged tiles instead
+            const osg::NodeCallback* cullCallback = node.getCullCallback();
+            return !cullCallback || (dynamic_cast<const SceneUtil::LightListCallback*>(cullCallback) && !cullCallback->getNestedCallback());
+        }
+
+        static bool canMerge(const osg::Node& node)
+        {
+            if (!canMergeCallbacks(node) || !canMerge(node.getStateSet()))
+                return false;
+
+            // Not switches, LODs, sequences, light sources or other things that decide what is drawn
+            if (typeid(node) == typeid(osg::Group))
+                return true;
+            const osg::Transform* transform = node.asTransform();
+            return transform && !dynamic_cast<const osg::Camera*>(transform) && transform->getReferenceFrame() == osg::Transform::RELATIVE_RF;
+        }
+
+        static bool canMerge(const osg::Drawable& drawable)
+        {
+            // Not skinned or morphed geometry, particles or custom drawables
+            if (typeid(drawable) != typeid(osg::Geometry))
+                return false;
+            if (drawable.getUpdateCallback() || drawable.getCullCallback() || drawable.getDrawCallback() || !canMerge(drawable.getStateSet()))
+                return false;
+
+            const osg::Geometry* geometry = drawable.asGeometry();
+            if (!dynamic_cast<const osg::Vec3Array*>(geometry->getVertexArray()))
+                return false;
+            if (geometry->getNormalArray() && !dynamic_cast<const osg::Vec3Array*>(geometry->getNormalArray()))
+                return false;
+            return true;
+        }
+
+        static bool canMerge(const osg::StateSet* stateset)
+        {
+            if (!stateset)
+                return true;
+            if (stateset->getUpdateCallback() || stateset->getEventCallback())
+                return false;
+
+            // Transparent objects are sorted by distance, merging them would break the order
+            return stateset->getRenderingHint() != osg::StateSet::TRANSPARENT_BIN
+                    && stateset->getRenderBinMode() == osg::StateSet::INHERIT_RENDERBIN_DETAILS;
+        }
+    };
+
+    /// Collects the geometry of a subgraph, with its transform and the state sets on the path to it.
+    class CollectGeometryVisitor : public osg::NodeVisitor
+    {
+    public:
+        struct Entry
+        {
+            const osg::Geometry* mGeometry;
+            osg::Matrixf mTransform;
+            std::vector<const osg::StateSet*> mStateSets;
+        };
+
+        CollectGeometryVisitor(const osg::Matrixf& transform)
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+        {
+            mTransforms.push_back(transform);
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            pushStateSet(node.getStateSet());
+            traverse(node);
+            popStateSet(node.getStateSet());
+        }
+
+        virtual void apply(osg::Transform& transform)
+        {
+            osg::Matrix matrix (mTransforms.back());
+            transform.computeLocalToWorldMatrix(matrix, this);
+            mTransforms.push_back(matrix);
+            apply(static_cast<osg::Node&>(transform));
+            mTransforms.pop_back();
+        }
+
+        virtual void apply(osg::Geode& geode)
+        {
+            pushStateSet(geode.getStateSet());
+            for (unsigned int i=0; i<geode.getNumDrawables(); ++i)
+                add(*geode.getDrawable(i));
+            popStateSet(geode.getStateSet());
+        }
+
+#if OSG_VERSION_GREATER_OR_EQUAL(3,3,3)
+        virtual void apply(osg::Drawable& drawable)
+        {
+            add(drawable);
+        }
+#endif
+
+        std::vector<Entry> mEntries;
+
+    private:
+        void add(const osg::Drawable& drawable)
+        {
+            Entry entry;
+            entry.mGeometry = drawable.asGeometry();
+            entry.mTransform = mTransforms.back();
+            entry.mStateSets = mStateSets;
+            if (drawable.getStateSet())
+                entry.mStateSets.push_back(drawable.getStateSet());
+            mEntries.push_back(entry);
+        }
+
+        void pushStateSet(const osg::StateSet* stateset)
+        {
+            if (stateset)
+                mStateSets.push_back(stateset);
+        }
+
+        void popStateSet(const osg::StateSet* stateset)
+        {
+            if (stateset)
+                mStateSets.pop_back();
+        }
+
+        std::vector<osg::Matrix> mTransforms;
+        std::vector<const osg::StateSet*> mStateSets;
+    };
+
+    /// Copies geometry without its state set. The state sets of the added subgraphs are shared with other objects,
+    /// so they must not get new parents on a worker thread.
+    class CopyGeometryOp : public osg::CopyOp
+    {
+    public:
+        CopyGeometryOp()
+            : osg::CopyOp(osg::CopyOp::DEEP_COPY_ARRAYS|osg::CopyOp::DEEP_COPY_PRIMITIVES)
+        {
+        }
+
+        virtual osg::StateSet* operator() (const osg::StateSet*) const
+        {
+            return NULL;
+        }
+    };
+
+    osg::ref_ptr<osg::Geometry> copyGeometry(const osg::Geometry& geometry, osg::StateSet* stateset)
+    {
+        osg::ref_ptr<osg::Geometry> copy = new osg::Geometry(geometry, CopyGeometryOp());
+        copy->setUserDataContainer(NULL);
+        copy->setComputeBoundingBoxCallback(NULL);
+        copy->setStateSet(stateset);
+        copy->setDataVariance(osg::Object::STATIC);
+        return copy;
+    }
+
+    /// Does the instancing shader match what the fixed function pipeline would draw? It covers one texture,
+    /// modulated by the material and lit by the sun and the ambient light.
+    bool canInstance(const osg::Geometry& geometry, const osg::StateSet* stateset)
+    {
+        if (!stateset || !geometry.getTexCoordArray(0))
+            return false;
+
+        const osg::StateAttribute::GLModeValue lighting = stateset->getMode(GL_LIGHTING);
+        if (lighting != osg::StateAttribute::INHERIT && !(lighting & osg::StateAttribute::ON))
+            return false;
+
+        const osg::StateSet::TextureAttributeList& textureAttributes = stateset->getTextureAttributeList();
+        if (textureAttributes.size() != 1 || !dynamic_cast<const osg::Texture2D*>(stateset->getTextureAttribute(0, osg::StateAttribute::TEXTURE)))
+            return false;
+        for (osg::StateSet::AttributeList::const_iterator it = textureAttributes[0].begin(); it != textureAttributes[0].end(); ++it)
+        {
+            const osg::StateAttribute* attribute = it->second.first.get();
+            if (attribute->getType() == osg::StateAttribute::TEXTURE || attribute->getType() == osg::StateAttribute::TEXMAT)
+                continue;
+            const osg::TexEnv* texEnv = dynamic_cast<const osg::TexEnv*>(attribute);
+            if (!texEnv || texEnv->getMode() != osg::TexEnv::MODULATE)
+                return false;
+        }
+
+        const osg::Material* material = static_cast<const osg::Material*>(stateset->getAttribute(osg::StateAttribute::MATERIAL));
+        if (geometry.getColorArray() && material && material->getColorMode() != osg::Material::OFF
+                && material->getColorMode() != osg::Material::AMBIENT_AND_DIFFUSE)
+            return false;
+        return true;
+    }
+
+    bool usesVertexColors(const osg::Geometry& geometry, const osg::StateSet* stateset)
+    {
+        const osg::Material* material = static_cast<const osg::Material*>(stateset->getAttribute(osg::StateAttribute::MATERIAL));
+        return geometry.getColorArray() && material && material->getColorMode() == osg::Material::AMBIENT_AND_DIFFUSE;
+    }
+
+    /// Covers all instances of an instanced draw.
+    class InstancedBoundingBoxCallback : public osg::Drawable::ComputeBoundingBoxCallback
+    {
+    public:
+        InstancedBoundingBoxCallback()
+        {
+        }
+
+        InstancedBoundingBoxCallback(const osg::BoundingBox& bounds)
+            : mBoundingBox(bounds)
+        {
+        }
+
+        InstancedBoundingBoxCallback(const InstancedBoundingBoxCallback& copy, const osg::CopyOp& copyop)
+            : osg::Drawable::ComputeBoundingBoxCallback(copy, copyop)
+            , mBoundingBox(copy.mBoundingBox)
+        {
+        }
+
+        META_Object(SceneUtil, InstancedBoundingBoxCallback)
+
+        virtual osg::BoundingBox computeBound(const osg::Drawable&) const
+        {
+            return mBoundingBox;
+        }
+
+    private:
+        osg::BoundingBox mBoundingBox;
+    };
+
+    void transformGeometry(osg::Geometry& geometry, const osg::Matrixf& transform)
+    {
+        osg::Vec3Array* vertices = static_cast<osg::Vec3Array*>(geometry.getVertexArray());
+        for (osg::Vec3Array::iterator it = vertices->begin(); it != vertices->end(); ++it)
+            *it = *it * transform;
+        vertices->dirty();
+
+        if (osg::Vec3Array* normals = static_cast<osg::Vec3Array*>(geometry.getNormalArray()))
+        {
+            // Normals are transformed by the inverse transpose
+            osg::Matrixf inverse;
+            inverse.invert(transform);
+            for (osg::Vec3Array::iterator it = normals->begin(); it != normals->end(); ++it)
+            {
+                *it = osg::Matrixf::transform3x3(inverse, *it);
+                it->normalize();
+            }
+            normals->dirty();
+        }
+
+        geometry.dirtyBound();
+    }
+
+}
+
+namespace SceneUtil
+{
+
+    StaticMerger::StaticMerger(float tileSize, unsigned int minInstances)
+        : mTileSize(tileSize)
+        , mMinInstances(minInstances)
+        , mMergedNode(new osg::Group)
+    {
+    }
+
+    unsigned int StaticMerger::getMaxInstancesPerDraw()
+    {
+        // 128 vec4 of uniform space, well within the limits of hardware that supports instancing
+        return 32;
+    }
+
+    bool StaticMerger::canMerge(const osg::Node &node)
+    {
+        CanMergeVisitor visitor;
+        const_cast<osg::Node&>(node).accept(visitor);
+        return visitor.mCanMerge;
+    }
+
+    void StaticMerger::add(const osg::Node &node, const osg::Matrixf &transform)
+    {
+        CollectGeometryVisitor visitor (transform);
+        const_cast<osg::Node&>(node).accept(visitor);
+
+        const osg::Vec3f position = transform.getTrans();
+        std::pair<int, int> tile (static_cast<int>(std::floor(position.x() / mTileSize)),
+                                  static_cast<int>(std::floor(position.y() / mTileSize)));
+
+        for (std::vector<CollectGeometryVisitor::Entry>::const_iterator it = visitor.mEntries.begin(); it != visitor.mEntries.end(); ++it)
+        {
+            Source source;
+            source.mGeometry = it->mGeometry;
+            source.mTransform = it->mTransform;
+            source.mStateSet = getStateSet(it->mStateSets);
+            source.mTile = tile;
+            mSources.push_back(source);
+        }
+    }
+
+    void StaticMerger::merge()
+    {
+        // Sources by geometry and state set, to find the repeated ones
+        typedef std::map<std::pair<const osg::Geometry*, const osg::StateSet*>, std::vector<const Source*> > SourceGroups;
+        typedef std::map<std::pair<int, int>, SourceGroups> TileMap;
+        TileMap tiles;
+
+        for (std::vector<Source>::const_iterator it = mSources.begin(); it != mSources.end(); ++it)
+            tiles[it->mTile][std::make_pair(it->mGeometry.get(), it->mStateSet.get())].push_back(&*it);
+
+        for (TileMap::const_iterator tile = tiles.begin(); tile != tiles.end(); ++tile)
+        {
+            osg::ref_ptr<osg::Group> tileNode = new osg::Group;
+            osg::ref_ptr<osg::Geode> merged = new osg::Geode;
+            osg::ref_ptr<osg::Group> instanced = new osg::Group;
+
+            for (SourceGroups::const_iterator group = tile->second.begin(); group != tile->second.end(); ++group)
+            {
+                const std::vector<const Source*>& sources = group->second;
+                if (mMinInstances > 0 && sources.size() >= mMinInstances && canInstance(*sources.front()->mGeometry, sources.front()->mStateSet))
+                {
+                    addInstances(sources, *instanced);
+                    continue;
+                }
+
+                for (std::vector<const Source*>::const_iterator it = sources.begin(); it != sources.end(); ++it)
+                {
+                    osg::ref_ptr<osg::Geometry> copy = copyGeometry(*(*it)->mGeometry, (*it)->mStateSet);
+                    transformGeometry(*copy, (*it)->mTransform);
+                    merged->addDrawable(copy);
+                }
+            }
+
+            if (merged->getNumDrawables())
+            {
+                // Combines the drawables that share a state set
+                osgUtil::Optimizer::MergeGeometryVisitor visitor;
+                merged->accept(visitor);
+                tileNode->addChild(merged);
+            }
+            if (instanced->getNumChildren())
+            {
+                tileNode->addChild(instanced);
+                mInstancedGroups.push_back(instanced);
+            }
+            mMergedNode->addChild(tileNode);
+        }
+
+        mSources.clear();
+        mStateSets.clear();
+    }
+
+    void StaticMerger::addInstances(const std::vector<const Source*>& sources, osg::Group& parent)
+    {
+        // Shared by the draws
+        osg::ref_ptr<osg::Geometry> geometry = copyGeometry(*sources.front()->mGeometry, sources.front()->mStateSet);
+        geometry->setUseDisplayList(false);
+        geometry->setUseVertexBufferObjects(true);
+
+        osg::BoundingBox bounds;
+        const osg::Vec3Array* vertices = static_cast<const osg::Vec3Array*>(geometry->getVertexArray());
+        for (osg::Vec3Array::const_iterator it = vertices->begin(); it != vertices->end(); ++it)
+            bounds.expandBy(*it);
+        const bool vertexColors = usesVertexColors(*geometry, geometry->getStateSet());
+
+        for (unsigned int start = 0; start < sources.size(); start += getMaxInstancesPerDraw())
+        {
+            const unsigned int count = std::min(static_cast<unsigned int>(sources.size()) - start, getMaxInstancesPerDraw());
+
+            osg::ref_ptr<osg::Uniform> transforms = new osg::Uniform(osg::Uniform::FLOAT_MAT4, "instanceTransforms", count);
+            osg::BoundingBox instanceBounds;
+            for (unsigned int i=0; i<count; ++i)
+            {
+                const osg::Matrixf& transform = sources[start+i]->mTransform;
+                transforms->setElement(i, transform);
+                for (unsigned int corner=0; corner<8; ++corner)
+                    instanceBounds.expandBy(bounds.corner(corner) * transform);
+            }
+
+            osg::ref_ptr<osg::Geometry> draw = new osg::Geometry(*geometry, osg::CopyOp::DEEP_COPY_PRIMITIVES);
+            for (unsigned int i=0; i<draw->getNumPrimitiveSets(); ++i)
+                draw->getPrimitiveSet(i)->setNumInstances(count);
+            // Culled as a whole
+            draw->setComputeBoundingBoxCallback(new InstancedBoundingBoxCallback(instanceBounds));
+            draw->dirtyBound();
+
+            osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+            geode->getOrCreateStateSet()->addUniform(transforms);
+            geode->getStateSet()->addUniform(new osg::Uniform("vertexColors", vertexColors));
+            geode->addDrawable(draw);
+            parent.addChild(geode);
+        }
+    }
+
+    osg::Group* StaticMerger::getMergedNode()
+    {
+        return mMergedNode.get();
+    }
+
+    const std::vector<osg::ref_ptr<osg::Group> >& StaticMerger::getInstancedGroups() const
+    {
+        return mInstancedGroups;
+    }
+
+    osg::StateSet* StaticMerger::getStateSet(const std::vector<const osg::StateSet*>& stateSets)
+    {
+        if (stateSets.empty())
+            return NULL;
+
+        // Always a copy, owned by the merged geometry, see CopyGeometryOp
+        osg::ref_ptr<osg::StateSet>& combined = mStateSets[stateSets];
+        if (!combined)
+        {
+            combined = new osg::StateSet(*stateSets.front(), osg::CopyOp::SHALLOW_COPY);
+            for (std::vector<const osg::StateSet*>::const_iterator it = stateSets.begin()+1; it != stateSets.end(); ++it)
+                combined->merge(**it);
+        }
+        return combined.get();
+    }
+
+}
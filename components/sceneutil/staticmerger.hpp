@@ -0,0 +1,86 @@
+#ifndef OPENMW_COMPONENTS_SCENEUTIL_STATICMERGER_H
+#define OPENMW_COMPONENTS_SCENEUTIL_STATICMERGER_H
+
+#include <map>
+#include <vector>
+
+#include <osg/ref_ptr>
+#include <osg/Referenced>
+#include <osg/Matrixf>
+#include <osg/Group>
+
+namespace osg
+{
+    class Geometry;
+    class StateSet;
+}
+
+namespace SceneUtil
+{
+
+    /// @brief Merges the geometry of static objects, so that objects sharing a material are drawn with few draw calls.
+    /// @par The objects are sorted into square tiles by their position. Each tile becomes a child of the merged node,
+    /// holding one Geode with the merged geometry, flattened into the coordinate space of the merged node.
+    /// @par Optionally, geometry that repeats often enough within a tile is drawn instanced instead of merged, with one
+    /// osg::Uniform array of instance transforms per draw. The instanced draws need a shader program, which the caller
+    /// sets on the state sets of getInstancedGroups(). See files/shaders/objects_instanced_vertex.glsl.
+    /// @par Objects are added on the main thread, which collects their geometry and copies their state sets. merge() may
+    /// then run on a worker thread, as it only reads the collected geometry, and does not change the added scene graphs.
+    class StaticMerger : public osg::Referenced
+    {
+    public:
+        /// @param minInstances How often the same geometry with the same state has to repeat within a tile to be drawn
+        /// instanced. 0 for no instancing.
+        StaticMerger(float tileSize, unsigned int minInstances = 0);
+
+        /// The size of the instanceTransforms uniform array of the instancing shader.
+        static unsigned int getMaxInstancesPerDraw();
+
+        /// Can the given subgraph be merged? Subgraphs with callbacks, switches, lights, skinning,
+        /// particles or transparency can not, since the merged copy would not behave the same.
+        static bool canMerge(const osg::Node& node);
+
+        /// Add a subgraph to merge. Must be mergeable, see canMerge().
+        /// @param transform From the subgraph to the merged node.
+        void add(const osg::Node& node, const osg::Matrixf& transform);
+
+        /// Copy the collected geometry into the merged node, and combine it.
+        void merge();
+
+        /// @note Complete after merge().
+        osg::Group* getMergedNode();
+
+        /// The groups of the merged node with instanced geometry, one per tile that has any.
+        /// @note Complete after merge().
+        const std::vector<osg::ref_ptr<osg::Group> >& getInstancedGroups() const;
+
+    private:
+        float mTileSize;
+        unsigned int mMinInstances;
+
+        struct Source
+        {
+            osg::ref_ptr<const osg::Geometry> mGeometry;
+            osg::Matrixf mTransform;
+            // Combined along the path to the geometry, including the geometry's own
+            osg::ref_ptr<osg::StateSet> mStateSet;
+            std::pair<int, int> mTile;
+        };
+        std::vector<Source> mSources;
+
+        // Combined state sets by the state sets they are made of, so that copies of the same model share them
+        typedef std::map<std::vector<const osg::StateSet*>, osg::ref_ptr<osg::StateSet> > StateSetCache;
+        StateSetCache mStateSets;
+
+        osg::ref_ptr<osg::Group> mMergedNode;
+        std::vector<osg::ref_ptr<osg::Group> > mInstancedGroups;
+
+        osg::StateSet* getStateSet(const std::vector<const osg::StateSet*>& stateSets);
+
+        /// Add draws of the geometry of the given sources, which all share the same geometry and state set.
+        void addInstances(const std::vector<const Source*>& sources, osg::Group& parent);
+    };
+
+}
+
+#endif
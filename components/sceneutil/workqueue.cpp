@@ -15,6 +15,13 @@ void WorkTicket::waitTillDone()
     }
 }
 
+bool WorkTicket::isDone()
+{
+    // Lock so the results of the work are visible to the caller
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    return mDone > 0;
+}
+
 void WorkTicket::signalDone()
 {
     {
@@ -24,6 +31,16 @@ void WorkTicket::signalDone()
     mCondition.broadcast();
 }
 
+void WorkTicket::cancel()
+{
+    mCancelled.exchange(1);
+}
+
+bool WorkTicket::isCancelled()
+{
+    return mCancelled > 0;
+}
+
 WorkItem::WorkItem()
     : mTicket(new WorkTicket)
 {
@@ -46,6 +63,7 @@ osg::ref_ptr<WorkTicket> WorkItem::getTicket()
 
 WorkQueue::WorkQueue(int workerThreads)
     : mIsReleased(false)
+    , mNextSequence(0)
 {
     for (int i=0; i<workerThreads; ++i)
     {
@@ -61,7 +79,10 @@ WorkQueue::~WorkQueue()
         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
         while (mQueue.size())
         {
-            WorkItem* item = mQueue.front();
+            // signal the tickets, so no one waits for the work forever
+            WorkItem* item = mQueue.top().mItem;
+            item->getTicket()->cancel();
+            item->getTicket()->signalDone();
             delete item;
             mQueue.pop();
         }
@@ -76,11 +97,15 @@ WorkQueue::~WorkQueue()
     }
 }
 
-osg::ref_ptr<WorkTicket> WorkQueue::addWorkItem(WorkItem *item)
+osg::ref_ptr<WorkTicket> WorkQueue::addWorkItem(WorkItem *item, int priority)
 {
     osg::ref_ptr<WorkTicket> ticket = item->getTicket();
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-    mQueue.push(item);
+    Entry entry;
+    entry.mPriority = priority;
+    entry.mSequence = mNextSequence++;
+    entry.mItem = item;
+    mQueue.push(entry);
     mCondition.signal();
     return ticket;
 }
@@ -94,7 +119,7 @@ WorkItem *WorkQueue::removeWorkItem()
     }
     if (mQueue.size())
     {
-        WorkItem* item = mQueue.front();
+        WorkItem* item = mQueue.top().mItem;
         mQueue.pop();
         return item;
     }
@@ -114,7 +139,10 @@ void WorkThread::run()
         WorkItem* item = mWorkQueue->removeWorkItem();
         if (!item)
             return;
-        item->doWork();
+        if (item->getTicket()->isCancelled())
+            item->getTicket()->signalDone();
+        else
+            item->doWork();
         delete item;
     }
 }
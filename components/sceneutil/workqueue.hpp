@@ -10,6 +10,7 @@
 #include <osg/ref_ptr>
 
 #include <queue>
+#include <vector>
 
 namespace SceneUtil
 {
@@ -19,10 +20,19 @@ namespace SceneUtil
     public:
         void waitTillDone();
 
+        /// Has the work been completed? Does not wait.
+        bool isDone();
+
         void signalDone();
 
+        /// Skip the work if it has not started yet. The ticket is still signalled as done.
+        void cancel();
+
+        bool isCancelled();
+
     private:
         OpenThreads::Atomic mDone;
+        OpenThreads::Atomic mCancelled;
         OpenThreads::Mutex mMutex;
         OpenThreads::Condition mCondition;
     };
@@ -57,15 +67,17 @@ namespace SceneUtil
     };
 
     /// @brief A work queue that users can push work items onto, to be completed by one or more background threads.
+    /// @par Items with a higher priority are taken first, items with the same priority in the order they were added.
     class WorkQueue
     {
     public:
         WorkQueue(int numWorkerThreads=1);
+        /// Cancels the items that were not started yet, and waits for the others.
         ~WorkQueue();
 
-        /// Add a new work item to the back of the queue.
-        /// @par The returned WorkTicket may be used by the caller to wait until the work is complete.
-        osg::ref_ptr<WorkTicket> addWorkItem(WorkItem* item);
+        /// Add a new work item to the queue.
+        /// @par The returned WorkTicket may be used by the caller to wait until the work is complete, or to cancel it.
+        osg::ref_ptr<WorkTicket> addWorkItem(WorkItem* item, int priority=0);
 
         /// Get the next work item from the front of the queue. If the queue is empty, waits until a new item is added.
         /// If the workqueue is in the process of being destroyed, may return NULL.
@@ -75,8 +87,23 @@ namespace SceneUtil
         void runThread();
 
     private:
+        struct Entry
+        {
+            int mPriority;
+            unsigned int mSequence;
+            WorkItem* mItem;
+
+            bool operator< (const Entry& other) const
+            {
+                if (mPriority != other.mPriority)
+                    return mPriority < other.mPriority;
+                return mSequence > other.mSequence;
+            }
+        };
+
         bool mIsReleased;
-        std::queue<WorkItem*> mQueue;
+        std::priority_queue<Entry> mQueue;
+        unsigned int mNextSequence;
 
         OpenThreads::Mutex mMutex;
         OpenThreads::Condition mCondition;
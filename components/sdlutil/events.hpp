@@ -1,6 +1,8 @@
 #ifndef _SFO_EVENTS_H
 #define _SFO_EVENTS_H
 
+#include <vector>
+
 #include <SDL_types.h>
 #include <SDL_events.h>
 
@@ -78,6 +80,16 @@ public:
     virtual void windowResized (int x, int y) {}
 };
 
+/// Sees the input events before they are handled, to record them or to replace them with recorded ones
+class EventRecorder
+{
+public:
+    virtual ~EventRecorder() {}
+
+    /** @remarks Called with the events of each capture, except for the window and quit events */
+    virtual void captured(std::vector<SDL_Event>& events) = 0;
+};
+
 }
 
 #endif
@@ -15,6 +15,7 @@ InputWrapper::InputWrapper(SDL_Window* window, osg::ref_ptr<osgViewer::Viewer> v
         mKeyboardListener(NULL),
         mWindowListener(NULL),
         mConListener(NULL),
+        mEventRecorder(NULL),
         mWarpX(0),
         mWarpY(0),
         mWarpCompensate(false),
@@ -59,106 +60,123 @@ InputWrapper::InputWrapper(SDL_Window* window, osg::ref_ptr<osgViewer::Viewer> v
             return;
         }
 
+        mEvents.clear();
         while(SDL_PollEvent(&evt))
         {
-            switch(evt.type)
-            {
-                case SDL_MOUSEMOTION:
-                    // Ignore this if it happened due to a warp
-                    if(!_handleWarpMotion(evt.motion))
-                    {
-                        // If in relative mode, don't trigger events unless window has focus
-                        if (!mWantRelative || mWindowHasFocus)
-                            mMouseListener->mouseMoved(_packageMouseMotion(evt));
-
-                        // Try to keep the mouse inside the window
-                        if (mWindowHasFocus)
-                            _wrapMousePointer(evt.motion);
-                    }
-                    break;
-                case SDL_MOUSEWHEEL:
-                    mMouseListener->mouseMoved(_packageMouseMotion(evt));
-                    break;
-                case SDL_MOUSEBUTTONDOWN:
-                    mMouseListener->mousePressed(evt.button, evt.button.button);
-                    break;
-                case SDL_MOUSEBUTTONUP:
-                    mMouseListener->mouseReleased(evt.button, evt.button.button);
-                    break;
-                case SDL_KEYDOWN:
-                    if (!evt.key.repeat)
-                        mKeyboardListener->keyPressed(evt.key);
-
-                    // temporary for the stats viewer
-                    if (evt.key.keysym.sym == SDLK_F3)
-                        mViewer->getEventQueue()->keyPress(osgGA::GUIEventAdapter::KEY_F3);
-
-                    break;
-                case SDL_KEYUP:
-                    if (!evt.key.repeat)
-                        mKeyboardListener->keyReleased(evt.key);
-
-                    // temporary for the stats viewer
-                    if (evt.key.keysym.sym == SDLK_F3)
-                        mViewer->getEventQueue()->keyRelease(osgGA::GUIEventAdapter::KEY_F3);
-
-                    break;
-                case SDL_TEXTINPUT:
-                    mKeyboardListener->textInput(evt.text);
-                    break;
-                case SDL_JOYHATMOTION: //As we manage everything with GameController, don't even bother with these.
-                case SDL_JOYAXISMOTION:
-                case SDL_JOYBUTTONDOWN:
-                case SDL_JOYBUTTONUP:
-                case SDL_JOYDEVICEADDED:
-                case SDL_JOYDEVICEREMOVED:
-                    break;
-                case SDL_CONTROLLERDEVICEADDED:
-                    if(mConListener)
-                        mConListener->controllerAdded(1, evt.cdevice); //We only support one joystick, so give everything a generic deviceID
-                    break;
-                case SDL_CONTROLLERDEVICEREMOVED:
-                    if(mConListener)
-                        mConListener->controllerRemoved(evt.cdevice);
-                    break;
-                case SDL_CONTROLLERBUTTONDOWN:
-                    if(mConListener)
-                        mConListener->buttonPressed(1, evt.cbutton);
-                    break;
-                case SDL_CONTROLLERBUTTONUP:
-                    if(mConListener)
-                        mConListener->buttonReleased(1, evt.cbutton);
-                    break;
-                case SDL_CONTROLLERAXISMOTION:
-                    if(mConListener)
-                        mConListener->axisMoved(1, evt.caxis);
-                    break;
-                case SDL_WINDOWEVENT:
-                    handleWindowEvent(evt);
-                    break;
-                case SDL_QUIT:
-                    if (mWindowListener)
-                        mWindowListener->windowClosed();
-                    break;
-                case SDL_CLIPBOARDUPDATE:
-                    break; // We don't need this event, clipboard is retrieved on demand
-
-                case SDL_FINGERDOWN:
-                case SDL_FINGERUP:
-                case SDL_FINGERMOTION:
-                case SDL_DOLLARGESTURE:
-                case SDL_DOLLARRECORD:
-                case SDL_MULTIGESTURE:
-                    // No use for touch & gesture events
-                    break;
-
-                default:
-                    std::ios::fmtflags f(std::cerr.flags());
-                    std::cerr << "Unhandled SDL event of type 0x" << std::hex << evt.type << std::endl;
-                    std::cerr.flags(f);
-                    break;
-            }
+            // Not part of the input, so neither recorded nor replayed
+            if (evt.type == SDL_WINDOWEVENT || evt.type == SDL_QUIT)
+                handleEvent(evt);
+            else
+                mEvents.push_back(evt);
+        }
+
+        if (mEventRecorder)
+            mEventRecorder->captured(mEvents);
+
+        for (std::vector<SDL_Event>::const_iterator it = mEvents.begin(); it != mEvents.end(); ++it)
+            handleEvent(*it);
+    }
+
+    void InputWrapper::handleEvent(const SDL_Event& evt)
+    {
+        switch(evt.type)
+        {
+            case SDL_MOUSEMOTION:
+                // Ignore this if it happened due to a warp
+                if(!_handleWarpMotion(evt.motion))
+                {
+                    // If in relative mode, don't trigger events unless window has focus
+                    if (!mWantRelative || mWindowHasFocus)
+                        mMouseListener->mouseMoved(_packageMouseMotion(evt));
+
+                    // Try to keep the mouse inside the window
+                    if (mWindowHasFocus)
+                        _wrapMousePointer(evt.motion);
+                }
+                break;
+            case SDL_MOUSEWHEEL:
+                mMouseListener->mouseMoved(_packageMouseMotion(evt));
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+                mMouseListener->mousePressed(evt.button, evt.button.button);
+                break;
+            case SDL_MOUSEBUTTONUP:
+                mMouseListener->mouseReleased(evt.button, evt.button.button);
+                break;
+            case SDL_KEYDOWN:
+                if (!evt.key.repeat)
+                    mKeyboardListener->keyPressed(evt.key);
+
+                // temporary for the stats viewer
+                if (evt.key.keysym.sym == SDLK_F3)
+                    mViewer->getEventQueue()->keyPress(osgGA::GUIEventAdapter::KEY_F3);
+
+                break;
+            case SDL_KEYUP:
+                if (!evt.key.repeat)
+                    mKeyboardListener->keyReleased(evt.key);
+
+                // temporary for the stats viewer
+                if (evt.key.keysym.sym == SDLK_F3)
+                    mViewer->getEventQueue()->keyRelease(osgGA::GUIEventAdapter::KEY_F3);
+
+                break;
+            case SDL_TEXTINPUT:
+                mKeyboardListener->textInput(evt.text);
+                break;
+            case SDL_JOYHATMOTION: //As we manage everything with GameController, don't even bother with these.
+            case SDL_JOYAXISMOTION:
+            case SDL_JOYBUTTONDOWN:
+            case SDL_JOYBUTTONUP:
+            case SDL_JOYDEVICEADDED:
+            case SDL_JOYDEVICEREMOVED:
+                break;
+            case SDL_CONTROLLERDEVICEADDED:
+                if(mConListener)
+                    mConListener->controllerAdded(1, evt.cdevice); //We only support one joystick, so give everything a generic deviceID
+                break;
+            case SDL_CONTROLLERDEVICEREMOVED:
+                if(mConListener)
+                    mConListener->controllerRemoved(evt.cdevice);
+                break;
+            case SDL_CONTROLLERBUTTONDOWN:
+                if(mConListener)
+                    mConListener->buttonPressed(1, evt.cbutton);
+                break;
+            case SDL_CONTROLLERBUTTONUP:
+                if(mConListener)
+                    mConListener->buttonReleased(1, evt.cbutton);
+                break;
+            case SDL_CONTROLLERAXISMOTION:
+                if(mConListener)
+                    mConListener->axisMoved(1, evt.caxis);
+                break;
+            case SDL_WINDOWEVENT:
+                handleWindowEvent(evt);
+                break;
+            case SDL_QUIT:
+                if (mWindowListener)
+                    mWindowListener->windowClosed();
+                break;
+            case SDL_CLIPBOARDUPDATE:
+                break; // We don't need this event, clipboard is retrieved on demand
+
+            case SDL_FINGERDOWN:
+            case SDL_FINGERUP:
+            case SDL_FINGERMOTION:
+            case SDL_DOLLARGESTURE:
+            case SDL_DOLLARRECORD:
+            case SDL_MULTIGESTURE:
+                // No use for touch & gesture events
+                break;
+
+            default:
+                std::ios::fmtflags f(std::cerr.flags());
+                std::cerr << "Unhandled SDL event of type 0x" << std::hex << evt.type << std::endl;
+                std::cerr.flags(f);
+                break;
         }
+
     }
 
     void InputWrapper::handleWindowEvent(const SDL_Event& evt)
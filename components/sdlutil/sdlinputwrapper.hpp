@@ -2,6 +2,7 @@
 #define OPENMW_COMPONENTS_SDLUTIL_SDLINPUTWRAPPER_H
 
 #include <map>
+#include <vector>
 
 #include <osg/ref_ptr>
 
@@ -28,6 +29,7 @@ namespace SDLUtil
         void setKeyboardEventCallback(KeyListener* listen) { mKeyboardListener = listen; }
         void setWindowEventCallback(WindowListener* listen) { mWindowListener = listen; }
         void setControllerEventCallback(ControllerListener* listen) { mConListener = listen; }
+        void setEventRecorder(EventRecorder* recorder) { mEventRecorder = recorder; }
 
         void capture(bool windowEventsOnly);
         bool isModifierHeld(SDL_Keymod mod);
@@ -45,6 +47,7 @@ namespace SDLUtil
         void updateMouseSettings();
 
     private:
+        void handleEvent(const SDL_Event& evt);
         void handleWindowEvent(const SDL_Event& evt);
 
         bool _handleWarpMotion(const SDL_MouseMotionEvent& evt);
@@ -60,6 +63,10 @@ namespace SDLUtil
         KeyListener* mKeyboardListener;
         WindowListener* mWindowListener;
         ControllerListener* mConListener;
+        EventRecorder* mEventRecorder;
+
+        // The events of the current capture, kept to reuse the memory
+        std::vector<SDL_Event> mEvents;
 
         typedef std::map<SDL_Keycode, OIS::KeyCode> KeyMap;
         KeyMap mKeyMap;
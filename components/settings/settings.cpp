@@ -58,6 +58,8 @@ namespace Settings
 CategorySettingValueMap Manager::mDefaultSettings = CategorySettingValueMap();
 CategorySettingValueMap Manager::mUserSettings = CategorySettingValueMap();
 CategorySettingVector Manager::mChangedSettings = CategorySettingVector();
+// Starts past the generation of a Value that was not read yet
+unsigned int Manager::sGeneration = 1;
 
 typedef std::map< CategorySetting, bool > CategorySettingStatusMap;
 
@@ -358,18 +360,21 @@ void Manager::clear()
     mDefaultSettings.clear();
     mUserSettings.clear();
     mChangedSettings.clear();
+    ++sGeneration;
 }
 
 void Manager::loadDefault(const std::string &file)
 {
     SettingsFileParser parser;
     parser.loadSettingsFile(file, mDefaultSettings);
+    ++sGeneration;
 }
 
 void Manager::loadUser(const std::string &file)
 {
     SettingsFileParser parser;
     parser.loadSettingsFile(file, mUserSettings);
+    ++sGeneration;
 }
 
 void Manager::saveUser(const std::string &file)
@@ -422,6 +427,7 @@ void Manager::setString(const std::string &setting, const std::string &category,
     mUserSettings[key] = value;
 
     mChangedSettings.insert(key);
+    ++sGeneration;
 }
 
 void Manager::setInt (const std::string& setting, const std::string& category, const int value)
@@ -446,4 +452,29 @@ const CategorySettingVector Manager::apply()
     return vec;
 }
 
+unsigned int Manager::getGeneration()
+{
+    return sGeneration;
+}
+
+void readValue (const std::string& setting, const std::string& category, int& value)
+{
+    value = Manager::getInt (setting, category);
+}
+
+void readValue (const std::string& setting, const std::string& category, float& value)
+{
+    value = Manager::getFloat (setting, category);
+}
+
+void readValue (const std::string& setting, const std::string& category, bool& value)
+{
+    value = Manager::getBool (setting, category);
+}
+
+void readValue (const std::string& setting, const std::string& category, std::string& value)
+{
+    value = Manager::getString (setting, category);
+}
+
 }
@@ -23,6 +23,9 @@ namespace Settings
         static CategorySettingVector mChangedSettings;
         ///< tracks all the settings that were changed since the last apply() call
 
+        static unsigned int getGeneration();
+        ///< changes whenever a setting may have changed, see Value
+
         void clear();
         ///< clears all settings and default settings
 
@@ -47,6 +50,49 @@ namespace Settings
         static void setFloat (const std::string& setting, const std::string& category, const float value);
         static void setString (const std::string& setting, const std::string& category, const std::string& value);
         static void setBool (const std::string& setting, const std::string& category, const bool value);
+
+    private:
+        static unsigned int sGeneration;
+    };
+
+    void readValue (const std::string& setting, const std::string& category, int& value);
+    void readValue (const std::string& setting, const std::string& category, float& value);
+    void readValue (const std::string& setting, const std::string& category, bool& value);
+    void readValue (const std::string& setting, const std::string& category, std::string& value);
+
+    ///
+    /// \brief A setting that is read often, e.g. every frame
+    ///
+    /// The setting is looked up and parsed when it is first read, and again only after the settings
+    /// were changed, so reading it is usually as cheap as reading a member. Changes made with the
+    /// Manager::set functions are picked up on the next read, without waiting for Manager::apply().
+    ///
+    /// \note Not thread safe, keep a separate Value per thread.
+    template <typename T>
+    class Value
+    {
+        public:
+
+            Value (const std::string& setting, const std::string& category)
+            : mSetting (setting), mCategory (category), mGeneration (0), mValue() {}
+
+            const T& get() const
+            {
+                if (mGeneration!=Manager::getGeneration())
+                {
+                    readValue (mSetting, mCategory, mValue);
+                    mGeneration = Manager::getGeneration();
+                }
+
+                return mValue;
+            }
+
+        private:
+
+            std::string mSetting;
+            std::string mCategory;
+            mutable unsigned int mGeneration;
+            mutable T mValue;
     };
 
 }
@@ -178,9 +178,10 @@ namespace Terrain
 
     osg::ref_ptr<osg::Vec2Array> BufferCache::getUVBuffer()
     {
-        if (mUvBufferMap.find(mNumVerts) != mUvBufferMap.end())
+        std::map<int, osg::ref_ptr<osg::Vec2Array> >::const_iterator found = mUvBufferMap.find(mNumVerts);
+        if (found != mUvBufferMap.end())
         {
-            return mUvBufferMap[mNumVerts];
+            return found->second;
         }
 
         int vertexCount = mNumVerts * mNumVerts;
@@ -208,9 +209,10 @@ namespace Terrain
     {
         unsigned int verts = mNumVerts;
 
-        if (mIndexBufferMap.find(flags) != mIndexBufferMap.end())
+        std::map<int, osg::ref_ptr<osg::DrawElements> >::const_iterator found = mIndexBufferMap.find(flags);
+        if (found != mIndexBufferMap.end())
         {
-            return mIndexBufferMap[flags];
+            return found->second;
         }
 
         osg::ref_ptr<osg::DrawElements> buffer;
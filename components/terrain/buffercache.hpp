@@ -10,6 +10,7 @@ namespace Terrain
 {
 
     /// @brief Implements creation and caching of vertex buffers for terrain chunks.
+    /// @note Not thread safe, except for getting buffers that were created before.
     class BufferCache
     {
     public:
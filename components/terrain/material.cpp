@@ -5,7 +5,8 @@
 #include <osg/Texture2D>
 #include <osg/TexMat>
 #include <osg/Material>
-#include <osg/TexEnvCombine>
+#include <osg/Program>
+#include <osg/Uniform>
 
 namespace Terrain
 {
@@ -66,12 +67,36 @@ namespace Terrain
         }
     }
 
+    ShaderTechnique::ShaderTechnique(osg::Program* program, const std::vector<osg::ref_ptr<osg::Texture2D> >& layers,
+                                     const std::vector<osg::ref_ptr<osg::Texture2D> >& blendmaps, int blendmapScale, float layerTileSize)
+    {
+        osg::ref_ptr<osg::StateSet> stateset (new osg::StateSet);
+        stateset->setAttributeAndModes(program, osg::StateAttribute::ON);
+
+        for (unsigned int i=0; i<layers.size(); ++i)
+            stateset->setTextureAttribute(i, layers[i]);
+        for (unsigned int i=0; i<blendmaps.size(); ++i)
+            stateset->setTextureAttribute(getMaxLayers() + i, blendmaps[i]);
+
+        stateset->addUniform(new osg::Uniform("numLayers", static_cast<int>(layers.size())));
+        stateset->addUniform(new osg::Uniform("blendmapScale", static_cast<float>(blendmapScale)));
+        stateset->addUniform(new osg::Uniform("layerTileSize", layerTileSize));
+
+        addPass(stateset);
+    }
+
+    unsigned int ShaderTechnique::getMaxLayers()
+    {
+        return 8;
+    }
+
     Effect::Effect(const std::vector<osg::ref_ptr<osg::Texture2D> > &layers, const std::vector<osg::ref_ptr<osg::Texture2D> > &blendmaps,
-                   int blendmapScale, float layerTileSize)
+                   int blendmapScale, float layerTileSize, osg::Program* program)
         : mLayers(layers)
         , mBlendmaps(blendmaps)
         , mBlendmapScale(blendmapScale)
         , mLayerTileSize(layerTileSize)
+        , mProgram(program)
     {
         osg::ref_ptr<osg::Material> material (new osg::Material);
         material->setColorMode(osg::Material::AMBIENT_AND_DIFFUSE);
@@ -82,7 +107,10 @@ namespace Terrain
 
     bool Effect::define_techniques()
     {
-        addTechnique(new FixedFunctionTechnique(mLayers, mBlendmaps, mBlendmapScale, mLayerTileSize));
+        if (mProgram)
+            addTechnique(new ShaderTechnique(mProgram, mLayers, mBlendmaps, mBlendmapScale, mLayerTileSize));
+        else
+            addTechnique(new FixedFunctionTechnique(mLayers, mBlendmaps, mBlendmapScale, mLayerTileSize));
 
         return true;
     }
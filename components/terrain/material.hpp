@@ -9,6 +9,7 @@
 namespace osg
 {
     class Texture2D;
+    class Program;
 }
 
 namespace Terrain
@@ -25,12 +26,31 @@ namespace Terrain
         virtual void define_passes() {}
     };
 
+    /// @brief Blends all layers in a single pass, with the blend values of four layers packed into each blendmap.
+    /// @par Layer i is bound to texture unit i, blendmap i to unit getMaxLayers()+i. The sampler uniforms are not set by
+    /// the technique, since they are the same for every chunk.
+    class ShaderTechnique : public osgFX::Technique
+    {
+    public:
+        ShaderTechnique(osg::Program* program,
+                const std::vector<osg::ref_ptr<osg::Texture2D> >& layers,
+                const std::vector<osg::ref_ptr<osg::Texture2D> >& blendmaps, int blendmapScale, float layerTileSize);
+
+        /// The most layers the shader can blend. Chunks with more layers need the FixedFunctionTechnique.
+        static unsigned int getMaxLayers();
+
+    protected:
+        virtual void define_passes() {}
+    };
+
     class Effect : public osgFX::Effect
     {
     public:
+        /// @param program If not NULL, use the ShaderTechnique with this program, and packed blendmaps.
         Effect(
                 const std::vector<osg::ref_ptr<osg::Texture2D> >& layers,
-                const std::vector<osg::ref_ptr<osg::Texture2D> >& blendmaps, int blendmapScale, float layerTileSize);
+                const std::vector<osg::ref_ptr<osg::Texture2D> >& blendmaps, int blendmapScale, float layerTileSize,
+                osg::Program* program = NULL);
 
         virtual bool define_techniques();
 
@@ -52,6 +72,7 @@ namespace Terrain
         std::vector<osg::ref_ptr<osg::Texture2D> > mBlendmaps;
         int mBlendmapScale;
         float mLayerTileSize;
+        osg::ref_ptr<osg::Program> mProgram;
     };
 
 }
@@ -0,0 +1,700 @@
+#include "quadtreeworld.hpp"
+
+#include <cmath>
+#include <limits>
+#include <iostream>
+
+#include <OpenThreads/ScopedLock>
+
+#include <osg/Geometry>
+#include <osg/Geode>
+#include <osg/Material>
+#include <osg/Math>
+#include <osg/Switch>
+#include <osg/Texture2D>
+#include <osg/Version>
+
+#include <osgUtil/CullVisitor>
+#include <osgUtil/IncrementalCompileOperation>
+
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/texturemanager.hpp>
+
+#include <components/sceneutil/lightmanager.hpp>
+#include <components/sceneutil/positionattitudetransform.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include <components/esm/loadland.hpp>
+
+#include "material.hpp"
+#include "storage.hpp"
+
+namespace
+{
+    class StaticBoundingBoxCallback : public osg::Drawable::ComputeBoundingBoxCallback
+    {
+    public:
+        StaticBoundingBoxCallback(const osg::BoundingBox& bounds)
+            : mBoundingBox(bounds)
+        {
+        }
+
+        virtual osg::BoundingBox computeBound(const osg::Drawable&) const
+        {
+            return mBoundingBox;
+        }
+
+    private:
+        osg::BoundingBox mBoundingBox;
+    };
+
+    // Calls QuadTreeWorld::cull instead of traversing the children of the terrain root
+    class QuadTreeCullCallback : public osg::NodeCallback
+    {
+    public:
+        QuadTreeCullCallback(Terrain::QuadTreeWorld* world)
+            : mWorld(world)
+        {
+        }
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            mWorld->cull(static_cast<osgUtil::CullVisitor*>(nv));
+        }
+
+    private:
+        Terrain::QuadTreeWorld* mWorld;
+    };
+
+    osg::Vec4f getAverageColor(const osg::Image& image)
+    {
+#if !OSG_VERSION_GREATER_OR_EQUAL(3,4,0)
+        // Older versions can not read the colours of compressed images
+        if (image.isCompressed())
+            return osg::Vec4f(0.5f, 0.5f, 0.5f, 1.f);
+#endif
+        const int samples = 8;
+        osg::Vec4f sum;
+        for (int t=0; t<samples; ++t)
+            for (int s=0; s<samples; ++s)
+                sum += image.getColor(osg::Vec2f((s+0.5f)/samples, (t+0.5f)/samples));
+        sum /= samples*samples;
+        sum.a() = 1.f;
+        return sum;
+    }
+}
+
+namespace Terrain
+{
+
+class BuiltChunk : public osg::Referenced
+{
+public:
+    BuiltChunk()
+        : mEmpty(true)
+        , mMinHeight(0.f)
+        , mMaxHeight(0.f)
+    {
+    }
+
+    bool mEmpty;
+    float mMinHeight;
+    float mMaxHeight;
+
+    osg::ref_ptr<osg::Node> mNode;
+    // Without primitive sets, copied for each combination of LOD flags
+    osg::ref_ptr<osg::Geometry> mGeometry;
+    // Holds the copies of mGeometry
+    osg::ref_ptr<osg::Switch> mLodSwitch;
+    // < LOD flags, child of mLodSwitch >
+    std::map<unsigned int, unsigned int> mVariants;
+};
+
+struct QuadTreeWorld::QuadNode
+{
+    QuadNode(const osg::Vec2f& center, float size)
+        : mCenter(center)
+        , mSize(size)
+        , mEmpty(false)
+        , mBoundsKnown(false)
+        , mMinHeight(0.f)
+        , mMaxHeight(0.f)
+        , mLastUsed(0.0)
+        , mSelected(0)
+    {
+        for (int i=0; i<4; ++i)
+            mChildren[i] = NULL;
+    }
+
+    ~QuadNode()
+    {
+        for (int i=0; i<4; ++i)
+            delete mChildren[i];
+    }
+
+    // In cell units
+    osg::Vec2f mCenter;
+    float mSize;
+
+    // Child i is on the positive x side if i&1, and on the positive y side if i&2. Created once the node is subdivided.
+    QuadNode* mChildren[4];
+
+    // No terrain in the area of the node
+    bool mEmpty;
+
+    bool mBoundsKnown;
+    float mMinHeight;
+    float mMaxHeight;
+
+    // Pending while mTicket is set, and attached to the terrain root after
+    osg::ref_ptr<BuiltChunk> mChunk;
+    osg::ref_ptr<SceneUtil::WorkTicket> mTicket;
+
+    // The time the chunk was last requested or drawn
+    double mLastUsed;
+    // Equals mSelectionNumber if the node is selected by the current cull
+    unsigned int mSelected;
+};
+
+class QuadTreeWorld::BuildChunkItem : public SceneUtil::WorkItem
+{
+public:
+    BuildChunkItem(QuadTreeWorld* terrain, float size, const osg::Vec2f& center, BuiltChunk* result)
+        : mTerrain(terrain)
+        , mSize(size)
+        , mCenter(center)
+        , mResult(result)
+    {
+    }
+
+    virtual void doWork()
+    {
+        try
+        {
+            mTerrain->buildChunk(mSize, mCenter, *mResult);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to build terrain: " << e.what() << std::endl;
+        }
+        mTicket->signalDone();
+    }
+
+private:
+    QuadTreeWorld* mTerrain;
+    float mSize;
+    osg::Vec2f mCenter;
+    osg::ref_ptr<BuiltChunk> mResult;
+};
+
+QuadTreeWorld::QuadTreeWorld(osg::Group *parent, Resource::ResourceSystem *resourceSystem, osgUtil::IncrementalCompileOperation *ico,
+                             Storage *storage, int nodeMask)
+    : Terrain::World(parent, resourceSystem, ico, storage, nodeMask)
+    , mRootsCreated(false)
+    , mRootSize(16.f)
+    , mMinSize(0.25f)
+    , mRootOriginX(0)
+    , mRootOriginY(0)
+    , mNumRootsX(0)
+    , mNumRootsY(0)
+    , mLodFactor(2.f)
+    , mViewDistance(std::numeric_limits<float>::max())
+    , mExpiryDelay(10.0)
+    , mLastCullTime(0.0)
+    , mSelectionNumber(0)
+{
+    // The chunks of every size have the vertices of the smallest chunks at full detail
+    mCache = BufferCache(static_cast<unsigned int>((storage->getCellVertices()-1)*mMinSize) + 1);
+
+    // Create the shared buffer now, so building chunks in the background only reads the cache.
+    // Index buffers are only created on the main thread.
+    mCache.getUVBuffer();
+
+    mTerrainRoot->addCullCallback(new QuadTreeCullCallback(this));
+    // The root has no bound until chunks are built, and it must be culled to request them
+    mTerrainRoot->setCullingActive(false);
+}
+
+QuadTreeWorld::~QuadTreeWorld()
+{
+    for (std::vector<QuadNode*>::iterator it = mLoaded.begin(); it != mLoaded.end(); ++it)
+    {
+        if ((*it)->mTicket)
+        {
+            (*it)->mTicket->cancel();
+            (*it)->mTicket->waitTillDone();
+        }
+    }
+
+    for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mCancelled.begin(); it != mCancelled.end(); ++it)
+        (*it)->waitTillDone();
+
+    mTerrainRoot->removeCullCallback(mTerrainRoot->getCullCallback());
+
+    for (std::vector<QuadNode*>::iterator it = mRoots.begin(); it != mRoots.end(); ++it)
+        delete *it;
+}
+
+void QuadTreeWorld::setViewDistance(float distance)
+{
+    mViewDistance = distance;
+}
+
+void QuadTreeWorld::createRoots()
+{
+    mRootsCreated = true;
+
+    float minX, maxX, minY, maxY;
+    mStorage->getBounds(minX, maxX, minY, maxY);
+
+    mRootOriginX = static_cast<int>(std::floor(minX / mRootSize) * mRootSize);
+    mRootOriginY = static_cast<int>(std::floor(minY / mRootSize) * mRootSize);
+    mNumRootsX = std::max(1, static_cast<int>(std::ceil((maxX - mRootOriginX) / mRootSize)));
+    mNumRootsY = std::max(1, static_cast<int>(std::ceil((maxY - mRootOriginY) / mRootSize)));
+
+    for (int y=0; y<mNumRootsY; ++y)
+        for (int x=0; x<mNumRootsX; ++x)
+        {
+            osg::Vec2f center (mRootOriginX + (x+0.5f)*mRootSize, mRootOriginY + (y+0.5f)*mRootSize);
+            mRoots.push_back(new QuadNode(center, mRootSize));
+        }
+}
+
+osg::Vec4f QuadTreeWorld::getLayerColor(const std::string &texture)
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mLayerColorMutex);
+        std::map<std::string, osg::Vec4f>::const_iterator found = mLayerColors.find(texture);
+        if (found != mLayerColors.end())
+            return found->second;
+    }
+
+    osg::Vec4f color (0.5f, 0.5f, 0.5f, 1.f);
+    osg::ref_ptr<osg::Image> image = mResourceSystem->getTextureManager()->getImage(texture);
+    if (image && image->s() > 0 && image->t() > 0)
+        color = getAverageColor(*image);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mLayerColorMutex);
+    mLayerColors[texture] = color;
+    return color;
+}
+
+osg::ref_ptr<osg::Node> QuadTreeWorld::createCompositeMaterial(float size, const osg::Vec2f& center)
+{
+    const int cells = static_cast<int>(size);
+    const int texelsPerCell = ESM::Land::LAND_TEXTURE_SIZE;
+    osg::Vec2f origin = center - osg::Vec2f(size/2.f, size/2.f);
+
+    osg::ref_ptr<osg::Image> image (new osg::Image);
+    image->allocateImage(cells*texelsPerCell, cells*texelsPerCell, 1, GL_RGB, GL_UNSIGNED_BYTE);
+
+    for (int cellY=0; cellY<cells; ++cellY)
+        for (int cellX=0; cellX<cells; ++cellX)
+        {
+            std::vector<LayerInfo> layerList;
+            std::vector<osg::ref_ptr<osg::Image> > blendmaps;
+            mStorage->getBlendmaps(1.f, origin + osg::Vec2f(cellX+0.5f, cellY+0.5f), false, blendmaps, layerList);
+
+            std::vector<osg::Vec4f> layerColors;
+            for (std::vector<LayerInfo>::const_iterator it = layerList.begin(); it != layerList.end(); ++it)
+                layerColors.push_back(getLayerColor(it->mDiffuseMap));
+
+            for (int y=0; y<texelsPerCell; ++y)
+                for (int x=0; x<texelsPerCell; ++x)
+                {
+                    // The first layer is the base, the blendmaps are for the layers after it
+                    osg::Vec4f color = layerColors.empty() ? osg::Vec4f(0.5f, 0.5f, 0.5f, 1.f) : layerColors[0];
+                    for (unsigned int i=0; i<blendmaps.size() && i+1<layerColors.size(); ++i)
+                    {
+                        float blend = *blendmaps[i]->data(x, y) / 255.f;
+                        color = color * (1.f - blend) + layerColors[i+1] * blend;
+                    }
+
+                    unsigned char* texel = image->data(cellX*texelsPerCell + x, cellY*texelsPerCell + y);
+                    for (int i=0; i<3; ++i)
+                        texel[i] = static_cast<unsigned char>(osg::clampBetween(color[i], 0.f, 1.f) * 255);
+                }
+        }
+
+    osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D);
+    texture->setImage(image);
+    texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+    texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+
+    osg::ref_ptr<osg::Group> group (new osg::Group);
+    osg::StateSet* stateset = group->getOrCreateStateSet();
+    stateset->setTextureAttributeAndModes(0, texture);
+    osg::ref_ptr<osg::Material> material (new osg::Material);
+    material->setColorMode(osg::Material::AMBIENT_AND_DIFFUSE);
+    stateset->setAttributeAndModes(material, osg::StateAttribute::ON);
+    return group;
+}
+
+void QuadTreeWorld::buildChunk(float size, const osg::Vec2f &center, BuiltChunk &result)
+{
+    osg::Vec2f origin = center - osg::Vec2f(size/2.f, size/2.f);
+
+    // getMinMaxHeights only takes chunks of up to one cell
+    float minH = std::numeric_limits<float>::max();
+    float maxH = -std::numeric_limits<float>::max();
+    bool hasLand = false;
+    bool hasHoles = false;
+    if (size <= 1.f)
+        hasLand = mStorage->getMinMaxHeights(size, center, minH, maxH);
+    else
+    {
+        for (int y=0; y<size; ++y)
+            for (int x=0; x<size; ++x)
+            {
+                float cellMin, cellMax;
+                if (mStorage->getMinMaxHeights(1.f, origin + osg::Vec2f(x+0.5f, y+0.5f), cellMin, cellMax))
+                {
+                    hasLand = true;
+                    minH = std::min(minH, cellMin);
+                    maxH = std::max(maxH, cellMax);
+                }
+                else
+                    hasHoles = true;
+            }
+    }
+
+    if (!hasLand)
+        return; // no terrain defined
+
+    if (hasHoles)
+    {
+        // Where the land is missing, fillVertexBuffers uses this height
+        minH = std::min(minH, -2048.f);
+        maxH = std::max(maxH, -2048.f);
+    }
+
+    result.mEmpty = false;
+    result.mMinHeight = minH;
+    result.mMaxHeight = maxH;
+
+    osg::Vec2f worldCenter = center*mStorage->getCellWorldSize();
+    osg::ref_ptr<SceneUtil::PositionAttitudeTransform> transform (new SceneUtil::PositionAttitudeTransform);
+    transform->setPosition(osg::Vec3f(worldCenter.x(), worldCenter.y(), 0.f));
+
+    osg::ref_ptr<osg::Vec3Array> positions (new osg::Vec3Array);
+    osg::ref_ptr<osg::Vec3Array> normals (new osg::Vec3Array);
+    osg::ref_ptr<osg::Vec4Array> colors (new osg::Vec4Array);
+
+    osg::ref_ptr<osg::VertexBufferObject> vbo (new osg::VertexBufferObject);
+    positions->setVertexBufferObject(vbo);
+    normals->setVertexBufferObject(vbo);
+    colors->setVertexBufferObject(vbo);
+
+    // Keep every 2^lodLevel-th vertex, so that the chunk has as many vertices as the smallest chunks
+    int lodLevel = 0;
+    while (size / mMinSize > (1 << lodLevel))
+        ++lodLevel;
+    mStorage->fillVertexBuffers(lodLevel, size, center, positions, normals, colors);
+
+    osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry);
+    geometry->setVertexArray(positions);
+    geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+    geometry->setColorArray(colors, osg::Array::BIND_PER_VERTEX);
+    geometry->setUseDisplayList(false);
+    geometry->setUseVertexBufferObjects(true);
+
+    // use texture coordinates for both texture units, the layer texture and blend texture
+    for (unsigned int i=0; i<2; ++i)
+        geometry->setTexCoordArray(i, mCache.getUVBuffer());
+
+    // we already know the bounding box, so no need to let OSG compute it.
+    float halfSize = 0.5f*mStorage->getCellWorldSize()*size;
+    osg::BoundingBox bounds(osg::Vec3f(-halfSize, -halfSize, minH), osg::Vec3f(halfSize, halfSize, maxH));
+    geometry->setComputeBoundingBoxCallback(new StaticBoundingBoxCallback(bounds));
+
+    // For compiling textures, I don't think the osgFX::Effect does it correctly
+    osg::ref_ptr<osg::Node> textureCompileDummy (new osg::Node);
+
+    osg::ref_ptr<osg::Node> material;
+    if (size <= 1.f)
+        material = createLayerEffect(size, center, textureCompileDummy);
+    else
+        material = createCompositeMaterial(size, center);
+
+    material->addCullCallback(new SceneUtil::LightListCallback);
+    transform->addChild(material);
+
+    osg::ref_ptr<osg::Switch> lodSwitch (new osg::Switch);
+    material->asGroup()->addChild(lodSwitch);
+
+    if (mIncrementalCompileOperation)
+    {
+        mIncrementalCompileOperation->add(material);
+        mIncrementalCompileOperation->add(textureCompileDummy);
+    }
+
+    result.mNode = transform;
+    result.mGeometry = geometry;
+    result.mLodSwitch = lodSwitch;
+}
+
+void QuadTreeWorld::request(QuadNode *node)
+{
+    node->mLastUsed = mLastCullTime;
+    if (node->mChunk)
+        return;
+
+    // The land data is loaded on the main thread, since building the chunk only reads it
+    osg::Vec2f origin = node->mCenter - osg::Vec2f(node->mSize/2.f, node->mSize/2.f);
+    int startX = static_cast<int>(std::floor(origin.x()));
+    int startY = static_cast<int>(std::floor(origin.y()));
+    int cells = std::max(1, static_cast<int>(node->mSize));
+    for (int y=startY; y<startY+cells; ++y)
+        for (int x=startX; x<startX+cells; ++x)
+            mStorage->loadCell(x, y);
+
+    node->mChunk = new BuiltChunk;
+    node->mChunk->setThreadSafeRefUnref(true);
+
+    if (mWorkQueue)
+    {
+        // Like the terrain of the TerrainGrid, before the scenes loaded in the background
+        node->mTicket = mWorkQueue->addWorkItem(new BuildChunkItem(this, node->mSize, node->mCenter, node->mChunk), 1);
+        mLoaded.push_back(node);
+    }
+    else
+    {
+        buildChunk(node->mSize, node->mCenter, *node->mChunk);
+        if (attachChunk(node))
+            mLoaded.push_back(node);
+    }
+}
+
+bool QuadTreeWorld::attachChunk(QuadNode *node)
+{
+    node->mTicket = NULL;
+
+    BuiltChunk* chunk = node->mChunk;
+    node->mBoundsKnown = !chunk->mEmpty;
+    node->mMinHeight = chunk->mMinHeight;
+    node->mMaxHeight = chunk->mMaxHeight;
+
+    if (chunk->mEmpty || !chunk->mNode)
+    {
+        node->mEmpty = chunk->mEmpty;
+        node->mChunk = NULL;
+        return false;
+    }
+
+    mTerrainRoot->addChild(chunk->mNode);
+    return true;
+}
+
+void QuadTreeWorld::update()
+{
+    if (!mRootsCreated)
+        createRoots();
+
+    std::vector<QuadNode*> loaded;
+    loaded.reserve(mLoaded.size());
+    for (std::vector<QuadNode*>::iterator it = mLoaded.begin(); it != mLoaded.end(); ++it)
+    {
+        QuadNode* node = *it;
+        bool expired = mLastCullTime - node->mLastUsed > mExpiryDelay;
+        if (node->mTicket)
+        {
+            if (node->mTicket->isDone())
+            {
+                if (attachChunk(node))
+                    loaded.push_back(node);
+            }
+            else if (expired)
+            {
+                node->mTicket->cancel();
+                mCancelled.push_back(node->mTicket);
+                node->mTicket = NULL;
+                node->mChunk = NULL;
+            }
+            else
+                loaded.push_back(node);
+        }
+        else if (expired)
+        {
+            mTerrainRoot->removeChild(node->mChunk->mNode);
+            node->mChunk = NULL;
+        }
+        else
+            loaded.push_back(node);
+    }
+    mLoaded.swap(loaded);
+
+    for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mCancelled.begin(); it != mCancelled.end();)
+    {
+        if ((*it)->isDone())
+            it = mCancelled.erase(it);
+        else
+            ++it;
+    }
+}
+
+float QuadTreeWorld::getDistance(const QuadNode *node, const osg::Vec3f &point) const
+{
+    float cellWorldSize = mStorage->getCellWorldSize();
+    float halfSize = node->mSize * cellWorldSize / 2.f;
+    osg::Vec2f center = node->mCenter * cellWorldSize;
+
+    float dx = std::max(0.f, std::abs(point.x() - center.x()) - halfSize);
+    float dy = std::max(0.f, std::abs(point.y() - center.y()) - halfSize);
+    float dz = 0.f;
+    if (node->mBoundsKnown)
+        dz = std::max(0.f, std::max(node->mMinHeight - point.z(), point.z() - node->mMaxHeight));
+    return std::sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+bool QuadTreeWorld::select(QuadNode *node, const osg::Vec3f &eyePoint)
+{
+    if (node->mEmpty)
+        return true;
+
+    float distance = getDistance(node, eyePoint);
+    if (distance > mViewDistance)
+        return true;
+
+    if (node->mSize > mMinSize && distance < node->mSize * mStorage->getCellWorldSize() * mLodFactor)
+    {
+        if (!node->mChildren[0])
+        {
+            float offset = node->mSize / 4.f;
+            for (int i=0; i<4; ++i)
+                node->mChildren[i] = new QuadNode(node->mCenter + osg::Vec2f((i&1) ? offset : -offset, (i&2) ? offset : -offset),
+                                                  node->mSize / 2.f);
+        }
+
+        size_t start = mSelection.size();
+        bool covered = true;
+        // Select all children, even once one is not covered, so that all of them are requested
+        for (int i=0; i<4; ++i)
+            covered = select(node->mChildren[i], eyePoint) && covered;
+        if (covered)
+            return true;
+
+        if (!node->mChunk || node->mTicket)
+            return false; // Better part of the area than none of it
+
+        // Draw this chunk until all children are built
+        for (size_t i=start; i<mSelection.size(); ++i)
+            mSelection[i]->mSelected = 0;
+        mSelection.resize(start);
+    }
+
+    if (node->mChunk && !node->mTicket)
+    {
+        node->mLastUsed = mLastCullTime;
+        node->mSelected = mSelectionNumber;
+        mSelection.push_back(node);
+        return true;
+    }
+
+    request(node);
+    return false;
+}
+
+float QuadTreeWorld::getSelectedSize(const osg::Vec2f &point) const
+{
+    int rootX = static_cast<int>(std::floor((point.x() - mRootOriginX) / mRootSize));
+    int rootY = static_cast<int>(std::floor((point.y() - mRootOriginY) / mRootSize));
+    if (rootX < 0 || rootY < 0 || rootX >= mNumRootsX || rootY >= mNumRootsY)
+        return 0.f;
+
+    const QuadNode* node = mRoots[rootY * mNumRootsX + rootX];
+    while (node)
+    {
+        if (node->mSelected == mSelectionNumber)
+            return node->mSize;
+        if (!node->mChildren[0])
+            return 0.f;
+        node = node->mChildren[(point.x() >= node->mCenter.x() ? 1 : 0) + (point.y() >= node->mCenter.y() ? 2 : 0)];
+    }
+    return 0.f;
+}
+
+unsigned int QuadTreeWorld::getLodFlags(const QuadNode *node) const
+{
+    // Just across the middle of each edge
+    float distance = node->mSize/2.f + mMinSize/2.f;
+    osg::Vec2f neighbours[4];
+    neighbours[North] = node->mCenter + osg::Vec2f(0.f, distance);
+    neighbours[East] = node->mCenter + osg::Vec2f(distance, 0.f);
+    neighbours[South] = node->mCenter + osg::Vec2f(0.f, -distance);
+    neighbours[West] = node->mCenter + osg::Vec2f(-distance, 0.f);
+
+    // The edges have (cell vertices - 1) * min size segments, and can be stitched to at most one segment
+    int maxDelta = 0;
+    while ((1 << (maxDelta+1)) <= (mStorage->getCellVertices()-1)*mMinSize)
+        ++maxDelta;
+
+    unsigned int flags = 0;
+    for (int i=0; i<4; ++i)
+    {
+        float neighbourSize = getSelectedSize(neighbours[i]);
+        if (neighbourSize <= node->mSize)
+            continue; // the finer chunk stitches the edge
+
+        int delta = 0;
+        while (node->mSize * (1 << delta) < neighbourSize && delta < maxDelta)
+            ++delta;
+        flags |= delta << (4*i);
+    }
+    return flags;
+}
+
+void QuadTreeWorld::drawChunk(QuadNode *node, unsigned int lodFlags, osgUtil::CullVisitor *cv)
+{
+    float cellWorldSize = mStorage->getCellWorldSize();
+    float halfSize = node->mSize * cellWorldSize / 2.f;
+    osg::Vec2f center = node->mCenter * cellWorldSize;
+    osg::BoundingBox bounds(osg::Vec3f(center.x() - halfSize, center.y() - halfSize, node->mMinHeight),
+                            osg::Vec3f(center.x() + halfSize, center.y() + halfSize, node->mMaxHeight));
+    if (cv->isCulled(bounds))
+        return;
+
+    BuiltChunk* chunk = node->mChunk;
+    std::map<unsigned int, unsigned int>::const_iterator found = chunk->mVariants.find(lodFlags);
+    unsigned int index;
+    if (found != chunk->mVariants.end())
+        index = found->second;
+    else
+    {
+        osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry(*chunk->mGeometry, osg::CopyOp::SHALLOW_COPY));
+        geometry->addPrimitiveSet(mCache.getIndexBuffer(lodFlags));
+
+#if OSG_VERSION_GREATER_OR_EQUAL(3,3,3)
+        osg::ref_ptr<osg::Node> variant = geometry;
+#else
+        osg::ref_ptr<osg::Geode> variant (new osg::Geode);
+        variant->addDrawable(geometry);
+#endif
+        index = chunk->mLodSwitch->getNumChildren();
+        chunk->mLodSwitch->addChild(variant, false);
+        chunk->mVariants[lodFlags] = index;
+    }
+
+    chunk->mLodSwitch->setSingleChildOn(index);
+    chunk->mNode->accept(*cv);
+}
+
+void QuadTreeWorld::cull(osgUtil::CullVisitor *cv)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mCullMutex);
+
+    if (cv->getFrameStamp())
+        mLastCullTime = cv->getFrameStamp()->getReferenceTime();
+
+    if (++mSelectionNumber == 0)
+        mSelectionNumber = 1;
+    mSelection.clear();
+
+    osg::Vec3f eyePoint = cv->getEyePoint();
+    for (std::vector<QuadNode*>::iterator it = mRoots.begin(); it != mRoots.end(); ++it)
+        select(*it, eyePoint);
+
+    for (std::vector<QuadNode*>::iterator it = mSelection.begin(); it != mSelection.end(); ++it)
+        drawChunk(*it, getLodFlags(*it), cv);
+}
+
+}
@@ -0,0 +1,131 @@
+#ifndef COMPONENTS_TERRAIN_QUADTREEWORLD_H
+#define COMPONENTS_TERRAIN_QUADTREEWORLD_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <OpenThreads/Mutex>
+
+#include <osg/Vec2f>
+#include <osg/Vec4f>
+
+#include "world.hpp"
+
+namespace osg
+{
+    class Node;
+}
+
+namespace osgUtil
+{
+    class CullVisitor;
+}
+
+namespace SceneUtil
+{
+    class WorkTicket;
+}
+
+namespace Terrain
+{
+
+    class BuiltChunk;
+
+    /// @brief Terrain implementation that covers the whole world with a quad tree of chunks. Chunks further away from the
+    /// camera cover a larger area with the same number of vertices, so that distant land is cheap to draw.
+    /// @par The chunks are selected per camera while culling, and built on the work queue when they are first needed.
+    /// Until a chunk is built, the coarser chunk covering it is drawn instead. Edges towards coarser chunks are stitched
+    /// with the index buffers of the BufferCache, so that there are no cracks.
+    /// @par Chunks of up to one cell are textured with the blended layers like the TerrainGrid. Larger chunks would need
+    /// too many layers, so they are textured with a composite map holding the average colour of each layer texture.
+    /// @par Chunks that were not drawn for a while are dropped. The loadCell() hints are ignored.
+    /// @note Not thread safe for CullThreadPerCamera threading mode.
+    class QuadTreeWorld : public Terrain::World
+    {
+    public:
+        QuadTreeWorld(osg::Group* parent, Resource::ResourceSystem* resourceSystem, osgUtil::IncrementalCompileOperation* ico,
+                      Storage* storage, int nodeMask);
+        ~QuadTreeWorld();
+
+        virtual void setViewDistance(float distance);
+
+        /// Attaches the chunks that were built in the background, and drops the chunks that were not drawn for a while.
+        virtual void update();
+
+        /// Select and draw the chunks for the camera of the given cull visitor.
+        /// @note Called by the cull callback of the terrain root.
+        void cull(osgUtil::CullVisitor* cv);
+
+    private:
+        struct QuadNode;
+
+        class BuildChunkItem;
+
+        /// @note Only uses thread safe parts of the storage and resource system, so it can be called in the background.
+        void buildChunk(float size, const osg::Vec2f& center, BuiltChunk& result);
+
+        osg::ref_ptr<osg::Node> createCompositeMaterial(float size, const osg::Vec2f& center);
+
+        /// The average colour of a layer texture, for composite maps. Thread safe.
+        osg::Vec4f getLayerColor(const std::string& texture);
+
+        /// Add the chunks of the node or its children to draw to mSelection.
+        /// @return Is the area of the node covered by the selected chunks?
+        bool select(QuadNode* node, const osg::Vec3f& eyePoint);
+
+        /// Request the chunk of the node to be built.
+        void request(QuadNode* node);
+
+        /// The size of the selected chunk that contains the given point, or 0 if there is none.
+        float getSelectedSize(const osg::Vec2f& point) const;
+
+        /// The LOD flags of the index buffer stitching the edges of the node to its neighbours.
+        unsigned int getLodFlags(const QuadNode* node) const;
+
+        void drawChunk(QuadNode* node, unsigned int lodFlags, osgUtil::CullVisitor* cv);
+
+        /// Add the built chunk of the node to the scene.
+        /// @return false if the chunk has no terrain, and was dropped.
+        bool attachChunk(QuadNode* node);
+
+        void createRoots();
+
+        float getDistance(const QuadNode* node, const osg::Vec3f& point) const;
+
+        // Created by the first update(), since the terrain bounds are not known before the content files are loaded
+        std::vector<QuadNode*> mRoots;
+        bool mRootsCreated;
+        float mRootSize;
+        float mMinSize;
+        int mRootOriginX;
+        int mRootOriginY;
+        int mNumRootsX;
+        int mNumRootsY;
+
+        // Chunks are subdivided while the camera is closer than their size times this factor
+        float mLodFactor;
+        float mViewDistance;
+
+        // Seconds until chunks that are not drawn are dropped
+        double mExpiryDelay;
+        double mLastCullTime;
+
+        // Incremented for each cull, to tell the nodes selected by the current cull
+        unsigned int mSelectionNumber;
+        std::vector<QuadNode*> mSelection;
+        // Cameras culled in parallel take turns selecting and drawing the chunks
+        OpenThreads::Mutex mCullMutex;
+
+        // The nodes with a chunk, built or pending
+        std::vector<QuadNode*> mLoaded;
+        // Builds that were dropped before they were done. They still use this object, so the destructor waits for them.
+        std::vector<osg::ref_ptr<SceneUtil::WorkTicket> > mCancelled;
+
+        std::map<std::string, osg::Vec4f> mLayerColors;
+        OpenThreads::Mutex mLayerColorMutex;
+    };
+
+}
+
+#endif
@@ -27,6 +27,10 @@ namespace Terrain
         /// Get bounds of the whole terrain in cell units
         virtual void getBounds(float& minX, float& maxX, float& minY, float& maxY) = 0;
 
+        /// Load whatever data is needed to build the terrain of this cell, so that it can be built in a background thread.
+        /// @note Called from the main thread, before building the terrain of the cell in the background.
+        virtual void loadCell(int cellX, int cellY) {}
+
         /// Get the minimum and maximum heights of a terrain region.
         /// @note Will only be called for chunks with size = minBatchSize, i.e. leafs of the quad tree.
         ///        Larger chunks can simply merge AABB of children.
@@ -1,12 +1,14 @@
 #include "terraingrid.hpp"
 
 #include <memory>
+#include <iostream>
 
 #include <components/resource/resourcesystem.hpp>
 #include <components/resource/texturemanager.hpp>
 
 #include <components/sceneutil/lightmanager.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
+#include <components/sceneutil/workqueue.hpp>
 
 #include <components/esm/loadland.hpp>
 
@@ -52,10 +54,27 @@ TerrainGrid::TerrainGrid(osg::Group* parent, Resource::ResourceSystem* resourceS
     , mKdTreeBuilder(new osg::KdTreeBuilder)
 {
     mCache = BufferCache((storage->getCellVertices()-1)/static_cast<float>(mNumSplits) + 1);
+
+    // Create the shared buffers now, so building terrain in the background only reads the cache
+    mCache.getIndexBuffer(0);
+    mCache.getUVBuffer();
 }
 
 TerrainGrid::~TerrainGrid()
 {
+    for (PendingGrid::iterator it = mPending.begin(); it != mPending.end(); ++it)
+    {
+        it->second.mTicket->cancel();
+        it->second.mTicket->waitTillDone();
+    }
+    mPending.clear();
+
+    while (!mPreloaded.empty())
+        clearPreloadedCell(mPreloaded.begin()->first.first, mPreloaded.begin()->first.second);
+
+    for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mCancelled.begin(); it != mCancelled.end(); ++it)
+        (*it)->waitTillDone();
+
     while (!mGrid.empty())
     {
         unloadCell(mGrid.begin()->first.first, mGrid.begin()->first.second);
@@ -68,6 +87,41 @@ public:
     osg::ref_ptr<osg::Node> mNode;
 };
 
+class BuiltTerrain : public osg::Referenced
+{
+public:
+    osg::ref_ptr<osg::Node> mNode;
+};
+
+class TerrainGrid::BuildTerrainItem : public SceneUtil::WorkItem
+{
+public:
+    BuildTerrainItem(TerrainGrid* terrain, const osg::Vec2f& center, BuiltTerrain* result)
+        : mTerrain(terrain)
+        , mCenter(center)
+        , mResult(result)
+    {
+    }
+
+    virtual void doWork()
+    {
+        try
+        {
+            mResult->mNode = mTerrain->buildTerrain(NULL, 1.f, mCenter);
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Failed to build terrain: " << e.what() << std::endl;
+        }
+        mTicket->signalDone();
+    }
+
+private:
+    TerrainGrid* mTerrain;
+    osg::Vec2f mCenter;
+    osg::ref_ptr<BuiltTerrain> mResult;
+};
+
 osg::ref_ptr<osg::Node> TerrainGrid::buildTerrain (osg::Group* parent, float chunkSize, const osg::Vec2f& chunkCenter)
 {
     if (chunkSize * mNumSplits > 1.f)
@@ -127,41 +181,14 @@ osg::ref_ptr<osg::Node> TerrainGrid::buildTerrain (osg::Group* parent, float chu
         osg::BoundingBox bounds(min, max);
         geometry->setComputeBoundingBoxCallback(new StaticBoundingBoxCallback(bounds));
 
-        std::vector<LayerInfo> layerList;
-        std::vector<osg::ref_ptr<osg::Image> > blendmaps;
-        mStorage->getBlendmaps(chunkSize, chunkCenter, false, blendmaps, layerList);
-
-        // For compiling textures, I don't think the osgFX::Effect does it correctly
-        osg::ref_ptr<osg::Node> textureCompileDummy (new osg::Node);
-
-        std::vector<osg::ref_ptr<osg::Texture2D> > layerTextures;
-        for (std::vector<LayerInfo>::const_iterator it = layerList.begin(); it != layerList.end(); ++it)
-        {
-            layerTextures.push_back(mResourceSystem->getTextureManager()->getTexture2D(it->mDiffuseMap, osg::Texture::REPEAT, osg::Texture::REPEAT));
-            textureCompileDummy->getOrCreateStateSet()->setTextureAttributeAndModes(0, layerTextures.back());
-        }
-
-        std::vector<osg::ref_ptr<osg::Texture2D> > blendmapTextures;
-        for (std::vector<osg::ref_ptr<osg::Image> >::const_iterator it = blendmaps.begin(); it != blendmaps.end(); ++it)
-        {
-            osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D);
-            texture->setImage(*it);
-            texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
-            texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
-            texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
-            texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
-            texture->setResizeNonPowerOfTwoHint(false);
-            blendmapTextures.push_back(texture);
-
-            textureCompileDummy->getOrCreateStateSet()->setTextureAttributeAndModes(0, layerTextures.back());
-        }
-
         // use texture coordinates for both texture units, the layer texture and blend texture
         for (unsigned int i=0; i<2; ++i)
             geometry->setTexCoordArray(i, mCache.getUVBuffer());
 
-        float blendmapScale = ESM::Land::LAND_TEXTURE_SIZE*chunkSize;
-        osg::ref_ptr<osgFX::Effect> effect (new Terrain::Effect(layerTextures, blendmapTextures, blendmapScale, blendmapScale));
+        // For compiling textures, I don't think the osgFX::Effect does it correctly
+        osg::ref_ptr<osg::Node> textureCompileDummy (new osg::Node);
+
+        osg::ref_ptr<osg::Group> effect = createLayerEffect(chunkSize, chunkCenter, textureCompileDummy);
 
         effect->addCullCallback(new SceneUtil::LightListCallback);
 
@@ -189,15 +216,73 @@ osg::ref_ptr<osg::Node> TerrainGrid::buildTerrain (osg::Group* parent, float chu
 
 void TerrainGrid::loadCell(int x, int y)
 {
-    if (mGrid.find(std::make_pair(x, y)) != mGrid.end())
+    std::pair<int, int> key = std::make_pair(x, y);
+    if (mGrid.find(key) != mGrid.end() || mPending.find(key) != mPending.end())
         return; // already loaded
 
-    osg::Vec2f center(x+0.5f, y+0.5f);
+    // A preload that is not done yet may be queued behind many others, so build the terrain again instead of waiting for it
+    PendingGrid::iterator preloaded = mPreloaded.find(key);
+    if (preloaded != mPreloaded.end() && preloaded->second.mTicket->isDone())
+    {
+        mPending[key] = preloaded->second;
+        mPreloaded.erase(preloaded);
+        return;
+    }
 
-    osg::ref_ptr<osg::Node> terrainNode = buildTerrain(NULL, 1.f, center);
+    if (mWorkQueue)
+    {
+        // Before the scenes loaded in the background, so that the terrain of loaded cells is attached first
+        mPending[key] = buildTerrainAsync(x, y, 1);
+        return;
+    }
+
+    osg::ref_ptr<osg::Node> terrainNode = buildTerrain(NULL, 1.f, osg::Vec2f(x+0.5f, y+0.5f));
     if (!terrainNode)
         return; // no terrain defined
 
+    addCell(x, y, terrainNode);
+}
+
+TerrainGrid::PendingCell TerrainGrid::buildTerrainAsync(int x, int y, int priority)
+{
+    mStorage->loadCell(x, y);
+
+    PendingCell pending;
+    pending.mResult = new BuiltTerrain;
+    pending.mResult->setThreadSafeRefUnref(true);
+    pending.mTicket = mWorkQueue->addWorkItem(new BuildTerrainItem(this, osg::Vec2f(x+0.5f, y+0.5f), pending.mResult), priority);
+    return pending;
+}
+
+void TerrainGrid::preloadCell(int x, int y)
+{
+    if (!mWorkQueue)
+        return;
+
+    std::pair<int, int> key = std::make_pair(x, y);
+    if (mGrid.find(key) != mGrid.end() || mPending.find(key) != mPending.end() || mPreloaded.find(key) != mPreloaded.end())
+        return;
+
+    // After everything that is needed right away
+    mPreloaded[key] = buildTerrainAsync(x, y, -1);
+}
+
+void TerrainGrid::clearPreloadedCell(int x, int y)
+{
+    PendingGrid::iterator preloaded = mPreloaded.find(std::make_pair(x,y));
+    if (preloaded == mPreloaded.end())
+        return;
+
+    if (!preloaded->second.mTicket->isDone())
+    {
+        preloaded->second.mTicket->cancel();
+        mCancelled.push_back(preloaded->second.mTicket);
+    }
+    mPreloaded.erase(preloaded);
+}
+
+void TerrainGrid::addCell(int x, int y, osg::Node* terrainNode)
+{
     std::auto_ptr<GridElement> element (new GridElement);
     element->mNode = terrainNode;
     mTerrainRoot->addChild(element->mNode);
@@ -212,8 +297,50 @@ void TerrainGrid::loadCell(int x, int y)
     mGrid[std::make_pair(x,y)] = element.release();
 }
 
+void TerrainGrid::update()
+{
+    for (PendingGrid::iterator it = mPending.begin(); it != mPending.end();)
+    {
+        if (!it->second.mTicket->isDone())
+        {
+            ++it;
+            continue;
+        }
+        if (it->second.mResult->mNode)
+            addCell(it->first.first, it->first.second, it->second.mResult->mNode);
+        mPending.erase(it++);
+    }
+
+    for (std::vector<osg::ref_ptr<SceneUtil::WorkTicket> >::iterator it = mCancelled.begin(); it != mCancelled.end();)
+    {
+        if ((*it)->isDone())
+            it = mCancelled.erase(it);
+        else
+            ++it;
+    }
+}
+
+void TerrainGrid::waitForLoadedCells()
+{
+    for (PendingGrid::iterator it = mPending.begin(); it != mPending.end(); ++it)
+        it->second.mTicket->waitTillDone();
+    update();
+}
+
 void TerrainGrid::unloadCell(int x, int y)
 {
+    PendingGrid::iterator pending = mPending.find(std::make_pair(x,y));
+    if (pending != mPending.end())
+    {
+        if (!pending->second.mTicket->isDone())
+        {
+            pending->second.mTicket->cancel();
+            mCancelled.push_back(pending->second.mTicket);
+        }
+        mPending.erase(pending);
+        return;
+    }
+
     Grid::iterator it = mGrid.find(std::make_pair(x,y));
     if (it == mGrid.end())
         return;
@@ -1,6 +1,9 @@
 #ifndef COMPONENTS_TERRAIN_TERRAINGRID_H
 #define COMPONENTS_TERRAIN_TERRAINGRID_H
 
+#include <map>
+#include <vector>
+
 #include <osg/Vec2f>
 
 #include "world.hpp"
@@ -11,12 +14,20 @@ namespace osg
     class KdTreeBuilder;
 }
 
+namespace SceneUtil
+{
+    class WorkTicket;
+}
+
 namespace Terrain
 {
 
     class GridElement;
+    class BuiltTerrain;
 
     /// @brief Simple terrain implementation that loads cells in a grid, with no LOD
+    /// @par With a work queue, the terrain of loaded cells is built in the background, and attached by the first update()
+    /// after it is done, so that loading a cell does not stall the frame.
     class TerrainGrid : public Terrain::World
     {
     public:
@@ -27,9 +38,37 @@ namespace Terrain
         virtual void loadCell(int x, int y);
         virtual void unloadCell(int x, int y);
 
+        /// Builds the terrain in the background, if there is a work queue.
+        virtual void preloadCell(int x, int y);
+        virtual void clearPreloadedCell(int x, int y);
+
+        /// Attaches the terrain that was built in the background.
+        virtual void update();
+
+        virtual void waitForLoadedCells();
+
     private:
+        /// @note Only uses thread safe parts of the storage and resource system, so it can be called in the background.
         osg::ref_ptr<osg::Node> buildTerrain (osg::Group* parent, float chunkSize, const osg::Vec2f& chunkCenter);
 
+        void addCell(int x, int y, osg::Node* terrainNode);
+
+        class BuildTerrainItem;
+
+        struct PendingCell
+        {
+            osg::ref_ptr<BuiltTerrain> mResult;
+            osg::ref_ptr<SceneUtil::WorkTicket> mTicket;
+        };
+
+        PendingCell buildTerrainAsync(int x, int y, int priority);
+        typedef std::map<std::pair<int, int>, PendingCell> PendingGrid;
+        PendingGrid mPending;
+        // Built by preloadCell(), moved to mPending by loadCell() once done
+        PendingGrid mPreloaded;
+        // Preloads that were dropped before they were done. They still use this object, so the destructor waits for them.
+        std::vector<osg::ref_ptr<SceneUtil::WorkTicket> > mCancelled;
+
         // split each ESM::Cell into mNumSplits*mNumSplits terrain chunks
         unsigned int mNumSplits;
 
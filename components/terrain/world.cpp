@@ -1,9 +1,20 @@
 #include "world.hpp"
 
+#include <sstream>
+
 #include <osg/Group>
+#include <osg/Program>
+#include <osg/Texture2D>
+#include <osg/Uniform>
 #include <osgUtil/IncrementalCompileOperation>
 
+#include <components/esm/loadland.hpp>
+
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/texturemanager.hpp>
+
 #include "storage.hpp"
+#include "material.hpp"
 
 namespace Terrain
 {
@@ -15,6 +26,8 @@ World::World(osg::Group* parent, Resource::ResourceSystem* resourceSystem, osgUt
     , mParent(parent)
     , mResourceSystem(resourceSystem)
     , mIncrementalCompileOperation(ico)
+    , mWorkQueue(NULL)
+    , mNodeMask(nodeMask)
 {
     mTerrainRoot = new osg::Group;
     mTerrainRoot->setNodeMask(nodeMask);
@@ -35,4 +48,76 @@ float World::getHeightAt(const osg::Vec3f &worldPos)
     return mStorage->getHeightAt(worldPos);
 }
 
+void World::setEnabled(bool enabled)
+{
+    mTerrainRoot->setNodeMask(enabled ? mNodeMask : 0);
+}
+
+void World::setWorkQueue(SceneUtil::WorkQueue *workQueue)
+{
+    mWorkQueue = workQueue;
+}
+
+void World::setShaderProgram(osg::Program *program)
+{
+    mShaderProgram = program;
+
+    // The texture units of ShaderTechnique, the same for every chunk
+    osg::StateSet* stateset = mTerrainRoot->getOrCreateStateSet();
+    for (unsigned int i=0; i<ShaderTechnique::getMaxLayers(); ++i)
+    {
+        std::ostringstream name;
+        name << "diffuseMap" << i;
+        stateset->addUniform(new osg::Uniform(name.str().c_str(), static_cast<int>(i)));
+    }
+    for (unsigned int i=0; i<(ShaderTechnique::getMaxLayers()+2)/4; ++i)
+    {
+        std::ostringstream name;
+        name << "blendMap" << i;
+        stateset->addUniform(new osg::Uniform(name.str().c_str(), static_cast<int>(ShaderTechnique::getMaxLayers() + i)));
+    }
+}
+
+osg::ref_ptr<osg::Group> World::createLayerEffect(float chunkSize, const osg::Vec2f &chunkCenter, osg::Node *textureCompileDummy)
+{
+    std::vector<LayerInfo> layerList;
+    std::vector<osg::ref_ptr<osg::Image> > blendmaps;
+    mStorage->getBlendmaps(chunkSize, chunkCenter, mShaderProgram != NULL, blendmaps, layerList);
+
+    osg::ref_ptr<osg::Program> program = mShaderProgram;
+    if (program && layerList.size() > ShaderTechnique::getMaxLayers())
+    {
+        // Too many layers for the shader, so blend them in passes
+        program = NULL;
+        layerList.clear();
+        blendmaps.clear();
+        mStorage->getBlendmaps(chunkSize, chunkCenter, false, blendmaps, layerList);
+    }
+
+    std::vector<osg::ref_ptr<osg::Texture2D> > layerTextures;
+    for (std::vector<LayerInfo>::const_iterator it = layerList.begin(); it != layerList.end(); ++it)
+    {
+        layerTextures.push_back(mResourceSystem->getTextureManager()->getTexture2D(it->mDiffuseMap, osg::Texture::REPEAT, osg::Texture::REPEAT));
+        textureCompileDummy->getOrCreateStateSet()->setTextureAttributeAndModes(0, layerTextures.back());
+    }
+
+    std::vector<osg::ref_ptr<osg::Texture2D> > blendmapTextures;
+    for (std::vector<osg::ref_ptr<osg::Image> >::const_iterator it = blendmaps.begin(); it != blendmaps.end(); ++it)
+    {
+        osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D);
+        texture->setImage(*it);
+        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+        texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+        texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        texture->setResizeNonPowerOfTwoHint(false);
+        blendmapTextures.push_back(texture);
+
+        textureCompileDummy->getOrCreateStateSet()->setTextureAttributeAndModes(0, layerTextures.back());
+    }
+
+    float blendmapScale = ESM::Land::LAND_TEXTURE_SIZE*chunkSize;
+    return new Terrain::Effect(layerTextures, blendmapTextures, blendmapScale, blendmapScale, program);
+}
+
 }
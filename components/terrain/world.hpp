@@ -9,6 +9,9 @@
 namespace osg
 {
     class Group;
+    class Node;
+    class Program;
+    class Vec2f;
 }
 
 namespace osgUtil
@@ -21,6 +24,11 @@ namespace Resource
     class ResourceSystem;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace Terrain
 {
     class Storage;
@@ -45,9 +53,41 @@ namespace Terrain
         virtual void loadCell(int x, int y) {}
         virtual void unloadCell(int x, int y) {}
 
+        /// Build the terrain of the given cell ahead of time, so that a later loadCell() only needs to attach it.
+        /// This is only a hint and may be ignored by the implementation.
+        virtual void preloadCell(int x, int y) {}
+        /// Drop the terrain built by preloadCell(), unless the cell was loaded meanwhile.
+        virtual void clearPreloadedCell(int x, int y) {}
+
+        /// Chunks further away from the camera are not drawn. Only used by implementations that page terrain by distance.
+        virtual void setViewDistance(float distance) {}
+
+        /// Show or hide all of the terrain. Enabled by default.
+        void setEnabled(bool enabled);
+
+        /// Attach the terrain of loaded cells that was built in the background meanwhile.
+        /// @note Call once per frame, before rendering.
+        virtual void update() {}
+
+        /// Wait for the terrain of all loaded cells to be built, and attach it. For when stalling is hidden anyway,
+        /// e.g. behind a loading screen.
+        virtual void waitForLoadedCells() {}
+
+        /// Set the queue to build terrain on in the background. By default terrain is built right away.
+        void setWorkQueue(SceneUtil::WorkQueue* workQueue);
+
+        /// Blend the layers of terrain built from now on in a single pass with the given program, see ShaderTechnique.
+        /// Chunks with too many layers still use the fixed function pipeline. By default, only that is used.
+        void setShaderProgram(osg::Program* program);
+
         Storage* getStorage() { return mStorage; }
 
     protected:
+        /// Create the node blending the texture layers of a chunk of up to one cell, with the textures to compile added
+        /// to \a textureCompileDummy.
+        /// @note Only uses thread safe parts of the storage and resource system, so it can be called in the background.
+        osg::ref_ptr<osg::Group> createLayerEffect(float chunkSize, const osg::Vec2f& chunkCenter, osg::Node* textureCompileDummy);
+
         Storage* mStorage;
 
         BufferCache mCache;
@@ -58,6 +98,12 @@ namespace Terrain
         Resource::ResourceSystem* mResourceSystem;
 
         osg::ref_ptr<osgUtil::IncrementalCompileOperation> mIncrementalCompileOperation;
+
+        SceneUtil::WorkQueue* mWorkQueue;
+
+        int mNodeMask;
+
+        osg::ref_ptr<osg::Program> mShaderProgram;
     };
 
 }
@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <stdexcept>
@@ -44,6 +46,34 @@
 
 using namespace ToUTF8;
 
+namespace
+{
+    /// Skip the ASCII characters at \a ptr, up to \a end or a zero terminator. Tests a machine
+    /// word at a time for a byte with the high bit set or a zero byte.
+    /// @return The first character that is not ASCII, or the terminator.
+    const char* skipAscii(const char* ptr, const char* end)
+    {
+        const size_t ones = ~static_cast<size_t>(0) / 0xff;
+        const size_t highBits = ones * 0x80;
+
+        while (end - ptr >= static_cast<ptrdiff_t>(sizeof(size_t)))
+        {
+            size_t word;
+            std::memcpy(&word, ptr, sizeof(word));
+            // The high bit of a byte is set in the second term if that byte is zero, or a byte
+            // before it is zero. Either way the word has to be scanned byte by byte.
+            if ((word | ((word - ones) & ~word)) & highBits)
+                break;
+            ptr += sizeof(size_t);
+        }
+
+        unsigned char ch = *ptr;
+        while (ch && ch < 128)
+            ch = *(++ptr);
+        return ptr;
+    }
+}
+
 Utf8Encoder::Utf8Encoder(const FromType sourceEncoding):
     mOutput(50*1024)
 {
@@ -78,6 +108,11 @@ Utf8Encoder::Utf8Encoder(const FromType sourceEncoding):
 }
 
 std::string Utf8Encoder::getUtf8(const char* input, size_t size)
+{
+    return getUtf8View(input, size).toString();
+}
+
+Misc::StringView Utf8Encoder::getUtf8View(const char* input, size_t size)
 {
     // Double check that the input string stops at some point (it might
     // contain zero terminators before this, inside its own data, which
@@ -93,19 +128,28 @@ std::string Utf8Encoder::getUtf8(const char* input, size_t size)
     // Compute output length, and check for pure ascii input at the same
     // time.
     bool ascii;
-    size_t outlen = getLength(input, ascii);
+    size_t outlen = getLength(input, size, ascii);
 
     // If we're pure ascii, then don't bother converting anything.
     if(ascii)
-        return std::string(input, outlen);
+        return Misc::StringView(input, outlen);
 
     // Make sure the output is large enough
     resize(outlen);
     char *out = &mOutput[0];
 
-    // Translate
+    // Translate, copying the ASCII runs at once
+    const char* end = input + size;
     while (*input)
-        copyFromArray(*(input++), out);
+    {
+        const char* run = skipAscii(input, end);
+        std::memcpy(out, input, run-input);
+        out += run-input;
+        input = run;
+
+        if (*input)
+            copyFromArray(*(input++), out);
+    }
 
     // Make sure that we wrote the correct number of bytes
     assert((out-&mOutput[0]) == (int)outlen);
@@ -114,8 +158,7 @@ std::string Utf8Encoder::getUtf8(const char* input, size_t size)
     assert(mOutput.size() > outlen);
     assert(mOutput[outlen] == 0);
 
-    // Return a string
-    return std::string(&mOutput[0], outlen);
+    return Misc::StringView(&mOutput[0], outlen);
 }
 
 std::string Utf8Encoder::getLegacyEnc(const char *input, size_t size)
@@ -134,7 +177,7 @@ std::string Utf8Encoder::getLegacyEnc(const char *input, size_t size)
     // Compute output length, and check for pure ascii input at the same
     // time.
     bool ascii;
-    size_t outlen = getLength2(input, ascii);
+    size_t outlen = getLength2(input, size, ascii);
 
     // If we're pure ascii, then don't bother converting anything.
     if(ascii)
@@ -182,17 +225,15 @@ void Utf8Encoder::resize(size_t size)
   is the case, then the ascii parameter is set to true, and the
   caller can optimize for this case.
  */
-size_t Utf8Encoder::getLength(const char* input, bool &ascii)
+size_t Utf8Encoder::getLength(const char* input, size_t size, bool &ascii)
 {
     ascii = true;
     size_t len = 0;
-    const char* ptr = input;
-    unsigned char inp = *ptr;
 
     // Do away with the ascii part of the string first (this is almost
     // always the entire string.)
-    while (inp && inp < 128)
-        inp = *(++ptr);
+    const char* ptr = skipAscii(input, input+size);
+    unsigned char inp = *ptr;
     len += (ptr-input);
 
     // If we're not at the null terminator at this point, then there
@@ -229,17 +270,15 @@ void Utf8Encoder::copyFromArray(unsigned char ch, char* &out)
         *(out++) = *(in++);
 }
 
-size_t Utf8Encoder::getLength2(const char* input, bool &ascii)
+size_t Utf8Encoder::getLength2(const char* input, size_t size, bool &ascii)
 {
     ascii = true;
     size_t len = 0;
-    const char* ptr = input;
-    unsigned char inp = *ptr;
 
     // Do away with the ascii part of the string first (this is almost
     // always the entire string.)
-    while (inp && inp < 128)
-        inp = *(++ptr);
+    const char* ptr = skipAscii(input, input+size);
+    unsigned char inp = *ptr;
     len += (ptr-input);
 
     // If we're not at the null terminator at this point, then there
@@ -5,6 +5,8 @@
 #include <cstring>
 #include <vector>
 
+#include <components/misc/stringview.hpp>
+
 namespace ToUTF8
 {
     // These are all the currently supported code pages
@@ -34,6 +36,11 @@ namespace ToUTF8
                 return getUtf8(str.c_str(), str.size());
             }
 
+            /// Like getUtf8(), but without creating a string. The result points either into the
+            /// input, if no conversion was needed, or into an internal buffer, which is only valid
+            /// until the next call to the encoder.
+            Misc::StringView getUtf8View(const char *input, size_t size);
+
             std::string getLegacyEnc(const char *input, size_t size);
             inline std::string getLegacyEnc(const std::string &str)
             {
@@ -42,9 +49,9 @@ namespace ToUTF8
 
         private:
             void resize(size_t size);
-            size_t getLength(const char* input, bool &ascii);
+            size_t getLength(const char* input, size_t size, bool &ascii);
             void copyFromArray(unsigned char chp, char* &out);
-            size_t getLength2(const char* input, bool &ascii);
+            size_t getLength2(const char* input, size_t size, bool &ascii);
             void copyFromArray2(const char*& chp, char* &out);
 
             std::vector<char> mOutput;
@@ -22,6 +22,7 @@ namespace VFS
         virtual ~Archive() {}
 
         /// List all resources contained in this archive, and run the resource names through the given normalize function.
+        /// @note May be called concurrently for different archives, so implementations must not touch shared state.
         virtual void listResources(std::map<std::string, File*>& out, char (*normalize_function) (char)) = 0;
     };
 
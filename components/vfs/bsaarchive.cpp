@@ -4,19 +4,32 @@ namespace VFS
 {
 
 
-BsaArchive::BsaArchive(const std::string &filename)
+BsaArchive::BsaArchive(const std::string &filename, bool mapIntoMemory)
+    : mFilename(filename)
+    , mMapIntoMemory(mapIntoMemory)
+    , mOpened(false)
 {
-    mFile.open(filename);
-
-    const Bsa::BSAFile::FileList &filelist = mFile.getList();
-    for(Bsa::BSAFile::FileList::const_iterator it = filelist.begin();it != filelist.end();++it)
-    {
-        mResources.push_back(BsaArchiveFile(&*it, &mFile));
-    }
 }
 
 void BsaArchive::listResources(std::map<std::string, File *> &out, char (*normalize_function)(char))
 {
+    // Reading the header is deferred to here, so archives can be opened concurrently by VFS::Manager::buildIndex
+    if (!mOpened)
+    {
+        mFile.open(mFilename);
+        if (mMapIntoMemory)
+            mFile.mapIntoMemory();
+
+        const Bsa::BSAFile::FileList &filelist = mFile.getList();
+        mResources.reserve(filelist.size());
+        for(Bsa::BSAFile::FileList::const_iterator it = filelist.begin();it != filelist.end();++it)
+        {
+            mResources.push_back(BsaArchiveFile(&*it, &mFile));
+        }
+
+        mOpened = true;
+    }
+
     for (std::vector<BsaArchiveFile>::iterator it = mResources.begin(); it != mResources.end(); ++it)
     {
         std::string ent = it->mInfo->name;
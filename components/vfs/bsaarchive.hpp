@@ -22,11 +22,16 @@ namespace VFS
     class BsaArchive : public Archive
     {
     public:
-        BsaArchive(const std::string& filename);
+        /// @param mapIntoMemory Map the whole archive into memory, so opened files are read without copies or syscalls.
+        BsaArchive(const std::string& filename, bool mapIntoMemory);
 
         virtual void listResources(std::map<std::string, File*>& out, char (*normalize_function) (char));
 
     private:
+        std::string mFilename;
+        bool mMapIntoMemory;
+        bool mOpened;
+
         Bsa::BSAFile mFile;
 
         std::vector<BsaArchiveFile> mResources;
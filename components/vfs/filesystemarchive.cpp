@@ -1,15 +1,64 @@
 #include "filesystemarchive.hpp"
 
+#include <stdexcept>
+
 #include <boost/filesystem.hpp>
 
+#include <components/files/directorycache.hpp>
+#include <components/files/lz4.hpp>
+#include <components/files/memorystream.hpp>
+#include <components/misc/stringops.hpp>
+
+namespace
+{
+    const char* const sCompressedExtension = ".lz4";
+    const size_t sCompressedExtensionSize = 4;
+
+    bool isCompressedName(const std::string& name)
+    {
+        return name.size() > sCompressedExtensionSize
+                && Misc::StringUtils::ciEqual(name.substr(name.size() - sCompressedExtensionSize), sCompressedExtension);
+    }
+}
+
 namespace VFS
 {
 
-    FileSystemArchive::FileSystemArchive(const std::string &path)
+    FileSystemArchive::FileSystemArchive(const std::string &path, Files::DirectoryCache* cache)
         : mBuiltIndex(false)
         , mPath(path)
+        , mCache(cache)
+    {
+
+    }
+
+    void FileSystemArchive::addDirectory(const boost::filesystem::path& directory, size_t prefix, char (*normalize_function) (char))
+    {
+        Files::DirectoryCache::Listing listing = mCache->getListing(directory);
+
+        for (std::vector<std::string>::const_iterator it = listing.mFiles.begin(); it != listing.mFiles.end(); ++it)
+            addFile((directory / *it).string(), prefix, normalize_function);
+
+        for (std::vector<std::string>::const_iterator it = listing.mDirectories.begin(); it != listing.mDirectories.end(); ++it)
+            addDirectory(directory / *it, prefix, normalize_function);
+    }
+
+    void FileSystemArchive::addFile(const std::string &proper, size_t prefix, char (*normalize_function)(char))
     {
+        const bool compressed = isCompressedName(proper);
 
+        FileSystemArchiveFile file(proper, compressed);
+
+        std::string searchable;
+
+        std::transform(proper.begin() + prefix, proper.end() - (compressed ? sCompressedExtensionSize : 0),
+                       std::back_inserter(searchable), normalize_function);
+
+        std::pair<index::iterator, bool> result = mIndex.insert (std::make_pair (searchable, file));
+
+        // Prefer the uncompressed variant
+        if (!result.second && result.first->second.isCompressed() && !compressed)
+            result.first->second = file;
     }
 
     void FileSystemArchive::listResources(std::map<std::string, File *> &out, char (*normalize_function)(char))
@@ -25,20 +74,17 @@ namespace VFS
             if (mPath.size () > 0 && mPath [prefix - 1] != '\\' && mPath [prefix - 1] != '/')
                 ++prefix;
 
-            for (directory_iterator i (mPath); i != end; ++i)
+            if (mCache)
+                addDirectory(mPath, prefix, normalize_function);
+            else
             {
-                if(boost::filesystem::is_directory (*i))
-                    continue;
-
-                std::string proper = i->path ().string ();
+                for (directory_iterator i (mPath); i != end; ++i)
+                {
+                    if(boost::filesystem::is_directory (*i))
+                        continue;
 
-                FileSystemArchiveFile file(proper);
-
-                std::string searchable;
-
-                std::transform(proper.begin() + prefix, proper.end(), std::back_inserter(searchable), normalize_function);
-
-                mIndex.insert (std::make_pair (searchable, file));
+                    addFile(i->path ().string (), prefix, normalize_function);
+                }
             }
 
             mBuiltIndex = true;
@@ -52,14 +98,40 @@ namespace VFS
 
     // ----------------------------------------------------------------------------------
 
-    FileSystemArchiveFile::FileSystemArchiveFile(const std::string &path)
+    FileSystemArchiveFile::FileSystemArchiveFile(const std::string &path, bool compressed)
         : mPath(path)
+        , mCompressed(compressed)
     {
     }
 
     Files::IStreamPtr FileSystemArchiveFile::open()
     {
-        return Files::openConstrainedFileStream(mPath.c_str());
+        if (!mCompressed)
+            return Files::openConstrainedFileStream(mPath.c_str());
+
+        std::vector<char> compressedData;
+        {
+            Files::IStreamPtr stream = Files::openConstrainedFileStream(mPath.c_str());
+            stream->seekg(0, std::ios_base::end);
+            compressedData.resize(stream->tellg());
+            stream->seekg(0, std::ios_base::beg);
+            if (!compressedData.empty())
+                stream->read(&compressedData[0], compressedData.size());
+            if (!stream->good() && !compressedData.empty())
+                throw std::runtime_error("Failed to read '" + mPath + "'");
+        }
+
+        Files::SharedBuffer buffer (new std::vector<char>);
+        try
+        {
+            Files::decompressLz4(compressedData.empty() ? NULL : &compressedData[0], compressedData.size(), *buffer);
+        }
+        catch (std::exception& e)
+        {
+            throw std::runtime_error(std::string(e.what()) + " in '" + mPath + "'");
+        }
+
+        return Files::IStreamPtr(new Files::ISharedMemStream(buffer));
     }
 
 }
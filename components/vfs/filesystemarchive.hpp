@@ -1,30 +1,51 @@
 #ifndef OPENMW_COMPONENTS_RESOURCE_FILESYSTEMARCHIVE_H
 #define OPENMW_COMPONENTS_RESOURCE_FILESYSTEMARCHIVE_H
 
+#include <boost/filesystem/path.hpp>
+
 #include "archive.hpp"
 
+namespace Files
+{
+    class DirectoryCache;
+}
+
 namespace VFS
 {
 
     class FileSystemArchiveFile : public File
     {
     public:
-        FileSystemArchiveFile(const std::string& path);
+        /// @param compressed The file is in the LZ4 frame format, and is decompressed in memory when opened.
+        FileSystemArchiveFile(const std::string& path, bool compressed = false);
 
         virtual Files::IStreamPtr open();
 
+        bool isCompressed() const { return mCompressed; }
+
     private:
         std::string mPath;
+        bool mCompressed;
 
     };
 
+    /// @brief Archive of the loose files in a directory on the file system.
+    /// @par Files with an additional .lz4 extension (e.g. "textures/tx_a.dds.lz4") are
+    /// listed without that extension and decompressed when opened. If a directory contains
+    /// both the compressed and the uncompressed variant, the uncompressed file is used.
     class FileSystemArchive : public Archive
     {
     public:
-        FileSystemArchive(const std::string& path);
+        /// @param cache Optional cache of directory listings to use instead of walking the directory tree.
+        /// Only used while building the index, i.e. during the first listResources() call.
+        FileSystemArchive(const std::string& path, Files::DirectoryCache* cache = NULL);
 
         virtual void listResources(std::map<std::string, File*>& out, char (*normalize_function) (char));
 
+    private:
+        void addDirectory(const boost::filesystem::path& directory, size_t prefix, char (*normalize_function) (char));
+
+        void addFile(const std::string& proper, size_t prefix, char (*normalize_function) (char));
 
     private:
         typedef std::map <std::string, FileSystemArchiveFile> index;
@@ -33,6 +54,8 @@ namespace VFS
         bool mBuiltIndex;
         std::string mPath;
 
+        Files::DirectoryCache* mCache;
+
     };
 
 }
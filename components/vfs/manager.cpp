@@ -2,6 +2,10 @@
 
 #include <cctype>
 #include <stdexcept>
+#include <algorithm>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 #include <components/misc/stringops.hpp>
 
@@ -26,6 +30,74 @@ namespace
         std::transform(path.begin(), path.end(), path.begin(), normalize_char);
     }
 
+    /// FNV-1a over the normalized characters of the name
+    size_t hash_path(const char* name, size_t length, char (*normalize_char)(char))
+    {
+        size_t hash = 2166136261u;
+        for (size_t i=0; i<length; ++i)
+        {
+            hash ^= static_cast<unsigned char>(normalize_char(name[i]));
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    /// Runs Archive::listResources for all archives on a number of threads, with a separate output map per archive.
+    class ListResourcesJob
+    {
+    public:
+        ListResourcesJob(const std::vector<VFS::Archive*>& archives, char (*normalize_function)(char))
+            : mArchives(archives)
+            , mNormalizeFunction(normalize_function)
+            , mNext(0)
+            , mResults(archives.size())
+        {
+        }
+
+        void run()
+        {
+            while (true)
+            {
+                size_t index;
+                {
+                    boost::mutex::scoped_lock lock(mMutex);
+                    if (mNext >= mArchives.size() || !mError.empty())
+                        return;
+                    index = mNext++;
+                }
+
+                try
+                {
+                    mArchives[index]->listResources(mResults[index], mNormalizeFunction);
+                }
+                catch (std::exception& e)
+                {
+                    boost::mutex::scoped_lock lock(mMutex);
+                    if (mError.empty())
+                        mError = e.what();
+                }
+            }
+        }
+
+        /// @note Only call once all threads have finished.
+        const std::vector<std::map<std::string, VFS::File*> >& getResults() const
+        {
+            if (!mError.empty())
+                throw std::runtime_error(mError);
+            return mResults;
+        }
+
+    private:
+        const std::vector<VFS::Archive*>& mArchives;
+        char (*mNormalizeFunction)(char);
+
+        boost::mutex mMutex;
+        size_t mNext;
+        std::string mError;
+
+        std::vector<std::map<std::string, VFS::File*> > mResults;
+    };
+
 }
 
 namespace VFS
@@ -33,12 +105,16 @@ namespace VFS
 
     Manager::Manager(bool strict)
         : mStrict(strict)
+        , mPrefetcher(64*1024*1024)
     {
 
     }
 
     Manager::~Manager()
     {
+        // The prefetch thread may still be reading from the archives
+        mPrefetcher.stop();
+
         for (std::vector<Archive*>::iterator it = mArchives.begin(); it != mArchives.end(); ++it)
             delete *it;
         mArchives.clear();
@@ -53,32 +129,145 @@ namespace VFS
     {
         mIndex.clear();
 
-        for (std::vector<Archive*>::const_iterator it = mArchives.begin(); it != mArchives.end(); ++it)
-            (*it)->listResources(mIndex, mStrict ? &strict_normalize_char : &nonstrict_normalize_char);
+        char (*normalize_char)(char) = mStrict ? &strict_normalize_char : &nonstrict_normalize_char;
+
+        // Archives are scanned concurrently, since directory walks are mostly waiting on the file system.
+        // The results are then merged in the order the archives were added, so later archives still take priority.
+        ListResourcesJob job(mArchives, normalize_char);
+        {
+            size_t numThreads = std::max(1u, boost::thread::hardware_concurrency());
+            numThreads = std::min(numThreads, mArchives.size());
+
+            boost::thread_group threads;
+            for (size_t i=1; i<numThreads; ++i)
+                threads.create_thread(boost::bind(&ListResourcesJob::run, &job));
+            job.run();
+            threads.join_all();
+        }
+
+        const std::vector<std::map<std::string, File*> >& results = job.getResults();
+        for (std::vector<std::map<std::string, File*> >::const_iterator it = results.begin(); it != results.end(); ++it)
+            for (std::map<std::string, File*>::const_iterator file = it->begin(); file != it->end(); ++file)
+                mIndex[file->first] = file->second;
+
+        size_t tableSize = 16;
+        while (tableSize <= mIndex.size() * 2)
+            tableSize *= 2;
+
+        HashEntry empty;
+        empty.mHash = 0;
+        empty.mName = NULL;
+        empty.mFile = NULL;
+        mHashIndex.assign(tableSize, empty);
+
+        const size_t mask = tableSize - 1;
+        for (std::map<std::string, File*>::const_iterator it = mIndex.begin(); it != mIndex.end(); ++it)
+        {
+            // the keys are already normalized, so they can be hashed as they are
+            size_t hash = hash_path(it->first.c_str(), it->first.size(), &strict_normalize_char);
+
+            size_t slot = hash & mask;
+            while (mHashIndex[slot].mFile)
+                slot = (slot + 1) & mask;
+
+            mHashIndex[slot].mHash = hash;
+            mHashIndex[slot].mName = &it->first;
+            mHashIndex[slot].mFile = it->second;
+        }
+    }
+
+    File* Manager::lookup(const char *name, size_t length) const
+    {
+        if (mHashIndex.empty())
+            return NULL;
+
+        char (*normalize_char)(char) = mStrict ? &strict_normalize_char : &nonstrict_normalize_char;
+
+        const size_t hash = hash_path(name, length, normalize_char);
+        const size_t mask = mHashIndex.size() - 1;
+
+        for (size_t slot = hash & mask; mHashIndex[slot].mFile; slot = (slot + 1) & mask)
+        {
+            const HashEntry& entry = mHashIndex[slot];
+            if (entry.mHash != hash || entry.mName->size() != length)
+                continue;
+
+            const char* key = entry.mName->c_str();
+            size_t i = 0;
+            while (i < length && normalize_char(name[i]) == key[i])
+                ++i;
+            if (i == length)
+                return entry.mFile;
+        }
+        return NULL;
     }
 
     Files::IStreamPtr Manager::get(const std::string &name) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
+        if (mPrefetcher.isActive())
+        {
+            std::string normalized = name;
+            normalize_path(normalized, mStrict);
+            return getNormalized(normalized);
+        }
 
-        return getNormalized(normalized);
+        File* file = lookup(name.c_str(), name.size());
+        if (!file)
+        {
+            std::string normalized = name;
+            normalize_path(normalized, mStrict);
+            throw std::runtime_error("Resource '" + normalized + "' not found");
+        }
+        return file->open();
     }
 
     Files::IStreamPtr Manager::getNormalized(const std::string &normalizedName) const
     {
-        std::map<std::string, File*>::const_iterator found = mIndex.find(normalizedName);
-        if (found == mIndex.end())
+        File* file = lookup(normalizedName.c_str(), normalizedName.size());
+        if (!file)
             throw std::runtime_error("Resource '" + normalizedName + "' not found");
-        return found->second->open();
+
+        if (mPrefetcher.isActive())
+        {
+            Files::IStreamPtr prefetched = mPrefetcher.take(normalizedName);
+            if (prefetched)
+                return prefetched;
+        }
+
+        return file->open();
+    }
+
+    void Manager::prefetch(const std::vector<std::string> &names) const
+    {
+        for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+        {
+            std::string normalized = *it;
+            normalize_path(normalized, mStrict);
+
+            File* file = lookup(normalized.c_str(), normalized.size());
+            if (file)
+                mPrefetcher.prefetch(normalized, file);
+        }
+    }
+
+    void Manager::setPrefetchBufferSize(size_t bytes)
+    {
+        mPrefetcher.setMaxBufferedBytes(bytes);
+    }
+
+    Prefetcher::Stats Manager::getPrefetchStats() const
+    {
+        return mPrefetcher.getStats();
     }
 
     bool Manager::exists(const std::string &name) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
+        return lookup(name.c_str(), name.size()) != NULL;
+    }
 
-        return mIndex.find(normalized) != mIndex.end();
+    bool Manager::exists(const char *name, size_t length) const
+    {
+        return lookup(name, length) != NULL;
     }
 
     const std::map<std::string, File*>& Manager::getIndex() const
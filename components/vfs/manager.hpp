@@ -6,6 +6,8 @@
 #include <vector>
 #include <map>
 
+#include "prefetcher.hpp"
+
 namespace VFS
 {
 
@@ -35,6 +37,10 @@ namespace VFS
         /// Does a file with this name exist?
         bool exists(const std::string& name) const;
 
+        /// Does a file with this name exist?
+        /// @note Does not allocate, the name is normalized on the fly while hashing and comparing.
+        bool exists(const char* name, size_t length) const;
+
         /// Get a complete list of files from all archives
         const std::map<std::string, File*>& getIndex() const;
 
@@ -49,12 +55,38 @@ namespace VFS
         /// @note Throws an exception if the file can not be found.
         Files::IStreamPtr getNormalized(const std::string& normalizedName) const;
 
+        /// Read the given files into memory on a background thread, so that a later get() of them is served from memory.
+        /// @note Names of files that do not exist are ignored. The data is only kept until the next get() of each file.
+        void prefetch(const std::vector<std::string>& names) const;
+
+        /// Set the upper limit for the total size of prefetched files held in memory. The oldest files are dropped first.
+        void setPrefetchBufferSize(size_t bytes);
+
+        Prefetcher::Stats getPrefetchStats() const;
+
     private:
+        /// Find a file in the hash index, or NULL if there is no file with this name.
+        File* lookup(const char* name, size_t length) const;
+
         bool mStrict;
 
         std::vector<Archive*> mArchives;
 
+        /// Sorted index, used for listing files
         std::map<std::string, File*> mIndex;
+
+        struct HashEntry
+        {
+            size_t mHash;
+            const std::string* mName; // points into mIndex
+            File* mFile;
+        };
+
+        /// Open addressing hash table over mIndex, used for name lookups.
+        /// @note The size is always a power of two and more than twice the number of files.
+        std::vector<HashEntry> mHashIndex;
+
+        mutable Prefetcher mPrefetcher;
     };
 
 }
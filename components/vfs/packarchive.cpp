@@ -0,0 +1,51 @@
+#include "packarchive.hpp"
+
+#include <algorithm>
+
+namespace VFS
+{
+
+    PackArchive::PackArchive(const std::string &filename)
+        : mFilename(filename)
+        , mOpened(false)
+    {
+    }
+
+    void PackArchive::listResources(std::map<std::string, File *> &out, char (*normalize_function)(char))
+    {
+        // Reading the directory is deferred to here, so archives can be opened concurrently by VFS::Manager::buildIndex
+        if (!mOpened)
+        {
+            mFile.open(mFilename);
+
+            const Bsa::PackFile::FileList &filelist = mFile.getList();
+            mResources.reserve(filelist.size());
+            for (Bsa::PackFile::FileList::const_iterator it = filelist.begin(); it != filelist.end(); ++it)
+                mResources.push_back(PackArchiveFile(&*it, &mFile));
+
+            mOpened = true;
+        }
+
+        for (std::vector<PackArchiveFile>::iterator it = mResources.begin(); it != mResources.end(); ++it)
+        {
+            std::string ent = it->mInfo->mName;
+            std::transform(ent.begin(), ent.end(), ent.begin(), normalize_function);
+
+            out[ent] = &*it;
+        }
+    }
+
+    // ------------------------------------------------------------------------------
+
+    PackArchiveFile::PackArchiveFile(const Bsa::PackFile::FileStruct *info, const Bsa::PackFile *pack)
+        : mInfo(info)
+        , mFile(pack)
+    {
+    }
+
+    Files::IStreamPtr PackArchiveFile::open()
+    {
+        return mFile->getFile(mInfo);
+    }
+
+}
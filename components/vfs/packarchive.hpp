@@ -0,0 +1,41 @@
+#ifndef OPENMW_COMPONENTS_VFS_PACKARCHIVE_H
+#define OPENMW_COMPONENTS_VFS_PACKARCHIVE_H
+
+#include "archive.hpp"
+
+#include <components/bsa/packfile.hpp>
+
+namespace VFS
+{
+
+    class PackArchiveFile : public File
+    {
+    public:
+        PackArchiveFile(const Bsa::PackFile::FileStruct* info, const Bsa::PackFile* pack);
+
+        virtual Files::IStreamPtr open();
+
+        const Bsa::PackFile::FileStruct* mInfo;
+        const Bsa::PackFile* mFile;
+    };
+
+    /// @brief Archive of the files in a pack archive, see Bsa::PackFile.
+    class PackArchive : public Archive
+    {
+    public:
+        PackArchive(const std::string& filename);
+
+        virtual void listResources(std::map<std::string, File*>& out, char (*normalize_function) (char));
+
+    private:
+        std::string mFilename;
+        bool mOpened;
+
+        Bsa::PackFile mFile;
+
+        std::vector<PackArchiveFile> mResources;
+    };
+
+}
+
+#endif
@@ -0,0 +1,195 @@
+#include "prefetcher.hpp"
+
+#include <boost/bind.hpp>
+
+#include <components/files/memorystream.hpp>
+
+#include "archive.hpp"
+
+namespace
+{
+
+    const size_t sChunkSize = 64*1024;
+
+}
+
+namespace VFS
+{
+
+    Prefetcher::Prefetcher(size_t maxBufferedBytes)
+        : mThreadStarted(false)
+        , mQuit(false)
+        , mMaxBufferedBytes(maxBufferedBytes)
+    {
+        mStats.mHits = 0;
+        mStats.mMisses = 0;
+        mStats.mEvictions = 0;
+        mStats.mBufferedBytes = 0;
+    }
+
+    Prefetcher::~Prefetcher()
+    {
+        stop();
+    }
+
+    void Prefetcher::stop()
+    {
+        {
+            boost::mutex::scoped_lock lock(mMutex);
+            mQuit = true;
+            mQueue.clear();
+            mRequested.clear();
+        }
+        mCondition.notify_all();
+
+        if (mThreadStarted)
+        {
+            mThread.join();
+            mThreadStarted = false;
+        }
+    }
+
+    void Prefetcher::prefetch(const std::string &name, File *file)
+    {
+        {
+            boost::mutex::scoped_lock lock(mMutex);
+            if (mQuit || mBuffers.find(name) != mBuffers.end() || !mRequested.insert(name).second)
+                return;
+
+            mQueue.push_back(std::make_pair(name, file));
+
+            if (!mThreadStarted)
+            {
+                mThread = boost::thread(boost::bind(&Prefetcher::run, this));
+                mThreadStarted = true;
+            }
+        }
+        mCondition.notify_one();
+    }
+
+    Files::IStreamPtr Prefetcher::take(const std::string &name)
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+
+        std::map<std::string, Buffer>::iterator found = mBuffers.find(name);
+        if (found != mBuffers.end())
+        {
+            Buffer buffer = found->second;
+            mBuffers.erase(found);
+            mStats.mBufferedBytes -= buffer->size();
+            ++mStats.mHits;
+
+            if (mBuffers.empty())
+                mBufferOrder.clear();
+
+            return Files::IStreamPtr(new Files::ISharedMemStream(buffer));
+        }
+
+        // Requested, but not read yet. The caller is going to read the file itself now, so don't bother.
+        if (mRequested.erase(name))
+        {
+            ++mStats.mMisses;
+
+            if (name != mReading)
+            {
+                for (std::deque<std::pair<std::string, File*> >::iterator it = mQueue.begin(); it != mQueue.end(); ++it)
+                {
+                    if (it->first == name)
+                    {
+                        mQueue.erase(it);
+                        break;
+                    }
+                }
+            }
+        }
+
+        return Files::IStreamPtr();
+    }
+
+    bool Prefetcher::isActive() const
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        return !mRequested.empty() || !mBuffers.empty();
+    }
+
+    void Prefetcher::setMaxBufferedBytes(size_t bytes)
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        mMaxBufferedBytes = bytes;
+        evict(0);
+    }
+
+    Prefetcher::Stats Prefetcher::getStats() const
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+        return mStats;
+    }
+
+    void Prefetcher::evict(size_t neededBytes)
+    {
+        while (mStats.mBufferedBytes + neededBytes > mMaxBufferedBytes && !mBufferOrder.empty())
+        {
+            std::pair<std::string, const std::vector<char>*> oldest = mBufferOrder.front();
+            mBufferOrder.pop_front();
+
+            std::map<std::string, Buffer>::iterator found = mBuffers.find(oldest.first);
+            if (found != mBuffers.end() && found->second.get() == oldest.second)
+            {
+                mStats.mBufferedBytes -= found->second->size();
+                ++mStats.mEvictions;
+                mBuffers.erase(found);
+            }
+        }
+    }
+
+    void Prefetcher::run()
+    {
+        while (true)
+        {
+            std::pair<std::string, File*> item;
+            {
+                boost::mutex::scoped_lock lock(mMutex);
+                while (mQueue.empty() && !mQuit)
+                    mCondition.wait(lock);
+                if (mQuit)
+                    return;
+
+                item = mQueue.front();
+                mQueue.pop_front();
+                mReading = item.first;
+            }
+
+            Buffer buffer (new std::vector<char>);
+            bool success = true;
+            try
+            {
+                Files::IStreamPtr stream = item.second->open();
+                while (stream->good())
+                {
+                    size_t offset = buffer->size();
+                    buffer->resize(offset + sChunkSize);
+                    stream->read(&(*buffer)[offset], sChunkSize);
+                    buffer->resize(offset + stream->gcount());
+                }
+            }
+            catch (std::exception&)
+            {
+                // Leave it to the synchronous read to report the error
+                success = false;
+            }
+
+            boost::mutex::scoped_lock lock(mMutex);
+            mReading.clear();
+
+            // If the name is no longer requested, take() was called in the meantime
+            if (!mRequested.erase(item.first) || !success || buffer->size() > mMaxBufferedBytes)
+                continue;
+
+            evict(buffer->size());
+            mBuffers[item.first] = buffer;
+            mBufferOrder.push_back(std::make_pair(item.first, buffer.get()));
+            mStats.mBufferedBytes += buffer->size();
+        }
+    }
+
+}
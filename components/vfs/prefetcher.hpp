@@ -0,0 +1,90 @@
+#ifndef OPENMW_COMPONENTS_VFS_PREFETCHER_H
+#define OPENMW_COMPONENTS_VFS_PREFETCHER_H
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <components/files/constrainedfilestream.hpp>
+#include <components/files/memorystream.hpp>
+
+namespace VFS
+{
+
+    class File;
+
+    /// @brief Reads files into memory on a background thread, ahead of the time they are needed.
+    /// @par Buffered files are kept until they are taken out with take(), or until they are evicted
+    /// (oldest first) to keep the total size within the given limit.
+    class Prefetcher
+    {
+    public:
+        struct Stats
+        {
+            /// Number of take() calls that were served from memory
+            size_t mHits;
+            /// Number of take() calls for files that were requested, but not read yet
+            size_t mMisses;
+            /// Number of buffered files that were dropped before being used
+            size_t mEvictions;
+            /// Total size of the files currently held in memory
+            size_t mBufferedBytes;
+        };
+
+        /// @param maxBufferedBytes Upper limit for the total size of the files held in memory.
+        Prefetcher(size_t maxBufferedBytes);
+        ~Prefetcher();
+
+        /// Stop the background thread, dropping any queued files. Must be called before the queued File objects are destroyed.
+        void stop();
+
+        /// Queue the given file to be read on the background thread.
+        /// @param name The normalized file name, used as key for take().
+        void prefetch(const std::string& name, File* file);
+
+        /// Take the contents of the given file out of memory, if it was prefetched.
+        /// @return An empty pointer if the file was not prefetched, or is not read yet.
+        Files::IStreamPtr take(const std::string& name);
+
+        /// Is anything queued or held in memory? Can be used to skip take() altogether.
+        bool isActive() const;
+
+        void setMaxBufferedBytes(size_t bytes);
+
+        Stats getStats() const;
+
+    private:
+        typedef Files::SharedBuffer Buffer;
+
+        void run();
+
+        /// @note Call with mMutex locked.
+        void evict(size_t neededBytes);
+
+        mutable boost::mutex mMutex;
+        boost::condition_variable mCondition;
+        boost::thread mThread;
+        bool mThreadStarted;
+        bool mQuit;
+
+        std::deque<std::pair<std::string, File*> > mQueue;
+        /// Names of files in mQueue, and of the file currently being read
+        std::set<std::string> mRequested;
+        std::string mReading;
+
+        std::map<std::string, Buffer> mBuffers;
+        /// Buffered files, oldest first. May contain files that were already taken out.
+        std::deque<std::pair<std::string, const std::vector<char>*> > mBufferOrder;
+
+        size_t mMaxBufferedBytes;
+        Stats mStats;
+    };
+
+}
+
+#endif
@@ -6,11 +6,13 @@
 #include <components/vfs/manager.hpp>
 #include <components/vfs/bsaarchive.hpp>
 #include <components/vfs/filesystemarchive.hpp>
+#include <components/vfs/packarchive.hpp>
 
 namespace VFS
 {
 
-    void registerArchives(VFS::Manager *vfs, const Files::Collections &collections, const std::vector<std::string> &archives, bool useLooseFiles)
+    void registerArchives(VFS::Manager *vfs, const Files::Collections &collections, const std::vector<std::string> &archives, bool useLooseFiles, bool mapArchives,
+        Files::DirectoryCache* directoryCache)
     {
         const Files::PathContainer& dataDirs = collections.getPaths();
 
@@ -20,9 +22,16 @@ namespace VFS
             {
                 // Last BSA has the highest priority
                 const std::string archivePath = collections.getPath(*archive).string();
+                if (Bsa::PackFile::isPackFile(archivePath))
+                {
+                    std::cout << "Adding pack archive " << archivePath << std::endl;
+                    vfs->addArchive(new PackArchive(archivePath));
+                    continue;
+                }
+
                 std::cout << "Adding BSA archive " << archivePath << std::endl;
 
-                vfs->addArchive(new BsaArchive(archivePath));
+                vfs->addArchive(new BsaArchive(archivePath, mapArchives));
             }
             else
             {
@@ -37,7 +46,7 @@ namespace VFS
             {
                 std::cout << "Adding data directory " << iter->string() << std::endl;
                 // Last data dir has the highest priority
-                vfs->addArchive(new FileSystemArchive(iter->string()));
+                vfs->addArchive(new FileSystemArchive(iter->string(), directoryCache));
             }
 
         vfs->buildIndex();
@@ -3,13 +3,22 @@
 
 #include <components/files/collections.hpp>
 
+namespace Files
+{
+    class DirectoryCache;
+}
+
 namespace VFS
 {
     class Manager;
 
     /// @brief Register BSA and file system archives based on the given OpenMW configuration.
+    /// @par Archives that start like a pack archive (see Bsa::PackFile) are read as such, all others as BSA archives.
+    /// @param mapArchives Map BSA archives into memory instead of opening them again for every file read.
+    /// @param directoryCache Optional cache of directory listings to use when scanning data directories.
     void registerArchives (VFS::Manager* vfs, const Files::Collections& collections,
-        const std::vector<std::string>& archives, bool useLooseFiles);
+        const std::vector<std::string>& archives, bool useLooseFiles, bool mapArchives,
+        Files::DirectoryCache* directoryCache = NULL);
 }
 
 #endif
@@ -1,8 +1,10 @@
 #include "videostate.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include <osg/Texture2D>
+#include <osg/BufferObject>
 
 extern "C"
 {
@@ -38,6 +40,19 @@ struct FlushPacket : AVPacket
 
 static FlushPacket flush_pkt;
 
+static const char* drainString = "DRAIN";
+struct DrainPacket : AVPacket
+{
+    DrainPacket()
+        : AVPacket()
+    {
+        data = ( (uint8_t*)drainString);
+    }
+};
+
+// Put after the last video packet, to get the pictures still delayed in the decoder threads
+static DrainPacket drain_pkt;
+
 #include "videoplayer.hpp"
 #include "audiodecoder.hpp"
 #include "audiofactory.hpp"
@@ -46,6 +61,10 @@ namespace
 {
     const int MAX_AUDIOQ_SIZE = (5 * 16 * 1024);
     const int MAX_VIDEOQ_SIZE = (5 * 256 * 1024);
+
+    // Decoded pictures are kept up to this size in total, but at least 2 of them. At 1080p that is about
+    // half a second of video.
+    const size_t MAX_PICTQ_BYTES = 128 * 1024 * 1024;
 }
 
 namespace Video
@@ -58,7 +77,7 @@ VideoState::VideoState()
     , audio_st(NULL)
     , video_st(NULL), frame_last_pts(0.0)
     , video_clock(0.0), sws_context(NULL), rgbaFrame(NULL), pictq_size(0)
-    , pictq_rindex(0), pictq_windex(0)
+    , pictq_rindex(0), pictq_windex(0), pictq_capacity(VIDEO_PICTURE_QUEUE_SIZE), mVideoDrained(false)
     , mSeekRequested(false)
     , mSeekPos(0)
     , mVideoEnded(false)
@@ -85,7 +104,7 @@ void VideoState::setAudioFactory(MovieAudioFactory *factory)
 void PacketQueue::put(AVPacket *pkt)
 {
     AVPacketList *pkt1;
-    if(pkt != &flush_pkt && !pkt->buf && av_dup_packet(pkt) < 0)
+    if(pkt != &flush_pkt && pkt != &drain_pkt && !pkt->buf && av_dup_packet(pkt) < 0)
         throw std::runtime_error("Failed to duplicate packet");
 
     pkt1 = (AVPacketList*)av_malloc(sizeof(AVPacketList));
@@ -149,7 +168,7 @@ void PacketQueue::clear()
     for(pkt = this->first_pkt; pkt != NULL; pkt = pkt1)
     {
         pkt1 = pkt->next;
-        if (pkt->pkt.data != flush_pkt.data)
+        if (pkt->pkt.data != flush_pkt.data && pkt->pkt.data != drain_pkt.data)
             av_free_packet(&pkt->pkt);
         av_freep(&pkt);
     }
@@ -222,12 +241,20 @@ void VideoState::video_display(VideoPicture *vp)
             mTexture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
         }
 
-        osg::ref_ptr<osg::Image> image = new osg::Image;
+        // Keep the same image, so each picture is uploaded into the existing texture. The pixel buffer object
+        // lets the driver copy the picture asynchronously rather than stalling the draw.
+        if (!mImage.get())
+        {
+            mImage = new osg::Image;
+            mImage->setDataVariance(osg::Object::DYNAMIC);
+            mImage->setPixelBufferObject(new osg::PixelBufferObject(mImage.get()));
+        }
 
-        image->setImage((*this->video_st)->codec->width, (*this->video_st)->codec->height,
-                        1, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, &vp->data[0], osg::Image::NO_DELETE);
+        mImage->setImage((*this->video_st)->codec->width, (*this->video_st)->codec->height,
+                         1, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, &vp->data[0], osg::Image::NO_DELETE);
 
-        mTexture->setImage(image);
+        if (mTexture->getImage() != mImage.get())
+            mTexture->setImage(mImage);
     }
 }
 
@@ -242,7 +269,7 @@ void VideoState::video_refresh()
         VideoPicture* vp = &this->pictq[this->pictq_rindex];
         this->video_display(vp);
 
-        this->pictq_rindex = (pictq_rindex+1) % VIDEO_PICTURE_ARRAY_SIZE;
+        this->pictq_rindex = (pictq_rindex+1) % (this->pictq_capacity+1);
         this->frame_last_pts = vp->pts;
         this->pictq_size--;
         this->pictq_cond.notify_one();
@@ -259,12 +286,12 @@ void VideoState::video_refresh()
         for (; i<this->pictq_size-1; ++i)
         {
             if (this->pictq[pictq_rindex].pts + threshold <= this->get_master_clock())
-                this->pictq_rindex = (this->pictq_rindex+1) % VIDEO_PICTURE_ARRAY_SIZE; // not enough time to show this picture
+                this->pictq_rindex = (this->pictq_rindex+1) % (this->pictq_capacity+1); // not enough time to show this picture
             else
                 break;
         }
 
-        assert (this->pictq_rindex < VIDEO_PICTURE_ARRAY_SIZE);
+        assert (this->pictq_rindex <= this->pictq_capacity);
         VideoPicture* vp = &this->pictq[this->pictq_rindex];
 
         this->video_display(vp);
@@ -274,7 +301,7 @@ void VideoState::video_refresh()
         this->pictq_size -= i;
         // update queue for next picture
         this->pictq_size--;
-        this->pictq_rindex = (this->pictq_rindex+1) % VIDEO_PICTURE_ARRAY_SIZE;
+        this->pictq_rindex = (this->pictq_rindex+1) % (this->pictq_capacity+1);
         this->pictq_cond.notify_one();
     }
 }
@@ -287,7 +314,7 @@ int VideoState::queue_picture(AVFrame *pFrame, double pts)
     /* wait until we have a new pic */
     {
         boost::unique_lock<boost::mutex> lock(this->pictq_mutex);
-        while(this->pictq_size >= VIDEO_PICTURE_QUEUE_SIZE && !this->mQuit)
+        while(this->pictq_size >= this->pictq_capacity && !this->mQuit)
             this->pictq_cond.timed_wait(lock, boost::posix_time::milliseconds(1));
     }
     if(this->mQuit)
@@ -320,7 +347,7 @@ int VideoState::queue_picture(AVFrame *pFrame, double pts)
               0, (*this->video_st)->codec->height, &dst, this->rgbaFrame->linesize);
 
     // now we inform our display thread that we have a pic ready
-    this->pictq_windex = (this->pictq_windex+1) % VIDEO_PICTURE_ARRAY_SIZE;
+    this->pictq_windex = (this->pictq_windex+1) % (this->pictq_capacity+1);
     this->pictq_size++;
     this->pictq_mutex.unlock();
 
@@ -347,31 +374,6 @@ double VideoState::synchronize_video(AVFrame *src_frame, double pts)
     return pts;
 }
 
-static void our_free_buffer(void *opaque, uint8_t *data);
-/* These are called whenever we allocate a frame
- * buffer. We use this to store the global_pts in
- * a frame at the time it is allocated.
- */
-static int64_t global_video_pkt_pts = AV_NOPTS_VALUE;
-static int our_get_buffer(struct AVCodecContext *c, AVFrame *pic, int flags)
-{
-    AVBufferRef *ref;
-    int ret = avcodec_default_get_buffer2(c, pic, flags);
-    int64_t *pts = (int64_t*)av_malloc(sizeof(int64_t));
-    *pts = global_video_pkt_pts;
-    pic->opaque = pts;
-    ref = av_buffer_create((uint8_t *)pic->opaque, sizeof(int64_t), our_free_buffer, pic->buf[0], flags);
-    pic->buf[0] = ref;
-    return ret;
-}
-static void our_free_buffer(void *opaque, uint8_t *data)
-{
-    AVBufferRef *ref = (AVBufferRef *)opaque;
-    av_buffer_unref(&ref);
-    av_free(data);
-}
-
-
 void VideoState::video_thread_loop(VideoState *self)
 {
     AVPacket pkt1, *packet = &pkt1;
@@ -396,32 +398,43 @@ void VideoState::video_thread_loop(VideoState *self)
             self->pictq_mutex.unlock();
 
             self->frame_last_pts = packet->pts * av_q2d((*self->video_st)->time_base);
-            global_video_pkt_pts = static_cast<int64_t>(self->frame_last_pts);
+            self->mVideoDrained = false;
             continue;
         }
 
-        // Save global pts to be stored in pFrame
-        global_video_pkt_pts = packet->pts;
-        // Decode video frame
-        if(avcodec_decode_video2((*self->video_st)->codec, pFrame, &frameFinished, packet) < 0)
-            throw std::runtime_error("Error decoding video frame");
-
-        double pts = 0;
-        if(packet->dts != AV_NOPTS_VALUE)
-            pts = static_cast<double>(packet->dts);
-        else if(pFrame->opaque && *(int64_t*)pFrame->opaque != AV_NOPTS_VALUE)
-            pts = static_cast<double>(*(int64_t*)pFrame->opaque);
-        pts *= av_q2d((*self->video_st)->time_base);
-
-        av_free_packet(packet);
-
-        // Did we get a video frame?
-        if(frameFinished)
+        bool drain = (packet->data == drain_pkt.data);
+        if(drain)
         {
-            pts = self->synchronize_video(pFrame, pts);
-            if(self->queue_picture(pFrame, pts) < 0)
-                break;
+            // An empty packet returns the delayed pictures, one at a time
+            packet->data = NULL;
+            packet->size = 0;
         }
+
+        do
+        {
+            // Decode video frame
+            if(avcodec_decode_video2((*self->video_st)->codec, pFrame, &frameFinished, packet) < 0)
+                throw std::runtime_error("Error decoding video frame");
+
+            // With frame threading the picture is from an earlier packet, so take its time from the decoder
+            double pts = 0;
+            int64_t timestamp = av_frame_get_best_effort_timestamp(pFrame);
+            if(timestamp != AV_NOPTS_VALUE)
+                pts = static_cast<double>(timestamp) * av_q2d((*self->video_st)->time_base);
+
+            // Did we get a video frame?
+            if(frameFinished)
+            {
+                pts = self->synchronize_video(pFrame, pts);
+                if(self->queue_picture(pFrame, pts) < 0)
+                    break;
+            }
+        } while(drain && frameFinished);
+
+        if(drain)
+            self->mVideoDrained = true;
+        else
+            av_free_packet(packet);
     }
 
     av_free(pFrame);
@@ -434,6 +447,7 @@ void VideoState::decode_thread_loop(VideoState *self)
 {
     AVFormatContext *pFormatCtx = self->format_ctx;
     AVPacket pkt1, *packet = &pkt1;
+    bool drainQueued = false;
 
     try
     {
@@ -497,6 +511,7 @@ void VideoState::decode_thread_loop(VideoState *self)
                     self->pictq_windex = 0;
                     self->pictq_mutex.unlock();
                     self->mExternalClock.set(seek_target);
+                    drainQueued = false;
                 }
                 self->mSeekRequested = false;
             }
@@ -511,12 +526,24 @@ void VideoState::decode_thread_loop(VideoState *self)
 
             if(av_read_frame(pFormatCtx, packet) < 0)
             {
-                if (self->audioq.nb_packets == 0 && self->videoq.nb_packets == 0 && self->pictq_size == 0)
+                if(self->video_st && !drainQueued)
+                {
+                    self->mVideoDrained = false;
+                    self->videoq.put(&drain_pkt);
+                    drainQueued = true;
+                }
+                if (self->audioq.nb_packets == 0 && self->videoq.nb_packets == 0 && self->pictq_size == 0
+                        && (!self->video_st || self->mVideoDrained))
                     self->mVideoEnded = true;
+                else
+                    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
                 continue;
             }
             else
+            {
                 self->mVideoEnded = false;
+                drainQueued = false;
+            }
 
             // Is this a packet from the video stream?
             if(self->video_st && packet->stream_index == self->video_st-pFormatCtx->streams)
@@ -553,6 +580,12 @@ int VideoState::stream_open(int stream_index, AVFormatContext *pFormatCtx)
     // Get a pointer to the codec context for the video stream
     codecCtx = pFormatCtx->streams[stream_index]->codec;
     codec = avcodec_find_decoder(codecCtx->codec_id);
+    if(codecCtx->codec_type == AVMEDIA_TYPE_VIDEO)
+    {
+        // Decode on as many threads as there are cores, several pictures at once where the codec allows it
+        codecCtx->thread_count = 0;
+        codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    }
     if(!codec || (avcodec_open2(codecCtx, codec, NULL) < 0))
     {
         fprintf(stderr, "Unsupported codec!\n");
@@ -586,7 +619,12 @@ int VideoState::stream_open(int stream_index, AVFormatContext *pFormatCtx)
     case AVMEDIA_TYPE_VIDEO:
         this->video_st = pFormatCtx->streams + stream_index;
 
-        codecCtx->get_buffer2 = our_get_buffer;
+        if(codecCtx->width > 0 && codecCtx->height > 0)
+        {
+            size_t pictureSize = static_cast<size_t>(codecCtx->width) * codecCtx->height * 4;
+            this->pictq_capacity = static_cast<int>(std::max<size_t>(2,
+                std::min<size_t>(VIDEO_PICTURE_QUEUE_SIZE, MAX_PICTQ_BYTES / pictureSize)));
+        }
         this->video_thread = boost::thread(video_thread_loop, this);
         break;
 
@@ -722,6 +760,7 @@ void VideoState::deinit()
         mTexture->setImage(NULL);
         mTexture = NULL;
     }
+    mImage = NULL;
 }
 
 double VideoState::get_external_clock()
@@ -9,6 +9,7 @@
 namespace osg
 {
     class Texture2D;
+    class Image;
 }
 
 #include "videodefs.hpp"
@@ -16,6 +17,7 @@ namespace osg
 #define VIDEO_PICTURE_QUEUE_SIZE 50
 // allocate one extra to make sure we do not overwrite the osg::Image currently set on the texture
 #define VIDEO_PICTURE_ARRAY_SIZE (VIDEO_PICTURE_QUEUE_SIZE+1)
+// NOTE: large videos use less of the pictures, see pictq_capacity
 
 extern "C"
 {
@@ -117,6 +119,7 @@ struct VideoState {
     static int64_t istream_seek(void *user_data, int64_t offset, int whence);
 
     osg::ref_ptr<osg::Texture2D> mTexture;
+    osg::ref_ptr<osg::Image> mImage;
 
     MovieAudioFactory* mAudioFactory;
     boost::shared_ptr<MovieAudioDecoder> mAudioDecoder;
@@ -141,6 +144,7 @@ struct VideoState {
     VideoPicture pictq[VIDEO_PICTURE_ARRAY_SIZE];
     AVFrame*     rgbaFrame; // used as buffer for the frame converted from its native format to RGBA
     int          pictq_size, pictq_rindex, pictq_windex;
+    int          pictq_capacity; ///< number of pictures queued at most, the ring uses one more
     boost::mutex pictq_mutex;
     boost::condition_variable pictq_cond;
 
@@ -151,6 +155,7 @@ struct VideoState {
     uint64_t mSeekPos;
 
     volatile bool mVideoEnded;
+    volatile bool mVideoDrained; ///< the decoder returned all pictures after the last packet
     volatile bool mPaused;
     volatile bool mQuit;
 };
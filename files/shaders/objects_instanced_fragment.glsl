@@ -0,0 +1,15 @@
+#version 120
+
+uniform sampler2D diffuseMap;
+
+varying vec4  colorPassthrough;
+varying float depthPassthrough;
+
+void main(void)
+{
+    gl_FragData[0] = texture2D(diffuseMap, gl_TexCoord[0].xy) * colorPassthrough;
+
+    // fog
+    float fogValue = clamp((depthPassthrough - gl_Fog.start) * gl_Fog.scale, 0.0, 1.0);
+    gl_FragData[0].xyz = mix(gl_FragData[0].xyz, gl_Fog.color.xyz, fogValue);
+}
@@ -0,0 +1,34 @@
+#version 120
+#extension GL_ARB_draw_instanced : require
+
+// Transforms from the model to the cell scene node, one per instance
+uniform mat4 instanceTransforms[@maxInstances];
+// Vertex colors replace the ambient and diffuse material colors, as with osg::Material::AMBIENT_AND_DIFFUSE
+uniform bool vertexColors;
+
+varying vec4  colorPassthrough;
+varying float depthPassthrough;
+
+void main(void)
+{
+    mat4 instanceTransform = instanceTransforms[gl_InstanceIDARB];
+    vec4 viewPos = gl_ModelViewMatrix * (instanceTransform * gl_Vertex);
+    gl_Position = gl_ProjectionMatrix * viewPos;
+    gl_ClipVertex = viewPos;
+
+    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;
+
+    // Lit by the sun and the ambient light only
+    vec3 viewNormal = normalize(gl_NormalMatrix * (mat3(instanceTransform) * gl_Normal));
+    vec3 lightDir = normalize(gl_LightSource[0].position.xyz);
+
+    vec4 ambient = vertexColors ? gl_Color : gl_FrontMaterial.ambient;
+    vec4 diffuse = vertexColors ? gl_Color : gl_FrontMaterial.diffuse;
+
+    colorPassthrough.xyz = gl_FrontMaterial.emission.xyz
+            + ambient.xyz * (gl_LightModel.ambient.xyz + gl_LightSource[0].ambient.xyz)
+            + diffuse.xyz * gl_LightSource[0].diffuse.xyz * max(dot(viewNormal, lightDir), 0.0);
+    colorPassthrough.w = diffuse.w;
+
+    depthPassthrough = gl_Position.z;
+}
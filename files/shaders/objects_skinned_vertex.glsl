@@ -0,0 +1,87 @@
+#version 120
+
+// Skinning transforms from the geometry to itself, one per bone, see SceneUtil::RigGeometry
+uniform mat4 boneMatrices[@maxBones];
+
+// Up to four bones per vertex. Vertices without any weights are not skinned.
+attribute vec4 boneIndices;
+attribute vec4 boneWeights;
+
+// The number of lights in use, including the sun, see SceneUtil::LightManager
+uniform int lightCount;
+// The osg::Material::ColorMode of the material: 0 = OFF, 1 = EMISSION, 2 = AMBIENT, 3 = AMBIENT_AND_DIFFUSE
+uniform int colorMode;
+// Generate the coordinates of texture unit 1 like osg::TexGen::SPHERE_MAP does, for the enchantment glow
+uniform bool sphereMapTexUnit1;
+
+// There is no fragment shader, the fixed function pipeline textures and fogs the lit vertices
+void main(void)
+{
+    mat4 skinMatrix = boneMatrices[int(boneIndices.x)] * boneWeights.x
+                    + boneMatrices[int(boneIndices.y)] * boneWeights.y
+                    + boneMatrices[int(boneIndices.z)] * boneWeights.z
+                    + boneMatrices[int(boneIndices.w)] * boneWeights.w;
+    if (boneWeights == vec4(0.0))
+        skinMatrix = mat4(1.0);
+
+    vec4 viewPos = gl_ModelViewMatrix * (skinMatrix * gl_Vertex);
+    gl_Position = gl_ProjectionMatrix * viewPos;
+    gl_ClipVertex = viewPos;
+    gl_FogFragCoord = abs(viewPos.z);
+
+    vec3 viewNormal = normalize(gl_NormalMatrix * (mat3(skinMatrix) * gl_Normal));
+
+    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;
+    if (sphereMapTexUnit1)
+    {
+        vec3 r = reflect(normalize(viewPos.xyz), viewNormal);
+        float m = 2.0 * sqrt(r.x * r.x + r.y * r.y + (r.z + 1.0) * (r.z + 1.0));
+        gl_TexCoord[1] = gl_TextureMatrix[1] * vec4(r.x / m + 0.5, r.y / m + 0.5, 0.0, 1.0);
+    }
+    else
+        gl_TexCoord[1] = gl_TextureMatrix[1] * gl_MultiTexCoord1;
+    gl_TexCoord[2] = gl_TextureMatrix[2] * gl_MultiTexCoord2;
+    gl_TexCoord[3] = gl_TextureMatrix[3] * gl_MultiTexCoord3;
+
+    // Per vertex lighting like the fixed function pipeline
+    vec4 emission = colorMode == 1 ? gl_Color : gl_FrontMaterial.emission;
+    vec4 ambient = (colorMode == 2 || colorMode == 3) ? gl_Color : gl_FrontMaterial.ambient;
+    vec4 diffuse = colorMode == 3 ? gl_Color : gl_FrontMaterial.diffuse;
+
+    vec3 ambientLight = gl_LightModel.ambient.xyz;
+    vec3 diffuseLight = vec3(0.0);
+    vec3 specularLight = vec3(0.0);
+    for (int i=0; i<lightCount; ++i)
+    {
+        vec4 lightPos = gl_LightSource[i].position;
+        vec3 lightDir = lightPos.xyz;
+        float attenuation = 1.0;
+        if (lightPos.w != 0.0)
+        {
+            lightDir -= viewPos.xyz;
+            float distance = length(lightDir);
+            attenuation = 1.0 / (gl_LightSource[i].constantAttenuation
+                                 + gl_LightSource[i].linearAttenuation * distance
+                                 + gl_LightSource[i].quadraticAttenuation * distance * distance);
+        }
+        lightDir = normalize(lightDir);
+
+        ambientLight += gl_LightSource[i].ambient.xyz * attenuation;
+        float lambert = dot(viewNormal, lightDir);
+        if (lambert > 0.0)
+        {
+            diffuseLight += gl_LightSource[i].diffuse.xyz * lambert * attenuation;
+            if (gl_FrontMaterial.shininess > 0.0)
+            {
+                vec3 halfVector = normalize(lightDir + vec3(0.0, 0.0, 1.0));
+                specularLight += gl_LightSource[i].specular.xyz * attenuation
+                        * pow(max(dot(viewNormal, halfVector), 0.0), gl_FrontMaterial.shininess);
+            }
+        }
+    }
+
+    gl_FrontColor.xyz = emission.xyz + ambient.xyz * ambientLight + diffuse.xyz * diffuseLight
+            + gl_FrontMaterial.specular.xyz * specularLight;
+    gl_FrontColor.w = diffuse.w;
+    gl_BackColor = gl_FrontColor;
+}
@@ -0,0 +1,43 @@
+#version 120
+
+// One step of the ripple heightfield of MWRender::RippleMap, a damped wave equation.
+// The red channel holds the height of the current step, the green channel the height of the step before.
+
+#define MAX_RIPPLES @max_ripples
+
+const float DAMPING = 0.985;
+
+varying vec2 uv;
+
+uniform sampler2D heightMap;
+
+// The size of one texel
+uniform float texelSize;
+// Where the texels of the last step are, after the heightfield moved with the camera
+uniform vec2 offset;
+
+// New ripples: centre xy and radius z in texture coordinates, strength w
+uniform vec4 ripples[MAX_RIPPLES];
+uniform int numRipples;
+
+void main(void)
+{
+    vec2 coord = uv + offset;
+    vec2 heights = texture2D(heightMap, coord).rg;
+
+    float neighbours = texture2D(heightMap, coord + vec2(texelSize, 0.0)).r
+                     + texture2D(heightMap, coord - vec2(texelSize, 0.0)).r
+                     + texture2D(heightMap, coord + vec2(0.0, texelSize)).r
+                     + texture2D(heightMap, coord - vec2(0.0, texelSize)).r;
+
+    float height = (neighbours * 0.5 - heights.y) * DAMPING;
+
+    for (int i=0; i<numRipples; ++i)
+    {
+        float distance = length(uv - ripples[i].xy) / ripples[i].z;
+        if (distance < 1.0)
+            height += ripples[i].w * (cos(distance * 3.14159265) + 1.0) * 0.5;
+    }
+
+    gl_FragData[0] = vec4(height, heights.x, 0.0, 1.0);
+}
@@ -0,0 +1,59 @@
+#version 120
+
+// The layers in the order they are blended, see Terrain::ShaderTechnique
+uniform sampler2D diffuseMap0;
+uniform sampler2D diffuseMap1;
+uniform sampler2D diffuseMap2;
+uniform sampler2D diffuseMap3;
+uniform sampler2D diffuseMap4;
+uniform sampler2D diffuseMap5;
+uniform sampler2D diffuseMap6;
+uniform sampler2D diffuseMap7;
+
+// The blend values of the layers after the first, four layers per texture
+uniform sampler2D blendMap0;
+uniform sampler2D blendMap1;
+
+uniform int numLayers;
+uniform float layerTileSize;
+uniform float blendmapScale;
+
+varying vec2  uvPassthrough;
+varying vec4  colorPassthrough;
+varying float depthPassthrough;
+
+void main(void)
+{
+    vec2 layerUV = uvPassthrough * layerTileSize;
+
+    // Maps the corner vertices directly to the center of a blendmap texel
+    vec2 blendUV = (uvPassthrough - 0.5) * (blendmapScale / (blendmapScale + 1.0)) + 0.5;
+
+    vec3 color = texture2D(diffuseMap0, layerUV).xyz;
+    if (numLayers > 1)
+    {
+        vec4 blend = texture2D(blendMap0, blendUV);
+        color = mix(color, texture2D(diffuseMap1, layerUV).xyz, blend.x);
+        if (numLayers > 2)
+            color = mix(color, texture2D(diffuseMap2, layerUV).xyz, blend.y);
+        if (numLayers > 3)
+            color = mix(color, texture2D(diffuseMap3, layerUV).xyz, blend.z);
+        if (numLayers > 4)
+            color = mix(color, texture2D(diffuseMap4, layerUV).xyz, blend.w);
+    }
+    if (numLayers > 5)
+    {
+        vec4 blend = texture2D(blendMap1, blendUV);
+        color = mix(color, texture2D(diffuseMap5, layerUV).xyz, blend.x);
+        if (numLayers > 6)
+            color = mix(color, texture2D(diffuseMap6, layerUV).xyz, blend.y);
+        if (numLayers > 7)
+            color = mix(color, texture2D(diffuseMap7, layerUV).xyz, blend.z);
+    }
+
+    gl_FragData[0] = vec4(color * colorPassthrough.xyz, colorPassthrough.w);
+
+    // fog
+    float fogValue = clamp((depthPassthrough - gl_Fog.start) * gl_Fog.scale, 0.0, 1.0);
+    gl_FragData[0].xyz = mix(gl_FragData[0].xyz, gl_Fog.color.xyz, fogValue);
+}
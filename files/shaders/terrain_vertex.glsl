@@ -0,0 +1,46 @@
+#version 120
+
+// The number of lights in use, including the sun, see SceneUtil::LightManager
+uniform int lightCount;
+
+varying vec2  uvPassthrough;
+varying vec4  colorPassthrough;
+varying float depthPassthrough;
+
+void main(void)
+{
+    vec4 viewPos = gl_ModelViewMatrix * gl_Vertex;
+    gl_Position = gl_ProjectionMatrix * viewPos;
+    gl_ClipVertex = viewPos;
+
+    uvPassthrough = gl_MultiTexCoord0.xy;
+
+    // Per vertex lighting like the fixed function pipeline. Vertex colors replace the ambient and diffuse material
+    // colors, as with osg::Material::AMBIENT_AND_DIFFUSE.
+    vec3 viewNormal = normalize(gl_NormalMatrix * gl_Normal);
+    vec3 ambient = gl_LightModel.ambient.xyz;
+    vec3 diffuse = vec3(0.0);
+    for (int i=0; i<lightCount; ++i)
+    {
+        vec4 lightPos = gl_LightSource[i].position;
+        vec3 lightDir = lightPos.xyz;
+        float attenuation = 1.0;
+        if (lightPos.w != 0.0)
+        {
+            lightDir -= viewPos.xyz;
+            float distance = length(lightDir);
+            attenuation = 1.0 / (gl_LightSource[i].constantAttenuation
+                                 + gl_LightSource[i].linearAttenuation * distance
+                                 + gl_LightSource[i].quadraticAttenuation * distance * distance);
+        }
+        lightDir = normalize(lightDir);
+
+        ambient += gl_LightSource[i].ambient.xyz * attenuation;
+        diffuse += gl_LightSource[i].diffuse.xyz * max(dot(viewNormal, lightDir), 0.0) * attenuation;
+    }
+
+    colorPassthrough.xyz = gl_FrontMaterial.emission.xyz + gl_Color.xyz * (ambient + diffuse);
+    colorPassthrough.w = gl_Color.w;
+
+    depthPassthrough = gl_Position.z;
+}
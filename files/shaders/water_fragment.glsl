@@ -1,6 +1,7 @@
 #version 120
 
 #define REFRACTION @refraction_enabled
+#define RIPPLES @ripples_enabled
 
 // Inspired by Blender GLSL Water by martinsh ( http://devlog-martinsh.blogspot.de/2012/07/waterundewater-shader-wip.html )
 
@@ -36,6 +37,8 @@ const float WIND_SPEED = 0.2f;
 
 const vec3 WATER_COLOR = vec3(0.090195, 0.115685, 0.12745);
 
+const float RIPPLE_BUMP = 2.0;                     // strength of the ripples of the ripple map
+
 // -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -
 
 float fresnel_dielectric(vec3 Incoming, vec3 Normal, float eta)
@@ -68,6 +71,14 @@ uniform sampler2D refractionMap;
 uniform sampler2D refractionDepthMap;
 #endif
                 
+#if RIPPLES
+// The heightfield of MWRender::RippleMap
+uniform sampler2D rippleMap;
+// The world position of the lower left corner of the ripple map in xy, its size in z
+uniform vec3 rippleArea;
+uniform float rippleTexelSize;
+#endif
+
 uniform float osg_SimulationTime;
 
 uniform float near;
@@ -114,6 +125,14 @@ void main(void)
 
     normal = vec3(-normal.x, -normal.y, normal.z);
 
+#if RIPPLES
+    // the ripple map is cleared to 0 outside of its area
+    vec2 rippleCoord = (worldPos.xy - rippleArea.xy) / rippleArea.z;
+    vec2 rippleSlope = vec2(texture2D(rippleMap, rippleCoord - vec2(rippleTexelSize, 0.0)).r - texture2D(rippleMap, rippleCoord + vec2(rippleTexelSize, 0.0)).r,
+                            texture2D(rippleMap, rippleCoord - vec2(0.0, rippleTexelSize)).r - texture2D(rippleMap, rippleCoord + vec2(0.0, rippleTexelSize)).r);
+    normal = normalize(normal + vec3(rippleSlope * RIPPLE_BUMP, 0.0));
+#endif
+
     // normal for sunlight scattering
     vec3 lNormal = (normal0 * BIG_WAVES_X*0.5 + normal1 * BIG_WAVES_Y*0.5 +
 		normal2 * MID_WAVES_X*0.2 + normal3 * MID_WAVES_Y*0.2 +